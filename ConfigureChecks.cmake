@@ -59,6 +59,19 @@ if(CMAKE_SYSTEM_NAME STREQUAL "Linux")
 		}"
 		HAVE_LINUX_IF_BONDING_H
 	)
+	#
+	# For dumpcap's block-mapped capture rings.
+	#
+	check_c_source_compiles(
+		"#include <sys/socket.h>
+		#include <linux/if_packet.h>
+		int main(void)
+		{
+			struct tpacket_req3 req;
+			return TPACKET_V3 + PACKET_FANOUT + sizeof req;
+		}"
+		HAVE_TPACKET3
+	)
 endif()
 
 #Functions
@@ -129,6 +142,7 @@ else()
 	#
 	check_include_file("alloca.h"    HAVE_ALLOCA_H)
 endif()
+check_function_exists("copy_file_range"  HAVE_COPY_FILE_RANGE)
 check_function_exists("getifaddrs"       HAVE_GETIFADDRS)
 check_function_exists("issetugid"        HAVE_ISSETUGID)
 check_function_exists("mkstemps"         HAVE_MKSTEMPS)
@@ -68,6 +68,7 @@
 
 #include <wiretap/wtap.h>
 
+#include <ui/clopts_common.h>
 #include <ui/cmdarg_err.h>
 #include <wsutil/filesystem.h>
 #include <wsutil/privileges.h>
@@ -102,6 +103,8 @@
 
 static gboolean stop_after_failure = FALSE;
 
+static int num_threads = 1;             /* Files read at the same time (-j) */
+
 /*
  * table report variables
  */
@@ -159,14 +162,6 @@ static gboolean cap_file_hashes    = TRUE;  /* Calculate file hashes */
 #define HASH_BUF_SIZE (1024 * 1024)
 
 
-static gchar file_sha256[HASH_STR_SIZE];
-static gchar file_rmd160[HASH_STR_SIZE];
-static gchar file_sha1[HASH_STR_SIZE];
-
-static guint num_ipv4_addresses;
-static guint num_ipv6_addresses;
-static guint num_decryption_secrets;
-
 /*
  * If we have at least two packets with time stamps, and they're not in
  * order - i.e., the later packet has a time stamp older than the earlier
@@ -219,8 +214,22 @@ typedef struct _capture_info {
   GArray               *interface_packet_counts;  /* array of per_packet interface_id counts; one entry per file IDB */
   guint32               pkt_interface_id_unknown; /* counts if packet interface_id didn't match a known one */
   GArray               *idb_info_strings;         /* array of IDB info strings */
+
+  guint                 num_ipv4_addresses;
+  guint                 num_ipv6_addresses;
+  guint                 num_decryption_secrets;
+
+  gchar                 file_sha256[HASH_STR_SIZE];
+  gchar                 file_rmd160[HASH_STR_SIZE];
+  gchar                 file_sha1[HASH_STR_SIZE];
 } capture_info;
 
+/*
+ * The capture_info of the file being read by this thread, for the
+ * wiretap callbacks, which aren't told which file they're called for.
+ */
+static GPrivate counted_cf_info;
+
 static char *decimal_point;
 
 static void
@@ -743,9 +752,9 @@ print_stats(const gchar *filename, capture_info *cf_info)
     }
   }
   if (cap_file_hashes) {
-    printf     ("SHA256:              %s\n", file_sha256);
-    printf     ("RIPEMD160:           %s\n", file_rmd160);
-    printf     ("SHA1:                %s\n", file_sha1);
+    printf     ("SHA256:              %s\n", cf_info->file_sha256);
+    printf     ("RIPEMD160:           %s\n", cf_info->file_rmd160);
+    printf     ("SHA1:                %s\n", cf_info->file_sha1);
   }
   if (cap_order)          printf     ("Strict time order:   %s\n", order_string(cf_info->order));
 
@@ -798,14 +807,14 @@ print_stats(const gchar *filename, capture_info *cf_info)
     }
 
     if (cap_file_nrb) {
-      if (num_ipv4_addresses != 0)
-        printf   ("Number of resolved IPv4 addresses in file: %u\n", num_ipv4_addresses);
-      if (num_ipv6_addresses != 0)
-        printf   ("Number of resolved IPv6 addresses in file: %u\n", num_ipv6_addresses);
+      if (cf_info->num_ipv4_addresses != 0)
+        printf   ("Number of resolved IPv4 addresses in file: %u\n", cf_info->num_ipv4_addresses);
+      if (cf_info->num_ipv6_addresses != 0)
+        printf   ("Number of resolved IPv6 addresses in file: %u\n", cf_info->num_ipv6_addresses);
     }
     if (cap_file_dsb) {
-      if (num_decryption_secrets != 0)
-        printf   ("Number of decryption secrets in file: %u\n", num_decryption_secrets);
+      if (cf_info->num_decryption_secrets != 0)
+        printf   ("Number of decryption secrets in file: %u\n", cf_info->num_decryption_secrets);
     }
   }
 }
@@ -1025,17 +1034,17 @@ print_stats_table(const gchar *filename, capture_info *cf_info)
   if (cap_file_hashes) {
     putsep();
     putquote();
-    printf("%s", file_sha256);
+    printf("%s", cf_info->file_sha256);
     putquote();
 
     putsep();
     putquote();
-    printf("%s", file_rmd160);
+    printf("%s", cf_info->file_rmd160);
     putquote();
 
     putsep();
     putquote();
-    printf("%s", file_sha1);
+    printf("%s", cf_info->file_sha1);
     putquote();
   }
 
@@ -1146,13 +1155,13 @@ cleanup_capture_info(capture_info *cf_info)
 static void
 count_ipv4_address(const guint addr _U_, const gchar *name _U_)
 {
-  num_ipv4_addresses++;
+  ((capture_info *)g_private_get(&counted_cf_info))->num_ipv4_addresses++;
 }
 
 static void
 count_ipv6_address(const void *addrp _U_, const gchar *name _U_)
 {
-  num_ipv6_addresses++;
+  ((capture_info *)g_private_get(&counted_cf_info))->num_ipv6_addresses++;
 }
 
 static void
@@ -1160,24 +1169,78 @@ count_decryption_secret(guint32 secrets_type _U_, const void *secrets _U_, guint
 {
   /* XXX - count them based on the secrets type (which is an opaque code,
      not a small integer)? */
-  num_decryption_secrets++;
+  ((capture_info *)g_private_get(&counted_cf_info))->num_decryption_secrets++;
+}
+
+static void
+hash_to_str(const unsigned char *hash, size_t length, char *str) {
+  int i;
+
+  for (i = 0; i < (int) length; i++) {
+    g_snprintf(str+(i*2), 3, "%02x", hash[i]);
+  }
 }
 
+static void
+calculate_hashes(const char *filename, capture_info *cf_info)
+{
+  FILE         *fh;
+  char         *hash_buf;
+  gcry_md_hd_t  hd = NULL;
+  size_t        hash_bytes;
+
+  g_strlcpy(cf_info->file_sha256, "<unknown>", HASH_STR_SIZE);
+  g_strlcpy(cf_info->file_rmd160, "<unknown>", HASH_STR_SIZE);
+  g_strlcpy(cf_info->file_sha1, "<unknown>", HASH_STR_SIZE);
+
+  if (!cap_file_hashes)
+    return;
+
+  gcry_md_open(&hd, GCRY_MD_SHA256, 0);
+  if (!hd)
+    return;
+  gcry_md_enable(hd, GCRY_MD_RMD160);
+  gcry_md_enable(hd, GCRY_MD_SHA1);
+
+  fh = ws_fopen(filename, "rb");
+  if (fh) {
+    hash_buf = (char *)g_malloc(HASH_BUF_SIZE);
+    while((hash_bytes = fread(hash_buf, 1, HASH_BUF_SIZE, fh)) > 0) {
+      gcry_md_write(hd, hash_buf, hash_bytes);
+    }
+    gcry_md_final(hd);
+    hash_to_str(gcry_md_read(hd, GCRY_MD_SHA256), HASH_SIZE_SHA256, cf_info->file_sha256);
+    hash_to_str(gcry_md_read(hd, GCRY_MD_RMD160), HASH_SIZE_RMD160, cf_info->file_rmd160);
+    hash_to_str(gcry_md_read(hd, GCRY_MD_SHA1), HASH_SIZE_SHA1, cf_info->file_sha1);
+    g_free(hash_buf);
+    fclose(fh);
+  }
+  gcry_md_close(hd);
+}
+
+/*
+ * Read a file and fill in its capture_info, leaving it open for the
+ * report.  This doesn't print anything but errors, so that it can be done
+ * for several files at once; report_cap_file() prints the report and
+ * closes the file.  Returns 2, with nothing to report, if the file couldn't
+ * be read, 1 if it couldn't be read to the end, and 0 otherwise.
+ */
 static int
-process_cap_file(const char *filename, gboolean need_separator)
+read_cap_file(const char *filename, capture_info *p_cf_info)
 {
   int                   status = 0;
   int                   err;
   gchar                *err_info;
   gint64                size;
-  gint64                data_offset;
 
   guint32               packet = 0;
   gint64                bytes  = 0;
   guint32               snaplen_min_inferred = 0xffffffff;
   guint32               snaplen_max_inferred =          0;
-  wtap_rec              rec;
-  Buffer                buf;
+  wtap_batch            batch;
+  wtap_rec             *rec;
+  guint                 rec_num;
+  gboolean              more;
   capture_info          cf_info;
   gboolean              have_times = TRUE;
   nstime_t              start_time;
@@ -1191,16 +1254,13 @@ process_cap_file(const char *filename, gboolean need_separator)
   guint                 i;
   wtapng_iface_descriptions_t *idb_info;
 
+  memset(&cf_info, 0, sizeof cf_info);
   cf_info.wth = wtap_open_offline(filename, WTAP_TYPE_AUTO, &err, &err_info, FALSE);
   if (!cf_info.wth) {
     cfile_open_failure_message(filename, err, err_info);
     return 2;
   }
 
-  if (need_separator && long_report) {
-    printf("\n");
-  }
-
   nstime_set_zero(&start_time);
   start_time_tsprec = WTAP_TSPREC_UNKNOWN;
   nstime_set_zero(&stop_time);
@@ -1223,110 +1283,114 @@ process_cap_file(const char *filename, gboolean need_separator)
   idb_info = NULL;
 
   /* Register callbacks for new name<->address maps from the file and
-     decryption secrets from the file. */
+     decryption secrets from the file; they count them in cf_info, whose
+     counters start at zero.  Registering the decryption secrets callback
+     calls it for those already read. */
+  g_private_set(&counted_cf_info, &cf_info);
   wtap_set_cb_new_ipv4(cf_info.wth, count_ipv4_address);
   wtap_set_cb_new_ipv6(cf_info.wth, count_ipv6_address);
   wtap_set_cb_new_secrets(cf_info.wth, count_decryption_secret);
 
-  /* Zero out the counters for the callbacks. */
-  num_ipv4_addresses = 0;
-  num_ipv6_addresses = 0;
-  num_decryption_secrets = 0;
+  /* We only look at the records, not at what the packets contain. */
+  wtap_set_headers_only(cf_info.wth, TRUE);
 
   /* Tally up data that we need to parse through the file to find */
-  wtap_rec_init(&rec);
-  ws_buffer_init(&buf, 1514);
-  while (wtap_read(cf_info.wth, &rec, &buf, &err, &err_info, &data_offset))  {
-    if (rec.presence_flags & WTAP_HAS_TS) {
-      prev_time = cur_time;
-      cur_time = rec.ts;
-      if (packet == 0) {
-        start_time = rec.ts;
-        start_time_tsprec = rec.tsprec;
-        stop_time  = rec.ts;
-        stop_time_tsprec = rec.tsprec;
-        prev_time  = rec.ts;
-      }
-      if (nstime_cmp(&cur_time, &prev_time) < 0) {
-        order = NOT_IN_ORDER;
-      }
-      if (nstime_cmp(&cur_time, &start_time) < 0) {
-        start_time = cur_time;
-        start_time_tsprec = rec.tsprec;
-      }
-      if (nstime_cmp(&cur_time, &stop_time) > 0) {
-        stop_time = cur_time;
-        stop_time_tsprec = rec.tsprec;
-      }
-    } else {
-      have_times = FALSE; /* at least one packet has no time stamp */
-      if (order != NOT_IN_ORDER)
-        order = ORDER_UNKNOWN;
-    }
-
-    if (rec.rec_type == REC_TYPE_PACKET) {
-      bytes += rec.rec_header.packet_header.len;
-      packet++;
-
-      /* If caplen < len for a rcd, then presumably           */
-      /* 'Limit packet capture length' was done for this rcd. */
-      /* Keep track as to the min/max actual snapshot lengths */
-      /*  seen for this file.                                 */
-      if (rec.rec_header.packet_header.caplen < rec.rec_header.packet_header.len) {
-        if (rec.rec_header.packet_header.caplen < snaplen_min_inferred)
-          snaplen_min_inferred = rec.rec_header.packet_header.caplen;
-        if (rec.rec_header.packet_header.caplen > snaplen_max_inferred)
-          snaplen_max_inferred = rec.rec_header.packet_header.caplen;
-      }
-
-      if ((rec.rec_header.packet_header.pkt_encap > 0) &&
-          (rec.rec_header.packet_header.pkt_encap < WTAP_NUM_ENCAP_TYPES)) {
-        cf_info.encap_counts[rec.rec_header.packet_header.pkt_encap] += 1;
+  wtap_batch_init(&batch, 256);
+  more = TRUE;
+  while (more) {
+    more = wtap_read_batch(cf_info.wth, &batch, &err, &err_info);
+    for (rec_num = 0; rec_num < batch.num_recs; rec_num++) {
+      rec = &batch.recs[rec_num];
+      if (rec->presence_flags & WTAP_HAS_TS) {
+        prev_time = cur_time;
+        cur_time = rec->ts;
+        if (packet == 0) {
+          start_time = rec->ts;
+          start_time_tsprec = rec->tsprec;
+          stop_time  = rec->ts;
+          stop_time_tsprec = rec->tsprec;
+          prev_time  = rec->ts;
+        }
+        if (nstime_cmp(&cur_time, &prev_time) < 0) {
+          order = NOT_IN_ORDER;
+        }
+        if (nstime_cmp(&cur_time, &start_time) < 0) {
+          start_time = cur_time;
+          start_time_tsprec = rec->tsprec;
+        }
+        if (nstime_cmp(&cur_time, &stop_time) > 0) {
+          stop_time = cur_time;
+          stop_time_tsprec = rec->tsprec;
+        }
       } else {
-        fprintf(stderr, "capinfos: Unknown packet encapsulation %d in frame %u of file \"%s\"\n",
-                rec.rec_header.packet_header.pkt_encap, packet, filename);
+        have_times = FALSE; /* at least one packet has no time stamp */
+        if (order != NOT_IN_ORDER)
+          order = ORDER_UNKNOWN;
       }
 
-      /* Packet interface_id info */
-      if (rec.presence_flags & WTAP_HAS_INTERFACE_ID) {
-        /* cf_info.num_interfaces is size, not index, so it's one more than max index */
-        if (rec.rec_header.packet_header.interface_id >= cf_info.num_interfaces) {
-          /*
-           * OK, re-fetch the number of interfaces, as there might have
-           * been an interface that was in the middle of packets, and
-           * grow the array to be big enough for the new number of
-           * interfaces.
-           */
-          idb_info = wtap_file_get_idb_info(cf_info.wth);
-
-          cf_info.num_interfaces = idb_info->interface_data->len;
-          g_array_set_size(cf_info.interface_packet_counts, cf_info.num_interfaces);
-
-          g_free(idb_info);
-          idb_info = NULL;
-        }
-        if (rec.rec_header.packet_header.interface_id < cf_info.num_interfaces) {
-          g_array_index(cf_info.interface_packet_counts, guint32,
-                        rec.rec_header.packet_header.interface_id) += 1;
+      if (rec->rec_type == REC_TYPE_PACKET) {
+        bytes += rec->rec_header.packet_header.len;
+        packet++;
+
+        /* If caplen < len for a rcd, then presumably           */
+        /* 'Limit packet capture length' was done for this rcd. */
+        /* Keep track as to the min/max actual snapshot lengths */
+        /*  seen for this file.                                 */
+        if (rec->rec_header.packet_header.caplen < rec->rec_header.packet_header.len) {
+          if (rec->rec_header.packet_header.caplen < snaplen_min_inferred)
+            snaplen_min_inferred = rec->rec_header.packet_header.caplen;
+          if (rec->rec_header.packet_header.caplen > snaplen_max_inferred)
+            snaplen_max_inferred = rec->rec_header.packet_header.caplen;
         }
-        else {
-          cf_info.pkt_interface_id_unknown += 1;
+
+        if ((rec->rec_header.packet_header.pkt_encap > 0) &&
+            (rec->rec_header.packet_header.pkt_encap < WTAP_NUM_ENCAP_TYPES)) {
+          cf_info.encap_counts[rec->rec_header.packet_header.pkt_encap] += 1;
+        } else {
+          fprintf(stderr, "capinfos: Unknown packet encapsulation %d in frame %u of file \"%s\"\n",
+                  rec->rec_header.packet_header.pkt_encap, packet, filename);
         }
-      }
-      else {
-        /* it's for interface_id 0 */
-        if (cf_info.num_interfaces != 0) {
-          g_array_index(cf_info.interface_packet_counts, guint32, 0) += 1;
+
+        /* Packet interface_id info */
+        if (rec->presence_flags & WTAP_HAS_INTERFACE_ID) {
+          /* cf_info.num_interfaces is size, not index, so it's one more than max index */
+          if (rec->rec_header.packet_header.interface_id >= cf_info.num_interfaces) {
+            /*
+             * OK, re-fetch the number of interfaces, as there might have
+             * been an interface that was in the middle of packets, and
+             * grow the array to be big enough for the new number of
+             * interfaces.
+             */
+            idb_info = wtap_file_get_idb_info(cf_info.wth);
+
+            cf_info.num_interfaces = idb_info->interface_data->len;
+            g_array_set_size(cf_info.interface_packet_counts, cf_info.num_interfaces);
+
+            g_free(idb_info);
+            idb_info = NULL;
+          }
+          if (rec->rec_header.packet_header.interface_id < cf_info.num_interfaces) {
+            g_array_index(cf_info.interface_packet_counts, guint32,
+                          rec->rec_header.packet_header.interface_id) += 1;
+          }
+          else {
+            cf_info.pkt_interface_id_unknown += 1;
+          }
         }
         else {
-          cf_info.pkt_interface_id_unknown += 1;
+          /* it's for interface_id 0 */
+          if (cf_info.num_interfaces != 0) {
+            g_array_index(cf_info.interface_packet_counts, guint32, 0) += 1;
+          }
+          else {
+            cf_info.pkt_interface_id_unknown += 1;
+          }
         }
       }
-    }
 
+    }
   } /* while */
-  wtap_rec_cleanup(&rec);
-  ws_buffer_free(&buf);
+  wtap_batch_cleanup(&batch);
 
   /*
    * Get IDB info strings.
@@ -1431,16 +1495,127 @@ process_cap_file(const char *filename, gboolean need_separator)
     cf_info.packet_size = (double)bytes / packet;                  /* Avg packet size      */
   }
 
+  calculate_hashes(filename, &cf_info);
+
+  g_private_set(&counted_cf_info, NULL);
+  *p_cf_info = cf_info;
+  return status;
+}
+
+/* Print the report for a file read by read_cap_file(), and close it */
+static void
+report_cap_file(const char *filename, capture_info *cf_info, gboolean need_separator)
+{
+  if (need_separator && long_report) {
+    printf("\n");
+  }
+
   if (long_report) {
-    print_stats(filename, &cf_info);
+    print_stats(filename, cf_info);
   } else {
-    print_stats_table(filename, &cf_info);
+    print_stats_table(filename, cf_info);
   }
 
-  cleanup_capture_info(&cf_info);
-  wtap_close(cf_info.wth);
+  cleanup_capture_info(cf_info);
+  wtap_close(cf_info->wth);
+}
 
-  return status;
+/*
+ * Reading several files at once: the files are read by a thread pool,
+ * no more than a few files ahead of the one being reported, and reported
+ * in the order they were given, so the output is the same as when they're
+ * read one after the other.
+ */
+typedef struct {
+  const char   *filename;
+  capture_info  cf_info;
+  int           status;
+  gboolean      done;
+} cap_file_job_t;
+
+static GMutex jobs_mutex;
+static GCond  jobs_cond;
+
+static void
+read_cap_file_job(gpointer data, gpointer user_data _U_)
+{
+  cap_file_job_t *job = (cap_file_job_t *)data;
+
+  job->status = read_cap_file(job->filename, &job->cf_info);
+
+  g_mutex_lock(&jobs_mutex);
+  job->done = TRUE;
+  g_cond_broadcast(&jobs_cond);
+  g_mutex_unlock(&jobs_mutex);
+}
+
+/* Read and report the files, with num_threads threads if there are
+   several; returns the status of the last one that failed, or 0. */
+static int
+process_cap_files(char **filenames, int num_files)
+{
+  int             overall_status = 0;
+  int             status;
+  gboolean        need_separator = FALSE;
+  GThreadPool    *pool = NULL;
+  cap_file_job_t *jobs;
+  int             max_ahead;
+  int             next_job = 0;
+  int             i;
+
+  jobs = g_new0(cap_file_job_t, num_files);
+  if (num_threads > 1 && num_files > 1) {
+    pool = g_thread_pool_new(read_cap_file_job, NULL, num_threads, TRUE, NULL);
+  }
+  /* Files read but not reported yet are kept open; don't get far ahead. */
+  max_ahead = pool ? 2 * num_threads : 1;
+
+  for (i = 0; i < num_files; i++) {
+    if (pool) {
+      for (; next_job < num_files && next_job < i + max_ahead; next_job++) {
+        jobs[next_job].filename = filenames[next_job];
+        g_thread_pool_push(pool, &jobs[next_job], NULL);
+      }
+      g_mutex_lock(&jobs_mutex);
+      while (!jobs[i].done)
+        g_cond_wait(&jobs_cond, &jobs_mutex);
+      g_mutex_unlock(&jobs_mutex);
+      status = jobs[i].status;
+    } else {
+      status = read_cap_file(filenames[i], &jobs[i].cf_info);
+    }
+
+    if (status != 2) {
+      /* Either it succeeded or it got a "short read" but has
+         information anyway.  Note that we need a blank line before
+         the next file's information, to separate it from the
+         previous file. */
+      report_cap_file(filenames[i], &jobs[i].cf_info, need_separator);
+      need_separator = TRUE;
+    }
+    if (status) {
+      /* Something failed.  It's been reported; remember that processing
+         one file failed and, if -C was specified, stop. */
+      overall_status = status;
+      if (stop_after_failure)
+        break;
+    }
+  }
+
+  if (pool) {
+    /* Drop the files not started, and close the ones read but not
+       reported. */
+    g_thread_pool_free(pool, TRUE, TRUE);
+    for (i++; i < next_job; i++) {
+      if (jobs[i].done && jobs[i].status != 2) {
+        cleanup_capture_info(&jobs[i].cf_info);
+        wtap_close(jobs[i].cf_info.wth);
+      }
+    }
+  }
+  g_free(jobs);
+
+  return overall_status;
 }
 
 static void
@@ -1500,6 +1675,7 @@ print_usage(FILE *output)
   fprintf(output, "Miscellaneous:\n");
   fprintf(output, "  -h display this help and exit\n");
   fprintf(output, "  -C cancel processing if file open fails (default is to continue)\n");
+  fprintf(output, "  -j <threads> read up to <threads> files at the same time (default is 1)\n");
   fprintf(output, "  -A generate all infos (default)\n");
   fprintf(output, "  -K disable displaying the capture comment\n");
   fprintf(output, "\n");
@@ -1531,15 +1707,6 @@ capinfos_cmdarg_err_cont(const char *msg_format, va_list ap)
   fprintf(stderr, "\n");
 }
 
-static void
-hash_to_str(const unsigned char *hash, size_t length, char *str) {
-  int i;
-
-  for (i = 0; i < (int) length; i++) {
-    g_snprintf(str+(i*2), 3, "%02x", hash[i]);
-  }
-}
-
 int
 main(int argc, char *argv[])
 {
@@ -1556,7 +1723,6 @@ main(int argc, char *argv[])
       cfile_write_failure_message,
       cfile_close_failure_message
   };
-  gboolean need_separator = FALSE;
   int    opt;
   int    overall_error_status = EXIT_SUCCESS;
   static const struct option long_options[] = {
@@ -1565,12 +1731,6 @@ main(int argc, char *argv[])
       {0, 0, 0, 0 }
   };
 
-  int status = 0;
-  FILE  *fh;
-  char  *hash_buf = NULL;
-  gcry_md_hd_t hd = NULL;
-  size_t hash_bytes;
-
   /*
    * Set the C-language locale to the native environment and set the
    * code page to UTF-8 on Windows.
@@ -1615,7 +1775,7 @@ main(int argc, char *argv[])
   wtap_init(TRUE);
 
   /* Process the options */
-  while ((opt = getopt_long(argc, argv, "abcdehiklmnoqrstuvxyzABCDEFHIKLMNQRST", long_options, NULL)) !=-1) {
+  while ((opt = getopt_long(argc, argv, "abcdehij:klmnoqrstuvxyzABCDEFHIKLMNQRST", long_options, NULL)) !=-1) {
 
     switch (opt) {
 
@@ -1731,6 +1891,10 @@ main(int argc, char *argv[])
         stop_after_failure = TRUE;
         break;
 
+      case 'j':
+        num_threads = get_positive_int(optarg, "number of threads");
+        break;
+
       case 'A':
         enable_all_infos();
         break;
@@ -1810,57 +1974,11 @@ main(int argc, char *argv[])
 
   if (cap_file_hashes) {
     gcry_check_version(NULL);
-    gcry_md_open(&hd, GCRY_MD_SHA256, 0);
-    if (hd) {
-      gcry_md_enable(hd, GCRY_MD_RMD160);
-      gcry_md_enable(hd, GCRY_MD_SHA1);
-    }
-    hash_buf = (char *)g_malloc(HASH_BUF_SIZE);
   }
 
-  overall_error_status = 0;
-
-  for (opt = optind; opt < argc; opt++) {
-
-    g_strlcpy(file_sha256, "<unknown>", HASH_STR_SIZE);
-    g_strlcpy(file_rmd160, "<unknown>", HASH_STR_SIZE);
-    g_strlcpy(file_sha1, "<unknown>", HASH_STR_SIZE);
-
-    if (cap_file_hashes) {
-      fh = ws_fopen(argv[opt], "rb");
-      if (fh && hd) {
-        while((hash_bytes = fread(hash_buf, 1, HASH_BUF_SIZE, fh)) > 0) {
-          gcry_md_write(hd, hash_buf, hash_bytes);
-        }
-        gcry_md_final(hd);
-        hash_to_str(gcry_md_read(hd, GCRY_MD_SHA256), HASH_SIZE_SHA256, file_sha256);
-        hash_to_str(gcry_md_read(hd, GCRY_MD_RMD160), HASH_SIZE_RMD160, file_rmd160);
-        hash_to_str(gcry_md_read(hd, GCRY_MD_SHA1), HASH_SIZE_SHA1, file_sha1);
-      }
-      if (fh) fclose(fh);
-      if (hd) gcry_md_reset(hd);
-    }
-
-    status = process_cap_file(argv[opt], need_separator);
-    if (status) {
-      /* Something failed.  It's been reported; remember that processing
-         one file failed and, if -C was specified, stop. */
-      overall_error_status = status;
-      if (stop_after_failure)
-        goto exit;
-    }
-    if (status != 2) {
-      /* Either it succeeded or it got a "short read" but printed
-         information anyway.  Note that we need a blank line before
-         the next file's information, to separate it from the
-         previous file. */
-      need_separator = TRUE;
-    }
-  }
+  overall_error_status = process_cap_files(argv + optind, argc - optind);
 
 exit:
-  g_free(hash_buf);
-  gcry_md_close(hd);
   wtap_cleanup();
   free_progdirs();
   return overall_error_status;
@@ -63,6 +63,8 @@ static pcap_t* (*p_pcap_open_live) (const char *, int, int, int, char *);
 static int     (*p_pcap_loop) (pcap_t *, int, pcap_handler, guchar *);
 static pcap_t* (*p_pcap_open_dead) (int, int);
 static void    (*p_pcap_freecode) (struct bpf_program *);
+static int     (*p_pcap_offline_filter) (const struct bpf_program *,
+			const struct pcap_pkthdr *, const u_char *);
 static int     (*p_pcap_findalldevs) (pcap_if_t **, char *);
 static void    (*p_pcap_freealldevs) (pcap_if_t *);
 static int (*p_pcap_datalink_name_to_val) (const char *);
@@ -152,6 +154,7 @@ load_wpcap(void)
 #endif
 		SYM(pcap_loop, FALSE),
 		SYM(pcap_freecode, FALSE),
+		SYM(pcap_offline_filter, FALSE),
 		SYM(pcap_findalldevs, FALSE),
 		SYM(pcap_freealldevs, FALSE),
 		SYM(pcap_datalink_name_to_val, FALSE),
@@ -467,6 +470,14 @@ pcap_freecode(struct bpf_program *a)
 	p_pcap_freecode(a);
 }
 
+int
+pcap_offline_filter(const struct bpf_program *a, const struct pcap_pkthdr *b,
+		    const u_char *c)
+{
+	g_assert(has_wpcap);
+	return p_pcap_offline_filter(a, b, c);
+}
+
 int
 pcap_findalldevs(pcap_if_t **a, char *errbuf)
 {
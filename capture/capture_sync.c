@@ -453,6 +453,13 @@ sync_pipe_start(capture_options *capture_opts, capture_session *cap_session, inf
         argv = sync_pipe_add_arg(argv, &argc, "--compress-type");
         argv = sync_pipe_add_arg(argv, &argc, capture_opts->compress_type);
     }
+    if (capture_opts->update_interval != DEFAULT_UPDATE_INTERVAL) {
+        char sinterval[ARGV_NUMBER_LEN];
+
+        argv = sync_pipe_add_arg(argv, &argc, "--update-interval");
+        g_snprintf(sinterval, ARGV_NUMBER_LEN, "%u", capture_opts->update_interval);
+        argv = sync_pipe_add_arg(argv, &argc, sinterval);
+    }
 
 #ifdef _WIN32
     /* init SECURITY_ATTRIBUTES */
@@ -0,0 +1,193 @@
+/* capture_flow.c
+ * dumpcap's parsing of the flows packets belong to
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <wsutil/pint.h>
+
+#include "capture_flow.h"
+
+/* The link-layer types whose headers we know; LINKTYPE_ and DLT_ values. */
+#define LT_ETHERNET         1
+#define LT_RAW_12           12      /* DLT_RAW on most platforms */
+#define LT_RAW_14           14      /* DLT_RAW on OpenBSD */
+#define LT_RAW              101
+#define LT_LINUX_SLL        113
+#define LT_IPV4             228
+#define LT_IPV6             229
+
+#define ETHERTYPE_IPV4      0x0800
+#define ETHERTYPE_IPV6      0x86dd
+#define ETHERTYPE_VLAN      0x8100
+#define ETHERTYPE_QINQ      0x88a8
+#define ETHERTYPE_QINQ_OLD  0x9100
+
+#define IP_PROTO_TCP        6
+#define IP_PROTO_UDP        17
+#define IP_PROTO_SCTP       132
+
+gboolean
+capture_flow_parse(int linktype, const guint8 *pd, guint32 caplen,
+                   capture_flow_key *key)
+{
+    guint32 off = 0, hlen;
+    guint16 ethertype;
+    guint8 version, next;
+    gboolean first_fragment = TRUE;
+    int tags;
+
+    switch (linktype) {
+
+    case LT_ETHERNET:
+        if (caplen < 14)
+            return FALSE;
+        ethertype = pntoh16(pd + 12);
+        off = 14;
+        for (tags = 0; tags < 2 && (ethertype == ETHERTYPE_VLAN ||
+                                    ethertype == ETHERTYPE_QINQ ||
+                                    ethertype == ETHERTYPE_QINQ_OLD); tags++) {
+            if (caplen < off + 4)
+                return FALSE;
+            ethertype = pntoh16(pd + off + 2);
+            off += 4;
+        }
+        if (ethertype != ETHERTYPE_IPV4 && ethertype != ETHERTYPE_IPV6)
+            return FALSE;
+        break;
+
+    case LT_LINUX_SLL:
+        if (caplen < 16)
+            return FALSE;
+        ethertype = pntoh16(pd + 14);
+        if (ethertype != ETHERTYPE_IPV4 && ethertype != ETHERTYPE_IPV6)
+            return FALSE;
+        off = 16;
+        break;
+
+    case LT_RAW_12:
+    case LT_RAW_14:
+    case LT_RAW:
+    case LT_IPV4:
+    case LT_IPV6:
+        break;
+
+    default:
+        return FALSE;
+    }
+
+    if (caplen < off + 1)
+        return FALSE;
+    version = pd[off] >> 4;
+    if (version == 4) {
+        if (caplen < off + 20)
+            return FALSE;
+        hlen = (pd[off] & 0x0f) * 4;
+        if (hlen < 20)
+            return FALSE;
+        /* Only the first fragment has the transport-layer header. */
+        first_fragment = (pntoh16(pd + off + 6) & 0x1fff) == 0;
+        next = pd[off + 9];
+        key->addr_len = 4;
+        memcpy(key->src, pd + off + 12, 4);
+        memcpy(key->dst, pd + off + 16, 4);
+        off += hlen;
+    } else if (version == 6) {
+        if (caplen < off + 40)
+            return FALSE;
+        next = pd[off + 6];
+        key->addr_len = 16;
+        memcpy(key->src, pd + off + 8, 16);
+        memcpy(key->dst, pd + off + 24, 16);
+        off += 40;
+        /* Skip the extension headers that come before the transport header. */
+        for (;;) {
+            if (next == 0 || next == 43 || next == 60) {
+                /* Hop-by-hop, routing, destination options */
+                if (caplen < off + 2)
+                    return FALSE;
+                hlen = (pd[off + 1] + 1) * 8;
+            } else if (next == 44) {
+                /* Fragment */
+                if (caplen < off + 8)
+                    return FALSE;
+                if ((pntoh16(pd + off + 2) & 0xfff8) != 0)
+                    first_fragment = FALSE;
+                hlen = 8;
+            } else {
+                break;
+            }
+            next = pd[off];
+            off += hlen;
+        }
+    } else {
+        return FALSE;
+    }
+
+    key->ip_proto = next;
+    key->src_port = key->dst_port = CAPTURE_FLOW_NO_PORT;
+    if (first_fragment &&
+        (next == IP_PROTO_TCP || next == IP_PROTO_UDP || next == IP_PROTO_SCTP)) {
+        if (caplen < off + 4)
+            return FALSE;
+        key->src_port = pntoh16(pd + off);
+        key->dst_port = pntoh16(pd + off + 2);
+    }
+    return TRUE;
+}
+
+/* FNV-1a of an address and port. */
+static guint32
+endpoint_hash(const guint8 *addr, guint addr_len, guint32 port)
+{
+    guint32 h = 2166136261U;
+    guint i;
+
+    for (i = 0; i < addr_len; i++)
+        h = (h ^ addr[i]) * 16777619U;
+    for (i = 0; i < 4; i++)
+        h = (h ^ ((port >> (i * 8)) & 0xff)) * 16777619U;
+    return h;
+}
+
+guint32
+capture_flow_hash(const capture_flow_key *key)
+{
+    guint32 h;
+
+    /* Adding the endpoints' hashes makes it the same both ways. */
+    h = endpoint_hash(key->src, key->addr_len, key->src_port) +
+        endpoint_hash(key->dst, key->addr_len, key->dst_port);
+    h ^= key->ip_proto;
+
+    /* Mix the bits, so that any of them can pick a bucket. */
+    h ^= h >> 16;
+    h *= 0x85ebca6bU;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35U;
+    h ^= h >> 16;
+    return h;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,64 @@
+/* capture_flow.h
+ * Definitions for dumpcap's and TShark's parsing of the flows packets
+ * belong to
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __CAPTURE_FLOW_H__
+#define __CAPTURE_FLOW_H__
+
+#include <glib.h>
+
+#define CAPTURE_FLOW_NO_PORT    G_MAXUINT32
+
+/*
+ * What dumpcap can find out, without dissecting it, about the flow a
+ * packet belongs to.  The headers are parsed only for Ethernet (with up
+ * to two VLAN tags), Linux cooked and raw IP link-layer types; IPv6
+ * extension headers before the transport header are skipped.
+ */
+typedef struct {
+    guint8  ip_proto;           /**< the IP protocol of the transport-layer header */
+    guint8  addr_len;           /**< 4 for IPv4, 16 for IPv6 */
+    guint8  src[16];            /**< the source address */
+    guint8  dst[16];            /**< the destination address */
+    guint32 src_port;           /**< the TCP, UDP or SCTP source port, or CAPTURE_FLOW_NO_PORT */
+    guint32 dst_port;           /**< the TCP, UDP or SCTP destination port, or CAPTURE_FLOW_NO_PORT */
+} capture_flow_key;
+
+/** Find the flow of a packet.
+ *
+ * The ports are only found for unfragmented packets and first fragments.
+ *
+ * @param linktype the DLT_ or LINKTYPE_ value of the packet
+ * @param pd the packet data
+ * @param caplen the number of bytes of it that were captured
+ * @param key filled in with the flow
+ * @return FALSE if it's not an IP packet, or its headers weren't all
+ * captured
+ */
+gboolean capture_flow_parse(int linktype, const guint8 *pd, guint32 caplen,
+                            capture_flow_key *key);
+
+/** Hash a flow, giving the same value for both of its directions. */
+guint32 capture_flow_hash(const capture_flow_key *key);
+
+#endif /* __CAPTURE_FLOW_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -28,6 +28,7 @@
 #include <ui/cmdarg_err.h>
 #include <wsutil/file_util.h>
 #include <wsutil/ws_pipe.h>
+#include <wsutil/stream_compress.h>
 
 #include "capture/capture_ifinfo.h"
 #include "capture/capture-pcap-util.h"
@@ -119,6 +120,7 @@ capture_opts_init(capture_options *capture_opts)
     capture_opts->capture_child                   = FALSE;
     capture_opts->print_file_names                = FALSE;
     capture_opts->print_name_to                   = NULL;
+    capture_opts->update_interval                 = DEFAULT_UPDATE_INTERVAL;
     capture_opts->compress_type                   = NULL;
 }
 
@@ -258,6 +260,7 @@ capture_opts_log(const char *log_domain, GLogLevelFlags log_level, capture_optio
     g_log(log_domain, log_level, "AutostopPackets (%u) : %u", capture_opts->has_autostop_packets, capture_opts->autostop_packets);
     g_log(log_domain, log_level, "AutostopFilesize(%u) : %u (KB)", capture_opts->has_autostop_filesize, capture_opts->autostop_filesize);
     g_log(log_domain, log_level, "AutostopDuration(%u) : %.3f", capture_opts->has_autostop_duration, capture_opts->autostop_duration);
+    g_log(log_domain, log_level, "UpdateInterval      : %u (ms)", capture_opts->update_interval);
 }
 
 /*
@@ -991,12 +994,25 @@ capture_opts_add_opt(capture_options *capture_opts, int opt, const char *optarg_
             ;
         } else if (strcmp(optarg_str_p, "gzip") == 0) {
             ;
+        } else if (strcmp(optarg_str_p, "zstd") == 0) {
+            if (!ws_cstream_type_supported(WS_CSTREAM_ZSTD)) {
+                cmdarg_err("zstd compression isn't supported by this build");
+                return 1;
+            }
+        } else if (strcmp(optarg_str_p, "lz4") == 0) {
+            if (!ws_cstream_type_supported(WS_CSTREAM_LZ4)) {
+                cmdarg_err("LZ4 compression isn't supported by this build");
+                return 1;
+            }
         } else {
-            cmdarg_err("parameter of --compress-type can be 'none' or 'gzip'");
+            cmdarg_err("parameter of --compress-type can be 'none', 'gzip', 'zstd' or 'lz4'");
             return 1;
         }
         capture_opts->compress_type = g_strdup(optarg_str_p);
         break;
+    case LONGOPT_UPDATE_INTERVAL:  /* interval between reports of new packets */
+        capture_opts->update_interval = get_positive_int(optarg_str_p, "update interval");
+        break;
     default:
         /* the caller is responsible to send us only the right opt's */
         g_assert_not_reached();
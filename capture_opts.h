@@ -47,6 +47,7 @@ extern "C" {
 #define LONGOPT_LIST_TSTAMP_TYPES LONGOPT_BASE_CAPTURE+2
 #define LONGOPT_SET_TSTAMP_TYPE   LONGOPT_BASE_CAPTURE+3
 #define LONGOPT_COMPRESS_TYPE     LONGOPT_BASE_CAPTURE+4
+#define LONGOPT_UPDATE_INTERVAL   LONGOPT_BASE_CAPTURE+5
 
 /*
  * Options for capturing common to all capturing programs.
@@ -88,7 +89,8 @@ extern "C" {
     {"linktype",              required_argument, NULL, 'y'}, \
     {"list-time-stamp-types", no_argument,       NULL, LONGOPT_LIST_TSTAMP_TYPES}, \
     {"time-stamp-type",       required_argument, NULL, LONGOPT_SET_TSTAMP_TYPE}, \
-    {"compress-type",         required_argument, NULL, LONGOPT_COMPRESS_TYPE},
+    {"compress-type",         required_argument, NULL, LONGOPT_COMPRESS_TYPE}, \
+    {"update-interval",       required_argument, NULL, LONGOPT_UPDATE_INTERVAL},
 
 
 #define OPTSTRING_CAPTURE_COMMON \
@@ -317,6 +319,8 @@ typedef struct capture_options_tag {
     gboolean           print_file_names;      /**< TRUE if printing names of completed
                                                    files as we close them */
     gchar             *print_name_to;         /**< output file name */
+    guint              update_interval;       /**< Time in ms between reports of
+                                                   new packets to the parent */
 
     /* internally used (don't touch from outside) */
     gboolean           output_to_pipe;        /**< save_file is a pipe (named or stdout) */
@@ -379,6 +383,9 @@ capture_opts_free_interface_t(interface_t *device);
 /* Default capture buffer size in Mbytes. */
 #define DEFAULT_CAPTURE_BUFFER_SIZE 2
 
+/* Default time in ms between reports of new packets to the parent. */
+#define DEFAULT_UPDATE_INTERVAL 500
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,163 @@
+/* capture_shm_ring.c
+ * Shared memory rings through which extcap tools can send captured data
+ * to dumpcap
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#ifndef _WIN32
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include <glib.h>
+
+#include "capture_shm_ring.h"
+
+struct shm_ring {
+    shm_ring_header *hdr;
+    guint8          *data;
+    guint32          mask;          /**< data_size - 1 */
+    size_t           map_len;
+};
+
+shm_ring *
+shm_ring_open(const char *path, char *errmsg, size_t errmsg_len)
+{
+    shm_ring        *ring;
+    shm_ring_header  hdr;
+    struct stat      st;
+    void            *map;
+    int              fd;
+
+    fd = open(path, O_RDWR);
+    if (fd < 0) {
+        g_snprintf(errmsg, (gulong)errmsg_len,
+                   "Couldn't open the shared memory ring \"%s\": %s.",
+                   path, g_strerror(errno));
+        return NULL;
+    }
+    if (fstat(fd, &st) < 0 || read(fd, &hdr, sizeof hdr) != (ssize_t)sizeof hdr) {
+        g_snprintf(errmsg, (gulong)errmsg_len,
+                   "Couldn't read the shared memory ring \"%s\".", path);
+        close(fd);
+        return NULL;
+    }
+    if (hdr.magic != SHM_RING_MAGIC || hdr.version != SHM_RING_VERSION ||
+        hdr.data_size == 0 || (hdr.data_size & (hdr.data_size - 1)) != 0 ||
+        (guint64)st.st_size < (guint64)SHM_RING_DATA_OFFSET + hdr.data_size) {
+        g_snprintf(errmsg, (gulong)errmsg_len,
+                   "\"%s\" isn't a shared memory ring of a version we support.", path);
+        close(fd);
+        return NULL;
+    }
+
+    map = mmap(NULL, SHM_RING_DATA_OFFSET + (size_t)hdr.data_size,
+               PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        g_snprintf(errmsg, (gulong)errmsg_len,
+                   "Couldn't map the shared memory ring \"%s\": %s.",
+                   path, g_strerror(errno));
+        return NULL;
+    }
+    /* The mapping keeps it, so it needn't be left behind. */
+    unlink(path);
+
+    ring = g_new(shm_ring, 1);
+    ring->hdr = (shm_ring_header *)map;
+    ring->data = (guint8 *)map + SHM_RING_DATA_OFFSET;
+    ring->mask = hdr.data_size - 1;
+    ring->map_len = SHM_RING_DATA_OFFSET + (size_t)hdr.data_size;
+    return ring;
+}
+
+guint32
+shm_ring_available(shm_ring *ring)
+{
+    guint32 head = (guint32)g_atomic_int_get(&ring->hdr->head);
+    guint32 tail = (guint32)ring->hdr->tail;
+
+    return head - tail;
+}
+
+size_t
+shm_ring_read(shm_ring *ring, char *buf, size_t sz)
+{
+    guint32 avail = shm_ring_available(ring);
+    guint32 tail = (guint32)ring->hdr->tail;
+    guint32 off, n, first;
+
+    if (avail > ring->mask + 1) {
+        /* The writer has gone wrong; don't read outside the ring. */
+        avail = ring->mask + 1;
+    }
+    n = sz < avail ? (guint32)sz : avail;
+    off = tail & ring->mask;
+    first = MIN(n, ring->mask + 1 - off);
+    memcpy(buf, ring->data + off, first);
+    memcpy(buf + first, ring->data, n - first);
+    /* Let the writer have the space only once we've copied out of it. */
+    g_atomic_int_set(&ring->hdr->tail, (gint)(tail + n));
+    return n;
+}
+
+gboolean
+shm_ring_closed(shm_ring *ring)
+{
+    return g_atomic_int_get(&ring->hdr->closed) != 0;
+}
+
+gboolean
+shm_ring_wait_begin(shm_ring *ring)
+{
+    /* A full barrier between storing the flag and looking at head. */
+    g_atomic_int_compare_and_exchange(&ring->hdr->reader_waiting, 0, 1);
+    if (shm_ring_available(ring) != 0 || shm_ring_closed(ring)) {
+        shm_ring_wait_end(ring);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void
+shm_ring_wait_end(shm_ring *ring)
+{
+    g_atomic_int_set(&ring->hdr->reader_waiting, 0);
+}
+
+void
+shm_ring_close(shm_ring *ring)
+{
+    if (ring == NULL)
+        return;
+    munmap(ring->hdr, ring->map_len);
+    g_free(ring);
+}
+
+#endif /* _WIN32 */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
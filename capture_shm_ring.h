@@ -0,0 +1,120 @@
+/* capture_shm_ring.h
+ * Definitions for the shared memory rings through which extcap tools can
+ * send captured data to dumpcap
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __CAPTURE_SHM_RING_H__
+#define __CAPTURE_SHM_RING_H__
+
+#include <glib.h>
+
+/*
+ * A program writing a capture to dumpcap through a FIFO, as extcap tools
+ * do, can instead put the capture data into a ring in a file mapped into
+ * the memory of both processes, so that it needn't be copied through the
+ * kernel a few bytes at a time.  The data in the ring is exactly what
+ * would have been written to the FIFO: a pcap or pcapng stream.
+ *
+ * The writer creates the ring file, with the header below followed by
+ * the data area, and starts by writing, in its own byte order, to the
+ * FIFO:
+ *
+ *    SHM_RING_MAGIC (32 bits)
+ *    the length of the path of the ring file (32 bits)
+ *    the path, without a terminating NUL
+ *
+ * Dumpcap maps the ring and removes the file.  From then on, the FIFO
+ * carries no data; the writer writes a byte to it, of any value, after
+ * making data available while dumpcap is waiting for some, and closes it
+ * at the end of the capture, after setting the "closed" field.
+ *
+ * head and tail count the bytes written and read, modulo 2^32; the
+ * writer may write, at offset head % data_size of the data area, up to
+ * data_size - (head - tail) bytes, and then advance head.  It has to
+ * wait for dumpcap to advance tail if the ring is full; dumpcap does not
+ * signal that.  So that a wakeup isn't missed, the writer has to store
+ * head and then load reader_waiting, and dumpcap store reader_waiting
+ * and then load head, with a full memory barrier in between.
+ */
+
+#define SHM_RING_MAGIC              0x47525357  /* "WSRG" on a little-endian host */
+#define SHM_RING_VERSION            1
+#define SHM_RING_DATA_OFFSET        4096        /* of the data area, from the start of the file */
+#define SHM_RING_MAX_PATH_LEN       4096
+
+typedef struct {
+    guint32 magic;              /**< SHM_RING_MAGIC */
+    guint32 version;            /**< SHM_RING_VERSION */
+    guint32 data_size;          /**< size of the data area, a power of 2 */
+    guint32 reserved[13];
+    /* Written by the writer, on their own cache line. */
+    volatile gint head;         /**< bytes written */
+    volatile gint closed;       /**< nonzero once nothing more will be written */
+    guint32 reserved_w[14];
+    /* Written by dumpcap, on their own cache line. */
+    volatile gint tail;         /**< bytes read */
+    volatile gint reader_waiting; /**< nonzero if dumpcap is waiting for data */
+    guint32 reserved_r[14];
+} shm_ring_header;
+
+#ifndef _WIN32
+
+typedef struct shm_ring shm_ring;
+
+/** Map a ring file into memory and remove it.
+ *
+ * @param path the path of the file
+ * @param errmsg buffer for an error message
+ * @param errmsg_len size of errmsg
+ * @return the ring, or NULL on error
+ */
+shm_ring *shm_ring_open(const char *path, char *errmsg, size_t errmsg_len);
+
+/** Copy up to sz bytes out of a ring.
+ *
+ * @return the number of bytes copied, 0 if the ring is empty
+ */
+size_t shm_ring_read(shm_ring *ring, char *buf, size_t sz);
+
+/** Get the number of bytes in a ring. */
+guint32 shm_ring_available(shm_ring *ring);
+
+/** Has the writer said it will write no more? */
+gboolean shm_ring_closed(shm_ring *ring);
+
+/** Say that we're about to wait for the writer to signal that there's
+ * data.
+ *
+ * @return FALSE, without waiting having been said, if there already is
+ * data or the writer is done
+ */
+gboolean shm_ring_wait_begin(shm_ring *ring);
+
+/** Say that we're no longer waiting. */
+void shm_ring_wait_end(shm_ring *ring);
+
+/** Unmap a ring. */
+void shm_ring_close(shm_ring *ring);
+
+#endif /* _WIN32 */
+
+#endif /* __CAPTURE_SHM_RING_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,150 @@
+/* capture_slice.c
+ * dumpcap's per-protocol packet slicing rules
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <wsutil/strtoi.h>
+
+#include "capture_flow.h"
+#include "capture_slice.h"
+
+#define IP_PROTO_ANY        -1
+#define IP_PROTO_TCP        6
+#define IP_PROTO_UDP        17
+#define IP_PROTO_SCTP       132
+
+typedef struct {
+    int     ip_proto;           /* IP_PROTO_ANY for any */
+    guint32 port;               /* CAPTURE_FLOW_NO_PORT for any */
+    guint32 length;             /* 0 for the whole packet */
+} slice_rule;
+
+struct capture_slice_rules {
+    GArray *rules;              /* slice_rule, in the order they apply */
+};
+
+capture_slice_rules *
+capture_slice_rules_new(void)
+{
+    capture_slice_rules *rules = g_new(capture_slice_rules, 1);
+
+    rules->rules = g_array_new(FALSE, FALSE, sizeof(slice_rule));
+    return rules;
+}
+
+gboolean
+capture_slice_rules_add(capture_slice_rules *rules, const char *spec,
+                        char **err_str)
+{
+    slice_rule rule;
+    const char *eq, *colon;
+    gchar *proto;
+    guint16 port;
+    guint8 proto_num;
+
+    eq = strchr(spec, '=');
+    if (eq == NULL) {
+        *err_str = g_strdup_printf("The slicing rule \"%s\" has no \"=<length>\".", spec);
+        return FALSE;
+    }
+    if (!ws_strtou32(eq + 1, NULL, &rule.length)) {
+        *err_str = g_strdup_printf("The length in the slicing rule \"%s\" isn't a valid number.", spec);
+        return FALSE;
+    }
+
+    colon = memchr(spec, ':', eq - spec);
+    proto = g_strndup(spec, (colon != NULL ? colon : eq) - spec);
+    if (g_ascii_strcasecmp(proto, "ip") == 0) {
+        rule.ip_proto = IP_PROTO_ANY;
+    } else if (g_ascii_strcasecmp(proto, "tcp") == 0) {
+        rule.ip_proto = IP_PROTO_TCP;
+    } else if (g_ascii_strcasecmp(proto, "udp") == 0) {
+        rule.ip_proto = IP_PROTO_UDP;
+    } else if (g_ascii_strcasecmp(proto, "sctp") == 0) {
+        rule.ip_proto = IP_PROTO_SCTP;
+    } else if (ws_strtou8(proto, NULL, &proto_num)) {
+        rule.ip_proto = proto_num;
+    } else {
+        *err_str = g_strdup_printf("The protocol in the slicing rule \"%s\" isn't ip, tcp, udp, sctp or a protocol number.", spec);
+        g_free(proto);
+        return FALSE;
+    }
+    g_free(proto);
+
+    rule.port = CAPTURE_FLOW_NO_PORT;
+    if (colon != NULL) {
+        gchar *port_str = g_strndup(colon + 1, eq - (colon + 1));
+        gboolean ok = ws_strtou16(port_str, NULL, &port);
+
+        g_free(port_str);
+        if (!ok) {
+            *err_str = g_strdup_printf("The port in the slicing rule \"%s\" isn't a valid port number.", spec);
+            return FALSE;
+        }
+        if (rule.ip_proto != IP_PROTO_TCP && rule.ip_proto != IP_PROTO_UDP &&
+            rule.ip_proto != IP_PROTO_SCTP) {
+            *err_str = g_strdup_printf("The slicing rule \"%s\" has a port, but not for tcp, udp or sctp.", spec);
+            return FALSE;
+        }
+        rule.port = port;
+    }
+
+    g_array_append_val(rules->rules, rule);
+    return TRUE;
+}
+
+void
+capture_slice_rules_free(capture_slice_rules *rules)
+{
+    if (rules == NULL)
+        return;
+    g_array_free(rules->rules, TRUE);
+    g_free(rules);
+}
+
+guint32
+capture_slice_length(const capture_slice_rules *rules, int linktype,
+                     const guint8 *pd, guint32 caplen)
+{
+    const slice_rule *rule;
+    capture_flow_key key;
+    guint i;
+
+    if (!capture_flow_parse(linktype, pd, caplen, &key))
+        return caplen;
+
+    for (i = 0; i < rules->rules->len; i++) {
+        rule = &g_array_index(rules->rules, slice_rule, i);
+        if (rule->ip_proto != IP_PROTO_ANY && rule->ip_proto != key.ip_proto)
+            continue;
+        if (rule->port != CAPTURE_FLOW_NO_PORT &&
+            rule->port != key.src_port && rule->port != key.dst_port)
+            continue;
+        return (rule->length == 0 || rule->length > caplen) ? caplen : rule->length;
+    }
+    return caplen;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,79 @@
+/* capture_slice.h
+ * Definitions for dumpcap's per-protocol packet slicing rules
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __CAPTURE_SLICE_H__
+#define __CAPTURE_SLICE_H__
+
+#include <glib.h>
+
+/*
+ * A set of slicing rules says how much of each packet to write, based on
+ * its IP protocol and TCP, UDP or SCTP ports, so that, for example, only
+ * the headers of bulk TLS traffic are kept but DNS packets are kept
+ * whole.  A rule is written as
+ *
+ *    <protocol>[:<port>]=<length>
+ *
+ * where <protocol> is "ip" (any IPv4 or IPv6 packet), "tcp", "udp",
+ * "sctp", or an IP protocol number; <port>, if given, has to be either
+ * the source or the destination port; and <length> is the number of
+ * bytes to keep, counted from the start of the link-layer header, or 0
+ * to keep the whole packet.  The first rule that matches a packet
+ * applies; packets that no rule matches, or whose headers can't be
+ * parsed, are left as they are, that is, cut to the snapshot length.
+ *
+ * The headers are parsed only for Ethernet (with up to two VLAN tags),
+ * Linux cooked and raw IP link-layer types.  Only the captured length
+ * of a packet changes; its original length is still written.
+ */
+typedef struct capture_slice_rules capture_slice_rules;
+
+/** Create an empty rule set. */
+capture_slice_rules *capture_slice_rules_new(void);
+
+/** Add a rule at the end of a rule set.
+ *
+ * @param rules the rule set
+ * @param spec the rule, as described above
+ * @param err_str set to an error message, to be freed with g_free(), if
+ * the rule is malformed
+ * @return TRUE on success
+ */
+gboolean capture_slice_rules_add(capture_slice_rules *rules, const char *spec,
+                                 char **err_str);
+
+/** Free a rule set; rules may be NULL. */
+void capture_slice_rules_free(capture_slice_rules *rules);
+
+/** Get the number of bytes of a packet to write.
+ *
+ * @param rules the rule set
+ * @param linktype the DLT_ or LINKTYPE_ value of the packet
+ * @param pd the packet data
+ * @param caplen the number of bytes of it that were captured
+ * @return caplen, or less if a rule says so
+ */
+guint32 capture_slice_length(const capture_slice_rules *rules, int linktype,
+                             const guint8 *pd, guint32 caplen);
+
+#endif /* __CAPTURE_SLICE_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
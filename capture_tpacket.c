@@ -0,0 +1,350 @@
+/* capture_tpacket.c
+ * Linux TPACKET_V3 capture rings for dumpcap
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#ifdef HAVE_TPACKET3
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <net/if_arp.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <linux/filter.h>
+
+#include <glib.h>
+
+#include "capture_tpacket.h"
+
+/*
+ * Blocks are retired after this many milliseconds even if they aren't
+ * full, so that packets don't sit in a block on a quiet interface.
+ */
+#define TPACKET_BLOCK_TIMEOUT   100
+
+#define TPACKET_BLOCK_SIZE      (1024 * 1024)
+#define TPACKET_MIN_BLOCKS      4
+#define TPACKET_FRAME_SIZE      2048
+
+#define VLAN_TAG_LEN            4
+
+struct tpacket_ring {
+    int          fd;
+    guint8      *map;
+    size_t       map_len;
+    guint32      block_size;
+    guint32      block_nr;
+    guint32      next;          /**< Next block the kernel will hand over */
+    gint        *in_use;        /**< Per block; TRUE from next_block() until release_block() */
+    guint32      packets;       /**< Kernel statistics, accumulated */
+    guint32      drops;
+};
+
+tpacket_ring *
+tpacket_ring_open(const char *ifname, gboolean promisc, size_t ring_size,
+                  int fanout_group, int *linktype, char *errmsg, size_t errmsg_len)
+{
+    tpacket_ring       *ring;
+    struct ifreq        ifr;
+    struct tpacket_req3 req;
+    struct sockaddr_ll  sll;
+    unsigned int        ifindex;
+    int                 val;
+
+    ifindex = if_nametoindex(ifname);
+    if (ifindex == 0) {
+        g_snprintf(errmsg, errmsg_len, "There is no interface named \"%s\"", ifname);
+        return NULL;
+    }
+
+    ring = g_new0(tpacket_ring, 1);
+    ring->fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+    if (ring->fd == -1) {
+        g_snprintf(errmsg, errmsg_len, "Can't open a packet socket: %s", g_strerror(errno));
+        g_free(ring);
+        return NULL;
+    }
+
+    /*
+     * The kernel strips VLAN tags; we put them back the way libpcap does,
+     * which is only simple for Ethernet.
+     */
+    memset(&ifr, 0, sizeof ifr);
+    g_strlcpy(ifr.ifr_name, ifname, sizeof ifr.ifr_name);
+    if (ioctl(ring->fd, SIOCGIFHWADDR, &ifr) == -1) {
+        g_snprintf(errmsg, errmsg_len, "Can't get the hardware type of \"%s\": %s",
+                   ifname, g_strerror(errno));
+        goto fail;
+    }
+    switch (ifr.ifr_hwaddr.sa_family) {
+
+    case ARPHRD_ETHER:
+    case ARPHRD_LOOPBACK:
+        *linktype = DLT_EN10MB;
+        break;
+
+    default:
+        g_snprintf(errmsg, errmsg_len,
+                   "TPACKET_V3 capture is only supported on Ethernet interfaces; \"%s\" has hardware type %u",
+                   ifname, ifr.ifr_hwaddr.sa_family);
+        goto fail;
+    }
+
+    val = TPACKET_V3;
+    if (setsockopt(ring->fd, SOL_PACKET, PACKET_VERSION, &val, sizeof val) == -1) {
+        g_snprintf(errmsg, errmsg_len, "Can't use TPACKET_V3 on this system: %s", g_strerror(errno));
+        goto fail;
+    }
+
+    /* Leave room in front of each packet to put a VLAN tag back. */
+    val = VLAN_TAG_LEN;
+    if (setsockopt(ring->fd, SOL_PACKET, PACKET_RESERVE, &val, sizeof val) == -1) {
+        g_snprintf(errmsg, errmsg_len, "Can't reserve packet headroom: %s", g_strerror(errno));
+        goto fail;
+    }
+
+    ring->block_size = TPACKET_BLOCK_SIZE;
+    ring->block_nr = (guint32)MAX(ring_size / TPACKET_BLOCK_SIZE, TPACKET_MIN_BLOCKS);
+    memset(&req, 0, sizeof req);
+    req.tp_block_size = ring->block_size;
+    req.tp_block_nr = ring->block_nr;
+    req.tp_frame_size = TPACKET_FRAME_SIZE;
+    req.tp_frame_nr = (ring->block_size / TPACKET_FRAME_SIZE) * ring->block_nr;
+    req.tp_retire_blk_tov = TPACKET_BLOCK_TIMEOUT;
+    if (setsockopt(ring->fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof req) == -1) {
+        g_snprintf(errmsg, errmsg_len, "Can't set up a %u MB capture ring: %s",
+                   (ring->block_size / (1024 * 1024)) * ring->block_nr, g_strerror(errno));
+        goto fail;
+    }
+
+    ring->map_len = (size_t)ring->block_size * ring->block_nr;
+    ring->map = (guint8 *)mmap(NULL, ring->map_len, PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, 0);
+    if (ring->map == MAP_FAILED) {
+        ring->map = NULL;
+        g_snprintf(errmsg, errmsg_len, "Can't map the capture ring: %s", g_strerror(errno));
+        goto fail;
+    }
+    ring->in_use = g_new0(gint, ring->block_nr);
+
+    memset(&sll, 0, sizeof sll);
+    sll.sll_family = AF_PACKET;
+    sll.sll_protocol = htons(ETH_P_ALL);
+    sll.sll_ifindex = (int)ifindex;
+    if (bind(ring->fd, (struct sockaddr *)&sll, sizeof sll) == -1) {
+        g_snprintf(errmsg, errmsg_len, "Can't bind to \"%s\": %s", ifname, g_strerror(errno));
+        goto fail;
+    }
+
+    if (promisc) {
+        struct packet_mreq mr;
+
+        memset(&mr, 0, sizeof mr);
+        mr.mr_ifindex = (int)ifindex;
+        mr.mr_type = PACKET_MR_PROMISC;
+        if (setsockopt(ring->fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mr, sizeof mr) == -1) {
+            g_snprintf(errmsg, errmsg_len, "Can't put \"%s\" into promiscuous mode: %s",
+                       ifname, g_strerror(errno));
+            goto fail;
+        }
+    }
+
+    /*
+     * Spread flows across the rings in the group by hash, reassembling
+     * fragments first so that all of a datagram goes to one ring.
+     */
+    if (fanout_group >= 0) {
+        val = (fanout_group & 0xffff) | ((PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG) << 16);
+        if (setsockopt(ring->fd, SOL_PACKET, PACKET_FANOUT, &val, sizeof val) == -1) {
+            g_snprintf(errmsg, errmsg_len, "Can't join fanout group %d on \"%s\": %s",
+                       fanout_group, ifname, g_strerror(errno));
+            goto fail;
+        }
+    }
+
+    return ring;
+
+fail:
+    tpacket_ring_close(ring);
+    return NULL;
+}
+
+gboolean
+tpacket_ring_set_filter(tpacket_ring *ring, const struct bpf_program *fcode,
+                        char *errmsg, size_t errmsg_len)
+{
+    struct sock_fprog prog;
+
+    /* libpcap's BPF instructions have the same layout as the kernel's. */
+    prog.len = (unsigned short)fcode->bf_len;
+    prog.filter = (struct sock_filter *)(void *)fcode->bf_insns;
+    if (setsockopt(ring->fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof prog) == -1) {
+        g_snprintf(errmsg, errmsg_len, "Can't attach the capture filter: %s", g_strerror(errno));
+        return FALSE;
+    }
+    return TRUE;
+}
+
+int
+tpacket_ring_next_block(tpacket_ring *ring, int timeout_ms, void **block,
+                        char *errmsg, size_t errmsg_len)
+{
+    struct tpacket_block_desc *bd;
+    struct pollfd              pfd;
+
+    /*
+     * If the writer still has the next block, the ring is full; the
+     * kernel is dropping packets until the block comes back.
+     */
+    if (g_atomic_int_get(&ring->in_use[ring->next])) {
+        g_usleep(1000);
+        return 0;
+    }
+
+    bd = (struct tpacket_block_desc *)(void *)(ring->map + (size_t)ring->next * ring->block_size);
+    if (!(g_atomic_int_get((gint *)&bd->hdr.bh1.block_status) & TP_STATUS_USER)) {
+        pfd.fd = ring->fd;
+        pfd.events = POLLIN | POLLERR;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, timeout_ms) == -1) {
+            if (errno == EINTR)
+                return 0;
+            g_snprintf(errmsg, errmsg_len, "Unexpected error from poll: %s", g_strerror(errno));
+            return -1;
+        }
+        if (pfd.revents & POLLERR) {
+            int       err = 0;
+            socklen_t len = sizeof err;
+
+            if (getsockopt(ring->fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err != 0) {
+                if (err == ENETDOWN)
+                    g_snprintf(errmsg, errmsg_len, "The interface went down");
+                else
+                    g_snprintf(errmsg, errmsg_len, "Error on the packet socket: %s", g_strerror(err));
+                return -1;
+            }
+        }
+        /* This reads the status with a barrier, so the packets are visible. */
+        if (!(g_atomic_int_get((gint *)&bd->hdr.bh1.block_status) & TP_STATUS_USER))
+            return 0;
+    }
+
+    g_atomic_int_set(&ring->in_use[ring->next], TRUE);
+    ring->next = (ring->next + 1) % ring->block_nr;
+    *block = bd;
+    return 1;
+}
+
+guint32
+tpacket_block_num_packets(const void *block)
+{
+    return ((const struct tpacket_block_desc *)block)->hdr.bh1.num_pkts;
+}
+
+guint32
+tpacket_block_len(const void *block)
+{
+    return ((const struct tpacket_block_desc *)block)->hdr.bh1.blk_len;
+}
+
+void
+tpacket_block_foreach(void *block, tpacket_packet_cb cb, void *user)
+{
+    const struct tpacket_block_desc *bd = (const struct tpacket_block_desc *)block;
+    guint8  *p = (guint8 *)block + bd->hdr.bh1.offset_to_first_pkt;
+    guint32  i;
+
+    for (i = 0; i < bd->hdr.bh1.num_pkts; i++) {
+        const struct tpacket3_hdr *hdr = (const struct tpacket3_hdr *)(void *)p;
+        guint8  *data = p + hdr->tp_mac;
+        guint32  caplen = hdr->tp_snaplen;
+        guint32  len = hdr->tp_len;
+
+        /*
+         * Put the VLAN tag the kernel stripped back after the MAC
+         * addresses, moving them into the room PACKET_RESERVE left.
+         */
+        if ((hdr->tp_status & TP_STATUS_VLAN_VALID) && caplen >= 2 * ETH_ALEN) {
+            guint16 tag[2];
+
+            tag[0] = htons((hdr->tp_status & TP_STATUS_VLAN_TPID_VALID) ?
+                           hdr->hv1.tp_vlan_tpid : ETH_P_8021Q);
+            tag[1] = htons((guint16)hdr->hv1.tp_vlan_tci);
+            data -= VLAN_TAG_LEN;
+            memmove(data, data + VLAN_TAG_LEN, 2 * ETH_ALEN);
+            memcpy(data + 2 * ETH_ALEN, tag, VLAN_TAG_LEN);
+            caplen += VLAN_TAG_LEN;
+            len += VLAN_TAG_LEN;
+        }
+
+        cb(user, hdr->tp_sec, hdr->tp_nsec, caplen, len, data);
+        p += hdr->tp_next_offset;
+    }
+}
+
+void
+tpacket_ring_release_block(tpacket_ring *ring, void *block)
+{
+    struct tpacket_block_desc *bd = (struct tpacket_block_desc *)block;
+    guint32 index = (guint32)(((guint8 *)block - ring->map) / ring->block_size);
+
+    g_atomic_int_set((gint *)&bd->hdr.bh1.block_status, TP_STATUS_KERNEL);
+    g_atomic_int_set(&ring->in_use[index], FALSE);
+}
+
+gboolean
+tpacket_ring_stats(tpacket_ring *ring, guint32 *packets, guint32 *drops)
+{
+    struct tpacket_stats_v3 st;
+    socklen_t               len = sizeof st;
+
+    /* Reading the statistics resets them, so we keep the totals. */
+    if (getsockopt(ring->fd, SOL_PACKET, PACKET_STATISTICS, &st, &len) == -1)
+        return FALSE;
+    ring->packets += st.tp_packets;
+    ring->drops += st.tp_drops;
+    *packets = ring->packets;
+    *drops = ring->drops;
+    return TRUE;
+}
+
+void
+tpacket_ring_close(tpacket_ring *ring)
+{
+    if (ring->map != NULL)
+        munmap(ring->map, ring->map_len);
+    if (ring->fd != -1)
+        close(ring->fd);
+    g_free(ring->in_use);
+    g_free(ring);
+}
+
+#endif /* HAVE_TPACKET3 */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,99 @@
+/* capture_tpacket.h
+ * Definitions for dumpcap's Linux TPACKET_V3 capture rings
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __CAPTURE_TPACKET_H__
+#define __CAPTURE_TPACKET_H__
+
+#include <glib.h>
+
+#ifdef HAVE_TPACKET3
+
+#include <pcap/bpf.h>
+
+/*
+ * A TPACKET_V3 ring is a PF_PACKET socket whose receive buffer is a set
+ * of blocks mapped into our address space; the kernel fills a block with
+ * packets and hands the whole block over, and we hand it back when we've
+ * written the packets out.  Several rings on one interface can be joined
+ * into a fanout group, so that the kernel spreads the interface's flows
+ * across them and each can be read by its own thread.
+ *
+ * Blocks are handed over in order; a block that has been taken with
+ * tpacket_ring_next_block() stays ours, and the kernel drops packets
+ * rather than overwrite it, until it's given back with
+ * tpacket_ring_release_block(), which may be called from another thread.
+ */
+typedef struct tpacket_ring tpacket_ring;
+
+/** Called for each packet in a block. */
+typedef void (*tpacket_packet_cb)(void *user, guint32 sec, guint32 nsec,
+                                  guint32 caplen, guint32 len, const guint8 *data);
+
+/** Open a ring on an interface.
+ *
+ * @param ifname the interface name
+ * @param promisc TRUE to put the interface into promiscuous mode
+ * @param ring_size the size of the ring, in bytes
+ * @param fanout_group the fanout group ID, or -1 for none
+ * @param linktype set to the DLT_ value for the interface
+ * @param errmsg buffer for an error message
+ * @param errmsg_len size of errmsg
+ * @return the ring, or NULL on error
+ */
+tpacket_ring *tpacket_ring_open(const char *ifname, gboolean promisc,
+                                size_t ring_size, int fanout_group,
+                                int *linktype, char *errmsg, size_t errmsg_len);
+
+/** Attach a compiled capture filter to a ring. */
+gboolean tpacket_ring_set_filter(tpacket_ring *ring, const struct bpf_program *fcode,
+                                 char *errmsg, size_t errmsg_len);
+
+/** Wait up to timeout_ms for the kernel to hand over the next block.
+ *
+ * @return 1 with *block set if we got one, 0 on timeout, -1 on error,
+ * with errmsg filled in
+ */
+int tpacket_ring_next_block(tpacket_ring *ring, int timeout_ms, void **block,
+                            char *errmsg, size_t errmsg_len);
+
+/** Get the number of packets and the number of bytes of packet data in
+ * a block. */
+guint32 tpacket_block_num_packets(const void *block);
+guint32 tpacket_block_len(const void *block);
+
+/** Call cb for each packet in a block; the data points into the ring,
+ * which is modified to put back VLAN tags. */
+void tpacket_block_foreach(void *block, tpacket_packet_cb cb, void *user);
+
+/** Give a block back to the kernel. */
+void tpacket_ring_release_block(tpacket_ring *ring, void *block);
+
+/** Get the kernel's packet and drop counts for a ring since it was opened. */
+gboolean tpacket_ring_stats(tpacket_ring *ring, guint32 *packets, guint32 *drops);
+
+/** Close a ring; all of its blocks must have been released. */
+void tpacket_ring_close(tpacket_ring *ring);
+
+#endif /* HAVE_TPACKET3 */
+
+#endif /* __CAPTURE_TPACKET_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -60,12 +60,32 @@ struct packet_provider_data {
   frame_data  *prev_cap;
   frame_data_sequence *frames;       /* Sequence of frames, if we're keeping that information */
   GTree       *frames_user_comments; /* BST with user comments for frames (key = frame_data) */
+  GTree       *frames_shift_offsets; /* BST with time shift offsets for frames (key = frame_data) */
+  struct frame_record_cache *record_cache; /* Records of recently read frames, if we're keeping them */
 };
 
+/*
+ * Totals of a set of frames, kept up to date as frames join and leave
+ * it.  start and stop are the earliest and latest time stamps of the
+ * frames that have them; when a frame with one of them leaves the set,
+ * or frames' time stamps are shifted, they have to be found again, and
+ * range_stale is set.  Use cf_get_frame_totals() to read them.
+ */
+typedef struct {
+  guint32   count;        /* Number of frames */
+  guint32   count_ts;     /* Number of frames with time stamps */
+  guint64   bytes;        /* Sum of the frames' lengths */
+  nstime_t  start;        /* Earliest time stamp */
+  nstime_t  stop;         /* Latest time stamp */
+  gboolean  range_stale;  /* TRUE if start and stop have to be found again */
+} frame_totals_t;
+
 typedef struct _capture_file {
   epan_t                     *epan;
   file_state                  state;                /* Current state of capture file */
   gchar                      *filename;             /* Name of capture file */
+  gchar                     **member_filenames;     /* NULL-terminated names of the files a virtual capture file is read from, or NULL */
+  gboolean                    members_appended;     /* Are they read one after the other, rather than merged? */
   gchar                      *source;               /* Temp file source, e.g. "Pipe from elsewhere" */
   gboolean                    is_tempfile;          /* Is capture file a temporary file? */
   gboolean                    unsaved_changes;      /* Does the capture file have changes that have not been saved? */
@@ -83,6 +103,9 @@ typedef struct _capture_file {
   guint32                     marked_count;         /* Number of marked frames */
   guint32                     ignored_count;        /* Number of ignored frames */
   guint32                     ref_time_count;       /* Number of time referenced frames */
+  frame_totals_t              all_totals;           /* Totals of all frames */
+  frame_totals_t              filtered_totals;      /* Totals of the frames that passed the display filter */
+  frame_totals_t              marked_totals;        /* Totals of the marked frames */
   gboolean                    drops_known;          /* TRUE if we know how many packets were dropped */
   guint32                     drops;                /* Dropped packets */
   nstime_t                    elapsed_time;         /* Elapsed time */
@@ -93,6 +116,8 @@ typedef struct _capture_file {
   gboolean                    redissecting;         /* TRUE if currently redissecting (cf_redissect_packets) */
   gboolean                    read_lock;            /* TRUE if currently processing a file (cf_read) */
   rescan_type                 redissection_queued;  /* Queued redissection type. */
+  guint32                     refilter_next;        /* Next frame to refilter in the background, or 0 if none */
+  guint32                     refilter_last;        /* Last frame to refilter in the background */
   /* search */
   gchar                      *sfilter;              /* Filter, hex value, or string being searched */
   gboolean                    hex;                  /* TRUE if "Hex value" search was last selected */
@@ -117,6 +142,8 @@ typedef struct _capture_file {
   frame_data                 *current_frame;        /* Frame data */
   gint                        current_row;          /* Row number */
   epan_dissect_t             *edt;                  /* Protocol dissection */
+  struct frame_tree          *current_tree;         /* What edt was dissected from, if it's to be kept in tree_cache */
+  struct frame_tree_cache    *tree_cache;           /* Trees of recently selected frames, if we're keeping them */
   field_info                 *finfo_selected;       /* Field info */
   wtap_rec                    rec;                  /* Record header */
   Buffer                      buf;                  /* Record data */
@@ -125,6 +152,18 @@ typedef struct _capture_file {
   gulong                      computed_elapsed;     /* Elapsed time to load the file (in msec). */
 
   guint32                     cum_bytes;
+  struct frame_proto_index   *proto_index;          /* Protocols in each frame, if we're keeping that information */
+  struct frame_field_store   *field_store;          /* Values of some fields in each frame, if we're keeping them */
+  struct frame_expert_info   *expert_info;          /* Expert info items of each frame, if we're keeping them */
+  struct frame_traffic_tables *traffic_tables;      /* Conversation and endpoint tables, if we're keeping them */
+  struct frame_proto_hier    *proto_hier;           /* Protocol hierarchy of each frame, if we're keeping it */
+  struct frame_bytes_search  *bytes_search;         /* Matches in all frames of the last packet bytes search, if any */
+  gchar                      *filter_frames_dfilter; /* A display filter that can only match filter_frames, if any */
+  guint32                    *filter_frames;        /* The frames it can match, in ascending order */
+  guint                       filter_frames_count;
+  gboolean                    first_pass_deferred;  /* TRUE if frames were loaded from a dissection index and not all dissected yet */
+  guint32                     visited_through;      /* If first_pass_deferred, all frames up to this one have been dissected */
+  guint32                     colorized_through;    /* All frames up to this one were colorized, with the current coloring rules, on their first pass */
 } capture_file;
 
 extern void cap_file_init(capture_file *cf);
@@ -133,6 +172,8 @@ const char *cap_file_provider_get_interface_name(struct packet_provider_data *pr
 const char *cap_file_provider_get_interface_description(struct packet_provider_data *prov, guint32 interface_id);
 const char *cap_file_provider_get_user_comment(struct packet_provider_data *prov, const frame_data *fd);
 void cap_file_provider_set_user_comment(struct packet_provider_data *prov, frame_data *fd, const char *new_comment);
+const nstime_t *cap_file_provider_get_shift_offset(struct packet_provider_data *prov, const frame_data *fd);
+void cap_file_provider_set_shift_offset(struct packet_provider_data *prov, frame_data *fd, const nstime_t *offset);
 
 #ifdef __cplusplus
 }
@@ -21,6 +21,11 @@
 #include <netinet/in.h>
 #endif
 
+#ifdef HAVE_TPACKET3
+#include <unistd.h>     /* for getpid() */
+#include <net/if.h>     /* for if_nametoindex() */
+#endif
+
 /*
  * If we have getopt_long() in the system library, include <getopt.h>.
  * Otherwise, we're using our own getopt_long() (either because the
@@ -43,6 +48,7 @@
 
 #include <ui/cmdarg_err.h>
 #include <wsutil/strtoi.h>
+#include <wsutil/numa.h>
 #include <cli_main.h>
 #include <version_info.h>
 
@@ -54,6 +60,10 @@
 #endif
 
 #include "ringbuffer.h"
+#include "capture_tpacket.h"
+#include "capture_shm_ring.h"
+#include "capture_slice.h"
+#include "capture_flow.h"
 
 #include "capture/capture_ifinfo.h"
 #include "capture/capture-pcap-util.h"
@@ -87,6 +97,7 @@
 #include "wsutil/time_util.h"
 #include "wsutil/please_report_bug.h"
 #include "wsutil/glib-compat.h"
+#include "wsutil/capture_index.h"
 
 #include "capture/ws80211_utils.h"
 
@@ -122,6 +133,22 @@ static gint64 pcap_queue_bytes;
 static gint64 pcap_queue_packets;
 static gint64 pcap_queue_byte_limit = 0;
 static gint64 pcap_queue_packet_limit = 0;
+/* Writer statistics; the queue ones are protected by the queue lock */
+static gint64 pcap_queue_max_bytes;
+static gint64 pcap_queue_max_packets;
+static guint32 pcap_queue_full_drops;
+static guint32 file_switch_count;
+static gint64 file_switch_max_usec;
+
+/* Maximum number of queued packets to write for each queue lock */
+#define WRITER_BATCH_SIZE 256
+
+/* Packets of several interfaces held back by the writer to be written in
+   time stamp order, see --reorder-window; only the writer touches these. */
+static guint64    reorder_window = 0;     /* nanoseconds, 0: in arrival order */
+static GPtrArray *reorder_heap = NULL;    /* min-heap of pcap_queue_element */
+static guint64    reorder_latest_ts = 0;  /* latest time stamp seen */
+static guint64    reorder_seq = 0;
 
 static gboolean capture_child = FALSE; /* FALSE: standalone call, TRUE: this is an Wireshark capture child */
 #ifdef _WIN32
@@ -207,6 +234,10 @@ typedef struct _capture_src {
     gboolean                     from_cap_pipe;          /**< TRUE if we are capturing data from a capture pipe */
     gboolean                     from_cap_socket;        /**< TRUE if we're capturing from socket */
     gboolean                     from_pcapng;            /**< TRUE if we're capturing from pcapng format */
+#ifdef HAVE_TPACKET3
+    gboolean                     from_tpacket;           /**< TRUE if we're capturing from TPACKET_V3 rings */
+    GPtrArray                   *tp_queues;              /**< The tpacket_queue's for the rings */
+#endif
     union {
         pcap_pipe_info_t         pcap;                   /**< Pcap info when capturing from a pipe */
         pcapng_pipe_info_t       pcapng;                 /**< Pcapng info when capturing from a pipe */
@@ -215,6 +246,13 @@ typedef struct _capture_src {
     HANDLE                       cap_pipe_h;             /**< The handle of the capture pipe */
 #endif
     int                          cap_pipe_fd;            /**< the file descriptor of the capture pipe */
+#ifndef _WIN32
+    shm_ring                    *cap_pipe_ring;          /**< The ring the data comes through, if the writer set one up */
+    gboolean                     cap_pipe_ring_eof;      /**< TRUE if the writer has closed the pipe of a ring */
+    char *                       cap_pipe_rbuf;          /**< Data read from the pipe ahead of the records it holds */
+    size_t                       cap_pipe_rbuf_off;      /**< Offset of the first unused byte in cap_pipe_rbuf */
+    size_t                       cap_pipe_rbuf_len;      /**< Number of bytes read into cap_pipe_rbuf */
+#endif
     gboolean                     cap_pipe_modified;      /**< TRUE if data in the pipe uses modified pcap headers */
     char *                       cap_pipe_databuf;       /**< Pointer to the data buffer we've allocated */
     size_t                       cap_pipe_databuf_size;  /**< Current size of the data buffer */
@@ -237,6 +275,20 @@ typedef struct _capture_src {
 #endif
 } capture_src;
 
+#ifdef HAVE_TPACKET3
+/*
+ * One of the TPACKET_V3 rings of a capture_src, read by its own thread.
+ */
+typedef struct _tpacket_queue {
+    capture_src                 *pcap_src;
+    tpacket_ring                *ring;
+    guint                        index;
+    GThread                     *tid;
+    guint32                      received;               /**< Packets handed to the writer */
+    guint32                      dropped;                /**< Packets dropped because the writer's queue was full */
+} tpacket_queue;
+#endif
+
 typedef struct _saved_idb {
     gboolean deleted;
     guint interface_id; /* capture_src->interface_id for the associated SHB */
@@ -280,8 +332,18 @@ typedef struct _pcap_queue_element {
     union {
         struct pcap_pkthdr  phdr;
         pcapng_block_header_t  bh;
+#ifdef HAVE_TPACKET3
+        struct {
+            tpacket_queue      *queue;
+            void               *block;
+        } tp;                   /**< A whole ring block, written in place */
+#endif
     } u;
-    u_char             *pd;
+    u_char             *pd;     /**< Points just past the element, in the same allocation */
+    /* Set by the writer for the packets it holds back to reorder */
+    guint64             order_ts;   /**< Time stamp in nanoseconds */
+    guint64             order_seq;  /**< Arrival order, for equal time stamps */
+    gint64              held_since; /**< Monotonic time it was dequeued at */
 } pcap_queue_element;
 
 /*
@@ -325,6 +387,14 @@ static gboolean need_timeout_workaround;
 
 #define WRITER_THREAD_TIMEOUT 100000 /* usecs */
 
+/*
+ * On UN*X, we read from a pipe in chunks of up to this size, and write
+ * as many of the records in each chunk as it holds in full straight out
+ * of it, rather than reading each record header and each record's data
+ * with a separate read().
+ */
+#define PIPE_READ_AHEAD_SIZE  (256 * 1024)
+
 static void
 console_log_handler(const char *log_domain, GLogLevelFlags log_level,
                     const char *message, gpointer user_data _U_);
@@ -333,12 +403,55 @@ console_log_handler(const char *log_domain, GLogLevelFlags log_level,
 static capture_options global_capture_opts;
 static gboolean quiet = FALSE;
 static gboolean use_threads = FALSE;
+#ifdef HAVE_TPACKET3
+static int tpacket_queues = 0;  /* TPACKET_V3 rings per interface, or 0 to use libpcap */
+#endif
 static guint64 start_time;
+static capture_slice_rules *slice_rules = NULL; /* --slice rules, or NULL if none */
+
+/*
+ * With --flow-files, the IP packets are spread across that many output
+ * files by the hash of their flow, the same in both directions, so that
+ * each flow is in one file; the file named with -w gets the packets that
+ * aren't in a flow, and the first share of the flows, and the others are
+ * named after it.  With --flow-sample, only one flow in that many is
+ * written.
+ */
+static guint flow_files = 0;
+static guint flow_sample = 0;
+
+typedef struct {
+    char    *name;
+    FILE    *pdh;
+    char    *io_buffer;
+    guint64  bytes_written;
+} flow_output;
+static flow_output *flow_outputs = NULL;    /* the second and later files */
+
+/*
+ * With --index, each capture file gets an index of its packets, written
+ * beside it when it's closed, by a thread so that the writer doesn't
+ * wait for that.
+ */
+static gboolean write_index = FALSE;
+static capture_index *capture_idx = NULL;   /* index of the current file */
+static GThreadPool *index_writer = NULL;
+static gint index_write_err = 0;            /* errno of the first failure to write one */
+
+typedef struct {
+    capture_index *ci;
+    gchar         *path;
+} index_write_job;
 
 static void capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
                                          const u_char *pd);
 static void capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
                                          const u_char *pd);
+#ifdef HAVE_TPACKET3
+static void capture_loop_write_tpacket_cb(void *pcap_src_p, guint32 sec, guint32 nsec,
+                                          guint32 caplen, guint32 len, const guint8 *pd);
+static void capture_loop_queue_tpacket_block(tpacket_queue *queue, void *block);
+#endif
 static void capture_loop_write_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t *bh, u_char *pd);
 static void capture_loop_queue_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t *bh, u_char *pd);
 static void capture_loop_get_errmsg(char *errmsg, size_t errmsglen,
@@ -352,6 +465,10 @@ static void WS_NORETURN exit_main(int err);
 static void report_new_capture_file(const char *filename);
 static void report_packet_count(unsigned int packet_count);
 static void report_packet_drops(guint32 received, guint32 pcap_drops, guint32 drops, guint32 flushed, guint32 ps_ifdrop, gchar *name);
+static void report_writer_stats(void);
+#ifdef HAVE_TPACKET3
+static void report_queue_drops(const char *name, guint index, guint32 received, guint32 kernel_drops, guint32 drops);
+#endif
 static void report_capture_error(const char *error_msg, const char *secondary_error_msg);
 static void report_cfilter_error(capture_options *capture_opts, guint i, const char *errmsg);
 
@@ -400,6 +517,7 @@ print_usage(FILE *output)
     fprintf(output, "  -k <freq>,[<type>],[<center_freq1>],[<center_freq2>]\n");
     fprintf(output, "                           set channel on wifi interface\n");
     fprintf(output, "  -S                       print statistics for each interface once per second\n");
+    fprintf(output, "                           (of the packets matching -f, if given)\n");
     fprintf(output, "  -M                       for -D, -L, and -S, produce machine-readable output\n");
     fprintf(output, "\n");
 #ifdef HAVE_PCAP_REMOTE
@@ -433,8 +551,19 @@ print_usage(FILE *output)
     fprintf(output, "                                          an exact multiple of NUM secs\n");
     fprintf(output, "                          printname:FILE - print filename to FILE when written\n");
     fprintf(output, "                                           (can use 'stdout' or 'stderr')\n");
+    fprintf(output, "  --compress-type <type>   compress ring buffer files: with gzip once each\n");
+    fprintf(output, "                           file is closed (without a files: limit), or with\n");
+    fprintf(output, "                           zstd or lz4 as they're written\n");
+    fprintf(output, "  --index                  write an index of each capture file beside it, for\n");
+    fprintf(output, "                           indexcap to search\n");
     fprintf(output, "  -n                       use pcapng format instead of pcap (default)\n");
     fprintf(output, "  -P                       use libpcap format instead of pcapng\n");
+    fprintf(output, "  --slice <proto>[:<port>]=<length>\n");
+    fprintf(output, "                           write only <length> bytes (0 = all) of packets of\n");
+    fprintf(output, "                           IP protocol <proto> (ip, tcp, udp, sctp or a number)\n");
+    fprintf(output, "                           to or from <port>; may be repeated, first match wins\n");
+    fprintf(output, "  --flow-files <n>         spread the packets across <n> files, by flow\n");
+    fprintf(output, "  --flow-sample <n>        write only one in <n> flows\n");
     fprintf(output, "  --capture-comment <comment>\n");
     fprintf(output, "                           add a capture comment to the output file\n");
     fprintf(output, "                           (only for pcapng)\n");
@@ -444,7 +573,19 @@ print_usage(FILE *output)
     fprintf(output, "  -C <byte_limit>          maximum number of bytes used for buffering packets\n");
     fprintf(output, "                           within dumpcap\n");
     fprintf(output, "  -t                       use a separate thread per interface\n");
+    fprintf(output, "  --reorder-window <ms>    write the packets of all interfaces in time stamp\n");
+    fprintf(output, "                           order, holding them back for up to <ms> (implies -t)\n");
+#ifdef HAVE_TPACKET3
+    fprintf(output, "  --tpacket <rings>        capture from network interfaces with <rings>\n");
+    fprintf(output, "                           TPACKET_V3 rings each, in a fanout group, with a\n");
+    fprintf(output, "                           thread per ring (implies -t)\n");
+#endif
+    fprintf(output, "  --cpu-affinity <cpus>|node:<node>|iface:<interface>\n");
+    fprintf(output, "                           run only on the given CPUs, those of a NUMA node,\n");
+    fprintf(output, "                           or those of the node an interface is attached to\n");
     fprintf(output, "  -q                       don't report packet capture counts\n");
+    fprintf(output, "  --update-interval <ms>   time between reports of new packets to the parent\n");
+    fprintf(output, "                           process (def: %dms)\n", DEFAULT_UPDATE_INTERVAL);
     fprintf(output, "  -v, --version            print version information and exit\n");
     fprintf(output, "  -h, --help               display this help and exit\n");
     fprintf(output, "\n");
@@ -901,7 +1042,7 @@ typedef struct {
 
 /* Print the number of packets captured for each interface until we're killed. */
 static int
-print_statistics_loop(gboolean machine_readable)
+print_statistics_loop(gboolean machine_readable, const char *cfilter)
 {
     GList       *if_list, *if_entry, *stat_list = NULL, *stat_entry;
     if_info_t   *if_info;
@@ -911,6 +1052,7 @@ print_statistics_loop(gboolean machine_readable)
     pcap_t      *pch;
     char        errbuf[PCAP_ERRBUF_SIZE];
     struct pcap_stat ps;
+    struct bpf_program fcode;
 
     if_list = get_interface_list(&err, &err_str);
     if (if_list == NULL) {
@@ -943,6 +1085,28 @@ print_statistics_loop(gboolean machine_readable)
         pch = pcap_open_live(if_info->name, MIN_PACKET_SIZE, 0, 0, errbuf);
 #endif
 
+        if (pch && cfilter != NULL) {
+            /*
+             * Count only the packets the filter accepts.  It's run by
+             * the kernel, where it can be, so this shows what a capture
+             * with it would have to keep up with.
+             */
+            if (!compile_capture_filter(if_info->name, pch, &fcode, cfilter)) {
+                g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, "Skipping interface %s for stats: %s",
+                    if_info->name, pcap_geterr(pch));
+                pcap_close(pch);
+                pch = NULL;
+            } else {
+                if (pcap_setfilter(pch, &fcode) < 0) {
+                    g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, "Skipping interface %s for stats: %s",
+                        if_info->name, pcap_geterr(pch));
+                    pcap_close(pch);
+                    pch = NULL;
+                }
+                pcap_freecode(&fcode);
+            }
+        }
+
         if (pch) {
             if_stat = g_new(if_stat_t, 1);
             if_stat->name = g_strdup(if_info->name);
@@ -962,6 +1126,8 @@ print_statistics_loop(gboolean machine_readable)
     }
 
     if (!machine_readable) {
+        if (cfilter != NULL)
+            printf("Packets matching \"%s\":\n", cfilter);
         printf("%-15s  %10s  %10s\n", "Interface", "Received",
             "Dropped");
     }
@@ -1201,11 +1367,81 @@ cap_pipe_adjust_pcap_header(gboolean byte_swapped, struct pcap_hdr *hdr, struct
     }
 }
 
+#ifndef _WIN32
+/* Consume the bytes the writer of a ring has written to its pipe to wake
+ * us up, noting whether it has closed the pipe.
+ *
+ * Returns -1 on error.
+ */
+static int
+cap_pipe_ring_drain(capture_src *pcap_src, int pipe_fd)
+{
+    char doorbell[256];
+    ssize_t b;
+
+    b = ws_read(pipe_fd, doorbell, sizeof doorbell);
+    if (b < 0)
+        return -1;
+    if (b == 0)
+        pcap_src->cap_pipe_ring_eof = TRUE;
+    return 0;
+}
+
+/* Read from a ring, waiting until there's something to read.  Like
+ * read(), return 0 once the writer is done and the ring is empty.
+ */
+static ssize_t
+cap_pipe_ring_read(capture_src *pcap_src, int pipe_fd, char *buf, size_t sz)
+{
+    shm_ring *ring = pcap_src->cap_pipe_ring;
+    size_t n;
+    fd_set rfds;
+    int sel_ret;
+
+    for (;;) {
+        n = shm_ring_read(ring, buf, sz);
+        if (n > 0)
+            return (ssize_t)n;
+        if (shm_ring_closed(ring) || pcap_src->cap_pipe_ring_eof) {
+            /* The writer may have written more before saying so. */
+            return (ssize_t)shm_ring_read(ring, buf, sz);
+        }
+        if (shm_ring_wait_begin(ring)) {
+            FD_ZERO(&rfds);
+            FD_SET(pipe_fd, &rfds);
+            sel_ret = select(pipe_fd+1, &rfds, NULL, NULL, NULL);
+            if (sel_ret > 0 && cap_pipe_ring_drain(pcap_src, pipe_fd) < 0)
+                sel_ret = -1;
+            shm_ring_wait_end(ring);
+            if (sel_ret < 0 && errno != EINTR)
+                return -1;
+        }
+    }
+}
+#endif
+
+#ifndef _WIN32
+/* Read as much as one read() gives us into the empty read-ahead buffer.
+ *
+ * Returns the same values as read().
+ */
+static ssize_t
+cap_pipe_fill_read_ahead(capture_src *pcap_src, int pipe_fd)
+{
+    ssize_t b;
+
+    b = ws_read(pipe_fd, pcap_src->cap_pipe_rbuf, PIPE_READ_AHEAD_SIZE);
+    pcap_src->cap_pipe_rbuf_off = 0;
+    pcap_src->cap_pipe_rbuf_len = b > 0 ? (size_t)b : 0;
+    return b;
+}
+#endif
+
 /* Wrapper: distinguish between recv/read if we're reading on Windows,
- * or just read().
+ * or from a ring, or from the read-ahead buffer, or just read().
  */
 static ssize_t
-cap_pipe_read(int pipe_fd, char *buf, size_t sz, gboolean from_socket _U_)
+cap_pipe_read(capture_src *pcap_src _U_, int pipe_fd, char *buf, size_t sz, gboolean from_socket _U_)
 {
 #ifdef _WIN32
     if (from_socket) {
@@ -1214,6 +1450,26 @@ cap_pipe_read(int pipe_fd, char *buf, size_t sz, gboolean from_socket _U_)
         return -1;
     }
 #else
+    size_t n;
+    ssize_t b;
+
+    if (pcap_src->cap_pipe_ring != NULL)
+        return cap_pipe_ring_read(pcap_src, pipe_fd, buf, sz);
+    if (pcap_src->cap_pipe_rbuf != NULL) {
+        if (pcap_src->cap_pipe_rbuf_off == pcap_src->cap_pipe_rbuf_len) {
+            /* Reading large amounts straight into the caller's buffer is
+             * cheaper than copying them out of ours. */
+            if (sz >= PIPE_READ_AHEAD_SIZE)
+                return ws_read(pipe_fd, buf, sz);
+            b = cap_pipe_fill_read_ahead(pcap_src, pipe_fd);
+            if (b <= 0)
+                return b;
+        }
+        n = MIN(sz, pcap_src->cap_pipe_rbuf_len - pcap_src->cap_pipe_rbuf_off);
+        memcpy(buf, pcap_src->cap_pipe_rbuf + pcap_src->cap_pipe_rbuf_off, n);
+        pcap_src->cap_pipe_rbuf_off += n;
+        return (ssize_t)n;
+    }
     return ws_read(pipe_fd, buf, sz);
 #endif
 }
@@ -1258,7 +1514,7 @@ static void *cap_thread_read(void *arg)
               )
            {
                ssize_t b;
-               b = cap_pipe_read(pcap_src->cap_pipe_fd, pcap_src->cap_pipe_buf+bytes_read,
+               b = cap_pipe_read(pcap_src, pcap_src->cap_pipe_fd, pcap_src->cap_pipe_buf+bytes_read,
                         pcap_src->cap_pipe_bytes_to_read - bytes_read, pcap_src->from_cap_socket);
                if (b <= 0) {
                    if (b == 0) {
@@ -1346,13 +1602,27 @@ pipe_read_sync(capture_src *pcap_src, void *buf, DWORD nbytes)
 /* Provide select() functionality for a single file descriptor
  * on UNIX/POSIX. Windows uses cap_pipe_read via a thread.
  *
+ * If the data of pcap_src comes through a ring, wait for there to be
+ * data in the ring, or for the writer to be done, instead; if some data
+ * has already been read ahead, don't wait at all.
+ *
  * Returns the same values as select.
  */
 static int
-cap_pipe_select(int pipe_fd)
+cap_pipe_select(capture_src *pcap_src _U_, int pipe_fd)
 {
     fd_set      rfds;
     struct timeval timeout;
+    int         sel_ret;
+#ifndef _WIN32
+    shm_ring   *ring = pcap_src->cap_pipe_ring;
+
+    /* Whatever we've read ahead can be read without blocking. */
+    if (pcap_src->cap_pipe_rbuf_off < pcap_src->cap_pipe_rbuf_len)
+        return 1;
+    if (ring != NULL && (pcap_src->cap_pipe_ring_eof || !shm_ring_wait_begin(ring)))
+        return 1;
+#endif
 
     FD_ZERO(&rfds);
     FD_SET(pipe_fd, &rfds);
@@ -1360,7 +1630,18 @@ cap_pipe_select(int pipe_fd)
     timeout.tv_sec = PIPE_READ_TIMEOUT / 1000000;
     timeout.tv_usec = PIPE_READ_TIMEOUT % 1000000;
 
-    return select(pipe_fd+1, &rfds, NULL, NULL, &timeout);
+    sel_ret = select(pipe_fd+1, &rfds, NULL, NULL, &timeout);
+#ifndef _WIN32
+    if (ring != NULL) {
+        if (sel_ret > 0 && cap_pipe_ring_drain(pcap_src, pipe_fd) < 0)
+            sel_ret = -1;
+        shm_ring_wait_end(ring);
+        if (sel_ret >= 0)
+            sel_ret = (shm_ring_available(ring) > 0 || shm_ring_closed(ring) ||
+                       pcap_src->cap_pipe_ring_eof) ? 1 : 0;
+    }
+#endif
+    return sel_ret;
 }
 
 #define DEF_TCP_PORT 19000
@@ -1463,14 +1744,14 @@ cap_pipe_read_data_bytes(capture_src *pcap_src, char *errmsg, size_t errmsgl)
             return -1;
         }
 
-        sel_ret = cap_pipe_select(fd);
+        sel_ret = cap_pipe_select(pcap_src, fd);
         if (sel_ret < 0) {
             g_snprintf(errmsg, (gulong)errmsgl,
                        "Unexpected error from select: %s.", g_strerror(errno));
             pcap_src->cap_pipe_err = PIPERR;
             return -1;
         } else if (sel_ret > 0) {
-            b = cap_pipe_read(fd, pcap_src->cap_pipe_databuf+pcap_src->cap_pipe_bytes_read+bytes_read,
+            b = cap_pipe_read(pcap_src, fd, pcap_src->cap_pipe_databuf+pcap_src->cap_pipe_bytes_read+bytes_read,
                               sz-bytes_read, pcap_src->from_cap_socket);
             if (b <= 0) {
                 if (b == 0) {
@@ -1521,6 +1802,90 @@ static int pcapng_pipe_dispatch(loop_data *ld, capture_src *pcap_src,
 static char not_our_bug[] =
     "Please report this to the developers of the program writing to the pipe.";
 
+#ifndef _WIN32
+/* Read exactly sz bytes from a pipe, or from its ring if it has one.
+ *
+ * Returns sz, 0 on EOF, or -1 on error.
+ */
+static ssize_t
+cap_pipe_read_exactly(capture_src *pcap_src, int fd, void *buf, size_t sz)
+{
+    size_t bytes_read = 0;
+    ssize_t b;
+    int sel_ret;
+
+    while (bytes_read < sz) {
+        sel_ret = cap_pipe_select(pcap_src, fd);
+        if (sel_ret < 0)
+            return -1;
+        if (sel_ret > 0) {
+            b = cap_pipe_read(pcap_src, fd, (char *)buf + bytes_read,
+                              sz - bytes_read, FALSE);
+            if (b <= 0)
+                return b;
+            bytes_read += b;
+        }
+    }
+    return (ssize_t)sz;
+}
+
+/* The writer has announced, with SHM_RING_MAGIC, that the data will come
+ * through a ring; read the path of its file, map it, and read the real
+ * magic number from it.
+ *
+ * Returns -1 with errmsg set on error.
+ */
+static int
+cap_pipe_open_ring(int fd, capture_src *pcap_src, guint32 *magic,
+                   char *errmsg, size_t errmsgl)
+{
+    guint32 path_len;
+    char *path;
+    ssize_t b;
+
+    b = cap_pipe_read_exactly(pcap_src, fd, &path_len, sizeof path_len);
+    if (b <= 0) {
+        g_snprintf(errmsg, (gulong)errmsgl,
+                   "Error reading the ring path length from the pipe.");
+        return -1;
+    }
+    if (path_len == 0 || path_len > SHM_RING_MAX_PATH_LEN) {
+        g_snprintf(errmsg, (gulong)errmsgl,
+                   "The ring path length written to the pipe, %u, is invalid.",
+                   path_len);
+        return -1;
+    }
+    path = (char *)g_malloc(path_len + 1);
+    b = cap_pipe_read_exactly(pcap_src, fd, path, path_len);
+    if (b <= 0) {
+        g_snprintf(errmsg, (gulong)errmsgl,
+                   "Error reading the ring path from the pipe.");
+        g_free(path);
+        return -1;
+    }
+    path[path_len] = '\0';
+
+    pcap_src->cap_pipe_ring = shm_ring_open(path, errmsg, errmsgl);
+    g_free(path);
+    if (pcap_src->cap_pipe_ring == NULL)
+        return -1;
+    g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, "cap_pipe_open_live: reading from a ring");
+
+    b = cap_pipe_read_exactly(pcap_src, fd, magic, sizeof *magic);
+    if (b <= 0) {
+        if (b == 0)
+            g_snprintf(errmsg, (gulong)errmsgl,
+                       "End of file on ring magic during open.");
+        else
+            g_snprintf(errmsg, (gulong)errmsgl,
+                       "Error on ring magic during open: %s.",
+                       g_strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+#endif
+
 /* Mimic pcap_open_live() for pipe captures
 
  * We check if "pipename" is "-" (stdin), a AF_UNIX socket, or a FIFO,
@@ -1756,14 +2121,14 @@ cap_pipe_open_live(char *pipename,
     {
         bytes_read = 0;
         while (bytes_read < sizeof magic) {
-            sel_ret = cap_pipe_select(fd);
+            sel_ret = cap_pipe_select(pcap_src, fd);
             if (sel_ret < 0) {
                 g_snprintf(errmsg, (gulong)errmsgl,
                            "Unexpected error from select: %s.",
                            g_strerror(errno));
                 goto error;
             } else if (sel_ret > 0) {
-                b = cap_pipe_read(fd, ((char *)&magic)+bytes_read,
+                b = cap_pipe_read(pcap_src, fd, ((char *)&magic)+bytes_read,
                                   sizeof magic-bytes_read,
                                   pcap_src->from_cap_socket);
                 /* jump messaging, if extcap had an error, stderr will provide the correct message */
@@ -1807,6 +2172,13 @@ cap_pipe_open_live(char *pipename,
     }
 #endif
 
+#ifndef _WIN32
+    if (magic == SHM_RING_MAGIC && !pcap_src->from_cap_socket) {
+        if (cap_pipe_open_ring(fd, pcap_src, &magic, errmsg, errmsgl) < 0)
+            goto error;
+    }
+#endif
+
     switch (magic) {
     case PCAP_MAGIC:
     case PCAP_NSEC_MAGIC:
@@ -1859,6 +2231,12 @@ cap_pipe_open_live(char *pipename,
         goto error;
     }
 
+#ifndef _WIN32
+    /* A ring is in memory already; copying it again wouldn't help. */
+    if (pcap_src->cap_pipe_ring == NULL)
+        pcap_src->cap_pipe_rbuf = (char *)g_malloc(PIPE_READ_AHEAD_SIZE);
+#endif
+
     if (pcap_src->from_pcapng)
         pcapng_pipe_open_live(fd, pcap_src, errmsg, errmsgl);
     else
@@ -1907,14 +2285,14 @@ pcap_pipe_open_live(int fd,
         /* Keep reading until we get the rest of the header. */
         bytes_read = 0;
         while (bytes_read < sizeof(struct pcap_hdr)) {
-            sel_ret = cap_pipe_select(fd);
+            sel_ret = cap_pipe_select(pcap_src, fd);
             if (sel_ret < 0) {
                 g_snprintf(errmsg, (gulong)errmsgl,
                            "Unexpected error from select: %s.",
                            g_strerror(errno));
                 goto error;
             } else if (sel_ret > 0) {
-                b = cap_pipe_read(fd, ((char *)hdr)+bytes_read,
+                b = cap_pipe_read(pcap_src, fd, ((char *)hdr)+bytes_read,
                                   sizeof(struct pcap_hdr) - bytes_read,
                                   pcap_src->from_cap_socket);
                 if (b <= 0) {
@@ -2275,6 +2653,87 @@ error:
 #endif
 }
 
+#ifndef _WIN32
+/* Get the read-ahead buffer of a pipe ready to have records taken from
+ * it: if it's empty, read into it, as select() has said we can without
+ * blocking.
+ *
+ * Returns the number of bytes in it, or -1, with cap_pipe_err set and,
+ * on error, errmsg filled in, on EOF or error.
+ */
+static ssize_t
+cap_pipe_read_ahead(capture_src *pcap_src, char *errmsg, size_t errmsgl)
+{
+    ssize_t b;
+
+    if (pcap_src->cap_pipe_rbuf_off == pcap_src->cap_pipe_rbuf_len) {
+        b = cap_pipe_fill_read_ahead(pcap_src, pcap_src->cap_pipe_fd);
+        if (b <= 0) {
+            if (b == 0) {
+                pcap_src->cap_pipe_err = PIPEOF;
+            } else {
+                g_snprintf(errmsg, (gulong)errmsgl, "Error reading from pipe: %s",
+                           g_strerror(errno));
+                pcap_src->cap_pipe_err = PIPERR;
+            }
+            return -1;
+        }
+    }
+    return (ssize_t)(pcap_src->cap_pipe_rbuf_len - pcap_src->cap_pipe_rbuf_off);
+}
+
+/* Write all the complete records in the read-ahead buffer of a pcap pipe
+ * straight out of it.  Whatever is left, including any record with
+ * something wrong with it, is left for pcap_pipe_dispatch() to read, and
+ * to report on, as usual.
+ *
+ * Returns the number of records written, or -1 as cap_pipe_read_ahead()
+ * does.
+ */
+static int
+pcap_pipe_dispatch_read_ahead(capture_src *pcap_src, char *errmsg, size_t errmsgl)
+{
+    pcap_pipe_info_t *pcap_info = &pcap_src->cap_pipe_info.pcap;
+    size_t hdr_len = pcap_src->cap_pipe_modified ?
+        sizeof(struct pcaprec_modified_hdr) : sizeof(struct pcaprec_hdr);
+    struct pcap_pkthdr phdr;
+    ssize_t avail;
+    char *rec;
+    int records = 0;
+
+    avail = cap_pipe_read_ahead(pcap_src, errmsg, errmsgl);
+    if (avail < 0)
+        return -1;
+
+    while (global_ld.go && (size_t)avail >= hdr_len) {
+        rec = pcap_src->cap_pipe_rbuf + pcap_src->cap_pipe_rbuf_off;
+        memcpy(&pcap_info->rechdr, rec, hdr_len);
+        cap_pipe_adjust_pcap_header(pcap_info->byte_swapped, &pcap_info->hdr,
+                                    &pcap_info->rechdr.hdr);
+        if (pcap_info->rechdr.hdr.incl_len > pcap_src->cap_pipe_max_pkt_size ||
+            pcap_info->rechdr.hdr.incl_len > (size_t)avail - hdr_len) {
+            break;
+        }
+
+        phdr.ts.tv_sec = pcap_info->rechdr.hdr.ts_sec;
+        phdr.ts.tv_usec = pcap_info->rechdr.hdr.ts_usec;
+        phdr.caplen = pcap_info->rechdr.hdr.incl_len;
+        phdr.len = pcap_info->rechdr.hdr.orig_len;
+
+        if (use_threads) {
+            capture_loop_queue_packet_cb((u_char *)pcap_src, &phdr, (u_char *)rec + hdr_len);
+        } else {
+            capture_loop_write_packet_cb((u_char *)pcap_src, &phdr, (u_char *)rec + hdr_len);
+        }
+
+        pcap_src->cap_pipe_rbuf_off += hdr_len + phdr.caplen;
+        avail -= hdr_len + phdr.caplen;
+        records++;
+    }
+    return records;
+}
+#endif
+
 /* We read one record from the pipe, take care of byte order in the record
  * header, write the record to the capture file, and update capture statistics. */
 static int
@@ -2294,6 +2753,15 @@ pcap_pipe_dispatch(loop_data *ld, capture_src *pcap_src, char *errmsg, size_t er
     g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, "pcap_pipe_dispatch");
 #endif
 
+#ifndef _WIN32
+    if (pcap_src->cap_pipe_state == STATE_EXPECT_REC_HDR && pcap_src->cap_pipe_rbuf != NULL) {
+        int records = pcap_pipe_dispatch_read_ahead(pcap_src, errmsg, errmsgl);
+
+        if (records != 0)
+            return records;
+    }
+#endif
+
     switch (pcap_src->cap_pipe_state) {
 
     case STATE_EXPECT_REC_HDR:
@@ -2319,7 +2787,7 @@ pcap_pipe_dispatch(loop_data *ld, capture_src *pcap_src, char *errmsg, size_t er
         if (pcap_src->from_cap_socket)
 #endif
         {
-            b = cap_pipe_read(pcap_src->cap_pipe_fd, ((char *)&pcap_info->rechdr)+pcap_src->cap_pipe_bytes_read,
+            b = cap_pipe_read(pcap_src, pcap_src->cap_pipe_fd, ((char *)&pcap_info->rechdr)+pcap_src->cap_pipe_bytes_read,
                  pcap_src->cap_pipe_bytes_to_read - pcap_src->cap_pipe_bytes_read, pcap_src->from_cap_socket);
             if (b <= 0) {
                 if (b == 0)
@@ -2374,7 +2842,7 @@ pcap_pipe_dispatch(loop_data *ld, capture_src *pcap_src, char *errmsg, size_t er
         if (pcap_src->from_cap_socket)
 #endif
         {
-            b = cap_pipe_read(pcap_src->cap_pipe_fd,
+            b = cap_pipe_read(pcap_src, pcap_src->cap_pipe_fd,
                               pcap_src->cap_pipe_databuf+pcap_src->cap_pipe_bytes_read,
                               pcap_src->cap_pipe_bytes_to_read - pcap_src->cap_pipe_bytes_read,
                               pcap_src->from_cap_socket);
@@ -2519,6 +2987,56 @@ pcap_pipe_dispatch(loop_data *ld, capture_src *pcap_src, char *errmsg, size_t er
     return -1;
 }
 
+#ifndef _WIN32
+/* Write all the complete blocks in the read-ahead buffer of a pcapng pipe
+ * straight out of it, up to the next SHB.  Whatever is left, including
+ * any block with something wrong with it, is left for
+ * pcapng_pipe_dispatch() to read, and to report on, as usual.
+ *
+ * Returns the number of blocks written, or -1 as cap_pipe_read_ahead()
+ * does.
+ */
+static int
+pcapng_pipe_dispatch_read_ahead(capture_src *pcap_src, char *errmsg, size_t errmsgl)
+{
+    pcapng_block_header_t *bh = &pcap_src->cap_pipe_info.pcapng.bh;
+    ssize_t avail;
+    char *block;
+    int blocks = 0;
+
+    avail = cap_pipe_read_ahead(pcap_src, errmsg, errmsgl);
+    if (avail < 0)
+        return -1;
+
+    while (global_ld.go && (size_t)avail >= sizeof(pcapng_block_header_t)) {
+        block = pcap_src->cap_pipe_rbuf + pcap_src->cap_pipe_rbuf_off;
+        /* The block is handed on in place, and its fields are read as
+         * 32-bit values. */
+        if (((guintptr)block & 3) != 0)
+            break;
+        memcpy(bh, block, sizeof(pcapng_block_header_t));
+        if (bh->block_type == BLOCK_TYPE_SHB ||
+            (bh->block_total_length & 0x03) != 0 ||
+            bh->block_total_length > pcap_src->cap_pipe_max_pkt_size ||
+            bh->block_total_length < sizeof(pcapng_block_header_t)+sizeof(guint32) ||
+            bh->block_total_length > (size_t)avail) {
+            break;
+        }
+
+        if (use_threads) {
+            capture_loop_queue_pcapng_cb(pcap_src, bh, (u_char *)block);
+        } else {
+            capture_loop_write_pcapng_cb(pcap_src, bh, (u_char *)block);
+        }
+
+        pcap_src->cap_pipe_rbuf_off += bh->block_total_length;
+        avail -= bh->block_total_length;
+        blocks++;
+    }
+    return blocks;
+}
+#endif
+
 static int
 pcapng_pipe_dispatch(loop_data *ld, capture_src *pcap_src, char *errmsg, size_t errmsgl)
 {
@@ -2534,6 +3052,15 @@ pcapng_pipe_dispatch(loop_data *ld, capture_src *pcap_src, char *errmsg, size_t
     g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, "pcapng_pipe_dispatch");
 #endif
 
+#ifndef _WIN32
+    if (pcap_src->cap_pipe_state == STATE_EXPECT_REC_HDR && pcap_src->cap_pipe_rbuf != NULL) {
+        int blocks = pcapng_pipe_dispatch_read_ahead(pcap_src, errmsg, errmsgl);
+
+        if (blocks != 0)
+            return blocks;
+    }
+#endif
+
     switch (pcap_src->cap_pipe_state) {
 
     case STATE_EXPECT_REC_HDR:
@@ -2767,6 +3294,88 @@ pcapng_pipe_dispatch(loop_data *ld, capture_src *pcap_src, char *errmsg, size_t
     return -1;
 }
 
+#ifdef HAVE_TPACKET3
+/*
+ * Open tpacket_queues TPACKET_V3 rings on a network interface, in one
+ * fanout group, instead of opening it with libpcap.
+ *
+ * We still give the source a pcap_t, a "dead" one, so that capture filters
+ * are compiled, and the snapshot length and errors are reported, as they
+ * are for libpcap sources.
+ */
+static gboolean
+capture_loop_open_tpacket(interface_options *interface_opts, capture_src *pcap_src,
+                          char *errmsg, size_t errmsg_len)
+{
+    int            fanout_group = -1;
+    size_t         ring_size = (size_t)MAX(interface_opts->buffer_size, 1) * 1024 * 1024;
+    tpacket_queue *queue;
+    guint          i;
+
+    if (tpacket_queues > 1) {
+        /* Group IDs are per network namespace; make ours unlikely to clash. */
+        fanout_group = ((int)getpid() + (int)pcap_src->interface_id) & 0xffff;
+    }
+
+    pcap_src->from_tpacket = TRUE;
+    pcap_src->tp_queues = g_ptr_array_new();
+    for (i = 0; i < (guint)tpacket_queues; i++) {
+        queue = g_new0(tpacket_queue, 1);
+        queue->pcap_src = pcap_src;
+        queue->index = i;
+        queue->ring = tpacket_ring_open(interface_opts->name, interface_opts->promisc_mode,
+                                        ring_size, fanout_group, &pcap_src->linktype,
+                                        errmsg, errmsg_len);
+        if (queue->ring == NULL) {
+            g_free(queue);
+            return FALSE;
+        }
+        g_ptr_array_add(pcap_src->tp_queues, queue);
+    }
+
+    if (interface_opts->linktype != -1 && interface_opts->linktype != pcap_src->linktype) {
+        g_snprintf(errmsg, (gulong) errmsg_len,
+                   "The link-layer header type can't be set with --tpacket.");
+        return FALSE;
+    }
+
+    pcap_src->snaplen = interface_opts->has_snaplen ? interface_opts->snaplen : WTAP_MAX_PACKET_SIZE_STANDARD;
+    pcap_src->ts_nsec = TRUE;
+    pcap_src->pcap_h = pcap_open_dead(pcap_src->linktype, pcap_src->snaplen);
+    if (pcap_src->pcap_h == NULL) {
+        g_snprintf(errmsg, (gulong) errmsg_len, "Could not allocate memory.");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ * pcap_geterr() returns the pcap_t's error buffer, so putting our errors
+ * there gets them reported just like libpcap's.
+ */
+static void
+capture_loop_set_tpacket_error(capture_src *pcap_src, const char *errmsg)
+{
+    g_strlcpy(pcap_geterr(pcap_src->pcap_h), errmsg, PCAP_ERRBUF_SIZE);
+}
+
+/* Get the number of packets the kernel dropped on a source's rings. */
+static guint32
+capture_loop_tpacket_drops(capture_src *pcap_src)
+{
+    guint32 total = 0, packets, drops;
+    guint   i;
+
+    for (i = 0; i < pcap_src->tp_queues->len; i++) {
+        tpacket_queue *queue = (tpacket_queue *)g_ptr_array_index(pcap_src->tp_queues, i);
+
+        if (tpacket_ring_stats(queue->ring, &packets, &drops))
+            total += drops;
+    }
+    return total;
+}
+#endif /* HAVE_TPACKET3 */
+
 /** Open the capture input sources; each one is either a pcap device,
  *  a capture pipe, or a capture socket.
  *  Returns TRUE if it succeeds, FALSE otherwise. */
@@ -2832,6 +3441,15 @@ capture_loop_open_input(capture_options *capture_opts, loop_data *ld,
         g_array_append_val(ld->pcaps, pcap_src);
 
         g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, "capture_loop_open_input : %s", interface_opts->name);
+#ifdef HAVE_TPACKET3
+        if (tpacket_queues > 0 && if_nametoindex(interface_opts->name) != 0) {
+            /* A network interface, and we've been asked to read those ourselves */
+            if (!capture_loop_open_tpacket(interface_opts, pcap_src, errmsg, errmsg_len)) {
+                return FALSE;
+            }
+            continue;
+        }
+#endif
         pcap_src->pcap_h = open_capture_device(capture_opts, interface_opts,
             CAP_READ_TIMEOUT, &open_err, &open_err_str);
 
@@ -2999,6 +3617,15 @@ static void capture_loop_close_input(loop_data *ld)
                 cap_pipe_close(pcap_src->cap_pipe_fd, pcap_src->from_cap_socket);
                 pcap_src->cap_pipe_fd = -1;
             }
+#ifndef _WIN32
+            if (pcap_src->cap_pipe_ring != NULL) {
+                shm_ring_close(pcap_src->cap_pipe_ring);
+                pcap_src->cap_pipe_ring = NULL;
+            }
+            g_free(pcap_src->cap_pipe_rbuf);
+            pcap_src->cap_pipe_rbuf = NULL;
+            pcap_src->cap_pipe_rbuf_off = pcap_src->cap_pipe_rbuf_len = 0;
+#endif
 #ifdef _WIN32
             if (pcap_src->cap_pipe_h != INVALID_HANDLE_VALUE) {
                 CloseHandle(pcap_src->cap_pipe_h);
@@ -3015,6 +3642,21 @@ static void capture_loop_close_input(loop_data *ld)
                 pcap_src->cap_pipe_info.pcapng.src_iface_to_global = NULL;
             }
         } else {
+#ifdef HAVE_TPACKET3
+            /* TPACKET_V3 rings; the writer has given all their blocks back. */
+            if (pcap_src->tp_queues != NULL) {
+                guint q;
+
+                for (q = 0; q < pcap_src->tp_queues->len; q++) {
+                    tpacket_queue *queue = (tpacket_queue *)g_ptr_array_index(pcap_src->tp_queues, q);
+
+                    tpacket_ring_close(queue->ring);
+                    g_free(queue);
+                }
+                g_ptr_array_free(pcap_src->tp_queues, TRUE);
+                pcap_src->tp_queues = NULL;
+            }
+#endif
             /* Capture device.  If open, close the pcap_t. */
             if (pcap_src->pcap_h != NULL) {
                 g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, "capture_loop_close_input: closing %p", (void *)pcap_src->pcap_h);
@@ -3060,15 +3702,48 @@ capture_loop_init_filter(pcap_t *pcap_h, gboolean from_cap_pipe,
     return INITFILTER_NO_ERROR;
 }
 
-/*
- * Write the dumpcap pcapng SHB and IDBs if needed.
- * Called from capture_loop_init_output and do_file_switch_or_stop.
- */
-static gboolean
-capture_loop_init_pcapng_output(capture_options *capture_opts, loop_data *ld,
-                                int *err)
+#ifdef HAVE_TPACKET3
+/* init the capture filter for TPACKET_V3 rings */
+static initfilter_status_t
+capture_loop_init_tpacket_filter(capture_src *pcap_src, const gchar *name, const gchar *cfilter)
 {
-    g_rw_lock_reader_lock (&ld->saved_shb_idb_lock);
+    struct bpf_program  fcode;
+    char                errmsg[PCAP_ERRBUF_SIZE];
+    initfilter_status_t status = INITFILTER_NO_ERROR;
+    guint               i;
+
+    g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, "capture_loop_init_tpacket_filter: %s", cfilter);
+
+    /* Compile it against the stand-in pcap_t, and attach it to each ring. */
+    if (!compile_capture_filter(name, pcap_src->pcap_h, &fcode, cfilter)) {
+        return INITFILTER_BAD_FILTER;
+    }
+    for (i = 0; i < pcap_src->tp_queues->len; i++) {
+        tpacket_queue *queue = (tpacket_queue *)g_ptr_array_index(pcap_src->tp_queues, i);
+
+        if (!tpacket_ring_set_filter(queue->ring, &fcode, errmsg, sizeof errmsg)) {
+            capture_loop_set_tpacket_error(pcap_src, errmsg);
+            status = INITFILTER_OTHER_ERROR;
+            break;
+        }
+    }
+#ifdef HAVE_PCAP_FREECODE
+    pcap_freecode(&fcode);
+#endif
+
+    return status;
+}
+#endif
+
+/*
+ * Write the dumpcap pcapng SHB and IDBs if needed.
+ * Called from capture_loop_init_output and do_file_switch_or_stop.
+ */
+static gboolean
+capture_loop_init_pcapng_output(capture_options *capture_opts, loop_data *ld,
+                                int *err)
+{
+    g_rw_lock_reader_lock (&ld->saved_shb_idb_lock);
 
     if (ld->pcapng_passthrough && !ld->saved_shb) {
         /* We have a single pcapng capture interface and this is the first or only output file. */
@@ -3197,12 +3872,12 @@ capture_loop_init_output(capture_options *capture_opts, loop_data *ld, char *err
         if (ld->pdh == NULL) {
             err = errno;
         } else {
-            size_t buffsize = IO_BUF_SIZE;
+            size_t buffsize = CAPTURE_IO_BUF_SIZE;
 #ifdef HAVE_STRUCT_STAT_ST_BLKSIZE
             ws_statb64 statb;
 
             if (ws_fstat64(ld->save_file_fd, &statb) == 0) {
-                if (statb.st_blksize > IO_BUF_SIZE) {
+                if (statb.st_blksize > CAPTURE_IO_BUF_SIZE) {
                     buffsize = statb.st_blksize;
                 }
             }
@@ -3256,6 +3931,139 @@ capture_loop_init_output(capture_options *capture_opts, loop_data *ld, char *err
     return TRUE;
 }
 
+/* the name of the n'th --flow-files file: "capture.pcapng" -> "capture_<n>.pcapng" */
+static char *
+flow_output_name(const char *save_file, guint n)
+{
+    const char *base, *ext;
+
+    base = strrchr(save_file, G_DIR_SEPARATOR);
+    ext = strrchr(base != NULL ? base : save_file, '.');
+    if (ext == NULL || ext == base + 1 || ext == save_file)
+        return g_strdup_printf("%s_%u", save_file, n);
+    return g_strdup_printf("%.*s_%u%s", (int)(ext - save_file), save_file, n, ext);
+}
+
+/* close the second and later --flow-files files */
+static gboolean
+capture_loop_close_flow_outputs(int *err_close)
+{
+    gboolean success = TRUE;
+    guint i;
+
+    if (flow_outputs == NULL)
+        return TRUE;
+    for (i = 0; i < flow_files - 1; i++) {
+        if (flow_outputs[i].pdh != NULL && fclose(flow_outputs[i].pdh) == EOF) {
+            if (err_close != NULL && success)
+                *err_close = errno;
+            success = FALSE;
+        }
+        g_free(flow_outputs[i].io_buffer);
+        g_free(flow_outputs[i].name);
+    }
+    g_free(flow_outputs);
+    flow_outputs = NULL;
+    return success;
+}
+
+/* open the second and later --flow-files files, and write the same
+   headers to them as to the first */
+static gboolean
+capture_loop_init_flow_outputs(capture_options *capture_opts, loop_data *ld,
+                               char *errmsg, int errmsg_len)
+{
+    flow_output *fo;
+    FILE        *first_pdh = ld->pdh;
+    guint64      first_bytes_written = ld->bytes_written;
+    capture_src *pcap_src;
+    gboolean     successful;
+    int          fd, err = 0;
+    guint        i;
+
+    for (i = 0; i < ld->pcaps->len; i++) {
+        pcap_src = g_array_index(ld->pcaps, capture_src *, i);
+        if (pcap_src->from_pcapng) {
+            /* We'd have to get the IDBs it writes into all the files. */
+            g_snprintf(errmsg, errmsg_len,
+                       "Packets read from a pcapng pipe can't be spread across files with --flow-files.");
+            return FALSE;
+        }
+    }
+
+    flow_outputs = g_new0(flow_output, flow_files - 1);
+    for (i = 0; i < flow_files - 1; i++) {
+        fo = &flow_outputs[i];
+        fo->name = flow_output_name(capture_opts->save_file, i + 1);
+        fd = ws_open(fo->name, O_WRONLY|O_BINARY|O_TRUNC|O_CREAT,
+                     (capture_opts->group_read_access) ? 0640 : 0600);
+        if (fd == -1 || (fo->pdh = ws_fdopen(fd, "wb")) == NULL) {
+            err = errno;
+            if (fd != -1)
+                ws_close(fd);
+            break;
+        }
+        fo->io_buffer = (char *)g_malloc(CAPTURE_IO_BUF_SIZE);
+        setvbuf(fo->pdh, fo->io_buffer, _IOFBF, CAPTURE_IO_BUF_SIZE);
+
+        if (capture_opts->use_pcapng) {
+            /* The headers are written to ld->pdh. */
+            ld->pdh = fo->pdh;
+            ld->bytes_written = 0;
+            successful = capture_loop_init_pcapng_output(capture_opts, ld, &err);
+            fo->bytes_written = ld->bytes_written;
+            ld->pdh = first_pdh;
+            ld->bytes_written = first_bytes_written;
+        } else {
+            pcap_src = g_array_index(ld->pcaps, capture_src *, 0);
+            successful = libpcap_write_file_header(fo->pdh, pcap_src->linktype, pcap_src->snaplen,
+                                                   pcap_src->ts_nsec, &fo->bytes_written, &err);
+        }
+        if (!successful)
+            break;
+    }
+    if (i < flow_files - 1) {
+        g_snprintf(errmsg, errmsg_len,
+                   "The file to which part of the capture would be"
+                   " saved (\"%s\") could not be opened: %s.",
+                   flow_outputs[i].name, g_strerror(err));
+        for (i = 0; i < flow_files - 1; i++) {
+            if (flow_outputs[i].name != NULL)
+                ws_unlink(flow_outputs[i].name);
+        }
+        capture_loop_close_flow_outputs(NULL);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* pick the file to write a packet to; FALSE if --flow-sample leaves it out */
+static gboolean
+capture_loop_flow_output(capture_src *pcap_src, const guint8 *pd, guint32 caplen,
+                         FILE **pdh, guint64 **bytes_written)
+{
+    capture_flow_key key;
+    guint32 hash, bucket;
+
+    *pdh = global_ld.pdh;
+    *bytes_written = &global_ld.bytes_written;
+    if (flow_files < 2 && flow_sample < 2)
+        return TRUE;
+    if (!capture_flow_parse(pcap_src->linktype, pd, caplen, &key))
+        return TRUE;
+
+    hash = capture_flow_hash(&key);
+    bucket = flow_files > 1 ? hash % flow_files : 0;
+    /* Sample with other bits than those that picked the bucket. */
+    if (flow_sample > 1 && (hash / MAX(flow_files, 1)) % flow_sample != 0)
+        return FALSE;
+    if (bucket != 0) {
+        *pdh = flow_outputs[bucket - 1].pdh;
+        *bytes_written = &flow_outputs[bucket - 1].bytes_written;
+    }
+    return TRUE;
+}
+
 static gboolean
 capture_loop_close_output(capture_options *capture_opts, loop_data *ld, int *err_close)
 {
@@ -3277,6 +4085,12 @@ capture_loop_close_output(capture_options *capture_opts, loop_data *ld, int *err
                     guint64 isb_ifrecv, isb_ifdrop;
                     struct pcap_stat stats;
 
+#ifdef HAVE_TPACKET3
+                    if (pcap_src->from_tpacket) {
+                        isb_ifrecv = pcap_src->received;
+                        isb_ifdrop = capture_loop_tpacket_drops(pcap_src) + pcap_src->dropped + pcap_src->flushed;
+                    } else
+#endif
                     if (pcap_stats(pcap_src->pcap_h, &stats) >= 0) {
                         isb_ifrecv = pcap_src->received;
                         isb_ifdrop = stats.ps_drop + pcap_src->dropped + pcap_src->flushed;
@@ -3338,7 +4152,7 @@ capture_loop_dispatch(loop_data *ld,
 #ifdef _WIN32
         if (pcap_src->from_cap_socket) {
 #endif
-            sel_ret = cap_pipe_select(pcap_src->cap_pipe_fd);
+            sel_ret = cap_pipe_select(pcap_src, pcap_src->cap_pipe_fd);
             if (sel_ret <= 0) {
                 if (sel_ret < 0 && errno != EINTR) {
                     g_snprintf(errmsg, errmsg_len,
@@ -3389,7 +4203,7 @@ capture_loop_dispatch(loop_data *ld,
         g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, "capture_loop_dispatch: from pcap_dispatch with select");
 #endif
         if (pcap_src->pcap_fd != -1) {
-            sel_ret = cap_pipe_select(pcap_src->pcap_fd);
+            sel_ret = cap_pipe_select(pcap_src, pcap_src->pcap_fd);
             if (sel_ret > 0) {
                 /*
                  * "select()" says we can read from it without blocking; go for
@@ -3583,6 +4397,10 @@ capture_loop_open_output(capture_options *capture_opts, int *save_file_fd,
                 if (*save_file_fd != -1) {
                     g_free(capfile_name);
                     capfile_name = NULL;
+                    if (write_index) {
+                        /* remove indexes along with the files */
+                        ringbuf_set_sidecar_suffix(CAPTURE_INDEX_SUFFIX);
+                    }
                 }
                 if (capture_opts->print_file_names) {
                     if (!ringbuf_set_print_name(capture_opts->print_name_to, NULL)) {
@@ -3721,12 +4539,88 @@ static time_t get_next_time_interval(int interval_s) {
     return next_time;
 }
 
+static void
+index_write_thread(gpointer data, gpointer user_data _U_)
+{
+    index_write_job *job = (index_write_job *)data;
+    int              err;
+
+    err = capture_index_write(job->ci, job->path);
+    if (err != 0) {
+        /* Only the first error is reported. */
+        g_atomic_int_compare_and_exchange(&index_write_err, 0, err);
+    }
+    capture_index_free(job->ci);
+    g_free(job->path);
+    g_free(job);
+}
+
+/* Start an index for a new capture file, if we're writing them. */
+static void
+capture_loop_start_index(void)
+{
+    if (write_index) {
+        capture_index_free(capture_idx);
+        capture_idx = capture_index_new();
+    }
+}
+
+/* Have the index of a capture file that's done written beside it. */
+static void
+capture_loop_finish_index(const char *capture_file)
+{
+    index_write_job *job;
+
+    if (capture_idx == NULL)
+        return;
+
+    if (index_writer == NULL)
+        index_writer = g_thread_pool_new(index_write_thread, NULL, 1, FALSE, NULL);
+    job = g_new(index_write_job, 1);
+    job->ci = capture_idx;
+    job->path = g_strconcat(capture_file, CAPTURE_INDEX_SUFFIX, NULL);
+    g_thread_pool_push(index_writer, job, NULL);
+    capture_idx = NULL;
+}
+
+/* Wait for the indexes to be written, and report any failure. */
+static void
+capture_loop_wait_for_indexes(void)
+{
+    int err;
+
+    capture_index_free(capture_idx);
+    capture_idx = NULL;
+    if (index_writer != NULL) {
+        g_thread_pool_free(index_writer, FALSE, TRUE);
+        index_writer = NULL;
+    }
+    err = g_atomic_int_get(&index_write_err);
+    if (err != 0) {
+        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_WARNING,
+              "Couldn't write a capture index: %s", g_strerror(err));
+    }
+}
+
+/* Add a packet we're about to write at offset in the file to its index. */
+static inline void
+capture_loop_index_packet(capture_src *pcap_src, guint64 offset, guint32 sec,
+                          guint32 nsec, guint32 caplen, const guint8 *pd)
+{
+    if (capture_idx != NULL) {
+        capture_index_add_packet(capture_idx, (gint64)offset,
+                                 (gint64)sec * 1000000000 + nsec,
+                                 pcap_src->linktype, pd, caplen);
+    }
+}
+
 /* Do the work of handling either the file size or file duration capture
    conditions being reached, and switching files or stopping. */
 static gboolean
 do_file_switch_or_stop(capture_options *capture_opts)
 {
     gboolean          successful;
+    gint64            switch_start;
 
     if (capture_opts->multi_files_on) {
         if (capture_opts->has_autostop_files &&
@@ -3737,12 +4631,15 @@ do_file_switch_or_stop(capture_options *capture_opts)
         }
 
         /* Switch to the next ringbuffer file */
+        switch_start = g_get_monotonic_time();
+        capture_loop_finish_index(capture_opts->save_file);
         if (ringbuf_switch_file(&global_ld.pdh, &capture_opts->save_file,
                                 &global_ld.save_file_fd, &global_ld.err)) {
 
             /* File switch succeeded: reset the conditions */
             global_ld.bytes_written = 0;
             global_ld.packets_written = 0;
+            capture_loop_start_index();
             if (capture_opts->use_pcapng) {
                 successful = capture_loop_init_pcapng_output(capture_opts, &global_ld, &global_ld.err);
             } else {
@@ -3767,6 +4664,13 @@ do_file_switch_or_stop(capture_options *capture_opts)
                 global_ld.next_interval_time = get_next_time_interval(global_ld.interval_s);
             }
             fflush(global_ld.pdh);
+
+            /* Note how long the writer was held up by the switch */
+            file_switch_count++;
+            switch_start = g_get_monotonic_time() - switch_start;
+            if (switch_start > file_switch_max_usec)
+                file_switch_max_usec = switch_start;
+
             if (!quiet)
                 report_packet_count(global_ld.inpkts_to_sync_pipe);
             global_ld.inpkts_to_sync_pipe = 0;
@@ -3805,46 +4709,222 @@ pcap_read_handler(void* arg)
     return (NULL);
 }
 
-/* Try to pop an item off the packet queue and if it exists, write it */
-static gboolean
-capture_loop_dequeue_packet(void) {
+#ifdef HAVE_TPACKET3
+static void *
+tpacket_read_handler(void* arg)
+{
+    tpacket_queue *queue = (tpacket_queue *)arg;
+    capture_src   *pcap_src = queue->pcap_src;
+    char           errmsg[PCAP_ERRBUF_SIZE];
+    void          *block;
+    int            ret;
+
+    g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO, "Started thread for interface %d ring %u.",
+          pcap_src->interface_id, queue->index);
+
+    while (global_ld.go) {
+        ret = tpacket_ring_next_block(queue->ring, CAP_READ_TIMEOUT, &block, errmsg, sizeof errmsg);
+        if (ret < 0) {
+            /* Only the first ring to fail gets to say why. */
+            if (g_atomic_int_compare_and_exchange(&pcap_src->pcap_err, FALSE, TRUE))
+                capture_loop_set_tpacket_error(pcap_src, errmsg);
+            global_ld.go = FALSE;
+        } else if (ret > 0) {
+            capture_loop_queue_tpacket_block(queue, block);
+        }
+    }
+
+    g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO, "Stopped thread for interface %d ring %u.",
+          pcap_src->interface_id, queue->index);
+    g_thread_exit(NULL);
+    return (NULL);
+}
+#endif
+
+/* Write a dequeued element and free it */
+static void
+capture_loop_write_queue_element(pcap_queue_element *queue_element)
+{
+#ifdef HAVE_TPACKET3
+    if (queue_element->pcap_src->from_tpacket) {
+        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
+              "Dequeued a ring block of %u packets captured on interface %d.",
+              tpacket_block_num_packets(queue_element->u.tp.block),
+              queue_element->pcap_src->interface_id);
+
+        /* Write the packets straight from the ring, then hand the block back. */
+        tpacket_block_foreach(queue_element->u.tp.block, capture_loop_write_tpacket_cb,
+                              queue_element->pcap_src);
+        tpacket_ring_release_block(queue_element->u.tp.queue->ring, queue_element->u.tp.block);
+    } else
+#endif
+    if (queue_element->pcap_src->from_pcapng) {
+        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
+              "Dequeued a block of type 0x%08x of length %d captured on interface %d.",
+              queue_element->u.bh.block_type, queue_element->u.bh.block_total_length,
+              queue_element->pcap_src->interface_id);
+
+        capture_loop_write_pcapng_cb(queue_element->pcap_src,
+                                    &queue_element->u.bh,
+                                    queue_element->pd);
+    } else {
+        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
+            "Dequeued a packet of length %d captured on interface %d.",
+            queue_element->u.phdr.caplen, queue_element->pcap_src->interface_id);
+
+        capture_loop_write_packet_cb((u_char *) queue_element->pcap_src,
+                                    &queue_element->u.phdr,
+                                    queue_element->pd);
+    }
+    g_free(queue_element);
+}
+
+static inline gboolean
+reorder_before(const pcap_queue_element *a, const pcap_queue_element *b)
+{
+    return a->order_ts < b->order_ts ||
+           (a->order_ts == b->order_ts && a->order_seq < b->order_seq);
+}
+
+static void
+reorder_push(pcap_queue_element *queue_element)
+{
+    pcap_queue_element **heap;
+    guint                i, parent;
+
+    g_ptr_array_add(reorder_heap, queue_element);
+    heap = (pcap_queue_element **)reorder_heap->pdata;
+    for (i = reorder_heap->len - 1; i > 0; i = parent) {
+        parent = (i - 1) / 2;
+        if (!reorder_before(queue_element, heap[parent]))
+            break;
+        heap[i] = heap[parent];
+    }
+    heap[i] = queue_element;
+}
+
+static pcap_queue_element *
+reorder_pop(void)
+{
+    pcap_queue_element **heap = (pcap_queue_element **)reorder_heap->pdata;
+    pcap_queue_element  *first = heap[0], *last;
+    guint                len, i, child;
+
+    last = (pcap_queue_element *)g_ptr_array_remove_index_fast(reorder_heap, reorder_heap->len - 1);
+    len = reorder_heap->len;
+    if (len == 0)
+        return first;
+
+    /* Sift the last element down from the top */
+    heap = (pcap_queue_element **)reorder_heap->pdata;
+    for (i = 0; (child = 2 * i + 1) < len; i = child) {
+        if (child + 1 < len && reorder_before(heap[child + 1], heap[child]))
+            child++;
+        if (!reorder_before(heap[child], last))
+            break;
+        heap[i] = heap[child];
+    }
+    heap[i] = last;
+    return first;
+}
+
+/* Hold a captured packet back, to be written in time stamp order */
+static void
+reorder_hold(pcap_queue_element *queue_element, gint64 now)
+{
+    const struct pcap_pkthdr *phdr = &queue_element->u.phdr;
+
+    queue_element->order_ts = (guint64)phdr->ts.tv_sec * 1000000000 +
+        (guint64)phdr->ts.tv_usec * (queue_element->pcap_src->ts_nsec ? 1 : 1000);
+    queue_element->order_seq = reorder_seq++;
+    queue_element->held_since = now;
+    if (queue_element->order_ts > reorder_latest_ts)
+        reorder_latest_ts = queue_element->order_ts;
+    reorder_push(queue_element);
+}
+
+/* Write the held packets, in time stamp order, that are older than the
+   reorder window either by time stamp or by the time they have been held,
+   or all of them.  Returns the number of packets written. */
+static int
+reorder_release(gboolean all)
+{
     pcap_queue_element *queue_element;
+    gint64              now = g_get_monotonic_time();
+    int                 packets = 0;
+
+    while (reorder_heap != NULL && reorder_heap->len > 0) {
+        queue_element = (pcap_queue_element *)g_ptr_array_index(reorder_heap, 0);
+        if (!all &&
+            reorder_latest_ts - queue_element->order_ts < reorder_window &&
+            (guint64)(now - queue_element->held_since) * 1000 < reorder_window)
+            break;
+        capture_loop_write_queue_element(reorder_pop());
+        packets++;
+    }
+    return packets;
+}
+
+/* Pop up to WRITER_BATCH_SIZE items off the packet queue, waiting for
+   the first one for up to WRITER_THREAD_TIMEOUT, and write them; taking
+   the lock once for the batch keeps contention with the capture threads
+   down at high packet rates.  With a reorder window, packets are held
+   back and written in time stamp order instead.  Returns the number of
+   packets written. */
+static int
+capture_loop_dequeue_packets(void) {
+    pcap_queue_element *batch[WRITER_BATCH_SIZE];
+    pcap_queue_element *queue_element;
+    int                 count = 0, packets = 0, i;
+    gint64              now = 0;
 
     g_async_queue_lock(pcap_queue);
     queue_element = (pcap_queue_element *)g_async_queue_timeout_pop_unlocked(pcap_queue, WRITER_THREAD_TIMEOUT);
-    if (queue_element) {
-        if (queue_element->pcap_src->from_pcapng) {
-            pcap_queue_bytes -= queue_element->u.bh.block_total_length;
-        } else {
-            pcap_queue_bytes -= queue_element->u.phdr.caplen;
+    while (queue_element) {
+#ifdef HAVE_TPACKET3
+        if (queue_element->pcap_src->from_tpacket) {
+            pcap_queue_bytes -= tpacket_block_len(queue_element->u.tp.block);
+            pcap_queue_packets -= tpacket_block_num_packets(queue_element->u.tp.block);
+            packets += tpacket_block_num_packets(queue_element->u.tp.block);
+        } else
+#endif
+        {
+            if (queue_element->pcap_src->from_pcapng) {
+                pcap_queue_bytes -= queue_element->u.bh.block_total_length;
+            } else {
+                pcap_queue_bytes -= queue_element->u.phdr.caplen;
+            }
+            pcap_queue_packets -= 1;
         }
-        pcap_queue_packets -= 1;
+        batch[count++] = queue_element;
+        if (count == WRITER_BATCH_SIZE)
+            break;
+        queue_element = (pcap_queue_element *)g_async_queue_try_pop_unlocked(pcap_queue);
     }
     g_async_queue_unlock(pcap_queue);
-    if (queue_element) {
-        if (queue_element->pcap_src->from_pcapng) {
-            g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
-                  "Dequeued a block of type 0x%08x of length %d captured on interface %d.",
-                  queue_element->u.bh.block_type, queue_element->u.bh.block_total_length,
-                  queue_element->pcap_src->interface_id);
-
-            capture_loop_write_pcapng_cb(queue_element->pcap_src,
-                                        &queue_element->u.bh,
-                                        queue_element->pd);
+    if (reorder_window != 0)
+        now = g_get_monotonic_time();
+    for (i = 0; i < count; i++) {
+        queue_element = batch[i];
+#ifdef HAVE_TPACKET3
+        if (queue_element->pcap_src->from_tpacket) {
+            packets += tpacket_block_num_packets(queue_element->u.tp.block);
+        } else
+#endif
+        if (reorder_window != 0 && !queue_element->pcap_src->from_pcapng) {
+            reorder_hold(queue_element, now);
+            continue;
         } else {
-            g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
-                "Dequeued a packet of length %d captured on interface %d.",
-                queue_element->u.phdr.caplen, queue_element->pcap_src->interface_id);
-
-            capture_loop_write_packet_cb((u_char *) queue_element->pcap_src,
-                                        &queue_element->u.phdr,
-                                        queue_element->pd);
+            packets += 1;
         }
-        g_free(queue_element->pd);
-        g_free(queue_element);
-        return TRUE;
-    }
-    return FALSE;
+        /* Whole ring blocks and pcapng blocks aren't reordered; write
+           what is held before them. */
+        packets += reorder_release(TRUE);
+        capture_loop_write_queue_element(queue_element);
+    }
+    if (reorder_window != 0)
+        packets += reorder_release(FALSE);
+    return packets;
 }
 
 /*
@@ -3952,9 +5032,18 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
          * is NULL. This might be a bug in WPCap. Therefore we provide an empty
          * string.
          */
-        switch (capture_loop_init_filter(pcap_src->pcap_h, pcap_src->from_cap_pipe,
-                                         interface_opts->name,
-                                         interface_opts->cfilter?interface_opts->cfilter:"")) {
+        initfilter_status_t filter_status;
+
+#ifdef HAVE_TPACKET3
+        if (pcap_src->from_tpacket) {
+            filter_status = capture_loop_init_tpacket_filter(pcap_src, interface_opts->name,
+                                                             interface_opts->cfilter?interface_opts->cfilter:"");
+        } else
+#endif
+        filter_status = capture_loop_init_filter(pcap_src->pcap_h, pcap_src->from_cap_pipe,
+                                                 interface_opts->name,
+                                                 interface_opts->cfilter?interface_opts->cfilter:"");
+        switch (filter_status) {
 
         case INITFILTER_NO_ERROR:
             break;
@@ -3986,6 +5075,14 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
                                       sizeof(errmsg))) {
             goto error;
         }
+        if (flow_files > 1 &&
+            !capture_loop_init_flow_outputs(capture_opts, &global_ld, errmsg,
+                                            sizeof(errmsg))) {
+            fclose(global_ld.pdh);
+            global_ld.pdh = NULL;
+            goto error;
+        }
+        capture_loop_start_index();
 
         /* XXX - capture SIGTERM and close the capture, in case we're on a
            Linux 2.0[.x] system and you have to explicitly close the capture
@@ -4040,8 +5137,28 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
         pcap_queue = g_async_queue_new();
         pcap_queue_bytes = 0;
         pcap_queue_packets = 0;
+        pcap_queue_max_bytes = 0;
+        pcap_queue_max_packets = 0;
+        pcap_queue_full_drops = 0;
+        if (reorder_window != 0) {
+            reorder_heap = g_ptr_array_new();
+            reorder_latest_ts = 0;
+            reorder_seq = 0;
+        }
         for (i = 0; i < global_ld.pcaps->len; i++) {
             pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+#ifdef HAVE_TPACKET3
+            if (pcap_src->from_tpacket) {
+                guint q;
+
+                for (q = 0; q < pcap_src->tp_queues->len; q++) {
+                    tpacket_queue *queue = (tpacket_queue *)g_ptr_array_index(pcap_src->tp_queues, q);
+
+                    queue->tid = g_thread_new("Capture ring", tpacket_read_handler, queue);
+                }
+                continue;
+            }
+#endif
             /* XXX - Add an interface name here? */
             pcap_src->tid = g_thread_new("Capture read", pcap_read_handler, pcap_src);
         }
@@ -4049,13 +5166,7 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
     while (global_ld.go) {
         /* dispatch incoming packets */
         if (use_threads) {
-            gboolean dequeued = capture_loop_dequeue_packet();
-
-            if (dequeued) {
-                inpkts = 1;
-            } else {
-                inpkts = 0;
-            }
+            inpkts = capture_loop_dequeue_packets();
         } else {
             pcap_src = g_array_index(global_ld.pcaps, capture_src *, 0);
             inpkts = capture_loop_dispatch(&global_ld, errmsg,
@@ -4099,19 +5210,17 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
             }
         } /* inpkts */
 
-        /* Only update once every 500ms so as not to overload slow displays.
-         * This also prevents too much context-switching between the dumpcap
-         * and wireshark processes.
+        /* Only update once every update interval (500ms by default) so as
+         * not to overload slow displays. This also prevents too much
+         * context-switching between the dumpcap and wireshark processes.
          */
-#define DUMPCAP_UPD_TIME 500
-
 #ifdef _WIN32
         cur_time = GetTickCount();  /* Note: wraps to 0 if sys runs for 49.7 days */
-        if ((cur_time - upd_time) > DUMPCAP_UPD_TIME) /* wrap just causes an extra update */
+        if ((cur_time - upd_time) > capture_opts->update_interval) /* wrap just causes an extra update */
 #else
         gettimeofday(&cur_time, NULL);
         if (((guint64)cur_time.tv_sec * 1000000 + cur_time.tv_usec) >
-            ((guint64)upd_time.tv_sec * 1000000 + upd_time.tv_usec + DUMPCAP_UPD_TIME*1000))
+            ((guint64)upd_time.tv_sec * 1000000 + upd_time.tv_usec + (guint64)capture_opts->update_interval*1000))
 #endif
         {
 
@@ -4163,6 +5272,21 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
 
         for (i = 0; i < global_ld.pcaps->len; i++) {
             pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+#ifdef HAVE_TPACKET3
+            if (pcap_src->from_tpacket) {
+                guint q;
+
+                for (q = 0; q < pcap_src->tp_queues->len; q++) {
+                    tpacket_queue *queue = (tpacket_queue *)g_ptr_array_index(pcap_src->tp_queues, q);
+
+                    g_thread_join(queue->tid);
+                    pcap_src->dropped += queue->dropped;
+                }
+                g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO, "Ring threads of interface %u terminated.",
+                      pcap_src->interface_id);
+                continue;
+            }
+#endif
             g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO, "Waiting for thread of interface %u...",
                   pcap_src->interface_id);
             g_thread_join(pcap_src->tid);
@@ -4170,15 +5294,26 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
                   pcap_src->interface_id);
         }
         while (1) {
-            gboolean dequeued = capture_loop_dequeue_packet();
-            if (!dequeued) {
+            int dequeued = capture_loop_dequeue_packets();
+            /* Packets being reordered may be left in the queue after a
+               dequeue that wrote nothing. */
+            if (dequeued == 0 && g_async_queue_length(pcap_queue) <= 0) {
                 break;
             }
-            global_ld.inpkts_to_sync_pipe += 1;
+            global_ld.inpkts_to_sync_pipe += dequeued;
             if (capture_opts->output_to_pipe) {
                 fflush(global_ld.pdh);
             }
         }
+        if (reorder_heap != NULL) {
+            /* Write what the reorder window still holds. */
+            global_ld.inpkts_to_sync_pipe += reorder_release(TRUE);
+            if (capture_opts->output_to_pipe) {
+                fflush(global_ld.pdh);
+            }
+            g_ptr_array_free(reorder_heap, TRUE);
+            reorder_heap = NULL;
+        }
     }
 
 
@@ -4315,6 +5450,10 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
     if (capture_opts->saving_to_file) {
         /* close the output file */
         close_ok = capture_loop_close_output(capture_opts, &global_ld, &err_close);
+        if (!capture_loop_close_flow_outputs(close_ok ? &err_close : NULL))
+            close_ok = FALSE;
+        capture_loop_finish_index(capture_opts->save_file);
+        capture_loop_wait_for_indexes();
     } else
         close_ok = TRUE;
 
@@ -4354,6 +5493,23 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
         pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
         interface_opts = &g_array_index(capture_opts->ifaces, interface_options, i);
         received = pcap_src->received;
+#ifdef HAVE_TPACKET3
+        if (pcap_src->from_tpacket) {
+            guint q;
+
+            for (q = 0; q < pcap_src->tp_queues->len; q++) {
+                tpacket_queue *queue = (tpacket_queue *)g_ptr_array_index(pcap_src->tp_queues, q);
+                guint32        packets, drops = 0;
+
+                tpacket_ring_stats(queue->ring, &packets, &drops);
+                pcap_dropped += drops;
+                report_queue_drops(interface_opts->display_name, q, queue->received, drops, queue->dropped);
+            }
+            *stats_known = TRUE;
+            stats->ps_drop = pcap_dropped;
+            stats->ps_ifdrop = 0;
+        } else
+#endif
         if (pcap_src->pcap_h != NULL) {
             g_assert(!pcap_src->from_cap_pipe);
             /* Get the capture statistics, so we know how many packets were dropped. */
@@ -4370,6 +5526,7 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
         }
         report_packet_drops(received, pcap_dropped, pcap_src->dropped, pcap_src->flushed, stats->ps_ifdrop, interface_opts->display_name);
     }
+    report_writer_stats();
 
     /* close the input file (pcap or capture pipe) */
     capture_loop_close_input(&global_ld);
@@ -4380,6 +5537,7 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
     return write_ok && close_ok;
 
 error:
+    capture_loop_wait_for_indexes();
     if (capture_opts->multi_files_on) {
         /* cleanup ringbuffer */
         ringbuf_error_cleanup();
@@ -4556,12 +5714,15 @@ capture_loop_write_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t
                                        bh->block_total_length,
                                        &global_ld.bytes_written, &err);
 
-        fflush(global_ld.pdh);
         if (!successful) {
             global_ld.go = FALSE;
             global_ld.err = err;
             pcap_src->dropped++;
         } else if (bh->block_type == BLOCK_TYPE_EPB || bh->block_type == BLOCK_TYPE_SPB || bh->block_type == BLOCK_TYPE_SYSTEMD_JOURNAL) {
+            /* we don't look inside blocks we pass through, so an index
+               can't say where their packets are */
+            if (capture_idx != NULL)
+                capture_index_set_incomplete(capture_idx);
             /* count packet only if we actually have an EPB or SPB */
 #if defined(DEBUG_DUMPCAP) || defined(DEBUG_CHILD_DUMPCAP)
             g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
@@ -4581,6 +5742,9 @@ capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
     capture_src *pcap_src = (capture_src *) (void *) pcap_src_p;
     int          err;
     guint        ts_mul    = pcap_src->ts_nsec ? 1000000000 : 1000000;
+    guint32      caplen    = phdr->caplen;
+    FILE        *pdh;
+    guint64     *bytes_written;
 
     g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, "capture_loop_write_packet_cb");
 
@@ -4592,27 +5756,38 @@ capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
         return;
     }
 
+    if (slice_rules != NULL)
+        caplen = capture_slice_length(slice_rules, pcap_src->linktype, pd, caplen);
+
     if (global_ld.pdh) {
         gboolean successful;
 
+        if (!capture_loop_flow_output(pcap_src, pd, caplen, &pdh, &bytes_written))
+            return;
+
+        capture_loop_index_packet(pcap_src, *bytes_written,
+                                  (guint32)phdr->ts.tv_sec,
+                                  (guint32)phdr->ts.tv_usec * (pcap_src->ts_nsec ? 1 : 1000),
+                                  caplen, pd);
+
         /* We're supposed to write the packet to a file; do so.
            If this fails, set "ld->go" to FALSE, to stop the capture, and set
            "ld->err" to the error. */
         if (global_capture_opts.use_pcapng) {
-            successful = pcapng_write_enhanced_packet_block(global_ld.pdh,
+            successful = pcapng_write_enhanced_packet_block(pdh,
                                                             NULL,
                                                             phdr->ts.tv_sec, (gint32)phdr->ts.tv_usec,
-                                                            phdr->caplen, phdr->len,
+                                                            caplen, phdr->len,
                                                             pcap_src->interface_id,
                                                             ts_mul,
                                                             pd, 0,
-                                                            &global_ld.bytes_written, &err);
+                                                            bytes_written, &err);
         } else {
-            successful = libpcap_write_packet(global_ld.pdh,
+            successful = libpcap_write_packet(pdh,
                                               phdr->ts.tv_sec, (gint32)phdr->ts.tv_usec,
-                                              phdr->caplen, phdr->len,
+                                              caplen, phdr->len,
                                               pd,
-                                              &global_ld.bytes_written, &err);
+                                              bytes_written, &err);
         }
         if (!successful) {
             global_ld.go = FALSE;
@@ -4622,13 +5797,70 @@ capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
 #if defined(DEBUG_DUMPCAP) || defined(DEBUG_CHILD_DUMPCAP)
             g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
                   "Wrote a pcap packet of length %d captured on interface %u.",
-                   phdr->caplen, pcap_src->interface_id);
+                   caplen, pcap_src->interface_id);
 #endif
             capture_loop_wrote_one_packet(pcap_src);
         }
     }
 }
 
+#ifdef HAVE_TPACKET3
+/* one packet from a TPACKET_V3 ring block, write it */
+static void
+capture_loop_write_tpacket_cb(void *pcap_src_p, guint32 sec, guint32 nsec,
+                              guint32 caplen, guint32 len, const guint8 *pd)
+{
+    capture_src *pcap_src = (capture_src *)pcap_src_p;
+    int          err;
+    FILE        *pdh;
+    guint64     *bytes_written;
+
+    if (!global_ld.go) {
+        pcap_src->flushed++;
+        return;
+    }
+
+    /* The capture filter truncates packets, but there might not be one. */
+    if (caplen > (guint32)pcap_src->snaplen)
+        caplen = (guint32)pcap_src->snaplen;
+    if (slice_rules != NULL)
+        caplen = capture_slice_length(slice_rules, pcap_src->linktype, pd, caplen);
+
+    if (global_ld.pdh) {
+        gboolean successful;
+
+        if (!capture_loop_flow_output(pcap_src, pd, caplen, &pdh, &bytes_written))
+            return;
+
+        capture_loop_index_packet(pcap_src, *bytes_written, sec, nsec, caplen, pd);
+
+        if (global_capture_opts.use_pcapng) {
+            successful = pcapng_write_enhanced_packet_block(pdh,
+                                                            NULL,
+                                                            sec, nsec,
+                                                            caplen, len,
+                                                            pcap_src->interface_id,
+                                                            1000000000,
+                                                            pd, 0,
+                                                            bytes_written, &err);
+        } else {
+            successful = libpcap_write_packet(pdh,
+                                              sec, nsec,
+                                              caplen, len,
+                                              pd,
+                                              bytes_written, &err);
+        }
+        if (!successful) {
+            global_ld.go = FALSE;
+            global_ld.err = err;
+            pcap_src->dropped++;
+        } else {
+            capture_loop_wrote_one_packet(pcap_src);
+        }
+    }
+}
+#endif
+
 /* one packet was captured, queue it */
 static void
 capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
@@ -4646,19 +5878,15 @@ capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
         return;
     }
 
-    queue_element = g_new(pcap_queue_element, 1);
+    /* One allocation for the element and the data. */
+    queue_element = (pcap_queue_element *)g_try_malloc(sizeof(pcap_queue_element) + phdr->caplen);
     if (queue_element == NULL) {
        pcap_src->dropped++;
        return;
     }
     queue_element->pcap_src = pcap_src;
     queue_element->u.phdr = *phdr;
-    queue_element->pd = (u_char *)g_malloc(phdr->caplen);
-    if (queue_element->pd == NULL) {
-        pcap_src->dropped++;
-        g_free(queue_element);
-        return;
-    }
+    queue_element->pd = (u_char *)(queue_element + 1);
     memcpy(queue_element->pd, pd, phdr->caplen);
     g_async_queue_lock(pcap_queue);
     if (((pcap_queue_byte_limit == 0) || (pcap_queue_bytes < pcap_queue_byte_limit)) &&
@@ -4667,13 +5895,17 @@ capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
         g_async_queue_push_unlocked(pcap_queue, queue_element);
         pcap_queue_bytes += phdr->caplen;
         pcap_queue_packets += 1;
+        if (pcap_queue_bytes > pcap_queue_max_bytes)
+            pcap_queue_max_bytes = pcap_queue_bytes;
+        if (pcap_queue_packets > pcap_queue_max_packets)
+            pcap_queue_max_packets = pcap_queue_packets;
     } else {
         limit_reached = TRUE;
+        pcap_queue_full_drops++;
     }
     g_async_queue_unlock(pcap_queue);
     if (limit_reached) {
         pcap_src->dropped++;
-        g_free(queue_element->pd);
         g_free(queue_element);
         g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
               "Dropped a packet of length %d captured on interface %u.",
@@ -4706,19 +5938,15 @@ capture_loop_queue_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t
         return;
     }
 
-    queue_element = g_new(pcap_queue_element, 1);
+    /* One allocation for the element and the data. */
+    queue_element = (pcap_queue_element *)g_try_malloc(sizeof(pcap_queue_element) + bh->block_total_length);
     if (queue_element == NULL) {
        pcap_src->dropped++;
        return;
     }
     queue_element->pcap_src = pcap_src;
     queue_element->u.bh = *bh;
-    queue_element->pd = (u_char *)g_malloc(bh->block_total_length);
-    if (queue_element->pd == NULL) {
-        pcap_src->dropped++;
-        g_free(queue_element);
-        return;
-    }
+    queue_element->pd = (u_char *)(queue_element + 1);
     memcpy(queue_element->pd, pd, bh->block_total_length);
     g_async_queue_lock(pcap_queue);
     if (((pcap_queue_byte_limit == 0) || (pcap_queue_bytes < pcap_queue_byte_limit)) &&
@@ -4727,13 +5955,17 @@ capture_loop_queue_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t
         g_async_queue_push_unlocked(pcap_queue, queue_element);
         pcap_queue_bytes += bh->block_total_length;
         pcap_queue_packets += 1;
+        if (pcap_queue_bytes > pcap_queue_max_bytes)
+            pcap_queue_max_bytes = pcap_queue_bytes;
+        if (pcap_queue_packets > pcap_queue_max_packets)
+            pcap_queue_max_packets = pcap_queue_packets;
     } else {
         limit_reached = TRUE;
+        pcap_queue_full_drops++;
     }
     g_async_queue_unlock(pcap_queue);
     if (limit_reached) {
         pcap_src->dropped++;
-        g_free(queue_element->pd);
         g_free(queue_element);
         g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
               "Dropped a packet of length %d captured on interface %u.",
@@ -4751,6 +5983,61 @@ capture_loop_queue_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t
           pcap_queue_bytes, pcap_queue_packets);
 }
 
+#ifdef HAVE_TPACKET3
+/* one block was filled by the kernel in a TPACKET_V3 ring, queue it */
+static void
+capture_loop_queue_tpacket_block(tpacket_queue *queue, void *block)
+{
+    pcap_queue_element *queue_element;
+    guint32             num_packets = tpacket_block_num_packets(block);
+    guint32             len = tpacket_block_len(block);
+    gboolean            limit_reached;
+
+    if (num_packets == 0) {
+        tpacket_ring_release_block(queue->ring, block);
+        return;
+    }
+
+    /* The packets stay in the ring until the writer is done with them. */
+    queue_element = g_try_new(pcap_queue_element, 1);
+    if (queue_element == NULL) {
+        queue->dropped += num_packets;
+        tpacket_ring_release_block(queue->ring, block);
+        return;
+    }
+    queue_element->pcap_src = queue->pcap_src;
+    queue_element->u.tp.queue = queue;
+    queue_element->u.tp.block = block;
+    queue_element->pd = NULL;
+    g_async_queue_lock(pcap_queue);
+    if (((pcap_queue_byte_limit == 0) || (pcap_queue_bytes < pcap_queue_byte_limit)) &&
+        ((pcap_queue_packet_limit == 0) || (pcap_queue_packets < pcap_queue_packet_limit))) {
+        limit_reached = FALSE;
+        g_async_queue_push_unlocked(pcap_queue, queue_element);
+        pcap_queue_bytes += len;
+        pcap_queue_packets += num_packets;
+        if (pcap_queue_bytes > pcap_queue_max_bytes)
+            pcap_queue_max_bytes = pcap_queue_bytes;
+        if (pcap_queue_packets > pcap_queue_max_packets)
+            pcap_queue_max_packets = pcap_queue_packets;
+    } else {
+        limit_reached = TRUE;
+        pcap_queue_full_drops += num_packets;
+    }
+    g_async_queue_unlock(pcap_queue);
+    if (limit_reached) {
+        queue->dropped += num_packets;
+        tpacket_ring_release_block(queue->ring, block);
+        g_free(queue_element);
+        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
+              "Dropped a ring block of %u packets captured on interface %u.",
+              num_packets, queue->pcap_src->interface_id);
+    } else {
+        queue->received += num_packets;
+    }
+}
+#endif
+
 static int
 set_80211_channel(const char *iface, const char *opt)
 {
@@ -4828,6 +6115,13 @@ get_dumpcap_runtime_info(GString *str)
 
 #define LONGOPT_IFNAME             LONGOPT_BASE_APPLICATION+1
 #define LONGOPT_IFDESCR            LONGOPT_BASE_APPLICATION+2
+#define LONGOPT_TPACKET            LONGOPT_BASE_APPLICATION+3
+#define LONGOPT_INDEX              LONGOPT_BASE_APPLICATION+4
+#define LONGOPT_REORDER_WINDOW     LONGOPT_BASE_APPLICATION+5
+#define LONGOPT_SLICE              LONGOPT_BASE_APPLICATION+6
+#define LONGOPT_FLOW_FILES         LONGOPT_BASE_APPLICATION+7
+#define LONGOPT_FLOW_SAMPLE        LONGOPT_BASE_APPLICATION+8
+#define LONGOPT_CPU_AFFINITY       LONGOPT_BASE_APPLICATION+9
 
 /* And now our feature presentation... [ fade to music ] */
 int
@@ -4841,6 +6135,15 @@ main(int argc, char *argv[])
         LONGOPT_CAPTURE_COMMON
         {"ifname", required_argument, NULL, LONGOPT_IFNAME},
         {"ifdescr", required_argument, NULL, LONGOPT_IFDESCR},
+#ifdef HAVE_TPACKET3
+        {"tpacket", required_argument, NULL, LONGOPT_TPACKET},
+#endif
+        {"index", no_argument, NULL, LONGOPT_INDEX},
+        {"reorder-window", required_argument, NULL, LONGOPT_REORDER_WINDOW},
+        {"slice", required_argument, NULL, LONGOPT_SLICE},
+        {"flow-files", required_argument, NULL, LONGOPT_FLOW_FILES},
+        {"flow-sample", required_argument, NULL, LONGOPT_FLOW_SAMPLE},
+        {"cpu-affinity", required_argument, NULL, LONGOPT_CPU_AFFINITY},
         {0, 0, 0, 0 }
     };
 
@@ -5195,6 +6498,7 @@ main(int argc, char *argv[])
         case 'I':        /* Monitor mode */
 #endif
         case LONGOPT_COMPRESS_TYPE:        /* compress type */
+        case LONGOPT_UPDATE_INTERVAL:      /* interval between reports of new packets */
             status = capture_opts_add_opt(&global_capture_opts, opt, optarg, &start_capture);
             if (status != 0) {
                 exit_main(status);
@@ -5223,6 +6527,53 @@ main(int argc, char *argv[])
                 exit_main(1);
             }
             break;
+#ifdef HAVE_TPACKET3
+        case LONGOPT_TPACKET:
+            tpacket_queues = get_positive_int(optarg, "number of TPACKET_V3 rings");
+            /* Each ring is read by its own thread. */
+            use_threads = TRUE;
+            break;
+#endif
+        case LONGOPT_INDEX:
+            write_index = TRUE;
+            break;
+        case LONGOPT_REORDER_WINDOW:
+            reorder_window = (guint64)get_positive_int(optarg, "reorder window") * 1000000;
+            /* The writer reorders what the capture threads queue. */
+            use_threads = TRUE;
+            break;
+        case LONGOPT_SLICE:
+        {
+            char *err_str;
+
+            if (slice_rules == NULL)
+                slice_rules = capture_slice_rules_new();
+            if (!capture_slice_rules_add(slice_rules, optarg, &err_str)) {
+                cmdarg_err("%s", err_str);
+                g_free(err_str);
+                exit_main(1);
+            }
+            break;
+        }
+        case LONGOPT_FLOW_FILES:
+            flow_files = get_positive_int(optarg, "number of flow files");
+            break;
+        case LONGOPT_FLOW_SAMPLE:
+            flow_sample = get_positive_int(optarg, "flow sampling rate");
+            break;
+        case LONGOPT_CPU_AFFINITY:
+        {
+            /* Before the interfaces are opened, so that the kernel's
+             * capture buffers are allocated on the CPUs' node */
+            char *affinity_err = ws_numa_set_cpu_affinity(optarg);
+
+            if (affinity_err != NULL) {
+                cmdarg_err("--cpu-affinity %s: %s.", optarg, affinity_err);
+                g_free(affinity_err);
+                exit_main(1);
+            }
+            break;
+        }
         case 'Z':
             capture_child = TRUE;
 #ifdef _WIN32
@@ -5393,6 +6744,27 @@ main(int argc, char *argv[])
                 exit_main(1);
             }
         }
+
+        if (write_index &&
+            (global_capture_opts.save_file == NULL || global_capture_opts.output_to_pipe)) {
+            cmdarg_err("An index can only be written for a capture saved to a permanent file.");
+            exit_main(1);
+        }
+
+        if (flow_files > 1) {
+            if (global_capture_opts.save_file == NULL || global_capture_opts.output_to_pipe) {
+                cmdarg_err("Flow files requested, but capture isn't being saved to a permanent file.");
+                exit_main(1);
+            }
+            if (global_capture_opts.multi_files_on) {
+                cmdarg_err("Flow files and a ring buffer can't be used at the same time.");
+                exit_main(1);
+            }
+            if (write_index) {
+                cmdarg_err("An index can't be written for flow files.");
+                exit_main(1);
+            }
+        }
     }
 
     /*
@@ -5435,10 +6807,12 @@ main(int argc, char *argv[])
 
     /*
      * "-S" requires no interface to be selected; it gives statistics
-     * for all interfaces.
+     * for all interfaces, counting only the packets that match the
+     * capture filter if one was given.
      */
     if (print_statistics) {
-        status = print_statistics_loop(machine_readable);
+        status = print_statistics_loop(machine_readable,
+                                       global_capture_opts.default_options.cfilter);
         exit_main(status);
     }
 
@@ -5828,6 +7202,46 @@ report_packet_drops(guint32 received, guint32 pcap_drops, guint32 drops, guint32
     }
 }
 
+#ifdef HAVE_TPACKET3
+static void
+report_queue_drops(const char *name, guint index, guint32 received, guint32 kernel_drops, guint32 drops)
+{
+    if (capture_child) {
+        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG,
+            "Packets received/dropped on interface '%s' ring %u: %u/%u (kernel:%u/dumpcap:%u)",
+            name, index, received, kernel_drops + drops, kernel_drops, drops);
+    } else {
+        fprintf(stderr,
+            "Packets received/dropped on interface '%s' ring %u: %u/%u (kernel:%u/dumpcap:%u)\n",
+            name, index, received, kernel_drops + drops, kernel_drops, drops);
+        /* stderr could be line buffered */
+        fflush(stderr);
+    }
+}
+#endif
+
+static void
+report_writer_stats(void)
+{
+    /* Nothing interesting to say unless we queued packets or switched files. */
+    if (!use_threads && file_switch_count == 0)
+        return;
+
+    if (capture_child) {
+        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG,
+            "Writer: queue high water %" G_GINT64_FORMAT " packets/%" G_GINT64_FORMAT " bytes, %u dropped on full queue, %u file switches, longest %" G_GINT64_FORMAT " us",
+            pcap_queue_max_packets, pcap_queue_max_bytes, pcap_queue_full_drops,
+            file_switch_count, file_switch_max_usec);
+    } else {
+        fprintf(stderr,
+            "Writer: queue high water %" G_GINT64_FORMAT " packets/%" G_GINT64_FORMAT " bytes, %u dropped on full queue, %u file switches, longest %" G_GINT64_FORMAT " us\n",
+            pcap_queue_max_packets, pcap_queue_max_bytes, pcap_queue_full_drops,
+            file_switch_count, file_switch_max_usec);
+        /* stderr could be line buffered */
+        fflush(stderr);
+    }
+}
+
 
 /************************************************************************************************/
 /* signal_pipe handling */
@@ -54,6 +54,7 @@
 #endif
 
 #include <wiretap/secrets-types.h>
+#include <wiretap/time_index.h>
 #include <wiretap/wtap.h>
 
 #include "epan/etypes.h"
@@ -72,7 +73,6 @@
 #include <ui/cmdarg_err.h>
 #include <wsutil/filesystem.h>
 #include <wsutil/file_util.h>
-#include <wsutil/wsgcrypt.h>
 #include <wsutil/plugins.h>
 #include <wsutil/privileges.h>
 #include <wsutil/report_message.h>
@@ -82,6 +82,7 @@
 #include <version_info.h>
 #include <wsutil/pint.h>
 #include <wsutil/strtoi.h>
+#include <wsutil/xxh3.h>
 #include <wiretap/wtap_opttypes.h>
 
 #include "ui/failure_message.h"
@@ -106,22 +107,50 @@ struct select_item {
 
 /*
  * Duplicate frame detection
+ *
+ * The packets in the window are kept in a ring, oldest first, which
+ * grows as needed up to the size of the window, and a hash table counts
+ * how many of them have each length and hash, so that checking for a
+ * duplicate doesn't mean comparing against every packet in the window.
  */
-typedef struct _fd_hash_t {
-    guint8     digest[16];
+typedef struct _fd_hash_key_t {
+    guint8     digest[XXH3_128_LEN];
     guint32    len;
+} fd_hash_key_t;
+
+typedef struct _fd_hash_t {
+    fd_hash_key_t key;
     nstime_t   frame_time;
 } fd_hash_t;
 
+typedef struct _fd_hash_count_t {
+    fd_hash_key_t key;
+    guint32    count;           /* entries in the window with the key */
+} fd_hash_count_t;
+
 #define DEFAULT_DUP_DEPTH       5   /* Used with -d */
-#define MAX_DUP_DEPTH     1000000   /* the maximum window (and actual size of fd_hash[]) for de-duplication */
+#define TIME_DUP_DEPTH    1000000   /* Used with -w */
+#define MAX_DUP_DEPTH   100000000   /* the maximum window for de-duplication */
 
-static fd_hash_t fd_hash[MAX_DUP_DEPTH];
-static int       dup_window    = DEFAULT_DUP_DEPTH;
-static int       cur_dup_entry = 0;
+static fd_hash_t  *fd_hash       = NULL;  /* the ring */
+static guint32     fd_hash_size  = 0;     /* entries allocated */
+static guint32     fd_hash_count = 0;     /* entries used */
+static guint32     dup_window    = DEFAULT_DUP_DEPTH;
+static guint32     cur_dup_entry = 0;     /* the newest entry */
+static GHashTable *fd_hash_keys  = NULL;  /* fd_hash_key_t -> fd_hash_count_t */
 
 static guint32   ignored_bytes  = 0;  /* Used with -I */
 
+/* Byte ranges to leave out of the hash, with --dup-ignore */
+typedef struct _dup_ignore_range_t {
+    guint32    offset;
+    guint32    len;
+} dup_ignore_range_t;
+
+static GArray   *dup_ignore_ranges = NULL;
+static guint8   *dup_ignore_buf = NULL;
+static guint32   dup_ignore_buf_size = 0;
+
 #define ONE_BILLION 1000000000
 
 /* Weights of different errors we can introduce */
@@ -590,15 +619,129 @@ remove_vlan_info(const wtap_packet_header *phdr, guint8* fd, guint32* len) {
     }
 }
 
+static guint
+fd_hash_key_hash(gconstpointer key)
+{
+    /* The digest is a hash already. */
+    return pntoh32(((const fd_hash_key_t *)key)->digest);
+}
+
+static gboolean
+fd_hash_key_equal(gconstpointer a, gconstpointer b)
+{
+    const fd_hash_key_t *key_a = (const fd_hash_key_t *)a;
+    const fd_hash_key_t *key_b = (const fd_hash_key_t *)b;
+
+    return key_a->len == key_b->len
+        && memcmp(key_a->digest, key_b->digest, XXH3_128_LEN) == 0;
+}
+
+/*
+ * Make the next entry in the ring the current one, dropping the oldest
+ * packet from the window if it's full.
+ */
+static fd_hash_t *
+dup_window_next(void)
+{
+    /* A window of 0 behaves like a window of 1; neither finds anything. */
+    guint32 window = MAX(dup_window, 1);
+
+    if (fd_hash_count == window) {
+        fd_hash_count_t *c;
+
+        cur_dup_entry++;
+        if (cur_dup_entry >= window)
+            cur_dup_entry = 0;
+
+        c = (fd_hash_count_t *)g_hash_table_lookup(fd_hash_keys, &fd_hash[cur_dup_entry].key);
+        if (c != NULL && --c->count == 0)
+            g_hash_table_remove(fd_hash_keys, &c->key);
+    } else {
+        if (fd_hash_count == fd_hash_size) {
+            fd_hash_size = MIN(MAX(fd_hash_size * 2, 1024), window);
+            fd_hash = g_renew(fd_hash_t, fd_hash, fd_hash_size);
+        }
+        cur_dup_entry = fd_hash_count++;
+    }
+
+    return &fd_hash[cur_dup_entry];
+}
+
+/* Count the current entry among the packets in the window. */
+static void
+dup_window_add(const fd_hash_t *entry)
+{
+    fd_hash_count_t *c;
+
+    c = (fd_hash_count_t *)g_hash_table_lookup(fd_hash_keys, &entry->key);
+    if (c == NULL) {
+        c = g_new(fd_hash_count_t, 1);
+        c->key = entry->key;
+        c->count = 0;
+        g_hash_table_insert(fd_hash_keys, &c->key, c);
+    }
+    c->count++;
+}
+
+static void
+dup_window_init(void)
+{
+    fd_hash_keys = g_hash_table_new_full(fd_hash_key_hash, fd_hash_key_equal, NULL, g_free);
+}
+
+static void
+dup_window_cleanup(void)
+{
+    if (fd_hash_keys != NULL)
+        g_hash_table_destroy(fd_hash_keys);
+    g_free(fd_hash);
+    g_free(dup_ignore_buf);
+    if (dup_ignore_ranges != NULL)
+        g_array_free(dup_ignore_ranges, TRUE);
+}
+
+/*
+ * Compute the digest of a frame, leaving out the first offset bytes and,
+ * counting from there, the --dup-ignore ranges.  The digest is XXH3-128,
+ * which is far faster than a cryptographic hash; nobody is expected to
+ * make packets collide on purpose to fool editcap.
+ */
+static void
+dup_digest(const guint8 *fd, guint32 len, guint32 offset, fd_hash_t *entry)
+{
+    const guint8 *data = &fd[offset];
+    guint32 data_len = len - offset;
+    guint i;
+
+    entry->key.len = len;
+
+    if (dup_ignore_ranges != NULL) {
+        if (data_len > dup_ignore_buf_size) {
+            dup_ignore_buf_size = MAX(data_len, 2048);
+            dup_ignore_buf = (guint8 *)g_realloc(dup_ignore_buf, dup_ignore_buf_size);
+        }
+        memcpy(dup_ignore_buf, data, data_len);
+        for (i = 0; i < dup_ignore_ranges->len; i++) {
+            const dup_ignore_range_t *range = &g_array_index(dup_ignore_ranges, dup_ignore_range_t, i);
+
+            if (range->offset < data_len)
+                memset(&dup_ignore_buf[range->offset], 0,
+                       MIN(range->len, data_len - range->offset));
+        }
+        data = dup_ignore_buf;
+    }
+
+    ws_xxh3_128(data, data_len, entry->key.digest);
+}
+
 static gboolean
 is_duplicate(guint8* fd, guint32 len) {
-    int i;
     const struct ieee80211_radiotap_header* tap_header;
+    fd_hash_t *entry;
+    gboolean dup;
 
     /*Hint to ignore some bytes at the start of the frame for the digest calculation(-I option) */
     guint32 offset = ignored_bytes;
-    guint32 new_len;
-    guint8 *new_fd;
 
     if (len <= ignored_bytes) {
         offset = 0;
@@ -612,63 +755,51 @@ is_duplicate(guint8* fd, guint32 len) {
             offset = 0;
     }
 
-    new_fd  = &fd[offset];
-    new_len = len - (offset);
-
-    cur_dup_entry++;
-    if (cur_dup_entry >= dup_window)
-        cur_dup_entry = 0;
+    entry = dup_window_next();
 
     /* Calculate our digest */
-    gcry_md_hash_buffer(GCRY_MD_MD5, fd_hash[cur_dup_entry].digest, new_fd, new_len);
-
-    fd_hash[cur_dup_entry].len = len;
+    dup_digest(fd, len, offset, entry);
 
-    /* Look for duplicates */
-    for (i = 0; i < dup_window; i++) {
-        if (i == cur_dup_entry)
-            continue;
-
-        if (fd_hash[i].len == fd_hash[cur_dup_entry].len
-            && memcmp(fd_hash[i].digest, fd_hash[cur_dup_entry].digest, 16) == 0) {
-            return TRUE;
-        }
-    }
+    /* Look for duplicates among the other packets in the window */
+    dup = g_hash_table_contains(fd_hash_keys, &entry->key);
+    dup_window_add(entry);
 
-    return FALSE;
+    return dup;
 }
 
 static gboolean
 is_duplicate_rel_time(guint8* fd, guint32 len, const nstime_t *current) {
-    int i;
+    fd_hash_t *entry;
+    guint32 n, i;
 
     /*Hint to ignore some bytes at the start of the frame for the digest calculation(-I option) */
     guint32 offset = ignored_bytes;
-    guint32 new_len;
-    guint8 *new_fd;
 
     if (len <= ignored_bytes) {
         offset = 0;
     }
 
-    new_fd  = &fd[offset];
-    new_len = len - (offset);
-
-    cur_dup_entry++;
-    if (cur_dup_entry >= dup_window)
-        cur_dup_entry = 0;
+    entry = dup_window_next();
 
     /* Calculate our digest */
-    gcry_md_hash_buffer(GCRY_MD_MD5, fd_hash[cur_dup_entry].digest, new_fd, new_len);
+    dup_digest(fd, len, offset, entry);
 
-    fd_hash[cur_dup_entry].len = len;
-    fd_hash[cur_dup_entry].frame_time.secs = current->secs;
-    fd_hash[cur_dup_entry].frame_time.nsecs = current->nsecs;
+    entry->frame_time.secs = current->secs;
+    entry->frame_time.nsecs = current->nsecs;
+
+    /*
+     * If no other packet in the window has the same length and
+     * digest, this one isn't a duplicate, and there's no need to look
+     * at the times.
+     */
+    if (!g_hash_table_contains(fd_hash_keys, &entry->key)) {
+        dup_window_add(entry);
+        return FALSE;
+    }
+    dup_window_add(entry);
 
     /*
      * Look for relative time related duplicates.
-     * This is hopefully a reasonably efficient mechanism for
-     * finding duplicates by rel time in the fd_hash[] cache.
      * We check starting from the most recently added hash
      * entries and work backwards towards older packets.
      * This approach allows the dup test to be terminated
@@ -679,35 +810,13 @@ is_duplicate_rel_time(guint8* fd, guint32 len, const nstime_t *current) {
      * "well-formed" in the sense that the packet timestamps are
      * in strict chronologically increasing order (which is NOT
      * always the case!!).
-     *
-     * The fd_hash[] table was deliberately created large (1,000,000).
-     * Looking for time related duplicates in large trace files with
-     * non-fractional dup time window values can potentially take
-     * a long time to complete.
      */
 
-    for (i = cur_dup_entry - 1;; i--) {
+    for (n = 1; n < fd_hash_count; n++) {
         nstime_t delta;
         int cmp;
 
-        if (i < 0)
-            i = dup_window - 1;
-
-        if (i == cur_dup_entry) {
-            /*
-             * We've decremented back to where we started.
-             * Check no more!
-             */
-            break;
-        }
-
-        if (nstime_is_unset(&(fd_hash[i].frame_time))) {
-            /*
-             * We've decremented to an unused fd_hash[] entry.
-             * Check no more!
-             */
-            break;
-        }
+        i = cur_dup_entry >= n ? cur_dup_entry - n : dup_window + cur_dup_entry - n;
 
         nstime_delta(&delta, current, &fd_hash[i].frame_time);
 
@@ -742,8 +851,7 @@ is_duplicate_rel_time(guint8* fd, guint32 len, const nstime_t *current) {
              * Check no more!
              */
             break;
-        } else if (fd_hash[i].len == fd_hash[cur_dup_entry].len
-                   && memcmp(fd_hash[i].digest, fd_hash[cur_dup_entry].digest, 16) == 0) {
+        } else if (fd_hash_key_equal(&fd_hash[i].key, &entry->key)) {
             return TRUE;
         }
     }
@@ -769,6 +877,10 @@ print_usage(FILE *output)
     fprintf(output, "                         Time format for -A/-B options is\n");
     fprintf(output, "                         YYYY-MM-DDThh:mm:ss[.nnnnnnnnn][Z|+-hh:mm]\n");
     fprintf(output, "                         Unix epoch timestamps are also supported.\n");
+    fprintf(output, "  --time-index <file>    use the time index of the input file saved in <file>\n");
+    fprintf(output, "                         to read only the part of it that can have packets\n");
+    fprintf(output, "                         selected by -A/-B; if <file> isn't an index of the\n");
+    fprintf(output, "                         input file as it is now, make one and save it there.\n");
     fprintf(output, "\n");
     fprintf(output, "Duplicate packet removal:\n");
     fprintf(output, "  --novlan               remove vlan info from packets before checking for duplicates.\n");
@@ -776,11 +888,18 @@ print_usage(FILE *output)
     fprintf(output, "  -D <dup window>        remove packet if duplicate; configurable <dup window>.\n");
     fprintf(output, "                         Valid <dup window> values are 0 to %d.\n", MAX_DUP_DEPTH);
     fprintf(output, "                         NOTE: A <dup window> of 0 with -v (verbose option) is\n");
-    fprintf(output, "                         useful to print MD5 hashes.\n");
+    fprintf(output, "                         useful to print packet hashes.\n");
     fprintf(output, "  -w <dup time window>   remove packet if duplicate packet is found EQUAL TO OR\n");
     fprintf(output, "                         LESS THAN <dup time window> prior to current packet.\n");
     fprintf(output, "                         A <dup time window> is specified in relative seconds\n");
     fprintf(output, "                         (e.g. 0.000001).\n");
+    fprintf(output, "  --dup-ignore <offset>[:<length>]\n");
+    fprintf(output, "                         ignore <length> bytes (default 1) at <offset> when\n");
+    fprintf(output, "                         checking for duplicates, counting from the first byte\n");
+    fprintf(output, "                         that isn't skipped by -I or --skip-radiotap-header.\n");
+    fprintf(output, "                         May be given more than once; e.g. --dup-ignore 8\n");
+    fprintf(output, "                         --dup-ignore 10:2 with -I 14 ignores the IPv4 TTL\n");
+    fprintf(output, "                         and header checksum of Ethernet frames.\n");
     fprintf(output, "           NOTE: The use of the 'Duplicate packet removal' options with\n");
     fprintf(output, "           other editcap options except -v may not always work as expected.\n");
     fprintf(output, "           Specifically the -r, -t or -S options will very likely NOT have the\n");
@@ -821,7 +940,7 @@ print_usage(FILE *output)
     fprintf(output, "                         the pseudo-random number generator. This allows one to\n");
     fprintf(output, "                         repeat a particular sequence of errors.\n");
     fprintf(output, "  -I <bytes to ignore>   ignore the specified number of bytes at the beginning\n");
-    fprintf(output, "                         of the frame during MD5 hash calculation, unless the\n");
+    fprintf(output, "                         of the frame during hash calculation, unless the\n");
     fprintf(output, "                         frame is too short, then the full frame is used.\n");
     fprintf(output, "                         Useful to remove duplicated packets taken on\n");
     fprintf(output, "                         several routers (different mac addresses for\n");
@@ -861,7 +980,7 @@ print_usage(FILE *output)
     fprintf(output, "  -v                     verbose output.\n");
     fprintf(output, "                         If -v is used with any of the 'Duplicate Packet\n");
     fprintf(output, "                         Removal' options (-d, -D or -w) then Packet lengths\n");
-    fprintf(output, "                         and MD5 hashes are printed to standard-error.\n");
+    fprintf(output, "                         and hashes are printed to standard-error.\n");
     fprintf(output, "  -V, --version          print version information and exit.\n");
 }
 
@@ -1100,6 +1219,8 @@ main(int argc, char *argv[])
 #define LONGOPT_DISCARD_ALL_SECRETS  LONGOPT_BASE_APPLICATION+5
 #define LONGOPT_CAPTURE_COMMENT      LONGOPT_BASE_APPLICATION+6
 #define LONGOPT_DISCARD_CAPTURE_COMMENT LONGOPT_BASE_APPLICATION+7
+#define LONGOPT_DUP_IGNORE           LONGOPT_BASE_APPLICATION+8
+#define LONGOPT_TIME_INDEX           LONGOPT_BASE_APPLICATION+9
 
     static const struct option long_options[] = {
         {"novlan", no_argument, NULL, LONGOPT_NO_VLAN},
@@ -1111,6 +1232,8 @@ main(int argc, char *argv[])
         {"version", no_argument, NULL, 'V'},
         {"capture-comment", required_argument, NULL, LONGOPT_CAPTURE_COMMENT},
         {"discard-capture-comment", no_argument, NULL, LONGOPT_DISCARD_CAPTURE_COMMENT},
+        {"dup-ignore", required_argument, NULL, LONGOPT_DUP_IGNORE},
+        {"time-index", required_argument, NULL, LONGOPT_TIME_INDEX},
         {0, 0, 0, 0 }
     };
 
@@ -1139,6 +1262,13 @@ main(int argc, char *argv[])
     guint         max_packet_number  = 0;
     GArray       *dsb_types          = NULL;
     GPtrArray    *dsb_filenames      = NULL;
+    char         *time_index_filename = NULL;
+    wtap_time_index *tidx            = NULL;
+    gboolean      build_time_index   = FALSE;
+    gboolean      read_stopped       = FALSE;
+    gboolean      have_stop_offset   = FALSE;
+    gint64        stop_offset        = 0;
+    guint32       skipped_count;
     wtap_rec                     read_rec;
     Buffer                       read_buf;
     const wtap_rec              *rec;
@@ -1266,6 +1396,27 @@ main(int argc, char *argv[])
             break;
         }
 
+        case LONGOPT_TIME_INDEX:
+        {
+            g_free(time_index_filename);
+            time_index_filename = g_strdup(optarg);
+            break;
+        }
+
+        case LONGOPT_DUP_IGNORE:
+        {
+            dup_ignore_range_t range;
+            gchar **parts = g_strsplit(optarg, ":", 2);
+
+            range.offset = get_guint32(parts[0], "offset of the bytes to ignore");
+            range.len = parts[1] != NULL ? get_guint32(parts[1], "number of bytes to ignore") : 1;
+            g_strfreev(parts);
+            if (dup_ignore_ranges == NULL)
+                dup_ignore_ranges = g_array_new(FALSE, FALSE, sizeof(dup_ignore_range_t));
+            g_array_append_val(dup_ignore_ranges, range);
+            break;
+        }
+
         case 'a':
         {
             guint frame_number;
@@ -1364,7 +1515,7 @@ main(int argc, char *argv[])
             dup_detect_by_time = FALSE;
             dup_window = get_guint32(optarg, "duplicate window");
             if (dup_window > MAX_DUP_DEPTH) {
-                fprintf(stderr, "editcap: \"%d\" duplicate window value must be between 0 and %d inclusive.\n",
+                fprintf(stderr, "editcap: \"%u\" duplicate window value must be between 0 and %d inclusive.\n",
                         dup_window, MAX_DUP_DEPTH);
                 ret = INVALID_OPTION;
                 goto clean_exit;
@@ -1482,7 +1633,7 @@ main(int argc, char *argv[])
         case 'w':
             dup_detect = FALSE;
             dup_detect_by_time = TRUE;
-            dup_window = MAX_DUP_DEPTH;
+            dup_window = TIME_DUP_DEPTH;
             if (!set_rel_time(optarg)) {
                 ret = INVALID_OPTION;
                 goto clean_exit;
@@ -1691,16 +1842,38 @@ main(int argc, char *argv[])
         max_packet_number = G_MAXUINT;
 
     if (dup_detect || dup_detect_by_time) {
-        for (i = 0; i < dup_window; i++) {
-            memset(&fd_hash[i].digest, 0, 16);
-            fd_hash[i].len = 0;
-            nstime_set_unset(&fd_hash[i].frame_time);
-        }
+        dup_window_init();
     }
 
     /* Set up an array of all IDBs seen */
     idbs_seen = g_array_new(FALSE, FALSE, sizeof(wtap_block_t));
 
+    if (time_index_filename != NULL) {
+        tidx = wtap_time_index_read(time_index_filename, wth);
+        if (tidx == NULL) {
+            /* There's no index of the file as it is now; make one. */
+            tidx = wtap_time_index_new();
+            build_time_index = TRUE;
+        } else if (split_packet_count == 0 && nstime_is_unset(&secs_per_block)) {
+            /*
+             * Don't read the parts of the file that can't have packets
+             * in the selected timeframe.  (When splitting, they still
+             * start new output files, so they have to be read.)
+             */
+            if (have_starttime) {
+                if (!wtap_time_index_seek(tidx, wth, &starttime, &skipped_count, &read_err)) {
+                    cfile_read_failure_message(argv[optind], read_err, NULL);
+                    ret = INVALID_FILE;
+                    goto clean_exit;
+                }
+                read_count += skipped_count;
+                count += skipped_count;
+            }
+            if (have_stoptime)
+                have_stop_offset = wtap_time_index_stop_offset(tidx, &stoptime, &stop_offset);
+        }
+    }
+
     /* Read all of the packets in turn */
     wtap_rec_init(&read_rec);
     ws_buffer_init(&read_buf, 1514);
@@ -1711,15 +1884,24 @@ main(int argc, char *argv[])
          * presumably indicate that we weren't capturing on that
          * interface at this point, but what about, for example, NRBs?
          */
-        if (max_packet_number <= read_count)
+        if (max_packet_number <= read_count) {
+            read_stopped = TRUE;
+            break;
+        }
+
+        /* The rest of the file is after the selected timeframe. */
+        if (have_stop_offset && data_offset >= stop_offset)
             break;
 
+        if (build_time_index)
+            wtap_time_index_add(tidx, wth, &read_rec, data_offset);
+
         read_count++;
 
         rec = &read_rec;
 
         /* Extra actions for the first packet */
-        if (read_count == 1) {
+        if (pdh == NULL) {
             if (split_packet_count != 0 || !nstime_is_unset(&secs_per_block)) {
                 if (!fileset_extract_prefix_suffix(argv[optind+1], &fprefix, &fsuffix)) {
                     ret = CANT_EXTRACT_PREFIX;
@@ -2012,12 +2194,12 @@ main(int argc, char *argv[])
                 if (dup_detect) {
                     if (is_duplicate(buf, rec->rec_header.packet_header.caplen)) {
                         if (verbose) {
-                            fprintf(stderr, "Skipped: %u, Len: %u, MD5 Hash: ",
+                            fprintf(stderr, "Skipped: %u, Len: %u, Hash: ",
                                     count,
                                     rec->rec_header.packet_header.caplen);
-                            for (i = 0; i < 16; i++)
+                            for (i = 0; i < XXH3_128_LEN; i++)
                                 fprintf(stderr, "%02x",
-                                        (unsigned char)fd_hash[cur_dup_entry].digest[i]);
+                                        (unsigned char)fd_hash[cur_dup_entry].key.digest[i]);
                             fprintf(stderr, "\n");
                         }
                         duplicate_count++;
@@ -2025,12 +2207,12 @@ main(int argc, char *argv[])
                         continue;
                     } else {
                         if (verbose) {
-                            fprintf(stderr, "Packet: %u, Len: %u, MD5 Hash: ",
+                            fprintf(stderr, "Packet: %u, Len: %u, Hash: ",
                                     count,
                                     rec->rec_header.packet_header.caplen);
-                            for (i = 0; i < 16; i++)
+                            for (i = 0; i < XXH3_128_LEN; i++)
                                 fprintf(stderr, "%02x",
-                                        (unsigned char)fd_hash[cur_dup_entry].digest[i]);
+                                        (unsigned char)fd_hash[cur_dup_entry].key.digest[i]);
                             fprintf(stderr, "\n");
                         }
                     }
@@ -2048,12 +2230,12 @@ main(int argc, char *argv[])
                                                   rec->rec_header.packet_header.caplen,
                                                   &current)) {
                             if (verbose) {
-                                fprintf(stderr, "Skipped: %u, Len: %u, MD5 Hash: ",
+                                fprintf(stderr, "Skipped: %u, Len: %u, Hash: ",
                                         count,
                                         rec->rec_header.packet_header.caplen);
-                                for (i = 0; i < 16; i++)
+                                for (i = 0; i < XXH3_128_LEN; i++)
                                     fprintf(stderr, "%02x",
-                                            (unsigned char)fd_hash[cur_dup_entry].digest[i]);
+                                            (unsigned char)fd_hash[cur_dup_entry].key.digest[i]);
                                 fprintf(stderr, "\n");
                             }
                             duplicate_count++;
@@ -2061,12 +2243,12 @@ main(int argc, char *argv[])
                             continue;
                         } else {
                             if (verbose) {
-                                fprintf(stderr, "Packet: %u, Len: %u, MD5 Hash: ",
+                                fprintf(stderr, "Packet: %u, Len: %u, Hash: ",
                                         count,
                                         rec->rec_header.packet_header.caplen);
-                                for (i = 0; i < 16; i++)
+                                for (i = 0; i < XXH3_128_LEN; i++)
                                     fprintf(stderr, "%02x",
-                                            (unsigned char)fd_hash[cur_dup_entry].digest[i]);
+                                            (unsigned char)fd_hash[cur_dup_entry].key.digest[i]);
                                 fprintf(stderr, "\n");
                             }
                         }
@@ -2219,6 +2401,13 @@ main(int argc, char *argv[])
         /* Print a message noting that the read failed somewhere along the
          * line. */
         cfile_read_failure_message(argv[optind], read_err, read_err_info);
+    } else if (build_time_index && !read_stopped) {
+        /* The whole file was read; save its index. */
+        wtap_time_index_finish(tidx, wth);
+        if (!wtap_time_index_write(tidx, time_index_filename, &write_err)) {
+            fprintf(stderr, "editcap: Can't write time index \"%s\": %s\n",
+                    time_index_filename, wtap_strerror(write_err));
+        }
     }
 
     if (!pdh) {
@@ -2250,7 +2439,7 @@ main(int argc, char *argv[])
     }
 
     if (dup_detect) {
-        fprintf(stderr, "%u packet%s seen, %u packet%s skipped with duplicate window of %i packets.\n",
+        fprintf(stderr, "%u packet%s seen, %u packet%s skipped with duplicate window of %u packets.\n",
                 count - 1, plurality(count - 1, "", "s"), duplicate_count,
                 plurality(duplicate_count, "", "s"), dup_window);
     } else if (dup_detect_by_time) {
@@ -2262,6 +2451,9 @@ main(int argc, char *argv[])
     }
 
 clean_exit:
+    dup_window_cleanup();
+    wtap_time_index_free(tidx);
+    g_free(time_index_filename);
     if (dsb_filenames) {
         g_array_free(dsb_types, TRUE);
         g_ptr_array_free(dsb_filenames, TRUE);
@@ -81,12 +81,14 @@
 #include "addr_and_mask.h"
 #include "ipv6.h"
 #include "addr_resolv.h"
+#include "addr_resolv_data.h"
 #include "wsutil/filesystem.h"
 
 #include <wsutil/report_message.h>
 #include <wsutil/file_util.h>
 #include <wsutil/pint.h>
 #include <wsutil/inet_addr.h>
+#include <wsutil/strtoi.h>
 
 #include <epan/strutil.h>
 #include <epan/to_str-int.h>
@@ -98,12 +100,12 @@
 #define ENAME_SUBNETS   "subnets"
 #define ENAME_ETHERS    "ethers"
 #define ENAME_IPXNETS   "ipxnets"
-#define ENAME_MANUF     "manuf"
 #define ENAME_WKA       "wka"
 #define ENAME_SERVICES  "services"
 #define ENAME_VLANS     "vlans"
 #define ENAME_SS7PCS    "ss7pcs"
 #define ENAME_ENTERPRISES "enterprises.tsv"
+#define ENAME_DNS_CACHE "dns_cache"
 
 #define HASHETHSIZE      2048
 #define HASHHOSTSIZE     2048
@@ -222,6 +224,10 @@ static wmem_map_t *wka_hashtable = NULL;
 static wmem_map_t *eth_hashtable = NULL;
 // Maps guint -> serv_port_t*
 static wmem_map_t *serv_port_hashtable = NULL;
+/* Whether the tables above also have all entries of the compiled-in tables */
+static gboolean manuf_hashtable_complete = FALSE;
+static gboolean wka_hashtable_complete = FALSE;
+static gboolean serv_port_hashtable_complete = FALSE;
 static GHashTable *enterprises_hashtable = NULL;
 
 static subnet_length_entry_t subnet_length_entries[SUBNETLENGTHSIZE]; /* Ordered array of entries */
@@ -294,14 +300,11 @@ static gboolean resolve_synchronously = FALSE;
 gchar *g_ethers_path    = NULL;     /* global ethers file     */
 gchar *g_pethers_path   = NULL;     /* personal ethers file   */
 gchar *g_wka_path       = NULL;     /* global well-known-addresses file */
-gchar *g_manuf_path     = NULL;     /* global manuf file      */
 gchar *g_ipxnets_path   = NULL;     /* global ipxnets file    */
 gchar *g_pipxnets_path  = NULL;     /* personal ipxnets file  */
-gchar *g_services_path  = NULL;     /* global services file   */
 gchar *g_pservices_path = NULL;     /* personal services file */
 gchar *g_pvlan_path     = NULL;     /* personal vlans file    */
 gchar *g_ss7pcs_path    = NULL;     /* personal ss7pcs file   */
-gchar *g_enterprises_path = NULL;   /* global enterprises file   */
 gchar *g_penterprises_path = NULL;  /* personal enterprises file */
                                     /* first resolving call   */
 
@@ -349,6 +352,24 @@ static  gboolean  async_dns_initialized = FALSE;
 static  guint       async_dns_in_flight = 0;
 static  wmem_list_t *async_dns_queue_head = NULL;
 
+/*
+ * Names found with the external resolver, and addresses it found no
+ * name for, are kept in the personal ENAME_DNS_CACHE file for
+ * dns_cache_ttl seconds, so that reading the same capture again, or
+ * another one from the same network, doesn't have to wait for DNS.
+ * c-ares doesn't tell us the TTLs of the records it found, so all the
+ * entries get the same lifetime.
+ */
+typedef struct _dns_cache_entry
+{
+    gchar   *name;      /* NULL if there's no name for the address */
+    gint64   expires;   /* seconds since the Epoch */
+} dns_cache_entry_t;
+
+static guint dns_cache_ttl = 0;
+static GHashTable *dns_cache_table = NULL;  /* printable address -> dns_cache_entry_t */
+static gboolean dns_cache_changed = FALSE;
+
 //UAT for providing a list of DNS servers to C-ARES for name resolution
 gboolean use_custom_dns_server_list = FALSE;
 struct dns_server_data {
@@ -395,6 +416,50 @@ dnsserver_uat_fld_ip_chk_cb(void* r _U_, const char* ipaddr, guint len _U_, cons
 
 
 
+static void
+dns_cache_entry_free(gpointer data)
+{
+    dns_cache_entry_t *entry = (dns_cache_entry_t *)data;
+
+    g_free(entry->name);
+    g_free(entry);
+}
+
+/*
+ * Remember what the external resolver said about an address, if the
+ * cache is in use: the name it found, or, if status says there isn't
+ * one, that there isn't.  Other failures, such as timeouts, aren't
+ * remembered, so that the address is looked up again next time.
+ */
+static void
+dns_cache_add(int family, const void *addr, int status, const struct hostent *he)
+{
+    dns_cache_entry_t *entry;
+    gchar addr_str[WS_INET6_ADDRSTRLEN];
+
+    if (!dns_cache_table)
+        return;
+
+    if (status == ARES_SUCCESS && he->h_name && he->h_name[0] != '\0') {
+        entry = g_new(dns_cache_entry_t, 1);
+        entry->name = g_strdup(he->h_name);
+    } else if (status == ARES_ENOTFOUND || status == ARES_SUCCESS) {
+        entry = g_new(dns_cache_entry_t, 1);
+        entry->name = NULL;
+    } else {
+        return;
+    }
+    entry->expires = g_get_real_time() / G_USEC_PER_SEC + dns_cache_ttl;
+
+    if (family == AF_INET)
+        ip_to_str_buf((const guint8 *)addr, addr_str, sizeof(addr_str));
+    else
+        ip6_to_str_buf((const ws_in6_addr *)addr, addr_str, sizeof(addr_str));
+
+    g_hash_table_replace(dns_cache_table, g_strdup(addr_str), entry);
+    dns_cache_changed = TRUE;
+}
+
 static void
 c_ares_ghba_sync_cb(void *arg, int status, int timeouts _U_, struct hostent *he) {
     sync_dns_data_t *sdd = (sync_dns_data_t *)arg;
@@ -416,6 +481,7 @@ c_ares_ghba_sync_cb(void *arg, int status, int timeouts _U_, struct hostent *he)
         }
 
     }
+    dns_cache_add(sdd->family, &sdd->addr, status, he);
 
     /*
      * Let our caller know that this is complete.
@@ -520,7 +586,7 @@ sync_lookup_ip6(const ws_in6_addr *addr)
     sdd->family = AF_INET6;
     memcpy(&sdd->addr.ip6, addr, sizeof(sdd->addr.ip6));
     sdd->completed = &completed;
-    ares_gethostbyaddr(ghba_chan, &addr, sizeof(ws_in6_addr), AF_INET6,
+    ares_gethostbyaddr(ghba_chan, addr, sizeof(ws_in6_addr), AF_INET6,
                        c_ares_ghba_sync_cb, sdd);
 
     /*
@@ -758,34 +824,84 @@ wmem_utoa(wmem_allocator_t *allocator, guint port)
     return bp;
 }
 
-static const gchar *
-_serv_name_lookup(port_type proto, guint port, serv_port_t **value_ret)
+/* A name in the compiled-in tables, or NULL if there is none */
+static inline const gchar *
+resolv_data_name(guint32 offset)
 {
-    serv_port_t *serv_port_table;
+    return offset != 0 ? &resolv_data_strings[offset] : NULL;
+}
 
-    serv_port_table = (serv_port_t *)wmem_map_lookup(serv_port_hashtable, GUINT_TO_POINTER(port));
+static int
+resolv_data_serv_port_cmp(const void *key, const void *member)
+{
+    guint port = *(const guint *)key;
+    guint member_port = ((const resolv_data_serv_port_t *)member)->port;
 
-    if (value_ret != NULL)
-        *value_ret = serv_port_table;
+    return port < member_port ? -1 : port > member_port;
+}
+
+/* Look a port up in the table compiled from the global services file. */
+static const gchar *
+resolv_data_serv_name_lookup(port_type proto, guint port)
+{
+    const resolv_data_serv_port_t *serv_port;
 
-    if (serv_port_table == NULL)
+    serv_port = (const resolv_data_serv_port_t *)bsearch(&port, resolv_data_serv_port,
+            resolv_data_serv_port_count, sizeof(resolv_data_serv_port_t), resolv_data_serv_port_cmp);
+    if (serv_port == NULL)
         return NULL;
 
     switch (proto) {
         case PT_UDP:
-            return serv_port_table->udp_name;
+            return resolv_data_name(serv_port->udp_name);
         case PT_TCP:
-            return serv_port_table->tcp_name;
+            return resolv_data_name(serv_port->tcp_name);
         case PT_SCTP:
-            return serv_port_table->sctp_name;
+            return resolv_data_name(serv_port->sctp_name);
         case PT_DCCP:
-            return serv_port_table->dccp_name;
+            return resolv_data_name(serv_port->dccp_name);
         default:
             break;
     }
     return NULL;
 }
 
+static const gchar *
+_serv_name_lookup(port_type proto, guint port, serv_port_t **value_ret)
+{
+    serv_port_t *serv_port_table;
+    const gchar *name = NULL;
+
+    serv_port_table = (serv_port_t *)wmem_map_lookup(serv_port_hashtable, GUINT_TO_POINTER(port));
+
+    if (value_ret != NULL)
+        *value_ret = serv_port_table;
+
+    /* Names from the personal services file replace the global ones. */
+    if (serv_port_table != NULL) {
+        switch (proto) {
+            case PT_UDP:
+                name = serv_port_table->udp_name;
+                break;
+            case PT_TCP:
+                name = serv_port_table->tcp_name;
+                break;
+            case PT_SCTP:
+                name = serv_port_table->sctp_name;
+                break;
+            case PT_DCCP:
+                name = serv_port_table->dccp_name;
+                break;
+            default:
+                break;
+        }
+    }
+    if (name == NULL)
+        name = resolv_data_serv_name_lookup(proto, port);
+
+    return name;
+}
+
 const gchar *
 try_serv_name_lookup(port_type proto, guint port)
 {
@@ -819,12 +935,10 @@ initialize_services(void)
     gboolean parse_file = TRUE;
     g_assert(serv_port_hashtable == NULL);
     serv_port_hashtable = wmem_map_new(wmem_epan_scope(), g_direct_hash, g_direct_equal);
+    serv_port_hashtable_complete = FALSE;
 
-    /* Compute the pathname of the services file. */
-    if (g_services_path == NULL) {
-        g_services_path = get_datafile_path(ENAME_SERVICES);
-    }
-    parse_services_file(g_services_path);
+    /* The global services file is compiled into resolv_data_serv_port;
+     * only the personal one is read into the hash table. */
 
     /* Compute the pathname of the personal services file */
     if (g_pservices_path == NULL) {
@@ -846,8 +960,6 @@ static void
 service_name_lookup_cleanup(void)
 {
     serv_port_hashtable = NULL;
-    g_free(g_services_path);
-    g_services_path = NULL;
     g_free(g_pservices_path);
     g_pservices_path = NULL;
 }
@@ -908,10 +1020,8 @@ initialize_enterprises(void)
     g_assert(enterprises_hashtable == NULL);
     enterprises_hashtable = g_hash_table_new_full(NULL, NULL, NULL, g_free);
 
-    if (g_enterprises_path == NULL) {
-        g_enterprises_path = get_datafile_path(ENAME_ENTERPRISES);
-    }
-    parse_enterprises_file(g_enterprises_path);
+    /* The global enterprises file is compiled into resolv_data_enterprises;
+     * only the personal one is read into the hash table. */
 
     if (g_penterprises_path == NULL) {
         /* Check profile directory before personal configuration */
@@ -924,10 +1034,28 @@ initialize_enterprises(void)
     parse_enterprises_file(g_penterprises_path);
 }
 
+static int
+resolv_data_enterprise_cmp(const void *key, const void *member)
+{
+    guint32 number = *(const guint32 *)key;
+    guint32 member_number = ((const resolv_data_enterprise_t *)member)->number;
+
+    return number < member_number ? -1 : number > member_number;
+}
+
 const gchar *
 try_enterprises_lookup(guint32 value)
 {
-    return (const gchar *)g_hash_table_lookup(enterprises_hashtable, GUINT_TO_POINTER(value));
+    const gchar *name;
+    const resolv_data_enterprise_t *enterprise;
+
+    name = (const gchar *)g_hash_table_lookup(enterprises_hashtable, GUINT_TO_POINTER(value));
+    if (name != NULL)
+        return name;
+
+    enterprise = (const resolv_data_enterprise_t *)bsearch(&value, resolv_data_enterprises,
+            resolv_data_enterprises_count, sizeof(resolv_data_enterprise_t), resolv_data_enterprise_cmp);
+    return enterprise != NULL ? resolv_data_name(enterprise->name) : NULL;
 }
 
 const gchar *
@@ -959,9 +1087,6 @@ enterprises_cleanup(void)
     g_assert(enterprises_hashtable);
     g_hash_table_destroy(enterprises_hashtable);
     enterprises_hashtable = NULL;
-    g_assert(g_enterprises_path);
-    g_free(g_enterprises_path);
-    g_enterprises_path = NULL;
     g_free(g_penterprises_path);
     g_penterprises_path = NULL;
     g_free(g_pservices_path);
@@ -1047,6 +1172,7 @@ c_ares_ghba_cb(void *arg, int status, int timeouts _U_, struct hostent *he) {
             }
         }
     }
+    dns_cache_add(caqm->family, &caqm->addr, status, he);
     wmem_free(wmem_epan_scope(), caqm);
 }
 
@@ -1537,7 +1663,7 @@ get_ethbyaddr(const guint8 *addr)
 } /* get_ethbyaddr */
 
 static hashmanuf_t *
-manuf_hash_new_entry(const guint8 *addr, char* name, char* longname)
+manuf_hash_new_entry(const guint8 *addr, const char* name, const char* longname)
 {
     guint manuf_key;
     hashmanuf_t *manuf_value;
@@ -1572,7 +1698,7 @@ manuf_hash_new_entry(const guint8 *addr, char* name, char* longname)
 }
 
 static void
-wka_hash_new_entry(const guint8 *addr, char* name)
+wka_hash_new_entry(const guint8 *addr, const char* name)
 {
     guint8 *wka_key;
 
@@ -1604,12 +1730,57 @@ add_manuf_name(const guint8 *addr, unsigned int mask, gchar *name, gchar *longna
     }
 } /* add_manuf_name */
 
+static int
+resolv_data_manuf_cmp(const void *key, const void *member)
+{
+    guint32 oui = *(const guint32 *)key;
+    guint32 member_oui = ((const resolv_data_manuf_t *)member)->oui;
+
+    return oui < member_oui ? -1 : oui > member_oui;
+}
+
+/* Look an OUI up in the table compiled from the manuf file. */
+static const resolv_data_manuf_t *
+resolv_data_manuf_lookup(guint32 manuf_key)
+{
+    guint32 first, last;
+
+    if (manuf_key > 0xFFFFFF)
+        return NULL;
+
+    /* The index narrows the search down to the OUIs with the same first octet. */
+    first = resolv_data_manuf_index[manuf_key >> 16];
+    last = resolv_data_manuf_index[(manuf_key >> 16) + 1];
+
+    return (const resolv_data_manuf_t *)bsearch(&manuf_key, &resolv_data_manuf[first],
+            last - first, sizeof(resolv_data_manuf_t), resolv_data_manuf_cmp);
+}
+
+static int
+resolv_data_wka_cmp(const void *key, const void *member)
+{
+    return memcmp(key, ((const resolv_data_wka_t *)member)->addr, 6);
+}
+
+/* Look an address range up in the table compiled from the manuf file. */
+static const gchar *
+resolv_data_wka_lookup(const guint8 *masked_addr)
+{
+    const resolv_data_wka_t *wka;
+
+    wka = (const resolv_data_wka_t *)bsearch(masked_addr, resolv_data_wka,
+            resolv_data_wka_count, sizeof(resolv_data_wka_t), resolv_data_wka_cmp);
+    return wka != NULL ? resolv_data_name(wka->name) : NULL;
+}
+
 static hashmanuf_t *
 manuf_name_lookup(const guint8 *addr)
 {
     guint32       manuf_key;
     guint8       oct;
     hashmanuf_t  *manuf_value;
+    const resolv_data_manuf_t *manuf;
+    guint8        unicast_addr[3];
 
     /* manuf needs only the 3 most significant octets of the ethernet address */
     manuf_key = addr[0];
@@ -1626,6 +1797,10 @@ manuf_name_lookup(const guint8 *addr)
     if (manuf_value != NULL) {
         return manuf_value;
     }
+    /* The hash table caches the entries of the compiled-in table as they are used. */
+    if ((manuf = resolv_data_manuf_lookup(manuf_key)) != NULL) {
+        return manuf_hash_new_entry(addr, resolv_data_name(manuf->name), resolv_data_name(manuf->longname));
+    }
 
     /* Mask out the broadcast/multicast flag but not the locally
      * administered flag as locally administered means: not assigned
@@ -1638,6 +1813,12 @@ manuf_name_lookup(const guint8 *addr)
         if (manuf_value != NULL) {
             return manuf_value;
         }
+        if ((manuf = resolv_data_manuf_lookup(manuf_key)) != NULL) {
+            unicast_addr[0] = (guint8)(addr[0] & 0xFE);
+            unicast_addr[1] = addr[1];
+            unicast_addr[2] = addr[2];
+            return manuf_hash_new_entry(unicast_addr, resolv_data_name(manuf->name), resolv_data_name(manuf->longname));
+        }
     }
 
     /* Add the address as a hex string */
@@ -1645,13 +1826,13 @@ manuf_name_lookup(const guint8 *addr)
 
 } /* manuf_name_lookup */
 
-static gchar *
+static const gchar *
 wka_name_lookup(const guint8 *addr, const unsigned int mask)
 {
     guint8     masked_addr[6];
     guint      num;
     gint       i;
-    gchar     *name;
+    const gchar *name;
 
     if (wka_hashtable == NULL) {
         return NULL;
@@ -1666,7 +1847,10 @@ wka_name_lookup(const guint8 *addr, const unsigned int mask)
     for (; i < 6; i++)
         masked_addr[i] = 0;
 
-    name = (gchar *)wmem_map_lookup(wka_hashtable, masked_addr);
+    /* Entries of the wka file take precedence over the ranges of the manuf file. */
+    name = (const gchar *)wmem_map_lookup(wka_hashtable, masked_addr);
+    if (name == NULL)
+        name = resolv_data_wka_lookup(masked_addr);
 
     return name;
 
@@ -1710,6 +1894,8 @@ initialize_ethers(void)
     wka_hashtable   = wmem_map_new(wmem_epan_scope(), eth_addr_hash, eth_addr_cmp);
     manuf_hashtable = wmem_map_new(wmem_epan_scope(), g_direct_hash, g_direct_equal);
     eth_hashtable   = wmem_map_new(wmem_epan_scope(), eth_addr_hash, eth_addr_cmp);
+    manuf_hashtable_complete = FALSE;
+    wka_hashtable_complete = FALSE;
 
     /* Compute the pathname of the ethers file. */
     if (g_ethers_path == NULL) {
@@ -1728,16 +1914,7 @@ initialize_ethers(void)
         }
     }
 
-    /* Compute the pathname of the manuf file */
-    if (g_manuf_path == NULL)
-        g_manuf_path = get_datafile_path(ENAME_MANUF);
-
-    /* Read it and initialize the hash table */
-    set_ethent(g_manuf_path);
-    while ((eth = get_ethent(&mask, TRUE))) {
-        add_manuf_name(eth->addr, mask, eth->name, eth->longname);
-    }
-    end_ethent();
+    /* The manuf file is compiled into resolv_data_manuf and resolv_data_wka. */
 
     /* Compute the pathname of the wka file */
     if (g_wka_path == NULL)
@@ -1759,8 +1936,6 @@ ethers_cleanup(void)
     g_ethers_path = NULL;
     g_free(g_pethers_path);
     g_pethers_path = NULL;
-    g_free(g_manuf_path);
-    g_manuf_path = NULL;
     g_free(g_wka_path);
     g_wka_path = NULL;
 }
@@ -1778,7 +1953,7 @@ eth_addr_resolve(hashether_t *tp) {
         return tp;
     } else {
         guint         mask;
-        gchar        *name;
+        const gchar  *name;
         address       ether_addr;
 
         /* Unknown name.  Try looking for it in the well-known-address
@@ -2874,6 +3049,15 @@ addr_resolve_pref_init(module_t *nameres)
             10,
             &name_resolve_concurrency);
 
+    prefs_register_uint_preference(nameres, "dns_cache_ttl",
+            "Keep names found with DNS for (seconds)",
+            "How long names found with the external resolver, and"
+            " addresses it found no name for, are kept in the \"dns_cache\""
+            " file in the personal configuration directory, so that"
+            " they needn't be looked up again. 0 keeps nothing.",
+            10,
+            &dns_cache_ttl);
+
     prefs_register_bool_preference(nameres, "hosts_file_handling",
             "Only use the profile \"hosts\" file",
             "By default \"hosts\" files will be loaded from multiple sources."
@@ -2912,22 +3096,15 @@ disable_name_resolution(void) {
     gbl_resolv_flags.ss7pc_name                         = FALSE;
 }
 
-gboolean
-host_name_lookup_process(void) {
+/*
+ * Submit queued asynchronous queries, up to name_resolve_concurrency
+ * of them in flight at once.
+ */
+static void
+submit_async_dns_queue(void) {
     async_dns_queue_msg_t *caqm;
-    struct timeval tv = { 0, 0 };
-    int nfds;
-    fd_set rfds, wfds;
-    gboolean nro = new_resolved_objects;
     wmem_list_frame_t* head;
 
-    new_resolved_objects = FALSE;
-    nro |= maxmind_db_lookup_process();
-
-    if (!async_dns_initialized)
-        /* c-ares not initialized. Bail out and cancel timers. */
-        return nro;
-
     head = wmem_list_head(async_dns_queue_head);
 
     while (head != NULL && async_dns_in_flight <= name_resolve_concurrency) {
@@ -2945,24 +3122,105 @@ host_name_lookup_process(void) {
 
         head = wmem_list_head(async_dns_queue_head);
     }
+}
+
+/*
+ * Wait up to *tv for replies to the queries in flight, and process
+ * them; returns FALSE if there's nothing to wait for or select() failed.
+ */
+static gboolean
+process_async_dns_replies(struct timeval *tv) {
+    int nfds;
+    fd_set rfds, wfds;
 
     FD_ZERO(&rfds);
     FD_ZERO(&wfds);
     nfds = ares_fds(ghba_chan, &rfds, &wfds);
     if (nfds > 0) {
-        if (select(nfds, &rfds, &wfds, NULL, &tv) == -1) { /* call to select() failed */
+        if (select(nfds, &rfds, &wfds, NULL, tv) == -1) { /* call to select() failed */
             /* If it's interrupted by a signal, no need to put out a message */
             if (errno != EINTR)
                 fprintf(stderr, "Warning: call to select() failed, error is %s\n", g_strerror(errno));
-            return nro;
+            return FALSE;
         }
         ares_process(ghba_chan, &rfds, &wfds);
+        return TRUE;
     }
+    return FALSE;
+}
+
+gboolean
+host_name_lookup_process(void) {
+    struct timeval tv = { 0, 0 };
+    gboolean nro = new_resolved_objects;
+
+    new_resolved_objects = FALSE;
+    nro |= maxmind_db_lookup_process();
+
+    if (!async_dns_initialized)
+        /* c-ares not initialized. Bail out and cancel timers. */
+        return nro;
+
+    submit_async_dns_queue();
+    process_async_dns_replies(&tv);
 
     /* Any new entries? */
     return nro;
 }
 
+void
+host_name_lookup_prefetch(const address *addr) {
+    guint32 ip4;
+    ws_in6_addr ip6;
+
+    if (!gbl_resolv_flags.network_name || !gbl_resolv_flags.use_external_net_name_resolver ||
+        resolve_synchronously || name_resolve_concurrency == 0)
+        return;
+
+    switch (addr->type) {
+        case AT_IPv4:
+            memcpy(&ip4, addr->data, sizeof(ip4));
+            host_lookup(ip4);
+            break;
+        case AT_IPv6:
+            memcpy(&ip6, addr->data, sizeof(ip6));
+            host_lookup6(&ip6);
+            break;
+        default:
+            break;
+    }
+}
+
+gboolean
+host_name_lookup_wait(guint timeout) {
+    gint64 deadline = g_get_monotonic_time() + (gint64)timeout * 1000;
+
+    if (!async_dns_initialized)
+        return TRUE;
+
+    for (;;) {
+        struct timeval max_tv, tv;
+        gint64 remaining;
+
+        submit_async_dns_queue();
+        if (async_dns_in_flight == 0 && wmem_list_count(async_dns_queue_head) == 0)
+            return TRUE;
+
+        remaining = deadline - g_get_monotonic_time();
+        if (remaining <= 0)
+            return FALSE;
+
+        /* Wake up at least once a second; see wait_for_sync_resolv(). */
+        if (remaining > G_USEC_PER_SEC)
+            remaining = G_USEC_PER_SEC;
+        max_tv.tv_sec = (long)(remaining / G_USEC_PER_SEC);
+        max_tv.tv_usec = (long)(remaining % G_USEC_PER_SEC);
+        tv = *ares_timeout(ghba_chan, &max_tv, &tv);
+        if (!process_async_dns_replies(&tv))
+            return FALSE;
+    }
+}
+
 static void
 _host_name_lookup_cleanup(void) {
     async_dns_queue_head = NULL;
@@ -3093,6 +3351,139 @@ add_manually_resolved(void)
     }
 }
 
+/*
+ * The DNS cache file has one line for each address:
+ *
+ *   <address> <expiry time, in seconds since the Epoch> <name or ->
+ */
+static void
+read_dns_cache(void)
+{
+    char *path;
+    FILE *fp;
+    char line[MAX_LINELEN];
+    gchar *addr_str, *expires_str, *name;
+    gint64 expires, now;
+    union {
+        guint32 ip4_addr;
+        ws_in6_addr ip6_addr;
+    } host_addr;
+    gboolean is_ipv6;
+    dns_cache_entry_t *entry;
+
+    path = get_persconffile_path(ENAME_DNS_CACHE, FALSE);
+    fp = ws_fopen(path, "r");
+    g_free(path);
+    if (fp == NULL)
+        return;
+
+    now = g_get_real_time() / G_USEC_PER_SEC;
+    while (fgetline(line, sizeof(line), fp) >= 0) {
+        if (line[0] == '#')
+            continue;
+
+        if ((addr_str = strtok(line, " \t")) == NULL ||
+            (expires_str = strtok(NULL, " \t")) == NULL ||
+            (name = strtok(NULL, " \t")) == NULL)
+            continue;
+
+        if (ws_inet_pton6(addr_str, &host_addr.ip6_addr)) {
+            is_ipv6 = TRUE;
+        } else if (ws_inet_pton4(addr_str, &host_addr.ip4_addr)) {
+            is_ipv6 = FALSE;
+        } else {
+            continue;
+        }
+
+        if (!ws_strtoi64(expires_str, NULL, &expires))
+            continue;
+        if (expires <= now || expires > now + dns_cache_ttl) {
+            /* Expired, or kept for longer than we now want. */
+            dns_cache_changed = TRUE;
+            continue;
+        }
+
+        if (strcmp(name, "-") == 0)
+            name = NULL;
+
+        entry = g_new(dns_cache_entry_t, 1);
+        entry->name = g_strdup(name);
+        entry->expires = expires;
+        g_hash_table_replace(dns_cache_table, g_strdup(addr_str), entry);
+
+        if (name) {
+            if (is_ipv6)
+                add_ipv6_name(&host_addr.ip6_addr, name);
+            else
+                add_ipv4_name(host_addr.ip4_addr, name);
+        } else if (is_ipv6) {
+            /* Don't ask again; show the address. */
+            hashipv6_t *tp = (hashipv6_t *)wmem_map_lookup(ipv6_hash_table, &host_addr.ip6_addr);
+
+            if (tp == NULL) {
+                ws_in6_addr *addr_key = wmem_new(wmem_epan_scope(), ws_in6_addr);
+
+                tp = new_ipv6(&host_addr.ip6_addr);
+                memcpy(addr_key, &host_addr.ip6_addr, 16);
+                fill_dummy_ip6(tp);
+                wmem_map_insert(ipv6_hash_table, addr_key, tp);
+            }
+            tp->flags |= TRIED_RESOLVE_ADDRESS;
+        } else {
+            hashipv4_t *tp = (hashipv4_t *)wmem_map_lookup(ipv4_hash_table, GUINT_TO_POINTER(host_addr.ip4_addr));
+
+            if (tp == NULL) {
+                tp = new_ipv4(host_addr.ip4_addr);
+                fill_dummy_ip4(host_addr.ip4_addr, tp);
+                wmem_map_insert(ipv4_hash_table, GUINT_TO_POINTER(host_addr.ip4_addr), tp);
+            }
+            tp->flags |= TRIED_RESOLVE_ADDRESS;
+        }
+    }
+    fclose(fp);
+}
+
+static void
+write_dns_cache(void)
+{
+    char *pf_dir_path;
+    char *path;
+    FILE *fp;
+    GHashTableIter iter;
+    gpointer key, value;
+    gint64 now;
+
+    if (!dns_cache_changed)
+        return;
+
+    /* It's only a cache; if we can't write it, carry on without it. */
+    if (create_persconffile_dir(&pf_dir_path) == -1) {
+        g_free(pf_dir_path);
+        return;
+    }
+
+    path = get_persconffile_path(ENAME_DNS_CACHE, FALSE);
+    fp = ws_fopen(path, "w");
+    g_free(path);
+    if (fp == NULL)
+        return;
+
+    fputs("# Names found with DNS by Wireshark, and when to forget them.\n"
+          "# This file is regenerated each time Wireshark or TShark exits or\n"
+          "# opens a capture file; edits will be lost.\n", fp);
+
+    now = g_get_real_time() / G_USEC_PER_SEC;
+    g_hash_table_iter_init(&iter, dns_cache_table);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        dns_cache_entry_t *entry = (dns_cache_entry_t *)value;
+
+        if (entry->expires > now)
+            fprintf(fp, "%s %" G_GINT64_FORMAT " %s\n", (const char *)key,
+                    entry->expires, entry->name ? entry->name : "-");
+    }
+    fclose(fp);
+}
+
 static void
 host_name_lookup_init(void)
 {
@@ -3154,6 +3545,14 @@ host_name_lookup_init(void)
 
     subnet_name_lookup_init();
 
+    /* The names in the cache came from the external resolver. */
+    g_assert(dns_cache_table == NULL);
+    if (dns_cache_ttl > 0 && gbl_resolv_flags.network_name &&
+        gbl_resolv_flags.use_external_net_name_resolver) {
+        dns_cache_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, dns_cache_entry_free);
+        read_dns_cache();
+    }
+
     add_manually_resolved();
 
     ss7pc_name_lookup_init();
@@ -3167,6 +3566,13 @@ host_name_lookup_cleanup(void)
 
     _host_name_lookup_cleanup();
 
+    if (dns_cache_table) {
+        write_dns_cache();
+        g_hash_table_destroy(dns_cache_table);
+        dns_cache_table = NULL;
+    }
+    dns_cache_changed = FALSE;
+
     ipxnet_hash_table = NULL;
     ipv4_hash_table = NULL;
     ipv6_hash_table = NULL;
@@ -3405,7 +3811,6 @@ tvb_get_manuf_name(tvbuff_t *tvb, gint offset)
 const gchar *
 get_manuf_name_if_known(const guint8 *addr)
 {
-    hashmanuf_t *manuf_value;
     guint manuf_key;
     guint8 oct;
 
@@ -3418,12 +3823,7 @@ get_manuf_name_if_known(const guint8 *addr)
     oct = addr[2];
     manuf_key = manuf_key | oct;
 
-    manuf_value = (hashmanuf_t *)wmem_map_lookup(manuf_hashtable, GUINT_TO_POINTER(manuf_key));
-    if ((manuf_value == NULL) || (manuf_value->status == HASHETHER_STATUS_UNRESOLVED)) {
-        return NULL;
-    }
-
-    return manuf_value->resolved_longname;
+    return uint_get_manuf_name_if_known(manuf_key);
 
 } /* get_manuf_name_if_known */
 
@@ -3431,9 +3831,22 @@ const gchar *
 uint_get_manuf_name_if_known(const guint manuf_key)
 {
     hashmanuf_t *manuf_value;
+    const resolv_data_manuf_t *manuf;
+    guint8 addr[3];
 
     manuf_value = (hashmanuf_t *)wmem_map_lookup(manuf_hashtable, GUINT_TO_POINTER(manuf_key));
-    if ((manuf_value == NULL) || (manuf_value->status == HASHETHER_STATUS_UNRESOLVED)) {
+    if (manuf_value == NULL) {
+        if ((manuf = resolv_data_manuf_lookup(manuf_key)) == NULL) {
+            return NULL;
+        }
+        /* Cache it like manuf_name_lookup() does, so that the name is
+         * truncated the same way whichever way it is looked up. */
+        addr[0] = (guint8)(manuf_key >> 16);
+        addr[1] = (guint8)(manuf_key >> 8);
+        addr[2] = (guint8)manuf_key;
+        manuf_value = manuf_hash_new_entry(addr, resolv_data_name(manuf->name), resolv_data_name(manuf->longname));
+    }
+    if (manuf_value->status == HASHETHER_STATUS_UNRESOLVED) {
         return NULL;
     }
 
@@ -3607,15 +4020,46 @@ get_host_ipaddr6(const char *host, ws_in6_addr *addrp)
     return FALSE;
 }
 
+/*
+ * The compiled-in entries are only added to the hash tables when they are
+ * looked up; add all others when someone wants to see every entry.
+ */
 wmem_map_t *
 get_manuf_hashtable(void)
 {
+    guint i;
+    guint8 addr[3];
+
+    if (manuf_hashtable != NULL && !manuf_hashtable_complete) {
+        for (i = 0; i < resolv_data_manuf_count; i++) {
+            const resolv_data_manuf_t *manuf = &resolv_data_manuf[i];
+
+            if (wmem_map_contains(manuf_hashtable, GUINT_TO_POINTER(manuf->oui)))
+                continue;
+            addr[0] = (guint8)(manuf->oui >> 16);
+            addr[1] = (guint8)(manuf->oui >> 8);
+            addr[2] = (guint8)manuf->oui;
+            manuf_hash_new_entry(addr, resolv_data_name(manuf->name), resolv_data_name(manuf->longname));
+        }
+        manuf_hashtable_complete = TRUE;
+    }
     return manuf_hashtable;
 }
 
 wmem_map_t *
 get_wka_hashtable(void)
 {
+    guint i;
+
+    if (wka_hashtable != NULL && !wka_hashtable_complete) {
+        for (i = 0; i < resolv_data_wka_count; i++) {
+            const resolv_data_wka_t *wka = &resolv_data_wka[i];
+
+            if (!wmem_map_contains(wka_hashtable, wka->addr))
+                wka_hash_new_entry(wka->addr, resolv_data_name(wka->name));
+        }
+        wka_hashtable_complete = TRUE;
+    }
     return wka_hashtable;
 }
 
@@ -3625,9 +4069,36 @@ get_eth_hashtable(void)
     return eth_hashtable;
 }
 
+/* Fill in a name of the personal services file, or of the compiled-in table. */
+static void
+serv_port_complete_name(gchar **name, guint32 offset)
+{
+    if (*name == NULL && offset != 0)
+        *name = wmem_strdup(wmem_epan_scope(), resolv_data_name(offset));
+}
+
 wmem_map_t *
 get_serv_port_hashtable(void)
 {
+    guint i;
+
+    if (serv_port_hashtable != NULL && !serv_port_hashtable_complete) {
+        for (i = 0; i < resolv_data_serv_port_count; i++) {
+            const resolv_data_serv_port_t *serv_port = &resolv_data_serv_port[i];
+            serv_port_t *serv_port_table;
+
+            serv_port_table = (serv_port_t *)wmem_map_lookup(serv_port_hashtable, GUINT_TO_POINTER(serv_port->port));
+            if (serv_port_table == NULL) {
+                serv_port_table = wmem_new0(wmem_epan_scope(), serv_port_t);
+                wmem_map_insert(serv_port_hashtable, GUINT_TO_POINTER(serv_port->port), serv_port_table);
+            }
+            serv_port_complete_name(&serv_port_table->tcp_name, serv_port->tcp_name);
+            serv_port_complete_name(&serv_port_table->udp_name, serv_port->udp_name);
+            serv_port_complete_name(&serv_port_table->sctp_name, serv_port->sctp_name);
+            serv_port_complete_name(&serv_port_table->dccp_name, serv_port->dccp_name);
+        }
+        serv_port_hashtable_complete = TRUE;
+    }
     return serv_port_hashtable;
 }
 
@@ -194,6 +194,23 @@ WS_DLL_PUBLIC void disable_name_resolution(void);
  */
 WS_DLL_PUBLIC gboolean host_name_lookup_process(void);
 
+/** If we're using c-ares, wait for the outstanding asynchronous host name
+ *  lookups to finish, so that a later pass over the packets has the names
+ *  without having to wait for each one.
+ *
+ * @param timeout the longest to wait, in milliseconds
+ * @return True if all the lookups finished in time.
+ */
+WS_DLL_PUBLIC gboolean host_name_lookup_wait(guint timeout);
+
+/** Start looking up the name of an IPv4 or IPv6 address, if names are
+ *  being looked up asynchronously with an external resolver, so that it's
+ *  ready by the time it's wanted.  Other addresses are ignored.
+ *
+ * @param addr the address
+ */
+WS_DLL_PUBLIC void host_name_lookup_prefetch(const address *addr);
+
 /* get_hostname returns the host name or "%d.%d.%d.%d" if not found */
 WS_DLL_PUBLIC const gchar *get_hostname(const guint addr);
 
@@ -0,0 +1,86 @@
+/* addr_resolv_data.h
+ * Definitions for the name resolution databases that are compiled into
+ * libwireshark from the manuf, services and enterprises.tsv files.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __ADDR_RESOLV_DATA_H__
+#define __ADDR_RESOLV_DATA_H__
+
+#include <glib.h>
+
+/*
+ * Tables in addr_resolv_data.c; automatically generated by
+ * tools/make-addr-resolv-data.py.
+ *
+ * Each table is sorted by its key and is searched with bsearch().
+ * Names are offsets into resolv_data_strings, so that the tables need
+ * no relocations and stay in read-only memory shared by every process
+ * using the library. Offset 0 is the empty string and means "no name".
+ */
+
+/* A manufacturer ID (OUI) from the manuf file */
+typedef struct {
+    guint32 oui;        /* The 24 bits of the OUI */
+    guint32 name;
+    guint32 longname;
+} resolv_data_manuf_t;
+
+/* A /28 or /36 range of MAC addresses from the manuf file */
+typedef struct {
+    guint32 name;
+    guint8  addr[6];    /* The first address of the range */
+} resolv_data_wka_t;
+
+/* The names of a port from the services file */
+typedef struct {
+    guint16 port;
+    guint32 tcp_name;
+    guint32 udp_name;
+    guint32 sctp_name;
+    guint32 dccp_name;
+} resolv_data_serv_port_t;
+
+/* An entry of the enterprises.tsv file */
+typedef struct {
+    guint32 number;
+    guint32 name;
+} resolv_data_enterprise_t;
+
+extern const char resolv_data_strings[];
+
+extern const resolv_data_manuf_t resolv_data_manuf[];
+extern const guint resolv_data_manuf_count;
+/* resolv_data_manuf[resolv_data_manuf_index[o]] is the first OUI that
+ * starts with the octet o, resolv_data_manuf_index[o + 1] is one past
+ * the last one. */
+extern const guint32 resolv_data_manuf_index[257];
+
+extern const resolv_data_wka_t resolv_data_wka[];
+extern const guint resolv_data_wka_count;
+
+extern const resolv_data_serv_port_t resolv_data_serv_port[];
+extern const guint resolv_data_serv_port_count;
+
+extern const resolv_data_enterprise_t resolv_data_enterprises[];
+extern const guint resolv_data_enterprises_count;
+
+#endif /* __ADDR_RESOLV_DATA_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
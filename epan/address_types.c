@@ -519,6 +519,29 @@ static int vines_len(void)
 
 
 
+/*
+ * The strings of the addresses seen in the capture file, for
+ * address_to_str_interned(); the table is emptied when the file is closed,
+ * and bounded, for captures with more addresses than are worth keeping.
+ */
+#define MAX_INTERNED_ADDRESSES 65536
+
+static wmem_map_t *interned_addresses = NULL;
+
+static guint
+interned_address_hash(gconstpointer key)
+{
+    const address *addr = (const address *)key;
+
+    return add_address_to_hash((guint)addr->type, addr);
+}
+
+static gboolean
+interned_address_equal(gconstpointer a, gconstpointer b)
+{
+    return addresses_equal((const address *)a, (const address *)b);
+}
+
 void address_types_initialize(void)
 {
     static address_type_t none_address = {
@@ -694,6 +717,9 @@ void address_types_initialize(void)
     address_type_register(AT_IB, &ib_address );
     address_type_register(AT_AX25, &ax25_address );
     address_type_register(AT_VINES, &vines_address );
+
+    interned_addresses = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
+            interned_address_hash, interned_address_equal);
 }
 
 /* Given an address type id, return an address_type_t* */
@@ -728,6 +754,32 @@ address_to_str(wmem_allocator_t *scope, const address *addr)
     return str;
 }
 
+const gchar *
+address_to_str_interned(const address *addr)
+{
+    address *key;
+    gchar *str;
+
+    /* The string of an address type registered by a dissector might
+     * depend on its preferences; the table isn't locked. */
+    if ((addr->type >= AT_END_OF_LIST) || wmem_threaded_scopes())
+        return NULL;
+
+    str = (gchar *)wmem_map_lookup(interned_addresses, addr);
+    if (str != NULL)
+        return str;
+
+    if (wmem_map_size(interned_addresses) >= MAX_INTERNED_ADDRESSES)
+        return NULL;
+
+    key = wmem_new(wmem_file_scope(), address);
+    copy_address_wmem(wmem_file_scope(), key, addr);
+    str = address_to_str(wmem_file_scope(), addr);
+    wmem_map_insert(interned_addresses, key, str);
+
+    return str;
+}
+
 void address_to_str_buf(const address* addr, gchar *buf, int buf_len)
 {
     address_type_t *at;
@@ -11,11 +11,18 @@
 #include "config.h"
 
 #include <errno.h>
+#include <string.h>
 #include <glib.h>
 
+#ifdef __SSE2__
+/* SSE2 is part of x86-64, so it needs no flag and no CPUID check. */
+#include <emmintrin.h>
+#endif
+
 #include <epan/proto.h>
 #include <epan/wmem/wmem.h>
 
+#include <wsutil/bits_ctz.h>
 #include <wsutil/pint.h>
 #include <wsutil/unicode-utils.h>
 
@@ -55,6 +62,104 @@
  * the code pages don't all work (do *any* work?).
  */
 
+/*
+ * Return the number of bytes at the beginning of ptr that are ASCII, that
+ * is, that have the high-order bit clear; most strings in packets are all
+ * ASCII, so test 16 (or 8) bytes at a time.
+ */
+static gint
+ascii_prefix_len(const guint8 *ptr, gint length)
+{
+    gint len = 0;
+
+#ifdef __SSE2__
+    while (length - len >= 16) {
+        guint32 mask = (guint32)_mm_movemask_epi8(
+            _mm_loadu_si128((const __m128i *)(const void *)(ptr + len)));
+
+        if (mask != 0)
+            return len + ws_ctz(mask);
+        len += 16;
+    }
+#else
+    while (length - len >= 8) {
+        guint64 word;
+
+        memcpy(&word, ptr + len, sizeof word);
+        if (word & G_GUINT64_CONSTANT(0x8080808080808080))
+            break;
+        len += 8;
+    }
+#endif
+    while (len < length && ptr[len] < 0x80)
+        len++;
+    return len;
+}
+
+/*
+ * Return the number of bytes at the beginning of ptr that are well-formed
+ * UTF-8, as given by Table 3-7 "Well-Formed UTF-8 Byte Sequences" of the
+ * Unicode Standard; runs of ASCII are skipped by ascii_prefix_len().
+ */
+static gint
+utf_8_valid_prefix_len(const guint8 *ptr, gint length)
+{
+    gint len = 0;
+    gint seq_len;
+    guint8 ch, lo, hi;
+
+    for (;;) {
+        len += ascii_prefix_len(ptr + len, length - len);
+        if (len == length)
+            return len;
+
+        ch = ptr[len];
+        lo = 0x80;
+        hi = 0xbf;
+        if (ch < 0xc2 || ch > 0xf4) {
+            return len;
+        } else if (ch < 0xe0) {
+            seq_len = 2;
+        } else if (ch < 0xf0) {
+            seq_len = 3;
+            if (ch == 0xe0)
+                lo = 0xa0;
+            else if (ch == 0xed)
+                hi = 0x9f;
+        } else {
+            seq_len = 4;
+            if (ch == 0xf0)
+                lo = 0x90;
+            else if (ch == 0xf4)
+                hi = 0x8f;
+        }
+        if (length - len < seq_len)
+            return len;
+        /* The second byte has the range that depends on the first;
+         * any others are continuation bytes. */
+        if (ptr[len + 1] < lo || ptr[len + 1] > hi)
+            return len;
+        if (seq_len > 2 && (ptr[len + 2] & 0xc0) != 0x80)
+            return len;
+        if (seq_len > 3 && (ptr[len + 3] & 0xc0) != 0x80)
+            return len;
+        len += seq_len;
+    }
+}
+
+/*
+ * Copy a string that needs no translation.
+ */
+static guint8 *
+copy_string(wmem_allocator_t *scope, const guint8 *ptr, gint length)
+{
+    guint8 *str = (guint8 *)wmem_alloc(scope, length + 1);
+
+    memcpy(str, ptr, length);
+    str[length] = '\0';
+    return str;
+}
+
 /*
  * Given a wmem scope, a pointer, and a length, treat the string of bytes
  * referred to by the pointer and length as an ASCII string, with all bytes
@@ -68,16 +173,23 @@ guint8 *
 get_ascii_string(wmem_allocator_t *scope, const guint8 *ptr, gint length)
 {
     wmem_strbuf_t *str;
+    gint run;
+
+    run = ascii_prefix_len(ptr, length);
+    if (run == length)
+        return copy_string(scope, ptr, length);
 
     str = wmem_strbuf_sized_new(scope, length+1, 0);
 
     while (length > 0) {
-        guint8 ch = *ptr;
-
-        if (ch < 0x80)
-            wmem_strbuf_append_c(str, ch);
-        else
-            wmem_strbuf_append_unichar(str, UNREPL);
+        run = ascii_prefix_len(ptr, length);
+        wmem_strbuf_append_len(str, ptr, run);
+        ptr += run;
+        length -= run;
+        if (length == 0)
+            break;
+
+        wmem_strbuf_append_unichar(str, UNREPL);
         ptr++;
         length--;
     }
@@ -106,6 +218,12 @@ get_utf_8_string(wmem_allocator_t *scope, const guint8 *ptr, gint length)
     wmem_strbuf_t *str;
     guint8 ch;
     const guint8 *prev;
+    gint valid_len;
+
+    /* Most strings are well-formed, and are just copied. */
+    valid_len = utf_8_valid_prefix_len(ptr, length);
+    if (valid_len == length)
+        return copy_string(scope, ptr, length);
 
     str = wmem_strbuf_sized_new(scope, length+1, 0);
 
@@ -115,6 +233,19 @@ get_utf_8_string(wmem_allocator_t *scope, const guint8 *ptr, gint length)
      * U+FFFD Substitution of Maximal Subparts. */
     while (length > 0) {
         gsize unichar_len;
+
+        /* Copy the well-formed bytes up to the next ill-formed
+         * sequence at once; the rest of the loop replaces that. */
+        if (valid_len < 0)
+            valid_len = utf_8_valid_prefix_len(ptr, length);
+        if (valid_len > 0) {
+            wmem_strbuf_append_len(str, ptr, valid_len);
+            ptr += valid_len;
+            length -= valid_len;
+            if (length == 0)
+                break;
+        }
+        valid_len = -1;
         ch = *ptr;
 
         if (ch < 0x80) {
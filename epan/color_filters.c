@@ -51,6 +51,12 @@ static gboolean filters_enabled = TRUE;
  */
 static gboolean tmp_colors_set = FALSE;
 
+/* The protocols that have been in the tree of some colorized packet.  A
+ * color filter's required protocols only rule a packet out once they've
+ * been seen, as a dissector might add a protocol's fields without adding
+ * the protocol itself. */
+static GHashTable *seen_protos = NULL;
+
 /* Create a new filter */
 color_filter_t *
 color_filter_new(const gchar *name,          /* The name of the filter to create */
@@ -496,9 +502,18 @@ prime_edt(gpointer data, gpointer user_data)
 {
     color_filter_t *colorf = (color_filter_t *)data;
     epan_dissect_t *edt    = (epan_dissect_t *)user_data;
+    const int      *protos;
+    int             num_protos, i;
 
-    if (colorf->c_colorfilter != NULL)
+    if (colorf->c_colorfilter != NULL) {
         epan_dissect_prime_with_dfilter(edt, colorf->c_colorfilter);
+
+        /* Keep the protocols the filter requires, too, so that
+         * color_filter_may_match() can look them up. */
+        protos = dfilter_required_protocols(colorf->c_colorfilter, &num_protos);
+        for (i = 0; i < num_protos; i++)
+            epan_dissect_prime_with_hfid(edt, protos[i]);
+    }
 }
 
 /* Prime the epan_dissect_t with all the compiler
@@ -510,6 +525,31 @@ color_filters_prime_edt(epan_dissect_t *edt)
         g_slist_foreach(color_filter_list, prime_edt, edt);
 }
 
+/* Can the filter match the packet, given the protocols in its tree?
+ * Most packets lack the protocols of most coloring rules, and looking a
+ * protocol up is much cheaper than running the filter. */
+static gboolean
+color_filter_may_match(const color_filter_t *colorf, epan_dissect_t *edt)
+{
+    const int *protos;
+    int        num_protos, i;
+    GPtrArray *finfos;
+
+    protos = dfilter_required_protocols(colorf->c_colorfilter, &num_protos);
+    for (i = 0; i < num_protos; i++) {
+        finfos = proto_get_finfo_ptr_array(edt->tree, protos[i]);
+        if (finfos != NULL && finfos->len > 0) {
+            if (seen_protos == NULL)
+                seen_protos = g_hash_table_new(g_direct_hash, g_direct_equal);
+            g_hash_table_add(seen_protos, GINT_TO_POINTER(protos[i]));
+        } else if (seen_protos != NULL &&
+                   g_hash_table_contains(seen_protos, GINT_TO_POINTER(protos[i]))) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
 /* * Return the color_t for later use */
 const color_filter_t *
 color_filters_colorize_packet(epan_dissect_t *edt)
@@ -525,6 +565,7 @@ color_filters_colorize_packet(epan_dissect_t *edt)
             colorf = (color_filter_t *)curr->data;
             if ( (!colorf->disabled) &&
                  (colorf->c_colorfilter != NULL) &&
+                 color_filter_may_match(colorf, edt) &&
                  dfilter_apply_edt(colorf->c_colorfilter, edt)) {
                 return colorf;
             }
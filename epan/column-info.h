@@ -45,6 +45,7 @@ typedef struct {
   gchar              *col_buf;              /**< Buffer into which to copy data for column */
   int                 col_fence;            /**< Stuff in column buffer before this index is immutable */
   gboolean            writable;             /**< writable or not */
+  gboolean            wanted;               /**< contents are used; if not, fmt_matx matches no formats */
 } col_item_t;
 
 /** Column info */
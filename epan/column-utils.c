@@ -873,118 +873,168 @@ col_has_time_fmt(column_info *cinfo, const gint col)
           (col_item->fmt_matx[COL_DELTA_TIME_DIS]));
 }
 
-static void
-set_abs_ymd_time(const frame_data *fd, gchar *buf, char *decimal_point, gboolean local)
+/*
+ * The part of an absolute time column up to the seconds only changes once
+ * a second, and consecutive packets are usually in the same second, so the
+ * last one is kept for each format, in local time and in UTC; only the
+ * fraction of a second is formatted for each packet.
+ */
+typedef enum {
+  ABS_TIME_SECS_HMS,      /* hh:mm:ss */
+  ABS_TIME_SECS_YMD,      /* YYYY-MM-DD hh:mm:ss */
+  ABS_TIME_SECS_YDOY,     /* YYYY/DOY hh:mm:ss */
+  ABS_TIME_SECS_NUM_FMTS
+} abs_time_secs_fmt_e;
+
+typedef struct {
+  gboolean valid;
+  time_t   secs;
+  gboolean failed;        /* localtime() or gmtime() couldn't convert it */
+  gchar    str[32];
+  size_t   len;
+} abs_time_secs_cache_t;
+
+static abs_time_secs_cache_t abs_time_secs_cache[ABS_TIME_SECS_NUM_FMTS][2];
+
+static const abs_time_secs_cache_t *
+get_abs_time_secs(time_t then, gboolean local, abs_time_secs_fmt_e fmt)
 {
+  abs_time_secs_cache_t *cache = &abs_time_secs_cache[fmt][local ? 1 : 0];
   struct tm *tmp;
-  time_t then;
-  int tsprecision;
+  int len = 0;
 
-  if (fd->has_ts) {
-    then = fd->abs_ts.secs;
-    if (local)
-      tmp = localtime(&then);
-    else
-      tmp = gmtime(&then);
-  } else
-    tmp = NULL;
-  if (tmp != NULL) {
-    switch (timestamp_get_precision()) {
-    case TS_PREC_FIXED_SEC:
-      tsprecision = WTAP_TSPREC_SEC;
-      break;
-    case TS_PREC_FIXED_DSEC:
-      tsprecision = WTAP_TSPREC_DSEC;
-      break;
-    case TS_PREC_FIXED_CSEC:
-      tsprecision = WTAP_TSPREC_CSEC;
-      break;
-    case TS_PREC_FIXED_MSEC:
-      tsprecision = WTAP_TSPREC_MSEC;
-      break;
-    case TS_PREC_FIXED_USEC:
-      tsprecision = WTAP_TSPREC_USEC;
-      break;
-    case TS_PREC_FIXED_NSEC:
-      tsprecision = WTAP_TSPREC_NSEC;
-      break;
-    case TS_PREC_AUTO:
-      tsprecision = fd->tsprec;
-      break;
-    default:
-      g_assert_not_reached();
-    }
-    switch (tsprecision) {
-    case WTAP_TSPREC_SEC:
-      snprintf(buf, COL_MAX_LEN,"%04d-%02d-%02d %02d:%02d:%02d",
-        tmp->tm_year + 1900,
-        tmp->tm_mon + 1,
-        tmp->tm_mday,
-        tmp->tm_hour,
-        tmp->tm_min,
-        tmp->tm_sec);
-      break;
-    case WTAP_TSPREC_DSEC:
-      snprintf(buf, COL_MAX_LEN,"%04d-%02d-%02d %02d:%02d:%02d%s%01d",
-        tmp->tm_year + 1900,
-        tmp->tm_mon + 1,
-        tmp->tm_mday,
-        tmp->tm_hour,
-        tmp->tm_min,
-        tmp->tm_sec,
-        decimal_point,
-        fd->abs_ts.nsecs / 100000000);
-      break;
-    case WTAP_TSPREC_CSEC:
-      snprintf(buf, COL_MAX_LEN,"%04d-%02d-%02d %02d:%02d:%02d%s%02d",
-        tmp->tm_year + 1900,
-        tmp->tm_mon + 1,
-        tmp->tm_mday,
-        tmp->tm_hour,
-        tmp->tm_min,
-        tmp->tm_sec,
-        decimal_point,
-        fd->abs_ts.nsecs / 10000000);
-      break;
-    case WTAP_TSPREC_MSEC:
-      snprintf(buf, COL_MAX_LEN, "%04d-%02d-%02d %02d:%02d:%02d%s%03d",
-        tmp->tm_year + 1900,
-        tmp->tm_mon + 1,
-        tmp->tm_mday,
-        tmp->tm_hour,
-        tmp->tm_min,
-        tmp->tm_sec,
-        decimal_point,
-        fd->abs_ts.nsecs / 1000000);
-      break;
-    case WTAP_TSPREC_USEC:
-      snprintf(buf, COL_MAX_LEN, "%04d-%02d-%02d %02d:%02d:%02d%s%06d",
-        tmp->tm_year + 1900,
-        tmp->tm_mon + 1,
-        tmp->tm_mday,
-        tmp->tm_hour,
-        tmp->tm_min,
-        tmp->tm_sec,
-        decimal_point,
-        fd->abs_ts.nsecs / 1000);
-      break;
-    case WTAP_TSPREC_NSEC:
-      snprintf(buf, COL_MAX_LEN, "%04d-%02d-%02d %02d:%02d:%02d%s%09d",
-        tmp->tm_year + 1900,
-        tmp->tm_mon + 1,
-        tmp->tm_mday,
-        tmp->tm_hour,
-        tmp->tm_min,
-        tmp->tm_sec,
-        decimal_point,
-        fd->abs_ts.nsecs);
-      break;
-    default:
-      g_assert_not_reached();
-    }
-  } else {
+  if (cache->valid && cache->secs == then)
+    return cache->failed ? NULL : cache;
+
+  if (local)
+    tmp = localtime(&then);
+  else
+    tmp = gmtime(&then);
+  cache->valid = TRUE;
+  cache->secs = then;
+  cache->failed = (tmp == NULL);
+  if (tmp == NULL)
+    return NULL;
+
+  switch (fmt) {
+  case ABS_TIME_SECS_HMS:
+    len = snprintf(cache->str, sizeof cache->str, "%02d:%02d:%02d",
+      tmp->tm_hour,
+      tmp->tm_min,
+      tmp->tm_sec);
+    break;
+  case ABS_TIME_SECS_YMD:
+    len = snprintf(cache->str, sizeof cache->str, "%04d-%02d-%02d %02d:%02d:%02d",
+      tmp->tm_year + 1900,
+      tmp->tm_mon + 1,
+      tmp->tm_mday,
+      tmp->tm_hour,
+      tmp->tm_min,
+      tmp->tm_sec);
+    break;
+  case ABS_TIME_SECS_YDOY:
+    len = snprintf(cache->str, sizeof cache->str, "%04d/%03d %02d:%02d:%02d",
+      tmp->tm_year + 1900,
+      tmp->tm_yday + 1,
+      tmp->tm_hour,
+      tmp->tm_min,
+      tmp->tm_sec);
+    break;
+  default:
+    g_assert_not_reached();
+  }
+  if (len < 0)
+    len = 0;
+  cache->len = MIN((size_t)len, sizeof cache->str - 1);
+  return cache;
+}
+
+static int
+get_frame_tsprecision(const frame_data *fd)
+{
+  switch (timestamp_get_precision()) {
+  case TS_PREC_FIXED_SEC:
+    return WTAP_TSPREC_SEC;
+  case TS_PREC_FIXED_DSEC:
+    return WTAP_TSPREC_DSEC;
+  case TS_PREC_FIXED_CSEC:
+    return WTAP_TSPREC_CSEC;
+  case TS_PREC_FIXED_MSEC:
+    return WTAP_TSPREC_MSEC;
+  case TS_PREC_FIXED_USEC:
+    return WTAP_TSPREC_USEC;
+  case TS_PREC_FIXED_NSEC:
+    return WTAP_TSPREC_NSEC;
+  case TS_PREC_AUTO:
+    return fd->tsprec;
+  default:
+    g_assert_not_reached();
+    return WTAP_TSPREC_NSEC;
+  }
+}
+
+static void
+set_abs_time_fmt(const frame_data *fd, gchar *buf, char *decimal_point,
+                 gboolean local, abs_time_secs_fmt_e fmt)
+{
+  const abs_time_secs_cache_t *secs;
+  guint32 frac;
+  size_t len;
+  int digits, i;
+
+  if (!fd->has_ts ||
+      (secs = get_abs_time_secs(fd->abs_ts.secs, local, fmt)) == NULL) {
+    buf[0] = '\0';
+    return;
+  }
+  memcpy(buf, secs->str, secs->len);
+  buf += secs->len;
+
+  switch (get_frame_tsprecision(fd)) {
+  case WTAP_TSPREC_SEC:
+    digits = 0;
+    break;
+  case WTAP_TSPREC_DSEC:
+    digits = 1;
+    break;
+  case WTAP_TSPREC_CSEC:
+    digits = 2;
+    break;
+  case WTAP_TSPREC_MSEC:
+    digits = 3;
+    break;
+  case WTAP_TSPREC_USEC:
+    digits = 6;
+    break;
+  case WTAP_TSPREC_NSEC:
+    digits = 9;
+    break;
+  default:
+    g_assert_not_reached();
+    digits = 9;
+  }
+  if (digits == 0) {
     buf[0] = '\0';
+    return;
   }
+
+  len = strlen(decimal_point);
+  memcpy(buf, decimal_point, len);
+  buf += len;
+  frac = (guint32)fd->abs_ts.nsecs;
+  for (i = digits; i < 9; i++)
+    frac /= 10;
+  for (i = digits - 1; i >= 0; i--) {
+    buf[i] = '0' + frac % 10;
+    frac /= 10;
+  }
+  buf[digits] = '\0';
+}
+
+static void
+set_abs_ymd_time(const frame_data *fd, gchar *buf, char *decimal_point, gboolean local)
+{
+  set_abs_time_fmt(fd, buf, decimal_point, local, ABS_TIME_SECS_YMD);
 }
 
 static void
@@ -1010,109 +1060,7 @@ col_set_utc_ymd_time(const frame_data *fd, column_info *cinfo, const int col)
 static void
 set_abs_ydoy_time(const frame_data *fd, gchar *buf, char *decimal_point, gboolean local)
 {
-  struct tm *tmp;
-  time_t then;
-  int tsprecision;
-
-  if (fd->has_ts) {
-    then = fd->abs_ts.secs;
-    if (local)
-      tmp = localtime(&then);
-    else
-      tmp = gmtime(&then);
-  } else
-    tmp = NULL;
-  if (tmp != NULL) {
-    switch (timestamp_get_precision()) {
-    case TS_PREC_FIXED_SEC:
-      tsprecision = WTAP_TSPREC_SEC;
-      break;
-    case TS_PREC_FIXED_DSEC:
-      tsprecision = WTAP_TSPREC_DSEC;
-      break;
-    case TS_PREC_FIXED_CSEC:
-      tsprecision = WTAP_TSPREC_CSEC;
-      break;
-    case TS_PREC_FIXED_MSEC:
-      tsprecision = WTAP_TSPREC_MSEC;
-      break;
-    case TS_PREC_FIXED_USEC:
-      tsprecision = WTAP_TSPREC_USEC;
-      break;
-    case TS_PREC_FIXED_NSEC:
-      tsprecision = WTAP_TSPREC_NSEC;
-      break;
-    case TS_PREC_AUTO:
-      tsprecision = fd->tsprec;
-      break;
-    default:
-      g_assert_not_reached();
-    }
-    switch (tsprecision) {
-    case WTAP_TSPREC_SEC:
-      snprintf(buf, COL_MAX_LEN,"%04d/%03d %02d:%02d:%02d",
-        tmp->tm_year + 1900,
-        tmp->tm_yday + 1,
-        tmp->tm_hour,
-        tmp->tm_min,
-        tmp->tm_sec);
-      break;
-    case WTAP_TSPREC_DSEC:
-      snprintf(buf, COL_MAX_LEN,"%04d/%03d %02d:%02d:%02d%s%01d",
-        tmp->tm_year + 1900,
-        tmp->tm_yday + 1,
-        tmp->tm_hour,
-        tmp->tm_min,
-        tmp->tm_sec,
-        decimal_point,
-        fd->abs_ts.nsecs / 100000000);
-      break;
-    case WTAP_TSPREC_CSEC:
-      snprintf(buf, COL_MAX_LEN,"%04d/%03d %02d:%02d:%02d%s%02d",
-        tmp->tm_year + 1900,
-        tmp->tm_yday + 1,
-        tmp->tm_hour,
-        tmp->tm_min,
-        tmp->tm_sec,
-        decimal_point,
-        fd->abs_ts.nsecs / 10000000);
-      break;
-    case WTAP_TSPREC_MSEC:
-      snprintf(buf, COL_MAX_LEN, "%04d/%03d %02d:%02d:%02d%s%03d",
-        tmp->tm_year + 1900,
-        tmp->tm_yday + 1,
-        tmp->tm_hour,
-        tmp->tm_min,
-        tmp->tm_sec,
-        decimal_point,
-        fd->abs_ts.nsecs / 1000000);
-      break;
-    case WTAP_TSPREC_USEC:
-      snprintf(buf, COL_MAX_LEN, "%04d/%03d %02d:%02d:%02d%s%06d",
-        tmp->tm_year + 1900,
-        tmp->tm_yday + 1,
-        tmp->tm_hour,
-        tmp->tm_min,
-        tmp->tm_sec,
-        decimal_point,
-        fd->abs_ts.nsecs / 1000);
-      break;
-    case WTAP_TSPREC_NSEC:
-      snprintf(buf, COL_MAX_LEN, "%04d/%03d %02d:%02d:%02d%s%09d",
-        tmp->tm_year + 1900,
-        tmp->tm_yday + 1,
-        tmp->tm_hour,
-        tmp->tm_min,
-        tmp->tm_sec,
-        decimal_point,
-        fd->abs_ts.nsecs);
-      break;
-    default:
-      g_assert_not_reached();
-    }
-  } else {
-    buf[0] = '\0';
-  }
+  set_abs_time_fmt(fd, buf, decimal_point, local, ABS_TIME_SECS_YDOY);
 }
 
 static void
@@ -1468,98 +1416,7 @@ col_set_delta_time_dis(const frame_data *fd, column_info *cinfo, const int col)
 static void
 set_abs_time(const frame_data *fd, gchar *buf, char *decimal_point, gboolean local)
 {
-  struct tm *tmp;
-  time_t then;
-  int tsprecision;
-
-  if (fd->has_ts) {
-    then = fd->abs_ts.secs;
-    if (local)
-      tmp = localtime(&then);
-    else
-      tmp = gmtime(&then);
-  } else
-    tmp = NULL;
-  if (tmp != NULL) {
-    switch (timestamp_get_precision()) {
-    case TS_PREC_FIXED_SEC:
-      tsprecision = WTAP_TSPREC_SEC;
-      break;
-    case TS_PREC_FIXED_DSEC:
-      tsprecision = WTAP_TSPREC_DSEC;
-      break;
-    case TS_PREC_FIXED_CSEC:
-      tsprecision = WTAP_TSPREC_CSEC;
-      break;
-    case TS_PREC_FIXED_MSEC:
-      tsprecision = WTAP_TSPREC_MSEC;
-      break;
-    case TS_PREC_FIXED_USEC:
-      tsprecision = WTAP_TSPREC_USEC;
-      break;
-    case TS_PREC_FIXED_NSEC:
-      tsprecision = WTAP_TSPREC_NSEC;
-      break;
-    case TS_PREC_AUTO:
-      tsprecision = fd->tsprec;
-      break;
-    default:
-      g_assert_not_reached();
-    }
-    switch (tsprecision) {
-    case WTAP_TSPREC_SEC:
-      snprintf(buf, COL_MAX_LEN,"%02d:%02d:%02d",
-        tmp->tm_hour,
-        tmp->tm_min,
-        tmp->tm_sec);
-      break;
-    case WTAP_TSPREC_DSEC:
-      snprintf(buf, COL_MAX_LEN,"%02d:%02d:%02d%s%01d",
-        tmp->tm_hour,
-        tmp->tm_min,
-        tmp->tm_sec,
-        decimal_point,
-        fd->abs_ts.nsecs / 100000000);
-      break;
-    case WTAP_TSPREC_CSEC:
-      snprintf(buf, COL_MAX_LEN,"%02d:%02d:%02d%s%02d",
-        tmp->tm_hour,
-        tmp->tm_min,
-        tmp->tm_sec,
-        decimal_point,
-        fd->abs_ts.nsecs / 10000000);
-      break;
-    case WTAP_TSPREC_MSEC:
-      snprintf(buf, COL_MAX_LEN,"%02d:%02d:%02d%s%03d",
-        tmp->tm_hour,
-        tmp->tm_min,
-        tmp->tm_sec,
-        decimal_point,
-        fd->abs_ts.nsecs / 1000000);
-      break;
-    case WTAP_TSPREC_USEC:
-      snprintf(buf, COL_MAX_LEN,"%02d:%02d:%02d%s%06d",
-        tmp->tm_hour,
-        tmp->tm_min,
-        tmp->tm_sec,
-        decimal_point,
-        fd->abs_ts.nsecs / 1000);
-      break;
-    case WTAP_TSPREC_NSEC:
-      snprintf(buf, COL_MAX_LEN, "%02d:%02d:%02d%s%09d",
-        tmp->tm_hour,
-        tmp->tm_min,
-        tmp->tm_sec,
-        decimal_point,
-        fd->abs_ts.nsecs);
-      break;
-    default:
-      g_assert_not_reached();
-    }
-
-  } else {
-    *buf = '\0';
-  }
+  set_abs_time_fmt(fd, buf, decimal_point, local, ABS_TIME_SECS_HMS);
 }
 
 static void
@@ -1941,6 +1798,8 @@ col_set_addr(packet_info *pinfo, const int col, const address *addr, const gbool
 
   if (res && (name = address_to_name(addr)) != NULL)
     col_item->col_data = name;
+  else if ((name = address_to_str_interned(addr)) != NULL)
+    col_item->col_data = name;
   else {
     col_item->col_data = col_item->col_buf;
     address_to_str_buf(addr, col_item->col_buf, COL_MAX_LEN);
@@ -1951,8 +1810,12 @@ col_set_addr(packet_info *pinfo, const int col, const address *addr, const gbool
 
   pinfo->cinfo->col_expr.col_expr[col] = address_type_column_filter_string(addr, is_src);
   /* For address types that have a filter, create a string */
-  if (strlen(pinfo->cinfo->col_expr.col_expr[col]) > 0)
-    address_to_str_buf(addr, pinfo->cinfo->col_expr.col_expr_val[col], COL_MAX_LEN);
+  if (strlen(pinfo->cinfo->col_expr.col_expr[col]) > 0) {
+    if ((name = address_to_str_interned(addr)) != NULL)
+      g_strlcpy(pinfo->cinfo->col_expr.col_expr_val[col], name, COL_MAX_LEN);
+    else
+      address_to_str_buf(addr, pinfo->cinfo->col_expr.col_expr_val[col], COL_MAX_LEN);
+  }
 }
 
 /* ------------------------ */
@@ -2158,6 +2021,8 @@ col_fill_in(packet_info *pinfo, const gboolean fill_col_exprs, const gboolean fi
 
   for (i = 0; i < pinfo->cinfo->num_cols; i++) {
     col_item = &pinfo->cinfo->columns[i];
+    if (!col_item->wanted)
+      continue;
     if (col_based_on_frame_data(pinfo->cinfo, i)) {
       if (fill_fd_colums)
         col_fill_in_frame_data(pinfo->fd, pinfo->cinfo, i, fill_col_exprs);
@@ -806,6 +806,30 @@ get_column_tooltip(const gint col)
     return g_string_free (column_tooltip, FALSE);
 }
 
+/* Set the first and last columns with each format. */
+static void
+col_set_format_ranges(column_info *cinfo)
+{
+  int i, j;
+
+  for (j = 0; j < NUM_COL_FMTS; j++) {
+    cinfo->col_first[j] = -1;
+    cinfo->col_last[j] = -1;
+  }
+
+  for (i = 0; i < cinfo->num_cols; i++) {
+    for (j = 0; j < NUM_COL_FMTS; j++) {
+      if (!cinfo->columns[i].fmt_matx[j])
+          continue;
+
+      if (cinfo->col_first[j] == -1)
+        cinfo->col_first[j] = i;
+
+      cinfo->col_last[j] = i;
+    }
+  }
+}
+
 void
 col_finalize(column_info *cinfo)
 {
@@ -848,6 +872,7 @@ col_finalize(column_info *cinfo)
 
     col_item->fmt_matx = g_new0(gboolean, NUM_COL_FMTS);
     get_column_format_matches(col_item->fmt_matx, col_item->col_fmt);
+    col_item->wanted = TRUE;
     col_item->col_data = NULL;
 
     if (col_item->col_fmt == COL_INFO)
@@ -862,19 +887,26 @@ col_finalize(column_info *cinfo)
   cinfo->col_expr.col_expr[i] = NULL;
   cinfo->col_expr.col_expr_val[i] = NULL;
 
-  for (i = 0; i < cinfo->num_cols; i++) {
-    int j;
+  col_set_format_ranges(cinfo);
+}
 
-    for (j = 0; j < NUM_COL_FMTS; j++) {
-      if (!cinfo->columns[i].fmt_matx[j])
-          continue;
+void
+col_set_wanted(column_info *cinfo, const gint col, const gboolean wanted)
+{
+  col_item_t* col_item = &cinfo->columns[col];
 
-      if (cinfo->col_first[j] == -1)
-        cinfo->col_first[j] = i;
+  if (col_item->wanted == wanted)
+    return;
 
-      cinfo->col_last[j] = i;
-    }
-  }
+  col_item->wanted = wanted;
+  /*
+   * An unwanted column matches no formats, so that nothing is ever
+   * written to it.
+   */
+  memset(col_item->fmt_matx, 0, NUM_COL_FMTS * sizeof(gboolean));
+  if (wanted)
+    get_column_format_matches(col_item->fmt_matx, col_item->col_fmt);
+  col_set_format_ranges(cinfo);
 }
 
 void
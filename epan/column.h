@@ -70,6 +70,19 @@ WS_DLL_PUBLIC
 void
 col_finalize(column_info *cinfo);
 
+/** Say whether the contents of a column are used.  Nothing is written
+ * to a column that isn't wanted, so dissectors don't spend time
+ * formatting it; its data is always empty.  All columns are wanted
+ * when the array is built.
+ *
+ * @param cinfo the column array
+ * @param col the column number
+ * @param wanted TRUE if the column's contents are used
+ */
+WS_DLL_PUBLIC
+void
+col_set_wanted(column_info *cinfo, const gint col, const gboolean wanted);
+
 WS_DLL_PUBLIC
 void
 build_column_format_array(column_info *cinfo, const gint num_cols, const gboolean reset_fences);
@@ -15,6 +15,7 @@
 #include "packet.h"
 #include "to_str.h"
 #include "conversation.h"
+#include "prefs.h"
 
 /* define DEBUG_CONVERSATION for pretty debug printing */
 /* #define DEBUG_CONVERSATION */
@@ -45,26 +46,75 @@ struct conversation_key {
 /*
  * Hash table for conversations with no wildcards.
  */
-static wmem_map_t *conversation_hashtable_exact = NULL;
+static wmem_flat_map_t *conversation_hashtable_exact = NULL;
 
 /*
  * Hash table for conversations with one wildcard address.
  */
-static wmem_map_t *conversation_hashtable_no_addr2 = NULL;
+static wmem_flat_map_t *conversation_hashtable_no_addr2 = NULL;
 
 /*
  * Hash table for conversations with one wildcard port.
  */
-static wmem_map_t *conversation_hashtable_no_port2 = NULL;
+static wmem_flat_map_t *conversation_hashtable_no_port2 = NULL;
 
 /*
  * Hash table for conversations with one wildcard address and port.
  */
-static wmem_map_t *conversation_hashtable_no_addr2_or_port2 = NULL;
+static wmem_flat_map_t *conversation_hashtable_no_addr2_or_port2 = NULL;
 
 
 static guint32 new_index;
 
+/*
+ * Changed whenever a conversation is added to or removed from one of the
+ * hash tables, or the tables are emptied, so that the memo of the last
+ * find_conversation() below is known to be still valid.
+ */
+static guint32 conversation_generation = 1;
+
+/*
+ * The arguments and result of the last find_conversation(). Dissectors at
+ * several layers of a packet, and several calls in one dissector, often
+ * look up the same conversation; those lookups are answered from here.
+ * Only addresses of up to CONVERSATION_MEMO_ADDR_LEN bytes are memoized,
+ * and a copy of them is kept, as the data of the packet may be gone by
+ * the time of the next lookup.
+ */
+#define CONVERSATION_MEMO_ADDR_LEN	16
+
+typedef struct {
+	address_type type;
+	int len;
+	guint8 data[CONVERSATION_MEMO_ADDR_LEN];
+} conversation_memo_addr_t;
+
+static struct {
+	guint32 generation;	/* 0 if there is no memo */
+	guint32 frame_num;
+	conversation_memo_addr_t addr_a;
+	conversation_memo_addr_t addr_b;	/* type AT_END_OF_LIST for a NULL addr_b */
+	endpoint_type etype;
+	guint32 port_a;
+	guint32 port_b;
+	guint options;
+	conversation_t *conversation;
+} conversation_memo;
+
+/*
+ * Expiry of idle conversations: the capture time of the frame being
+ * dissected, when the tables are next searched for idle conversations,
+ * and the functions freeing the data of each protocol, by protocol ID.
+ */
+#define CONVERSATION_EXPIRY_INTERVAL	10	/* seconds of capture time */
+
+static gboolean conversation_expiry_enabled = FALSE;
+static time_t conversation_now;
+static time_t conversation_next_expiry;
+static guint conversation_count;
+static guint conversation_expired_count;
+static GHashTable *conversation_proto_data_free_funcs = NULL;
+
 /*
  * Placeholder for address-less conversations.
  */
@@ -158,6 +208,7 @@ conversation_create_from_template(conversation_t *conversation, const address *a
 		 * the handler of the new conversation as well.
 		 */
 		new_conversation_from_template->dissector_tree = conversation->dissector_tree;
+		new_conversation_from_template->dissector_tree_shared = TRUE;
 
 		return new_conversation_from_template;
 	}
@@ -167,39 +218,70 @@ conversation_create_from_template(conversation_t *conversation, const address *a
 	}
 }
 
+/*
+ * The conversation hashes are computed with the steps of MurmurHash3, a
+ * 32-bit word at a time. IPv4 and IPv6 addresses, by far the most common
+ * ones, are added a word at a time too; other addresses are added a byte
+ * at a time with add_address_to_hash(), the One-at-a-Time hash, see
+ * https://web.archive.org/web/20070615045827/http://eternallyconfuzzled.com/tuts/algorithms/jsw_tut_hashing.aspx#existing
+ */
+static inline guint
+conversation_hash_add_word(guint hash_val, guint32 word)
+{
+	word *= 0xcc9e2d51;
+	word = (word << 15) | (word >> 17);
+	word *= 0x1b873593;
+
+	hash_val ^= word;
+	hash_val = (hash_val << 13) | (hash_val >> 19);
+	return hash_val * 5 + 0xe6546b64;
+}
+
+static inline guint
+conversation_hash_add_address(guint hash_val, const address *addr)
+{
+	guint32 word;
+	int i;
+
+	if ((addr->type == AT_IPv4 || addr->type == AT_IPv6) && addr->len % 4 == 0) {
+		for (i = 0; i < addr->len; i += 4) {
+			memcpy(&word, (const guint8 *)addr->data + i, 4);
+			hash_val = conversation_hash_add_word(hash_val, word);
+		}
+		return hash_val;
+	}
+	return add_address_to_hash(hash_val, addr);
+}
+
+static inline guint
+conversation_hash_finish(guint hash_val)
+{
+	hash_val ^= hash_val >> 16;
+	hash_val *= 0x85ebca6b;
+	hash_val ^= hash_val >> 13;
+	hash_val *= 0xc2b2ae35;
+	hash_val ^= hash_val >> 16;
+
+	return hash_val;
+}
+
 /*
  * Compute the hash value for two given address/port pairs if the match
  * is to be exact.
  */
-/* https://web.archive.org/web/20070615045827/http://eternallyconfuzzled.com/tuts/algorithms/jsw_tut_hashing.aspx#existing
- * (formerly at http://eternallyconfuzzled.com/tuts/algorithms/jsw_tut_hashing.aspx#existing)
- * One-at-a-Time hash
- */
 guint
 conversation_hash_exact(gconstpointer v)
 {
 	const conversation_key_t key = (const conversation_key_t)v;
 	guint hash_val;
-	address tmp_addr;
 
 	hash_val = 0;
-	tmp_addr.len  = 4;
-
-	hash_val = add_address_to_hash(hash_val, &key->addr1);
-
-	tmp_addr.data = &key->port1;
-	hash_val = add_address_to_hash(hash_val, &tmp_addr);
-
-	hash_val = add_address_to_hash(hash_val, &key->addr2);
-
-	tmp_addr.data = &key->port2;
-	hash_val = add_address_to_hash(hash_val, &tmp_addr);
+	hash_val = conversation_hash_add_address(hash_val, &key->addr1);
+	hash_val = conversation_hash_add_word(hash_val, key->port1);
+	hash_val = conversation_hash_add_address(hash_val, &key->addr2);
+	hash_val = conversation_hash_add_word(hash_val, key->port2);
 
-	hash_val += ( hash_val << 3 );
-	hash_val ^= ( hash_val >> 11 );
-	hash_val += ( hash_val << 15 );
-
-	return hash_val;
+	return conversation_hash_finish(hash_val);
 }
 
 /*
@@ -263,24 +345,13 @@ conversation_hash_no_addr2(gconstpointer v)
 {
 	const conversation_key_t key = (const conversation_key_t)v;
 	guint hash_val;
-	address tmp_addr;
 
 	hash_val = 0;
-	tmp_addr.len  = 4;
-
-	hash_val = add_address_to_hash(hash_val, &key->addr1);
-
-	tmp_addr.data = &key->port1;
-	hash_val = add_address_to_hash(hash_val, &tmp_addr);
+	hash_val = conversation_hash_add_address(hash_val, &key->addr1);
+	hash_val = conversation_hash_add_word(hash_val, key->port1);
+	hash_val = conversation_hash_add_word(hash_val, key->port2);
 
-	tmp_addr.data = &key->port2;
-	hash_val = add_address_to_hash(hash_val, &tmp_addr);
-
-	hash_val += ( hash_val << 3 );
-	hash_val ^= ( hash_val >> 11 );
-	hash_val += ( hash_val << 15 );
-
-	return hash_val;
+	return conversation_hash_finish(hash_val);
 }
 
 /*
@@ -328,23 +399,13 @@ conversation_hash_no_port2(gconstpointer v)
 {
 	const conversation_key_t key = (const conversation_key_t)v;
 	guint hash_val;
-	address tmp_addr;
 
 	hash_val = 0;
-	tmp_addr.len  = 4;
-
-	hash_val = add_address_to_hash(hash_val, &key->addr1);
-
-	tmp_addr.data = &key->port1;
-	hash_val = add_address_to_hash(hash_val, &tmp_addr);
+	hash_val = conversation_hash_add_address(hash_val, &key->addr1);
+	hash_val = conversation_hash_add_word(hash_val, key->port1);
+	hash_val = conversation_hash_add_address(hash_val, &key->addr2);
 
-	hash_val = add_address_to_hash(hash_val, &key->addr2);
-
-	hash_val += ( hash_val << 3 );
-	hash_val ^= ( hash_val >> 11 );
-	hash_val += ( hash_val << 15 );
-
-	return hash_val;
+	return conversation_hash_finish(hash_val);
 }
 
 /*
@@ -392,21 +453,12 @@ conversation_hash_no_addr2_or_port2(gconstpointer v)
 {
 	const conversation_key_t key = (const conversation_key_t)v;
 	guint hash_val;
-	address tmp_addr;
 
 	hash_val = 0;
-	tmp_addr.len  = 4;
-
-	hash_val = add_address_to_hash(hash_val, &key->addr1);
-
-	tmp_addr.data = &key->port1;
-	hash_val = add_address_to_hash(hash_val, &tmp_addr);
+	hash_val = conversation_hash_add_address(hash_val, &key->addr1);
+	hash_val = conversation_hash_add_word(hash_val, key->port1);
 
-	hash_val += ( hash_val << 3 );
-	hash_val ^= ( hash_val >> 11 );
-	hash_val += ( hash_val << 15 );
-
-	return hash_val;
+	return conversation_hash_finish(hash_val);
 }
 
 /*
@@ -458,16 +510,16 @@ conversation_init(void)
 	 * above.
 	 */
 	conversation_hashtable_exact =
-	    wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), conversation_hash_exact,
+	    wmem_flat_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), conversation_hash_exact,
 	      conversation_match_exact);
 	conversation_hashtable_no_addr2 =
-	    wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), conversation_hash_no_addr2,
+	    wmem_flat_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), conversation_hash_no_addr2,
 	      conversation_match_no_addr2);
 	conversation_hashtable_no_port2 =
-	    wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), conversation_hash_no_port2,
+	    wmem_flat_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), conversation_hash_no_port2,
 	      conversation_match_no_port2);
 	conversation_hashtable_no_addr2_or_port2 =
-	    wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), conversation_hash_no_addr2_or_port2,
+	    wmem_flat_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), conversation_hash_no_addr2_or_port2,
 	      conversation_match_no_addr2_or_port2);
 
 }
@@ -481,6 +533,31 @@ void conversation_epan_reset(void)
 	 * Start the conversation indices over at 0.
 	 */
 	new_index = 0;
+
+	/*
+	 * The conversations are gone along with the file scope.
+	 */
+	conversation_generation++;
+
+	conversation_now = 0;
+	conversation_next_expiry = 0;
+	conversation_count = 0;
+	conversation_expired_count = 0;
+}
+
+void
+conversation_set_expiry(const gboolean enable)
+{
+	conversation_expiry_enabled = enable;
+}
+
+void
+conversation_register_proto_data_free(const int proto, GDestroyNotify free_func)
+{
+	if (conversation_proto_data_free_funcs == NULL)
+		conversation_proto_data_free_funcs = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	g_hash_table_insert(conversation_proto_data_free_funcs, GINT_TO_POINTER(proto), (gpointer)free_func);
 }
 
 /*
@@ -490,17 +567,19 @@ void conversation_epan_reset(void)
  * Mostly adapted from the old conversation_new().
  */
 static void
-conversation_insert_into_hashtable(wmem_map_t *hashtable, conversation_t *conv)
+conversation_insert_into_hashtable(wmem_flat_map_t *hashtable, conversation_t *conv)
 {
 	conversation_t *chain_head, *chain_tail, *cur, *prev;
 
-	chain_head = (conversation_t *)wmem_map_lookup(hashtable, conv->key_ptr);
+	conversation_generation++;
+
+	chain_head = (conversation_t *)wmem_flat_map_lookup(hashtable, conv->key_ptr);
 
 	if (NULL==chain_head) {
 		/* New entry */
 		conv->next = NULL;
 		conv->last = conv;
-		wmem_map_insert(hashtable, conv->key_ptr, conv);
+		wmem_flat_map_insert(hashtable, conv->key_ptr, conv);
 		DPRINT(("created a new conversation chain"));
 	}
 	else {
@@ -529,7 +608,7 @@ conversation_insert_into_hashtable(wmem_map_t *hashtable, conversation_t *conv)
 				conv->next = chain_head;
 				conv->last = chain_tail;
 				chain_head->last = NULL;
-				wmem_map_insert(hashtable, conv->key_ptr, conv);
+				wmem_flat_map_insert(hashtable, conv->key_ptr, conv);
 			}
 			else {
 				/* Inserting into the middle of the chain */
@@ -546,20 +625,22 @@ conversation_insert_into_hashtable(wmem_map_t *hashtable, conversation_t *conv)
  * taking into account ordering and hash chains and all that good stuff.
  */
 static void
-conversation_remove_from_hashtable(wmem_map_t *hashtable, conversation_t *conv)
+conversation_remove_from_hashtable(wmem_flat_map_t *hashtable, conversation_t *conv)
 {
 	conversation_t *chain_head, *cur, *prev;
 
-	chain_head = (conversation_t *)wmem_map_lookup(hashtable, conv->key_ptr);
+	conversation_generation++;
+
+	chain_head = (conversation_t *)wmem_flat_map_lookup(hashtable, conv->key_ptr);
 
 	if (conv == chain_head) {
 		/* We are currently the front of the chain */
 		if (NULL == conv->next) {
 			/* We are the only conversation in the chain, no need to
 			 * update next pointer, but do not call
-			 * wmem_map_remove() either because the conv data
+			 * wmem_flat_map_remove() either because the conv data
 			 * will be re-inserted. */
-			wmem_map_steal(hashtable, conv->key_ptr);
+			wmem_flat_map_steal(hashtable, conv->key_ptr);
 		}
 		else {
 			/* Update the head of the chain */
@@ -571,7 +652,10 @@ conversation_remove_from_hashtable(wmem_map_t *hashtable, conversation_t *conv)
 			else
 				chain_head->latest_found = conv->latest_found;
 
-			wmem_map_insert(hashtable, chain_head->key_ptr, chain_head);
+			/* Steal the entry first, so that the table no longer
+			 * refers to our key, which may be freed. */
+			wmem_flat_map_steal(hashtable, conv->key_ptr);
+			wmem_flat_map_insert(hashtable, chain_head->key_ptr, chain_head);
 		}
 	}
 	else {
@@ -601,6 +685,131 @@ conversation_remove_from_hashtable(wmem_map_t *hashtable, conversation_t *conv)
 	}
 }
 
+static guint
+conversation_idle_timeout(const conversation_t *conv)
+{
+	/* Templates stand for connections yet to come, not for traffic */
+	if (conv->options & CONVERSATION_TEMPLATE)
+		return 0;
+
+	switch (conv->key_ptr->etype) {
+	case ENDPOINT_TCP:
+		return prefs.conversation_idle_timeout_tcp;
+	case ENDPOINT_UDP:
+		return prefs.conversation_idle_timeout_udp;
+	default:
+		return prefs.conversation_idle_timeout_other;
+	}
+}
+
+static void
+conversation_collect_idle(gpointer key _U_, gpointer value, gpointer user_data)
+{
+	GPtrArray *idle = (GPtrArray *)user_data;
+	conversation_t *conv;
+	guint timeout;
+
+	for (conv = (conversation_t *)value; conv != NULL; conv = conv->next) {
+		timeout = conversation_idle_timeout(conv);
+		if (timeout != 0 && conversation_now - conv->last_time > (time_t)timeout)
+			g_ptr_array_add(idle, conv);
+	}
+}
+
+static gboolean
+conversation_free_proto_data(const void *key, void *value, void *user_data _U_)
+{
+	GDestroyNotify free_func;
+
+	free_func = (GDestroyNotify)g_hash_table_lookup(conversation_proto_data_free_funcs, key);
+	if (free_func != NULL)
+		free_func(value);
+
+	return FALSE;
+}
+
+/*
+ * Remove a conversation from its hash table and free it, along with the
+ * data of the protocols that registered a function to free it.
+ */
+static void
+conversation_free(wmem_flat_map_t *hashtable, conversation_t *conv)
+{
+	conversation_remove_from_hashtable(hashtable, conv);
+
+	if (conv->data_list != NULL) {
+		if (conversation_proto_data_free_funcs != NULL)
+			wmem_tree_foreach(conv->data_list, conversation_free_proto_data, NULL);
+		wmem_tree_destroy(conv->data_list, FALSE, FALSE);
+	}
+	if (!conv->dissector_tree_shared)
+		wmem_flat_tree_destroy(conv->dissector_tree);
+
+	free_address_wmem(wmem_file_scope(), &conv->key_ptr->addr1);
+	free_address_wmem(wmem_file_scope(), &conv->key_ptr->addr2);
+	wmem_free(wmem_file_scope(), conv->key_ptr);
+	wmem_free(wmem_file_scope(), conv);
+
+	conversation_count--;
+	conversation_expired_count++;
+}
+
+/*
+ * Free the conversations of a hash table that have been idle for too long;
+ * they are collected first, as the table must not change while it is
+ * walked.
+ */
+static void
+conversation_expire_hashtable(wmem_flat_map_t *hashtable)
+{
+	GPtrArray *idle;
+	guint i;
+
+	if (wmem_flat_map_size(hashtable) == 0)
+		return;
+
+	idle = g_ptr_array_new();
+	wmem_flat_map_foreach(hashtable, conversation_collect_idle, idle);
+	for (i = 0; i < idle->len; i++)
+		conversation_free(hashtable, (conversation_t *)g_ptr_array_index(idle, i));
+	g_ptr_array_free(idle, TRUE);
+}
+
+void
+conversation_new_frame(const packet_info *pinfo)
+{
+	if (pinfo->presence_flags & PINFO_HAS_TS)
+		conversation_now = pinfo->abs_ts.secs;
+
+	if (!conversation_expiry_enabled || pinfo->fd->visited)
+		return;
+	if (prefs.conversation_idle_timeout_tcp == 0 &&
+	    prefs.conversation_idle_timeout_udp == 0 &&
+	    prefs.conversation_idle_timeout_other == 0)
+		return;
+
+	/*
+	 * Look for idle conversations every few seconds of capture time; if
+	 * the clock went back, start over from the new time.
+	 */
+	if (conversation_now < conversation_next_expiry &&
+	    conversation_next_expiry - conversation_now <= CONVERSATION_EXPIRY_INTERVAL)
+		return;
+	conversation_next_expiry = conversation_now + CONVERSATION_EXPIRY_INTERVAL;
+
+	conversation_expire_hashtable(conversation_hashtable_exact);
+	conversation_expire_hashtable(conversation_hashtable_no_addr2);
+	conversation_expire_hashtable(conversation_hashtable_no_port2);
+	conversation_expire_hashtable(conversation_hashtable_no_addr2_or_port2);
+}
+
+void
+conversation_get_stats(conversation_stats_t *stats)
+{
+	stats->conversations = conversation_count;
+	stats->expired = conversation_expired_count;
+}
+
 /*
  * Given two address/port pairs for a packet, create a new conversation
  * to contain packets between those address/port pairs.
@@ -617,10 +826,12 @@ conversation_new(const guint32 setup_frame, const address *addr1, const address
 	DISSECTOR_ASSERT(!(options | CONVERSATION_TEMPLATE) || ((options | (NO_ADDR2 | NO_PORT2 | NO_PORT2_FORCE))) &&
 				"A conversation template may not be constructed without wildcard options");
 */
-	wmem_map_t* hashtable;
+	wmem_flat_map_t* hashtable;
 	conversation_t *conversation=NULL;
 	conversation_key_t new_key;
 
+	dissector_state_write("conversation_new");
+
 #ifdef DEBUG_CONVERSATION
 	gchar *addr1_str, *addr2_str;
 	if (addr1 == NULL) {
@@ -744,14 +955,16 @@ conversation_new(const guint32 setup_frame, const address *addr1, const address
 	conversation->conv_index = new_index;
 	conversation->setup_frame = conversation->last_frame = setup_frame;
 	conversation->data_list = NULL;
+	conversation->last_time = conversation_now;
 
-	conversation->dissector_tree = wmem_tree_new(wmem_file_scope());
+	conversation->dissector_tree = wmem_flat_tree_new(wmem_file_scope());
 
 	/* set the options and key pointer */
 	conversation->options = options;
 	conversation->key_ptr = new_key;
 
 	new_index++;
+	conversation_count++;
 
 	DINDENT();
 	conversation_insert_into_hashtable(hashtable, conversation);
@@ -842,7 +1055,7 @@ conversation_set_addr2(conversation_t *conv, const address *addr)
  * {addr1, port1, addr2, port2} and set up before frame_num.
  */
 static conversation_t *
-conversation_lookup_hashtable(wmem_map_t *hashtable, const guint32 frame_num, const address *addr1, const address *addr2,
+conversation_lookup_hashtable(wmem_flat_map_t *hashtable, const guint32 frame_num, const address *addr1, const address *addr2,
     const endpoint_type etype, const guint32 port1, const guint32 port2)
 {
 	conversation_t* convo=NULL;
@@ -850,6 +1063,13 @@ conversation_lookup_hashtable(wmem_map_t *hashtable, const guint32 frame_num, co
 	conversation_t* chain_head=NULL;
 	struct conversation_key key;
 
+	/*
+	 * Most captures have no wildcarded conversations at all; don't
+	 * bother hashing the key to find that out.
+	 */
+	if (wmem_flat_map_size(hashtable) == 0)
+		return NULL;
+
 	/*
 	 * We don't make a copy of the address data, we just copy the
 	 * pointer to it, as "key" disappears when we return.
@@ -868,7 +1088,7 @@ conversation_lookup_hashtable(wmem_map_t *hashtable, const guint32 frame_num, co
 	key.port1 = port1;
 	key.port2 = port2;
 
-	chain_head = (conversation_t *)wmem_map_lookup(hashtable, &key);
+	chain_head = (conversation_t *)wmem_flat_map_lookup(hashtable, &key);
 
 	if (chain_head && (chain_head->setup_frame <= frame_num)) {
 		match = chain_head;
@@ -929,8 +1149,8 @@ conversation_lookup_hashtable(wmem_map_t *hashtable, const guint32 frame_num, co
  *
  *	otherwise, we found no matching conversation, and return NULL.
  */
-conversation_t *
-find_conversation(const guint32 frame_num, const address *addr_a, const address *addr_b, const endpoint_type etype,
+static conversation_t *
+find_conversation_work(const guint32 frame_num, const address *addr_a, const address *addr_b, const endpoint_type etype,
     const guint32 port_a, const guint32 port_b, const guint options)
 {
 	conversation_t *conversation;
@@ -1288,6 +1508,77 @@ end:
 	return conversation;
 }
 
+static inline gboolean
+conversation_memo_addr_equal(const conversation_memo_addr_t *memo, const address *addr)
+{
+	if (addr == NULL)
+		return memo->type == AT_END_OF_LIST;
+	return memo->type == addr->type && memo->len == addr->len &&
+	    (addr->len == 0 || memcmp(memo->data, addr->data, addr->len) == 0);
+}
+
+static inline void
+conversation_memo_addr_set(conversation_memo_addr_t *memo, const address *addr)
+{
+	if (addr == NULL) {
+		memo->type = AT_END_OF_LIST;
+		memo->len = 0;
+	} else {
+		memo->type = (address_type)addr->type;
+		memo->len = addr->len;
+		if (addr->len > 0)
+			memcpy(memo->data, addr->data, addr->len);
+	}
+}
+
+conversation_t *
+find_conversation(const guint32 frame_num, const address *addr_a, const address *addr_b, const endpoint_type etype,
+    const guint32 port_a, const guint32 port_b, const guint options)
+{
+	conversation_t *conversation;
+	guint32 generation = conversation_generation;
+
+	if (conversation_memo.generation == generation &&
+	    conversation_memo.frame_num == frame_num &&
+	    conversation_memo.etype == etype &&
+	    conversation_memo.port_a == port_a &&
+	    conversation_memo.port_b == port_b &&
+	    conversation_memo.options == options &&
+	    conversation_memo_addr_equal(&conversation_memo.addr_a, addr_a) &&
+	    conversation_memo_addr_equal(&conversation_memo.addr_b, addr_b)) {
+		conversation = conversation_memo.conversation;
+		if (conversation != NULL)
+			conversation->last_time = conversation_now;
+		return conversation;
+	}
+
+	conversation = find_conversation_work(frame_num, addr_a, addr_b, etype,
+	    port_a, port_b, options);
+	if (conversation != NULL)
+		conversation->last_time = conversation_now;
+
+	/*
+	 * A wildcarded match may have filled in the conversation's address
+	 * or port 2, or made a new conversation from a template; then the
+	 * same lookup could give another result next time, so don't keep it.
+	 */
+	if (conversation_generation == generation &&
+	    (addr_a == NULL || addr_a->len <= CONVERSATION_MEMO_ADDR_LEN) &&
+	    (addr_b == NULL || addr_b->len <= CONVERSATION_MEMO_ADDR_LEN)) {
+		conversation_memo.generation = generation;
+		conversation_memo.frame_num = frame_num;
+		conversation_memo_addr_set(&conversation_memo.addr_a, addr_a);
+		conversation_memo_addr_set(&conversation_memo.addr_b, addr_b);
+		conversation_memo.etype = etype;
+		conversation_memo.port_a = port_a;
+		conversation_memo.port_b = port_b;
+		conversation_memo.options = options;
+		conversation_memo.conversation = conversation;
+	}
+
+	return conversation;
+}
+
 conversation_t *find_conversation_by_id(const guint32 frame, const endpoint_type etype, const guint32 id, const guint options)
 {
 	/* Force the lack of a address or port B */
@@ -1297,6 +1588,8 @@ conversation_t *find_conversation_by_id(const guint32 frame, const endpoint_type
 void
 conversation_add_proto_data(conversation_t *conv, const int proto, void *proto_data)
 {
+	dissector_state_write("conversation_add_proto_data");
+
 	/* Add it to the list of items for this conversation. */
 	if (conv->data_list == NULL)
 		conv->data_list = wmem_tree_new(wmem_file_scope());
@@ -1325,7 +1618,8 @@ void
 conversation_set_dissector_from_frame_number(conversation_t *conversation,
 	const guint32 starting_frame_num, const dissector_handle_t handle)
 {
-	wmem_tree_insert32(conversation->dissector_tree, starting_frame_num, (void *)handle);
+	dissector_state_write("conversation_set_dissector");
+	wmem_flat_tree_insert32(conversation->dissector_tree, starting_frame_num, (void *)handle);
 }
 
 void
@@ -1337,14 +1631,14 @@ conversation_set_dissector(conversation_t *conversation, const dissector_handle_
 dissector_handle_t
 conversation_get_dissector(conversation_t *conversation, const guint32 frame_num)
 {
-	return (dissector_handle_t)wmem_tree_lookup32_le(conversation->dissector_tree, frame_num);
+	return (dissector_handle_t)wmem_flat_tree_lookup32_le(conversation->dissector_tree, frame_num);
 }
 
 static gboolean try_conversation_call_dissector_helper(conversation_t *conversation, gboolean* dissector_success,
 					tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data)
 {
 	int ret;
-	dissector_handle_t handle = (dissector_handle_t)wmem_tree_lookup32_le(
+	dissector_handle_t handle = (dissector_handle_t)wmem_flat_tree_lookup32_le(
 					conversation->dissector_tree, pinfo->num);
 	if (handle == NULL)
 		return FALSE;
@@ -1421,7 +1715,7 @@ try_conversation_dissector_by_id(const endpoint_type etype, const guint32 id, tv
 	if (conversation != NULL) {
 		int ret;
 
-		dissector_handle_t handle = (dissector_handle_t)wmem_tree_lookup32_le(conversation->dissector_tree, pinfo->num);
+		dissector_handle_t handle = (dissector_handle_t)wmem_flat_tree_lookup32_le(conversation->dissector_tree, pinfo->num);
 		if (handle == NULL)
 			return FALSE;
 		ret = call_dissector_only(handle, tvb, pinfo, tree, data);
@@ -1564,25 +1858,25 @@ guint32 conversation_get_endpoint_by_id(struct _packet_info *pinfo, endpoint_typ
 	return pinfo->conv_endpoint->port1;
 }
 
-wmem_map_t *
+wmem_flat_map_t *
 get_conversation_hashtable_exact(void)
 {
 	return conversation_hashtable_exact;
 }
 
-wmem_map_t *
+wmem_flat_map_t *
 get_conversation_hashtable_no_addr2(void)
 {
 	return conversation_hashtable_no_addr2;
 }
 
-wmem_map_t *
+wmem_flat_map_t *
 get_conversation_hashtable_no_port2(void)
 {
 	return conversation_hashtable_no_port2;
 }
 
-wmem_map_t *
+wmem_flat_map_t *
 get_conversation_hashtable_no_addr2_or_port2(void)
 {
 	return conversation_hashtable_no_addr2_or_port2;
@@ -95,9 +95,14 @@ typedef struct conversation {
 					/* Assume that setup_frame is also the lowest frame number for now. */
 	guint32 last_frame;		/** highest frame number in this conversation */
 	wmem_tree_t *data_list;		/** list of data associated with conversation */
-	wmem_tree_t *dissector_tree;	/** tree containing protocol dissector client associated with conversation */
+	wmem_flat_tree_t *dissector_tree;	/** tree containing protocol dissector client associated with conversation */
 	guint	options;		/** wildcard flags */
 	conversation_key_t key_ptr;	/** pointer to the key for this conversation */
+	time_t	last_time;		/** capture time (seconds) of the last frame that found it */
+	gboolean dissector_tree_shared;	/** dissector_tree belongs to the template it was made from */
+	heur_dissector_list_t heur_list;	/** heuristic list whose heur_entry last accepted a packet of it */
+	heur_dtbl_entry_t *heur_entry;	/** that heuristic dissector */
+	guint	heur_generation;	/** generation of heur_list when heur_entry was remembered */
 } conversation_t;
 
 
@@ -119,6 +124,40 @@ extern void conversation_init(void);
  */
 extern void conversation_epan_reset(void);
 
+/**
+ * Called before each frame is dissected: notes its time, and drops the
+ * conversations that have been idle for longer than the
+ * conversation_idle_timeout_* preferences, if expiry is enabled.
+ */
+extern void conversation_new_frame(const packet_info *pinfo);
+
+/**
+ * Enable or disable the expiry of idle conversations. Conversations that
+ * expire are gone for good, so this must only be enabled when every frame
+ * is dissected once, in order, as by TShark in a single pass; it is
+ * disabled by default.
+ */
+WS_DLL_PUBLIC void conversation_set_expiry(const gboolean enable);
+
+/**
+ * Register the function that frees the data a protocol keeps with
+ * conversation_add_proto_data(), called when a conversation expires. The
+ * data of protocols with no such function is only freed with the file
+ * scope.
+ */
+WS_DLL_PUBLIC void conversation_register_proto_data_free(const int proto, GDestroyNotify free_func);
+
+/**
+ * Number of conversations, for keeping an eye on the memory used in long
+ * captures.
+ */
+typedef struct {
+	guint	conversations;		/* currently in the tables */
+	guint	expired;		/* freed for being idle since the capture was opened */
+} conversation_stats_t;
+
+WS_DLL_PUBLIC void conversation_get_stats(conversation_stats_t *stats);
+
 /*
  * Given two address/port pairs for a packet, create a new conversation
  * to contain packets between those address/port pairs.
@@ -242,16 +281,16 @@ WS_DLL_PUBLIC
 void conversation_set_addr2(conversation_t *conv, const address *addr);
 
 WS_DLL_PUBLIC
-wmem_map_t *get_conversation_hashtable_exact(void);
+wmem_flat_map_t *get_conversation_hashtable_exact(void);
 
 WS_DLL_PUBLIC
-wmem_map_t *get_conversation_hashtable_no_addr2(void);
+wmem_flat_map_t *get_conversation_hashtable_no_addr2(void);
 
 WS_DLL_PUBLIC
-wmem_map_t * get_conversation_hashtable_no_port2(void);
+wmem_flat_map_t * get_conversation_hashtable_no_port2(void);
 
 WS_DLL_PUBLIC
-wmem_map_t *get_conversation_hashtable_no_addr2_or_port2(void);
+wmem_flat_map_t *get_conversation_hashtable_no_addr2_or_port2(void);
 
 /* Temporary function to handle port_type to endpoint_type conversion
    For now it's a 1-1 mapping, but the intention is to remove
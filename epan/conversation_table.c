@@ -558,6 +558,43 @@ char *get_hostlist_filter(hostlist_talker_t *host)
     return str;
 }
 
+/*
+ * Find a conversation in a table, in either direction.
+ */
+static conv_item_t *
+find_conversation_item(conv_hash_t *ch, const address *src, const address *dst,
+        guint32 src_port, guint32 dst_port, conv_id_t conv_id, gboolean *is_fwd_direction)
+{
+    conv_item_t *conv_item = NULL;
+    /* first, check in the fwd conversations */
+    conv_key_t existing_key;
+    gpointer conversation_idx_hash_val;
+
+    existing_key.addr1 = *src;
+    existing_key.addr2 = *dst;
+    existing_key.port1 = src_port;
+    existing_key.port2 = dst_port;
+    existing_key.conv_id = conv_id;
+    if (g_hash_table_lookup_extended(ch->hashtable, &existing_key, NULL, &conversation_idx_hash_val)) {
+        conv_item = &g_array_index(ch->conv_array, conv_item_t, GPOINTER_TO_UINT(conversation_idx_hash_val));
+    }
+    if (conv_item == NULL) {
+        /* then, check in the rev conversations if not found in 'fwd' */
+        existing_key.addr1 = *dst;
+        existing_key.addr2 = *src;
+        existing_key.port1 = dst_port;
+        existing_key.port2 = src_port;
+        if (g_hash_table_lookup_extended(ch->hashtable, &existing_key, NULL, &conversation_idx_hash_val)) {
+            conv_item = &g_array_index(ch->conv_array, conv_item_t, GPOINTER_TO_UINT(conversation_idx_hash_val));
+        }
+        *is_fwd_direction = FALSE;
+    } else {
+        /* a conversation was found in this same fwd direction */
+        *is_fwd_direction = TRUE;
+    }
+    return conv_item;
+}
+
 void
 add_conversation_table_data(conv_hash_t *ch, const address *src, const address *dst, guint32 src_port, guint32 dst_port, int num_frames, int num_bytes,
         nstime_t *ts, nstime_t *abs_ts, ct_dissector_info_t *ct_info, endpoint_type etype)
@@ -593,31 +630,7 @@ add_conversation_table_data_with_conv_id(
                                               NULL);              /* value_destroy_func */
 
     } else { /* try to find it among the existing known conversations */
-        /* first, check in the fwd conversations */
-        conv_key_t existing_key;
-        gpointer conversation_idx_hash_val;
-
-        existing_key.addr1 = *src;
-        existing_key.addr2 = *dst;
-        existing_key.port1 = src_port;
-        existing_key.port2 = dst_port;
-        existing_key.conv_id = conv_id;
-        if (g_hash_table_lookup_extended(ch->hashtable, &existing_key, NULL, &conversation_idx_hash_val)) {
-            conv_item = &g_array_index(ch->conv_array, conv_item_t, GPOINTER_TO_UINT(conversation_idx_hash_val));
-        }
-        if (conv_item == NULL) {
-            /* then, check in the rev conversations if not found in 'fwd' */
-            existing_key.addr1 = *dst;
-            existing_key.addr2 = *src;
-            existing_key.port1 = dst_port;
-            existing_key.port2 = src_port;
-            if (g_hash_table_lookup_extended(ch->hashtable, &existing_key, NULL, &conversation_idx_hash_val)) {
-                conv_item = &g_array_index(ch->conv_array, conv_item_t, GPOINTER_TO_UINT(conversation_idx_hash_val));
-            }
-        } else {
-            /* a conversation was found in this same fwd direction */
-            is_fwd_direction = TRUE;
-        }
+        conv_item = find_conversation_item(ch, src, dst, src_port, dst_port, conv_id, &is_fwd_direction);
     }
 
     /* if we still don't know what conversation this is it has to be a new one
@@ -792,6 +805,277 @@ add_hostlist_table_data(conv_hash_t *ch, const address *addr, guint32 port, gboo
     }
 }
 
+/*
+ * Saving and merging the states of conversation and endpoint tables, which
+ * lets them be computed by several processes, or over several files; see
+ * set_tap_listener_mergeable().  Addresses are saved with their data; the
+ * dissector information, which only the GUIs use to build filters, isn't
+ * saved, but taken from the entries already in the table, if any.
+ */
+static void
+save_address(GByteArray *state, const address *addr)
+{
+    gint32 type_len[2];
+
+    type_len[0] = addr->type;
+    type_len[1] = addr->len;
+    g_byte_array_append(state, (const guint8 *)type_len, sizeof type_len);
+    if (addr->len > 0)
+        g_byte_array_append(state, (const guint8 *)addr->data, addr->len);
+}
+
+/* The address's data points into the state. */
+static gboolean
+read_address(tap_state_reader_t *reader, address *addr)
+{
+    gint32 type_len[2];
+
+    if (!tap_state_read(reader, type_len, sizeof type_len) ||
+        type_len[1] < 0 || (gsize)type_len[1] > reader->len)
+        return FALSE;
+    set_address(addr, type_len[0], type_len[1], type_len[1] > 0 ? reader->data : NULL);
+    reader->data += type_len[1];
+    reader->len -= type_len[1];
+    return TRUE;
+}
+
+void
+copy_conversation_table_data(conv_hash_t *dst, const conv_hash_t *src)
+{
+    guint i;
+
+    reset_conversation_table_data(dst);
+    for (i = 0; src->conv_array && i < src->conv_array->len; i++) {
+        conv_item_t *from = &g_array_index(src->conv_array, conv_item_t, i);
+        conv_item_t *conv_item;
+
+        /* The conversations of a table are distinct, so each one is new. */
+        add_conversation_table_data_with_conv_id(dst, &from->src_address, &from->dst_address,
+                from->src_port, from->dst_port, from->conv_id, 0, 0,
+                nstime_is_unset(&from->start_time) ? NULL : &from->start_time,
+                &from->start_abs_time, from->dissector_info, from->etype);
+        conv_item = &g_array_index(dst->conv_array, conv_item_t, dst->conv_array->len - 1);
+        conv_item->rx_frames = from->rx_frames;
+        conv_item->tx_frames = from->tx_frames;
+        conv_item->rx_bytes = from->rx_bytes;
+        conv_item->tx_bytes = from->tx_bytes;
+        conv_item->stop_time = from->stop_time;
+    }
+}
+
+void
+copy_hostlist_table_data(conv_hash_t *dst, const conv_hash_t *src)
+{
+    guint i;
+
+    reset_hostlist_table_data(dst);
+    for (i = 0; src->conv_array && i < src->conv_array->len; i++) {
+        hostlist_talker_t *from = &g_array_index(src->conv_array, hostlist_talker_t, i);
+        hostlist_talker_t *talker;
+
+        add_hostlist_table_data(dst, &from->myaddress, from->port, TRUE, 0, 0,
+                from->dissector_info, from->etype);
+        talker = &g_array_index(dst->conv_array, hostlist_talker_t, dst->conv_array->len - 1);
+        talker->rx_frames = from->rx_frames;
+        talker->tx_frames = from->tx_frames;
+        talker->rx_bytes = from->rx_bytes;
+        talker->tx_bytes = from->tx_bytes;
+    }
+}
+
+void
+conversation_table_save_state(void *tapdata, GByteArray *state)
+{
+    conv_hash_t *ch = (conv_hash_t *)tapdata;
+    guint i;
+
+    for (i = 0; ch->conv_array && i < ch->conv_array->len; i++) {
+        conv_item_t *conv_item = &g_array_index(ch->conv_array, conv_item_t, i);
+        gint32 etype = conv_item->etype;
+
+        save_address(state, &conv_item->src_address);
+        save_address(state, &conv_item->dst_address);
+        g_byte_array_append(state, (const guint8 *)&etype, sizeof etype);
+        g_byte_array_append(state, (const guint8 *)&conv_item->src_port, sizeof conv_item->src_port);
+        g_byte_array_append(state, (const guint8 *)&conv_item->dst_port, sizeof conv_item->dst_port);
+        g_byte_array_append(state, (const guint8 *)&conv_item->conv_id, sizeof conv_item->conv_id);
+        g_byte_array_append(state, (const guint8 *)&conv_item->rx_frames, sizeof conv_item->rx_frames);
+        g_byte_array_append(state, (const guint8 *)&conv_item->tx_frames, sizeof conv_item->tx_frames);
+        g_byte_array_append(state, (const guint8 *)&conv_item->rx_bytes, sizeof conv_item->rx_bytes);
+        g_byte_array_append(state, (const guint8 *)&conv_item->tx_bytes, sizeof conv_item->tx_bytes);
+        g_byte_array_append(state, (const guint8 *)&conv_item->start_time, sizeof conv_item->start_time);
+        g_byte_array_append(state, (const guint8 *)&conv_item->stop_time, sizeof conv_item->stop_time);
+        g_byte_array_append(state, (const guint8 *)&conv_item->start_abs_time, sizeof conv_item->start_abs_time);
+    }
+}
+
+gboolean
+conversation_table_merge_state(void *tapdata, const guint8 *state, gsize len)
+{
+    conv_hash_t *ch = (conv_hash_t *)tapdata;
+    tap_state_reader_t reader;
+    ct_dissector_info_t *ct_info = NULL;
+    nstime_t first_time;        /* absolute time of the first frame of our capture */
+    gboolean have_first_time = FALSE;
+    guint i;
+
+    /* The relative times of saved conversations are from the first frame
+       of the capture they were saved from; when merging several captures,
+       make them relative to the first frame of ours. */
+    for (i = 0; ch->conv_array && i < ch->conv_array->len; i++) {
+        conv_item_t *conv_item = &g_array_index(ch->conv_array, conv_item_t, i);
+
+        ct_info = conv_item->dissector_info;
+        if (!have_first_time && !nstime_is_unset(&conv_item->start_time)) {
+            nstime_delta(&first_time, &conv_item->start_abs_time, &conv_item->start_time);
+            have_first_time = TRUE;
+        }
+    }
+
+    reader.data = state;
+    reader.len = len;
+    while (reader.len > 0) {
+        conv_item_t from;
+        conv_item_t *conv_item = NULL;
+        gint32 etype;
+        gboolean is_fwd_direction = TRUE;
+        nstime_t from_first_time, offset;
+
+        if (!read_address(&reader, &from.src_address) ||
+            !read_address(&reader, &from.dst_address) ||
+            !tap_state_read(&reader, &etype, sizeof etype) ||
+            !tap_state_read(&reader, &from.src_port, sizeof from.src_port) ||
+            !tap_state_read(&reader, &from.dst_port, sizeof from.dst_port) ||
+            !tap_state_read(&reader, &from.conv_id, sizeof from.conv_id) ||
+            !tap_state_read(&reader, &from.rx_frames, sizeof from.rx_frames) ||
+            !tap_state_read(&reader, &from.tx_frames, sizeof from.tx_frames) ||
+            !tap_state_read(&reader, &from.rx_bytes, sizeof from.rx_bytes) ||
+            !tap_state_read(&reader, &from.tx_bytes, sizeof from.tx_bytes) ||
+            !tap_state_read(&reader, &from.start_time, sizeof from.start_time) ||
+            !tap_state_read(&reader, &from.stop_time, sizeof from.stop_time) ||
+            !tap_state_read(&reader, &from.start_abs_time, sizeof from.start_abs_time))
+            return FALSE;
+
+        if (!nstime_is_unset(&from.start_time)) {
+            nstime_delta(&from_first_time, &from.start_abs_time, &from.start_time);
+            if (have_first_time) {
+                nstime_delta(&offset, &from_first_time, &first_time);
+                nstime_add(&from.start_time, &offset);
+                nstime_add(&from.stop_time, &offset);
+            } else {
+                first_time = from_first_time;
+                have_first_time = TRUE;
+            }
+        }
+
+        if (ch->conv_array != NULL)
+            conv_item = find_conversation_item(ch, &from.src_address, &from.dst_address,
+                    from.src_port, from.dst_port, from.conv_id, &is_fwd_direction);
+        if (conv_item == NULL) {
+            add_conversation_table_data_with_conv_id(ch, &from.src_address, &from.dst_address,
+                    from.src_port, from.dst_port, from.conv_id, 0, 0,
+                    nstime_is_unset(&from.start_time) ? NULL : &from.start_time,
+                    &from.start_abs_time, ct_info, (endpoint_type)etype);
+            conv_item = &g_array_index(ch->conv_array, conv_item_t, ch->conv_array->len - 1);
+            is_fwd_direction = TRUE;
+        }
+
+        if (is_fwd_direction) {
+            conv_item->tx_frames += from.tx_frames;
+            conv_item->tx_bytes += from.tx_bytes;
+            conv_item->rx_frames += from.rx_frames;
+            conv_item->rx_bytes += from.rx_bytes;
+        } else {
+            conv_item->tx_frames += from.rx_frames;
+            conv_item->tx_bytes += from.rx_bytes;
+            conv_item->rx_frames += from.tx_frames;
+            conv_item->rx_bytes += from.tx_bytes;
+        }
+
+        if (!nstime_is_unset(&from.start_time)) {
+            if (nstime_is_unset(&conv_item->start_time)) {
+                conv_item->start_time = from.start_time;
+                conv_item->stop_time = from.stop_time;
+                conv_item->start_abs_time = from.start_abs_time;
+            } else {
+                if (nstime_cmp(&from.start_time, &conv_item->start_time) < 0) {
+                    conv_item->start_time = from.start_time;
+                    conv_item->start_abs_time = from.start_abs_time;
+                }
+                if (nstime_cmp(&from.stop_time, &conv_item->stop_time) > 0) {
+                    conv_item->stop_time = from.stop_time;
+                }
+            }
+        }
+    }
+    return TRUE;
+}
+
+void
+hostlist_table_save_state(void *tapdata, GByteArray *state)
+{
+    conv_hash_t *ch = (conv_hash_t *)tapdata;
+    guint i;
+
+    for (i = 0; ch->conv_array && i < ch->conv_array->len; i++) {
+        hostlist_talker_t *talker = &g_array_index(ch->conv_array, hostlist_talker_t, i);
+        gint32 etype = talker->etype;
+
+        save_address(state, &talker->myaddress);
+        g_byte_array_append(state, (const guint8 *)&etype, sizeof etype);
+        g_byte_array_append(state, (const guint8 *)&talker->port, sizeof talker->port);
+        g_byte_array_append(state, (const guint8 *)&talker->rx_frames, sizeof talker->rx_frames);
+        g_byte_array_append(state, (const guint8 *)&talker->tx_frames, sizeof talker->tx_frames);
+        g_byte_array_append(state, (const guint8 *)&talker->rx_bytes, sizeof talker->rx_bytes);
+        g_byte_array_append(state, (const guint8 *)&talker->tx_bytes, sizeof talker->tx_bytes);
+    }
+}
+
+gboolean
+hostlist_table_merge_state(void *tapdata, const guint8 *state, gsize len)
+{
+    conv_hash_t *ch = (conv_hash_t *)tapdata;
+    tap_state_reader_t reader;
+    hostlist_dissector_info_t *host_info = NULL;
+
+    if (ch->conv_array && ch->conv_array->len > 0)
+        host_info = g_array_index(ch->conv_array, hostlist_talker_t, 0).dissector_info;
+
+    reader.data = state;
+    reader.len = len;
+    while (reader.len > 0) {
+        hostlist_talker_t from;
+        hostlist_talker_t *talker;
+        host_key_t existing_key;
+        gpointer talker_idx_hash_val;
+        gint32 etype;
+
+        if (!read_address(&reader, &from.myaddress) ||
+            !tap_state_read(&reader, &etype, sizeof etype) ||
+            !tap_state_read(&reader, &from.port, sizeof from.port) ||
+            !tap_state_read(&reader, &from.rx_frames, sizeof from.rx_frames) ||
+            !tap_state_read(&reader, &from.tx_frames, sizeof from.tx_frames) ||
+            !tap_state_read(&reader, &from.rx_bytes, sizeof from.rx_bytes) ||
+            !tap_state_read(&reader, &from.tx_bytes, sizeof from.tx_bytes))
+            return FALSE;
+
+        /* Find the talker, adding it if it's new. */
+        add_hostlist_table_data(ch, &from.myaddress, from.port, TRUE, 0, 0,
+                host_info, (endpoint_type)etype);
+        copy_address_shallow(&existing_key.myaddress, &from.myaddress);
+        existing_key.port = from.port;
+        if (!g_hash_table_lookup_extended(ch->hashtable, &existing_key, NULL, &talker_idx_hash_val))
+            return FALSE;
+        talker = &g_array_index(ch->conv_array, hostlist_talker_t, GPOINTER_TO_UINT(talker_idx_hash_val));
+
+        talker->rx_frames += from.rx_frames;
+        talker->tx_frames += from.tx_frames;
+        talker->rx_bytes += from.rx_bytes;
+        talker->tx_bytes += from.tx_bytes;
+    }
+    return TRUE;
+}
+
 /*
  * Editor modelines
  *
@@ -319,6 +319,32 @@ add_conversation_table_data_with_conv_id(conv_hash_t *ch, const address *src, co
 WS_DLL_PUBLIC void add_hostlist_table_data(conv_hash_t *ch, const address *addr,
     guint32 port, gboolean sender, int num_frames, int num_bytes, hostlist_dissector_info_t *host_info, endpoint_type etype);
 
+/** Replace the contents of a conversation table with a copy of another's.
+ *
+ * @param dst the table to fill
+ * @param src the table to copy
+ */
+WS_DLL_PUBLIC void copy_conversation_table_data(conv_hash_t *dst, const conv_hash_t *src);
+
+/** As copy_conversation_table_data(), for an endpoint table. */
+WS_DLL_PUBLIC void copy_hostlist_table_data(conv_hash_t *dst, const conv_hash_t *src);
+
+/** Save the state of a conversation table tap listener, whose tap data is
+ * the conv_hash_t; for set_tap_listener_mergeable().
+ */
+WS_DLL_PUBLIC void conversation_table_save_state(void *tapdata, GByteArray *state);
+
+/** Merge a state saved by conversation_table_save_state() into a conversation
+ * table; for set_tap_listener_mergeable().
+ */
+WS_DLL_PUBLIC gboolean conversation_table_merge_state(void *tapdata, const guint8 *state, gsize len);
+
+/** As conversation_table_save_state(), for an endpoint table. */
+WS_DLL_PUBLIC void hostlist_table_save_state(void *tapdata, GByteArray *state);
+
+/** As conversation_table_merge_state(), for an endpoint table. */
+WS_DLL_PUBLIC gboolean hostlist_table_merge_state(void *tapdata, const guint8 *state, gsize len);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
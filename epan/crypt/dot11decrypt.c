@@ -112,28 +112,6 @@ extern const UINT32 crc32_table[256];
 extern "C" {
 #endif
 
-/**
- * It is a step of the PBKDF2 (specifically the PKCS #5 v2.0) defined in
- * the RFC 2898 to derive a key (used as PMK in WPA)
- * @param ppbytes [IN] pointer to a password (sequence of between 8 and
- * 63 ASCII encoded characters)
- * @param ssid [IN] pointer to the SSID string encoded in max 32 ASCII
- * encoded characters
- * @param iterations [IN] times to hash the password (4096 for WPA)
- * @param count [IN] ???
- * @param output [OUT] pointer to a preallocated buffer of
- * SHA1_DIGEST_LEN characters that will contain a part of the key
- */
-static INT Dot11DecryptRsnaPwd2PskStep(
-    const guint8 *ppbytes,
-    const guint passLength,
-    const CHAR *ssid,
-    const size_t ssidLength,
-    const INT iterations,
-    const INT count,
-    UCHAR *output)
-    ;
-
 /**
  * It calculates the passphrase-to-PSK mapping reccomanded for use with
  * RSNAs. This implementation uses the PBKDF2 method defined in the RFC
@@ -2701,10 +2679,25 @@ Dot11DecryptFtDerivePtk(
 
 #define MAX_SSID_LENGTH 32 /* maximum SSID length */
 
+/*
+ * The PSKs derived from passphrases, keyed by the SSID and the passphrase.
+ * Deriving one takes 8192 HMAC-SHA1 computations, and it's done for every
+ * passphrase whenever the keys are set, and for every EAPOL message 2 with
+ * a passphrase that has no SSID.
+ */
+#define DOT11DECRYPT_PSK_CACHE_MAX 1024
+
+static GHashTable *psk_cache = NULL;
+G_LOCK_DEFINE_STATIC(psk_cache);
+
+/*
+ * A step of PBKDF2 (PKCS #5 v2.0, RFC 2898), with an HMAC-SHA1 handle
+ * keyed with the passphrase, reset for every iteration rather than opened
+ * and keyed again.
+ */
 static INT
 Dot11DecryptRsnaPwd2PskStep(
-    const guint8 *ppBytes,
-    const guint ppLength,
+    gcry_md_hd_t hmac,
     const CHAR *ssid,
     const size_t ssidLength,
     const INT iterations,
@@ -2714,31 +2707,26 @@ Dot11DecryptRsnaPwd2PskStep(
     UCHAR digest[MAX_SSID_LENGTH+4] = { 0 };  /* SSID plus 4 bytes of count */
     INT i, j;
 
-    if (ssidLength > MAX_SSID_LENGTH) {
-        /* This "should not happen" */
-        return DOT11DECRYPT_RET_UNSUCCESS;
-    }
-
     /* U1 = PRF(P, S || INT(i)) */
     memcpy(digest, ssid, ssidLength);
     digest[ssidLength] = (UCHAR)((count>>24) & 0xff);
     digest[ssidLength+1] = (UCHAR)((count>>16) & 0xff);
     digest[ssidLength+2] = (UCHAR)((count>>8) & 0xff);
     digest[ssidLength+3] = (UCHAR)(count & 0xff);
-    if (ws_hmac_buffer(GCRY_MD_SHA1, digest, digest, (guint32) ssidLength + 4, ppBytes, ppLength)) {
-      return DOT11DECRYPT_RET_UNSUCCESS;
-    }
+    gcry_md_reset(hmac);
+    gcry_md_write(hmac, digest, ssidLength + 4);
+    memcpy(digest, gcry_md_read(hmac, 0), HASH_SHA1_LENGTH);
 
     /* output = U1 */
-    memcpy(output, digest, 20);
+    memcpy(output, digest, HASH_SHA1_LENGTH);
     for (i = 1; i < iterations; i++) {
         /* Un = PRF(P, Un-1) */
-        if (ws_hmac_buffer(GCRY_MD_SHA1, digest, digest, HASH_SHA1_LENGTH, ppBytes, ppLength)) {
-          return DOT11DECRYPT_RET_UNSUCCESS;
-        }
+        gcry_md_reset(hmac);
+        gcry_md_write(hmac, digest, HASH_SHA1_LENGTH);
+        memcpy(digest, gcry_md_read(hmac, 0), HASH_SHA1_LENGTH);
 
         /* output = output xor Un */
-        for (j = 0; j < 20; j++) {
+        for (j = 0; j < HASH_SHA1_LENGTH; j++) {
             output[j] ^= digest[j];
         }
     }
@@ -2753,19 +2741,70 @@ Dot11DecryptRsnaPwd2Psk(
     const size_t ssidLength,
     UCHAR *output)
 {
+    size_t passLength = strlen(passphrase);
+    guint8 *key_data;
+    GBytes *cache_key;
+    const guint8 *cached_psk;
+    GByteArray *pp_ba;
+    gcry_md_hd_t hmac;
     UCHAR m_output[40] = { 0 };
-    GByteArray *pp_ba = g_byte_array_new();
 
+    if (ssidLength > MAX_SSID_LENGTH) {
+        /* This "should not happen" */
+        return DOT11DECRYPT_RET_UNSUCCESS;
+    }
+
+    /* The length of the SSID, the SSID, and the passphrase */
+    key_data = (guint8 *)g_malloc(1 + ssidLength + passLength);
+    key_data[0] = (guint8)ssidLength;
+    memcpy(key_data + 1, ssid, ssidLength);
+    memcpy(key_data + 1 + ssidLength, passphrase, passLength);
+    cache_key = g_bytes_new_take(key_data, 1 + ssidLength + passLength);
+
+    G_LOCK(psk_cache);
+    if (psk_cache == NULL) {
+        psk_cache = g_hash_table_new_full(g_bytes_hash, g_bytes_equal,
+                                          (GDestroyNotify)g_bytes_unref, g_free);
+    }
+    cached_psk = (const guint8 *)g_hash_table_lookup(psk_cache, cache_key);
+    if (cached_psk != NULL) {
+        memcpy(output, cached_psk, DOT11DECRYPT_WPA_PWD_PSK_LEN);
+    }
+    G_UNLOCK(psk_cache);
+
+    if (cached_psk != NULL) {
+        g_bytes_unref(cache_key);
+        return 0;
+    }
+
+    pp_ba = g_byte_array_new();
     if (!uri_str_to_bytes(passphrase, pp_ba)) {
         g_byte_array_free(pp_ba, TRUE);
+        g_bytes_unref(cache_key);
         return 0;
     }
 
-    Dot11DecryptRsnaPwd2PskStep(pp_ba->data, pp_ba->len, ssid, ssidLength, 4096, 1, m_output);
-    Dot11DecryptRsnaPwd2PskStep(pp_ba->data, pp_ba->len, ssid, ssidLength, 4096, 2, &m_output[20]);
+    /* gcry_kdf_derive() would do, but it doesn't allow an empty SSID */
+    if (gcry_md_open(&hmac, GCRY_MD_SHA1, GCRY_MD_FLAG_HMAC) ||
+        gcry_md_setkey(hmac, pp_ba->data, pp_ba->len)) {
+        gcry_md_close(hmac);
+        g_byte_array_free(pp_ba, TRUE);
+        g_bytes_unref(cache_key);
+        return DOT11DECRYPT_RET_UNSUCCESS;
+    }
+    Dot11DecryptRsnaPwd2PskStep(hmac, ssid, ssidLength, 4096, 1, m_output);
+    Dot11DecryptRsnaPwd2PskStep(hmac, ssid, ssidLength, 4096, 2, &m_output[20]);
+    gcry_md_close(hmac);
+    g_byte_array_free(pp_ba, TRUE);
 
     memcpy(output, m_output, DOT11DECRYPT_WPA_PWD_PSK_LEN);
-    g_byte_array_free(pp_ba, TRUE);
+
+    G_LOCK(psk_cache);
+    if (g_hash_table_size(psk_cache) >= DOT11DECRYPT_PSK_CACHE_MAX) {
+        g_hash_table_remove_all(psk_cache);
+    }
+    g_hash_table_insert(psk_cache, cache_key, g_memdup2(output, DOT11DECRYPT_WPA_PWD_PSK_LEN));
+    G_UNLOCK(psk_cache);
 
     return 0;
 }
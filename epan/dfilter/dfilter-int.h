@@ -17,6 +17,7 @@
 
 /* Passed back to user */
 struct epan_dfilter {
+	guint		ref_count;	/* the cache holds one; see dfilter_compile() */
 	GPtrArray	*insns;
 	GPtrArray	*consts;
 	guint		num_registers;
@@ -26,7 +27,17 @@ struct epan_dfilter {
 	gboolean	*owns_memory;
 	int		*interesting_fields;
 	int		num_interesting_fields;
+	int		*required_protos;	/* protocols a frame must have to match */
+	int		num_required_protos;
 	GPtrArray	*deprecated;
+	struct dfvm_code *code;		/* threaded code, or NULL to interpret insns */
+	guint		code_len;
+	/* "field" and "field <relation> constant" filters run without the VM */
+	header_field_info *simple_hfinfo;
+	int		simple_op;	/* dfvm_opcode_t */
+	int		simple_storage;	/* dfvm_simple_storage_t */
+	guint64		simple_uvalue;
+	gint64		simple_svalue;
 };
 
 typedef struct {
@@ -42,6 +53,8 @@ typedef struct {
 	int		next_const_id;
 	int		next_register;
 	int		first_constant; /* first register used as a constant */
+	header_field_info *simple_hfinfo; /* see dfw_check_simple() */
+	int		simple_op;
 } dfwork_t;
 
 /*
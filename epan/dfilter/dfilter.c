@@ -34,6 +34,103 @@ static void*	ParserObj = NULL;
  */
 dfwork_t *global_dfw;
 
+/*
+ * Compiled filters are cached, by their text once macros are expanded:
+ * the filter toolbar, coloring rules and sharkd compile the same filters
+ * over and over, and filters with large sets take a while to compile.
+ * A filter refers to the fields it tests, so the cache is emptied when
+ * fields are registered or deregistered.  Filters are reference counted,
+ * so that the cache and the callers of dfilter_compile() can share them.
+ */
+#define DFILTER_CACHE_SIZE	64
+
+typedef struct {
+	gchar		*text;
+	dfilter_t	*df;
+} dfilter_cache_entry_t;
+
+static GHashTable *dfilter_cache = NULL;	/* text -> link in dfilter_cache_lru */
+static GQueue dfilter_cache_lru = G_QUEUE_INIT;	/* most recently used first */
+static guint dfilter_cache_generation;
+
+static void
+dfilter_cache_entry_free(dfilter_cache_entry_t *entry)
+{
+	dfilter_free(entry->df);
+	g_free(entry->text);
+	g_free(entry);
+}
+
+static void
+dfilter_cache_clear(void)
+{
+	dfilter_cache_entry_t *entry;
+
+	if (dfilter_cache)
+		g_hash_table_remove_all(dfilter_cache);
+	while ((entry = (dfilter_cache_entry_t *)g_queue_pop_head(&dfilter_cache_lru)) != NULL)
+		dfilter_cache_entry_free(entry);
+}
+
+/* Empty the cache if the fields its filters refer to may have changed. */
+static void
+dfilter_cache_check_generation(void)
+{
+	if (dfilter_cache_generation != proto_registrar_get_generation()) {
+		dfilter_cache_clear();
+		dfilter_cache_generation = proto_registrar_get_generation();
+	}
+}
+
+/* Returns a new reference to the cached filter compiled from text,
+ * or NULL. */
+static dfilter_t *
+dfilter_cache_lookup(const gchar *text)
+{
+	GList			*link;
+	dfilter_cache_entry_t	*entry;
+
+	if (!dfilter_cache)
+		return NULL;
+
+	dfilter_cache_check_generation();
+	link = (GList *)g_hash_table_lookup(dfilter_cache, text);
+	if (!link)
+		return NULL;
+
+	g_queue_unlink(&dfilter_cache_lru, link);
+	g_queue_push_head_link(&dfilter_cache_lru, link);
+	entry = (dfilter_cache_entry_t *)link->data;
+	entry->df->ref_count++;
+	return entry->df;
+}
+
+static void
+dfilter_cache_add(const gchar *text, dfilter_t *df)
+{
+	dfilter_cache_entry_t	*entry;
+
+	if (!dfilter_cache)
+		dfilter_cache = g_hash_table_new(g_str_hash, g_str_equal);
+
+	dfilter_cache_check_generation();
+	if (g_hash_table_contains(dfilter_cache, text))
+		return;
+
+	entry = g_new(dfilter_cache_entry_t, 1);
+	entry->text = g_strdup(text);
+	entry->df = df;
+	df->ref_count++;
+	g_queue_push_head(&dfilter_cache_lru, entry);
+	g_hash_table_insert(dfilter_cache, entry->text, dfilter_cache_lru.head);
+
+	if (dfilter_cache_lru.length > DFILTER_CACHE_SIZE) {
+		entry = (dfilter_cache_entry_t *)g_queue_pop_tail(&dfilter_cache_lru);
+		g_hash_table_remove(dfilter_cache, entry->text);
+		dfilter_cache_entry_free(entry);
+	}
+}
+
 void
 dfilter_fail(dfwork_t *dfw, const char *format, ...)
 {
@@ -80,6 +177,12 @@ dfilter_cleanup(void)
 {
 	dfilter_macro_cleanup();
 
+	dfilter_cache_clear();
+	if (dfilter_cache) {
+		g_hash_table_destroy(dfilter_cache);
+		dfilter_cache = NULL;
+	}
+
 	/* Free the Lemon Parser object */
 	if (ParserObj) {
 		DfilterFree(ParserObj, g_free);
@@ -95,6 +198,7 @@ dfilter_new(void)
 	dfilter_t	*df;
 
 	df = g_new0(dfilter_t, 1);
+	df->ref_count = 1;
 	df->insns = NULL;
 	df->deprecated = NULL;
 
@@ -124,6 +228,11 @@ dfilter_free(dfilter_t *df)
 	if (!df)
 		return;
 
+	/* The cache, or another caller of dfilter_compile(), may still
+	 * be using it. */
+	if (--df->ref_count > 0)
+		return;
+
 	if (df->insns) {
 		free_insns(df->insns);
 	}
@@ -132,6 +241,9 @@ dfilter_free(dfilter_t *df)
 	}
 
 	g_free(df->interesting_fields);
+	g_free(df->required_protos);
+
+	dfvm_code_free(df);
 
 	/* Clear registers with constant values (as set by dfvm_init_const).
 	 * Other registers were cleared on RETURN by free_register_overhead. */
@@ -225,6 +337,13 @@ dfilter_compile(const gchar *text, dfilter_t **dfp, gchar **err_msg)
 		return FALSE;
 	}
 
+	/* Has it been compiled already? */
+	*dfp = dfilter_cache_lookup(expanded_text);
+	if (*dfp) {
+		wmem_free(NULL, expanded_text);
+		return TRUE;
+	}
+
 	if (df_lex_init(&scanner) != 0) {
 		wmem_free(NULL, expanded_text);
 		*dfp = NULL;
@@ -345,6 +464,8 @@ dfilter_compile(const gchar *text, dfilter_t **dfp, gchar **err_msg)
 		dfw->consts = NULL;
 		dfilter->interesting_fields = dfw_interesting_fields(dfw,
 			&dfilter->num_interesting_fields);
+		dfilter->required_protos = dfw_required_protocols(dfw,
+			&dfilter->num_required_protos);
 
 		/* Initialize run-time space */
 		dfilter->num_registers = dfw->first_constant;
@@ -356,9 +477,19 @@ dfilter_compile(const gchar *text, dfilter_t **dfp, gchar **err_msg)
 		/* Initialize constants */
 		dfvm_init_const(dfilter);
 
+		/* Pick the engine to run it: simple filters need no
+		 * instructions; for the rest, translate the instructions
+		 * into threaded code if we can. */
+		if (dfw->simple_hfinfo)
+			dfvm_init_simple(dfilter, dfw->simple_hfinfo, (dfvm_opcode_t)dfw->simple_op);
+		else
+			dfvm_compile(dfilter);
+
 		/* Add any deprecated items */
 		dfilter->deprecated = deprecated;
 
+		dfilter_cache_add(expanded_text, dfilter);
+
 		/* And give it to the user. */
 		*dfp = dfilter;
 	}
@@ -427,6 +558,25 @@ dfilter_has_interesting_fields(const dfilter_t *df)
 	return (df->num_interesting_fields > 0);
 }
 
+gboolean
+dfilter_interested_in_field(const dfilter_t *df, int field_id)
+{
+	int i;
+
+	for (i = 0; i < df->num_interesting_fields; i++) {
+		if (df->interesting_fields[i] == field_id)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+const int *
+dfilter_required_protocols(const dfilter_t *df, int *num_protos)
+{
+	*num_protos = df->num_required_protos;
+	return df->required_protos;
+}
+
 GPtrArray *
 dfilter_deprecated_tokens(dfilter_t *df) {
 	if (df->deprecated && df->deprecated->len > 0) {
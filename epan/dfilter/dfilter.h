@@ -43,6 +43,9 @@ dfilter_cleanup(void);
  * g_malloc(), and must be freed with g_free().
  * The dfilter* will be set to NULL after a failure.
  *
+ * Compiled filters are cached, so compiling the same text again
+ * can give the same dfilter_t; each must be freed with dfilter_free().
+ *
  * Returns TRUE on success, FALSE on failure.
  */
 WS_DLL_PUBLIC
@@ -50,7 +53,8 @@ gboolean
 dfilter_compile(const gchar *text, dfilter_t **dfp, gchar **err_msg);
 
 /* Frees all memory used by dfilter, and frees
- * the dfilter itself. */
+ * the dfilter itself, once no other dfilter_compile()
+ * caller, nor the cache, is using it. */
 WS_DLL_PUBLIC
 void
 dfilter_free(dfilter_t *df);
@@ -72,6 +76,18 @@ dfilter_prime_proto_tree(const dfilter_t *df, proto_tree *tree);
 gboolean
 dfilter_has_interesting_fields(const dfilter_t *df);
 
+/* Check if the dfilter looks at the values of the field with the given id */
+WS_DLL_PUBLIC
+gboolean
+dfilter_interested_in_field(const dfilter_t *df, int field_id);
+
+/* Get the ids of protocols that have to be in a frame for the dfilter to
+ * match it.  Frames without one of them can't match; frames with all of
+ * them might.  Returns NULL, with *num_protos set to 0, if there aren't any. */
+WS_DLL_PUBLIC
+const int *
+dfilter_required_protocols(const dfilter_t *df, int *num_protos);
+
 WS_DLL_PUBLIC
 GPtrArray *
 dfilter_deprecated_tokens(dfilter_t *df);
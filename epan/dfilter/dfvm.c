@@ -12,6 +12,195 @@
 
 #include <ftypes/ftypes-int.h>
 
+/*
+ * The elements of a set are looked up, in a hash table, by a 64-bit key:
+ * the value of an integer, or the address of an IPv4 host.  An IPv4 subnet
+ * of prefix length len < 32 has the key ((len + 1) << 32) | network, so
+ * an address is looked up as a host, and then in the subnets of each
+ * prefix length the set has, at most 33 lookups whatever its size.
+ */
+struct dfvm_fvalue_set {
+	GPtrArray	*fvalues;	/* the elements */
+	ftenum_t	ftype;		/* their type */
+	guint64		*slots;		/* the hash table of their keys */
+	guint		mask;		/* number of slots - 1 */
+	gboolean	has_empty_key;	/* the key marking empty slots is in the set */
+	guint		num_keys;
+	guint64		prefix_lens;	/* bit len set if there are subnets of length len */
+};
+
+#define SET_EMPTY_SLOT	G_MAXUINT64
+
+static inline guint
+fvalue_set_hash(guint64 key, guint mask)
+{
+	/* Fibonacci hashing; the top bits are the best mixed. */
+	return (guint)((key * G_GUINT64_CONSTANT(0x9E3779B97F4A7C15)) >> 32) & mask;
+}
+
+static inline guint32
+ipv4_prefix_mask(guint len)
+{
+	return len == 0 ? 0 : 0xffffffffU << (32 - len);
+}
+
+static guint
+ipv4_prefix_len(guint32 nmask)
+{
+	guint	len = 0;
+
+	while (len < 32 && (nmask & (0x80000000U >> len)))
+		len++;
+	return len;
+}
+
+/* The key of a value to look up, or of an element of a set;
+ * FALSE if it doesn't have one. */
+static gboolean
+fvalue_set_key(const fvalue_t *fv, gboolean element, guint64 *key)
+{
+	ftenum_t	ftype = fvalue_type_ftenum(fv);
+	guint		len;
+
+	switch (dfvm_simple_storage(ftype)) {
+		case DFVM_SIMPLE_UINT:
+			*key = fv->value.uinteger;
+			return TRUE;
+		case DFVM_SIMPLE_SINT:
+			*key = (guint64)(gint64)fv->value.sinteger;
+			return TRUE;
+		case DFVM_SIMPLE_UINT64:
+			*key = fv->value.uinteger64;
+			return TRUE;
+		case DFVM_SIMPLE_SINT64:
+			*key = (guint64)fv->value.sinteger64;
+			return TRUE;
+		case DFVM_SIMPLE_NONE:
+		default:
+			break;
+	}
+	if (ftype != FT_IPv4)
+		return FALSE;
+	if (fv->value.ipv4.nmask == 0xffffffff) {
+		*key = fv->value.ipv4.addr;
+		return TRUE;
+	}
+	/* A subnet is equal to every address in it, so it can't be looked
+	 * up itself; it can only be looked for. */
+	if (!element)
+		return FALSE;
+	len = ipv4_prefix_len(fv->value.ipv4.nmask);
+	if (fv->value.ipv4.nmask != ipv4_prefix_mask(len))
+		return FALSE;
+	*key = ((guint64)(len + 1) << 32) | (fv->value.ipv4.addr & fv->value.ipv4.nmask);
+	return TRUE;
+}
+
+gboolean
+dfvm_fvalue_set_can_hold(const fvalue_t *fv)
+{
+	guint64	key;
+
+	return fvalue_set_key(fv, TRUE, &key);
+}
+
+static gboolean
+fvalue_set_has_key(const dfvm_fvalue_set_t *set, guint64 key)
+{
+	guint	i;
+
+	if (key == SET_EMPTY_SLOT)
+		return set->has_empty_key;
+	for (i = fvalue_set_hash(key, set->mask); set->slots[i] != SET_EMPTY_SLOT; i = (i + 1) & set->mask) {
+		if (set->slots[i] == key)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+dfvm_fvalue_set_t *
+dfvm_fvalue_set_new(GPtrArray *fvalues)
+{
+	dfvm_fvalue_set_t	*set;
+	const fvalue_t		*fv;
+	guint			i, j, size;
+	guint64			key;
+
+	g_assert(fvalues->len > 0);
+
+	set = g_new0(dfvm_fvalue_set_t, 1);
+	set->fvalues = fvalues;
+	set->ftype = fvalue_type_ftenum((fvalue_t *)g_ptr_array_index(fvalues, 0));
+
+	/* Keep the table at most half full. */
+	for (size = 16; size < fvalues->len * 2; size *= 2)
+		;
+	set->slots = g_new(guint64, size);
+	for (i = 0; i < size; i++)
+		set->slots[i] = SET_EMPTY_SLOT;
+	set->mask = size - 1;
+
+	for (i = 0; i < fvalues->len; i++) {
+		fv = (const fvalue_t *)g_ptr_array_index(fvalues, i);
+		if (!fvalue_set_key(fv, TRUE, &key))
+			g_assert_not_reached();
+		if (key >> 32 != 0 && set->ftype == FT_IPv4)
+			set->prefix_lens |= G_GUINT64_CONSTANT(1) << ((key >> 32) - 1);
+		if (fvalue_set_has_key(set, key))
+			continue;
+		if (key == SET_EMPTY_SLOT) {
+			set->has_empty_key = TRUE;
+		} else {
+			for (j = fvalue_set_hash(key, set->mask); set->slots[j] != SET_EMPTY_SLOT; j = (j + 1) & set->mask)
+				;
+			set->slots[j] = key;
+		}
+		set->num_keys++;
+	}
+	return set;
+}
+
+static void
+dfvm_fvalue_set_free(dfvm_fvalue_set_t *set)
+{
+	guint	i;
+
+	for (i = 0; i < set->fvalues->len; i++) {
+		fvalue_t *fv = (fvalue_t *)g_ptr_array_index(set->fvalues, i);
+		FVALUE_FREE(fv);
+	}
+	g_ptr_array_free(set->fvalues, TRUE);
+	g_free(set->slots);
+	g_free(set);
+}
+
+static gboolean
+fvalue_set_contains(const dfvm_fvalue_set_t *set, const fvalue_t *fv)
+{
+	guint64	key, lens;
+	guint	len, i;
+
+	if (fvalue_type_ftenum(fv) == set->ftype && fvalue_set_key(fv, FALSE, &key)) {
+		if (fvalue_set_has_key(set, key))
+			return TRUE;
+		/* Look for the networks of an IPv4 address. */
+		for (lens = set->prefix_lens, len = 0; lens != 0; lens >>= 1, len++) {
+			if ((lens & 1) &&
+			    fvalue_set_has_key(set, ((guint64)(len + 1) << 32) | (key & ipv4_prefix_mask(len))))
+				return TRUE;
+		}
+		return FALSE;
+	}
+
+	/* A value of another type (from another field with the same name)
+	 * or a subnet: compare it with each element. */
+	for (i = 0; i < set->fvalues->len; i++) {
+		if (fvalue_eq(fv, (const fvalue_t *)g_ptr_array_index(set->fvalues, i)))
+			return TRUE;
+	}
+	return FALSE;
+}
+
 dfvm_insn_t*
 dfvm_insn_new(dfvm_opcode_t op)
 {
@@ -37,7 +226,13 @@ dfvm_value_free(dfvm_value_t *v)
 			drange_free(v->value.drange);
 			break;
 		case PCRE:
-			g_regex_unref(v->value.pcre);
+			fvalue_regex_free(v->value.pcre);
+			break;
+		case FVALUE_SET:
+			dfvm_fvalue_set_free(v->value.fvalue_set);
+			break;
+		case NEEDLES:
+			fvalue_needles_free(v->value.needles);
 			break;
 		default:
 			/* nothing */
@@ -111,7 +306,7 @@ dfvm_dump(FILE *f, dfilter_t *df)
 			case PUT_PCRE:
 				fprintf(f, "%05d PUT_PCRE\t%s -> reg#%u\n",
 					id,
-					g_regex_get_pattern(arg1->value.pcre),
+					fvalue_regex_pattern(arg1->value.pcre),
 					arg2->value.numeric);
 				break;
 			case CHECK_EXISTS:
@@ -128,6 +323,8 @@ dfvm_dump(FILE *f, dfilter_t *df)
 			case ANY_CONTAINS:
 			case ANY_MATCHES:
 			case ANY_IN_RANGE:
+			case ANY_IN_SET:
+			case ANY_CONTAINS_ANY:
 			case NOT:
 			case RETURN:
 			case IF_TRUE_GOTO:
@@ -273,6 +470,18 @@ dfvm_dump(FILE *f, dfilter_t *df)
 					arg3->value.numeric);
 				break;
 
+			case ANY_IN_SET:
+				fprintf(f, "%05d ANY_IN_SET\treg#%u in set of %u values\n",
+					id, arg1->value.numeric,
+					arg2->value.fvalue_set->num_keys);
+				break;
+
+			case ANY_CONTAINS_ANY:
+				fprintf(f, "%05d ANY_CONTAINS_ANY\treg#%u contains any of %u values\n",
+					id, arg1->value.numeric,
+					fvalue_needles_count(arg2->value.needles));
+				break;
+
 			case NOT:
 				fprintf(f, "%05d NOT\n", id);
 				break;
@@ -296,6 +505,16 @@ dfvm_dump(FILE *f, dfilter_t *df)
 				break;
 		}
 	}
+
+	fprintf(f, "\nEngine: ");
+	if (df->simple_hfinfo) {
+		fprintf(f, "simple (%s %s)\n", df->simple_hfinfo->abbrev,
+			df->simple_op == CHECK_EXISTS ? "exists" : "vs. constant");
+	} else if (df->code) {
+		fprintf(f, "threaded code (%u elements)\n", df->code_len);
+	} else {
+		fprintf(f, "interpreter\n");
+	}
 }
 
 /* Reads a field from the proto_tree and loads the fvalues into a register,
@@ -364,7 +583,7 @@ put_fvalue(dfilter_t *df, fvalue_t *fv, int reg)
 /* Put a constant PCRE in a register. These will not be cleared by
  * free_register_overhead. */
 static gboolean
-put_pcre(dfilter_t *df, GRegex *pcre, int reg)
+put_pcre(dfilter_t *df, fvalue_regex_t *pcre, int reg)
 {
 	df->registers[reg] = g_list_append(NULL, pcre);
 	df->owns_memory[reg] = FALSE;
@@ -403,7 +622,7 @@ any_matches(dfilter_t *df, int reg1, int reg2)
 	while (list_a) {
 		list_b = df->registers[reg2];
 		while (list_b) {
-			if (fvalue_matches((fvalue_t *)list_a->data, (GRegex *)list_b->data)) {
+			if (fvalue_matches((fvalue_t *)list_a->data, (fvalue_regex_t *)list_b->data)) {
 				return TRUE;
 			}
 			list_b = g_list_next(list_b);
@@ -444,6 +663,31 @@ any_in_range(dfilter_t *df, int reg1, int reg2, int reg3)
 	return FALSE;
 }
 
+static gboolean
+any_in_set(dfilter_t *df, int reg, const dfvm_fvalue_set_t *set)
+{
+	GList	*list;
+
+	for (list = df->registers[reg]; list; list = g_list_next(list)) {
+		if (fvalue_set_contains(set, (const fvalue_t *)list->data)) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+static gboolean
+any_contains_any(dfilter_t *df, int reg, const fvalue_needles_t *needles)
+{
+	GList	*list;
+
+	for (list = df->registers[reg]; list; list = g_list_next(list)) {
+		if (fvalue_contains_any((const fvalue_t *)list->data, needles)) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
 
 static void
 free_owned_register(gpointer data, gpointer user_data _U_)
@@ -502,6 +746,625 @@ mk_range(dfilter_t *df, int from_reg, int to_reg, drange_t *d_range)
 
 
 
+/*
+ * Threaded code.
+ *
+ * dfvm_compile() translates the instruction list of a compiled filter
+ * into an array of dfvm_code_t.  Each element has a pointer to the
+ * function that executes it, its operands already decoded, and, for
+ * jumps, a pointer to the element to jump to; executing the filter is then
+ * just a matter of calling each element's function, which returns the
+ * next element to execute, until RETURN.
+ *
+ * The common "field <relation> constant" sequence (READ_TREE of a field
+ * into a register, IF_FALSE_GOTO, and a relation between that register
+ * and a constant) is fused into a single element that compares the field's
+ * values with the constant in place, without loading them into a register.
+ */
+struct dfvm_code {
+	dfvm_code_func_t	func;
+	const dfvm_code_t	*target;	/* jump target */
+	const dfvm_insn_t	*insn;		/* (first) instruction this was compiled from */
+	header_field_info	*hfinfo;
+	FvalueCmpFunc		cmp;
+	const fvalue_t		*fvalue;	/* constant operand of fused relations */
+	const fvalue_regex_t	*pcre;		/* constant operand of fused "matches" */
+	const dfvm_fvalue_set_t	*set;		/* operand of ANY_IN_SET */
+	const fvalue_needles_t	*needles;	/* operand of ANY_CONTAINS_ANY */
+	int			reg1;
+	int			reg2;
+	int			reg3;
+};
+
+static const dfvm_code_t *
+code_check_exists(dfilter_t *df _U_, proto_tree *tree, const dfvm_code_t *code,
+		gboolean *accum)
+{
+	header_field_info	*hfinfo;
+
+	for (hfinfo = code->hfinfo; hfinfo; hfinfo = hfinfo->same_name_next) {
+		if (proto_check_for_protocol_or_field(tree, hfinfo->id)) {
+			*accum = TRUE;
+			return code + 1;
+		}
+	}
+	*accum = FALSE;
+	return code + 1;
+}
+
+static const dfvm_code_t *
+code_read_tree(dfilter_t *df, proto_tree *tree, const dfvm_code_t *code,
+		gboolean *accum)
+{
+	*accum = read_tree(df, tree, code->hfinfo, code->reg1);
+	return code + 1;
+}
+
+static const dfvm_code_t *
+code_call_function(dfilter_t *df, proto_tree *tree _U_, const dfvm_code_t *code,
+		gboolean *accum)
+{
+	GList	*param1 = NULL;
+	GList	*param2 = NULL;
+
+	if (code->insn->arg3) {
+		param1 = df->registers[code->reg2];
+	}
+	if (code->insn->arg4) {
+		param2 = df->registers[code->reg3];
+	}
+	*accum = code->insn->arg1->value.funcdef->function(param1, param2,
+			&df->registers[code->reg1]);
+	// functions create a new value, so own it.
+	df->owns_memory[code->reg1] = TRUE;
+	return code + 1;
+}
+
+static const dfvm_code_t *
+code_mk_range(dfilter_t *df, proto_tree *tree _U_, const dfvm_code_t *code,
+		gboolean *accum _U_)
+{
+	mk_range(df, code->reg1, code->reg2, code->insn->arg3->value.drange);
+	return code + 1;
+}
+
+static const dfvm_code_t *
+code_any_test(dfilter_t *df, proto_tree *tree _U_, const dfvm_code_t *code,
+		gboolean *accum)
+{
+	*accum = any_test(df, code->cmp, code->reg1, code->reg2);
+	return code + 1;
+}
+
+static const dfvm_code_t *
+code_any_matches(dfilter_t *df, proto_tree *tree _U_, const dfvm_code_t *code,
+		gboolean *accum)
+{
+	*accum = any_matches(df, code->reg1, code->reg2);
+	return code + 1;
+}
+
+static const dfvm_code_t *
+code_any_in_range(dfilter_t *df, proto_tree *tree _U_, const dfvm_code_t *code,
+		gboolean *accum)
+{
+	*accum = any_in_range(df, code->reg1, code->reg2, code->reg3);
+	return code + 1;
+}
+
+static const dfvm_code_t *
+code_any_in_set(dfilter_t *df, proto_tree *tree _U_, const dfvm_code_t *code,
+		gboolean *accum)
+{
+	*accum = any_in_set(df, code->reg1, code->set);
+	return code + 1;
+}
+
+static const dfvm_code_t *
+code_any_contains_any(dfilter_t *df, proto_tree *tree _U_, const dfvm_code_t *code,
+		gboolean *accum)
+{
+	*accum = any_contains_any(df, code->reg1, code->needles);
+	return code + 1;
+}
+
+static const dfvm_code_t *
+code_not(dfilter_t *df _U_, proto_tree *tree _U_, const dfvm_code_t *code,
+		gboolean *accum)
+{
+	*accum = !*accum;
+	return code + 1;
+}
+
+static const dfvm_code_t *
+code_return(dfilter_t *df _U_, proto_tree *tree _U_, const dfvm_code_t *code _U_,
+		gboolean *accum _U_)
+{
+	return NULL;
+}
+
+static const dfvm_code_t *
+code_if_true_goto(dfilter_t *df _U_, proto_tree *tree _U_, const dfvm_code_t *code,
+		gboolean *accum)
+{
+	return *accum ? code->target : code + 1;
+}
+
+static const dfvm_code_t *
+code_if_false_goto(dfilter_t *df _U_, proto_tree *tree _U_, const dfvm_code_t *code,
+		gboolean *accum)
+{
+	return *accum ? code + 1 : code->target;
+}
+
+/* READ_TREE, IF_FALSE_GOTO and ANY_xxx of the field with a constant. */
+static const dfvm_code_t *
+code_field_test_const(dfilter_t *df _U_, proto_tree *tree, const dfvm_code_t *code,
+		gboolean *accum)
+{
+	header_field_info	*hfinfo;
+	GPtrArray		*finfos;
+	gboolean		found_something = FALSE;
+	guint			i;
+
+	for (hfinfo = code->hfinfo; hfinfo; hfinfo = hfinfo->same_name_next) {
+		finfos = proto_get_finfo_ptr_array(tree, hfinfo->id);
+		if (finfos == NULL || finfos->len == 0)
+			continue;
+		found_something = TRUE;
+		for (i = 0; i < finfos->len; i++) {
+			field_info *finfo = (field_info *)g_ptr_array_index(finfos, i);
+			if (code->cmp(&finfo->value, code->fvalue)) {
+				*accum = TRUE;
+				return code + 1;
+			}
+		}
+	}
+	*accum = FALSE;
+	/* Not finding the field at all takes the IF_FALSE_GOTO. */
+	return found_something ? code + 1 : code->target;
+}
+
+/* READ_TREE, IF_FALSE_GOTO and ANY_MATCHES of the field with a constant. */
+static const dfvm_code_t *
+code_field_matches_const(dfilter_t *df _U_, proto_tree *tree, const dfvm_code_t *code,
+		gboolean *accum)
+{
+	header_field_info	*hfinfo;
+	GPtrArray		*finfos;
+	gboolean		found_something = FALSE;
+	guint			i;
+
+	for (hfinfo = code->hfinfo; hfinfo; hfinfo = hfinfo->same_name_next) {
+		finfos = proto_get_finfo_ptr_array(tree, hfinfo->id);
+		if (finfos == NULL || finfos->len == 0)
+			continue;
+		found_something = TRUE;
+		for (i = 0; i < finfos->len; i++) {
+			field_info *finfo = (field_info *)g_ptr_array_index(finfos, i);
+			if (fvalue_matches(&finfo->value, code->pcre)) {
+				*accum = TRUE;
+				return code + 1;
+			}
+		}
+	}
+	*accum = FALSE;
+	return found_something ? code + 1 : code->target;
+}
+
+static FvalueCmpFunc
+relation_cmp_func(dfvm_opcode_t op)
+{
+	switch (op) {
+		case ANY_EQ:
+			return fvalue_eq;
+		case ANY_NE:
+			return fvalue_ne;
+		case ANY_GT:
+			return fvalue_gt;
+		case ANY_GE:
+			return fvalue_ge;
+		case ANY_LT:
+			return fvalue_lt;
+		case ANY_LE:
+			return fvalue_le;
+		case ANY_BITWISE_AND:
+			return fvalue_bitwise_and;
+		case ANY_CONTAINS:
+			return fvalue_contains;
+		default:
+			return NULL;
+	}
+}
+
+/* Counts the uses of each register other than loading it from the tree. */
+static void
+count_register_uses(dfvm_value_t *arg, int *uses)
+{
+	if (arg && arg->type == REGISTER) {
+		uses[arg->value.numeric]++;
+	}
+}
+
+/*
+ * Can instructions id, id+1 and id+2 be fused into a single element that
+ * tests a field against a constant?
+ */
+static gboolean
+can_fuse_field_test(dfilter_t *df, int id, const gboolean *is_target,
+		const int *reg_uses)
+{
+	dfvm_insn_t	*read, *jmp, *test;
+	int		reg;
+
+	if (id + 2 >= (int)df->insns->len)
+		return FALSE;
+
+	read = (dfvm_insn_t *)g_ptr_array_index(df->insns, id);
+	jmp = (dfvm_insn_t *)g_ptr_array_index(df->insns, id + 1);
+	test = (dfvm_insn_t *)g_ptr_array_index(df->insns, id + 2);
+
+	if (read->op != READ_TREE || jmp->op != IF_FALSE_GOTO)
+		return FALSE;
+	if (test->op != ANY_MATCHES && relation_cmp_func(test->op) == NULL)
+		return FALSE;
+
+	/* Nothing may jump into the middle of the sequence. */
+	if (is_target[id + 1] || is_target[id + 2])
+		return FALSE;
+
+	/* The relation must be between the field and a constant... */
+	reg = read->arg2->value.numeric;
+	if ((int)test->arg1->value.numeric != reg ||
+	    test->arg2->value.numeric < df->num_registers)
+		return FALSE;
+
+	/* ...and nothing else may use the register, as we won't load it. */
+	if (reg_uses[reg] != 1)
+		return FALSE;
+
+	return TRUE;
+}
+
+gboolean
+dfvm_compile(dfilter_t *df)
+{
+	int		id, length, num_code, target;
+	dfvm_insn_t	*insn;
+	int		*code_index;
+	gboolean	*is_target;
+	int		*reg_uses;
+	gboolean	*fused;
+	dfvm_code_t	*code, *c;
+	gboolean	ok = TRUE;
+
+	length = df->insns->len;
+	if (length == 0)
+		return FALSE;
+
+	code_index = g_new(int, length);
+	is_target = g_new0(gboolean, length);
+	reg_uses = g_new0(int, df->max_registers);
+	fused = g_new0(gboolean, length);
+
+	/* Find the jump targets and the register uses. */
+	for (id = 0; id < length; id++) {
+		insn = (dfvm_insn_t *)g_ptr_array_index(df->insns, id);
+		if (insn->op == IF_TRUE_GOTO || insn->op == IF_FALSE_GOTO) {
+			target = insn->arg1->value.numeric;
+			if (target < 0 || target >= length) {
+				ok = FALSE;
+				break;
+			}
+			is_target[target] = TRUE;
+		}
+		if (insn->op != READ_TREE) {
+			count_register_uses(insn->arg1, reg_uses);
+			count_register_uses(insn->arg2, reg_uses);
+			count_register_uses(insn->arg3, reg_uses);
+			count_register_uses(insn->arg4, reg_uses);
+		}
+	}
+
+	/* Decide what to fuse, and where each instruction's code goes. */
+	num_code = 0;
+	for (id = 0; ok && id < length; id++) {
+		code_index[id] = num_code;
+		if (can_fuse_field_test(df, id, is_target, reg_uses)) {
+			fused[id] = TRUE;
+			code_index[id + 1] = num_code;
+			code_index[id + 2] = num_code;
+			id += 2;
+		}
+		num_code++;
+	}
+
+	code = g_new0(dfvm_code_t, ok ? num_code : 1);
+	for (id = 0, c = code; ok && id < length; id++, c++) {
+		insn = (dfvm_insn_t *)g_ptr_array_index(df->insns, id);
+		c->insn = insn;
+
+		if (fused[id]) {
+			dfvm_insn_t *jmp = (dfvm_insn_t *)g_ptr_array_index(df->insns, id + 1);
+			dfvm_insn_t *test = (dfvm_insn_t *)g_ptr_array_index(df->insns, id + 2);
+			GList *constant = df->registers[test->arg2->value.numeric];
+
+			c->hfinfo = insn->arg1->value.hfinfo;
+			c->target = &code[code_index[jmp->arg1->value.numeric]];
+			if (test->op == ANY_MATCHES) {
+				c->func = code_field_matches_const;
+				c->pcre = (const fvalue_regex_t *)constant->data;
+			} else {
+				c->func = code_field_test_const;
+				c->cmp = relation_cmp_func(test->op);
+				c->fvalue = (const fvalue_t *)constant->data;
+			}
+			id += 2;
+			continue;
+		}
+
+		switch (insn->op) {
+			case CHECK_EXISTS:
+				c->func = code_check_exists;
+				c->hfinfo = insn->arg1->value.hfinfo;
+				break;
+
+			case READ_TREE:
+				c->func = code_read_tree;
+				c->hfinfo = insn->arg1->value.hfinfo;
+				c->reg1 = insn->arg2->value.numeric;
+				break;
+
+			case CALL_FUNCTION:
+				c->func = code_call_function;
+				c->reg1 = insn->arg2->value.numeric;
+				if (insn->arg3)
+					c->reg2 = insn->arg3->value.numeric;
+				if (insn->arg4)
+					c->reg3 = insn->arg4->value.numeric;
+				break;
+
+			case MK_RANGE:
+				c->func = code_mk_range;
+				c->reg1 = insn->arg1->value.numeric;
+				c->reg2 = insn->arg2->value.numeric;
+				break;
+
+			case ANY_EQ:
+			case ANY_NE:
+			case ANY_GT:
+			case ANY_GE:
+			case ANY_LT:
+			case ANY_LE:
+			case ANY_BITWISE_AND:
+			case ANY_CONTAINS:
+				c->func = code_any_test;
+				c->cmp = relation_cmp_func(insn->op);
+				c->reg1 = insn->arg1->value.numeric;
+				c->reg2 = insn->arg2->value.numeric;
+				break;
+
+			case ANY_MATCHES:
+				c->func = code_any_matches;
+				c->reg1 = insn->arg1->value.numeric;
+				c->reg2 = insn->arg2->value.numeric;
+				break;
+
+			case ANY_IN_RANGE:
+				c->func = code_any_in_range;
+				c->reg1 = insn->arg1->value.numeric;
+				c->reg2 = insn->arg2->value.numeric;
+				c->reg3 = insn->arg3->value.numeric;
+				break;
+
+			case ANY_IN_SET:
+				c->func = code_any_in_set;
+				c->reg1 = insn->arg1->value.numeric;
+				c->set = insn->arg2->value.fvalue_set;
+				break;
+
+			case ANY_CONTAINS_ANY:
+				c->func = code_any_contains_any;
+				c->reg1 = insn->arg1->value.numeric;
+				c->needles = insn->arg2->value.needles;
+				break;
+
+			case NOT:
+				c->func = code_not;
+				break;
+
+			case RETURN:
+				c->func = code_return;
+				break;
+
+			case IF_TRUE_GOTO:
+				c->func = code_if_true_goto;
+				c->target = &code[code_index[insn->arg1->value.numeric]];
+				break;
+
+			case IF_FALSE_GOTO:
+				c->func = code_if_false_goto;
+				c->target = &code[code_index[insn->arg1->value.numeric]];
+				break;
+
+			default:
+				/* Leave this filter to the interpreter. */
+				ok = FALSE;
+				break;
+		}
+	}
+
+	g_free(code_index);
+	g_free(is_target);
+	g_free(reg_uses);
+	g_free(fused);
+
+	if (!ok) {
+		g_free(code);
+		return FALSE;
+	}
+
+	df->code = code;
+	df->code_len = num_code;
+	return TRUE;
+}
+
+void
+dfvm_code_free(dfilter_t *df)
+{
+	g_free(df->code);
+	df->code = NULL;
+	df->code_len = 0;
+}
+
+/*
+ * Filters that are just "field", or "field <relation> constant" for a field
+ * with an integral type, are common enough to be worth running without
+ * executing any instructions: we check for the field, or compare its
+ * values with the constant, straight from the finfo array.
+ */
+dfvm_simple_storage_t
+dfvm_simple_storage(ftenum_t ftype)
+{
+	/* FT_BOOLEAN is stored as an integer, but compares differently. */
+	if (IS_FT_UINT32(ftype))
+		return DFVM_SIMPLE_UINT;
+	if (IS_FT_INT32(ftype))
+		return DFVM_SIMPLE_SINT;
+	if (IS_FT_UINT64(ftype))
+		return DFVM_SIMPLE_UINT64;
+	if (IS_FT_INT64(ftype))
+		return DFVM_SIMPLE_SINT64;
+	return DFVM_SIMPLE_NONE;
+}
+
+void
+dfvm_init_simple(dfilter_t *df, header_field_info *hfinfo, dfvm_opcode_t op)
+{
+	dfvm_insn_t	*insn;
+	fvalue_t	*fv;
+
+	df->simple_hfinfo = hfinfo;
+	df->simple_op = op;
+	df->simple_storage = DFVM_SIMPLE_NONE;
+	if (op == CHECK_EXISTS)
+		return;
+
+	g_assert(df->consts->len == 1);
+	insn = (dfvm_insn_t *)g_ptr_array_index(df->consts, 0);
+	g_assert(insn->op == PUT_FVALUE);
+	fv = insn->arg1->value.fvalue;
+
+	df->simple_storage = dfvm_simple_storage(fvalue_type_ftenum(fv));
+	switch (df->simple_storage) {
+		case DFVM_SIMPLE_UINT:
+			df->simple_uvalue = fv->value.uinteger;
+			break;
+		case DFVM_SIMPLE_SINT:
+			df->simple_svalue = fv->value.sinteger;
+			break;
+		case DFVM_SIMPLE_UINT64:
+			df->simple_uvalue = fv->value.uinteger64;
+			break;
+		case DFVM_SIMPLE_SINT64:
+			df->simple_svalue = fv->value.sinteger64;
+			break;
+		case DFVM_SIMPLE_NONE:
+		default:
+			/* dfw_check_simple() shouldn't have let this through. */
+			g_assert_not_reached();
+	}
+}
+
+static inline gboolean
+simple_cmp_uint(int op, guint64 a, guint64 b)
+{
+	switch (op) {
+		case ANY_EQ:	return a == b;
+		case ANY_NE:	return a != b;
+		case ANY_GT:	return a > b;
+		case ANY_GE:	return a >= b;
+		case ANY_LT:	return a < b;
+		case ANY_LE:	return a <= b;
+		default:
+			g_assert_not_reached();
+			return FALSE;
+	}
+}
+
+static inline gboolean
+simple_cmp_sint(int op, gint64 a, gint64 b)
+{
+	switch (op) {
+		case ANY_EQ:	return a == b;
+		case ANY_NE:	return a != b;
+		case ANY_GT:	return a > b;
+		case ANY_GE:	return a >= b;
+		case ANY_LT:	return a < b;
+		case ANY_LE:	return a <= b;
+		default:
+			g_assert_not_reached();
+			return FALSE;
+	}
+}
+
+static gboolean
+simple_test(const dfilter_t *df, const fvalue_t *fv)
+{
+	switch (df->simple_storage) {
+		case DFVM_SIMPLE_UINT:
+			return simple_cmp_uint(df->simple_op, fv->value.uinteger, df->simple_uvalue);
+		case DFVM_SIMPLE_SINT:
+			return simple_cmp_sint(df->simple_op, fv->value.sinteger, df->simple_svalue);
+		case DFVM_SIMPLE_UINT64:
+			return simple_cmp_uint(df->simple_op, fv->value.uinteger64, df->simple_uvalue);
+		case DFVM_SIMPLE_SINT64:
+			return simple_cmp_sint(df->simple_op, fv->value.sinteger64, df->simple_svalue);
+		default:
+			g_assert_not_reached();
+			return FALSE;
+	}
+}
+
+static gboolean
+dfvm_apply_simple(dfilter_t *df, proto_tree *tree)
+{
+	header_field_info	*hfinfo;
+	GPtrArray		*finfos;
+	guint			i;
+
+	for (hfinfo = df->simple_hfinfo; hfinfo; hfinfo = hfinfo->same_name_next) {
+		if (df->simple_op == CHECK_EXISTS) {
+			if (proto_check_for_protocol_or_field(tree, hfinfo->id))
+				return TRUE;
+			continue;
+		}
+		finfos = proto_get_finfo_ptr_array(tree, hfinfo->id);
+		if (finfos == NULL)
+			continue;
+		for (i = 0; i < finfos->len; i++) {
+			field_info *finfo = (field_info *)g_ptr_array_index(finfos, i);
+			if (simple_test(df, &finfo->value))
+				return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+static gboolean
+dfvm_apply_code(dfilter_t *df, proto_tree *tree)
+{
+	const dfvm_code_t	*code = df->code;
+	gboolean		accum = TRUE;
+
+	do {
+		code = code->func(df, tree, code, &accum);
+	} while (code != NULL);
+
+	free_register_overhead(df);
+	return accum;
+}
+
 gboolean
 dfvm_apply(dfilter_t *df, proto_tree *tree)
 {
@@ -518,6 +1381,14 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 
 	g_assert(tree);
 
+	if (df->simple_hfinfo) {
+		return dfvm_apply_simple(df, tree);
+	}
+
+	if (df->code) {
+		return dfvm_apply_code(df, tree);
+	}
+
 	length = df->insns->len;
 
 	for (id = 0; id < length; id++) {
@@ -623,6 +1494,16 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 						arg3->value.numeric);
 				break;
 
+			case ANY_IN_SET:
+				accum = any_in_set(df, arg1->value.numeric,
+						arg2->value.fvalue_set);
+				break;
+
+			case ANY_CONTAINS_ANY:
+				accum = any_contains_any(df, arg1->value.numeric,
+						arg2->value.needles);
+				break;
+
 			case NOT:
 				accum = !accum;
 				break;
@@ -710,6 +1591,8 @@ dfvm_init_const(dfilter_t *df)
 			case ANY_CONTAINS:
 			case ANY_MATCHES:
 			case ANY_IN_RANGE:
+			case ANY_IN_SET:
+			case ANY_CONTAINS_ANY:
 			case NOT:
 			case RETURN:
 			case IF_TRUE_GOTO:
@@ -24,9 +24,15 @@ typedef enum {
 	INTEGER,
 	DRANGE,
 	FUNCTION_DEF,
-	PCRE
+	PCRE,
+	FVALUE_SET,
+	NEEDLES
 } dfvm_value_type_t;
 
+/* A set of constants that ANY_IN_SET tests the values of a register
+ * against; see dfvm_fvalue_set_new(). */
+typedef struct dfvm_fvalue_set dfvm_fvalue_set_t;
+
 typedef struct {
 	dfvm_value_type_t	type;
 
@@ -36,7 +42,9 @@ typedef struct {
 		drange_t		*drange;
 		header_field_info	*hfinfo;
 		df_func_def_t		*funcdef;
-		GRegex			*pcre;
+		fvalue_regex_t		*pcre;
+		dfvm_fvalue_set_t	*fvalue_set;
+		fvalue_needles_t	*needles;
 	} value;
 
 } dfvm_value_t;
@@ -63,7 +71,9 @@ typedef enum {
 	ANY_MATCHES,
 	MK_RANGE,
 	CALL_FUNCTION,
-	ANY_IN_RANGE
+	ANY_IN_RANGE,
+	ANY_IN_SET,
+	ANY_CONTAINS_ANY
 
 } dfvm_opcode_t;
 
@@ -88,9 +98,54 @@ dfvm_value_new(dfvm_value_type_t type);
 void
 dfvm_dump(FILE *f, dfilter_t *df);
 
+/* Can fv be looked up in a set, rather than compared with each of its
+ * elements in turn? */
+gboolean
+dfvm_fvalue_set_can_hold(const fvalue_t *fv);
+
+/* Make a set of fvalues, which must all be of the same type and accepted
+ * by dfvm_fvalue_set_can_hold(); the set takes the array and the values. */
+dfvm_fvalue_set_t *
+dfvm_fvalue_set_new(GPtrArray *fvalues);
+
+/* How the values of a field are stored, for filters run by
+ * dfvm_apply_simple(). */
+typedef enum {
+	DFVM_SIMPLE_NONE,
+	DFVM_SIMPLE_UINT,
+	DFVM_SIMPLE_SINT,
+	DFVM_SIMPLE_UINT64,
+	DFVM_SIMPLE_SINT64
+} dfvm_simple_storage_t;
+
+dfvm_simple_storage_t
+dfvm_simple_storage(ftenum_t ftype);
+
+/* Set up df to be run without executing its instructions; hfinfo is the
+ * field, and op is CHECK_EXISTS or the relation between the field and the
+ * filter's only constant. */
+void
+dfvm_init_simple(dfilter_t *df, header_field_info *hfinfo, dfvm_opcode_t op);
+
+/* Compiled form of a filter's instructions; see dfvm_compile(). */
+typedef struct dfvm_code dfvm_code_t;
+
+typedef const dfvm_code_t *(*dfvm_code_func_t)(dfilter_t *df, proto_tree *tree,
+		const dfvm_code_t *code, gboolean *accum);
+
 gboolean
 dfvm_apply(dfilter_t *df, proto_tree *tree);
 
+/* Translate the instructions of df into threaded code that dfvm_apply()
+ * runs instead of interpreting them.  Must be called after
+ * dfvm_init_const().  Returns FALSE, leaving the filter to the
+ * interpreter, if the instructions can't be translated. */
+gboolean
+dfvm_compile(dfilter_t *df);
+
+void
+dfvm_code_free(dfilter_t *df);
+
 void
 dfvm_init_const(dfilter_t *df);
 
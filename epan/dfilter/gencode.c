@@ -8,6 +8,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include "dfilter-int.h"
 #include "gencode.h"
 #include "dfvm.h"
@@ -233,7 +235,7 @@ dfw_append_function(dfwork_t *dfw, stnode_t *node, dfvm_value_t **p_jmp)
 
 /* returns register number */
 static int
-dfw_append_put_pcre(dfwork_t *dfw, GRegex *pcre)
+dfw_append_put_pcre(dfwork_t *dfw, fvalue_regex_t *pcre)
 {
 	dfvm_insn_t	*insn;
 	dfvm_value_t	*val1, *val2;
@@ -308,10 +310,66 @@ fixup_jumps(gpointer data, gpointer user_data)
 	}
 }
 
-/* Generate the code for the in operator.  It behaves much like an OR-ed
- * series of == tests, but without the redundant existence checks. */
+/* Sets with at least this many constants that can be looked up by key
+ * are tested with a single ANY_IN_SET, rather than one ANY_EQ each. */
+#define MIN_FVALUE_SET_SIZE	8
+
+/* Sets with at least this many strings that can be looked for together
+ * are tested with a single ANY_CONTAINS_ANY, rather than one ANY_CONTAINS
+ * each. */
+#define MIN_NEEDLES_SIZE	2
+
+/* Take the constants of a set that can_hold accepts out of its nodes, if
+ * there are at least min_count of them; returns NULL, leaving the nodes
+ * alone, if there aren't. */
+static GPtrArray *
+steal_set_fvalues(GSList *nodelist, gboolean (*can_hold)(const fvalue_t *),
+		guint min_count)
+{
+	GSList		*l;
+	stnode_t	*node1, *node2;
+	fvalue_t	*fv;
+	ftenum_t	ftype = FT_NONE;
+	guint		count = 0;
+	GPtrArray	*fvalues;
+
+	for (l = nodelist; l; l = g_slist_next(g_slist_next(l))) {
+		node1 = (stnode_t*)l->data;
+		node2 = (stnode_t*)g_slist_next(l)->data;
+		if (node2 || stnode_type_id(node1) != STTYPE_FVALUE)
+			continue;
+		fv = (fvalue_t*)stnode_data(node1);
+		if (!can_hold(fv))
+			continue;
+		if (count == 0)
+			ftype = fvalue_type_ftenum(fv);
+		else if (fvalue_type_ftenum(fv) != ftype)
+			continue;
+		count++;
+	}
+	if (count < min_count)
+		return NULL;
+
+	fvalues = g_ptr_array_sized_new(count);
+	for (l = nodelist; l; l = g_slist_next(g_slist_next(l))) {
+		node1 = (stnode_t*)l->data;
+		node2 = (stnode_t*)g_slist_next(l)->data;
+		if (node2 || stnode_type_id(node1) != STTYPE_FVALUE)
+			continue;
+		fv = (fvalue_t*)stnode_data(node1);
+		if (!can_hold(fv) || fvalue_type_ftenum(fv) != ftype)
+			continue;
+		g_ptr_array_add(fvalues, stnode_steal_data(node1));
+	}
+	return fvalues;
+}
+
+/* Generate the code for the in and contains any operators.  They behave
+ * much like an OR-ed series of == or contains tests, but without the
+ * redundant existence checks; the constants that can be are looked up in
+ * a hashed set, or looked for in a single pass, instead. */
 static void
-gen_relation_in(dfwork_t *dfw, stnode_t *st_arg1, stnode_t *st_arg2)
+gen_relation_in(dfwork_t *dfw, test_op_t st_op, stnode_t *st_arg1, stnode_t *st_arg2)
 {
 	dfvm_insn_t	*insn;
 	dfvm_value_t	*val1, *val2, *val3;
@@ -320,12 +378,19 @@ gen_relation_in(dfwork_t *dfw, stnode_t *st_arg1, stnode_t *st_arg2)
 	stnode_t	*node1, *node2;
 	GSList		*nodelist_head, *nodelist;
 	GSList		*jumplist = NULL;
+	GPtrArray	*set_fvalues;
 
 	/* Create code for the LHS of the relation */
 	reg1 = gen_entity(dfw, st_arg1, &jmp1);
 
 	/* Create code for the set on the RHS of the relation */
 	nodelist_head = nodelist = (GSList*)stnode_steal_data(st_arg2);
+	if (st_op == TEST_OP_CONTAINS_ANY)
+		set_fvalues = steal_set_fvalues(nodelist_head,
+				fvalue_needles_can_hold, MIN_NEEDLES_SIZE);
+	else
+		set_fvalues = steal_set_fvalues(nodelist_head,
+				dfvm_fvalue_set_can_hold, MIN_FVALUE_SET_SIZE);
 	while (nodelist) {
 		node1 = (stnode_t*)nodelist->data;
 		nodelist = g_slist_next(nodelist);
@@ -351,18 +416,23 @@ gen_relation_in(dfwork_t *dfw, stnode_t *st_arg1, stnode_t *st_arg2)
 			insn->arg2 = val2;
 			insn->arg3 = val3;
 			dfw_append_insn(dfw, insn);
+		} else if (stnode_data(node1) == NULL) {
+			/* Constant taken into the set. */
+			continue;
 		} else {
 			int	reg2;
 
-			/* Normal element: add equality test. */
+			/* Normal element: add equality or contains test. */
 			reg2 = gen_entity(dfw, node1, &jmp2);
 
 			/* Add test to see if the item matches */
-			gen_relation_regs(dfw, ANY_EQ, reg1, reg2);
+			gen_relation_regs(dfw,
+					st_op == TEST_OP_CONTAINS_ANY ? ANY_CONTAINS : ANY_EQ,
+					reg1, reg2);
 		}
 
 		/* Exit as soon as we find a match */
-		if (nodelist) {
+		if (nodelist || set_fvalues) {
 			insn = dfvm_insn_new(IF_TRUE_GOTO);
 			val1 = dfvm_value_new(INSN_NUMBER);
 			insn->arg1 = val1;
@@ -381,6 +451,27 @@ gen_relation_in(dfwork_t *dfw, stnode_t *st_arg1, stnode_t *st_arg2)
 		}
 	}
 
+	/* Test the constants taken into the set last, with a lookup. */
+	if (set_fvalues && st_op == TEST_OP_CONTAINS_ANY) {
+		insn = dfvm_insn_new(ANY_CONTAINS_ANY);
+		val1 = dfvm_value_new(REGISTER);
+		val1->value.numeric = reg1;
+		val2 = dfvm_value_new(NEEDLES);
+		val2->value.needles = fvalue_needles_new(set_fvalues);
+		insn->arg1 = val1;
+		insn->arg2 = val2;
+		dfw_append_insn(dfw, insn);
+	} else if (set_fvalues) {
+		insn = dfvm_insn_new(ANY_IN_SET);
+		val1 = dfvm_value_new(REGISTER);
+		val1->value.numeric = reg1;
+		val2 = dfvm_value_new(FVALUE_SET);
+		val2->value.fvalue_set = dfvm_fvalue_set_new(set_fvalues);
+		insn->arg1 = val1;
+		insn->arg2 = val2;
+		dfw_append_insn(dfw, insn);
+	}
+
 	/* Jump here if the LHS entity was not present */
 	if (jmp1) {
 		jmp1->value.numeric = dfw->next_insn_id;
@@ -426,7 +517,7 @@ gen_entity(dfwork_t *dfw, stnode_t *st_arg, dfvm_value_t **p_jmp)
 		reg = dfw_append_function(dfw, st_arg, p_jmp);
 	}
 	else if (e_type == STTYPE_PCRE) {
-		reg = dfw_append_put_pcre(dfw, (GRegex *)stnode_steal_data(st_arg));
+		reg = dfw_append_put_pcre(dfw, (fvalue_regex_t *)stnode_steal_data(st_arg));
 	}
 	else {
 		/* printf("sttype_id is %u\n", (unsigned)e_type); */
@@ -543,7 +634,8 @@ gen_test(dfwork_t *dfw, stnode_t *st_node)
 			break;
 
 		case TEST_OP_IN:
-			gen_relation_in(dfw, st_arg1, st_arg2);
+		case TEST_OP_CONTAINS_ANY:
+			gen_relation_in(dfw, st_op, st_arg1, st_arg2);
 			break;
 	}
 }
@@ -565,6 +657,79 @@ gencode(dfwork_t *dfw, stnode_t *st_node)
 }
 
 
+/*
+ * Is the filter just "field", or "field <relation> constant" for a field
+ * with an integral type?  If so, note the field and the relation, so that
+ * dfvm_apply() can run the filter without executing its instructions.
+ */
+static void
+dfw_check_simple(dfwork_t *dfw, stnode_t *st_node)
+{
+	test_op_t		st_op;
+	stnode_t		*st_arg1, *st_arg2;
+	header_field_info	*hfinfo, *hf;
+	dfvm_opcode_t		op;
+	dfvm_simple_storage_t	storage;
+
+	dfw->simple_hfinfo = NULL;
+
+	if (stnode_type_id(st_node) != STTYPE_TEST)
+		return;
+
+	sttype_test_get(st_node, &st_op, &st_arg1, &st_arg2);
+	switch (st_op) {
+		case TEST_OP_EXISTS:
+			op = CHECK_EXISTS;
+			break;
+		case TEST_OP_EQ:
+			op = ANY_EQ;
+			break;
+		case TEST_OP_NE:
+			op = ANY_NE;
+			break;
+		case TEST_OP_GT:
+			op = ANY_GT;
+			break;
+		case TEST_OP_GE:
+			op = ANY_GE;
+			break;
+		case TEST_OP_LT:
+			op = ANY_LT;
+			break;
+		case TEST_OP_LE:
+			op = ANY_LE;
+			break;
+		default:
+			return;
+	}
+
+	if (stnode_type_id(st_arg1) != STTYPE_FIELD)
+		return;
+	if (op != CHECK_EXISTS && stnode_type_id(st_arg2) != STTYPE_FVALUE)
+		return;
+
+	/* Rewind to find the first field of this name. */
+	hfinfo = (header_field_info*)stnode_data(st_arg1);
+	while (hfinfo->same_name_prev_id != -1) {
+		hfinfo = proto_registrar_get_nth(hfinfo->same_name_prev_id);
+	}
+
+	if (op != CHECK_EXISTS) {
+		/* All the fields with this name have to store their
+		 * values the same way. */
+		storage = dfvm_simple_storage(hfinfo->type);
+		if (storage == DFVM_SIMPLE_NONE)
+			return;
+		for (hf = hfinfo->same_name_next; hf; hf = hf->same_name_next) {
+			if (dfvm_simple_storage(hf->type) != storage)
+				return;
+		}
+	}
+
+	dfw->simple_hfinfo = hfinfo;
+	dfw->simple_op = op;
+}
+
 void
 dfw_gencode(dfwork_t *dfw)
 {
@@ -576,6 +741,7 @@ dfw_gencode(dfwork_t *dfw)
 	dfw->consts = g_ptr_array_new();
 	dfw->loaded_fields = g_hash_table_new(g_direct_hash, g_direct_equal);
 	dfw->interesting_fields = g_hash_table_new(g_direct_hash, g_direct_equal);
+	dfw_check_simple(dfw, dfw->st_root);
 	gencode(dfw, dfw->st_root);
 	dfw_append_insn(dfw, dfvm_insn_new(RETURN));
 
@@ -669,6 +835,150 @@ get_hash_key(gpointer key, gpointer value _U_, gpointer user_data)
 	hki->i++;
 }
 
+/*
+ * Find the protocol a field belongs to, for the purpose of working out
+ * which protocols have to be in a frame for a filter to match it.
+ * Returns -1 if we shouldn't rely on it.
+ */
+static int
+field_protocol(header_field_info *hfinfo)
+{
+	header_field_info	*hf;
+	int			proto_id;
+
+	/* Rewind to find the first field of this name. */
+	while (hfinfo->same_name_prev_id != -1) {
+		hfinfo = proto_registrar_get_nth(hfinfo->same_name_prev_id);
+	}
+
+	proto_id = (hfinfo->parent == -1) ? hfinfo->id : hfinfo->parent;
+	for (hf = hfinfo->same_name_next; hf; hf = hf->same_name_next) {
+		if (((hf->parent == -1) ? hf->id : hf->parent) != proto_id)
+			return -1;
+	}
+
+	/* The "_ws" pseudo-protocols and "frame" aren't dissector layers. */
+	hf = proto_registrar_get_nth(proto_id);
+	if (strncmp(hf->abbrev, "_ws", 3) == 0 || strcmp(hf->abbrev, "frame") == 0)
+		return -1;
+
+	return proto_id;
+}
+
+static gint
+compare_protocols(gconstpointer a, gconstpointer b)
+{
+	return *(const int *)a - *(const int *)b;
+}
+
+static void
+add_required_protocol(GArray *protos, stnode_t *st_arg)
+{
+	int	proto_id;
+	guint	i;
+
+	if (st_arg == NULL || stnode_type_id(st_arg) != STTYPE_FIELD)
+		return;
+
+	proto_id = field_protocol((header_field_info *)stnode_data(st_arg));
+	if (proto_id == -1)
+		return;
+	for (i = 0; i < protos->len; i++) {
+		if (g_array_index(protos, int, i) == proto_id)
+			return;
+	}
+	g_array_append_val(protos, proto_id);
+	g_array_sort(protos, compare_protocols);
+}
+
+/*
+ * Return the sorted set of protocols that have to be present in a
+ * frame for the (sub)expression to be true.  It's conservative: a
+ * protocol not in the set might still be required.
+ */
+static GArray *
+required_protocols(stnode_t *st_node)
+{
+	test_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+	GArray		*protos, *protos1, *protos2;
+	guint		i, j;
+
+	protos = g_array_new(FALSE, FALSE, sizeof(int));
+	if (stnode_type_id(st_node) != STTYPE_TEST)
+		return protos;
+
+	sttype_test_get(st_node, &st_op, &st_arg1, &st_arg2);
+	switch (st_op) {
+		case TEST_OP_AND:
+		case TEST_OP_OR:
+			protos1 = required_protocols(st_arg1);
+			protos2 = required_protocols(st_arg2);
+			for (i = 0, j = 0; i < protos1->len || j < protos2->len; ) {
+				int p1 = (i < protos1->len) ? g_array_index(protos1, int, i) : G_MAXINT;
+				int p2 = (j < protos2->len) ? g_array_index(protos2, int, j) : G_MAXINT;
+
+				/* Both sides of an AND have to be true, so it
+				 * needs what either needs; only one side of an OR
+				 * has to be, so it needs only what both need. */
+				if (p1 == p2) {
+					g_array_append_val(protos, p1);
+					i++;
+					j++;
+				} else if (p1 < p2) {
+					if (st_op == TEST_OP_AND)
+						g_array_append_val(protos, p1);
+					i++;
+				} else {
+					if (st_op == TEST_OP_AND)
+						g_array_append_val(protos, p2);
+					j++;
+				}
+			}
+			g_array_free(protos1, TRUE);
+			g_array_free(protos2, TRUE);
+			break;
+
+		case TEST_OP_EXISTS:
+		case TEST_OP_EQ:
+		case TEST_OP_NE:
+		case TEST_OP_GT:
+		case TEST_OP_GE:
+		case TEST_OP_LT:
+		case TEST_OP_LE:
+		case TEST_OP_BITWISE_AND:
+		case TEST_OP_CONTAINS:
+		case TEST_OP_MATCHES:
+		case TEST_OP_IN:
+		case TEST_OP_CONTAINS_ANY:
+			/* These are false if a field isn't there. */
+			add_required_protocol(protos, st_arg1);
+			if (st_op != TEST_OP_EXISTS && st_op != TEST_OP_IN &&
+			    st_op != TEST_OP_CONTAINS_ANY)
+				add_required_protocol(protos, st_arg2);
+			break;
+
+		default:
+			/* Including NOT, which is true if the fields aren't there. */
+			break;
+	}
+	return protos;
+}
+
+int*
+dfw_required_protocols(dfwork_t *dfw, int *caller_num_protos)
+{
+	GArray	*protos;
+
+	protos = required_protocols(dfw->st_root);
+	*caller_num_protos = protos->len;
+	if (protos->len == 0) {
+		g_array_free(protos, TRUE);
+		return NULL;
+	}
+	return (int *)g_array_free(protos, FALSE);
+}
+
 int*
 dfw_interesting_fields(dfwork_t *dfw, int *caller_num_fields)
 {
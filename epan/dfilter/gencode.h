@@ -16,4 +16,7 @@ dfw_gencode(dfwork_t *dfw);
 int*
 dfw_interesting_fields(dfwork_t *dfw, int *caller_num_fields);
 
+int*
+dfw_required_protocols(dfwork_t *dfw, int *caller_num_protos);
+
 #endif
@@ -392,41 +392,25 @@ is_bytes_type(enum ftenum type)
 	return FALSE;
 }
 
-/* Gets a GRegex from a string, and sets the error message on failure. */
-static GRegex*
-dfilter_g_regex_from_string(dfwork_t *dfw, const char *s)
+/* Gets a compiled regex from a string, and sets the error message on failure. */
+static fvalue_regex_t*
+dfilter_regex_from_string(dfwork_t *dfw, const char *s)
 {
-	GError *regex_error = NULL;
-	GRegexCompileFlags cflags = (GRegexCompileFlags)(G_REGEX_CASELESS | G_REGEX_OPTIMIZE);
-	GRegex *pcre;
+	fvalue_regex_t *pcre;
+	char *errmsg = NULL;
 
 	/*
 	 * As FT_BYTES and FT_PROTOCOL contain arbitrary binary data
 	 * and FT_STRING is not guaranteed to contain valid UTF-8,
-	 * we have to disable support for UTF-8 patterns and treat
-	 * every pattern and subject as raw bytes.
-	 *
-	 * Should support for UTF-8 patterns be necessary, then we
-	 * should compile a pattern without G_REGEX_RAW. Additionally,
-	 * we MUST use g_utf8_validate() before calling g_regex_match_full()
-	 * or risk crashes.
+	 * the pattern and every subject are treated as raw bytes;
+	 * see fvalue_regex_compile().
 	 */
-	cflags = (GRegexCompileFlags)(cflags | G_REGEX_RAW);
-
-	pcre = g_regex_new(
-			s,			/* pattern */
-			cflags,			/* Compile options */
-			(GRegexMatchFlags)0,	/* Match options */
-			&regex_error		/* Compile / study errors */
-			);
-
-	if (regex_error) {
+	pcre = fvalue_regex_compile(s, &errmsg);
+	if (pcre == NULL) {
 		if (dfw->error_message == NULL)
-			dfw->error_message = g_strdup(regex_error->message);
-		g_error_free(regex_error);
-		if (pcre) {
-			g_regex_unref(pcre);
-		}
+			dfw->error_message = errmsg;
+		else
+			g_free(errmsg);
 		return NULL;
 	}
 	return pcre;
@@ -674,7 +658,7 @@ check_relation_LHS_FIELD(dfwork_t *dfw, const char *relation_string,
 	df_func_def_t		*funcdef;
 	ftenum_t		ftype1, ftype2;
 	fvalue_t		*fvalue;
-	GRegex			*pcre;
+	fvalue_regex_t		*pcre;
 	char			*s;
 
 	type2 = stnode_type_id(st_arg2);
@@ -716,8 +700,8 @@ check_relation_LHS_FIELD(dfwork_t *dfw, const char *relation_string,
 	         type2 == STTYPE_CHARCONST) {
 		s = (char *)stnode_data(st_arg2);
 		if (strcmp(relation_string, "matches") == 0) {
-			/* Convert to a GRegex */
-			pcre = dfilter_g_regex_from_string(dfw, s);
+			/* Convert to a regex */
+			pcre = dfilter_regex_from_string(dfw, s);
 			if (!pcre) {
 				THROW(TypeError);
 			}
@@ -810,8 +794,10 @@ check_relation_LHS_FIELD(dfwork_t *dfw, const char *relation_string,
 	}
 	else if (type2 == STTYPE_SET) {
 		GSList *nodelist;
-		/* A set should only ever appear on RHS of 'in' operation */
-		if (strcmp(relation_string, "in") != 0) {
+		gboolean contains_any;
+		/* A set should only ever appear on RHS of 'in' or 'contains any' */
+		contains_any = strcmp(relation_string, "contains any") == 0;
+		if (!contains_any && strcmp(relation_string, "in") != 0) {
 			g_assert_not_reached();
 		}
 		/* Attempt to interpret one element of the set at a time. Each
@@ -831,7 +817,14 @@ check_relation_LHS_FIELD(dfwork_t *dfw, const char *relation_string,
 			nodelist = g_slist_next(nodelist);
 			g_assert(nodelist);
 			stnode_t *node_right = (stnode_t *)nodelist->data;
-			if (node_right) {
+			if (node_right && contains_any) {
+				dfilter_fail(dfw, "A set for 'contains any' may not contain value ranges.");
+				THROW(TypeError);
+			} else if (contains_any) {
+				/* Each element is a string to look for. */
+				check_relation_LHS_FIELD(dfw, "contains", can_func,
+						allow_partial_value, st_arg2, st_arg1, node);
+			} else if (node_right) {
 				/* range type, check if comparison is possible. */
 				if (!ftype_can_ge(ftype1)) {
 					dfilter_fail(dfw, "%s (type=%s) cannot participate in '%s' comparison.",
@@ -1056,7 +1049,7 @@ check_relation_LHS_RANGE(dfwork_t *dfw, const char *relation_string,
 	header_field_info	*hfinfo1, *hfinfo2;
 	ftenum_t		ftype1, ftype2;
 	fvalue_t		*fvalue;
-	GRegex			*pcre;
+	fvalue_regex_t		*pcre;
 	char			*s;
 	int                     len_range;
 
@@ -1120,8 +1113,8 @@ check_relation_LHS_RANGE(dfwork_t *dfw, const char *relation_string,
 		DebugLog(("    5 check_relation_LHS_RANGE(type2 = STTYPE_STRING)\n"));
 		s = (char*)stnode_data(st_arg2);
 		if (strcmp(relation_string, "matches") == 0) {
-			/* Convert to a GRegex * */
-			pcre = dfilter_g_regex_from_string(dfw, s);
+			/* Convert to a regex */
+			pcre = dfilter_regex_from_string(dfw, s);
 			if (!pcre) {
 				THROW(TypeError);
 			}
@@ -1142,8 +1135,8 @@ check_relation_LHS_RANGE(dfwork_t *dfw, const char *relation_string,
 		s = (char*)stnode_data(st_arg2);
 		len_range = drange_get_total_length(sttype_range_drange(st_arg1));
 		if (strcmp(relation_string, "matches") == 0) {
-			/* Convert to a GRegex */
-			pcre = dfilter_g_regex_from_string(dfw, s);
+			/* Convert to a regex */
+			pcre = dfilter_regex_from_string(dfw, s);
 			if (!pcre) {
 				THROW(TypeError);
 			}
@@ -1194,8 +1187,8 @@ check_relation_LHS_RANGE(dfwork_t *dfw, const char *relation_string,
 		DebugLog(("    5 check_relation_LHS_RANGE(type2 = STTYPE_CHARCONST)\n"));
 		s = (char*)stnode_data(st_arg2);
 		if (strcmp(relation_string, "matches") == 0) {
-			/* Convert to a GRegex */
-			pcre = dfilter_g_regex_from_string(dfw, s);
+			/* Convert to a regex */
+			pcre = dfilter_regex_from_string(dfw, s);
 			if (!pcre) {
 				THROW(TypeError);
 			}
@@ -1284,7 +1277,7 @@ check_relation_LHS_FUNCTION(dfwork_t *dfw, const char *relation_string,
 	header_field_info	*hfinfo2;
 	ftenum_t		ftype1, ftype2;
 	fvalue_t		*fvalue;
-	GRegex			*pcre;
+	fvalue_regex_t		*pcre;
 	char			*s;
 	df_func_def_t		*funcdef;
 	df_func_def_t		*funcdef2;
@@ -1327,8 +1320,8 @@ check_relation_LHS_FUNCTION(dfwork_t *dfw, const char *relation_string,
 	else if (type2 == STTYPE_STRING) {
 		s = (char*)stnode_data(st_arg2);
 		if (strcmp(relation_string, "matches") == 0) {
-			/* Convert to a GRegex */
-			pcre = dfilter_g_regex_from_string(dfw, s);
+			/* Convert to a regex */
+			pcre = dfilter_regex_from_string(dfw, s);
 			if (!pcre) {
 				THROW(TypeError);
 			}
@@ -1346,8 +1339,8 @@ check_relation_LHS_FUNCTION(dfwork_t *dfw, const char *relation_string,
 	else if (type2 == STTYPE_UNPARSED || type2 == STTYPE_CHARCONST) {
 		s = (char*)stnode_data(st_arg2);
 		if (strcmp(relation_string, "matches") == 0) {
-			/* Convert to a GRegex */
-			pcre = dfilter_g_regex_from_string(dfw, s);
+			/* Convert to a regex */
+			pcre = dfilter_regex_from_string(dfw, s);
 			if (!pcre) {
 				THROW(TypeError);
 			}
@@ -1550,6 +1543,9 @@ check_test(dfwork_t *dfw, stnode_t *st_node, GPtrArray *deprecated)
 			 * semantics of equality. */
 			check_relation(dfw, "in", FALSE, ftype_can_eq, st_node, st_arg1, st_arg2);
 			break;
+		case TEST_OP_CONTAINS_ANY:
+			check_relation(dfw, "contains any", TRUE, ftype_can_contains, st_node, st_arg1, st_arg2);
+			break;
 
 		default:
 			g_assert_not_reached();
@@ -27,16 +27,11 @@ fvalue_free(gpointer value)
 static void
 pcre_free(gpointer value)
 {
-	GRegex	*pcre = (GRegex*)value;
+	fvalue_regex_t	*pcre = (fvalue_regex_t*)value;
 
 	/* If the data was not claimed with stnode_steal_data(), free it. */
 	if (pcre) {
-		/*
-		 * They're reference-counted, so just drop the reference
-		 * count; it'll get freed when the reference count drops
-		 * to 0.
-		 */
-		g_regex_unref(pcre);
+		fvalue_regex_free(pcre);
 	}
 }
 
@@ -85,6 +85,7 @@ num_operands(test_op_t op)
 		case TEST_OP_CONTAINS:
 		case TEST_OP_MATCHES:
 		case TEST_OP_IN:
+		case TEST_OP_CONTAINS_ANY:
 			return 2;
 	}
 	g_assert_not_reached();
@@ -25,7 +25,8 @@ typedef enum {
 	TEST_OP_BITWISE_AND,
 	TEST_OP_CONTAINS,
 	TEST_OP_MATCHES,
-	TEST_OP_IN
+	TEST_OP_IN,
+	TEST_OP_CONTAINS_ANY
 } test_op_t;
 
 void
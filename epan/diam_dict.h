@@ -71,4 +71,10 @@ extern void ddict_print(FILE* fh, ddict_t* d);
 extern ddict_t* ddict_scan(const char* directory, const char* filename, int dbg);
 extern void ddict_free(ddict_t* d);
 
+/* The dictionary as last scanned from the same files, or NULL if there's
+   no cached copy or any of the files have changed since */
+extern ddict_t* ddict_cache_load(const char* directory, const char* filename);
+/* Keep a copy of a dictionary scanned from those files */
+extern void ddict_cache_save(const char* directory, const char* filename, const ddict_t* d);
+
 #endif
@@ -0,0 +1,397 @@
+/*
+ ** diam_dict_cache.c
+ ** Cache of the parsed Diameter dictionary
+ **
+ ** Scanning the XML of the dictionary, with its many included files,
+ ** takes a good part of the start-up time; the result of the scan is
+ ** kept in a binary file in the user's cache directory, which is
+ ** mapped and read back as long as none of the files of the dictionary
+ ** have changed.
+ **
+ ** SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <wsutil/file_util.h>
+
+#include "diam_dict.h"
+
+#define DDICT_CACHE_MAGIC	"WSDDICT1"
+#define DDICT_CACHE_MAGIC_LEN	8
+
+static gint
+compare_names(gconstpointer a, gconstpointer b)
+{
+	return strcmp(*(const gchar * const *)a, *(const gchar * const *)b);
+}
+
+/*
+ * What the dictionary was scanned from: the directory, the top file, and
+ * the name, size and modification time of every file in the directory,
+ * as entities can include any of them.
+ */
+static GString *
+ddict_cache_fingerprint(const char* system_directory, const char* filename)
+{
+	GString *fp;
+	GDir *dir;
+	const gchar *name;
+	GPtrArray *names;
+	gchar *path;
+	ws_statb64 st;
+	guint i;
+
+	dir = g_dir_open(system_directory, 0, NULL);
+	if (dir == NULL)
+		return NULL;
+
+	names = g_ptr_array_new_with_free_func(g_free);
+	while ((name = g_dir_read_name(dir)) != NULL)
+		g_ptr_array_add(names, g_strdup(name));
+	g_dir_close(dir);
+	g_ptr_array_sort(names, compare_names);
+
+	fp = g_string_new(NULL);
+	g_string_append_printf(fp, "%s\n%s\n", system_directory, filename);
+	for (i = 0; i < names->len; i++) {
+		name = (const gchar *)g_ptr_array_index(names, i);
+		path = g_build_filename(system_directory, name, NULL);
+		if (ws_stat64(path, &st) == 0) {
+			g_string_append_printf(fp, "%s %" G_GINT64_FORMAT " %" G_GINT64_FORMAT "\n",
+			    name, (gint64)st.st_size, (gint64)st.st_mtime);
+		}
+		g_free(path);
+	}
+	g_ptr_array_free(names, TRUE);
+	return fp;
+}
+
+static gchar *
+ddict_cache_path(void)
+{
+	return g_build_filename(g_get_user_cache_dir(), "wireshark",
+	    "diameter-dictionary.cache", NULL);
+}
+
+/*
+ * Writing.  Numbers are little-endian 32-bit; strings are their length
+ * plus one (0 for NULL) followed by their bytes.
+ */
+static void
+put_uint(GByteArray *buf, guint32 v)
+{
+	v = GUINT32_TO_LE(v);
+	g_byte_array_append(buf, (const guint8 *)&v, 4);
+}
+
+static void
+put_str(GByteArray *buf, const char *s)
+{
+	guint32 len;
+
+	if (s == NULL) {
+		put_uint(buf, 0);
+		return;
+	}
+	len = (guint32)strlen(s);
+	put_uint(buf, len + 1);
+	g_byte_array_append(buf, (const guint8 *)s, len);
+}
+
+static void
+put_namecodes(GByteArray *buf, const struct _ddict_namecode_t* nc)
+{
+	const struct _ddict_namecode_t* n;
+	guint32 count = 0;
+
+	for (n = nc; n; n = n->next)
+		count++;
+	put_uint(buf, count);
+	for (n = nc; n; n = n->next) {
+		put_str(buf, n->name);
+		put_uint(buf, n->code);
+	}
+}
+
+void
+ddict_cache_save(const char* system_directory, const char* filename, const ddict_t* d)
+{
+	GString *fp;
+	GByteArray *buf;
+	gchar *path, *dir;
+	const ddict_vendor_t *v;
+	const ddict_cmd_t *c;
+	const ddict_typedefn_t *t;
+	const ddict_avp_t *a;
+	const ddict_xmlpi_t *x;
+	guint32 count;
+
+	fp = ddict_cache_fingerprint(system_directory, filename);
+	if (fp == NULL)
+		return;
+
+	buf = g_byte_array_new();
+	g_byte_array_append(buf, (const guint8 *)DDICT_CACHE_MAGIC, DDICT_CACHE_MAGIC_LEN);
+	put_str(buf, fp->str);
+	g_string_free(fp, TRUE);
+
+	put_namecodes(buf, d->applications);
+
+	for (count = 0, v = d->vendors; v; v = v->next)
+		count++;
+	put_uint(buf, count);
+	for (v = d->vendors; v; v = v->next) {
+		put_str(buf, v->name);
+		put_str(buf, v->desc);
+		put_uint(buf, v->code);
+	}
+
+	for (count = 0, c = d->cmds; c; c = c->next)
+		count++;
+	put_uint(buf, count);
+	for (c = d->cmds; c; c = c->next) {
+		put_str(buf, c->name);
+		put_str(buf, c->vendor);
+		put_uint(buf, c->code);
+	}
+
+	for (count = 0, t = d->typedefns; t; t = t->next)
+		count++;
+	put_uint(buf, count);
+	for (t = d->typedefns; t; t = t->next) {
+		put_str(buf, t->name);
+		put_str(buf, t->parent);
+	}
+
+	for (count = 0, a = d->avps; a; a = a->next)
+		count++;
+	put_uint(buf, count);
+	for (a = d->avps; a; a = a->next) {
+		put_str(buf, a->name);
+		put_str(buf, a->description);
+		put_str(buf, a->vendor);
+		put_str(buf, a->type);
+		put_uint(buf, a->code);
+		put_namecodes(buf, a->gavps);
+		put_namecodes(buf, a->enums);
+	}
+
+	for (count = 0, x = d->xmlpis; x; x = x->next)
+		count++;
+	put_uint(buf, count);
+	for (x = d->xmlpis; x; x = x->next) {
+		put_str(buf, x->name);
+		put_str(buf, x->key);
+		put_str(buf, x->value);
+	}
+
+	/* It's only a cache; if it can't be written, the dictionary is
+	   scanned again next time. */
+	path = ddict_cache_path();
+	dir = g_path_get_dirname(path);
+	if (g_mkdir_with_parents(dir, 0755) == 0)
+		g_file_set_contents(path, (const gchar *)buf->data, buf->len, NULL);
+	g_free(dir);
+	g_free(path);
+	g_byte_array_free(buf, TRUE);
+}
+
+/* Reading */
+typedef struct {
+	const guint8 *p;
+	const guint8 *end;
+	gboolean ok;
+} ddict_cache_reader_t;
+
+static guint32
+get_uint(ddict_cache_reader_t *r)
+{
+	guint32 v;
+
+	if (!r->ok || r->end - r->p < 4) {
+		r->ok = FALSE;
+		return 0;
+	}
+	memcpy(&v, r->p, 4);
+	r->p += 4;
+	return GUINT32_FROM_LE(v);
+}
+
+/* A count of items, each of which takes at least min_size bytes. */
+static guint32
+get_count(ddict_cache_reader_t *r, gsize min_size)
+{
+	guint32 count = get_uint(r);
+
+	if (r->ok && (gsize)(r->end - r->p) / min_size < count) {
+		r->ok = FALSE;
+		return 0;
+	}
+	return count;
+}
+
+static char *
+get_str(ddict_cache_reader_t *r)
+{
+	guint32 len = get_uint(r);
+	char *s;
+
+	if (!r->ok || len == 0)
+		return NULL;
+	len--;
+	if ((guint32)(r->end - r->p) < len) {
+		r->ok = FALSE;
+		return NULL;
+	}
+	s = g_strndup((const char *)r->p, len);
+	r->p += len;
+	return s;
+}
+
+static struct _ddict_namecode_t*
+get_namecodes(ddict_cache_reader_t *r)
+{
+	struct _ddict_namecode_t *first = NULL, *last = NULL, *n;
+	guint32 count, i;
+
+	count = get_count(r, 8);
+	for (i = 0; i < count && r->ok; i++) {
+		n = g_new(struct _ddict_namecode_t, 1);
+		n->name = get_str(r);
+		n->code = get_uint(r);
+		n->next = NULL;
+		if (last)
+			last->next = n;
+		else
+			first = n;
+		last = n;
+	}
+	return first;
+}
+
+/* Append to a list, keeping the order of the dictionary. */
+#define DDICT_APPEND(first, last, item) do { \
+	if (last) (last)->next = (item); else (first) = (item); \
+	(last) = (item); } while (0)
+
+ddict_t*
+ddict_cache_load(const char* system_directory, const char* filename)
+{
+	GString *fp;
+	gchar *path;
+	GMappedFile *mapped;
+	ddict_cache_reader_t r;
+	char *cached_fp;
+	ddict_t *d;
+	ddict_vendor_t *v, *last_v = NULL;
+	ddict_cmd_t *c, *last_c = NULL;
+	ddict_typedefn_t *t, *last_t = NULL;
+	ddict_avp_t *a, *last_a = NULL;
+	ddict_xmlpi_t *x, *last_x = NULL;
+	guint32 count, i;
+
+	path = ddict_cache_path();
+	mapped = g_mapped_file_new(path, FALSE, NULL);
+	g_free(path);
+	if (mapped == NULL)
+		return NULL;
+
+	r.p = (const guint8 *)g_mapped_file_get_contents(mapped);
+	r.end = r.p + g_mapped_file_get_length(mapped);
+	r.ok = (r.end - r.p >= DDICT_CACHE_MAGIC_LEN &&
+	    memcmp(r.p, DDICT_CACHE_MAGIC, DDICT_CACHE_MAGIC_LEN) == 0);
+	r.p += r.ok ? DDICT_CACHE_MAGIC_LEN : 0;
+
+	/* Is it of this dictionary, as it is now? */
+	cached_fp = get_str(&r);
+	fp = ddict_cache_fingerprint(system_directory, filename);
+	if (!r.ok || cached_fp == NULL || fp == NULL || strcmp(cached_fp, fp->str) != 0) {
+		g_free(cached_fp);
+		if (fp)
+			g_string_free(fp, TRUE);
+		g_mapped_file_unref(mapped);
+		return NULL;
+	}
+	g_free(cached_fp);
+	g_string_free(fp, TRUE);
+
+	d = g_new0(ddict_t, 1);
+
+	d->applications = get_namecodes(&r);
+
+	count = get_count(&r, 12);
+	for (i = 0; i < count && r.ok; i++) {
+		v = g_new0(ddict_vendor_t, 1);
+		v->name = get_str(&r);
+		v->desc = get_str(&r);
+		v->code = get_uint(&r);
+		DDICT_APPEND(d->vendors, last_v, v);
+	}
+
+	count = get_count(&r, 12);
+	for (i = 0; i < count && r.ok; i++) {
+		c = g_new0(ddict_cmd_t, 1);
+		c->name = get_str(&r);
+		c->vendor = get_str(&r);
+		c->code = get_uint(&r);
+		DDICT_APPEND(d->cmds, last_c, c);
+	}
+
+	count = get_count(&r, 8);
+	for (i = 0; i < count && r.ok; i++) {
+		t = g_new0(ddict_typedefn_t, 1);
+		t->name = get_str(&r);
+		t->parent = get_str(&r);
+		DDICT_APPEND(d->typedefns, last_t, t);
+	}
+
+	count = get_count(&r, 28);
+	for (i = 0; i < count && r.ok; i++) {
+		a = g_new0(ddict_avp_t, 1);
+		a->name = get_str(&r);
+		a->description = get_str(&r);
+		a->vendor = get_str(&r);
+		a->type = get_str(&r);
+		a->code = get_uint(&r);
+		a->gavps = get_namecodes(&r);
+		a->enums = get_namecodes(&r);
+		DDICT_APPEND(d->avps, last_a, a);
+	}
+
+	count = get_count(&r, 12);
+	for (i = 0; i < count && r.ok; i++) {
+		x = g_new0(ddict_xmlpi_t, 1);
+		x->name = get_str(&r);
+		x->key = get_str(&r);
+		x->value = get_str(&r);
+		DDICT_APPEND(d->xmlpis, last_x, x);
+	}
+
+	g_mapped_file_unref(mapped);
+
+	if (!r.ok || r.p != r.end) {
+		/* Truncated or damaged; scan the dictionary instead. */
+		ddict_free(d);
+		return NULL;
+	}
+	return d;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -995,6 +995,16 @@ read_enabled_and_disabled_lists(void)
    * Enable/disable protocols and heuristic dissectors as per the
    * contents of the files we just read.
    */
+  apply_enabled_and_disabled_lists();
+}
+
+/*
+ * Enable/disable protocols and heuristic dissectors as per the lists
+ * read by read_enabled_and_disabled_lists().
+ */
+void
+apply_enabled_and_disabled_lists(void)
+{
   set_protos_list(disabled_protos, global_disabled_protos, FALSE);
   set_protos_list(enabled_protos, global_enabled_protos, TRUE);
   set_disabled_heur_dissector_list();
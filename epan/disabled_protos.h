@@ -47,6 +47,14 @@ proto_enable_heuristic_by_name(const char *name, gboolean enable);
 extern void
 read_enabled_and_disabled_lists(void);
 
+/*
+ * Enable/disable protocols and heuristic dissectors again as per the
+ * lists that were read, for those registered since, such as the ones
+ * of plugins loaded when they're first needed.
+ */
+extern void
+apply_enabled_and_disabled_lists(void);
+
 /*
  * Write out the lists of enabled and disabled protocols and heuristic
  * dissectors to the corresponding files.  Report errors through the UI.
@@ -197,6 +197,23 @@ static dissector_table_t ber_syntax_dissector_table = NULL;
 
 static GHashTable *syntax_table = NULL;
 
+/*
+ * Index of a CHOICE table by the class and tag of its alternatives, made
+ * the first time the table is used.  It's only used for tables whose
+ * alternatives all have a tag of their own, so that the alternative for
+ * a tag is the first one with that class and tag; for the others,
+ * dissect_ber_choice() goes through the table.
+ */
+typedef struct {
+    gboolean    by_tag;
+    gint        num_choices;
+    GHashTable *choices;    /* class and tag -> index of the alternative + 1 */
+} ber_choice_index_t;
+
+static GHashTable *choice_indices = NULL; /* const ber_choice_t * -> ber_choice_index_t * */
+
+#define BER_CHOICE_KEY(ber_class, tag) GUINT_TO_POINTER(((guint)(tag) << 2) | (guint)(ber_class))
+
 static gint8    last_class;
 static gboolean last_pc;
 static gint32   last_tag;
@@ -2763,6 +2780,56 @@ proto_tree_add_debug_text(tree, "SET dissect_ber_set(%s) calling subdissector\n"
 #define DEBUG_BER_CHOICE
 #endif
 
+static void
+ber_choice_index_free(gpointer data)
+{
+    ber_choice_index_t *choice_index = (ber_choice_index_t *)data;
+
+    if (choice_index->choices)
+        g_hash_table_destroy(choice_index->choices);
+    g_free(choice_index);
+}
+
+static const ber_choice_index_t *
+get_ber_choice_index(const ber_choice_t *choice)
+{
+    ber_choice_index_t *choice_index;
+    const ber_choice_t *ch;
+
+    if (!choice_indices)
+        choice_indices = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, ber_choice_index_free);
+
+    choice_index = (ber_choice_index_t *)g_hash_table_lookup(choice_indices, choice);
+    if (choice_index)
+        return choice_index;
+
+    choice_index = g_new0(ber_choice_index_t, 1);
+    choice_index->by_tag = TRUE;
+    for (ch = choice; ch->func; ch++) {
+        if (ch->tag < 0 || ch->tag > 0x3fffffff) {
+            /* Matched in other ways; go through the table. */
+            choice_index->by_tag = FALSE;
+            break;
+        }
+    }
+    choice_index->num_choices = (gint)(ch - choice);
+    if (choice_index->by_tag) {
+        choice_index->choices = g_hash_table_new(g_direct_hash, g_direct_equal);
+        for (ch = choice; ch->func; ch++) {
+            gpointer key;
+
+            /* An alternative of another class never matches. */
+            if (ch->ber_class < BER_CLASS_UNI || ch->ber_class > BER_CLASS_PRI)
+                continue;
+            key = BER_CHOICE_KEY(ch->ber_class, ch->tag);
+            if (!g_hash_table_contains(choice_index->choices, key))
+                g_hash_table_insert(choice_index->choices, key, GINT_TO_POINTER((gint)(ch - choice) + 1));
+        }
+    }
+    g_hash_table_insert(choice_indices, (gpointer)choice, choice_index);
+    return choice_index;
+}
+
 int
 dissect_ber_choice(asn1_ctx_t *actx, proto_tree *parent_tree, tvbuff_t *tvb, int offset, const ber_choice_t *choice, gint hf_id, gint ett_id, gint *branch_taken)
 {
@@ -2781,6 +2848,7 @@ dissect_ber_choice(asn1_ctx_t *actx, proto_tree *parent_tree, tvbuff_t *tvb, int
     gboolean    first_pass;
     header_field_info  *hfinfo;
     const ber_choice_t *ch;
+    const ber_choice_index_t *choice_index;
 
 #ifdef DEBUG_BER_CHOICE
 {
@@ -2843,6 +2911,25 @@ proto_tree_add_debug_text(tree, "CHOICE dissect_ber_choice(%s) entered len:%d\n"
        run out of entries */
     ch = choice;
     first_pass = TRUE;
+
+    /* If the alternative can be looked up, start the loop at it, or, if
+       there's none, end it before it starts. */
+    choice_index = get_ber_choice_index(choice);
+    if (choice_index->by_tag) {
+        gint choice_num = 0;
+
+        if (ber_class >= BER_CLASS_UNI && ber_class <= BER_CLASS_PRI && tag >= 0 && tag <= 0x3fffffff)
+            choice_num = GPOINTER_TO_INT(g_hash_table_lookup(choice_index->choices, BER_CHOICE_KEY(ber_class, tag)));
+        if (choice_num > 0) {
+            ch = &choice[choice_num - 1];
+            if (branch_taken) {
+                *branch_taken = choice_num - 2;
+            }
+        } else {
+            ch = &choice[choice_index->num_choices];
+            first_pass = FALSE;
+        }
+    }
     while (ch->func || first_pass) {
         if (branch_taken) {
             (*branch_taken)++;
@@ -4312,6 +4399,8 @@ static void
 ber_shutdown(void)
 {
     g_hash_table_destroy(syntax_table);
+    if (choice_indices)
+        g_hash_table_destroy(choice_indices);
 }
 
 void
@@ -151,7 +151,7 @@ proto_register_data(void)
 		"data"		/* abbrev */
 		);
 
-	data_handle = register_dissector("data", dissect_data, proto_data);
+	data_handle = register_dissector_stateless("data", dissect_data, proto_data);
 
 	proto_register_fields(proto_data, hfi, array_length(hfi));
 	proto_register_subtree_array(ett, array_length(ett));
@@ -2111,7 +2111,14 @@ dictionary_load(void)
 
 	/* load the dictionary */
 	dir = wmem_strdup_printf(NULL, "%s" G_DIR_SEPARATOR_S "diameter" G_DIR_SEPARATOR_S, get_datafile_dir());
-	d = ddict_scan(dir,"dictionary.xml",do_debug_parser);
+	d = NULL;
+	if (!do_debug_parser)
+		d = ddict_cache_load(dir,"dictionary.xml");
+	if (d == NULL) {
+		d = ddict_scan(dir,"dictionary.xml",do_debug_parser);
+		if (d != NULL)
+			ddict_cache_save(dir,"dictionary.xml",d);
+	}
 	wmem_free(NULL, dir);
 	if (d == NULL) {
 		g_hash_table_destroy(vendors);
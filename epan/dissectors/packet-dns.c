@@ -542,6 +542,16 @@ typedef struct _dns_conv_info_t {
   wmem_tree_t *pdus;
 } dns_conv_info_t;
 
+/* Free the information of a conversation that expired */
+static void
+dns_conv_info_free(gpointer data)
+{
+  dns_conv_info_t *dns_info = (dns_conv_info_t *)data;
+
+  wmem_tree_destroy(dns_info->pdus, FALSE, TRUE);
+  wmem_free(wmem_file_scope(), dns_info);
+}
+
 /* DNS structs and definitions */
 
 /* Ports used for DNS. */
@@ -1348,6 +1358,62 @@ qname_labels_count(const gchar* name, gint name_len)
     return labels;
 }
 
+/*
+ * The names already expanded in the DNS message being dissected, by the
+ * offset they start at, so that compression pointers to them don't walk
+ * their labels again.  It's reset by dns_name_cache_start() at the start
+ * of each message, and dropped along with wmem_packet_scope(), which has
+ * the names it points to; names in any other tvbuff aren't cached.
+ *
+ * Only names that were read without a length limit, and that were
+ * expanded completely, without bitstring labels, are kept.
+ */
+typedef struct {
+  const gchar *name;
+  gint         name_len;
+} dns_cached_name_t;
+
+typedef struct {
+  tvbuff_t   *tvb;
+  int         dns_data_offset;
+  wmem_map_t *names;            /* offset -> dns_cached_name_t */
+} dns_name_cache_t;
+
+static dns_name_cache_t *dns_name_cache;
+
+/* The most pointers of one name whose targets are added to the cache */
+#define MAX_CACHED_POINTERS 8
+
+static gboolean
+dns_name_cache_drop(wmem_allocator_t *allocator _U_, wmem_cb_event_t event _U_,
+    void *user_data _U_)
+{
+  dns_name_cache = NULL;
+  return FALSE;
+}
+
+static void
+dns_name_cache_start(tvbuff_t *tvb, int dns_data_offset)
+{
+  if (dns_name_cache == NULL) {
+    dns_name_cache = wmem_new(wmem_packet_scope(), dns_name_cache_t);
+    wmem_register_callback(wmem_packet_scope(), dns_name_cache_drop, NULL);
+  }
+  dns_name_cache->tvb = tvb;
+  dns_name_cache->dns_data_offset = dns_data_offset;
+  dns_name_cache->names = wmem_map_new(wmem_packet_scope(), g_direct_hash, g_direct_equal);
+}
+
+static wmem_map_t *
+dns_name_cache_names(tvbuff_t *tvb, int dns_data_offset)
+{
+  if (dns_name_cache == NULL || dns_name_cache->tvb != tvb ||
+      dns_name_cache->dns_data_offset != dns_data_offset) {
+    return NULL;
+  }
+  return dns_name_cache->names;
+}
+
 /* This function returns the number of bytes consumed and the expanded string
  * in *name.
  * The string is allocated with wmem_packet_scope scope and does not need to be freed.
@@ -1364,12 +1430,40 @@ expand_dns_name(tvbuff_t *tvb, int offset, int max_len, int dns_data_offset,
   int     component_len;
   int     indir_offset;
   int     maxname;
+  wmem_map_t *cached_names = NULL;
+  const dns_cached_name_t *cached;
+  gboolean cacheable      = FALSE;
+  int     num_targets     = 0;
+  int     target_offsets[MAX_CACHED_POINTERS + 1];
+  int     target_name_lens[MAX_CACHED_POINTERS + 1];
 
   const int min_len = 1;        /* Minimum length of encoded name (for root) */
         /* If we're about to return a value (probably negative) which is less
          * than the minimum length, we're looking at bad data and we're liable
          * to put the dissector into a loop.  Instead we throw an exception */
 
+  if (max_len == 0) {
+    cached_names = dns_name_cache_names(tvb, dns_data_offset);
+  }
+  if (cached_names) {
+    /* A name that's just a pointer to a name already expanded, as most
+       names in responses are, is that name. */
+    component_len = tvb_get_guint8(tvb, offset);
+    if ((component_len & 0xc0) == 0xc0) {
+      indir_offset = dns_data_offset +
+        (((component_len & ~0xc0) << 8) | tvb_get_guint8(tvb, offset + 1));
+      if (indir_offset != offset + 4 &&
+          (cached = (const dns_cached_name_t *)wmem_map_lookup(cached_names, GINT_TO_POINTER(indir_offset))) != NULL) {
+        *name = cached->name;
+        *name_len = cached->name_len;
+        return 2;
+      }
+    }
+    cacheable = TRUE;
+    target_offsets[num_targets] = offset;
+    target_name_lens[num_targets++] = 0;
+  }
+
   maxname = MAX_DNAME_LEN;
   np=(gchar *)wmem_alloc(wmem_packet_scope(), maxname);
   *name=np;
@@ -1399,6 +1493,19 @@ expand_dns_name(tvbuff_t *tvb, int offset, int max_len, int dns_data_offset,
         else {
           maxname--;
         }
+        if (!max_len && tvb_bytes_exist(tvb, offset, component_len)) {
+          /* Copy what fits of the label in one go. */
+          int copy_len = MIN(component_len, MAX(maxname, 0));
+
+          if (copy_len > 0) {
+            tvb_memcpy(tvb, np, offset, copy_len);
+          }
+          np += copy_len;
+          (*name_len) += copy_len;
+          maxname -= copy_len;
+          offset += component_len;
+          break;
+        }
         while (component_len > 0) {
           if (max_len && offset - start_offset > max_len - 1) {
             THROW(ReportedBoundsError);
@@ -1424,6 +1531,7 @@ expand_dns_name(tvbuff_t *tvb, int offset, int max_len, int dns_data_offset,
             int label_len;
             int print_len;
 
+            cacheable = FALSE;
             bit_count = tvb_get_guint8(tvb, offset);
             offset++;
             label_len = (bit_count - 1) / 8 + 1;
@@ -1511,14 +1619,61 @@ expand_dns_name(tvbuff_t *tvb, int offset, int max_len, int dns_data_offset,
           return len;
         }
 
+        if (cacheable) {
+          cached = (const dns_cached_name_t *)wmem_map_lookup(cached_names, GINT_TO_POINTER(indir_offset));
+          if (cached) {
+            /* Append the rest of the name, as the labels would have been. */
+            int copy_len;
+
+            if (cached->name_len > 0) {
+              if (np != *name) {
+                if (maxname > 0) {
+                  *np++ = '.';
+                  (*name_len)++;
+                  maxname--;
+                }
+              }
+              else {
+                maxname--;
+              }
+              copy_len = MIN(cached->name_len, MAX(maxname, 0));
+              memcpy(np, cached->name, copy_len);
+              np += copy_len;
+              (*name_len) += copy_len;
+              maxname -= copy_len;
+            }
+            goto done;
+          }
+          if (num_targets <= MAX_CACHED_POINTERS) {
+            target_offsets[num_targets] = indir_offset;
+            target_name_lens[num_targets++] = *name_len;
+          }
+        }
+
         offset = indir_offset;
         break;   /* now continue processing from there */
     }
   }
 
+done:
   // Do we have space for the terminating 0?
   if (maxname > 0) {
     *np = '\0';
+    if (cacheable) {
+      /* The name from each pointer target on, without the separator
+         before it, is the name at that target. */
+      for (int i = 0; i < num_targets; i++) {
+        dns_cached_name_t *target = wmem_new(wmem_packet_scope(), dns_cached_name_t);
+        int skip = target_name_lens[i];
+
+        if (skip > 0 && skip < *name_len) {
+          skip++;
+        }
+        target->name = *name + skip;
+        target->name_len = *name_len - skip;
+        wmem_map_insert(cached_names, GINT_TO_POINTER(target_offsets[i]), target);
+      }
+    }
   }
   else {
     *name="<Name too long>";
@@ -4096,6 +4251,7 @@ dissect_dns_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
   gboolean           is_multiple_responds = FALSE;
 
   dns_data_offset = offset;
+  dns_name_cache_start(tvb, dns_data_offset);
 
   col_clear(pinfo->cinfo, COL_INFO);
 
@@ -6392,6 +6548,8 @@ proto_register_dns(void)
   expert_dns = expert_register_protocol(proto_dns);
   expert_register_field_array(expert_dns, ei, array_length(ei));
 
+  conversation_register_proto_data_free(proto_dns, dns_conv_info_free);
+
   dns_module = prefs_register_protocol(proto_dns, NULL);
 
   prefs_register_bool_preference(dns_module, "desegment_dns_messages",
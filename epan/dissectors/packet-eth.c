@@ -1106,9 +1106,9 @@ proto_register_eth(void)
                                  "Set the condition that must be true for the CCSDS dissector to be called",
                                  &ccsds_heuristic_bit);
 
-  eth_withoutfcs_handle = register_dissector("eth_withoutfcs", dissect_eth_withoutfcs, proto_eth);
-  register_dissector("eth_withfcs", dissect_eth_withfcs, proto_eth);
-  eth_maybefcs_handle = register_dissector("eth_maybefcs", dissect_eth_maybefcs, proto_eth);
+  eth_withoutfcs_handle = register_dissector_stateless("eth_withoutfcs", dissect_eth_withoutfcs, proto_eth);
+  register_dissector_stateless("eth_withfcs", dissect_eth_withfcs, proto_eth);
+  eth_maybefcs_handle = register_dissector_stateless("eth_maybefcs", dissect_eth_maybefcs, proto_eth);
   eth_tap = register_tap("eth");
 
   register_conversation_table(proto_eth, TRUE, eth_conversation_packet, eth_hostlist_packet);
@@ -115,6 +115,7 @@ static gboolean generate_md5_hash   = FALSE;
 static gboolean generate_epoch_time = TRUE;
 static gboolean generate_bits_field = TRUE;
 static gboolean disable_packet_size_limited_in_summary = FALSE;
+static gboolean skip_outbound_checksums = FALSE;
 
 static const value_string p2p_dirs[] = {
 	{ P2P_DIR_UNKNOWN, "Unknown" },
@@ -257,6 +258,15 @@ frame_seq_analysis_packet( void *ptr, packet_info *pinfo, epan_dissect_t *edt _U
  * be registered when the dissector is used in the frame, not in the
  * proto_register_XXX function.
  */
+gboolean
+frame_checksum_offloaded(packet_info *pinfo)
+{
+	return skip_outbound_checksums &&
+	    pinfo->rec->rec_type == REC_TYPE_PACKET &&
+	    (pinfo->rec->presence_flags & WTAP_HAS_PACK_FLAGS) &&
+	    PACK_FLAGS_DIRECTION(pinfo->rec->rec_header.packet_header.pack_flags) == PACK_FLAGS_DIRECTION_OUTBOUND;
+}
+
 void
 register_frame_end_routine(packet_info *pinfo, void (*func)(void))
 {
@@ -285,6 +295,8 @@ dissect_frame(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, void*
 	frame_data_t *fr_data = (frame_data_t*)data;
 	const color_filter_t *color_filter;
 	dissector_handle_t dissector_handle;
+	const nstime_t *shift_offset;
+	nstime_t     no_shift_offset;
 
 	tree=parent_tree;
 
@@ -635,8 +647,13 @@ dissect_frame(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, void*
 								  " the valid range is 0-1000000000",
 								  (long) pinfo->abs_ts.nsecs);
 			}
+			shift_offset = epan_get_shift_offset(pinfo->epan, pinfo->fd);
+			if (shift_offset == NULL) {
+				nstime_set_zero(&no_shift_offset);
+				shift_offset = &no_shift_offset;
+			}
 			item = proto_tree_add_time(fh_tree, hf_frame_shift_offset, tvb,
-					    0, 0, &(pinfo->fd->shift_offset));
+					    0, 0, shift_offset);
 			proto_item_set_generated(item);
 
 			if (generate_epoch_time) {
@@ -1301,6 +1318,12 @@ proto_register_frame(void)
 	    "Disable 'packet size limited during capture' message in summary",
 	    "Whether or not 'packet size limited during capture' message in shown in Info column.",
 	    &disable_packet_size_limited_in_summary);
+	prefs_register_bool_preference(frame_module, "skip_outbound_checksums",
+	    "Don't validate checksums of outbound frames",
+	    "Whether IPv4, TCP and UDP checksums should be left unverified in frames that the capture file "
+	    "marks as outbound, whose checksums are usually filled in by the network adapter after the frame "
+	    "was captured (\"checksum offload\").",
+	    &skip_outbound_checksums);
 
 	frame_tap=register_tap("frame");
 }
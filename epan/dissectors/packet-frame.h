@@ -18,3 +18,13 @@
  */
 void
 register_frame_end_routine(packet_info *pinfo, void (*func)(void));
+
+/*
+ * Should checksums in this frame be left unverified because the network
+ * adapter computes them after the capture point?  That's the case for
+ * outbound frames, according to the pcapng EPB flags, if the user asked
+ * for it; pcapng has no way to say that an inbound frame's checksums
+ * were verified by the adapter.
+ */
+gboolean
+frame_checksum_offloaded(packet_info *pinfo);
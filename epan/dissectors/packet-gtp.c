@@ -2408,82 +2408,90 @@ guint32 gtp_session_count;
 
 /* Relation between frame -> session */
 GHashTable* session_table;
-/* Relation between <teid,ip> -> frame */
-wmem_tree_t* frame_tree;
-
+/* Relation between <ip,teid> -> the frames that set it up, newest first */
 typedef struct {
+    address ip;
     guint32 teid;
-    guint32 frame;
-} gtp_info_t;
+} gtp_teid_key_t;
+
+static wmem_map_t *teid_frame_map;
+/* Relation between frame -> the <ip,teid>s it set up */
+static wmem_map_t *frame_teid_map;
+/* Relation between session -> the frames added to it; a frame may since
+ * have been added to another session */
+static wmem_map_t *session_frame_map;
+
+static guint
+gtp_teid_key_hash(gconstpointer k)
+{
+    const gtp_teid_key_t *key = (const gtp_teid_key_t *)k;
+
+    return add_address_to_hash(key->teid, &key->ip);
+}
+
+static gboolean
+gtp_teid_key_equal(gconstpointer k1, gconstpointer k2)
+{
+    const gtp_teid_key_t *key1 = (const gtp_teid_key_t *)k1;
+    const gtp_teid_key_t *key2 = (const gtp_teid_key_t *)k2;
+
+    return key1->teid == key2->teid && addresses_equal(&key1->ip, &key2->ip);
+}
 
 /* GTP Session funcs*/
 guint32
 get_frame(address ip, guint32 teid, guint32 *frame) {
-    gboolean found = FALSE;
-    wmem_list_frame_t *elem;
-    gtp_info_t *info;
-    wmem_list_t *info_list;
-    gchar *ip_str;
-
-    /* First we get the teid list*/
-    ip_str = address_to_str(wmem_packet_scope(), &ip);
-    info_list = (wmem_list_t*)wmem_tree_lookup_string(frame_tree, ip_str, 0);
-    if (info_list != NULL) {
-        elem = wmem_list_head(info_list);
-        while (!found && elem) {
-            info = (gtp_info_t*)wmem_list_frame_data(elem);
-            if (teid == info->teid) {
-                *frame = info->frame;
-                return 1;
-            }
-            elem = wmem_list_frame_next(elem);
-        }
+    gtp_teid_key_t key;
+    wmem_list_t *frames;
+
+    key.ip = ip;
+    key.teid = teid;
+    frames = (wmem_list_t*)wmem_map_lookup(teid_frame_map, &key);
+    if (frames != NULL && wmem_list_count(frames) > 0) {
+        *frame = GPOINTER_TO_UINT(wmem_list_frame_data(wmem_list_head(frames)));
+        return 1;
     }
     return 0;
 }
 
-static gboolean
-call_foreach_ip(const void *key _U_, void *value, void *data){
-    wmem_list_frame_t * elem;
-    wmem_list_t *info_list = (wmem_list_t *)value;
-    gtp_info_t *info;
-    guint32* frame = (guint32*)data;
-
-    /* We loop over the <teid, frame> list */
-    elem = wmem_list_head(info_list);
-    while (elem) {
-        info = (gtp_info_t*)wmem_list_frame_data(elem);
-        if (info->frame == *frame) {
-            wmem_list_frame_t * del = elem;
-            /* proceed to next request */
-            elem = wmem_list_frame_next(elem);
-            /* If we find the frame we remove its information from the list */
-            wmem_list_remove_frame(info_list, del);
-            wmem_free(wmem_file_scope(), info);
-        }
-        else {
-            elem = wmem_list_frame_next(elem);
-        }
-    }
-
-    return FALSE;
-}
-
 void
 remove_frame_info(guint32 *f) {
-    /* For each ip node */
-    wmem_tree_foreach(frame_tree, call_foreach_ip, (void *)f);
+    wmem_list_t *keys;
+    wmem_list_frame_t *elem;
+    wmem_list_t *frames;
+
+    keys = (wmem_list_t*)wmem_map_remove(frame_teid_map, GUINT_TO_POINTER(*f));
+    if (keys == NULL) {
+        return;
+    }
+
+    /* For each <ip,teid> the frame set up */
+    for (elem = wmem_list_head(keys); elem; elem = wmem_list_frame_next(elem)) {
+        frames = (wmem_list_t*)wmem_map_lookup(teid_frame_map, wmem_list_frame_data(elem));
+        if (frames != NULL) {
+            wmem_list_remove(frames, GUINT_TO_POINTER(*f));
+        }
+    }
+    wmem_destroy_list(keys);
 }
 
 void
 add_gtp_session(guint32 frame, guint32 session) {
     guint32 *f, *session_count;
+    wmem_array_t *frames;
 
     f = wmem_new0(wmem_file_scope(), guint32);
     session_count = wmem_new0(wmem_file_scope(), guint32);
     *f = frame;
     *session_count = session;
     g_hash_table_insert(session_table, f, session_count);
+
+    frames = (wmem_array_t*)wmem_map_lookup(session_frame_map, GUINT_TO_POINTER(session));
+    if (frames == NULL) {
+        frames = wmem_array_new(wmem_file_scope(), sizeof(guint32));
+        wmem_map_insert(session_frame_map, GUINT_TO_POINTER(session), frames);
+    }
+    wmem_array_append_one(frames, frame);
 }
 
 gboolean
@@ -2516,67 +2524,67 @@ ip_exists(address ip, wmem_list_t *ip_list) {
     return found;
 }
 
-static gboolean
-info_exists(gtp_info_t *wanted, wmem_list_t *info_list) {
-    wmem_list_frame_t *elem;
-    gtp_info_t *info;
-    gboolean found;
-    found = FALSE;
-    elem = wmem_list_head(info_list);
-    while (!found && elem) {
-        info = (gtp_info_t*)wmem_list_frame_data(elem);
-        found = wanted->teid == info->teid;
-        elem = wmem_list_frame_next(elem);
+/* Remove the information of all the frames still in a session */
+static void
+remove_session_info(guint32 session) {
+    wmem_array_t *frames;
+    guint32 fr, *fr_session;
+    guint i;
+
+    frames = (wmem_array_t*)wmem_map_lookup(session_frame_map, GUINT_TO_POINTER(session));
+    if (frames == NULL) {
+        return;
+    }
+
+    for (i = 0; i < wmem_array_get_count(frames); i++) {
+        fr = *(guint32*)wmem_array_index(frames, i);
+        fr_session = (guint32 *)g_hash_table_lookup(session_table, &fr);
+        if (fr_session != NULL && *fr_session == session) {
+            remove_frame_info(&fr);
+        }
     }
-    return found;
 }
 
 void
 fill_map(wmem_list_t *teid_list, wmem_list_t *ip_list, guint32 frame) {
     wmem_list_frame_t *elem_ip, *elem_teid;
-    gtp_info_t *gtp_info;
-    wmem_list_t * info_list; /* List of <teids,frames>*/
-    guint32 *f, *session, *fr, *session_count;
-    GHashTableIter iter;
-    guint32 teid;
-    gchar *ip;
+    gtp_teid_key_t key, *teid_key;
+    wmem_list_t *frames; /* List of the frames setting up an <ip,teid> */
+    wmem_list_t *keys;
+    guint32 *session;
 
     elem_ip = wmem_list_head(ip_list);
     while (elem_ip) {
-        ip = address_to_str(wmem_file_scope(), (address*)wmem_list_frame_data(elem_ip));
-        /* We check if a teid list exists for this ip */
-        info_list = (wmem_list_t*)wmem_tree_lookup_string(frame_tree, ip, 0);
-        if (info_list == NULL) {
-            info_list = wmem_list_new(wmem_file_scope());
-        }
+        key.ip = *(address*)wmem_list_frame_data(elem_ip);
         /* We loop over the teid list */
         elem_teid = wmem_list_head(teid_list);
         while (elem_teid) {
-            teid = *(guint32*)wmem_list_frame_data(elem_teid);
-            f = wmem_new0(wmem_file_scope(), guint32);
-            *f = frame;
-            gtp_info = wmem_new0(wmem_file_scope(), gtp_info_t);
-            gtp_info->teid = teid;
-            gtp_info->frame = *f;
-            if (info_exists(gtp_info, info_list)) {
+            key.teid = *(guint32*)wmem_list_frame_data(elem_teid);
+            if (!wmem_map_lookup_extended(teid_frame_map, &key, (const void **)&teid_key, (void **)&frames)) {
+                teid_key = wmem_new(wmem_file_scope(), gtp_teid_key_t);
+                copy_address_wmem(wmem_file_scope(), &teid_key->ip, &key.ip);
+                teid_key->teid = key.teid;
+                frames = wmem_list_new(wmem_file_scope());
+                wmem_map_insert(teid_frame_map, teid_key, frames);
+            } else if (wmem_list_count(frames) > 0) {
                 /* If the teid and ip already existed, that means that we need to remove old info about that session */
                 /* We look for its session ID */
-                session = (guint32 *)g_hash_table_lookup(session_table, f);
+                session = (guint32 *)g_hash_table_lookup(session_table, &frame);
                 if (session) {
-                    g_hash_table_iter_init(&iter, session_table);
-                    while (g_hash_table_iter_next(&iter, (gpointer*)&fr, (gpointer*)&session_count)) {
-                        /* If the msg has the same session ID and it's not the upd req we have to remove its info */
-                        if (*session_count == *session) {
-                            /* If it's the session we are looking for, we remove all the frame information */
-                            remove_frame_info(fr);
-                        }
-                    }
+                    remove_session_info(*session);
                 }
             }
-            wmem_list_prepend(info_list, gtp_info);
+            wmem_list_prepend(frames, GUINT_TO_POINTER(frame));
+
+            keys = (wmem_list_t*)wmem_map_lookup(frame_teid_map, GUINT_TO_POINTER(frame));
+            if (keys == NULL) {
+                keys = wmem_list_new(wmem_file_scope());
+                wmem_map_insert(frame_teid_map, GUINT_TO_POINTER(frame), keys);
+            }
+            wmem_list_prepend(keys, teid_key);
+
             elem_teid = wmem_list_frame_next(elem_teid);
         }
-        wmem_tree_insert_string(frame_tree, ip, info_list, 0);
         elem_ip = wmem_list_frame_next(elem_ip);
     }
 }
@@ -10179,7 +10187,9 @@ gtp_init(void)
 {
     gtp_session_count = 1;
     session_table = g_hash_table_new(g_int_hash, g_int_equal);
-    frame_tree = wmem_tree_new(wmem_file_scope());
+    teid_frame_map = wmem_map_new(wmem_file_scope(), gtp_teid_key_hash, gtp_teid_key_equal);
+    frame_teid_map = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
+    session_frame_map = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
 }
 
 static void
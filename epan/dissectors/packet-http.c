@@ -352,7 +352,7 @@ http_eo_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const
 	if(eo_info) { /* We have data waiting for us */
 		/* These values will be freed when the Export Object window
 		 * is closed. */
-		entry = g_new(export_object_entry_t, 1);
+		entry = g_new0(export_object_entry_t, 1);
 
 		entry->pkt_num = pinfo->num;
 		entry->hostname = g_strdup(eo_info->hostname);
@@ -4250,6 +4250,7 @@ proto_register_http(void)
 
 	register_follow_stream(proto_http, "http_follow", tcp_follow_conv_filter, tcp_follow_index_filter, tcp_follow_address_filter,
 							tcp_port_to_display, follow_tvb_tap_listener);
+	register_follow_stream_frames(proto_http, tcp_follow_stream_frames);
 	http_eo_tap = register_export_object(proto_http, http_eo_packet, NULL);
 }
 
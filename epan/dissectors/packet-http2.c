@@ -115,10 +115,10 @@ typedef struct {
     gint length;
     union {
         struct {
-            /* header data */
-            char *data;
-            /* length of data */
-            guint datalen;
+            /* header name and value, each as a length (uint32) followed
+               by the string, interned in http2_hdrcache_map */
+            const char *name;
+            const char *value;
             /* name index or name/value index if type is one of
                HTTP2_HD_INDEXED and HTTP2_HD_*_INDEXED_NAMEs */
             guint idx;
@@ -515,11 +515,11 @@ static const fragment_items http2_body_fragment_items = {
    header fields (e.g., 4KiB).  Allocating each of them requires lots
    of memory.  The maximum compression is achieved in HPACK by
    referencing header field stored in dynamic table by one or two
-   bytes.  We reduce memory usage by caching header field in this
-   wmem_map_t to reuse its memory region when we see the same header
-   field next time. */
+   bytes.  We reduce memory usage by caching header names and values
+   in this wmem_map_t to reuse their memory regions when we see the
+   same name or value next time. */
 static wmem_map_t *http2_hdrcache_map = NULL;
-/* Header name_length + name + value_length + value */
+/* Header name or value length + name or value */
 static char *http2_header_pstr = NULL;
 #endif
 
@@ -1460,15 +1460,13 @@ process_http2_header_repr_info(wmem_array_t *headers,
 
         if(header_repr_info->complete) {
             if(header_repr_info->type == HTTP2_HD_HEADER_TABLE_SIZE_UPDATE) {
-                http2_header_t *out;
+                http2_header_t out;
 
-                out = wmem_new(wmem_file_scope(), http2_header_t);
+                out.type = header_repr_info->type;
+                out.length = i - start;
+                out.table.header_table_size = header_repr_info->integer;
 
-                out->type = header_repr_info->type;
-                out->length = i - start;
-                out->table.header_table_size = header_repr_info->integer;
-
-                wmem_array_append(headers, out, 1);
+                wmem_array_append_one(headers, out);
 
                 reset_http2_header_repr_info(header_repr_info);
                 /* continue to decode header table size update or
@@ -1487,12 +1485,11 @@ process_http2_header_repr_info(wmem_array_t *headers,
 static size_t http2_hdrcache_length(gconstpointer vv)
 {
     const guint8 *v = (const guint8 *)vv;
-    guint32 namelen, valuelen;
+    guint32 len;
 
-    namelen = pntoh32(v);
-    valuelen = pntoh32(v + sizeof(namelen) + namelen);
+    len = pntoh32(v);
 
-    return namelen + valuelen + sizeof(namelen) + sizeof(valuelen);
+    return len + sizeof(len);
 }
 
 static guint http2_hdrcache_hash(gconstpointer key)
@@ -1510,6 +1507,39 @@ static gboolean http2_hdrcache_equal(gconstpointer lhs, gconstpointer rhs)
     return alen == blen && memcmp(a, b, alen) == 0;
 }
 
+/* Return the cached copy of a header name or value, prefixed with its
+   length, adding it to http2_hdrcache_map if it isn't there yet. */
+static const char *
+http2_hdrcache_intern(const guint8 *str, size_t len)
+{
+    char *cached_pstr;
+
+    http2_header_pstr = (char *)wmem_realloc(wmem_file_scope(), http2_header_pstr, 4 + len);
+
+    /* len is of size_t.  In order to get length in 4 bytes, we have to
+       copy it to guint32. */
+    phton32(&http2_header_pstr[0], (guint32)len);
+    memcpy(&http2_header_pstr[4], str, len);
+
+    cached_pstr = (char *)wmem_map_lookup(http2_hdrcache_map, http2_header_pstr);
+    if (!cached_pstr) {
+        cached_pstr = http2_header_pstr;
+        wmem_map_insert(http2_hdrcache_map, cached_pstr, cached_pstr);
+        http2_header_pstr = NULL;
+    }
+
+    return cached_pstr;
+}
+
+/* length of the decompressed header, as name length, name, value length
+   and value */
+static guint
+http2_header_datalen(const http2_header_t *hdr)
+{
+    return (guint)(http2_hdrcache_length(hdr->table.data.name) +
+                   http2_hdrcache_length(hdr->table.data.value));
+}
+
 static int
 is_in_header_context(tvbuff_t *tvb, packet_info *pinfo, http2_session_t* h2session)
 {
@@ -1774,6 +1804,7 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, guint offset, prot
     http2_header_repr_info_t *header_repr_info;
     wmem_list_t *header_list;
     wmem_array_t *headers;
+    wmem_array_t *frame_headers;
     guint i;
     const gchar *method_header_value = NULL;
     const gchar *path_header_value = NULL;
@@ -1809,13 +1840,15 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, guint offset, prot
 
         final = flags & HTTP2_FLAGS_END_HEADERS;
 
-        headers = wmem_array_sized_new(wmem_file_scope(), sizeof(http2_header_t), 16);
+        /* collected for this frame only, and copied into an array of
+           the right size for the capture file once it's known */
+        frame_headers = wmem_array_sized_new(wmem_packet_scope(), sizeof(http2_header_t), 16);
 
         for(;;) {
             nghttp2_nv nv;
             int inflate_flags = 0;
 
-            if (wmem_array_get_count(headers) >= MAX_HTTP2_HEADER_LINES) {
+            if (wmem_array_get_count(frame_headers) >= MAX_HTTP2_HEADER_LINES) {
                 header_data->header_lines_exceeded = TRUE;
                 break;
             }
@@ -1830,13 +1863,11 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, guint offset, prot
             headbuf += rv;
             headlen -= rv;
 
-            rv -= process_http2_header_repr_info(headers, header_repr_info, headbuf - rv, rv);
+            rv -= process_http2_header_repr_info(frame_headers, header_repr_info, headbuf - rv, rv);
 
             if(inflate_flags & NGHTTP2_HD_INFLATE_EMIT) {
-                char *cached_pstr;
-                guint32 len;
                 guint datalen = (guint)(4 + nv.namelen + 4 + nv.valuelen);
-                http2_header_t *out;
+                http2_header_t out;
 
                 if (decompressed_bytes + datalen >= MAX_HTTP2_HEADER_SIZE) {
                     header_data->header_size_reached = decompressed_bytes;
@@ -1844,44 +1875,21 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, guint offset, prot
                     break;
                 }
 
-                out = wmem_new(wmem_file_scope(), http2_header_t);
+                out.type = header_repr_info->type;
+                out.length = rv;
+                out.table.data.idx = header_repr_info->integer;
 
-                out->type = header_repr_info->type;
-                out->length = rv;
-                out->table.data.idx = header_repr_info->integer;
-
-                out->table.data.datalen = datalen;
                 decompressed_bytes += datalen;
 
-                /* Prepare buffer... with the following format
-                   name length (uint32)
-                   name (string)
-                   value length (uint32)
-                   value (string)
+                /* Names repeat in most header blocks, and values often do,
+                   so they are cached separately, each with the format
+                   length (uint32)
+                   name or value (string)
                 */
-                http2_header_pstr = (char *)wmem_realloc(wmem_file_scope(), http2_header_pstr, out->table.data.datalen);
-
-                /* nv.namelen and nv.valuelen are of size_t.  In order
-                   to get length in 4 bytes, we have to copy it to
-                   guint32. */
-                len = (guint32)nv.namelen;
-                phton32(&http2_header_pstr[0], len);
-                memcpy(&http2_header_pstr[4], nv.name, nv.namelen);
-
-                len = (guint32)nv.valuelen;
-                phton32(&http2_header_pstr[4 + nv.namelen], len);
-                memcpy(&http2_header_pstr[4 + nv.namelen + 4], nv.value, nv.valuelen);
-
-                cached_pstr = (char *)wmem_map_lookup(http2_hdrcache_map, http2_header_pstr);
-                if (cached_pstr) {
-                    out->table.data.data = cached_pstr;
-                } else {
-                    wmem_map_insert(http2_hdrcache_map, http2_header_pstr, http2_header_pstr);
-                    out->table.data.data = http2_header_pstr;
-                    http2_header_pstr = NULL;
-                }
+                out.table.data.name = http2_hdrcache_intern(nv.name, nv.namelen);
+                out.table.data.value = http2_hdrcache_intern(nv.value, nv.valuelen);
 
-                wmem_array_append(headers, out, 1);
+                wmem_array_append_one(frame_headers, out);
 
                 reset_http2_header_repr_info(header_repr_info);
             }
@@ -1895,6 +1903,9 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, guint offset, prot
             }
         }
 
+        headers = wmem_array_sized_new(wmem_file_scope(), sizeof(http2_header_t), wmem_array_get_count(frame_headers));
+        wmem_array_append(headers, wmem_array_get_raw(frame_headers), wmem_array_get_count(frame_headers));
+
         wmem_list_append(header_list, headers);
 
         if(!header_data->current) {
@@ -1926,6 +1937,7 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, guint offset, prot
     for(i = 0; i < wmem_array_get_count(headers); ++i) {
         http2_header_t *in;
         tvbuff_t *next_tvb;
+        guint datalen;
 
         in = (http2_header_t*)wmem_array_index(headers, i);
 
@@ -1933,10 +1945,14 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, guint offset, prot
             continue;
         }
 
-        header_len += in->table.data.datalen;
+        header_len += http2_header_datalen(in);
 
         /* Now setup the tvb buffer to have the new data */
-        next_tvb = tvb_new_child_real_data(tvb, in->table.data.data, in->table.data.datalen, in->table.data.datalen);
+        datalen = (guint)http2_hdrcache_length(in->table.data.name);
+        next_tvb = tvb_new_child_real_data(tvb, (const guint8 *)in->table.data.name, datalen, datalen);
+        tvb_composite_append(header_tvb, next_tvb);
+        datalen = (guint)http2_hdrcache_length(in->table.data.value);
+        next_tvb = tvb_new_child_real_data(tvb, (const guint8 *)in->table.data.value, datalen, datalen);
         tvb_composite_append(header_tvb, next_tvb);
     }
 
@@ -2854,7 +2870,7 @@ http2_get_header_value(packet_info *pinfo, const gchar* name, gboolean the_other
     guint32 name_len;
     guint32 value_len;
     http2_header_t *hdr;
-    gchar* data;
+    const gchar* data;
 
     conversation_t* conversation = find_or_create_conversation(pinfo);
     header_stream_info = get_header_stream_info(pinfo, get_http2_session(pinfo, conversation), the_other_direction);
@@ -2877,23 +2893,17 @@ http2_get_header_value(packet_info *pinfo, const gchar* name, gboolean the_other
                 continue;
             }
 
-            /* parsing data as format:
-                   name length (uint32)
-                   name (string)
-                   value length (uint32)
-                   value (string)
+            /* parsing name and value as format:
+                   length (uint32)
+                   name or value (string)
             */
-            data = (gchar*) hdr->table.data.data;
+            data = hdr->table.data.name;
             name_len = pntoh32(data);
             if (strlen(name) == name_len && strncmp(data + 4, name, name_len) == 0) {
-                value_len = pntoh32(data + 4 + name_len);
-                if (4 + name_len + 4 + value_len == hdr->table.data.datalen) {
-                    /* return value */
-                    return wmem_strndup(wmem_packet_scope(), data + 4 + name_len + 4, value_len);
-                }
-                else {
-                    return NULL; /* unexpected error */
-                }
+                data = hdr->table.data.value;
+                value_len = pntoh32(data);
+                /* return value */
+                return wmem_strndup(wmem_packet_scope(), data + 4, value_len);
             }
         }
     }
@@ -4107,6 +4117,7 @@ proto_register_http2(void)
 
     register_follow_stream(proto_http2, "http2_follow", http2_follow_conv_filter, http2_follow_index_filter, tcp_follow_address_filter,
                            tcp_port_to_display, follow_tvb_tap_listener);
+    register_follow_stream_frames(proto_http2, tcp_follow_stream_frames);
 }
 
 static void http2_stats_tree_init(stats_tree* st)
@@ -41,6 +41,7 @@
 #include <wsutil/str_util.h>
 
 #include "packet-ip.h"
+#include "packet-frame.h"
 #include "packet-juniper.h"
 #include "packet-sflow.h"
 #include "packet-gre.h"
@@ -2036,7 +2037,8 @@ dissect_ip_v4(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, void*
    * If checksum checking is enabled, and we have the entire IP header
    * available, check the checksum.
    */
-  if (ip_check_checksum && tvb_bytes_exist(tvb, offset, hlen)) {
+  if (ip_check_checksum && !frame_checksum_offloaded(pinfo) &&
+      tvb_bytes_exist(tvb, offset, hlen)) {
     ipsum = ip_checksum_tvb(tvb, offset, hlen);
     item = proto_tree_add_checksum(ip_tree, tvb, offset + 10, hf_ip_checksum, hf_ip_checksum_status, &ei_ip_checksum_bad, pinfo, ipsum,
                                 ENC_BIG_ENDIAN, PROTO_CHECKSUM_VERIFY|PROTO_CHECKSUM_IN_CKSUM);
@@ -2085,9 +2087,11 @@ dissect_ip_v4(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, void*
                                         offset + 10, 2, iph->ip_sum,
                                         "0x%04x [%s]",
                                         iph->ip_sum,
-                                        ip_check_checksum ?
-                                            "not all data available" :
-                                            "validation disabled");
+                                        !ip_check_checksum ?
+                                            "validation disabled" :
+                                        frame_checksum_offloaded(pinfo) ?
+                                            "outbound, possibly offloaded" :
+                                            "not all data available");
     item = proto_tree_add_uint(ip_tree, hf_ip_checksum_status, tvb,
                                     offset + 10, 0, PROTO_CHECKSUM_E_UNVERIFIED);
     proto_item_set_generated(item);
@@ -2952,6 +2956,7 @@ proto_register_ip(void)
     "Show IPv4 summary in protocol tree",
     "Whether the IPv4 summary line should be shown in the protocol tree",
     &ip_summary_in_tree);
+  prefs_set_preference_effect_display(ip_module, "summary_in_tree");
   prefs_register_bool_preference(ip_module, "check_checksum",
   "Validate the IPv4 checksum if possible",
   "Whether to validate the IPv4 checksum", &ip_check_checksum);
@@ -3738,6 +3738,7 @@ proto_register_ipv6(void)
                                    "Show IPv6 summary in protocol tree",
                                    "Whether the IPv6 summary line should be shown in the protocol tree",
                                    &ipv6_summary_in_tree);
+    prefs_set_preference_effect_display(ipv6_module, "summary_in_tree");
     prefs_register_bool_preference(ipv6_module, "use_geoip" ,
                                    "Enable IPv6 geolocation",
                                    "Whether to look up IPv6 addresses in each MaxMind database we have loaded",
@@ -18,7 +18,6 @@
 #include "config.h"
 
 #include <epan/packet.h>
-#include <epan/tvbparse.h>
 #include <epan/proto_data.h>
 #include <wsutil/wsjson.h>
 
@@ -33,7 +32,7 @@
 
 void proto_register_json(void);
 void proto_reg_handoff_json(void);
-static char *json_string_unescape(tvbparse_elem_t *tok);
+static char *json_string_unescape(tvbuff_t *tvb, int offset, int len);
 
 static dissector_handle_t json_handle;
 
@@ -122,27 +121,22 @@ typedef struct {
 
 /* Preferences */
 static gboolean json_compact = FALSE;
-
-static tvbparse_wanted_t* want;
-static tvbparse_wanted_t* want_ignore;
+static gboolean json_keep_tapes = TRUE;
 
 static dissector_handle_t text_lines_handle;
 
-typedef enum {
-	JSON_TOKEN_INVALID = -1,
-	JSON_TOKEN_NUMBER = 0,
-	JSON_TOKEN_STRING,
-	JSON_TOKEN_FALSE,
-	JSON_TOKEN_NULL,
-	JSON_TOKEN_TRUE,
-
-	/* not really tokens ... */
-	JSON_OBJECT,
-	JSON_ARRAY
-
-} json_token_type_t;
+/* The values of the JSON texts at the start of a tvbuff, as found by
+ * json_tape_parse(); kept, if json_keep_tapes, so that dissecting the
+ * frame again doesn't parse them again. */
+typedef struct {
+	guint			len;		/* of the tvbuff */
+	guint			parsed_len;	/* of the JSON texts */
+	guint			n_entries;
+	json_tape_entry_t	*entries;
+} json_tape_t;
 
 typedef struct {
+	tvbuff_t *tvb;
 	wmem_stack_t *stack;
 	wmem_stack_t *stack_compact; /* Used for compact json form only */
 	wmem_stack_t *array_idx;	/* Used for compact json form only.
@@ -157,9 +151,9 @@ typedef struct {
 #define JSON_COMPACT_OBJECT_WITHOUT_KEY -1
 #define JSON_COMPACT_ARRAY 0
 
-#define JSON_ARRAY_BEGIN(json_tvbparse_data) wmem_stack_push(json_tvbparse_data->array_idx, GINT_TO_POINTER(JSON_COMPACT_ARRAY))
-#define JSON_OBJECT_BEGIN(json_tvbparse_data) wmem_stack_push(json_tvbparse_data->array_idx, GINT_TO_POINTER(JSON_COMPACT_OBJECT_WITHOUT_KEY))
-#define JSON_ARRAY_OBJECT_END(json_tvbparse_data) wmem_stack_pop(json_tvbparse_data->array_idx)
+#define JSON_ARRAY_BEGIN(data) wmem_stack_push(data->array_idx, GINT_TO_POINTER(JSON_COMPACT_ARRAY))
+#define JSON_OBJECT_BEGIN(data) wmem_stack_push(data->array_idx, GINT_TO_POINTER(JSON_COMPACT_OBJECT_WITHOUT_KEY))
+#define JSON_ARRAY_OBJECT_END(data) wmem_stack_pop(data->array_idx)
 #define JSON_INSIDE_ARRAY(idx) (idx >= JSON_COMPACT_ARRAY)
 #define JSON_OBJECT_SET_HAS_KEY(idx) (idx == JSON_COMPACT_OBJECT_WITH_KEY)
 
@@ -178,6 +172,9 @@ json_object_add_key(json_parser_data_t *data)
 	wmem_stack_push(data->array_idx, GINT_TO_POINTER(JSON_COMPACT_OBJECT_WITH_KEY));
 }
 
+static json_tape_t *json_get_tape(tvbuff_t *tvb, packet_info *pinfo);
+static void json_dissect_tape(json_parser_data_t *data, const json_tape_t *tape);
+
 static int
 dissect_json(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data)
 {
@@ -185,7 +182,7 @@ dissect_json(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data)
 	proto_item *ti = NULL;
 
 	json_parser_data_t parser_data;
-	tvbparse_t *tt;
+	json_tape_t *tape;
 
 	http_message_info_t *message_info;
 	const char *data_name;
@@ -193,6 +190,7 @@ dissect_json(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data)
 
 	/* Save pinfo*/
 	parser_data.pinfo = pinfo;
+	parser_data.tvb = tvb;
 	/* JSON dissector can be called in a JSON native file or when transported
 	 * by another protocol, will make entry in the Protocol column on summary display accordingly
 	 */
@@ -258,13 +256,14 @@ dissect_json(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data)
 	}
 
 
-	tt = tvbparse_init(tvb, offset, -1, &parser_data, want_ignore);
+	tape = json_get_tape(tvb, pinfo);
 
-	/* XXX, only one json in packet? */
-	while ((tvbparse_get(tt, want)))
-		;
+	/* Without a tree, only the length is wanted, unless the decoders
+	 * of the compact form have to see the values */
+	if (tree || json_compact)
+		json_dissect_tape(&parser_data, tape);
 
-	offset = tvbparse_curr_offset(tt);
+	offset = tape->parsed_len;
 
 	proto_item_set_len(ti, offset);
 
@@ -291,14 +290,12 @@ dissect_json_file(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* dat
 	return dissect_json(tvb, pinfo, tree, NULL);
 }
 
-static void before_object(void *tvbparse_data, const void *wanted_data _U_, tvbparse_elem_t *tok) {
-	json_parser_data_t *data = (json_parser_data_t *) tvbparse_data;
-
+static void before_object(json_parser_data_t *data, const json_tape_entry_t *tok) {
 	proto_tree *tree = (proto_tree *)wmem_stack_peek(data->stack);
 	proto_tree *subtree;
 	proto_item *ti;
 
-	ti = proto_tree_add_item(tree, &hfi_json_object, tok->tvb, tok->offset, tok->len, ENC_NA);
+	ti = proto_tree_add_item(tree, &hfi_json_object, data->tvb, tok->offset, tok->len, ENC_NA);
 
 	subtree = proto_item_add_subtree(ti, ett_json_object);
 	wmem_stack_push(data->stack, subtree);
@@ -311,7 +308,7 @@ static void before_object(void *tvbparse_data, const void *wanted_data _U_, tvbp
 		gint idx = GPOINTER_TO_INT(wmem_stack_peek(data->array_idx));
 
 		if (JSON_INSIDE_ARRAY(idx)) {
-			ti_compact = proto_tree_add_none_format(tree_compact, &hfi_json_object_compact, tok->tvb, tok->offset, tok->len, "%d:", idx);
+			ti_compact = proto_tree_add_none_format(tree_compact, &hfi_json_object_compact, data->tvb, tok->offset, tok->len, "%d:", idx);
 			subtree_compact = proto_item_add_subtree(ti_compact, ett_json_object_compact);
 			json_array_index_increment(data);
 		} else {
@@ -323,9 +320,7 @@ static void before_object(void *tvbparse_data, const void *wanted_data _U_, tvbp
 	}
 }
 
-static void after_object(void *tvbparse_data, const void *wanted_data _U_, tvbparse_elem_t *elem _U_) {
-	json_parser_data_t *data = (json_parser_data_t *) tvbparse_data;
-
+static void after_object(json_parser_data_t *data) {
 	wmem_stack_pop(data->stack);
 
 	if (json_compact) {
@@ -348,7 +343,7 @@ static void after_object(void *tvbparse_data, const void *wanted_data _U_, tvbpa
 static GHashTable* header_fields_hash = NULL;
 
 static proto_item*
-json_key_lookup(proto_tree* tree, tvbparse_elem_t* tok, char* key_str, packet_info* pinfo)
+json_key_lookup(proto_tree* tree, tvbuff_t* tvb, int offset, int len, char* key_str, packet_info* pinfo)
 {
 	proto_item* ti;
 	int hf_id = -1;
@@ -365,21 +360,24 @@ json_key_lookup(proto_tree* tree, tvbparse_elem_t* tok, char* key_str, packet_in
 	hfi = proto_registrar_get_nth(hf_id);
 	DISSECTOR_ASSERT(hfi != NULL);
 
-	ti = proto_tree_add_item(tree, hfi, tok->tvb, tok->offset + (4 + str_len), tok->len - (5 + str_len), ENC_NA);
+	ti = proto_tree_add_item(tree, hfi, tvb, offset + (4 + str_len), len - (5 + str_len), ENC_NA);
 	if (json_data_decoder_rec->json_data_decoder) {
-		(*json_data_decoder_rec->json_data_decoder)(tok->tvb, tree, pinfo, tok->offset + (4 + str_len), tok->len - (5 + str_len));
+		(*json_data_decoder_rec->json_data_decoder)(tvb, tree, pinfo, offset + (4 + str_len), len - (5 + str_len));
 	}
 	return ti;
 
 }
-static void before_member(void *tvbparse_data, const void *wanted_data _U_, tvbparse_elem_t *tok) {
-	json_parser_data_t *data = (json_parser_data_t *) tvbparse_data;
+
+/* A member is a key and a value */
+static void before_member(json_parser_data_t *data, const json_tape_entry_t *key_tok, const json_tape_entry_t *value_tok) {
+	int offset = key_tok->offset;
+	int len = value_tok->offset + value_tok->len - key_tok->offset;
 
 	proto_tree *tree = (proto_tree *)wmem_stack_peek(data->stack);
 	proto_tree *subtree;
 	proto_item *ti;
 
-	ti = proto_tree_add_item(tree, &hfi_json_member, tok->tvb, tok->offset, tok->len, ENC_NA);
+	ti = proto_tree_add_item(tree, &hfi_json_member, data->tvb, offset, len, ENC_NA);
 
 	subtree = proto_item_add_subtree(ti, ett_json_member);
 	wmem_stack_push(data->stack, subtree);
@@ -389,16 +387,10 @@ static void before_member(void *tvbparse_data, const void *wanted_data _U_, tvbp
 		proto_tree *subtree_compact;
 		proto_item *ti_compact = NULL;
 
-		tvbparse_elem_t *key_tok = tok->sub;
-
-		if (key_tok && key_tok->id == JSON_TOKEN_STRING) {
-			char *key_str = json_string_unescape(key_tok);
-			ti_compact = json_key_lookup(tree_compact, tok, key_str, data->pinfo);
-			if (!ti_compact) {
-				ti_compact = proto_tree_add_none_format(tree_compact, &hfi_json_member_compact, tok->tvb, tok->offset, tok->len, "%s:", key_str);
-			}
-		} else {
-			ti_compact = proto_tree_add_item(tree_compact, &hfi_json_member_compact, tok->tvb, tok->offset, tok->len, ENC_NA);
+		char *key_str = json_string_unescape(data->tvb, key_tok->offset, key_tok->len);
+		ti_compact = json_key_lookup(tree_compact, data->tvb, offset, len, key_str, data->pinfo);
+		if (!ti_compact) {
+			ti_compact = proto_tree_add_none_format(tree_compact, &hfi_json_member_compact, data->tvb, offset, len, "%s:", key_str);
 		}
 
 		subtree_compact = proto_item_add_subtree(ti_compact, ett_json_member_compact);
@@ -406,20 +398,14 @@ static void before_member(void *tvbparse_data, const void *wanted_data _U_, tvbp
 	}
 }
 
-static void after_member(void *tvbparse_data, const void *wanted_data _U_, tvbparse_elem_t *tok) {
-	json_parser_data_t *data = (json_parser_data_t *) tvbparse_data;
-
+static void after_member(json_parser_data_t *data, const json_tape_entry_t *key_tok) {
 	proto_tree *tree = (proto_tree *)wmem_stack_pop(data->stack);
 
 	if (tree) {
-		tvbparse_elem_t *key_tok = tok->sub;
-
-		if (key_tok && key_tok->id == JSON_TOKEN_STRING) {
-			char *key = json_string_unescape(key_tok);
+		char *key = json_string_unescape(data->tvb, key_tok->offset, key_tok->len);
 
-			proto_tree_add_string(tree, &hfi_json_key, key_tok->tvb, key_tok->offset, key_tok->len, key);
-			proto_item_append_text(tree, " Key: %s", key);
-		}
+		proto_tree_add_string(tree, &hfi_json_key, data->tvb, key_tok->offset, key_tok->len, key);
+		proto_item_append_text(tree, " Key: %s", key);
 	}
 
 	if (json_compact) {
@@ -428,14 +414,12 @@ static void after_member(void *tvbparse_data, const void *wanted_data _U_, tvbpa
 	}
 }
 
-static void before_array(void *tvbparse_data, const void *wanted_data _U_, tvbparse_elem_t *tok) {
-	json_parser_data_t *data = (json_parser_data_t *) tvbparse_data;
-
+static void before_array(json_parser_data_t *data, const json_tape_entry_t *tok) {
 	proto_tree *tree = (proto_tree *)wmem_stack_peek(data->stack);
 	proto_tree *subtree;
 	proto_item *ti;
 
-	ti = proto_tree_add_item(tree, &hfi_json_array, tok->tvb, tok->offset, tok->len, ENC_NA);
+	ti = proto_tree_add_item(tree, &hfi_json_array, data->tvb, tok->offset, tok->len, ENC_NA);
 
 	subtree = proto_item_add_subtree(ti, ett_json_array);
 	wmem_stack_push(data->stack, subtree);
@@ -445,9 +429,7 @@ static void before_array(void *tvbparse_data, const void *wanted_data _U_, tvbpa
 	}
 }
 
-static void after_array(void *tvbparse_data, const void *wanted_data _U_, tvbparse_elem_t *elem _U_) {
-	json_parser_data_t *data = (json_parser_data_t *) tvbparse_data;
-
+static void after_array(json_parser_data_t *data) {
 	wmem_stack_pop(data->stack);
 
 	if (json_compact) {
@@ -488,20 +470,20 @@ json_tvb_memcpy_utf8(char *buf, tvbuff_t *tvb, int offset, int offset_max)
 	return len;
 }
 
-static char *json_string_unescape(tvbparse_elem_t *tok)
+static char *json_string_unescape(tvbuff_t *tvb, int offset, int len)
 {
-	char *str = (char *)wmem_alloc(wmem_packet_scope(), (size_t)tok->len - 1);
+	char *str = (char *)wmem_alloc(wmem_packet_scope(), (size_t)len - 1);
 	int i, j;
 
 	j = 0;
-	for (i = 1; i < tok->len - 1; i++) {
-		guint8 ch = tvb_get_guint8(tok->tvb, tok->offset + i);
+	for (i = 1; i < len - 1; i++) {
+		guint8 ch = tvb_get_guint8(tvb, offset + i);
 		int bin;
 
 		if (ch == '\\') {
 			i++;
 
-			ch = tvb_get_guint8(tok->tvb, tok->offset + i);
+			ch = tvb_get_guint8(tvb, offset + i);
 			switch (ch) {
 				case '\"':
 				case '\\':
@@ -535,7 +517,7 @@ static char *json_string_unescape(tvbparse_elem_t *tok)
 						i++;
 						unicode_hex <<= 4;
 
-						ch = tvb_get_guint8(tok->tvb, tok->offset + i);
+						ch = tvb_get_guint8(tvb, offset + i);
 						bin = ws_xton(ch);
 						if (bin == -1) {
 							valid = FALSE;
@@ -545,11 +527,11 @@ static char *json_string_unescape(tvbparse_elem_t *tok)
 					}
 
 					if ((IS_LEAD_SURROGATE(unicode_hex))) {
-						ch = tvb_get_guint8(tok->tvb, tok->offset + i + 1);
+						ch = tvb_get_guint8(tvb, offset + i + 1);
 
 						if (ch == '\\') {
 							i++;
-							ch = tvb_get_guint8(tok->tvb, tok->offset + i + 1);
+							ch = tvb_get_guint8(tvb, offset + i + 1);
 							if (ch == 'u') {
 								guint16 lead_surrogate = unicode_hex;
 								guint16 trail_surrogate = 0;
@@ -559,7 +541,7 @@ static char *json_string_unescape(tvbparse_elem_t *tok)
 									i++;
 									trail_surrogate <<= 4;
 
-									ch = tvb_get_guint8(tok->tvb, tok->offset + i);
+									ch = tvb_get_guint8(tvb, offset + i);
 									bin = ws_xton(ch);
 									if (bin == -1) {
 										valid = FALSE;
@@ -594,7 +576,7 @@ static char *json_string_unescape(tvbparse_elem_t *tok)
 				}
 
 				default:
-					/* not valid by JSON grammar (also tvbparse rules should not allow it) */
+					/* not valid by JSON grammar (also json_tape_parse() should not allow it) */
 					DISSECTOR_ASSERT_NOT_REACHED();
 					break;
 			}
@@ -604,7 +586,7 @@ static char *json_string_unescape(tvbparse_elem_t *tok)
 
 			str[j] = ch;
 			/* XXX if it's not valid UTF-8 character, add some expert info? (it violates JSON grammar) */
-			utf_len = json_tvb_memcpy_utf8(&str[j], tok->tvb, tok->offset + i, tok->offset + tok->len);
+			utf_len = json_tvb_memcpy_utf8(&str[j], tvb, offset + i, offset + len);
 			j += utf_len;
 			i += (utf_len - 1);
 		}
@@ -615,48 +597,36 @@ static char *json_string_unescape(tvbparse_elem_t *tok)
 	return str;
 }
 
-static void after_value(void *tvbparse_data, const void *wanted_data _U_, tvbparse_elem_t *tok) {
-	json_parser_data_t *data = (json_parser_data_t *) tvbparse_data;
-
+static void after_value(json_parser_data_t *data, const json_tape_entry_t *tok) {
 	proto_tree *tree = (proto_tree *)wmem_stack_peek(data->stack);
-	json_token_type_t value_id = JSON_TOKEN_INVALID;
-
-	if (tok->sub)
-		value_id = (json_token_type_t)tok->sub->id;
+	json_tape_type_t value_id = tok->type;
 
 	switch (value_id) {
-		case JSON_TOKEN_STRING:
-			if (tok->len >= 2)
-				proto_tree_add_string(tree, &hfi_json_value_string, tok->tvb, tok->offset, tok->len, json_string_unescape(tok));
-			else
-				proto_tree_add_item(tree, &hfi_json_value_string, tok->tvb, tok->offset, tok->len, ENC_ASCII|ENC_NA);
+		case JSON_TAPE_STRING:
+			proto_tree_add_string(tree, &hfi_json_value_string, data->tvb, tok->offset, tok->len, json_string_unescape(data->tvb, tok->offset, tok->len));
 			break;
 
-		case JSON_TOKEN_NUMBER:
+		case JSON_TAPE_NUMBER:
 			/* XXX, convert to number */
-			proto_tree_add_item(tree, &hfi_json_value_number, tok->tvb, tok->offset, tok->len, ENC_ASCII|ENC_NA);
+			proto_tree_add_item(tree, &hfi_json_value_number, data->tvb, tok->offset, tok->len, ENC_ASCII|ENC_NA);
 			break;
 
-		case JSON_TOKEN_FALSE:
-			proto_tree_add_item(tree, &hfi_json_value_false, tok->tvb, tok->offset, tok->len, ENC_NA);
+		case JSON_TAPE_FALSE:
+			proto_tree_add_item(tree, &hfi_json_value_false, data->tvb, tok->offset, tok->len, ENC_NA);
 			break;
 
-		case JSON_TOKEN_NULL:
-			proto_tree_add_item(tree, &hfi_json_value_null, tok->tvb, tok->offset, tok->len, ENC_NA);
+		case JSON_TAPE_NULL:
+			proto_tree_add_item(tree, &hfi_json_value_null, data->tvb, tok->offset, tok->len, ENC_NA);
 			break;
 
-		case JSON_TOKEN_TRUE:
-			proto_tree_add_item(tree, &hfi_json_value_true, tok->tvb, tok->offset, tok->len, ENC_NA);
+		case JSON_TAPE_TRUE:
+			proto_tree_add_item(tree, &hfi_json_value_true, data->tvb, tok->offset, tok->len, ENC_NA);
 			break;
 
-		case JSON_OBJECT:
-		case JSON_ARRAY:
+		case JSON_TAPE_OBJECT:
+		case JSON_TAPE_ARRAY:
 			/* already added */
 			break;
-
-		default:
-			proto_tree_add_format_text(tree, tok->tvb, tok->offset, tok->len);
-			break;
 	}
 
 	if (json_compact) {
@@ -664,14 +634,16 @@ static void after_value(void *tvbparse_data, const void *wanted_data _U_, tvbpar
 
 		gint idx = GPOINTER_TO_INT(wmem_stack_peek(data->array_idx));
 
-		char *val_str = tvb_get_string_enc(wmem_packet_scope(), tok->tvb, tok->offset, tok->len, ENC_UTF_8);
+		char *val_str;
 
-		if (value_id == JSON_OBJECT || value_id == JSON_ARRAY) {
+		if (value_id == JSON_TAPE_OBJECT || value_id == JSON_TAPE_ARRAY) {
 			return;
 		}
 
+		val_str = tvb_get_string_enc(wmem_packet_scope(), data->tvb, tok->offset, tok->len, ENC_UTF_8);
+
 		if (JSON_INSIDE_ARRAY(idx)) {
-			proto_tree_add_none_format(tree_compact, &hfi_json_array_item_compact, tok->tvb, tok->offset, tok->len, "%d: %s", idx, val_str);
+			proto_tree_add_none_format(tree_compact, &hfi_json_array_item_compact, data->tvb, tok->offset, tok->len, "%d: %s", idx, val_str);
 			json_array_index_increment(data);
 		} else {
 			proto_item *parent_item = proto_tree_get_parent(tree_compact);
@@ -680,137 +652,118 @@ static void after_value(void *tvbparse_data, const void *wanted_data _U_, tvbpar
 	}
 }
 
-static void init_json_parser(void) {
-	static tvbparse_wanted_t _want_object;
-	static tvbparse_wanted_t _want_array;
-
-	tvbparse_wanted_t *want_object, *want_array;
-	tvbparse_wanted_t *want_member;
-	tvbparse_wanted_t *want_string;
-	tvbparse_wanted_t *want_number, *want_int;
-	tvbparse_wanted_t *want_value;
-	tvbparse_wanted_t *want_value_separator;
-
-#define tvbparse_optional(id, private_data, before_cb, after_cb, wanted) \
-	tvbparse_some(id, 0, 1, private_data, before_cb, after_cb, wanted)
-
-	tvbparse_wanted_t *want_quot = tvbparse_char(-1,"\"",NULL,NULL,NULL);
-
-	want_string = tvbparse_set_seq(JSON_TOKEN_STRING, NULL, NULL, NULL,
-			want_quot,
-			tvbparse_some(-1, 0, G_MAXINT, NULL, NULL, NULL,
-				tvbparse_set_oneof(-1, NULL, NULL, NULL,
-					tvbparse_not_chars(-1, 0, 0, "\"" "\\", NULL, NULL, NULL), /* XXX, without invalid unicode characters */
-					tvbparse_set_seq(-1, NULL, NULL, NULL,
-						tvbparse_char(-1, "\\", NULL, NULL, NULL),
-						tvbparse_set_oneof(-1, NULL, NULL, NULL,
-							tvbparse_chars(-1, 0, 1, "\"" "\\" "/bfnrt", NULL, NULL, NULL),
-							tvbparse_set_seq(-1, NULL, NULL, NULL,
-								tvbparse_char(-1, "u", NULL, NULL, NULL),
-								tvbparse_chars(-1, 4, 4, "0123456789abcdefABCDEF", NULL, NULL, NULL),
-								NULL),
-							NULL),
-						NULL),
-					NULL)
-				),
-			want_quot,
-			NULL);
-
-	want_value_separator = tvbparse_char(-1, ",", NULL, NULL, NULL);
-
-	/* int = zero / ( digit1-9 *DIGIT ) */
-	want_int = tvbparse_set_oneof(-1, NULL, NULL, NULL,
-			tvbparse_char(-1, "0", NULL, NULL, NULL),
-			tvbparse_set_seq(-1, NULL, NULL, NULL,
-				tvbparse_chars(-1, 1, 1, "123456789", NULL, NULL, NULL),
-				tvbparse_optional(-1, NULL, NULL, NULL, /* tvbparse_chars() don't respect 0 as min_len ;/ */
-					tvbparse_chars(-1, 0, 0, "0123456789", NULL, NULL, NULL)),
-				NULL),
-			NULL);
-
-	/* number = [ minus ] int [ frac ] [ exp ] */
-	want_number = tvbparse_set_seq(JSON_TOKEN_NUMBER, NULL, NULL, NULL,
-			tvbparse_optional(-1, NULL, NULL, NULL, /* tvbparse_chars() don't respect 0 as min_len ;/ */
-				tvbparse_chars(-1, 0, 1, "-", NULL, NULL, NULL)),
-			want_int,
-			/* frac = decimal-point 1*DIGIT */
-			tvbparse_optional(-1, NULL, NULL, NULL,
-				tvbparse_set_seq(-1, NULL, NULL, NULL,
-					tvbparse_char(-1, ".", NULL, NULL, NULL),
-					tvbparse_chars(-1, 1, 0, "0123456789", NULL, NULL, NULL),
-					NULL)),
-			/* exp = e [ minus / plus ] 1*DIGIT */
-			tvbparse_optional(-1, NULL, NULL, NULL,
-				tvbparse_set_seq(-1, NULL, NULL, NULL,
-					tvbparse_char(-1, "eE", NULL, NULL, NULL),
-					tvbparse_optional(-1, NULL, NULL, NULL, /* tvbparse_chars() don't respect 0 as min_len ;/ */
-						tvbparse_chars(-1, 0, 1, "-+", NULL, NULL, NULL)),
-					tvbparse_chars(-1, 1, 0, "0123456789", NULL, NULL, NULL),
-					NULL)),
-			NULL);
-
-	/* value = false / null / true / object / array / number / string */
-	want_value = tvbparse_set_oneof(-1, NULL, NULL, after_value,
-			tvbparse_string(JSON_TOKEN_FALSE, "false", NULL, NULL, NULL),
-			tvbparse_string(JSON_TOKEN_NULL, "null", NULL, NULL, NULL),
-			tvbparse_string(JSON_TOKEN_TRUE, "true", NULL, NULL, NULL),
-			&_want_object,
-			&_want_array,
-			want_number,
-			want_string,
-			NULL);
-
-	/* array = begin-array [ value *( value-separator value ) ] end-array */
-	want_array = tvbparse_set_seq(JSON_ARRAY, NULL, before_array, after_array,
-			tvbparse_char(-1, "[", NULL, NULL, NULL),
-			tvbparse_optional(-1, NULL, NULL, NULL,
-				tvbparse_set_seq(-1, NULL, NULL, NULL,
-					want_value,
-					tvbparse_some(-1, 0, G_MAXINT, NULL, NULL, NULL,
-						tvbparse_set_seq(-1, NULL, NULL, NULL,
-							want_value_separator,
-							want_value,
-							NULL)),
-					NULL)
-				),
-			tvbparse_char(-1, "]", NULL, NULL, NULL),
-			NULL);
-	_want_array = *want_array;
-
-	/* member = string name-separator value */
-	want_member = tvbparse_set_seq(-1, NULL, before_member, after_member,
-			want_string,
-			tvbparse_char(-1, ":", NULL, NULL, NULL),
-			want_value,
-			NULL);
-
-	/* object = begin-object [ member *( value-separator member ) ] end-object */
-	want_object = tvbparse_set_seq(JSON_OBJECT, NULL, before_object, after_object,
-			tvbparse_char(-1, "{", NULL, NULL, NULL),
-			tvbparse_optional(-1, NULL, NULL, NULL,
-				tvbparse_set_seq(-1, NULL, NULL, NULL,
-					want_member,
-					tvbparse_some(-1, 0, G_MAXINT, NULL, NULL, NULL,
-						tvbparse_set_seq(-1, NULL, NULL, NULL,
-							want_value_separator,
-							want_member,
-							NULL)),
-					NULL)
-				),
-			tvbparse_char(-1, "}", NULL, NULL, NULL),
-			NULL);
-	_want_object = *want_object;
-
-	want_ignore = tvbparse_chars(-1, 1, 0, " \t\r\n", NULL, NULL, NULL);
-
-	/* JSON-text = object / array */
-	want = tvbparse_set_oneof(-1, NULL, NULL, NULL,
-		want_object,
-		want_array,
-		/* tvbparse_not_chars(-1, 1, 0, " \t\r\n", NULL, NULL, NULL), */
-		NULL);
-
-	/* XXX, heur? */
+/*
+ * Parse the JSON texts (objects or arrays) at the start of a tvbuff, or
+ * get what was found parsing them when the frame was dissected before.
+ */
+static json_tape_t *
+json_get_tape(tvbuff_t *tvb, packet_info *pinfo)
+{
+	wmem_allocator_t *scope = json_keep_tapes ? wmem_file_scope() : pinfo->pool;
+	json_tape_t *tape;
+	const guint8 *buf;
+	GArray *entries;
+	size_t offset, end;
+	guint len = tvb_captured_length(tvb);
+
+	/* A frame can have several JSON bodies; the layer tells them apart. */
+	tape = (json_tape_t *)p_get_proto_data(scope, pinfo, proto_json, pinfo->curr_layer_num);
+	if (tape) {
+		if (tape->len == len)
+			return tape;
+		p_remove_proto_data(scope, pinfo, proto_json, pinfo->curr_layer_num);
+	}
+
+	buf = tvb_get_ptr(tvb, 0, len);
+	entries = g_array_new(FALSE, FALSE, sizeof(json_tape_entry_t));
+	offset = 0;
+	for (;;) {
+		/* JSON-text = object / array */
+		end = offset;
+		while (end < len && (buf[end] == ' ' || buf[end] == '\t' || buf[end] == '\r' || buf[end] == '\n'))
+			end++;
+		if (end == len || (buf[end] != '{' && buf[end] != '['))
+			break;
+
+		end = json_tape_parse(buf, len, end, entries);
+		if (end == 0)
+			break;
+		offset = end;
+	}
+
+	tape = wmem_new(scope, json_tape_t);
+	tape->len = len;
+	tape->parsed_len = (guint)offset;
+	tape->n_entries = entries->len;
+	tape->entries = (json_tape_entry_t *)wmem_memdup(scope, entries->data, entries->len * sizeof(json_tape_entry_t));
+	g_array_free(entries, TRUE);
+
+	p_add_proto_data(scope, pinfo, proto_json, pinfo->curr_layer_num, tape);
+	return tape;
+}
+
+/* A value has been added; a value in an object ends a member */
+static void
+json_value_done(json_parser_data_t *data, const json_tape_t *tape, wmem_stack_t *containers, guint i)
+{
+	const json_tape_entry_t *parent;
+
+	if (wmem_stack_count(containers) == 0)
+		return;
+
+	after_value(data, &tape->entries[i]);
+
+	parent = &tape->entries[GPOINTER_TO_UINT(wmem_stack_peek(containers))];
+	if (parent->type == JSON_TAPE_OBJECT)
+		after_member(data, &tape->entries[i - 1]);
+}
+
+/* Add the values of a tape to the trees, in the order they're in the data */
+static void
+json_dissect_tape(json_parser_data_t *data, const json_tape_t *tape)
+{
+	wmem_stack_t *containers = wmem_stack_new(wmem_packet_scope());
+	const json_tape_entry_t *tok;
+	guint container;
+	guint i = 0;
+
+	while (i < tape->n_entries || wmem_stack_count(containers) != 0) {
+		if (wmem_stack_count(containers) != 0) {
+			container = GPOINTER_TO_UINT(wmem_stack_peek(containers));
+			if (i == tape->entries[container].next) {
+				wmem_stack_pop(containers);
+				if (tape->entries[container].type == JSON_TAPE_OBJECT)
+					after_object(data);
+				else
+					after_array(data);
+				json_value_done(data, tape, containers, container);
+				continue;
+			}
+			if (tape->entries[container].type == JSON_TAPE_OBJECT) {
+				/* The key; the value is next */
+				before_member(data, &tape->entries[i], &tape->entries[i + 1]);
+				i++;
+			}
+		}
+
+		tok = &tape->entries[i];
+		switch (tok->type) {
+			case JSON_TAPE_OBJECT:
+				before_object(data, tok);
+				wmem_stack_push(containers, GUINT_TO_POINTER(i));
+				break;
+
+			case JSON_TAPE_ARRAY:
+				before_array(data, tok);
+				wmem_stack_push(containers, GUINT_TO_POINTER(i));
+				break;
+
+			default:
+				json_value_done(data, tape, containers, i);
+				break;
+		}
+		i++;
+	}
 }
 
 /* This function tries to understand if the payload is json or not */
@@ -934,13 +887,16 @@ proto_register_json(void)
 
 	json_handle = register_dissector("json", dissect_json, proto_json);
 
-	init_json_parser();
-
 	json_module = prefs_register_protocol(proto_json, NULL);
 	prefs_register_bool_preference(json_module, "compact_form",
 		"Display JSON in compact form",
 		"Display JSON like in browsers devtool",
 		&json_compact);
+	prefs_register_bool_preference(json_module, "keep_parsed",
+		"Keep the parsed structure of JSON bodies",
+		"Keep what was found parsing a JSON body, about 16 bytes per value,"
+		" so that dissecting its frame again doesn't parse it again",
+		&json_keep_tapes);
 
 	proto_json_3gpp = proto_register_protocol("JSON 3GPP", "JSON_3GPP", "json_3gpp");
 
@@ -938,13 +938,18 @@ typedef struct _pfcp_hdr {
 
 /* Relation between frame -> session */
 GHashTable* pfcp_session_table;
-/* Relation between <seid,ip> -> frame */
-wmem_tree_t* pfcp_frame_tree;
-
-typedef struct pfcp_info {
+/* Relation between <ip,seid> -> the frames that set it up, newest first */
+typedef struct pfcp_seid_key {
+    address ip;
     guint64 seid;
-    guint32 frame;
-} pfcp_info_t;
+} pfcp_seid_key_t;
+
+static wmem_map_t *pfcp_seid_frame_map;
+/* Relation between frame -> the <ip,seid>s it set up */
+static wmem_map_t *pfcp_frame_seid_map;
+/* Relation between session -> the frames added to it; a frame may since
+ * have been added to another session */
+static wmem_map_t *pfcp_session_frame_map;
 
 
 static dissector_table_t pfcp_enterprise_ies_dissector_table;
@@ -1474,74 +1479,77 @@ static const value_string pfcp_ie_type[] = {
 
 static value_string_ext pfcp_ie_type_ext = VALUE_STRING_EXT_INIT(pfcp_ie_type);
 
+static guint
+pfcp_seid_key_hash(gconstpointer k)
+{
+    const pfcp_seid_key_t *key = (const pfcp_seid_key_t *)k;
+
+    return add_address_to_hash((guint)(key->seid ^ (key->seid >> 32)), &key->ip);
+}
+
+static gboolean
+pfcp_seid_key_equal(gconstpointer k1, gconstpointer k2)
+{
+    const pfcp_seid_key_t *key1 = (const pfcp_seid_key_t *)k1;
+    const pfcp_seid_key_t *key2 = (const pfcp_seid_key_t *)k2;
+
+    return key1->seid == key2->seid && addresses_equal(&key1->ip, &key2->ip);
+}
+
 /* PFCP Session funcs*/
 static guint32
 pfcp_get_frame(address ip, guint64 seid, guint32 *frame) {
-    gboolean found = FALSE;
-    wmem_list_frame_t *elem;
-    pfcp_info_t *info;
-    wmem_list_t *info_list;
-    gchar *ip_str;
-
-    /* First we get the seid list*/
-    ip_str = address_to_str(wmem_packet_scope(), &ip);
-    info_list = (wmem_list_t*)wmem_tree_lookup_string(pfcp_frame_tree, ip_str, 0);
-    if (info_list != NULL) {
-        elem = wmem_list_head(info_list);
-        while (!found && elem) {
-            info = (pfcp_info_t*)wmem_list_frame_data(elem);
-            if (seid == info->seid) {
-                *frame = info->frame;
-                return 1;
-            }
-            elem = wmem_list_frame_next(elem);
-        }
-    }
-    return 0;
-}
+    pfcp_seid_key_t key;
+    wmem_list_t *frames;
 
-static gboolean
-pfcp_call_foreach_ip(const void *key _U_, void *value, void *data){
-    wmem_list_frame_t * elem;
-    wmem_list_t *info_list = (wmem_list_t *)value;
-    pfcp_info_t *info;
-    guint32* frame = (guint32*)data;
-
-    /* We loop over the <seid, frame> list */
-    elem = wmem_list_head(info_list);
-    while (elem) {
-        info = (pfcp_info_t*)wmem_list_frame_data(elem);
-        if (info->frame == *frame) {
-            wmem_list_frame_t * del = elem;
-            /* proceed to next request */
-            elem = wmem_list_frame_next(elem);
-            /* If we find the frame we remove its information from the list */
-            wmem_list_remove_frame(info_list, del);
-            wmem_free(wmem_file_scope(), info);
-        }
-        else {
-            elem = wmem_list_frame_next(elem);
-        }
+    key.ip = ip;
+    key.seid = seid;
+    frames = (wmem_list_t*)wmem_map_lookup(pfcp_seid_frame_map, &key);
+    if (frames != NULL && wmem_list_count(frames) > 0) {
+        *frame = GPOINTER_TO_UINT(wmem_list_frame_data(wmem_list_head(frames)));
+        return 1;
     }
-
-    return FALSE;
+    return 0;
 }
 
 static void
 pfcp_remove_frame_info(guint32 *f) {
-    /* For each ip node */
-    wmem_tree_foreach(pfcp_frame_tree, pfcp_call_foreach_ip, (void *)f);
+    wmem_list_t *keys;
+    wmem_list_frame_t *elem;
+    wmem_list_t *frames;
+
+    keys = (wmem_list_t*)wmem_map_remove(pfcp_frame_seid_map, GUINT_TO_POINTER(*f));
+    if (keys == NULL) {
+        return;
+    }
+
+    /* For each <ip,seid> the frame set up */
+    for (elem = wmem_list_head(keys); elem; elem = wmem_list_frame_next(elem)) {
+        frames = (wmem_list_t*)wmem_map_lookup(pfcp_seid_frame_map, wmem_list_frame_data(elem));
+        if (frames != NULL) {
+            wmem_list_remove(frames, GUINT_TO_POINTER(*f));
+        }
+    }
+    wmem_destroy_list(keys);
 }
 
 static void
 pfcp_add_session(guint32 frame, guint32 session) {
     guint32 *f, *session_count;
+    wmem_array_t *frames;
 
     f = wmem_new0(wmem_file_scope(), guint32);
     session_count = wmem_new0(wmem_file_scope(), guint32);
     *f = frame;
     *session_count = session;
     g_hash_table_insert(pfcp_session_table, f, session_count);
+
+    frames = (wmem_array_t*)wmem_map_lookup(pfcp_session_frame_map, GUINT_TO_POINTER(session));
+    if (frames == NULL) {
+        frames = wmem_array_new(wmem_file_scope(), sizeof(guint32));
+        wmem_map_insert(pfcp_session_frame_map, GUINT_TO_POINTER(session), frames);
+    }
+    wmem_array_append_one(frames, frame);
 }
 
 static gboolean
@@ -1574,71 +1582,70 @@ pfcp_ip_exists(address ip, wmem_list_t *ip_list) {
     return found;
 }
 
-static gboolean
-pfcp_info_exists(pfcp_info_t *wanted, wmem_list_t *info_list) {
-    wmem_list_frame_t *elem;
-    pfcp_info_t *info;
-    gboolean found;
-    found = FALSE;
-    elem = wmem_list_head(info_list);
-    while (!found && elem) {
-        info = (pfcp_info_t*)wmem_list_frame_data(elem);
-        found = wanted->seid == info->seid;
-        elem = wmem_list_frame_next(elem);
+/* Remove the information of all the frames still in a session */
+static void
+pfcp_remove_session_info(guint32 session) {
+    wmem_array_t *frames;
+    guint32 fr, *fr_session;
+    guint i;
+
+    frames = (wmem_array_t*)wmem_map_lookup(pfcp_session_frame_map, GUINT_TO_POINTER(session));
+    if (frames == NULL) {
+        return;
+    }
+
+    for (i = 0; i < wmem_array_get_count(frames); i++) {
+        fr = *(guint32*)wmem_array_index(frames, i);
+        fr_session = (guint32 *)g_hash_table_lookup(pfcp_session_table, &fr);
+        if (fr_session != NULL && *fr_session == session) {
+            pfcp_remove_frame_info(&fr);
+        }
     }
-    return found;
 }
 
 static void
 pfcp_fill_map(wmem_list_t *seid_list, wmem_list_t *ip_list, guint32 frame) {
     wmem_list_frame_t *elem_ip, *elem_seid;
-    pfcp_info_t *pfcp_info;
-    wmem_list_t * info_list; /* List of <seids,frames>*/
-    guint32 *f, *session, *fr, *session_count;
-    GHashTableIter iter;
-    guint64 seid;
-    gchar *ip;
+    pfcp_seid_key_t key, *seid_key;
+    wmem_list_t *frames; /* List of the frames setting up an <ip,seid> */
+    wmem_list_t *keys;
+    guint32 *session;
 
     elem_ip = wmem_list_head(ip_list);
 
     while (elem_ip) {
-        ip = address_to_str(wmem_file_scope(), (address*)wmem_list_frame_data(elem_ip));
-        /* We check if a seid list exists for this ip */
-        info_list = (wmem_list_t*)wmem_tree_lookup_string(pfcp_frame_tree, ip, 0);
-        if (info_list == NULL) {
-            info_list = wmem_list_new(wmem_file_scope());
-        }
+        key.ip = *(address*)wmem_list_frame_data(elem_ip);
 
         /* We loop over the seid list */
         elem_seid = wmem_list_head(seid_list);
         while (elem_seid) {
-            seid = *(guint64*)wmem_list_frame_data(elem_seid);
-            f = wmem_new0(wmem_file_scope(), guint32);
-            *f = frame;
-            pfcp_info = wmem_new0(wmem_file_scope(), pfcp_info_t);
-            pfcp_info->seid = seid;
-            pfcp_info->frame = *f;
-
-            if (pfcp_info_exists(pfcp_info, info_list)) {
+            key.seid = *(guint64*)wmem_list_frame_data(elem_seid);
+
+            if (!wmem_map_lookup_extended(pfcp_seid_frame_map, &key, (const void **)&seid_key, (void **)&frames)) {
+                seid_key = wmem_new(wmem_file_scope(), pfcp_seid_key_t);
+                copy_address_wmem(wmem_file_scope(), &seid_key->ip, &key.ip);
+                seid_key->seid = key.seid;
+                frames = wmem_list_new(wmem_file_scope());
+                wmem_map_insert(pfcp_seid_frame_map, seid_key, frames);
+            } else if (wmem_list_count(frames) > 0) {
                 /* If the seid and ip already existed, that means that we need to remove old info about that session */
                 /* We look for its session ID */
-                session = (guint32 *)g_hash_table_lookup(pfcp_session_table, f);
+                session = (guint32 *)g_hash_table_lookup(pfcp_session_table, &frame);
                 if (session) {
-                    g_hash_table_iter_init(&iter, pfcp_session_table);
-
-                    while (g_hash_table_iter_next(&iter, (gpointer*)&fr, (gpointer*)&session_count)) {
-                        /* If the msg has the same session ID and it's not the upd req we have to remove its info */
-                        if (*session_count == *session) {
-                            /* If it's the session we are looking for, we remove all the frame information */
-                            pfcp_remove_frame_info(fr);
-                        }
-                    }
+                    pfcp_remove_session_info(*session);
                 }
             }
-            wmem_list_prepend(info_list, pfcp_info);
+            wmem_list_prepend(frames, GUINT_TO_POINTER(frame));
+
+            keys = (wmem_list_t*)wmem_map_lookup(pfcp_frame_seid_map, GUINT_TO_POINTER(frame));
+            if (keys == NULL) {
+                keys = wmem_list_new(wmem_file_scope());
+                wmem_map_insert(pfcp_frame_seid_map, GUINT_TO_POINTER(frame), keys);
+            }
+            wmem_list_prepend(keys, seid_key);
+
             elem_seid = wmem_list_frame_next(elem_seid);
         }
-        wmem_tree_insert_string(pfcp_frame_tree, ip, info_list, 0);
         elem_ip = wmem_list_frame_next(elem_ip);
     }
 }
@@ -9138,7 +9145,9 @@ pfcp_init(void)
 {
     pfcp_session_count = 1;
     pfcp_session_table = g_hash_table_new(g_int_hash, g_int_equal);
-    pfcp_frame_tree = wmem_tree_new(wmem_file_scope());
+    pfcp_seid_frame_map = wmem_map_new(wmem_file_scope(), pfcp_seid_key_hash, pfcp_seid_key_equal);
+    pfcp_frame_seid_map = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
+    pfcp_session_frame_map = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
 }
 
 static void
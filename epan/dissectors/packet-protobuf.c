@@ -182,6 +182,8 @@ typedef struct {
 } protobuf_varint_tvb_info_t;
 
 static PbwDescriptorPool* pbw_pool = NULL;
+/* checksum of the search paths and of the .proto files pbw_pool was loaded from */
+static gchar* pbw_pool_fingerprint = NULL;
 
 /* protobuf source files search paths */
 typedef struct {
@@ -1464,6 +1466,80 @@ load_all_files_in_dir(PbwDescriptorPool* pool, const gchar* dir_path)
     return TRUE;
 }
 
+/* add the path, modification time and size of a file to a fingerprint */
+static void
+fingerprint_file(const char* path, void* checksum)
+{
+    ws_statb64 st;
+    gint64 file_info[2] = { 0, -1 };
+
+    if (ws_stat64(path, &st) == 0) {
+        file_info[0] = (gint64) st.st_mtime;
+        file_info[1] = (gint64) st.st_size;
+    }
+    g_checksum_update((GChecksum*) checksum, (const guchar*) path, strlen(path) + 1);
+    g_checksum_update((GChecksum*) checksum, (const guchar*) file_info, sizeof file_info);
+}
+
+/* add all the files that load_all_files_in_dir() would load to a fingerprint */
+static void
+fingerprint_all_files_in_dir(GChecksum* checksum, const gchar* dir_path)
+{
+    WS_DIR        *dir;             /* scanned directory */
+    WS_DIRENT     *file;            /* current file */
+    const gchar   *dot;
+    const gchar   *name;            /* current file or dir name (without parent dir path) */
+    gchar         *path;            /* sub file or dir path of dir_path */
+
+    if (g_file_test(dir_path, G_FILE_TEST_IS_DIR)) {
+        if ((dir = ws_dir_open(dir_path, 0, NULL)) != NULL) {
+            while ((file = ws_dir_read_name(dir)) != NULL) {
+                name = ws_dir_get_name(file);
+                path = g_build_filename(dir_path, name, NULL);
+                dot = strrchr(name, '.');
+                if (dot && g_ascii_strcasecmp(dot + 1, "proto") == 0) {
+                    fingerprint_file(path, checksum);
+                } else {
+                    fingerprint_all_files_in_dir(checksum, path);
+                }
+                g_free(path);
+            }
+            ws_dir_close(dir);
+        }
+    }
+}
+
+/* Get a checksum of the search paths, of the .proto files in the directories
+ * to be loaded and of the files loaded into pbw_pool, that changes if any of
+ * them would make the pool different when loaded again. Parsing thousands
+ * of message types is slow, so the pool is kept until this changes. */
+static gchar*
+get_proto_files_fingerprint(void)
+{
+    guint i;
+    gchar* fingerprint;
+    GChecksum* checksum = g_checksum_new(G_CHECKSUM_SHA256);
+
+    for (i = 0; i < num_protobuf_search_paths; ++i) {
+        const gchar* path = protobuf_search_paths[i].path ? protobuf_search_paths[i].path : "";
+        guchar load_all = protobuf_search_paths[i].load_all ? 1 : 0;
+
+        g_checksum_update(checksum, (const guchar*) path, strlen(path) + 1);
+        g_checksum_update(checksum, &load_all, 1);
+        if (load_all) {
+            fingerprint_all_files_in_dir(checksum, path);
+        }
+    }
+
+    if (pbw_pool) {
+        pbw_foreach_proto_file(pbw_pool, fingerprint_file, checksum);
+    }
+
+    fingerprint = g_strdup(g_checksum_get_string(checksum));
+    g_checksum_free(checksum);
+    return fingerprint;
+}
+
 /* There might be a lot of errors to be found during parsing .proto files.
    We buffer the errors first, and print them in one list finally. */
 static wmem_strbuf_t* err_msg_buf = NULL;
@@ -1715,6 +1791,7 @@ protobuf_reinit(int target)
     range_t* udp_port_range;
     const gchar* message_type;
     gboolean loading_completed = TRUE;
+    gchar* fingerprint;
 
     if (target & PREFS_UPDATE_PROTOBUF_UDP_MESSAGE_TYPES) {
         /* delete protobuf dissector from old udp ports */
@@ -1745,6 +1822,15 @@ protobuf_reinit(int target)
         return;
     }
 
+    if (target & PREFS_UPDATE_PROTOBUF_SEARCH_PATHS) {
+        fingerprint = get_proto_files_fingerprint();
+        if (pbw_pool && pbw_pool_fingerprint && strcmp(fingerprint, pbw_pool_fingerprint) == 0) {
+            /* neither the search paths nor the .proto files have changed */
+            target &= ~PREFS_UPDATE_PROTOBUF_SEARCH_PATHS;
+        }
+        g_free(fingerprint);
+    }
+
     if (target & PREFS_UPDATE_PROTOBUF_SEARCH_PATHS) {
         /* convert protobuf_search_path_t array to char* array. should release by g_free(). */
         source_paths = g_new0(char *, num_protobuf_search_paths + 1);
@@ -1769,6 +1855,10 @@ protobuf_reinit(int target)
 
         g_free(source_paths);
         update_header_fields(TRUE);
+
+        /* load again next time if it failed */
+        g_free(pbw_pool_fingerprint);
+        pbw_pool_fingerprint = loading_completed ? get_proto_files_fingerprint() : NULL;
     }
 
     /* check if the message types of UDP port exist */
@@ -57,6 +57,7 @@
 #include <wsutil/pint.h>
 
 #include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
 #include <epan/follow.h>
 #include <epan/addr_resolv.h>
 
@@ -65,6 +66,11 @@ void proto_reg_handoff_quic(void);
 void proto_register_quic(void);
 
 static int quic_follow_tap = -1;
+static int quic_tap = -1;
+
+/* Key of the quic_tap_info of the QUIC packet being dissected, in the packet
+ * scope proto data, for frames to add to. */
+#define QUIC_PROTO_DATA_TAP_INFO 1
 
 /* Initialize the protocol and registered fields */
 static int proto_quic = -1;
@@ -326,16 +332,25 @@ struct quic_cid_item {
  */
 typedef struct _quic_stream_state {
     guint64         stream_id;
-    wmem_tree_t    *multisegment_pdus;
+    wmem_flat_tree_t *multisegment_pdus;
+    wmem_flat_tree_t *received;     /**< Stream data seen in the first pass, as disjoint ranges (start offset -> quic_stream_range). */
+    wmem_flat_tree_t *duplicates;   /**< Frame number -> STREAM data in it that had been received already (quic_stream_range). */
     void           *subdissector_private;
 } quic_stream_state;
 
+/** Range [start, end) of stream offsets. */
+typedef struct _quic_stream_range {
+    guint32         start;
+    guint32         end;
+} quic_stream_range;
+
 /**
  * State for a single QUIC connection, identified by one or more Destination
  * Connection IDs (DCID).
  */
 typedef struct quic_info_data {
     guint32         number;         /** Similar to "udp.stream", but for identifying QUIC connections across migrations. */
+    wmem_array_t   *frames;         /**< Frames in which the connection appears, in ascending order. */
     guint32         version;
     address         server_address;
     guint16         server_port;
@@ -361,8 +376,8 @@ typedef struct quic_info_data {
     quic_cid_item_t server_cids;    /**< SCID of server from first Retry/Handshake. */
     quic_cid_t      client_dcid_initial;    /**< DCID from Initial Packet. */
     dissector_handle_t app_handle;  /**< Application protocol handle (NULL if unknown). */
-    wmem_map_t     *client_streams; /**< Map from Stream ID -> STREAM info (guint64 -> quic_stream_state), sent by the client. */
-    wmem_map_t     *server_streams; /**< Map from Stream ID -> STREAM info (guint64 -> quic_stream_state), sent by the server. */
+    wmem_flat_map_t *client_streams;    /**< Map from Stream ID -> STREAM info (guint64 -> quic_stream_state), sent by the client. */
+    wmem_flat_map_t *server_streams;    /**< Map from Stream ID -> STREAM info (guint64 -> quic_stream_state), sent by the server. */
     gquic_info_data_t *gquic_info; /**< GQUIC info for >Q050 flows. */
 } quic_info_data_t;
 
@@ -382,6 +397,7 @@ typedef struct quic_packet_info quic_packet_info_t;
 typedef struct quic_datagram {
     quic_info_data_t       *conn;
     quic_packet_info_t      first_packet;
+    guint                   padding_offset; /**< Offset of the padding after the coalesced packets (0 if none), set on the first pass. */
     gboolean                from_server : 1;
 } quic_datagram;
 
@@ -395,11 +411,31 @@ typedef struct quic_datagram {
  * quic_server_connections. Retry.DCID should normally correspond to an entry in
  * quic_client_connections.
  */
-static wmem_map_t *quic_client_connections, *quic_server_connections;
-static wmem_map_t *quic_initial_connections;    /* Initial.DCID -> connection */
+static wmem_flat_map_t *quic_client_connections, *quic_server_connections;
+static wmem_flat_map_t *quic_initial_connections;    /* Initial.DCID -> connection */
 static wmem_list_t *quic_connections;   /* All unique connections. */
 static guint32 quic_cid_lengths;        /* Bitmap of CID lengths. */
 static guint quic_connections_count;
+static wmem_map_t *quic_connection_frames; /* Connection number -> frames */
+
+/**
+ * Radix tree of the CIDs in quic_client_connections and
+ * quic_server_connections, for short header packets whose DCID length is
+ * unknown: walking it with the bytes of the packet finds the longest known
+ * CID at once, instead of looking up every possible length.
+ *
+ * The children of a node begin with different bytes; those of the root are
+ * indexed by their first byte. Removed CIDs only clear the connection.
+ */
+typedef struct quic_cid_node {
+    struct quic_cid_node   *children;
+    struct quic_cid_node   *sibling;
+    quic_info_data_t       *client_conn;    /**< Connection of the CID ending here in quic_client_connections. */
+    quic_info_data_t       *server_conn;    /**< Same for quic_server_connections. */
+    guint8                  label_len;
+    guint8                  label[];
+} quic_cid_node_t;
+static quic_cid_node_t *quic_cid_tree[256];
 
 /* Returns the QUIC draft version or 0 if not applicable. */
 static inline guint8 quic_draft_version(guint32 version) {
@@ -867,15 +903,115 @@ quic_cids_has_match(const quic_cid_item_t *items, const quic_cid_t *raw_cid)
     return FALSE;
 }
 
+static quic_cid_node_t *
+quic_cid_node_new(const guint8 *label, guint8 label_len)
+{
+    quic_cid_node_t *node;
+
+    node = (quic_cid_node_t *)wmem_alloc0(wmem_file_scope(), sizeof(quic_cid_node_t) + label_len);
+    memcpy(node->label, label, label_len);
+    node->label_len = label_len;
+    return node;
+}
+
+/** Returns the node of the CID, adding it if needed. */
+static quic_cid_node_t *
+quic_cid_tree_add(const quic_cid_t *cid)
+{
+    quic_cid_node_t **node_p = &quic_cid_tree[cid->cid[0]];
+    guint8 pos = 0;
+
+    for (;;) {
+        quic_cid_node_t *node = *node_p;
+        guint8 common = 0;
+
+        if (!node) {
+            *node_p = quic_cid_node_new(cid->cid + pos, cid->len - pos);
+            return *node_p;
+        }
+        // The first byte always matches.
+        while (common < node->label_len && pos + common < cid->len &&
+               node->label[common] == cid->cid[pos + common]) {
+            common++;
+        }
+        if (common < node->label_len) {
+            // Split the node where the CID leaves its label.
+            quic_cid_node_t *parent = quic_cid_node_new(node->label, common);
+            parent->children = node;
+            parent->sibling = node->sibling;
+            node->sibling = NULL;
+            node->label_len -= common;
+            memmove(node->label, node->label + common, node->label_len);
+            *node_p = node = parent;
+        }
+        pos += common;
+        if (pos == cid->len) {
+            return node;
+        }
+        node_p = &node->children;
+        while (*node_p && (*node_p)->label[0] != cid->cid[pos]) {
+            node_p = &(*node_p)->sibling;
+        }
+    }
+}
+
+/**
+ * Returns the node of the longest CID that begins raw_cid and is shorter than
+ * max_len bytes (at most the length of raw_cid), or NULL if there is none.
+ * Its length is stored in cid_len.
+ */
+static quic_cid_node_t *
+quic_cid_tree_find_prefix(const quic_cid_t *raw_cid, guint8 max_len, guint8 *cid_len)
+{
+    quic_cid_node_t *node, *found = NULL;
+    guint8 pos = 0;
+
+    if (raw_cid->len == 0) {
+        return NULL;
+    }
+    DISSECTOR_ASSERT(max_len <= raw_cid->len);
+    node = quic_cid_tree[raw_cid->cid[0]];
+    while (node && pos + node->label_len < max_len &&
+           !memcmp(node->label, raw_cid->cid + pos, node->label_len)) {
+        pos += node->label_len;
+        if (node->client_conn || node->server_conn) {
+            found = node;
+            *cid_len = pos;
+        }
+        node = node->children;
+        while (node && node->label[0] != raw_cid->cid[pos]) {
+            node = node->sibling;
+        }
+    }
+    return found;
+}
+
 static void
 quic_cids_insert(quic_cid_t *cid, quic_info_data_t *conn, gboolean from_server)
 {
-    wmem_map_t *connections = from_server ? quic_server_connections : quic_client_connections;
+    wmem_flat_map_t *connections = from_server ? quic_server_connections : quic_client_connections;
     // Replace any previous CID key with the new one.
-    wmem_map_remove(connections, cid);
-    wmem_map_insert(connections, cid, conn);
+    wmem_flat_map_remove(connections, cid);
+    wmem_flat_map_insert(connections, cid, conn);
     G_STATIC_ASSERT(QUIC_MAX_CID_LENGTH <= 8 * sizeof(quic_cid_lengths));
     quic_cid_lengths |= (1ULL << cid->len);
+    if (cid->len > 0) {
+        quic_cid_node_t *node = quic_cid_tree_add(cid);
+        if (from_server) {
+            node->server_conn = conn;
+        } else {
+            node->client_conn = conn;
+        }
+    }
+}
+
+static void
+quic_cids_remove_server(quic_cid_t *cid)
+{
+    wmem_flat_map_remove(quic_server_connections, cid);
+    if (cid->len > 0) {
+        quic_cid_tree_add(cid)->server_conn = NULL;
+    }
 }
 
 static inline gboolean
@@ -922,16 +1058,16 @@ quic_connection_find_dcid(packet_info *pinfo, const quic_cid_t *dcid, gboolean *
         if (!quic_cids_is_known_length(dcid)) {
             return NULL;
         }
-        conn = (quic_info_data_t *) wmem_map_lookup(quic_client_connections, dcid);
+        conn = (quic_info_data_t *) wmem_flat_map_lookup(quic_client_connections, dcid);
         if (conn) {
             // DCID recognized by client, so it was from server.
             *from_server = TRUE;
             // On collision (both client and server choose the same CID), check
             // the port to learn about the side.
             // This is required for supporting draft -10 which has a single CID.
-            check_ports = !!wmem_map_lookup(quic_server_connections, dcid);
+            check_ports = !!wmem_flat_map_lookup(quic_server_connections, dcid);
         } else {
-            conn = (quic_info_data_t *) wmem_map_lookup(quic_server_connections, dcid);
+            conn = (quic_info_data_t *) wmem_flat_map_lookup(quic_server_connections, dcid);
             if (conn) {
                 // DCID recognized by server, so it was from client.
                 *from_server = FALSE;
@@ -952,6 +1088,27 @@ quic_connection_find_dcid(packet_info *pinfo, const quic_cid_t *dcid, gboolean *
     return conn;
 }
 
+/**
+ * Like quic_connection_find_dcid, for a CID found in quic_cid_tree.
+ */
+static quic_info_data_t *
+quic_connection_find_cid_node(packet_info *pinfo, const quic_cid_node_t *node, gboolean *from_server)
+{
+    quic_info_data_t *conn = node->client_conn;
+
+    if (conn) {
+        *from_server = TRUE;
+        if (node->server_conn) {
+            *from_server = conn->server_port == pinfo->srcport &&
+                    addresses_equal(&conn->server_address, &pinfo->src);
+        }
+    } else {
+        conn = node->server_conn;
+        *from_server = FALSE;
+    }
+    return conn;
+}
+
 /**
  * Try to find a QUIC connection based on DCID. For short header packets, DCID
  * will be modified in order to find the actual length.
@@ -966,7 +1123,7 @@ quic_connection_find(packet_info *pinfo, guint8 long_packet_type,
 
     if (long_packet_type == QUIC_LPT_0RTT && dcid->len > 0) {
         // The 0-RTT packet always matches the SCID/DCID of the Client Initial
-        conn = (quic_info_data_t *) wmem_map_lookup(quic_initial_connections, dcid);
+        conn = (quic_info_data_t *) wmem_flat_map_lookup(quic_initial_connections, dcid);
         *from_server = FALSE;
     } else {
         // Find a connection for Handshake, Version Negotiation and Server Initial packets by
@@ -998,11 +1155,13 @@ quic_connection_find(packet_info *pinfo, guint8 long_packet_type,
         }
 
         // No match found so far, potentially connection migration. Length of
-        // actual DCID is unknown, so just keep decrementing until found.
-        while (!conn && dcid->len > 1) {
-            dcid->len--;
-            if (quic_cids_is_known_length(dcid)) {
-                conn = quic_connection_find_dcid(pinfo, dcid, from_server);
+        // actual DCID is unknown, so find the longest known CID it begins with.
+        if (!conn) {
+            guint8 cid_len;
+            const quic_cid_node_t *node = quic_cid_tree_find_prefix(dcid, dcid->len, &cid_len);
+            if (node) {
+                dcid->len = cid_len;
+                conn = quic_connection_find_cid_node(pinfo, node, from_server);
             }
         }
         if (!conn) {
@@ -1023,6 +1182,8 @@ quic_connection_create(packet_info *pinfo, guint32 version)
     conn = wmem_new0(wmem_file_scope(), quic_info_data_t);
     wmem_list_append(quic_connections, conn);
     conn->number = quic_connections_count++;
+    conn->frames = wmem_array_new(wmem_file_scope(), sizeof(guint32));
+    wmem_map_insert(quic_connection_frames, GUINT_TO_POINTER(conn->number), conn->frames);
     conn->version = version;
     copy_address_wmem(wmem_file_scope(), &conn->server_address, &pinfo->dst);
     conn->server_port = pinfo->destport;
@@ -1064,7 +1225,7 @@ quic_connection_update_initial(quic_info_data_t *conn, const quic_cid_t *scid, c
         // According to the spec, the Initial Packet DCID MUST be at least 8
         // bytes, but non-conforming implementations could exist.
         memcpy(&conn->client_dcid_initial, dcid, sizeof(quic_cid_t));
-        wmem_map_insert(quic_initial_connections, &conn->client_dcid_initial, conn);
+        wmem_flat_map_insert(quic_initial_connections, &conn->client_dcid_initial, conn);
         conn->client_dcid_set = TRUE;
     }
 }
@@ -1119,7 +1280,7 @@ quic_connection_create_or_update(quic_info_data_t **conn_p,
                 // the next server Initial Packet can link the connection with
                 // that new SCID.
                 quic_connection_update_initial(conn, scid, dcid);
-                wmem_map_remove(quic_server_connections, &conn->server_cids.data);
+                quic_cids_remove_server(&conn->server_cids.data);
                 memset(&conn->server_cids, 0, sizeof(quic_cid_t));
             }
             break;
@@ -1135,7 +1296,7 @@ quic_connection_create_or_update(quic_info_data_t **conn_p,
                 // client should start a new cryptographic handshake. Erase the
                 // current "Initial DCID" such that the next client Initial
                 // packet populates the new value.
-                wmem_map_remove(quic_initial_connections, &conn->client_dcid_initial);
+                wmem_flat_map_remove(quic_initial_connections, &conn->client_dcid_initial);
                 memset(&conn->client_dcid_initial, 0, sizeof(quic_cid_t));
                 conn->client_dcid_set = FALSE;
             }
@@ -1177,33 +1338,100 @@ static reassembly_table quic_reassembly_table;
 static quic_stream_state *
 quic_get_stream_state(packet_info *pinfo, quic_info_data_t *quic_info, gboolean from_server, guint64 stream_id)
 {
-    wmem_map_t **streams_p = from_server ? &quic_info->server_streams : &quic_info->client_streams;
-    wmem_map_t *streams = *streams_p;
+    wmem_flat_map_t **streams_p = from_server ? &quic_info->server_streams : &quic_info->client_streams;
+    wmem_flat_map_t *streams = *streams_p;
     quic_stream_state *stream = NULL;
 
     if (PINFO_FD_VISITED(pinfo)) {
         DISSECTOR_ASSERT(streams);
-        stream = (quic_stream_state *)wmem_map_lookup(streams, &stream_id);
+        stream = (quic_stream_state *)wmem_flat_map_lookup(streams, &stream_id);
         DISSECTOR_ASSERT(stream);
         return stream;
     }
 
     // Initialize per-connection and per-stream state.
     if (!streams) {
-        streams = wmem_map_new(wmem_file_scope(), wmem_int64_hash, g_int64_equal);
+        streams = wmem_flat_map_new(wmem_file_scope(), wmem_int64_hash, g_int64_equal);
         *streams_p = streams;
     } else {
-        stream = (quic_stream_state *)wmem_map_lookup(streams, &stream_id);
+        stream = (quic_stream_state *)wmem_flat_map_lookup(streams, &stream_id);
     }
     if (!stream) {
         stream = wmem_new0(wmem_file_scope(), quic_stream_state);
         stream->stream_id = stream_id;
-        stream->multisegment_pdus = wmem_tree_new(wmem_file_scope());
-        wmem_map_insert(streams, &stream->stream_id, stream);
+        stream->multisegment_pdus = wmem_flat_tree_new(wmem_file_scope());
+        stream->received = wmem_flat_tree_new(wmem_file_scope());
+        stream->duplicates = wmem_flat_tree_new(wmem_file_scope());
+        wmem_flat_map_insert(streams, &stream->stream_id, stream);
     }
     return stream;
 }
 
+/**
+ * Adds [start, end) to the received ranges of the stream, merging it with the
+ * ranges it overlaps or touches. Returns TRUE, adding nothing, if all of it
+ * had been received already.
+ */
+static gboolean
+quic_stream_add_received(quic_stream_state *stream, guint32 start, guint32 end)
+{
+    quic_stream_range *prev, *next;
+
+    prev = (quic_stream_range *)wmem_flat_tree_lookup32_le(stream->received, start);
+    if (prev && prev->end >= start) {
+        if (prev->end >= end) {
+            return TRUE;
+        }
+        start = prev->start;
+    } else {
+        prev = NULL;
+    }
+    // Absorb the ranges that begin within the new one.
+    while ((next = (quic_stream_range *)wmem_flat_tree_lookup32_le(stream->received, end)) &&
+           next->start > start) {
+        end = MAX(end, next->end);
+        wmem_flat_tree_remove32(stream->received, next->start);
+    }
+    if (!prev) {
+        prev = wmem_new(wmem_file_scope(), quic_stream_range);
+        prev->start = start;
+        wmem_flat_tree_insert32(stream->received, start, prev);
+    }
+    prev->end = end;
+    return FALSE;
+}
+
+/**
+ * Returns TRUE if the STREAM data [seq, nxtseq) of this frame had all been
+ * received in earlier frames (a retransmission, or a duplicate packet). It is
+ * then neither reassembled again nor given to the subdissector a second time,
+ * which would also make the reassembled data overlap.
+ * Only one such range is remembered for each frame and stream; any further
+ * ones are dissected as usual, on every pass.
+ */
+static gboolean
+quic_stream_is_duplicate(packet_info *pinfo, quic_stream_state *stream, guint32 seq, guint32 nxtseq)
+{
+    quic_stream_range *dup;
+
+    if (seq == nxtseq) {
+        return FALSE;
+    }
+    if (PINFO_FD_VISITED(pinfo)) {
+        dup = (quic_stream_range *)wmem_flat_tree_lookup32(stream->duplicates, pinfo->num);
+        return dup && dup->start == seq && dup->end == nxtseq;
+    }
+    if (!quic_stream_add_received(stream, seq, nxtseq) ||
+        wmem_flat_tree_lookup32(stream->duplicates, pinfo->num)) {
+        return FALSE;
+    }
+    dup = wmem_new(wmem_file_scope(), quic_stream_range);
+    dup->start = seq;
+    dup->end = nxtseq;
+    wmem_flat_tree_insert32(stream->duplicates, pinfo->num, dup);
+    return TRUE;
+}
+
 static void
 process_quic_stream(tvbuff_t *tvb, int offset, packet_info *pinfo, proto_tree *tree,
                     quic_info_data_t *quic_info, quic_stream_info *stream_info)
@@ -1237,6 +1465,10 @@ desegment_quic_stream(tvbuff_t *tvb, int offset, int length, packet_info *pinfo,
     const guint32 nxtseq = seq + (guint32)length;
     guint32 reassembly_id = 0;
 
+    if (quic_stream_is_duplicate(pinfo, stream, seq, nxtseq)) {
+        return;
+    }
+
     // XXX fix the tvb accessors below such that no new tvb is needed.
     tvb = tvb_new_subset_length(tvb, 0, offset + length);
 
@@ -1267,7 +1499,7 @@ again:
     /* Have we seen this PDU before (and is it the start of a multi-
      * segment PDU)?
      */
-    if ((msp = (struct tcp_multisegment_pdu *)wmem_tree_lookup32(stream->multisegment_pdus, seq)) &&
+    if ((msp = (struct tcp_multisegment_pdu *)wmem_flat_tree_lookup32(stream->multisegment_pdus, seq)) &&
             nxtseq <= msp->nxtpdu) {
         // TODO show expert info for retransmission? Additional checks may be
         // necessary here to tell a retransmission apart from other (normal?)
@@ -1280,7 +1512,7 @@ again:
     }
     /* Else, find the most previous PDU starting before this sequence number */
     if (!msp && seq > 0) {
-        msp = (struct tcp_multisegment_pdu *)wmem_tree_lookup32_le(stream->multisegment_pdus, seq-1);
+        msp = (struct tcp_multisegment_pdu *)wmem_flat_tree_lookup32_le(stream->multisegment_pdus, seq-1);
         /* Unless if we already fully reassembled the msp that covers seq-1
          * and seq is beyond the end of that msp. In that case this segment
          * will be the start of a new msp.
@@ -1639,12 +1871,23 @@ dissect_quic_frame_type(tvbuff_t *tvb, packet_info *pinfo, proto_tree *quic_tree
                 break;
             }
 
-            proto_tree_add_item_ret_varint(ft_tree, hf_quic_ack_largest_acknowledged, tvb, offset, -1, ENC_VARINT_QUIC, NULL, &lenvar);
+            guint64 largest_acknowledged, ack_delay;
+            quic_tap_info *tap_info;
+
+            proto_tree_add_item_ret_varint(ft_tree, hf_quic_ack_largest_acknowledged, tvb, offset, -1, ENC_VARINT_QUIC, &largest_acknowledged, &lenvar);
             offset += lenvar;
 
-            proto_tree_add_item_ret_varint(ft_tree, hf_quic_ack_ack_delay, tvb, offset, -1, ENC_VARINT_QUIC, NULL, &lenvar);
+            proto_tree_add_item_ret_varint(ft_tree, hf_quic_ack_ack_delay, tvb, offset, -1, ENC_VARINT_QUIC, &ack_delay, &lenvar);
             offset += lenvar;
 
+            tap_info = (quic_tap_info *)p_get_proto_data(wmem_packet_scope(), pinfo, proto_quic, QUIC_PROTO_DATA_TAP_INFO);
+            if (tap_info && (frame_type == FT_ACK || frame_type == FT_ACK_ECN) &&
+                (!tap_info->has_ack || largest_acknowledged > tap_info->largest_acknowledged)) {
+                tap_info->has_ack = TRUE;
+                tap_info->largest_acknowledged = largest_acknowledged;
+                tap_info->ack_delay = ack_delay;
+            }
+
             proto_tree_add_item_ret_varint(ft_tree, hf_quic_ack_ack_range_count, tvb, offset, -1, ENC_VARINT_QUIC, &ack_range_count, &lenvar);
             offset += lenvar;
 
@@ -2774,6 +3017,12 @@ quic_process_payload(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, proto_
     /*
      * If no decryption error has occurred yet, try decryption on the first
      * pass and store the result for later use.
+     *
+     * The plaintext is kept (in file scope) for the whole capture rather than
+     * in a cache with a budget: the ciphers are replaced on key updates and
+     * only the current ones are kept, so a later pass could not decrypt an
+     * evicted packet again. Header protection is likewise only removed on
+     * the first pass (first_byte and pkn_len are stored alongside).
      */
     if (!PINFO_FD_VISITED(pinfo)) {
         if (!quic_packet->decryption.error && quic_is_pp_cipher_initialized(pp_cipher)) {
@@ -3466,20 +3715,14 @@ quic_extract_header(tvbuff_t *tvb, guint8 *long_packet_type, guint32 *version,
 }
 
 /**
- * Sanity check on (coalasced) packet.
- * https://tools.ietf.org/html/draft-ietf-quic-transport-32#section-12.2
- * "Senders MUST NOT coalesce QUIC packets with different connection IDs
- *  into a single UDP datagram"
- * For the first packet of the datagram, we simply save the DCID for later usage (no real check).
- * For any subsequent packets, we control if DCID is valid.
+ * Extracts the DCID of a (coalesced) packet; returns FALSE if it cannot be
+ * known.
  */
 static gboolean
-check_dcid_on_coalesced_packet(tvbuff_t *tvb, const quic_datagram *dgram_info,
-                               gboolean is_first_packet, quic_cid_t *first_packet_dcid)
+get_dcid_of_coalesced_packet(tvbuff_t *tvb, const quic_datagram *dgram_info, quic_cid_t *dcid)
 {
     guint offset = 0;
     guint8 first_byte, dcid_len;
-    quic_cid_t dcid = {.len=0};
 
     first_byte = tvb_get_guint8(tvb, offset);
     offset++;
@@ -3488,29 +3731,49 @@ check_dcid_on_coalesced_packet(tvbuff_t *tvb, const quic_datagram *dgram_info,
         dcid_len = tvb_get_guint8(tvb, offset);
         offset++;
         if (dcid_len && dcid_len <= QUIC_MAX_CID_LENGTH) {
-            dcid.len = dcid_len;
-            tvb_memcpy(tvb, dcid.cid, offset, dcid.len);
+            dcid->len = dcid_len;
+            tvb_memcpy(tvb, dcid->cid, offset, dcid->len);
         }
     } else {
         quic_info_data_t *conn = dgram_info->conn;
         gboolean from_server = dgram_info->from_server;
         if (conn) {
-            dcid.len = from_server ? conn->client_cids.data.len : conn->server_cids.data.len;
-            if (dcid.len) {
-                tvb_memcpy(tvb, dcid.cid, offset, dcid.len);
+            dcid->len = from_server ? conn->client_cids.data.len : conn->server_cids.data.len;
+            if (dcid->len) {
+                tvb_memcpy(tvb, dcid->cid, offset, dcid->len);
             }
         } else {
             /* If we don't have a valid quic_info_data_t structure for this flow,
                we can't really validate the CID. */
-            return TRUE;
+            return FALSE;
         }
     }
+    return TRUE;
+}
 
-    if (is_first_packet) {
-        *first_packet_dcid = dcid;
-        return TRUE; /* Nothing to check */
-    }
+/**
+ * Sanity check on (coalasced) packet.
+ * https://tools.ietf.org/html/draft-ietf-quic-transport-32#section-12.2
+ * "Senders MUST NOT coalesce QUIC packets with different connection IDs
+ *  into a single UDP datagram"
+ * The DCID of any packet after the first is compared with that of the first
+ * packet, which is only extracted the first time it is needed (most
+ * datagrams hold a single packet).
+ */
+static gboolean
+check_dcid_on_coalesced_packet(tvbuff_t *tvb, const quic_datagram *dgram_info,
+                               tvbuff_t *first_packet_tvb, quic_cid_t *first_packet_dcid,
+                               gboolean *first_packet_dcid_set)
+{
+    quic_cid_t dcid = {.len=0};
 
+    if (!get_dcid_of_coalesced_packet(tvb, dgram_info, &dcid)) {
+        return TRUE;
+    }
+    if (!*first_packet_dcid_set) {
+        get_dcid_of_coalesced_packet(first_packet_tvb, dgram_info, first_packet_dcid);
+        *first_packet_dcid_set = TRUE;
+    }
     return quic_connection_equal(&dcid, first_packet_dcid);
 }
 
@@ -3524,7 +3787,9 @@ dissect_quic(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
     quic_datagram *dgram_info = NULL;
     quic_packet_info_t *quic_packet = NULL;
     quic_cid_t  real_retry_odcid = {.len=0}, *retry_odcid = NULL;
+    tvbuff_t   *first_packet_tvb = NULL;
     quic_cid_t  first_packet_dcid = {.len=0}; /* DCID of the first packet of the datagram */
+    gboolean    first_packet_dcid_set = FALSE;
 
     col_set_str(pinfo->cinfo, COL_PROTOCOL, "QUIC");
 
@@ -3556,6 +3821,13 @@ dissect_quic(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
         quic_connection_create_or_update(&conn, pinfo, long_packet_type, version, &scid, &dcid, from_server);
         dgram_info->conn = conn;
         dgram_info->from_server = from_server;
+        if (conn) {
+            guint frames_count = wmem_array_get_count(conn->frames);
+
+            if (frames_count == 0 || *(guint32 *)wmem_array_index(conn->frames, frames_count - 1) != pinfo->num) {
+                wmem_array_append_one(conn->frames, pinfo->num);
+            }
+        }
 #if 0
         proto_tree_add_debug_text(quic_tree, "Connection: %d %p DCID=%s SCID=%s from_server:%d", pinfo->num, dgram_info->conn, cid_to_string(&dcid), cid_to_string(&scid), dgram_info->from_server);
     } else {
@@ -3584,9 +3856,15 @@ dissect_quic(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
 
         tvbuff_t *next_tvb = quic_get_message_tvb(tvb, offset);
 
-        if (!check_dcid_on_coalesced_packet(next_tvb, dgram_info, offset == 0, &first_packet_dcid)) {
+        /* The first pass remembers where the padding begins, if it does. */
+        if (offset == 0) {
+            first_packet_tvb = next_tvb;
+        } else if (PINFO_FD_VISITED(pinfo) ? offset == dgram_info->padding_offset :
+                   !check_dcid_on_coalesced_packet(next_tvb, dgram_info, first_packet_tvb,
+                                                   &first_packet_dcid, &first_packet_dcid_set)) {
             /* Coalesced packet with unexpected CID; it probably is some kind
                of unencrypted padding data added after the valid QUIC payload */
+            dgram_info->padding_offset = offset;
             expert_add_info_format(pinfo, quic_tree, &ei_quic_coalesced_padding_data,
                                    "(Random) padding data appended to the datagram");
             break;
@@ -3597,6 +3875,16 @@ dissect_quic(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
         proto_item_set_generated(ti);
         guint new_offset = 0;
         guint8 first_byte = tvb_get_guint8(next_tvb, 0);
+        quic_tap_info *tap_info = NULL;
+        if (dgram_info->conn && have_tap_listener(quic_tap)) {
+            tap_info = wmem_new0(wmem_packet_scope(), quic_tap_info);
+            tap_info->connection_number = dgram_info->conn->number;
+            tap_info->from_server = dgram_info->from_server;
+            tap_info->length = tvb_reported_length(next_tvb);
+            tap_info->short_header = !(first_byte & 0x80);
+            p_remove_proto_data(wmem_packet_scope(), pinfo, proto_quic, QUIC_PROTO_DATA_TAP_INFO);
+            p_add_proto_data(wmem_packet_scope(), pinfo, proto_quic, QUIC_PROTO_DATA_TAP_INFO, tap_info);
+        }
         if (first_byte & 0x80) {
             guint8 long_packet_type = (first_byte & 0x30) >> 4;
             proto_tree_add_item(quic_tree, hf_quic_header_form, next_tvb, 0, 1, ENC_NA);
@@ -3618,6 +3906,16 @@ dissect_quic(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
             // should usually not be present unless decryption is not possible.
             proto_tree_add_item(quic_tree, hf_quic_remaining_payload, next_tvb, new_offset, -1, ENC_NA);
         }
+        if (tap_info) {
+            if (quic_packet->pkn_len && !quic_packet->decryption.error) {
+                tap_info->pkn_known = TRUE;
+                tap_info->packet_number = quic_packet->packet_number;
+                // The spin bit is not protected.
+                tap_info->spin_bit = tap_info->short_header && (first_byte & 0x20);
+            }
+            p_remove_proto_data(wmem_packet_scope(), pinfo, proto_quic, QUIC_PROTO_DATA_TAP_INFO);
+            tap_queue_packet(quic_tap, pinfo, tap_info);
+        }
         offset += tvb_reported_length(next_tvb);
     } while (tvb_reported_length_remaining(tvb, offset));
 
@@ -3728,10 +4026,12 @@ quic_init(void)
 {
     quic_connections = wmem_list_new(wmem_file_scope());
     quic_connections_count = 0;
-    quic_initial_connections = wmem_map_new(wmem_file_scope(), quic_connection_hash, quic_connection_equal);
-    quic_client_connections = wmem_map_new(wmem_file_scope(), quic_connection_hash, quic_connection_equal);
-    quic_server_connections = wmem_map_new(wmem_file_scope(), quic_connection_hash, quic_connection_equal);
+    quic_connection_frames = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
+    quic_initial_connections = wmem_flat_map_new(wmem_file_scope(), quic_connection_hash, quic_connection_equal);
+    quic_client_connections = wmem_flat_map_new(wmem_file_scope(), quic_connection_hash, quic_connection_equal);
+    quic_server_connections = wmem_flat_map_new(wmem_file_scope(), quic_connection_hash, quic_connection_equal);
     quic_cid_lengths = 0;
+    memset(quic_cid_tree, 0, sizeof(quic_cid_tree));
 }
 
 /** Release QUIC dissection state on closing a capture file. */
@@ -3742,8 +4042,247 @@ quic_cleanup(void)
     quic_initial_connections = NULL;
     quic_client_connections = NULL;
     quic_server_connections = NULL;
+    memset(quic_cid_tree, 0, sizeof(quic_cid_tree));
+}
+
+/* QUIC connection statistics {{{ */
+
+/*
+ * One row per connection, in the order in which the connections were first
+ * tapped. Losses are gaps in the packet numbers of 1-RTT packets that were
+ * not filled later; ACK RTT samples are taken when a 1-RTT ACK frame
+ * acknowledges one of the last few 1-RTT packets of the peer; spin bit RTT
+ * samples are the times between changes of the spin bit in one direction.
+ */
+typedef enum {
+    CONNECTION_COLUMN = 0,
+    CLIENT_PACKETS_COLUMN,
+    CLIENT_BYTES_COLUMN,
+    CLIENT_LOST_COLUMN,
+    SERVER_PACKETS_COLUMN,
+    SERVER_BYTES_COLUMN,
+    SERVER_LOST_COLUMN,
+    ACK_RTT_SAMPLES_COLUMN,
+    ACK_RTT_MIN_COLUMN,
+    ACK_RTT_AVG_COLUMN,
+    SPIN_RTT_SAMPLES_COLUMN,
+    SPIN_RTT_AVG_COLUMN
+} quic_conn_stat_columns;
+
+static stat_tap_table_item quic_conn_stat_fields[] = {
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "Connection", "%10u"},
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "Client Packets", "%14u"},
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "Client Bytes", "%12u"},
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "Client Lost", "%11u"},
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "Server Packets", "%14u"},
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "Server Bytes", "%12u"},
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "Server Lost", "%11u"},
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "ACK RTT Samples", "%15u"},
+    {TABLE_ITEM_FLOAT, TAP_ALIGN_RIGHT, "Min ACK RTT (ms)", "%16.3f"},
+    {TABLE_ITEM_FLOAT, TAP_ALIGN_RIGHT, "Avg ACK RTT (ms)", "%16.3f"},
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "Spin RTT Samples", "%16u"},
+    {TABLE_ITEM_FLOAT, TAP_ALIGN_RIGHT, "Avg Spin RTT (ms)", "%17.3f"}
+};
+
+/* The recent 1-RTT packets of each side, indexed by packet number modulo
+ * this, that ACK frames are matched against. */
+#define QUIC_CONN_STAT_SENT_SLOTS 8
+
+/* State of a connection, in the user data of its CONNECTION_COLUMN. Arrays
+ * are indexed by from_server. */
+typedef struct {
+    guint64     bytes[2];
+    guint64     max_pkn[2];         /**< Largest 1-RTT packet number, valid if pkn_seen. */
+    guint32     missing[2];         /**< Packet numbers skipped and not seen since. */
+    gboolean    pkn_seen[2];
+    gboolean    spin[2];            /**< Last spin bit, valid if pkn_seen. */
+    gboolean    spin_edge_seen[2];
+    double      spin_edge[2];       /**< Time of the last change of the spin bit. */
+    double      spin_rtt_sum;
+    guint32     spin_rtt_count;
+    double      ack_rtt_sum;
+    double      ack_rtt_min;
+    guint32     ack_rtt_count;
+    struct {
+        guint64 pkn;
+        double  time;
+        gboolean valid;             /**< FALSE if unused or acknowledged already. */
+    } sent[2][QUIC_CONN_STAT_SENT_SLOTS];
+} quic_conn_stat_t;
+
+/* Connection number -> 1 + row. */
+static GHashTable *quic_conn_stat_rows;
+
+static void
+quic_conn_stat_init(stat_tap_table_ui* new_stat)
+{
+    const char *table_name = "QUIC Connections";
+    int num_fields = sizeof(quic_conn_stat_fields)/sizeof(stat_tap_table_item);
+    stat_tap_table *table;
+
+    table = stat_tap_find_table(new_stat, table_name);
+    if (table) {
+        if (new_stat->stat_tap_reset_table_cb) {
+            new_stat->stat_tap_reset_table_cb(table);
+        }
+        return;
+    }
+
+    if (!quic_conn_stat_rows) {
+        quic_conn_stat_rows = g_hash_table_new(g_direct_hash, g_direct_equal);
+    }
+    table = stat_tap_init_table(table_name, num_fields, 0, "quic.connection.number");
+    stat_tap_add_table(new_stat, table);
+}
+
+static void
+quic_conn_stat_set_uint(stat_tap_table *table, guint row, guint column, guint64 value)
+{
+    stat_tap_table_item_type *item_data = stat_tap_get_field_data(table, row, column);
+    item_data->value.uint_value = (guint)MIN(value, G_MAXUINT);
+    stat_tap_set_field_data(table, row, column, item_data);
+}
+
+static void
+quic_conn_stat_set_float(stat_tap_table *table, guint row, guint column, double value)
+{
+    stat_tap_table_item_type *item_data = stat_tap_get_field_data(table, row, column);
+    item_data->value.float_value = value;
+    stat_tap_set_field_data(table, row, column, item_data);
 }
 
+static tap_packet_status
+quic_conn_stat_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const void *data)
+{
+    stat_data_t *stat_data = (stat_data_t *)tapdata;
+    const quic_tap_info *info = (const quic_tap_info *)data;
+    stat_tap_table *table;
+    stat_tap_table_item_type *item_data;
+    quic_conn_stat_t *stat;
+    guint row;
+    const int side = info->from_server ? 1 : 0;
+    const double now = nstime_to_sec(&pinfo->abs_ts);
+
+    table = g_array_index(stat_data->stat_tap_data->tables, stat_tap_table*, 0);
+    row = GPOINTER_TO_UINT(g_hash_table_lookup(quic_conn_stat_rows, GUINT_TO_POINTER(info->connection_number)));
+    if (row == 0) {
+        stat_tap_table_item_type items[sizeof(quic_conn_stat_fields)/sizeof(stat_tap_table_item)];
+        guint i;
+
+        memset(items, 0, sizeof(items));
+        for (i = 0; i < G_N_ELEMENTS(items); i++) {
+            items[i].type = quic_conn_stat_fields[i].type;
+        }
+        items[CONNECTION_COLUMN].value.uint_value = info->connection_number;
+        items[CONNECTION_COLUMN].user_data.ptr_value = g_new0(quic_conn_stat_t, 1);
+        row = table->num_elements;
+        stat_tap_init_table_row(table, row, G_N_ELEMENTS(items), items);
+        g_hash_table_insert(quic_conn_stat_rows, GUINT_TO_POINTER(info->connection_number), GUINT_TO_POINTER(row + 1));
+    } else {
+        row--;
+    }
+    item_data = stat_tap_get_field_data(table, row, CONNECTION_COLUMN);
+    stat = (quic_conn_stat_t *)item_data->user_data.ptr_value;
+
+    stat->bytes[side] += info->length;
+    item_data = stat_tap_get_field_data(table, row, side ? SERVER_PACKETS_COLUMN : CLIENT_PACKETS_COLUMN);
+    item_data->value.uint_value++;
+    stat_tap_set_field_data(table, row, side ? SERVER_PACKETS_COLUMN : CLIENT_PACKETS_COLUMN, item_data);
+    quic_conn_stat_set_uint(table, row, side ? SERVER_BYTES_COLUMN : CLIENT_BYTES_COLUMN, stat->bytes[side]);
+
+    if (!info->short_header || !info->pkn_known) {
+        return TAP_PACKET_REDRAW;
+    }
+
+    if (info->has_ack) {
+        const int peer = !side;
+        guint slot = (guint)(info->largest_acknowledged % QUIC_CONN_STAT_SENT_SLOTS);
+
+        if (stat->sent[peer][slot].valid && stat->sent[peer][slot].pkn == info->largest_acknowledged) {
+            double rtt = now - stat->sent[peer][slot].time;
+            // Assume the default ack_delay_exponent of 3.
+            double ack_delay = (double)(info->ack_delay << 3) / 1000000.0;
+
+            stat->sent[peer][slot].valid = FALSE;
+            if (rtt >= 0) {
+                if (stat->ack_rtt_count > 0 && rtt - ack_delay >= stat->ack_rtt_min) {
+                    rtt -= ack_delay;
+                }
+                if (stat->ack_rtt_count == 0 || rtt < stat->ack_rtt_min) {
+                    stat->ack_rtt_min = rtt;
+                }
+                stat->ack_rtt_sum += rtt;
+                stat->ack_rtt_count++;
+                quic_conn_stat_set_uint(table, row, ACK_RTT_SAMPLES_COLUMN, stat->ack_rtt_count);
+                quic_conn_stat_set_float(table, row, ACK_RTT_MIN_COLUMN, stat->ack_rtt_min * 1000.0);
+                quic_conn_stat_set_float(table, row, ACK_RTT_AVG_COLUMN, stat->ack_rtt_sum * 1000.0 / stat->ack_rtt_count);
+            }
+        }
+    }
+
+    if (!stat->pkn_seen[side] || info->packet_number > stat->max_pkn[side]) {
+        if (stat->pkn_seen[side]) {
+            stat->missing[side] += (guint32)MIN(info->packet_number - stat->max_pkn[side] - 1, G_MAXUINT32 - stat->missing[side]);
+            // Only packets in order show the spin bit changes.
+            if (info->spin_bit != stat->spin[side]) {
+                if (stat->spin_edge_seen[side]) {
+                    stat->spin_rtt_sum += now - stat->spin_edge[side];
+                    stat->spin_rtt_count++;
+                    quic_conn_stat_set_uint(table, row, SPIN_RTT_SAMPLES_COLUMN, stat->spin_rtt_count);
+                    quic_conn_stat_set_float(table, row, SPIN_RTT_AVG_COLUMN, stat->spin_rtt_sum * 1000.0 / stat->spin_rtt_count);
+                }
+                stat->spin_edge_seen[side] = TRUE;
+                stat->spin_edge[side] = now;
+            }
+        }
+        stat->pkn_seen[side] = TRUE;
+        stat->max_pkn[side] = info->packet_number;
+        stat->spin[side] = info->spin_bit;
+    } else if (info->packet_number < stat->max_pkn[side] && stat->missing[side] > 0) {
+        // Reordered rather than lost.
+        stat->missing[side]--;
+    }
+    quic_conn_stat_set_uint(table, row, side ? SERVER_LOST_COLUMN : CLIENT_LOST_COLUMN, stat->missing[side]);
+
+    guint slot = (guint)(info->packet_number % QUIC_CONN_STAT_SENT_SLOTS);
+    stat->sent[side][slot].pkn = info->packet_number;
+    stat->sent[side][slot].time = now;
+    stat->sent[side][slot].valid = TRUE;
+
+    return TAP_PACKET_REDRAW;
+}
+
+static void
+quic_conn_stat_reset(stat_tap_table* table)
+{
+    guint element, column;
+    stat_tap_table_item_type *item_data;
+
+    for (element = 0; element < table->num_elements; element++) {
+        item_data = stat_tap_get_field_data(table, element, CONNECTION_COLUMN);
+        memset(item_data->user_data.ptr_value, 0, sizeof(quic_conn_stat_t));
+        for (column = CLIENT_PACKETS_COLUMN; column < table->num_fields; column++) {
+            item_data = stat_tap_get_field_data(table, element, column);
+            if (item_data->type == TABLE_ITEM_FLOAT) {
+                item_data->value.float_value = 0.0;
+            } else {
+                item_data->value.uint_value = 0;
+            }
+            stat_tap_set_field_data(table, element, column, item_data);
+        }
+    }
+}
+
+static void
+quic_conn_stat_free_table_item(stat_tap_table* table _U_, guint row _U_, guint column, stat_tap_table_item_type* field_data)
+{
+    if (column != CONNECTION_COLUMN) return;
+    g_hash_table_remove(quic_conn_stat_rows, GUINT_TO_POINTER(field_data->value.uint_value));
+    g_free(field_data->user_data.ptr_value);
+    field_data->user_data.ptr_value = NULL;
+}
+/* QUIC connection statistics }}} */
+
 /* Follow QUIC Stream functionality {{{ */
 
 static gchar *
@@ -3772,6 +4311,12 @@ quic_follow_index_filter(guint stream, guint sub_stream)
     return g_strdup_printf("quic.connection.number eq %u and quic.stream.stream_id eq %u", stream, sub_stream);
 }
 
+static wmem_array_t *
+quic_follow_stream_frames(guint stream, guint sub_stream _U_)
+{
+    return (wmem_array_t *)wmem_map_lookup(quic_connection_frames, GUINT_TO_POINTER(stream));
+}
+
 static gchar *
 quic_follow_address_filter(address *src_addr _U_, address *dst_addr _U_, int src_port _U_, int dst_port _U_)
 {
@@ -3801,6 +4346,26 @@ proto_register_quic(void)
 {
     expert_module_t *expert_quic;
 
+    static tap_param quic_conn_stat_params[] = {
+        { PARAM_FILTER, "filter", "Filter", NULL, TRUE }
+    };
+
+    static stat_tap_table_ui quic_conn_stat_table = {
+        REGISTER_STAT_GROUP_UNSORTED,
+        "QUIC Connections",
+        "quic",
+        "quic,conn",
+        quic_conn_stat_init,
+        quic_conn_stat_packet,
+        quic_conn_stat_reset,
+        quic_conn_stat_free_table_item,
+        NULL,
+        sizeof(quic_conn_stat_fields)/sizeof(stat_tap_table_item), quic_conn_stat_fields,
+        sizeof(quic_conn_stat_params)/sizeof(tap_param), quic_conn_stat_params,
+        NULL,
+        0
+    };
+
     static hf_register_info hf[] = {
         { &hf_quic_connection_number,
           { "Connection Number", "quic.connection.number",
@@ -4467,11 +5032,16 @@ proto_register_quic(void)
 
     register_follow_stream(proto_quic, "quic_follow", quic_follow_conv_filter, quic_follow_index_filter, quic_follow_address_filter,
                            udp_port_to_display, follow_quic_tap_listener);
+    register_follow_stream_frames(proto_quic, quic_follow_stream_frames);
 
     // TODO implement custom reassembly functions that uses the QUIC Connection
     // ID instead of address and port numbers.
     reassembly_table_register(&quic_reassembly_table,
                               &addresses_ports_reassembly_table_functions);
+    /* Reassembled STREAM data is a composite over the fragments rather than
+     * another copy of them; with duplicates skipped, the fragments of a
+     * stream rarely overlap, which would make it fall back to copying. */
+    quic_reassembly_table.composite_data = TRUE;
 
     /*
      * Application protocol. QUIC with TLS uses ALPN.
@@ -4480,6 +5050,9 @@ proto_register_quic(void)
      * bytes, but in practice these do not exist yet.
      */
     quic_proto_dissector_table = register_dissector_table("quic.proto", "QUIC Protocol", proto_quic, FT_STRING, FALSE);
+
+    quic_tap = register_tap("quic");
+    register_stat_tap_table_ui(&quic_conn_stat_table);
 }
 
 void
@@ -61,6 +61,24 @@ void   *quic_stream_get_proto_data(struct _packet_info *pinfo, quic_stream_info
 /** Returns the number of items for quic.connection.number. */
 WS_DLL_PUBLIC guint32 get_quic_connections_count(void);
 
+/**
+ * Data of the "quic" tap, queued for every QUIC packet of a known connection.
+ * Packet numbers, spin bits and ACK frames are only known for packets which
+ * could be decrypted.
+ */
+typedef struct _quic_tap_info {
+    guint32     connection_number;  /**< As quic.connection.number. */
+    gboolean    from_server;
+    guint32     length;             /**< Length of the QUIC packet within the UDP datagram. */
+    gboolean    short_header;
+    gboolean    pkn_known;          /**< TRUE if packet_number and spin_bit are set. */
+    guint64     packet_number;
+    gboolean    spin_bit;           /**< Short header packets only. */
+    gboolean    has_ack;            /**< TRUE if there is an ACK or ACK_ECN frame. */
+    guint64     largest_acknowledged;
+    guint64     ack_delay;          /**< Raw ACK Delay field, not scaled by ack_delay_exponent. */
+} quic_tap_info;
+
 typedef struct gquic_info_data {
     guint8 version;
     gboolean version_valid;
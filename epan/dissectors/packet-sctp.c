@@ -429,9 +429,16 @@ typedef struct _infodata_t {
   guint16 direction;
 } infodata_t;
 
-static wmem_list_t *assoc_info_list = NULL;
+/* The associations, newest first, by their pair of ports and by each of
+   their tags, so that those a packet may belong to are found without
+   going through them all. */
+static wmem_map_t *assocs_by_ports = NULL;
+static wmem_map_t *assocs_by_tag = NULL;
 static guint num_assocs = 0;
 
+#define ASSOC_PORTS_KEY(a, b) \
+  GUINT_TO_POINTER((a) < (b) ? ((guint)(a) << 16) | (b) : ((guint)(b) << 16) | (a))
+
 UAT_CSTRING_CB_DEF(type_fields, type_name, type_field_t)
 UAT_VS_DEF(type_fields, type_enable, type_field_t, guint, 0, "Show")
 UAT_DEC_CB_DEF(type_fields, type_id, type_field_t)
@@ -582,87 +589,148 @@ static gint sctp_assoc_vtag_cmp(const assoc_info_t *a, const assoc_info_t *b)
 }
 #undef RETURN_DIRECTION
 
+static void
+assoc_index_add(wmem_map_t *map, gpointer key, assoc_info_t *info)
+{
+  wmem_list_t *list = (wmem_list_t *)wmem_map_lookup(map, key);
+
+  if (list == NULL) {
+    list = wmem_list_new(wmem_file_scope());
+    wmem_map_insert(map, key, list);
+  } else if (wmem_list_frame_data(wmem_list_head(list)) == info) {
+    return;
+  }
+  wmem_list_prepend(list, info);
+}
+
+/* A tag of an association may be learned after it's created; it's found
+   by any tag it has had, and what it has now is checked. */
+static void
+assoc_index_add_tag(assoc_info_t *info, guint32 tag)
+{
+  if (tag != 0)
+    assoc_index_add(assocs_by_tag, GUINT_TO_POINTER(tag), info);
+}
+
+/* Does a packet seen before belong to an association, by its tags?
+   1 if it does and goes in its direction, 2 if in the other one, 0 if it
+   doesn't belong to it. */
+static int
+assoc_tags_match(const assoc_info_t *tmpinfo, const assoc_info_t *info)
+{
+  if ((tmpinfo->initiate_tag != 0 && tmpinfo->initiate_tag == info->initiate_tag) ||
+      (tmpinfo->verification_tag1 != 0 && tmpinfo->verification_tag1 == info->verification_tag1) ||
+      (tmpinfo->verification_tag2 != 0 && tmpinfo->verification_tag2 == info->verification_tag2))
+    return 1;
+  if ((tmpinfo->verification_tag1 != 0 && tmpinfo->verification_tag1 == info->verification_tag2) ||
+      (tmpinfo->verification_tag2 != 0 && tmpinfo->verification_tag2 == info->verification_tag1) ||
+      (tmpinfo->verification_tag1 == 0 && tmpinfo->initiate_tag != 0 &&
+      tmpinfo->initiate_tag == info->verification_tag1))
+    return 2;
+  return 0;
+}
+
 static infodata_t
 find_assoc_index(assoc_info_t* tmpinfo, gboolean visited)
 {
-  assoc_info_t *info = NULL;
+  assoc_info_t *info = NULL, *found = NULL;
+  wmem_list_t *list;
   wmem_list_frame_t *elem;
   gboolean cmp = FALSE;
+  int match, found_match = 0;
+  guint32 tags[3];
+  guint i;
   infodata_t inf;
   inf.assoc_index = -1;
   inf.direction = 1;
 
-  if (assoc_info_list == NULL) {
-    assoc_info_list = wmem_list_new(wmem_file_scope());
+  if (assocs_by_ports == NULL) {
+    assocs_by_ports = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
+    assocs_by_tag = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
   }
 
-  for (elem = wmem_list_head(assoc_info_list); elem; elem = wmem_list_frame_next(elem))
+  if (visited) {
+    /* The newest association that has one of the packet's tags */
+    tags[0] = tmpinfo->initiate_tag;
+    tags[1] = tmpinfo->verification_tag1;
+    tags[2] = tmpinfo->verification_tag2;
+    for (i = 0; i < 3; i++) {
+      if (tags[i] == 0)
+        continue;
+      list = (wmem_list_t *)wmem_map_lookup(assocs_by_tag, GUINT_TO_POINTER(tags[i]));
+      for (elem = list ? wmem_list_head(list) : NULL; elem; elem = wmem_list_frame_next(elem)) {
+        info = (assoc_info_t*) wmem_list_frame_data(elem);
+        if (found != NULL && info->assoc_index <= found->assoc_index)
+          continue;
+        match = assoc_tags_match(tmpinfo, info);
+        if (match != 0) {
+          found = info;
+          found_match = match;
+        }
+      }
+    }
+    if (found != NULL) {
+      inf.assoc_index = found->assoc_index;
+      if (found_match == 1)
+        inf.direction = found->direction;
+      else
+        inf.direction = (found->direction == 1) ? 2 : 1;
+    }
+    return inf;
+  }
+
+  /* Only associations between the same ports can match. */
+  list = (wmem_list_t *)wmem_map_lookup(assocs_by_ports, ASSOC_PORTS_KEY(tmpinfo->sport, tmpinfo->dport));
+  for (elem = list ? wmem_list_head(list) : NULL; elem; elem = wmem_list_frame_next(elem))
   {
     info = (assoc_info_t*) wmem_list_frame_data(elem);
 
-    if (!visited) {
-      cmp = sctp_assoc_vtag_cmp(tmpinfo, info);
-      if (cmp < ASSOC_NOT_FOUND) {
-        switch (cmp)
-        {
-          case FORWARD_ADD_FORWARD_VTAG:
-          case BACKWARD_ADD_FORWARD_VTAG:
-            info->verification_tag1 = tmpinfo->verification_tag1;
-            break;
-          case BACKWARD_ADD_BACKWARD_VTAG:
-            info->verification_tag2 = tmpinfo->verification_tag1;
-            info->direction = 1;
-            inf.assoc_index = info->assoc_index;
-            inf.direction = 2;
-            return inf;
-          case BACKWARD_STREAM:
-            inf.assoc_index = info->assoc_index;
-            inf.direction = 2;
-            return inf;
-        }
-        if (cmp == FORWARD_STREAM || cmp == FORWARD_ADD_FORWARD_VTAG) {
+    cmp = sctp_assoc_vtag_cmp(tmpinfo, info);
+    if (cmp < ASSOC_NOT_FOUND) {
+      switch (cmp)
+      {
+        case FORWARD_ADD_FORWARD_VTAG:
+        case BACKWARD_ADD_FORWARD_VTAG:
+          info->verification_tag1 = tmpinfo->verification_tag1;
+          assoc_index_add_tag(info, info->verification_tag1);
+          break;
+        case BACKWARD_ADD_BACKWARD_VTAG:
+          info->verification_tag2 = tmpinfo->verification_tag1;
+          assoc_index_add_tag(info, info->verification_tag2);
           info->direction = 1;
-        } else {
-          info->direction = 2;
-        }
-        inf.assoc_index = info->assoc_index;
-        inf.direction = info->direction;
-        return inf;
-      }
-    } else {
-      if ((tmpinfo->initiate_tag != 0 && tmpinfo->initiate_tag == info->initiate_tag) ||
-          (tmpinfo->verification_tag1 != 0 && tmpinfo->verification_tag1 == info->verification_tag1) ||
-          (tmpinfo->verification_tag2 != 0 && tmpinfo->verification_tag2 == info->verification_tag2)) {
-        inf.assoc_index = info->assoc_index;
-        inf.direction = info->direction;
-        return inf;
-      } else if ((tmpinfo->verification_tag1 != 0 && tmpinfo->verification_tag1 == info->verification_tag2) ||
-                 (tmpinfo->verification_tag2 != 0 && tmpinfo->verification_tag2 == info->verification_tag1) ||
-                 (tmpinfo->verification_tag1 == 0 && tmpinfo->initiate_tag != 0 &&
-                 tmpinfo->initiate_tag == info->verification_tag1)) {
-        inf.assoc_index = info->assoc_index;
-        if (info->direction == 1)
+          inf.assoc_index = info->assoc_index;
+          inf.direction = 2;
+          return inf;
+        case BACKWARD_STREAM:
+          inf.assoc_index = info->assoc_index;
           inf.direction = 2;
-        else
-          inf.direction = 1;
-        return inf;
+          return inf;
       }
+      if (cmp == FORWARD_STREAM || cmp == FORWARD_ADD_FORWARD_VTAG) {
+        info->direction = 1;
+      } else {
+        info->direction = 2;
+      }
+      inf.assoc_index = info->assoc_index;
+      inf.direction = info->direction;
+      return inf;
     }
   }
 
-  if (!elem && !visited) {
-    info = wmem_new0(wmem_file_scope(), assoc_info_t);
-    info->assoc_index = num_assocs;
-    info->sport = tmpinfo->sport;
-    info->dport = tmpinfo->dport;
-    info->verification_tag1 = tmpinfo->verification_tag1;
-    info->verification_tag2 = tmpinfo->verification_tag2;
-    info->initiate_tag = tmpinfo->initiate_tag;
-    num_assocs++;
-    wmem_list_prepend(assoc_info_list, info);
-    inf.assoc_index = info->assoc_index;
-    inf.direction = 1;
-  }
+  info = wmem_new0(wmem_file_scope(), assoc_info_t);
+  info->assoc_index = num_assocs;
+  info->sport = tmpinfo->sport;
+  info->dport = tmpinfo->dport;
+  info->verification_tag1 = tmpinfo->verification_tag1;
+  info->verification_tag2 = tmpinfo->verification_tag2;
+  info->initiate_tag = tmpinfo->initiate_tag;
+  num_assocs++;
+  assoc_index_add(assocs_by_ports, ASSOC_PORTS_KEY(info->sport, info->dport), info);
+  assoc_index_add_tag(info, info->initiate_tag);
+  assoc_index_add_tag(info, info->verification_tag1);
+  assoc_index_add_tag(info, info->verification_tag2);
+  inf.assoc_index = info->assoc_index;
+  inf.direction = 1;
 
   return inf;
 }
@@ -2618,7 +2686,8 @@ sctp_init(void)
   frag_table = g_hash_table_new_full(frag_hash, frag_equal,
       (GDestroyNotify)g_free, (GDestroyNotify)frag_free_msgs);
   num_assocs = 0;
-  assoc_info_list = NULL;
+  assocs_by_ports = NULL;
+  assocs_by_tag = NULL;
 }
 
 static void
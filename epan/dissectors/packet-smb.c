@@ -1010,7 +1010,7 @@ static const value_string smb2_fid_types[] = {
 
 /* This struct contains the relationship between
 	the row# in the export_object window and the file being captured;
-	the row# in this GSList will match the row# in the entry list */
+	the row# in this GPtrArray will match the row# in the entry list */
 
 typedef struct _active_file {
 	guint16   tid, uid;
@@ -1022,8 +1022,11 @@ typedef struct _active_file {
 	gboolean  is_out_of_memory; /* TRUE if we cannot allocate memory for this file */
 } active_file ;
 
-/* This is the GSList that will contain all the files that we are tracking */
-static GSList    *GSL_active_files = NULL;
+/* This is the GPtrArray that will contain all the files that we are tracking */
+static GPtrArray *GPA_active_files = NULL;
+/* The row# of the last file in GPA_active_files with each tid and fid,
+	keyed by its active_file */
+static GHashTable *GHT_active_file_rows = NULL;
 
 /* We define a free chunk in a file as an start offset and end offset
 	Consider a free chunk as a "hole" in a file that we are capturing */
@@ -1188,34 +1191,39 @@ insert_chunk(active_file   *file, export_object_entry_t *entry, const smb_eo_t *
 	}
 }
 
-/* We use this function to obtain the index in the GSL of a given file */
+/* The best-working criteria of two identical files is that the file
+	that is the same of the file that we are analyzing is the last one
+	in the list that has the same tid and the same fid */
+/* note that we have excluded uid from the comparison, because a file can
+	be opened by different SMB users and it is still the same file */
+static guint
+active_file_hash(gconstpointer k)
+{
+	const active_file *file = (const active_file *)k;
+
+	return file->fid ^ ((guint)file->tid << 16);
+}
+
+static gboolean
+active_file_equal(gconstpointer k1, gconstpointer k2)
+{
+	const active_file *file1 = (const active_file *)k1;
+	const active_file *file2 = (const active_file *)k2;
+
+	return file1->tid == file2->tid && file1->fid == file2->fid;
+}
+
+/* We use this function to obtain the index in the GPA of a given file */
 static int
-find_incoming_file(GSList *GSL_active_files_p, active_file *incoming_file)
+find_incoming_file(active_file *incoming_file)
 {
-	int          i, row, last;
-	active_file *in_list_file;
+	gpointer row;
 
-	row  = -1;
-	last = g_slist_length(GSL_active_files_p) - 1;
-
-	/* We lookup in reverse order because it is more likely that the file
-		is one of the latest */
-	for (i=last; i>=0; i--) {
-		in_list_file = (active_file *)g_slist_nth_data(GSL_active_files_p, i);
-		/* The best-working criteria of two identical files is that the file
-			that is the same of the file that we are analyzing is the last one
-			in the list that has the same tid and the same fid */
-		/* note that we have excluded in_list_file->uid == incoming_file->uid
-			from the comparison, because a file can be opened by different
-			SMB users and it is still the same file */
-		if (in_list_file->tid == incoming_file->tid &&
-			in_list_file->fid == incoming_file->fid) {
-			row = i;
-			break;
-		}
-	}
+	if (!GHT_active_file_rows)
+		return -1;
 
-	return row;
+	row = g_hash_table_lookup(GHT_active_file_rows, incoming_file);
+	return row ? GPOINTER_TO_INT(row) - 1 : -1;
 }
 
 static tap_packet_status
@@ -1279,11 +1287,11 @@ smb_eo_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const
 	incoming_file.tid = eo_info->tid;
 	incoming_file.uid = eo_info->uid;
 	incoming_file.fid = eo_info->fid;
-	active_row = find_incoming_file(GSL_active_files, &incoming_file);
+	active_row = find_incoming_file(&incoming_file);
 
 	if (active_row == -1) { /* This is a new-tracked file */
 		/* Construct the entry in the list of active files */
-		entry = g_new(export_object_entry_t, 1);
+		entry = g_new0(export_object_entry_t, 1);
 		entry->payload_data = NULL;
 		entry->payload_len = 0;
 		new_file = g_new(active_file, 1);
@@ -1329,10 +1337,16 @@ smb_eo_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const
 		}
 
 		object_list->add_entry(object_list->gui_data, entry);
-		GSL_active_files = g_slist_append(GSL_active_files, new_file);
+		if (!GPA_active_files) {
+			GPA_active_files = g_ptr_array_new();
+			GHT_active_file_rows = g_hash_table_new(active_file_hash, active_file_equal);
+		}
+		g_ptr_array_add(GPA_active_files, new_file);
+		/* the row# of the entry, plus one so that it is not NULL */
+		g_hash_table_insert(GHT_active_file_rows, new_file, GINT_TO_POINTER(GPA_active_files->len));
 	}
 	else if (is_supported_filetype) {
-		current_file = (active_file *)g_slist_nth_data(GSL_active_files, active_row);
+		current_file = (active_file *)g_ptr_array_index(GPA_active_files, active_row);
 		/* Recalculate the current file flags */
 		current_file->flag_contains = current_file->flag_contains|contains;
 		current_entry = object_list->get_entry(object_list->gui_data, active_row);
@@ -1368,23 +1382,24 @@ smb_eo_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const
 static void
 smb_eo_cleanup(void)
 {
-	int          i, last;
+	guint        i;
 	active_file *in_list_file;
 
 	/* Free any previous data structures used in previous invocation to the
 		export_object_smb function */
-	last = g_slist_length(GSL_active_files);
-	if (GSL_active_files) {
-		for (i=last-1; i>=0; i--) {
-			in_list_file = (active_file *)g_slist_nth_data(GSL_active_files, i);
+	if (GPA_active_files) {
+		g_hash_table_destroy(GHT_active_file_rows);
+		GHT_active_file_rows = NULL;
+		for (i=0; i<GPA_active_files->len; i++) {
+			in_list_file = (active_file *)g_ptr_array_index(GPA_active_files, i);
 			if (in_list_file->free_chunk_list) {
 				g_slist_free(in_list_file->free_chunk_list);
 				in_list_file->free_chunk_list = NULL;
 			}
 			g_free(in_list_file);
 		}
-		g_slist_free(GSL_active_files);
-		GSL_active_files = NULL;
+		g_ptr_array_free(GPA_active_files, TRUE);
+		GPA_active_files = NULL;
 	}
 }
 
@@ -21425,6 +21440,8 @@ proto_register_smb(void)
 	register_srt_table(proto_smb, NULL, 3, smbstat_packet, smbstat_init, NULL);
 	/* Register the tap for the "Export Object" function */
 	smb_eo_tap = register_export_object(proto_smb, smb_eo_packet, smb_eo_cleanup);
+	/* Files are put together from the reads and writes as they're seen. */
+	export_object_set_updates_entries(proto_smb);
 }
 
 void
@@ -1461,6 +1461,22 @@ smb2_fid_info_hash(gconstpointer k)
 	return hash;
 }
 
+/* Callback for freeing, once the packet has been dissected and tapped,
+ * the saved info of a request whose response has been seen, when matched
+ * requests are not kept. */
+static gboolean
+smb2_saved_info_forget(wmem_allocator_t *allocator _U_, wmem_cb_event_t event _U_,
+		       void *user_data)
+{
+	smb2_saved_info_t *ssi = (smb2_saved_info_t *)user_data;
+
+	wmem_free(wmem_file_scope(), ssi->preauth_hash_req);
+	wmem_free(wmem_file_scope(), ssi->preauth_hash_res);
+	wmem_free(wmem_file_scope(), ssi);
+
+	return FALSE;
+}
+
 /* Callback for destroying the glib hash tables associated with a conversation
  * struct. */
 static gboolean
@@ -6196,6 +6212,7 @@ smb2_pipe_set_file_id(packet_info *pinfo, smb2_info_t *si)
 
 static gboolean smb2_pipe_reassembly = TRUE;
 static gboolean smb2_verify_signatures = FALSE;
+static gboolean smb2_forget_matched = FALSE;
 static reassembly_table smb2_pipe_reassembly_table;
 
 static int
@@ -10969,7 +10986,12 @@ dissect_smb2(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, gboolea
 					/* just  set the response frame and move it to the matched table */
 					ssi->frame_res = pinfo->num;
 					g_hash_table_remove(si->conv->unmatched, ssi);
-					g_hash_table_insert(si->conv->matched, ssi, ssi);
+					if (smb2_forget_matched) {
+						/* nothing will look for it again */
+						wmem_register_callback(wmem_packet_scope(), smb2_saved_info_forget, ssi);
+					} else {
+						g_hash_table_insert(si->conv->matched, ssi, ssi);
+					}
 				}
 			}
 		} else {
@@ -13870,6 +13892,15 @@ proto_register_smb2(void)
 		"Whether the dissector should try to verify SMB2 signatures",
 		&smb2_verify_signatures);
 
+	prefs_register_bool_preference(smb2_module, "forget_matched",
+		"Forget requests once their response has been seen",
+		"Whether the dissector should free what it saved about a request "
+		"as soon as its response has been dissected. This saves memory on "
+		"very large captures read in a single pass (e.g. by TShark without "
+		"-2), but requests and responses are no longer linked to each other "
+		"when packets are dissected again",
+		&smb2_forget_matched);
+
 	seskey_uat = uat_new("Secret session key to use for decryption",
 			     sizeof(smb2_seskey_field_t),
 			     "smb2_seskey_list",
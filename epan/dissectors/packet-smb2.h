@@ -58,20 +58,23 @@ typedef enum {
 	SMB2_EI_FILENAME,	/* fid tracking  char * */
 	SMB2_EI_FINDPATTERN	/* find tracking  char * */
 } smb2_extra_info_t;
+/* One of these is kept for every request, for the whole capture unless
+ * matched ones are forgotten, so the members are ordered not to need
+ * padding. */
 typedef struct _smb2_saved_info_t {
-	guint8 smb2_class;
-	guint8 infolevel;
 	guint64 msg_id;
-	guint32 frame_req, frame_res;
 	nstime_t req_time;
 	guint8 *preauth_hash_req, *preauth_hash_res;
 	smb2_fid_info_t *file;
-	e_ctx_hnd policy_hnd; 		/* for eo_smb tracking */
 	smb_eo_t	*eo_info_t;	/* for storing eo_smb infos */
+	void *extra_info;
 	guint64		file_offset;	/* needed file_offset for eo_smb */
+	guint32 frame_req, frame_res;
 	guint32		bytes_moved;	/* needed for eo_smb */
-	void *extra_info;
+	e_ctx_hnd policy_hnd; 		/* for eo_smb tracking */
 	smb2_extra_info_t extra_info_type;
+	guint8 smb2_class;
+	guint8 infolevel;
 } smb2_saved_info_t;
 
 typedef struct _smb2_tid_info_t {
@@ -37,6 +37,7 @@
 
 #include "packet-tcp.h"
 #include "packet-ip.h"
+#include "packet-frame.h"
 #include "packet-icmp.h"
 
 void proto_register_tcp(void);
@@ -618,6 +619,11 @@ static dissector_handle_t tcp_handle;
 static dissector_handle_t sport_handle;
 static dissector_handle_t tcp_opt_unknown_handle;
 static guint32 tcp_stream_count;
+/* Relation between stream -> the frames in which it appears */
+static wmem_map_t *tcp_stream_frames;
+/* Relation between stream -> the headers of its segments, for the graphs */
+static wmem_map_t *tcp_stream_graph_segments;
+static gboolean tcp_record_graph_segments = TRUE;
 static guint32 mptcp_stream_count;
 
 
@@ -973,6 +979,11 @@ gchar *tcp_follow_index_filter(guint stream, guint sub_stream _U_)
     return g_strdup_printf("tcp.stream eq %u", stream);
 }
 
+wmem_array_t *tcp_follow_stream_frames(guint stream, guint sub_stream _U_)
+{
+    return (wmem_array_t *)wmem_map_lookup(tcp_stream_frames, GUINT_TO_POINTER(stream));
+}
+
 gchar *tcp_follow_address_filter(address *src_addr, address *dst_addr, int src_port, int dst_port)
 {
     const gchar  *ip_version = src_addr->type == AT_IPv6 ? "v6" : "";
@@ -1429,6 +1440,7 @@ static void conversation_completeness_fill(gchar *buf, guint32 value)
 static gboolean tcp_analyze_seq           = TRUE;
 static gboolean tcp_relative_seq          = TRUE;
 static gboolean tcp_track_bytes_in_flight = TRUE;
+static gboolean tcp_analyze_flags_only    = FALSE;
 static gboolean tcp_calculate_ts          = TRUE;
 
 static gboolean tcp_analyze_mptcp                   = TRUE;
@@ -1524,11 +1536,11 @@ init_tcp_conversation_data(packet_info *pinfo)
     tcpd=wmem_new0(wmem_file_scope(), struct tcp_analysis);
     tcpd->flow1.win_scale=-1;
     tcpd->flow1.window = G_MAXUINT32;
-    tcpd->flow1.multisegment_pdus=wmem_tree_new(wmem_file_scope());
+    tcpd->flow1.multisegment_pdus=wmem_flat_tree_new(wmem_file_scope());
 
     tcpd->flow2.window = G_MAXUINT32;
     tcpd->flow2.win_scale=-1;
-    tcpd->flow2.multisegment_pdus=wmem_tree_new(wmem_file_scope());
+    tcpd->flow2.multisegment_pdus=wmem_flat_tree_new(wmem_file_scope());
 
     /* Only allocate the data if its actually going to be analyzed */
     if (tcp_analyze_seq)
@@ -1559,6 +1571,8 @@ init_tcp_conversation_data(packet_info *pinfo)
     tcpd->flow1.closing_initiator = FALSE;
     tcpd->flow2.closing_initiator = FALSE;
     tcpd->stream = tcp_stream_count++;
+    tcpd->stream_frames = wmem_array_new(wmem_file_scope(), sizeof(guint32));
+    wmem_map_insert(tcp_stream_frames, GUINT_TO_POINTER(tcpd->stream), tcpd->stream_frames);
     tcpd->server_port = 0;
 
     return tcpd;
@@ -1687,6 +1701,52 @@ guint32 get_tcp_stream_count(void)
     return tcp_stream_count;
 }
 
+const tcp_graph_segments_t *tcp_get_graph_segments(guint32 stream)
+{
+    return (const tcp_graph_segments_t *)wmem_map_lookup(tcp_stream_graph_segments, GUINT_TO_POINTER(stream));
+}
+
+/* Remember the header of a segment, so that the graphs of its stream can be
+ * drawn without dissecting the capture again */
+static void
+tcp_add_graph_segment(packet_info *pinfo, const struct tcpheader *tcph)
+{
+    tcp_graph_segments_t *graph;
+    tcp_graph_segment_t seg;
+    guint i;
+
+    graph = (tcp_graph_segments_t *)wmem_map_lookup(tcp_stream_graph_segments, GUINT_TO_POINTER(tcph->th_stream));
+    if (!graph) {
+        graph = wmem_new(wmem_file_scope(), tcp_graph_segments_t);
+        copy_address_wmem(wmem_file_scope(), &graph->src_address, &tcph->ip_src);
+        copy_address_wmem(wmem_file_scope(), &graph->dst_address, &tcph->ip_dst);
+        graph->src_port = tcph->th_sport;
+        graph->dst_port = tcph->th_dport;
+        graph->segments = wmem_array_new(wmem_file_scope(), sizeof(tcp_graph_segment_t));
+        graph->sack_edges = wmem_array_new(wmem_file_scope(), sizeof(guint32));
+        wmem_map_insert(tcp_stream_graph_segments, GUINT_TO_POINTER(tcph->th_stream), graph);
+    }
+
+    seg.num = pinfo->num;
+    seg.rel_secs = (guint32)pinfo->rel_ts.secs;
+    seg.rel_usecs = pinfo->rel_ts.nsecs/1000;
+    seg.th_seq = tcph->th_seq;
+    seg.th_ack = tcph->th_ack;
+    seg.th_win = tcph->th_win;
+    seg.th_seglen = tcph->th_seglen;
+    seg.th_flags = tcph->th_flags;
+    seg.from_dst = !(tcph->th_sport == graph->src_port && tcph->th_dport == graph->dst_port &&
+                     addresses_equal(&tcph->ip_src, &graph->src_address) &&
+                     addresses_equal(&tcph->ip_dst, &graph->dst_address));
+    seg.num_sack_ranges = MIN(MAX_TCP_SACK_RANGES, tcph->num_sack_ranges);
+    seg.first_sack = wmem_array_get_count(graph->sack_edges) / 2;
+    for (i = 0; i < seg.num_sack_ranges; i++) {
+        wmem_array_append_one(graph->sack_edges, tcph->sack_left_edge[i]);
+        wmem_array_append_one(graph->sack_edges, tcph->sack_right_edge[i]);
+    }
+    wmem_array_append_one(graph->segments, seg);
+}
+
 /* Return the mptcp current stream count */
 guint32 get_mptcp_stream_count(void)
 {
@@ -1756,12 +1816,12 @@ print_pdu_tracking_data(packet_info *pinfo, tvbuff_t *tvb, proto_tree *tcp_tree,
    and let TCP try to find out what it can about this segment
 */
 static int
-scan_for_next_pdu(tvbuff_t *tvb, proto_tree *tcp_tree, packet_info *pinfo, int offset, guint32 seq, guint32 nxtseq, wmem_tree_t *multisegment_pdus)
+scan_for_next_pdu(tvbuff_t *tvb, proto_tree *tcp_tree, packet_info *pinfo, int offset, guint32 seq, guint32 nxtseq, wmem_flat_tree_t *multisegment_pdus)
 {
     struct tcp_multisegment_pdu *msp=NULL;
 
     if(!pinfo->fd->visited) {
-        msp=(struct tcp_multisegment_pdu *)wmem_tree_lookup32_le(multisegment_pdus, seq-1);
+        msp=(struct tcp_multisegment_pdu *)wmem_flat_tree_lookup32_le(multisegment_pdus, seq-1);
         if(msp) {
             /* If this is a continuation of a PDU started in a
              * previous segment we need to update the last_frame
@@ -1796,7 +1856,7 @@ scan_for_next_pdu(tvbuff_t *tvb, proto_tree *tcp_tree, packet_info *pinfo, int o
          * this segment we also verify that the found PDU does span
          * beyond the end of this segment.
          */
-        msp=(struct tcp_multisegment_pdu *)wmem_tree_lookup32_le(multisegment_pdus, nxtseq-1);
+        msp=(struct tcp_multisegment_pdu *)wmem_flat_tree_lookup32_le(multisegment_pdus, nxtseq-1);
         if(msp) {
             if(pinfo->num==msp->first_frame) {
                 proto_item *item;
@@ -1815,7 +1875,7 @@ scan_for_next_pdu(tvbuff_t *tvb, proto_tree *tcp_tree, packet_info *pinfo, int o
         /* Second we check if this segment is part of a PDU started
          * prior to the segment (seq-1)
          */
-        msp=(struct tcp_multisegment_pdu *)wmem_tree_lookup32_le(multisegment_pdus, seq-1);
+        msp=(struct tcp_multisegment_pdu *)wmem_flat_tree_lookup32_le(multisegment_pdus, seq-1);
         if(msp) {
             /* If this segment is completely within a previous PDU
              * then we just skip this packet
@@ -1839,7 +1899,7 @@ scan_for_next_pdu(tvbuff_t *tvb, proto_tree *tcp_tree, packet_info *pinfo, int o
    use this function to remember where the next pdu starts
 */
 struct tcp_multisegment_pdu *
-pdu_store_sequencenumber_of_next_pdu(packet_info *pinfo, guint32 seq, guint32 nxtpdu, wmem_tree_t *multisegment_pdus)
+pdu_store_sequencenumber_of_next_pdu(packet_info *pinfo, guint32 seq, guint32 nxtpdu, wmem_flat_tree_t *multisegment_pdus)
 {
     struct tcp_multisegment_pdu *msp;
 
@@ -1851,7 +1911,7 @@ pdu_store_sequencenumber_of_next_pdu(packet_info *pinfo, guint32 seq, guint32 nx
     msp->last_frame=pinfo->num;
     msp->last_frame_time=pinfo->abs_ts;
     msp->flags=0;
-    wmem_tree_insert32(multisegment_pdus, seq, (void *)msp);
+    wmem_flat_tree_insert32(multisegment_pdus, seq, (void *)msp);
     /*g_warning("pdu_store_sequencenumber_of_next_pdu: seq %u", seq);*/
     return msp;
 }
@@ -1944,12 +2004,36 @@ tcp_analyze_get_acked_struct(guint32 frame, guint32 seq, guint32 ack, gboolean c
 }
 
 
-/* fwd contains a list of all segments processed but not yet ACKed in the
+/* The segment at position i (0 being the oldest) of the ring of unacked
+ * segments of a flow */
+#define TCP_UNACKED_SEGMENT(info, i) \
+    (&(info)->segments[((info)->segment_first + (i)) & ((info)->segment_capacity - 1)])
+
+/* Add a segment after the newest one in the ring, growing it if it's full */
+static tcp_unacked_t *
+tcp_unacked_add(tcp_analyze_seq_flow_info_t *info)
+{
+    guint16 capacity;
+
+    if (info->segment_count == info->segment_capacity) {
+        capacity = info->segment_capacity ? (guint16)(info->segment_capacity * 2) : 8;
+        info->segments = (tcp_unacked_t *)wmem_realloc(wmem_file_scope(), info->segments,
+                capacity * sizeof(tcp_unacked_t));
+        /* move the segments that had wrapped around to after the old end */
+        memcpy(&info->segments[info->segment_capacity], info->segments,
+                info->segment_first * sizeof(tcp_unacked_t));
+        info->segment_capacity = capacity;
+    }
+    info->segment_count++;
+    return TCP_UNACKED_SEGMENT(info, info->segment_count - 1);
+}
+
+/* fwd contains a ring of all segments processed but not yet ACKed in the
  *     same direction as the current segment.
- * rev contains a list of all segments received but not yet ACKed in the
+ * rev contains a ring of all segments received but not yet ACKed in the
  *     opposite direction to the current segment.
  *
- * New segments are always added to the head of the fwd/rev lists.
+ * New segments are always added after the newest one of the fwd/rev rings.
  *
  * Changes below should be synced with ChAdvTCPAnalysis in the User's
  * Guide: docbook/wsug_src/WSUG_chapter_advanced.adoc
@@ -1957,19 +2041,24 @@ tcp_analyze_get_acked_struct(guint32 frame, guint32 seq, guint32 ack, gboolean c
 static void
 tcp_analyze_sequence_number(packet_info *pinfo, guint32 seq, guint32 ack, guint32 seglen, guint16 flags, guint32 window, struct tcp_analysis *tcpd)
 {
+    tcp_analyze_seq_flow_info_t *rev_info;
     tcp_unacked_t *ual=NULL;
-    tcp_unacked_t *prevual=NULL;
     guint32 nextseq;
-    int ackcount;
+    guint16 i, front, kept;
+    gboolean acked, keep;
 
 #if 0
     printf("\nanalyze_sequence numbers   frame:%u\n",pinfo->num);
     printf("FWD list lastflags:0x%04x base_seq:%u: nextseq:%u lastack:%u\n",tcpd->fwd->lastsegmentflags,tcpd->fwd->base_seq,tcpd->fwd->tcp_analyze_seq_info->nextseq,tcpd->rev->tcp_analyze_seq_info->lastack);
-    for(ual=tcpd->fwd->tcp_analyze_seq_info->segments; ual; ual=ual->next)
+    for(i=0; i<tcpd->fwd->tcp_analyze_seq_info->segment_count; i++) {
+            ual=TCP_UNACKED_SEGMENT(tcpd->fwd->tcp_analyze_seq_info, i);
             printf("Frame:%d Seq:%u Nextseq:%u\n",ual->frame,ual->seq,ual->nextseq);
+    }
     printf("REV list lastflags:0x%04x base_seq:%u nextseq:%u lastack:%u\n",tcpd->rev->lastsegmentflags,tcpd->rev->base_seq,tcpd->rev->tcp_analyze_seq_info->nextseq,tcpd->fwd->tcp_analyze_seq_info->lastack);
-    for(ual=tcpd->rev->tcp_analyze_seq_info->segments; ual; ual=ual->next)
+    for(i=0; i<tcpd->rev->tcp_analyze_seq_info->segment_count; i++) {
+            ual=TCP_UNACKED_SEGMENT(tcpd->rev->tcp_analyze_seq_info, i);
             printf("Frame:%d Seq:%u Nextseq:%u\n",ual->frame,ual->seq,ual->nextseq);
+    }
 #endif
 
     if (!tcpd) {
@@ -2325,22 +2414,22 @@ finished_checking_retransmission_type:
 
     nextseq = seq+seglen;
     if ((seglen || flags&(TH_SYN|TH_FIN)) && tcpd->fwd->tcp_analyze_seq_info->segment_count < TCP_MAX_UNACKED_SEGMENTS) {
-        /* Add this new sequence number to the fwd list.  But only if there
-         * aren't "too many" unacked segments (e.g., we're not seeing the ACKs).
-         */
-        ual = wmem_new(wmem_file_scope(), tcp_unacked_t);
-        ual->next=tcpd->fwd->tcp_analyze_seq_info->segments;
-        tcpd->fwd->tcp_analyze_seq_info->segments=ual;
-        tcpd->fwd->tcp_analyze_seq_info->segment_count++;
-        ual->frame=pinfo->num;
-        ual->seq=seq;
-        ual->ts=pinfo->abs_ts;
-
         /* next sequence number is seglen bytes away, plus SYN/FIN which counts as one byte */
         if( (flags&(TH_SYN|TH_FIN)) ) {
             nextseq+=1;
         }
-        ual->nextseq=nextseq;
+
+        /* Add this new sequence number to the fwd ring.  But only if there
+         * aren't "too many" unacked segments (e.g., we're not seeing the ACKs),
+         * and we want the ACK RTT and bytes in flight they are kept for.
+         */
+        if (!tcp_analyze_flags_only) {
+            ual = tcp_unacked_add(tcpd->fwd->tcp_analyze_seq_info);
+            ual->frame=pinfo->num;
+            ual->seq=seq;
+            ual->nextseq=nextseq;
+            ual->ts=pinfo->abs_ts;
+        }
     }
 
     /* Store the highest number seen so far for nextseq so we can detect
@@ -2388,72 +2477,82 @@ finished_checking_retransmission_type:
     }
 
 
-    /* remove all segments this ACKs and we don't need to keep around any more
+    /* remove all segments this ACKs and we don't need to keep around any more.
+     * The segments are acked oldest first, so those at the front of the ring
+     * are dropped by moving its start, and the later ones that are kept only
+     * have to be moved down over the holes left by any others.
      */
-    ackcount=0;
-    prevual = NULL;
-    ual = tcpd->rev->tcp_analyze_seq_info->segments;
-    while(ual) {
-        tcp_unacked_t *tmpual;
-
-        /* If this ack matches the segment, process accordingly */
+    rev_info = tcpd->rev->tcp_analyze_seq_info;
+    front = 0;
+    kept = 0;
+    acked = FALSE;
+    for (i = 0; i < rev_info->segment_count; i++) {
+        ual = TCP_UNACKED_SEGMENT(rev_info, i);
+
+        /* If this ack matches the segment, process accordingly; if it
+         * matches several (retransmissions), the RTT is that of the oldest */
         if(ack==ual->nextseq) {
-            tcp_analyze_get_acked_struct(pinfo->num, seq, ack, TRUE, tcpd);
-            tcpd->ta->frame_acked=ual->frame;
-            nstime_delta(&tcpd->ta->ts, &pinfo->abs_ts, &ual->ts);
+            if (!acked) {
+                tcp_analyze_get_acked_struct(pinfo->num, seq, ack, TRUE, tcpd);
+                tcpd->ta->frame_acked=ual->frame;
+                nstime_delta(&tcpd->ta->ts, &pinfo->abs_ts, &ual->ts);
+                acked = TRUE;
+            }
+            keep = FALSE;
         }
         /* If this acknowledges part of the segment, adjust the segment info for the acked part */
         else if (GT_SEQ(ack, ual->seq) && LE_SEQ(ack, ual->nextseq)) {
             ual->seq = ack;
-            continue;
+            keep = TRUE;
         }
         /* If this acknowledges a segment prior to this one, leave this segment alone and move on */
-        else if (GT_SEQ(ual->nextseq,ack)) {
-            prevual = ual;
-            ual = ual->next;
-            continue;
+        else {
+            keep = GT_SEQ(ual->nextseq,ack);
         }
 
-        /* This segment is old, or an exact match.  Delete the segment from the list */
-        ackcount++;
-        tmpual=ual->next;
+        if (keep) {
+            if (front + kept != i) {
+                *TCP_UNACKED_SEGMENT(rev_info, front + kept) = *ual;
+            }
+            kept++;
+            continue;
+        }
 
+        /* This segment is old, or an exact match.  Delete the segment from the ring */
         if (tcpd->rev->scps_capable) {
           /* Track largest segment successfully sent for SNACK analysis*/
           if ((ual->nextseq - ual->seq) > tcpd->fwd->maxsizeacked) {
             tcpd->fwd->maxsizeacked = (ual->nextseq - ual->seq);
           }
         }
-
-        if (!prevual) {
-            tcpd->rev->tcp_analyze_seq_info->segments = tmpual;
+        if (kept == 0) {
+            front++;
         }
-        else{
-            prevual->next = tmpual;
-        }
-        wmem_free(wmem_file_scope(), ual);
-        ual = tmpual;
-        tcpd->rev->tcp_analyze_seq_info->segment_count--;
     }
+    if (rev_info->segment_capacity) {
+        rev_info->segment_first = (rev_info->segment_first + front) & (rev_info->segment_capacity - 1);
+    }
+    rev_info->segment_count = kept;
 
     /* how many bytes of data are there in flight after this frame
      * was sent
      */
-    ual=tcpd->fwd->tcp_analyze_seq_info->segments;
-    if (tcp_track_bytes_in_flight && seglen!=0 && ual && tcpd->fwd->valid_bif) {
+    if (tcp_track_bytes_in_flight && seglen!=0 && tcpd->fwd->tcp_analyze_seq_info->segment_count && tcpd->fwd->valid_bif) {
+        tcp_analyze_seq_flow_info_t *fwd_info = tcpd->fwd->tcp_analyze_seq_info;
         guint32 first_seq, last_seq, in_flight;
         guint32 delivered = 0;
 
+        ual = TCP_UNACKED_SEGMENT(fwd_info, 0);
         first_seq = ual->seq - tcpd->fwd->base_seq;
         last_seq = ual->nextseq - tcpd->fwd->base_seq;
-        while (ual) {
+        for (i = 1; i < fwd_info->segment_count; i++) {
+            ual = TCP_UNACKED_SEGMENT(fwd_info, i);
             if ((ual->nextseq-tcpd->fwd->base_seq)>last_seq) {
                 last_seq = ual->nextseq-tcpd->fwd->base_seq;
             }
             if ((ual->seq-tcpd->fwd->base_seq)<first_seq) {
                 first_seq = ual->seq-tcpd->fwd->base_seq;
             }
-            ual = ual->next;
         }
         in_flight = last_seq-first_seq;
 
@@ -3196,6 +3295,10 @@ static gboolean tcp_desegment = TRUE;
  * subdissector (depends on "tcp_desegment"). */
 static gboolean tcp_reassemble_out_of_order = FALSE;
 
+/* Build reassembled PDUs as composites over the segments instead of copying
+ * them into one buffer. */
+static gboolean tcp_composite_reassembly = FALSE;
+
 /* Returns true iff any gap exists in the segments associated with msp up to the
  * given sequence number (it ignores any gaps after the sequence number). */
 static gboolean
@@ -3209,8 +3312,11 @@ missing_segments(packet_info *pinfo, struct tcp_multisegment_pdu *msp, guint32 s
     }
 
     fd_head = fragment_get(&tcp_reassembly_table, pinfo, msp->first_frame, NULL);
-    /* msp implies existence of fragments, this should never be NULL. */
-    DISSECTOR_ASSERT(fd_head);
+    /* msp implies existence of fragments, but they may have been dropped
+     * to keep within the reassembly memory limits. */
+    if (!fd_head) {
+        return FALSE;
+    }
 
     /* Find length of contiguous fragments. */
     guint32 max = 0;
@@ -3295,7 +3401,7 @@ again:
          * Only shortcircuit here when the first segment of the MSP is known,
          * and when this this first segment is not one to complete the MSP.
          */
-        if ((msp = (struct tcp_multisegment_pdu *)wmem_tree_lookup32(tcpd->fwd->multisegment_pdus, seq)) &&
+        if ((msp = (struct tcp_multisegment_pdu *)wmem_flat_tree_lookup32(tcpd->fwd->multisegment_pdus, seq)) &&
                 nxtseq <= msp->nxtpdu &&
                 !(msp->flags & MSP_FLAGS_MISSING_FIRST_SEGMENT) && msp->last_frame != pinfo->num) {
             const char* str;
@@ -3375,7 +3481,7 @@ again:
         }
         /* Else, find the most previous PDU starting before this sequence number */
         if (!msp) {
-            msp = (struct tcp_multisegment_pdu *)wmem_tree_lookup32_le(tcpd->fwd->multisegment_pdus, seq-1);
+            msp = (struct tcp_multisegment_pdu *)wmem_flat_tree_lookup32_le(tcpd->fwd->multisegment_pdus, seq-1);
         }
     }
 
@@ -6537,6 +6643,15 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
         item = proto_tree_add_uint(tcp_tree, hf_tcp_stream, tvb, offset, 0, tcpd->stream);
         proto_item_set_generated(item);
 
+        /* Remember the frames of the stream, for following it */
+        if (!PINFO_FD_VISITED(pinfo)) {
+            guint count = wmem_array_get_count(tcpd->stream_frames);
+
+            if (count == 0 || *(guint32 *)wmem_array_index(tcpd->stream_frames, count - 1) != pinfo->num) {
+                wmem_array_append_one(tcpd->stream_frames, pinfo->num);
+            }
+        }
+
         /* Display the completeness of this TCP conversation */
         item = proto_tree_add_uint(tcp_tree, hf_tcp_completeness, NULL, 0, 0, tcpd->conversation_completeness);
         proto_item_set_generated(item);
@@ -6912,7 +7027,7 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
            packet, are willing to allow subdissectors to request reassembly
            on it. */
 
-        if (tcp_check_checksum) {
+        if (tcp_check_checksum && !frame_checksum_offloaded(pinfo)) {
             /* We haven't turned checksum checking off; checksum it. */
 
             /* Set up the fields of the pseudo-header. */
@@ -7137,6 +7252,10 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
         }
     }
 
+    if (tcp_record_graph_segments && !PINFO_FD_VISITED(pinfo)) {
+        tcp_add_graph_segment(pinfo, tcph);
+    }
+
     tap_queue_packet(tcp_tap, pinfo, tcph);
 
     /* if it is an MPTCP packet */
@@ -7163,7 +7282,7 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
              * for this flow, terminate reassembly and dissect the
              * results. */
             tcpd->fwd->fin = pinfo->num;
-            msp=(struct tcp_multisegment_pdu *)wmem_tree_lookup32_le(tcpd->fwd->multisegment_pdus, tcph->th_seq-1);
+            msp=(struct tcp_multisegment_pdu *)wmem_flat_tree_lookup32_le(tcpd->fwd->multisegment_pdus, tcph->th_seq-1);
             if(msp) {
                 fragment_head *ipfd_head;
 
@@ -7269,6 +7388,10 @@ static void
 tcp_init(void)
 {
     tcp_stream_count = 0;
+    tcp_stream_frames = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
+    tcp_stream_graph_segments = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
+
+    tcp_reassembly_table.composite_data = tcp_composite_reassembly;
 
     /* MPTCP init */
     mptcp_stream_count = 0;
@@ -8271,6 +8394,7 @@ proto_register_tcp(void)
         "Show TCP summary in protocol tree",
         "Whether the TCP summary line should be shown in the protocol tree",
         &tcp_summary_in_tree);
+    prefs_set_preference_effect_display(tcp_module, "summary_in_tree");
     prefs_register_bool_preference(tcp_module, "check_checksum",
         "Validate the TCP checksum if possible",
         "Whether to validate the TCP checksum or not.  "
@@ -8285,6 +8409,18 @@ proto_register_tcp(void)
         "Whether out-of-order segments should be buffered and reordered before passing it to a subdissector. "
         "To use this option you must also enable \"Allow subdissector to reassemble TCP streams\".",
         &tcp_reassemble_out_of_order);
+    prefs_register_bool_preference(tcp_module, "composite_reassembly",
+        "Reassemble without copying segment data",
+        "Whether reassembled PDUs should refer to the data of their segments rather than hold a copy of it. "
+        "This saves memory and time with large PDUs, but a PDU may still be copied when a subdissector needs "
+        "it in one piece.",
+        &tcp_composite_reassembly);
+    prefs_register_bool_preference(tcp_module, "record_graph_segments",
+        "Record segments for the stream graphs",
+        "Whether the headers of the segments of each stream should be kept when the capture is first read, "
+        "so that its stream graphs can be drawn without dissecting every packet again. "
+        "This takes about 40 bytes per segment.",
+        &tcp_record_graph_segments);
     prefs_register_bool_preference(tcp_module, "analyze_sequence_numbers",
         "Analyze TCP sequence numbers",
         "Make the TCP dissector analyze TCP sequence numbers to find and flag segment retransmissions, missing segments and RTT",
@@ -8309,6 +8445,12 @@ proto_register_tcp(void)
         "To use this option you must also enable \"Analyze TCP sequence numbers\". "
         "This takes a lot of memory but allows you to track how much data are in flight at a time and graphing it in io-graphs",
         &tcp_track_bytes_in_flight);
+    prefs_register_bool_preference(tcp_module, "analyze_flags_only",
+        "Only flag problems in the sequence analysis",
+        "Make the analysis of TCP sequence numbers only flag retransmissions, lost segments and the like, "
+        "without keeping the unacknowledged segments of each flow for the ACK RTT and the number of bytes "
+        "in flight. This saves memory and time with captures of many connections.",
+        &tcp_analyze_flags_only);
     prefs_register_bool_preference(tcp_module, "calculate_timestamps",
         "Calculate conversation timestamps",
         "Calculate timestamps relative to the first frame and the previous frame in the tcp conversation",
@@ -8390,6 +8532,7 @@ proto_register_tcp(void)
     register_conversation_table(proto_mptcp, FALSE, mptcpip_conversation_packet, tcpip_hostlist_packet);
     register_follow_stream(proto_tcp, "tcp_follow", tcp_follow_conv_filter, tcp_follow_index_filter, tcp_follow_address_filter,
                             tcp_port_to_display, follow_tcp_tap_listener);
+    register_follow_stream_frames(proto_tcp, tcp_follow_stream_frames);
 }
 
 void
@@ -144,10 +144,9 @@ tcp_dissect_pdus(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
 		 dissector_t dissect_pdu, void* dissector_data);
 
 extern struct tcp_multisegment_pdu *
-pdu_store_sequencenumber_of_next_pdu(packet_info *pinfo, guint32 seq, guint32 nxtpdu, wmem_tree_t *multisegment_pdus);
+pdu_store_sequencenumber_of_next_pdu(packet_info *pinfo, guint32 seq, guint32 nxtpdu, wmem_flat_tree_t *multisegment_pdus);
 
 typedef struct _tcp_unacked_t {
-	struct _tcp_unacked_t *next;
 	guint32 frame;
 	guint32	seq;
 	guint32	nextseq;
@@ -294,8 +293,12 @@ typedef enum {
  * is enabled, so save the memory when it isn't
  */
 typedef struct tcp_analyze_seq_flow_info_t {
-	tcp_unacked_t *segments;/* List of segments for which we haven't seen an ACK */
+	tcp_unacked_t *segments;/* Ring of the segments for which we haven't seen an ACK,
+				 * oldest first; it grows as needed and its capacity
+				 * is always a power of 2 */
+	guint16 segment_first;	/* Where the oldest of them is in the ring */
 	guint16 segment_count;	/* How many unacked segments we're currently storing */
+	guint16 segment_capacity;
     guint32 lastack;	/* Last seen ack for the reverse flow */
 	nstime_t lastacktime;	/* Time of the last ack packet */
 	guint32 lastnondupack;	/* frame number of last seen non dupack */
@@ -366,7 +369,7 @@ typedef struct _tcp_flow_t {
 	/* This tree is indexed by sequence number and keeps track of all
 	 * all pdus spanning multiple segments for this flow.
 	 */
-	wmem_tree_t *multisegment_pdus;
+	wmem_flat_tree_t *multisegment_pdus;
 
 	/* Process info, currently discovered via IPFIX */
 	tcp_process_info_t* process_info;
@@ -458,6 +461,9 @@ struct tcp_analysis {
 	 */
 	guint32         stream;
 
+	/* The frames in which the stream appears, in ascending order */
+	wmem_array_t   *stream_frames;
+
 	/* Remembers the server port on the SYN (or SYN|ACK) packet to
 	 * help determine which dissector to call
 	 */
@@ -532,6 +538,38 @@ extern void add_tcp_process_info(guint32 frame_num, address *local_addr, address
  */
 WS_DLL_PUBLIC guint32 get_tcp_stream_count(void);
 
+/* The header of a segment of a stream, as the stream graphs draw it */
+typedef struct _tcp_graph_segment {
+	guint32	num;		/* frame number */
+	guint32	rel_secs;	/* time relative to the first frame */
+	guint32	rel_usecs;
+	guint32	th_seq;
+	guint32	th_ack;
+	guint32	th_win;
+	guint32	th_seglen;
+	guint16	th_flags;
+	guint8	from_dst;	/* sent by the destination of the first segment */
+	guint8	num_sack_ranges;
+	guint32	first_sack;	/* index of its first range in sack_edges */
+} tcp_graph_segment_t;
+
+typedef struct _tcp_graph_segments {
+	/* The endpoints, as seen in the first segment */
+	address	src_address;
+	address	dst_address;
+	guint16	src_port;
+	guint16	dst_port;
+	wmem_array_t *segments;		/* tcp_graph_segment_t, in frame order */
+	wmem_array_t *sack_edges;	/* guint32 left and right edges */
+} tcp_graph_segments_t;
+
+/** Get the segments of a TCP stream recorded on the first pass
+ *
+ * @param stream The TCP stream number
+ * @return The segments, or NULL if they weren't recorded
+ */
+WS_DLL_PUBLIC const tcp_graph_segments_t *tcp_get_graph_segments(guint32 stream);
+
 /** Get the current number of MPTCP streams
  *
  * @return The number of MPTCP streams
@@ -542,6 +580,7 @@ WS_DLL_PUBLIC guint32 get_mptcp_stream_count(void);
 extern gchar *tcp_follow_conv_filter(epan_dissect_t *edt, packet_info *pinfo, guint *stream, guint *sub_stream);
 extern gchar *tcp_follow_index_filter(guint stream, guint sub_stream);
 extern gchar *tcp_follow_address_filter(address *src_addr, address *dst_addr, int src_port, int dst_port);
+extern wmem_array_t *tcp_follow_stream_frames(guint stream, guint sub_stream);
 
 #ifdef __cplusplus
 }
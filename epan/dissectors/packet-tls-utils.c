@@ -3601,7 +3601,7 @@ ssl_create_flow(void)
   flow = wmem_new(wmem_file_scope(), SslFlow);
   flow->byte_seq = 0;
   flow->flags = 0;
-  flow->multisegment_pdus = wmem_tree_new(wmem_file_scope());
+  flow->multisegment_pdus = wmem_flat_tree_new(wmem_file_scope());
   return flow;
 }
 /* }}} */
@@ -4687,7 +4687,9 @@ tls_decrypt_aead_record(SslDecryptSession *ssl, SslDecoder *decoder,
             ssl_debug_printf("%s seq %" G_GUINT64_FORMAT "\n", G_STRFUNC, seq);
         }
 
-            /* Set nonce and additional authentication data */
+            /* Set nonce and additional authentication data. The cipher handle
+             * was opened and keyed once for this decoder by ssl_create_decoder();
+             * only the nonce and AAD change from one record to the next. */
 #ifdef HAVE_LIBGCRYPT_AEAD
         gcry_cipher_reset(decoder->evp);
         ssl_print_data("nonce", nonce, 12);
@@ -5903,78 +5905,105 @@ tls13_key_update(SslDecryptSession *ssl, gboolean is_from_server)
 
 /** SSL keylog file handling. {{{ */
 
-static GRegex *
-ssl_compile_keyfile_regex(void)
-{
-#define OCTET "(?:[[:xdigit:]]{2})"
-    const gchar *pattern =
-        "(?:"
-        /* Matches Client Hellos having this Client Random */
-        "PMS_CLIENT_RANDOM (?<client_random_pms>" OCTET "{32}) "
-        /* Matches first part of encrypted RSA pre-master secret */
-        "|RSA (?<encrypted_pmk>" OCTET "{8}) "
-        /* Pre-Master-Secret is given, it is 48 bytes for RSA,
-           but it can be of any length for DHE */
-        ")(?<pms>" OCTET "+)"
-        "|(?:"
-        /* Matches Server Hellos having a Session ID */
-        "RSA Session-ID:(?<session_id>" OCTET "+) Master-Key:"
-        /* Matches Client Hellos having this Client Random */
-        "|CLIENT_RANDOM (?<client_random>" OCTET "{32}) "
-        /* Master-Secret is given, its length is fixed */
-        ")(?<master_secret>" OCTET "{" G_STRINGIFY(SSL_MASTER_SECRET_LENGTH) "})"
-        "|(?"
-        /* TLS 1.3 Client Random to Derived Secrets mapping. */
-        ":CLIENT_EARLY_TRAFFIC_SECRET (?<client_early>" OCTET "{32})"
-        "|CLIENT_HANDSHAKE_TRAFFIC_SECRET (?<client_handshake>" OCTET "{32})"
-        "|SERVER_HANDSHAKE_TRAFFIC_SECRET (?<server_handshake>" OCTET "{32})"
-        "|CLIENT_TRAFFIC_SECRET_0 (?<client_appdata>" OCTET "{32})"
-        "|SERVER_TRAFFIC_SECRET_0 (?<server_appdata>" OCTET "{32})"
-        "|EARLY_EXPORTER_SECRET (?<early_exporter>" OCTET "{32})"
-        "|EXPORTER_SECRET (?<exporter>" OCTET "{32})"
-        ") (?<derived_secret>" OCTET "+)";
-#undef OCTET
-    static GRegex *regex = NULL;
-    GError *gerr = NULL;
-
-    if (!regex) {
-        regex = g_regex_new(pattern,
-                (GRegexCompileFlags)(G_REGEX_OPTIMIZE | G_REGEX_ANCHORED | G_REGEX_RAW),
-                G_REGEX_MATCH_ANCHORED, &gerr);
-        if (gerr) {
-            ssl_debug_printf("%s failed to compile regex: %s\n", G_STRFUNC,
-                             gerr->message);
-            g_error_free(gerr);
-            regex = NULL;
-        }
-    }
-
-    return regex;
-}
-
-typedef struct ssl_master_key_match_group {
-    const char *re_group_name;
-    GHashTable *master_key_ht;
-} ssl_master_key_match_group_t;
+/* The formats of the lines of a keylog file, in the order they're tried.
+ * Each is a prefix, a hex-encoded key, a separator and a hex-encoded
+ * secret, which may be followed by anything; a length of 0 means any
+ * number of bytes, at least one. */
+typedef struct {
+    const char *prefix;
+    guint       key_len;
+    const char *separator;
+    guint       secret_len;
+    const char *name;           /* for the debug log */
+    size_t      map_offset;     /* of the table in ssl_master_key_map_t */
+} tls_keylog_format_t;
+
+static const tls_keylog_format_t tls_keylog_formats[] = {
+    { "PMS_CLIENT_RANDOM ",               32, " ", 0, "client_random_pms", offsetof(ssl_master_key_map_t, pms) },
+    { "RSA ",                             8,  " ", 0, "encrypted_pmk",     offsetof(ssl_master_key_map_t, pre_master) },
+    { "RSA Session-ID:",                  0,  " Master-Key:", SSL_MASTER_SECRET_LENGTH,
+                                                      "session_id",        offsetof(ssl_master_key_map_t, session) },
+    { "CLIENT_RANDOM ",                   32, " ", SSL_MASTER_SECRET_LENGTH,
+                                                      "client_random",     offsetof(ssl_master_key_map_t, crandom) },
+    /* TLS 1.3 Client Random to Derived Secrets mapping. */
+    { "CLIENT_EARLY_TRAFFIC_SECRET ",     32, " ", 0, "client_early",      offsetof(ssl_master_key_map_t, tls13_client_early) },
+    { "CLIENT_HANDSHAKE_TRAFFIC_SECRET ", 32, " ", 0, "client_handshake",  offsetof(ssl_master_key_map_t, tls13_client_handshake) },
+    { "SERVER_HANDSHAKE_TRAFFIC_SECRET ", 32, " ", 0, "server_handshake",  offsetof(ssl_master_key_map_t, tls13_server_handshake) },
+    { "CLIENT_TRAFFIC_SECRET_0 ",         32, " ", 0, "client_appdata",    offsetof(ssl_master_key_map_t, tls13_client_appdata) },
+    { "SERVER_TRAFFIC_SECRET_0 ",         32, " ", 0, "server_appdata",    offsetof(ssl_master_key_map_t, tls13_server_appdata) },
+    { "EARLY_EXPORTER_SECRET ",           32, " ", 0, "early_exporter",    offsetof(ssl_master_key_map_t, tls13_early_exporter) },
+    { "EXPORTER_SECRET ",                 32, " ", 0, "exporter",          offsetof(ssl_master_key_map_t, tls13_exporter) },
+};
+
+/* The length of the run of hex digits at the start of s, which is len
+ * bytes long */
+static gsize
+tls_keylog_hex_len(const char *s, gsize len)
+{
+    gsize i;
+
+    for (i = 0; i < len && g_ascii_isxdigit(s[i]); i++)
+        ;
+    return i;
+}
+
+/* Decodes len bytes from the hex digits at in, which have been checked */
+static void
+tls_keylog_from_hex(guchar *out, const char *in, guint len)
+{
+    guint i;
+
+    for (i = 0; i < len; i++)
+        out[i] = ws_xton(in[2 * i]) << 4 | ws_xton(in[2 * i + 1]);
+}
+
+/* If line is in the format, returns TRUE and where the hex-encoded key
+ * and secret are; the secret may be followed by anything. */
+static gboolean
+tls_keylog_match(const tls_keylog_format_t *format, const char *line, gsize linelen,
+                 const char **key, gsize *key_hex_len,
+                 const char **secret, gsize *secret_hex_len)
+{
+    gsize prefix_len = strlen(format->prefix);
+    gsize sep_len = strlen(format->separator);
+    gsize pos, hex_len;
+
+    if (linelen < prefix_len || memcmp(line, format->prefix, prefix_len) != 0)
+        return FALSE;
+    pos = prefix_len;
+
+    /* The key is followed by the separator, so it's all of the run of
+     * hex digits, and that has to be whole bytes. */
+    hex_len = tls_keylog_hex_len(line + pos, linelen - pos);
+    if (hex_len == 0 || (hex_len & 1) ||
+        (format->key_len && hex_len != 2 * format->key_len))
+        return FALSE;
+    *key = line + pos;
+    *key_hex_len = hex_len;
+    pos += hex_len;
+
+    if (linelen - pos < sep_len || memcmp(line + pos, format->separator, sep_len) != 0)
+        return FALSE;
+    pos += sep_len;
+
+    /* The secret is as many whole bytes as there are, or as many as the
+     * format has. */
+    hex_len = tls_keylog_hex_len(line + pos, linelen - pos) & ~(gsize)1;
+    if (format->secret_len) {
+        if (hex_len < 2 * format->secret_len)
+            return FALSE;
+        hex_len = 2 * format->secret_len;
+    } else if (hex_len == 0) {
+        return FALSE;
+    }
+    *secret = line + pos;
+    *secret_hex_len = hex_len;
+    return TRUE;
+}
 
 void
 tls_keylog_process_lines(const ssl_master_key_map_t *mk_map, const guint8 *data, guint datalen)
 {
-    ssl_master_key_match_group_t mk_groups[] = {
-        { "encrypted_pmk",  mk_map->pre_master },
-        { "session_id",     mk_map->session },
-        { "client_random",  mk_map->crandom },
-        { "client_random_pms",  mk_map->pms },
-        /* TLS 1.3 map from Client Random to derived secret. */
-        { "client_early",       mk_map->tls13_client_early },
-        { "client_handshake",   mk_map->tls13_client_handshake },
-        { "server_handshake",   mk_map->tls13_server_handshake },
-        { "client_appdata",     mk_map->tls13_client_appdata },
-        { "server_appdata",     mk_map->tls13_server_appdata },
-        { "early_exporter",     mk_map->tls13_early_exporter },
-        { "exporter",           mk_map->tls13_exporter },
-    };
-
     /* The format of the file is a series of records with one of the following formats:
      *   - "RSA xxxx yyyy"
      *     Where xxxx are the first 8 bytes of the encrypted pre-master secret (hex-encoded)
@@ -6013,80 +6042,64 @@ tls_keylog_process_lines(const ssl_master_key_map_t *mk_map, const guint8 *data,
      *     handshake or master secrets. (This format is introduced with TLS 1.3
      *     and supported by BoringSSL, OpenSSL, etc. See bug 12779.)
      */
-    GRegex *regex = ssl_compile_keyfile_regex();
-    if (!regex)
-        return;
-
     const char *next_line = (const char *)data;
     const char *line_end = next_line + datalen;
     while (next_line && next_line < line_end) {
         const char *line = next_line;
         next_line = (const char *)memchr(line, '\n', line_end - line);
-        gssize linelen;
+        gsize linelen;
 
         if (next_line) {
             linelen = next_line - line;
             next_line++;    /* drop LF */
         } else {
-            linelen = (gssize)(line_end - line);
+            linelen = line_end - line;
         }
         if (linelen > 0 && line[linelen - 1] == '\r') {
             linelen--;      /* drop CR */
         }
 
         ssl_debug_printf("  checking keylog line: %.*s\n", (int)linelen, line);
-        GMatchInfo *mi;
-        if (g_regex_match_full(regex, line, linelen, 0, G_REGEX_MATCH_ANCHORED, &mi, NULL)) {
-            gchar *hex_key, *hex_pre_ms_or_ms;
-            StringInfo *key = wmem_new(wmem_file_scope(), StringInfo);
-            StringInfo *pre_ms_or_ms = NULL;
-            GHashTable *ht = NULL;
-
-            /* Is the PMS being supplied with the PMS_CLIENT_RANDOM
-             * otherwise we will use the Master Secret
-             */
-            hex_pre_ms_or_ms = g_match_info_fetch_named(mi, "master_secret");
-            if (hex_pre_ms_or_ms == NULL || !*hex_pre_ms_or_ms) {
-                g_free(hex_pre_ms_or_ms);
-                hex_pre_ms_or_ms = g_match_info_fetch_named(mi, "pms");
-            }
-            if (hex_pre_ms_or_ms == NULL || !*hex_pre_ms_or_ms) {
-                g_free(hex_pre_ms_or_ms);
-                hex_pre_ms_or_ms = g_match_info_fetch_named(mi, "derived_secret");
-            }
-            /* There is always a match, otherwise the regex is wrong. */
-            DISSECTOR_ASSERT(hex_pre_ms_or_ms && strlen(hex_pre_ms_or_ms));
+        const char *hex_key = NULL, *hex_secret = NULL;
+        gsize hex_key_len = 0, hex_secret_len = 0;
+        unsigned i;
 
+        for (i = 0; i < G_N_ELEMENTS(tls_keylog_formats); i++) {
+            if (tls_keylog_match(&tls_keylog_formats[i], line, linelen,
+                                 &hex_key, &hex_key_len, &hex_secret, &hex_secret_len))
+                break;
+        }
+        if (i < G_N_ELEMENTS(tls_keylog_formats)) {
+            const tls_keylog_format_t *format = &tls_keylog_formats[i];
+            GHashTable *ht = *(GHashTable * const *)((const char *)mk_map + format->map_offset);
+            StringInfo key, pre_ms_or_ms;
+            const StringInfo *known;
+
+            ssl_debug_printf("    matched %s\n", format->name);
             /* convert from hex to bytes and save to hashtable */
-            pre_ms_or_ms = wmem_new(wmem_file_scope(), StringInfo);
-            from_hex(pre_ms_or_ms, hex_pre_ms_or_ms, strlen(hex_pre_ms_or_ms));
-            g_free(hex_pre_ms_or_ms);
-
-            /* Find a master key from any format (CLIENT_RANDOM, SID, ...) */
-            for (unsigned i = 0; i < G_N_ELEMENTS(mk_groups); i++) {
-                ssl_master_key_match_group_t *g = &mk_groups[i];
-                hex_key = g_match_info_fetch_named(mi, g->re_group_name);
-                if (hex_key && *hex_key) {
-                    ssl_debug_printf("    matched %s\n", g->re_group_name);
-                    ht = g->master_key_ht;
-                    from_hex(key, hex_key, strlen(hex_key));
-                    g_free(hex_key);
-                    break;
-                }
-                g_free(hex_key);
+            ssl_data_alloc(&key, hex_key_len / 2);
+            ssl_data_alloc(&pre_ms_or_ms, hex_secret_len / 2);
+            tls_keylog_from_hex(key.data, hex_key, key.data_len);
+            tls_keylog_from_hex(pre_ms_or_ms.data, hex_secret, pre_ms_or_ms.data_len);
+
+            /* A line read again, like a last line without a newline,
+             * or repeated doesn't take more memory. */
+            known = (const StringInfo *)g_hash_table_lookup(ht, &key);
+            if (!known || !ssl_equal(known, &pre_ms_or_ms)) {
+                g_hash_table_insert(ht, ssl_data_clone(&key), ssl_data_clone(&pre_ms_or_ms));
             }
-            DISSECTOR_ASSERT(ht); /* Cannot be reached, or regex is wrong. */
-
-            g_hash_table_insert(ht, key, pre_ms_or_ms);
+            g_free(key.data);
+            g_free(pre_ms_or_ms.data);
 
         } else if (linelen > 0 && line[0] != '#') {
             ssl_debug_printf("    unrecognized line\n");
         }
-        /* always free match info even if there is no match. */
-        g_match_info_free(mi);
     }
 }
 
+/* Read this much of the keylog file at a time */
+#define TLS_KEYLOG_READ_SIZE    (64 * 1024)
+
 void
 ssl_load_keyfile(const gchar *tls_keylog_filename, FILE **keylog_file,
                  const ssl_master_key_map_t *mk_map)
@@ -6098,11 +6111,6 @@ ssl_load_keyfile(const gchar *tls_keylog_filename, FILE **keylog_file,
         return;
     }
 
-    /* Validate regexes before even trying to use it. */
-    if (!ssl_compile_keyfile_regex()) {
-        return;
-    }
-
     ssl_debug_printf("trying to use TLS keylog in %s\n", tls_keylog_filename);
 
     /* if the keylog file was deleted/overwritten, re-open it */
@@ -6113,29 +6121,54 @@ ssl_load_keyfile(const gchar *tls_keylog_filename, FILE **keylog_file,
     }
 
     if (*keylog_file == NULL) {
-        *keylog_file = ws_fopen(tls_keylog_filename, "r");
+        /* Binary, so that the offsets are those of the bytes read; the
+         * CR of a CRLF is dropped with the line. */
+        *keylog_file = ws_fopen(tls_keylog_filename, "rb");
         if (!*keylog_file) {
             ssl_debug_printf("%s failed to open SSL keylog\n", G_STRFUNC);
             return;
         }
     }
 
+    /* Process the file a block of whole lines at a time, keeping the end
+     * of a line that's cut off for the next block. A last line without a
+     * newline is processed, but it's read again next time, so that if
+     * it's only partly written yet, the whole line replaces it then. */
+    gsize bufsize = TLS_KEYLOG_READ_SIZE, used = 0, n, done;
+    char *buf = (char *)g_malloc(bufsize);
+
     for (;;) {
-        char buf[1110], *line;
-        line = fgets(buf, sizeof(buf), *keylog_file);
-        if (!line) {
-            if (feof(*keylog_file)) {
-                /* Ensure that newly appended keys can be read in the future. */
-                clearerr(*keylog_file);
-            } else if (ferror(*keylog_file)) {
+        if (used == bufsize) {
+            bufsize *= 2;
+            buf = (char *)g_realloc(buf, bufsize);
+        }
+        n = fread(buf + used, 1, bufsize - used, *keylog_file);
+        if (n == 0) {
+            if (used > 0)
+                tls_keylog_process_lines(mk_map, (guint8 *)buf, (guint)used);
+            if (ferror(*keylog_file)) {
                 ssl_debug_printf("%s Error while reading key log file, closing it!\n", G_STRFUNC);
                 fclose(*keylog_file);
                 *keylog_file = NULL;
+            } else {
+                /* Ensure that newly appended keys can be read in the future. */
+                clearerr(*keylog_file);
+                if (used > 0)
+                    fseek(*keylog_file, -(long)used, SEEK_CUR);
             }
             break;
         }
-        tls_keylog_process_lines(mk_map, (guint8 *)line, (int)strlen(line));
+        used += n;
+
+        for (done = used; done > 0 && buf[done - 1] != '\n'; done--)
+            ;
+        if (done > 0) {
+            tls_keylog_process_lines(mk_map, (guint8 *)buf, (guint)done);
+            memmove(buf, buf + done, used - done);
+            used -= done;
+        }
     }
+    g_free(buf);
 }
 /** SSL keylog file handling. }}} */
 
@@ -314,7 +314,7 @@ typedef struct _SslCipherSuite {
 typedef struct _SslFlow {
     guint32 byte_seq;
     guint16 flags;
-    wmem_tree_t *multisegment_pdus;
+    wmem_flat_tree_t *multisegment_pdus;
 } SslFlow;
 
 typedef struct _SslDecompress SslDecompress;
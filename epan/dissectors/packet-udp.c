@@ -33,6 +33,7 @@
 #include <wsutil/str_util.h>
 
 #include "packet-udp.h"
+#include "packet-frame.h"
 
 #include <epan/conversation.h>
 #include <epan/conversation_table.h>
@@ -585,7 +586,7 @@ handle_export_pdu_conversation(packet_info *pinfo, tvbuff_t *tvb, int uh_dport,
     conversation_t *conversation = find_conversation(pinfo->num, &pinfo->dst, &pinfo->src, ENDPOINT_UDP, uh_dport, uh_sport, 0);
     if (conversation != NULL)
     {
-      dissector_handle_t handle = (dissector_handle_t)wmem_tree_lookup32_le(conversation->dissector_tree, pinfo->num);
+      dissector_handle_t handle = (dissector_handle_t)wmem_flat_tree_lookup32_le(conversation->dissector_tree, pinfo->num);
       if (handle != NULL)
       {
         exp_pdu_data_t *exp_pdu_data = export_pdu_create_common_tags(pinfo, dissector_handle_get_dissector_name(handle), EXP_PDU_TAG_PROTO_NAME);
@@ -1116,8 +1117,9 @@ dissect(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, guint32 ip_proto)
        XXX - make a bigger scatter-gather list once we do fragment
        reassembly? */
 
-    if (((ip_proto == IP_PROTO_UDP) && udp_check_checksum) ||
-        ((ip_proto == IP_PROTO_UDPLITE) && udplite_check_checksum)) {
+    if ((((ip_proto == IP_PROTO_UDP) && udp_check_checksum) ||
+         ((ip_proto == IP_PROTO_UDPLITE) && udplite_check_checksum)) &&
+        !frame_checksum_offloaded(pinfo)) {
       /* Set up the fields of the pseudo-header. */
       SET_CKSUM_VEC_PTR(cksum_vec[0], (const guint8 *)pinfo->src.data, pinfo->src.len);
       SET_CKSUM_VEC_PTR(cksum_vec[1], (const guint8 *)pinfo->dst.data, pinfo->dst.len);
@@ -1377,6 +1379,7 @@ proto_register_udp(void)
                                  "Show UDP summary in protocol tree",
                                  "Whether the UDP summary line should be shown in the protocol tree",
                                  &udp_summary_in_tree);
+  prefs_set_preference_effect_display(udp_module, "summary_in_tree");
   prefs_register_bool_preference(udp_module, "try_heuristic_first",
                                  "Try heuristic sub-dissectors first",
                                  "Try to decode a packet using an heuristic sub-dissector"
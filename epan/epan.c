@@ -57,10 +57,12 @@
 #include "stats_tree.h"
 #include "secrets.h"
 #include "funnel.h"
+#include "tvbuff-int.h"
 #include <dtd.h>
 
 #ifdef HAVE_PLUGINS
 #include <wsutil/plugins.h>
+#include "plugin_manifest.h"
 #endif
 
 #ifdef HAVE_LUA
@@ -96,6 +98,9 @@ static GSList *epan_plugin_register_all_handoffs = NULL;
 
 static wmem_allocator_t *pinfo_pool_cache = NULL;
 
+/* The allocator of pinfo->pool; see epan_init() */
+static wmem_allocator_type_t pinfo_pool_type = WMEM_ALLOCATOR_BLOCK_FAST;
+
 /* Global variables holding the content of the corresponding environment variable
  * to save fetching it repeatedly.
  */
@@ -179,6 +184,7 @@ epan_plugin_cleanup(gpointer data, gpointer user_data _U_)
 #ifdef HAVE_PLUGINS
 void epan_register_plugin(const epan_plugin *plug)
 {
+	plugin_manifest_keep_loaded();
 	epan_plugins = g_slist_prepend(epan_plugins, (epan_plugin *)plug);
 	if (plug->register_all_protocols)
 		epan_plugin_register_all_procotols = g_slist_prepend(epan_plugin_register_all_procotols, plug->register_all_protocols);
@@ -229,6 +235,15 @@ epan_init(register_cb cb, gpointer client_data, gboolean load_plugins)
 		wireshark_abort_on_too_many_items = FALSE;
 	}
 
+	/* The per-packet pool is emptied after every packet and never
+	 * has anything freed in it otherwise, so by default it uses the
+	 * bump allocator, which keeps its blocks across packets;
+	 * WIRESHARK_PACKET_POOL=block selects the general block allocator,
+	 * to compare them. */
+	pinfo_pool_type = WMEM_ALLOCATOR_BLOCK_FAST;
+	if (g_strcmp0(getenv("WIRESHARK_PACKET_POOL"), "block") == 0)
+		pinfo_pool_type = WMEM_ALLOCATOR_BLOCK;
+
 	/*
 	 * proto_init -> register_all_protocols -> g_async_queue_new which
 	 * requires threads to be initialized. This happens automatically with
@@ -249,7 +264,11 @@ epan_init(register_cb cb, gpointer client_data, gboolean load_plugins)
 
 	if (load_plugins) {
 #ifdef HAVE_PLUGINS
-		libwireshark_plugins = plugins_init(WS_PLUGIN_EPAN);
+		/* Dissector plugins whose registrations are known from an
+		 * earlier run are loaded when they're first needed. */
+		plugin_manifest_init();
+		libwireshark_plugins = plugins_init_deferred(WS_PLUGIN_EPAN, plugin_manifest_defer, NULL);
+		plugin_manifest_end();
 #endif
 	}
 
@@ -284,6 +303,9 @@ epan_init(register_cb cb, gpointer client_data, gboolean load_plugins)
 		reassembly_tables_init();
 		g_slist_foreach(epan_plugins, epan_plugin_init, NULL);
 		proto_init(epan_plugin_register_all_procotols, epan_plugin_register_all_handoffs, cb, client_data);
+#ifdef HAVE_PLUGINS
+		plugin_manifest_register_deferred(libwireshark_plugins);
+#endif
 		g_slist_foreach(epan_plugins, epan_plugin_register_all_tap_listeners, NULL);
 		packet_cache_proto_handles();
 		dfilter_init();
@@ -400,6 +422,7 @@ epan_cleanup(void)
 	addr_resolv_cleanup();
 
 #ifdef HAVE_PLUGINS
+	plugin_manifest_cleanup();
 	plugins_cleanup(libwireshark_plugins);
 	libwireshark_plugins = NULL;
 #endif
@@ -415,6 +438,7 @@ epan_cleanup(void)
 struct epan_session {
 	struct packet_provider_data *prov;	/* packet provider data for this session */
 	struct packet_provider_funcs funcs;	/* functions using that data */
+	gboolean threaded_scopes;		/* wmem scopes usable from several threads */
 };
 
 epan_t *
@@ -441,6 +465,15 @@ epan_get_user_comment(const epan_t *session, const frame_data *fd)
 	return NULL;
 }
 
+const nstime_t *
+epan_get_shift_offset(const epan_t *session, const frame_data *fd)
+{
+	if (fd->has_shift_offset && session->funcs.get_shift_offset)
+		return session->funcs.get_shift_offset(session->prov, fd);
+
+	return NULL;
+}
+
 const char *
 epan_get_interface_name(const epan_t *session, guint32 interface_id)
 {
@@ -473,12 +506,25 @@ epan_get_frame_ts(const epan_t *session, guint32 frame_num)
 	return abs_ts;
 }
 
+void
+epan_set_threaded_scopes(epan_t *session, gboolean threaded)
+{
+	if (session->threaded_scopes == threaded)
+		return;
+
+	wmem_set_threaded_scopes(threaded);
+	session->threaded_scopes = threaded;
+}
+
 void
 epan_free(epan_t *session)
 {
 	if (session) {
 		/* XXX, it should take session as param */
 		cleanup_dissection();
+		tvb_uncompress_cache_clear();
+
+		epan_set_threaded_scopes(session, FALSE);
 
 		g_slice_free(epan_t, session);
 	}
@@ -513,12 +559,12 @@ epan_dissect_init(epan_dissect_t *edt, epan_t *session, const gboolean create_pr
 	edt->session = session;
 
 	memset(&edt->pi, 0, sizeof(edt->pi));
-	if (pinfo_pool_cache != NULL) {
-		edt->pi.pool = pinfo_pool_cache;
-		pinfo_pool_cache = NULL;
-	}
-	else {
-		edt->pi.pool = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK_FAST);
+	/* The cached pool is taken and put back atomically, as
+	 * epan_set_threaded_scopes() lets several threads dissect at once. */
+	edt->pi.pool = (wmem_allocator_t *)g_atomic_pointer_get(&pinfo_pool_cache);
+	if (edt->pi.pool == NULL ||
+	    !g_atomic_pointer_compare_and_exchange(&pinfo_pool_cache, edt->pi.pool, NULL)) {
+		edt->pi.pool = wmem_allocator_new(pinfo_pool_type);
 	}
 
 	if (create_proto_tree) {
@@ -542,7 +588,7 @@ epan_dissect_reset(epan_dissect_t *edt)
 
 	g_assert(edt);
 
-	g_slist_free(edt->pi.proto_data);
+	g_free(edt->pi.proto_data);
 	g_slist_free(edt->pi.dependent_frames);
 
 	/* Free the data sources list. */
@@ -645,7 +691,7 @@ epan_dissect_cleanup(epan_dissect_t* edt)
 
 	g_slist_foreach(epan_plugins, epan_plugin_dissect_cleanup, edt);
 
-	g_slist_free(edt->pi.proto_data);
+	g_free(edt->pi.proto_data);
 	g_slist_free(edt->pi.dependent_frames);
 
 	/* Free the data sources list. */
@@ -660,9 +706,12 @@ epan_dissect_cleanup(epan_dissect_t* edt)
 		proto_tree_free(edt->tree);
 	}
 
-	if (pinfo_pool_cache == NULL) {
+	if (g_atomic_pointer_get(&pinfo_pool_cache) == NULL) {
 		wmem_free_all(edt->pi.pool);
-		pinfo_pool_cache = edt->pi.pool;
+		if (!g_atomic_pointer_compare_and_exchange(&pinfo_pool_cache, NULL, edt->pi.pool)) {
+			/* another thread got there first */
+			wmem_destroy_allocator(edt->pi.pool);
+		}
 	}
 	else {
 		wmem_destroy_allocator(edt->pi.pool);
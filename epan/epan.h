@@ -51,6 +51,7 @@ struct packet_provider_funcs {
 	const char *(*get_interface_name)(struct packet_provider_data *prov, guint32 interface_id);
 	const char *(*get_interface_description)(struct packet_provider_data *prov, guint32 interface_id);
 	const char *(*get_user_comment)(struct packet_provider_data *prov, const frame_data *fd);
+	const nstime_t *(*get_shift_offset)(struct packet_provider_data *prov, const frame_data *fd);
 };
 
 /**
@@ -156,12 +157,30 @@ WS_DLL_PUBLIC epan_t *epan_new(struct packet_provider_data *prov,
 
 WS_DLL_PUBLIC const char *epan_get_user_comment(const epan_t *session, const frame_data *fd);
 
+/**
+ * Get how much a frame's time stamp has been shifted, or NULL if it
+ * hasn't been.
+ */
+WS_DLL_PUBLIC const nstime_t *epan_get_shift_offset(const epan_t *session, const frame_data *fd);
+
 WS_DLL_PUBLIC const char *epan_get_interface_name(const epan_t *session, guint32 interface_id);
 
 WS_DLL_PUBLIC const char *epan_get_interface_description(const epan_t *session, guint32 interface_id);
 
 const nstime_t *epan_get_frame_ts(const epan_t *session, guint32 frame_num);
 
+/**
+ * Set whether the wmem file and epan scopes may be used from several
+ * threads at once while this session is open; see wmem_set_threaded_scopes().
+ * Worker threads then call wmem_thread_init_scopes() to get a packet scope
+ * of their own. This only makes the memory scopes ready for it: most
+ * dissectors keep state in globals and are not thread-safe yet.
+ *
+ * It must be called while no packet is being dissected, and is turned off
+ * again by epan_free().
+ */
+WS_DLL_PUBLIC void epan_set_threaded_scopes(epan_t *session, gboolean threaded);
+
 WS_DLL_PUBLIC void epan_free(epan_t *session);
 
 WS_DLL_PUBLIC const gchar*
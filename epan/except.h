@@ -64,11 +64,27 @@ struct except_cleanup {
     void *except_context;
 };
 
+/*
+ * setjmp() also saves the signal mask on some platforms (the BSDs and
+ * macOS), which takes a system call for every TRY, most of which never
+ * see an exception.  Nothing here changes the signal mask between a TRY
+ * and a throw, so use sigsetjmp() without saving it where it exists.
+ */
+#ifdef _WIN32
+typedef jmp_buf except_jmp_buf;
+#define except_setjmp(env)          setjmp(env)
+#define except_longjmp(env, val)    longjmp(env, val)
+#else
+typedef sigjmp_buf except_jmp_buf;
+#define except_setjmp(env)          sigsetjmp(env, 0)
+#define except_longjmp(env, val)    siglongjmp(env, val)
+#endif
+
 struct except_catch {
     const except_id_t *except_id;
     size_t except_size;
     except_t except_obj;
-    jmp_buf except_jmp;
+    except_jmp_buf except_jmp;
 };
 
 enum except_stacktype {
@@ -174,7 +190,7 @@ WS_DLL_PUBLIC void except_free(void *);
         struct except_stacknode except_sn;                      \
         struct except_catch except_ch;                          \
         except_setup_try(&except_sn, &except_ch, ID, NUM);      \
-        if (setjmp(except_ch.except_jmp))                       \
+        if (except_setjmp(except_ch.except_jmp))                \
             *(PPE) = &except_ch.except_obj;                     \
         else                                                    \
             *(PPE) = 0
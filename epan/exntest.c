@@ -9,6 +9,8 @@
 #include <config.h>
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <glib.h>
 #include "exceptions.h"
 
@@ -206,10 +208,67 @@ run_tests(void)
         printf("success\n");
 }
 
-int main(void)
+#define BENCH_DEPTH 8
+
+/* A dissector calling a subdissector, BENCH_DEPTH deep, each in a TRY */
+static void
+bench_nested(int depth, gboolean throw_at_bottom)
+{
+    TRY {
+        if (depth > 1)
+            bench_nested(depth - 1, throw_at_bottom);
+        else if (throw_at_bottom)
+            THROW(ReportedBoundsError);
+    }
+    CATCH(BoundsError) {
+        failed = TRUE;
+    }
+    ENDTRY;
+}
+
+static void
+run_benchmark(unsigned int iterations)
+{
+    unsigned int i;
+    gint64 start, no_throw, with_throw;
+
+    start = g_get_monotonic_time();
+    for (i = 0; i < iterations; i++) {
+        bench_nested(BENCH_DEPTH, FALSE);
+    }
+    no_throw = g_get_monotonic_time() - start;
+
+    start = g_get_monotonic_time();
+    for (i = 0; i < iterations; i++) {
+        TRY {
+            bench_nested(BENCH_DEPTH, TRUE);
+        }
+        CATCH(ReportedBoundsError) {
+        }
+        ENDTRY;
+    }
+    with_throw = g_get_monotonic_time() - start;
+
+    printf("%u iterations of %d nested TRYs\n", iterations, BENCH_DEPTH);
+    printf("no exception:      %8.1f ns per TRY\n",
+           no_throw * 1000.0 / ((double)iterations * BENCH_DEPTH));
+    printf("caught at the top: %8.1f ns per iteration\n",
+           with_throw * 1000.0 / iterations);
+}
+
+/*
+ * Run with "-b [iterations]" to measure the cost of TRY, rather than
+ * check that exceptions work.
+ */
+int main(int argc, char **argv)
 {
     except_init();
-    run_tests();
+    if (argc > 1 && strcmp(argv[1], "-b") == 0) {
+        unsigned int iterations = argc > 2 ? (unsigned int)strtoul(argv[2], NULL, 10) : 1000000;
+        run_benchmark(iterations > 0 ? iterations : 1);
+    } else {
+        run_tests();
+    }
     except_deinit();
     exit(failed?1:0);
 }
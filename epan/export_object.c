@@ -16,11 +16,14 @@
 #include "packet_info.h"
 #include "export_object.h"
 
+#include <wsutil/file_util.h>
+
 struct register_eo {
     int proto_id;                        /* protocol id (0-indexed) */
     const char* tap_listen_str;          /* string used in register_tap_listener (NULL to use protocol name) */
     tap_packet_cb eo_func;               /* function to be called for new incoming packets for SRT */
     export_object_gui_reset_cb reset_cb; /* function to parse parameters of optional arguments of tap string */
+    gboolean updates_entries;            /* entries are changed after they're added */
 };
 
 static wmem_tree_t *registered_eo_tables = NULL;
@@ -37,6 +40,7 @@ register_export_object(const int proto_id, tap_packet_cb export_packet_func, exp
     table->tap_listen_str = wmem_strdup_printf(wmem_epan_scope(), "%s_eo", proto_get_protocol_filter_name(proto_id));
     table->eo_func = export_packet_func;
     table->reset_cb = reset_cb;
+    table->updates_entries = FALSE;
 
     if (registered_eo_tables == NULL)
         registered_eo_tables = wmem_tree_new(wmem_epan_scope());
@@ -45,6 +49,20 @@ register_export_object(const int proto_id, tap_packet_cb export_packet_func, exp
     return register_tap(table->tap_listen_str);
 }
 
+void
+export_object_set_updates_entries(const int proto_id)
+{
+    register_eo_t *eo = get_eo_by_name(proto_get_protocol_filter_name(proto_id));
+
+    DISSECTOR_ASSERT(eo);
+    eo->updates_entries = TRUE;
+}
+
+gboolean get_eo_updates_entries(register_eo_t* eo)
+{
+    return eo->updates_entries;
+}
+
 int get_eo_proto_id(register_eo_t* eo)
 {
     if (!eo) {
@@ -152,6 +170,10 @@ void eo_free_entry(export_object_entry_t *entry)
     g_free(entry->content_type);
     g_free(entry->filename);
     g_free(entry->payload_data);
+    if (entry->spool_filename) {
+        ws_unlink(entry->spool_filename);
+        g_free(entry->spool_filename);
+    }
 
     g_free(entry);
 }
@@ -33,6 +33,10 @@ typedef struct _export_object_entry_t {
       we could support objects that don't fit into the address space. */
     gint64 payload_len;
     guint8 *payload_data;
+    /* If not NULL, the payload has been written to this temporary
+       file, which is removed by eo_free_entry(), and payload_data is
+       NULL. */
+    gchar *spool_filename;
 } export_object_entry_t;
 
 /** Maximum file name size for the file to which we save an object.
@@ -70,6 +74,21 @@ typedef void (*export_object_gui_reset_cb)(void);
  */
 WS_DLL_PUBLIC int register_export_object(const int proto_id, tap_packet_cb export_packet_func, export_object_gui_reset_cb reset_cb);
 
+/** Note that the export object handler of a protocol keeps adding to the
+ * entries it has passed to add_entry, getting them back with get_entry, so
+ * that they're only complete once all the packets have been tapped.
+ *
+ * @param proto_id is the protocol with objects to export
+ */
+WS_DLL_PUBLIC void export_object_set_updates_entries(const int proto_id);
+
+/** Does the export object handler change entries after adding them?
+ *
+ * @param eo Registered Export Object
+ * @return TRUE if entries are only complete once all the packets have been tapped
+ */
+WS_DLL_PUBLIC gboolean get_eo_updates_entries(register_eo_t* eo);
+
 /** Get protocol ID from Export Object
  *
  * @param eo Registered Export Object
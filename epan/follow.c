@@ -28,6 +28,7 @@ struct register_follow {
     follow_address_filter_func address_filter; /* generate address filter to follow */
     follow_port_to_display_func port_to_display; /* port to name resolution for follow type */
     tap_packet_cb tap_handler; /* tap listener handler */
+    follow_stream_frames_func stream_frames; /* frames of a stream, or NULL */
 };
 
 static wmem_tree_t *registered_followers = NULL;
@@ -53,6 +54,7 @@ void register_follow_stream(const int proto_id, const char* tap_listener,
   follower->address_filter = address_filter;
   follower->port_to_display = port_to_display;
   follower->tap_handler    = tap_handler;
+  follower->stream_frames  = NULL;
 
   if (registered_followers == NULL)
     registered_followers = wmem_tree_new(wmem_epan_scope());
@@ -60,6 +62,16 @@ void register_follow_stream(const int proto_id, const char* tap_listener,
   wmem_tree_insert_string(registered_followers, proto_get_protocol_short_name(find_protocol_by_id(proto_id)), follower, 0);
 }
 
+void register_follow_stream_frames(const int proto_id, follow_stream_frames_func stream_frames)
+{
+  register_follow_t *follower;
+
+  follower = get_follow_by_name(proto_get_protocol_short_name(find_protocol_by_id(proto_id)));
+  DISSECTOR_ASSERT(follower);
+
+  follower->stream_frames = stream_frames;
+}
+
 int get_follow_proto_id(register_follow_t* follower)
 {
   if (follower == NULL)
@@ -96,6 +108,11 @@ follow_port_to_display_func get_follow_port_to_display(register_follow_t* follow
   return follower->port_to_display;
 }
 
+follow_stream_frames_func get_follow_stream_frames_func(register_follow_t* follower)
+{
+  return follower->stream_frames;
+}
+
 tap_packet_cb get_follow_tap_handler(register_follow_t* follower)
 {
   return follower->tap_handler;
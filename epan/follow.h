@@ -106,12 +106,23 @@ typedef gchar* (*follow_conv_filter_func)(epan_dissect_t *edt, packet_info *pinf
 typedef gchar* (*follow_index_filter_func)(guint stream, guint sub_stream);
 typedef gchar* (*follow_address_filter_func)(address* src_addr, address* dst_addr, int src_port, int dst_port);
 typedef gchar* (*follow_port_to_display_func)(wmem_allocator_t *allocator, guint port);
+typedef wmem_array_t* (*follow_stream_frames_func)(guint stream, guint sub_stream);
 
 WS_DLL_PUBLIC
 void register_follow_stream(const int proto_id, const char* tap_listener,
                             follow_conv_filter_func conv_filter, follow_index_filter_func index_filter, follow_address_filter_func address_filter,
                             follow_port_to_display_func port_to_display, tap_packet_cb tap_handler);
 
+/** Register a function that gets the frames in which a stream appears,
+ * for a follower registered with register_follow_stream().
+ * @param proto_id protocol id of the follower
+ * @param stream_frames function returning the numbers (guint32), in
+ * ascending order, of all the frames that the follower's index filter for
+ * a stream and sub-stream can match, or NULL if they aren't known
+ */
+WS_DLL_PUBLIC
+void register_follow_stream_frames(const int proto_id, follow_stream_frames_func stream_frames);
+
 /** Get protocol ID from registered follower
  *
  * @param follower Registered follower
@@ -161,6 +172,12 @@ WS_DLL_PUBLIC follow_address_filter_func get_follow_address_func(register_follow
  */
 WS_DLL_PUBLIC follow_port_to_display_func get_follow_port_to_display(register_follow_t* follower);
 
+/** Provide function that gets the frames in which a stream appears.
+ * @param follower [in] Registered follower
+ * @return A frames function handler, or NULL if the follower has none
+ */
+WS_DLL_PUBLIC follow_stream_frames_func get_follow_stream_frames_func(register_follow_t* follower);
+
 /** Provide function that handles tap data (tap_packet_cb parameter of register_tap_listener)
  *
  * @param follower [in] Registered follower
@@ -211,8 +211,7 @@ frame_data_init(frame_data *fdata, guint32 num, const wtap_rec *rec,
   fdata->has_user_comment = 0;
   fdata->need_colorize = 0;
   fdata->color_filter = NULL;
-  fdata->shift_offset.secs = 0;
-  fdata->shift_offset.nsecs = 0;
+  fdata->has_shift_offset = 0;
   fdata->frame_ref_num = 0;
   fdata->prev_dis_num = 0;
 }
@@ -273,19 +272,15 @@ frame_data_reset(frame_data *fdata)
   fdata->visited = 0;
   fdata->subnum = 0;
 
-  if (fdata->pfd) {
-    g_slist_free(fdata->pfd);
-    fdata->pfd = NULL;
-  }
+  g_free(fdata->pfd);
+  fdata->pfd = NULL;
 }
 
 void
 frame_data_destroy(frame_data *fdata)
 {
-  if (fdata->pfd) {
-    g_slist_free(fdata->pfd);
-    fdata->pfd = NULL;
-  }
+  g_free(fdata->pfd);
+  fdata->pfd = NULL;
 }
 
 /*
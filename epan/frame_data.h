@@ -60,6 +60,11 @@ typedef enum {
    fields within the first 16 or 32 bytes, so they all fit in a cache
    line? */
 struct _color_filter; /* Forward */
+
+/* The proto data of a frame or of a packet, in a single g_malloc()ed block;
+   see proto_data.c */
+typedef struct _proto_data_list proto_data_list_t;
+
 DIAG_OFF_PEDANTIC
 typedef struct _frame_data {
   guint32      num;          /**< Frame number */
@@ -70,7 +75,7 @@ typedef struct _frame_data {
   /* These two are pointers, meaning 64-bit on LP64 (64-bit UN*X) and
      LLP64 (64-bit Windows) platforms.  Put them here, one after the
      other, so they don't require padding between them. */
-  GSList      *pfd;          /**< Per frame proto data */
+  proto_data_list_t *pfd;    /**< Per frame proto data */
   const struct _color_filter *color_filter;  /**< Per-packet matching color_filter_t object */
   guint16      subnum;       /**< subframe number, for protocols that require this */
   /* Keep the bitfields below to 16 bits, so this plus the previous field
@@ -87,10 +92,10 @@ typedef struct _frame_data {
   unsigned int has_phdr_comment : 1; /** 1 = there's comment for this packet */
   unsigned int has_user_comment : 1; /** 1 = user set (also deleted) comment for this packet */
   unsigned int need_colorize    : 1; /**< 1 = need to (re-)calculate packet color */
+  unsigned int has_shift_offset : 1; /**< 1 = abs_ts has been shifted; see epan_get_shift_offset() */
   unsigned int tsprec           : 4; /**< Time stamp precision -2^tsprec gives up to femtoseconds */
-  nstime_t     abs_ts;       /**< Absolute timestamp */
-  nstime_t     shift_offset; /**< How much the abs_tm of the frame is shifted */
   guint32      frame_ref_num; /**< Previous reference frame (0 if this is one) */
+  nstime_t     abs_ts;       /**< Absolute timestamp */
   guint32      prev_dis_num; /**< Previous displayed frame (0 if first one) */
 } frame_data;
 DIAG_ON_PEDANTIC
@@ -384,11 +384,11 @@ cmp_contains(const fvalue_t *fv_a, const fvalue_t *fv_b)
 }
 
 static gboolean
-cmp_matches(const fvalue_t *fv, const GRegex *regex)
+cmp_matches(const fvalue_t *fv, const fvalue_regex_t *regex)
 {
 	const protocol_value_t *a = (const protocol_value_t *)&fv->value.protocol;
 	volatile gboolean rc = FALSE;
-	const char *data = NULL; /* tvb data */
+	const guint8 *data = NULL; /* tvb data */
 	guint32 tvb_len; /* tvb length */
 
 	if (! regex) {
@@ -397,27 +397,12 @@ cmp_matches(const fvalue_t *fv, const GRegex *regex)
 	TRY {
 		if (a->tvb != NULL) {
 			tvb_len = tvb_captured_length(a->tvb);
-			data = (const char *)tvb_get_ptr(a->tvb, 0, tvb_len);
-			rc = g_regex_match_full(
-				regex,		/* Compiled PCRE */
-				data,		/* The data to check for the pattern... */
-				tvb_len,	/* ... and its length */
-				0,		/* Start offset within data */
-				(GRegexMatchFlags)0,		/* GRegexMatchFlags */
-				NULL,		/* We are not interested in the match information */
-				NULL		/* We don't want error information */
-				);
+			data = tvb_get_ptr(a->tvb, 0, tvb_len);
+			rc = fvalue_regex_matches(regex, data, tvb_len);
 			/* NOTE - DO NOT g_free(data) */
 		} else {
-			rc = g_regex_match_full(
-			regex,		/* Compiled PCRE */
-			a->proto_string,		/* The data to check for the pattern... */
-			(int)strlen(a->proto_string),	/* ... and its length */
-			0,		/* Start offset within data */
-			(GRegexMatchFlags)0,		/* GRegexMatchFlags */
-			NULL,		/* We are not interested in the match information */
-			NULL		/* We don't want error information */
-			);
+			rc = fvalue_regex_matches(regex,
+			    (const guint8 *)a->proto_string, strlen(a->proto_string));
 		}
 	}
 	CATCH_ALL {
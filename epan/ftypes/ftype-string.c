@@ -16,16 +16,22 @@
 
 #include <strutil.h>
 
+/* The string was set with fvalue_set_string_pooled(), and isn't ours */
+#define string_is_pooled	fvalue_gboolean1
+
 static void
 string_fvalue_new(fvalue_t *fv)
 {
 	fv->value.string = NULL;
+	fv->string_is_pooled = FALSE;
 }
 
 static void
 string_fvalue_free(fvalue_t *fv)
 {
-	g_free(fv->value.string);
+	if (!fv->string_is_pooled)
+		g_free(fv->value.string);
+	fv->string_is_pooled = FALSE;
 }
 
 static void
@@ -39,6 +45,18 @@ string_fvalue_set_string(fvalue_t *fv, const gchar *value)
 	fv->value.string = (gchar *)g_strdup(value);
 }
 
+void
+fvalue_set_string_pooled(fvalue_t *fv, const gchar *value)
+{
+	g_assert(fv->ftype->free_value == string_fvalue_free);
+	DISSECTOR_ASSERT(value != NULL);
+
+	string_fvalue_free(fv);
+
+	fv->value.string = (gchar *)value;
+	fv->string_is_pooled = TRUE;
+}
+
 static int
 string_repr_len(fvalue_t *fv, ftrepr_t rtype, int field_display _U_)
 {
@@ -186,22 +204,14 @@ cmp_contains(const fvalue_t *fv_a, const fvalue_t *fv_b)
 }
 
 static gboolean
-cmp_matches(const fvalue_t *fv, const GRegex *regex)
+cmp_matches(const fvalue_t *fv, const fvalue_regex_t *regex)
 {
 	char *str = fv->value.string;
 
 	if (! regex) {
 		return FALSE;
 	}
-	return g_regex_match_full(
-			regex,		/* Compiled PCRE */
-			str,		/* The data to check for the pattern... */
-			(int)strlen(str),	/* ... and its length */
-			0,		/* Start offset within data */
-			(GRegexMatchFlags)0,		/* GRegexMatchFlags */
-			NULL,		/* We are not interested in the match information */
-			NULL		/* We don't want error information */
-			);
+	return fvalue_regex_matches(regex, (const guint8 *)str, strlen(str));
 }
 
 void
@@ -0,0 +1,244 @@
+/*
+ * Sets of strings for the "contains any" operator
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 2001 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/exceptions.h>
+#include <wsutil/ws_mempbrk.h>
+
+#include "ftypes-int.h"
+
+/*
+ * All the needles are looked for in a single pass over the subject:
+ * ws_mempbrk_exec(), which is vectorized, finds the next byte that some
+ * needle begins with, a table of the first two bytes of the needles throws
+ * away most of the false starts, and only the needles that begin with
+ * that byte are compared there.
+ */
+struct _fvalue_needles_t {
+	GPtrArray	*fvalues;	/* the needles */
+	/* The bytes of the needles, ordered by their first byte; those
+	 * that begin with byte c are [start[c], start[c + 1]) */
+	const guint8	**data;
+	gsize		*len;
+	guint		start[257];
+	gsize		min_len;
+	/* TRUE for the bytes that are needles by themselves */
+	gboolean	whole[256];
+	/* Bit b of pairs[a][b / 8] is set if a needle begins with a, b */
+	guint8		pairs[256][32];
+	ws_mempbrk_pattern first_bytes;
+};
+
+/*
+ * The bytes contains compares, for the types whose values are searched
+ * for as bytes; FALSE for the other types, and for protocols without
+ * data.
+ */
+static gboolean
+fvalue_search_bytes(const fvalue_t *fv, const guint8 **data, gsize *len)
+{
+	volatile gboolean ok = FALSE;
+
+	switch (fv->ftype->ftype) {
+		case FT_STRING:
+		case FT_STRINGZ:
+		case FT_UINT_STRING:
+		case FT_STRINGZPAD:
+		case FT_STRINGZTRUNC:
+			*data = (const guint8 *)fv->value.string;
+			*len = strlen(fv->value.string);
+			return TRUE;
+
+		case FT_BYTES:
+		case FT_UINT_BYTES:
+		case FT_AX25:
+		case FT_VINES:
+		case FT_ETHER:
+		case FT_OID:
+		case FT_REL_OID:
+		case FT_SYSTEM_ID:
+		case FT_FCWWN:
+			*data = fv->value.bytes->data;
+			*len = fv->value.bytes->len;
+			return TRUE;
+
+		case FT_PROTOCOL:
+			if (fv->value.protocol.tvb == NULL)
+				return FALSE;
+			TRY {
+				*len = tvb_captured_length(fv->value.protocol.tvb);
+				*data = tvb_get_ptr(fv->value.protocol.tvb, 0, (gint)*len);
+				ok = TRUE;
+			}
+			CATCH_ALL {
+				/* nothing */
+			}
+			ENDTRY;
+			return ok;
+
+		default:
+			return FALSE;
+	}
+}
+
+gboolean
+fvalue_needles_can_hold(const fvalue_t *fv)
+{
+	const guint8	*data;
+	gsize		len;
+
+	/* ws_mempbrk_compile() takes the first bytes as a string, so a
+	 * needle can't begin with NUL; and what an empty needle means
+	 * depends on the type. */
+	return fvalue_search_bytes(fv, &data, &len) && len > 0 && data[0] != '\0';
+}
+
+fvalue_needles_t *
+fvalue_needles_new(GPtrArray *fvalues)
+{
+	fvalue_needles_t	*needles;
+	const guint8		*data;
+	gsize			len;
+	guint			next[256];
+	gchar			first_bytes[257];
+	guint			i, n, c;
+
+	g_assert(fvalues->len > 0);
+
+	needles = g_new0(fvalue_needles_t, 1);
+	needles->fvalues = fvalues;
+	needles->data = g_new(const guint8 *, fvalues->len);
+	needles->len = g_new(gsize, fvalues->len);
+	needles->min_len = G_MAXSIZE;
+
+	/* Count the needles that begin with each byte... */
+	for (i = 0; i < fvalues->len; i++) {
+		if (!fvalue_search_bytes((const fvalue_t *)g_ptr_array_index(fvalues, i), &data, &len))
+			g_assert_not_reached();
+		needles->start[data[0] + 1]++;
+	}
+	n = 0;
+	for (c = 0; c < 256; c++) {
+		needles->start[c + 1] += needles->start[c];
+		next[c] = needles->start[c];
+		if (needles->start[c + 1] != needles->start[c])
+			first_bytes[n++] = (gchar)c;
+	}
+	first_bytes[n] = '\0';
+	ws_mempbrk_compile(&needles->first_bytes, first_bytes);
+
+	/* ...and put them in order. */
+	for (i = 0; i < fvalues->len; i++) {
+		fvalue_search_bytes((const fvalue_t *)g_ptr_array_index(fvalues, i), &data, &len);
+		g_assert(len > 0 && data[0] != '\0');
+		needles->data[next[data[0]]] = data;
+		needles->len[next[data[0]]] = len;
+		next[data[0]]++;
+		if (len < needles->min_len)
+			needles->min_len = len;
+		if (len == 1)
+			needles->whole[data[0]] = TRUE;
+		else
+			needles->pairs[data[0]][data[1] >> 3] |= 1 << (data[1] & 7);
+	}
+	return needles;
+}
+
+static gboolean
+needles_search(const fvalue_needles_t *needles, const guint8 *subj, gsize subj_len)
+{
+	const guint8	*p, *last, *end;
+	guint		c, i;
+
+	if (subj_len < needles->min_len)
+		return FALSE;
+
+	/* No needle fits in the subject after last. */
+	p = subj;
+	end = subj + subj_len;
+	last = end - needles->min_len;
+	while (p <= last) {
+		p = ws_mempbrk_exec(p, last - p + 1, &needles->first_bytes, NULL);
+		if (p == NULL)
+			return FALSE;
+		c = *p;
+		if (needles->whole[c])
+			return TRUE;
+		if (p + 1 < end && (needles->pairs[c][p[1] >> 3] & (1 << (p[1] & 7)))) {
+			for (i = needles->start[c]; i < needles->start[c + 1]; i++) {
+				if (needles->len[i] <= (gsize)(end - p) &&
+				    memcmp(p, needles->data[i], needles->len[i]) == 0)
+					return TRUE;
+			}
+		}
+		p++;
+	}
+	return FALSE;
+}
+
+gboolean
+fvalue_contains_any(const fvalue_t *fv, const fvalue_needles_t *needles)
+{
+	const guint8	*subj;
+	gsize		subj_len;
+	guint		i;
+
+	if (fvalue_search_bytes(fv, &subj, &subj_len))
+		return needles_search(needles, subj, subj_len);
+
+	/* A protocol without data, or a value of another type (from another
+	 * field with the same name): compare it with each needle. */
+	if (fv->ftype->cmp_contains == NULL)
+		return FALSE;
+	for (i = 0; i < needles->fvalues->len; i++) {
+		if (fvalue_contains(fv, (const fvalue_t *)g_ptr_array_index(needles->fvalues, i)))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+guint
+fvalue_needles_count(const fvalue_needles_t *needles)
+{
+	return needles->fvalues->len;
+}
+
+void
+fvalue_needles_free(fvalue_needles_t *needles)
+{
+	guint	i;
+
+	for (i = 0; i < needles->fvalues->len; i++) {
+		fvalue_t *fv = (fvalue_t *)g_ptr_array_index(needles->fvalues, i);
+		FVALUE_FREE(fv);
+	}
+	g_ptr_array_free(needles->fvalues, TRUE);
+	g_free(needles->data);
+	g_free(needles->len);
+	g_free(needles);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -0,0 +1,562 @@
+/*
+ * Regular expressions for the "matches" operator
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 2001 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#ifdef HAVE_PCRE2
+#define PCRE2_CODE_UNIT_WIDTH 8
+#include <pcre2.h>
+#endif
+
+#include <wsutil/ws_mempbrk.h>
+
+#include "ftypes.h"
+
+/* The shortest required literal worth looking for before running the
+ * regex; the regex engines already look for a single required byte. */
+#define MIN_LITERAL_LEN 2
+
+struct _fvalue_regex_t {
+#ifdef HAVE_PCRE2
+	pcre2_code	*code;
+#else
+	GRegex		*code;
+#endif
+	char		*pattern;
+
+	/*
+	 * A string, in lower case, that every subject the regex matches
+	 * has to contain, looked for first to reject most subjects
+	 * quickly; NULL if the pattern has none.
+	 */
+	guint8		*literal;
+	gsize		literal_len;
+	/* TRUE if the literal has letters, and so has to be looked for
+	 * without regard to case */
+	gboolean	literal_caseless;
+	/* For a caseless literal, the offset of the byte in it to look
+	 * for first, and a pattern for it in both cases */
+	gsize		anchor;
+	ws_mempbrk_pattern anchor_needles;
+	/* TRUE if the whole pattern is the literal, so that finding it is
+	 * the match */
+	gboolean	literal_only;
+};
+
+/*
+ * Finding the literal string that a pattern requires.
+ *
+ * This isn't a parser of the whole PCRE syntax; anything it isn't sure
+ * about either ends the current run of literal characters or, if it
+ * could change the meaning of what follows, such as option settings,
+ * \Q...\E quoting or alternation, makes it give up. A pattern only has
+ * to be valid for it to be compiled afterwards.
+ */
+
+typedef struct {
+	const char	*p;		/* next character of the pattern */
+	GByteArray	*run;		/* literal characters in a row */
+	GByteArray	*best;		/* longest run so far */
+	gboolean	pure;		/* nothing but literal characters so far */
+} literal_scan_t;
+
+static void
+literal_scan_end_run(literal_scan_t *scan)
+{
+	if (scan->run->len > scan->best->len) {
+		g_byte_array_set_size(scan->best, 0);
+		g_byte_array_append(scan->best, scan->run->data, scan->run->len);
+	}
+	g_byte_array_set_size(scan->run, 0);
+}
+
+/*
+ * Skip the quantifier, if any, after an atom. Sets *optional if the atom
+ * may occur no times, *repeated if it may occur several times; returns
+ * FALSE if what follows the atom can't be understood.
+ */
+static gboolean
+literal_scan_quantifier(literal_scan_t *scan, gboolean *optional, gboolean *repeated)
+{
+	const char *q;
+	guint min = 0;
+	gboolean digits = FALSE;
+
+	*optional = FALSE;
+	*repeated = FALSE;
+	switch (*scan->p) {
+
+	case '?':
+		*optional = TRUE;
+		scan->p++;
+		break;
+
+	case '*':
+		*optional = TRUE;
+		*repeated = TRUE;
+		scan->p++;
+		break;
+
+	case '+':
+		*repeated = TRUE;
+		scan->p++;
+		break;
+
+	case '{':
+		/* Only {n}, {n,} and {n,m}; give up on anything else,
+		   which the PCRE version in use may or may not take as
+		   a quantifier */
+		for (q = scan->p + 1; g_ascii_isdigit(*q); q++) {
+			if (min < 1000)
+				min = min * 10 + (*q - '0');
+			digits = TRUE;
+		}
+		if (!digits)
+			return FALSE;
+		if (*q == ',') {
+			for (q++; g_ascii_isdigit(*q); q++)
+				;
+		}
+		if (*q != '}')
+			return FALSE;
+		*optional = (min == 0);
+		*repeated = TRUE;
+		scan->p = q + 1;
+		break;
+
+	default:
+		return TRUE;
+	}
+
+	/* Lazy or possessive */
+	if (*scan->p == '?' || *scan->p == '+')
+		scan->p++;
+	return TRUE;
+}
+
+/* Skip a character class, scan->p pointing after its "[" */
+static gboolean
+literal_scan_class(literal_scan_t *scan)
+{
+	const char *q = scan->p;
+
+	if (*q == '^')
+		q++;
+	if (*q == ']')
+		q++;
+	for (;;) {
+		if (*q == '\0') {
+			return FALSE;
+		} else if (*q == '\\') {
+			if (q[1] == '\0')
+				return FALSE;
+			q += 2;
+		} else if (q[0] == '[' && q[1] == ':') {
+			q = strstr(q + 2, ":]");
+			if (q == NULL)
+				return FALSE;
+			q += 2;
+		} else if (*q == ']') {
+			scan->p = q + 1;
+			return TRUE;
+		} else {
+			q++;
+		}
+	}
+}
+
+/* Skip a group, scan->p pointing after its "(" */
+static gboolean
+literal_scan_group(literal_scan_t *scan)
+{
+	guint depth = 1;
+
+	while (depth > 0) {
+		switch (*scan->p) {
+
+		case '\0':
+			return FALSE;
+
+		case '\\':
+			if (scan->p[1] == '\0')
+				return FALSE;
+			scan->p += 2;
+			break;
+
+		case '[':
+			scan->p++;
+			if (!literal_scan_class(scan))
+				return FALSE;
+			break;
+
+		case '(':
+			depth++;
+			scan->p++;
+			break;
+
+		case ')':
+			depth--;
+			scan->p++;
+			break;
+
+		default:
+			scan->p++;
+			break;
+		}
+	}
+	return TRUE;
+}
+
+/*
+ * Read an escape, scan->p pointing after its backslash. Sets *literal to
+ * the character it stands for, or to -1 if it doesn't stand for a single
+ * character but can be skipped; returns FALSE if it can't be understood.
+ */
+static gboolean
+literal_scan_escape(literal_scan_t *scan, int *literal)
+{
+	char c = *scan->p;
+	guint value = 0;
+	int i;
+
+	if (c == '\0')
+		return FALSE;
+	scan->p++;
+	if (!g_ascii_isalnum(c)) {
+		*literal = (guint8)c;
+		return TRUE;
+	}
+
+	switch (c) {
+
+	case 't':	*literal = '\t';	return TRUE;
+	case 'n':	*literal = '\n';	return TRUE;
+	case 'r':	*literal = '\r';	return TRUE;
+	case 'f':	*literal = '\f';	return TRUE;
+	case 'e':	*literal = 0x1b;	return TRUE;
+	case 'a':	*literal = 0x07;	return TRUE;
+
+	case 'x':
+		if (*scan->p == '{') {
+			for (scan->p++; g_ascii_isxdigit(*scan->p); scan->p++) {
+				value = value * 16 + g_ascii_xdigit_value(*scan->p);
+				if (value > 0xff)
+					return FALSE;
+			}
+			if (*scan->p != '}')
+				return FALSE;
+			scan->p++;
+		} else {
+			for (i = 0; i < 2 && g_ascii_isxdigit(*scan->p); i++, scan->p++)
+				value = value * 16 + g_ascii_xdigit_value(*scan->p);
+		}
+		*literal = value;
+		return TRUE;
+
+	/* Character types and assertions, with no argument */
+	case 'd': case 'D': case 'w': case 'W': case 's': case 'S':
+	case 'h': case 'H': case 'v': case 'V': case 'R': case 'X':
+	case 'b': case 'B': case 'A': case 'z': case 'Z': case 'G':
+	case 'K': case 'C':
+		*literal = -1;
+		return TRUE;
+
+	default:
+		/* Back references, octal, \p{...}, \Q...\E and so on */
+		return FALSE;
+	}
+}
+
+/*
+ * Find the longest run of literal characters, each occurring exactly
+ * once, that every match of a pattern contains; returns FALSE if there
+ * isn't one or the pattern is too complex to tell.
+ */
+static gboolean
+regex_required_literal(const char *pattern, GByteArray *literal, gboolean *literal_only)
+{
+	literal_scan_t	scan;
+	gboolean	ok = TRUE;
+	gboolean	optional, repeated;
+	int		c;
+	guint8		byte;
+
+	scan.p = pattern;
+	scan.run = g_byte_array_new();
+	scan.best = literal;
+	scan.pure = TRUE;
+
+	while (ok && *scan.p != '\0') {
+		c = (guint8)*scan.p++;
+		switch (c) {
+
+		case '\\':
+			ok = literal_scan_escape(&scan, &c);
+			break;
+
+		case '[':
+			ok = literal_scan_class(&scan);
+			c = -1;
+			break;
+
+		case '(':
+			/* Option settings, such as (?x) or (?-i) and the
+			   (*VERB) items can change how the rest is read */
+			if (*scan.p == '*' || (*scan.p == '?' &&
+			    (g_ascii_isalpha(scan.p[1]) || scan.p[1] == '-' || scan.p[1] == '^'))) {
+				ok = FALSE;
+				break;
+			}
+			ok = literal_scan_group(&scan);
+			c = -1;
+			break;
+
+		case '.':
+		case '^':
+		case '$':
+			c = -1;
+			break;
+
+		case '|':
+		case ')':
+		case '*':
+		case '+':
+		case '?':
+		case '{':
+			ok = FALSE;
+			break;
+
+		default:
+			break;
+		}
+		if (!ok || !literal_scan_quantifier(&scan, &optional, &repeated)) {
+			ok = FALSE;
+			break;
+		}
+
+		if (c < 0) {
+			scan.pure = FALSE;
+			literal_scan_end_run(&scan);
+		} else if (optional) {
+			scan.pure = FALSE;
+			literal_scan_end_run(&scan);
+		} else {
+			byte = g_ascii_tolower(c);
+			g_byte_array_append(scan.run, &byte, 1);
+			if (repeated) {
+				scan.pure = FALSE;
+				literal_scan_end_run(&scan);
+			}
+		}
+	}
+	if (ok)
+		literal_scan_end_run(&scan);
+
+	g_byte_array_free(scan.run, TRUE);
+	*literal_only = ok && scan.pure;
+	return ok && literal->len >= MIN_LITERAL_LEN;
+}
+
+static void
+regex_set_literal(fvalue_regex_t *regex)
+{
+	GByteArray	*literal = g_byte_array_new();
+	gchar		needles[3];
+	gsize		i;
+
+	if (!regex_required_literal(regex->pattern, literal, &regex->literal_only)) {
+		g_byte_array_free(literal, TRUE);
+		regex->literal_only = FALSE;
+		return;
+	}
+
+	regex->literal_len = literal->len;
+	regex->literal = g_byte_array_free(literal, FALSE);
+	regex->literal_caseless = FALSE;
+	for (i = regex->literal_len; i-- > 0; ) {
+		if (g_ascii_isalpha(regex->literal[i])) {
+			regex->literal_caseless = TRUE;
+			regex->anchor = i;
+		}
+	}
+	if (!regex->literal_caseless)
+		return;
+
+	/* Rather than the first letter, look first for a byte that has
+	   only one case, if there is one, other than NUL, which
+	   ws_mempbrk_compile() can't look for */
+	for (i = 0; i < regex->literal_len; i++) {
+		if (!g_ascii_isalpha(regex->literal[i]) && regex->literal[i] != '\0') {
+			regex->anchor = i;
+			break;
+		}
+	}
+	needles[0] = g_ascii_tolower(regex->literal[regex->anchor]);
+	needles[1] = g_ascii_toupper(regex->literal[regex->anchor]);
+	needles[2] = '\0';
+	if (needles[1] == needles[0])
+		needles[1] = '\0';
+	ws_mempbrk_compile(&regex->anchor_needles, needles);
+}
+
+/* Does a subject contain the literal? */
+static gboolean
+regex_find_literal(const fvalue_regex_t *regex, const guint8 *subj, gsize subj_len)
+{
+	const guint8	*p, *end, *found, *start;
+	gsize		i;
+
+	if (subj_len < regex->literal_len)
+		return FALSE;
+	if (!regex->literal_caseless)
+		return ws_memmem(subj, subj_len, regex->literal, regex->literal_len) != NULL;
+
+	/* The anchor of each place the literal could start at */
+	p = subj + regex->anchor;
+	end = p + (subj_len - regex->literal_len) + 1;
+	while (p < end) {
+		found = ws_mempbrk_exec(p, end - p, &regex->anchor_needles, NULL);
+		if (found == NULL)
+			return FALSE;
+		start = found - regex->anchor;
+		for (i = 0; i < regex->literal_len; i++) {
+			if (g_ascii_tolower(start[i]) != regex->literal[i])
+				break;
+		}
+		if (i == regex->literal_len)
+			return TRUE;
+		p = found + 1;
+	}
+	return FALSE;
+}
+
+fvalue_regex_t *
+fvalue_regex_compile(const char *patt, char **errmsg)
+{
+	fvalue_regex_t	*regex;
+#ifdef HAVE_PCRE2
+	pcre2_code	*code;
+	int		errorcode;
+	PCRE2_SIZE	erroroffset;
+	PCRE2_UCHAR	errorbuf[256];
+
+	/*
+	 * As FT_BYTES and FT_PROTOCOL contain arbitrary binary data
+	 * and FT_STRING is not guaranteed to contain valid UTF-8,
+	 * patterns and subjects are treated as bytes, with no UTF
+	 * mode and so no UTF-8 checks.
+	 */
+	code = pcre2_compile((PCRE2_SPTR)patt, PCRE2_ZERO_TERMINATED,
+			PCRE2_CASELESS, &errorcode, &erroroffset, NULL);
+	if (code == NULL) {
+		pcre2_get_error_message(errorcode, errorbuf, sizeof errorbuf);
+		*errmsg = g_strdup_printf("Error while compiling regular expression %s at char %u: %s",
+				patt, (guint)erroroffset, (const char *)errorbuf);
+		return NULL;
+	}
+	/* Where the JIT isn't available, matching is interpreted */
+	pcre2_jit_compile(code, PCRE2_JIT_COMPLETE);
+#else
+	GRegex		*code;
+	GError		*regex_error = NULL;
+
+	/* See above; G_REGEX_RAW turns off UTF-8 */
+	code = g_regex_new(patt,
+			(GRegexCompileFlags)(G_REGEX_CASELESS | G_REGEX_OPTIMIZE | G_REGEX_RAW),
+			(GRegexMatchFlags)0, &regex_error);
+	if (regex_error) {
+		*errmsg = g_strdup(regex_error->message);
+		g_error_free(regex_error);
+		if (code)
+			g_regex_unref(code);
+		return NULL;
+	}
+#endif
+
+	regex = g_new0(fvalue_regex_t, 1);
+	regex->code = code;
+	regex->pattern = g_strdup(patt);
+	regex_set_literal(regex);
+	return regex;
+}
+
+gboolean
+fvalue_regex_matches(const fvalue_regex_t *regex, const guint8 *subj, gsize subj_len)
+{
+#ifdef HAVE_PCRE2
+	pcre2_match_data *match_data;
+	int		rc;
+#endif
+
+	if (subj == NULL)
+		subj = (const guint8 *)"";
+
+	if (regex->literal != NULL) {
+		if (!regex_find_literal(regex, subj, subj_len))
+			return FALSE;
+		if (regex->literal_only)
+			return TRUE;
+	}
+
+#ifdef HAVE_PCRE2
+	/* Only whether there is a match matters, not where */
+	match_data = pcre2_match_data_create(1, NULL);
+	rc = pcre2_match(regex->code, (PCRE2_SPTR)subj, subj_len, 0, 0, match_data, NULL);
+	if (rc == PCRE2_ERROR_JIT_STACKLIMIT) {
+		/* The JIT's default stack is small; the interpreter can go
+		   further before giving up */
+		rc = pcre2_match(regex->code, (PCRE2_SPTR)subj, subj_len, 0,
+				PCRE2_NO_JIT, match_data, NULL);
+	}
+	pcre2_match_data_free(match_data);
+	return rc >= 0;
+#else
+	return g_regex_match_full(regex->code, (const gchar *)subj, (gssize)subj_len,
+			0, (GRegexMatchFlags)0, NULL, NULL);
+#endif
+}
+
+const char *
+fvalue_regex_pattern(const fvalue_regex_t *regex)
+{
+	return regex->pattern;
+}
+
+void
+fvalue_regex_free(fvalue_regex_t *regex)
+{
+	if (regex == NULL)
+		return;
+#ifdef HAVE_PCRE2
+	pcre2_code_free(regex->code);
+#else
+	g_regex_unref(regex->code);
+#endif
+	g_free(regex->pattern);
+	g_free(regex->literal);
+	g_free(regex);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
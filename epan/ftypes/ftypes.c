@@ -750,7 +750,7 @@ fvalue_contains(const fvalue_t *a, const fvalue_t *b)
 }
 
 gboolean
-fvalue_matches(const fvalue_t *a, const GRegex *b)
+fvalue_matches(const fvalue_t *a, const fvalue_regex_t *b)
 {
 	/* XXX - check compatibility of a and b */
 	g_assert(a->ftype->cmp_matches);
@@ -205,6 +205,26 @@ WS_DLL_PUBLIC
 gboolean
 ftype_can_matches(enum ftenum ftype);
 
+/* ---------------- REGEX ----------------- */
+
+/* A compiled regular expression for the "matches" operator, which is
+ * case-insensitive and treats the pattern and the subjects as bytes. */
+typedef struct _fvalue_regex_t fvalue_regex_t;
+
+/* Returns NULL, setting *errmsg to a message to be freed with g_free(),
+ * if the pattern isn't valid. */
+fvalue_regex_t *
+fvalue_regex_compile(const char *patt, char **errmsg);
+
+gboolean
+fvalue_regex_matches(const fvalue_regex_t *regex, const guint8 *subj, gsize subj_len);
+
+const char *
+fvalue_regex_pattern(const fvalue_regex_t *regex);
+
+void
+fvalue_regex_free(fvalue_regex_t *regex);
+
 /* ---------------- FVALUE ----------------- */
 
 #include <epan/ipv4.h>
@@ -304,6 +324,12 @@ fvalue_set_time(fvalue_t *fv, const nstime_t *value);
 void
 fvalue_set_string(fvalue_t *fv, const gchar *value);
 
+/* Set a string fvalue to a string that stays valid as long as the fvalue
+ * does, such as one allocated in the same pool, without copying it; the
+ * fvalue doesn't free it. */
+void
+fvalue_set_string_pooled(fvalue_t *fv, const gchar *value);
+
 void
 fvalue_set_protocol(fvalue_t *fv, tvbuff_t *value, const gchar *name);
 
@@ -368,7 +394,31 @@ gboolean
 fvalue_contains(const fvalue_t *a, const fvalue_t *b);
 
 gboolean
-fvalue_matches(const fvalue_t *a, const GRegex *b);
+fvalue_matches(const fvalue_t *a, const fvalue_regex_t *b);
+
+/* A set of strings for the "contains any" operator, all looked for in a
+ * single pass over the subject. */
+typedef struct _fvalue_needles_t fvalue_needles_t;
+
+/* Can fv be one of the needles of a set, rather than be looked for by
+ * itself? */
+gboolean
+fvalue_needles_can_hold(const fvalue_t *fv);
+
+/* Make a set of needles, which must all be accepted by
+ * fvalue_needles_can_hold(); the set takes the array and the values. */
+fvalue_needles_t *
+fvalue_needles_new(GPtrArray *fvalues);
+
+guint
+fvalue_needles_count(const fvalue_needles_t *needles);
+
+void
+fvalue_needles_free(fvalue_needles_t *needles);
+
+/* Does a contain any of the needles? */
+gboolean
+fvalue_contains_any(const fvalue_t *a, const fvalue_needles_t *b);
 
 guint
 fvalue_length(fvalue_t *fv);
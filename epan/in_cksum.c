@@ -15,6 +15,8 @@
 
 #include <glib.h>
 
+#include <wsutil/ws_cksum.h>
+
 #include <epan/tvbuff.h>
 #include <epan/in_cksum.h>
 
@@ -25,6 +27,11 @@
  * code and should be modified for each CPU to be as fast as possible.
  */
 
+/*
+ * Below this, the loops here are as fast as calling ws_cksum_sum().
+ */
+#define IN_CKSUM_SIMD_MIN	256
+
 #define ADDCARRY(x)  {if ((x) > 65535) (x) -= 65535;}
 #define REDUCE {l_util.l = sum; sum = l_util.s[0] + l_util.s[1]; ADDCARRY(sum);}
 
@@ -75,6 +82,15 @@ in_cksum(const vec_t *vec, int veclen)
 			mlen--;
 			byte_swapped = 1;
 		}
+		/*
+		 * Hand long runs of words to ws_cksum_sum() if it can use
+		 * SIMD instructions; it returns at most 0xffff.
+		 */
+		if (mlen >= IN_CKSUM_SIMD_MIN && ws_cksum_have_simd()) {
+			sum += ws_cksum_sum((const guint8 *)w, mlen & ~1);
+			w += mlen >> 1;
+			mlen &= 1;
+		}
 		/*
 		 * Unroll the loop to make overhead from
 		 * branches &c small.
@@ -21,6 +21,7 @@ static mmdb_lookup_t mmdb_not_found;
 #ifdef HAVE_MAXMINDDB
 
 #include <stdio.h>
+#include <string.h>
 #include <errno.h>
 
 #include <epan/wmem/wmem.h>
@@ -61,11 +62,24 @@ typedef struct _mmdbr_response_t {
     gboolean is_ipv4;
     ws_in4_addr ipv4_addr;
     ws_in6_addr ipv6_addr;
+    int prefix_len; // Of the network with the same results, or -1
     mmdb_lookup_t mmdb_val;
 } mmdb_response_t;
 
 static wmem_map_t *mmdb_ipv4_map;
 static wmem_map_t *mmdb_ipv6_map;
+
+// Results of the networks the resolved addresses are in, so that other
+// addresses in them are resolved without asking mmdbresolve. There's a
+// map of network addresses for each prefix length that's been seen.
+typedef struct _mmdb_prefix_cache_t {
+    wmem_map_t *maps[129];  // By prefix length
+    guint8 lens[129];       // Prefix lengths that have a map, longest first
+    guint num_lens;
+} mmdb_prefix_cache_t;
+
+static mmdb_prefix_cache_t mmdb_ipv4_prefixes;
+static mmdb_prefix_cache_t mmdb_ipv6_prefixes;
 static GAsyncQueue *mmdbr_response_q; // g_allocated mmdbr_response_t *
 static GThread *read_mmdbr_stdout_thread;
 
@@ -123,6 +137,7 @@ static void mmdb_resolve_stop(void);
 #define RES_LOCATION_LATITUDE   "location.latitude"
 #define RES_LOCATION_LONGITUDE  "location.longitude"
 #define RES_LOCATION_ACCURACY   "location.accuracy_radius"
+#define RES_PREFIX_LENGTH       "network.prefix_length"
 #define RES_END                 "# End "
 
 // Interned strings and v6 addresses, similar to GLib's string chunks.
@@ -153,6 +168,67 @@ static void init_lookup(mmdb_lookup_t *lookup) {
     *lookup = empty_lookup;
 }
 
+static ws_in4_addr mask_ipv4_addr(ws_in4_addr addr, guint prefix_len) {
+    return prefix_len == 0 ? 0 : addr & g_htonl(0xffffffffU << (32 - prefix_len));
+}
+
+static void mask_ipv6_addr(ws_in6_addr *addr, guint prefix_len) {
+    guint i = prefix_len / 8;
+
+    if (i < sizeof(addr->bytes)) {
+        if (prefix_len % 8) {
+            addr->bytes[i++] &= (guint8) (0xff << (8 - prefix_len % 8));
+        }
+        memset(addr->bytes + i, 0, sizeof(addr->bytes) - i);
+    }
+}
+
+// Get the map of a prefix length, adding it if needed.
+static wmem_map_t *prefix_cache_map(mmdb_prefix_cache_t *cache, guint prefix_len, gboolean is_ipv4) {
+    guint i;
+
+    if (!cache->maps[prefix_len]) {
+        if (is_ipv4) {
+            cache->maps[prefix_len] = wmem_map_new(wmem_epan_scope(), g_direct_hash, g_direct_equal);
+        } else {
+            cache->maps[prefix_len] = wmem_map_new(wmem_epan_scope(), ipv6_oat_hash, ipv6_equal);
+        }
+        for (i = cache->num_lens; i > 0 && cache->lens[i - 1] < prefix_len; i--) {
+            cache->lens[i] = cache->lens[i - 1];
+        }
+        cache->lens[i] = (guint8) prefix_len;
+        cache->num_lens++;
+    }
+    return cache->maps[prefix_len];
+}
+
+static mmdb_lookup_t *prefix_cache_lookup_ipv4(ws_in4_addr addr) {
+    for (guint i = 0; i < mmdb_ipv4_prefixes.num_lens; i++) {
+        guint prefix_len = mmdb_ipv4_prefixes.lens[i];
+        mmdb_lookup_t *result = (mmdb_lookup_t *) wmem_map_lookup(mmdb_ipv4_prefixes.maps[prefix_len],
+                GUINT_TO_POINTER(mask_ipv4_addr(addr, prefix_len)));
+        if (result) {
+            return result;
+        }
+    }
+    return NULL;
+}
+
+static mmdb_lookup_t *prefix_cache_lookup_ipv6(const ws_in6_addr *addr) {
+    for (guint i = 0; i < mmdb_ipv6_prefixes.num_lens; i++) {
+        guint prefix_len = mmdb_ipv6_prefixes.lens[i];
+        ws_in6_addr net_addr = *addr;
+        mmdb_lookup_t *result;
+
+        mask_ipv6_addr(&net_addr, prefix_len);
+        result = (mmdb_lookup_t *) wmem_map_lookup(mmdb_ipv6_prefixes.maps[prefix_len], net_addr.bytes);
+        if (result) {
+            return result;
+        }
+    }
+    return NULL;
+}
+
 static gboolean mmdbr_pipe_valid(void) {
     g_rw_lock_reader_lock(&mmdbr_pipe_mtx);
     gboolean pipe_valid = ws_pipe_valid(&mmdbr_pipe);
@@ -161,6 +237,7 @@ static gboolean mmdbr_pipe_valid(void) {
 }
 
 // Writing to mmdbr_pipe.stdin_fd can block. Do so in a separate thread.
+#define MMDBR_MAX_WRITE_LEN 4096
 static gpointer
 write_mmdbr_stdin_worker(gpointer sifd_data) {
     int stdin_fd = GPOINTER_TO_INT(sifd_data);
@@ -186,13 +263,25 @@ write_mmdbr_stdin_worker(gpointer sifd_data) {
             continue;
         }
 
-        MMDB_DEBUG("write %s ql %d", request, g_async_queue_length(mmdbr_request_q));
-        ssize_t req_status = ws_write(stdin_fd, request, (unsigned int)strlen(request));
+        // Send the requests queued meanwhile along with this one, so that
+        // the addresses of a burst of packets cost one write.
+        GString *requests = g_string_new(request);
+        g_free(request);
+        while (requests->len < MMDBR_MAX_WRITE_LEN &&
+               (request = (char *) g_async_queue_try_pop(mmdbr_request_q)) != NULL) {
+            if (strcmp(request, mmdbr_stop_sentinel) != 0) {
+                g_string_append(requests, request);
+            }
+            g_free(request);
+        }
+
+        MMDB_DEBUG("write %s ql %d", requests->str, g_async_queue_length(mmdbr_request_q));
+        ssize_t req_status = ws_write(stdin_fd, requests->str, (unsigned int)requests->len);
+        g_string_free(requests, TRUE);
         if (req_status < 0) {
             MMDB_DEBUG("write error %s. exiting thread.", g_strerror(errno));
             return NULL;
         }
-        g_free(request);
     }
     return NULL;
 }
@@ -289,6 +378,7 @@ read_mmdbr_stdout_worker(gpointer data _U_) {
             }
             // Reset state.
             init_lookup(&response->mmdb_val);
+            response->prefix_len = -1;
             g_string_truncate(country_iso, 0);
             g_string_truncate(country, 0);
             g_string_truncate(city, 0);
@@ -328,8 +418,19 @@ read_mmdbr_stdout_worker(gpointer data _U_) {
             } else {
                 MMDB_DEBUG("Invalid accuracy radius: %s", val_start);
             }
+        } else if (val_start && g_str_has_prefix(line, RES_PREFIX_LENGTH)) {
+            guint32 prefix_len;
+            if (ws_strtou32(val_start, NULL, &prefix_len) &&
+                    prefix_len <= (guint32) (response->is_ipv4 ? 32 : 128)) {
+                response->prefix_len = (int) prefix_len;
+            } else {
+                MMDB_DEBUG("Invalid prefix length: %s", val_start);
+            }
         } else if (g_str_has_prefix(line, RES_END)) {
-            if (response->mmdb_val.found && cur_addr[0]) {
+            // Addresses that weren't found are sent back too if the
+            // network they're in is known, so that it can be cached.
+            if ((response->mmdb_val.found || response->prefix_len >= 0) && cur_addr[0] &&
+                    strcmp(cur_addr, "init") != 0) {
                 if (country_iso->len) {
                     response->mmdb_val.country_iso = g_strdup(country_iso->str);
                 }
@@ -350,6 +451,7 @@ read_mmdbr_stdout_worker(gpointer data _U_) {
             }
             cur_addr[0] = '\0';
             init_lookup(&response->mmdb_val);
+            response->prefix_len = -1;
         }
     }
 
@@ -617,6 +719,21 @@ gboolean maxmind_db_lookup_process(void)
     mmdb_response_t *response;
 
     while (mmdbr_response_q && (response = (mmdb_response_t *) g_async_queue_try_pop(mmdbr_response_q)) != NULL) {
+        if (!response->mmdb_val.found) {
+            // Only the network is new.
+            if (response->is_ipv4) {
+                wmem_map_insert(prefix_cache_map(&mmdb_ipv4_prefixes, response->prefix_len, TRUE),
+                        GUINT_TO_POINTER(mask_ipv4_addr(response->ipv4_addr, response->prefix_len)),
+                        &mmdb_not_found);
+            } else {
+                mask_ipv6_addr(&response->ipv6_addr, response->prefix_len);
+                wmem_map_insert(prefix_cache_map(&mmdb_ipv6_prefixes, response->prefix_len, FALSE),
+                        chunkify_v6_addr(&response->ipv6_addr), &mmdb_not_found);
+            }
+            g_free(response);
+            continue;
+        }
+
         mmdb_lookup_t *mmdb_val = (mmdb_lookup_t *) g_memdup2(&response->mmdb_val, sizeof(mmdb_lookup_t));
         if (response->mmdb_val.country_iso) {
             char *country_iso = (char *) response->mmdb_val.country_iso;
@@ -642,8 +759,18 @@ gboolean maxmind_db_lookup_process(void)
 
         if (response->is_ipv4) {
             wmem_map_insert(mmdb_ipv4_map, GUINT_TO_POINTER(response->ipv4_addr), mmdb_val);
+            if (response->prefix_len >= 0) {
+                wmem_map_insert(prefix_cache_map(&mmdb_ipv4_prefixes, response->prefix_len, TRUE),
+                        GUINT_TO_POINTER(mask_ipv4_addr(response->ipv4_addr, response->prefix_len)),
+                        mmdb_val);
+            }
         } else {
             wmem_map_insert(mmdb_ipv6_map, chunkify_v6_addr(&response->ipv6_addr), mmdb_val);
+            if (response->prefix_len >= 0) {
+                mask_ipv6_addr(&response->ipv6_addr, response->prefix_len);
+                wmem_map_insert(prefix_cache_map(&mmdb_ipv6_prefixes, response->prefix_len, FALSE),
+                        chunkify_v6_addr(&response->ipv6_addr), mmdb_val);
+            }
         }
         new_entries = TRUE;
         g_free(response);
@@ -656,6 +783,10 @@ const mmdb_lookup_t *
 maxmind_db_lookup_ipv4(const ws_in4_addr *addr) {
     mmdb_lookup_t *result = (mmdb_lookup_t *) wmem_map_lookup(mmdb_ipv4_map, GUINT_TO_POINTER(*addr));
 
+    if (!result && (result = prefix_cache_lookup_ipv4(*addr)) != NULL) {
+        wmem_map_insert(mmdb_ipv4_map, GUINT_TO_POINTER(*addr), result);
+    }
+
     if (!result) {
         result = &mmdb_not_found;
         wmem_map_insert(mmdb_ipv4_map, GUINT_TO_POINTER(*addr), result);
@@ -675,6 +806,10 @@ const mmdb_lookup_t *
 maxmind_db_lookup_ipv6(const ws_in6_addr *addr) {
     mmdb_lookup_t * result = (mmdb_lookup_t *) wmem_map_lookup(mmdb_ipv6_map, addr->bytes);
 
+    if (!result && (result = prefix_cache_lookup_ipv6(addr)) != NULL) {
+        wmem_map_insert(mmdb_ipv6_map, chunkify_v6_addr(addr), result);
+    }
+
     if (!result) {
         result = &mmdb_not_found;
         wmem_map_insert(mmdb_ipv6_map, chunkify_v6_addr(addr), result);
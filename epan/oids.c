@@ -79,6 +79,63 @@ static const oid_value_type_t unknown_type =    { FT_BYTES,  BASE_NONE, BER_CLAS
 
 static oid_info_t oid_root = { 0, NULL, OID_KIND_UNKNOWN, NULL, &unknown_type, -2, NULL, NULL, NULL};
 
+/*
+ * The same few OIDs turn up in packet after packet; what looking up an
+ * encoded OID in the tree gives, and its resolved name once it's been
+ * asked for, are kept here by the encoded bytes.  It's all thrown away
+ * when OIDs are added, and when it gets too big.
+ */
+#define OID_ENCODED_CACHE_MAX_ENTRIES 8192
+
+typedef struct {
+	guint8* bytes;
+	gint bytes_len;
+	guint32* subids;
+	guint subids_len;
+	oid_info_t* info;
+	guint matched;
+	guint left;
+	gchar* resolved;	/* NULL until asked for */
+} oid_encoded_cache_entry_t;
+
+static GHashTable* oid_encoded_cache = NULL;
+
+static guint oid_encoded_cache_hash(gconstpointer key) {
+	const oid_encoded_cache_entry_t* e = (const oid_encoded_cache_entry_t*)key;
+	guint h = 5381;
+	gint i;
+
+	for (i = 0; i < e->bytes_len; i++)
+		h = (h << 5) + h + e->bytes[i];
+	return h;
+}
+
+static gboolean oid_encoded_cache_equal(gconstpointer a, gconstpointer b) {
+	const oid_encoded_cache_entry_t* ea = (const oid_encoded_cache_entry_t*)a;
+	const oid_encoded_cache_entry_t* eb = (const oid_encoded_cache_entry_t*)b;
+
+	return ea->bytes_len == eb->bytes_len && memcmp(ea->bytes, eb->bytes, ea->bytes_len) == 0;
+}
+
+static void oid_encoded_cache_entry_free(gpointer p) {
+	oid_encoded_cache_entry_t* e = (oid_encoded_cache_entry_t*)p;
+
+	g_free(e->bytes);
+	wmem_free(NULL, e->subids);
+	wmem_free(NULL, e->resolved);
+	g_free(e);
+}
+
+static void oid_encoded_cache_clear(void) {
+	if (oid_encoded_cache) {
+		g_hash_table_destroy(oid_encoded_cache);
+		oid_encoded_cache = NULL;
+	}
+}
+
+/* Look an encoded OID up in the tree, or get what that gave last time. */
+static oid_encoded_cache_entry_t* oid_encoded_cache_get(const guint8 *bytes, gint bytes_len);
+
 static void prepopulate_oids(void) {
 	if (!oid_root.children) {
 		char* debug_env = getenv("WIRESHARK_DEBUG_MIBS");
@@ -105,6 +162,7 @@ static oid_info_t* add_oid(const char* name, oid_kind_t kind, const oid_value_ty
 	oid_info_t* c = &oid_root;
 
 	prepopulate_oids();
+	oid_encoded_cache_clear();
 	oid_len--;
 
 	do {
@@ -847,6 +905,7 @@ void oids_init(void) {
 }
 
 void oids_cleanup(void) {
+	oid_encoded_cache_clear();
 #ifdef HAVE_LIBSMI
 	unregister_mibs();
 #else
@@ -1052,9 +1111,43 @@ done:
 }
 
 
+static oid_encoded_cache_entry_t* oid_encoded_cache_get(const guint8 *bytes, gint bytes_len) {
+	oid_encoded_cache_entry_t key, *e;
+
+	if (bytes_len < 0)
+		bytes_len = 0;
+	key.bytes = (guint8 *)bytes;
+	key.bytes_len = bytes_len;
+	if (oid_encoded_cache) {
+		e = (oid_encoded_cache_entry_t*)g_hash_table_lookup(oid_encoded_cache, &key);
+		if (e)
+			return e;
+		if (g_hash_table_size(oid_encoded_cache) >= OID_ENCODED_CACHE_MAX_ENTRIES)
+			g_hash_table_remove_all(oid_encoded_cache);
+	} else {
+		oid_encoded_cache = g_hash_table_new_full(oid_encoded_cache_hash,
+		    oid_encoded_cache_equal, oid_encoded_cache_entry_free, NULL);
+	}
+
+	e = g_new(oid_encoded_cache_entry_t, 1);
+	e->bytes = (guint8 *)g_memdup2(bytes, bytes_len);
+	e->bytes_len = bytes_len;
+	e->subids = NULL;
+	e->subids_len = oid_encoded2subid(NULL, bytes, bytes_len, &e->subids);
+	e->info = oid_get(e->subids_len, e->subids, &e->matched, &e->left);
+	e->resolved = NULL;
+	g_hash_table_add(oid_encoded_cache, e);
+	return e;
+}
+
 oid_info_t* oid_get_from_encoded(wmem_allocator_t *scope, const guint8 *bytes, gint byteslen, guint32** subids_p, guint* matched_p, guint* left_p) {
-	guint subids_len = oid_encoded2subid(scope, bytes, byteslen, subids_p);
-	return oid_get(subids_len, *subids_p, matched_p, left_p);
+	oid_encoded_cache_entry_t* e = oid_encoded_cache_get(bytes, byteslen);
+
+	*subids_p = e->subids ?
+	    (guint32 *)wmem_memdup(scope, e->subids, e->subids_len * sizeof(guint32)) : NULL;
+	*matched_p = e->matched;
+	*left_p = e->left;
+	return e->info;
 }
 
 oid_info_t* oid_get_from_string(wmem_allocator_t *scope, const gchar *oid_str, guint32** subids_p, guint* matched, guint* left) {
@@ -1063,13 +1156,11 @@ oid_info_t* oid_get_from_string(wmem_allocator_t *scope, const gchar *oid_str, g
 }
 
 gchar *oid_resolved_from_encoded(wmem_allocator_t *scope, const guint8 *oid, gint oid_len) {
-	guint32 *subid_oid = NULL;
-	gchar * ret;
-	guint subid_oid_length = oid_encoded2subid(NULL, oid, oid_len, &subid_oid);
+	oid_encoded_cache_entry_t* e = oid_encoded_cache_get(oid, oid_len);
 
-	ret = oid_resolved(scope, subid_oid_length, subid_oid);
-	wmem_free(NULL, subid_oid);
-	return ret;
+	if (!e->resolved)
+		e->resolved = oid_resolved(NULL, e->subids_len, e->subids);
+	return wmem_strdup(scope, e->resolved);
 }
 
 gchar *rel_oid_resolved_from_encoded(wmem_allocator_t *scope, const guint8 *oid, gint oid_len) {
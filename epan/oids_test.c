@@ -47,6 +47,7 @@ example_s ex6rel = {".81.127.16383.2097151.268435455.128.16384.2097152.268435456
     25, (const guint8*)"\x51\x7f\xff\x7f\xff\xff\x7f\xff\xff\xff\x7f\x81\x00\x81\x80\x00\x81\x80\x80\x00\x81\x80\x80\x80\x00",
     9, { 81, 0x7F, 0x3FFF, 0x1FFFFF, 0x0FFFFFFF, 1+0x7F, 1+0x3FFF, 1+0x1FFFFF, 1+0x0FFFFFFF} };
 example_s ex7 = {"2.1.1", "joint-iso-itu-t.asn1.basic-encoding", 2, (const guint8*)"\x51\x01", 3, {2,1,1} };
+example_s ex8 = {"2.1.2", "joint-iso-itu-t.asn1.ber-derived", 2, (const guint8*)"\x51\x02", 3, {2,1,2} };
 DIAG_ON_PEDANTIC
 
 /*
@@ -456,6 +457,22 @@ oids_test_add_string(void)
     wmem_free(NULL, oid);
 }
 
+static void
+oids_test_add_encoded_resolved_before(void)
+{
+    gchar* oid;
+
+    /* A name looked up before the OID is added mustn't stick. */
+    oid = oid_resolved_from_encoded(NULL, ex8.encoded, ex8.encoded_len);
+    g_assert_cmpstr(oid, ==, "joint-iso-itu-t.1.2");
+    wmem_free(NULL, oid);
+
+    oid_add_from_encoded(ex8.resolved, ex8.encoded, ex8.encoded_len);
+    oid = oid_resolved_from_encoded(NULL, ex8.encoded, ex8.encoded_len);
+    g_assert_cmpstr(oid, ==, ex8.resolved);
+    wmem_free(NULL, oid);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -508,6 +525,7 @@ main(int argc, char **argv)
     g_test_add_func("/oids/add/subids",   oids_test_add_subids);
     g_test_add_func("/oids/add/encoded",   oids_test_add_encoded);
     g_test_add_func("/oids/add/string",   oids_test_add_string);
+    g_test_add_func("/oids/add/encoded/resolvedbefore",   oids_test_add_encoded_resolved_before);
 
     wmem_init();
     test_scope = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
@@ -27,16 +27,19 @@
 
 #include "addr_resolv.h"
 #include "tvbuff.h"
+#include "tvbuff-int.h"
 #include "epan_dissect.h"
 
 #include "wmem/wmem.h"
 
 #include <epan/exceptions.h>
+#include <epan/conversation.h>
 #include <epan/reassemble.h>
 #include <epan/stream.h>
 #include <epan/expert.h>
 #include <epan/prefs.h>
 #include <epan/range.h>
+#include <epan/plugin_manifest.h>
 
 #include <wsutil/str_util.h>
 #include <wsutil/ws_printf.h> /* ws_debug_printf */
@@ -68,6 +71,11 @@ struct data_source {
  * e.g. for TCP or UDP port number tables and protocols with no fixed
  * port number.
  *
+ * "handle_set" holds the same handles, and "protocol_handles" maps each
+ * of their protocols to the first of them registered for it, so that
+ * registering a handle needn't walk the list; the list is sorted by
+ * filter name only when it's next looked at, if "handles_unsorted".
+ *
  * "ui_name" is the name the dissector table has in the user interface.
  *
  * "type" is a field type giving the width of the uint value for that
@@ -81,16 +89,30 @@ struct data_source {
  * for determining dependencies.
  */
 struct dissector_table {
+	const char	*name;
 	GHashTable	*hash_table;
 	GSList		*dissector_handles;
+	GHashTable	*handle_set;
+	GHashTable	*protocol_handles;
+	gboolean	handles_unsorted;
 	const char	*ui_name;
 	ftenum_t	type;
 	int		param;
 	protocol_t	*protocol;
 	GHashFunc	hash_func;
 	gboolean	supports_decode_as;
+	dtbl_entry_t	***uint_pages;	/* see find_uint_dtbl_entry() */
+	guint		uint_page_count;
+	gboolean	deferred_plugins;	/* see dissector_table_load_plugins() */
 };
 
+/* Whether the handoffs are done; see dissector_tables_freeze() */
+static gboolean dissector_tables_frozen = FALSE;
+
+static void dissector_table_uint_pages_free(dissector_table_t sub_dissectors);
+static void dissector_tables_freeze(void);
+static void dissector_table_sort_handles(dissector_table_t sub_dissectors);
+
 /*
  * Dissector tables. const char * -> dissector_table *
  */
@@ -111,6 +133,7 @@ static GHashTable *registered_dissectors = NULL;
  */
 struct depend_dissector_list {
 	GSList		*dissectors;
+	GHashTable	*dissector_set;	/* the names in "dissectors" */
 };
 
 /* Maps char *dissector_name to depend_dissector_list_t */
@@ -147,6 +170,7 @@ destroy_depend_dissector_list(void *data)
 	depend_dissector_list_t dissector_list = (depend_dissector_list_t)data;
 	GSList **list = &(dissector_list->dissectors);
 
+	g_hash_table_destroy(dissector_list->dissector_set);
 	g_slist_free_full(*list, g_free);
 	g_slice_free(struct depend_dissector_list, dissector_list);
 }
@@ -155,8 +179,12 @@ destroy_depend_dissector_list(void *data)
  * A heuristics dissector list.
  */
 struct heur_dissector_list {
+	const char	*name;
 	protocol_t	*protocol;
 	GSList		*dissectors;
+	guint		generation;	/* bumped when a dissector is deleted */
+	gboolean	deferred_plugins;	/* see dissector_table_load_plugins() */
+	heur_dissector_list_stats_t stats;
 };
 
 static GHashTable *heur_dissector_lists = NULL;
@@ -188,8 +216,13 @@ destroy_dissector_table(void *data)
 {
 	struct dissector_table *table = (struct dissector_table *)data;
 
+	dissector_table_uint_pages_free(table);
 	g_hash_table_destroy(table->hash_table);
 	g_slist_free(table->dissector_handles);
+	if (table->handle_set)
+		g_hash_table_destroy(table->handle_set);
+	if (table->protocol_handles)
+		g_hash_table_destroy(table->protocol_handles);
 	g_slice_free(struct dissector_table, data);
 }
 
@@ -228,6 +261,9 @@ packet_cache_proto_handles(void)
 
 	proto_malformed = proto_get_id_by_filter_name("_ws.malformed");
 	g_assert(proto_malformed != -1);
+
+	/* The handoffs are done; from now on, tables change rarely. */
+	dissector_tables_freeze();
 }
 
 /* List of routines that are called before we make a pass through a capture file
@@ -237,6 +273,10 @@ static GSList *init_routines = NULL;
 static GSList *cleanup_routines = NULL;
 static GSList *shutdown_routines = NULL;
 
+/* Whether a file is being dissected, between init_dissection() and
+ * cleanup_dissection() */
+static gboolean dissection_initialized = FALSE;
+
 typedef void (*void_func_t)(void);
 
 /* Initialize all data structures used for dissection. */
@@ -253,12 +293,15 @@ packet_cleanup(void)
 	g_slist_free(init_routines);
 	g_slist_free(cleanup_routines);
 	g_slist_free(postseq_cleanup_routines);
+	dissector_tables_frozen = FALSE;
 	g_hash_table_destroy(dissector_tables);
 	g_hash_table_destroy(dissector_table_aliases);
 	g_hash_table_destroy(registered_dissectors);
 	g_hash_table_destroy(depend_dissector_lists);
 	g_hash_table_destroy(heur_dissector_lists);
 	g_hash_table_destroy(heuristic_short_names);
+	if (dissector_profiles)
+		g_hash_table_destroy(dissector_profiles);
 	g_slist_foreach(shutdown_routines, &call_routine, NULL);
 	g_slist_free(shutdown_routines);
 	if (postdissectors) {
@@ -308,6 +351,24 @@ register_shutdown_routine(void (*func)(void))
 	shutdown_routines = g_slist_prepend(shutdown_routines, (gpointer)func);
 }
 
+/*
+ * Call a routine that registers more dissectors after startup, such as one
+ * that loads a plugin; if a file is being dissected, the init routines it
+ * registers have missed init_dissection(), so call them now.
+ */
+void
+packet_register_late(void (*register_func)(gpointer), gpointer data)
+{
+	GSList *old_init_routines = init_routines;
+	GSList *l;
+
+	register_func(data);
+	if (dissection_initialized) {
+		for (l = init_routines; l != old_init_routines; l = l->next)
+			call_routine(l->data, NULL);
+	}
+}
+
 /* Initialize all data structures used for dissection. */
 void
 init_dissection(void)
@@ -332,6 +393,8 @@ init_dissection(void)
 
 	/* Initialize the expert infos */
 	expert_packet_init();
+
+	dissection_initialized = TRUE;
 }
 
 void
@@ -347,6 +410,7 @@ cleanup_dissection(void)
 	expert_packet_cleanup();
 
 	wmem_leave_file_scope();
+	dissection_initialized = FALSE;
 
 	/*
 	 * Keep the name resolution info around until we start the next
@@ -570,9 +634,12 @@ dissect_record(epan_dissect_t *edt, int file_type_subtype,
 	edt->pi.link_dir = LINK_DIR_UNKNOWN;
 	edt->pi.layers = wmem_list_new(edt->pi.pool);
 	edt->tvb = tvb;
+	tvb_set_packet_pool(tvb, edt->pi.pool);
 
 	frame_delta_abs_time(edt->session, fd, fd->frame_ref_num, &edt->pi.rel_ts);
 
+	conversation_new_frame(&edt->pi);
+
 	/* pkt comment use first user, later from rec */
 	if (fd->has_user_comment)
 		frame_dissector_data.pkt_comment = epan_get_user_comment(edt->session, fd);
@@ -636,6 +703,7 @@ dissect_file(epan_dissect_t *edt, wtap_rec *rec,
 	edt->pi.link_dir = LINK_DIR_UNKNOWN;
 	edt->pi.layers = wmem_list_new(edt->pi.pool);
 	edt->tvb = tvb;
+	tvb_set_packet_pool(tvb, edt->pi.pool);
 
 
 	frame_delta_abs_time(edt->session, fd, fd->frame_ref_num, &edt->pi.rel_ts);
@@ -690,8 +758,361 @@ struct dissector_handle {
 	void		*dissector_func;
 	void		*dissector_data;
 	protocol_t	*protocol;
+	gboolean	stateless;	/* registered as keeping no state */
 };
 
+/*
+ * Profiling of the dissectors called through handles and of the heuristic
+ * dissectors, off unless dissector_profiling_enable() turns it on; it
+ * costs only a test of dissector_profiling otherwise.
+ */
+static gboolean dissector_profiling = FALSE;
+
+/* dissector handle or heur_dtbl_entry_t -> dissector_profile_t */
+static GHashTable *dissector_profiles = NULL;
+
+/* The profiled calls in progress, innermost first, to tell their self time */
+typedef struct dissector_profile_frame {
+	struct dissector_profile_frame *outer;
+	gint64 children_time;
+} dissector_profile_frame_t;
+
+static dissector_profile_frame_t *dissector_profile_current = NULL;
+
+static void
+dissector_profile_free(gpointer data)
+{
+	dissector_profile_t *profile = (dissector_profile_t *)data;
+
+	g_free(profile->name);
+	g_free(profile);
+}
+
+void
+dissector_profiling_enable(const gboolean enable)
+{
+	if (enable && dissector_profiles == NULL)
+		dissector_profiles = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+		    NULL, dissector_profile_free);
+	dissector_profiling = enable;
+}
+
+gboolean
+dissector_profiling_enabled(void)
+{
+	return dissector_profiling;
+}
+
+void
+dissector_profiling_reset(void)
+{
+	if (dissector_profiles)
+		g_hash_table_remove_all(dissector_profiles);
+}
+
+static gint
+dissector_profile_compare(gconstpointer a, gconstpointer b)
+{
+	const dissector_profile_t *profile_a = *(const dissector_profile_t * const *)a;
+	const dissector_profile_t *profile_b = *(const dissector_profile_t * const *)b;
+
+	if (profile_a->self_time != profile_b->self_time)
+		return profile_a->self_time < profile_b->self_time ? 1 : -1;
+	return g_strcmp0(profile_a->name, profile_b->name);
+}
+
+GPtrArray *
+dissector_profiling_get(void)
+{
+	GPtrArray      *profiles = g_ptr_array_new();
+	GHashTableIter  iter;
+	gpointer        value;
+
+	if (dissector_profiles) {
+		g_hash_table_iter_init(&iter, dissector_profiles);
+		while (g_hash_table_iter_next(&iter, NULL, &value))
+			g_ptr_array_add(profiles, value);
+	}
+	g_ptr_array_sort(profiles, dissector_profile_compare);
+	return profiles;
+}
+
+/*
+ * Accounting of the file scope memory allocated by each protocol, off
+ * unless dissector_memory_accounting_enable() turns it on; while it is on,
+ * the wmem accounting tag is the id of the protocol being dissected.
+ */
+static gboolean dissector_memory_accounting = FALSE;
+
+void
+dissector_memory_accounting_enable(const gboolean enable)
+{
+	wmem_accounting_enable(wmem_file_scope(), enable);
+	dissector_memory_accounting = enable;
+}
+
+gboolean
+dissector_memory_accounting_enabled(void)
+{
+	return dissector_memory_accounting;
+}
+
+static void
+dissector_memory_add(int tag, guint64 allocs, guint64 bytes, void *user_data)
+{
+	GPtrArray *usages = (GPtrArray *)user_data;
+	dissector_memory_t *usage = g_new(dissector_memory_t, 1);
+	protocol_t *protocol = tag >= 0 ? find_protocol_by_id(tag) : NULL;
+
+	usage->proto_id = tag;
+	usage->protocol = protocol ? proto_get_protocol_short_name(protocol) : NULL;
+	usage->allocs = allocs;
+	usage->bytes = bytes;
+	g_ptr_array_add(usages, usage);
+}
+
+static gint
+dissector_memory_compare(gconstpointer a, gconstpointer b)
+{
+	const dissector_memory_t *usage_a = *(const dissector_memory_t * const *)a;
+	const dissector_memory_t *usage_b = *(const dissector_memory_t * const *)b;
+
+	if (usage_a->bytes != usage_b->bytes)
+		return usage_a->bytes < usage_b->bytes ? 1 : -1;
+	return usage_a->proto_id - usage_b->proto_id;
+}
+
+GPtrArray *
+dissector_memory_accounting_get(void)
+{
+	GPtrArray *usages = g_ptr_array_new_with_free_func(g_free);
+
+	wmem_accounting_foreach(wmem_file_scope(), dissector_memory_add, usages);
+	g_ptr_array_sort(usages, dissector_memory_compare);
+	return usages;
+}
+
+/*
+ * Checking of the dissectors registered as stateless, off unless
+ * dissector_state_checking_enable() turns it on: the functions that keep
+ * state from one packet to the next call dissector_state_write(), and a
+ * write made while a stateless dissector is the innermost one called
+ * through a handle is counted against it.
+ */
+static gboolean dissector_state_checking = FALSE;
+
+/* dissector handle -> dissector_state_check_t */
+static GHashTable *dissector_state_checks = NULL;
+
+/* The check of the innermost dissector called, NULL unless it's stateless */
+static dissector_state_check_t *dissector_state_current = NULL;
+
+/* The frame being dissected, for the first write of a check */
+static guint32 dissector_state_frame = 0;
+
+static void
+dissector_state_check_free(gpointer data)
+{
+	dissector_state_check_t *check = (dissector_state_check_t *)data;
+
+	g_free(check->name);
+	g_free(check);
+}
+
+void
+dissector_state_checking_enable(const gboolean enable)
+{
+	if (enable && dissector_state_checks == NULL)
+		dissector_state_checks = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+		    NULL, dissector_state_check_free);
+	dissector_state_checking = enable;
+}
+
+gboolean
+dissector_state_checking_enabled(void)
+{
+	return dissector_state_checking;
+}
+
+void
+dissector_state_checking_reset(void)
+{
+	if (dissector_state_checks)
+		g_hash_table_remove_all(dissector_state_checks);
+}
+
+static gint
+dissector_state_check_compare(gconstpointer a, gconstpointer b)
+{
+	const dissector_state_check_t *check_a = *(const dissector_state_check_t * const *)a;
+	const dissector_state_check_t *check_b = *(const dissector_state_check_t * const *)b;
+
+	if (check_a->writes != check_b->writes)
+		return check_a->writes < check_b->writes ? 1 : -1;
+	return g_strcmp0(check_a->name, check_b->name);
+}
+
+GPtrArray *
+dissector_state_checking_get(void)
+{
+	GPtrArray      *checks = g_ptr_array_new();
+	GHashTableIter  iter;
+	gpointer        value;
+
+	if (dissector_state_checks) {
+		g_hash_table_iter_init(&iter, dissector_state_checks);
+		while (g_hash_table_iter_next(&iter, NULL, &value))
+			g_ptr_array_add(checks, value);
+	}
+	g_ptr_array_sort(checks, dissector_state_check_compare);
+	return checks;
+}
+
+void
+dissector_state_write(const char *what)
+{
+	dissector_state_check_t *check = dissector_state_current;
+
+	if (check == NULL)
+		return;
+	if (check->writes++ == 0) {
+		check->first_frame = dissector_state_frame;
+		check->first_write = what;
+	}
+}
+
+static dissector_state_check_t *
+dissector_state_check_get(dissector_handle_t handle)
+{
+	dissector_state_check_t *check;
+
+	check = (dissector_state_check_t *)g_hash_table_lookup(dissector_state_checks, handle);
+	if (check == NULL) {
+		check = g_new0(dissector_state_check_t, 1);
+		check->protocol = handle->protocol ? proto_get_protocol_short_name(handle->protocol) : NULL;
+		check->name = g_strdup(handle->name ? handle->name : (check->protocol ? check->protocol : "(unnamed)"));
+		g_hash_table_insert(dissector_state_checks, handle, check);
+	}
+	return check;
+}
+
+static dissector_profile_t *
+dissector_profile_get(const void *key, const char *name, protocol_t *protocol, const gboolean heuristic)
+{
+	dissector_profile_t *profile;
+
+	profile = (dissector_profile_t *)g_hash_table_lookup(dissector_profiles, key);
+	if (profile == NULL) {
+		profile = g_new0(dissector_profile_t, 1);
+		profile->protocol = protocol ? proto_get_protocol_short_name(protocol) : NULL;
+		profile->name = g_strdup(name ? name : (profile->protocol ? profile->protocol : "(unnamed)"));
+		profile->heuristic = heuristic;
+		g_hash_table_insert(dissector_profiles, (gpointer)key, profile);
+	}
+	return profile;
+}
+
+static inline int
+call_dissector_func(dissector_handle_t handle, tvbuff_t *tvb,
+		    packet_info *pinfo, proto_tree *tree, void *data)
+{
+	if (handle->dissector_type == DISSECTOR_TYPE_SIMPLE) {
+		return ((dissector_t)handle->dissector_func)(tvb, pinfo, tree, data);
+	}
+	else if (handle->dissector_type == DISSECTOR_TYPE_CALLBACK) {
+		return ((dissector_cb_t)handle->dissector_func)(tvb, pinfo, tree, data, handle->dissector_data);
+	}
+	g_assert_not_reached();
+	return 0;
+}
+
+/*
+ * Call a dissector, either through a handle or a heuristic one, adding the
+ * call to its profile if profile isn't NULL, counting the memory it
+ * allocates against its protocol if memory accounting is on and the state
+ * it writes against it if state checking is on.
+ */
+static int
+call_dissector_instrumented(dissector_profile_t *profile, protocol_t *protocol,
+			    dissector_handle_t handle, heur_dissector_t heur_dissector,
+			    tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void *data)
+{
+	dissector_profile_frame_t frame;
+	dissector_state_check_t *saved_state_check = dissector_state_current;
+	volatile int len = 0;
+	gint64       start = 0, elapsed;
+	int          saved_tag = 0;
+
+	frame.outer = dissector_profile_current;
+	frame.children_time = 0;
+	if (profile != NULL) {
+		dissector_profile_current = &frame;
+
+		profile->calls++;
+		profile->bytes += tvb_captured_length(tvb);
+		start = g_get_monotonic_time();
+	}
+	/* A stateless dissector is only answerable for what it does itself,
+	   not for the heuristic and stateful dissectors it calls */
+	if (dissector_state_checking) {
+		dissector_state_frame = pinfo->num;
+		if (handle != NULL && handle->stateless) {
+			dissector_state_current = dissector_state_check_get(handle);
+			dissector_state_current->calls++;
+		} else {
+			dissector_state_current = NULL;
+		}
+	}
+	/* Protocols in name only are parts of another protocol, whose
+	   memory they are counted in */
+	if (dissector_memory_accounting && protocol != NULL && !proto_is_pino(protocol))
+		saved_tag = wmem_accounting_set_tag(proto_get_id(protocol));
+	else
+		protocol = NULL;
+	TRY {
+		if (handle != NULL)
+			len = call_dissector_func(handle, tvb, pinfo, tree, data);
+		else
+			len = heur_dissector(tvb, pinfo, tree, data);
+	}
+	CATCH_ALL {
+		if (profile != NULL)
+			profile->exceptions++;
+		RETHROW;
+	}
+	FINALLY {
+		dissector_state_current = saved_state_check;
+		if (protocol != NULL)
+			wmem_accounting_set_tag(saved_tag);
+		if (profile != NULL) {
+			elapsed = g_get_monotonic_time() - start;
+			profile->total_time += elapsed;
+			profile->self_time += elapsed - frame.children_time;
+			dissector_profile_current = frame.outer;
+			if (frame.outer != NULL)
+				frame.outer->children_time += elapsed;
+		}
+	}
+	ENDTRY;
+
+	if (profile != NULL && len != 0)
+		profile->accepted++;
+	return len;
+}
+
+static inline int
+call_heur_dissector_func(heur_dtbl_entry_t *hdtbl_entry, tvbuff_t *tvb,
+			 packet_info *pinfo, proto_tree *tree, void *data)
+{
+	if (dissector_profiling || dissector_memory_accounting || dissector_state_checking) {
+		return call_dissector_instrumented(dissector_profiling ?
+		    dissector_profile_get(hdtbl_entry, hdtbl_entry->short_name,
+		    hdtbl_entry->protocol, TRUE) : NULL, hdtbl_entry->protocol,
+		    NULL, hdtbl_entry->dissector, tvb, pinfo, tree, data);
+	}
+	return (hdtbl_entry->dissector)(tvb, pinfo, tree, data);
+}
+
 /* This function will return
  * old style dissector :
  *   length of the payload or 1 of the payload is empty
@@ -702,6 +1123,23 @@ struct dissector_handle {
  * The only time this function will return 0 is if it is a new style dissector
  * and if the dissector rejected the packet.
  */
+/*
+ * Call the dissector for a handle, profiling it or accounting its memory if
+ * asked to; the caller looks after pinfo->current_proto.
+ */
+static inline int
+call_dissector_handle_func(dissector_handle_t handle, tvbuff_t *tvb,
+			   packet_info *pinfo, proto_tree *tree, void *data)
+{
+	if (dissector_profiling || dissector_memory_accounting || dissector_state_checking) {
+		return call_dissector_instrumented(dissector_profiling ?
+		    dissector_profile_get(handle, handle->name, handle->protocol,
+		    FALSE) : NULL, handle->protocol,
+		    handle, NULL, tvb, pinfo, tree, data);
+	}
+	return call_dissector_func(handle, tvb, pinfo, tree, data);
+}
+
 static int
 call_dissector_through_handle(dissector_handle_t handle, tvbuff_t *tvb,
 			      packet_info *pinfo, proto_tree *tree, void *data)
@@ -716,15 +1154,7 @@ call_dissector_through_handle(dissector_handle_t handle, tvbuff_t *tvb,
 			proto_get_protocol_short_name(handle->protocol);
 	}
 
-	if (handle->dissector_type == DISSECTOR_TYPE_SIMPLE) {
-		len = ((dissector_t)handle->dissector_func)(tvb, pinfo, tree, data);
-	}
-	else if (handle->dissector_type == DISSECTOR_TYPE_CALLBACK) {
-		len = ((dissector_cb_t)handle->dissector_func)(tvb, pinfo, tree, data, handle->dissector_data);
-	}
-	else {
-		g_assert_not_reached();
-	}
+	len = call_dissector_handle_func(handle, tvb, pinfo, tree, data);
 	pinfo->current_proto = saved_proto;
 
 	return len;
@@ -760,6 +1190,7 @@ call_dissector_work(dissector_handle_t handle, tvbuff_t *tvb, packet_info *pinfo
 	int          len;
 	guint        saved_layers_len = 0;
 	guint        saved_tree_count = tree ? tree->tree_data->count : 0;
+	gboolean     named;
 
 	if (handle->protocol != NULL &&
 	    !proto_is_protocol_enabled(handle->protocol)) {
@@ -788,7 +1219,8 @@ call_dissector_work(dissector_handle_t handle, tvbuff_t *tvb, packet_info *pinfo
 	 */
 	pinfo->saved_can_desegment = saved_can_desegment;
 	pinfo->can_desegment = saved_can_desegment-(saved_can_desegment>0);
-	if ((handle->protocol != NULL) && (!proto_is_pino(handle->protocol))) {
+	named = handle->protocol != NULL && !proto_is_pino(handle->protocol);
+	if (named) {
 		pinfo->current_proto =
 			proto_get_protocol_short_name(handle->protocol);
 
@@ -808,11 +1240,12 @@ call_dissector_work(dissector_handle_t handle, tvbuff_t *tvb, packet_info *pinfo
 		len = call_dissector_work_error(handle, tvb, pinfo, tree, data);
 	} else {
 		/*
-		 * Just call the subdissector.
+		 * Just call the subdissector; we've already set
+		 * pinfo->current_proto, and restore it below.
 		 */
-		len = call_dissector_through_handle(handle, tvb, pinfo, tree, data);
+		len = call_dissector_handle_func(handle, tvb, pinfo, tree, data);
 	}
-	if (handle->protocol != NULL && !proto_is_pino(handle->protocol) && add_proto_name &&
+	if (named && add_proto_name &&
 		(len == 0 || (tree && saved_tree_count == tree->tree_data->count))) {
 		/*
 		 * We've added a layer and either the dissector didn't
@@ -952,11 +1385,152 @@ struct dtbl_entry {
 	dissector_handle_t current;
 };
 
+/*
+ * The uint tables are frozen once the handoffs are done: from then on,
+ * the entries of the values below DTBL_UINT_DIRECT_LIMIT are also kept in
+ * pages of DTBL_UINT_PAGE_SIZE pointers, indexed by the upper bits of the
+ * value, those pages that have no entry not being allocated. Every
+ * change of a table, as made by "Decode As", updates them.
+ */
+#define DTBL_UINT_PAGE_BITS	8
+#define DTBL_UINT_PAGE_SIZE	(1U << DTBL_UINT_PAGE_BITS)
+#define DTBL_UINT_DIRECT_LIMIT	(1U << (2 * DTBL_UINT_PAGE_BITS))
+
+static void
+dissector_table_uint_pages_free(dissector_table_t sub_dissectors)
+{
+	guint i;
+
+	for (i = 0; i < sub_dissectors->uint_page_count; i++)
+		g_free(sub_dissectors->uint_pages[i]);
+	g_free(sub_dissectors->uint_pages);
+	sub_dissectors->uint_pages = NULL;
+	sub_dissectors->uint_page_count = 0;
+}
+
+static void
+dissector_table_uint_pages_build(dissector_table_t sub_dissectors)
+{
+	GHashTableIter  iter;
+	gpointer        key, value;
+	guint32         pattern, max_pattern = 0;
+	dtbl_entry_t  **page;
+
+	dissector_table_uint_pages_free(sub_dissectors);
+
+	if (!dissector_tables_frozen ||
+	    g_hash_table_size(sub_dissectors->hash_table) == 0)
+		return;
+
+	switch (sub_dissectors->type) {
+
+	case FT_UINT8:
+	case FT_UINT16:
+	case FT_UINT24:
+	case FT_UINT32:
+	case FT_NONE:
+		break;
+
+	default:
+		return;
+	}
+
+	g_hash_table_iter_init(&iter, sub_dissectors->hash_table);
+	while (g_hash_table_iter_next(&iter, &key, NULL)) {
+		pattern = GPOINTER_TO_UINT(key);
+		if (pattern < DTBL_UINT_DIRECT_LIMIT && pattern > max_pattern)
+			max_pattern = pattern;
+	}
+
+	sub_dissectors->uint_page_count = (max_pattern >> DTBL_UINT_PAGE_BITS) + 1;
+	sub_dissectors->uint_pages = g_new0(dtbl_entry_t **, sub_dissectors->uint_page_count);
+
+	g_hash_table_iter_init(&iter, sub_dissectors->hash_table);
+	while (g_hash_table_iter_next(&iter, &key, &value)) {
+		pattern = GPOINTER_TO_UINT(key);
+		if (pattern >= DTBL_UINT_DIRECT_LIMIT)
+			continue;
+		page = sub_dissectors->uint_pages[pattern >> DTBL_UINT_PAGE_BITS];
+		if (page == NULL) {
+			page = g_new0(dtbl_entry_t *, DTBL_UINT_PAGE_SIZE);
+			sub_dissectors->uint_pages[pattern >> DTBL_UINT_PAGE_BITS] = page;
+		}
+		page[pattern & (DTBL_UINT_PAGE_SIZE - 1)] = (dtbl_entry_t *)value;
+	}
+}
+
+/* Keep the pages of a frozen table in step with a change of its hash table */
+static void
+dissector_table_uint_page_set(dissector_table_t sub_dissectors, const guint32 pattern,
+			       dtbl_entry_t *dtbl_entry)
+{
+	dtbl_entry_t **page;
+
+	if (!dissector_tables_frozen || pattern >= DTBL_UINT_DIRECT_LIMIT)
+		return;
+
+	if (sub_dissectors->uint_pages == NULL ||
+	    (pattern >> DTBL_UINT_PAGE_BITS) >= sub_dissectors->uint_page_count) {
+		if (dtbl_entry != NULL)
+			dissector_table_uint_pages_build(sub_dissectors);
+		return;
+	}
+
+	page = sub_dissectors->uint_pages[pattern >> DTBL_UINT_PAGE_BITS];
+	if (page == NULL) {
+		if (dtbl_entry == NULL)
+			return;
+		page = g_new0(dtbl_entry_t *, DTBL_UINT_PAGE_SIZE);
+		sub_dissectors->uint_pages[pattern >> DTBL_UINT_PAGE_BITS] = page;
+	}
+	page[pattern & (DTBL_UINT_PAGE_SIZE - 1)] = dtbl_entry;
+}
+
+static void
+dissector_table_freeze(gpointer key _U_, gpointer value, gpointer user_data _U_)
+{
+	dissector_table_uint_pages_build((dissector_table_t)value);
+	dissector_table_sort_handles((dissector_table_t)value);
+}
+
+static void
+dissector_tables_freeze(void)
+{
+	dissector_tables_frozen = TRUE;
+	g_hash_table_foreach(dissector_tables, dissector_table_freeze, NULL);
+}
+
+/*
+ * Plugins whose loading was deferred are loaded the first time one of the
+ * tables they add to is used; see plugin_manifest.c.
+ */
+static inline void
+dissector_table_load_plugins(dissector_table_t sub_dissectors)
+{
+	if (G_UNLIKELY(sub_dissectors->deferred_plugins)) {
+		sub_dissectors->deferred_plugins = FALSE;
+		plugin_manifest_load(PLUGIN_MANIFEST_TABLE, sub_dissectors->name);
+	}
+}
+
+void
+dissector_table_defer_plugins(const char *name)
+{
+	dissector_table_t sub_dissectors = (dissector_table_t) g_hash_table_lookup(dissector_tables, name);
+
+	if (sub_dissectors)
+		sub_dissectors->deferred_plugins = TRUE;
+}
+
 /* Finds a dissector table by table name. */
 dissector_table_t
 find_dissector_table(const char *name)
 {
 	dissector_table_t dissector_table = (dissector_table_t) g_hash_table_lookup(dissector_tables, name);
+
+	plugin_manifest_note(PLUGIN_MANIFEST_TABLE, name);
+	if (! dissector_table && plugin_manifest_load(PLUGIN_MANIFEST_TABLE, name))
+		dissector_table = (dissector_table_t) g_hash_table_lookup(dissector_tables, name);
 	if (! dissector_table) {
 		const char *new_name = (const char *) g_hash_table_lookup(dissector_table_aliases, name);
 		if (new_name) {
@@ -973,6 +1547,21 @@ find_dissector_table(const char *name)
 static dtbl_entry_t *
 find_uint_dtbl_entry(dissector_table_t sub_dissectors, const guint32 pattern)
 {
+	dtbl_entry_t **page;
+
+	dissector_table_load_plugins(sub_dissectors);
+
+	/*
+	 * Once the tables are frozen, the entries of the small values, which
+	 * are almost all of them, are found by indexing instead of hashing.
+	 */
+	if (sub_dissectors->uint_pages != NULL && pattern < DTBL_UINT_DIRECT_LIMIT) {
+		if ((pattern >> DTBL_UINT_PAGE_BITS) >= sub_dissectors->uint_page_count)
+			return NULL;
+		page = sub_dissectors->uint_pages[pattern >> DTBL_UINT_PAGE_BITS];
+		return page != NULL ? page[pattern & (DTBL_UINT_PAGE_SIZE - 1)] : NULL;
+	}
+
 	switch (sub_dissectors->type) {
 
 	case FT_UINT8:
@@ -1081,6 +1670,7 @@ dissector_add_uint(const char *name, const guint32 pattern, dissector_handle_t h
 	/* do the table insertion */
 	g_hash_table_insert(sub_dissectors->hash_table,
 			     GUINT_TO_POINTER(pattern), (gpointer)dtbl_entry);
+	dissector_table_uint_page_set(sub_dissectors, pattern, dtbl_entry);
 
 	/*
 	 * Now, if this table supports "Decode As", add this handle
@@ -1242,6 +1832,7 @@ dissector_delete_uint(const char *name, const guint32 pattern,
 		 */
 		g_hash_table_remove(sub_dissectors->hash_table,
 				    GUINT_TO_POINTER(pattern));
+		dissector_table_uint_page_set(sub_dissectors, pattern, NULL);
 	}
 }
 
@@ -1283,6 +1874,7 @@ void dissector_delete_all(const char *name, dissector_handle_t handle)
 	g_assert (sub_dissectors);
 
 	g_hash_table_foreach_remove (sub_dissectors->hash_table, dissector_delete_all_check, handle);
+	dissector_table_uint_pages_build(sub_dissectors);
 }
 
 static void
@@ -1292,7 +1884,16 @@ dissector_delete_from_table(gpointer key _U_, gpointer value, gpointer user_data
 	g_assert (sub_dissectors);
 
 	g_hash_table_foreach_remove(sub_dissectors->hash_table, dissector_delete_all_check, user_data);
+	dissector_table_uint_pages_build(sub_dissectors);
 	sub_dissectors->dissector_handles = g_slist_remove(sub_dissectors->dissector_handles, user_data);
+	if (sub_dissectors->handle_set)
+		g_hash_table_remove(sub_dissectors->handle_set, user_data);
+	if (sub_dissectors->protocol_handles) {
+		dissector_handle_t handle = (dissector_handle_t)user_data;
+
+		if (g_hash_table_lookup(sub_dissectors->protocol_handles, handle->protocol) == handle)
+			g_hash_table_remove(sub_dissectors->protocol_handles, handle->protocol);
+	}
 }
 
 /* Delete handle from all tables and dissector_handles lists */
@@ -1337,6 +1938,7 @@ dissector_change_uint(const char *name, const guint32 pattern, dissector_handle_
 	/* do the table insertion */
 	g_hash_table_insert(sub_dissectors->hash_table,
 			     GUINT_TO_POINTER(pattern), (gpointer)dtbl_entry);
+	dissector_table_uint_page_set(sub_dissectors, pattern, dtbl_entry);
 }
 
 /* Reset an entry in a uint dissector table to its initial value. */
@@ -1365,6 +1967,7 @@ dissector_reset_uint(const char *name, const guint32 pattern)
 	} else {
 		g_hash_table_remove(sub_dissectors->hash_table,
 				    GUINT_TO_POINTER(pattern));
+		dissector_table_uint_page_set(sub_dissectors, pattern, NULL);
 	}
 }
 
@@ -1464,12 +2067,34 @@ dissector_get_default_uint_handle(const char *name, const guint32 uint_val)
 	return NULL;
 }
 
+/*
+ * Hash and compare the keys of case-insensitive string tables with ASCII
+ * case folded as they go, so that looking a string up doesn't need a
+ * lowercased copy of it.
+ */
+static guint
+dissector_str_case_hash(gconstpointer key)
+{
+	const guint8 *p;
+	guint32 h = 5381;
+
+	for (p = (const guint8 *)key; *p != '\0'; p++)
+		h = (h << 5) + h + (guint8)g_ascii_tolower(*p);
+
+	return h;
+}
+
+static gboolean
+dissector_str_case_equal(gconstpointer a, gconstpointer b)
+{
+	return g_ascii_strcasecmp((const char *)a, (const char *)b) == 0;
+}
+
 /* Find an entry in a string dissector table. */
 static dtbl_entry_t *
 find_string_dtbl_entry(dissector_table_t const sub_dissectors, const gchar *pattern)
 {
-	dtbl_entry_t *ret;
-	char *key;
+	dissector_table_load_plugins(sub_dissectors);
 
 	switch (sub_dissectors->type) {
 
@@ -1490,20 +2115,11 @@ find_string_dtbl_entry(dissector_table_t const sub_dissectors, const gchar *patt
 		g_assert_not_reached();
 	}
 
-	if (sub_dissectors->param == TRUE) {
-		key = g_ascii_strdown(pattern, -1);
-	} else {
-		key = g_strdup(pattern);
-	}
-
 	/*
-	 * Find the entry.
+	 * Find the entry.  Case-insensitive tables fold the case of the
+	 * pattern as they hash and compare it.
 	 */
-	ret = (dtbl_entry_t *)g_hash_table_lookup(sub_dissectors->hash_table, key);
-
-	g_free(key);
-
-	return ret;
+	return (dtbl_entry_t *)g_hash_table_lookup(sub_dissectors->hash_table, pattern);
 }
 
 /* Add an entry to a string dissector table. */
@@ -1617,6 +2233,7 @@ dissector_change_string(const char *name, const gchar *pattern,
 {
 	dissector_table_t  sub_dissectors = find_dissector_table(name);
 	dtbl_entry_t      *dtbl_entry;
+	char *key;
 
 	/* sanity check */
 	g_assert(sub_dissectors);
@@ -1643,7 +2260,12 @@ dissector_change_string(const char *name, const gchar *pattern,
 	dtbl_entry->current = handle;
 
 	/* do the table insertion */
-	g_hash_table_insert(sub_dissectors->hash_table, (gpointer)g_strdup(pattern),
+	if (sub_dissectors->param == TRUE) {
+		key = g_ascii_strdown(pattern, -1);
+	} else {
+		key = g_strdup(pattern);
+	}
+	g_hash_table_insert(sub_dissectors->hash_table, (gpointer)key,
 			     (gpointer)dtbl_entry);
 }
 
@@ -1819,7 +2441,10 @@ void dissector_add_custom_table_handle(const char *name, void *pattern, dissecto
 
 dissector_handle_t dissector_get_custom_table_handle(dissector_table_t sub_dissectors, void *key)
 {
-	dtbl_entry_t *dtbl_entry = (dtbl_entry_t *)g_hash_table_lookup(sub_dissectors->hash_table, key);
+	dtbl_entry_t *dtbl_entry;
+
+	dissector_table_load_plugins(sub_dissectors);
+	dtbl_entry = (dtbl_entry_t *)g_hash_table_lookup(sub_dissectors->hash_table, key);
 
 	if (dtbl_entry != NULL)
 		return dtbl_entry->current;
@@ -1885,6 +2510,7 @@ int dissector_try_guid_new(dissector_table_t sub_dissectors,
 	struct dissector_handle *handle;
 	int len;
 
+	dissector_table_load_plugins(sub_dissectors);
 	dtbl_entry = (dtbl_entry_t *)g_hash_table_lookup(sub_dissectors->hash_table, guid_val);
 	if (dtbl_entry != NULL) {
 		/*
@@ -1943,6 +2569,7 @@ dissector_handle_t dissector_get_guid_handle(
 {
 	dtbl_entry_t *dtbl_entry;
 
+	dissector_table_load_plugins(sub_dissectors);
 	dtbl_entry = (dtbl_entry_t *)g_hash_table_lookup(sub_dissectors->hash_table, guid_val);
 	if (dtbl_entry != NULL)
 		return dtbl_entry->current;
@@ -2018,13 +2645,26 @@ dissector_compare_filter_name(gconstpointer dissector_a, gconstpointer dissector
 	return ret;
 }
 
+/* Sort the handles of a table by filter name, if any were added since
+   they were last sorted.  g_slist_sort() is stable, and handles are
+   prepended, so handles with the same name stay newest first. */
+static void
+dissector_table_sort_handles(dissector_table_t sub_dissectors)
+{
+	if (!sub_dissectors->handles_unsorted)
+		return;
+
+	sub_dissectors->dissector_handles =
+		g_slist_sort(sub_dissectors->dissector_handles, (GCompareFunc)dissector_compare_filter_name);
+	sub_dissectors->handles_unsorted = FALSE;
+}
+
 /* Add a handle to the list of handles that *could* be used with this
    table.  That list is used by the "Decode As"/"-d" code in the UI. */
 void
 dissector_add_for_decode_as(const char *name, dissector_handle_t handle)
 {
 	dissector_table_t  sub_dissectors = find_dissector_table(name);
-	GSList            *entry;
 	dissector_handle_t dup_handle;
 
 	/*
@@ -2065,8 +2705,9 @@ dissector_add_for_decode_as(const char *name, dissector_handle_t handle)
 		register_depend_dissector(proto_get_protocol_short_name(sub_dissectors->protocol), proto_get_protocol_short_name(handle->protocol));
 
 	/* Is it already in this list? */
-	entry = g_slist_find(sub_dissectors->dissector_handles, (gpointer)handle);
-	if (entry != NULL) {
+	if (sub_dissectors->handle_set == NULL)
+		sub_dissectors->handle_set = g_hash_table_new(g_direct_hash, g_direct_equal);
+	if (g_hash_table_contains(sub_dissectors->handle_set, handle)) {
 		/*
 		 * Yes - don't insert it again.
 		 */
@@ -2080,32 +2721,35 @@ dissector_add_for_decode_as(const char *name, dissector_handle_t handle)
 	   so we don't do the check for them. */
 	if (sub_dissectors->type != FT_STRING)
 	{
-		for (entry = sub_dissectors->dissector_handles; entry != NULL; entry = g_slist_next(entry))
+		if (sub_dissectors->protocol_handles == NULL)
+			sub_dissectors->protocol_handles = g_hash_table_new(g_direct_hash, g_direct_equal);
+		dup_handle = (dissector_handle_t)g_hash_table_lookup(sub_dissectors->protocol_handles, handle->protocol);
+		if (dup_handle != NULL)
 		{
-			dup_handle = (dissector_handle_t)entry->data;
-			if (dup_handle->protocol == handle->protocol)
-			{
-				const char *dissector_name, *dup_dissector_name;
-
-				dissector_name = dissector_handle_get_dissector_name(handle);
-				if (dissector_name == NULL)
-					dissector_name = "(anonymous)";
-				dup_dissector_name = dissector_handle_get_dissector_name(dup_handle);
-				if (dup_dissector_name == NULL)
-					dup_dissector_name = "(anonymous)";
-				fprintf(stderr, "Duplicate dissectors %s and %s for protocol %s in dissector table %s\n",
-				    dissector_name, dup_dissector_name,
-				    proto_get_protocol_short_name(handle->protocol),
-				    name);
-				if (wireshark_abort_on_dissector_bug)
-					abort();
-			}
+			const char *dissector_name, *dup_dissector_name;
+
+			dissector_name = dissector_handle_get_dissector_name(handle);
+			if (dissector_name == NULL)
+				dissector_name = "(anonymous)";
+			dup_dissector_name = dissector_handle_get_dissector_name(dup_handle);
+			if (dup_dissector_name == NULL)
+				dup_dissector_name = "(anonymous)";
+			fprintf(stderr, "Duplicate dissectors %s and %s for protocol %s in dissector table %s\n",
+			    dissector_name, dup_dissector_name,
+			    proto_get_protocol_short_name(handle->protocol),
+			    name);
+			if (wireshark_abort_on_dissector_bug)
+				abort();
 		}
+		else
+			g_hash_table_insert(sub_dissectors->protocol_handles, handle->protocol, handle);
 	}
 
-	/* Add it to the list. */
+	/* Add it to the list; it's sorted when it's next looked at. */
+	g_hash_table_add(sub_dissectors->handle_set, handle);
 	sub_dissectors->dissector_handles =
-		g_slist_insert_sorted(sub_dissectors->dissector_handles, (gpointer)handle, (GCompareFunc)dissector_compare_filter_name);
+		g_slist_prepend(sub_dissectors->dissector_handles, (gpointer)handle);
+	sub_dissectors->handles_unsorted = TRUE;
 }
 
 void dissector_add_for_decode_as_with_preference(const char *name,
@@ -2131,6 +2775,8 @@ dissector_table_get_dissector_handles(dissector_table_t dissector_table) {
 	if (!dissector_table)
 		return NULL;
 
+	dissector_table_load_plugins(dissector_table);
+	dissector_table_sort_handles(dissector_table);
 	return dissector_table->dissector_handles;
 }
 
@@ -2164,6 +2810,7 @@ dissector_handle_t dissector_table_get_dissector_handle(dissector_table_t dissec
 	lookup.dissector_short_name = short_name;
 	lookup.handle = NULL;
 
+	dissector_table_sort_handles(dissector_table);
 	g_slist_foreach(dissector_table->dissector_handles, find_dissector_in_table, &lookup);
 	return lookup.handle;
 }
@@ -2289,6 +2936,7 @@ dissector_table_foreach (const char *table_name,
 	dissector_foreach_info_t info;
 	dissector_table_t        sub_dissectors = find_dissector_table(table_name);
 
+	dissector_table_load_plugins(sub_dissectors);
 	info.table_name    = table_name;
 	info.selector_type = sub_dissectors->type;
 	info.caller_func   = func;
@@ -2308,6 +2956,8 @@ dissector_table_foreach_handle(const char     *table_name,
 	dissector_table_t sub_dissectors = find_dissector_table(table_name);
 	GSList *tmp;
 
+	dissector_table_load_plugins(sub_dissectors);
+	dissector_table_sort_handles(sub_dissectors);
 	for (tmp = sub_dissectors->dissector_handles; tmp != NULL;
 	     tmp = g_slist_next(tmp))
         func(table_name, tmp->data, user_data);
@@ -2450,6 +3100,7 @@ register_dissector_table(const char *name, const char *ui_name, const int proto,
 	/* Create and register the dissector table for this name; returns */
 	/* a pointer to the dissector table. */
 	sub_dissectors = g_slice_new(struct dissector_table);
+	sub_dissectors->name = name;
 	switch (type) {
 
 	case FT_UINT8:
@@ -2471,11 +3122,19 @@ register_dissector_table(const char *name, const char *ui_name, const int proto,
 	case FT_STRINGZ:
 	case FT_STRINGZPAD:
 	case FT_STRINGZTRUNC:
-		sub_dissectors->hash_func = g_str_hash;
-		sub_dissectors->hash_table = g_hash_table_new_full(g_str_hash,
-							       g_str_equal,
-							       &g_free,
-							       &g_free);
+		if (param == TRUE) {
+			sub_dissectors->hash_func = dissector_str_case_hash;
+			sub_dissectors->hash_table = g_hash_table_new_full(dissector_str_case_hash,
+								       dissector_str_case_equal,
+								       &g_free,
+								       &g_free);
+		} else {
+			sub_dissectors->hash_func = g_str_hash;
+			sub_dissectors->hash_table = g_hash_table_new_full(g_str_hash,
+								       g_str_equal,
+								       &g_free,
+								       &g_free);
+		}
 		break;
 	case FT_GUID:
 		sub_dissectors->hash_table = g_hash_table_new_full(uuid_hash,
@@ -2500,12 +3159,19 @@ register_dissector_table(const char *name, const char *ui_name, const int proto,
 		g_assert_not_reached();
 	}
 	sub_dissectors->dissector_handles = NULL;
+	sub_dissectors->handle_set = NULL;
+	sub_dissectors->protocol_handles = NULL;
+	sub_dissectors->handles_unsorted = FALSE;
 	sub_dissectors->ui_name = ui_name;
 	sub_dissectors->type    = type;
 	sub_dissectors->param   = param;
 	sub_dissectors->protocol  = find_protocol_by_id(proto);
 	sub_dissectors->supports_decode_as = FALSE;
+	sub_dissectors->uint_pages = NULL;
+	sub_dissectors->uint_page_count = 0;
+	sub_dissectors->deferred_plugins = FALSE;
 	g_hash_table_insert(dissector_tables, (gpointer)name, (gpointer) sub_dissectors);
+	plugin_manifest_note(PLUGIN_MANIFEST_TABLE, name);
 	return sub_dissectors;
 }
 
@@ -2522,6 +3188,7 @@ dissector_table_t register_custom_dissector_table(const char *name,
 	/* Create and register the dissector table for this name; returns */
 	/* a pointer to the dissector table. */
 	sub_dissectors = g_slice_new(struct dissector_table);
+	sub_dissectors->name = name;
 	sub_dissectors->hash_func = hash_func;
 	sub_dissectors->hash_table = g_hash_table_new_full(hash_func,
 							       key_equal_func,
@@ -2529,12 +3196,19 @@ dissector_table_t register_custom_dissector_table(const char *name,
 							       &g_free);
 
 	sub_dissectors->dissector_handles = NULL;
+	sub_dissectors->handle_set = NULL;
+	sub_dissectors->protocol_handles = NULL;
+	sub_dissectors->handles_unsorted = FALSE;
 	sub_dissectors->ui_name = ui_name;
 	sub_dissectors->type    = FT_BYTES; /* Consider key a "blob" of data, no need to really create new type */
 	sub_dissectors->param   = BASE_NONE;
 	sub_dissectors->protocol  = find_protocol_by_id(proto);
 	sub_dissectors->supports_decode_as = FALSE;
+	sub_dissectors->uint_pages = NULL;
+	sub_dissectors->uint_page_count = 0;
+	sub_dissectors->deferred_plugins = FALSE;
 	g_hash_table_insert(dissector_tables, (gpointer)name, (gpointer) sub_dissectors);
+	plugin_manifest_note(PLUGIN_MANIFEST_TABLE, name);
 	return sub_dissectors;
 }
 
@@ -2623,11 +3297,25 @@ check_valid_heur_name_or_fail(const char *heur_name)
 	}
 }
 
+void
+heur_dissector_list_defer_plugins(const char *name)
+{
+	heur_dissector_list_t sub_dissectors = (heur_dissector_list_t)g_hash_table_lookup(heur_dissector_lists, name);
+
+	if (sub_dissectors)
+		sub_dissectors->deferred_plugins = TRUE;
+}
+
 /* Finds a heuristic dissector table by table name. */
 heur_dissector_list_t
 find_heur_dissector_list(const char *name)
 {
-	return (heur_dissector_list_t)g_hash_table_lookup(heur_dissector_lists, name);
+	heur_dissector_list_t sub_dissectors = (heur_dissector_list_t)g_hash_table_lookup(heur_dissector_lists, name);
+
+	plugin_manifest_note(PLUGIN_MANIFEST_HEURISTIC, name);
+	if (!sub_dissectors && plugin_manifest_load(PLUGIN_MANIFEST_HEURISTIC, name))
+		sub_dissectors = (heur_dissector_list_t)g_hash_table_lookup(heur_dissector_lists, name);
+	return sub_dissectors;
 }
 
 gboolean
@@ -2701,6 +3389,9 @@ heur_dissector_add(const char *name, heur_dissector_t dissector, const char *dis
 	hdtbl_entry->short_name = g_strdup(internal_name);
 	hdtbl_entry->list_name = g_strdup(name);
 	hdtbl_entry->enabled   = (enable == HEURISTIC_ENABLE);
+	hdtbl_entry->tries     = 0;
+	hdtbl_entry->accepted  = 0;
+	hdtbl_entry->score     = 0;
 
 	/* do the table insertion */
 	g_hash_table_insert(heuristic_short_names, (gpointer)hdtbl_entry->short_name, hdtbl_entry);
@@ -2752,9 +3443,117 @@ heur_dissector_delete(const char *name, heur_dissector_t dissector, const int pr
 		g_slice_free(heur_dtbl_entry_t, found_entry->data);
 		sub_dissectors->dissectors = g_slist_delete_link(sub_dissectors->dissectors,
 		    found_entry);
+		/* Conversations may still point to it */
+		sub_dissectors->generation++;
+	}
+}
+
+/*
+ * With prefs.heuristic_adaptive_order, the heuristic dissectors of a list
+ * are kept in decreasing order of their score, the number of packets they
+ * accepted lately; the scores of a list are halved when one of them gets
+ * to HEUR_SCORE_MAX, so that the order follows changes in the traffic.
+ */
+#define HEUR_SCORE_MAX	1024
+
+static void
+heur_dissector_list_accepted(heur_dissector_list_t sub_dissectors, GSList *entry)
+{
+	heur_dtbl_entry_t *hdtbl_entry = (heur_dtbl_entry_t *)entry->data;
+	GSList            *e;
+
+	if (!prefs.heuristic_adaptive_order) {
+		/* Bubble the matched entry to the top for faster search next time. */
+		if (entry != sub_dissectors->dissectors) {
+			sub_dissectors->dissectors = g_slist_remove_link(sub_dissectors->dissectors, entry);
+			sub_dissectors->dissectors = g_slist_concat(entry, sub_dissectors->dissectors);
+		}
+		return;
+	}
+
+	if (++hdtbl_entry->score >= HEUR_SCORE_MAX) {
+		for (e = sub_dissectors->dissectors; e != NULL; e = g_slist_next(e))
+			((heur_dtbl_entry_t *)e->data)->score /= 2;
+	}
+
+	/* Move it before the first entry with a lower score */
+	for (e = sub_dissectors->dissectors; e != entry; e = g_slist_next(e)) {
+		if (((heur_dtbl_entry_t *)e->data)->score < hdtbl_entry->score) {
+			sub_dissectors->dissectors = g_slist_delete_link(sub_dissectors->dissectors, entry);
+			sub_dissectors->dissectors = g_slist_insert_before(sub_dissectors->dissectors, e, hdtbl_entry);
+			break;
+		}
 	}
 }
 
+/*
+ * Call one heuristic dissector of dissector_try_heuristic(), if it is
+ * enabled; returns what it returned, or 0 if it isn't.
+ */
+static int
+try_heur_dissector_entry(heur_dissector_list_t sub_dissectors, heur_dtbl_entry_t *hdtbl_entry,
+			 tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void *data,
+			 guint16 saved_can_desegment, guint saved_layers_len, guint saved_tree_count)
+{
+	int proto_id;
+	int len;
+
+	/* XXX - why set this now and above? */
+	pinfo->can_desegment = saved_can_desegment-(saved_can_desegment>0);
+
+	if (hdtbl_entry->protocol != NULL &&
+		(!proto_is_protocol_enabled(hdtbl_entry->protocol)||(hdtbl_entry->enabled==FALSE))) {
+		/*
+		 * No - don't try this dissector.
+		 */
+		return 0;
+	}
+
+	if (hdtbl_entry->protocol != NULL) {
+		proto_id = proto_get_id(hdtbl_entry->protocol);
+		/* do NOT change this behavior - wslua uses the protocol short name set here in order
+		   to determine which Lua-based heurisitc dissector to call */
+		pinfo->current_proto =
+			proto_get_protocol_short_name(hdtbl_entry->protocol);
+
+		/*
+		 * Add the protocol name to the layers; we'll remove it
+		 * if the dissector fails.
+		 */
+		pinfo->curr_layer_num++;
+		wmem_list_append(pinfo->layers, GINT_TO_POINTER(proto_id));
+	}
+
+	pinfo->heur_list_name = hdtbl_entry->list_name;
+
+	hdtbl_entry->tries++;
+	sub_dissectors->stats.tries++;
+	len = call_heur_dissector_func(hdtbl_entry, tvb, pinfo, tree, data);
+	if (hdtbl_entry->protocol != NULL &&
+		(len == 0 || (tree && saved_tree_count == tree->tree_data->count))) {
+		/*
+		 * We added a protocol layer above. The dissector
+		 * didn't accept the packet or it didn't add any
+		 * items to the tree so remove it from the list.
+		 */
+		while (wmem_list_count(pinfo->layers) > saved_layers_len) {
+			if (len == 0) {
+				/*
+				 * Only reduce the layer number if the dissector
+				 * rejected the data. Since tree can be NULL on
+				 * the first pass, we cannot check it or it will
+				 * break dissectors that rely on a stable value.
+				 */
+				pinfo->curr_layer_num--;
+			}
+			wmem_list_remove_frame(pinfo->layers, wmem_list_tail(pinfo->layers));
+		}
+	}
+	if (len)
+		hdtbl_entry->accepted++;
+	return len;
+}
+
 gboolean
 dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 			packet_info *pinfo, proto_tree *tree, heur_dtbl_entry_t **heur_dtbl_entry, void *data)
@@ -2763,14 +3562,18 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 	const char        *saved_curr_proto;
 	const char        *saved_heur_list_name;
 	GSList            *entry;
-	GSList            *prev_entry = NULL;
 	guint16            saved_can_desegment;
 	guint              saved_layers_len = 0;
 	heur_dtbl_entry_t *hdtbl_entry;
-	int                proto_id;
-	int                len;
+	heur_dtbl_entry_t *cached_entry = NULL;
+	conversation_t    *conversation = NULL;
 	guint              saved_tree_count = tree ? tree->tree_data->count : 0;
 
+	if (G_UNLIKELY(sub_dissectors->deferred_plugins)) {
+		sub_dissectors->deferred_plugins = FALSE;
+		plugin_manifest_load(PLUGIN_MANIFEST_HEURISTIC, sub_dissectors->name);
+	}
+
 	/* can_desegment is set to 2 by anyone which offers this api/service.
 	   then everytime a subdissector is called it is decremented by one.
 	   thus only the subdissector immediately ontop of whoever offers this
@@ -2793,78 +3596,61 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 
 	DISSECTOR_ASSERT(saved_layers_len < PINFO_LAYER_MAX_RECURSION_DEPTH);
 
-	for (entry = sub_dissectors->dissectors; entry != NULL;
-	    entry = g_slist_next(entry)) {
-		/* XXX - why set this now and above? */
-		pinfo->can_desegment = saved_can_desegment-(saved_can_desegment>0);
-		hdtbl_entry = (heur_dtbl_entry_t *)entry->data;
+	sub_dissectors->stats.calls++;
 
-		if (hdtbl_entry->protocol != NULL &&
-			(!proto_is_protocol_enabled(hdtbl_entry->protocol)||(hdtbl_entry->enabled==FALSE))) {
-			/*
-			 * No - don't try this dissector.
-			 */
-			continue;
-		}
-
-		if (hdtbl_entry->protocol != NULL) {
-			proto_id = proto_get_id(hdtbl_entry->protocol);
-			/* do NOT change this behavior - wslua uses the protocol short name set here in order
-			   to determine which Lua-based heurisitc dissector to call */
-			pinfo->current_proto =
-				proto_get_protocol_short_name(hdtbl_entry->protocol);
-
-			/*
-			 * Add the protocol name to the layers; we'll remove it
-			 * if the dissector fails.
-			 */
-			pinfo->curr_layer_num++;
-			wmem_list_append(pinfo->layers, GINT_TO_POINTER(proto_id));
+	/*
+	 * In the adaptive mode, first try the dissector which accepted the
+	 * last packet of this conversation it was tried on, so that only the
+	 * first packets of a flow go through the whole list.
+	 */
+	if (prefs.heuristic_adaptive_order) {
+		conversation = find_conversation_pinfo(pinfo, 0);
+		if (conversation != NULL && conversation->heur_list == sub_dissectors &&
+		    conversation->heur_generation == sub_dissectors->generation) {
+			cached_entry = conversation->heur_entry;
+			if (try_heur_dissector_entry(sub_dissectors, cached_entry, tvb, pinfo, tree, data,
+			    saved_can_desegment, saved_layers_len, saved_tree_count)) {
+				sub_dissectors->stats.cache_hits++;
+				*heur_dtbl_entry = cached_entry;
+				status = TRUE;
+			}
 		}
+	}
 
-		pinfo->heur_list_name = hdtbl_entry->list_name;
+	for (entry = sub_dissectors->dissectors; !status && entry != NULL;
+	    entry = g_slist_next(entry)) {
+		hdtbl_entry = (heur_dtbl_entry_t *)entry->data;
+		if (hdtbl_entry == cached_entry)
+			continue;
 
-		len = (hdtbl_entry->dissector)(tvb, pinfo, tree, data);
-		if (hdtbl_entry->protocol != NULL &&
-			(len == 0 || (tree && saved_tree_count == tree->tree_data->count))) {
-			/*
-			 * We added a protocol layer above. The dissector
-			 * didn't accept the packet or it didn't add any
-			 * items to the tree so remove it from the list.
-			 */
-			while (wmem_list_count(pinfo->layers) > saved_layers_len) {
-				if (len == 0) {
-					/*
-					 * Only reduce the layer number if the dissector
-					 * rejected the data. Since tree can be NULL on
-					 * the first pass, we cannot check it or it will
-					 * break dissectors that rely on a stable value.
-					 */
-					pinfo->curr_layer_num--;
-				}
-				wmem_list_remove_frame(pinfo->layers, wmem_list_tail(pinfo->layers));
-			}
-		}
-		if (len) {
+		if (try_heur_dissector_entry(sub_dissectors, hdtbl_entry, tvb, pinfo, tree, data,
+		    saved_can_desegment, saved_layers_len, saved_tree_count)) {
 			*heur_dtbl_entry = hdtbl_entry;
-
-			/* Bubble the matched entry to the top for faster search next time. */
-			if (prev_entry != NULL) {
-				sub_dissectors->dissectors = g_slist_remove_link(sub_dissectors->dissectors, entry);
-				sub_dissectors->dissectors = g_slist_concat(entry, sub_dissectors->dissectors);
+			heur_dissector_list_accepted(sub_dissectors, entry);
+			if (conversation != NULL) {
+				conversation->heur_list = sub_dissectors;
+				conversation->heur_entry = hdtbl_entry;
+				conversation->heur_generation = sub_dissectors->generation;
 			}
 			status = TRUE;
-			break;
 		}
-		prev_entry = entry;
 	}
 
+	if (status)
+		sub_dissectors->stats.accepted++;
+
 	pinfo->current_proto = saved_curr_proto;
 	pinfo->heur_list_name = saved_heur_list_name;
 	pinfo->can_desegment = saved_can_desegment;
 	return status;
 }
 
+void
+heur_dissector_list_get_stats(heur_dissector_list_t sub_dissectors, heur_dissector_list_stats_t *stats)
+{
+	*stats = sub_dissectors->stats;
+}
+
 typedef struct heur_dissector_foreach_info {
 	gpointer      caller_data;
 	DATFunc_heur  caller_func;
@@ -2959,7 +3745,7 @@ dissector_all_heur_tables_foreach_table (DATFunc_heur_table func,
 	info.caller_func = func;
 	if (compare_key_func != NULL)
 	{
-		list = g_hash_table_get_keys(dissector_tables);
+		list = g_hash_table_get_keys(heur_dissector_lists);
 		list = g_list_sort(list, compare_key_func);
 		g_list_foreach(list, dissector_all_heur_tables_foreach_list_func, &info);
 		g_list_free(list);
@@ -3011,10 +3797,15 @@ register_heur_dissector_list(const char *name, const int proto)
 	/* Create and register the dissector table for this name; returns */
 	/* a pointer to the dissector table. */
 	sub_dissectors = g_slice_new(struct heur_dissector_list);
+	sub_dissectors->name = name;
 	sub_dissectors->protocol  = find_protocol_by_id(proto);
 	sub_dissectors->dissectors = NULL;	/* initially empty */
+	sub_dissectors->generation = 0;
+	sub_dissectors->deferred_plugins = FALSE;
+	memset(&sub_dissectors->stats, 0, sizeof(sub_dissectors->stats));
 	g_hash_table_insert(heur_dissector_lists, (gpointer)name,
 			    (gpointer) sub_dissectors);
+	plugin_manifest_note(PLUGIN_MANIFEST_HEURISTIC, name);
 	return sub_dissectors;
 }
 
@@ -3083,13 +3874,17 @@ get_dissector_names(void)
 dissector_handle_t
 find_dissector(const char *name)
 {
-	return (dissector_handle_t)g_hash_table_lookup(registered_dissectors, name);
+	dissector_handle_t handle = (dissector_handle_t)g_hash_table_lookup(registered_dissectors, name);
+
+	if (!handle && plugin_manifest_load(PLUGIN_MANIFEST_DISSECTOR, name))
+		handle = (dissector_handle_t)g_hash_table_lookup(registered_dissectors, name);
+	return handle;
 }
 
 /** Find a dissector by name and add parent protocol as a depedency*/
 dissector_handle_t find_dissector_add_dependency(const char *name, const int parent_proto)
 {
-	dissector_handle_t handle = (dissector_handle_t)g_hash_table_lookup(registered_dissectors, name);
+	dissector_handle_t handle = find_dissector(name);
 	if ((handle != NULL) && (parent_proto > 0))
 	{
 		register_depend_dissector(proto_get_protocol_short_name(find_protocol_by_id(parent_proto)), dissector_handle_get_short_name(handle));
@@ -3119,6 +3914,7 @@ new_dissector_handle(enum dissector_e type, void *dissector, const int proto, co
 	handle->dissector_func	= dissector;
 	handle->dissector_data	= cb_data;
 	handle->protocol	= find_protocol_by_id(proto);
+	handle->stateless	= FALSE;
 	return handle;
 }
 
@@ -3154,6 +3950,7 @@ register_dissector_handle(const char *name, dissector_handle_t handle)
 	g_assert(g_hash_table_lookup(registered_dissectors, name) == NULL);
 
 	g_hash_table_insert(registered_dissectors, (gpointer)name, handle);
+	plugin_manifest_note(PLUGIN_MANIFEST_DISSECTOR, name);
 
 	return handle;
 }
@@ -3169,6 +3966,24 @@ register_dissector(const char *name, dissector_t dissector, const int proto)
 	return register_dissector_handle(name, handle);
 }
 
+/* Register a new dissector by name, as one that keeps no state. */
+dissector_handle_t
+register_dissector_stateless(const char *name, dissector_t dissector, const int proto)
+{
+	struct dissector_handle *handle;
+
+	handle = new_dissector_handle(DISSECTOR_TYPE_SIMPLE, dissector, proto, name, NULL);
+	handle->stateless = TRUE;
+
+	return register_dissector_handle(name, handle);
+}
+
+gboolean
+dissector_handle_is_stateless(const dissector_handle_t handle)
+{
+	return handle != NULL && handle->stateless;
+}
+
 dissector_handle_t
 register_dissector_with_data(const char *name, dissector_cb_t dissector, const int proto, void *cb_data)
 {
@@ -3188,6 +4003,7 @@ remove_depend_dissector_from_list(depend_dissector_list_t sub_dissectors, const
 		dependent, (GCompareFunc)strcmp);
 
 	if (found_entry) {
+		g_hash_table_remove(sub_dissectors->dissector_set, found_entry->data);
 		g_free(found_entry->data);
 		sub_dissectors->dissectors = g_slist_delete_link(sub_dissectors->dissectors, found_entry);
 		return TRUE;
@@ -3216,6 +4032,8 @@ deregister_dissector(const char *name)
 	g_hash_table_remove(depend_dissector_lists, name);
 	g_hash_table_foreach(depend_dissector_lists, remove_depend_dissector_ghfunc, (gpointer)name);
 	g_hash_table_remove(heur_dissector_lists, name);
+	if (dissector_state_checks)
+		g_hash_table_remove(dissector_state_checks, handle);
 
 	destroy_dissector_handle(handle);
 }
@@ -3318,7 +4136,7 @@ void call_heur_dissector_direct(heur_dtbl_entry_t *heur_dtbl_entry, tvbuff_t *tv
 	pinfo->heur_list_name = heur_dtbl_entry->list_name;
 
 	/* call the dissector, in case of failure call data handle (might happen with exported PDUs) */
-	if (!(*heur_dtbl_entry->dissector)(tvb, pinfo, tree, data)) {
+	if (!call_heur_dissector_func(heur_dtbl_entry, tvb, pinfo, tree, data)) {
 		call_dissector_work(data_handle, tvb, pinfo, tree, TRUE, NULL);
 
 		/*
@@ -3339,19 +4157,10 @@ void call_heur_dissector_direct(heur_dtbl_entry_t *heur_dtbl_entry, tvbuff_t *tv
 
 }
 
-static gint
-find_matching_proto_name(gconstpointer arg1, gconstpointer arg2)
-{
-	const char    *protocol_name = (const char*)arg1;
-	const gchar   *name   = (const gchar *)arg2;
-
-	return strcmp(protocol_name, name);
-}
-
 gboolean register_depend_dissector(const char* parent, const char* dependent)
 {
-	GSList                *list_entry;
 	depend_dissector_list_t sub_dissectors;
+	char                   *name;
 
 	if ((parent == NULL) || (dependent == NULL))
 	{
@@ -3364,15 +4173,17 @@ gboolean register_depend_dissector(const char* parent, const char* dependent)
 		/* parent protocol doesn't exist, create it */
 		sub_dissectors = g_slice_new(struct depend_dissector_list);
 		sub_dissectors->dissectors = NULL;	/* initially empty */
+		sub_dissectors->dissector_set = g_hash_table_new(g_str_hash, g_str_equal);
 		g_hash_table_insert(depend_dissector_lists, (gpointer)g_strdup(parent), (gpointer) sub_dissectors);
 	}
 
 	/* Verify that sub-dissector is not already in the list */
-	list_entry = g_slist_find_custom(sub_dissectors->dissectors, (gpointer)dependent, find_matching_proto_name);
-	if (list_entry != NULL)
+	if (g_hash_table_contains(sub_dissectors->dissector_set, dependent))
 		return TRUE; /* Dependency already exists */
 
-	sub_dissectors->dissectors = g_slist_prepend(sub_dissectors->dissectors, (gpointer)g_strdup(dependent));
+	name = g_strdup(dependent);
+	g_hash_table_add(sub_dissectors->dissector_set, name);
+	sub_dissectors->dissectors = g_slist_prepend(sub_dissectors->dissectors, (gpointer)name);
 	return TRUE;
 }
 
@@ -3537,6 +4348,9 @@ register_postdissector(dissector_handle_t handle)
 {
 	postdissector p;
 
+	/* Post-dissectors are called for every packet, never looked up. */
+	plugin_manifest_keep_loaded();
+
 	if (!postdissectors)
 		postdissectors = g_array_sized_new(FALSE, FALSE, (guint)sizeof(postdissector), 1);
 
@@ -50,6 +50,9 @@ struct epan_range;
 extern void packet_init(void);
 extern void packet_cache_proto_handles(void);
 extern void packet_cleanup(void);
+extern void packet_register_late(void (*register_func)(gpointer), gpointer data);
+extern void dissector_table_defer_plugins(const char *name);
+extern void heur_dissector_list_defer_plugins(const char *name);
 
 /* Handle for dissectors you call directly or register with "dissector_add_uint()".
    This handle is opaque outside of "packet.c". */
@@ -440,8 +443,19 @@ typedef struct heur_dtbl_entry {
 	const gchar *display_name;     /* the string used to present heuristic to user */
 	gchar *short_name;     /* string used for "internal" use to uniquely identify heuristic */
 	gboolean enabled;
+	guint64 tries;         /* times dissector_try_heuristic() called it */
+	guint64 accepted;      /* times it accepted the packet */
+	guint score;           /* recent acceptances, for the adaptive order */
 } heur_dtbl_entry_t;
 
+/** Statistics of the calls of dissector_try_heuristic() on a list. */
+typedef struct {
+	guint64 calls;         /**< Calls of dissector_try_heuristic() */
+	guint64 tries;         /**< Heuristic dissectors called by these */
+	guint64 accepted;      /**< Calls in which one accepted the packet */
+	guint64 cache_hits;    /**< Calls in which the one remembered for the conversation accepted it */
+} heur_dissector_list_stats_t;
+
 /** A protocol uses this function to register a heuristic sub-dissector list.
  *  Call this in the parent dissectors proto_register function.
  *
@@ -496,6 +510,14 @@ WS_DLL_PUBLIC gboolean has_heur_dissector_list(const gchar *name);
 WS_DLL_PUBLIC gboolean dissector_try_heuristic(heur_dissector_list_t sub_dissectors,
     tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, heur_dtbl_entry_t **hdtbl_entry, void *data);
 
+/** Get the statistics of the calls of dissector_try_heuristic() on a list.
+ *
+ * @param sub_dissectors the sub-dissector list
+ * @param[out] stats the statistics
+ */
+WS_DLL_PUBLIC void heur_dissector_list_get_stats(heur_dissector_list_t sub_dissectors,
+    heur_dissector_list_stats_t *stats);
+
 /** Find a heuristic dissector table by table name.
  *
  * @param name name of the dissector table
@@ -535,6 +557,17 @@ WS_DLL_PUBLIC void heur_dissector_delete(const char *name, heur_dissector_t diss
 /** Register a new dissector. */
 WS_DLL_PUBLIC dissector_handle_t register_dissector(const char *name, dissector_t dissector, const int proto);
 
+/** Register a new dissector by name, as one that keeps no state from one
+ * packet to the next: it creates no conversations and adds no data to them,
+ * adds no file scope data to frames and reassembles nothing, so that how it
+ * dissects a packet doesn't depend on the packets dissected before.  The
+ * dissectors it calls needn't be stateless.  dissector_state_checking_enable()
+ * checks that the dissectors registered this way are. */
+WS_DLL_PUBLIC dissector_handle_t register_dissector_stateless(const char *name, dissector_t dissector, const int proto);
+
+/** TRUE if the dissector was registered with register_dissector_stateless(). */
+WS_DLL_PUBLIC gboolean dissector_handle_is_stateless(const dissector_handle_t handle);
+
 /** Register a new dissector with a callback pointer. */
 WS_DLL_PUBLIC dissector_handle_t register_dissector_with_data(const char *name, dissector_cb_t dissector, const int proto, void *cb_data);
 
@@ -615,6 +648,92 @@ WS_DLL_PUBLIC int call_dissector_only(dissector_handle_t handle, tvbuff_t *tvb,
 WS_DLL_PUBLIC void call_heur_dissector_direct(heur_dtbl_entry_t *heur_dtbl_entry, tvbuff_t *tvb,
     packet_info *pinfo, proto_tree *tree, void *data);
 
+/** Statistics of the calls of a dissector, collected while
+ * dissector_profiling_enable() is on. Times are in microseconds. */
+typedef struct {
+	gchar *name;		/**< Dissector name, or heuristic dissector short name */
+	const char *protocol;	/**< Short name of its protocol, or NULL */
+	gboolean heuristic;	/**< TRUE for a heuristic dissector */
+	guint64 calls;
+	guint64 accepted;	/**< Calls that returned a non-zero length */
+	guint64 exceptions;	/**< Calls ended by an exception */
+	guint64 bytes;		/**< Captured bytes of the tvbuffs passed to it */
+	gint64 total_time;	/**< Time in it, including the dissectors it called */
+	gint64 self_time;	/**< Time in it, excluding the dissectors it called */
+} dissector_profile_t;
+
+/** Turn the profiling of the calls of each dissector and heuristic
+ * dissector on or off. Turning it off keeps the statistics. */
+WS_DLL_PUBLIC void dissector_profiling_enable(const gboolean enable);
+
+WS_DLL_PUBLIC gboolean dissector_profiling_enabled(void);
+
+/** Forget the statistics collected so far. Must not be called while
+ * dissecting. */
+WS_DLL_PUBLIC void dissector_profiling_reset(void);
+
+/** Get the dissector_profile_t of the dissectors called since profiling
+ * was enabled or reset, by decreasing self time. The profiles are only
+ * valid until the next reset; free the array with g_ptr_array_free(). */
+WS_DLL_PUBLIC GPtrArray *dissector_profiling_get(void);
+
+/** The file scope memory allocated by the dissectors of a protocol,
+ * counted while dissector_memory_accounting_enable() is on; see
+ * wmem_accounting_enable() for what the byte counts include. */
+typedef struct {
+	int proto_id;		/**< Protocol id, or -1 for memory allocated outside any dissector */
+	const char *protocol;	/**< Short name of the protocol, or NULL */
+	guint64 allocs;		/**< Allocations and reallocations */
+	guint64 bytes;		/**< Bytes asked for */
+} dissector_memory_t;
+
+/** Turn the accounting of the file scope memory allocated by each protocol
+ * on or off. The counts start again with each file; turning accounting off
+ * discards them. */
+WS_DLL_PUBLIC void dissector_memory_accounting_enable(const gboolean enable);
+
+WS_DLL_PUBLIC gboolean dissector_memory_accounting_enabled(void);
+
+/** Get the dissector_memory_t of the protocols that allocated file scope
+ * memory in the current file, by decreasing number of bytes; free the array
+ * with g_ptr_array_free(), which frees its elements. */
+WS_DLL_PUBLIC GPtrArray *dissector_memory_accounting_get(void);
+
+/** What the dissectors registered with register_dissector_stateless() did
+ * while dissector_state_checking_enable() was on. */
+typedef struct {
+	gchar *name;		/**< Dissector name */
+	const char *protocol;	/**< Short name of its protocol, or NULL */
+	guint64 calls;
+	guint64 writes;		/**< State written by the dissector itself */
+	guint32 first_frame;	/**< Frame of the first write */
+	const char *first_write; /**< What the first write was, such as "conversation_new" */
+} dissector_state_check_t;
+
+/** Turn the checking of the stateless dissectors on or off. While it is
+ * on, every write of state that a stateless dissector makes is counted
+ * against it. Turning it off keeps the counts. */
+WS_DLL_PUBLIC void dissector_state_checking_enable(const gboolean enable);
+
+WS_DLL_PUBLIC gboolean dissector_state_checking_enabled(void);
+
+/** Forget the counts collected so far. Must not be called while
+ * dissecting. */
+WS_DLL_PUBLIC void dissector_state_checking_reset(void);
+
+/** Get the dissector_state_check_t of the stateless dissectors called since
+ * checking was enabled or reset, those with the most writes first. They
+ * are only valid until the next reset; free the array with
+ * g_ptr_array_free(). */
+WS_DLL_PUBLIC GPtrArray *dissector_state_checking_get(void);
+
+/** Note that state outliving the packet is being written, for the checking
+ * of the stateless dissectors; what names the kind of write, and must be a
+ * constant string. Called by the conversation, per-frame data and
+ * reassembly functions, and by any other code that keeps state for
+ * dissectors. */
+WS_DLL_PUBLIC void dissector_state_write(const char *what);
+
 /* This is opaque outside of "packet.c". */
 struct depend_dissector_list;
 typedef struct depend_dissector_list *depend_dissector_list_t;
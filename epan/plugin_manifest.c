@@ -0,0 +1,482 @@
+/* plugin_manifest.c
+ * Cache of what each dissector plugin registers, so that plugins can be
+ * loaded when they're first needed rather than at startup
+ *
+ * Opening every plugin and running its registration routines takes a good
+ * part of the start-up time.  The first time a plugin is seen, it's loaded
+ * at startup as before, and the protocols, dissector tables, heuristic
+ * lists and named dissectors it registers or adds to are recorded in a
+ * file in the user's cache directory.  As long as the plugin file doesn't
+ * change, later runs don't load it until one of those is used: a display
+ * filter field of one of its protocols, a lookup in one of its tables or
+ * heuristic lists, or a search for one of its dissectors.
+ *
+ * Plugins that register preferences, post-dissectors, taps or anything
+ * that isn't a dissector are always loaded at startup; their preferences
+ * are read, and they're run, before anything would look them up.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <wsutil/file_util.h>
+
+#include "proto.h"
+#include "packet.h"
+#include "disabled_protos.h"
+#include "plugin_manifest.h"
+
+#define MANIFEST_GROUP		"manifest"
+
+static const char *item_keys[PLUGIN_MANIFEST_NUM_ITEMS] = {
+	"protocols", "tables", "heuristics", "dissectors"
+};
+
+typedef struct {
+	gchar		*name;		/* the file name, which plugins_load() takes */
+	gchar		*filename;	/* the path, and the group in the cache */
+	gint64		size;
+	gint64		mtime;
+	gchar		*version;
+	gboolean	keep_loaded;	/* can't be deferred */
+	GPtrArray	*items[PLUGIN_MANIFEST_NUM_ITEMS];	/* of gchar * */
+	gboolean	seen;		/* found in this run */
+	gboolean	deferred;	/* not loaded yet */
+	gboolean	loading_late;	/* being loaded by plugin_manifest_load() */
+	const proto_plugin *plug;	/* what it passed to proto_register_plugin() */
+} manifest_entry_t;
+
+/* filename -> manifest_entry_t */
+static GHashTable *manifest_entries = NULL;
+/* For each kind of item, item -> GSList of the deferred entries with it */
+static GHashTable *deferred_items[PLUGIN_MANIFEST_NUM_ITEMS];
+/* The plugin whose registration is being recorded */
+static manifest_entry_t *recording = NULL;
+static gboolean manifest_changed = FALSE;
+static gboolean manifest_load_at_startup = FALSE;
+static plugins_t *manifest_plugins = NULL;
+
+static void
+manifest_entry_free(gpointer data)
+{
+	manifest_entry_t *entry = (manifest_entry_t *)data;
+	int i;
+
+	g_free(entry->name);
+	g_free(entry->filename);
+	g_free(entry->version);
+	for (i = 0; i < PLUGIN_MANIFEST_NUM_ITEMS; i++)
+		g_ptr_array_free(entry->items[i], TRUE);
+	g_free(entry);
+}
+
+static manifest_entry_t *
+manifest_entry_new(const char *filename)
+{
+	manifest_entry_t *entry;
+	int i;
+
+	entry = g_new0(manifest_entry_t, 1);
+	entry->filename = g_strdup(filename);
+	for (i = 0; i < PLUGIN_MANIFEST_NUM_ITEMS; i++)
+		entry->items[i] = g_ptr_array_new_with_free_func(g_free);
+	g_hash_table_replace(manifest_entries, entry->filename, entry);
+	return entry;
+}
+
+static gchar *
+manifest_path(void)
+{
+	return g_build_filename(g_get_user_cache_dir(), "wireshark",
+	    "plugin-manifest.cache", NULL);
+}
+
+void
+plugin_manifest_init(void)
+{
+	gchar *path;
+	GKeyFile *kf;
+	gchar **groups, **items;
+	gchar *version;
+	manifest_entry_t *entry;
+	gsize i, j;
+	int k;
+
+	manifest_entries = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, manifest_entry_free);
+	for (k = 0; k < PLUGIN_MANIFEST_NUM_ITEMS; k++)
+		deferred_items[k] = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)g_slist_free);
+	manifest_load_at_startup = (getenv("WIRESHARK_LOAD_PLUGINS_AT_STARTUP") != NULL);
+
+	path = manifest_path();
+	kf = g_key_file_new();
+	if (!g_key_file_load_from_file(kf, path, G_KEY_FILE_NONE, NULL)) {
+		g_key_file_free(kf);
+		g_free(path);
+		return;
+	}
+	g_free(path);
+
+	/* Plugins are only good for the version they were built for. */
+	version = g_key_file_get_string(kf, MANIFEST_GROUP, "version", NULL);
+	if (g_strcmp0(version, VERSION) != 0) {
+		g_free(version);
+		g_key_file_free(kf);
+		return;
+	}
+	g_free(version);
+
+	groups = g_key_file_get_groups(kf, NULL);
+	for (i = 0; groups[i] != NULL; i++) {
+		if (strcmp(groups[i], MANIFEST_GROUP) == 0)
+			continue;
+		entry = manifest_entry_new(groups[i]);
+		entry->size = g_key_file_get_int64(kf, groups[i], "size", NULL);
+		entry->mtime = g_key_file_get_int64(kf, groups[i], "mtime", NULL);
+		entry->version = g_key_file_get_string(kf, groups[i], "version", NULL);
+		entry->keep_loaded = g_key_file_get_boolean(kf, groups[i], "keep_loaded", NULL);
+		for (k = 0; k < PLUGIN_MANIFEST_NUM_ITEMS; k++) {
+			items = g_key_file_get_string_list(kf, groups[i], item_keys[k], NULL, NULL);
+			for (j = 0; items != NULL && items[j] != NULL; j++)
+				g_ptr_array_add(entry->items[k], g_strdup(items[j]));
+			g_strfreev(items);
+		}
+	}
+	g_strfreev(groups);
+	g_key_file_free(kf);
+}
+
+static void
+manifest_save(void)
+{
+	GKeyFile *kf;
+	GHashTableIter iter;
+	gpointer value;
+	manifest_entry_t *entry;
+	gchar *data, *path, *dir;
+	gsize len;
+	int k;
+
+	kf = g_key_file_new();
+	g_key_file_set_string(kf, MANIFEST_GROUP, "version", VERSION);
+	g_hash_table_iter_init(&iter, manifest_entries);
+	while (g_hash_table_iter_next(&iter, NULL, &value)) {
+		entry = (manifest_entry_t *)value;
+		if (!entry->seen)
+			continue;
+		g_key_file_set_int64(kf, entry->filename, "size", entry->size);
+		g_key_file_set_int64(kf, entry->filename, "mtime", entry->mtime);
+		if (entry->version)
+			g_key_file_set_string(kf, entry->filename, "version", entry->version);
+		g_key_file_set_boolean(kf, entry->filename, "keep_loaded", entry->keep_loaded);
+		for (k = 0; k < PLUGIN_MANIFEST_NUM_ITEMS; k++) {
+			if (entry->items[k]->len == 0)
+				continue;
+			g_key_file_set_string_list(kf, entry->filename, item_keys[k],
+			    (const gchar * const *)entry->items[k]->pdata, entry->items[k]->len);
+		}
+	}
+	data = g_key_file_to_data(kf, &len, NULL);
+	g_key_file_free(kf);
+
+	/* It's only a cache; if it can't be written, the plugins are
+	   loaded at startup again next time. */
+	path = manifest_path();
+	dir = g_path_get_dirname(path);
+	if (g_mkdir_with_parents(dir, 0755) == 0)
+		g_file_set_contents(path, data, len, NULL);
+	g_free(dir);
+	g_free(path);
+	g_free(data);
+}
+
+static gboolean
+manifest_entry_can_defer(const manifest_entry_t *entry)
+{
+	int k;
+
+	if (manifest_load_at_startup || entry->keep_loaded || entry->version == NULL)
+		return FALSE;
+	/* It must be possible to look it up by something. */
+	for (k = 0; k < PLUGIN_MANIFEST_NUM_ITEMS; k++) {
+		if (entry->items[k]->len > 0)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+const char *
+plugin_manifest_defer(const char *name, const char *filename, void *user_data _U_)
+{
+	manifest_entry_t *entry;
+	ws_statb64 st;
+	guint i;
+	int k;
+	GSList *entries;
+
+	if (manifest_entries == NULL || ws_stat64(filename, &st) != 0) {
+		/* Loading it will report what's wrong with it. */
+		recording = NULL;
+		return NULL;
+	}
+
+	entry = (manifest_entry_t *)g_hash_table_lookup(manifest_entries, filename);
+	if (entry != NULL && entry->size == (gint64)st.st_size &&
+	    entry->mtime == (gint64)st.st_mtime) {
+		entry->seen = TRUE;
+		if (manifest_entry_can_defer(entry)) {
+			g_free(entry->name);
+			entry->name = g_strdup(name);
+			entry->deferred = TRUE;
+			for (k = 0; k < PLUGIN_MANIFEST_NUM_ITEMS; k++) {
+				for (i = 0; i < entry->items[k]->len; i++) {
+					gchar *item = (gchar *)g_ptr_array_index(entry->items[k], i);
+					entries = (GSList *)g_hash_table_lookup(deferred_items[k], item);
+					g_hash_table_steal(deferred_items[k], item);
+					g_hash_table_insert(deferred_items[k], item, g_slist_prepend(entries, entry));
+				}
+			}
+			recording = NULL;
+			return entry->version;
+		}
+		/* Up to date, but it has to be loaded now. */
+	} else {
+		entry = manifest_entry_new(filename);
+		entry->size = (gint64)st.st_size;
+		entry->mtime = (gint64)st.st_mtime;
+		entry->seen = TRUE;
+		manifest_changed = TRUE;
+	}
+	g_free(entry->name);
+	entry->name = g_strdup(name);
+
+	/* plugins_init_deferred() calls its registration function next. */
+	recording = entry;
+	return NULL;
+}
+
+gboolean
+plugin_manifest_note_plugin(const void *plug)
+{
+	if (recording == NULL)
+		return FALSE;
+	recording->plug = (const proto_plugin *)plug;
+	return recording->loading_late;
+}
+
+void
+plugin_manifest_keep_loaded(void)
+{
+	if (recording == NULL || recording->keep_loaded)
+		return;
+	recording->keep_loaded = TRUE;
+	manifest_changed = TRUE;
+}
+
+void
+plugin_manifest_begin(const void *plug)
+{
+	GHashTableIter iter;
+	gpointer value;
+
+	recording = NULL;
+	if (manifest_entries == NULL)
+		return;
+	g_hash_table_iter_init(&iter, manifest_entries);
+	while (g_hash_table_iter_next(&iter, NULL, &value)) {
+		if (((manifest_entry_t *)value)->plug == plug) {
+			recording = (manifest_entry_t *)value;
+			return;
+		}
+	}
+}
+
+void
+plugin_manifest_end(void)
+{
+	recording = NULL;
+}
+
+void
+plugin_manifest_note(plugin_manifest_item_e item, const char *name)
+{
+	GPtrArray *items;
+	gchar *prefix;
+	guint i;
+
+	if (recording == NULL || recording->loading_late || name == NULL)
+		return;
+
+	/* Display filter fields are looked up by the part of their
+	   name before the first dot; see proto_register_prefix(). */
+	if (item == PLUGIN_MANIFEST_PROTOCOL)
+		prefix = g_strndup(name, strcspn(name, "."));
+	else
+		prefix = g_strdup(name);
+
+	/* An up-to-date plugin that's loaded at startup records what it
+	   already has, which changes nothing. */
+	items = recording->items[item];
+	for (i = 0; i < items->len; i++) {
+		if (strcmp((const gchar *)g_ptr_array_index(items, i), prefix) == 0) {
+			g_free(prefix);
+			return;
+		}
+	}
+	g_ptr_array_add(items, prefix);
+	manifest_changed = TRUE;
+}
+
+static void
+manifest_load_protocol(const char *match)
+{
+	gchar *prefix = g_strndup(match, strcspn(match, "."));
+
+	plugin_manifest_load(PLUGIN_MANIFEST_PROTOCOL, prefix);
+	g_free(prefix);
+}
+
+static void
+manifest_version_cb(const char *name _U_, const char *version,
+    const char *types _U_, const char *filename, void *user_data _U_)
+{
+	manifest_entry_t *entry;
+
+	entry = (manifest_entry_t *)g_hash_table_lookup(manifest_entries, filename);
+	if (entry != NULL && !entry->deferred && g_strcmp0(entry->version, version) != 0) {
+		g_free(entry->version);
+		entry->version = g_strdup(version);
+		manifest_changed = TRUE;
+	}
+}
+
+void
+plugin_manifest_register_deferred(plugins_t *plugins)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+
+	recording = NULL;
+	manifest_plugins = plugins;
+	if (manifest_entries == NULL)
+		return;
+
+	/* Plugins that are gone are dropped from the cache. */
+	g_hash_table_iter_init(&iter, manifest_entries);
+	while (g_hash_table_iter_next(&iter, NULL, &value)) {
+		if (!((manifest_entry_t *)value)->seen)
+			manifest_changed = TRUE;
+	}
+
+	/* The versions of the plugins loaded now, to list the plugins with
+	   when they're deferred. */
+	plugins_get_descriptions(manifest_version_cb, NULL);
+
+	g_hash_table_iter_init(&iter, deferred_items[PLUGIN_MANIFEST_PROTOCOL]);
+	while (g_hash_table_iter_next(&iter, &key, NULL))
+		proto_register_prefix((const char *)key, manifest_load_protocol);
+	g_hash_table_iter_init(&iter, deferred_items[PLUGIN_MANIFEST_TABLE]);
+	while (g_hash_table_iter_next(&iter, &key, NULL))
+		dissector_table_defer_plugins((const char *)key);
+	g_hash_table_iter_init(&iter, deferred_items[PLUGIN_MANIFEST_HEURISTIC]);
+	while (g_hash_table_iter_next(&iter, &key, NULL))
+		heur_dissector_list_defer_plugins((const char *)key);
+
+	if (manifest_changed) {
+		manifest_save();
+		manifest_changed = FALSE;
+	}
+}
+
+static void
+manifest_entry_register(gpointer data)
+{
+	manifest_entry_t *entry = (manifest_entry_t *)data;
+	manifest_entry_t *saved_recording = recording;
+
+	/* Loading it may look up, and so load, another deferred plugin. */
+	recording = entry;
+	entry->loading_late = TRUE;
+	if (plugins_load(manifest_plugins, entry->name) && entry->plug != NULL) {
+		if (entry->plug->register_protoinfo)
+			entry->plug->register_protoinfo();
+		if (entry->plug->register_handoff)
+			entry->plug->register_handoff();
+	}
+	entry->loading_late = FALSE;
+	recording = saved_recording;
+}
+
+gboolean
+plugin_manifest_load(plugin_manifest_item_e item, const char *name)
+{
+	GSList *entries, *l;
+	manifest_entry_t *entry;
+	gboolean loaded = FALSE;
+
+	if (deferred_items[item] == NULL || manifest_plugins == NULL)
+		return FALSE;
+
+	entries = (GSList *)g_hash_table_lookup(deferred_items[item], name);
+	if (entries == NULL)
+		return FALSE;
+	g_hash_table_steal(deferred_items[item], name);
+
+	for (l = entries; l != NULL; l = l->next) {
+		entry = (manifest_entry_t *)l->data;
+		if (!entry->deferred)
+			continue;
+		entry->deferred = FALSE;
+		packet_register_late(manifest_entry_register, entry);
+		loaded = TRUE;
+	}
+	g_slist_free(entries);
+
+	/* The protocols and heuristics that have just been registered are
+	   enabled or disabled as the user said. */
+	if (loaded)
+		apply_enabled_and_disabled_lists();
+	return loaded;
+}
+
+void
+plugin_manifest_cleanup(void)
+{
+	int k;
+
+	for (k = 0; k < PLUGIN_MANIFEST_NUM_ITEMS; k++) {
+		if (deferred_items[k] != NULL) {
+			g_hash_table_destroy(deferred_items[k]);
+			deferred_items[k] = NULL;
+		}
+	}
+	if (manifest_entries != NULL) {
+		g_hash_table_destroy(manifest_entries);
+		manifest_entries = NULL;
+	}
+	recording = NULL;
+	manifest_plugins = NULL;
+	manifest_changed = FALSE;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
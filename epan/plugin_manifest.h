@@ -0,0 +1,83 @@
+/* plugin_manifest.h
+ * Cache of what each dissector plugin registers, so that plugins can be
+ * loaded when they're first needed rather than at startup
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __PLUGIN_MANIFEST_H__
+#define __PLUGIN_MANIFEST_H__
+
+#include <glib.h>
+
+#include <wsutil/plugins.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* What a plugin is looked up by, and so loaded by, once it's deferred */
+typedef enum {
+	PLUGIN_MANIFEST_PROTOCOL,	/* a protocol's filter name, up to the first dot */
+	PLUGIN_MANIFEST_TABLE,		/* a dissector table it registers or adds to */
+	PLUGIN_MANIFEST_HEURISTIC,	/* a heuristic list it registers or adds to */
+	PLUGIN_MANIFEST_DISSECTOR,	/* a dissector it registers by name */
+	PLUGIN_MANIFEST_NUM_ITEMS
+} plugin_manifest_item_e;
+
+/* Read the cache; before plugins_init_deferred(). */
+extern void plugin_manifest_init(void);
+
+/* The plugin_defer_callback for plugins_init_deferred(). */
+extern const char *plugin_manifest_defer(const char *name, const char *filename,
+    void *user_data);
+
+/*
+ * Called by proto_register_plugin().  Returns TRUE if the plugin is being
+ * loaded late, in which case it's registered right away rather than by
+ * proto_init().
+ */
+extern gboolean plugin_manifest_note_plugin(const void *plug);
+
+/* The plugin registering now can't be deferred (it registers preferences,
+ * a post-dissector, or something that isn't a dissector). */
+extern void plugin_manifest_keep_loaded(void);
+
+/* Record what a dissector plugin's registration routines register. */
+extern void plugin_manifest_begin(const void *plug);
+extern void plugin_manifest_end(void);
+extern void plugin_manifest_note(plugin_manifest_item_e item, const char *name);
+
+/*
+ * After proto_init(): set up the loading of the deferred plugins on first
+ * use, and write the cache if it has changed.
+ */
+extern void plugin_manifest_register_deferred(plugins_t *plugins);
+
+/* Load the deferred plugins that provide "name"; TRUE if any was loaded. */
+extern gboolean plugin_manifest_load(plugin_manifest_item_e item, const char *name);
+
+extern void plugin_manifest_cleanup(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __PLUGIN_MANIFEST_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -143,6 +143,9 @@ WS_DLL_PUBLIC guint32 prefs_get_max_value(pref_t *pref);
 #define PREF_EFFECT_FONT              (1u << 3)
 #define PREF_EFFECT_GUI_LAYOUT        (1u << 4)
 #define PREF_EFFECT_FIELDS            (1u << 5)
+/* Changes only how each packet is shown, not the state dissectors keep
+ * across frames, so the packets needn't be dissected again from the first */
+#define PREF_EFFECT_DISPLAY           (1u << 6)
 #define PREF_EFFECT_CUSTOM            (1u << 31)
 
 /** Fetch flags that show the effect of the preference
@@ -36,6 +36,7 @@
 
 #include <epan/prefs-int.h>
 #include <epan/uat-int.h>
+#include <epan/plugin_manifest.h>
 
 #include "epan/filter_expressions.h"
 
@@ -979,6 +980,10 @@ register_preference(module_t *module, const char *name, const char *title,
     const gchar *p;
     const char *name_prefix = (module->name != NULL) ? module->name : module->parent->name;
 
+    /* The preferences files are read once, after the dissectors are
+       registered, so a plugin with preferences has to be loaded then. */
+    plugin_manifest_keep_loaded();
+
     preference = g_new(pref_t,1);
     preference->name = name;
     preference->title = title;
@@ -1985,6 +1990,15 @@ prefs_set_preference_effect_fields(module_t *module, const char *name)
     }
 }
 
+void
+prefs_set_preference_effect_display(module_t *module, const char *name)
+{
+    pref_t * pref = prefs_find_preference(module, name);
+    if (pref) {
+        prefs_set_effect_flags(pref, (prefs_get_effect_flags(pref) & ~PREF_EFFECT_DISSECTION) | PREF_EFFECT_DISPLAY);
+    }
+}
+
 /*
  * Check to see if a preference is obsolete.
  */
@@ -3392,7 +3406,80 @@ prefs_register_modules(void)
                                    "The maximum depth of the dissection tree (Increase with caution)",
                                    10,
                                    &prefs.gui_max_tree_depth);
-
+#ifndef _WIN32
+    prefs_register_uint_preference(gui_module, "filter_workers",
+                                   "Display filter worker processes",
+                                   "The number of worker processes used to apply a new display filter to a "
+                                   "capture file that has been completely read (1 applies it in the main process)",
+                                   10,
+                                   &prefs.gui_filter_workers);
+#endif
+    prefs_register_bool_preference(gui_module, "dissection_index",
+                                   "Keep a dissection index for capture files",
+                                   "Save the results of reading a capture file in an index file next to it, "
+                                   "and use that to open the file again without reading it all; packets "
+                                   "are then dissected when they are first needed",
+                                   &prefs.gui_dissection_index);
+    prefs_register_bool_preference(gui_module, "protocol_index",
+                                   "Skip packets without the protocols a display filter needs",
+                                   "Remember which protocols were dissected in each packet, and when a new "
+                                   "display filter is applied, don't dissect packets that lack a protocol "
+                                   "the filter requires",
+                                   &prefs.gui_protocol_index);
+    prefs_register_string_preference(gui_module, "field_store",
+                                     "Fields to keep the values of for statistics",
+                                     "The names of integer fields, separated by commas, whose values are kept "
+                                     "for each packet when a capture file is read, so that statistics and "
+                                     "graphs of them can be computed again without dissecting the packets",
+                                     (const char **)&prefs.gui_field_store);
+    prefs_register_bool_preference(gui_module, "expert_info_first_pass",
+                                   "Keep expert information as capture files are read",
+                                   "Keep the expert information items added when each packet is first "
+                                   "dissected, so that the Expert Information dialog can show them "
+                                   "without dissecting all the packets again",
+                                   &prefs.gui_expert_info_first_pass);
+    prefs_register_bool_preference(gui_module, "traffic_tables_first_pass",
+                                   "Keep conversation and endpoint tables as capture files are read",
+                                   "Add each packet to the conversation and endpoint tables when it is "
+                                   "first dissected, so that the Conversations and Endpoints dialogs can "
+                                   "show them without dissecting all the packets again",
+                                   &prefs.gui_traffic_tables_first_pass);
+    prefs_register_bool_preference(gui_module, "proto_hier_first_pass",
+                                   "Keep protocol hierarchy statistics as capture files are read",
+                                   "Record the protocols in each packet when it is first dissected, "
+                                   "so that the Protocol Hierarchy dialog can show them for any "
+                                   "display filter without dissecting all the packets again",
+                                   &prefs.gui_proto_hier_first_pass);
+    prefs_register_uint_preference(gui_module, "packet_list_cache_size",
+                                   "Packet list column text cache size (MB)",
+                                   "The most memory, in megabytes, used to keep the column text of the "
+                                   "packet list's rows, so that they needn't be dissected again when "
+                                   "they are shown; the text of the rows least recently shown is "
+                                   "dropped beyond it (0 means no limit)",
+                                   10,
+                                   &prefs.gui_packet_list_cache_size);
+    prefs_register_uint_preference(gui_module, "record_cache_size",
+                                   "Packet record cache size (MB)",
+                                   "The most memory, in megabytes, used to keep the records of the packets "
+                                   "read most recently, so that showing their bytes or details again needn't "
+                                   "read them from the capture file, which for a compressed file means "
+                                   "decompressing it again (0 disables the cache)",
+                                   10,
+                                   &prefs.gui_record_cache_size);
+    prefs_register_uint_preference(gui_module, "tree_cache_size",
+                                   "Packet tree cache size",
+                                   "The number of packets, other than the selected one, whose details are "
+                                   "kept after they were last selected, so that selecting one of them "
+                                   "again needn't dissect it again; they're dropped whenever something "
+                                   "that changes the dissection does (0 disables the cache)",
+                                   10,
+                                   &prefs.gui_tree_cache_size);
+    prefs_register_bool_preference(gui_module, "colorize_first_pass",
+                                   "Colorize packets as they are read",
+                                   "Apply the coloring rules to each packet when a capture file is first "
+                                   "read, rather than dissecting the packet again to colorize it when it "
+                                   "is shown",
+                                   &prefs.gui_colorize_first_pass);
 
     /* User Interface : Layout */
     gui_layout_module = prefs_register_subtree(gui_module, "Layout", "Layout", gui_layout_callback);
@@ -3752,6 +3839,58 @@ prefs_register_modules(void)
                                    "Currently only ICMP and ICMPv6 use this preference to add VLAN ID to conversation tracking",
                                    &prefs.strict_conversation_tracking_heuristics);
 
+    prefs_register_uint_preference(protocols_module, "reassembly_max_memory",
+                                   "Memory limit for incomplete reassemblies (MB)",
+                                   "The most memory that fragments waiting for reassembly may take up in all protocols together. "
+                                   "When it is exceeded, the reassemblies extended the longest time ago are dropped. 0 means no limit.",
+                                   10,
+                                   &prefs.reassembly_max_memory);
+
+    prefs_register_uint_preference(protocols_module, "reassembly_table_max_memory",
+                                   "Memory limit for incomplete reassemblies per protocol (MB)",
+                                   "The most memory that fragments waiting for reassembly may take up in any one reassembly table. "
+                                   "0 means no limit.",
+                                   10,
+                                   &prefs.reassembly_table_max_memory);
+
+    prefs_register_uint_preference(protocols_module, "reassembly_max_age",
+                                   "Drop incomplete reassemblies after this many packets",
+                                   "Reassemblies that haven't been extended for this many packets are dropped. "
+                                   "0 means they are kept until the end of the capture.",
+                                   10,
+                                   &prefs.reassembly_max_age);
+
+    prefs_register_uint_preference(protocols_module, "conversation_idle_timeout_tcp",
+                                   "Forget idle TCP conversations after (s)",
+                                   "TCP conversations, and the data dissectors keep for them, are dropped once no packet has been "
+                                   "seen for them for this many seconds of capture time. This only applies when packets are "
+                                   "dissected in a single pass, such as by TShark without -2. 0 means they are kept until the end of the capture.",
+                                   10,
+                                   &prefs.conversation_idle_timeout_tcp);
+
+    prefs_register_uint_preference(protocols_module, "conversation_idle_timeout_udp",
+                                   "Forget idle UDP conversations after (s)",
+                                   "UDP conversations, and the data dissectors keep for them, are dropped once no packet has been "
+                                   "seen for them for this many seconds of capture time. This only applies when packets are "
+                                   "dissected in a single pass, such as by TShark without -2. 0 means they are kept until the end of the capture.",
+                                   10,
+                                   &prefs.conversation_idle_timeout_udp);
+
+    prefs_register_uint_preference(protocols_module, "conversation_idle_timeout_other",
+                                   "Forget other idle conversations after (s)",
+                                   "Conversations other than TCP and UDP ones are dropped once no packet has been seen for them "
+                                   "for this many seconds of capture time. This only applies when packets are dissected in a "
+                                   "single pass, such as by TShark without -2. 0 means they are kept until the end of the capture.",
+                                   10,
+                                   &prefs.conversation_idle_timeout_other);
+
+    prefs_register_bool_preference(protocols_module, "heuristic_adaptive_order",
+                                   "Try the heuristic dissectors that succeed most often first",
+                                   "Order the heuristic dissectors of each protocol by how many packets they accepted lately, "
+                                   "and try the one that last accepted a packet of a conversation first on its other packets. "
+                                   "Otherwise the one that last accepted a packet is tried first.",
+                                   &prefs.heuristic_adaptive_order);
+
     /* Obsolete preferences
      * These "modules" were reorganized/renamed to correspond to their GUI
      * configuration screen within the preferences dialog
@@ -4211,6 +4350,18 @@ pre_init_prefs(void)
     prefs.gui_max_export_objects     = 1000;
     prefs.gui_max_tree_items = 1 * 1000 * 1000;
     prefs.gui_max_tree_depth = 5 * 100;
+    prefs.gui_filter_workers = 1;
+    prefs.gui_dissection_index = FALSE;
+    prefs.gui_protocol_index = FALSE;
+    g_free(prefs.gui_field_store);
+    prefs.gui_field_store = g_strdup("");
+    prefs.gui_expert_info_first_pass = TRUE;
+    prefs.gui_traffic_tables_first_pass = TRUE;
+    prefs.gui_proto_hier_first_pass = TRUE;
+    prefs.gui_packet_list_cache_size = 512;
+    prefs.gui_record_cache_size = 16;
+    prefs.gui_tree_cache_size = 8;
+    prefs.gui_colorize_first_pass = TRUE;
     prefs.gui_decimal_places1 = DEF_GUI_DECIMAL_PLACES1;
     prefs.gui_decimal_places2 = DEF_GUI_DECIMAL_PLACES2;
     prefs.gui_decimal_places3 = DEF_GUI_DECIMAL_PLACES3;
@@ -4264,6 +4415,13 @@ pre_init_prefs(void)
     prefs.st_sort_showfullname = FALSE;
     prefs.display_hidden_proto_items = FALSE;
     prefs.display_byte_fields_with_spaces = FALSE;
+    prefs.reassembly_max_memory = 0;
+    prefs.reassembly_table_max_memory = 0;
+    prefs.reassembly_max_age = 0;
+    prefs.conversation_idle_timeout_tcp = 0;
+    prefs.conversation_idle_timeout_udp = 0;
+    prefs.conversation_idle_timeout_other = 0;
+    prefs.heuristic_adaptive_order = FALSE;
 }
 
 /*
@@ -178,6 +178,17 @@ typedef struct _e_prefs {
   guint        gui_max_export_objects;
   guint        gui_max_tree_items;
   guint        gui_max_tree_depth;
+  guint        gui_filter_workers;
+  gboolean     gui_dissection_index;
+  gboolean     gui_protocol_index;
+  gchar       *gui_field_store;
+  gboolean     gui_expert_info_first_pass;
+  gboolean     gui_traffic_tables_first_pass;
+  gboolean     gui_proto_hier_first_pass;
+  guint        gui_packet_list_cache_size; /* MB, 0 = no limit */
+  guint        gui_record_cache_size; /* MB, 0 = no cache */
+  guint        gui_tree_cache_size; /* trees, 0 = no cache */
+  gboolean     gui_colorize_first_pass;
   layout_type_e gui_layout_type;
   layout_pane_content_e gui_layout_content_1;
   layout_pane_content_e gui_layout_content_2;
@@ -209,6 +220,13 @@ typedef struct _e_prefs {
   gboolean     enable_incomplete_dissectors_check;
   gboolean     incomplete_dissectors_check_debug;
   gboolean     strict_conversation_tracking_heuristics;
+  guint        reassembly_max_memory;        /* MB for all reassembly tables, 0 = no limit */
+  guint        reassembly_table_max_memory;  /* MB for each reassembly table, 0 = no limit */
+  guint        reassembly_max_age;           /* frames, 0 = no limit */
+  guint        conversation_idle_timeout_tcp;   /* seconds, 0 = never expire */
+  guint        conversation_idle_timeout_udp;   /* seconds, 0 = never expire */
+  guint        conversation_idle_timeout_other; /* seconds, 0 = never expire */
+  gboolean     heuristic_adaptive_order;
   gboolean     filter_expressions_old;  /* TRUE if old filter expressions preferences were loaded. */
   gboolean     gui_update_enabled;
   software_update_channel_e gui_update_channel;
@@ -531,6 +549,16 @@ WS_DLL_PUBLIC void prefs_register_obsolete_preference(module_t *module,
 WS_DLL_PUBLIC void prefs_set_preference_effect_fields(module_t *module,
     const char *name);
 
+/*
+ * Mark a dissector preference that only changes what the columns and the
+ * protocol tree of each packet show, and not the state kept across frames
+ * (conversations, reassembly, sequence analysis and the like).  Changing it
+ * then redraws the packets instead of dissecting the whole capture again
+ * from the first frame.
+ */
+WS_DLL_PUBLIC void prefs_set_preference_effect_display(module_t *module,
+    const char *name);
+
 
 typedef guint (*pref_cb)(pref_t *pref, gpointer user_data);
 
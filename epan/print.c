@@ -27,7 +27,9 @@
 #include <epan/prefs.h>
 #include <epan/print.h>
 #include <epan/charsets.h>
+#include <epan/ipv4.h>
 #include <wsutil/json_dumper.h>
+#include <wsutil/arrow_writer.h>
 #include <wsutil/filesystem.h>
 #include <version_info.h>
 #include <wsutil/utf8_entities.h>
@@ -49,7 +51,7 @@ typedef struct {
 
 typedef struct {
     int             level;
-    FILE           *fh;
+    GString        *buf;            /* the packet, written out at its end */
     GSList         *src_list;
     gchar         **filter;
     pf_flags        filter_flags;
@@ -81,6 +83,9 @@ struct _output_fields {
     GPtrArray   **field_values;
     gchar         quote;
     gboolean      includes_col_fields;
+    GArray       *prime_hfids;
+    arrow_type_e *arrow_types;
+    field_info  **arrow_values;
 };
 
 static gchar *get_field_hex_value(GSList *src_list, field_info *fi);
@@ -97,12 +102,14 @@ static void write_specified_fields(fields_format format,
                                    epan_dissect_t *edt, column_info *cinfo,
                                    FILE *fh,
                                    json_dumper *dumper);
+static void append_escaped_xml(GString *buf, const char *unescaped_string);
 static void print_escaped_xml(FILE *fh, const char *unescaped_string);
 static void print_escaped_csv(FILE *fh, const char *unescaped_string);
 
 typedef void (*proto_node_value_writer)(proto_node *, write_json_data *);
 static void write_json_index(json_dumper *dumper, epan_dissect_t *edt);
 static void write_json_proto_node_list(GSList *proto_node_list_head, write_json_data *data);
+static void write_json_proto_node_key(GSList *node_values_list, write_json_data *data);
 static void write_json_proto_node(GSList *node_values_head,
                                   const char *suffix,
                                   proto_node_value_writer value_writer,
@@ -117,7 +124,7 @@ static void write_json_proto_node_value(proto_node *node, write_json_data *data)
 static void write_json_proto_node_no_value(proto_node *node, write_json_data *data);
 static const char *proto_node_to_json_key(proto_node *node);
 
-static void print_pdml_geninfo(epan_dissect_t *edt, FILE *fh);
+static void print_pdml_geninfo(epan_dissect_t *edt, GString *buf);
 static void write_ek_summary(column_info *cinfo, write_json_data *pdata);
 
 static void proto_tree_get_node_field_values(proto_node *node, gpointer data);
@@ -300,30 +307,40 @@ static gboolean check_protocolfilter(gchar **protocolfilter, const char *str)
 void
 write_pdml_proto_tree(output_fields_t* fields, gchar **protocolfilter, pf_flags protocolfilter_flags, epan_dissect_t *edt, column_info *cinfo, FILE *fh, gboolean use_color)
 {
+    /*
+     * The packet is put together in memory and written out at once;
+     * the buffer is kept, at the size of the largest packet, for the
+     * next one.
+     */
+    static GString *buf = NULL;
     write_pdml_data data;
     const color_filter_t *cfp;
 
     g_assert(edt);
     g_assert(fh);
 
+    if (buf == NULL)
+        buf = g_string_sized_new(8192);
+    g_string_truncate(buf, 0);
+
     cfp = edt->pi.fd->color_filter;
 
     /* Create the output */
     if (use_color && (cfp != NULL)) {
-        fprintf(fh, "<packet foreground='#%06x' background='#%06x'>\n",
+        g_string_append_printf(buf, "<packet foreground='#%06x' background='#%06x'>\n",
             color_t_to_rgb(&cfp->fg_color),
             color_t_to_rgb(&cfp->bg_color));
     } else {
-        fprintf(fh, "<packet>\n");
+        g_string_append(buf, "<packet>\n");
     }
 
     /* Print a "geninfo" protocol as required by PDML */
-    print_pdml_geninfo(edt, fh);
+    print_pdml_geninfo(edt, buf);
 
     if (fields == NULL || fields->fields == NULL) {
         /* Write out all fields */
         data.level    = 0;
-        data.fh       = fh;
+        data.buf      = buf;
         data.src_list = edt->pi.data_src;
         data.filter   = protocolfilter;
         data.filter_flags   = protocolfilter_flags;
@@ -332,10 +349,13 @@ write_pdml_proto_tree(output_fields_t* fields, gchar **protocolfilter, pf_flags
                                     &data);
     } else {
         /* Write out specified fields */
+        fwrite(buf->str, 1, buf->len, fh);
+        g_string_truncate(buf, 0);
         write_specified_fields(FORMAT_XML, fields, edt, cinfo, fh, NULL);
     }
 
-    fprintf(fh, "</packet>\n\n");
+    g_string_append(buf, "</packet>\n\n");
+    fwrite(buf->str, 1, buf->len, fh);
 }
 
 void
@@ -408,28 +428,40 @@ write_fields_proto_tree(output_fields_t* fields, epan_dissect_t *edt, column_inf
     write_specified_fields(FORMAT_CSV, fields, edt, cinfo, fh, NULL);
 }
 
-/* Indent to the correct level */
-static void print_indent(int level, FILE *fh)
+/* Indent to the correct level; compact PDML isn't indented */
+static void pdml_indent(write_pdml_data *pdata, int level)
 {
     /* Use a buffer pre-filed with spaces */
 #define MAX_INDENT 2048
     static char spaces[MAX_INDENT];
     static gboolean inited = FALSE;
     if (!inited) {
-        for (int n=0; n < MAX_INDENT; n++) {
-            spaces[n] = ' ';
-        }
+        memset(spaces, ' ', MAX_INDENT);
         inited = TRUE;
     }
 
-    if (fh == NULL) {
+    if (pdata->filter_flags & PF_PDML_COMPACT) {
         return;
     }
 
-    /* Temp terminate at right length and write to fh. */
-    spaces[MIN(level*2, MAX_INDENT-1)] ='\0';
-    fputs(spaces, fh);
-    spaces[MIN(level*2, MAX_INDENT-1)] =' ';
+    g_string_append_len(pdata->buf, spaces, MIN(level*2, MAX_INDENT-1));
+}
+
+/*
+ * Whether a field's label is "<name>: <show>", which compact PDML leaves
+ * out, as it says nothing that the field's name and show don't.
+ */
+static gboolean
+pdml_showname_is_redundant(field_info *fi, const char *label, const char *show)
+{
+    size_t name_len;
+
+    if (show == NULL)
+        return FALSE;
+    name_len = strlen(fi->hfinfo->name);
+    return strncmp(label, fi->hfinfo->name, name_len) == 0 &&
+           label[name_len] == ':' && label[name_len + 1] == ' ' &&
+           strcmp(label + name_len + 2, show) == 0;
 }
 
 /* Write out a tree's data, and any child nodes, as PDML */
@@ -442,6 +474,7 @@ proto_tree_write_node_pdml(proto_node *node, gpointer data)
     gchar            label_str[ITEM_LABEL_LENGTH];
     char            *dfilter_string;
     gboolean         wrap_in_fake_protocol;
+    gboolean         compact = (pdata->filter_flags & PF_PDML_COMPACT) == PF_PDML_COMPACT;
 
     /* dissection with an invisible proto tree? */
     g_assert(fi);
@@ -453,14 +486,14 @@ proto_tree_write_node_pdml(proto_node *node, gpointer data)
           (fi->hfinfo->id == proto_data)) &&
          (pdata->level == 0));
 
-    print_indent(pdata->level + 1, pdata->fh);
+    pdml_indent(pdata, pdata->level + 1);
 
     if (wrap_in_fake_protocol) {
         /* Open fake protocol wrapper */
-        fputs("<proto name=\"fake-field-wrapper\">\n", pdata->fh);
+        g_string_append(pdata->buf, "<proto name=\"fake-field-wrapper\">\n");
         pdata->level++;
 
-        print_indent(pdata->level + 1, pdata->fh);
+        pdml_indent(pdata, pdata->level + 1);
     }
 
     /* Text label. It's printed as a field with no name. */
@@ -473,26 +506,26 @@ proto_tree_write_node_pdml(proto_node *node, gpointer data)
         }
 
         /* Show empty name since it is a required field */
-        fputs("<field name=\"", pdata->fh);
-        fputs("\" show=\"", pdata->fh);
-        print_escaped_xml(pdata->fh, label_ptr);
+        g_string_append(pdata->buf, "<field name=\"");
+        g_string_append(pdata->buf, "\" show=\"");
+        append_escaped_xml(pdata->buf, label_ptr);
 
-        fprintf(pdata->fh, "\" size=\"%d", fi->length);
+        g_string_append_printf(pdata->buf, "\" size=\"%d", fi->length);
         if (node->parent && node->parent->finfo && (fi->start < node->parent->finfo->start)) {
-            fprintf(pdata->fh, "\" pos=\"%d", node->parent->finfo->start + fi->start);
+            g_string_append_printf(pdata->buf, "\" pos=\"%d", node->parent->finfo->start + fi->start);
         } else {
-            fprintf(pdata->fh, "\" pos=\"%d", fi->start);
+            g_string_append_printf(pdata->buf, "\" pos=\"%d", fi->start);
         }
 
         if (fi->length > 0) {
-            fputs("\" value=\"", pdata->fh);
+            g_string_append(pdata->buf, "\" value=\"");
             pdml_write_field_hex_value(pdata, fi);
         }
 
         if (node->first_child != NULL) {
-            fputs("\">\n", pdata->fh);
+            g_string_append(pdata->buf, "\">\n");
         } else {
-            fputs("\"/>\n", pdata->fh);
+            g_string_append(pdata->buf, "\"/>\n");
         }
     }
 
@@ -500,17 +533,17 @@ proto_tree_write_node_pdml(proto_node *node, gpointer data)
      * printed as a field instead of a protocol. */
     else if (fi->hfinfo->id == proto_data) {
         /* Write out field with data */
-        fputs("<field name=\"data\" value=\"", pdata->fh);
+        g_string_append(pdata->buf, "<field name=\"data\" value=\"");
         pdml_write_field_hex_value(pdata, fi);
-        fputs("\">\n", pdata->fh);
+        g_string_append(pdata->buf, "\">\n");
     } else {
         /* Normal protocols and fields */
         if ((fi->hfinfo->type == FT_PROTOCOL) && (fi->hfinfo->id != proto_expert)) {
-            fputs("<proto name=\"", pdata->fh);
+            g_string_append(pdata->buf, "<proto name=\"");
         } else {
-            fputs("<field name=\"", pdata->fh);
+            g_string_append(pdata->buf, "<field name=\"");
         }
-        print_escaped_xml(pdata->fh, fi->hfinfo->abbrev);
+        append_escaped_xml(pdata->buf, fi->hfinfo->abbrev);
 
 #if 0
         /* PDML spec, see:
@@ -526,28 +559,39 @@ proto_tree_write_node_pdml(proto_node *node, gpointer data)
          * (like it's contained in the fi->rep->representation).
          * Unfortunately, we don't have the field data representation for
          * all fields, so this isn't currently possible */
-        fputs("\" showname=\"", pdata->fh);
-        print_escaped_xml(pdata->fh, fi->hfinfo->name);
+        g_string_append(pdata->buf, "\" showname=\"");
+        append_escaped_xml(pdata->buf, fi->hfinfo->name);
 #endif
 
+        switch (fi->hfinfo->type) {
+        case FT_PROTOCOL:
+        case FT_NONE:
+            dfilter_string = NULL;
+            break;
+        default:
+            dfilter_string = fvalue_to_string_repr(NULL, &fi->value, FTREPR_DISPLAY, fi->hfinfo->display);
+            break;
+        }
+
         if (fi->rep) {
-            fputs("\" showname=\"", pdata->fh);
-            print_escaped_xml(pdata->fh, fi->rep->representation);
+            label_ptr = fi->rep->representation;
         } else {
             label_ptr = label_str;
             proto_item_fill_label(fi, label_str);
-            fputs("\" showname=\"", pdata->fh);
-            print_escaped_xml(pdata->fh, label_ptr);
+        }
+        if (!compact || !pdml_showname_is_redundant(fi, label_ptr, dfilter_string)) {
+            g_string_append(pdata->buf, "\" showname=\"");
+            append_escaped_xml(pdata->buf, label_ptr);
         }
 
         if (proto_item_is_hidden(node) && (prefs.display_hidden_proto_items == FALSE))
-            fprintf(pdata->fh, "\" hide=\"yes");
+            g_string_append(pdata->buf, "\" hide=\"yes");
 
-        fprintf(pdata->fh, "\" size=\"%d", fi->length);
+        g_string_append_printf(pdata->buf, "\" size=\"%d", fi->length);
         if (node->parent && node->parent->finfo && (fi->start < node->parent->finfo->start)) {
-            fprintf(pdata->fh, "\" pos=\"%d", node->parent->finfo->start + fi->start);
+            g_string_append_printf(pdata->buf, "\" pos=\"%d", node->parent->finfo->start + fi->start);
         } else {
-            fprintf(pdata->fh, "\" pos=\"%d", fi->start);
+            g_string_append_printf(pdata->buf, "\" pos=\"%d", fi->start);
         }
 /*      fprintf(pdata->fh, "\" id=\"%d", fi->hfinfo->id);*/
 
@@ -557,14 +601,14 @@ proto_tree_write_node_pdml(proto_node *node, gpointer data)
         case FT_PROTOCOL:
             break;
         case FT_NONE:
-            fputs("\" show=\"\" value=\"",  pdata->fh);
+            if (!compact)
+                g_string_append(pdata->buf, "\" show=\"\" value=\"");
             break;
         default:
-            dfilter_string = fvalue_to_string_repr(NULL, &fi->value, FTREPR_DISPLAY, fi->hfinfo->display);
             if (dfilter_string != NULL) {
 
-                fputs("\" show=\"", pdata->fh);
-                print_escaped_xml(pdata->fh, dfilter_string);
+                g_string_append(pdata->buf, "\" show=\"");
+                append_escaped_xml(pdata->buf, dfilter_string);
             }
             wmem_free(NULL, dfilter_string);
 
@@ -576,7 +620,7 @@ proto_tree_write_node_pdml(proto_node *node, gpointer data)
              * they might be generated fields.
              */
             if (fi->length > 0) {
-                fputs("\" value=\"", pdata->fh);
+                g_string_append(pdata->buf, "\" value=\"");
 
                 if (fi->hfinfo->bitmask!=0) {
                     switch (fi->value.ftype->ftype) {
@@ -584,32 +628,32 @@ proto_tree_write_node_pdml(proto_node *node, gpointer data)
                         case FT_INT16:
                         case FT_INT24:
                         case FT_INT32:
-                            fprintf(pdata->fh, "%X", (guint) fvalue_get_sinteger(&fi->value));
+                            g_string_append_printf(pdata->buf, "%X", (guint) fvalue_get_sinteger(&fi->value));
                             break;
                         case FT_CHAR:
                         case FT_UINT8:
                         case FT_UINT16:
                         case FT_UINT24:
                         case FT_UINT32:
-                            fprintf(pdata->fh, "%X", fvalue_get_uinteger(&fi->value));
+                            g_string_append_printf(pdata->buf, "%X", fvalue_get_uinteger(&fi->value));
                             break;
                         case FT_INT40:
                         case FT_INT48:
                         case FT_INT56:
                         case FT_INT64:
-                            fprintf(pdata->fh, "%" G_GINT64_MODIFIER "X", fvalue_get_sinteger64(&fi->value));
+                            g_string_append_printf(pdata->buf, "%" G_GINT64_MODIFIER "X", fvalue_get_sinteger64(&fi->value));
                             break;
                         case FT_UINT40:
                         case FT_UINT48:
                         case FT_UINT56:
                         case FT_UINT64:
                         case FT_BOOLEAN:
-                            fprintf(pdata->fh, "%" G_GINT64_MODIFIER "X", fvalue_get_uinteger64(&fi->value));
+                            g_string_append_printf(pdata->buf, "%" G_GINT64_MODIFIER "X", fvalue_get_uinteger64(&fi->value));
                             break;
                         default:
                             g_assert_not_reached();
                     }
-                    fputs("\" unmaskedvalue=\"", pdata->fh);
+                    g_string_append(pdata->buf, "\" unmaskedvalue=\"");
                     pdml_write_field_hex_value(pdata, fi);
                 } else {
                     pdml_write_field_hex_value(pdata, fi);
@@ -618,11 +662,11 @@ proto_tree_write_node_pdml(proto_node *node, gpointer data)
         }
 
         if (node->first_child != NULL) {
-            fputs("\">\n", pdata->fh);
+            g_string_append(pdata->buf, "\">\n");
         } else if (fi->hfinfo->id == proto_data) {
-            fputs("\">\n", pdata->fh);
+            g_string_append(pdata->buf, "\">\n");
         } else {
-            fputs("\"/>\n", pdata->fh);
+            g_string_append(pdata->buf, "\"/>\n");
         }
     }
 
@@ -646,12 +690,12 @@ proto_tree_write_node_pdml(proto_node *node, gpointer data)
                 pdata->filter = _filter;
             }
         } else {
-            print_indent(pdata->level + 2, pdata->fh);
+            pdml_indent(pdata, pdata->level + 2);
 
             /* print dummy field */
-            fputs("<field name=\"filtered\" value=\"", pdata->fh);
-            print_escaped_xml(pdata->fh, fi->hfinfo->abbrev);
-            fputs("\" />\n", pdata->fh);
+            g_string_append(pdata->buf, "<field name=\"filtered\" value=\"");
+            append_escaped_xml(pdata->buf, fi->hfinfo->abbrev);
+            g_string_append(pdata->buf, "\" />\n");
         }
     }
 
@@ -661,25 +705,25 @@ proto_tree_write_node_pdml(proto_node *node, gpointer data)
     }
 
     if (node->first_child != NULL) {
-        print_indent(pdata->level + 1, pdata->fh);
+        pdml_indent(pdata, pdata->level + 1);
 
         /* Close off current element */
         /* Data and expert "protocols" use simple tags */
         if ((fi->hfinfo->id != proto_data) && (fi->hfinfo->id != proto_expert)) {
             if (fi->hfinfo->type == FT_PROTOCOL) {
-                fputs("</proto>\n", pdata->fh);
+                g_string_append(pdata->buf, "</proto>\n");
             } else {
-                fputs("</field>\n", pdata->fh);
+                g_string_append(pdata->buf, "</field>\n");
             }
         } else {
-            fputs("</field>\n", pdata->fh);
+            g_string_append(pdata->buf, "</field>\n");
         }
     }
 
     /* Close off fake wrapper protocol */
     if (wrap_in_fake_protocol) {
-        print_indent(pdata->level + 1, pdata->fh);
-        fputs("</proto>\n", pdata->fh);
+        pdml_indent(pdata, pdata->level + 1);
+        g_string_append(pdata->buf, "</proto>\n");
     }
 }
 
@@ -781,72 +825,85 @@ write_json_proto_node_list(GSList *proto_node_list_head, write_json_data *pdata)
     // Loop over each list of nodes (differentiated by json key) and write the associated json key:value pair in the
     // output.
     while (current_node != NULL) {
-        // Get the list of values for the current json key.
-        GSList *node_values_list = (GSList *) current_node->data;
-
-        // Retrieve the json key from the first value.
-        proto_node *first_value = (proto_node *) node_values_list->data;
-        const char *json_key = proto_node_to_json_key(first_value);
-        // Check if the current json key is filtered from the output with the "-j" cli option.
-        gboolean is_filtered = pdata->filter != NULL && !check_protocolfilter(pdata->filter, json_key);
-
-        field_info *fi = first_value->finfo;
-        char *value_string_repr = fvalue_to_string_repr(NULL, &fi->value, FTREPR_DISPLAY, fi->hfinfo->display);
-
-        // We assume all values of a json key have roughly the same layout. Thus we can use the first value to derive
-        // attributes of all the values.
-        gboolean has_value = value_string_repr != NULL;
-        gboolean has_children = first_value->first_child != NULL;
-        gboolean is_pseudo_text_field = fi->hfinfo->id == 0;
+        write_json_proto_node_key((GSList *) current_node->data, pdata);
+        current_node = current_node->next;
+    }
+    json_dumper_end_object(pdata->dumper);
+}
 
-        wmem_free(NULL, value_string_repr); // fvalue_to_string_repr returns allocated buffer
+/**
+ * Write the key:value pairs of the nodes associated with one json key.
+ * @param node_values_list Linked list of the nodes associated with the json key.
+ * @param pdata json writing metadata
+ */
+static void
+write_json_proto_node_key(GSList *node_values_list, write_json_data *pdata)
+{
+    // Retrieve the json key from the first value.
+    proto_node *first_value = (proto_node *) node_values_list->data;
+    const char *json_key = proto_node_to_json_key(first_value);
+    // Check if the current json key is filtered from the output with the "-j" cli option.
+    gboolean is_filtered = pdata->filter != NULL && !check_protocolfilter(pdata->filter, json_key);
 
-        // "-x" command line option. A "_raw" suffix is added to the json key so the textual value can be printed
-        // with the original json key. If both hex and text writing are enabled the raw information of fields whose
-        // length is equal to 0 is not written to the output. If the field is a special text pseudo field no raw
-        // information is written either.
-        if (pdata->print_hex && (!pdata->print_text || fi->length > 0) && !is_pseudo_text_field) {
-            write_json_proto_node(node_values_list, "_raw", write_json_proto_node_hex_dump, pdata);
-        }
+    field_info *fi = first_value->finfo;
+    char *value_string_repr = fvalue_to_string_repr(NULL, &fi->value, FTREPR_DISPLAY, fi->hfinfo->display);
 
-        if (pdata->print_text && has_value) {
+    // We assume all values of a json key have roughly the same layout. Thus we can use the first value to derive
+    // attributes of all the values.
+    gboolean has_value = value_string_repr != NULL;
+    gboolean has_children = first_value->first_child != NULL;
+    gboolean is_pseudo_text_field = fi->hfinfo->id == 0;
+
+    // "-x" command line option. A "_raw" suffix is added to the json key so the textual value can be printed
+    // with the original json key. If both hex and text writing are enabled the raw information of fields whose
+    // length is equal to 0 is not written to the output. If the field is a special text pseudo field no raw
+    // information is written either.
+    if (pdata->print_hex && (!pdata->print_text || fi->length > 0) && !is_pseudo_text_field) {
+        write_json_proto_node(node_values_list, "_raw", write_json_proto_node_hex_dump, pdata);
+    }
+
+    if (pdata->print_text && has_value) {
+        if (node_values_list->next == NULL) {
+            // A single value, which we already have as a string.
+            json_dumper_set_member_name(pdata->dumper, json_key);
+            json_dumper_value_string(pdata->dumper, value_string_repr);
+        } else {
             write_json_proto_node(node_values_list, "", write_json_proto_node_value, pdata);
         }
+    }
 
-        if (has_children) {
-            // If a node has both a value and a set of children we print the value and the children in separate
-            // key:value pairs. These can't have the same key so whenever a value is already printed with the node
-            // json key we print the children with the same key with a "_tree" suffix added.
-            char *suffix = has_value ? "_tree": "";
+    wmem_free(NULL, value_string_repr); // fvalue_to_string_repr returns allocated buffer
 
-            if (is_filtered) {
-                write_json_proto_node(node_values_list, suffix, write_json_proto_node_filtered, pdata);
-            } else {
-                // Remove protocol filter for children, if children should be included. This functionality is enabled
-                // with the "-J" command line option. We save the filter so it can be reenabled when we are done with
-                // the current key:value pair.
-                gchar **_filter = NULL;
-                if ((pdata->filter_flags&PF_INCLUDE_CHILDREN) == PF_INCLUDE_CHILDREN) {
-                    _filter = pdata->filter;
-                    pdata->filter = NULL;
-                }
+    if (has_children) {
+        // If a node has both a value and a set of children we print the value and the children in separate
+        // key:value pairs. These can't have the same key so whenever a value is already printed with the node
+        // json key we print the children with the same key with a "_tree" suffix added.
+        char *suffix = has_value ? "_tree": "";
 
-                write_json_proto_node(node_values_list, suffix, write_json_proto_node_children, pdata);
-
-                // Put protocol filter back
-                if ((pdata->filter_flags&PF_INCLUDE_CHILDREN) == PF_INCLUDE_CHILDREN) {
-                    pdata->filter = _filter;
-                }
+        if (is_filtered) {
+            write_json_proto_node(node_values_list, suffix, write_json_proto_node_filtered, pdata);
+        } else {
+            // Remove protocol filter for children, if children should be included. This functionality is enabled
+            // with the "-J" command line option. We save the filter so it can be reenabled when we are done with
+            // the current key:value pair.
+            gchar **_filter = NULL;
+            if ((pdata->filter_flags&PF_INCLUDE_CHILDREN) == PF_INCLUDE_CHILDREN) {
+                _filter = pdata->filter;
+                pdata->filter = NULL;
             }
-        }
 
-        if (!has_value && !has_children && (pdata->print_text || (pdata->print_hex && is_pseudo_text_field))) {
-            write_json_proto_node(node_values_list, "", write_json_proto_node_no_value, pdata);
+            write_json_proto_node(node_values_list, suffix, write_json_proto_node_children, pdata);
+
+            // Put protocol filter back
+            if ((pdata->filter_flags&PF_INCLUDE_CHILDREN) == PF_INCLUDE_CHILDREN) {
+                pdata->filter = _filter;
+            }
         }
+    }
 
-        current_node = current_node->next;
+    if (!has_value && !has_children && (pdata->print_text || (pdata->print_hex && is_pseudo_text_field))) {
+        write_json_proto_node(node_values_list, "", write_json_proto_node_no_value, pdata);
     }
-    json_dumper_end_object(pdata->dumper);
 }
 
 /**
@@ -866,9 +923,13 @@ write_json_proto_node(GSList *node_values_head,
     // Retrieve json key from first value.
     proto_node *first_value = (proto_node *) node_values_head->data;
     const char *json_key = proto_node_to_json_key(first_value);
-    gchar* json_key_suffix = g_strdup_printf("%s%s", json_key, suffix);
-    json_dumper_set_member_name(pdata->dumper, json_key_suffix);
-    g_free(json_key_suffix);
+    if (suffix[0] == '\0') {
+        json_dumper_set_member_name(pdata->dumper, json_key);
+    } else {
+        gchar* json_key_suffix = g_strconcat(json_key, suffix, NULL);
+        json_dumper_set_member_name(pdata->dumper, json_key_suffix);
+        g_free(json_key_suffix);
+    }
     write_json_proto_node_value_list(node_values_head, value_writer, pdata);
 }
 
@@ -973,9 +1034,22 @@ write_json_proto_node_hex_dump(proto_node *node, write_json_data *pdata)
 static void
 write_json_proto_node_children(proto_node *node, write_json_data *data)
 {
-    GSList *grouped_children_list = data->node_children_grouper(node);
-    write_json_proto_node_list(grouped_children_list, data);
-    g_slist_free_full(grouped_children_list, (GDestroyNotify) g_slist_free);
+    if (data->node_children_grouper == proto_node_group_children_by_unique) {
+        // Each child is a group of its own; write them as they come, without building the lists.
+        proto_node *child;
+
+        json_dumper_begin_object(data->dumper);
+        for (child = node->first_child; child != NULL; child = child->next) {
+            GSList child_values = { child, NULL };
+
+            write_json_proto_node_key(&child_values, data);
+        }
+        json_dumper_end_object(data->dumper);
+    } else {
+        GSList *grouped_children_list = data->node_children_grouper(node);
+        write_json_proto_node_list(grouped_children_list, data);
+        g_slist_free_full(grouped_children_list, (GDestroyNotify) g_slist_free);
+    }
 }
 
 /**
@@ -1140,19 +1214,29 @@ write_ek_summary(column_info *cinfo, write_json_data* pdata)
     for (i = 0; i < cinfo->num_cols; i++) {
         if (!get_column_visible(i))
             continue;
-        json_dumper_set_member_name(pdata->dumper, g_ascii_strdown(cinfo->columns[i].col_title, -1));
+        gchar *name = g_ascii_strdown(cinfo->columns[i].col_title, -1);
+
+        json_dumper_set_member_name(pdata->dumper, name);
         json_dumper_value_string(pdata->dumper, cinfo->columns[i].col_data);
+        g_free(name);
     }
 }
 
+/*
+ * The instances of an EK attribute, in the reverse order of the tree, as
+ * prepending is O(1) where appending is O(n).
+ */
+typedef struct {
+    GSList *instances;
+} ek_attr_t;
+
 /* Write out a tree's data, and any child nodes, as JSON for EK */
 static void
-ek_fill_attr(proto_node *node, GSList **attr_list, GHashTable *attr_table, write_json_data *pdata)
+ek_fill_attr(proto_node *node, GSList **attr_list, GHashTable *attr_table, GString *node_name, write_json_data *pdata)
 {
     field_info *fi         = NULL;
     field_info *fi_parent  = NULL;
-    gchar *node_name       = NULL;
-    GSList *attr_instances = NULL;
+    ek_attr_t *attr        = NULL;
 
     proto_node *current_node = node->first_child;
     while (current_node != NULL) {
@@ -1163,22 +1247,21 @@ ek_fill_attr(proto_node *node, GSList **attr_list, GHashTable *attr_table, write
         g_assert(fi);
 
         if (fi_parent == NULL) {
-            node_name = g_strdup(fi->hfinfo->abbrev);
+            g_string_assign(node_name, fi->hfinfo->abbrev);
         } else {
-            node_name = g_strconcat(fi_parent->hfinfo->abbrev, "_", fi->hfinfo->abbrev, NULL);
+            g_string_assign(node_name, fi_parent->hfinfo->abbrev);
+            g_string_append_c(node_name, '_');
+            g_string_append(node_name, fi->hfinfo->abbrev);
         }
 
-        attr_instances = (GSList *) g_hash_table_lookup(attr_table, node_name);
+        attr = (ek_attr_t *) g_hash_table_lookup(attr_table, node_name->str);
         // First time we encounter this attr
-        if (attr_instances == NULL) {
-            attr_instances = g_slist_append(attr_instances, current_node);
-            *attr_list = g_slist_prepend(*attr_list, attr_instances);
-        } else {
-            attr_instances = g_slist_append(attr_instances, current_node);
+        if (attr == NULL) {
+            attr = g_new0(ek_attr_t, 1);
+            *attr_list = g_slist_prepend(*attr_list, attr);
+            g_hash_table_insert(attr_table, g_strdup(node_name->str), attr);
         }
-
-        // Update instance list for this attr in hash table
-        g_hash_table_insert(attr_table, node_name, attr_instances);
+        attr->instances = g_slist_prepend(attr->instances, current_node);
 
         /* Field, recurse through children*/
         if (fi->hfinfo->type != FT_PROTOCOL && current_node->first_child != NULL) {
@@ -1191,7 +1274,7 @@ ek_fill_attr(proto_node *node, GSList **attr_list, GHashTable *attr_table, write
                         pdata->filter = NULL;
                     }
 
-                    ek_fill_attr(current_node, attr_list, attr_table, pdata);
+                    ek_fill_attr(current_node, attr_list, attr_table, node_name, pdata);
 
                     /* Put protocol filter back */
                     if ((pdata->filter_flags&PF_INCLUDE_CHILDREN) == PF_INCLUDE_CHILDREN) {
@@ -1201,7 +1284,7 @@ ek_fill_attr(proto_node *node, GSList **attr_list, GHashTable *attr_table, write
                     // Don't traverse children if filtered out
                 }
             } else {
-                ek_fill_attr(current_node, attr_list, attr_table, pdata);
+                ek_fill_attr(current_node, attr_list, attr_table, node_name, pdata);
             }
         } else {
             // Will descend into object at another point
@@ -1219,13 +1302,16 @@ ek_write_name(proto_node *pnode, gchar* suffix, write_json_data* pdata)
 
     if (fi->hfinfo->parent != -1) {
         header_field_info* parent = proto_registrar_get_nth(fi->hfinfo->parent);
-        str = g_strdup_printf("%s_%s%s", parent->abbrev, fi->hfinfo->abbrev, suffix ? suffix : "");
+        str = g_strconcat(parent->abbrev, "_", fi->hfinfo->abbrev, suffix, NULL);
         json_dumper_set_member_name(pdata->dumper, str);
-    } else {
-        str = g_strdup_printf("%s%s", fi->hfinfo->abbrev, suffix ? suffix : "");
+        g_free(str);
+    } else if (suffix != NULL) {
+        str = g_strconcat(fi->hfinfo->abbrev, suffix, NULL);
         json_dumper_set_member_name(pdata->dumper, str);
+        g_free(str);
+    } else {
+        json_dumper_set_member_name(pdata->dumper, fi->hfinfo->abbrev);
     }
-    g_free(str);
 }
 
 static void
@@ -1358,7 +1444,7 @@ ek_write_attr_hex(GSList *attr_instances, write_json_data *pdata)
     // Raw name
     ek_write_name(pnode, "_raw", pdata);
 
-    if (g_slist_length(attr_instances) > 1) {
+    if (attr_instances->next != NULL) {
         json_dumper_begin_array(pdata->dumper);
     }
 
@@ -1372,7 +1458,7 @@ ek_write_attr_hex(GSList *attr_instances, write_json_data *pdata)
         current_node = current_node->next;
     }
 
-    if (g_slist_length(attr_instances) > 1) {
+    if (attr_instances->next != NULL) {
         json_dumper_end_array(pdata->dumper);
     }
 }
@@ -1392,7 +1478,7 @@ ek_write_attr(GSList *attr_instances, write_json_data *pdata)
     // Print attr name
     ek_write_name(pnode, NULL, pdata);
 
-    if (g_slist_length(attr_instances) > 1) {
+    if (attr_instances->next != NULL) {
         json_dumper_begin_array(pdata->dumper);
     }
 
@@ -1447,7 +1533,7 @@ ek_write_attr(GSList *attr_instances, write_json_data *pdata)
         current_node = current_node->next;
     }
 
-    if (g_slist_length(attr_instances) > 1) {
+    if (attr_instances->next != NULL) {
         json_dumper_end_array(pdata->dumper);
     }
 }
@@ -1458,23 +1544,28 @@ proto_tree_write_node_ek(proto_node *node, write_json_data *pdata)
 {
     GSList *attr_list  = NULL;
     GHashTable *attr_table  = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    GString *node_name = g_string_new(NULL);
 
-    ek_fill_attr(node, &attr_list, attr_table, pdata);
+    ek_fill_attr(node, &attr_list, attr_table, node_name, pdata);
 
     g_hash_table_destroy(attr_table);
+    g_string_free(node_name, TRUE);
 
     // Print attributes
     attr_list = g_slist_reverse(attr_list);
     GSList *current_attr = attr_list;
     while (current_attr != NULL) {
-        GSList *attr_instances = (GSList *) current_attr->data;
+        ek_attr_t *attr = (ek_attr_t *) current_attr->data;
+        GSList *attr_instances = g_slist_reverse(attr->instances);
 
         ek_write_attr(attr_instances, pdata);
 
+        g_slist_free(attr_instances);
+        g_free(attr);
         current_attr = current_attr->next;
     }
 
-    g_slist_free_full(attr_list, (GDestroyNotify) g_slist_free);
+    g_slist_free(attr_list);
 }
 
 /* Print info for a 'geninfo' pseudo-protocol. This is required by
@@ -1482,7 +1573,7 @@ proto_tree_write_node_ek(proto_node *node, write_json_data *pdata)
  * but we produce a 'geninfo' protocol in the PDML to conform to spec.
  * The 'frame' protocol follows the 'geninfo' protocol in the PDML. */
 static void
-print_pdml_geninfo(epan_dissect_t *edt, FILE *fh)
+print_pdml_geninfo(epan_dissect_t *edt, GString *buf)
 {
     guint32     num, len, caplen;
     GPtrArray  *finfo_array;
@@ -1507,37 +1598,36 @@ print_pdml_geninfo(epan_dissect_t *edt, FILE *fh)
     caplen = edt->pi.fd->cap_len;
 
     /* Print geninfo start */
-    fprintf(fh,
+    g_string_append_printf(buf,
             "  <proto name=\"geninfo\" pos=\"0\" showname=\"General information\" size=\"%d\">\n",
             frame_finfo->length);
 
     /* Print geninfo.num */
-    fprintf(fh,
+    g_string_append_printf(buf,
             "    <field name=\"num\" pos=\"0\" show=\"%u\" showname=\"Number\" value=\"%x\" size=\"%d\"/>\n",
             num, num, frame_finfo->length);
 
     /* Print geninfo.len */
-    fprintf(fh,
+    g_string_append_printf(buf,
             "    <field name=\"len\" pos=\"0\" show=\"%u\" showname=\"Frame Length\" value=\"%x\" size=\"%d\"/>\n",
             len, len, frame_finfo->length);
 
     /* Print geninfo.caplen */
-    fprintf(fh,
+    g_string_append_printf(buf,
             "    <field name=\"caplen\" pos=\"0\" show=\"%u\" showname=\"Captured Length\" value=\"%x\" size=\"%d\"/>\n",
             caplen, caplen, frame_finfo->length);
 
     tmp = abs_time_to_str(NULL, &edt->pi.abs_ts, ABSOLUTE_TIME_LOCAL, TRUE);
 
     /* Print geninfo.timestamp */
-    fprintf(fh,
+    g_string_append_printf(buf,
             "    <field name=\"timestamp\" pos=\"0\" show=\"%s\" showname=\"Captured Time\" value=\"%d.%09d\" size=\"%d\"/>\n",
             tmp, (int)edt->pi.abs_ts.secs, edt->pi.abs_ts.nsecs, frame_finfo->length);
 
     wmem_free(NULL, tmp);
 
     /* Print geninfo end */
-    fprintf(fh,
-            "  </proto>\n");
+    g_string_append(buf, "  </proto>\n");
 }
 
 void
@@ -1569,26 +1659,33 @@ write_psml_preamble(column_info *cinfo, FILE *fh)
 void
 write_psml_columns(epan_dissect_t *edt, FILE *fh, gboolean use_color)
 {
+    static GString *buf = NULL;
     gint i;
     const color_filter_t *cfp = edt->pi.fd->color_filter;
 
+    /* As with PDML, the packet is written out at once. */
+    if (buf == NULL)
+        buf = g_string_sized_new(1024);
+    g_string_truncate(buf, 0);
+
     if (use_color && (cfp != NULL)) {
-        fprintf(fh, "<packet foreground='#%06x' background='#%06x'>\n",
+        g_string_append_printf(buf, "<packet foreground='#%06x' background='#%06x'>\n",
             color_t_to_rgb(&cfp->fg_color),
             color_t_to_rgb(&cfp->bg_color));
     } else {
-        fprintf(fh, "<packet>\n");
+        g_string_append(buf, "<packet>\n");
     }
 
     for (i = 0; i < edt->pi.cinfo->num_cols; i++) {
         if (!get_column_visible(i))
             continue;
-        fprintf(fh, "<section>");
-        print_escaped_xml(fh, edt->pi.cinfo->columns[i].col_data);
-        fprintf(fh, "</section>\n");
+        g_string_append(buf, "<section>");
+        append_escaped_xml(buf, edt->pi.cinfo->columns[i].col_data);
+        g_string_append(buf, "</section>\n");
     }
 
-    fprintf(fh, "</packet>\n\n");
+    g_string_append(buf, "</packet>\n\n");
+    fwrite(buf->str, 1, buf->len, fh);
 }
 
 void
@@ -1763,58 +1860,64 @@ get_field_data(GSList *src_list, field_info *fi)
     return NULL;  /* not found */
 }
 
-/* Print a string, escaping out certain characters that need to
+/* Append a string, escaping out certain characters that need to
  * escaped out for XML. */
 static void
-print_escaped_xml(FILE *fh, const char *unescaped_string)
+append_escaped_xml(GString *buf, const char *unescaped_string)
 {
     const char *p;
+    size_t      run;
 
-#define ESCAPED_BUFFER_MAX 256
-    static char temp_buffer[ESCAPED_BUFFER_MAX];
-    gint        offset = 0;
-
-    if (fh == NULL || unescaped_string == NULL) {
+    if (unescaped_string == NULL) {
         return;
     }
 
-    for (p = unescaped_string; *p != '\0'; p++) {
-        switch (*p) {
+    /*
+     * Most strings have few or no characters to escape; copy the runs
+     * between them at once.  strcspn() is vectorized by the C library on
+     * the platforms where that matters.
+     */
+    for (p = unescaped_string; ; p += run + 1) {
+        run = strcspn(p, "&<>\"'");
+        g_string_append_len(buf, p, run);
+        switch (p[run]) {
+        case '\0':
+            return;
         case '&':
-            g_strlcpy(&temp_buffer[offset], "&amp;", ESCAPED_BUFFER_MAX-offset);
-            offset += 5;
+            g_string_append_len(buf, "&amp;", 5);
             break;
         case '<':
-            g_strlcpy(&temp_buffer[offset], "&lt;", ESCAPED_BUFFER_MAX-offset);
-            offset += 4;
+            g_string_append_len(buf, "&lt;", 4);
             break;
         case '>':
-            g_strlcpy(&temp_buffer[offset], "&gt;", ESCAPED_BUFFER_MAX-offset);
-            offset += 4;
+            g_string_append_len(buf, "&gt;", 4);
             break;
         case '"':
-            g_strlcpy(&temp_buffer[offset], "&quot;", ESCAPED_BUFFER_MAX-offset);
-            offset += 6;
+            g_string_append_len(buf, "&quot;", 6);
             break;
         case '\'':
-            g_strlcpy(&temp_buffer[offset], "&#x27;", ESCAPED_BUFFER_MAX-offset);
-            offset += 6;
+            g_string_append_len(buf, "&#x27;", 6);
             break;
-        default:
-            temp_buffer[offset++] = *p;
-        }
-        if (offset > ESCAPED_BUFFER_MAX-8) {
-            /* Getting close to end of buffer so flush to fh */
-            temp_buffer[offset] = '\0';
-            fputs(temp_buffer, fh);
-            offset = 0;
         }
     }
-    if (offset) {
-        /* Flush any outstanding data */
-        temp_buffer[offset] = '\0';
-        fputs(temp_buffer, fh);
+}
+
+/* Print a string, escaping out certain characters that need to
+ * escaped out for XML. */
+static void
+print_escaped_xml(FILE *fh, const char *unescaped_string)
+{
+    static GString *buf = NULL;
+
+    if (fh == NULL || unescaped_string == NULL) {
+        return;
     }
+
+    if (buf == NULL)
+        buf = g_string_sized_new(256);
+    g_string_truncate(buf, 0);
+    append_escaped_xml(buf, unescaped_string);
+    fwrite(buf->str, 1, buf->len, fh);
 }
 
 static void
@@ -1859,7 +1962,7 @@ pdml_write_field_hex_value(write_pdml_data *pdata, field_info *fi)
         return;
 
     if (fi->length > tvb_captured_length_remaining(fi->ds_tvb, fi->start)) {
-        fprintf(pdata->fh, "field length invalid!");
+        g_string_append(pdata->buf, "field length invalid!");
         return;
     }
 
@@ -1867,26 +1970,17 @@ pdml_write_field_hex_value(write_pdml_data *pdata, field_info *fi)
     pd = get_field_data(pdata->src_list, fi);
 
     if (pd) {
-        /* Used fixed buffer where can, otherwise temp malloc */
-        static gchar str_static[129];
-        gchar *str = str_static;
-        gchar* str_heap = NULL;
-        if (fi->length > 64) {
-            str_heap = (gchar*)g_malloc0(fi->length*2+1);
-            str = str_heap;
-        }
-
         static const char hex[] = "0123456789abcdef";
+        gsize  start = pdata->buf->len;
+        gchar *str;
 
-        /* Print a simple hex dump */
+        /* Print a simple hex dump, straight into the packet's buffer */
+        g_string_set_size(pdata->buf, start + 2 * (gsize)fi->length);
+        str = pdata->buf->str + start;
         for (i = 0 ; i < fi->length; i++) {
             str[2*i] =   hex[pd[i] >> 4];
             str[2*i+1] = hex[pd[i] & 0xf];
         }
-        str[2 * fi->length] = '\0';
-        fputs(str, pdata->fh);
-        g_free(str_heap);
-
     }
 }
 
@@ -2096,6 +2190,13 @@ void output_fields_free(output_fields_t* fields)
             g_free(fields->field_values);
         }
 
+        if (NULL != fields->prime_hfids) {
+            g_array_free(fields->prime_hfids, TRUE);
+        }
+
+        g_free(fields->arrow_types);
+        g_free(fields->arrow_values);
+
         for (i = 0; i < fields->fields->len; ++i) {
             gchar* field = (gchar *)g_ptr_array_index(fields->fields,i);
             g_free(field);
@@ -2130,6 +2231,60 @@ void output_fields_add(output_fields_t *fields, const gchar *field)
 
 }
 
+gboolean output_fields_need_visible_tree(output_fields_t *fields)
+{
+    gsize i;
+
+    g_assert(fields);
+
+    if (NULL == fields->fields)
+        return FALSE;
+
+    for (i = 0; i < fields->fields->len; i++) {
+        gchar *field = (gchar *)g_ptr_array_index(fields->fields, i);
+        header_field_info *hfinfo;
+
+        if (!strncmp(field, COLUMN_FIELD_FILTER, strlen(COLUMN_FIELD_FILTER)))
+            continue;
+
+        /* Protocols and text items are written using their labels,
+         * which are only generated for a visible tree. */
+        hfinfo = proto_registrar_get_byname(field);
+        if (hfinfo == NULL || hfinfo->type == FT_PROTOCOL || hfinfo->id == hf_text_only)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+void output_fields_prime_edt(output_fields_t *fields, epan_dissect_t *edt)
+{
+    guint i;
+
+    g_assert(fields);
+
+    if (NULL == fields->fields)
+        return;
+
+    if (NULL == fields->prime_hfids) {
+        /* Look the fields up the first time; there may be several
+         * fields with the same name. */
+        fields->prime_hfids = g_array_new(FALSE, FALSE, sizeof(int));
+        for (i = 0; i < fields->fields->len; i++) {
+            gchar *field = (gchar *)g_ptr_array_index(fields->fields, i);
+            header_field_info *hfinfo;
+
+            if (!strncmp(field, COLUMN_FIELD_FILTER, strlen(COLUMN_FIELD_FILTER)))
+                continue;
+
+            for (hfinfo = proto_registrar_get_byname(field); hfinfo != NULL; hfinfo = hfinfo->same_name_next)
+                g_array_append_val(fields->prime_hfids, hfinfo->id);
+        }
+    }
+
+    for (i = 0; i < fields->prime_hfids->len; i++)
+        epan_dissect_prime_with_hfid(edt, g_array_index(fields->prime_hfids, int, i));
+}
+
 static void
 output_field_check(void *data, void *user_data)
 {
@@ -2291,6 +2446,26 @@ gboolean output_fields_has_cols(output_fields_t* fields)
     return fields->includes_col_fields;
 }
 
+gboolean output_fields_has_col(output_fields_t* fields, const gchar *col_title)
+{
+    gsize i;
+    const gsize prefix_len = strlen(COLUMN_FIELD_FILTER);
+
+    g_assert(fields);
+
+    if (!fields->includes_col_fields)
+        return FALSE;
+
+    for (i = 0; i < fields->fields->len; ++i) {
+        const gchar* field = (const gchar *)g_ptr_array_index(fields->fields, i);
+
+        if (!strncmp(field, COLUMN_FIELD_FILTER, prefix_len) &&
+            !strcmp(field + prefix_len, col_title))
+            return TRUE;
+    }
+    return FALSE;
+}
+
 void write_fields_preamble(output_fields_t* fields, FILE *fh)
 {
     gsize i;
@@ -2408,27 +2583,9 @@ static void proto_tree_get_node_field_values(proto_node *node, gpointer data)
     }
 }
 
-static void write_specified_fields(fields_format format, output_fields_t *fields, epan_dissect_t *edt, column_info *cinfo, FILE *fh, json_dumper *dumper)
+static void prepare_field_values(output_fields_t *fields)
 {
     gsize     i;
-    gint      col;
-    gchar    *col_name;
-    gpointer  field_index;
-
-    write_field_data_t data;
-
-    g_assert(fields);
-    g_assert(fields->fields);
-    g_assert(edt);
-    /* JSON formats must go through json_dumper */
-    if (format == FORMAT_JSON || format == FORMAT_EK) {
-        g_assert(!fh && dumper);
-    } else {
-        g_assert(fh && !dumper);
-    }
-
-    data.fields = fields;
-    data.edt = edt;
 
     if (NULL == fields->field_indicies) {
         /* Prepare a lookup table from string abbreviation for field to its index. */
@@ -2453,25 +2610,57 @@ static void write_specified_fields(fields_format format, output_fields_t *fields
     /* XXX: ToDo: use packet-scope'd memory & (if/when implemented) wmem ptr_array */
     if (NULL == fields->field_values)
         fields->field_values = g_new0(GPtrArray*, fields->fields->len);  /* free'd in output_fields_free() */
+}
 
-    proto_tree_children_foreach(edt->tree, proto_tree_get_node_field_values,
-                                &data);
+/* Add columns to fields */
+static void add_column_field_values(output_fields_t *fields, column_info *cinfo)
+{
+    gint      col;
+    gchar    *col_name;
+    gpointer  field_index;
 
-    /* Add columns to fields */
-    if (fields->includes_col_fields) {
-        for (col = 0; col < cinfo->num_cols; col++) {
-            if (!get_column_visible(col))
-                continue;
-            /* Prepend COLUMN_FIELD_FILTER as the field name */
-            col_name = g_strdup_printf("%s%s", COLUMN_FIELD_FILTER, cinfo->columns[col].col_title);
-            field_index = g_hash_table_lookup(fields->field_indicies, col_name);
-            g_free(col_name);
+    if (!fields->includes_col_fields)
+        return;
 
-            if (NULL != field_index) {
-                format_field_values(fields, field_index, g_strdup(cinfo->columns[col].col_data));
-            }
+    for (col = 0; col < cinfo->num_cols; col++) {
+        if (!get_column_visible(col))
+            continue;
+        /* Prepend COLUMN_FIELD_FILTER as the field name */
+        col_name = g_strdup_printf("%s%s", COLUMN_FIELD_FILTER, cinfo->columns[col].col_title);
+        field_index = g_hash_table_lookup(fields->field_indicies, col_name);
+        g_free(col_name);
+
+        if (NULL != field_index) {
+            format_field_values(fields, field_index, g_strdup(cinfo->columns[col].col_data));
         }
     }
+}
+
+static void write_specified_fields(fields_format format, output_fields_t *fields, epan_dissect_t *edt, column_info *cinfo, FILE *fh, json_dumper *dumper)
+{
+    gsize     i;
+
+    write_field_data_t data;
+
+    g_assert(fields);
+    g_assert(fields->fields);
+    g_assert(edt);
+    /* JSON formats must go through json_dumper */
+    if (format == FORMAT_JSON || format == FORMAT_EK) {
+        g_assert(!fh && dumper);
+    } else {
+        g_assert(fh && !dumper);
+    }
+
+    data.fields = fields;
+    data.edt = edt;
+
+    prepare_field_values(fields);
+
+    proto_tree_children_foreach(edt->tree, proto_tree_get_node_field_values,
+                                &data);
+
+    add_column_field_values(fields, cinfo);
 
     switch (format) {
     case FORMAT_CSV:
@@ -2596,6 +2785,231 @@ void write_fields_finale(output_fields_t* fields _U_ , FILE *fh _U_)
     /* Nothing to do */
 }
 
+/* Rows per Arrow record batch */
+#define ARROW_BATCH_ROWS 65536
+
+static arrow_type_e arrow_ftype(ftenum_t type)
+{
+    switch (type) {
+    case FT_BOOLEAN:
+        return ARROW_TYPE_BOOL;
+    case FT_UINT8:
+    case FT_UINT16:
+    case FT_UINT24:
+    case FT_UINT32:
+    case FT_FRAMENUM:
+    case FT_INT8:
+    case FT_INT16:
+    case FT_INT24:
+    case FT_INT32:
+    case FT_INT40:
+    case FT_INT48:
+    case FT_INT56:
+    case FT_INT64:
+        return ARROW_TYPE_INT64;
+    case FT_UINT40:
+    case FT_UINT48:
+    case FT_UINT56:
+    case FT_UINT64:
+        return ARROW_TYPE_UINT64;
+    case FT_IPv4:
+        return ARROW_TYPE_UINT32;
+    case FT_FLOAT:
+    case FT_DOUBLE:
+    case FT_RELATIVE_TIME:
+        return ARROW_TYPE_DOUBLE;
+    case FT_ABSOLUTE_TIME:
+        return ARROW_TYPE_TIMESTAMP;
+    default:
+        return ARROW_TYPE_UTF8;
+    }
+}
+
+/* The type of a field's column; fields of several types, columns, and
+ * fields written as text by -T fields are strings. */
+static arrow_type_e arrow_field_type(const gchar *field)
+{
+    header_field_info *hfinfo;
+    arrow_type_e       type;
+
+    if (!strncmp(field, COLUMN_FIELD_FILTER, strlen(COLUMN_FIELD_FILTER)))
+        return ARROW_TYPE_UTF8;
+
+    hfinfo = proto_registrar_get_byname(field);
+    if (hfinfo == NULL || hfinfo->id == hf_text_only || hfinfo->id == proto_data)
+        return ARROW_TYPE_UTF8;
+
+    type = arrow_ftype(hfinfo->type);
+    for (hfinfo = hfinfo->same_name_next; hfinfo != NULL; hfinfo = hfinfo->same_name_next) {
+        if (arrow_ftype(hfinfo->type) != type)
+            return ARROW_TYPE_UTF8;
+    }
+    return type;
+}
+
+arrow_writer *write_arrow_preamble(output_fields_t* fields, FILE *fh)
+{
+    arrow_writer *writer;
+    gsize         i;
+
+    g_assert(fields);
+    g_assert(fh);
+    g_assert(fields->fields);
+
+    prepare_field_values(fields);
+    if (NULL == fields->arrow_types) {
+        fields->arrow_types = g_new(arrow_type_e, fields->fields->len);
+        fields->arrow_values = g_new0(field_info *, fields->fields->len);
+    }
+
+    writer = arrow_writer_new(fh, ARROW_BATCH_ROWS);
+    for (i = 0; i < fields->fields->len; i++) {
+        const gchar *field = (const gchar *)g_ptr_array_index(fields->fields, i);
+
+        fields->arrow_types[i] = arrow_field_type(field);
+        arrow_writer_add_column(writer, field, fields->arrow_types[i]);
+    }
+    return writer;
+}
+
+static void proto_tree_get_node_arrow_values(proto_node *node, gpointer data)
+{
+    write_field_data_t *call_data;
+    output_fields_t    *fields;
+    field_info         *fi;
+    gpointer            field_index;
+
+    call_data = (write_field_data_t *)data;
+    fields = call_data->fields;
+    fi = PNODE_FINFO(node);
+
+    /* dissection with an invisible proto tree? */
+    g_assert(fi);
+
+    field_index = g_hash_table_lookup(fields->field_indicies, fi->hfinfo->abbrev);
+    if (NULL != field_index) {
+        guint indx = GPOINTER_TO_UINT(field_index) - 1;
+
+        /* Strings are formatted as with -T fields; other values are
+         * taken from the occurrence asked for, the first unless it's
+         * the last. */
+        if (fields->arrow_types[indx] == ARROW_TYPE_UTF8)
+            format_field_values(fields, field_index, get_node_field_value(fi, call_data->edt));
+        else if (fields->arrow_values[indx] == NULL || fields->occurrence == 'l')
+            fields->arrow_values[indx] = fi;
+    }
+
+    /* Recurse here. */
+    if (node->first_child != NULL) {
+        proto_tree_children_foreach(node, proto_tree_get_node_arrow_values,
+                                    call_data);
+    }
+}
+
+static void write_arrow_value(arrow_writer *writer, guint column, arrow_type_e type, field_info *fi)
+{
+    const nstime_t *ts;
+
+    switch (type) {
+    case ARROW_TYPE_BOOL:
+        arrow_writer_set_bool(writer, column, fvalue_get_uinteger64(&fi->value) != 0);
+        break;
+    case ARROW_TYPE_INT64:
+        switch (fi->hfinfo->type) {
+        case FT_INT8:
+        case FT_INT16:
+        case FT_INT24:
+        case FT_INT32:
+            arrow_writer_set_int64(writer, column, fvalue_get_sinteger(&fi->value));
+            break;
+        case FT_INT40:
+        case FT_INT48:
+        case FT_INT56:
+        case FT_INT64:
+            arrow_writer_set_int64(writer, column, fvalue_get_sinteger64(&fi->value));
+            break;
+        default:
+            arrow_writer_set_int64(writer, column, fvalue_get_uinteger(&fi->value));
+            break;
+        }
+        break;
+    case ARROW_TYPE_UINT64:
+        arrow_writer_set_uint64(writer, column, fvalue_get_uinteger64(&fi->value));
+        break;
+    case ARROW_TYPE_UINT32:
+        arrow_writer_set_uint64(writer, column, ((const ipv4_addr_and_mask *)fvalue_get(&fi->value))->addr);
+        break;
+    case ARROW_TYPE_DOUBLE:
+        if (fi->hfinfo->type == FT_RELATIVE_TIME) {
+            ts = (const nstime_t *)fvalue_get(&fi->value);
+            arrow_writer_set_double(writer, column, nstime_to_sec(ts));
+        } else {
+            arrow_writer_set_double(writer, column, fvalue_get_floating(&fi->value));
+        }
+        break;
+    case ARROW_TYPE_TIMESTAMP:
+        ts = (const nstime_t *)fvalue_get(&fi->value);
+        arrow_writer_set_int64(writer, column, (gint64)ts->secs * 1000000000 + ts->nsecs);
+        break;
+    default:
+        g_assert_not_reached();
+        break;
+    }
+}
+
+gboolean write_arrow_proto_tree(output_fields_t *fields, epan_dissect_t *edt, column_info *cinfo, arrow_writer *writer)
+{
+    write_field_data_t data;
+    GString           *str;
+    gsize              i, j;
+
+    g_assert(fields);
+    g_assert(fields->arrow_types);
+    g_assert(edt);
+    g_assert(writer);
+
+    data.fields = fields;
+    data.edt = edt;
+
+    proto_tree_children_foreach(edt->tree, proto_tree_get_node_arrow_values,
+                                &data);
+    add_column_field_values(fields, cinfo);
+
+    str = NULL;
+    for (i = 0; i < fields->fields->len; i++) {
+        if (fields->arrow_types[i] != ARROW_TYPE_UTF8) {
+            if (NULL != fields->arrow_values[i]) {
+                write_arrow_value(writer, (guint)i, fields->arrow_types[i], fields->arrow_values[i]);
+                fields->arrow_values[i] = NULL;
+            }
+        } else if (NULL != fields->field_values[i]) {
+            GPtrArray *fv_p = fields->field_values[i];
+
+            /* The (partial) field values, with the aggregators between
+             * them, make up the string. */
+            if (str == NULL)
+                str = g_string_new(NULL);
+            g_string_truncate(str, 0);
+            for (j = 0; j < g_ptr_array_len(fv_p); j++) {
+                g_string_append(str, (const gchar *)g_ptr_array_index(fv_p, j));
+                g_free(g_ptr_array_index(fv_p, j));
+            }
+            arrow_writer_set_string(writer, (guint)i, str->str, (gssize)str->len);
+            g_ptr_array_free(fv_p, TRUE);  /* get ready for the next packet */
+            fields->field_values[i] = NULL;
+        }
+    }
+    if (str != NULL)
+        g_string_free(str, TRUE);
+
+    return arrow_writer_end_row(writer);
+}
+
+gboolean write_arrow_finale(arrow_writer *writer)
+{
+    return arrow_writer_finish(writer);
+}
+
 /* Returns an g_malloced string */
 gchar* get_node_field_value(field_info* fi, epan_dissect_t* edt)
 {
@@ -2733,6 +3147,9 @@ output_fields_t* output_fields_new(void)
     fields->field_values        = NULL;
     fields->quote               ='\0';
     fields->includes_col_fields = FALSE;
+    fields->prime_hfids         = NULL;
+    fields->arrow_types         = NULL;
+    fields->arrow_values        = NULL;
     return fields;
 }
 
@@ -20,6 +20,7 @@
 #include <epan/print_stream.h>
 
 #include <wsutil/json_dumper.h>
+#include <wsutil/arrow_writer.h>
 
 #include "ws_symbol_export.h"
 
@@ -51,7 +52,8 @@ typedef enum {
 
 typedef enum {
   PF_NONE = 0x00,
-  PF_INCLUDE_CHILDREN = 0x01
+  PF_INCLUDE_CHILDREN = 0x01,
+  PF_PDML_COMPACT = 0x02      /* PDML without indentation and redundant attributes */
 } pf_flags;
 
 /*
@@ -70,6 +72,16 @@ WS_DLL_PUBLIC gsize output_fields_num_fields(output_fields_t* info);
 WS_DLL_PUBLIC gboolean output_fields_set_option(output_fields_t* info, gchar* option);
 WS_DLL_PUBLIC void output_fields_list_options(FILE *fh);
 WS_DLL_PUBLIC gboolean output_fields_has_cols(output_fields_t* info);
+WS_DLL_PUBLIC gboolean output_fields_has_col(output_fields_t* info, const gchar *col_title);
+
+/*
+ * Does writing the fields need a visible protocol tree?  If not, an
+ * invisible tree primed with output_fields_prime_edt() before each
+ * packet is dissected has all of them, and it's cheaper to build, as
+ * no other fields are added to it.
+ */
+WS_DLL_PUBLIC gboolean output_fields_need_visible_tree(output_fields_t* info);
+WS_DLL_PUBLIC void output_fields_prime_edt(output_fields_t* info, epan_dissect_t *edt);
 
 /*
  * Higher-level packet-printing code.
@@ -125,6 +137,17 @@ WS_DLL_PUBLIC void write_fields_preamble(output_fields_t* fields, FILE *fh);
 WS_DLL_PUBLIC void write_fields_proto_tree(output_fields_t* fields, epan_dissect_t *edt, column_info *cinfo, FILE *fh);
 WS_DLL_PUBLIC void write_fields_finale(output_fields_t* fields, FILE *fh);
 
+/*
+ * The fields, written as an Apache Arrow IPC stream with a column for each
+ * of them.  Integers, booleans, floating-point numbers, IPv4 addresses and
+ * times keep their types, taking the value of one occurrence of the field,
+ * the first unless the "occurrence" option asks for the last; other fields
+ * are strings, as written by write_fields_proto_tree().
+ */
+WS_DLL_PUBLIC arrow_writer *write_arrow_preamble(output_fields_t* fields, FILE *fh);
+WS_DLL_PUBLIC gboolean write_arrow_proto_tree(output_fields_t* fields, epan_dissect_t *edt, column_info *cinfo, arrow_writer *writer);
+WS_DLL_PUBLIC gboolean write_arrow_finale(arrow_writer *writer);
+
 WS_DLL_PUBLIC gchar* get_node_field_value(field_info* fi, epan_dissect_t* edt);
 
 extern void print_cache_field_handles(void);
@@ -44,6 +44,7 @@
 #include "show_exception.h"
 #include "in_cksum.h"
 #include "register-int.h"
+#include "plugin_manifest.h"
 
 #include <wsutil/ws_printf.h> /* ws_debug_printf */
 #include <wsutil/crash_info.h>
@@ -195,6 +196,7 @@ struct ptvcursor {
 
 
 static const char *hf_try_val_to_str(guint32 value, const header_field_info *hfinfo);
+static void hf_vs_index_forget(const header_field_info *hfinfo);
 static const char *hf_try_val64_to_str(guint64 value, const header_field_info *hfinfo);
 static int hfinfo_bitoffset(const header_field_info *hfinfo);
 static int hfinfo_mask_bitwidth(const header_field_info *hfinfo);
@@ -264,6 +266,8 @@ proto_tree_set_time(field_info *fi, const nstime_t *value_ptr);
 static void
 proto_tree_set_string(field_info *fi, const char* value);
 static void
+proto_tree_set_string_pooled(field_info *fi, const char* value);
+static void
 proto_tree_set_ax25(field_info *fi, const guint8* value);
 static void
 proto_tree_set_ax25_tvb(field_info *fi, tvbuff_t *tvb, gint start);
@@ -364,13 +368,99 @@ static GList *protocols = NULL;
 static GPtrArray *deregistered_fields = NULL;
 static GPtrArray *deregistered_data = NULL;
 
+/* Changed whenever a field is registered or deregistered */
+static guint registrar_generation = 0;
+
 /* indexed by prefix, contains initializers */
 static GHashTable* prefixes = NULL;
 
+/*
+ * proto_nodes and field_infos are allocated from slabs belonging to the
+ * tree root.  A slab is a list of chunks, each holding a fixed number of
+ * objects of one size; the chunks are kept until the tree is freed, so
+ * that resetting the tree for the next packet just rewinds its slabs.
+ */
+#define NODE_SLAB_CHUNK_OBJS	256
+
+typedef struct _node_slab_chunk {
+	struct _node_slab_chunk *next;
+} node_slab_chunk_t;
+
+/* Keep the objects in a chunk aligned for any type they hold. */
+#define NODE_SLAB_CHUNK_HDR	((sizeof(node_slab_chunk_t) + 15) & ~(gsize)15)
+
+struct _node_slab {
+	gsize              obj_size;
+	node_slab_chunk_t *first;
+	node_slab_chunk_t *cur;         /* chunk we're allocating from */
+	guint              cur_used;    /* objects used in cur */
+	guint              used;        /* objects used in all chunks */
+	guint              high_water;  /* most objects used for one packet */
+};
+
+static struct _node_slab *
+node_slab_new(gsize obj_size)
+{
+	struct _node_slab *slab = g_new(struct _node_slab, 1);
+
+	slab->obj_size = obj_size;
+	slab->first = NULL;
+	slab->cur = NULL;
+	slab->cur_used = NODE_SLAB_CHUNK_OBJS;
+	slab->used = 0;
+	slab->high_water = 0;
+	return slab;
+}
+
+static void *
+node_slab_alloc(struct _node_slab *slab)
+{
+	if (G_UNLIKELY(slab->cur_used == NODE_SLAB_CHUNK_OBJS)) {
+		node_slab_chunk_t *next = slab->cur ? slab->cur->next : slab->first;
+
+		if (next == NULL) {
+			next = (node_slab_chunk_t *)g_malloc(NODE_SLAB_CHUNK_HDR +
+			    NODE_SLAB_CHUNK_OBJS * slab->obj_size);
+			next->next = NULL;
+			if (slab->cur)
+				slab->cur->next = next;
+			else
+				slab->first = next;
+		}
+		slab->cur = next;
+		slab->cur_used = 0;
+	}
+	slab->used++;
+	return (guint8 *)slab->cur + NODE_SLAB_CHUNK_HDR +
+	    slab->cur_used++ * slab->obj_size;
+}
+
+static void
+node_slab_reset(struct _node_slab *slab)
+{
+	if (slab->used > slab->high_water)
+		slab->high_water = slab->used;
+	slab->cur = NULL;
+	slab->cur_used = NODE_SLAB_CHUNK_OBJS;
+	slab->used = 0;
+}
+
+static void
+node_slab_free(struct _node_slab *slab)
+{
+	node_slab_chunk_t *chunk, *next;
+
+	for (chunk = slab->first; chunk != NULL; chunk = next) {
+		next = chunk->next;
+		g_free(chunk);
+	}
+	g_free(slab);
+}
+
 /* Contains information about a field when a dissector calls
  * proto_tree_add_item.  */
-#define FIELD_INFO_NEW(pool, fi)  fi = wmem_new(pool, field_info)
-#define FIELD_INFO_FREE(pool, fi) wmem_free(pool, fi)
+#define FIELD_INFO_NEW(tree_data, fi) \
+	fi = (field_info *)node_slab_alloc((tree_data)->finfo_slab)
 
 /* Contains the space for proto_nodes. */
 #define PROTO_NODE_INIT(node)			\
@@ -378,8 +468,8 @@ static GHashTable* prefixes = NULL;
 	node->last_child = NULL;		\
 	node->next = NULL;
 
-#define PROTO_NODE_FREE(pool, node)			\
-	wmem_free(pool, node)
+#define PROTO_NODE_NEW(tree_data, node) \
+	node = (proto_node *)node_slab_alloc((tree_data)->node_slab)
 
 /* String space for protocol and field items for the GUI */
 #define ITEM_LABEL_NEW(pool, il)			\
@@ -417,6 +507,14 @@ static GHashTable *gpa_protocol_aliases = NULL;
 static char *last_field_name = NULL;
 static header_field_info *last_hfinfo;
 
+/*
+ * The names in gpa_name_map, in order without regard to case, to find
+ * those that begin with a prefix.  Built when first needed and again
+ * when the registry has changed.
+ */
+static GPtrArray *abbrev_index = NULL;
+static guint abbrev_index_generation;
+
 static void save_same_name_hfinfo(gpointer data)
 {
 	same_name_hfinfo = (header_field_info*)data;
@@ -450,6 +548,9 @@ static GSList *dissector_plugins = NULL;
 void
 proto_register_plugin(const proto_plugin *plug)
 {
+	/* A plugin loaded after startup registers itself when it's loaded. */
+	if (plugin_manifest_note_plugin(plug))
+		return;
 	dissector_plugins = g_slist_prepend(dissector_plugins, (proto_plugin *)plug);
 }
 #else /* HAVE_PLUGINS */
@@ -466,7 +567,9 @@ call_plugin_register_protoinfo(gpointer data, gpointer user_data _U_)
 	proto_plugin *plug = (proto_plugin *)data;
 
 	if (plug->register_protoinfo) {
+		plugin_manifest_begin(plug);
 		plug->register_protoinfo();
+		plugin_manifest_end();
 	}
 }
 
@@ -476,7 +579,9 @@ call_plugin_register_handoff(gpointer data, gpointer user_data _U_)
 	proto_plugin *plug = (proto_plugin *)data;
 
 	if (plug->register_handoff) {
+		plugin_manifest_begin(plug);
 		plug->register_handoff();
+		plugin_manifest_end();
 	}
 }
 
@@ -576,6 +681,19 @@ proto_cleanup_base(void)
 	g_free(last_field_name);
 	last_field_name = NULL;
 
+	if (abbrev_index) {
+		g_ptr_array_free(abbrev_index, TRUE);
+		abbrev_index = NULL;
+	}
+
+	if (hf_vs_indexes) {
+		g_hash_table_destroy(hf_vs_indexes);
+		hf_vs_indexes = NULL;
+	}
+	g_free(hf_vs_index_by_id);
+	hf_vs_index_by_id = NULL;
+	hf_vs_index_by_id_len = 0;
+
 	while (protocols) {
 		protocol = (protocol_t *)protocols->data;
 		PROTO_REGISTRAR_GET_NTH(protocol->proto_id, hfinfo);
@@ -770,6 +888,12 @@ proto_tree_reset(proto_tree *tree)
 	/* Reset track of the number of children */
 	tree_data->count = 0;
 
+	/* All the nodes are gone; reuse their space for the next packet. */
+	tree_data->packets++;
+	tree_data->total_nodes += tree_data->node_slab->used;
+	node_slab_reset(tree_data->node_slab);
+	node_slab_reset(tree_data->finfo_slab);
+
 	PROTO_NODE_INIT(tree);
 }
 
@@ -791,6 +915,15 @@ proto_tree_free(proto_tree *tree)
 		g_hash_table_destroy(tree_data->interesting_hfids);
 	}
 
+	if (tree_data->packets != 0) {
+		g_debug("proto_tree: %" G_GUINT64_FORMAT " packets, %.1f nodes per packet, at most %u",
+		    tree_data->packets,
+		    (double)tree_data->total_nodes / (double)tree_data->packets,
+		    MAX(tree_data->node_slab->high_water, tree_data->node_slab->used));
+	}
+	node_slab_free(tree_data->node_slab);
+	node_slab_free(tree_data->finfo_slab);
+
 	g_slice_free(tree_data_t, tree_data);
 
 	g_slice_free(proto_tree, tree);
@@ -856,6 +989,12 @@ proto_registrar_get_nth(guint hfindex)
 	return hfinfo;
 }
 
+guint
+proto_registrar_get_generation(void)
+{
+	return registrar_generation;
+}
+
 
 /*	Prefix initialization
  *	  this allows for a dissector to register a display filter name prefix
@@ -1006,6 +1145,72 @@ proto_registrar_get_byalias(const char *alias_name)
 	return hfinfo;
 }
 
+static gint
+abbrev_index_compare(gconstpointer a, gconstpointer b)
+{
+	const header_field_info *hfinfo_a = *(const header_field_info * const *)a;
+	const header_field_info *hfinfo_b = *(const header_field_info * const *)b;
+
+	return g_ascii_strcasecmp(hfinfo_a->abbrev, hfinfo_b->abbrev);
+}
+
+static void
+abbrev_index_update(void)
+{
+	GHashTableIter     iter;
+	gpointer           value;
+	header_field_info *hfinfo;
+
+	if (abbrev_index) {
+		if (abbrev_index_generation == registrar_generation)
+			return;
+		g_ptr_array_free(abbrev_index, TRUE);
+	}
+
+	abbrev_index = g_ptr_array_sized_new(g_hash_table_size(gpa_name_map));
+	g_hash_table_iter_init(&iter, gpa_name_map);
+	while (g_hash_table_iter_next(&iter, NULL, &value)) {
+		/* The map has the last field registered under the name. */
+		hfinfo = (header_field_info *)value;
+		while (hfinfo->same_name_prev_id != -1) {
+			PROTO_REGISTRAR_GET_NTH(hfinfo->same_name_prev_id, hfinfo);
+		}
+		g_ptr_array_add(abbrev_index, hfinfo);
+	}
+	g_ptr_array_sort(abbrev_index, abbrev_index_compare);
+	abbrev_index_generation = registrar_generation;
+}
+
+void
+proto_registrar_foreach_prefix(const char *prefix, GFunc func, gpointer user_data)
+{
+	header_field_info *hfinfo;
+	size_t             prefix_len = strlen(prefix);
+	guint              low, high, mid;
+
+	abbrev_index_update();
+
+	/* Find the first name that doesn't sort before the prefix... */
+	low = 0;
+	high = abbrev_index->len;
+	while (low < high) {
+		mid = low + (high - low) / 2;
+		hfinfo = (header_field_info *)g_ptr_array_index(abbrev_index, mid);
+		if (g_ascii_strncasecmp(hfinfo->abbrev, prefix, prefix_len) < 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	/* ...and go on while they begin with it. */
+	for (; low < abbrev_index->len; low++) {
+		hfinfo = (header_field_info *)g_ptr_array_index(abbrev_index, low);
+		if (g_ascii_strncasecmp(hfinfo->abbrev, prefix, prefix_len) != 0)
+			break;
+		func(hfinfo, user_data);
+	}
+}
+
 int
 proto_registrar_get_id_byname(const char *field_name)
 {
@@ -2816,9 +3021,9 @@ proto_tree_new_item(field_info *new_fi, proto_tree *tree,
 			break;
 
 		case FT_STRING:
-			stringval = get_string_value(wmem_packet_scope(),
+			stringval = get_string_value(PNODE_POOL(tree),
 			    tvb, start, length, &length, encoding);
-			proto_tree_set_string(new_fi, stringval);
+			proto_tree_set_string_pooled(new_fi, stringval);
 
 			/* Instead of calling proto_item_set_len(), since we
 			 * don't yet have a proto_item, we set the
@@ -2833,9 +3038,9 @@ proto_tree_new_item(field_info *new_fi, proto_tree *tree,
 			break;
 
 		case FT_STRINGZ:
-			stringval = get_stringz_value(wmem_packet_scope(),
+			stringval = get_stringz_value(PNODE_POOL(tree),
 			    tree, tvb, start, length, &length, encoding);
-			proto_tree_set_string(new_fi, stringval);
+			proto_tree_set_string_pooled(new_fi, stringval);
 
 			/* Instead of calling proto_item_set_len(),
 			 * since we don't yet have a proto_item, we
@@ -2864,9 +3069,9 @@ proto_tree_new_item(field_info *new_fi, proto_tree *tree,
 			 */
 			if (encoding == TRUE)
 				encoding = ENC_ASCII|ENC_LITTLE_ENDIAN;
-			stringval = get_uint_string_value(wmem_packet_scope(),
+			stringval = get_uint_string_value(PNODE_POOL(tree),
 			    tree, tvb, start, length, &length, encoding);
-			proto_tree_set_string(new_fi, stringval);
+			proto_tree_set_string_pooled(new_fi, stringval);
 
 			/* Instead of calling proto_item_set_len(), since we
 			 * don't yet have a proto_item, we set the
@@ -2881,9 +3086,9 @@ proto_tree_new_item(field_info *new_fi, proto_tree *tree,
 			break;
 
 		case FT_STRINGZPAD:
-			stringval = get_stringzpad_value(wmem_packet_scope(),
+			stringval = get_stringzpad_value(PNODE_POOL(tree),
 			    tvb, start, length, &length, encoding);
-			proto_tree_set_string(new_fi, stringval);
+			proto_tree_set_string_pooled(new_fi, stringval);
 
 			/* Instead of calling proto_item_set_len(), since we
 			 * don't yet have a proto_item, we set the
@@ -2898,9 +3103,9 @@ proto_tree_new_item(field_info *new_fi, proto_tree *tree,
 			break;
 
 		case FT_STRINGZTRUNC:
-			stringval = get_stringztrunc_value(wmem_packet_scope(),
+			stringval = get_stringztrunc_value(PNODE_POOL(tree),
 			    tvb, start, length, &length, encoding);
-			proto_tree_set_string(new_fi, stringval);
+			proto_tree_set_string_pooled(new_fi, stringval);
 
 			/* Instead of calling proto_item_set_len(), since we
 			 * don't yet have a proto_item, we set the
@@ -4931,7 +5136,8 @@ proto_tree_add_string(proto_tree *tree, int hfindex, tvbuff_t *tvb, gint start,
 
 	pi = proto_tree_add_pi(tree, hfinfo, tvb, start, &length);
 	DISSECTOR_ASSERT(length >= 0);
-	proto_tree_set_string(PNODE_FINFO(pi), value);
+	proto_tree_set_string_pooled(PNODE_FINFO(pi),
+	    value ? wmem_strdup(PNODE_POOL(tree), value) : NULL);
 
 	return pi;
 }
@@ -4990,6 +5196,18 @@ proto_tree_set_string(field_info *fi, const char* value)
 	}
 }
 
+/* Set the FT_STRING value to a string allocated in the pool of the
+ * field's tree, which lasts as long as the field does */
+static void
+proto_tree_set_string_pooled(field_info *fi, const char* value)
+{
+	if (value) {
+		fvalue_set_string_pooled(&fi->value, value);
+	} else {
+		fvalue_set_string_pooled(&fi->value, "[ Null ]");
+	}
+}
+
 /* Set the FT_AX25 value */
 static void
 proto_tree_set_ax25(field_info *fi, const guint8* value)
@@ -5886,7 +6104,7 @@ proto_tree_add_node(proto_tree *tree, field_info *fi)
 		/* XXX - is it safe to continue here? */
 	}
 
-	pnode = wmem_new(PNODE_POOL(tree), proto_node);
+	PROTO_NODE_NEW(PTREE_DATA(tree), pnode);
 	PROTO_NODE_INIT(pnode);
 	pnode->parent = tnode;
 	PNODE_FINFO(pnode) = fi;
@@ -6216,7 +6434,7 @@ new_field_info(proto_tree *tree, header_field_info *hfinfo, tvbuff_t *tvb,
 {
 	field_info *fi;
 
-	FIELD_INFO_NEW(PNODE_POOL(tree), fi);
+	FIELD_INFO_NEW(PTREE_DATA(tree), fi);
 
 	fi->hfinfo     = hfinfo;
 	fi->start      = start;
@@ -6666,13 +6884,12 @@ proto_custom_set(proto_tree* tree, GSList *field_ids, gint occurrence,
 	char number_buf[48];
 	const char *number_out;
 	char *str;
-	int *field_idx;
+	GSList *field_id_item;
 	int field_id;
-	int ii = 0;
 
 	g_assert(field_ids != NULL);
-	while ((field_idx = (int *) g_slist_nth_data(field_ids, ii++))) {
-		field_id = *field_idx;
+	for (field_id_item = field_ids; field_id_item != NULL; field_id_item = field_id_item->next) {
+		field_id = *(int *)field_id_item->data;
 		PROTO_REGISTRAR_GET_NTH((guint)field_id, hfinfo);
 
 		/* do we need to rewind ? */
@@ -7134,9 +7351,25 @@ proto_tree_create_root(packet_info *pinfo)
 	/* Keep track of the number of children */
 	pnode->tree_data->count = 0;
 
+	pnode->tree_data->node_slab = node_slab_new(sizeof(proto_node));
+	pnode->tree_data->finfo_slab = node_slab_new(sizeof(field_info));
+	pnode->tree_data->packets = 0;
+	pnode->tree_data->total_nodes = 0;
+
 	return (proto_tree *)pnode;
 }
 
+void
+proto_tree_get_node_stats(proto_tree *tree, proto_tree_node_stats_t *stats)
+{
+	tree_data_t *tree_data = PTREE_DATA(tree);
+
+	stats->nodes = tree_data->node_slab->used;
+	stats->high_water = MAX(tree_data->node_slab->high_water, stats->nodes);
+	stats->packets = tree_data->packets;
+	stats->total_nodes = tree_data->total_nodes;
+}
+
 
 /* "prime" a proto_tree with a single hfid that a dfilter
  * is interested in. */
@@ -7336,6 +7569,18 @@ check_valid_filter_name_or_fail(const char *filter_name)
 	}
 }
 
+/*
+ * Protocols registered after proto_init(), such as those of plugins
+ * loaded when they're first needed, go into the list in order.
+ */
+static GList *
+proto_list_add(GList *list, protocol_t *protocol)
+{
+	if (tree_is_expanded != NULL)
+		return g_list_insert_sorted(list, protocol, proto_compare_name);
+	return g_list_prepend(list, protocol);
+}
+
 int
 proto_register_protocol(const char *name, const char *short_name,
 			const char *filter_name)
@@ -7385,7 +7630,7 @@ proto_register_protocol(const char *name, const char *short_name,
 	protocol->heur_list = NULL;
 
 	/* List will be sorted later by name, when all protocols completed registering */
-	protocols = g_list_prepend(protocols, protocol);
+	protocols = proto_list_add(protocols, protocol);
 	g_hash_table_insert(proto_names, (gpointer)name, protocol);
 	g_hash_table_insert(proto_filter_names, (gpointer)filter_name, protocol);
 	g_hash_table_insert(proto_short_names, (gpointer)short_name, protocol);
@@ -7403,6 +7648,7 @@ proto_register_protocol(const char *name, const char *short_name,
 	hfinfo->parent = -1; /* This field differentiates protos and fields */
 
 	protocol->proto_id = proto_register_field_init(hfinfo, hfinfo->parent);
+	plugin_manifest_note(PLUGIN_MANIFEST_PROTOCOL, filter_name);
 	return protocol->proto_id;
 }
 
@@ -7444,7 +7690,7 @@ proto_register_protocol_in_name_only(const char *name, const char *short_name, c
 	protocol->heur_list = NULL;
 
 	/* List will be sorted later by name, when all protocols completed registering */
-	protocols = g_list_prepend(protocols, protocol);
+	protocols = proto_list_add(protocols, protocol);
 
 	/* Here we allocate a new header_field_info struct */
 	hfinfo = g_slice_new(header_field_info);
@@ -7462,6 +7708,7 @@ proto_register_protocol_in_name_only(const char *name, const char *short_name, c
 	hfinfo->parent = -1; /* This field differentiates protos and fields */
 
 	protocol->proto_id = proto_register_field_init(hfinfo, hfinfo->parent);
+	plugin_manifest_note(PLUGIN_MANIFEST_PROTOCOL, filter_name);
 	return protocol->proto_id;
 }
 
@@ -7500,6 +7747,7 @@ proto_deregister_protocol(const char *short_name)
 
 	g_ptr_array_add(deregistered_fields, gpa_hfinfo.hfi[proto_id]);
 	g_hash_table_steal(gpa_name_map, protocol->filter_name);
+	registrar_generation++;
 
 	g_free(last_field_name);
 	last_field_name = NULL;
@@ -7994,8 +8242,10 @@ proto_deregister_field (const int parent, gint hf_id)
 		if (hfi->id == hf_id) {
 			/* Found the hf_id in this protocol */
 			g_hash_table_steal(gpa_name_map, hfi->abbrev);
+			hf_vs_index_forget(hfi);
 			g_ptr_array_remove_index_fast(proto->fields, i);
 			g_ptr_array_add(deregistered_fields, gpa_hfinfo.hfi[hf_id]);
+			registrar_generation++;
 			return;
 		}
 	}
@@ -8797,6 +9047,8 @@ proto_register_field_init(header_field_info *hfinfo, const int parent)
 
 	tmp_fld_check_assert(hfinfo);
 
+	registrar_generation++;
+
 	hfinfo->parent         = parent;
 	hfinfo->same_name_next = NULL;
 	hfinfo->same_name_prev_id = -1;
@@ -9378,9 +9630,84 @@ fill_label_boolean(field_info *fi, gchar *label_str)
 	label_fill(label_str, bitfield_byte_length, hfinfo, tfs_get_string(!!value, tfstring));
 }
 
+/*
+ * The plain value_strings of the integer fields are searched linearly by
+ * try_val_to_str(). Those with enough entries are indexed instead, with a
+ * value_string_ext, the first time a value of a field that has one is
+ * looked up, so that registration costs nothing more; the fields that
+ * share a value_string share its index.
+ */
+#define HF_VS_INDEX_MIN_ENTRIES	16
+
+typedef struct {
+	const value_string *vs;
+	value_string_ext *vse;		/* NULL if vs is too short to index */
+} hf_vs_index_t;
+
+/* value_string -> hf_vs_index_t */
+static GHashTable *hf_vs_indexes = NULL;
+
+/* Field id -> its hf_vs_index_t, NULL until it's needed */
+static hf_vs_index_t **hf_vs_index_by_id = NULL;
+static guint32 hf_vs_index_by_id_len = 0;
+
+static hf_vs_index_t *
+hf_vs_index_get(const header_field_info *hfinfo)
+{
+	const value_string *vs = (const value_string *)hfinfo->strings;
+	hf_vs_index_t *index;
+	guint n;
+
+	if ((guint32)hfinfo->id >= hf_vs_index_by_id_len) {
+		guint32 len = gpa_hfinfo.len;
+
+		hf_vs_index_by_id = (hf_vs_index_t **)g_realloc(hf_vs_index_by_id, len * sizeof (hf_vs_index_t *));
+		memset(hf_vs_index_by_id + hf_vs_index_by_id_len, 0, (len - hf_vs_index_by_id_len) * sizeof (hf_vs_index_t *));
+		hf_vs_index_by_id_len = len;
+	}
+
+	index = hf_vs_index_by_id[hfinfo->id];
+	if (index != NULL && index->vs == vs)
+		return index;
+
+	/* Not looked at yet, or the field's value_string has been changed */
+	if (hf_vs_indexes == NULL)
+		hf_vs_indexes = g_hash_table_new(g_direct_hash, g_direct_equal);
+	index = (hf_vs_index_t *)g_hash_table_lookup(hf_vs_indexes, vs);
+	if (index == NULL) {
+		index = wmem_new(wmem_epan_scope(), hf_vs_index_t);
+		index->vs = vs;
+		for (n = 0; n < HF_VS_INDEX_MIN_ENTRIES && vs[n].strptr != NULL; n++)
+			;
+		if (n < HF_VS_INDEX_MIN_ENTRIES) {
+			index->vse = NULL;
+		} else {
+			while (vs[n].strptr != NULL)
+				n++;
+			index->vse = value_string_ext_new_any_order(vs, n + 1, hfinfo->abbrev);
+		}
+		g_hash_table_insert(hf_vs_indexes, (gpointer)vs, index);
+	}
+	hf_vs_index_by_id[hfinfo->id] = index;
+	return index;
+}
+
+/* Forget the index of a field that's going away, and of its value_string,
+   which the field's owner may free */
+static void
+hf_vs_index_forget(const header_field_info *hfinfo)
+{
+	if ((guint32)hfinfo->id < hf_vs_index_by_id_len)
+		hf_vs_index_by_id[hfinfo->id] = NULL;
+	if (hf_vs_indexes != NULL && hfinfo->strings != NULL)
+		g_hash_table_remove(hf_vs_indexes, hfinfo->strings);
+}
+
 static const char *
 hf_try_val_to_str(guint32 value, const header_field_info *hfinfo)
 {
+	hf_vs_index_t *index;
+
 	if (hfinfo->display & BASE_RANGE_STRING)
 		return try_rval_to_str(value, (const range_string *) hfinfo->strings);
 
@@ -9397,7 +9724,12 @@ hf_try_val_to_str(guint32 value, const header_field_info *hfinfo)
 	if (hfinfo->display & BASE_UNIT_STRING)
 		return unit_name_string_get_value(value, (const struct unit_name_string*) hfinfo->strings);
 
-	return try_val_to_str(value, (const value_string *) hfinfo->strings);
+	if (hfinfo->strings == NULL)
+		return NULL;
+	index = hf_vs_index_get(hfinfo);
+	if (index->vse != NULL)
+		return try_val_to_str_ext(value, index->vse);
+	return try_val_to_str(value, index->vs);
 }
 
 static const char *
@@ -12911,7 +13243,7 @@ proto_tree_add_ts_23_038_7bits_packed_item(proto_tree *tree, const int hfindex,
 	byte_length = (((no_of_chars + 1) * 7) + (bit_offset & 0x07)) >> 3;
 	byte_offset = bit_offset >> 3;
 
-	string = tvb_get_ts_23_038_7bits_string_packed(wmem_packet_scope(), tvb, bit_offset, no_of_chars);
+	string = tvb_get_ts_23_038_7bits_string_packed(PNODE_POOL(tree), tvb, bit_offset, no_of_chars);
 
 	if (hfinfo->display == STR_UNICODE) {
 		DISSECTOR_ASSERT(g_utf8_validate(string, -1, NULL));
@@ -12919,7 +13251,7 @@ proto_tree_add_ts_23_038_7bits_packed_item(proto_tree *tree, const int hfindex,
 
 	pi = proto_tree_add_pi(tree, hfinfo, tvb, byte_offset, &byte_length);
 	DISSECTOR_ASSERT(byte_length >= 0);
-	proto_tree_set_string(PNODE_FINFO(pi), string);
+	proto_tree_set_string_pooled(PNODE_FINFO(pi), string);
 
 	return pi;
 }
@@ -12943,7 +13275,7 @@ proto_tree_add_ascii_7bits_item(proto_tree *tree, const int hfindex, tvbuff_t *t
 	byte_length = (((no_of_chars + 1) * 7) + (bit_offset & 0x07)) >> 3;
 	byte_offset = bit_offset >> 3;
 
-	string = tvb_get_ascii_7bits_string(wmem_packet_scope(), tvb, bit_offset, no_of_chars);
+	string = tvb_get_ascii_7bits_string(PNODE_POOL(tree), tvb, bit_offset, no_of_chars);
 
 	if (hfinfo->display == STR_UNICODE) {
 		DISSECTOR_ASSERT(g_utf8_validate(string, -1, NULL));
@@ -12951,7 +13283,7 @@ proto_tree_add_ascii_7bits_item(proto_tree *tree, const int hfindex, tvbuff_t *t
 
 	pi = proto_tree_add_pi(tree, hfinfo, tvb, byte_offset, &byte_length);
 	DISSECTOR_ASSERT(byte_length >= 0);
-	proto_tree_set_string(PNODE_FINFO(pi), string);
+	proto_tree_set_string_pooled(PNODE_FINFO(pi), string);
 
 	return pi;
 }
@@ -861,6 +861,10 @@ typedef struct {
     gboolean             fake_protocols;
     guint                count;
     struct _packet_info *pinfo;
+    struct _node_slab   *node_slab;   /* proto_nodes, reused for each packet */
+    struct _node_slab   *finfo_slab;  /* field_infos, reused for each packet */
+    guint64              packets;     /* number of times the tree has been reset */
+    guint64              total_nodes; /* nodes in the trees of those packets */
 } tree_data_t;
 
 /** Each proto_tree, proto_item is one of these. */
@@ -1160,6 +1164,19 @@ void proto_tree_reset(proto_tree *tree);
  @param tree the tree to free */
 WS_DLL_PUBLIC void proto_tree_free(proto_tree *tree);
 
+/** Statistics about the nodes allocated for a protocol tree root. */
+typedef struct {
+    guint   nodes;        /**< nodes in the tree for the current packet */
+    guint   high_water;   /**< most nodes in the tree for any one packet */
+    guint64 packets;      /**< packets for which the tree has been reset */
+    guint64 total_nodes;  /**< nodes in the trees of those packets */
+} proto_tree_node_stats_t;
+
+/** Get statistics about the nodes allocated for a protocol tree.
+ @param tree the tree root, as created by proto_tree_create_root()
+ @param stats filled in with the statistics */
+WS_DLL_PUBLIC void proto_tree_get_node_stats(proto_tree *tree, proto_tree_node_stats_t *stats);
+
 /** Set the tree visible or invisible.
  Is the parsing being done for a visible proto_tree or an invisible one?
  By setting this correctly, the proto_tree creation is sped up by not
@@ -2511,6 +2528,12 @@ WS_DLL_PUBLIC const char* proto_registrar_get_abbrev(const int n);
  @return the registered item */
 WS_DLL_PUBLIC header_field_info* proto_registrar_get_nth(guint hfindex);
 
+/** Get a number that changes whenever a field is registered or
+ deregistered, so that what was looked up in the registry can be known to
+ be out of date.
+ @return the generation of the registry */
+extern guint proto_registrar_get_generation(void);
+
 /** Get the header_field information based upon a field name.
  @param field_name the field name to search for
  @return the registered item */
@@ -2521,6 +2544,15 @@ WS_DLL_PUBLIC header_field_info* proto_registrar_get_byname(const char *field_na
  @return the registered item */
 WS_DLL_PUBLIC header_field_info* proto_registrar_get_byalias(const char *alias_name);
 
+/** Call a function for each protocol and field whose name begins with a
+ prefix, compared without regard to ASCII case, in the order of their names.
+ Of the fields registered under the same name, only the first is given.
+ The function mustn't register or deregister fields.
+ @param prefix the beginning of the names
+ @param func called with the header_field_info and user_data
+ @param user_data passed to func */
+WS_DLL_PUBLIC void proto_registrar_foreach_prefix(const char *prefix, GFunc func, gpointer user_data);
+
 /** Get the header_field id based upon a field name.
  @param field_name the field name to search for
  @return the field id for the registered item */
@@ -10,6 +10,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <glib.h>
 
 #if 0
@@ -20,9 +22,7 @@
 #include <epan/packet_info.h>
 #include <epan/proto_data.h>
 #include <epan/proto.h>
-#if 0
 #include <epan/packet.h>
-#endif
 #if 0
 #include <epan/timestamp.h>
 #endif
@@ -35,116 +35,127 @@ typedef struct _proto_data {
   void *proto_data;
 } proto_data_t;
 
-static gint
-p_compare(gconstpointer a, gconstpointer b)
+/* The proto data of a frame or of a packet, in a single g_malloc()ed
+   block, sorted by protocol and key so that an entry is found with a
+   binary search rather than by walking a list.  Of the entries with the
+   same protocol and key, the one added last comes first and is the one
+   found, as it was when they were prepended to a list. */
+struct _proto_data_list {
+  guint count;
+  guint size;
+  proto_data_t entries[];
+};
+
+/* Most frames have few entries */
+#define PROTO_DATA_LIST_MIN_SIZE 4
+
+static proto_data_list_t **
+p_get_list(wmem_allocator_t *scope, struct _packet_info* pinfo)
 {
-  const proto_data_t *ap = (const proto_data_t *)a;
-  const proto_data_t *bp = (const proto_data_t *)b;
-
-  if (ap -> proto > bp -> proto) {
-    return 1;
-  } else if (ap -> proto == bp -> proto) {
-    if (ap->key > bp->key){
-      return 1;
-    } else if (ap -> key == bp -> key) {
-      return 0;
-    }
-    return -1;
-  } else {
-    return -1;
+  if (scope == pinfo->pool) {
+    return &pinfo->proto_data;
+  } else if (scope == wmem_file_scope()) {
+    return &pinfo->fd->pfd;
   }
+  DISSECTOR_ASSERT(!"invalid wmem scope");
+  return NULL;
 }
 
-void
-p_add_proto_data(wmem_allocator_t *tmp_scope, struct _packet_info* pinfo, int proto, guint32 key, void *proto_data)
+/* The index of the first entry that isn't before (proto, key) */
+static guint
+p_lower_bound(const proto_data_list_t *list, int proto, guint32 key)
 {
-  proto_data_t     *p1;
-  GSList          **proto_list;
-  wmem_allocator_t *scope;
-
-  if (tmp_scope == pinfo->pool) {
-    scope = tmp_scope;
-    proto_list = &pinfo->proto_data;
-  } else if (tmp_scope == wmem_file_scope()) {
-    scope = wmem_file_scope();
-    proto_list = &pinfo->fd->pfd;
-  } else {
-    DISSECTOR_ASSERT(!"invalid wmem scope");
+  guint lo = 0, hi = list->count, mid;
+
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (list->entries[mid].proto < proto ||
+        (list->entries[mid].proto == proto && list->entries[mid].key < key)) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
   }
+  return lo;
+}
 
-  p1 = wmem_new(scope, proto_data_t);
-
-  p1->proto = proto;
-  p1->key = key;
-  p1->proto_data = proto_data;
+/* The entry for (proto, key), or NULL */
+static proto_data_t *
+p_find(proto_data_list_t *list, int proto, guint32 key)
+{
+  guint i;
 
-  /* Add it to the GSLIST */
-  *proto_list = g_slist_prepend(*proto_list, p1);
+  if (list == NULL)
+    return NULL;
+  i = p_lower_bound(list, proto, key);
+  if (i < list->count && list->entries[i].proto == proto && list->entries[i].key == key)
+    return &list->entries[i];
+  return NULL;
 }
 
-void *
-p_get_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto, guint32 key)
+void
+p_add_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto, guint32 key, void *proto_data)
 {
-  proto_data_t  temp, *p1;
-  GSList       *item;
+  proto_data_list_t **listp = p_get_list(scope, pinfo);
+  proto_data_list_t  *list = *listp;
+  guint               i;
 
-  temp.proto = proto;
-  temp.key = key;
-  temp.proto_data = NULL;
+  if (scope == wmem_file_scope())
+    dissector_state_write("p_add_proto_data");
 
-  if (scope == pinfo->pool) {
-    item = g_slist_find_custom(pinfo->proto_data, &temp, p_compare);
-  } else if (scope == wmem_file_scope()) {
-    item = g_slist_find_custom(pinfo->fd->pfd, &temp, p_compare);
-  } else {
-    DISSECTOR_ASSERT(!"invalid wmem scope");
-  }
+  if (list == NULL || list->count == list->size) {
+    guint size = list ? list->size * 2 : PROTO_DATA_LIST_MIN_SIZE;
 
-  if (item) {
-    p1 = (proto_data_t *)item->data;
-    return p1->proto_data;
+    list = (proto_data_list_t *)g_realloc(list, sizeof (proto_data_list_t) + size * sizeof (proto_data_t));
+    if (*listp == NULL)
+      list->count = 0;
+    list->size = size;
+    *listp = list;
   }
 
-  return NULL;
+  i = p_lower_bound(list, proto, key);
+  memmove(&list->entries[i + 1], &list->entries[i], (list->count - i) * sizeof (proto_data_t));
+  list->entries[i].proto = proto;
+  list->entries[i].key = key;
+  list->entries[i].proto_data = proto_data;
+  list->count++;
+}
+
+void *
+p_get_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto, guint32 key)
+{
+  proto_data_t *p1 = p_find(*p_get_list(scope, pinfo), proto, key);
+
+  return p1 ? p1->proto_data : NULL;
 }
 
 void
 p_remove_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto, guint32 key)
 {
-  proto_data_t  temp;
-  GSList       *item;
-  GSList      **proto_list;
-
-  temp.proto = proto;
-  temp.key = key;
-  temp.proto_data = NULL;
+  proto_data_list_t *list = *p_get_list(scope, pinfo);
+  proto_data_t      *p1 = p_find(list, proto, key);
 
-  if (scope == pinfo->pool) {
-    item = g_slist_find_custom(pinfo->proto_data, &temp, p_compare);
-    proto_list = &pinfo->proto_data;
-  } else if (scope == wmem_file_scope()) {
-    item = g_slist_find_custom(pinfo->fd->pfd, &temp, p_compare);
-    proto_list = &pinfo->fd->pfd;
-  } else {
-    DISSECTOR_ASSERT(!"invalid wmem scope");
+  if (p1) {
+    list->count--;
+    memmove(p1, p1 + 1, (list->count - (p1 - list->entries)) * sizeof (proto_data_t));
   }
+}
 
-  if (item) {
-    *proto_list = g_slist_remove(*proto_list, item->data);
-  }
+guint
+p_get_proto_data_count(wmem_allocator_t *scope, struct _packet_info* pinfo)
+{
+  proto_data_list_t *list = *p_get_list(scope, pinfo);
+
+  return list ? list->count : 0;
 }
 
 gchar *
 p_get_proto_name_and_key(wmem_allocator_t *scope, struct _packet_info* pinfo, guint pfd_index){
-  proto_data_t  *temp;
+  proto_data_list_t *list = *p_get_list(scope, pinfo);
+  proto_data_t      *temp;
 
-  if (scope == pinfo->pool) {
-    temp = (proto_data_t *)g_slist_nth_data(pinfo->proto_data, pfd_index);
-  } else if (scope == wmem_file_scope()) {
-    temp = (proto_data_t *)g_slist_nth_data(pinfo->fd->pfd, pfd_index);
-  } else {
-    DISSECTOR_ASSERT(!"invalid wmem scope");
-  }
+  DISSECTOR_ASSERT(list != NULL && pfd_index < list->count);
+  temp = &list->entries[pfd_index];
 
   return wmem_strdup_printf(wmem_packet_scope(),"[%s, key %u]",proto_get_protocol_name(temp->proto), temp->key);
 }
@@ -298,6 +298,13 @@ pbw_foreach_message(const PbwDescriptorPool* pool, void (*cb)(const PbwDescripto
     pbl_foreach_message((const pbl_descriptor_pool_t*) pool, (void (*)(const pbl_message_descriptor_t*, void*)) cb, userdata);
 }
 
+/* visit the absolute paths of all proto files loaded into this pool */
+void
+pbw_foreach_proto_file(const PbwDescriptorPool* pool, void (*cb)(const char* filename, void* userdata), void* userdata)
+{
+    pbl_foreach_proto_file((const pbl_descriptor_pool_t*) pool, cb, userdata);
+}
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
@@ -254,6 +254,10 @@ pbw_EnumValueDescriptor_number(const PbwEnumValueDescriptor* enumValue);
 void
 pbw_foreach_message(const PbwDescriptorPool* pool, void (*cb)(const PbwDescriptor* message, void* userdata), void* userdata);
 
+/* visit the absolute paths of all proto files loaded into this pool */
+void
+pbw_foreach_proto_file(const PbwDescriptorPool* pool, void (*cb)(const char* filename, void* userdata), void* userdata);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
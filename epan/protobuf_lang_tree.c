@@ -426,18 +426,86 @@ pbl_message_descriptor_full_name(const pbl_message_descriptor_t* message)
     return pbl_get_node_full_name((pbl_node_t*)message);
 }
 
+/* Field numbers up to this are looked up in an array, if the array is not
+ * mostly empty; larger or sparser ones are looked up in fields_by_number. */
+#define PBL_MAX_FIELD_ARRAY_NUMBER 4096
+
+/* free the field arrays of a message, that will be built again on demand */
+static void
+pbl_message_descriptor_drop_field_arrays(pbl_message_descriptor_t* message)
+{
+    g_free(message->field_array);
+    g_free(message->field_array_by_number);
+    message->field_array = NULL;
+    message->field_array_by_number = NULL;
+    message->field_array_len = 0;
+    message->field_array_by_number_len = 0;
+    message->fields_indexed = FALSE;
+}
+
+/* Build the arrays of fields of a message, in declaration order and by number,
+ * the first time they are needed, so that fields can be got without walking
+ * the fields list or hashing while dissecting. */
+static void
+pbl_message_descriptor_index_fields(pbl_message_descriptor_t* message)
+{
+    GSList* it;
+    int i;
+    int min_number = 0;
+    int max_number = 0;
+    pbl_field_descriptor_t* field;
+
+    if (message->fields_indexed) {
+        return;
+    }
+    message->fields_indexed = TRUE;
+
+    message->field_array_len = g_slist_length(message->fields);
+    if (message->field_array_len == 0) {
+        return;
+    }
+
+    message->field_array = g_new(pbl_field_descriptor_t*, message->field_array_len);
+    for (it = message->fields, i = 0; it; it = it->next, i++) {
+        field = (pbl_field_descriptor_t*) it->data;
+        message->field_array[i] = field;
+        min_number = MIN(min_number, field->number);
+        max_number = MAX(max_number, field->number);
+    }
+
+    if (min_number < 0 || max_number > PBL_MAX_FIELD_ARRAY_NUMBER || max_number > 8 * message->field_array_len + 64) {
+        return;
+    }
+
+    message->field_array_by_number_len = max_number + 1;
+    message->field_array_by_number = g_new0(pbl_field_descriptor_t*, message->field_array_by_number_len);
+    for (i = 0; i < message->field_array_len; i++) {
+        field = message->field_array[i];
+        /* like fields_by_number, the last field of a number wins */
+        message->field_array_by_number[field->number] = field;
+    }
+}
+
 /* like Descriptor::field_count() */
 int
 pbl_message_descriptor_field_count(const pbl_message_descriptor_t* message)
 {
-    return (message && message->fields) ? g_slist_length(message->fields) : 0;
+    if (message == NULL) {
+        return 0;
+    }
+    pbl_message_descriptor_index_fields((pbl_message_descriptor_t*) message);
+    return message->field_array_len;
 }
 
 /* like Descriptor::field() */
 const pbl_field_descriptor_t*
 pbl_message_descriptor_field(const pbl_message_descriptor_t* message, int field_index)
 {
-    return (message && message->fields) ? (pbl_field_descriptor_t*) g_slist_nth_data(message->fields, field_index) : NULL;
+    if (message == NULL) {
+        return NULL;
+    }
+    pbl_message_descriptor_index_fields((pbl_message_descriptor_t*) message);
+    return (field_index >= 0 && field_index < message->field_array_len) ? message->field_array[field_index] : NULL;
 }
 
 /* like Descriptor::FindFieldByNumber() */
@@ -445,6 +513,11 @@ const pbl_field_descriptor_t*
 pbl_message_descriptor_FindFieldByNumber(const pbl_message_descriptor_t* message, int number)
 {
     if (message && message->fields_by_number) {
+        pbl_message_descriptor_index_fields((pbl_message_descriptor_t*) message);
+        if (message->field_array_by_number) {
+            return (number >= 0 && number < message->field_array_by_number_len)
+                ? message->field_array_by_number[number] : NULL;
+        }
         return (pbl_field_descriptor_t*) g_hash_table_lookup(message->fields_by_number, GINT_TO_POINTER(number));
     } else {
         return NULL;
@@ -500,6 +573,12 @@ pbl_field_descriptor_type(const pbl_field_descriptor_t* field)
                 ((pbl_field_descriptor_t*)field)->type = PROTOBUF_TYPE_MESSAGE;
             }
         }
+        if (node && ((pbl_node_t*)field)->parent && ((pbl_node_t*)field)->parent->file
+            && ((pbl_node_t*)field)->parent->file->pool) {
+            /* keep what has been found for enum_type() or message_type() */
+            ((pbl_field_descriptor_t*)field)->type_node = node;
+            ((pbl_field_descriptor_t*)field)->type_node_generation = ((pbl_node_t*)field)->parent->file->pool->generation;
+        }
     }
     return field->type;
 }
@@ -556,13 +635,34 @@ pbl_field_descriptor_TypeName(int field_type)
     return val_to_str(field_type, protobuf_field_type, "UNKNOWN_FIELD_TYPE(%d)");
 }
 
+/* Find the message or enum node of the type of a field. The node found is kept
+ * in the field until more nodes are added to the pool, because searching for
+ * it by name in the context of the field is slow. */
+static const pbl_node_t*
+pbl_field_descriptor_type_node(const pbl_field_descriptor_t* field, pbl_node_type_t nodetype)
+{
+    pbl_field_descriptor_t* f = (pbl_field_descriptor_t*) field;
+    const pbl_node_t* context = ((pbl_node_t*)field)->parent;
+    const pbl_descriptor_pool_t* pool = (context && context->file) ? context->file->pool : NULL;
+
+    if (pool == NULL) {
+        return pbl_find_node_in_context(context, field->type_name, nodetype);
+    }
+
+    if (field->type_node == NULL || field->type_node_generation != pool->generation) {
+        f->type_node = pbl_find_node_in_context(context, field->type_name, nodetype);
+        f->type_node_generation = pool->generation;
+    }
+    return field->type_node;
+}
+
 /* like FieldDescriptor::message_type()  type = TYPE_MESSAGE or TYPE_GROUP */
 const pbl_message_descriptor_t*
 pbl_field_descriptor_message_type(const pbl_field_descriptor_t* field)
 {
     const pbl_node_t* n;
     if (field->type == PROTOBUF_TYPE_MESSAGE || field->type == PROTOBUF_TYPE_GROUP) {
-        n = pbl_find_node_in_context(((pbl_node_t*)field)->parent, field->type_name, PBL_MESSAGE);
+        n = pbl_field_descriptor_type_node(field, PBL_MESSAGE);
         return n ? (const pbl_message_descriptor_t*)n : NULL;
     }
     return NULL;
@@ -574,7 +674,7 @@ pbl_field_descriptor_enum_type(const pbl_field_descriptor_t* field)
 {
     const pbl_node_t* n;
     if (field->type == PROTOBUF_TYPE_ENUM) {
-        n = pbl_find_node_in_context(((pbl_node_t*)field)->parent, field->type_name, PBL_ENUM);
+        n = pbl_field_descriptor_type_node(field, PBL_ENUM);
         return n ? (const pbl_enum_descriptor_t*)n : NULL;
     }
     return NULL;
@@ -774,6 +874,18 @@ pbl_foreach_message(const pbl_descriptor_pool_t* pool, void (*cb)(const pbl_mess
     }
 }
 
+/* visit the absolute paths of all proto files of this pool */
+void
+pbl_foreach_proto_file(const pbl_descriptor_pool_t* pool, void (*cb)(const char*, void*), void* userdata)
+{
+    GHashTableIter it;
+    gpointer key, value;
+    g_hash_table_iter_init (&it, pool->proto_files);
+    while (g_hash_table_iter_next (&it, &key, &value)) {
+        (*cb)((const char*)key, userdata);
+    }
+}
+
 
 /*
  * Following are tree building functions that should only be invoked by protobuf_lang parser.
@@ -1000,6 +1112,11 @@ pbl_add_child(pbl_node_t* parent, pbl_node_t* child)
 
     child->parent = parent;
 
+    /* the types of fields already looked up may be found elsewhere now */
+    if (child->file && child->file->pool) {
+        child->file->pool->generation++;
+    }
+
     /* add child to children list */
     parent->children = g_slist_append(parent->children, child);
 
@@ -1032,6 +1149,7 @@ pbl_add_child(pbl_node_t* parent, pbl_node_t* child)
         pbl_message_descriptor_t* msg = (pbl_message_descriptor_t*) parent;
         /* add child to fields_by_number table */
         if (child->nodetype == PBL_FIELD || child->nodetype == PBL_MAP_FIELD) {
+            pbl_message_descriptor_drop_field_arrays(msg);
             msg->fields = g_slist_append(msg->fields, child);
             if (msg->fields_by_number == NULL) {
                 msg->fields_by_number = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, NULL);
@@ -1079,6 +1197,7 @@ pbl_merge_children(pbl_node_t* to, pbl_node_t* from)
 
         if (from->nodetype == PBL_MESSAGE) {
             pbl_message_descriptor_t* msg = (pbl_message_descriptor_t*) from;
+            pbl_message_descriptor_drop_field_arrays(msg);
             if (msg->fields) {
                 g_slist_free(msg->fields);
                 msg->fields = NULL;
@@ -1130,6 +1249,8 @@ pbl_free_node(gpointer anode)
         if (message_node->fields_by_number) {
             g_hash_table_destroy(message_node->fields_by_number);
         }
+        g_free(message_node->field_array);
+        g_free(message_node->field_array_by_number);
         break;
     case PBL_FIELD:
     case PBL_MAP_FIELD:
@@ -51,6 +51,7 @@ typedef struct {
     GHashTable* proto_files; /* all proto files that are parsed or to be parsed */
     GSList* proto_files_to_be_parsed; /* files is to be parsed */
     struct _protobuf_lang_state_t *parser_state; /* current parser state */
+    guint generation; /* changed whenever a node is added, to invalidate lookups cached in nodes */
 } pbl_descriptor_pool_t;
 
 /* file descriptor */
@@ -88,6 +89,12 @@ typedef struct {
     pbl_node_t basic_info;
     GSList* fields;
     GHashTable* fields_by_number;
+    /* built during first access, and dropped whenever a field is added */
+    gboolean fields_indexed;
+    struct pbl_field_descriptor_t** field_array; /* fields in declaration order */
+    int field_array_len;
+    struct pbl_field_descriptor_t** field_array_by_number; /* indexed by number */
+    int field_array_by_number_len; /* 0 if the numbers are too sparse for it */
 } pbl_message_descriptor_t;
 
 /* like google::protobuf::EnumValueDescriptor of protobuf cpp library */
@@ -97,11 +104,13 @@ typedef struct {
 } pbl_enum_value_descriptor_t;
 
 /* like google::protobuf::FieldDescriptor of protobuf cpp library */
-typedef struct {
+typedef struct pbl_field_descriptor_t {
     pbl_node_t basic_info;
     int number;
     int type; /* refer to PROTOBUF_TYPE_XXX of protobuf-helper.h */
     gchar* type_name;
+    const pbl_node_t* type_node; /* message or enum of type_name, found during first access */
+    guint type_node_generation; /* generation of the pool type_node was found in */
     pbl_node_t* options_node;
     gboolean is_repeated;
     gboolean is_required;
@@ -370,6 +379,10 @@ pbl_enum_value_descriptor_number(const pbl_enum_value_descriptor_t* enumValue);
 void
 pbl_foreach_message(const pbl_descriptor_pool_t* pool, void (*cb)(const pbl_message_descriptor_t*, void*), void* userdata);
 
+/* visit the absolute paths of all proto files of this pool */
+void
+pbl_foreach_proto_file(const pbl_descriptor_pool_t* pool, void (*cb)(const char*, void*), void* userdata);
+
 /*
  * Following are tree building functions.
  */
@@ -14,6 +14,7 @@
 
 #include <epan/packet.h>
 #include <epan/exceptions.h>
+#include <epan/prefs.h>
 #include <epan/reassemble.h>
 #include <epan/tvbuff-int.h>
 
@@ -315,6 +316,40 @@ reassembled_key_free(gpointer ptr)
 	g_slice_free(reassembled_key, (reassembled_key *)ptr);
 }
 
+/*
+ * The index that LINK_FRAG() keeps in the head of a reassembly, so that
+ * adding a fragment out of order and checking the fragments for gaps need
+ * not walk the whole list each time; with thousands of segments in a
+ * reassembly those walks made adding them quadratic.
+ *
+ * The offsets are only indexed once there are enough fragments for that
+ * to be worth it. The code that moves fragments between reassemblies
+ * (fragment_add_seq_single_work()) just drops the index, which is rebuilt
+ * from the list when it is next needed.
+ */
+#define FRAGMENT_INDEX_MIN_TREE	16
+
+typedef struct _fragment_index {
+	guint count;			/* fragments in the list */
+	fragment_item *last;		/* the last of them */
+	wmem_flat_tree_t *by_offset;	/* the last fragment at each offset */
+	guint32 contiguous;		/* end of the data without gaps from 0;
+					 * for FD_BLOCKSEQUENCE, in blocks */
+} fragment_index;
+
+static void
+fragment_index_free(fragment_head *fd_head)
+{
+	fragment_index *index = fd_head->frag_index;
+
+	if (index) {
+		if (index->by_offset)
+			wmem_flat_tree_destroy(index->by_offset);
+		g_slice_free(fragment_index, index);
+		fd_head->frag_index = NULL;
+	}
+}
+
 /*
  * For a fragment hash table entry, free the associated fragments.
  * The entry value (fd_chain) is freed herein and the entry is freed
@@ -330,6 +365,7 @@ free_all_fragments(gpointer key_arg _U_, gpointer value, gpointer user_data _U_)
 	/* g_hash_table_new_full() was used to supply a function
 	 * to free the key and anything to which it points
 	 */
+	fragment_index_free((fragment_head *)value);
 	for (fd_head = (fragment_head *)value; fd_head != NULL; fd_head = tmp_fd) {
 		tmp_fd=fd_head->next;
 
@@ -394,9 +430,142 @@ free_fragments(gpointer data, gpointer user_data _U_)
 
 	if (fd_head->tvb_data)
 		tvb_free(fd_head->tvb_data);
+	fragment_index_free(fd_head);
 	g_slice_free(fragment_item, fd_head);
 }
 
+/*
+ * Limits on the memory held by incomplete reassemblies.
+ *
+ * On the first pass, every REASSEMBLY_SWEEP_INTERVAL frames, the data of
+ * the reassemblies in a table that are still waiting for fragments is
+ * counted. Those that haven't been extended for prefs.reassembly_max_age
+ * frames are dropped, and then the ones extended the longest time ago
+ * until the table and all tables together are back within their memory
+ * limits. A dropped reassembly behaves as if its fragments had never
+ * been seen; it couldn't have been shown on later passes anyway, as only
+ * complete reassemblies are. Complete reassemblies are never dropped:
+ * their data can't be got back without dissecting their frames again.
+ */
+#define REASSEMBLY_SWEEP_INTERVAL	1000
+
+/* Pending data in all tables, as of the last sweep of each */
+static guint64 reassembly_pending_bytes;
+static guint reassembly_evicted_heads;
+static guint64 reassembly_evicted_bytes;
+
+/* Lookups of in-progress reassemblies, since the capture was opened */
+static guint64 reassembly_lookups;
+static guint64 reassembly_lookup_misses;
+static guint64 reassembly_completed;
+
+/* The amount of fragment data held by a reassembly */
+static guint64
+fragment_head_data_size(const fragment_head *fd_head)
+{
+	const fragment_item *fd;
+	guint64 size = 0;
+
+	for (fd = fd_head; fd; fd = fd->next) {
+		if (fd->tvb_data && !(fd->flags & FD_SUBSET_TVB))
+			size += tvb_captured_length(fd->tvb_data);
+	}
+	return size;
+}
+
+typedef struct {
+	gpointer key;
+	fragment_head *fd_head;
+	guint64 size;
+} sweep_candidate;
+
+static gint
+sweep_candidate_compare(gconstpointer a, gconstpointer b)
+{
+	const sweep_candidate *ca = (const sweep_candidate *)a;
+	const sweep_candidate *cb = (const sweep_candidate *)b;
+
+	return (ca->fd_head->frame > cb->fd_head->frame) - (ca->fd_head->frame < cb->fd_head->frame);
+}
+
+static void
+reassembly_table_evict(reassembly_table *table, fragment_head *fd_head, guint64 size)
+{
+	reassembly_evicted_heads++;
+	reassembly_evicted_bytes += size;
+	table->pending_bytes -= size;
+	reassembly_pending_bytes -= size;
+
+	free_all_fragments(NULL, fd_head, NULL);
+}
+
+static void
+reassembly_table_sweep(reassembly_table *table, const packet_info *pinfo)
+{
+	guint64 table_limit = (guint64)prefs.reassembly_table_max_memory << 20;
+	guint64 global_limit = (guint64)prefs.reassembly_max_memory << 20;
+	guint32 max_age = prefs.reassembly_max_age;
+	GHashTableIter iter;
+	gpointer key, value;
+	fragment_head *fd_head;
+	GArray *candidates;
+	sweep_candidate *candidate;
+	guint64 size;
+	guint i;
+
+	if (G_LIKELY(pinfo->fd->visited || pinfo->num < table->next_sweep))
+		return;
+	table->next_sweep = pinfo->num + REASSEMBLY_SWEEP_INTERVAL;
+	if (!table_limit && !global_limit && !max_age)
+		return;
+
+	/* Count again, dropping the reassemblies that are too old */
+	reassembly_pending_bytes -= table->pending_bytes;
+	table->pending_bytes = 0;
+	candidates = g_array_new(FALSE, FALSE, sizeof(sweep_candidate));
+
+	g_hash_table_iter_init(&iter, table->fragment_table);
+	while (g_hash_table_iter_next(&iter, &key, &value)) {
+		fd_head = (fragment_head *)value;
+		if (fd_head->flags & FD_DEFRAGMENTED)
+			continue;
+
+		size = fragment_head_data_size(fd_head);
+		table->pending_bytes += size;
+		reassembly_pending_bytes += size;
+		/* Whatever was looked up in this frame may still be in use,
+		 * and heads started without any fragment (as by
+		 * fragment_start_seq_check()) have no frame to go by */
+		if (fd_head->frame >= pinfo->num || !size)
+			continue;
+
+		if (max_age && pinfo->num - fd_head->frame > max_age) {
+			reassembly_table_evict(table, fd_head, size);
+			g_hash_table_iter_remove(&iter);
+		} else {
+			sweep_candidate c = { key, fd_head, size };
+			g_array_append_val(candidates, c);
+		}
+	}
+
+	if ((table_limit && table->pending_bytes > table_limit) ||
+	    (global_limit && reassembly_pending_bytes > global_limit)) {
+		g_array_sort(candidates, sweep_candidate_compare);
+		for (i = 0; i < candidates->len; i++) {
+			if ((!table_limit || table->pending_bytes <= table_limit) &&
+			    (!global_limit || reassembly_pending_bytes <= global_limit))
+				break;
+			candidate = &g_array_index(candidates, sweep_candidate, i);
+			/* The table owns the key; only remove it once the
+			 * head is freed, as removing it frees the key. */
+			reassembly_table_evict(table, candidate->fd_head, candidate->size);
+			g_hash_table_remove(table->fragment_table, candidate->key);
+		}
+	}
+
+	g_array_free(candidates, TRUE);
+}
+
 typedef struct register_reassembly_table {
 	reassembly_table *table;
 	const reassembly_table_functions *funcs;
@@ -435,6 +604,9 @@ reassembly_table_init(reassembly_table *table,
 		table->persistent_key_func = funcs->persistent_key_func;
 	if (table->free_temporary_key_func == NULL)
 		table->free_temporary_key_func = funcs->free_temporary_key_func;
+	reassembly_pending_bytes -= table->pending_bytes;
+	table->pending_bytes = 0;
+	table->next_sweep = 0;
 	if (table->fragment_table != NULL) {
 		/*
 		 * The fragment hash table exists.
@@ -488,6 +660,8 @@ reassembly_table_destroy(reassembly_table *table)
 	table->temporary_key_func = NULL;
 	table->persistent_key_func = NULL;
 	table->free_temporary_key_func = NULL;
+	reassembly_pending_bytes -= table->pending_bytes;
+	table->pending_bytes = 0;
 	if (table->fragment_table != NULL) {
 		/*
 		 * The fragment hash table exists.
@@ -542,18 +716,48 @@ lookup_fd_head(reassembly_table *table, const packet_info *pinfo,
 {
 	gpointer key;
 	gpointer value;
+	gboolean found;
+
+	reassembly_table_sweep(table, pinfo);
 
-	/* Create key to search hash with */
-	key = table->temporary_key_func(pinfo, id, data);
+	reassembly_lookups++;
 
 	/*
-	 * Look up the reassembly in the fragment table.
+	 * Look up the reassembly in the fragment table; the temporary keys
+	 * of the standard tables need not be allocated, as they're only
+	 * used for this lookup.
 	 */
-	if (!g_hash_table_lookup_extended(table->fragment_table, key, orig_keyp,
-					  &value))
+	if (table->temporary_key_func == fragment_addresses_temporary_key) {
+		fragment_addresses_key stack_key;
+
+		copy_address_shallow(&stack_key.src, &pinfo->src);
+		copy_address_shallow(&stack_key.dst, &pinfo->dst);
+		stack_key.id = id;
+		found = g_hash_table_lookup_extended(table->fragment_table,
+						     &stack_key, orig_keyp, &value);
+	} else if (table->temporary_key_func == fragment_addresses_ports_temporary_key) {
+		fragment_addresses_ports_key stack_key;
+
+		copy_address_shallow(&stack_key.src_addr, &pinfo->src);
+		copy_address_shallow(&stack_key.dst_addr, &pinfo->dst);
+		stack_key.src_port = pinfo->srcport;
+		stack_key.dst_port = pinfo->destport;
+		stack_key.id = id;
+		found = g_hash_table_lookup_extended(table->fragment_table,
+						     &stack_key, orig_keyp, &value);
+	} else {
+		/* Create key to search hash with */
+		key = table->temporary_key_func(pinfo, id, data);
+		found = g_hash_table_lookup_extended(table->fragment_table,
+						     key, orig_keyp, &value);
+		/* Free the key */
+		table->free_temporary_key_func(key);
+	}
+
+	if (!found) {
+		reassembly_lookup_misses++;
 		value = NULL;
-	/* Free the key */
-	table->free_temporary_key_func(key);
+	}
 
 	return (fragment_head *)value;
 }
@@ -604,16 +808,23 @@ fragment_delete(reassembly_table *table, const packet_info *pinfo,
 	}
 
 	fd_tvb_data=fd_head->tvb_data;
-	/* loop over all partial fragments and free any tvbuffs */
+	/* loop over all partial fragments and free any tvbuffs; if
+	 * fd_tvb_data is a composite over them (see fragment_add_composite()),
+	 * leave them to be freed along with it */
 	for(fd=fd_head->next;fd;){
 		fragment_item *tmp_fd;
 		tmp_fd=fd->next;
 
-		if (fd->tvb_data && !(fd->flags & FD_SUBSET_TVB))
-			tvb_free(fd->tvb_data);
+		if (fd->tvb_data && !(fd->flags & FD_SUBSET_TVB)) {
+			if (fd_tvb_data)
+				tvb_add_to_chain(fd_tvb_data, fd->tvb_data);
+			else
+				tvb_free(fd->tvb_data);
+		}
 		g_slice_free(fragment_item, fd);
 		fd=tmp_fd;
 	}
+	fragment_index_free(fd_head);
 	g_slice_free(fragment_head, fd_head);
 	g_hash_table_remove(table->fragment_table, key);
 
@@ -897,6 +1108,7 @@ fragment_reassembled(reassembly_table *table, fragment_head *fd_head,
 	fd_head->flags |= FD_DEFRAGMENTED;
 	fd_head->reassembled_in = pinfo->num;
 	fd_head->reas_in_layer_num = pinfo->curr_layer_num;
+	reassembly_completed++;
 }
 
 /*
@@ -935,20 +1147,106 @@ fragment_reassembled_single(reassembly_table *table, fragment_head *fd_head,
 	fd_head->flags |= FD_DEFRAGMENTED;
 	fd_head->reassembled_in = pinfo->num;
 	fd_head->reas_in_layer_num = pinfo->curr_layer_num;
+	reassembly_completed++;
+}
+
+/* The end of a fragment, in the units of fragment_index.contiguous */
+static inline guint32
+fragment_end(const fragment_head *fd_head, const fragment_item *fd)
+{
+	if (fd_head->flags & FD_BLOCKSEQUENCE)
+		return fd->offset + 1;
+	return fd->offset + fd->len;
+}
+
+/* Extend index->contiguous with fd and the fragments after it. */
+static void
+fragment_index_extend(const fragment_head *fd_head, fragment_index *index,
+		      const fragment_item *fd)
+{
+	guint32 end;
+
+	for (; fd && fd->offset <= index->contiguous; fd = fd->next) {
+		end = fragment_end(fd_head, fd);
+		if (end > index->contiguous)
+			index->contiguous = end;
+	}
+}
+
+static void
+fragment_index_add_tree(fragment_index *index, fragment_head *fd_head)
+{
+	fragment_item *fd_i;
+
+	index->by_offset = wmem_flat_tree_new(NULL);
+	for (fd_i = fd_head->next; fd_i; fd_i = fd_i->next)
+		wmem_flat_tree_insert32(index->by_offset, fd_i->offset, fd_i);
+}
+
+/* Get the index of a reassembly, building it from the list if needed. */
+static fragment_index *
+fragment_index_get(fragment_head *fd_head)
+{
+	fragment_index *index = fd_head->frag_index;
+	fragment_item *fd_i;
+
+	if (index)
+		return index;
+
+	index = g_slice_new0(fragment_index);
+	for (fd_i = fd_head->next; fd_i; fd_i = fd_i->next) {
+		index->count++;
+		index->last = fd_i;
+	}
+	fragment_index_extend(fd_head, index, fd_head->next);
+	if (index->count >= FRAGMENT_INDEX_MIN_TREE)
+		fragment_index_add_tree(index, fd_head);
+	fd_head->frag_index = index;
+	return index;
+}
+
+/*
+ * The amount of data without gaps from the start of the reassembly: in
+ * bytes, or for FD_BLOCKSEQUENCE the number of consecutive blocks from 0.
+ */
+static guint32
+fragment_contiguous(fragment_head *fd_head)
+{
+	return fragment_index_get(fd_head)->contiguous;
 }
 
 static void
 LINK_FRAG(fragment_head *fd_head,fragment_item *fd)
 {
+	fragment_index *index = fragment_index_get(fd_head);
 	fragment_item *fd_i;
 
-	/* add fragment to list, keep list sorted */
-	for(fd_i= fd_head; fd_i->next;fd_i=fd_i->next) {
-		if (fd->offset < fd_i->next->offset )
-			break;
+	/* add fragment to list, keep list sorted; fragments at the same
+	 * offset stay in the order they were added */
+	if (index->last == NULL || fd->offset >= index->last->offset) {
+		/* the usual case: append it */
+		fd_i = index->last ? index->last : fd_head;
+	} else if (index->by_offset) {
+		fd_i = (fragment_item *)wmem_flat_tree_lookup32_le(index->by_offset, fd->offset);
+		if (fd_i == NULL)
+			fd_i = fd_head;
+	} else {
+		for(fd_i= fd_head; fd_i->next;fd_i=fd_i->next) {
+			if (fd->offset < fd_i->next->offset )
+				break;
+		}
 	}
 	fd->next=fd_i->next;
 	fd_i->next=fd;
+
+	if (fd->next == NULL)
+		index->last = fd;
+	index->count++;
+	if (index->by_offset)
+		wmem_flat_tree_insert32(index->by_offset, fd->offset, fd);
+	else if (index->count >= FRAGMENT_INDEX_MIN_TREE)
+		fragment_index_add_tree(index, fd_head);
+	fragment_index_extend(fd_head, index, fd);
 }
 
 static void
@@ -958,6 +1256,8 @@ MERGE_FRAG(fragment_head *fd_head, fragment_item *fd)
 
 	if (fd == NULL) return;
 
+	fragment_index_free(fd_head);
+
 	for(fd_i = fd_head; fd_i->next; fd_i=fd_i->next) {
 		if (fd->offset < fd_i->next->offset) {
 			tmp = fd_i->next;
@@ -968,6 +1268,78 @@ MERGE_FRAG(fragment_head *fd_head, fragment_item *fd)
 	fd_i->next = fd;
 }
 
+/*
+ * For tables with composite_data set: if the fragments of a complete
+ * reassembly follow each other without gaps or partial overlaps, make the
+ * reassembled data a composite tvbuff over the fragments' own copies of
+ * their data, rather than copying all of it once more. The fragments keep
+ * their data, so fragment_reset_defragmentation() leaves them alone.
+ * Fragments wholly inside the data of earlier ones are checked and dropped
+ * like the overlaps of the copying code in fragment_add_work().
+ *
+ * Returns FALSE, having changed nothing, if the data has to be copied.
+ */
+static gboolean
+fragment_add_composite(fragment_head *fd_head)
+{
+	fragment_item *fd_i;
+	guint32 dfpos;
+	guint8 *data;
+
+	for (dfpos=0,fd_i=fd_head->next;fd_i;fd_i=fd_i->next) {
+		if (!fd_i->len)
+			continue;
+		if (!fd_i->tvb_data
+		    || fd_i->offset + fd_i->len < fd_i->offset
+		    || fd_i->offset + fd_i->len > fd_head->datalen)
+			return FALSE;
+		if (fd_i->offset + fd_i->len <= dfpos)
+			continue;	/* duplicate, checked below */
+		if (fd_i->offset != dfpos || (fd_i->flags & FD_SUBSET_TVB))
+			return FALSE;
+		dfpos += fd_i->len;
+	}
+	if (dfpos == 0 || dfpos != fd_head->datalen)
+		return FALSE;
+
+	fd_head->tvb_data = tvb_new_composite();
+	for (dfpos=0,fd_i=fd_head->next;fd_i;fd_i=fd_i->next) {
+		if (fd_i->len && fd_i->offset == dfpos) {
+			tvb_composite_append_unchained(fd_head->tvb_data, fd_i->tvb_data);
+			dfpos += fd_i->len;
+		}
+	}
+	tvb_composite_finalize(fd_head->tvb_data);
+
+	for (dfpos=0,fd_i=fd_head->next;fd_i;fd_i=fd_i->next) {
+		if (!fd_i->len)
+			continue;
+		if (fd_i->offset == dfpos) {
+			dfpos += fd_i->len;
+			continue;
+		}
+
+		/* duplicate/retransmission/overlap; copy the old data out
+		 * rather than have the whole composite made contiguous */
+		fd_i->flags    |= FD_OVERLAP;
+		fd_head->flags |= FD_OVERLAP;
+		data = (guint8 *)tvb_memdup(NULL, fd_head->tvb_data, fd_i->offset, fd_i->len);
+		if (memcmp(data, tvb_get_ptr(fd_i->tvb_data, 0, fd_i->len), fd_i->len)) {
+			fd_i->flags    |= FD_OVERLAPCONFLICT;
+			fd_head->flags |= FD_OVERLAPCONFLICT;
+		}
+		wmem_free(NULL, data);
+
+		if (fd_i->flags & FD_SUBSET_TVB)
+			fd_i->flags &= ~FD_SUBSET_TVB;
+		else
+			tvb_free(fd_i->tvb_data);
+		fd_i->tvb_data = NULL;
+	}
+
+	return TRUE;
+}
+
 /*
  * This function adds a new fragment to the fragment hash table.
  * If this is the first fragment seen for this datagram, a new entry
@@ -992,7 +1364,8 @@ MERGE_FRAG(fragment_head *fd_head, fragment_item *fd)
 static gboolean
 fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 		 const packet_info *pinfo, const guint32 frag_offset,
-		 const guint32 frag_data_len, const gboolean more_frags)
+		 const guint32 frag_data_len, const gboolean more_frags,
+		 const gboolean composite)
 {
 	fragment_item *fd;
 	fragment_item *fd_i;
@@ -1010,6 +1383,7 @@ fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 	fd->len  = frag_data_len;
 	fd->tvb_data = NULL;
 	fd->error = NULL;
+	fd->frag_index = NULL;
 
 	/*
 	 * Are we adding to an already-completed reassembly?
@@ -1162,19 +1536,10 @@ fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 	 * Check if we have received the entire fragment.
 	 * This is easy since the list is sorted and the head is faked.
 	 *
-	 * First, we compute the amount of contiguous data that's
-	 * available.  (The check for fd_i->offset <= max rules out
-	 * fragments that don't start before or at the end of the
-	 * previous fragment, i.e. fragments that have a gap between
-	 * them and the previous fragment.)
+	 * First, we get the amount of contiguous data that's
+	 * available, which LINK_FRAG() keeps track of.
 	 */
-	max = 0;
-	for (fd_i=fd_head->next;fd_i;fd_i=fd_i->next) {
-		if ( ((fd_i->offset)<=max) &&
-			((fd_i->offset+fd_i->len)>max) ){
-			max = fd_i->offset+fd_i->len;
-		}
-	}
+	max = fragment_contiguous(fd_head);
 
 	if (max < (fd_head->datalen)) {
 		/*
@@ -1190,129 +1555,134 @@ fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 	 */
 	/* store old data just in case */
 	old_tvb_data=fd_head->tvb_data;
-	data = (guint8 *) g_malloc(fd_head->datalen);
-	fd_head->tvb_data = tvb_new_real_data(data, fd_head->datalen, fd_head->datalen);
-	tvb_set_free_cb(fd_head->tvb_data, g_free);
-
-	/* add all data fragments */
-	for (dfpos=0,fd_i=fd_head;fd_i;fd_i=fd_i->next) {
-		if (fd_i->len) {
-			/*
-			 * The loop above that calculates max also
-			 * ensures that the only gaps that exist here
-			 * are ones where a fragment starts past the
-			 * end of the reassembled datagram, and there's
-			 * a gap between the previous fragment and
-			 * that fragment.
-			 *
-			 * A "DESEGMENT_UNTIL_FIN" was involved wherein the
-			 * FIN packet had an offset less than the highest
-			 * fragment offset seen. [Seen from a fuzz-test:
-			 * bug #2470]).
-			 *
-			 * Note that the "overlap" compare must only be
-			 * done for fragments with (offset+len) <= fd_head->datalen
-			 * and thus within the newly g_malloc'd buffer.
-			 */
-
-			if (fd_i->offset >= fd_head->datalen) {
+	if (!composite || !fragment_add_composite(fd_head)) {
+		data = (guint8 *) g_malloc(fd_head->datalen);
+		fd_head->tvb_data = tvb_new_real_data(data, fd_head->datalen, fd_head->datalen);
+		tvb_set_free_cb(fd_head->tvb_data, g_free);
+
+		/* add all data fragments */
+		for (dfpos=0,fd_i=fd_head;fd_i;fd_i=fd_i->next) {
+			if (fd_i->len) {
 				/*
-				 * Fragment starts after the end
-				 * of the reassembled packet.
+				 * The loop above that calculates max also
+				 * ensures that the only gaps that exist here
+				 * are ones where a fragment starts past the
+				 * end of the reassembled datagram, and there's
+				 * a gap between the previous fragment and
+				 * that fragment.
 				 *
-				 * This can happen if the length was
-				 * set after the offending fragment
-				 * was added to the reassembly.
+				 * A "DESEGMENT_UNTIL_FIN" was involved wherein the
+				 * FIN packet had an offset less than the highest
+				 * fragment offset seen. [Seen from a fuzz-test:
+				 * bug #2470]).
 				 *
-				 * Flag this fragment, but don't
-				 * try to extract any data from
-				 * it, as there's no place to put
-				 * it.
-				 *
-				 * XXX - add different flag value
-				 * for this.
-				 */
-				fd_i->flags    |= FD_TOOLONGFRAGMENT;
-				fd_head->flags |= FD_TOOLONGFRAGMENT;
-			} else if (fd_i->offset + fd_i->len < fd_i->offset) {
-				/* Integer overflow, unhandled by rest of
-				 * code so error out. This check handles
-				 * all possible remaining overflows.
+				 * Note that the "overlap" compare must only be
+				 * done for fragments with (offset+len) <= fd_head->datalen
+				 * and thus within the newly g_malloc'd buffer.
 				 */
-				fd_head->error = "offset + len < offset";
-			} else if (!fd_i->tvb_data) {
-				fd_head->error = "no data";
-			} else {
-				fraglen = fd_i->len;
-				if (fd_i->offset + fraglen > fd_head->datalen) {
+
+				if (fd_i->offset >= fd_head->datalen) {
 					/*
-					 * Fragment goes past the end
-					 * of the packet, as indicated
-					 * by the last fragment.
+					 * Fragment starts after the end
+					 * of the reassembled packet.
+					 *
+					 * This can happen if the length was
+					 * set after the offending fragment
+					 * was added to the reassembly.
 					 *
-					 * This can happen if the
-					 * length was set after the
-					 * offending fragment was
-					 * added to the reassembly.
+					 * Flag this fragment, but don't
+					 * try to extract any data from
+					 * it, as there's no place to put
+					 * it.
 					 *
-					 * Mark it as such, and only
-					 * copy from it what fits in
-					 * the packet.
+					 * XXX - add different flag value
+					 * for this.
 					 */
 					fd_i->flags    |= FD_TOOLONGFRAGMENT;
 					fd_head->flags |= FD_TOOLONGFRAGMENT;
-					fraglen = fd_head->datalen - fd_i->offset;
-				}
-				overlap = dfpos - fd_i->offset;
-				/* Guaranteed to be >= 0, previous code
-				 * has checked for gaps. */
-				if (overlap) {
-					/* duplicate/retransmission/overlap */
-					guint32 cmp_len = MIN(fd_i->len,overlap);
-
-					fd_i->flags    |= FD_OVERLAP;
-					fd_head->flags |= FD_OVERLAP;
-					if ( memcmp(data + fd_i->offset,
-							tvb_get_ptr(fd_i->tvb_data, 0, cmp_len),
-							cmp_len)
-							 ) {
-						fd_i->flags    |= FD_OVERLAPCONFLICT;
-						fd_head->flags |= FD_OVERLAPCONFLICT;
+				} else if (fd_i->offset + fd_i->len < fd_i->offset) {
+					/* Integer overflow, unhandled by rest of
+					 * code so error out. This check handles
+					 * all possible remaining overflows.
+					 */
+					fd_head->error = "offset + len < offset";
+				} else if (!fd_i->tvb_data) {
+					fd_head->error = "no data";
+				} else {
+					fraglen = fd_i->len;
+					if (fd_i->offset + fraglen > fd_head->datalen) {
+						/*
+						 * Fragment goes past the end
+						 * of the packet, as indicated
+						 * by the last fragment.
+						 *
+						 * This can happen if the
+						 * length was set after the
+						 * offending fragment was
+						 * added to the reassembly.
+						 *
+						 * Mark it as such, and only
+						 * copy from it what fits in
+						 * the packet.
+						 */
+						fd_i->flags    |= FD_TOOLONGFRAGMENT;
+						fd_head->flags |= FD_TOOLONGFRAGMENT;
+						fraglen = fd_head->datalen - fd_i->offset;
+					}
+					overlap = dfpos - fd_i->offset;
+					/* Guaranteed to be >= 0, previous code
+					 * has checked for gaps. */
+					if (overlap) {
+						/* duplicate/retransmission/overlap */
+						guint32 cmp_len = MIN(fd_i->len,overlap);
+
+						fd_i->flags    |= FD_OVERLAP;
+						fd_head->flags |= FD_OVERLAP;
+						if ( memcmp(data + fd_i->offset,
+								tvb_get_ptr(fd_i->tvb_data, 0, cmp_len),
+								cmp_len)
+								 ) {
+							fd_i->flags    |= FD_OVERLAPCONFLICT;
+							fd_head->flags |= FD_OVERLAPCONFLICT;
+						}
+					}
+					/* XXX: As in the fragment_add_seq funcs
+					 * like fragment_defragment_and_free() the
+					 * existing behavior does not overwrite
+					 * overlapping bytes even if there is a
+					 * conflict. It only adds new bytes.
+					 *
+					 * Since we only add fragments to a reassembly
+					 * if the reassembly isn't complete, the most
+					 * common case for overlap conflicts is when
+					 * an earlier reassembly isn't fully contained
+					 * in the capture, and we've reused an
+					 * indentification number / wrapped around
+					 * offset sequence numbers much later in the
+					 * capture. In that case, we probably *do*
+					 * want to overwrite conflicting bytes, since
+					 * the earlier fragments didn't form a complete
+					 * reassembly and should be effectively thrown
+					 * out rather than mixed with the new ones?
+					 */
+					if (fd_i->offset + fraglen > dfpos) {
+						memcpy(data+dfpos,
+							tvb_get_ptr(fd_i->tvb_data, overlap, fraglen-overlap),
+							fraglen-overlap);
+						dfpos = fd_i->offset + fraglen;
 					}
 				}
-				/* XXX: As in the fragment_add_seq funcs
-				 * like fragment_defragment_and_free() the
-				 * existing behavior does not overwrite
-				 * overlapping bytes even if there is a
-				 * conflict. It only adds new bytes.
-				 *
-				 * Since we only add fragments to a reassembly
-				 * if the reassembly isn't complete, the most
-				 * common case for overlap conflicts is when
-				 * an earlier reassembly isn't fully contained
-				 * in the capture, and we've reused an
-				 * indentification number / wrapped around
-				 * offset sequence numbers much later in the
-				 * capture. In that case, we probably *do*
-				 * want to overwrite conflicting bytes, since
-				 * the earlier fragments didn't form a complete
-				 * reassembly and should be effectively thrown
-				 * out rather than mixed with the new ones?
-				 */
-				if (fd_i->offset + fraglen > dfpos) {
-					memcpy(data+dfpos,
-						tvb_get_ptr(fd_i->tvb_data, overlap, fraglen-overlap),
-						fraglen-overlap);
-					dfpos = fd_i->offset + fraglen;
-				}
-			}
 
-			if (fd_i->flags & FD_SUBSET_TVB)
-				fd_i->flags &= ~FD_SUBSET_TVB;
-			else if (fd_i->tvb_data)
-				tvb_free(fd_i->tvb_data);
+				if (fd_i->flags & FD_SUBSET_TVB)
+					fd_i->flags &= ~FD_SUBSET_TVB;
+				else if (fd_i->tvb_data && old_tvb_data)
+					/* old_tvb_data may be a composite over it */
+					tvb_add_to_chain(tvb, fd_i->tvb_data);
+				else if (fd_i->tvb_data)
+					tvb_free(fd_i->tvb_data);
 
-			fd_i->tvb_data=NULL;
+				fd_i->tvb_data=NULL;
+			}
 		}
 	}
 
@@ -1343,6 +1713,7 @@ fragment_add_common(reassembly_table *table, tvbuff_t *tvb, const int offset,
 	fragment_item *fd_item;
 	gboolean already_added;
 
+	dissector_state_write("fragment_add");
 
 	/*
 	 * Dissector shouldn't give us garbage tvb info.
@@ -1509,7 +1880,7 @@ fragment_add_common(reassembly_table *table, tvbuff_t *tvb, const int offset,
 	}
 
 	if (fragment_add_work(fd_head, tvb, offset, pinfo, frag_offset,
-		frag_data_len, more_frags)) {
+		frag_data_len, more_frags, table->composite_data)) {
 		/*
 		 * Reassembly is complete.
 		 */
@@ -1593,7 +1964,7 @@ fragment_add_check(reassembly_table *table, tvbuff_t *tvb, const int offset,
 	}
 
 	if (fragment_add_work(fd_head, tvb, offset, pinfo, frag_offset,
-		frag_data_len, more_frags)) {
+		frag_data_len, more_frags, table->composite_data)) {
 		/*
 		 * Reassembly is complete.
 		 * Remove this from the table of in-progress
@@ -1752,6 +2123,7 @@ fragment_add_seq_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 	fd->len  = frag_data_len;
 	fd->tvb_data = NULL;
 	fd->error = NULL;
+	fd->frag_index = NULL;
 
 	/* fd_head->frame is the maximum of the frame numbers of all the
 	 * fragments added to the reassembly. */
@@ -1899,17 +2271,11 @@ fragment_add_seq_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 	}
 
 
-	/* check if we have received the entire fragment
-	 * this is easy since the list is sorted and the head is faked.
-	 * common case the whole list is scanned.
+	/* check if we have received the entire fragment: the number of
+	 * consecutive blocks from 0, which LINK_FRAG() keeps track of,
+	 * will be datalen+1 if all fragments have been seen
 	 */
-	max = 0;
-	for(fd_i=fd_head->next;fd_i;fd_i=fd_i->next) {
-	  if ( fd_i->offset==max ){
-		max++;
-	  }
-	}
-	/* max will now be datalen+1 if all fragments have been seen */
+	max = fragment_contiguous(fd_head);
 
 	if (max <= fd_head->datalen) {
 		/* we have not received all packets yet */
@@ -1955,6 +2321,8 @@ fragment_add_seq_common(reassembly_table *table, tvbuff_t *tvb,
 	fragment_head *fd_head;
 	gpointer orig_key;
 
+	dissector_state_write("fragment_add_seq");
+
 	fd_head = lookup_fd_head(table, pinfo, id, data, &orig_key);
 
 	/* have we already seen this frame ?*/
@@ -2205,6 +2573,7 @@ fragment_add_seq_single_move(reassembly_table *table, const packet_info *pinfo,
 		/* Don't take a reassembly starting with a First fragment. */
 		fd = new_fh->next;
 		if (fd && fd->offset != 0) {
+			fragment_index_free(fh);
 			prev_fd->next = fd;
 			for (; fd; fd=fd->next) {
 				fd->offset += offset;
@@ -2242,6 +2611,9 @@ fragment_add_seq_single_work(reassembly_table *table, tvbuff_t *tvb,
 	fragment_head *fh, *new_fh;
 	fragment_item *fd, *prev_fd;
 	guint32 frag_number, tmp_offset;
+
+	dissector_state_write("fragment_add_seq_single");
+
 	/* Have we already seen this frame?
 	 * If so, look for it in the table of reassembled packets.
 	 * Note here we store in the reassembly table by the single sequence
@@ -2284,6 +2656,7 @@ fragment_add_seq_single_work(reassembly_table *table, tvbuff_t *tvb,
 					}
 				}
 				prev_fd->next = NULL;
+				fragment_index_free(new_fh);
 				break;
 			}
 		}
@@ -2366,6 +2739,7 @@ fragment_add_seq_single_work(reassembly_table *table, tvbuff_t *tvb,
 		 * if bit errors mess up Last or First. */
 		if (fd != NULL) {
 			prev_fd->next = NULL;
+			fragment_index_free(fh);
 			fh->frame = 0;
 			for (prev_fd=fh->next; prev_fd; prev_fd=prev_fd->next) {
 				if (fh->frame < prev_fd->frame) {
@@ -2487,6 +2861,8 @@ fragment_start_seq_check(reassembly_table *table, const packet_info *pinfo,
 {
 	fragment_head *fd_head;
 
+	dissector_state_write("fragment_start_seq_check");
+
 	/* Have we already seen this frame ?*/
 	if (pinfo->fd->visited) {
 		return;
@@ -2509,6 +2885,7 @@ fragment_start_seq_check(reassembly_table *table, const packet_info *pinfo,
 		fd_head->flags = FD_BLOCKSEQUENCE|FD_DATALEN_SET;
 		fd_head->tvb_data = NULL;
 		fd_head->error = NULL;
+		fd_head->frag_index = NULL;
 
 		insert_fd_head(table, fd_head, pinfo, id, data);
 	}
@@ -2871,6 +3248,11 @@ static void
 reassembly_table_init_reg_tables(void)
 {
 	g_list_foreach(reassembly_table_list, reassembly_table_init_reg_table, NULL);
+	reassembly_evicted_heads = 0;
+	reassembly_evicted_bytes = 0;
+	reassembly_lookups = 0;
+	reassembly_lookup_misses = 0;
+	reassembly_completed = 0;
 }
 
 static void
@@ -2886,6 +3268,59 @@ reassembly_table_cleanup_reg_tables(void)
 	g_list_foreach(reassembly_table_list, reassembly_table_cleanup_reg_table, NULL);
 }
 
+static void
+reassembly_table_add_stats(gpointer p, gpointer user_data)
+{
+	register_reassembly_table_t* reg_table = (register_reassembly_table_t*)p;
+	reassembly_stats_t *stats = (reassembly_stats_t *)user_data;
+	GHashTable *seen;
+	GHashTableIter iter;
+	gpointer value;
+	fragment_head *fd_head;
+
+	stats->tables++;
+
+	if (reg_table->table->fragment_table) {
+		g_hash_table_iter_init(&iter, reg_table->table->fragment_table);
+		while (g_hash_table_iter_next(&iter, NULL, &value)) {
+			fd_head = (fragment_head *)value;
+			if (fd_head->flags & FD_DEFRAGMENTED) {
+				stats->complete_heads++;
+				stats->complete_bytes += fragment_head_data_size(fd_head);
+			} else {
+				stats->pending_heads++;
+				stats->pending_bytes += fragment_head_data_size(fd_head);
+			}
+		}
+	}
+
+	/* A reassembled PDU is in here once for each of its frames */
+	if (reg_table->table->reassembled_table) {
+		seen = g_hash_table_new(g_direct_hash, g_direct_equal);
+		g_hash_table_iter_init(&iter, reg_table->table->reassembled_table);
+		while (g_hash_table_iter_next(&iter, NULL, &value)) {
+			if (!g_hash_table_contains(seen, value)) {
+				g_hash_table_add(seen, value);
+				stats->complete_heads++;
+				stats->complete_bytes += fragment_head_data_size((fragment_head *)value);
+			}
+		}
+		g_hash_table_destroy(seen);
+	}
+}
+
+void
+reassembly_tables_get_stats(reassembly_stats_t *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+	g_list_foreach(reassembly_table_list, reassembly_table_add_stats, stats);
+	stats->evicted_heads = reassembly_evicted_heads;
+	stats->evicted_bytes = reassembly_evicted_bytes;
+	stats->lookups = reassembly_lookups;
+	stats->lookup_misses = reassembly_lookup_misses;
+	stats->completed = reassembly_completed;
+}
+
 void reassembly_tables_init(void)
 {
 	register_init_routine(&reassembly_table_init_reg_tables);
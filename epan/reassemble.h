@@ -83,6 +83,11 @@ typedef struct _fragment_item {
 	 * reassembly and for the fragments in a reassembly.
 	 */
 	const char *error;
+	/**
+	 * Only in the first item of the list: an index of the fragments
+	 * that is private to reassemble.c, or NULL.
+	 */
+	struct _fragment_index *frag_index;
 } fragment_item, fragment_head;
 
 
@@ -130,6 +135,19 @@ typedef struct {
 	fragment_temporary_key temporary_key_func;
 	fragment_persistent_key persistent_key_func;
 	GDestroyNotify free_temporary_key_func;		/* temporary key destruction function */
+	/*
+	 * If set, fragment_add() and friends make the reassembled data a
+	 * composite tvbuff over the fragments, rather than copying them into
+	 * one buffer, whenever the fragments fit together without partial
+	 * overlaps. The fragments then keep their data until the reassembly
+	 * is freed. This suits large PDUs of which only a small part is
+	 * usually looked at.
+	 */
+	gboolean composite_data;
+	/* Used to keep incomplete reassemblies within the limits set in the
+	 * preferences; see reassembly_table_sweep(). */
+	guint32 next_sweep;	/* frame from which to check the limits again */
+	guint64 pending_bytes;	/* data of incomplete reassemblies as last counted */
 } reassembly_table;
 
 /*
@@ -462,6 +480,30 @@ WS_DLL_PUBLIC gboolean
 show_fragment_seq_tree(fragment_head *ipfd_head, const fragment_items *fit,
     proto_tree *tree, packet_info *pinfo, tvbuff_t *tvb, proto_item **fi);
 
+/*
+ * Memory use of all registered reassembly tables, for debugging.
+ * "Pending" reassemblies are the ones still waiting for fragments, which
+ * are dropped when they exceed the limits set in the preferences;
+ * "complete" ones are kept until the end of the capture.  The counts of
+ * lookups and completed reassemblies show how much fragmented traffic
+ * the capture has.
+ */
+typedef struct {
+	guint   tables;
+	guint   pending_heads;
+	guint64 pending_bytes;
+	guint   complete_heads;
+	guint64 complete_bytes;
+	guint   evicted_heads;		/* since the capture was opened */
+	guint64 evicted_bytes;
+	guint64 lookups;		/* of pending reassemblies, for fragments, since the capture was opened */
+	guint64 lookup_misses;		/* the lookups that found none, mostly starting one */
+	guint64 completed;		/* reassemblies completed since the capture was opened */
+} reassembly_stats_t;
+
+WS_DLL_PUBLIC void
+reassembly_tables_get_stats(reassembly_stats_t *stats);
+
 /* Initialize internal structures
  */
 extern void reassembly_tables_init(void);
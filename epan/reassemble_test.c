@@ -38,6 +38,7 @@
 
 #include <epan/packet.h>
 #include <epan/packet_info.h>
+#include <epan/prefs.h>
 #include <epan/proto.h>
 #include <epan/tvbuff.h>
 #include <epan/reassemble.h>
@@ -1918,6 +1919,219 @@ test_fragment_add_partial_reassembly(void)
     ASSERT(!tvb_memeql(fd_head->tvb_data,190,data,40));
 }
 
+/* This tests fragment_add based reassembly on a table with composite_data
+ * set, going through the same steps as
+ * test_fragment_add_partial_reassembly(). The fragments keep their data,
+ * and the reassembled data refers to it.
+ *
+ *    seq_off   frame  tvb_off   len   (initial) more_frags
+ *    -------   -----  -------   ---   --------------------
+ *        0       1       10      50   false
+ *       50       2        0      40   true
+ *       50       3        0      40   true (a duplicate fragment)
+ *       90       4       20     100   false
+ */
+static void
+test_fragment_add_composite(void)
+{
+    fragment_head *fd_head;
+    fragment_item *fd;
+
+    printf("Starting test test_fragment_add_composite\n");
+
+    test_reassembly_table.composite_data = TRUE;
+
+    pinfo.num = 1;
+    fd_head=fragment_add(&test_reassembly_table, tvb, 10, &pinfo, 12, NULL,
+                             0, 50, FALSE);
+
+    ASSERT_NE_POINTER(NULL,fd_head);
+    ASSERT_EQ(50,fd_head->datalen);
+    ASSERT_EQ(FD_DEFRAGMENTED|FD_DATALEN_SET,fd_head->flags);
+    ASSERT_NE_POINTER(NULL,fd_head->tvb_data);
+
+    /* the fragment keeps its data, which the reassembly refers to */
+    fd=fd_head->next;
+    ASSERT_EQ(0,fd->flags);
+    ASSERT_NE_POINTER(NULL,fd->tvb_data);
+    ASSERT_EQ_POINTER(tvb_get_ptr(fd->tvb_data,0,50),tvb_get_ptr(fd_head->tvb_data,0,50));
+    ASSERT(!tvb_memeql(fd_head->tvb_data,0,data+10,50));
+
+    fragment_set_partial_reassembly(&test_reassembly_table, &pinfo, 12, NULL);
+
+    pinfo.num = 2;
+    fd_head=fragment_add(&test_reassembly_table, tvb, 0, &pinfo, 12, NULL,
+                         50, 40, TRUE);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+
+    fd_head=fragment_get(&test_reassembly_table, &pinfo, 12, NULL);
+    ASSERT_NE_POINTER(NULL,fd_head);
+    ASSERT_EQ(0,fd_head->flags);
+
+    /* no need to point the first fragment into the old reassembly */
+    fd=fd_head->next;
+    ASSERT_EQ(0,fd->flags);
+    ASSERT_NE_POINTER(NULL,fd->tvb_data);
+
+    pinfo.num = 3;
+    fd_head=fragment_add(&test_reassembly_table, tvb, 0, &pinfo, 12, NULL,
+                         50, 40, TRUE);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+
+    pinfo.num = 4;
+    fd_head=fragment_add(&test_reassembly_table, tvb, 20, &pinfo, 12, NULL,
+                         90, 100, FALSE);
+
+    ASSERT_NE_POINTER(NULL,fd_head);
+    ASSERT_EQ(4,fd_head->frame);
+    ASSERT_EQ(190,fd_head->datalen);
+    ASSERT_EQ(4,fd_head->reassembled_in);
+    ASSERT_EQ(FD_DEFRAGMENTED|FD_DATALEN_SET|FD_OVERLAP,fd_head->flags);
+    ASSERT_NE_POINTER(NULL,fd_head->tvb_data);
+
+    fd=fd_head->next;
+    ASSERT_EQ(1,fd->frame);
+    ASSERT_EQ(0,fd->flags);
+    ASSERT_NE_POINTER(NULL,fd->tvb_data);
+
+    fd=fd->next;
+    ASSERT_EQ(2,fd->frame);
+    ASSERT_EQ(0,fd->flags);
+    ASSERT_NE_POINTER(NULL,fd->tvb_data);
+
+    /* the duplicate has been checked and dropped */
+    fd=fd->next;
+    ASSERT_EQ(3,fd->frame);
+    ASSERT_EQ(FD_OVERLAP,fd->flags);
+    ASSERT_EQ_POINTER(NULL,fd->tvb_data);
+
+    fd=fd->next;
+    ASSERT_EQ(4,fd->frame);
+    ASSERT_EQ(0,fd->flags);
+    ASSERT_NE_POINTER(NULL,fd->tvb_data);
+    ASSERT_EQ_POINTER(NULL,fd->next);
+
+    /* searches go through the fragments without copying them... */
+    ASSERT_EQ(55,tvb_find_guint8(fd_head->tvb_data,0,-1,5));
+    ASSERT_EQ(94,tvb_find_guint8(fd_head->tvb_data,80,-1,24));
+
+    /* ...and so does getting bytes from within one fragment */
+    ASSERT_EQ_POINTER(tvb_get_ptr(fd_head->next->next->tvb_data,0,40),
+                      tvb_get_ptr(fd_head->tvb_data,50,40));
+
+    /* test the actual reassembly */
+    ASSERT(!tvb_memeql(fd_head->tvb_data,0,data+10,50));
+    ASSERT(!tvb_memeql(fd_head->tvb_data,50,data,40));
+    ASSERT(!tvb_memeql(fd_head->tvb_data,90,data+20,100));
+
+    test_reassembly_table.composite_data = FALSE;
+}
+
+/* Test case for many fragments arriving out of order, enough of them for
+ * the fragment list to be indexed. Adds 100 fragments of 2 bytes, the
+ * k-th at offset 2*k with the data at tvb offset k, in the order
+ * k = 37*i % 100, and checks that they are only reassembled by the last
+ * one added, in the right order. Then does the same for a sequence.
+ */
+static void
+test_fragment_add_out_of_order(void)
+{
+    fragment_head *fd_head;
+    fragment_item *fd;
+    guint32 i, k;
+
+    printf("Starting test test_fragment_add_out_of_order\n");
+
+    for (i = 0; i < 100; i++) {
+        k = 37*i % 100;
+        pinfo.num = i + 1;
+        fd_head=fragment_add(&test_reassembly_table, tvb, k, &pinfo, 12, NULL,
+                             2*k, 2, k != 99);
+        if (i < 99) {
+            ASSERT_EQ_POINTER(NULL,fd_head);
+        }
+    }
+
+    ASSERT_NE_POINTER(NULL,fd_head);
+    ASSERT_EQ(200,fd_head->datalen);
+    ASSERT_EQ(100,fd_head->reassembled_in);
+    ASSERT_EQ(FD_DEFRAGMENTED|FD_DATALEN_SET,fd_head->flags);
+
+    for (k = 0, fd = fd_head->next; fd; k++, fd = fd->next) {
+        ASSERT_EQ(2*k,fd->offset);
+        ASSERT(!tvb_memeql(fd_head->tvb_data,2*k,data+k,2));
+    }
+    ASSERT_EQ(100,k);
+
+    for (i = 0; i < 100; i++) {
+        k = 37*i % 100;
+        pinfo.num = 101 + i;
+        fd_head=fragment_add_seq(&test_reassembly_table, tvb, k, &pinfo, 13, NULL,
+                                 k, 2, k != 99, 0);
+        if (i < 99) {
+            ASSERT_EQ_POINTER(NULL,fd_head);
+        }
+    }
+
+    ASSERT_NE_POINTER(NULL,fd_head);
+    ASSERT_EQ(99,fd_head->datalen); /* seqno of the last fragment we have */
+    ASSERT_EQ(200,fd_head->reassembled_in);
+    ASSERT_EQ(FD_DEFRAGMENTED|FD_BLOCKSEQUENCE|FD_DATALEN_SET,fd_head->flags);
+
+    for (k = 0, fd = fd_head->next; fd; k++, fd = fd->next) {
+        ASSERT_EQ(k,fd->offset);
+        ASSERT(!tvb_memeql(fd_head->tvb_data,2*k,data+k,2));
+    }
+    ASSERT_EQ(100,k);
+}
+
+/* Test case for dropping incomplete reassemblies that are too old.
+ * Starts two datagrams, and checks that the one that isn't extended for
+ * longer than prefs.reassembly_max_age frames is dropped on the first pass.
+ */
+static void
+test_fragment_add_max_age(void)
+{
+    fragment_head *fd_head;
+    reassembly_stats_t stats;
+    guint evicted_heads;
+
+    printf("Starting test test_fragment_add_max_age\n");
+
+    prefs.reassembly_max_age = 100;
+    reassembly_tables_get_stats(&stats);
+    evicted_heads = stats.evicted_heads;
+
+    pinfo.num = 1;
+    fd_head=fragment_add(&test_reassembly_table, tvb, 10, &pinfo, 12, NULL,
+                         0, 50, TRUE);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+    fd_head=fragment_add(&test_reassembly_table, tvb, 10, &pinfo, 13, NULL,
+                         0, 50, TRUE);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+    ASSERT_EQ(2,g_hash_table_size(test_reassembly_table.fragment_table));
+
+    /* keep the second datagram going */
+    pinfo.num = 1000;
+    fd_head=fragment_add(&test_reassembly_table, tvb, 5, &pinfo, 13, NULL,
+                         50, 60, TRUE);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+
+    /* the limits are only checked from time to time */
+    pinfo.num = 1100;
+    fd_head=fragment_add(&test_reassembly_table, tvb, 5, &pinfo, 13, NULL,
+                         110, 60, TRUE);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+    ASSERT_EQ(1,g_hash_table_size(test_reassembly_table.fragment_table));
+    ASSERT_EQ_POINTER(NULL,fragment_get(&test_reassembly_table, &pinfo, 12, NULL));
+    ASSERT_NE_POINTER(NULL,fragment_get(&test_reassembly_table, &pinfo, 13, NULL));
+
+    reassembly_tables_get_stats(&stats);
+    ASSERT_EQ(evicted_heads + 1,stats.evicted_heads);
+
+    prefs.reassembly_max_age = 0;
+}
+
 /* XXX: Is the proper behavior here really throwing an exception instead
  * of setting FD_OVERLAP?
  */
@@ -3301,6 +3515,9 @@ main(int argc _U_, char **argv _U_)
 #endif
         test_simple_fragment_add,              /* frag table only   */
         test_fragment_add_partial_reassembly,
+        test_fragment_add_composite,
+        test_fragment_add_out_of_order,
+        test_fragment_add_max_age,
         test_fragment_add_duplicate_first,
         test_fragment_add_duplicate_middle,
         test_fragment_add_duplicate_last,
@@ -103,6 +103,71 @@ void reset_rtd_table(rtd_stat_table* table)
         memset(table->time_stats[i].rtd, 0, sizeof(timestat_t)*table->time_stats[i].num_timestat);
 }
 
+/*
+ * The statistics are saved as the table's dimensions, followed by the
+ * counters of each type of message and their time statistics.
+ */
+void rtd_table_save_state(void *tapdata, GByteArray *state)
+{
+    rtd_data_t *data = (rtd_data_t *)tapdata;
+    rtd_stat_table *table = &data->stat_table;
+    guint i;
+
+    g_byte_array_append(state, (const guint8 *)&table->num_rtds, sizeof table->num_rtds);
+    for (i = 0; i < table->num_rtds; i++)
+    {
+        rtd_timestat *ts = &table->time_stats[i];
+
+        g_byte_array_append(state, (const guint8 *)&ts->num_timestat, sizeof ts->num_timestat);
+        g_byte_array_append(state, (const guint8 *)&ts->open_req_num, sizeof ts->open_req_num);
+        g_byte_array_append(state, (const guint8 *)&ts->disc_rsp_num, sizeof ts->disc_rsp_num);
+        g_byte_array_append(state, (const guint8 *)&ts->req_dup_num, sizeof ts->req_dup_num);
+        g_byte_array_append(state, (const guint8 *)&ts->rsp_dup_num, sizeof ts->rsp_dup_num);
+        g_byte_array_append(state, (const guint8 *)ts->rtd, sizeof(timestat_t)*ts->num_timestat);
+    }
+}
+
+gboolean rtd_table_merge_state(void *tapdata, const guint8 *state, gsize len)
+{
+    rtd_data_t *data = (rtd_data_t *)tapdata;
+    rtd_stat_table *table = &data->stat_table;
+    tap_state_reader_t reader;
+    guint num_rtds, i, j;
+
+    reader.data = state;
+    reader.len = len;
+    if (!tap_state_read(&reader, &num_rtds, sizeof num_rtds) || num_rtds != table->num_rtds)
+        return FALSE;
+
+    for (i = 0; i < table->num_rtds; i++)
+    {
+        rtd_timestat *ts = &table->time_stats[i];
+        rtd_timestat from;
+
+        if (!tap_state_read(&reader, &from.num_timestat, sizeof from.num_timestat) ||
+            from.num_timestat != ts->num_timestat ||
+            !tap_state_read(&reader, &from.open_req_num, sizeof from.open_req_num) ||
+            !tap_state_read(&reader, &from.disc_rsp_num, sizeof from.disc_rsp_num) ||
+            !tap_state_read(&reader, &from.req_dup_num, sizeof from.req_dup_num) ||
+            !tap_state_read(&reader, &from.rsp_dup_num, sizeof from.rsp_dup_num))
+            return FALSE;
+        ts->open_req_num += from.open_req_num;
+        ts->disc_rsp_num += from.disc_rsp_num;
+        ts->req_dup_num += from.req_dup_num;
+        ts->rsp_dup_num += from.rsp_dup_num;
+
+        for (j = 0; j < ts->num_timestat; j++)
+        {
+            timestat_t stats;
+
+            if (!tap_state_read(&reader, &stats, sizeof stats))
+                return FALSE;
+            time_stat_merge(&ts->rtd[j], &stats);
+        }
+    }
+    return reader.len == 0;
+}
+
 register_rtd_t* get_rtd_table_by_name(const char* name)
 {
     return (register_rtd_t*)wmem_tree_lookup_string(registered_rtd_tables, name, 0);
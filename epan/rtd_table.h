@@ -118,6 +118,22 @@ WS_DLL_PUBLIC void free_rtd_table(rtd_stat_table* table);
  */
 WS_DLL_PUBLIC void reset_rtd_table(rtd_stat_table* table);
 
+/** Save the statistics of an rtd tap; see set_tap_listener_mergeable().
+ *
+ * @param tapdata the rtd_data_t of the tap
+ * @param state the array to append them to
+ */
+WS_DLL_PUBLIC void rtd_table_save_state(void *tapdata, GByteArray *state);
+
+/** Add saved statistics to those of an rtd tap; see set_tap_listener_mergeable().
+ *
+ * @param tapdata the rtd_data_t of the tap
+ * @param state the statistics, saved by rtd_table_save_state()
+ * @param len their length
+ * @return FALSE if they don't match the table
+ */
+WS_DLL_PUBLIC gboolean rtd_table_merge_state(void *tapdata, const guint8 *state, gsize len);
+
 /** Interator to walk RTD tables and execute func
  * Used for initialization
  *
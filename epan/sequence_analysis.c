@@ -219,7 +219,21 @@ sequence_analysis_sort_compare(gconstpointer a, gconstpointer b, gpointer user_d
 void
 sequence_analysis_list_sort(seq_analysis_info_t *sainfo)
 {
+    GList *list;
+
     if (!sainfo) return;
+
+    /*
+     * Taps add items as they see the frames, so the list is nearly always
+     * in order already; don't rebuild hundreds of thousands of links then.
+     */
+    for (list = g_queue_peek_head_link(sainfo->items); list && list->next; list = list->next) {
+        if (sequence_analysis_sort_compare(list->data, list->next->data, NULL) > 0)
+            break;
+    }
+    if (list == NULL || list->next == NULL)
+        return;
+
     g_queue_sort(sainfo->items, sequence_analysis_sort_compare, NULL);
 }
 
@@ -528,20 +542,22 @@ sequence_analysis_dump_to_file(FILE  *of, seq_analysis_info_t *sainfo, unsigned
 
         /* write the frame label */
 
-        g_string_printf(tmp_str, "%s", empty_line->str);
+        g_string_assign(tmp_str, empty_line->str);
         overwrite(tmp_str, sai->frame_label,
             start_position,
             end_position
             );
-        fprintf(of, "%s", tmp_str->str);
+        fputs(tmp_str->str, of);
 
         /* write the comments */
-        fprintf(of, "%s\n", sai->comment);
+        if (sai->comment != NULL)
+            fputs(sai->comment, of);
+        fputc('\n', of);
 
         /* write the arrow and frame label*/
-        fprintf(of, "%s", empty_header);
+        fputs(empty_header, of);
 
-        g_string_printf(tmp_str, "%s", empty_line->str);
+        g_string_assign(tmp_str, empty_line->str);
 
         g_string_truncate(tmp_str2, 0);
 
@@ -571,7 +587,8 @@ sequence_analysis_dump_to_file(FILE  *of, seq_analysis_info_t *sainfo, unsigned
             overwrite(tmp_str, dst_port, end_position-9, end_position+1);
         }
 
-        fprintf(of, "%s\n", tmp_str->str);
+        fputs(tmp_str->str, of);
+        fputc('\n', of);
     }
 
     g_string_free(label_string, TRUE);
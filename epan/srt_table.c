@@ -260,6 +260,92 @@ add_srt_table_data(srt_stat_table *rst, int indx, const nstime_t *req_time, pack
     time_stat_update(&rp->stats, &delta, pinfo);
 }
 
+/*
+ * The statistics are saved table by table, each as its number of
+ * procedures followed by those that have any samples, with their names.
+ */
+void
+srt_table_save_state(void *tapdata, GByteArray *state)
+{
+    srt_data_t *data = (srt_data_t *)tapdata;
+    guint32 num_tables = data->srt_array->len;
+    guint i;
+
+    g_byte_array_append(state, (const guint8 *)&num_tables, sizeof num_tables);
+    for (i = 0; i < data->srt_array->len; i++) {
+        srt_stat_table *rst = g_array_index(data->srt_array, srt_stat_table*, i);
+        gint32 num_procs = 0;
+        int j;
+
+        for (j = 0; j < rst->num_procs; j++) {
+            if (rst->procedures[j].stats.num != 0)
+                num_procs++;
+        }
+        g_byte_array_append(state, (const guint8 *)&num_procs, sizeof num_procs);
+        for (j = 0; j < rst->num_procs; j++) {
+            srt_procedure_t *rp = &rst->procedures[j];
+            guint32 name_len = rp->procedure ? (guint32)strlen(rp->procedure) : 0;
+
+            if (rp->stats.num == 0)
+                continue;
+            g_byte_array_append(state, (const guint8 *)&rp->proc_index, sizeof rp->proc_index);
+            g_byte_array_append(state, (const guint8 *)&name_len, sizeof name_len);
+            g_byte_array_append(state, (const guint8 *)rp->procedure, name_len);
+            g_byte_array_append(state, (const guint8 *)&rp->stats, sizeof rp->stats);
+        }
+    }
+}
+
+gboolean
+srt_table_merge_state(void *tapdata, const guint8 *state, gsize len)
+{
+    srt_data_t *data = (srt_data_t *)tapdata;
+    tap_state_reader_t reader;
+    guint32 num_tables, i;
+
+    reader.data = state;
+    reader.len = len;
+    if (!tap_state_read(&reader, &num_tables, sizeof num_tables) ||
+        num_tables != data->srt_array->len)
+        return FALSE;
+
+    for (i = 0; i < num_tables; i++) {
+        srt_stat_table *rst = g_array_index(data->srt_array, srt_stat_table*, i);
+        gint32 num_procs, j;
+
+        if (!tap_state_read(&reader, &num_procs, sizeof num_procs))
+            return FALSE;
+        for (j = 0; j < num_procs; j++) {
+            int proc_index;
+            guint32 name_len;
+            const char *name;
+            timestat_t stats;
+
+            if (!tap_state_read(&reader, &proc_index, sizeof proc_index) ||
+                proc_index < 0 ||
+                !tap_state_read(&reader, &name_len, sizeof name_len) ||
+                name_len > reader.len)
+                return FALSE;
+            name = (const char *)reader.data;
+            reader.data += name_len;
+            reader.len -= name_len;
+            if (!tap_state_read(&reader, &stats, sizeof stats))
+                return FALSE;
+
+            /* Procedures can be discovered as packets are seen. */
+            if (proc_index >= rst->num_procs ||
+                (rst->procedures[proc_index].procedure == NULL && name_len != 0)) {
+                gchar *procedure = g_strndup(name, name_len);
+
+                init_srt_table_row(rst, proc_index, procedure);
+                g_free(procedure);
+            }
+            time_stat_merge(&rst->procedures[proc_index].stats, &stats);
+        }
+    }
+    return reader.len == 0;
+}
+
 /*
  * Editor modelines
  *
@@ -198,6 +198,22 @@ WS_DLL_PUBLIC void init_srt_table_row(srt_stat_table *rst, int proc_index, const
  */
 WS_DLL_PUBLIC void add_srt_table_data(srt_stat_table *rst, int proc_index, const nstime_t *req_time, packet_info *pinfo);
 
+/** Save the statistics of the tables of an srt tap; see set_tap_listener_mergeable().
+ *
+ * @param tapdata the srt_data_t of the tap
+ * @param state the array to append them to
+ */
+WS_DLL_PUBLIC void srt_table_save_state(void *tapdata, GByteArray *state);
+
+/** Add saved statistics to those of the tables of an srt tap; see set_tap_listener_mergeable().
+ *
+ * @param tapdata the srt_data_t of the tap
+ * @param state the statistics, saved by srt_table_save_state()
+ * @param len their length
+ * @return FALSE if they don't match the tables
+ */
+WS_DLL_PUBLIC gboolean srt_table_merge_state(void *tapdata, const guint8 *state, gsize len);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
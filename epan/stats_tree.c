@@ -553,6 +553,157 @@ stats_tree_create_node_by_pname(stats_tree *st, const gchar *name,
     return stats_tree_create_node(st,name,stats_tree_parent_id_by_name(st,parent_name),datatype,with_children);
 }
 
+/*
+ * The state of a tree is saved node by node, parents before their
+ * children, each with its name, how to create it if the tree it is merged
+ * into doesn't have it, its values and its number of children.  Nodes are
+ * matched by name; the burst rate of a merged node is the highest of those
+ * of the nodes merged, as bursts that span the parts aren't seen.
+ */
+static void
+save_stat_node(const stat_node *node, GByteArray *state)
+{
+    const stat_node *child;
+    guint32 name_len = (guint32)strlen(node->name);
+    guint32 num_children = 0;
+    guint8 kind[3];
+
+    kind[0] = node->hash != NULL;
+    kind[1] = node->id >= 0;
+    kind[2] = (guint8)node->datatype;
+    g_byte_array_append(state, (const guint8 *)&name_len, sizeof name_len);
+    g_byte_array_append(state, (const guint8 *)node->name, name_len);
+    g_byte_array_append(state, kind, sizeof kind);
+    g_byte_array_append(state, (const guint8 *)&node->counter, sizeof node->counter);
+    g_byte_array_append(state, (const guint8 *)&node->total, sizeof node->total);
+    g_byte_array_append(state, (const guint8 *)&node->minvalue, sizeof node->minvalue);
+    g_byte_array_append(state, (const guint8 *)&node->maxvalue, sizeof node->maxvalue);
+    g_byte_array_append(state, (const guint8 *)&node->st_flags, sizeof node->st_flags);
+    g_byte_array_append(state, (const guint8 *)&node->max_burst, sizeof node->max_burst);
+    g_byte_array_append(state, (const guint8 *)&node->burst_time, sizeof node->burst_time);
+
+    for (child = node->children; child; child = child->next)
+        num_children++;
+    g_byte_array_append(state, (const guint8 *)&num_children, sizeof num_children);
+    for (child = node->children; child; child = child->next)
+        save_stat_node(child, state);
+}
+
+extern void
+stats_tree_save_state(void *p, GByteArray *state)
+{
+    stats_tree *st = (stats_tree *)p;
+
+    g_byte_array_append(state, (const guint8 *)&st->start, sizeof st->start);
+    g_byte_array_append(state, (const guint8 *)&st->now, sizeof st->now);
+    save_stat_node(&st->root, state);
+}
+
+/* Merge a saved node into node, then its children into node's. */
+static gboolean
+merge_stat_node(stats_tree *st, stat_node *node, tap_state_reader_t *reader)
+{
+    stat_node from;
+    guint32 num_children, i;
+
+    if (!tap_state_read(reader, &from.counter, sizeof from.counter) ||
+        !tap_state_read(reader, &from.total, sizeof from.total) ||
+        !tap_state_read(reader, &from.minvalue, sizeof from.minvalue) ||
+        !tap_state_read(reader, &from.maxvalue, sizeof from.maxvalue) ||
+        !tap_state_read(reader, &from.st_flags, sizeof from.st_flags) ||
+        !tap_state_read(reader, &from.max_burst, sizeof from.max_burst) ||
+        !tap_state_read(reader, &from.burst_time, sizeof from.burst_time) ||
+        !tap_state_read(reader, &num_children, sizeof num_children))
+        return FALSE;
+
+    node->counter += from.counter;
+    switch (node->datatype)
+    {
+    case STAT_DT_INT:
+        node->total.int_total += from.total.int_total;
+        node->minvalue.int_min = MIN(node->minvalue.int_min, from.minvalue.int_min);
+        node->maxvalue.int_max = MAX(node->maxvalue.int_max, from.maxvalue.int_max);
+        break;
+    case STAT_DT_FLOAT:
+        node->total.float_total += from.total.float_total;
+        node->minvalue.float_min = MIN(node->minvalue.float_min, from.minvalue.float_min);
+        node->maxvalue.float_max = MAX(node->maxvalue.float_max, from.maxvalue.float_max);
+        break;
+    }
+    node->st_flags |= from.st_flags;
+    if (from.max_burst > node->max_burst) {
+        node->max_burst = from.max_burst;
+        node->burst_time = from.burst_time;
+    }
+
+    for (i = 0; i < num_children; i++) {
+        stat_node *child;
+        guint32 name_len;
+        gchar *name;
+        guint8 kind[3];
+
+        if (!tap_state_read(reader, &name_len, sizeof name_len) || name_len > reader->len)
+            return FALSE;
+        name = g_strndup((const gchar *)reader->data, name_len);
+        reader->data += name_len;
+        reader->len -= name_len;
+        if (!tap_state_read(reader, kind, sizeof kind)) {
+            g_free(name);
+            return FALSE;
+        }
+
+        for (child = node->children; child; child = child->next) {
+            if (strcmp(child->name, name) == 0)
+                break;
+        }
+        if (!child) {
+            /* Only registered nodes can have children added to them. */
+            if (node->id < 0) {
+                g_free(name);
+                return FALSE;
+            }
+            child = new_stat_node(st, name, node->id, (stat_node_datatype)kind[2],
+                                  kind[0], kind[1]);
+        }
+        g_free(name);
+        if (!merge_stat_node(st, child, reader))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+extern gboolean
+stats_tree_merge_state(void *p, const guint8 *state, gsize len)
+{
+    stats_tree *st = (stats_tree *)p;
+    tap_state_reader_t reader;
+    double start, now;
+    guint32 name_len;
+    guint8 kind[3];
+
+    reader.data = state;
+    reader.len = len;
+    if (!tap_state_read(&reader, &start, sizeof start) ||
+        !tap_state_read(&reader, &now, sizeof now) ||
+        !tap_state_read(&reader, &name_len, sizeof name_len) ||
+        name_len > reader.len)
+        return FALSE;
+    /* The root's name is that of the tree. */
+    reader.data += name_len;
+    reader.len -= name_len;
+    if (!tap_state_read(&reader, kind, sizeof kind))
+        return FALSE;
+
+    if (start >= 0.0 && (st->start < 0.0 || start < st->start))
+        st->start = start;
+    if (now > st->now)
+        st->now = now;
+    if (st->start >= 0.0)
+        st->elapsed = st->now - st->start;
+
+    return merge_stat_node(st, &st->root, &reader) && reader.len == 0;
+}
+
 /* Internal function to update the burst calculation data - add entry to bucket */
 static void
 update_burst_calc(stat_node *node, gint value)
@@ -640,32 +791,10 @@ update_burst_calc(stat_node *node, gint value)
     }
 }
 
-/*
- * Increases by delta the counter of the node whose name is given
- * if the node does not exist yet it's created (with counter=1)
- * using parent_name as parent node.
- * with_hash=TRUE to indicate that the created node will have a parent
- */
-int
-stats_tree_manip_node_int(manip_node_mode mode, stats_tree *st, const char *name,
-              int parent_id, gboolean with_hash, gint value)
+/* Internal function to change the values of a node */
+static void
+manip_stat_node_int(manip_node_mode mode, stat_node *node, gint value)
 {
-    stat_node *node = NULL;
-    stat_node *parent = NULL;
-
-    g_assert( parent_id >= 0 && parent_id < (int) st->parents->len );
-
-    parent = (stat_node *)g_ptr_array_index(st->parents,parent_id);
-
-    if( parent->hash ) {
-        node = (stat_node *)g_hash_table_lookup(parent->hash,name);
-    } else {
-        node = (stat_node *)g_hash_table_lookup(st->names,name);
-    }
-
-    if ( node == NULL )
-        node = new_stat_node(st,name,parent_id,STAT_DT_INT,with_hash,with_hash);
-
     switch (mode) {
         case MN_INCREASE:
             node->counter += value;
@@ -695,11 +824,55 @@ stats_tree_manip_node_int(manip_node_mode mode, stats_tree *st, const char *name
             node->st_flags &= ~value;
             break;
     }
+}
 
-    if (node)
-        return node->id;
-    else
-        return -1;
+/*
+ * Increases by delta the counter of the node whose name is given
+ * if the node does not exist yet it's created (with counter=1)
+ * using parent_name as parent node.
+ * with_hash=TRUE to indicate that the created node will have a parent
+ */
+int
+stats_tree_manip_node_int(manip_node_mode mode, stats_tree *st, const char *name,
+              int parent_id, gboolean with_hash, gint value)
+{
+    stat_node *node = NULL;
+    stat_node *parent = NULL;
+
+    g_assert( parent_id >= 0 && parent_id < (int) st->parents->len );
+
+    parent = (stat_node *)g_ptr_array_index(st->parents,parent_id);
+
+    if( parent->hash ) {
+        node = (stat_node *)g_hash_table_lookup(parent->hash,name);
+    } else {
+        node = (stat_node *)g_hash_table_lookup(st->names,name);
+    }
+
+    if ( node == NULL )
+        node = new_stat_node(st,name,parent_id,STAT_DT_INT,with_hash,with_hash);
+
+    manip_stat_node_int(mode, node, value);
+
+    return node->id;
+}
+
+/*
+ * Changes the values of the node with the given id, as returned when it
+ * was created, without looking it up by name.
+ */
+int
+stats_tree_manip_node_int_by_id(manip_node_mode mode, stats_tree *st, int node_id, gint value)
+{
+    stat_node *node;
+
+    g_assert( node_id >= 0 && node_id < (int) st->parents->len );
+
+    node = (stat_node *)g_ptr_array_index(st->parents,node_id);
+
+    manip_stat_node_int(mode, node, value);
+
+    return node->id;
 }
 
 /*
@@ -909,31 +1082,13 @@ stats_tree_range_node_with_pname(stats_tree *st, const gchar *name,
 }
 
 
-extern int
-stats_tree_tick_range(stats_tree *st, const gchar *name, int parent_id,
-              int value_in_range)
+/* Internal function to tick a range node and its range containing a value */
+static void
+tick_range_node(stat_node *node, int value_in_range)
 {
-
-    stat_node *node = NULL;
-    stat_node *parent = NULL;
     stat_node *child = NULL;
     gint stat_floor, stat_ceil;
 
-    if (parent_id >= 0 && parent_id < (int) st->parents->len) {
-        parent = (stat_node *)g_ptr_array_index(st->parents,parent_id);
-    } else {
-        g_assert_not_reached();
-    }
-
-    if( parent->hash ) {
-        node = (stat_node *)g_hash_table_lookup(parent->hash,name);
-    } else {
-        node = (stat_node *)g_hash_table_lookup(st->names,name);
-    }
-
-    if ( node == NULL )
-        g_assert_not_reached();
-
     /* update stats for container node. counter should already be ticked so we only update total and min/max */
     node->total.int_total += value_in_range;
     if (node->minvalue.int_min > value_in_range) {
@@ -959,9 +1114,49 @@ stats_tree_tick_range(stats_tree *st, const gchar *name, int parent_id,
             }
             child->st_flags |= ST_FLG_AVERAGE;
             update_burst_calc(child, 1);
-            return node->id;
+            return;
         }
     }
+}
+
+extern int
+stats_tree_tick_range(stats_tree *st, const gchar *name, int parent_id,
+              int value_in_range)
+{
+
+    stat_node *node = NULL;
+    stat_node *parent = NULL;
+
+    if (parent_id >= 0 && parent_id < (int) st->parents->len) {
+        parent = (stat_node *)g_ptr_array_index(st->parents,parent_id);
+    } else {
+        g_assert_not_reached();
+    }
+
+    if( parent->hash ) {
+        node = (stat_node *)g_hash_table_lookup(parent->hash,name);
+    } else {
+        node = (stat_node *)g_hash_table_lookup(st->names,name);
+    }
+
+    if ( node == NULL )
+        g_assert_not_reached();
+
+    tick_range_node(node, value_in_range);
+
+    return node->id;
+}
+
+extern int
+stats_tree_tick_range_by_id(stats_tree *st, int range_node_id, int value_in_range)
+{
+    stat_node *node;
+
+    g_assert( range_node_id >= 0 && range_node_id < (int) st->parents->len );
+
+    node = (stat_node *)g_ptr_array_index(st->parents,range_node_id);
+
+    tick_range_node(node, value_in_range);
 
     return node->id;
 }
@@ -164,6 +164,11 @@ WS_DLL_PUBLIC int stats_tree_tick_range(stats_tree *st,
 #define stats_tree_tick_range_by_pname(st,name,parent_name,value_in_range) \
     stats_tree_tick_range((st),(name),stats_tree_parent_id_by_name((st),(parent_name),(value_in_range)))
 
+/* as stats_tree_tick_range, for the range node with the id returned when it was created */
+WS_DLL_PUBLIC int stats_tree_tick_range_by_id(stats_tree *st,
+                                              int range_node_id,
+                                              int value_in_range);
+
 /* */
 WS_DLL_PUBLIC int stats_tree_create_pivot(stats_tree *st,
                                           const gchar *name,
@@ -201,6 +206,17 @@ WS_DLL_PUBLIC int stats_tree_manip_node_int(manip_node_mode mode,
                                         gboolean with_children,
                                         gint value);
 
+/*
+ * manipulates the value of the node with the given id, as returned by
+ * stats_tree_create_node() and the like, or by stats_tree_manip_node_int()
+ * for a node created with_children; this is much cheaper than looking the
+ * node up by name, for nodes that are ticked for many packets.
+ */
+WS_DLL_PUBLIC int stats_tree_manip_node_int_by_id(manip_node_mode mode,
+                                                  stats_tree *st,
+                                                  int node_id,
+                                                  gint value);
+
 WS_DLL_PUBLIC int stats_tree_manip_node_float(manip_node_mode mode,
                                         stats_tree *st,
                                         const gchar *name,
@@ -220,6 +236,12 @@ WS_DLL_PUBLIC int stats_tree_manip_node_float(manip_node_mode mode,
 #define zero_stat_node(st,name,parent_id,with_children)                 \
     (stats_tree_manip_node_int(MN_SET,(st),(name),(parent_id),(with_children),0))
 
+#define increase_stat_node_by_id(st,node_id,value)                      \
+    (stats_tree_manip_node_int_by_id(MN_INCREASE,(st),(node_id),(value)))
+
+#define tick_stat_node_by_id(st,node_id)                                \
+    (stats_tree_manip_node_int_by_id(MN_INCREASE,(st),(node_id),1))
+
 /*
  * Add value to average calculation WITHOUT ticking node. Node MUST be ticked separately!
  *
@@ -237,6 +259,9 @@ WS_DLL_PUBLIC int stats_tree_manip_node_float(manip_node_mode mode,
 #define avg_stat_node_add_value_float(st,name,parent_id,with_children,value)  \
     (stats_tree_manip_node_float(MN_AVERAGE,(st),(name),(parent_id),(with_children),value))
 
+#define avg_stat_node_add_value_int_by_id(st,node_id,value)             \
+    (stats_tree_manip_node_int_by_id(MN_AVERAGE,(st),(node_id),(value)))
+
 /* Set flags for this node. Node created if it does not yet exist. */
 #define stat_node_set_flags(st,name,parent_id,with_children,flags)      \
     (stats_tree_manip_node_int(MN_SET_FLAGS,(st),(name),(parent_id),(with_children),flags))
@@ -180,6 +180,10 @@ WS_DLL_PUBLIC stats_tree *stats_tree_new(stats_tree_cfg *cfg, tree_pres *pr, con
 /** callback for taps */
 WS_DLL_PUBLIC tap_packet_status stats_tree_packet(void*, packet_info*, epan_dissect_t*, const void *);
 
+/** callbacks for set_tap_listener_mergeable() */
+WS_DLL_PUBLIC void stats_tree_save_state(void *p_st, GByteArray *state);
+WS_DLL_PUBLIC gboolean stats_tree_merge_state(void *p_st, const guint8 *state, gsize len);
+
 /** callback for reset */
 WS_DLL_PUBLIC void stats_tree_reset(void *p_st);
 
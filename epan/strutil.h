@@ -263,7 +263,7 @@ gchar*     xml_escape(const gchar *unescaped);
 
 /**
  * Return the first occurrence of needle in haystack.
- * Algorithm copied from GNU's glibc 2.3.2 memcmp()
+ * This is ws_memmem(), which uses SIMD instructions where it can.
  *
  * @param haystack The data to search
  * @param haystack_len The length of the search data
@@ -25,6 +25,7 @@
 #include <epan/packet_info.h>
 #include <epan/dfilter/dfilter.h>
 #include <epan/tap.h>
+#include <epan/plugin_manifest.h>
 
 static gboolean tapping_is_active=FALSE;
 
@@ -84,21 +85,39 @@ typedef struct _tap_listener_t {
 	guint flags;
 	gchar *fstring;
 	dfilter_t *code;
+	/* An other listener with the same filter, which is the one evaluated
+	   for both, or NULL; see tap_listeners_share_filters() */
+	struct _tap_listener_t *filter_owner;
+	int filter_result;	/* TAP_FILTER_xxx, for the frame being pushed */
+	gboolean retap;		/* marked by mark_tap_listener_for_retap() */
 	void *tapdata;
 	tap_reset_cb reset;
 	tap_packet_cb packet;
 	tap_draw_cb draw;
 	tap_finish_cb finish;
+	tap_save_state_cb save_state;	/* both NULL unless mergeable */
+	tap_merge_state_cb merge_state;
 } tap_listener_t;
 
 static tap_listener_t *tap_listener_queue=NULL;
 
+#define TAP_FILTER_UNKNOWN	-1	/* not evaluated yet */
+#define TAP_FILTER_FAILED	0
+#define TAP_FILTER_PASSED	1
+
+/* While a retap is limited to the listeners marked for it, the others are
+   left alone, as if they weren't registered. */
+static gboolean retap_marked_only=FALSE;
+
+#define TAP_LISTENER_ACTIVE(tl)	(!retap_marked_only || (tl)->retap)
+
 static GSList *tap_plugins = NULL;
 
 #ifdef HAVE_PLUGINS
 void
 tap_register_plugin(const tap_plugin *plug)
 {
+	plugin_manifest_keep_loaded();
 	tap_plugins = g_slist_prepend(tap_plugins, (tap_plugin *)plug);
 }
 #else /* HAVE_PLUGINS */
@@ -270,7 +289,7 @@ void tap_build_interesting (epan_dissect_t *edt)
 	/* loop over all tap listeners and build the list of all
 	   interesting hf_fields */
 	for(tl=tap_listener_queue;tl;tl=tl->next){
-		if(tl->code){
+		if(tl->code && !tl->filter_owner && TAP_LISTENER_ACTIVE(tl)){
 			epan_dissect_prime_with_dfilter(edt, tl->code);
 		}
 	}
@@ -295,6 +314,21 @@ tap_queue_init(epan_dissect_t *edt)
 	tap_build_interesting (edt);
 }
 
+/* Whether the frame being pushed passes the filter of a listener; a filter
+   is evaluated at most once a frame, however many packets were queued and
+   however many listeners have it. */
+static gboolean
+tap_listener_filter_passes(tap_listener_t *tl, epan_dissect_t *edt)
+{
+	tap_listener_t *owner = tl->filter_owner ? tl->filter_owner : tl;
+
+	if(owner->filter_result == TAP_FILTER_UNKNOWN){
+		owner->filter_result = dfilter_apply_edt(owner->code, edt) ?
+		    TAP_FILTER_PASSED : TAP_FILTER_FAILED;
+	}
+	return owner->filter_result == TAP_FILTER_PASSED;
+}
+
 /* this function is called after a packet has been fully dissected to push the tapped
    data to all extensions that has callbacks registered.
 */
@@ -317,6 +351,10 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 		return;
 	}
 
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		tl->filter_result = TAP_FILTER_UNKNOWN;
+	}
+
 	/* loop over all tap listeners and call the listener callback
 	   for all packets that match the filter. */
 	for(i=0;i<tap_packet_index;i++){
@@ -327,7 +365,7 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 			 */
 			if (!(tp->flags & TAP_PACKET_IS_ERROR_PACKET) || (tl->flags & TL_REQUIRES_ERROR_PACKETS))
 			{
-				if(tp->tap_id==tl->tap_id){
+				if(tp->tap_id==tl->tap_id && TAP_LISTENER_ACTIVE(tl)){
 					if(!tl->packet){
 						/* There isn't a per-packet
 						 * routine for this tap.
@@ -347,7 +385,7 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 					 * packet passes.
 					 */
 					if(tl->code){
-						if (!dfilter_apply_edt(tl->code, edt)){
+						if (!tap_listener_filter_passes(tl, edt)){
 							/* The packet didn't
 							 * pass the filter. */
 							continue;
@@ -431,6 +469,9 @@ reset_tap_listeners(void)
 	tap_listener_t *tl;
 
 	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(!TAP_LISTENER_ACTIVE(tl)){
+			continue;
+		}
 		if(tl->reset){
 			tl->reset(tl->tapdata);
 		}
@@ -503,6 +544,30 @@ find_tap_id(const char *name)
 	return 0;
 }
 
+/* Make each listener whose filter is the same as one of an other listener
+   use the result of that one. Called whenever a listener or a filter
+   changes. */
+static void
+tap_listeners_share_filters(void)
+{
+	tap_listener_t *tl, *tl2;
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		tl->filter_owner=NULL;
+		tl->filter_result=TAP_FILTER_UNKNOWN;
+		if(!tl->code){
+			continue;
+		}
+		for(tl2=tap_listener_queue;tl2!=tl;tl2=tl2->next){
+			if(tl2->code && !tl2->filter_owner &&
+			    strcmp(tl2->fstring, tl->fstring) == 0){
+				tl->filter_owner=tl2;
+				break;
+			}
+		}
+	}
+}
+
 static void
 free_tap_listener(tap_listener_t *tl)
 {
@@ -571,6 +636,7 @@ register_tap_listener(const char *tapname, void *tapdata, const char *fstring,
 	tl->next=tap_listener_queue;
 
 	tap_listener_queue=tl;
+	tap_listeners_share_filters();
 
 	return NULL;
 }
@@ -611,6 +677,7 @@ set_tap_dfilter(void *tapdata, const char *fstring)
 		if(fstring){
 			if(!dfilter_compile(fstring, &code, &err_msg)){
 				tl->fstring=NULL;
+				tap_listeners_share_filters();
 				error_string = g_string_new("");
 				g_string_printf(error_string,
 						 "Filter \"%s\" is invalid - %s",
@@ -621,6 +688,7 @@ set_tap_dfilter(void *tapdata, const char *fstring)
 		}
 		tl->fstring=g_strdup(fstring);
 		tl->code=code;
+		tap_listeners_share_filters();
 	}
 
 	return NULL;
@@ -653,6 +721,7 @@ tap_listeners_dfilter_recompile(void)
 		}
 		tl->code=code;
 	}
+	tap_listeners_share_filters();
 }
 
 /* this function removes a tap listener
@@ -683,6 +752,7 @@ remove_tap_listener(void *tapdata)
 			return;
 		}
 	}
+	tap_listeners_share_filters();
 	free_tap_listener(tl);
 }
 
@@ -696,7 +766,7 @@ tap_listeners_require_dissection(void)
 	tap_listener_t *tap_queue = tap_listener_queue;
 
 	while(tap_queue) {
-		if(!(tap_queue->flags & TL_IS_DISSECTOR_HELPER))
+		if(!(tap_queue->flags & TL_IS_DISSECTOR_HELPER) && TAP_LISTENER_ACTIVE(tap_queue))
 			return TRUE;
 
 		tap_queue = tap_queue->next;
@@ -706,6 +776,22 @@ tap_listeners_require_dissection(void)
 
 }
 
+gboolean
+tap_listeners_filtered_by(const char *fstring)
+{
+	tap_listener_t *tap_queue = tap_listener_queue;
+
+	while(tap_queue) {
+		if(!(tap_queue->flags & TL_IS_DISSECTOR_HELPER) && TAP_LISTENER_ACTIVE(tap_queue) &&
+		   (tap_queue->fstring == NULL || strcmp(tap_queue->fstring, fstring) != 0))
+			return FALSE;
+
+		tap_queue = tap_queue->next;
+	}
+
+	return TRUE;
+}
+
 /* Returns TRUE there is an active tap listener for the specified tap id. */
 gboolean
 have_tap_listener(int tap_id)
@@ -713,7 +799,7 @@ have_tap_listener(int tap_id)
 	tap_listener_t *tap_queue = tap_listener_queue;
 
 	while(tap_queue) {
-		if(tap_queue->tap_id == tap_id)
+		if(tap_queue->tap_id == tap_id && TAP_LISTENER_ACTIVE(tap_queue))
 			return TRUE;
 
 		tap_queue = tap_queue->next;
@@ -731,7 +817,7 @@ have_filtering_tap_listeners(void)
 	tap_listener_t *tl;
 
 	for(tl=tap_listener_queue;tl;tl=tl->next){
-		if(tl->code)
+		if(tl->code && TAP_LISTENER_ACTIVE(tl))
 			return TRUE;
 	}
 	return FALSE;
@@ -749,11 +835,137 @@ union_of_tap_listener_flags(void)
 	guint flags = 0;
 
 	for(tl=tap_listener_queue;tl;tl=tl->next){
-		flags|=tl->flags;
+		if(TAP_LISTENER_ACTIVE(tl))
+			flags|=tl->flags;
 	}
 	return flags;
 }
 
+void
+mark_tap_listener_for_retap(void *tapdata)
+{
+	tap_listener_t *tl;
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(tl->tapdata==tapdata){
+			tl->retap=TRUE;
+		}
+	}
+}
+
+gboolean
+tap_listeners_begin_retap(void)
+{
+	tap_listener_t *tl;
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(tl->retap){
+			retap_marked_only=TRUE;
+			break;
+		}
+	}
+	return retap_marked_only;
+}
+
+void
+tap_listeners_end_retap(void)
+{
+	tap_listener_t *tl;
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		tl->retap=FALSE;
+	}
+	retap_marked_only=FALSE;
+}
+
+void
+set_tap_listener_mergeable(void *tapdata, tap_save_state_cb save,
+			   tap_merge_state_cb merge)
+{
+	tap_listener_t *tl;
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(tl->tapdata==tapdata){
+			tl->save_state=save;
+			tl->merge_state=merge;
+			break;
+		}
+	}
+}
+
+gboolean
+tap_listeners_are_mergeable(void)
+{
+	tap_listener_t *tl;
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(tl->packet && !(tl->flags & TL_IS_DISSECTOR_HELPER) &&
+		   TAP_LISTENER_ACTIVE(tl) && !tl->merge_state)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+ * The states of the listeners are saved one after the other, in the order
+ * of the listener queue, each one preceded by its length; a listener
+ * that isn't mergeable has an empty state.
+ */
+void
+tap_listeners_save_states(GByteArray *states)
+{
+	tap_listener_t *tl;
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		guint start=states->len;
+		guint64 len=0;
+
+		g_byte_array_append(states, (const guint8 *)&len, sizeof len);
+		if(tl->save_state){
+			tl->save_state(tl->tapdata, states);
+			len=states->len - start - sizeof len;
+			memcpy(states->data + start, &len, sizeof len);
+		}
+	}
+}
+
+gboolean
+tap_listeners_merge_states(const guint8 *states, gsize len)
+{
+	tap_state_reader_t reader;
+	tap_listener_t *tl;
+
+	reader.data=states;
+	reader.len=len;
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		guint64 state_len;
+
+		if(!tap_state_read(&reader, &state_len, sizeof state_len) ||
+		   state_len > reader.len)
+			return FALSE;
+		if(state_len != 0){
+			if(!tl->merge_state ||
+			   !tl->merge_state(tl->tapdata, reader.data, (gsize)state_len))
+				return FALSE;
+			tl->needs_redraw=TRUE;
+		}
+		reader.data+=state_len;
+		reader.len-=(gsize)state_len;
+	}
+	return reader.len == 0;
+}
+
+gboolean
+tap_state_read(tap_state_reader_t *reader, void *buf, gsize len)
+{
+	if(len > reader->len)
+		return FALSE;
+	memcpy(buf, reader->data, len);
+	reader->data+=len;
+	reader->len-=len;
+	return TRUE;
+}
+
 void tap_cleanup(void)
 {
 	tap_listener_t *elem_lq;
@@ -32,6 +32,8 @@ typedef void (*tap_reset_cb)(void *tapdata);
 typedef tap_packet_status (*tap_packet_cb)(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const void *data);
 typedef void (*tap_draw_cb)(void *tapdata);
 typedef void (*tap_finish_cb)(void *tapdata);
+typedef void (*tap_save_state_cb)(void *tapdata, GByteArray *state);
+typedef gboolean (*tap_merge_state_cb)(void *tapdata, const guint8 *state, gsize len);
 
 /**
  * Flags to indicate what a tap listener's packet routine requires.
@@ -241,6 +243,13 @@ WS_DLL_PUBLIC void remove_tap_listener(void *tapdata);
  */
 WS_DLL_PUBLIC gboolean tap_listeners_require_dissection(void);
 
+/**
+ * Return TRUE if every tap listener that requires dissection has the
+ * given filter, so that frames that don't match it don't need to be
+ * dissected for them, FALSE otherwise.
+ */
+WS_DLL_PUBLIC gboolean tap_listeners_filtered_by(const char *fstring);
+
 /** Returns TRUE there is an active tap listener for the specified tap id. */
 WS_DLL_PUBLIC gboolean have_tap_listener(int tap_id);
 
@@ -254,6 +263,67 @@ WS_DLL_PUBLIC gboolean have_filtering_tap_listeners(void);
  */
 WS_DLL_PUBLIC guint union_of_tap_listener_flags(void);
 
+/** Limit the next retap to a listener: if any listeners are marked when
+ * tap_listeners_begin_retap() is called, the others keep their state and
+ * are neither reset, nor given packets, nor counted by
+ * union_of_tap_listener_flags() and the like until tap_listeners_end_retap().
+ * Call it for each listener whose state must be computed again, such as
+ * those of a dialog that was just opened or whose settings changed.
+ *
+ * @param tapdata the instance identifier given to register_tap_listener()
+ */
+WS_DLL_PUBLIC void mark_tap_listener_for_retap(void *tapdata);
+
+/** Called by the code retapping a file, before computing the flags and
+ * resetting the listeners. Returns TRUE if the retap is limited to the
+ * marked listeners.
+ */
+WS_DLL_PUBLIC gboolean tap_listeners_begin_retap(void);
+
+/** Called by the code retapping a file once it is done; clears the marks.
+ */
+WS_DLL_PUBLIC void tap_listeners_end_retap(void);
+
+/** Make a tap listener mergeable: its state depends only on which packets
+ * it has seen, not on their order or on the state of the dissectors, so
+ * that the packets can be split between several processes, each tapping
+ * some of them, and the states of the listeners in those processes merged
+ * into one.
+ *
+ * save appends the listener's state to a byte array, and merge adds a
+ * state saved that way in another process to the listener's own.  The
+ * processes must be forks of the same one, with the same listeners
+ * registered, so that a state may refer to data shared by all of them,
+ * such as the static structures of dissectors.
+ */
+WS_DLL_PUBLIC void set_tap_listener_mergeable(void *tapdata,
+    tap_save_state_cb save, tap_merge_state_cb merge);
+
+/** Returns TRUE if every tap listener that needs to see packets is
+ * mergeable.
+ */
+WS_DLL_PUBLIC gboolean tap_listeners_are_mergeable(void);
+
+/** Append the states of all the mergeable tap listeners to a byte array.
+ */
+WS_DLL_PUBLIC void tap_listeners_save_states(GByteArray *states);
+
+/** Merge states saved by tap_listeners_save_states() into the tap
+ * listeners.  Returns FALSE if they don't match the listeners.
+ */
+WS_DLL_PUBLIC gboolean tap_listeners_merge_states(const guint8 *states, gsize len);
+
+/** Reads the items of a listener's saved state, for the merge callback. */
+typedef struct {
+	const guint8 *data;
+	gsize len;
+} tap_state_reader_t;
+
+/** Copy the next len bytes of a saved state to buf; returns FALSE if the
+ * state is too short.
+ */
+WS_DLL_PUBLIC gboolean tap_state_read(tap_state_reader_t *reader, void *buf, gsize len);
+
 /** This function can be used by a dissector to fetch any tapped data before
  * returning.
  * This can be useful if one wants to extract the data inside dissector  BEFORE
@@ -56,6 +56,28 @@ time_stat_update(timestat_t *stats, const nstime_t *delta, packet_info *pinfo)
 	stats->num++;
 }
 
+/* Add the samples of a timestat_t struct to another one */
+void
+time_stat_merge(timestat_t *stats, const timestat_t *from)
+{
+	if(from->num==0)
+		return;
+
+	if(stats->num==0 || nstime_cmp(&from->min, &stats->min) < 0){
+		stats->min=from->min;
+		stats->min_num=from->min_num;
+	}
+
+	if(stats->num==0 || nstime_cmp(&from->max, &stats->max) > 0){
+		stats->max=from->max;
+		stats->max_num=from->max_num;
+	}
+
+	nstime_add(&stats->tot, &from->tot);
+
+	stats->num+=from->num;
+}
+
 /*
  * get_average - function
  *
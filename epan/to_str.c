@@ -418,6 +418,31 @@ get_zonename(struct tm *tmp)
 #endif /* _WIN32 */
 }
 
+/*
+ * Consecutive times to format are usually in the same second, so the
+ * broken-down time of the last one is kept, in UTC and in local time,
+ * rather than calling gmtime() or localtime() for each of them.
+ */
+static struct tm *
+get_broken_down_time(time_t secs, gboolean local)
+{
+	static struct tm tms[2];
+	static time_t tm_secs[2];
+	static gboolean tm_valid[2], tm_failed[2];
+	struct tm *tmp;
+	int i = local ? 1 : 0;
+
+	if (!tm_valid[i] || tm_secs[i] != secs) {
+		tmp = local ? localtime(&secs) : gmtime(&secs);
+		tm_valid[i] = TRUE;
+		tm_secs[i] = secs;
+		tm_failed[i] = (tmp == NULL);
+		if (tmp != NULL)
+			tms[i] = *tmp;
+	}
+	return tm_failed[i] ? NULL : &tms[i];
+}
+
 gchar *
 abs_time_to_str(wmem_allocator_t *scope, const nstime_t *abs_time, const absolute_time_display_e fmt,
 		gboolean show_zone)
@@ -432,12 +457,12 @@ abs_time_to_str(wmem_allocator_t *scope, const nstime_t *abs_time, const absolut
 		case ABSOLUTE_TIME_UTC:
 		case ABSOLUTE_TIME_DOY_UTC:
 		case ABSOLUTE_TIME_NTP_UTC:
-			tmp = gmtime(&abs_time->secs);
+			tmp = get_broken_down_time(abs_time->secs, FALSE);
 			zonename = "UTC";
 			break;
 
 		case ABSOLUTE_TIME_LOCAL:
-			tmp = localtime(&abs_time->secs);
+			tmp = get_broken_down_time(abs_time->secs, TRUE);
 			if (tmp) {
 				zonename = get_zonename(tmp);
 			}
@@ -539,12 +564,12 @@ abs_time_secs_to_str(wmem_allocator_t *scope, const time_t abs_time, const absol
 		case ABSOLUTE_TIME_UTC:
 		case ABSOLUTE_TIME_DOY_UTC:
 		case ABSOLUTE_TIME_NTP_UTC:
-			tmp = gmtime(&abs_time);
+			tmp = get_broken_down_time(abs_time, FALSE);
 			zonename = "UTC";
 			break;
 
 		case ABSOLUTE_TIME_LOCAL:
-			tmp = localtime(&abs_time);
+			tmp = get_broken_down_time(abs_time, TRUE);
 			if (tmp) {
 				zonename = get_zonename(tmp);
 			}
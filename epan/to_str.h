@@ -39,6 +39,18 @@ extern "C" {
 
 WS_DLL_PUBLIC gchar* address_to_str(wmem_allocator_t *scope, const address *addr);
 WS_DLL_PUBLIC gchar* address_with_resolution_to_str(wmem_allocator_t *scope, const address *addr);
+
+/*
+ * address_to_str_interned returns the same string as address_to_str, from a
+ * table of the addresses seen in the capture file, so that the string of
+ * each address is only made once.  The string lasts until the file is
+ * closed, and mustn't be modified.
+ *
+ * It returns NULL for address types registered by dissectors, when the
+ * table is full, or when dissection is threaded; the caller must then make
+ * the string itself.
+ */
+WS_DLL_PUBLIC const gchar* address_to_str_interned(const address *addr);
 WS_DLL_PUBLIC gchar* tvb_address_with_resolution_to_str(wmem_allocator_t *scope, tvbuff_t *tvb, int type, const gint offset);
 
 /*
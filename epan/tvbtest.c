@@ -15,6 +15,11 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef HAVE_ZLIB
+#define ZLIB_CONST
+#include <zlib.h>
+#endif
+
 #include "tvbuff.h"
 #include "exceptions.h"
 #include "wsutil/pint.h"
@@ -485,6 +490,83 @@ run_tests(void)
 	tvb_free_chain(tvb_parent);  /* should free all tvb's and associated data */
 }
 
+/* Reads straddling the members of a composite, which get copies of just
+ * the bytes read; the pointers to them have to stay valid. */
+static void
+test_composite_straddles(void)
+{
+	tvbuff_t	*tvb_parent, *tvb_comp;
+	guint8		data[64];
+	const guint8	*ptrs[64];
+	guint		i, len;
+
+	for (i = 0; i < sizeof data; i++)
+		data[i] = (guint8)i;
+
+	printf("Testing reads straddling composite members\n");
+	tvb_parent = tvb_new_real_data(data, sizeof data, sizeof data);
+	tvb_comp = tvb_new_composite();
+	for (i = 0; i < sizeof data; i += len) {
+		len = MIN(1 + i % 3, (guint)sizeof data - i);
+		tvb_composite_append(tvb_comp, tvb_new_subset_length(tvb_parent, i, len));
+	}
+	tvb_composite_finalize(tvb_comp);
+
+	for (i = 0; i + 4 <= sizeof data; i++) {
+		ptrs[i] = tvb_get_ptr(tvb_comp, i, 4);
+		if (memcmp(ptrs[i], data + i, 4) != 0 ||
+		    tvb_get_ntohl(tvb_comp, i) != pntoh32(data + i)) {
+			printf("Failed TVB=Composite straddles bad data at offset %u\n", i);
+			failed = TRUE;
+		}
+	}
+	for (i = 0; i + 4 <= sizeof data; i++) {
+		if (memcmp(ptrs[i], data + i, 4) != 0) {
+			printf("Failed TVB=Composite straddles data at offset %u changed\n", i);
+			failed = TRUE;
+		}
+	}
+
+	tvb_free_chain(tvb_parent);
+}
+
+#ifdef HAVE_ZLIB
+/* Uncompressing the same data again, which gets it from the cache, has
+ * to give the same result. */
+static void
+test_uncompress_cache(void)
+{
+	guint8		data[8192];
+	guint8		compr[9000];
+	uLongf		comprlen = sizeof compr;
+	tvbuff_t	*tvb_compr, *tvb_uncompr;
+	guint		i, pass;
+
+	for (i = 0; i < sizeof data; i++)
+		data[i] = (guint8)(i * i / 7);
+	if (compress(compr, &comprlen, data, sizeof data) != Z_OK) {
+		printf("Failed to compress the data for the uncompress cache test\n");
+		failed = TRUE;
+		return;
+	}
+
+	printf("Testing the uncompress cache\n");
+	tvb_compr = tvb_new_real_data(compr, (guint)comprlen, (gint)comprlen);
+	for (pass = 0; pass < 2; pass++) {
+		tvb_uncompr = tvb_uncompress(tvb_compr, 0, (int)comprlen);
+		if (tvb_uncompr == NULL ||
+		    tvb_captured_length(tvb_uncompr) != sizeof data ||
+		    tvb_memeql(tvb_uncompr, 0, data, sizeof data) != 0) {
+			printf("Failed TVB=Uncompressed data is wrong on pass %u\n", pass);
+			failed = TRUE;
+		}
+		if (tvb_uncompr)
+			tvb_free(tvb_uncompr);
+	}
+	tvb_free(tvb_compr);
+}
+#endif
+
 /* Note: valgrind can be used to check for tvbuff memory leaks */
 int
 main(void)
@@ -495,6 +577,10 @@ main(void)
 
 	except_init();
 	run_tests();
+	test_composite_straddles();
+#ifdef HAVE_ZLIB
+	test_uncompress_cache();
+#endif
 	except_deinit();
 	exit(failed?1:0);
 }
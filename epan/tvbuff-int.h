@@ -84,6 +84,18 @@ struct tvbuff {
 
 	/* Offset from beginning of first "real" tvbuff. */
 	gint			raw_offset;
+
+	/** If this tvbuff is freed with a packet, the packet's pool;
+	 * subsets of it are allocated from that pool, aren't
+	 * chained, and go away in bulk with the pool. */
+	wmem_allocator_t	*pool;
+
+	/** If not NULL, the tvbuff at the head of the chain this one
+	 * belongs to, to which tvbuffs derived from this one are added. */
+	struct tvbuff		*chain_head;
+
+	/** TRUE if this was allocated from pool. */
+	gboolean		in_pool;
 };
 
 WS_DLL_PUBLIC tvbuff_t *tvb_new(const struct tvb_ops *ops);
@@ -92,7 +104,31 @@ tvbuff_t *tvb_new_proxy(tvbuff_t *backing);
 
 void tvb_add_to_chain(tvbuff_t *parent, tvbuff_t *child);
 
+/* A tvbuff derived from backing, without a free routine of its own;
+   it's allocated from the pool of backing if it has one, and is added
+   to its chain otherwise. */
+tvbuff_t *tvb_new_derived(const struct tvb_ops *ops, tvbuff_t *backing);
+
+/* Free tvb, and the tvbuffs chained to it, along with a packet; pool is
+   the packet's pool, which must be freed after tvb's chain. */
+void tvb_set_packet_pool(tvbuff_t *tvb, wmem_allocator_t *pool);
+
 guint tvb_offset_from_real_beginning_counter(const tvbuff_t *tvb, const guint counter);
 
 void tvb_check_offset_length(const tvbuff_t *tvb, const gint offset, gint const length_val, guint *offset_ptr, guint *length_ptr);
+
+/*
+ * The most that is uncompressed from one buffer, so that a small
+ * "decompression bomb" can't use up all the memory; what follows is left
+ * out, as if not enough had been captured to uncompress it.
+ */
+#define TVB_UNCOMPRESS_MAX_LENGTH	(256 * 1024 * 1024)
+
+typedef tvbuff_t *(*tvb_uncompress_func)(tvbuff_t *tvb, const int offset, int comprlen);
+
+/* Uncompress with func, or get the result of doing it before. */
+tvbuff_t *tvb_uncompress_cached(tvb_uncompress_func func, tvbuff_t *tvb, const int offset, int comprlen);
+
+/* Drop the uncompressed data kept by tvb_uncompress_cached(). */
+void tvb_uncompress_cache_clear(void);
 #endif
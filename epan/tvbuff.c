@@ -64,16 +64,9 @@ ensure_contiguous(tvbuff_t *tvb, const gint offset, const gint length);
 static inline guint8 *
 tvb_get_raw_string(wmem_allocator_t *scope, tvbuff_t *tvb, const gint offset, const gint length);
 
-tvbuff_t *
-tvb_new(const struct tvb_ops *ops)
+static void
+tvb_init(tvbuff_t *tvb, const struct tvb_ops *ops)
 {
-	tvbuff_t *tvb;
-	gsize     size = ops->tvb_size;
-
-	g_assert(size >= sizeof(*tvb));
-
-	tvb = (tvbuff_t *) g_slice_alloc(size);
-
 	tvb->next		 = NULL;
 	tvb->ops		 = ops;
 	tvb->initialized	 = FALSE;
@@ -84,10 +77,58 @@ tvb_new(const struct tvb_ops *ops)
 	tvb->real_data		 = NULL;
 	tvb->raw_offset		 = -1;
 	tvb->ds_tvb		 = NULL;
+	tvb->pool		 = NULL;
+	tvb->chain_head		 = NULL;
+	tvb->in_pool		 = FALSE;
+}
+
+tvbuff_t *
+tvb_new(const struct tvb_ops *ops)
+{
+	tvbuff_t *tvb;
+	gsize     size = ops->tvb_size;
+
+	g_assert(size >= sizeof(*tvb));
+
+	tvb = (tvbuff_t *) g_slice_alloc(size);
+	tvb_init(tvb, ops);
+
+	return tvb;
+}
+
+tvbuff_t *
+tvb_new_derived(const struct tvb_ops *ops, tvbuff_t *backing)
+{
+	tvbuff_t *tvb;
+
+	/* Nothing would call its free routine. */
+	g_assert(ops->tvb_free == NULL);
+
+	if (backing->pool == NULL) {
+		tvb = tvb_new(ops);
+		tvb_add_to_chain(backing, tvb);
+		return tvb;
+	}
+
+	g_assert(ops->tvb_size >= sizeof(*tvb));
+
+	tvb = (tvbuff_t *) wmem_alloc(backing->pool, ops->tvb_size);
+	tvb_init(tvb, ops);
+	tvb->pool = backing->pool;
+	tvb->chain_head = backing->chain_head ? backing->chain_head : backing;
+	tvb->in_pool = TRUE;
 
 	return tvb;
 }
 
+void
+tvb_set_packet_pool(tvbuff_t *tvb, wmem_allocator_t *pool)
+{
+	DISSECTOR_ASSERT(tvb && !tvb->in_pool && tvb->chain_head == NULL);
+
+	tvb->pool = pool;
+}
+
 static void
 tvb_free_internal(tvbuff_t *tvb)
 {
@@ -98,6 +139,11 @@ tvb_free_internal(tvbuff_t *tvb)
 	if (tvb->ops->tvb_free)
 		tvb->ops->tvb_free(tvb);
 
+	if (tvb->in_pool) {
+		/* It goes with the pool. */
+		return;
+	}
+
 	size = tvb->ops->tvb_size;
 
 	g_slice_free1(size, tvb);
@@ -143,12 +189,21 @@ tvb_add_to_chain(tvbuff_t *parent, tvbuff_t *child)
 	DISSECTOR_ASSERT(parent);
 	DISSECTOR_ASSERT(child);
 
+	/* Tvbuffs from a pool aren't in a chain themselves. */
+	if (parent->chain_head)
+		parent = parent->chain_head;
+
 	while (child) {
 		tmp   = child;
 		child = child->next;
 
 		tmp->next    = parent->next;
 		parent->next = tmp;
+		if (parent->pool) {
+			/* It's freed with the packet, too. */
+			tmp->pool       = parent->pool;
+			tmp->chain_head = parent;
+		}
 	}
 }
 
@@ -2032,6 +2087,24 @@ _tvb_get_bits64(tvbuff_t *tvb, guint bit_offset, const gint total_no_of_bits)
 	guint64 value;
 	guint	octet_offset = bit_offset >> 3;
 	guint8	required_bits_in_first_octet = 8 - (bit_offset % 8);
+	guint	first_bit = bit_offset % 8;
+
+	/*
+	 * Bits that fit in 64 bits from the start of their first octet, as
+	 * the fields of PER and other bit-oriented protocols do, are fetched
+	 * with a single bounds check and put together in a register.
+	 */
+	if (total_no_of_bits > 0 && first_bit + total_no_of_bits <= 64)
+	{
+		guint octet_len = (first_bit + total_no_of_bits + 7) >> 3;
+		const guint8 *ptr = ensure_contiguous(tvb, octet_offset, octet_len);
+		guint i;
+
+		value = ptr[0] & bit_mask8[8 - first_bit];
+		for (i = 1; i < octet_len; i++)
+			value = (value << 8) | ptr[i];
+		return value >> (octet_len * 8 - first_bit - total_no_of_bits);
+	}
 
 	if(required_bits_in_first_octet > total_no_of_bits)
 	{
@@ -4293,37 +4366,81 @@ tvb_get_ds_tvb(tvbuff_t *tvb)
 	return(tvb->ds_tvb);
 }
 
-guint
-tvb_get_varint(tvbuff_t *tvb, guint offset, guint maxlen, guint64 *value, const guint encoding)
+/*
+ * Decode a protobuf varint of at most min(maxlen, FT_VARINT_MAX_LEN) bytes,
+ * returning its length, or 0 if it's longer than that.  The bytes are read
+ * in place once they've been checked to be there, rather than one at a
+ * time through tvb_get_guint8().
+ */
+static guint
+tvb_get_varint_protobuf(tvbuff_t *tvb, guint offset, guint maxlen, guint64 *value)
 {
+	const guint8 *ptr;
+	guint max_len = MIN(maxlen, FT_VARINT_MAX_LEN);
+	guint len;
+	guint i;
+	guint64 b; /* current byte */
+
 	*value = 0;
 
-	if (encoding & ENC_VARINT_PROTOBUF) {
-		guint i;
-		guint64 b; /* current byte */
+	len = MIN(max_len, (guint)_tvb_captured_length_remaining(tvb, offset));
+	if (len > 0) {
+		ptr = ensure_contiguous(tvb, offset, len);
+
+		/* tags, lengths and small values take a single byte */
+		if (ptr[0] < 0x80) {
+			*value = ptr[0];
+			return 1;
+		}
 
-		for (i = 0; ((i < FT_VARINT_MAX_LEN) && (i < maxlen)); ++i) {
-			b = tvb_get_guint8(tvb, offset++);
+		for (i = 0; i < len; ++i) {
+			b = ptr[i];
 			*value |= ((b & 0x7F) << (i * 7)); /* add lower 7 bits to val */
 
 			if (b < 0x80) {
-				/* end successfully becauseof last byte's msb(most significant bit) is zero */
 				return i + 1;
 			}
 		}
-	} else if (encoding & ENC_VARINT_ZIGZAG) {
-		guint i;
-		guint64 b; /* current byte */
 
-		for (i = 0; ((i < FT_VARINT_MAX_LEN) && (i < maxlen)); ++i) {
-			b = tvb_get_guint8(tvb, offset++);
-			*value |= ((b & 0x7F) << (i * 7)); /* add lower 7 bits to val */
+		if (len == max_len) {
+			return 0; /* all the bytes scanned, but no bytes' msb is zero */
+		}
 
-			if (b < 0x80) {
-				/* end successfully becauseof last byte's msb(most significant bit) is zero */
-				*value = (*value >> 1) ^ ((*value & 1) ? -1 : 0);
-				return i + 1;
-			}
+		/* the captured data ends before the varint does */
+		*value = 0;
+	}
+
+	/* let tvb_get_guint8() throw the right exception */
+	for (i = 0; i < max_len; ++i) {
+		b = tvb_get_guint8(tvb, offset++);
+		*value |= ((b & 0x7F) << (i * 7)); /* add lower 7 bits to val */
+
+		if (b < 0x80) {
+			/* end successfully becauseof last byte's msb(most significant bit) is zero */
+			return i + 1;
+		}
+	}
+
+	return 0;
+}
+
+guint
+tvb_get_varint(tvbuff_t *tvb, guint offset, guint maxlen, guint64 *value, const guint encoding)
+{
+	*value = 0;
+
+	if (encoding & ENC_VARINT_PROTOBUF) {
+		guint len = tvb_get_varint_protobuf(tvb, offset, maxlen, value);
+
+		if (len > 0) {
+			return len;
+		}
+	} else if (encoding & ENC_VARINT_ZIGZAG) {
+		guint len = tvb_get_varint_protobuf(tvb, offset, maxlen, value);
+
+		if (len > 0) {
+			*value = (*value >> 1) ^ ((*value & 1) ? -1 : 0);
+			return len;
 		}
 	}
 	else if (encoding & ENC_VARINT_QUIC) {
@@ -200,6 +200,12 @@ WS_DLL_PUBLIC void tvb_composite_append(tvbuff_t *tvb, tvbuff_t *member);
 /** Prepend to the list of tvbuffs that make up this composite tvbuff */
 extern void tvb_composite_prepend(tvbuff_t *tvb, tvbuff_t *member);
 
+/** Append to the list of tvbuffs that make up this composite tvbuff, without
+ * attaching the composite tvbuff to the chain of its first member. The
+ * caller must tvb_free() the composite tvbuff itself, and keep the members
+ * alive for as long as it exists. */
+extern void tvb_composite_append_unchained(tvbuff_t *tvb, tvbuff_t *member);
+
 /** Create an empty composite tvbuff. */
 WS_DLL_PUBLIC tvbuff_t *tvb_new_composite(void);
 
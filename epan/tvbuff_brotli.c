@@ -18,6 +18,7 @@
 #endif
 
 #include "tvbuff.h"
+#include "tvbuff-int.h"
 
 #ifdef HAVE_BROTLI
 
@@ -45,11 +46,12 @@ brotli_g_free_wrapper(void *opaque _U_, void *address)
  * succeeded or NULL if uncompression failed.
  */
 
-tvbuff_t *
-tvb_uncompress_brotli(tvbuff_t *tvb, const int offset, int comprlen)
+static tvbuff_t *
+uncompress_brotli(tvbuff_t *tvb, const int offset, int comprlen)
 {
     guint8              *compr;
     guint8              *uncompr        = NULL;
+    size_t               uncompr_size   = 0;
     tvbuff_t            *uncompr_tvb;
     BrotliDecoderState  *decoder;
     guint8              *strmbuf;
@@ -115,13 +117,6 @@ tvb_uncompress_brotli(tvbuff_t *tvb, const int offset, int comprlen)
             goto cleanup;
         }
 
-        /*
-         * Check if decompressed size is too large.
-         */
-        if (total_out > G_MAXINT) {
-            goto cleanup;
-        }
-
         /*
          * BrotliDecoderDecompressStream sets available_out to the number of bytes
          * left unused from the buffer. But we are interested in the bytes it wrote
@@ -129,9 +124,19 @@ tvb_uncompress_brotli(tvbuff_t *tvb, const int offset, int comprlen)
          */
         size_t pass_out = bufsiz - available_out;
         if (pass_out > 0) {
-            uncompr = (guint8 *)g_realloc(uncompr, total_out);
+            if (total_out > uncompr_size) {
+                uncompr_size = MAX(uncompr_size * 2, total_out);
+                uncompr = (guint8 *)g_realloc(uncompr, uncompr_size);
+            }
             memcpy(uncompr + (total_out - pass_out), strmbuf, pass_out);
         }
+
+        /*
+         * Leave the rest out if the decompressed size is too large.
+         */
+        if (total_out >= TVB_UNCOMPRESS_MAX_LENGTH) {
+            break;
+        }
     }
 
     if (uncompr == NULL) {
@@ -161,6 +166,12 @@ cleanup:
     BrotliDecoderDestroyInstance(decoder);
     return NULL;
 }
+
+tvbuff_t *
+tvb_uncompress_brotli(tvbuff_t *tvb, const int offset, int comprlen)
+{
+    return tvb_uncompress_cached(uncompress_brotli, tvb, offset, comprlen);
+}
 #else
 tvbuff_t *
 tvb_uncompress_brotli(tvbuff_t *tvb _U_, const int offset _U_, int comprlen _U_)
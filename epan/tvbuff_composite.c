@@ -18,12 +18,27 @@
 typedef struct {
 	GSList		*tvbs;
 
+	/* The members in order, filled in by
+	 * tvb_composite_finalize(). */
+	tvbuff_t	**members;
+	guint		num_members;
+
 	/* Used for quick testing to see if this
 	 * is the tvbuff that a COMPOSITE is
 	 * interested in. */
 	guint		*start_offsets;
 	guint		*end_offsets;
 
+	/* Copies of ranges that straddle members, handed out by
+	 * composite_get_ptr() rather than making the whole composite
+	 * contiguous, for as long as they add up to less than it. */
+	GSList		*straddles;
+	guint		straddle_bytes;
+	/* The last of them, and the range it holds */
+	const guint8	*last_straddle;
+	guint		last_straddle_offset;
+	guint		last_straddle_length;
+
 } tvb_comp_t;
 
 struct tvb_composite {
@@ -39,7 +54,9 @@ composite_free(tvbuff_t *tvb)
 	tvb_comp_t *composite = &composite_tvb->composite;
 
 	g_slist_free(composite->tvbs);
+	g_slist_free_full(composite->straddles, g_free);
 
+	g_free(composite->members);
 	g_free(composite->start_offsets);
 	g_free(composite->end_offsets);
 	g_free((gpointer)tvb->real_data);
@@ -51,37 +68,49 @@ composite_offset(const tvbuff_t *tvb _U_, const guint counter)
 	return counter;
 }
 
+/* Find the member holding the byte at abs_offset by a binary search of the
+ * end offsets; returns FALSE if abs_offset is past the last member. */
+static gboolean
+composite_find_member(const tvb_comp_t *composite, guint abs_offset, guint *member)
+{
+	guint lo = 0, hi = composite->num_members, mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (composite->end_offsets[mid] < abs_offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	*member = lo;
+	return lo < composite->num_members;
+}
+
+static void *composite_memcpy(tvbuff_t *tvb, void* _target, guint abs_offset, guint abs_length);
+
 static const guint8*
 composite_get_ptr(tvbuff_t *tvb, guint abs_offset, guint abs_length)
 {
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
-	guint	    i, num_members;
+	guint	    i;
 	tvb_comp_t *composite;
-	tvbuff_t   *member_tvb = NULL;
+	tvbuff_t   *member_tvb;
 	guint	    member_offset;
-	GSList	   *slist;
 
 	/* DISSECTOR_ASSERT(tvb->ops == &tvb_composite_ops); */
 
 	/* Maybe the range specified by offset/length
 	 * is contiguous inside one of the member tvbuffs */
 	composite = &composite_tvb->composite;
-	num_members = g_slist_length(composite->tvbs);
-
-	for (i = 0; i < num_members; i++) {
-		if (abs_offset <= composite->end_offsets[i]) {
-			slist = g_slist_nth(composite->tvbs, i);
-			member_tvb = (tvbuff_t *)slist->data;
-			break;
-		}
-	}
 
 	/* special case */
-	if (!member_tvb) {
+	if (!composite_find_member(composite, abs_offset, &i)) {
 		DISSECTOR_ASSERT(abs_offset == tvb->length && abs_length == 0);
 		return "";
 	}
 
+	member_tvb = composite->members[i];
 	member_offset = abs_offset - composite->start_offsets[i];
 
 	if (tvb_bytes_exist(member_tvb, member_offset, abs_length)) {
@@ -91,6 +120,26 @@ composite_get_ptr(tvbuff_t *tvb, guint abs_offset, guint abs_length)
 		DISSECTOR_ASSERT(!tvb->real_data);
 		return tvb_get_ptr(member_tvb, member_offset, abs_length);
 	}
+	else if (composite->last_straddle != NULL &&
+	    abs_offset >= composite->last_straddle_offset &&
+	    abs_offset - composite->last_straddle_offset + abs_length <= composite->last_straddle_length) {
+		/* Read again, as the fields of a header straddling two
+		 * members are. */
+		return composite->last_straddle + (abs_offset - composite->last_straddle_offset);
+	}
+	else if (abs_length <= tvb->length - composite->straddle_bytes) {
+		/* Copy only the bytes asked for; the pointer has to stay
+		 * valid for as long as the composite, so keep the copy. */
+		guint8 *straddle = (guint8 *)g_malloc(abs_length);
+
+		composite_memcpy(tvb, straddle, abs_offset, abs_length);
+		composite->straddles = g_slist_prepend(composite->straddles, straddle);
+		composite->straddle_bytes += abs_length;
+		composite->last_straddle = straddle;
+		composite->last_straddle_offset = abs_offset;
+		composite->last_straddle_length = abs_length;
+		return straddle;
+	}
 	else {
 		/* Use a temporary variable as tvb_memcpy is also checking tvb->real_data pointer */
 		void *real_data = g_malloc(tvb->length);
@@ -108,63 +157,103 @@ composite_memcpy(tvbuff_t *tvb, void* _target, guint abs_offset, guint abs_lengt
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
 	guint8 *target = (guint8 *) _target;
 
-	guint	    i, num_members;
+	guint	    i;
 	tvb_comp_t *composite;
-	tvbuff_t   *member_tvb = NULL;
+	tvbuff_t   *member_tvb;
 	guint	    member_offset, member_length;
-	GSList	   *slist;
 
 	/* DISSECTOR_ASSERT(tvb->ops == &tvb_composite_ops); */
 
-	/* Maybe the range specified by offset/length
-	 * is contiguous inside one of the member tvbuffs */
-	composite   = &composite_tvb->composite;
-	num_members = g_slist_length(composite->tvbs);
-
-	for (i = 0; i < num_members; i++) {
-		if (abs_offset <= composite->end_offsets[i]) {
-			slist = g_slist_nth(composite->tvbs, i);
-			member_tvb = (tvbuff_t *)slist->data;
-			break;
-		}
-	}
+	composite = &composite_tvb->composite;
 
 	/* special case */
-	if (!member_tvb) {
+	if (!composite_find_member(composite, abs_offset, &i)) {
 		DISSECTOR_ASSERT(abs_offset == tvb->length && abs_length == 0);
 		return target;
 	}
 
-	member_offset = abs_offset - composite->start_offsets[i];
-
-	if (tvb_bytes_exist(member_tvb, member_offset, abs_length)) {
-		DISSECTOR_ASSERT(!tvb->real_data);
-		return tvb_memcpy(member_tvb, target, member_offset, abs_length);
-	}
-	else {
-		/* The requested data is non-contiguous inside
-		 * the member tvb. We have to memcpy() the part that's in the member tvb,
-		 * then iterate across the other member tvb's, copying their portions
-		 * until we have copied all data.
-		 */
-		member_length = tvb_captured_length_remaining(member_tvb, member_offset);
+	/* The requested data may be non-contiguous across the member
+	 * tvbs. memcpy() the part that's in the first one, then go on with
+	 * the following ones, copying their portions until we have copied
+	 * all data.
+	 */
+	while (abs_length > 0) {
+		DISSECTOR_ASSERT(i < composite->num_members);
+		member_tvb = composite->members[i];
+		member_offset = abs_offset - composite->start_offsets[i];
+		member_length = MIN(abs_length, member_tvb->length - member_offset);
 
-		/* composite_memcpy() can't handle a member_length of zero. */
+		/* Members are never empty, so this always makes progress. */
 		DISSECTOR_ASSERT(member_length > 0);
 
 		tvb_memcpy(member_tvb, target, member_offset, member_length);
-		abs_offset	+= member_length;
-		abs_length	-= member_length;
+		target      += member_length;
+		abs_offset  += member_length;
+		abs_length  -= member_length;
+		i++;
+	}
 
-		/* Recurse */
-		if (abs_length > 0) {
-			composite_memcpy(tvb, target + member_length, abs_offset, abs_length);
-		}
+	return _target;
+}
 
-		return target;
+static gint
+composite_find_guint8(tvbuff_t *tvb, guint abs_offset, guint limit, guint8 needle)
+{
+	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
+	tvb_comp_t *composite = &composite_tvb->composite;
+	tvbuff_t   *member_tvb;
+	guint	    i, member_offset, member_length;
+	gint	    result;
+
+	/* Search each member in turn, rather than having the whole
+	 * composite made contiguous. */
+	if (!composite_find_member(composite, abs_offset, &i))
+		return -1;
+
+	while (limit > 0 && i < composite->num_members) {
+		member_tvb = composite->members[i];
+		member_offset = abs_offset - composite->start_offsets[i];
+		member_length = MIN(limit, member_tvb->length - member_offset);
+
+		result = tvb_find_guint8(member_tvb, member_offset, member_length, needle);
+		if (result != -1)
+			return composite->start_offsets[i] + result;
+
+		abs_offset += member_length;
+		limit      -= member_length;
+		i++;
 	}
 
-	DISSECTOR_ASSERT_NOT_REACHED();
+	return -1;
+}
+
+static gint
+composite_pbrk_guint8(tvbuff_t *tvb, guint abs_offset, guint limit, const ws_mempbrk_pattern* pattern, guchar *found_needle)
+{
+	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
+	tvb_comp_t *composite = &composite_tvb->composite;
+	tvbuff_t   *member_tvb;
+	guint	    i, member_offset, member_length;
+	gint	    result;
+
+	if (!composite_find_member(composite, abs_offset, &i))
+		return -1;
+
+	while (limit > 0 && i < composite->num_members) {
+		member_tvb = composite->members[i];
+		member_offset = abs_offset - composite->start_offsets[i];
+		member_length = MIN(limit, member_tvb->length - member_offset);
+
+		result = tvb_ws_mempbrk_pattern_guint8(member_tvb, member_offset, member_length, pattern, found_needle);
+		if (result != -1)
+			return composite->start_offsets[i] + result;
+
+		abs_offset += member_length;
+		limit      -= member_length;
+		i++;
+	}
+
+	return -1;
 }
 
 static const struct tvb_ops tvb_composite_ops = {
@@ -174,8 +263,8 @@ static const struct tvb_ops tvb_composite_ops = {
 	composite_offset,     /* offset */
 	composite_get_ptr,    /* get_ptr */
 	composite_memcpy,     /* memcpy */
-	NULL,                 /* find_guint8 XXX */
-	NULL,                 /* pbrk_guint8 XXX */
+	composite_find_guint8, /* find_guint8 */
+	composite_pbrk_guint8, /* pbrk_guint8 */
 	NULL,                 /* clone */
 };
 
@@ -199,14 +288,21 @@ tvb_new_composite(void)
 	tvb_comp_t *composite = &composite_tvb->composite;
 
 	composite->tvbs		 = NULL;
+	composite->members	 = NULL;
+	composite->num_members	 = 0;
 	composite->start_offsets = NULL;
 	composite->end_offsets	 = NULL;
+	composite->straddles	 = NULL;
+	composite->straddle_bytes = 0;
+	composite->last_straddle = NULL;
+	composite->last_straddle_offset = 0;
+	composite->last_straddle_length = 0;
 
 	return tvb;
 }
 
-void
-tvb_composite_append(tvbuff_t *tvb, tvbuff_t *member)
+static void
+composite_append(tvbuff_t *tvb, tvbuff_t *member, gboolean chain)
 {
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
 	tvb_comp_t *composite;
@@ -223,11 +319,29 @@ tvb_composite_append(tvbuff_t *tvb, tvbuff_t *member)
 	composite->tvbs = g_slist_append(composite->tvbs, member);
 
 	/* Attach the composite TVB to the first TVB only. */
-	if (!composite->tvbs->next) {
+	if (chain && !composite->tvbs->next) {
 		tvb_add_to_chain((tvbuff_t *)composite->tvbs->data, tvb);
 	}
 }
 
+void
+tvb_composite_append(tvbuff_t *tvb, tvbuff_t *member)
+{
+	composite_append(tvb, member, TRUE);
+}
+
+/*
+ * Unlike tvb_composite_append(), this leaves the composite TVB out of the
+ * chain of its first member; the caller frees it, and must keep the members
+ * alive for as long as it exists. This is for composites outliving any one
+ * packet, such as reassembled PDUs.
+ */
+void
+tvb_composite_append_unchained(tvbuff_t *tvb, tvbuff_t *member)
+{
+	composite_append(tvb, member, FALSE);
+}
+
 void
 tvb_composite_prepend(tvbuff_t *tvb, tvbuff_t *member)
 {
@@ -276,12 +390,15 @@ tvb_composite_finalize(tvbuff_t *tvb)
 	 */
 	DISSECTOR_ASSERT(num_members);
 
+	composite->members = g_new(tvbuff_t *, num_members);
+	composite->num_members = num_members;
 	composite->start_offsets = g_new(guint, num_members);
 	composite->end_offsets = g_new(guint, num_members);
 
 	for (slist = composite->tvbs; slist != NULL; slist = slist->next) {
 		DISSECTOR_ASSERT((guint) i < num_members);
 		member_tvb = (tvbuff_t *)slist->data;
+		composite->members[i] = member_tvb;
 		composite->start_offsets[i] = tvb->length;
 		tvb->length += member_tvb->length;
 		tvb->reported_length += member_tvb->reported_length;
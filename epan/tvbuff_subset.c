@@ -116,9 +116,9 @@ static const struct tvb_ops tvb_subset_ops = {
 
 static tvbuff_t *
 tvb_new_with_subset(tvbuff_t *backing, const guint reported_length,
-    const guint subset_tvb_offset, const guint subset_tvb_length)
+    const guint subset_tvb_offset, const guint subset_tvb_length, gboolean derived)
 {
-	tvbuff_t *tvb = tvb_new(&tvb_subset_ops);
+	tvbuff_t *tvb = derived ? tvb_new_derived(&tvb_subset_ops, backing) : tvb_new(&tvb_subset_ops);
 	struct tvb_subset *subset_tvb = (struct tvb_subset *) tvb;
 
 	subset_tvb->subset.offset = subset_tvb_offset;
@@ -173,9 +173,7 @@ tvb_new_subset_length_caplen(tvbuff_t *backing, const gint backing_offset, const
 		actual_reported_length = (guint)reported_length;
 
 	tvb = tvb_new_with_subset(backing, actual_reported_length,
-	    subset_tvb_offset, subset_tvb_length);
-
-	tvb_add_to_chain(backing, tvb);
+	    subset_tvb_offset, subset_tvb_length, TRUE);
 
 	return tvb;
 }
@@ -212,9 +210,7 @@ tvb_new_subset_length(tvbuff_t *backing, const gint backing_offset, const gint r
 			        &subset_tvb_length);
 
 	tvb = tvb_new_with_subset(backing, (guint)actual_reported_length,
-	    subset_tvb_offset, subset_tvb_length);
-
-	tvb_add_to_chain(backing, tvb);
+	    subset_tvb_offset, subset_tvb_length, TRUE);
 
 	return tvb;
 }
@@ -235,9 +231,7 @@ tvb_new_subset_remaining(tvbuff_t *backing, const gint backing_offset)
 	reported_length = backing->reported_length - subset_tvb_offset;
 
 	tvb = tvb_new_with_subset(backing, reported_length,
-	    subset_tvb_offset, subset_tvb_length);
-
-	tvb_add_to_chain(backing, tvb);
+	    subset_tvb_offset, subset_tvb_length, TRUE);
 
 	return tvb;
 }
@@ -248,7 +242,7 @@ tvb_new_proxy(tvbuff_t *backing)
 	tvbuff_t *tvb;
 
 	if (backing)
-		tvb = tvb_new_with_subset(backing, backing->reported_length, 0, backing->length);
+		tvb = tvb_new_with_subset(backing, backing->reported_length, 0, backing->length, FALSE);
 	else
 		tvb = tvb_new_real_data(NULL, 0, 0);
 
@@ -0,0 +1,201 @@
+/* tvbuff_uncompress_cache.c
+ * Cache of uncompressed data, so that dissecting a packet again doesn't
+ * uncompress its payload again
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+#include <wsutil/glib-compat.h>
+
+#include "tvbuff.h"
+#include "tvbuff-int.h"
+
+/*
+ * The result of uncompressing some data depends only on the data and on
+ * the algorithm, so entries are looked up by the compressed bytes
+ * themselves, and stay valid however many times, and in whichever
+ * packet, they're dissected.  Failures are cached too.
+ *
+ * Data shorter than this is uncompressed every time; that's cheaper
+ * than keeping it.
+ */
+#define UNCOMPRESS_CACHE_MIN_LENGTH	1024
+
+/* The most compressed and uncompressed bytes kept; the entries
+ * used least recently are dropped to stay under it. */
+#define UNCOMPRESS_CACHE_BUDGET		(64 * 1024 * 1024)
+
+typedef struct {
+	tvb_uncompress_func	func;		/* the algorithm */
+	guint64			hash;		/* of the compressed bytes */
+	guint8			*compr;
+	guint			comprlen;
+	guint8			*uncompr;	/* NULL if uncompressing failed */
+	guint			uncomprlen;
+	GList			*lru_link;	/* in uncompress_cache_lru */
+} uncompress_cache_entry_t;
+
+static GHashTable *uncompress_cache;
+/* The entries, the one used most recently first */
+static GQueue uncompress_cache_lru = G_QUEUE_INIT;
+static gsize uncompress_cache_bytes;
+
+/* FNV-1a */
+static guint64
+uncompress_cache_hash_bytes(const guint8 *data, guint len)
+{
+	guint64 hash = G_GUINT64_CONSTANT(0xcbf29ce484222325);
+	guint i;
+
+	for (i = 0; i < len; i++) {
+		hash ^= data[i];
+		hash *= G_GUINT64_CONSTANT(0x100000001b3);
+	}
+	return hash;
+}
+
+static guint
+uncompress_cache_hash(gconstpointer key)
+{
+	const uncompress_cache_entry_t *entry = (const uncompress_cache_entry_t *)key;
+
+	return (guint)(entry->hash ^ (entry->hash >> 32));
+}
+
+static gboolean
+uncompress_cache_equal(gconstpointer a, gconstpointer b)
+{
+	const uncompress_cache_entry_t *entry_a = (const uncompress_cache_entry_t *)a;
+	const uncompress_cache_entry_t *entry_b = (const uncompress_cache_entry_t *)b;
+
+	return entry_a->func == entry_b->func &&
+	    entry_a->hash == entry_b->hash &&
+	    entry_a->comprlen == entry_b->comprlen &&
+	    memcmp(entry_a->compr, entry_b->compr, entry_a->comprlen) == 0;
+}
+
+static void
+uncompress_cache_entry_free(gpointer data)
+{
+	uncompress_cache_entry_t *entry = (uncompress_cache_entry_t *)data;
+
+	uncompress_cache_bytes -= entry->comprlen + entry->uncomprlen;
+	g_queue_delete_link(&uncompress_cache_lru, entry->lru_link);
+	g_free(entry->compr);
+	g_free(entry->uncompr);
+	g_free(entry);
+}
+
+static tvbuff_t *
+uncompress_cache_entry_tvb(const uncompress_cache_entry_t *entry)
+{
+	guint8 *uncompr;
+	tvbuff_t *uncompr_tvb;
+
+	if (entry->uncompr == NULL)
+		return NULL;
+
+	/*
+	 * Hand out a copy, so that the entry can be dropped while the
+	 * tvbuff is still in use; copying is much faster than
+	 * uncompressing.  g_memdup2(..., 0) returns NULL, which would
+	 * look like a failure.
+	 */
+	uncompr = entry->uncomprlen ?
+	    (guint8 *)g_memdup2(entry->uncompr, entry->uncomprlen) :
+	    (guint8 *)g_strdup("");
+	uncompr_tvb = tvb_new_real_data(uncompr, entry->uncomprlen, entry->uncomprlen);
+	tvb_set_free_cb(uncompr_tvb, g_free);
+	return uncompr_tvb;
+}
+
+tvbuff_t *
+tvb_uncompress_cached(tvb_uncompress_func func, tvbuff_t *tvb, const int offset, int comprlen)
+{
+	uncompress_cache_entry_t key, *entry;
+	tvbuff_t *uncompr_tvb;
+	gsize size;
+
+	if (tvb == NULL || comprlen < UNCOMPRESS_CACHE_MIN_LENGTH)
+		return func(tvb, offset, comprlen);
+
+	if (uncompress_cache == NULL) {
+		uncompress_cache = g_hash_table_new_full(uncompress_cache_hash,
+		    uncompress_cache_equal, NULL, uncompress_cache_entry_free);
+	}
+
+	key.func = func;
+	key.compr = (guint8 *)tvb_get_ptr(tvb, offset, comprlen);
+	key.comprlen = comprlen;
+	key.hash = uncompress_cache_hash_bytes(key.compr, key.comprlen);
+
+	entry = (uncompress_cache_entry_t *)g_hash_table_lookup(uncompress_cache, &key);
+	if (entry != NULL) {
+		g_queue_unlink(&uncompress_cache_lru, entry->lru_link);
+		g_queue_push_head_link(&uncompress_cache_lru, entry->lru_link);
+		return uncompress_cache_entry_tvb(entry);
+	}
+
+	uncompr_tvb = func(tvb, offset, comprlen);
+
+	size = (gsize)comprlen + (uncompr_tvb ? tvb_captured_length(uncompr_tvb) : 0);
+	if (size > UNCOMPRESS_CACHE_BUDGET / 4) {
+		/* Keeping it would throw away too much else. */
+		return uncompr_tvb;
+	}
+	while (uncompress_cache_bytes + size > UNCOMPRESS_CACHE_BUDGET) {
+		g_hash_table_remove(uncompress_cache, g_queue_peek_tail(&uncompress_cache_lru));
+	}
+
+	entry = g_new(uncompress_cache_entry_t, 1);
+	entry->func = func;
+	entry->hash = key.hash;
+	entry->compr = (guint8 *)g_memdup2(key.compr, key.comprlen);
+	entry->comprlen = key.comprlen;
+	if (uncompr_tvb) {
+		entry->uncomprlen = tvb_captured_length(uncompr_tvb);
+		entry->uncompr = (guint8 *)g_malloc(entry->uncomprlen + 1);
+		tvb_memcpy(uncompr_tvb, entry->uncompr, 0, entry->uncomprlen);
+	} else {
+		entry->uncomprlen = 0;
+		entry->uncompr = NULL;
+	}
+	g_queue_push_head(&uncompress_cache_lru, entry);
+	entry->lru_link = g_queue_peek_head_link(&uncompress_cache_lru);
+	uncompress_cache_bytes += size;
+	g_hash_table_add(uncompress_cache, entry);
+
+	return uncompr_tvb;
+}
+
+void
+tvb_uncompress_cache_clear(void)
+{
+	if (uncompress_cache != NULL) {
+		g_hash_table_destroy(uncompress_cache);
+		uncompress_cache = NULL;
+	}
+	g_assert(uncompress_cache_lru.length == 0 && uncompress_cache_bytes == 0);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
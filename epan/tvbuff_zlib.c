@@ -22,6 +22,7 @@
 #endif
 
 #include "tvbuff.h"
+#include "tvbuff-int.h"
 #ifdef TVB_Z_DEBUG
 #include <wsutil/ws_printf.h> /* ws_debug_printf */
 #endif
@@ -37,11 +38,12 @@
 /* #define TVB_Z_DEBUG 1 */
 #undef TVB_Z_DEBUG
 
-tvbuff_t *
-tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
+static tvbuff_t *
+uncompress_zlib(tvbuff_t *tvb, const int offset, int comprlen)
 {
 	gint       err;
 	guint      bytes_out      = 0;
+	guint      uncompr_size   = 0;
 	guint8    *compr;
 	guint8    *uncompr        = NULL;
 	tvbuff_t  *uncompr_tvb    = NULL;
@@ -122,18 +124,27 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 				uncompr = (guint8 *)((bytes_pass || err != Z_STREAM_END) ?
 						g_memdup2(strmbuf, bytes_pass) :
 						g_strdup(""));
+				uncompr_size = bytes_pass;
 			} else {
-				guint8 *new_data = (guint8 *)g_malloc0(bytes_out + bytes_pass);
-
-				memcpy(new_data, uncompr, bytes_out);
-				memcpy(new_data + bytes_out, strmbuf, bytes_pass);
-
-				g_free(uncompr);
-				uncompr = new_data;
+				/* Grow the buffer geometrically, rather than
+				 * copying everything so far on each pass. */
+				if (bytes_out + bytes_pass > uncompr_size) {
+					uncompr_size = MAX(uncompr_size * 2, bytes_out + bytes_pass);
+					uncompr = (guint8 *)g_realloc(uncompr, uncompr_size);
+				}
+				memcpy(uncompr + bytes_out, strmbuf, bytes_pass);
 			}
 
 			bytes_out += bytes_pass;
 
+			if (bytes_out >= TVB_UNCOMPRESS_MAX_LENGTH && err != Z_STREAM_END) {
+				/* Leave the rest out. */
+				inflateEnd(strm);
+				g_free(strm);
+				g_free(strmbuf);
+				break;
+			}
+
 			if (err == Z_STREAM_END) {
 				inflateEnd(strm);
 				g_free(strm);
@@ -317,6 +328,12 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 	wmem_free(NULL, compr);
 	return uncompr_tvb;
 }
+
+tvbuff_t *
+tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
+{
+	return tvb_uncompress_cached(uncompress_zlib, tvb, offset, comprlen);
+}
 #else
 tvbuff_t *
 tvb_uncompress(tvbuff_t *tvb _U_, const int offset _U_, int comprlen _U_)
@@ -265,6 +265,69 @@ value_string_ext_new(const value_string *vs, guint vs_tot_num_entries,
     return vse;
 }
 
+static gint
+value_string_compare(gconstpointer a, gconstpointer b, gpointer user_data _U_)
+{
+    const value_string *vs_a = (const value_string *)a;
+    const value_string *vs_b = (const value_string *)b;
+
+    if (vs_a->value != vs_b->value)
+        return vs_a->value < vs_b->value ? -1 : 1;
+    return 0;
+}
+
+/* Initializes an extended value string whose array may be in any order:
+ * if it isn't in ascending order, puts a sorted copy of it in its place,
+ * and then does what _try_val_to_str_ext_init() does. */
+static const value_string *
+_try_val_to_str_ext_init_any_order(const guint32 val, value_string_ext *vse)
+{
+    const value_string *vs_p           = vse->_vs_p;
+    const guint         vs_num_entries = vse->_vs_num_entries;
+    value_string       *sorted;
+    guint               i, n;
+
+    for (i = 1; i < vs_num_entries; i++) {
+        if (vs_p[i - 1].value >= vs_p[i].value)
+            break;
+    }
+    if (i < vs_num_entries) {
+        /* g_qsort_with_data() is stable, so of the entries with the same
+         * value the first one, which is the one try_val_to_str() finds,
+         * comes first, and is the one kept. */
+        sorted = (value_string *)wmem_memdup(wmem_epan_scope(), vs_p,
+                (vs_num_entries + 1) * sizeof (value_string));
+        g_qsort_with_data(sorted, vs_num_entries, sizeof (value_string),
+                value_string_compare, NULL);
+        for (i = 1, n = 1; i < vs_num_entries; i++) {
+            if (sorted[i].value != sorted[n - 1].value)
+                sorted[n++] = sorted[i];
+        }
+        sorted[n].value = 0;
+        sorted[n].strptr = NULL;
+        vse->_vs_p = sorted;
+        vse->_vs_num_entries = n;
+    }
+
+    return _try_val_to_str_ext_init(val, vse);
+}
+
+/* Like value_string_ext_new(), but the values needn't be in ascending
+ * order, and the same value can appear more than once. The array isn't
+ * looked at before the first lookup, which sorts a copy of it if needed;
+ * the array must not change after that. */
+value_string_ext *
+value_string_ext_new_any_order(const value_string *vs, guint vs_tot_num_entries,
+        const gchar *vs_name)
+{
+    value_string_ext *vse;
+
+    vse = value_string_ext_new(vs, vs_tot_num_entries, vs_name);
+    vse->_vs_match2 = _try_val_to_str_ext_init_any_order;
+
+    return vse;
+}
+
 void
 value_string_ext_free(value_string_ext *vse)
 {
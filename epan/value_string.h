@@ -184,6 +184,13 @@ WS_DLL_PUBLIC
 value_string_ext *
 value_string_ext_new(const value_string *vs, guint vs_tot_num_entries, const gchar *vs_name);
 
+/* Like value_string_ext_new(), for a value_string whose values aren't in
+ * ascending order or aren't all different; the first lookup sorts a copy
+ * of it if it has to. */
+WS_DLL_PUBLIC
+value_string_ext *
+value_string_ext_new_any_order(const value_string *vs, guint vs_tot_num_entries, const gchar *vs_name);
+
 WS_DLL_PUBLIC
 void
 value_string_ext_free(value_string_ext *vse);
@@ -14,6 +14,8 @@
 
 #include "wmem_array.h"
 #include "wmem_core.h"
+#include "wmem_flat_map.h"
+#include "wmem_flat_tree.h"
 #include "wmem_list.h"
 #include "wmem_map.h"
 #include "wmem_miscutl.h"
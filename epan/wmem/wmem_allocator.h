@@ -20,6 +20,7 @@ extern "C" {
 #endif /* __cplusplus */
 
 struct _wmem_user_cb_container_t;
+struct _wmem_accounting_t;
 
 /* See section "4. Internal Design" of doc/README.wmem for details
  * on this structure */
@@ -41,6 +42,10 @@ struct _wmem_allocator_t {
     void                        *private_data;
     enum _wmem_allocator_type_t  type;
     gboolean                     in_scope;
+    guint64                      alloc_count;
+
+    /* Per-tag allocation accounting, NULL unless turned on */
+    struct _wmem_accounting_t   *accounting;
 };
 
 #ifdef __cplusplus
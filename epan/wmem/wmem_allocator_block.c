@@ -14,6 +14,8 @@
 
 #include <glib.h>
 
+#include <wsutil/numa.h>
+
 #include "wmem_core.h"
 #include "wmem_allocator.h"
 #include "wmem_allocator_block.h"
@@ -763,6 +765,9 @@ wmem_block_new_block(wmem_block_allocator_t *allocator)
 
     /* allocate the new block and add it to the block list */
     block = (wmem_block_hdr_t *)wmem_alloc(NULL, WMEM_BLOCK_SIZE);
+    /* Blocks live as long as their scope, which for the file scope is
+     * long enough for huge pages to save TLB misses, if they're wanted */
+    ws_numa_advise_huge_pages(block, WMEM_BLOCK_SIZE);
     wmem_block_add_to_block_list(allocator, block);
 
     /* initialize it */
@@ -41,6 +41,11 @@
  * also a nice power of two, of course. */
 #define WMEM_BLOCK_SIZE (2 * 1024 * 1024)
 
+/* free_all() keeps up to this many blocks, besides the first, for reuse:
+ * a pool that's emptied after every packet would otherwise give its extra
+ * blocks back to the OS and ask for them again on the next big packet. */
+#define WMEM_BLOCK_FAST_MAX_SPARE 8
+
 /* The header for an entire OS-level 'block' of memory */
 typedef struct _wmem_block_fast_hdr {
     struct _wmem_block_fast_hdr *next;
@@ -63,6 +68,9 @@ typedef struct _wmem_block_fast_jumbo {
 typedef struct {
     wmem_block_fast_hdr_t   *block_list;
     wmem_block_fast_jumbo_t *jumbo_list;
+    /* Blocks kept by free_all(), and how many */
+    wmem_block_fast_hdr_t   *spare_list;
+    guint                    spare_count;
 } wmem_block_fast_allocator_t;
 
 /* Creates a new block, and initializes it. */
@@ -71,8 +79,16 @@ wmem_block_fast_new_block(wmem_block_fast_allocator_t *allocator)
 {
     wmem_block_fast_hdr_t *block;
 
-    /* allocate/initialize the new block and add it to the block list */
-    block = (wmem_block_fast_hdr_t *)wmem_alloc(NULL, WMEM_BLOCK_SIZE);
+    /* take a spare block or allocate a new one, initialize it and add it
+     * to the block list */
+    if (allocator->spare_list) {
+        block = allocator->spare_list;
+        allocator->spare_list = block->next;
+        allocator->spare_count--;
+    }
+    else {
+        block = (wmem_block_fast_hdr_t *)wmem_alloc(NULL, WMEM_BLOCK_SIZE);
+    }
 
     block->pos  = WMEM_BLOCK_HEADER_SIZE;
     block->next = allocator->block_list;
@@ -177,8 +193,8 @@ wmem_block_fast_free_all(void *private_data)
     wmem_block_fast_hdr_t       *cur, *nxt;
     wmem_block_fast_jumbo_t     *cur_jum, *nxt_jum;
 
-    /* iterate through the blocks, freeing all but the first and reinitializing
-     * that one */
+    /* iterate through the blocks, reinitializing the first, keeping the
+     * others as spares as long as there's room and freeing the rest */
     cur = allocator->block_list;
 
     if (cur) {
@@ -190,7 +206,14 @@ wmem_block_fast_free_all(void *private_data)
 
     while (cur) {
         nxt  = cur->next;
-        wmem_free(NULL, cur);
+        if (allocator->spare_count < WMEM_BLOCK_FAST_MAX_SPARE) {
+            cur->next = allocator->spare_list;
+            allocator->spare_list = cur;
+            allocator->spare_count++;
+        }
+        else {
+            wmem_free(NULL, cur);
+        }
         cur = nxt;
     }
 
@@ -205,9 +228,20 @@ wmem_block_fast_free_all(void *private_data)
 }
 
 static void
-wmem_block_fast_gc(void *private_data _U_)
+wmem_block_fast_gc(void *private_data)
 {
-    /* No-op */
+    wmem_block_fast_allocator_t *allocator = (wmem_block_fast_allocator_t*) private_data;
+    wmem_block_fast_hdr_t       *cur, *nxt;
+
+    /* give the spare blocks back */
+    cur = allocator->spare_list;
+    while (cur) {
+        nxt = cur->next;
+        wmem_free(NULL, cur);
+        cur = nxt;
+    }
+    allocator->spare_list  = NULL;
+    allocator->spare_count = 0;
 }
 
 static void
@@ -216,8 +250,9 @@ wmem_block_fast_allocator_cleanup(void *private_data)
     wmem_block_fast_allocator_t *allocator = (wmem_block_fast_allocator_t*) private_data;
 
     /* wmem guarantees that free_all() is called directly before this, so
-     * simply free the first block */
+     * simply free the first block and the spares */
     wmem_free(NULL, allocator->block_list);
+    wmem_block_fast_gc(private_data);
 
     /* then just free the allocator structs */
     wmem_free(NULL, private_data);
@@ -242,6 +277,8 @@ wmem_block_fast_allocator_init(wmem_allocator_t *allocator)
 
     block_allocator->block_list = NULL;
     block_allocator->jumbo_list = NULL;
+    block_allocator->spare_list = NULL;
+    block_allocator->spare_count = 0;
 }
 
 /*
@@ -0,0 +1,176 @@
+/* wmem_allocator_locked.c
+ * Wireshark Memory Manager Locking Allocator Wrapper
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include "wmem_core.h"
+#include "wmem_allocator.h"
+#include "wmem_allocator_locked.h"
+
+/* The wrapper takes the place of the allocator's functions and private data,
+ * keeping the real ones to call with the mutex held. */
+typedef struct _wmem_locked_allocator_t {
+    GMutex  lock;
+
+    void *(*walloc)(void *private_data, const size_t size);
+    void  (*wfree)(void *private_data, void *ptr);
+    void *(*wrealloc)(void *private_data, void *ptr, const size_t size);
+
+    void  (*free_all)(void *private_data);
+    void  (*gc)(void *private_data);
+    void  (*cleanup)(void *private_data);
+
+    void   *private_data;
+} wmem_locked_allocator_t;
+
+static void *
+wmem_locked_alloc(void *private_data, const size_t size)
+{
+    wmem_locked_allocator_t *locked = (wmem_locked_allocator_t*) private_data;
+    void                    *ptr;
+
+    g_mutex_lock(&locked->lock);
+    ptr = locked->walloc(locked->private_data, size);
+    g_mutex_unlock(&locked->lock);
+
+    return ptr;
+}
+
+static void
+wmem_locked_free(void *private_data, void *ptr)
+{
+    wmem_locked_allocator_t *locked = (wmem_locked_allocator_t*) private_data;
+
+    g_mutex_lock(&locked->lock);
+    locked->wfree(locked->private_data, ptr);
+    g_mutex_unlock(&locked->lock);
+}
+
+static void *
+wmem_locked_realloc(void *private_data, void *ptr, const size_t size)
+{
+    wmem_locked_allocator_t *locked = (wmem_locked_allocator_t*) private_data;
+
+    g_mutex_lock(&locked->lock);
+    ptr = locked->wrealloc(locked->private_data, ptr, size);
+    g_mutex_unlock(&locked->lock);
+
+    return ptr;
+}
+
+static void
+wmem_locked_free_all(void *private_data)
+{
+    wmem_locked_allocator_t *locked = (wmem_locked_allocator_t*) private_data;
+
+    g_mutex_lock(&locked->lock);
+    locked->free_all(locked->private_data);
+    g_mutex_unlock(&locked->lock);
+}
+
+static void
+wmem_locked_gc(void *private_data)
+{
+    wmem_locked_allocator_t *locked = (wmem_locked_allocator_t*) private_data;
+
+    g_mutex_lock(&locked->lock);
+    locked->gc(locked->private_data);
+    g_mutex_unlock(&locked->lock);
+}
+
+static void
+wmem_locked_allocator_cleanup(void *private_data)
+{
+    wmem_locked_allocator_t *locked = (wmem_locked_allocator_t*) private_data;
+
+    locked->cleanup(locked->private_data);
+
+    g_mutex_clear(&locked->lock);
+    wmem_free(NULL, locked);
+}
+
+gboolean
+wmem_locked_allocator_is_wrapped(wmem_allocator_t *allocator)
+{
+    return allocator->walloc == &wmem_locked_alloc;
+}
+
+void
+wmem_locked_allocator_wrap(wmem_allocator_t *allocator)
+{
+    wmem_locked_allocator_t *locked;
+
+    if (wmem_locked_allocator_is_wrapped(allocator)) {
+        return;
+    }
+
+    locked = wmem_new(NULL, wmem_locked_allocator_t);
+    g_mutex_init(&locked->lock);
+
+    locked->walloc   = allocator->walloc;
+    locked->wrealloc = allocator->wrealloc;
+    locked->wfree    = allocator->wfree;
+
+    locked->free_all = allocator->free_all;
+    locked->gc       = allocator->gc;
+    locked->cleanup  = allocator->cleanup;
+
+    locked->private_data = allocator->private_data;
+
+    allocator->walloc   = &wmem_locked_alloc;
+    allocator->wrealloc = &wmem_locked_realloc;
+    allocator->wfree    = &wmem_locked_free;
+
+    allocator->free_all = &wmem_locked_free_all;
+    allocator->gc       = &wmem_locked_gc;
+    allocator->cleanup  = &wmem_locked_allocator_cleanup;
+
+    allocator->private_data = (void*) locked;
+}
+
+void
+wmem_locked_allocator_unwrap(wmem_allocator_t *allocator)
+{
+    wmem_locked_allocator_t *locked;
+
+    if (!wmem_locked_allocator_is_wrapped(allocator)) {
+        return;
+    }
+
+    locked = (wmem_locked_allocator_t*) allocator->private_data;
+
+    allocator->walloc   = locked->walloc;
+    allocator->wrealloc = locked->wrealloc;
+    allocator->wfree    = locked->wfree;
+
+    allocator->free_all = locked->free_all;
+    allocator->gc       = locked->gc;
+    allocator->cleanup  = locked->cleanup;
+
+    allocator->private_data = locked->private_data;
+
+    g_mutex_clear(&locked->lock);
+    wmem_free(NULL, locked);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,51 @@
+/* wmem_allocator_locked.h
+ * Definitions for the Wireshark Memory Manager Locking Allocator Wrapper
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WMEM_ALLOCATOR_LOCKED_H__
+#define __WMEM_ALLOCATOR_LOCKED_H__
+
+#include "wmem_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Make an allocator of any type safe to allocate from, free to and realloc
+ * in from several threads at once, by taking a mutex around each call. The
+ * memory already allocated stays valid, so this can be done at any time no
+ * other thread is using the allocator. */
+void
+wmem_locked_allocator_wrap(wmem_allocator_t *allocator);
+
+/* Undo wmem_locked_allocator_wrap(), with the same restriction. */
+void
+wmem_locked_allocator_unwrap(wmem_allocator_t *allocator);
+
+gboolean
+wmem_locked_allocator_is_wrapped(wmem_allocator_t *allocator);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __WMEM_ALLOCATOR_LOCKED_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
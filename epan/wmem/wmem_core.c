@@ -28,6 +28,53 @@
 static gboolean do_override = FALSE;
 static wmem_allocator_type_t override_type;
 
+/* Allocation accounting, see wmem_accounting_enable() */
+typedef struct {
+    guint64 allocs;
+    guint64 bytes;
+} wmem_accounting_entry_t;
+
+typedef struct _wmem_accounting_t {
+    GHashTable              *entries;   /* tag -> wmem_accounting_entry_t */
+    /* The entry of the tag last counted against, as the same tag is usually
+     * set for many allocations in a row */
+    int                      last_tag;
+    wmem_accounting_entry_t *last_entry;
+} wmem_accounting_t;
+
+static int accounting_tag = -1;
+
+static void
+wmem_account(wmem_accounting_t *accounting, const size_t size)
+{
+    wmem_accounting_entry_t *entry;
+
+    if (accounting->last_entry != NULL && accounting->last_tag == accounting_tag) {
+        entry = accounting->last_entry;
+    }
+    else {
+        entry = (wmem_accounting_entry_t *)g_hash_table_lookup(accounting->entries,
+                GINT_TO_POINTER(accounting_tag));
+        if (entry == NULL) {
+            entry = g_new0(wmem_accounting_entry_t, 1);
+            g_hash_table_insert(accounting->entries,
+                    GINT_TO_POINTER(accounting_tag), entry);
+        }
+        accounting->last_tag   = accounting_tag;
+        accounting->last_entry = entry;
+    }
+
+    entry->allocs++;
+    entry->bytes += size;
+}
+
+static void
+wmem_accounting_clear(wmem_accounting_t *accounting)
+{
+    g_hash_table_remove_all(accounting->entries);
+    accounting->last_entry = NULL;
+}
+
 void *
 wmem_alloc(wmem_allocator_t *allocator, const size_t size)
 {
@@ -41,6 +88,12 @@ wmem_alloc(wmem_allocator_t *allocator, const size_t size)
         return NULL;
     }
 
+    allocator->alloc_count++;
+
+    if (G_UNLIKELY(allocator->accounting)) {
+        wmem_account(allocator->accounting, size);
+    }
+
     return allocator->walloc(allocator->private_data, size);
 }
 
@@ -93,6 +146,10 @@ wmem_realloc(wmem_allocator_t *allocator, void *ptr, const size_t size)
 
     g_assert(allocator->in_scope);
 
+    if (G_UNLIKELY(allocator->accounting)) {
+        wmem_account(allocator->accounting, size);
+    }
+
     return allocator->wrealloc(allocator->private_data, ptr, size);
 }
 
@@ -102,6 +159,9 @@ wmem_free_all_real(wmem_allocator_t *allocator, gboolean final)
     wmem_call_callbacks(allocator,
             final ? WMEM_CB_DESTROY_EVENT : WMEM_CB_FREE_EVENT);
     allocator->free_all(allocator->private_data);
+    if (allocator->accounting) {
+        wmem_accounting_clear(allocator->accounting);
+    }
 }
 
 void
@@ -121,6 +181,7 @@ wmem_destroy_allocator(wmem_allocator_t *allocator)
 {
 
     wmem_free_all_real(allocator, TRUE);
+    wmem_accounting_enable(allocator, FALSE);
     allocator->cleanup(allocator->private_data);
     wmem_free(NULL, allocator);
 }
@@ -142,6 +203,8 @@ wmem_allocator_new(const wmem_allocator_type_t type)
     allocator->type      = real_type;
     allocator->callbacks = NULL;
     allocator->in_scope  = TRUE;
+    allocator->alloc_count = 0;
+    allocator->accounting  = NULL;
 
     switch (real_type) {
         case WMEM_ALLOCATOR_SIMPLE:
@@ -167,6 +230,55 @@ wmem_allocator_new(const wmem_allocator_type_t type)
     return allocator;
 }
 
+guint64
+wmem_allocator_alloc_count(const wmem_allocator_t *allocator)
+{
+    return allocator->alloc_count;
+}
+
+void
+wmem_accounting_enable(wmem_allocator_t *allocator, const gboolean enable)
+{
+    if (enable && allocator->accounting == NULL) {
+        allocator->accounting = g_new0(wmem_accounting_t, 1);
+        allocator->accounting->entries = g_hash_table_new_full(g_direct_hash,
+                g_direct_equal, NULL, g_free);
+    }
+    else if (!enable && allocator->accounting != NULL) {
+        g_hash_table_destroy(allocator->accounting->entries);
+        g_free(allocator->accounting);
+        allocator->accounting = NULL;
+    }
+}
+
+int
+wmem_accounting_set_tag(const int tag)
+{
+    int previous = accounting_tag;
+
+    accounting_tag = tag;
+    return previous;
+}
+
+void
+wmem_accounting_foreach(const wmem_allocator_t *allocator,
+        wmem_accounting_func func, void *user_data)
+{
+    GHashTableIter           iter;
+    gpointer                 key, value;
+    wmem_accounting_entry_t *entry;
+
+    if (allocator->accounting == NULL) {
+        return;
+    }
+
+    g_hash_table_iter_init(&iter, allocator->accounting->entries);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        entry = (wmem_accounting_entry_t *)value;
+        func(GPOINTER_TO_INT(key), entry->allocs, entry->bytes, user_data);
+    }
+}
+
 void
 wmem_init(void)
 {
@@ -186,15 +298,16 @@ wmem_init(void)
         if (strncmp(override_env, "simple", strlen("simple")) == 0) {
             override_type = WMEM_ALLOCATOR_SIMPLE;
         }
+        else if (strncmp(override_env, "block_fast", strlen("block_fast")) == 0) {
+            /* before "block", which it begins with */
+            override_type = WMEM_ALLOCATOR_BLOCK_FAST;
+        }
         else if (strncmp(override_env, "block", strlen("block")) == 0) {
             override_type = WMEM_ALLOCATOR_BLOCK;
         }
         else if (strncmp(override_env, "strict", strlen("strict")) == 0) {
             override_type = WMEM_ALLOCATOR_STRICT;
         }
-        else if (strncmp(override_env, "block_fast", strlen("block_fast")) == 0) {
-            override_type = WMEM_ALLOCATOR_BLOCK_FAST;
-        }
         else {
             g_warning("Unrecognized wmem override");
             do_override = FALSE;
@@ -195,6 +195,65 @@ WS_DLL_PUBLIC
 wmem_allocator_t *
 wmem_allocator_new(const wmem_allocator_type_t type);
 
+/** Get the number of allocations made with the given allocator since it
+ * was created. Reallocations aren't counted, and neither is memory that
+ * the allocator gets for itself.
+ *
+ * @param allocator The allocator.
+ * @return The number of allocations.
+ */
+WS_DLL_PUBLIC
+guint64
+wmem_allocator_alloc_count(const wmem_allocator_t *allocator);
+
+/** Turn the accounting of the allocations made with an allocator on or
+ * off. While it is on, each allocation is counted against the tag set with
+ * wmem_accounting_set_tag() at the time, so that, for example, the memory of
+ * a scope can be broken down by the protocol that asked for it. The counts
+ * start again from zero whenever the allocator's memory is all freed, and
+ * are discarded when accounting is turned off.
+ *
+ * The bytes counted are those asked for with wmem_alloc() and
+ * wmem_realloc(). Memory given back with wmem_free(), or by shrinking or
+ * moving a block, isn't taken off, so the counts are an upper bound of what
+ * each tag holds, not including the allocator's own overhead.
+ *
+ * @param allocator The allocator.
+ * @param enable TRUE to turn accounting on.
+ */
+WS_DLL_PUBLIC
+void
+wmem_accounting_enable(wmem_allocator_t *allocator, const gboolean enable);
+
+/** Set the tag that the allocations made from now on are counted against,
+ * in every allocator where accounting is on. There is a single tag for the
+ * whole program, not one per thread.
+ *
+ * @param tag The new tag, -1 for none.
+ * @return The previous tag, to put back afterwards.
+ */
+WS_DLL_PUBLIC
+int
+wmem_accounting_set_tag(const int tag);
+
+/** Function called for each tag by wmem_accounting_foreach(). */
+typedef void (*wmem_accounting_func)(int tag, guint64 allocs, guint64 bytes,
+        void *user_data);
+
+/** Call a function for each tag that allocations were counted against, in
+ * no particular order, with the number of allocations and reallocations and
+ * the number of bytes they asked for. Nothing is called if accounting is
+ * off.
+ *
+ * @param allocator The allocator.
+ * @param func The function to call.
+ * @param user_data Passed to func.
+ */
+WS_DLL_PUBLIC
+void
+wmem_accounting_foreach(const wmem_allocator_t *allocator,
+        wmem_accounting_func func, void *user_data);
+
 /** Initialize the wmem subsystem. This must be called before any other wmem
  * function, usually at the very beginning of your program.
  */
@@ -0,0 +1,444 @@
+/* wmem_flat_map.c
+ * Wireshark Memory Manager Open-Addressing Hash Map
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+#include "config.h"
+
+#include <glib.h>
+
+#include "wmem_core.h"
+#include "wmem_list.h"
+#include "wmem_flat_map.h"
+#include "wmem_user_cb.h"
+
+/* The entries are kept in the slots of the table, in "Robin Hood" order: a
+ * key goes in the first free slot at or after its home slot (the one its
+ * hash picks), and when inserting passes a key that is closer to its own
+ * home than the new key is to the new key's home, the two swap places and
+ * the displaced key carries on looking. That keeps every key within a few
+ * slots of its home even when the table is nearly full, so a lookup can stop
+ * as soon as it reaches a key closer to home than the one it's looking for
+ * would be there. */
+typedef struct _wmem_flat_map_slot_t {
+    const void *key;
+    void       *value;
+    guint32     hash;  /* the key's hash, mixed (see the HASH macro) */
+    guint32     dist;  /* 0 if the slot is empty, otherwise one more than the
+                          number of slots the key is past its home slot */
+} wmem_flat_map_slot_t;
+
+struct _wmem_flat_map_t {
+    guint count; /* number of items stored */
+
+    /* The base-2 logarithm of the actual size of the table, as in the
+     * wmem_map. */
+    guint capacity;
+
+    /* Used for universal integer hashing; a random odd number for each map,
+     * so that keys that happen to collide in one map don't in another. */
+    guint32 multiplier;
+
+    wmem_flat_map_slot_t *table;
+
+    GHashFunc  hash_func;
+    GEqualFunc eql_func;
+
+    guint      metadata_scope_cb_id;
+    guint      data_scope_cb_id;
+
+    wmem_allocator_t *metadata_allocator;
+    wmem_allocator_t *data_allocator;
+};
+
+/* The default capacity is 2^5 = 32 slots */
+#define WMEM_FLAT_MAP_DEFAULT_CAPACITY 5
+
+#define CAPACITY(MAP) (((size_t)1) << (MAP)->capacity)
+
+/* The table grows when it would be more than 7/8 full. */
+#define OVER_FULL(MAP, COUNT) ((size_t)(COUNT) * 8 > CAPACITY(MAP) * 7)
+
+/* The same universal integer hashing as the wmem_map; the top bits of the
+ * mixed hash pick the home slot. */
+#define HASH(MAP, KEY) ((guint32)((MAP)->hash_func(KEY) * (MAP)->multiplier))
+#define HOME(MAP, HASH_VAL) ((HASH_VAL) >> (32 - (MAP)->capacity))
+
+static void
+wmem_flat_map_init_table(wmem_flat_map_t *map)
+{
+    map->count     = 0;
+    map->capacity  = WMEM_FLAT_MAP_DEFAULT_CAPACITY;
+    map->table     = wmem_alloc0_array(map->data_allocator, wmem_flat_map_slot_t, CAPACITY(map));
+}
+
+static void
+wmem_flat_map_init(wmem_flat_map_t *map, GHashFunc hash_func, GEqualFunc eql_func)
+{
+    map->hash_func  = hash_func;
+    map->eql_func   = eql_func;
+    map->multiplier = g_random_int() | 1;
+    map->count      = 0;
+    map->capacity   = 0;
+    map->table      = NULL;
+}
+
+wmem_flat_map_t *
+wmem_flat_map_new(wmem_allocator_t *allocator,
+        GHashFunc hash_func, GEqualFunc eql_func)
+{
+    wmem_flat_map_t *map;
+
+    map = wmem_new(allocator, wmem_flat_map_t);
+
+    wmem_flat_map_init(map, hash_func, eql_func);
+    map->metadata_allocator = allocator;
+    map->data_allocator     = allocator;
+
+    return map;
+}
+
+static gboolean
+wmem_flat_map_reset_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event,
+        void *user_data)
+{
+    wmem_flat_map_t *map = (wmem_flat_map_t*)user_data;
+
+    map->count = 0;
+    map->table = NULL;
+
+    if (event == WMEM_CB_DESTROY_EVENT) {
+        wmem_unregister_callback(map->metadata_allocator, map->metadata_scope_cb_id);
+        wmem_free(map->metadata_allocator, map);
+    }
+
+    return TRUE;
+}
+
+static gboolean
+wmem_flat_map_destroy_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event _U_,
+        void *user_data)
+{
+    wmem_flat_map_t *map = (wmem_flat_map_t*)user_data;
+
+    wmem_unregister_callback(map->data_allocator, map->data_scope_cb_id);
+
+    return FALSE;
+}
+
+wmem_flat_map_t *
+wmem_flat_map_new_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_scope,
+        GHashFunc hash_func, GEqualFunc eql_func)
+{
+    wmem_flat_map_t *map;
+
+    map = wmem_new(metadata_scope, wmem_flat_map_t);
+
+    wmem_flat_map_init(map, hash_func, eql_func);
+    map->metadata_allocator = metadata_scope;
+    map->data_allocator     = data_scope;
+
+    map->metadata_scope_cb_id = wmem_register_callback(metadata_scope, wmem_flat_map_destroy_cb, map);
+    map->data_scope_cb_id     = wmem_register_callback(data_scope, wmem_flat_map_reset_cb, map);
+
+    return map;
+}
+
+/* Put an entry whose key isn't in the table into it, starting the search
+ * for a slot at slot i, dist - 1 slots past the entry's home; there must be
+ * a free slot. */
+static void
+wmem_flat_map_place(wmem_flat_map_t *map, const void *key, void *value, guint32 hash,
+        size_t i, guint32 dist)
+{
+    wmem_flat_map_slot_t  cur, tmp, *slot;
+    size_t                mask = CAPACITY(map) - 1;
+
+    cur.key   = key;
+    cur.value = value;
+    cur.hash  = hash;
+    cur.dist  = dist;
+
+    for (; ; i = (i + 1) & mask, cur.dist++) {
+        slot = &map->table[i];
+        if (slot->dist == 0) {
+            *slot = cur;
+            return;
+        }
+        if (slot->dist < cur.dist) {
+            /* this one is nearer its home than we are; take its place */
+            tmp   = *slot;
+            *slot = cur;
+            cur   = tmp;
+        }
+    }
+}
+
+static void
+wmem_flat_map_grow(wmem_flat_map_t *map)
+{
+    wmem_flat_map_slot_t *old_table;
+    size_t                old_cap, i;
+
+    /* store the old table and capacity */
+    old_table = map->table;
+    old_cap   = CAPACITY(map);
+
+    /* double the size and allocate new table */
+    map->capacity++;
+    map->table = wmem_alloc0_array(map->data_allocator, wmem_flat_map_slot_t, CAPACITY(map));
+
+    /* copy all the entries over from the old table; their hashes are kept,
+     * so the hash function needn't be called again */
+    for (i = 0; i < old_cap; i++) {
+        if (old_table[i].dist != 0) {
+            wmem_flat_map_place(map, old_table[i].key, old_table[i].value, old_table[i].hash,
+                    HOME(map, old_table[i].hash), 1);
+        }
+    }
+
+    /* free the old table */
+    wmem_free(map->data_allocator, old_table);
+}
+
+/* Find the slot holding a key, or NULL if the key isn't in the table. If it
+ * isn't, *stop and *stop_dist are set to where an insertion should start
+ * looking for a slot for it. */
+static inline wmem_flat_map_slot_t *
+wmem_flat_map_find(const wmem_flat_map_t *map, const void *key, guint32 hash,
+        size_t *stop, guint32 *stop_dist)
+{
+    wmem_flat_map_slot_t *slot;
+    size_t                mask = CAPACITY(map) - 1;
+    size_t                i;
+    guint32               dist;
+
+    for (i = HOME(map, hash), dist = 1; ; i = (i + 1) & mask, dist++) {
+        slot = &map->table[i];
+        /* An empty slot, or a key nearer its home than ours would be here,
+         * means ours isn't in the table. */
+        if (slot->dist < dist) {
+            if (stop) {
+                *stop = i;
+                *stop_dist = dist;
+            }
+            return NULL;
+        }
+        if (slot->hash == hash && map->eql_func(key, slot->key)) {
+            return slot;
+        }
+    }
+}
+
+/* Empty a slot, moving the entries after it that aren't in their home slots
+ * back by one. */
+static void
+wmem_flat_map_erase(wmem_flat_map_t *map, wmem_flat_map_slot_t *slot)
+{
+    size_t                mask = CAPACITY(map) - 1;
+    size_t                i = (size_t)(slot - map->table);
+    wmem_flat_map_slot_t *next;
+
+    for (;;) {
+        next = &map->table[(i + 1) & mask];
+        if (next->dist <= 1) {
+            map->table[i].dist = 0;
+            break;
+        }
+        map->table[i] = *next;
+        map->table[i].dist--;
+        i = (i + 1) & mask;
+    }
+
+    map->count--;
+}
+
+void *
+wmem_flat_map_insert(wmem_flat_map_t *map, const void *key, void *value)
+{
+    wmem_flat_map_slot_t *slot;
+    void                 *old_val;
+    guint32               hash, dist;
+    size_t                i;
+
+    /* Make sure we have a table */
+    if (map->table == NULL) {
+        wmem_flat_map_init_table(map);
+    }
+
+    hash = HASH(map, key);
+
+    slot = wmem_flat_map_find(map, key, hash, &i, &dist);
+    if (slot) {
+        /* replace and return old value for this key */
+        old_val = slot->value;
+        slot->value = value;
+        return old_val;
+    }
+
+    /* increase size if we would be over-full */
+    if (OVER_FULL(map, map->count + 1)) {
+        wmem_flat_map_grow(map);
+        i = HOME(map, hash);
+        dist = 1;
+    }
+
+    wmem_flat_map_place(map, key, value, hash, i, dist);
+    map->count++;
+
+    /* no previous entry, return NULL */
+    return NULL;
+}
+
+gboolean
+wmem_flat_map_contains(wmem_flat_map_t *map, const void *key)
+{
+    /* Make sure we have a table */
+    if (map->table == NULL) {
+        return FALSE;
+    }
+
+    return wmem_flat_map_find(map, key, HASH(map, key), NULL, NULL) != NULL;
+}
+
+void *
+wmem_flat_map_lookup(wmem_flat_map_t *map, const void *key)
+{
+    wmem_flat_map_slot_t *slot;
+
+    /* Make sure we have a table */
+    if (map->table == NULL) {
+        return NULL;
+    }
+
+    slot = wmem_flat_map_find(map, key, HASH(map, key), NULL, NULL);
+
+    return slot ? slot->value : NULL;
+}
+
+gboolean
+wmem_flat_map_lookup_extended(wmem_flat_map_t *map, const void *key, const void **orig_key, void **value)
+{
+    wmem_flat_map_slot_t *slot;
+
+    /* Make sure we have a table */
+    if (map->table == NULL) {
+        return FALSE;
+    }
+
+    slot = wmem_flat_map_find(map, key, HASH(map, key), NULL, NULL);
+    if (!slot) {
+        return FALSE;
+    }
+
+    if (orig_key) {
+        *orig_key = slot->key;
+    }
+    if (value) {
+        *value = slot->value;
+    }
+    return TRUE;
+}
+
+void *
+wmem_flat_map_remove(wmem_flat_map_t *map, const void *key)
+{
+    wmem_flat_map_slot_t *slot;
+    void                 *value;
+
+    /* Make sure we have a table */
+    if (map->table == NULL) {
+        return NULL;
+    }
+
+    slot = wmem_flat_map_find(map, key, HASH(map, key), NULL, NULL);
+    if (!slot) {
+        /* didn't find it */
+        return NULL;
+    }
+
+    value = slot->value;
+    wmem_flat_map_erase(map, slot);
+    return value;
+}
+
+gboolean
+wmem_flat_map_steal(wmem_flat_map_t *map, const void *key)
+{
+    wmem_flat_map_slot_t *slot;
+
+    /* Make sure we have a table */
+    if (map->table == NULL) {
+        return FALSE;
+    }
+
+    slot = wmem_flat_map_find(map, key, HASH(map, key), NULL, NULL);
+    if (!slot) {
+        /* didn't find it */
+        return FALSE;
+    }
+
+    wmem_flat_map_erase(map, slot);
+    return TRUE;
+}
+
+wmem_list_t*
+wmem_flat_map_get_keys(wmem_allocator_t *list_allocator, wmem_flat_map_t *map)
+{
+    size_t capacity, i;
+    wmem_list_t* list = wmem_list_new(list_allocator);
+
+    if (map->table != NULL) {
+        capacity = CAPACITY(map);
+
+        /* copy all the keys into the list */
+        for (i = 0; i < capacity; i++) {
+            if (map->table[i].dist != 0) {
+                wmem_list_prepend(list, (void*)map->table[i].key);
+            }
+        }
+    }
+
+    return list;
+}
+
+void
+wmem_flat_map_foreach(wmem_flat_map_t *map, GHFunc foreach_func, gpointer user_data)
+{
+    size_t capacity, i;
+
+    /* Make sure we have a table */
+    if (map->table == NULL) {
+        return;
+    }
+
+    capacity = CAPACITY(map);
+    for (i = 0; i < capacity; i++) {
+        if (map->table[i].dist != 0) {
+            foreach_func((gpointer)map->table[i].key, map->table[i].value, user_data);
+        }
+    }
+}
+
+guint
+wmem_flat_map_size(wmem_flat_map_t *map)
+{
+    return map->count;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,365 @@
+/* wmem_flat_tree.c
+ * Wireshark Memory Manager Flat Sorted Tree
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+#include "config.h"
+
+#include <string.h>
+#include <glib.h>
+
+#include "wmem_core.h"
+#include "wmem_tree.h"
+#include "wmem_flat_tree.h"
+#include "wmem_user_cb.h"
+
+#define WMEM_FLAT_TREE_LEAF_SIZE 64
+
+/* The keys of a leaf are kept apart from the values, so that the binary
+ * search only touches the (few) cache lines holding the keys. */
+typedef struct _wmem_flat_tree_leaf_t {
+    guint    count;
+    guint32  keys[WMEM_FLAT_TREE_LEAF_SIZE];
+    void    *values[WMEM_FLAT_TREE_LEAF_SIZE];
+} wmem_flat_tree_leaf_t;
+
+struct _wmem_flat_tree_t {
+    guint count; /* number of keys stored */
+
+    /* The leaves in key order, and the first key of each of them; no leaf is
+     * ever empty. */
+    guint                   leaf_count;
+    guint                   leaf_capacity;
+    guint32                *first_keys;
+    wmem_flat_tree_leaf_t **leaves;
+
+    guint metadata_scope_cb_id;
+    guint data_scope_cb_id;
+
+    wmem_allocator_t *metadata_allocator;
+    wmem_allocator_t *data_allocator;
+};
+
+/* The number of keys in a sorted array that are less than or equal to key */
+static inline guint
+upper_bound(const guint32 *keys, guint count, guint32 key)
+{
+    guint lo = 0, hi = count, mid;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (keys[mid] <= key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static void
+wmem_flat_tree_init(wmem_flat_tree_t *tree)
+{
+    tree->count         = 0;
+    tree->leaf_count    = 0;
+    tree->leaf_capacity = 0;
+    tree->first_keys    = NULL;
+    tree->leaves        = NULL;
+}
+
+wmem_flat_tree_t *
+wmem_flat_tree_new(wmem_allocator_t *allocator)
+{
+    wmem_flat_tree_t *tree;
+
+    tree = wmem_new(allocator, wmem_flat_tree_t);
+
+    wmem_flat_tree_init(tree);
+    tree->metadata_allocator = allocator;
+    tree->data_allocator     = allocator;
+
+    return tree;
+}
+
+static gboolean
+wmem_flat_tree_reset_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event,
+        void *user_data)
+{
+    wmem_flat_tree_t *tree = (wmem_flat_tree_t *)user_data;
+
+    wmem_flat_tree_init(tree);
+
+    if (event == WMEM_CB_DESTROY_EVENT) {
+        wmem_unregister_callback(tree->metadata_allocator, tree->metadata_scope_cb_id);
+        wmem_free(tree->metadata_allocator, tree);
+    }
+
+    return TRUE;
+}
+
+static gboolean
+wmem_flat_tree_destroy_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event _U_,
+        void *user_data)
+{
+    wmem_flat_tree_t *tree = (wmem_flat_tree_t *)user_data;
+
+    wmem_unregister_callback(tree->data_allocator, tree->data_scope_cb_id);
+
+    return FALSE;
+}
+
+wmem_flat_tree_t *
+wmem_flat_tree_new_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_scope)
+{
+    wmem_flat_tree_t *tree;
+
+    tree = wmem_new(metadata_scope, wmem_flat_tree_t);
+
+    wmem_flat_tree_init(tree);
+    tree->metadata_allocator = metadata_scope;
+    tree->data_allocator     = data_scope;
+
+    tree->metadata_scope_cb_id = wmem_register_callback(metadata_scope, wmem_flat_tree_destroy_cb, tree);
+    tree->data_scope_cb_id     = wmem_register_callback(data_scope, wmem_flat_tree_reset_cb, tree);
+
+    return tree;
+}
+
+void
+wmem_flat_tree_destroy(wmem_flat_tree_t *tree)
+{
+    guint i;
+
+    for (i = 0; i < tree->leaf_count; i++) {
+        wmem_free(tree->data_allocator, tree->leaves[i]);
+    }
+    wmem_free(tree->data_allocator, tree->first_keys);
+    wmem_free(tree->data_allocator, tree->leaves);
+    wmem_free(tree->metadata_allocator, tree);
+}
+
+gboolean
+wmem_flat_tree_is_empty(wmem_flat_tree_t *tree)
+{
+    return tree->count == 0;
+}
+
+guint
+wmem_flat_tree_count(wmem_flat_tree_t *tree)
+{
+    return tree->count;
+}
+
+/* Add an empty leaf at position pos of the index; the caller must put a key
+ * in it and set its first key. */
+static wmem_flat_tree_leaf_t *
+wmem_flat_tree_add_leaf(wmem_flat_tree_t *tree, guint pos)
+{
+    wmem_flat_tree_leaf_t *leaf;
+
+    if (tree->leaf_count == tree->leaf_capacity) {
+        tree->leaf_capacity = tree->leaf_capacity ? tree->leaf_capacity * 2 : 4;
+        tree->first_keys = (guint32 *)wmem_realloc(tree->data_allocator, tree->first_keys,
+                tree->leaf_capacity * sizeof(guint32));
+        tree->leaves = (wmem_flat_tree_leaf_t **)wmem_realloc(tree->data_allocator, tree->leaves,
+                tree->leaf_capacity * sizeof(wmem_flat_tree_leaf_t *));
+    }
+
+    memmove(&tree->first_keys[pos + 1], &tree->first_keys[pos],
+            (tree->leaf_count - pos) * sizeof(guint32));
+    memmove(&tree->leaves[pos + 1], &tree->leaves[pos],
+            (tree->leaf_count - pos) * sizeof(wmem_flat_tree_leaf_t *));
+
+    leaf = wmem_new(tree->data_allocator, wmem_flat_tree_leaf_t);
+    leaf->count = 0;
+
+    tree->leaves[pos] = leaf;
+    tree->leaf_count++;
+
+    return leaf;
+}
+
+void
+wmem_flat_tree_insert32(wmem_flat_tree_t *tree, guint32 key, void *data)
+{
+    wmem_flat_tree_leaf_t *leaf, *upper;
+    guint                  i, j;
+
+    if (tree->leaf_count > 0) {
+        leaf = tree->leaves[tree->leaf_count - 1];
+        if (key > leaf->keys[leaf->count - 1]) {
+            /* The usual case: a key past the end. Append it, starting a new
+             * leaf if the last one is full, which leaves it full for good. */
+            if (leaf->count == WMEM_FLAT_TREE_LEAF_SIZE) {
+                leaf = wmem_flat_tree_add_leaf(tree, tree->leaf_count);
+                tree->first_keys[tree->leaf_count - 1] = key;
+            }
+            leaf->keys[leaf->count] = key;
+            leaf->values[leaf->count] = data;
+            leaf->count++;
+            tree->count++;
+            return;
+        }
+    } else {
+        leaf = wmem_flat_tree_add_leaf(tree, 0);
+        tree->first_keys[0] = key;
+        leaf->keys[0] = key;
+        leaf->values[0] = data;
+        leaf->count = 1;
+        tree->count = 1;
+        return;
+    }
+
+    /* The leaf whose first key is the largest one not above the key, or the
+     * first leaf if the key is below them all. */
+    i = upper_bound(tree->first_keys, tree->leaf_count, key);
+    if (i > 0) {
+        i--;
+    }
+    leaf = tree->leaves[i];
+
+    j = upper_bound(leaf->keys, leaf->count, key);
+    if (j > 0 && leaf->keys[j - 1] == key) {
+        leaf->values[j - 1] = data;
+        return;
+    }
+
+    if (leaf->count == WMEM_FLAT_TREE_LEAF_SIZE) {
+        /* split it, moving its upper half to a new leaf after it */
+        upper = wmem_flat_tree_add_leaf(tree, i + 1);
+        upper->count = WMEM_FLAT_TREE_LEAF_SIZE / 2;
+        memcpy(upper->keys, &leaf->keys[WMEM_FLAT_TREE_LEAF_SIZE / 2],
+                upper->count * sizeof(guint32));
+        memcpy(upper->values, &leaf->values[WMEM_FLAT_TREE_LEAF_SIZE / 2],
+                upper->count * sizeof(void *));
+        leaf->count -= upper->count;
+        tree->first_keys[i + 1] = upper->keys[0];
+
+        if (j > leaf->count) {
+            i++;
+            j -= leaf->count;
+            leaf = upper;
+        }
+    }
+
+    memmove(&leaf->keys[j + 1], &leaf->keys[j], (leaf->count - j) * sizeof(guint32));
+    memmove(&leaf->values[j + 1], &leaf->values[j], (leaf->count - j) * sizeof(void *));
+    leaf->keys[j] = key;
+    leaf->values[j] = data;
+    leaf->count++;
+    if (j == 0) {
+        tree->first_keys[i] = key;
+    }
+    tree->count++;
+}
+
+/* Find the position of the largest key not above the given one; returns
+ * FALSE if there is no such key. */
+static inline gboolean
+wmem_flat_tree_find_le(const wmem_flat_tree_t *tree, guint32 key, guint *leaf_pos, guint *key_pos)
+{
+    const wmem_flat_tree_leaf_t *leaf;
+    guint                        i;
+
+    i = upper_bound(tree->first_keys, tree->leaf_count, key);
+    if (i == 0) {
+        return FALSE;
+    }
+    leaf = tree->leaves[i - 1];
+
+    *leaf_pos = i - 1;
+    /* the first key of the leaf is not above ours, so this is at least 1 */
+    *key_pos = upper_bound(leaf->keys, leaf->count, key) - 1;
+    return TRUE;
+}
+
+void *
+wmem_flat_tree_lookup32(wmem_flat_tree_t *tree, guint32 key)
+{
+    guint i, j;
+
+    if (!wmem_flat_tree_find_le(tree, key, &i, &j) || tree->leaves[i]->keys[j] != key) {
+        return NULL;
+    }
+    return tree->leaves[i]->values[j];
+}
+
+void *
+wmem_flat_tree_lookup32_le(wmem_flat_tree_t *tree, guint32 key)
+{
+    guint i, j;
+
+    if (!wmem_flat_tree_find_le(tree, key, &i, &j)) {
+        return NULL;
+    }
+    return tree->leaves[i]->values[j];
+}
+
+void *
+wmem_flat_tree_remove32(wmem_flat_tree_t *tree, guint32 key)
+{
+    wmem_flat_tree_leaf_t *leaf;
+    void                  *value;
+    guint                  i, j;
+
+    if (!wmem_flat_tree_find_le(tree, key, &i, &j) || tree->leaves[i]->keys[j] != key) {
+        return NULL;
+    }
+    leaf = tree->leaves[i];
+    value = leaf->values[j];
+
+    leaf->count--;
+    memmove(&leaf->keys[j], &leaf->keys[j + 1], (leaf->count - j) * sizeof(guint32));
+    memmove(&leaf->values[j], &leaf->values[j + 1], (leaf->count - j) * sizeof(void *));
+    tree->count--;
+
+    if (leaf->count == 0) {
+        /* drop the leaf from the index */
+        tree->leaf_count--;
+        memmove(&tree->first_keys[i], &tree->first_keys[i + 1],
+                (tree->leaf_count - i) * sizeof(guint32));
+        memmove(&tree->leaves[i], &tree->leaves[i + 1],
+                (tree->leaf_count - i) * sizeof(wmem_flat_tree_leaf_t *));
+        wmem_free(tree->data_allocator, leaf);
+    } else if (j == 0) {
+        tree->first_keys[i] = leaf->keys[0];
+    }
+
+    return value;
+}
+
+gboolean
+wmem_flat_tree_foreach(wmem_flat_tree_t *tree, wmem_foreach_func callback,
+        void *user_data)
+{
+    const wmem_flat_tree_leaf_t *leaf;
+    guint                        i, j;
+
+    for (i = 0; i < tree->leaf_count; i++) {
+        leaf = tree->leaves[i];
+        for (j = 0; j < leaf->count; j++) {
+            if (callback(GUINT_TO_POINTER(leaf->keys[j]), leaf->values[j], user_data)) {
+                return TRUE;
+            }
+        }
+    }
+
+    return FALSE;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,145 @@
+/* wmem_flat_tree.h
+ * Definitions for the Wireshark Memory Manager Flat Sorted Tree
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WMEM_FLAT_TREE_H__
+#define __WMEM_FLAT_TREE_H__
+
+#include <glib.h>
+
+#include "wmem_core.h"
+#include "wmem_tree.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** @addtogroup wmem
+ *  @{
+ *    @defgroup wmem-flat-tree Flat Sorted Tree
+ *
+ *    An ordered map from guint32 keys to values with the same lookup32 and
+ *    lookup32_le semantics as the wmem_tree. Instead of a node for every key
+ *    it keeps the keys in sorted arrays ("leaves") of up to 64 entries, with
+ *    a sorted index of the first key of each leaf; a lookup is a binary
+ *    search in the index and then in one leaf.
+ *
+ *    Inserting a key larger than any in the tree just appends it to the last
+ *    leaf, and leaves filled that way are left full, so trees keyed by frame
+ *    or sequence numbers that mostly arrive in increasing order take about
+ *    12 bytes per entry and one allocation for every 64 of them. Keys that
+ *    arrive out of order are still fine, but split the leaves they land in.
+ *
+ *    @{
+ */
+
+struct _wmem_flat_tree_t;
+typedef struct _wmem_flat_tree_t wmem_flat_tree_t;
+
+/** Creates a tree with the given allocator scope. When the scope is emptied,
+ * the tree is fully destroyed. */
+WS_DLL_PUBLIC
+wmem_flat_tree_t *
+wmem_flat_tree_new(wmem_allocator_t *allocator)
+G_GNUC_MALLOC;
+
+/** Creates a tree with two allocator scopes, like wmem_tree_new_autoreset().
+ * The base structure lives in the metadata scope, and the tree data lives in
+ * the data scope; every time free_all occurs in the data scope the tree is
+ * transparently emptied.
+ *
+ * WARNING: None of the tree (even the part in the metadata scope) can be used
+ * after the data scope has been *destroyed*.
+ */
+WS_DLL_PUBLIC
+wmem_flat_tree_t *
+wmem_flat_tree_new_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_scope)
+G_GNUC_MALLOC;
+
+/** Frees a tree made by wmem_flat_tree_new() and everything in it but the
+ * values. This is mostly useful for trees in the NULL (manual) scope, and
+ * must not be used on an autoreset tree. */
+WS_DLL_PUBLIC
+void
+wmem_flat_tree_destroy(wmem_flat_tree_t *tree);
+
+/** Returns true if the tree is empty (has no nodes). */
+WS_DLL_PUBLIC
+gboolean
+wmem_flat_tree_is_empty(wmem_flat_tree_t *tree);
+
+/** Returns number of nodes in tree */
+WS_DLL_PUBLIC
+guint
+wmem_flat_tree_count(wmem_flat_tree_t *tree);
+
+/** Insert a value indexed by a guint32 key. As with wmem_tree_insert32(),
+ * inserting a key that is already in the tree overwrites its value.
+ */
+WS_DLL_PUBLIC
+void
+wmem_flat_tree_insert32(wmem_flat_tree_t *tree, guint32 key, void *data);
+
+/** Look up a value in the tree indexed by a guint32 key. If the key is not
+ * found the function will return NULL.
+ */
+WS_DLL_PUBLIC
+void *
+wmem_flat_tree_lookup32(wmem_flat_tree_t *tree, guint32 key);
+
+/** Look up a value in the tree indexed by a guint32 key.
+ * Returns the value of the largest key that is less than or equal
+ * to the search key, or NULL if no such key exists.
+ */
+WS_DLL_PUBLIC
+void *
+wmem_flat_tree_lookup32_le(wmem_flat_tree_t *tree, guint32 key);
+
+/** Remove a key from the tree. Unlike wmem_tree_remove32() the key is really
+ * removed, so a later wmem_flat_tree_lookup32_le() finds the key before it
+ * rather than NULL.
+ *
+ * @return The removed value if the key was in the tree, or NULL.
+ */
+WS_DLL_PUBLIC
+void *
+wmem_flat_tree_remove32(wmem_flat_tree_t *tree, guint32 key);
+
+/** Call callback(GUINT_TO_POINTER(key), value, user_data) for each key in
+ * increasing order, as wmem_tree_foreach() does. The tree must not be
+ * changed from the callback.
+ *
+ * Returns TRUE if the traversal was ended prematurely by the callback.
+ */
+WS_DLL_PUBLIC
+gboolean
+wmem_flat_tree_foreach(wmem_flat_tree_t *tree, wmem_foreach_func callback,
+        void *user_data);
+
+/**   @}
+ *  @} */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __WMEM_FLAT_TREE_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
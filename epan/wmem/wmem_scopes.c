@@ -14,6 +14,7 @@
 #include "wmem_core.h"
 #include "wmem_scopes.h"
 #include "wmem_allocator.h"
+#include "wmem_allocator_locked.h"
 
 /* One of the supposed benefits of wmem over the old emem was going to be that
  * the scoping of the various memory pools would be obvious, since they would
@@ -35,16 +36,39 @@
  * perfect, but it should stop most of the bad behaviour that emem permitted.
  */
 
-/* TODO: Make these thread-local */
 static wmem_allocator_t *packet_scope = NULL;
 static wmem_allocator_t *file_scope   = NULL;
 static wmem_allocator_t *epan_scope   = NULL;
 
+/* When the scopes are threaded (see wmem_set_threaded_scopes()) the file and
+ * epan scopes take a lock around each allocation, and a thread that called
+ * wmem_thread_init_scopes() gets a packet scope of its own, kept here. The
+ * flag is checked first so that the single-threaded case doesn't pay for the
+ * thread-local lookup. */
+static gboolean threaded_scopes = FALSE;
+
+static void
+wmem_thread_packet_scope_destroy(gpointer data)
+{
+    wmem_destroy_allocator((wmem_allocator_t *)data);
+}
+
+static GPrivate thread_packet_scope = G_PRIVATE_INIT(wmem_thread_packet_scope_destroy);
+
 /* Packet Scope */
 
 wmem_allocator_t *
 wmem_packet_scope(void)
 {
+    wmem_allocator_t *scope;
+
+    if (G_UNLIKELY(threaded_scopes)) {
+        scope = (wmem_allocator_t *)g_private_get(&thread_packet_scope);
+        if (scope) {
+            return scope;
+        }
+    }
+
     g_assert(packet_scope);
 
     return packet_scope;
@@ -53,21 +77,23 @@ wmem_packet_scope(void)
 void
 wmem_enter_packet_scope(void)
 {
-    g_assert(packet_scope);
+    wmem_allocator_t *scope = wmem_packet_scope();
+
     g_assert(file_scope->in_scope);
-    g_assert(!packet_scope->in_scope);
+    g_assert(!scope->in_scope);
 
-    packet_scope->in_scope = TRUE;
+    scope->in_scope = TRUE;
 }
 
 void
 wmem_leave_packet_scope(void)
 {
-    g_assert(packet_scope);
-    g_assert(packet_scope->in_scope);
+    wmem_allocator_t *scope = wmem_packet_scope();
 
-    wmem_free_all(packet_scope);
-    packet_scope->in_scope = FALSE;
+    g_assert(scope->in_scope);
+
+    wmem_free_all(scope);
+    scope->in_scope = FALSE;
 }
 
 /* File Scope */
@@ -114,6 +140,59 @@ wmem_epan_scope(void)
     return epan_scope;
 }
 
+/* Threads */
+
+void
+wmem_set_threaded_scopes(gboolean threaded)
+{
+    g_assert(file_scope);
+    g_assert(epan_scope);
+
+    if (threaded) {
+        wmem_locked_allocator_wrap(file_scope);
+        wmem_locked_allocator_wrap(epan_scope);
+    } else {
+        wmem_locked_allocator_unwrap(file_scope);
+        wmem_locked_allocator_unwrap(epan_scope);
+    }
+
+    threaded_scopes = threaded;
+}
+
+gboolean
+wmem_threaded_scopes(void)
+{
+    return threaded_scopes;
+}
+
+void
+wmem_thread_init_scopes(void)
+{
+    wmem_allocator_t *scope;
+
+    g_assert(threaded_scopes);
+    g_assert(g_private_get(&thread_packet_scope) == NULL);
+
+    scope = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK_FAST);
+    scope->in_scope = FALSE;
+
+    g_private_set(&thread_packet_scope, scope);
+}
+
+void
+wmem_thread_cleanup_scopes(void)
+{
+    wmem_allocator_t *scope = (wmem_allocator_t *)g_private_get(&thread_packet_scope);
+
+    g_assert(scope);
+    g_assert(!scope->in_scope);
+
+    /* g_private_replace() would call the destroy notify for us, but do it
+     * ourselves so that the scope has gone when this returns. */
+    g_private_set(&thread_packet_scope, NULL);
+    wmem_destroy_allocator(scope);
+}
+
 /* Scope Management */
 
 void
@@ -141,6 +220,7 @@ wmem_cleanup_scopes(void)
 
     g_assert(packet_scope->in_scope == FALSE);
     g_assert(file_scope->in_scope   == FALSE);
+    g_assert(!threaded_scopes);
 
     wmem_destroy_allocator(packet_scope);
     wmem_destroy_allocator(file_scope);
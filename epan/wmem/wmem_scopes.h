@@ -52,6 +52,41 @@ WS_DLL_LOCAL
 void
 wmem_leave_file_scope(void);
 
+/* Threads */
+
+/** Make the file and epan scopes safe to use from several threads at once,
+ * or go back to using them from one thread only. Threads that have called
+ * wmem_thread_init_scopes() get a packet scope of their own from
+ * wmem_packet_scope() while this is on; the others all share the usual one.
+ *
+ * It must be called while no other thread is using the scopes. Memory
+ * allocated in a scope before the change stays valid afterwards. Callbacks
+ * on the file and epan scopes must still only be registered from one thread.
+ */
+WS_DLL_PUBLIC
+void
+wmem_set_threaded_scopes(gboolean threaded);
+
+/** Returns TRUE if wmem_set_threaded_scopes() turned threaded scopes on. */
+WS_DLL_PUBLIC
+gboolean
+wmem_threaded_scopes(void);
+
+/** Give the calling thread a packet scope of its own, which it enters and
+ * leaves with the usual packet scope calls. Scopes must be threaded. The
+ * scope is destroyed by wmem_thread_cleanup_scopes(), or when the thread
+ * exits.
+ */
+WS_DLL_PUBLIC
+void
+wmem_thread_init_scopes(void);
+
+/** Destroy the packet scope of the calling thread, which must not be in
+ * use. */
+WS_DLL_PUBLIC
+void
+wmem_thread_cleanup_scopes(void);
+
 /* Scope Management */
 
 WS_DLL_LOCAL
@@ -194,6 +194,94 @@ wmem_test_allocator_callbacks(void)
     g_assert_true(cb_called_count == 3);
 }
 
+static void
+wmem_test_allocator_alloc_count(void)
+{
+    wmem_allocator_t *allocator;
+    void             *ptr;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
+    g_assert_true(wmem_allocator_alloc_count(allocator) == 0);
+
+    ptr = wmem_alloc(allocator, 8);
+    wmem_alloc0(allocator, 8);
+    g_assert_true(wmem_allocator_alloc_count(allocator) == 2);
+
+    /* Zero-length allocations and reallocations don't count */
+    wmem_alloc(allocator, 0);
+    wmem_realloc(allocator, ptr, 16);
+    g_assert_true(wmem_allocator_alloc_count(allocator) == 2);
+
+    wmem_realloc(allocator, NULL, 16);
+    g_assert_true(wmem_allocator_alloc_count(allocator) == 3);
+
+    /* It's a count since creation, not of live allocations */
+    wmem_free_all(allocator);
+    g_assert_true(wmem_allocator_alloc_count(allocator) == 3);
+
+    wmem_destroy_allocator(allocator);
+}
+
+static void
+wmem_test_accounting_func(int tag, guint64 allocs, guint64 bytes,
+        void *user_data)
+{
+    guint64 *counts = (guint64 *)user_data;
+
+    g_assert_true(tag >= -1 && tag <= 1);
+    counts[2 * (tag + 1)]     = allocs;
+    counts[2 * (tag + 1) + 1] = bytes;
+}
+
+static void
+wmem_test_allocator_accounting(void)
+{
+    wmem_allocator_t *allocator;
+    void             *ptr;
+    guint64           counts[6];
+    int               saved_tag;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
+
+    /* Nothing is counted until accounting is on */
+    wmem_alloc(allocator, 8);
+    memset(counts, 0, sizeof counts);
+    wmem_accounting_foreach(allocator, wmem_test_accounting_func, counts);
+    g_assert_true(counts[0] == 0 && counts[1] == 0);
+
+    wmem_accounting_enable(allocator, TRUE);
+    wmem_alloc(allocator, 8);
+    saved_tag = wmem_accounting_set_tag(0);
+    g_assert_true(saved_tag == -1);
+    ptr = wmem_alloc(allocator, 10);
+    wmem_alloc0(allocator, 20);
+    wmem_accounting_set_tag(1);
+    wmem_realloc(allocator, ptr, 40);
+    wmem_alloc(allocator, 0);
+    g_assert_true(wmem_accounting_set_tag(saved_tag) == 1);
+
+    memset(counts, 0, sizeof counts);
+    wmem_accounting_foreach(allocator, wmem_test_accounting_func, counts);
+    g_assert_true(counts[0] == 1 && counts[1] == 8);
+    g_assert_true(counts[2] == 2 && counts[3] == 30);
+    g_assert_true(counts[4] == 1 && counts[5] == 40);
+
+    /* The counts are of what the allocator holds */
+    wmem_free_all(allocator);
+    memset(counts, 0, sizeof counts);
+    wmem_accounting_foreach(allocator, wmem_test_accounting_func, counts);
+    g_assert_true(counts[0] == 0 && counts[2] == 0 && counts[4] == 0);
+
+    wmem_alloc(allocator, 8);
+    wmem_accounting_enable(allocator, FALSE);
+    memset(counts, 0, sizeof counts);
+    wmem_accounting_foreach(allocator, wmem_test_accounting_func, counts);
+    g_assert_true(counts[0] == 0);
+
+    wmem_accounting_enable(allocator, TRUE);
+    wmem_destroy_allocator(allocator);
+}
+
 static void
 wmem_test_allocator_det(wmem_allocator_t *allocator, wmem_verify_func verify,
         guint len)
@@ -369,6 +457,108 @@ wmem_test_allocator_strict(void)
     wmem_test_allocator_jumbo(WMEM_ALLOCATOR_STRICT, &wmem_strict_check_canaries);
 }
 
+/* SCOPE TESTING FUNCTIONS (/wmem/scopes/) */
+
+#define SCOPE_THREADS       8
+#define SCOPE_THREAD_ITERS  2000
+
+static wmem_allocator_t *scope_thread_packet_scopes[SCOPE_THREADS];
+
+static gpointer
+wmem_test_scopes_thread(gpointer data)
+{
+    guint32           id = GPOINTER_TO_UINT(data);
+    guint32         **file_bufs;
+    guint32          *buf;
+    wmem_allocator_t *packet_scope;
+    guint             i, j, len;
+
+    wmem_thread_init_scopes();
+    packet_scope = wmem_packet_scope();
+    scope_thread_packet_scopes[id] = packet_scope;
+
+    file_bufs = g_new0(guint32 *, SCOPE_THREAD_ITERS);
+
+    for (i = 0; i < SCOPE_THREAD_ITERS; i++) {
+        wmem_enter_packet_scope();
+        g_assert_true(wmem_packet_scope() == packet_scope);
+
+        len = g_random_int_range(1, 256);
+        buf = wmem_alloc_array(wmem_packet_scope(), guint32, len);
+        for (j = 0; j < len; j++) {
+            buf[j] = id;
+        }
+
+        /* allocate, grow and free in the shared file scope */
+        file_bufs[i] = wmem_alloc_array(wmem_file_scope(), guint32, 2);
+        file_bufs[i][0] = id;
+        file_bufs[i][1] = i;
+        if (i % 3 == 0) {
+            file_bufs[i] = (guint32 *)wmem_realloc(wmem_file_scope(), file_bufs[i], 64 * sizeof(guint32));
+        }
+        if (i % 5 == 0 && i > 0) {
+            wmem_free(wmem_file_scope(), file_bufs[i - 1]);
+            file_bufs[i - 1] = NULL;
+        }
+
+        for (j = 0; j < len; j++) {
+            g_assert_true(buf[j] == id);
+        }
+        wmem_leave_packet_scope();
+    }
+
+    for (i = 0; i < SCOPE_THREAD_ITERS; i++) {
+        if (file_bufs[i]) {
+            g_assert_true(file_bufs[i][0] == id);
+            g_assert_true(file_bufs[i][1] == i);
+        }
+    }
+
+    g_free(file_bufs);
+    wmem_thread_cleanup_scopes();
+
+    return NULL;
+}
+
+static void
+wmem_test_scopes_threads(void)
+{
+    GThread *threads[SCOPE_THREADS];
+    guint    i, j;
+
+    wmem_enter_file_scope();
+
+    g_assert_true(!wmem_threaded_scopes());
+    wmem_set_threaded_scopes(TRUE);
+    g_assert_true(wmem_threaded_scopes());
+
+    /* a thread that hasn't asked for its own packet scope (this one) still
+     * gets the usual one */
+    g_assert_true(wmem_packet_scope() == wmem_packet_scope());
+
+    for (i = 0; i < SCOPE_THREADS; i++) {
+        threads[i] = g_thread_new("wmem_test", wmem_test_scopes_thread, GUINT_TO_POINTER(i));
+    }
+    for (i = 0; i < SCOPE_THREADS; i++) {
+        g_thread_join(threads[i]);
+    }
+
+    for (i = 0; i < SCOPE_THREADS; i++) {
+        g_assert_true(scope_thread_packet_scopes[i] != NULL);
+        g_assert_true(scope_thread_packet_scopes[i] != wmem_packet_scope());
+        for (j = 0; j < i; j++) {
+            g_assert_true(scope_thread_packet_scopes[i] != scope_thread_packet_scopes[j]);
+        }
+    }
+
+    wmem_set_threaded_scopes(FALSE);
+    g_assert_true(!wmem_threaded_scopes());
+
+    /* the file scope still works, and is emptied as usual */
+    g_assert_true(wmem_alloc(wmem_file_scope(), 16) != NULL);
+    wmem_leave_file_scope();
+}
+
 /* UTILITY TESTING FUNCTIONS (/wmem/utils/) */
 
 static void
@@ -631,6 +821,45 @@ wmem_test_stringperf(void)
     g_free(str_ptr);
 }
 
+/* A packet pool: many small allocations, the odd big packet taking
+ * more than a block, and everything freed at once after each packet.
+ * NOTE: You have to run "wmem_test --verbose" to see results. */
+static void
+wmem_time_packet_pool(wmem_allocator_type_t type, const char *name)
+{
+#define PACKET_COUNT (20 * 1000)
+    wmem_allocator_t   *allocator;
+    GRand              *rand;
+    int                 i, j, allocs;
+    double              start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+
+    allocator = wmem_allocator_force_new(type);
+    /* the same packets for each allocator */
+    rand = g_rand_new_with_seed(0x5eed);
+
+    RESOURCE_USAGE_START;
+    for (i = 0; i < PACKET_COUNT; i++) {
+        allocs = (i % 64 == 0) ? 40000 : g_rand_int_range(rand, 100, 400);
+        for (j = 0; j < allocs; j++) {
+            memset(wmem_alloc(allocator, g_rand_int_range(rand, 8, 128)), 0, 8);
+        }
+        wmem_free_all(allocator);
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "%s packet pool: u %.3f ms s %.3f ms", name, utime_ms, stime_ms);
+
+    g_rand_free(rand);
+    wmem_destroy_allocator(allocator);
+}
+
+static void
+wmem_test_packetperf(void)
+{
+    wmem_time_packet_pool(WMEM_ALLOCATOR_BLOCK, "block");
+    wmem_time_packet_pool(WMEM_ALLOCATOR_BLOCK_FAST, "block_fast");
+}
+
 /* DATA STRUCTURE TESTING FUNCTIONS (/wmem/datastruct/) */
 
 static void
@@ -1011,6 +1240,207 @@ wmem_test_map(void)
     wmem_destroy_allocator(allocator);
 }
 
+static void
+wmem_test_flat_map(void)
+{
+    wmem_allocator_t   *allocator, *extra_allocator;
+    wmem_flat_map_t    *map;
+    gchar              *str_key;
+    const void         *str_key_ret;
+    unsigned int        i, j;
+    unsigned int       *key_ret;
+    unsigned int       *value_ret;
+    void               *ret;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
+    extra_allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
+
+    /* insertion, lookup and removal of simple integer keys */
+    map = wmem_flat_map_new(allocator, g_direct_hash, g_direct_equal);
+    g_assert_true(map);
+
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        ret = wmem_flat_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(777777));
+        g_assert_true(ret == NULL);
+        ret = wmem_flat_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(i));
+        g_assert_true(ret == GINT_TO_POINTER(777777));
+        ret = wmem_flat_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(i));
+        g_assert_true(ret == GINT_TO_POINTER(i));
+    }
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        ret = wmem_flat_map_lookup(map, GINT_TO_POINTER(i));
+        g_assert_true(ret == GINT_TO_POINTER(i));
+        g_assert_true(wmem_flat_map_contains(map, GINT_TO_POINTER(i)) == TRUE);
+        g_assert_true(wmem_flat_map_lookup_extended(map, GINT_TO_POINTER(i), NULL, NULL));
+        key_ret = NULL;
+        value_ret = NULL;
+        g_assert_true(wmem_flat_map_lookup_extended(map, GINT_TO_POINTER(i), GINT_TO_POINTER(&key_ret), GINT_TO_POINTER(&value_ret)));
+        g_assert_true(key_ret == GINT_TO_POINTER(i));
+        g_assert_true(value_ret == GINT_TO_POINTER(i));
+        ret = wmem_flat_map_remove(map, GINT_TO_POINTER(i));
+        g_assert_true(ret == GINT_TO_POINTER(i));
+        g_assert_true(wmem_flat_map_contains(map, GINT_TO_POINTER(i)) == FALSE);
+        ret = wmem_flat_map_lookup(map, GINT_TO_POINTER(i));
+        g_assert_true(ret == NULL);
+        ret = wmem_flat_map_remove(map, GINT_TO_POINTER(i));
+        g_assert_true(ret == NULL);
+        /* removing moves the others about; they must all still be found */
+        if ((i % 1000) == 0) {
+            for (j=i+1; j<CONTAINER_ITERS; j++) {
+                g_assert_true(wmem_flat_map_lookup(map, GINT_TO_POINTER(j)) == GINT_TO_POINTER(j));
+            }
+        }
+    }
+    g_assert_true(wmem_flat_map_size(map) == 0);
+    wmem_free_all(allocator);
+
+    /* interleaved insertion and stealing */
+    map = wmem_flat_map_new(allocator, g_direct_hash, g_direct_equal);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        wmem_flat_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(i));
+        if (i % 3 == 0) {
+            g_assert_true(wmem_flat_map_steal(map, GINT_TO_POINTER(i / 3)));
+        }
+    }
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        gboolean stolen = (i <= (CONTAINER_ITERS - 1) / 3);
+
+        g_assert_true(wmem_flat_map_contains(map, GINT_TO_POINTER(i)) == !stolen);
+        g_assert_true(wmem_flat_map_steal(map, GINT_TO_POINTER(i)) == !stolen);
+    }
+    g_assert_true(wmem_flat_map_size(map) == 0);
+    wmem_free_all(allocator);
+
+    /* test auto-reset functionality */
+    map = wmem_flat_map_new_autoreset(allocator, extra_allocator, g_direct_hash, g_direct_equal);
+    g_assert_true(map);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        ret = wmem_flat_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(777777));
+        g_assert_true(ret == NULL);
+        ret = wmem_flat_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(i));
+        g_assert_true(ret == GINT_TO_POINTER(777777));
+    }
+    wmem_free_all(extra_allocator);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_flat_map_lookup(map, GINT_TO_POINTER(i)) == NULL);
+    }
+    g_assert_true(wmem_flat_map_size(map) == 0);
+    wmem_free_all(allocator);
+
+    /* string keys */
+    map = wmem_flat_map_new(allocator, wmem_str_hash, g_str_equal);
+    g_assert_true(map);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        str_key = wmem_test_rand_string(allocator, 1, 64);
+        wmem_flat_map_insert(map, str_key, GINT_TO_POINTER(i));
+        ret = wmem_flat_map_lookup(map, str_key);
+        g_assert_true(ret == GINT_TO_POINTER(i));
+        str_key_ret = NULL;
+        value_ret = NULL;
+        g_assert_true(wmem_flat_map_lookup_extended(map, str_key, &str_key_ret, GINT_TO_POINTER(&value_ret)) == TRUE);
+        g_assert_true(g_str_equal(str_key_ret, str_key));
+        g_assert_true(value_ret == GINT_TO_POINTER(i));
+    }
+
+    /* test foreach and keys */
+    map = wmem_flat_map_new(allocator, g_direct_hash, g_direct_equal);
+    g_assert_true(map);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        wmem_flat_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(2));
+    }
+    wmem_flat_map_foreach(map, check_val_map, GINT_TO_POINTER(2));
+    g_assert_true(wmem_flat_map_size(map) == CONTAINER_ITERS);
+    g_assert_true(wmem_list_count(wmem_flat_map_get_keys(allocator, map)) == CONTAINER_ITERS);
+
+    wmem_destroy_allocator(extra_allocator);
+    wmem_destroy_allocator(allocator);
+}
+
+#define MAPPERF_KEYS (1000 * 1000)
+
+typedef struct {
+    guint32 addr1, addr2;
+    guint16 port1, port2;
+} mapperf_key_t;
+
+static guint
+mapperf_hash(gconstpointer key)
+{
+    return wmem_strong_hash((const guint8 *)key, sizeof(mapperf_key_t));
+}
+
+static gboolean
+mapperf_equal(gconstpointer a, gconstpointer b)
+{
+    return memcmp(a, b, sizeof(mapperf_key_t)) == 0;
+}
+
+/* Compare the chained and the open-addressing maps with keys like those of
+ * the conversation tables.
+ * NOTE: You have to run "wmem_test --verbose" to see results. */
+static void
+wmem_test_mapperf(void)
+{
+    wmem_allocator_t   *allocator;
+    wmem_map_t         *map;
+    wmem_flat_map_t    *flat_map;
+    mapperf_key_t      *keys = g_new0(mapperf_key_t, MAPPERF_KEYS);
+    guint               found = 0;
+    int                 n, i;
+    double              start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+
+    for (i = 0; i < MAPPERF_KEYS; i++) {
+        keys[i].addr1 = g_random_int();
+        keys[i].addr2 = g_random_int();
+        keys[i].port1 = (guint16)g_random_int();
+        keys[i].port2 = (guint16)g_random_int();
+    }
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK);
+
+    for (n = 1000; n <= MAPPERF_KEYS; n *= 10) {
+        map = wmem_map_new(allocator, mapperf_hash, mapperf_equal);
+        RESOURCE_USAGE_START;
+        for (i = 0; i < n; i++) {
+            wmem_map_insert(map, &keys[i], &keys[i]);
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "wmem_map insert %d keys: u %.3f ms s %.3f ms", n, utime_ms, stime_ms);
+
+        RESOURCE_USAGE_START;
+        for (i = 0; i < MAPPERF_KEYS; i++) {
+            found += wmem_map_lookup(map, &keys[(gint64)i * 7919 % n]) != NULL;
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "wmem_map %d lookups in %d keys: u %.3f ms s %.3f ms", MAPPERF_KEYS, n, utime_ms, stime_ms);
+
+        flat_map = wmem_flat_map_new(allocator, mapperf_hash, mapperf_equal);
+        RESOURCE_USAGE_START;
+        for (i = 0; i < n; i++) {
+            wmem_flat_map_insert(flat_map, &keys[i], &keys[i]);
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "wmem_flat_map insert %d keys: u %.3f ms s %.3f ms", n, utime_ms, stime_ms);
+
+        RESOURCE_USAGE_START;
+        for (i = 0; i < MAPPERF_KEYS; i++) {
+            found += wmem_flat_map_lookup(flat_map, &keys[(gint64)i * 7919 % n]) != NULL;
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "wmem_flat_map %d lookups in %d keys: u %.3f ms s %.3f ms", MAPPERF_KEYS, n, utime_ms, stime_ms);
+
+        wmem_free_all(allocator);
+    }
+    g_assert_true(found == 2 * 4 * MAPPERF_KEYS);
+
+    wmem_destroy_allocator(allocator);
+    g_free(keys);
+}
+
 static void
 wmem_test_queue(void)
 {
@@ -1331,6 +1761,155 @@ wmem_test_tree(void)
 }
 
 
+static gboolean
+wmem_test_flat_tree_order_cb(const void *key, void *value _U_, void *user_data)
+{
+    guint32 *last = (guint32 *)user_data;
+
+    g_assert_true(GPOINTER_TO_UINT(key) >= *last);
+    *last = GPOINTER_TO_UINT(key);
+
+    return FALSE;
+}
+
+static void
+wmem_test_flat_tree(void)
+{
+    wmem_allocator_t   *allocator, *extra_allocator;
+    wmem_flat_tree_t   *tree;
+    wmem_tree_t        *ref;
+    guint32             i, key, last;
+    int                 seen_values = 0;
+
+    allocator       = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
+    extra_allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
+
+    tree = wmem_flat_tree_new(allocator);
+    g_assert_true(tree);
+    g_assert_true(wmem_flat_tree_is_empty(tree));
+    g_assert_true(wmem_flat_tree_lookup32_le(tree, 0) == NULL);
+
+    /* test basic 32-bit key operations, with keys in increasing order */
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_flat_tree_lookup32(tree, i*2) == NULL);
+        if (i > 0) {
+            g_assert_true(wmem_flat_tree_lookup32_le(tree, i*2) == GINT_TO_POINTER(i-1));
+            g_assert_true(wmem_flat_tree_lookup32_le(tree, i*2-1) == GINT_TO_POINTER(i-1));
+        }
+        wmem_flat_tree_insert32(tree, i*2, GINT_TO_POINTER(i));
+        g_assert_true(wmem_flat_tree_lookup32(tree, i*2) == GINT_TO_POINTER(i));
+        g_assert_true(!wmem_flat_tree_is_empty(tree));
+    }
+    g_assert_true(wmem_flat_tree_count(tree) == CONTAINER_ITERS);
+
+    /* fill in the gaps, which splits every leaf */
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        wmem_flat_tree_insert32(tree, i*2+1, GINT_TO_POINTER(i));
+    }
+    g_assert_true(wmem_flat_tree_count(tree) == 2*CONTAINER_ITERS);
+    for (i=0; i<2*CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_flat_tree_lookup32(tree, i) == GINT_TO_POINTER(i/2));
+    }
+
+    /* overwrite a value */
+    wmem_flat_tree_insert32(tree, 0, GINT_TO_POINTER(42));
+    g_assert_true(wmem_flat_tree_lookup32(tree, 0) == GINT_TO_POINTER(42));
+    g_assert_true(wmem_flat_tree_count(tree) == 2*CONTAINER_ITERS);
+
+    /* remove the even keys; the odd ones are then found by lookup32_le */
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_flat_tree_remove32(tree, i*2) == GINT_TO_POINTER(i ? i : 42));
+        g_assert_true(wmem_flat_tree_remove32(tree, i*2) == NULL);
+    }
+    g_assert_true(wmem_flat_tree_count(tree) == CONTAINER_ITERS);
+    g_assert_true(wmem_flat_tree_lookup32_le(tree, 0) == NULL);
+    for (i=1; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_flat_tree_lookup32(tree, i*2) == NULL);
+        g_assert_true(wmem_flat_tree_lookup32_le(tree, i*2) == GINT_TO_POINTER(i-1));
+    }
+    wmem_free_all(allocator);
+
+    /* random keys give the same results as the red/black tree */
+    tree = wmem_flat_tree_new(allocator);
+    ref  = wmem_tree_new(allocator);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        key = g_test_rand_int();
+        wmem_flat_tree_insert32(tree, key, GINT_TO_POINTER(i));
+        wmem_tree_insert32(ref, key, GINT_TO_POINTER(i));
+    }
+    g_assert_true(wmem_flat_tree_count(tree) == wmem_tree_count(ref));
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        key = g_test_rand_int();
+        g_assert_true(wmem_flat_tree_lookup32(tree, key) == wmem_tree_lookup32(ref, key));
+        g_assert_true(wmem_flat_tree_lookup32_le(tree, key) == wmem_tree_lookup32_le(ref, key));
+    }
+    last = 0;
+    g_assert_true(!wmem_flat_tree_foreach(tree, wmem_test_flat_tree_order_cb, &last));
+    wmem_free_all(allocator);
+
+    /* a tree in the manual scope can be destroyed explicitly */
+    tree = wmem_flat_tree_new(NULL);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        wmem_flat_tree_insert32(tree, CONTAINER_ITERS-i, GINT_TO_POINTER(i));
+    }
+    g_assert_true(wmem_flat_tree_count(tree) == CONTAINER_ITERS);
+    wmem_flat_tree_destroy(tree);
+
+    /* test auto-reset functionality */
+    tree = wmem_flat_tree_new_autoreset(allocator, extra_allocator);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_flat_tree_lookup32(tree, i) == NULL);
+        wmem_flat_tree_insert32(tree, i, GINT_TO_POINTER(i));
+        g_assert_true(wmem_flat_tree_lookup32(tree, i) == GINT_TO_POINTER(i));
+    }
+    g_assert_true(wmem_flat_tree_count(tree) == CONTAINER_ITERS);
+    wmem_free_all(extra_allocator);
+    g_assert_true(wmem_flat_tree_count(tree) == 0);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_flat_tree_lookup32(tree, i) == NULL);
+        g_assert_true(wmem_flat_tree_lookup32_le(tree, i) == NULL);
+    }
+    wmem_free_all(allocator);
+
+    /* test for-each functionality */
+    tree = wmem_flat_tree_new(allocator);
+    expected_user_data = GINT_TO_POINTER(g_test_rand_int());
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        do {
+            key = g_test_rand_int();
+        } while (wmem_flat_tree_lookup32(tree, key));
+        value_seen[i] = FALSE;
+        wmem_flat_tree_insert32(tree, key, GINT_TO_POINTER(i));
+    }
+
+    cb_called_count    = 0;
+    cb_continue_count  = CONTAINER_ITERS;
+    wmem_flat_tree_foreach(tree, wmem_test_foreach_cb, expected_user_data);
+    g_assert_true(cb_called_count   == CONTAINER_ITERS);
+    g_assert_true(cb_continue_count == 0);
+
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert_true(value_seen[i]);
+        value_seen[i] = FALSE;
+    }
+
+    cb_called_count    = 0;
+    cb_continue_count  = 10;
+    g_assert_true(wmem_flat_tree_foreach(tree, wmem_test_foreach_cb, expected_user_data));
+    g_assert_true(cb_called_count   == 10);
+    g_assert_true(cb_continue_count == 0);
+
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        if (value_seen[i]) {
+            seen_values++;
+        }
+    }
+    g_assert_true(seen_values == 10);
+
+    wmem_destroy_allocator(extra_allocator);
+    wmem_destroy_allocator(allocator);
+}
+
 /* to be used as userdata in the callback wmem_test_itree_check_overlap_cb*/
 typedef struct wmem_test_itree_user_data {
     wmem_range_t range;
@@ -1447,17 +2026,25 @@ main(int argc, char **argv)
     g_test_add_func("/wmem/allocator/simple",    wmem_test_allocator_simple);
     g_test_add_func("/wmem/allocator/strict",    wmem_test_allocator_strict);
     g_test_add_func("/wmem/allocator/callbacks", wmem_test_allocator_callbacks);
+    g_test_add_func("/wmem/allocator/alloc_count", wmem_test_allocator_alloc_count);
+    g_test_add_func("/wmem/allocator/accounting", wmem_test_allocator_accounting);
+
+    g_test_add_func("/wmem/scopes/threads", wmem_test_scopes_threads);
 
     g_test_add_func("/wmem/utils/misc",    wmem_test_miscutls);
     g_test_add_func("/wmem/utils/strings", wmem_test_strutls);
 
     if (!g_test_perf ()) {
         g_test_add_func("/wmem/utils/stringperf", wmem_test_stringperf);
+        g_test_add_func("/wmem/datastruct/mapperf", wmem_test_mapperf);
+        g_test_add_func("/wmem/allocator/packetperf", wmem_test_packetperf);
     }
 
     g_test_add_func("/wmem/datastruct/array",  wmem_test_array);
     g_test_add_func("/wmem/datastruct/list",   wmem_test_list);
     g_test_add_func("/wmem/datastruct/map",    wmem_test_map);
+    g_test_add_func("/wmem/datastruct/flatmap", wmem_test_flat_map);
+    g_test_add_func("/wmem/datastruct/flattree", wmem_test_flat_tree);
     g_test_add_func("/wmem/datastruct/queue",  wmem_test_queue);
     g_test_add_func("/wmem/datastruct/stack",  wmem_test_stack);
     g_test_add_func("/wmem/datastruct/strbuf", wmem_test_strbuf);
@@ -124,10 +124,16 @@ static expert_field ei_lua_proto_deprecated_note    = EI_INIT;
 static expert_field ei_lua_proto_deprecated_warn    = EI_INIT;
 static expert_field ei_lua_proto_deprecated_error   = EI_INIT;
 
+/* The packet scope lua_pinfo_end() is registered with, so that it is
+ * registered once per packet rather than once per call of a Lua dissector. */
+static wmem_allocator_t *lua_pinfo_end_pool = NULL;
+
 static gboolean
 lua_pinfo_end(wmem_allocator_t *allocator _U_, wmem_cb_event_t event _U_,
         void *user_data _U_)
 {
+    lua_pinfo_end_pool = NULL;
+
     clear_outstanding_Tvb();
     clear_outstanding_TvbRange();
     clear_outstanding_Pinfo();
@@ -199,7 +205,10 @@ int dissect_lua(tvbuff_t* tvb, packet_info* pinfo, proto_tree* tree, void* data
                     "Lua Error: did not find the %s dissector in the dissectors table", pinfo->current_proto);
     }
 
-    wmem_register_callback(pinfo->pool, lua_pinfo_end, NULL);
+    if (lua_pinfo_end_pool != pinfo->pool) {
+        wmem_register_callback(pinfo->pool, lua_pinfo_end, NULL);
+        lua_pinfo_end_pool = pinfo->pool;
+    }
 
     lua_pinfo = saved_lua_pinfo;
     lua_tree = saved_lua_tree;
@@ -297,7 +306,10 @@ gboolean heur_dissect_lua(tvbuff_t* tvb, packet_info* pinfo, proto_tree* tree, v
         lua_pop(L, 1);
     }
 
-    wmem_register_callback(pinfo->pool, lua_pinfo_end, NULL);
+    if (lua_pinfo_end_pool != pinfo->pool) {
+        wmem_register_callback(pinfo->pool, lua_pinfo_end, NULL);
+        lua_pinfo_end_pool = pinfo->pool;
+    }
 
     lua_pinfo = saved_lua_pinfo;
     lua_tree = saved_lua_tree;
@@ -241,6 +241,12 @@ struct _wslua_tap {
     int draw_ref;
     int reset_ref;
     gboolean all_fields;
+    int packets_ref;
+    GPtrArray* batch_fields;    /* the Fields whose values are batched, or NULL */
+    int batch_fields_ref;
+    int batch_ref;              /* the values of the packets batched so far */
+    guint batch_size;
+    guint batch_count;
 };
 
 /* a "File" object can be different things under the hood. It can either
@@ -784,6 +790,7 @@ extern TreeItem push_TreeItem(lua_State *L, proto_tree *tree, proto_item *item);
 extern void clear_outstanding_TreeItem(void);
 
 extern FieldInfo* push_FieldInfo(lua_State *L, field_info* f);
+extern int push_FieldInfo_value(lua_State* L, field_info* fi);
 extern void clear_outstanding_FieldInfo(void);
 
 extern void wslua_print_stack(char* s, lua_State* L);
@@ -308,6 +308,138 @@ WSLUA_METHOD ByteArray_raw(lua_State* L) {
     WSLUA_RETURN(1); /* A Lua string of the binary bytes in the ByteArray. */
 }
 
+/*
+ * Common code for the integer getters, so that a file reader can parse the
+ * fields of many records out of one block read with File:read_bytearray()
+ * without making a Lua string or a Tvb of each of them.
+ */
+static guint64 ByteArray_get_uint_common(lua_State* L, guint max_len, gboolean little_endian, gboolean is_signed) {
+    ByteArray ba = checkByteArray(L,1);
+    lua_Integer offset = luaL_checkinteger(L,2);
+    lua_Integer len = luaL_optinteger(L,3,max_len);
+    guint64 value = 0;
+    guint i;
+
+    if (len < 1 || len > (lua_Integer)max_len) {
+        luaL_argerror(L,3,"bad length");
+        return 0;
+    }
+
+    if (offset < 0 || (guint64)offset + (guint64)len > ba->len) {
+        luaL_argerror(L,2,"out of bounds");
+        return 0;
+    }
+
+    for (i = 0; i < (guint)len; i++) {
+        if (little_endian)
+            value |= (guint64)ba->data[offset + i] << (8 * i);
+        else
+            value = (value << 8) | ba->data[offset + i];
+    }
+
+    /* Sign-extend */
+    if (is_signed && len < 8 && (value & (G_GUINT64_CONSTANT(1) << (8 * len - 1))))
+        value |= G_GUINT64_CONSTANT(0xFFFFFFFFFFFFFFFF) << (8 * len);
+
+    return value;
+}
+
+WSLUA_METHOD ByteArray_uint(lua_State* L) {
+    /* Read a big endian encoded unsigned integer in a <<lua_class_ByteArray,`ByteArray`>>.
+
+       @since 3.5.0
+     */
+#define WSLUA_ARG_ByteArray_uint_OFFSET 2 /* The position of the first byte (0=first). */
+#define WSLUA_OPTARG_ByteArray_uint_LENGTH 3 /* The length of the integer, 1 to 4 (default=4). */
+    lua_pushnumber(L,(lua_Number)ByteArray_get_uint_common(L,4,FALSE,FALSE));
+
+    WSLUA_RETURN(1); /* The value of the integer. */
+}
+
+WSLUA_METHOD ByteArray_le_uint(lua_State* L) {
+    /* Read a little endian encoded unsigned integer in a <<lua_class_ByteArray,`ByteArray`>>.
+
+       @since 3.5.0
+     */
+#define WSLUA_ARG_ByteArray_le_uint_OFFSET 2 /* The position of the first byte (0=first). */
+#define WSLUA_OPTARG_ByteArray_le_uint_LENGTH 3 /* The length of the integer, 1 to 4 (default=4). */
+    lua_pushnumber(L,(lua_Number)ByteArray_get_uint_common(L,4,TRUE,FALSE));
+
+    WSLUA_RETURN(1); /* The value of the integer. */
+}
+
+WSLUA_METHOD ByteArray_int(lua_State* L) {
+    /* Read a big endian encoded signed integer in a <<lua_class_ByteArray,`ByteArray`>>.
+
+       @since 3.5.0
+     */
+#define WSLUA_ARG_ByteArray_int_OFFSET 2 /* The position of the first byte (0=first). */
+#define WSLUA_OPTARG_ByteArray_int_LENGTH 3 /* The length of the integer, 1 to 4 (default=4). */
+    lua_pushnumber(L,(lua_Number)(gint64)ByteArray_get_uint_common(L,4,FALSE,TRUE));
+
+    WSLUA_RETURN(1); /* The value of the integer. */
+}
+
+WSLUA_METHOD ByteArray_le_int(lua_State* L) {
+    /* Read a little endian encoded signed integer in a <<lua_class_ByteArray,`ByteArray`>>.
+
+       @since 3.5.0
+     */
+#define WSLUA_ARG_ByteArray_le_int_OFFSET 2 /* The position of the first byte (0=first). */
+#define WSLUA_OPTARG_ByteArray_le_int_LENGTH 3 /* The length of the integer, 1 to 4 (default=4). */
+    lua_pushnumber(L,(lua_Number)(gint64)ByteArray_get_uint_common(L,4,TRUE,TRUE));
+
+    WSLUA_RETURN(1); /* The value of the integer. */
+}
+
+WSLUA_METHOD ByteArray_uint64(lua_State* L) {
+    /* Read a big endian encoded 64 bit unsigned integer in a <<lua_class_ByteArray,`ByteArray`>>.
+
+       @since 3.5.0
+     */
+#define WSLUA_ARG_ByteArray_uint64_OFFSET 2 /* The position of the first byte (0=first). */
+#define WSLUA_OPTARG_ByteArray_uint64_LENGTH 3 /* The length of the integer, 1 to 8 (default=8). */
+    pushUInt64(L,ByteArray_get_uint_common(L,8,FALSE,FALSE));
+
+    WSLUA_RETURN(1); /* The <<lua_class_UInt64,`UInt64`>> value of the integer. */
+}
+
+WSLUA_METHOD ByteArray_le_uint64(lua_State* L) {
+    /* Read a little endian encoded 64 bit unsigned integer in a <<lua_class_ByteArray,`ByteArray`>>.
+
+       @since 3.5.0
+     */
+#define WSLUA_ARG_ByteArray_le_uint64_OFFSET 2 /* The position of the first byte (0=first). */
+#define WSLUA_OPTARG_ByteArray_le_uint64_LENGTH 3 /* The length of the integer, 1 to 8 (default=8). */
+    pushUInt64(L,ByteArray_get_uint_common(L,8,TRUE,FALSE));
+
+    WSLUA_RETURN(1); /* The <<lua_class_UInt64,`UInt64`>> value of the integer. */
+}
+
+WSLUA_METHOD ByteArray_int64(lua_State* L) {
+    /* Read a big endian encoded 64 bit signed integer in a <<lua_class_ByteArray,`ByteArray`>>.
+
+       @since 3.5.0
+     */
+#define WSLUA_ARG_ByteArray_int64_OFFSET 2 /* The position of the first byte (0=first). */
+#define WSLUA_OPTARG_ByteArray_int64_LENGTH 3 /* The length of the integer, 1 to 8 (default=8). */
+    pushInt64(L,(gint64)ByteArray_get_uint_common(L,8,FALSE,TRUE));
+
+    WSLUA_RETURN(1); /* The <<lua_class_Int64,`Int64`>> value of the integer. */
+}
+
+WSLUA_METHOD ByteArray_le_int64(lua_State* L) {
+    /* Read a little endian encoded 64 bit signed integer in a <<lua_class_ByteArray,`ByteArray`>>.
+
+       @since 3.5.0
+     */
+#define WSLUA_ARG_ByteArray_le_int64_OFFSET 2 /* The position of the first byte (0=first). */
+#define WSLUA_OPTARG_ByteArray_le_int64_LENGTH 3 /* The length of the integer, 1 to 8 (default=8). */
+    pushInt64(L,(gint64)ByteArray_get_uint_common(L,8,TRUE,TRUE));
+
+    WSLUA_RETURN(1); /* The <<lua_class_Int64,`Int64`>> value of the integer. */
+}
+
 WSLUA_METHOD ByteArray_tohex(lua_State* L) {
     /* Obtain a Lua string of the bytes in a <<lua_class_ByteArray,`ByteArray`>> as hex-ascii, with given separator
 
@@ -398,6 +530,14 @@ WSLUA_METHODS ByteArray_methods[] = {
     WSLUA_CLASS_FNREG(ByteArray,set_index),
     WSLUA_CLASS_FNREG(ByteArray,tohex),
     WSLUA_CLASS_FNREG(ByteArray,raw),
+    WSLUA_CLASS_FNREG(ByteArray,uint),
+    WSLUA_CLASS_FNREG(ByteArray,le_uint),
+    WSLUA_CLASS_FNREG(ByteArray,int),
+    WSLUA_CLASS_FNREG(ByteArray,le_int),
+    WSLUA_CLASS_FNREG(ByteArray,uint64),
+    WSLUA_CLASS_FNREG(ByteArray,le_uint64),
+    WSLUA_CLASS_FNREG(ByteArray,int64),
+    WSLUA_CLASS_FNREG(ByteArray,le_int64),
     { NULL, NULL }
 };
 
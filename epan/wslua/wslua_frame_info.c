@@ -133,7 +133,8 @@ static int FrameInfo_get_time (lua_State* L) {
     return 1; /* An NSTime object of the frame's timestamp. */
 }
 
-/* WSLUA_ATTRIBUTE FrameInfo_data RW The data buffer containing the packet.
+/* WSLUA_ATTRIBUTE FrameInfo_data RW The data buffer containing the packet, set from a
+   Lua string or, since 3.5.0, a <<lua_class_ByteArray,`ByteArray`>>.
 
    [NOTE]
    ====
@@ -163,8 +164,17 @@ static int FrameInfo_set_data (lua_State* L) {
         fi->rec->rec_header.packet_header.caplen = (guint32) len;
         fi->rec->rec_header.packet_header.len = (guint32) len;
     }
+    else if (isByteArray(L,2)) {
+        /* Saves a file reader the Lua string of each record it parses out of a block */
+        ByteArray ba = toByteArray(L,2);
+
+        ws_buffer_assure_space(fi->buf, ba->len);
+        memcpy(ws_buffer_start_ptr(fi->buf), ba->data, ba->len);
+        fi->rec->rec_header.packet_header.caplen = (guint32) ba->len;
+        fi->rec->rec_header.packet_header.len = (guint32) ba->len;
+    }
     else
-        luaL_error(L, "FrameInfo's attribute 'data' must be a Lua string");
+        luaL_error(L, "FrameInfo's attribute 'data' must be a Lua string or a ByteArray");
 
     return 0;
 }
@@ -67,11 +67,146 @@ static int tap_packet_cb_error_handler(lua_State* L) {
 }
 
 
+/* Lua 5.1 used lua_objlen() instead of lua_rawlen() */
+#if LUA_VERSION_NUM == 501
+#define lua_rawlen lua_objlen
+#endif
+
+#define LISTENER_DEFAULT_BATCH_SIZE 1000
+
+/* Start a new batch: a table with an array for every batched field. */
+static void lua_tap_new_batch(Listener tap) {
+    guint i;
+
+    if (tap->batch_ref != LUA_NOREF)
+        luaL_unref(tap->L, LUA_REGISTRYINDEX, tap->batch_ref);
+
+    lua_createtable(tap->L, tap->batch_fields->len, 0);
+    for (i = 0; i < tap->batch_fields->len; i++) {
+        lua_createtable(tap->L, (int)MIN(tap->batch_size, 65536), 0);
+        lua_rawseti(tap->L, -2, i + 1);
+    }
+    tap->batch_ref = luaL_ref(tap->L, LUA_REGISTRYINDEX);
+    tap->batch_count = 0;
+}
+
+/* Add the values of the batched fields in a packet (as light userdata, with
+ * its tree) to the current batch; called through lua_pcall(), as getting the
+ * value of a field can raise an error. */
+static int lua_tap_batch_packet(lua_State* L) {
+    Listener tap = (Listener)lua_touserdata(L,1);
+    proto_tree* tree = (proto_tree*)lua_touserdata(L,2);
+    int row = (int)tap->batch_count + 1;
+    guint i;
+
+    lua_rawgeti(L, LUA_REGISTRYINDEX, tap->batch_ref);
+
+    for (i = 0; i < tap->batch_fields->len; i++) {
+        Field f = (Field)g_ptr_array_index(tap->batch_fields, i);
+        header_field_info* hfi = f->hfi;
+        field_info* fi = NULL;
+
+        /* the first occurrence of the field, looking at fields of the same
+         * name as Field__call() does */
+        while (tree && hfi && !fi) {
+            GPtrArray* found = proto_get_finfo_ptr_array(tree, hfi->id);
+            if (found && found->len > 0)
+                fi = (field_info*)g_ptr_array_index(found, 0);
+            hfi = (hfi->same_name_prev_id != -1) ? proto_registrar_get_nth(hfi->same_name_prev_id) : NULL;
+        }
+
+        /* a packet without the field leaves a nil in its array */
+        if (fi) {
+            lua_rawgeti(L, -1, i + 1);
+            if (push_FieldInfo_value(L, fi) > 0)
+                lua_rawseti(L, -2, row);
+            lua_pop(L, 1);
+        }
+    }
+
+    lua_pop(L, 1);
+    return 0;
+}
+
+/* Give the current batch, if it's not empty, to the packets function. */
+static tap_packet_status lua_tap_flush_batch(Listener tap) {
+    tap_packet_status retval = TAP_PACKET_DONT_REDRAW;
+
+    if (tap->batch_count == 0) return TAP_PACKET_DONT_REDRAW;
+
+    lua_settop(tap->L,0);
+    lua_pushcfunction(tap->L,tap_packet_cb_error_handler);
+    lua_rawgeti(tap->L, LUA_REGISTRYINDEX, tap->packets_ref);
+    lua_rawgeti(tap->L, LUA_REGISTRYINDEX, tap->batch_ref);
+    lua_pushinteger(tap->L, (lua_Integer)tap->batch_count);
+
+    switch ( lua_pcall(tap->L,2,1,1) ) {
+        case 0:
+            retval = luaL_optinteger(tap->L,-1,1) == 0 ? TAP_PACKET_DONT_REDRAW : TAP_PACKET_REDRAW;
+            break;
+        case LUA_ERRRUN:
+            break;
+        case LUA_ERRMEM:
+            g_warning("Memory alloc error while calling listener tap callback packets");
+            break;
+        case LUA_ERRERR:
+            g_warning("Error while running the error handler function for listener tap callback");
+            break;
+        default:
+            g_assert_not_reached();
+            break;
+    }
+
+    lua_settop(tap->L,0);
+    lua_tap_new_batch(tap);
+
+    return retval;
+}
+
+static tap_packet_status lua_tap_batch(Listener tap, packet_info *pinfo, epan_dissect_t *edt) {
+    tap_packet_status retval = TAP_PACKET_DONT_REDRAW;
+
+    lua_settop(tap->L,0);
+    lua_pushcfunction(tap->L,tap_packet_cb_error_handler);
+    lua_pushcfunction(tap->L,lua_tap_batch_packet);
+    lua_pushlightuserdata(tap->L,tap);
+    lua_pushlightuserdata(tap->L,edt->tree);
+
+    lua_pinfo = pinfo;
+
+    switch ( lua_pcall(tap->L,2,0,1) ) {
+        case 0:
+            if (++tap->batch_count >= tap->batch_size)
+                retval = lua_tap_flush_batch(tap);
+            break;
+        case LUA_ERRRUN:
+            break;
+        case LUA_ERRMEM:
+            g_warning("Memory alloc error while batching the fields of a listener");
+            break;
+        case LUA_ERRERR:
+            g_warning("Error while running the error handler function for listener tap callback");
+            break;
+        default:
+            g_assert_not_reached();
+            break;
+    }
+
+    clear_outstanding_FieldInfo();
+
+    lua_pinfo = NULL;
+
+    return retval;
+}
+
 static tap_packet_status lua_tap_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const void *data) {
     Listener tap = (Listener)tapdata;
     tap_packet_status retval = TAP_PACKET_DONT_REDRAW;
     TreeItem lua_tree_tap;
 
+    if (tap->batch_fields && tap->packets_ref != LUA_NOREF)
+        return lua_tap_batch(tap, pinfo, edt);
+
     if (tap->packet_ref == LUA_NOREF) return TAP_PACKET_DONT_REDRAW; /* XXX - report error and return TAP_PACKET_FAILED? */
 
     lua_settop(tap->L,0);
@@ -132,6 +267,10 @@ static int tap_reset_cb_error_handler(lua_State* L) {
 static void lua_tap_reset(void *tapdata) {
     Listener tap = (Listener)tapdata;
 
+    /* the packets of a batch not given yet are dropped */
+    if (tap->batch_fields)
+        lua_tap_new_batch(tap);
+
     if (tap->reset_ref == LUA_NOREF) return;
 
     lua_pushcfunction(tap->L,tap_reset_cb_error_handler);
@@ -165,6 +304,10 @@ static void lua_tap_draw(void *tapdata) {
     Listener tap = (Listener)tapdata;
     const gchar* error;
 
+    /* so that what is drawn includes every packet seen */
+    if (tap->batch_fields && tap->packets_ref != LUA_NOREF)
+        lua_tap_flush_batch(tap);
+
     if (tap->draw_ref == LUA_NOREF) return;
 
     lua_pushcfunction(tap->L,tap_draw_cb_error_handler);
@@ -193,7 +336,7 @@ static void lua_tap_draw(void *tapdata) {
 /* TODO: we should probably use a Lua table here */
 static GPtrArray *listeners = NULL;
 
-static void deregister_Listener (lua_State* L _U_, Listener tap) {
+static void deregister_Listener (lua_State* L, Listener tap) {
     if (tap->all_fields) {
         epan_set_always_visible(FALSE);
         tap->all_fields = FALSE;
@@ -201,6 +344,12 @@ static void deregister_Listener (lua_State* L _U_, Listener tap) {
 
     remove_tap_listener(tap);
 
+    if (tap->batch_fields) {
+        luaL_unref(L, LUA_REGISTRYINDEX, tap->batch_fields_ref);
+        luaL_unref(L, LUA_REGISTRYINDEX, tap->batch_ref);
+        g_ptr_array_free(tap->batch_fields, TRUE);
+    }
+
     g_free(tap->filter);
     g_free(tap->name);
     g_free(tap);
@@ -236,6 +385,12 @@ WSLUA_CONSTRUCTOR Listener_new(lua_State* L) {
     tap->draw_ref = LUA_NOREF;
     tap->reset_ref = LUA_NOREF;
     tap->all_fields = all_fields;
+    tap->packets_ref = LUA_NOREF;
+    tap->batch_fields = NULL;
+    tap->batch_fields_ref = LUA_NOREF;
+    tap->batch_ref = LUA_NOREF;
+    tap->batch_size = 0;
+    tap->batch_count = 0;
 
     /*
      * XXX - do all Lua taps require the protocol tree?  If not, it might
@@ -320,6 +475,82 @@ WSLUA_METHOD Listener_remove(lua_State* L) {
     return 0;
 }
 
+WSLUA_METHOD Listener_batch(lua_State* L) {
+    /*
+    Delivers the values of some fields to the `packets` function, a batch of packets at a time,
+    instead of calling the `packet` function for every packet.
+
+    Setting the `packets` function is what makes a `Listener` batch its packets;
+    the batch in hand is also given to it before `draw` is called.
+
+    @since 3.5.0
+
+    ===== Example
+
+    [source,lua]
+    ----
+    local ip_len = Field.new("ip.len")
+    local tap = Listener.new("ip")
+    local bytes = 0
+
+    tap:batch({ ip_len }, 10000)
+
+    function tap.packets(values, count)
+        local lens = values[1]
+        for i = 1, count do
+            bytes = bytes + (lens[i] or 0)
+        end
+    end
+    ----
+    */
+#define WSLUA_ARG_Listener_batch_FIELDS 2 /* An array table of <<lua_class_Field,`Field`>>s, whose values are batched. */
+#define WSLUA_OPTARG_Listener_batch_SIZE 3 /* The number of packets in a batch. The default is 1000. */
+    Listener tap = checkListener(L,1);
+    lua_Integer size = luaL_optinteger(L,WSLUA_OPTARG_Listener_batch_SIZE,LISTENER_DEFAULT_BATCH_SIZE);
+    GPtrArray* fields;
+    int n, i;
+
+    luaL_checktype(L,WSLUA_ARG_Listener_batch_FIELDS,LUA_TTABLE);
+
+    if (size < 1 || size > G_MAXINT) {
+        WSLUA_OPTARG_ERROR(Listener_batch,SIZE,"must be a positive number");
+        return 0;
+    }
+
+    n = (int)lua_rawlen(L,WSLUA_ARG_Listener_batch_FIELDS);
+    if (n == 0) {
+        WSLUA_ARG_ERROR(Listener_batch,FIELDS,"must hold at least one Field");
+        return 0;
+    }
+
+    fields = g_ptr_array_sized_new(n);
+    for (i = 1; i <= n; i++) {
+        lua_rawgeti(L,WSLUA_ARG_Listener_batch_FIELDS,i);
+        if (!isField(L,-1)) {
+            g_ptr_array_free(fields,TRUE);
+            WSLUA_ARG_ERROR(Listener_batch,FIELDS,"must hold only Fields");
+            return 0;
+        }
+        g_ptr_array_add(fields,toField(L,-1));
+        lua_pop(L,1);
+    }
+
+    if (tap->batch_fields) {
+        luaL_unref(L, LUA_REGISTRYINDEX, tap->batch_fields_ref);
+        g_ptr_array_free(tap->batch_fields, TRUE);
+    }
+
+    /* keep the Fields from being collected */
+    lua_pushvalue(L,WSLUA_ARG_Listener_batch_FIELDS);
+    tap->batch_fields_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    tap->batch_fields = fields;
+    tap->batch_size = (guint)size;
+
+    lua_tap_new_batch(tap);
+
+    return 0;
+}
+
 WSLUA_METAMETHOD Listener__tostring(lua_State* L) {
     /* Generates a string of debug info for the tap `Listener`. */
     Listener tap = checkListener(L,1);
@@ -351,6 +582,24 @@ WSLUA_METAMETHOD Listener__tostring(lua_State* L) {
 WSLUA_ATTRIBUTE_FUNC_SETTER(Listener,packet);
 
 
+/* WSLUA_ATTRIBUTE Listener_packets WO A function that will be given the values of the fields set with
+    `Listener:batch()`, once every batch of packets.
+
+    When later called by Wireshark, the `packets` function will be given:
+      1. A table with an array for every field, in the order they were given to `Listener:batch()`,
+         holding the value of the field's first occurrence in every packet of the batch, or nil
+      2. The number of packets in the batch
+
+    [source,lua]
+    ----
+    function tap.packets(values,count) ... end
+    ----
+
+    @since 3.5.0
+*/
+WSLUA_ATTRIBUTE_FUNC_SETTER(Listener,packets);
+
+
 /* WSLUA_ATTRIBUTE Listener_draw WO A function that will be called once every few seconds to redraw the GUI objects;
             in Tshark this funtion is called only at the very end of the capture file.
 
@@ -386,6 +635,7 @@ static int Listener__gc(lua_State* L _U_) {
  */
 WSLUA_ATTRIBUTES Listener_attributes[] = {
     WSLUA_ATTRIBUTE_WOREG(Listener,packet),
+    WSLUA_ATTRIBUTE_WOREG(Listener,packets),
     WSLUA_ATTRIBUTE_WOREG(Listener,draw),
     WSLUA_ATTRIBUTE_WOREG(Listener,reset),
     { NULL, NULL, NULL }
@@ -394,6 +644,7 @@ WSLUA_ATTRIBUTES Listener_attributes[] = {
 WSLUA_METHODS Listener_methods[] = {
     WSLUA_CLASS_FNREG(Listener,new),
     WSLUA_CLASS_FNREG(Listener,remove),
+    WSLUA_CLASS_FNREG(Listener,batch),
     WSLUA_CLASS_FNREG(Listener,list),
     { NULL, NULL }
 };
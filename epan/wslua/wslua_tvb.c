@@ -331,14 +331,23 @@ WSLUA_CLASS_DEFINE(TvbRange,FAIL_ON_NULL("TvbRange"));
     If the <<lua_class_TvbRange,`TvbRange`>> span is outside the <<lua_class_Tvb,`Tvb`>>'s range the creation will cause a runtime error.
     */
 
+/*
+ * A TvbRange pushed into Lua is allocated in one block with the Tvb it
+ * refers to, as the two are always freed together; a dissector creates
+ * many of them for every packet.
+ */
+typedef struct {
+    struct _wslua_tvbrange range;
+    struct _wslua_tvb tvb;
+} tvbrange_block_t;
+
 static void free_TvbRange(TvbRange tvbr) {
     if (!(tvbr && tvbr->tvb)) return;
 
     if (!tvbr->tvb->expired) {
         tvbr->tvb->expired = TRUE;
     } else {
-        free_Tvb(tvbr->tvb);
-        g_free(tvbr);
+        g_slice_free(tvbrange_block_t, (tvbrange_block_t *)tvbr);
     }
 }
 
@@ -351,6 +360,7 @@ void clear_outstanding_TvbRange(void) {
 
 
 gboolean push_TvbRange(lua_State* L, tvbuff_t* ws_tvb, int offset, int len) {
+    tvbrange_block_t *block;
     TvbRange tvbr;
 
     if (!ws_tvb) {
@@ -369,8 +379,9 @@ gboolean push_TvbRange(lua_State* L, tvbuff_t* ws_tvb, int offset, int len) {
         return FALSE;
     }
 
-    tvbr = (TvbRange)g_malloc(sizeof(struct _wslua_tvbrange));
-    tvbr->tvb = (Tvb)g_malloc(sizeof(struct _wslua_tvb));
+    block = g_slice_new(tvbrange_block_t);
+    tvbr = &block->range;
+    tvbr->tvb = &block->tvb;
     tvbr->tvb->ws_tvb = ws_tvb;
     tvbr->tvb->expired = FALSE;
     tvbr->tvb->need_free = FALSE;
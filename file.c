@@ -21,9 +21,11 @@
 #include <wsutil/file_util.h>
 #include <wsutil/filesystem.h>
 #include <wsutil/json_dumper.h>
+#include <wsutil/tempfile.h>
 #include <version_info.h>
 
 #include <wiretap/merge.h>
+#include <wiretap/raw_copy.h>
 
 #include <epan/exceptions.h>
 #include <epan/epan.h>
@@ -44,6 +46,15 @@
 
 #include "cfile.h"
 #include "file.h"
+#include "file_index.h"
+#include "frame_bytes_search.h"
+#include "frame_proto_index.h"
+#include "frame_field_store.h"
+#include "frame_expert_info.h"
+#include "frame_traffic_tables.h"
+#include "frame_proto_hier.h"
+#include "frame_record_cache.h"
+#include "frame_tree_cache.h"
 #include "fileset.h"
 #include "frame_tvbuff.h"
 
@@ -68,12 +79,18 @@
 #ifdef _WIN32
 # include <winsock2.h>
 # include <ws2tcpip.h>
+#else
+# include <signal.h>
+# include <sys/wait.h>
+# include <unistd.h>
 #endif
 
 static gboolean read_record(capture_file *cf, wtap_rec *rec, Buffer *buf,
     dfilter_t *dfcode, epan_dissect_t *edt, column_info *cinfo, gint64 offset);
 
 static void rescan_packets(capture_file *cf, const char *action, const char *action_item, gboolean redissect);
+static void start_background_refilter(capture_file *cf);
+static void refilter_backlog(capture_file *cf, gint64 deadline);
 
 typedef enum {
   MR_NOTMATCHED,
@@ -87,13 +104,7 @@ static match_result match_protocol_tree(capture_file *cf, frame_data *fdata,
 static void match_subtree_text(proto_node *node, gpointer data);
 static match_result match_summary_line(capture_file *cf, frame_data *fdata,
     wtap_rec *, Buffer *, void *criterion);
-static match_result match_narrow_and_wide(capture_file *cf, frame_data *fdata,
-    wtap_rec *, Buffer *, void *criterion);
-static match_result match_narrow(capture_file *cf, frame_data *fdata,
-    wtap_rec *, Buffer *, void *criterion);
-static match_result match_wide(capture_file *cf, frame_data *fdata,
-    wtap_rec *, Buffer *, void *criterion);
-static match_result match_binary(capture_file *cf, frame_data *fdata,
+static match_result match_bytes(capture_file *cf, frame_data *fdata,
     wtap_rec *, Buffer *, void *criterion);
 static match_result match_regex(capture_file *cf, frame_data *fdata,
     wtap_rec *, Buffer *, void *criterion);
@@ -108,10 +119,18 @@ static gboolean find_packet(capture_file *cf, ws_match_function match_function,
 
 static void cf_rename_failure_alert_box(const char *filename, int err);
 static void ref_time_packets(capture_file *cf);
+static void ref_time_packets_from(capture_file *cf, frame_data *changed);
+
+static guint get_num_idbs(capture_file *cf);
+static gboolean can_use_file_index(capture_file *cf, dfilter_t *dfcode);
+static gboolean load_frames_from_index(capture_file *cf);
 
 /* Seconds spent processing packets between pushing UI updates. */
 #define PROGBAR_UPDATE_INTERVAL 0.150
 
+/* Microseconds spent refiltering frames in the background at a time. */
+#define REFILTER_CHUNK_TIME 50000
+
 /* Show the progress bar after this many seconds. */
 #define PROGBAR_SHOW_DELAY 0.5
 
@@ -242,6 +261,34 @@ ws_get_frame_ts(struct packet_provider_data *prov, guint32 frame_num)
   return NULL;
 }
 
+/*
+ * Set if we've been handed name resolution records or decryption
+ * secrets while reading the file sequentially; those aren't in a
+ * dissection index, so we can't write one for the file.
+ */
+static gboolean read_side_data;
+
+static void
+cf_new_ipv4_name(const guint addr, const gchar *name)
+{
+  read_side_data = TRUE;
+  add_ipv4_name(addr, name);
+}
+
+static void
+cf_new_ipv6_name(const void *addrp, const gchar *name)
+{
+  read_side_data = TRUE;
+  add_ipv6_name((const ws_in6_addr *)addrp, name);
+}
+
+static void
+cf_new_secrets(guint32 secrets_type, const void *secrets, guint size)
+{
+  read_side_data = TRUE;
+  secrets_wtap_callback(secrets_type, secrets, size);
+}
+
 static epan_t *
 ws_epan_new(capture_file *cf)
 {
@@ -249,24 +296,23 @@ ws_epan_new(capture_file *cf)
     ws_get_frame_ts,
     cap_file_provider_get_interface_name,
     cap_file_provider_get_interface_description,
-    cap_file_provider_get_user_comment
+    cap_file_provider_get_user_comment,
+    cap_file_provider_get_shift_offset
   };
 
   return epan_new(&cf->provider, &funcs);
 }
 
-cf_status_t
-cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_tempfile, int *err)
+/*
+ * Close whatever capture file we had open, and fill in the information
+ * for the one just opened.  member_filenames is NULL, or, for a virtual
+ * capture file, the names of its files, which cf takes over.
+ */
+static void
+cf_open_wth(capture_file *cf, wtap *wth, const char *fname,
+            gchar **member_filenames, gboolean members_appended,
+            unsigned int type, gboolean is_tempfile)
 {
-  wtap  *wth;
-  gchar *err_info;
-
-  wth = wtap_open_offline(fname, type, err, &err_info, TRUE);
-  if (wth == NULL)
-    goto fail;
-
-  /* The open succeeded.  Close whatever capture file we had open,
-     and fill in the information for this file. */
   cf_close(cf);
 
   /* Initialize the record metadata. */
@@ -286,6 +332,8 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_temp
      XXX - is that still true?  We need it for other reasons, though,
      in any case. */
   cf->filename = g_strdup(fname);
+  cf->member_filenames = member_filenames;
+  cf->members_appended = members_appended;
 
   /* Indicate whether it's a permanent or temporary file. */
   cf->is_tempfile = is_tempfile;
@@ -304,12 +352,31 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_temp
   cf->marked_count = 0;
   cf->ignored_count = 0;
   cf->ref_time_count = 0;
+  frame_totals_reset(&cf->all_totals);
+  frame_totals_reset(&cf->filtered_totals);
+  frame_totals_reset(&cf->marked_totals);
   cf->drops_known = FALSE;
   cf->drops     = 0;
   cf->snap      = wtap_snapshot_length(cf->provider.wth);
+  cf->refilter_next = 0;
+  cf->refilter_last = 0;
 
   /* Allocate a frame_data_sequence for the frames in this file */
   cf->provider.frames = new_frame_data_sequence();
+  if (prefs.gui_protocol_index)
+    cf->proto_index = frame_proto_index_new();
+  if (prefs.gui_field_store != NULL && prefs.gui_field_store[0] != '\0')
+    cf->field_store = frame_field_store_new(prefs.gui_field_store);
+  if (prefs.gui_expert_info_first_pass)
+    cf->expert_info = frame_expert_info_new();
+  if (prefs.gui_traffic_tables_first_pass)
+    cf->traffic_tables = frame_traffic_tables_new();
+  if (prefs.gui_proto_hier_first_pass)
+    cf->proto_hier = frame_proto_hier_new();
+  if (prefs.gui_record_cache_size > 0)
+    cf->provider.record_cache = frame_record_cache_new((gsize)prefs.gui_record_cache_size * 1024 * 1024);
+  if (prefs.gui_tree_cache_size > 0)
+    cf->tree_cache = frame_tree_cache_new(prefs.gui_tree_cache_size);
 
   nstime_set_zero(&cf->elapsed_time);
   cf->provider.ref = NULL;
@@ -325,15 +392,57 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_temp
   packet_list_queue_draw();
   cf_callback_invoke(cf_cb_file_opened, cf);
 
-  wtap_set_cb_new_ipv4(cf->provider.wth, add_ipv4_name);
-  wtap_set_cb_new_ipv6(cf->provider.wth, (wtap_new_ipv6_callback_t) add_ipv6_name);
-  wtap_set_cb_new_secrets(cf->provider.wth, secrets_wtap_callback);
+  wtap_set_cb_new_ipv4(cf->provider.wth, cf_new_ipv4_name);
+  wtap_set_cb_new_ipv6(cf->provider.wth, cf_new_ipv6_name);
+  wtap_set_cb_new_secrets(cf->provider.wth, cf_new_secrets);
+  read_side_data = FALSE;
+}
 
+cf_status_t
+cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_tempfile, int *err)
+{
+  wtap  *wth;
+  gchar *err_info;
+
+  wth = wtap_open_offline(fname, type, err, &err_info, TRUE);
+  if (wth == NULL) {
+    cfile_open_failure_alert_box(fname, *err, err_info);
+    return CF_ERROR;
+  }
+
+  /* The open succeeded. */
+  cf_open_wth(cf, wth, fname, NULL, FALSE, type, is_tempfile);
   return CF_OK;
+}
 
-fail:
-  cfile_open_failure_alert_box(fname, *err, err_info);
-  return CF_ERROR;
+cf_status_t
+cf_open_virtual(capture_file *cf, int in_file_count,
+                const char *const *in_filenames, gboolean do_append, int *err)
+{
+  wtap   *wth;
+  gchar  *err_info;
+  guint   err_fileno;
+  gchar **member_filenames;
+  int     i;
+
+  wth = merge_open_virtual(in_filenames, in_file_count, do_append,
+                           IDB_MERGE_MODE_ALL_SAME, err, &err_info,
+                           &err_fileno);
+  if (wth == NULL) {
+    cfile_open_failure_alert_box(in_filenames[err_fileno], *err, err_info);
+    return CF_ERROR;
+  }
+
+  member_filenames = g_new(gchar *, in_file_count + 1);
+  for (i = 0; i < in_file_count; i++)
+    member_filenames[i] = g_strdup(in_filenames[i]);
+  member_filenames[in_file_count] = NULL;
+
+  /* It's named after its first file; the records are read from the
+     files themselves, so it's not a temporary file. */
+  cf_open_wth(cf, wth, in_filenames[0], member_filenames, do_append,
+              WTAP_TYPE_AUTO, FALSE);
+  return CF_OK;
 }
 
 /*
@@ -373,6 +482,8 @@ cf_close(capture_file *cf)
     wtap_close(cf->provider.wth);
     cf->provider.wth = NULL;
   }
+  frame_record_cache_free(cf->provider.record_cache);
+  cf->provider.record_cache = NULL;
   /* We have no file open... */
   if (cf->filename != NULL) {
     /* If it's a temporary file, remove it. */
@@ -381,6 +492,8 @@ cf_close(capture_file *cf)
     g_free(cf->filename);
     cf->filename = NULL;
   }
+  g_strfreev(cf->member_filenames);
+  cf->member_filenames = NULL;
   /* ...which means we have no changes to that file to save. */
   cf->unsaved_changes = FALSE;
 
@@ -404,16 +517,39 @@ cf_close(capture_file *cf)
     free_frame_data_sequence(cf->provider.frames);
     cf->provider.frames = NULL;
   }
+  frame_proto_index_free(cf->proto_index);
+  cf->proto_index = NULL;
+  frame_field_store_free(cf->field_store);
+  cf->field_store = NULL;
+  frame_expert_info_free(cf->expert_info);
+  cf->expert_info = NULL;
+  frame_traffic_tables_free(cf->traffic_tables);
+  cf->traffic_tables = NULL;
+  frame_proto_hier_free(cf->proto_hier);
+  cf->proto_hier = NULL;
+  frame_bytes_search_free(cf->bytes_search);
+  cf->bytes_search = NULL;
+  cf_set_filter_frames(cf, NULL, NULL, 0);
+  cf->refilter_next = 0;
   if (cf->provider.frames_user_comments) {
     g_tree_destroy(cf->provider.frames_user_comments);
     cf->provider.frames_user_comments = NULL;
   }
+  if (cf->provider.frames_shift_offsets) {
+    g_tree_destroy(cf->provider.frames_shift_offsets);
+    cf->provider.frames_shift_offsets = NULL;
+  }
   cf_unselect_packet(cf);   /* nothing to select */
+  frame_tree_cache_free(cf->tree_cache);
+  cf->tree_cache = NULL;
   cf->first_displayed = 0;
   cf->last_displayed = 0;
 
   /* No frames, no frame selected, no field in that frame selected. */
   cf->count = 0;
+  frame_totals_reset(&cf->all_totals);
+  frame_totals_reset(&cf->filtered_totals);
+  frame_totals_reset(&cf->marked_totals);
   cf->current_frame = NULL;
   cf->current_row = 0;
   cf->finfo_selected = NULL;
@@ -426,6 +562,9 @@ cf_close(capture_file *cf)
 
   cf->f_datalen = 0;
   nstime_set_zero(&cf->elapsed_time);
+  cf->first_pass_deferred = FALSE;
+  cf->visited_through = 0;
+  cf->colorized_through = 0;
 
   reset_tap_listeners();
 
@@ -488,6 +627,13 @@ calc_progbar_val(capture_file *cf, gint64 size, gint64 file_pos, gchar *status_s
   return progbar_val;
 }
 
+/* Should frames be colorized when they're first dissected? */
+static gboolean
+colorize_on_first_pass(void)
+{
+  return prefs.gui_colorize_first_pass && color_filters_used();
+}
+
 cf_read_status_t
 cf_read(capture_file *cf, gboolean reloading)
 {
@@ -508,6 +654,8 @@ cf_read(capture_file *cf, gboolean reloading)
   guint                tap_flags;
   gboolean             compiled;
   volatile gboolean    is_read_aborted = FALSE;
+  gboolean             use_index;
+  gboolean             from_index = FALSE;
 
   /* The update_progress_dlg call below might end up accepting a user request to
    * trigger redissection/rescans which can modify/destroy the dissection
@@ -542,11 +690,19 @@ cf_read(capture_file *cf, gboolean reloading)
    *    one of the tap listeners requires a protocol tree;
    *
    *    a postdissector wants field values or protocols on
-   *    the first pass.
+   *    the first pass;
+   *
+   *    we're keeping the values of some fields of each frame;
+   *
+   *    we're keeping the protocol hierarchy of each frame;
+   *
+   *    we're colorizing frames on the first pass.
    */
   create_proto_tree =
     (dfcode != NULL || have_filtering_tap_listeners() ||
-     (tap_flags & TL_REQUIRES_PROTO_TREE) || postdissectors_want_hfids());
+     (tap_flags & TL_REQUIRES_PROTO_TREE) || postdissectors_want_hfids() ||
+     cf->field_store != NULL || cf->proto_hier != NULL ||
+     colorize_on_first_pass());
 
   reset_tap_listeners();
 
@@ -575,6 +731,12 @@ cf_read(capture_file *cf, gboolean reloading)
   /* Find the size of the file. */
   size = wtap_file_size(cf->provider.wth, NULL);
 
+  /* If there's an up-to-date dissection index for the file, and nothing
+     needs all the frames dissected now, load the frames from it. */
+  use_index = can_use_file_index(cf, dfcode);
+  if (use_index && !tap_listeners_require_dissection())
+    from_index = load_frames_from_index(cf);
+
   g_timer_start(prog_timer);
 
   wtap_rec_init(&rec);
@@ -589,7 +751,8 @@ cf_read(capture_file *cf, gboolean reloading)
     float   progbar_val;
     gchar   status_str[100];
 
-    while ((wtap_read(cf->provider.wth, &rec, &buf, &err, &err_info,
+    while (!from_index &&
+           (wtap_read(cf->provider.wth, &rec, &buf, &err, &err_info,
             &data_offset))) {
       if (size >= 0) {
         if (cf->count == max_records) {
@@ -687,9 +850,22 @@ cf_read(capture_file *cf, gboolean reloading)
   /* Close the sequential I/O side, to free up memory it requires. */
   wtap_sequential_close(cf->provider.wth);
 
+  /* The file's been read; from now on we only seek around in it, so
+     map it, if we can, to do that without system calls. */
+  wtap_map_random_access(cf->provider.wth);
+
   /* Allow the protocol dissectors to free up memory that they
-   * don't need after the sequential run-through of the packets. */
-  postseq_cleanup_all_protocols();
+   * don't need after the sequential run-through of the packets.
+   * If we loaded the frames from an index, that run-through
+   * hasn't happened yet. */
+  if (!from_index)
+    postseq_cleanup_all_protocols();
+
+  /* If we read the whole file, save an index for it, so we don't
+     have to read it sequentially the next time. */
+  if (use_index && !from_index && !read_side_data && err == 0 &&
+      !too_many_records && !is_read_aborted && !cf->stop_flag)
+    file_index_save(cf, get_num_idbs(cf));
 
   /* compute the time it took to load the file */
   compute_elapsed(cf, start_time);
@@ -802,11 +978,19 @@ cf_continue_tail(capture_file *cf, volatile int to_read, wtap_rec *rec,
    *    one of the tap listeners requires a protocol tree;
    *
    *    a postdissector wants field values or protocols on
-   *    the first pass.
+   *    the first pass;
+   *
+   *    we're keeping the values of some fields of each frame;
+   *
+   *    we're keeping the protocol hierarchy of each frame;
+   *
+   *    we're colorizing frames on the first pass.
    */
   create_proto_tree =
     (dfcode != NULL || have_filtering_tap_listeners() ||
-     (tap_flags & TL_REQUIRES_PROTO_TREE) || postdissectors_want_hfids());
+     (tap_flags & TL_REQUIRES_PROTO_TREE) || postdissectors_want_hfids() ||
+     cf->field_store != NULL || cf->proto_hier != NULL ||
+     colorize_on_first_pass());
 
   *err = 0;
 
@@ -946,11 +1130,19 @@ cf_finish_tail(capture_file *cf, wtap_rec *rec, Buffer *buf, int *err)
    *    one of the tap listeners requires a protocol tree;
    *
    *    a postdissector wants field values or protocols on
-   *    the first pass.
+   *    the first pass;
+   *
+   *    we're keeping the values of some fields of each frame;
+   *
+   *    we're keeping the protocol hierarchy of each frame;
+   *
+   *    we're colorizing frames on the first pass.
    */
   create_proto_tree =
     (dfcode != NULL || have_filtering_tap_listeners() ||
-     (tap_flags & TL_REQUIRES_PROTO_TREE) || postdissectors_want_hfids());
+     (tap_flags & TL_REQUIRES_PROTO_TREE) || postdissectors_want_hfids() ||
+     cf->field_store != NULL || cf->proto_hier != NULL ||
+     colorize_on_first_pass());
 
   if (cf->provider.wth == NULL) {
     cf_close(cf);
@@ -997,6 +1189,14 @@ cf_finish_tail(capture_file *cf, wtap_rec *rec, Buffer *buf, int *err)
      sequential I/O side, to free up memory it requires. */
   wtap_sequential_close(cf->provider.wth);
 
+  /* The capture's finished, so the file won't grow any more; map it. */
+  wtap_map_random_access(cf->provider.wth);
+
+  /* Finish refiltering the frames we had when the display filter
+     last changed. */
+  if (cf->refilter_next != 0)
+    refilter_backlog(cf, 0);
+
   /* Allow the protocol dissectors to free up memory that they
    * don't need after the sequential run-through of the packets. */
   postseq_cleanup_all_protocols();
@@ -1169,11 +1369,156 @@ void cf_set_rfcode(capture_file *cf, dfilter_t *rfcode)
   cf->rfcode = rfcode;
 }
 
+static void
+frame_totals_reset(frame_totals_t *totals)
+{
+  memset(totals, 0, sizeof *totals);
+}
+
+static void
+frame_totals_add(frame_totals_t *totals, const frame_data *fdata)
+{
+  totals->count++;
+  totals->bytes += fdata->pkt_len;
+  if (fdata->has_ts) {
+    if (totals->count_ts == 0) {
+      totals->start = fdata->abs_ts;
+      totals->stop = fdata->abs_ts;
+      totals->range_stale = FALSE;
+    } else if (!totals->range_stale) {
+      if (nstime_cmp(&fdata->abs_ts, &totals->start) < 0)
+        totals->start = fdata->abs_ts;
+      if (nstime_cmp(&fdata->abs_ts, &totals->stop) > 0)
+        totals->stop = fdata->abs_ts;
+    }
+    totals->count_ts++;
+  }
+}
+
+static void
+frame_totals_remove(frame_totals_t *totals, const frame_data *fdata)
+{
+  if (totals->count == 0)
+    return;
+  totals->count--;
+  totals->bytes -= fdata->pkt_len;
+  if (fdata->has_ts && totals->count_ts > 0) {
+    totals->count_ts--;
+    /* If it was the earliest or the latest, we don't know which one
+       is now without looking at all of them. */
+    if (nstime_cmp(&fdata->abs_ts, &totals->start) == 0 ||
+        nstime_cmp(&fdata->abs_ts, &totals->stop) == 0)
+      totals->range_stale = TRUE;
+  }
+}
+
+static void
+frame_totals_widen(frame_totals_t *totals, const frame_data *fdata)
+{
+  if (totals->count_ts == 0) {
+    totals->start = fdata->abs_ts;
+    totals->stop = fdata->abs_ts;
+    totals->count_ts = 1;
+  } else {
+    if (nstime_cmp(&fdata->abs_ts, &totals->start) < 0)
+      totals->start = fdata->abs_ts;
+    if (nstime_cmp(&fdata->abs_ts, &totals->stop) > 0)
+      totals->stop = fdata->abs_ts;
+    totals->count_ts++;
+  }
+}
+
+void
+cf_get_frame_totals(capture_file *cf, frame_totals_t *all,
+                    frame_totals_t *filtered, frame_totals_t *marked)
+{
+  frame_totals_t *stale[3];
+  guint           n_stale = 0;
+  guint           i;
+  guint32         framenum;
+  frame_data     *fdata;
+
+  /* Find the time ranges that have gone stale again, with one pass
+     over the frames. */
+  if (cf->all_totals.range_stale)
+    stale[n_stale++] = &cf->all_totals;
+  if (cf->filtered_totals.range_stale)
+    stale[n_stale++] = &cf->filtered_totals;
+  if (cf->marked_totals.range_stale)
+    stale[n_stale++] = &cf->marked_totals;
+  if (n_stale != 0) {
+    for (i = 0; i < n_stale; i++)
+      stale[i]->count_ts = 0;
+    for (framenum = 1; framenum <= cf->count; framenum++) {
+      fdata = frame_data_sequence_find(cf->provider.frames, framenum);
+      if (!fdata->has_ts)
+        continue;
+      if (cf->all_totals.range_stale)
+        frame_totals_widen(&cf->all_totals, fdata);
+      if (cf->filtered_totals.range_stale && fdata->passed_dfilter)
+        frame_totals_widen(&cf->filtered_totals, fdata);
+      if (cf->marked_totals.range_stale && fdata->marked)
+        frame_totals_widen(&cf->marked_totals, fdata);
+    }
+    for (i = 0; i < n_stale; i++)
+      stale[i]->range_stale = FALSE;
+  }
+
+  if (all)
+    *all = cf->all_totals;
+  if (filtered)
+    *filtered = cf->filtered_totals;
+  if (marked)
+    *marked = cf->marked_totals;
+}
+
+void
+cf_frame_times_changed(capture_file *cf)
+{
+  cf->all_totals.range_stale = TRUE;
+  cf->filtered_totals.range_stale = TRUE;
+  cf->marked_totals.range_stale = TRUE;
+}
+
+/*
+ * Update the displayed-frame bookkeeping for a frame whose
+ * "passed_dfilter" flag has been set.
+ */
+static void
+account_for_filtered_packet(frame_data *fdata, capture_file *cf,
+    column_info *cinfo, gboolean add_to_packet_list)
+{
+  if (fdata->passed_dfilter || fdata->ref_time)
+    cf->displayed_count++;
+  if (fdata->passed_dfilter)
+    frame_totals_add(&cf->filtered_totals, fdata);
+
+  if (add_to_packet_list) {
+    /* We fill the needed columns from new_packet_list */
+    packet_list_append(cinfo, fdata);
+  }
+
+  if (fdata->passed_dfilter || fdata->ref_time)
+  {
+    frame_data_set_after_dissect(fdata, &cf->cum_bytes);
+    cf->provider.prev_dis = fdata;
+
+    /* If we haven't yet seen the first frame, this is it. */
+    if (cf->first_displayed == 0)
+      cf->first_displayed = fdata->num;
+
+    /* This is the last frame we've seen so far. */
+    cf->last_displayed = fdata->num;
+  }
+}
+
 static void
 add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
     epan_dissect_t *edt, dfilter_t *dfcode, column_info *cinfo,
     wtap_rec *rec, Buffer *buf, gboolean add_to_packet_list)
 {
+  gboolean colorize;
+
   frame_data_set_before_dissect(fdata, &cf->elapsed_time,
                                 &cf->provider.ref, cf->provider.prev_dis);
   cf->provider.prev_cap = fdata;
@@ -1181,15 +1526,15 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
   if (dfcode != NULL) {
       epan_dissect_prime_with_dfilter(edt, dfcode);
   }
-#if 0
-  /* Prepare coloring rules, this ensures that display filter rules containing
-   * frame.color_rule references are still processed.
-   * TODO: actually detect that situation or maybe apply other optimizations? */
-  if (edt->tree && color_filters_used()) {
+
+  /* Colorize the frame now, on its first pass, rather than dissecting it
+     again to colorize it when it's shown.  This also lets display filters
+     with frame.coloring_rule references match. */
+  colorize = edt->tree != NULL && !fdata->visited && colorize_on_first_pass();
+  if (colorize) {
     color_filters_prime_edt(edt);
     fdata->need_colorize = 1;
   }
-#endif
 
   if (!fdata->visited) {
     /* This is the first pass, so prime the epan_dissect_t with the
@@ -1197,6 +1542,16 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
     prime_epan_dissect_with_postdissector_wanted_hfids(edt);
   }
 
+  /* Keep the fields we're storing in the tree, the first time we see
+     the frame. */
+  if (cf->field_store != NULL &&
+      fdata->num == frame_field_store_frame_count(cf->field_store) + 1)
+    frame_field_store_prime_edt(cf->field_store, edt);
+
+  /* And have all its protocols in the tree, to record them. */
+  if (cf->proto_hier != NULL)
+    frame_proto_hier_prime_edt(cf->proto_hier, edt, fdata->num);
+
   /* Dissect the frame. */
   epan_dissect_run_with_taps(edt, cf->cd_t, rec,
                              frame_tvbuff_new_buffer(&cf->provider, fdata, buf),
@@ -1216,26 +1571,37 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
   } else
     fdata->passed_dfilter = 1;
 
-  if (fdata->passed_dfilter || fdata->ref_time)
-    cf->displayed_count++;
+  /* Let the packet list know that it needn't colorize the frame. */
+  if (colorize && fdata->num == cf->colorized_through + 1)
+    cf->colorized_through = fdata->num;
 
-  if (add_to_packet_list) {
-    /* We fill the needed columns from new_packet_list */
-    packet_list_append(cinfo, fdata);
-  }
+  /* Record the frame's protocols, the first time we see it. */
+  if (cf->proto_index != NULL &&
+      fdata->num == frame_proto_index_frame_count(cf->proto_index) + 1)
+    frame_proto_index_add(cf->proto_index, &edt->pi);
 
-  if (fdata->passed_dfilter || fdata->ref_time)
-  {
-    frame_data_set_after_dissect(fdata, &cf->cum_bytes);
-    cf->provider.prev_dis = fdata;
+  /* Record the values of the fields we're storing, likewise. */
+  if (cf->field_store != NULL &&
+      fdata->num == frame_field_store_frame_count(cf->field_store) + 1)
+    frame_field_store_add(cf->field_store, edt);
 
-    /* If we haven't yet seen the first frame, this is it. */
-    if (cf->first_displayed == 0)
-      cf->first_displayed = fdata->num;
+  /* The "expert" tap has given the frame's expert info items to the
+     expert info store, likewise. */
+  if (cf->expert_info != NULL &&
+      fdata->num == frame_expert_info_frame_count(cf->expert_info) + 1)
+    frame_expert_info_frame_done(cf->expert_info);
 
-    /* This is the last frame we've seen so far. */
-    cf->last_displayed = fdata->num;
-  }
+  /* And its conversations and endpoints to the traffic tables. */
+  if (cf->traffic_tables != NULL &&
+      fdata->num == frame_traffic_tables_frame_count(cf->traffic_tables) + 1)
+    frame_traffic_tables_frame_done(cf->traffic_tables);
+
+  /* Record the protocols of its tree for protocol hierarchy statistics. */
+  if (cf->proto_hier != NULL &&
+      fdata->num == frame_proto_hier_frame_count(cf->proto_hier) + 1)
+    frame_proto_hier_add(cf->proto_hier, edt);
+
+  account_for_filtered_packet(fdata, cf, cinfo, add_to_packet_list);
 
   epan_dissect_reset(edt);
 }
@@ -1245,6 +1611,105 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
  * Returns TRUE if the packet was added to the packet (record) list,
  * FALSE otherwise.
  */
+static guint
+get_num_idbs(capture_file *cf)
+{
+  wtapng_iface_descriptions_t *idb_info;
+  guint num_idbs;
+
+  idb_info = wtap_file_get_idb_info(cf->provider.wth);
+  num_idbs = idb_info->interface_data->len;
+  g_free(idb_info);
+  return num_idbs;
+}
+
+/*
+ * Can we load the frames of the file we're about to read from a
+ * dissection index, or save one after reading it?
+ */
+static gboolean
+can_use_file_index(capture_file *cf, dfilter_t *dfcode)
+{
+  if (!prefs.gui_dissection_index)
+    return FALSE;
+
+  /* If the file is a temporary file, it won't be opened again; the
+     index is of a single file. */
+  if (cf->is_tempfile || cf->member_filenames != NULL)
+    return FALSE;
+
+  /* Read and display filters need every frame dissected, so that we
+     know which ones pass. */
+  if (cf->rfcode != NULL || dfcode != NULL)
+    return FALSE;
+
+  return TRUE;
+}
+
+/*
+ * Load the frames of the file from its dissection index, if it has an
+ * up-to-date one.  The frames haven't been dissected, so they're all
+ * displayed; cf_visit_frames_before() dissects them, in order, when
+ * they're first needed.
+ */
+static gboolean
+load_frames_from_index(capture_file *cf)
+{
+  file_index_t  *idx;
+  const gint32  *encaps;
+  guint          num_encaps, i;
+  guint32        frames_count, framenum;
+  frame_data     fdlocal;
+  frame_data    *fdata;
+
+  idx = file_index_open(cf, get_num_idbs(cf));
+  if (idx == NULL)
+    return FALSE;
+
+  frames_count = file_index_frame_count(idx);
+  if (frames_count > max_records) {
+    file_index_close(idx);
+    return FALSE;
+  }
+
+  /* Random access to a compressed file needs the seek points we'd
+     otherwise have found by reading it sequentially. */
+  if (cf->compression_type != WTAP_UNCOMPRESSED) {
+    const guint8 *seek_index;
+    gsize seek_index_len;
+
+    seek_index = file_index_get_seek_index(idx, &seek_index_len);
+    if (seek_index_len == 0 ||
+        !wtap_set_seek_index(cf->provider.wth, seek_index, seek_index_len)) {
+      file_index_close(idx);
+      return FALSE;
+    }
+  }
+
+  encaps = file_index_encapsulations(idx, &num_encaps);
+  for (i = 0; i < num_encaps; i++)
+    cf_add_encapsulation_type(cf, encaps[i]);
+
+  for (framenum = 1; framenum <= frames_count; framenum++) {
+    file_index_get_frame(idx, framenum, cf->cum_bytes, &fdlocal);
+    fdata = frame_data_sequence_add(cf->provider.frames, &fdlocal);
+    cf->count++;
+    frame_totals_add(&cf->all_totals, fdata);
+
+    frame_data_set_before_dissect(fdata, &cf->elapsed_time,
+                                  &cf->provider.ref, cf->provider.prev_dis);
+    cf->provider.prev_cap = fdata;
+    fdata->passed_dfilter = 1;
+    account_for_filtered_packet(fdata, cf, NULL, TRUE);
+  }
+  file_index_get_totals(idx, &cf->packet_comment_count, &cf->f_datalen);
+  file_index_close(idx);
+
+  cf->first_pass_deferred = TRUE;
+  cf->visited_through = 0;
+  return TRUE;
+}
+
 static gboolean
 read_record(capture_file *cf, wtap_rec *rec, Buffer *buf, dfilter_t *dfcode,
             epan_dissect_t *edt, column_info *cinfo, gint64 offset)
@@ -1254,6 +1719,10 @@ read_record(capture_file *cf, wtap_rec *rec, Buffer *buf, dfilter_t *dfcode,
   gboolean      passed = TRUE;
   gboolean      added = FALSE;
 
+  /* A new frame can add to what the trees of earlier ones show, such as
+     the frame with the response to a request. */
+  frame_tree_cache_invalidate(cf->tree_cache);
+
   /* Add this packet's link-layer encapsulation type to cf->linktypes, if
      it's not already there.
      XXX - yes, this is O(N), so if every packet had a different
@@ -1287,6 +1756,7 @@ read_record(capture_file *cf, wtap_rec *rec, Buffer *buf, dfilter_t *dfcode,
     fdata = frame_data_sequence_add(cf->provider.frames, &fdlocal);
 
     cf->count++;
+    frame_totals_add(&cf->all_totals, fdata);
     if (rec->opt_comment != NULL)
       cf->packet_comment_count++;
     cf->f_datalen = offset + fdlocal.cap_len;
@@ -1537,6 +2007,11 @@ cf_filter_packets(capture_file *cf, gchar *dftext, gboolean force)
   if (cf->redissection_queued == RESCAN_NONE) {
     if (cf->read_lock) {
       cf->redissection_queued = RESCAN_SCAN;
+    } else if (cf->state == FILE_READ_IN_PROGRESS && !cf->redissecting) {
+      /* We're capturing; filter new frames as they arrive, and the
+       * ones we already have in the background, so that we keep up
+       * with the capture. */
+      start_background_refilter(cf);
     } else if (cf->state != FILE_CLOSED) {
       if (dftext == NULL) {
         rescan_packets(cf, "Resetting", "filter", FALSE);
@@ -1549,15 +2024,37 @@ cf_filter_packets(capture_file *cf, gchar *dftext, gboolean force)
   /* Cleanup and release all dfilter resources */
   dfilter_free(dfcode);
 
+  /* What we were told about the frames it matches is only good now. */
+  cf_set_filter_frames(cf, NULL, NULL, 0);
+
   return CF_OK;
 }
 
+void
+cf_set_filter_frames(capture_file *cf, const gchar *dftext,
+                     const guint32 *frames, guint num_frames)
+{
+  g_free(cf->filter_frames_dfilter);
+  g_free(cf->filter_frames);
+  cf->filter_frames_dfilter = g_strdup(dftext);
+  cf->filter_frames = dftext ? (guint32 *)g_memdup(frames, num_frames * sizeof(guint32)) : NULL;
+  cf->filter_frames_count = dftext ? num_frames : 0;
+}
+
 void
 cf_reftime_packets(capture_file *cf)
 {
+  frame_tree_cache_invalidate(cf->tree_cache);
   ref_time_packets(cf);
 }
 
+void
+cf_reftime_packet(capture_file *cf, frame_data *fdata)
+{
+  frame_tree_cache_invalidate(cf->tree_cache);
+  ref_time_packets_from(cf, fdata);
+}
+
 void
 cf_redissect_packets(capture_file *cf)
 {
@@ -1580,6 +2077,82 @@ cf_redissect_packets(capture_file *cf)
   }
 }
 
+/*
+ * If the frames were loaded from a dissection index, dissectors haven't
+ * seen them yet.  Before a frame is dissected, dissect all the frames
+ * before it that haven't been dissected, so that dissectors see the
+ * frames in order, as they would have when reading the file.
+ */
+static void
+cf_visit_frames_before(capture_file *cf, guint32 framenum)
+{
+  epan_dissect_t  edt;
+  wtap_rec        rec;
+  Buffer          buf;
+  frame_data     *fdata;
+  guint32         num;
+  progdlg_t      *progbar = NULL;
+  GTimer         *prog_timer;
+  gchar           status_str[100];
+  int             err;
+  gchar          *err_info;
+
+  if (framenum <= cf->visited_through + 1)
+    return;
+
+  /* Visiting them can add to what the trees of later frames show. */
+  frame_tree_cache_invalidate(cf->tree_cache);
+
+  prog_timer = g_timer_new();
+  wtap_rec_init(&rec);
+  ws_buffer_init(&buf, 1514);
+  epan_dissect_init(&edt, cf->epan, postdissectors_want_hfids(), FALSE);
+
+  for (num = cf->visited_through + 1; num < framenum; num++) {
+    fdata = frame_data_sequence_find(cf->provider.frames, num);
+    if (fdata->visited)
+      continue;
+
+    if (progbar == NULL)
+      progbar = delayed_create_progress_dlg(cf->window, "Dissecting", "earlier packets",
+                                            FALSE, &cf->stop_flag, 0.0f);
+    if (progbar != NULL && g_timer_elapsed(prog_timer, NULL) > PROGBAR_UPDATE_INTERVAL) {
+      g_snprintf(status_str, sizeof(status_str), "%4u of %u frames", num, framenum);
+      update_progress_dlg(progbar, (gfloat)num / framenum, status_str);
+      g_timer_start(prog_timer);
+    }
+
+    if (!wtap_seek_read(cf->provider.wth, fdata->file_off, &rec, &buf, &err, &err_info)) {
+      /* The caller will fail to read its record, too, and report it. */
+      g_free(err_info);
+      break;
+    }
+    epan_dissect_run(&edt, cf->cd_t, &rec,
+                     frame_tvbuff_new_buffer(&cf->provider, fdata, &buf),
+                     fdata, NULL);
+    epan_dissect_reset(&edt);
+  }
+
+  epan_dissect_cleanup(&edt);
+  wtap_rec_cleanup(&rec);
+  ws_buffer_free(&buf);
+  if (progbar != NULL)
+    destroy_progress_dlg(progbar);
+  g_timer_destroy(prog_timer);
+
+  /* Move past any frames after those that have been dissected since. */
+  while (num <= cf->count &&
+         frame_data_sequence_find(cf->provider.frames, num)->visited)
+    num++;
+  cf->visited_through = num - 1;
+
+  if (cf->visited_through == cf->count) {
+    /* That's the sequential run-through done. */
+    cf->first_pass_deferred = FALSE;
+    postseq_cleanup_all_protocols();
+  }
+}
+
 gboolean
 cf_read_record(capture_file *cf, const frame_data *fdata,
                  wtap_rec *rec, Buffer *buf)
@@ -1587,7 +2160,12 @@ cf_read_record(capture_file *cf, const frame_data *fdata,
   int    err;
   gchar *err_info;
 
-  if (!wtap_seek_read(cf->provider.wth, fdata->file_off, rec, buf, &err, &err_info)) {
+  if (cf->first_pass_deferred)
+    cf_visit_frames_before(cf, fdata->num);
+
+  if (!frame_record_cache_read(cf->provider.record_cache, cf->provider.wth,
+                               fdata->num, fdata->file_off, rec, buf,
+                               &err, &err_info)) {
     cfile_read_failure_alert_box(cf->filename, err, err_info);
     return FALSE;
   }
@@ -1601,17 +2179,519 @@ cf_read_record_no_alert(capture_file *cf, const frame_data *fdata,
   int    err;
   gchar *err_info;
 
-  if (!wtap_seek_read(cf->provider.wth, fdata->file_off, rec, buf, &err, &err_info)) {
+  if (cf->first_pass_deferred)
+    cf_visit_frames_before(cf, fdata->num);
+
+  if (!frame_record_cache_read(cf->provider.record_cache, cf->provider.wth,
+                               fdata->num, fdata->file_off, rec, buf,
+                               &err, &err_info)) {
     g_free(err_info);
     return FALSE;
   }
-  return TRUE;
+  return TRUE;
+}
+
+gboolean
+cf_read_current_record(capture_file *cf)
+{
+  return cf_read_record(cf, cf->current_frame, &cf->rec, &cf->buf);
+}
+
+/*
+ * Parallel display filtering.
+ *
+ * When a new display filter is applied to a file that has been read in
+ * completely, every frame has already been visited, so the dissectors
+ * have all the cross-frame state they need and each frame can be filtered
+ * independently of the others.  If the "gui.filter_workers" preference
+ * asks for it, we fork worker processes, each of which dissects a range
+ * of frames with its own copy of the dissection state and reports which
+ * of them passed the filter, and which frames those depend upon.
+ * rescan_packets() then merges the results in frame order, doing the
+ * same bookkeeping that it would do after dissecting each frame itself.
+ */
+typedef struct {
+  guint8   *passed;          /* indexed by frame number */
+  GArray   *dependents;      /* pairs of frame numbers: frame, frame it depends upon */
+  guint     next_dependent;  /* next pair to merge */
+} prefilter_results_t;
+
+#ifndef _WIN32
+#define PREFILTER_POLL_INTERVAL (50 * 1000) /* microseconds */
+#define PREFILTER_MIN_FRAMES_PER_WORKER 1000
+
+typedef struct {
+  pid_t     pid;
+  int       out_fd;
+  gboolean  ok;
+} prefilter_worker_t;
+
+/*
+ * Can the display filter be applied by worker processes?
+ */
+static gboolean
+can_prefilter_packets(capture_file *cf, dfilter_t *dfcode, gboolean redissect)
+{
+  int hf_delta_displayed;
+
+  if (prefs.gui_filter_workers <= 1 || dfcode == NULL || redissect)
+    return FALSE;
+
+  /* All the frames have to have been visited. */
+  if (cf->state != FILE_READ_DONE || cf->first_pass_deferred ||
+      cf->count < 2 * PREFILTER_MIN_FRAMES_PER_WORKER)
+    return FALSE;
+
+  /* Taps have to see every frame, in order, in this process. */
+  if (tap_listeners_require_dissection())
+    return FALSE;
+
+  /* The workers don't know which frame was displayed before the first
+     frame in their range, so they can't filter on that. */
+  hf_delta_displayed = proto_registrar_get_id_byname("frame.time_delta_displayed");
+  if (hf_delta_displayed != -1 && dfilter_interested_in_field(dfcode, hf_delta_displayed))
+    return FALSE;
+
+  return TRUE;
+}
+
+static void
+prefilter_worker_run(capture_file *cf, dfilter_t *dfcode,
+                     guint32 first_framenum, guint32 last_framenum,
+                     int out_fd)
+{
+  epan_dissect_t  edt;
+  wtap_rec        rec;
+  Buffer          buf;
+  FILE           *out;
+  frame_data     *fdata;
+  guint32         framenum, i;
+  nstime_t        elapsed_time;
+  int             err;
+  gchar          *err_info;
+
+  /*
+   * Our random-access file descriptor shares its file position with
+   * those of the main process and the other workers; get one of our own.
+   */
+  wtap_fdclose(cf->provider.wth);
+  if (!wtap_fdreopen(cf->provider.wth, cf->filename, &err))
+    _exit(1);
+
+  out = ws_fdopen(out_fd, "wb");
+  if (out == NULL)
+    _exit(1);
+
+  /* Set up the state this range would have in a sequential pass. */
+  cf->provider.ref = NULL;
+  for (framenum = 1; framenum < first_framenum; framenum++) {
+    fdata = frame_data_sequence_find(cf->provider.frames, framenum);
+    if (cf->provider.ref == NULL || fdata->ref_time)
+      cf->provider.ref = fdata;
+  }
+  cf->provider.prev_dis = NULL;
+  nstime_set_zero(&elapsed_time);
+
+  wtap_rec_init(&rec);
+  ws_buffer_init(&buf, 1514);
+  epan_dissect_init(&edt, cf->epan, TRUE, FALSE);
+
+  for (framenum = first_framenum; framenum <= last_framenum; framenum++) {
+    fdata = frame_data_sequence_find(cf->provider.frames, framenum);
+    if (!wtap_seek_read(cf->provider.wth, fdata->file_off, &rec, &buf, &err, &err_info))
+      _exit(1);
+
+    frame_data_set_before_dissect(fdata, &elapsed_time,
+                                  &cf->provider.ref, cf->provider.prev_dis);
+    cf->provider.prev_cap = fdata;
+
+    epan_dissect_prime_with_dfilter(&edt, dfcode);
+    epan_dissect_run(&edt, cf->cd_t, &rec,
+                     frame_tvbuff_new_buffer(&cf->provider, fdata, &buf),
+                     fdata, NULL);
+
+    if (dfilter_apply_edt(dfcode, &edt)) {
+      GSList *dep;
+      guint32 hdr[2];
+
+      hdr[0] = framenum;
+      hdr[1] = g_slist_length(edt.pi.dependent_frames);
+      fwrite(hdr, sizeof hdr, 1, out);
+      for (dep = edt.pi.dependent_frames; dep != NULL; dep = dep->next) {
+        i = GPOINTER_TO_UINT(dep->data);
+        fwrite(&i, sizeof i, 1, out);
+      }
+    }
+    epan_dissect_reset(&edt);
+  }
+
+  if (fflush(out) == EOF || ferror(out))
+    _exit(1);
+
+  /* Don't run any exit-time cleanup; that's the main process's job. */
+  _exit(0);
+}
+
+/*
+ * Read a worker's results.
+ */
+static gboolean
+prefilter_worker_read_results(prefilter_worker_t *worker, guint32 frames_count,
+                              prefilter_results_t *results)
+{
+  FILE    *in;
+  guint32  hdr[2], dep, i;
+  gboolean ok = TRUE;
+
+  if (ws_lseek64(worker->out_fd, 0, SEEK_SET) == -1)
+    return FALSE;
+  in = ws_fdopen(worker->out_fd, "rb");
+  if (in == NULL)
+    return FALSE;
+  worker->out_fd = -1;  /* owned by "in" now */
+
+  while (ok && fread(hdr, sizeof hdr, 1, in) == 1) {
+    if (hdr[0] == 0 || hdr[0] > frames_count) {
+      ok = FALSE;
+      break;
+    }
+    results->passed[hdr[0]] = 1;
+    for (i = 0; i < hdr[1]; i++) {
+      if (fread(&dep, sizeof dep, 1, in) != 1) {
+        ok = FALSE;
+        break;
+      }
+      g_array_append_val(results->dependents, hdr[0]);
+      g_array_append_val(results->dependents, dep);
+    }
+  }
+  if (ferror(in))
+    ok = FALSE;
+  fclose(in);
+  return ok;
+}
+
+/*
+ * Apply the display filter to all the frames using worker processes.
+ * Returns FALSE if that couldn't be done, or was stopped by the user,
+ * in which case the caller has to do it the usual way.
+ */
+static gboolean
+prefilter_packets(capture_file *cf, dfilter_t *dfcode, const char *action,
+                  const char *action_item, prefilter_results_t *results)
+{
+  prefilter_worker_t *workers;
+  guint32      frames_count = cf->count;
+  guint32      frames_per_worker, first_framenum, last_framenum;
+  guint        num_workers, num_started, num_running, i;
+  progdlg_t   *progbar = NULL;
+  gchar        status_str[100];
+  gboolean     ok = TRUE;
+  GError      *gerr = NULL;
+
+  num_workers = MIN(prefs.gui_filter_workers, frames_count / PREFILTER_MIN_FRAMES_PER_WORKER);
+  frames_per_worker = (frames_count + num_workers - 1) / num_workers;
+  workers = g_new0(prefilter_worker_t, num_workers);
+
+  first_framenum = 1;
+  for (num_started = 0; num_started < num_workers && first_framenum <= frames_count; num_started++) {
+    prefilter_worker_t *worker = &workers[num_started];
+    gchar *out_path = NULL;
+
+    last_framenum = MIN(first_framenum + frames_per_worker - 1, frames_count);
+
+    worker->out_fd = create_tempfile(&out_path, "wireshark_filter", NULL, &gerr);
+    if (worker->out_fd == -1) {
+      g_clear_error(&gerr);
+      ok = FALSE;
+      break;
+    }
+    /* The file stays around only as long as the descriptor is open. */
+    ws_unlink(out_path);
+    g_free(out_path);
+
+    worker->pid = fork();
+    if (worker->pid == 0) {
+      /* Child. */
+      prefilter_worker_run(cf, dfcode, first_framenum, last_framenum, worker->out_fd);
+      /* NOTREACHED */
+    }
+    if (worker->pid == -1) {
+      ws_close(worker->out_fd);
+      worker->pid = 0;
+      ok = FALSE;
+      break;
+    }
+    first_framenum = last_framenum + 1;
+  }
+
+  /* Wait for the workers, keeping the progress dialog alive. */
+  num_running = num_started;
+  while (num_running > 0) {
+    for (i = 0; i < num_started; i++) {
+      int wstatus;
+
+      if (workers[i].pid != 0 && waitpid(workers[i].pid, &wstatus, WNOHANG) == workers[i].pid) {
+        workers[i].pid = 0;
+        workers[i].ok = WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == 0;
+        num_running--;
+      }
+    }
+    if (num_running == 0)
+      break;
+
+    if (progbar == NULL) {
+      progbar = delayed_create_progress_dlg(cf->window, action, action_item, TRUE,
+                                            &cf->stop_flag, 0.0f);
+    } else {
+      g_snprintf(status_str, sizeof(status_str),
+                 "%u of %u workers done", num_started - num_running, num_started);
+      update_progress_dlg(progbar, (gfloat)(num_started - num_running) / num_started,
+                          status_str);
+    }
+
+    if (cf->stop_flag) {
+      for (i = 0; i < num_started; i++) {
+        if (workers[i].pid != 0) {
+          kill(workers[i].pid, SIGKILL);
+          waitpid(workers[i].pid, NULL, 0);
+          workers[i].pid = 0;
+        }
+      }
+      ok = FALSE;
+      break;
+    }
+    g_usleep(PREFILTER_POLL_INTERVAL);
+  }
+
+  if (progbar != NULL)
+    destroy_progress_dlg(progbar);
+
+  if (ok) {
+    results->passed = (guint8 *)g_malloc0(frames_count + 1);
+    results->dependents = g_array_new(FALSE, FALSE, sizeof(guint32));
+    results->next_dependent = 0;
+  }
+  for (i = 0; i < num_started; i++) {
+    if (ok && workers[i].ok)
+      ok = prefilter_worker_read_results(&workers[i], frames_count, results);
+    else
+      ok = FALSE;
+    if (workers[i].out_fd != -1)
+      ws_close(workers[i].out_fd);
+  }
+  g_free(workers);
+
+  if (!ok && results->passed != NULL) {
+    g_free(results->passed);
+    results->passed = NULL;
+    g_array_free(results->dependents, TRUE);
+    results->dependents = NULL;
+  }
+  return ok;
+}
+#endif /* _WIN32 */
+
+/*
+ * Do the bookkeeping for a frame that the protocol index says can't
+ * match the display filter.
+ */
+static void
+add_unmatched_packet_to_packet_list(frame_data *fdata, capture_file *cf,
+    column_info *cinfo)
+{
+  frame_data_set_before_dissect(fdata, &cf->elapsed_time,
+                                &cf->provider.ref, cf->provider.prev_dis);
+  cf->provider.prev_cap = fdata;
+
+  fdata->passed_dfilter = 0;
+
+  account_for_filtered_packet(fdata, cf, cinfo, FALSE);
+}
+
+/*
+ * Do the bookkeeping for a frame that has been filtered by a worker
+ * process.
+ */
+static void
+add_prefiltered_packet_to_packet_list(frame_data *fdata, capture_file *cf,
+    column_info *cinfo, prefilter_results_t *results)
+{
+  frame_data_set_before_dissect(fdata, &cf->elapsed_time,
+                                &cf->provider.ref, cf->provider.prev_dis);
+  cf->provider.prev_cap = fdata;
+
+  fdata->passed_dfilter = results->passed[fdata->num];
+
+  /* Mark the frames this one depends upon, as dissecting it would have. */
+  while (results->next_dependent < results->dependents->len &&
+         g_array_index(results->dependents, guint32, results->next_dependent) == fdata->num) {
+    guint32 dep = g_array_index(results->dependents, guint32, results->next_dependent + 1);
+
+    find_and_mark_frame_depended_upon(GUINT_TO_POINTER(dep), cf->provider.frames);
+    results->next_dependent += 2;
+  }
+
+  account_for_filtered_packet(fdata, cf, cinfo, FALSE);
+}
+
+/*
+ * Start refiltering, in the background, the frames of a live capture
+ * that we've already read, after the display filter has changed.  Frames
+ * read from now on are filtered with the new filter as they arrive.
+ */
+static void
+start_background_refilter(capture_file *cf)
+{
+  guint32     framenum;
+  frame_data *fdata;
+
+  /* Frame dependencies from the previous filter are no longer valid; the
+     frames that pass the new one will mark theirs again. */
+  for (framenum = 1; framenum <= cf->count; framenum++) {
+    fdata = frame_data_sequence_find(cf->provider.frames, framenum);
+    fdata->dependent_of_displayed = 0;
+  }
+
+  if (cf->count == 0) {
+    cf->refilter_next = 0;
+    return;
+  }
+  cf->refilter_next = 1;
+  cf->refilter_last = cf->count;
+  packet_list_schedule_refilter();
+}
+
+/*
+ * Refilter a frame from the background refilter's backlog with the
+ * current display filter.  The frame has been dissected before, so
+ * neither the taps nor the protocol index need to see it again.
+ */
+static void
+refilter_frame(capture_file *cf, frame_data *fdata, epan_dissect_t *edt,
+    dfilter_t *dfcode, wtap_rec *rec, Buffer *buf)
+{
+  if (dfcode != NULL) {
+    epan_dissect_prime_with_dfilter(edt, dfcode);
+    epan_dissect_run(edt, cf->cd_t, rec,
+                     frame_tvbuff_new_buffer(&cf->provider, fdata, buf),
+                     fdata, NULL);
+    fdata->passed_dfilter = dfilter_apply_edt(dfcode, edt) ? 1 : 0;
+    if (fdata->passed_dfilter)
+      g_slist_foreach(edt->pi.dependent_frames, find_and_mark_frame_depended_upon, cf->provider.frames);
+    epan_dissect_reset(edt);
+  } else
+    fdata->passed_dfilter = 1;
+}
+
+/*
+ * Refilter frames from the background refilter's backlog, in order,
+ * until the backlog is empty or, if deadline isn't 0, until the
+ * monotonic clock passes it.
+ *
+ * The displayed frame counts are kept up to date as we go; the time
+ * and byte count fields that depend on the previous displayed frame,
+ * and the packet list, are redone once the whole backlog has been
+ * refiltered.
+ */
+static void
+refilter_backlog(capture_file *cf, gint64 deadline)
+{
+  dfilter_t      *dfcode;
+  epan_dissect_t  edt;
+  wtap_rec        rec;
+  Buffer          buf;
+  frame_data     *fdata;
+  gboolean        screen_frames = FALSE;
+  gboolean        was_displayed;
+  gboolean        was_passed;
+  gboolean        compiled;
+  guint32         framenum;
+
+  compiled = dfilter_compile(cf->dfilter, &dfcode, NULL);
+  g_assert(!cf->dfilter || (compiled && dfcode));
+
+  /* The index has every frame in the backlog, as they've all been
+     dissected. */
+  if (dfcode != NULL && cf->proto_index != NULL &&
+      frame_proto_index_frame_count(cf->proto_index) >= cf->refilter_last)
+    screen_frames = frame_proto_index_set_filter(cf->proto_index, dfcode);
+
+  wtap_rec_init(&rec);
+  ws_buffer_init(&buf, 1514);
+  epan_dissect_init(&edt, cf->epan, dfcode != NULL, FALSE);
+
+  while (cf->refilter_next <= cf->refilter_last) {
+    fdata = frame_data_sequence_find(cf->provider.frames, cf->refilter_next);
+    was_displayed = fdata->passed_dfilter || fdata->ref_time;
+    was_passed = fdata->passed_dfilter;
+
+    if (screen_frames &&
+        !frame_proto_index_may_match(cf->proto_index, fdata->num)) {
+      fdata->passed_dfilter = 0;
+    } else {
+      if (dfcode != NULL && !cf_read_record(cf, fdata, &rec, &buf)) {
+        /* Leave the rest of the backlog as it is. */
+        cf->refilter_next = cf->refilter_last + 1;
+        break;
+      }
+      refilter_frame(cf, fdata, &edt, dfcode, &rec, &buf);
+    }
+
+    if (fdata->passed_dfilter || fdata->ref_time) {
+      if (!was_displayed)
+        cf->displayed_count++;
+    } else if (was_displayed)
+      cf->displayed_count--;
+    if (fdata->passed_dfilter && !was_passed)
+      frame_totals_add(&cf->filtered_totals, fdata);
+    else if (!fdata->passed_dfilter && was_passed)
+      frame_totals_remove(&cf->filtered_totals, fdata);
+
+    cf->refilter_next++;
+    if (deadline != 0 && g_get_monotonic_time() >= deadline)
+      break;
+  }
+
+  epan_dissect_cleanup(&edt);
+  wtap_rec_cleanup(&rec);
+  ws_buffer_free(&buf);
+  dfilter_free(dfcode);
+
+  if (cf->refilter_next <= cf->refilter_last)
+    return;
+
+  /* The backlog is done. */
+  cf->refilter_next = 0;
+  ref_time_packets(cf);
+  cf->first_displayed = 0;
+  cf->last_displayed = 0;
+  for (framenum = 1; framenum <= cf->count; framenum++) {
+    fdata = frame_data_sequence_find(cf->provider.frames, framenum);
+    if (fdata->passed_dfilter || fdata->ref_time) {
+      if (cf->first_displayed == 0)
+        cf->first_displayed = framenum;
+      cf->last_displayed = framenum;
+    }
+  }
+
+  packet_list_recreate_visible_rows();
+
+  /* XXX - if the selected frame no longer passes, rescan_packets()
+     would select the nearest one that does; we just leave it alone. */
+  if (cf->current_frame != NULL &&
+      (cf->current_frame->passed_dfilter || cf->current_frame->ref_time))
+    packet_list_select_row_from_data(cf->current_frame);
 }
 
 gboolean
-cf_read_current_record(capture_file *cf)
+cf_continue_refilter(capture_file *cf)
 {
-  return cf_read_record(cf, cf->current_frame, &cf->rec, &cf->buf);
+  if (cf->refilter_next == 0)
+    return FALSE;
+
+  refilter_backlog(cf, g_get_monotonic_time() + REFILTER_CHUNK_TIME);
+  return cf->refilter_next != 0;
 }
 
 /* Rescan the list of packets, reconstructing the CList.
@@ -1652,9 +2732,16 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
   gboolean    compiled;
   guint32     frames_count;
   gboolean    queued_rescan_type = RESCAN_NONE;
-
-  /* Rescan in progress, clear pending actions. */
+  prefilter_results_t prefiltered = { NULL, NULL, 0 };
+  gboolean    screen_frames = FALSE;
+  gboolean    screened_out;
+  const guint32 *filter_frames = NULL;
+  guint       filter_frames_left = 0;
+
+  /* Rescan in progress, clear pending actions; this covers any
+     background refilter, too. */
   cf->redissection_queued = RESCAN_NONE;
+  cf->refilter_next = 0;
   g_assert(!cf->read_lock);
   cf->read_lock = TRUE;
 
@@ -1685,12 +2772,14 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
    *    one of the tap listeners requires a protocol tree;
    *
    *    we're redissecting and a postdissector wants field
-   *    values or protocols on the first pass.
+   *    values or protocols on the first pass, or we're colorizing
+   *    frames on it.
    */
   create_proto_tree =
     (dfcode != NULL || have_filtering_tap_listeners() ||
      (tap_flags & TL_REQUIRES_PROTO_TREE) ||
-     (redissect && postdissectors_want_hfids()));
+     (redissect && (postdissectors_want_hfids() || cf->field_store != NULL ||
+                    cf->proto_hier != NULL || colorize_on_first_pass())));
 
   reset_tap_listeners();
   /* Which frame, if any, is the currently selected frame?
@@ -1706,6 +2795,11 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
      screen updates while it happens. */
   packet_list_freeze();
 
+  /* The trees of the frames show what's displayed before them, and, if
+     we're redissecting, refer to the dissection session that's about
+     to be freed. */
+  frame_tree_cache_invalidate(cf->tree_cache);
+
   if (redissect) {
     /* We need to re-initialize all the state information that protocols
        keep, because some preference that controls a dissector has changed,
@@ -1737,6 +2831,35 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
      * packet list store. */
     packet_list_clear();
     add_to_packet_list = TRUE;
+
+    /* The protocols in each frame may change, too. */
+    if (cf->proto_index != NULL) {
+      frame_proto_index_free(cf->proto_index);
+      cf->proto_index = frame_proto_index_new();
+    }
+
+    /* And so may the values of the fields we're storing. */
+    if (cf->field_store != NULL) {
+      frame_field_store_free(cf->field_store);
+      cf->field_store = frame_field_store_new(prefs.gui_field_store);
+    }
+
+    /* And so may their expert info. */
+    if (cf->expert_info != NULL) {
+      frame_expert_info_free(cf->expert_info);
+      cf->expert_info = frame_expert_info_new();
+    }
+    if (cf->traffic_tables != NULL) {
+      frame_traffic_tables_free(cf->traffic_tables);
+      cf->traffic_tables = frame_traffic_tables_new();
+    }
+    if (cf->proto_hier != NULL) {
+      frame_proto_hier_free(cf->proto_hier);
+      cf->proto_hier = frame_proto_hier_new();
+    }
+
+    /* And the frames' colors, which are computed again on this pass. */
+    cf->colorized_through = 0;
   }
 
   /* We don't yet know which will be the first and last frames displayed. */
@@ -1745,6 +2868,7 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
 
   /* We currently don't display any packets */
   cf->displayed_count = 0;
+  frame_totals_reset(&cf->filtered_totals);
 
   /* Iterate through the list of frames.  Call a routine for each frame
      to check whether it should be displayed and, if so, add it to
@@ -1765,6 +2889,31 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
   cf->stop_flag = FALSE;
   start_time = g_get_monotonic_time();
 
+#ifndef _WIN32
+  /* Let worker processes do the dissection, if we can and have been
+     asked to.  If that fails we do it ourselves; if the user stopped
+     it, cf->stop_flag is set and the loop below stops right away. */
+  if (can_prefilter_packets(cf, dfcode, redissect))
+    prefilter_packets(cf, dfcode, action, action_item, &prefiltered);
+#endif
+
+  /* If we know which protocols are in each frame, we needn't dissect
+     frames that lack a protocol the filter requires. */
+  if (prefiltered.passed == NULL && !redissect && dfcode != NULL &&
+      cf->proto_index != NULL &&
+      frame_proto_index_frame_count(cf->proto_index) == cf->count &&
+      !tap_listeners_require_dissection())
+    screen_frames = frame_proto_index_set_filter(cf->proto_index, dfcode);
+
+  /* If we've been told which frames the filter can match, we needn't
+     dissect the others, unless a tap listener wants them. */
+  if (prefiltered.passed == NULL && !redissect && dfcode != NULL &&
+      g_strcmp0(cf->filter_frames_dfilter, cf->dfilter) == 0 &&
+      tap_listeners_filtered_by(cf->dfilter)) {
+    filter_frames = cf->filter_frames;
+    filter_frames_left = cf->filter_frames_count;
+  }
+
   /* no previous row yet */
   prev_frame_num = -1;
   prev_frame = NULL;
@@ -1789,7 +2938,7 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
      * callback such that wtap resupplies the secrets callback with previously
      * read secrets.
      */
-    wtap_set_cb_new_secrets(cf->provider.wth, secrets_wtap_callback);
+    wtap_set_cb_new_secrets(cf->provider.wth, cf_new_secrets);
   }
 
   for (framenum = 1; framenum <= frames_count; framenum++) {
@@ -1864,7 +3013,19 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
     /* Frame dependencies from the previous dissection/filtering are no longer valid. */
     fdata->dependent_of_displayed = 0;
 
-    if (!cf_read_record(cf, fdata, &rec, &buf))
+    screened_out = screen_frames &&
+                   !frame_proto_index_may_match(cf->proto_index, fdata->num);
+    if (filter_frames != NULL) {
+      if (filter_frames_left > 0 && *filter_frames == fdata->num) {
+        filter_frames++;
+        filter_frames_left--;
+      } else {
+        screened_out = TRUE;
+      }
+    }
+
+    if (prefiltered.passed == NULL && !screened_out &&
+        !cf_read_record(cf, fdata, &rec, &buf))
       break; /* error reading the frame */
 
     /* If the previous frame is displayed, and we haven't yet seen the
@@ -1875,9 +3036,14 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
       preceding_frame = prev_frame;
     }
 
-    add_packet_to_packet_list(fdata, cf, &edt, dfcode,
-                                    cinfo, &rec, &buf,
-                                    add_to_packet_list);
+    if (prefiltered.passed != NULL)
+      add_prefiltered_packet_to_packet_list(fdata, cf, cinfo, &prefiltered);
+    else if (screened_out)
+      add_unmatched_packet_to_packet_list(fdata, cf, cinfo);
+    else
+      add_packet_to_packet_list(fdata, cf, &edt, dfcode,
+                                      cinfo, &rec, &buf,
+                                      add_to_packet_list);
 
     /* If this frame is displayed, and this is the first frame we've
        seen displayed after the selected frame, remember this frame -
@@ -1902,6 +3068,10 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
   epan_dissect_cleanup(&edt);
   wtap_rec_cleanup(&rec);
   ws_buffer_free(&buf);
+  if (prefiltered.passed != NULL) {
+    g_free(prefiltered.passed);
+    g_array_free(prefiltered.dependents, TRUE);
+  }
 
   /* We are done redissecting the packet list. */
   cf->redissecting = FALSE;
@@ -2097,15 +3267,81 @@ ref_time_packets(capture_file *cf)
   }
 }
 
+/*
+ * The "Reference Time" flag of one frame has changed.  The frames before
+ * it don't depend on it, and neither do the frames from the next time
+ * reference frame on, as they start again from that frame; recalculate
+ * only the frames in between, picking up from what the frame before it
+ * holds.
+ */
+static void
+ref_time_packets_from(capture_file *cf, frame_data *changed)
+{
+  guint32     framenum;
+  frame_data *fdata;
+  frame_data *prev;
+  frame_data *ref = NULL;
+  guint32     cum_bytes = 0;
+  nstime_t    rel_ts;
+
+  if (changed->num > 1) {
+    prev = frame_data_sequence_find(cf->provider.frames, changed->num - 1);
+    ref = (prev->frame_ref_num != 0) ?
+        frame_data_sequence_find(cf->provider.frames, prev->frame_ref_num) : prev;
+    /* Undisplayed frames hold the count as it would be if they were. */
+    cum_bytes = prev->cum_bytes;
+    if (!prev->passed_dfilter && !prev->ref_time)
+      cum_bytes -= prev->pkt_len;
+  }
+
+  for (framenum = changed->num; framenum <= cf->count; framenum++) {
+    fdata = frame_data_sequence_find(cf->provider.frames, framenum);
+    if (fdata != changed && fdata->ref_time)
+      break;
+
+    fdata->cum_bytes = cum_bytes + fdata->pkt_len;
+
+    if (ref == NULL || fdata->ref_time)
+      ref = fdata;
+
+    fdata->frame_ref_num = (fdata != ref) ? ref->num : 0;
+    nstime_delta(&rel_ts, &fdata->abs_ts, &ref->abs_ts);
+    if ((gint32)cf->elapsed_time.secs < rel_ts.secs
+        || ((gint32)cf->elapsed_time.secs == rel_ts.secs && (gint32)cf->elapsed_time.nsecs < rel_ts.nsecs)) {
+      cf->elapsed_time = rel_ts;
+    }
+
+    if (fdata->passed_dfilter || fdata->ref_time) {
+      if (fdata->ref_time) {
+        cum_bytes = fdata->pkt_len;
+        fdata->cum_bytes = cum_bytes;
+      } else {
+        cum_bytes += fdata->pkt_len;
+      }
+    }
+  }
+
+  /* Frames still to be read carry on from the last one. */
+  if (framenum > cf->count) {
+    cf->provider.ref = ref;
+    cf->cum_bytes = cum_bytes;
+  }
+}
+
 typedef enum {
   PSP_FINISHED,
   PSP_STOPPED,
   PSP_FAILED
 } psp_return_t;
 
+/*
+ * If read_records is FALSE, the records aren't read, and the callback
+ * is handed NULL pointers for them; it gets only the frame data.
+ */
 static psp_return_t
-process_specified_records(capture_file *cf, packet_range_t *range,
+process_specified_records_work(capture_file *cf, packet_range_t *range,
     const char *string1, const char *string2, gboolean terminate_is_stop,
+    gboolean read_records,
     gboolean (*callback)(capture_file *, frame_data *,
                          wtap_rec *, Buffer *, void *),
     void *callback_args,
@@ -2203,13 +3439,14 @@ process_specified_records(capture_file *cf, packet_range_t *range,
     }
 
     /* Get the packet */
-    if (!cf_read_record(cf, fdata, &rec, &buf)) {
+    if (read_records && !cf_read_record(cf, fdata, &rec, &buf)) {
       /* Attempt to get the packet failed. */
       ret = PSP_FAILED;
       break;
     }
     /* Process the packet */
-    if (!callback(cf, fdata, &rec, &buf, callback_args)) {
+    if (!callback(cf, fdata, read_records ? &rec : NULL,
+                  read_records ? &buf : NULL, callback_args)) {
       /* Callback failed.  We assume it reported the error appropriately. */
       ret = PSP_FAILED;
       break;
@@ -2231,6 +3468,19 @@ process_specified_records(capture_file *cf, packet_range_t *range,
   return ret;
 }
 
+static psp_return_t
+process_specified_records(capture_file *cf, packet_range_t *range,
+    const char *string1, const char *string2, gboolean terminate_is_stop,
+    gboolean (*callback)(capture_file *, frame_data *,
+                         wtap_rec *, Buffer *, void *),
+    void *callback_args,
+    gboolean show_progress_bar)
+{
+  return process_specified_records_work(cf, range, string1, string2,
+                                        terminate_is_stop, TRUE, callback,
+                                        callback_args, show_progress_bar);
+}
+
 typedef struct {
   epan_dissect_t edt;
   column_info *cinfo;
@@ -2261,11 +3511,16 @@ cf_retap_packets(capture_file *cf)
 
   /* Presumably the user closed the capture file. */
   if (cf == NULL) {
+    tap_listeners_end_retap();
     return CF_READ_ABORTED;
   }
 
   cf_callback_invoke(cf_cb_file_retap_started, cf);
 
+  /* If some tap listeners were marked for this retap, only they are reset
+     and given the packets, and only their needs count below. */
+  tap_listeners_begin_retap();
+
   /* Get the union of the flags for all tap listeners. */
   tap_flags = union_of_tap_listener_flags();
 
@@ -2300,6 +3555,8 @@ cf_retap_packets(capture_file *cf)
   packet_range_cleanup(&range);
   epan_dissect_cleanup(&callback_args.edt);
 
+  tap_listeners_end_retap();
+
   cf_callback_invoke(cf_cb_file_retap_finished, cf);
 
   switch (ret) {
@@ -3252,9 +4509,10 @@ match_summary_line(capture_file *cf, frame_data *fdata,
 }
 
 typedef struct {
-    const guint8 *data;
-    size_t        data_len;
-} cbs_t;    /* "Counted byte string" */
+    frame_bytes_pattern_t *pattern;
+    guint32                len;     /* of the pattern's bytes */
+    frame_bytes_search_t  *search;  /* the pattern's matches in all frames, or NULL */
+} bytes_criterion_t;
 
 
 /*
@@ -3267,14 +4525,72 @@ typedef struct {
  * significantly better.
  */
 
+/*
+ * Match a pattern against all the frames at once, on worker threads that
+ * read the file themselves, unless that's been done for the pattern
+ * already, so that finding the next or previous match is a lookup.
+ * Returns NULL if that can't be done, or if the user stopped it, in which
+ * case *stopped is set.
+ */
+static frame_bytes_search_t *
+search_all_frames(capture_file *cf, const frame_bytes_pattern_t *pattern, gboolean *stopped)
+{
+  frame_bytes_search_t *search;
+  progdlg_t            *progbar = NULL;
+  gchar                 status_str[100];
+  guint32               done;
+
+  *stopped = FALSE;
+  if (cf->bytes_search != NULL &&
+      frame_bytes_search_is_for(cf->bytes_search, pattern, cf->count))
+    return cf->bytes_search;
+  frame_bytes_search_free(cf->bytes_search);
+  cf->bytes_search = NULL;
+
+  /* The whole file must have been read, and can't be growing. */
+  if (cf->state != FILE_READ_DONE || cf->filename == NULL || cf->count == 0)
+    return NULL;
+
+  /* The workers open a single file, by name. */
+  if (cf->member_filenames != NULL)
+    return NULL;
+
+  cf->stop_flag = FALSE;
+  search = frame_bytes_search_start(pattern, cf->filename, cf->open_type,
+                                    cf->provider.frames, cf->count);
+  while (!frame_bytes_search_wait(search, (gint64)(PROGBAR_UPDATE_INTERVAL * G_USEC_PER_SEC))) {
+    done = frame_bytes_search_frames_done(search);
+    if (progbar == NULL)
+      progbar = delayed_create_progress_dlg(cf->window, NULL, NULL, TRUE,
+                                            &cf->stop_flag, (gfloat) done / cf->count);
+    g_snprintf(status_str, sizeof(status_str),
+               "%4u of %u packets", done, cf->count);
+    update_progress_dlg(progbar, (gfloat) done / cf->count, status_str);
+    if (cf->stop_flag)
+      break;
+  }
+  if (progbar != NULL)
+    destroy_progress_dlg(progbar);
+
+  if (cf->stop_flag || !frame_bytes_search_succeeded(search)) {
+    /* If a frame couldn't be read, search the usual way, which reports
+       the error. */
+    *stopped = cf->stop_flag;
+    frame_bytes_search_free(search);
+    return NULL;
+  }
+  cf->bytes_search = search;
+  return search;
+}
+
 gboolean
 cf_find_packet_data(capture_file *cf, const guint8 *string, size_t string_size,
                     search_direction dir)
 {
-  cbs_t info;
-
-  info.data = string;
-  info.data_len = string_size;
+  bytes_criterion_t  criterion;
+  frame_bytes_mode_e mode;
+  gboolean           stopped;
+  gboolean           found;
 
   /* Regex, String or hex search? */
   if (cf->regex) {
@@ -3285,212 +4601,67 @@ cf_find_packet_data(capture_file *cf, const guint8 *string, size_t string_size,
     switch (cf->scs_type) {
 
     case SCS_NARROW_AND_WIDE:
-      return find_packet(cf, match_narrow_and_wide, &info, dir);
+      mode = FRAME_BYTES_NARROW_AND_WIDE;
+      break;
 
     case SCS_NARROW:
-      return find_packet(cf, match_narrow, &info, dir);
+      mode = FRAME_BYTES_EXACT;
+      break;
 
     case SCS_WIDE:
-      return find_packet(cf, match_wide, &info, dir);
+      mode = FRAME_BYTES_WIDE;
+      break;
 
     default:
       g_assert_not_reached();
       return FALSE;
     }
   } else
-    return find_packet(cf, match_binary, &info, dir);
-}
-
-static match_result
-match_narrow_and_wide(capture_file *cf, frame_data *fdata,
-                      wtap_rec *rec, Buffer *buf, void *criterion)
-{
-  cbs_t        *info       = (cbs_t *)criterion;
-  const guint8 *ascii_text = info->data;
-  size_t        textlen    = info->data_len;
-  match_result  result;
-  guint32       buf_len;
-  guint8       *pd;
-  guint32       i;
-  guint8        c_char;
-  size_t        c_match    = 0;
+    mode = FRAME_BYTES_EXACT;
 
-  /* Load the frame's data. */
-  if (!cf_read_record(cf, fdata, rec, buf)) {
-    /* Attempt to get the packet failed. */
-    return MR_ERROR;
-  }
-
-  result = MR_NOTMATCHED;
-  buf_len = fdata->cap_len;
-  pd = ws_buffer_start_ptr(buf);
-  i = 0;
-  while (i < buf_len) {
-    c_char = pd[i];
-    if (cf->case_type)
-      c_char = g_ascii_toupper(c_char);
-    if (c_char != '\0') {
-      if (c_char == ascii_text[c_match]) {
-        c_match += 1;
-        if (c_match == textlen) {
-          result = MR_MATCHED;
-          cf->search_pos = i; /* Save the position of the last character
-                                 for highlighting the field. */
-          cf->search_len = (guint32)textlen;
-          break;
-        }
-      }
-      else {
-        g_assert(i>=c_match);
-        i -= (guint32)c_match;
-        c_match = 0;
-      }
-    }
-    i += 1;
-  }
-  return result;
-}
-
-static match_result
-match_narrow(capture_file *cf, frame_data *fdata,
-             wtap_rec *rec, Buffer *buf, void *criterion)
-{
-  cbs_t        *info       = (cbs_t *)criterion;
-  const guint8 *ascii_text = info->data;
-  size_t        textlen    = info->data_len;
-  match_result  result;
-  guint32       buf_len;
-  guint8       *pd;
-  guint32       i;
-  guint8        c_char;
-  size_t        c_match    = 0;
-
-  /* Load the frame's data. */
-  if (!cf_read_record(cf, fdata, rec, buf)) {
-    /* Attempt to get the packet failed. */
-    return MR_ERROR;
-  }
-
-  result = MR_NOTMATCHED;
-  buf_len = fdata->cap_len;
-  pd = ws_buffer_start_ptr(buf);
-  i = 0;
-  while (i < buf_len) {
-    c_char = pd[i];
-    if (cf->case_type)
-      c_char = g_ascii_toupper(c_char);
-    if (c_char == ascii_text[c_match]) {
-      c_match += 1;
-      if (c_match == textlen) {
-        result = MR_MATCHED;
-        cf->search_pos = i; /* Save the position of the last character
-                               for highlighting the field. */
-        cf->search_len = (guint32)textlen;
-        break;
-      }
-    }
-    else {
-      g_assert(i>=c_match);
-      i -= (guint32)c_match;
-      c_match = 0;
-    }
-    i += 1;
-  }
+  /* Nothing matches nothing. */
+  if (string_size == 0)
+    return FALSE;
 
-  return result;
+  /* Only strings are matched ignoring case. */
+  criterion.pattern = frame_bytes_pattern_new(string, string_size, mode,
+                                              cf->string && cf->case_type);
+  criterion.len = (guint32)string_size;
+  criterion.search = search_all_frames(cf, criterion.pattern, &stopped);
+  if (stopped)
+    found = FALSE;
+  else
+    found = find_packet(cf, match_bytes, &criterion, dir);
+  frame_bytes_pattern_free(criterion.pattern);
+  return found;
 }
 
 static match_result
-match_wide(capture_file *cf, frame_data *fdata,
-           wtap_rec *rec, Buffer *buf, void *criterion)
+match_bytes(capture_file *cf, frame_data *fdata,
+            wtap_rec *rec, Buffer *buf, void *criterion)
 {
-  cbs_t        *info       = (cbs_t *)criterion;
-  const guint8 *ascii_text = info->data;
-  size_t        textlen    = info->data_len;
-  match_result  result;
-  guint32       buf_len;
-  guint8       *pd;
-  guint32       i;
-  guint8        c_char;
-  size_t        c_match    = 0;
-
-  /* Load the frame's data. */
-  if (!cf_read_record(cf, fdata, rec, buf)) {
-    /* Attempt to get the packet failed. */
-    return MR_ERROR;
-  }
+  bytes_criterion_t *info = (bytes_criterion_t *)criterion;
+  guint32            last_pos;
+  gboolean           matched;
 
-  result = MR_NOTMATCHED;
-  buf_len = fdata->cap_len;
-  pd = ws_buffer_start_ptr(buf);
-  i = 0;
-  while (i < buf_len) {
-    c_char = pd[i];
-    if (cf->case_type)
-      c_char = g_ascii_toupper(c_char);
-    if (c_char == ascii_text[c_match]) {
-      c_match += 1;
-      if (c_match == textlen) {
-        result = MR_MATCHED;
-        cf->search_pos = i; /* Save the position of the last character
-                               for highlighting the field. */
-        cf->search_len = (guint32)textlen;
-        break;
-      }
-      i += 1;
-    }
-    else {
-      g_assert(i>=(c_match*2));
-      i -= (guint32)c_match*2;
-      c_match = 0;
+  if (info->search != NULL) {
+    matched = frame_bytes_search_matched(info->search, fdata->num, &last_pos);
+  } else {
+    /* Load the frame's data. */
+    if (!cf_read_record(cf, fdata, rec, buf)) {
+      /* Attempt to get the packet failed. */
+      return MR_ERROR;
     }
-    i += 1;
-  }
-  return result;
-}
-
-static match_result
-match_binary(capture_file *cf, frame_data *fdata,
-             wtap_rec *rec, Buffer *buf, void *criterion)
-{
-  cbs_t        *info        = (cbs_t *)criterion;
-  const guint8 *binary_data = info->data;
-  size_t        datalen     = info->data_len;
-  match_result  result;
-  guint32       buf_len;
-  guint8       *pd;
-  guint32       i;
-  size_t        c_match     = 0;
-
-  /* Load the frame's data. */
-  if (!cf_read_record(cf, fdata, rec, buf)) {
-    /* Attempt to get the packet failed. */
-    return MR_ERROR;
+    matched = frame_bytes_pattern_match(info->pattern, ws_buffer_start_ptr(buf),
+                                        fdata->cap_len, &last_pos);
   }
+  if (!matched)
+    return MR_NOTMATCHED;
 
-  result = MR_NOTMATCHED;
-  buf_len = fdata->cap_len;
-  pd = ws_buffer_start_ptr(buf);
-  i = 0;
-  while (i < buf_len) {
-    if (pd[i] == binary_data[c_match]) {
-      c_match += 1;
-      if (c_match == datalen) {
-        result = MR_MATCHED;
-        cf->search_pos = i; /* Save the position of the last character
-                               for highlighting the field. */
-        cf->search_len = (guint32)datalen;
-        break;
-      }
-    }
-    else {
-      g_assert(i>=c_match);
-      i -= (guint32)c_match;
-      c_match = 0;
-    }
-    i += 1;
-  }
-  return result;
+  cf->search_pos = last_pos; /* Save the position of the last character
+                                for highlighting the field. */
+  cf->search_len = info->len;
+  return MR_MATCHED;
 }
 
 static match_result
@@ -3838,6 +5009,8 @@ void
 cf_select_packet(capture_file *cf, int row)
 {
   epan_dissect_t *old_edt;
+  frame_tree_t   *old_tree;
+  frame_tree_t   *tree = NULL;
   frame_data     *fdata;
 
   /* Get the frame data struct pointer for this frame */
@@ -3852,6 +5025,19 @@ cf_select_packet(capture_file *cf, int row)
     return;
   }
 
+  /* A tree that's to be kept needs a record of its own, as cf->rec
+     and cf->buf are reused for other frames. */
+  if (cf->tree_cache != NULL) {
+    tree = frame_tree_cache_take(cf->tree_cache, fdata->num);
+    if (tree == NULL) {
+      tree = frame_tree_new(cf->tree_cache, fdata->num);
+      if (!cf_read_record(cf, fdata, &tree->rec, &tree->buf)) {
+        frame_tree_free(tree);
+        return;
+      }
+    }
+  }
+
   /* Record that this frame is the current frame. */
   cf->current_frame = fdata;
   cf->current_row = row;
@@ -3876,18 +5062,36 @@ cf_select_packet(capture_file *cf, int row)
    * we replace it?
    */
   old_edt = cf->edt;
-  /* Create the logical protocol tree. */
-  /* We don't need the columns here. */
-  cf->edt = epan_dissect_new(cf->epan, TRUE, TRUE);
-
-  tap_build_interesting(cf->edt);
-  epan_dissect_run(cf->edt, cf->cd_t, &cf->rec,
-                   frame_tvbuff_new_buffer(&cf->provider, cf->current_frame, &cf->buf),
-                   cf->current_frame, NULL);
+  old_tree = cf->current_tree;
+  cf->current_tree = tree;
+  if (tree != NULL && tree->edt != NULL) {
+    /* It was dissected when it was last selected; nothing that changes
+       its tree has happened since, or it wouldn't be in the cache. */
+    cf->edt = tree->edt;
+  } else {
+    /* Create the logical protocol tree. */
+    /* We don't need the columns here. */
+    cf->edt = epan_dissect_new(cf->epan, TRUE, TRUE);
+
+    tap_build_interesting(cf->edt);
+    if (tree != NULL) {
+      epan_dissect_run(cf->edt, cf->cd_t, &tree->rec,
+                       frame_tvbuff_new_buffer(&cf->provider, cf->current_frame, &tree->buf),
+                       cf->current_frame, NULL);
+      tree->edt = cf->edt;
+    } else {
+      epan_dissect_run(cf->edt, cf->cd_t, &cf->rec,
+                       frame_tvbuff_new_buffer(&cf->provider, cf->current_frame, &cf->buf),
+                       cf->current_frame, NULL);
+    }
+  }
 
   dfilter_macro_build_ftv_cache(cf->edt->tree);
 
-  if (old_edt != NULL)
+  /* Keep the old tree for when its frame is selected again. */
+  if (old_tree != NULL)
+    frame_tree_cache_put(cf->tree_cache, old_tree);
+  else if (old_edt != NULL)
     epan_dissect_free(old_edt);
 }
 
@@ -3896,19 +5100,24 @@ void
 cf_unselect_packet(capture_file *cf)
 {
   epan_dissect_t *old_edt = cf->edt;
+  frame_tree_t   *old_tree = cf->current_tree;
 
   /*
    * See the comment in cf_select_packet() about deferring the freeing
    * of the old cf->edt.
    */
   cf->edt = NULL;
+  cf->current_tree = NULL;
 
   /* No packet is selected. */
   cf->current_frame = NULL;
   cf->current_row = 0;
 
-  /* Destroy the epan_dissect_t for the unselected packet. */
-  if (old_edt != NULL)
+  /* Destroy the epan_dissect_t for the unselected packet, unless it's
+     to be kept. */
+  if (old_tree != NULL)
+    frame_tree_cache_put(cf->tree_cache, old_tree);
+  else if (old_edt != NULL)
     epan_dissect_free(old_edt);
 }
 
@@ -3919,9 +5128,11 @@ void
 cf_mark_frame(capture_file *cf, frame_data *frame)
 {
   if (! frame->marked) {
+    frame_tree_cache_invalidate(cf->tree_cache);
     frame->marked = TRUE;
     if (cf->count > cf->marked_count)
       cf->marked_count++;
+    frame_totals_add(&cf->marked_totals, frame);
   }
 }
 
@@ -3932,9 +5143,11 @@ void
 cf_unmark_frame(capture_file *cf, frame_data *frame)
 {
   if (frame->marked) {
+    frame_tree_cache_invalidate(cf->tree_cache);
     frame->marked = FALSE;
     if (cf->marked_count > 0)
       cf->marked_count--;
+    frame_totals_remove(&cf->marked_totals, frame);
   }
 }
 
@@ -3945,6 +5158,7 @@ void
 cf_ignore_frame(capture_file *cf, frame_data *frame)
 {
   if (! frame->ignored) {
+    frame_tree_cache_invalidate(cf->tree_cache);
     frame->ignored = TRUE;
     if (cf->count > cf->ignored_count)
       cf->ignored_count++;
@@ -3958,6 +5172,7 @@ void
 cf_unignore_frame(capture_file *cf, frame_data *frame)
 {
   if (frame->ignored) {
+    frame_tree_cache_invalidate(cf->tree_cache);
     frame->ignored = FALSE;
     if (cf->ignored_count > 0)
       cf->ignored_count--;
@@ -4052,6 +5267,7 @@ cf_set_user_packet_comment(capture_file *cf, frame_data *fd, const gchar *new_co
     cf->packet_comment_count++;
 
   cap_file_provider_set_user_comment(&cf->provider, fd, new_comment);
+  frame_tree_cache_invalidate(cf->tree_cache);
 
   expert_update_comment_count(cf->packet_comment_count);
 
@@ -4289,6 +5505,9 @@ rescan_file(capture_file *cf, const char *fname, gboolean is_tempfile)
   /* Close the old handle. */
   wtap_close(cf->provider.wth);
 
+  /* The frames will be at other offsets in the new file. */
+  frame_record_cache_clear(cf->provider.record_cache);
+
   /* Open the new file. */
   /* XXX: this will go through all open_routines for a matching one. But right
      now rescan_file() is only used when a file is being saved to a different
@@ -4310,6 +5529,10 @@ rescan_file(capture_file *cf, const char *fname, gboolean is_tempfile)
      in any case. */
   cf->filename = g_strdup(fname);
 
+  /* It's read from the file we saved to, not the files it was. */
+  g_strfreev(cf->member_filenames);
+  cf->member_filenames = NULL;
+
   /* Indicate whether it's a permanent or temporary file. */
   cf->is_tempfile = is_tempfile;
 
@@ -4406,6 +5629,8 @@ rescan_file(capture_file *cf, const char *fname, gboolean is_tempfile)
   /* Close the sequential I/O side, to free up memory it requires. */
   wtap_sequential_close(cf->provider.wth);
 
+  wtap_map_random_access(cf->provider.wth);
+
   /* compute the time it took to load the file */
   compute_elapsed(cf, start_time);
 
@@ -4467,6 +5692,7 @@ cf_save_records(capture_file *cf, const char *fname, guint save_format,
 
   if (save_format == cf->cd_t && compression_type == cf->compression_type
       && !discard_comments && !cf->unsaved_changes
+      && cf->member_filenames == NULL
       && (wtap_addrinfo_list_empty(addr_lists) || wtap_file_type_subtype_supports_block(save_format, WTAP_BLOCK_NAME_RESOLUTION) == BLOCK_NOT_SUPPORTED)) {
     /* We're saving in the format it's already in, and we're not discarding
        comments, and there are no changes we have in memory that aren't saved
@@ -4791,6 +6017,104 @@ fail:
   return CF_WRITE_ERROR;
 }
 
+typedef struct {
+  wtap_raw_copier *copier;
+  packet_range_t  *range;
+  const char      *fname;
+  int              file_type;
+} raw_export_callback_args_t;
+
+/*
+ * Copy the record of a frame to the output file if it's in the range
+ * being exported, or skip it if it isn't.  We're called for every
+ * frame, as the copier has to see every record of the file.
+ */
+static gboolean
+raw_export_record(capture_file *cf, frame_data *fdata, wtap_rec *rec _U_,
+                  Buffer *buf _U_, void *argsp)
+{
+  raw_export_callback_args_t *args = (raw_export_callback_args_t *)argsp;
+  gboolean      wanted;
+  int           err;
+  gchar        *err_info;
+
+  wanted = packet_range_process_packet(args->range, fdata) == range_process_this;
+  if (!wtap_raw_copy_record(args->copier, fdata->file_off, wanted, &err,
+                            &err_info)) {
+    cfile_write_failure_alert_box(cf->filename, args->fname, err, err_info,
+                                  fdata->num, args->file_type);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/*
+ * Export the specified packets by copying their records from the
+ * capture file, without reading them with wiretap and writing them
+ * with wtap_dump(); "fname_new", if not NULL, is the temporary file
+ * to which "copier" is writing, to be renamed to "fname".
+ */
+static cf_write_status_t
+export_specified_packets_raw(capture_file *cf, const char *fname,
+                             gchar *fname_new, wtap_raw_copier *copier,
+                             packet_range_t *range, guint save_format)
+{
+  int                          err;
+  gchar                       *err_info;
+  raw_export_callback_args_t   callback_args;
+
+  callback_args.copier = copier;
+  callback_args.range = range;
+  callback_args.fname = fname;
+  callback_args.file_type = save_format;
+  switch (process_specified_records_work(cf, NULL, "Writing",
+                                         "specified records", TRUE, FALSE,
+                                         raw_export_record, &callback_args,
+                                         TRUE)) {
+
+  case PSP_FINISHED:
+    /* Completed successfully. */
+    break;
+
+  case PSP_STOPPED:
+    /* The user decided to abort the saving.
+       If we're writing to a temporary file, remove it. */
+    wtap_raw_copy_abort(copier);
+    if (fname_new != NULL) {
+      ws_unlink(fname_new);
+      g_free(fname_new);
+    }
+    return CF_WRITE_ABORTED;
+
+  case PSP_FAILED:
+    wtap_raw_copy_abort(copier);
+    goto fail;
+  }
+
+  if (!wtap_raw_copy_close(copier, &err, &err_info)) {
+    cfile_close_failure_alert_box(fname, err, err_info);
+    goto fail;
+  }
+
+  if (fname_new != NULL) {
+    /* We wrote out to fname_new; rename it on top of fname. */
+    if (ws_rename(fname_new, fname) == -1) {
+      cf_rename_failure_alert_box(fname, errno);
+      goto fail;
+    }
+    g_free(fname_new);
+  }
+
+  return CF_WRITE_OK;
+
+fail:
+  if (fname_new != NULL) {
+    ws_unlink(fname_new);
+    g_free(fname_new);
+  }
+  return CF_WRITE_ERROR;
+}
+
 cf_write_status_t
 cf_export_specified_packets(capture_file *cf, const char *fname,
                             packet_range_t *range, guint save_format,
@@ -4800,12 +6124,50 @@ cf_export_specified_packets(capture_file *cf, const char *fname,
   int                          err;
   gchar                       *err_info;
   wtap_dumper                 *pdh;
+  wtap_raw_copier             *copier;
   save_callback_args_t         callback_args;
   wtap_dump_params             params;
   int                          encap;
+  addrinfo_lists_t            *addr_lists;
 
   packet_range_process_init(range);
 
+  addr_lists = get_addrinfo_list();
+
+  if (save_format == cf->cd_t && compression_type == WTAP_UNCOMPRESSED
+      && cf->compression_type == WTAP_UNCOMPRESSED && !cf->unsaved_changes
+      && cf->member_filenames == NULL
+      && wtap_raw_copy_supported(save_format)
+      && (wtap_addrinfo_list_empty(addr_lists) || wtap_file_type_subtype_supports_block(save_format, WTAP_BLOCK_NAME_RESOLUTION) == BLOCK_NOT_SUPPORTED)) {
+    /* We're writing the packets in the format the file is already in,
+       and there's nothing about them that we'd have to change, so we
+       can copy their records as they are, rather than reading each
+       packet and writing it out again; that's a lot faster for large
+       files.  (The same conditions let cf_save_records() move or copy
+       the whole file.) */
+    if (file_exists(fname)) {
+      /* Do a "safe save", as below. */
+      fname_new = g_strdup_printf("%s~", fname);
+      copier = wtap_raw_copy_open(cf->filename, save_format, fname_new,
+                                  &err, &err_info);
+    } else {
+      copier = wtap_raw_copy_open(cf->filename, save_format, fname,
+                                  &err, &err_info);
+    }
+    if (copier != NULL)
+      return export_specified_packets_raw(cf, fname, fname_new, copier,
+                                          range, save_format);
+
+    /* We couldn't copy the records; write them with wtap_dump(), which
+       will report the error if it's one that affects it too. */
+    g_free(err_info);
+    if (fname_new != NULL) {
+      ws_unlink(fname_new);
+      g_free(fname_new);
+      fname_new = NULL;
+    }
+  }
+
   /* We're writing out specified packets from the specified capture
      file to another file.  Even if all captured packets are to be
      written, don't special-case the operation - read each packet
@@ -4846,7 +6208,7 @@ cf_export_specified_packets(capture_file *cf, const char *fname,
   }
 
   /* Add address resolution */
-  wtap_dump_set_addrinfo_list(pdh, get_addrinfo_list());
+  wtap_dump_set_addrinfo_list(pdh, addr_lists);
 
   /* Iterate through the list of packets, processing the packets we were
      told to process.
@@ -4959,7 +6321,9 @@ cf_rename_failure_alert_box(const char *filename, int err)
 void
 cf_reload(capture_file *cf) {
   gchar    *filename;
+  gchar   **member_filenames;
   gboolean  is_tempfile;
+  cf_status_t status;
   int       err;
 
   if (cf->read_lock) {
@@ -4980,7 +6344,17 @@ cf_reload(capture_file *cf) {
   filename = g_strdup(cf->filename);
   is_tempfile = cf->is_tempfile;
   cf->is_tempfile = FALSE;
-  if (cf_open(cf, filename, cf->open_type, is_tempfile, &err) == CF_OK) {
+  if (cf->member_filenames != NULL) {
+    /* A virtual capture file is opened again from all its files. */
+    member_filenames = g_strdupv(cf->member_filenames);
+    status = cf_open_virtual(cf, (int)g_strv_length(member_filenames),
+                             (const char *const *)member_filenames,
+                             cf->members_appended, &err);
+    g_strfreev(member_filenames);
+  } else {
+    status = cf_open(cf, filename, cf->open_type, is_tempfile, &err);
+  }
+  if (status == CF_OK) {
     switch (cf_read(cf, TRUE)) {
 
     case CF_READ_OK:
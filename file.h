@@ -124,6 +124,22 @@ cf_callback_remove(cf_callback_t func, gpointer user_data);
  */
 cf_status_t cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_tempfile, int *err);
 
+/**
+ * Open two or more capture files as one, without merging them into a
+ * temporary file; the records are read from the files themselves, in
+ * the order they'd be merged in.
+ *
+ * @param cf the capture file to be opened
+ * @param in_file_count the number of files to open
+ * @param in_filenames array of filenames
+ * @param do_append FALSE to merge chronologically, TRUE simply append
+ * @param err error code
+ * @return one of cf_status_t
+ */
+cf_status_t cf_open_virtual(capture_file *cf, int in_file_count,
+                            const char *const *in_filenames,
+                            gboolean do_append, int *err);
+
 /**
  * Close a capture file.
  *
@@ -208,6 +224,16 @@ void cf_fake_continue_tail(capture_file *cf);
 cf_read_status_t cf_finish_tail(capture_file *cf, wtap_rec *rec,
                                 Buffer *buf, int *err);
 
+/**
+ * Refilter some of the frames of a live capture that were read before
+ * the display filter last changed.  Call this when idle until it returns
+ * FALSE, after packet_list_schedule_refilter() is called.
+ *
+ * @param cf the capture file
+ * @return TRUE if there are more frames to refilter, FALSE if not
+ */
+gboolean cf_continue_refilter(capture_file *cf);
+
 /**
  * Determine whether this capture file (or a range of it) can be written
  * in any format using Wiretap rather than by copying the raw data.
@@ -394,6 +420,19 @@ void cf_set_rfcode(capture_file *cf, dfilter_t *rfcode);
  */
 cf_status_t cf_filter_packets(capture_file *cf, gchar *dfilter, gboolean force);
 
+/**
+ * Say that a display filter can only match some frames, so that if the
+ * next call to cf_filter_packets() applies it, only they're dissected,
+ * unless a tap listener needs the others.
+ *
+ * @param cf the capture file
+ * @param dfilter the display filter
+ * @param frames the numbers of the frames, in ascending order
+ * @param num_frames the number of frames
+ */
+void cf_set_filter_frames(capture_file *cf, const gchar *dfilter,
+                          const guint32 *frames, guint num_frames);
+
 /**
  * At least one "Refence Time" flag has changed, rescan all packets.
  *
@@ -401,6 +440,15 @@ cf_status_t cf_filter_packets(capture_file *cf, gchar *dfilter, gboolean force);
  */
 void cf_reftime_packets(capture_file *cf);
 
+/**
+ * The "Reference Time" flag of one frame has changed; recalculate only the
+ * frames that depend on it, i.e. those up to the next reference frame.
+ *
+ * @param cf the capture file
+ * @param fdata the frame whose flag has changed
+ */
+void cf_reftime_packet(capture_file *cf, frame_data *fdata);
+
 /**
  * Return the time it took to load the file (in msec).
  */
@@ -645,6 +693,29 @@ void cf_mark_frame(capture_file *cf, frame_data *frame);
  */
 void cf_unmark_frame(capture_file *cf, frame_data *frame);
 
+/**
+ * Get the totals of all the frames, of the frames that passed the
+ * display filter and of the marked frames, without going through the
+ * frames unless the earliest or latest time stamp of a set has to be
+ * found again.
+ *
+ * @param cf the capture file
+ * @param all if not NULL, filled in with the totals of all the frames
+ * @param filtered if not NULL, filled in with the totals of the frames that
+ * passed the display filter
+ * @param marked if not NULL, filled in with the totals of the marked frames
+ */
+void cf_get_frame_totals(capture_file *cf, frame_totals_t *all,
+                         frame_totals_t *filtered, frame_totals_t *marked);
+
+/**
+ * Note that the time stamps of frames in a particular capture have been
+ * changed, e.g. shifted.
+ *
+ * @param cf the capture file
+ */
+void cf_frame_times_changed(capture_file *cf);
+
 /**
  * Ignore a particular frame in a particular capture.
  *
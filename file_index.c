@@ -0,0 +1,372 @@
+/* file_index.c
+ * Routines for dissection index sidecar files
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+
+#include <glib.h>
+
+#include <wsutil/file_util.h>
+#include <wsutil/filesystem.h>
+
+#include <epan/frame_data.h>
+#include <epan/frame_data_sequence.h>
+
+#include "file_index.h"
+
+#define FILE_INDEX_SUFFIX       ".wsidx"
+#define FILE_INDEX_VERSION      2
+#define FILE_INDEX_BYTE_ORDER   0x1a2b3c4d
+#define FILE_INDEX_DIGEST_LEN   32      /* SHA-256 */
+#define FILE_INDEX_SAMPLE_LEN   65536   /* bytes hashed at each end of the capture file */
+#define FILE_INDEX_ENCAP_SLOTS(n)   (((n) + 1) & ~1U)
+
+static const char file_index_magic[8] = { 'W', 'S', 'F', 'I', 'D', 'X', '\r', '\n' };
+
+/*
+ * The file consists of a header, the encapsulation types (padded to
+ * an even number, to keep the records 8-byte aligned), one record per
+ * frame and, for a compressed file, the seek points wiretap found in
+ * it, all in host byte order; an index written on a machine with a
+ * different byte order is simply ignored.
+ */
+typedef struct {
+  char      magic[8];
+  guint32   byte_order;
+  guint32   version;
+  guint8    file_digest[FILE_INDEX_DIGEST_LEN];
+  guint8    settings_digest[FILE_INDEX_DIGEST_LEN];
+  guint32   frame_count;
+  guint32   num_idbs;
+  guint32   num_encaps;
+  guint32   seek_index_len;
+  guint64   packet_comment_count;
+  gint64    f_datalen;
+} file_index_header_t;
+
+#define FILE_INDEX_HAS_TS           0x0001
+#define FILE_INDEX_HAS_PHDR_COMMENT 0x0002
+#define FILE_INDEX_EBCDIC           0x0004
+#define FILE_INDEX_TSPREC_SHIFT     8
+
+typedef struct {
+  gint64    file_off;
+  gint64    ts_secs;
+  gint32    ts_nsecs;
+  guint32   pkt_len;
+  guint32   cap_len;
+  guint16   flags;
+  guint16   reserved;
+} file_index_record_t;
+
+struct file_index {
+  GMappedFile               *mapped;
+  const file_index_header_t *hdr;
+  const gint32              *encaps;
+  const file_index_record_t *records;
+  const guint8              *seek_index;
+};
+
+/*
+ * Profile files whose contents affect how frames are dissected.
+ */
+static const char *settings_files[] = {
+  "preferences",
+  "decode_as_entries",
+  "disabled_protos",
+  "enabled_protos",
+  "heuristic_protos",
+};
+
+gchar *
+file_index_path(const char *capture_path)
+{
+  return g_strconcat(capture_path, FILE_INDEX_SUFFIX, NULL);
+}
+
+static void
+checksum_update_file_sample(GChecksum *checksum, int fd, gint64 offset,
+                            guint8 *buf)
+{
+  ssize_t nread;
+
+  if (ws_lseek64(fd, offset, SEEK_SET) == -1)
+    return;
+  nread = ws_read(fd, buf, FILE_INDEX_SAMPLE_LEN);
+  if (nread > 0)
+    g_checksum_update(checksum, buf, (gssize)nread);
+}
+
+/*
+ * Compute a digest identifying the capture file.  Hashing all of a
+ * multi-gigabyte file would take longer than reading it, so we hash
+ * its size, its modification time, and the blocks at each end.
+ */
+static gboolean
+compute_file_digest(const char *capture_path, guint8 *digest)
+{
+  ws_statb64  statb;
+  int         fd;
+  GChecksum  *checksum;
+  guint8     *buf;
+  gint64      size, mtime;
+  gsize       digest_len = FILE_INDEX_DIGEST_LEN;
+
+  fd = ws_open(capture_path, O_RDONLY|O_BINARY, 0000);
+  if (fd == -1)
+    return FALSE;
+  if (ws_fstat64(fd, &statb) != 0) {
+    ws_close(fd);
+    return FALSE;
+  }
+
+  checksum = g_checksum_new(G_CHECKSUM_SHA256);
+  size = (gint64)statb.st_size;
+  mtime = (gint64)statb.st_mtime;
+  g_checksum_update(checksum, (const guchar *)&size, sizeof size);
+  g_checksum_update(checksum, (const guchar *)&mtime, sizeof mtime);
+
+  buf = (guint8 *)g_malloc(FILE_INDEX_SAMPLE_LEN);
+  checksum_update_file_sample(checksum, fd, 0, buf);
+  if (size > FILE_INDEX_SAMPLE_LEN)
+    checksum_update_file_sample(checksum, fd, size - FILE_INDEX_SAMPLE_LEN, buf);
+  g_free(buf);
+  ws_close(fd);
+
+  g_checksum_get_digest(checksum, digest, &digest_len);
+  g_checksum_free(checksum);
+  return TRUE;
+}
+
+/*
+ * Compute a digest of the version of Wireshark and the settings of
+ * the current profile, so that changing either invalidates the index.
+ */
+static void
+compute_settings_digest(guint8 *digest)
+{
+  GChecksum  *checksum;
+  const char *profile_name;
+  gsize       digest_len = FILE_INDEX_DIGEST_LEN;
+  guint       i;
+
+  checksum = g_checksum_new(G_CHECKSUM_SHA256);
+  g_checksum_update(checksum, (const guchar *)VERSION, -1);
+  profile_name = get_profile_name();
+  g_checksum_update(checksum, (const guchar *)profile_name, strlen(profile_name) + 1);
+
+  for (i = 0; i < G_N_ELEMENTS(settings_files); i++) {
+    char  *path = get_persconffile_path(settings_files[i], TRUE);
+    gchar *contents;
+    gsize  length;
+
+    if (g_file_get_contents(path, &contents, &length, NULL)) {
+      g_checksum_update(checksum, (const guchar *)contents, length);
+      g_free(contents);
+    }
+    /* Separate the files, so that moving text between them matters. */
+    g_checksum_update(checksum, (const guchar *)"", 1);
+    g_free(path);
+  }
+
+  g_checksum_get_digest(checksum, digest, &digest_len);
+  g_checksum_free(checksum);
+}
+
+file_index_t *
+file_index_open(capture_file *cf, guint num_idbs)
+{
+  file_index_t              *idx;
+  gchar                     *path;
+  GMappedFile               *mapped;
+  const file_index_header_t *hdr;
+  gsize                      length;
+  guint8                     digest[FILE_INDEX_DIGEST_LEN];
+
+  path = file_index_path(cf->filename);
+  mapped = g_mapped_file_new(path, FALSE, NULL);
+  g_free(path);
+  if (mapped == NULL)
+    return NULL;
+
+  length = g_mapped_file_get_length(mapped);
+  hdr = (const file_index_header_t *)g_mapped_file_get_contents(mapped);
+  if (length < sizeof *hdr ||
+      memcmp(hdr->magic, file_index_magic, sizeof file_index_magic) != 0 ||
+      hdr->byte_order != FILE_INDEX_BYTE_ORDER ||
+      hdr->version != FILE_INDEX_VERSION ||
+      hdr->num_idbs != num_idbs ||
+      length != sizeof *hdr +
+                FILE_INDEX_ENCAP_SLOTS(hdr->num_encaps) * sizeof(gint32) +
+                (gsize)hdr->frame_count * sizeof(file_index_record_t) +
+                hdr->seek_index_len)
+    goto stale;
+
+  if (!compute_file_digest(cf->filename, digest) ||
+      memcmp(digest, hdr->file_digest, sizeof digest) != 0)
+    goto stale;
+  compute_settings_digest(digest);
+  if (memcmp(digest, hdr->settings_digest, sizeof digest) != 0)
+    goto stale;
+
+  idx = g_new(file_index_t, 1);
+  idx->mapped = mapped;
+  idx->hdr = hdr;
+  idx->encaps = (const gint32 *)(hdr + 1);
+  idx->records = (const file_index_record_t *)(idx->encaps + FILE_INDEX_ENCAP_SLOTS(hdr->num_encaps));
+  idx->seek_index = (const guint8 *)(idx->records + hdr->frame_count);
+  return idx;
+
+stale:
+  g_mapped_file_unref(mapped);
+  return NULL;
+}
+
+guint32
+file_index_frame_count(const file_index_t *idx)
+{
+  return idx->hdr->frame_count;
+}
+
+const gint32 *
+file_index_encapsulations(const file_index_t *idx, guint *num_encaps)
+{
+  *num_encaps = idx->hdr->num_encaps;
+  return idx->encaps;
+}
+
+void
+file_index_get_totals(const file_index_t *idx, guint64 *packet_comment_count,
+                      gint64 *f_datalen)
+{
+  *packet_comment_count = idx->hdr->packet_comment_count;
+  *f_datalen = idx->hdr->f_datalen;
+}
+
+void
+file_index_get_frame(const file_index_t *idx, guint32 num, guint32 cum_bytes,
+                     frame_data *fdata)
+{
+  const file_index_record_t *rec = &idx->records[num - 1];
+
+  memset(fdata, 0, sizeof *fdata);
+  fdata->num = num;
+  fdata->file_off = rec->file_off;
+  fdata->pkt_len = rec->pkt_len;
+  fdata->cap_len = rec->cap_len;
+  fdata->cum_bytes = cum_bytes + rec->pkt_len;
+  fdata->abs_ts.secs = (time_t)rec->ts_secs;
+  fdata->abs_ts.nsecs = rec->ts_nsecs;
+  fdata->has_ts = (rec->flags & FILE_INDEX_HAS_TS) ? 1 : 0;
+  fdata->has_phdr_comment = (rec->flags & FILE_INDEX_HAS_PHDR_COMMENT) ? 1 : 0;
+  fdata->encoding = (rec->flags & FILE_INDEX_EBCDIC) ?
+      PACKET_CHAR_ENC_CHAR_EBCDIC : PACKET_CHAR_ENC_CHAR_ASCII;
+  fdata->tsprec = (rec->flags >> FILE_INDEX_TSPREC_SHIFT) & 0xF;
+}
+
+const guint8 *
+file_index_get_seek_index(const file_index_t *idx, gsize *len)
+{
+  *len = idx->hdr->seek_index_len;
+  return idx->seek_index;
+}
+
+void
+file_index_close(file_index_t *idx)
+{
+  g_mapped_file_unref(idx->mapped);
+  g_free(idx);
+}
+
+void
+file_index_save(capture_file *cf, guint num_idbs)
+{
+  file_index_header_t  hdr;
+  file_index_record_t  rec;
+  gchar               *path, *tmp_path;
+  GByteArray          *seek_index = NULL;
+  FILE                *fh;
+  guint32              framenum;
+  guint                i;
+  gboolean             ok = TRUE;
+
+  memset(&hdr, 0, sizeof hdr);
+  memcpy(hdr.magic, file_index_magic, sizeof file_index_magic);
+  hdr.byte_order = FILE_INDEX_BYTE_ORDER;
+  hdr.version = FILE_INDEX_VERSION;
+  if (!compute_file_digest(cf->filename, hdr.file_digest))
+    return;
+  compute_settings_digest(hdr.settings_digest);
+  hdr.frame_count = cf->count;
+  hdr.num_idbs = num_idbs;
+  hdr.num_encaps = cf->linktypes ? cf->linktypes->len : 0;
+  hdr.packet_comment_count = cf->packet_comment_count;
+  hdr.f_datalen = cf->f_datalen;
+
+  /* Without its seek points, reading a compressed file at random would
+     mean decompressing it from the start over and over. */
+  if (cf->compression_type != WTAP_UNCOMPRESSED) {
+    seek_index = wtap_get_seek_index(cf->provider.wth);
+    if (seek_index == NULL || seek_index->len > G_MAXUINT32) {
+      if (seek_index != NULL)
+        g_byte_array_free(seek_index, TRUE);
+      return;
+    }
+    hdr.seek_index_len = seek_index->len;
+  }
+
+  path = file_index_path(cf->filename);
+  tmp_path = g_strconcat(path, ".tmp", NULL);
+  fh = ws_fopen(tmp_path, "wb");
+  if (fh == NULL) {
+    /* Probably a read-only directory; that's fine. */
+    if (seek_index != NULL)
+      g_byte_array_free(seek_index, TRUE);
+    g_free(tmp_path);
+    g_free(path);
+    return;
+  }
+
+  ok = fwrite(&hdr, sizeof hdr, 1, fh) == 1;
+  for (i = 0; ok && i < FILE_INDEX_ENCAP_SLOTS(hdr.num_encaps); i++) {
+    gint32 encap = i < hdr.num_encaps ? g_array_index(cf->linktypes, int, i) : 0;
+
+    ok = fwrite(&encap, sizeof encap, 1, fh) == 1;
+  }
+  memset(&rec, 0, sizeof rec);
+  for (framenum = 1; ok && framenum <= cf->count; framenum++) {
+    const frame_data *fdata = frame_data_sequence_find(cf->provider.frames, framenum);
+
+    rec.file_off = fdata->file_off;
+    rec.ts_secs = (gint64)fdata->abs_ts.secs;
+    rec.ts_nsecs = fdata->abs_ts.nsecs;
+    rec.pkt_len = fdata->pkt_len;
+    rec.cap_len = fdata->cap_len;
+    rec.flags = (fdata->has_ts ? FILE_INDEX_HAS_TS : 0) |
+                (fdata->has_phdr_comment ? FILE_INDEX_HAS_PHDR_COMMENT : 0) |
+                (fdata->encoding == PACKET_CHAR_ENC_CHAR_EBCDIC ? FILE_INDEX_EBCDIC : 0) |
+                (fdata->tsprec << FILE_INDEX_TSPREC_SHIFT);
+    ok = fwrite(&rec, sizeof rec, 1, fh) == 1;
+  }
+  if (ok && seek_index != NULL && seek_index->len != 0)
+    ok = fwrite(seek_index->data, seek_index->len, 1, fh) == 1;
+  if (seek_index != NULL)
+    g_byte_array_free(seek_index, TRUE);
+  if (fclose(fh) != 0)
+    ok = FALSE;
+
+  if (!ok || ws_rename(tmp_path, path) != 0)
+    ws_unlink(tmp_path);
+  g_free(tmp_path);
+  g_free(path);
+}
@@ -0,0 +1,89 @@
+/* file_index.h
+ * Definitions for dissection index sidecar files
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __FILE_INDEX_H__
+#define __FILE_INDEX_H__
+
+#include "cfile.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * A dissection index is a file, stored next to a capture file, that
+ * records everything the first sequential pass over the capture file
+ * computes for each frame's frame_data, and, for a compressed file,
+ * where decompression can be started, so that the file can be reopened
+ * without reading it sequentially again.
+ *
+ * It's keyed by a digest of the capture file (its size, modification
+ * time, and leading and trailing blocks) and a digest of the settings
+ * of the current profile that affect dissection; if either changes,
+ * the index is ignored.
+ */
+typedef struct file_index file_index_t;
+
+/** Get the name of the index file for a capture file.
+ *
+ * @param capture_path the pathname of the capture file
+ * @return the pathname of the index file; must be g_free()d
+ */
+extern gchar *file_index_path(const char *capture_path);
+
+/** Open the index for a capture file, if it exists and is current.
+ *
+ * @param cf the capture file, which must have been opened
+ * @param num_idbs the number of interface descriptions wiretap knows about
+ * @return the index, or NULL if there isn't a usable one
+ */
+extern file_index_t *file_index_open(capture_file *cf, guint num_idbs);
+
+/** Get the number of frames in an index. */
+extern guint32 file_index_frame_count(const file_index_t *idx);
+
+/** Get the encapsulation types of the frames in an index. */
+extern const gint32 *file_index_encapsulations(const file_index_t *idx, guint *num_encaps);
+
+/** Get the packet comment count and data length recorded in an index. */
+extern void file_index_get_totals(const file_index_t *idx, guint64 *packet_comment_count,
+                                  gint64 *f_datalen);
+
+/** Fill in the frame_data for a frame from an index, as frame_data_init()
+ * would.
+ *
+ * @param idx the index
+ * @param num the frame number, from 1 through file_index_frame_count()
+ * @param cum_bytes the cumulative byte count before this frame
+ * @param fdata the frame_data to fill in
+ */
+extern void file_index_get_frame(const file_index_t *idx, guint32 num,
+                                 guint32 cum_bytes, frame_data *fdata);
+
+/** Get the seek points for a compressed capture file, to hand to
+ * wtap_set_seek_index(); *len is 0 for an uncompressed file. */
+extern const guint8 *file_index_get_seek_index(const file_index_t *idx, gsize *len);
+
+/** Close an index. */
+extern void file_index_close(file_index_t *idx);
+
+/** Write the index for a capture file that has been read completely.
+ * Failures are silently ignored; the index is only an optimization.
+ *
+ * @param cf the capture file
+ * @param num_idbs the number of interface descriptions wiretap knows about
+ */
+extern void file_index_save(capture_file *cf, guint num_idbs);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __FILE_INDEX_H__ */
@@ -0,0 +1,430 @@
+/* frame_bytes_search.c
+ * Routines for searching the bytes of frames
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/frame_data.h>
+#include <wiretap/wtap.h>
+#include <wsutil/buffer.h>
+
+#include "frame_bytes_search.h"
+
+struct frame_bytes_pattern {
+  guint8             *data;
+  size_t              len;
+  frame_bytes_mode_e  mode;
+  gboolean            nocase;
+  guint8              fold[256];        /* each byte as it's compared */
+  size_t              skip[256];        /* for FRAME_BYTES_EXACT */
+};
+
+/* Frames per thread below which it's not worth starting another one */
+#define MIN_WORKER_FRAMES 4096
+
+/* Frames a worker searches between updates of the progress */
+#define PROGRESS_FRAMES 256
+
+typedef struct {
+  gint64   offset;
+  guint32  cap_len;
+} frame_loc_t;
+
+typedef struct {
+  guint32  framenum;
+  guint32  last_pos;
+} match_t;
+
+typedef struct {
+  frame_bytes_search_t *search;
+  guint32               first;
+  guint32               last;
+  GArray               *matches;         /* match_t */
+  gboolean              failed;
+} worker_t;
+
+struct frame_bytes_search {
+  frame_bytes_pattern_t *pattern;
+  char                  *filename;
+  unsigned int           open_type;
+  guint32                frame_count;
+  frame_loc_t           *locs;
+
+  guint                  num_workers;
+  worker_t              *workers;
+  GThread              **threads;
+  GMutex                 mutex;
+  GCond                  cond;
+  guint                  running;       /* protected by mutex */
+  gint                   frames_done;   /* atomic */
+  gint                   stop;          /* atomic */
+
+  /* Once it's finished */
+  gboolean               joined;
+  gboolean               succeeded;
+  GArray                *matches;       /* match_t, in frame order */
+};
+
+frame_bytes_pattern_t *
+frame_bytes_pattern_new(const guint8 *data, size_t len, frame_bytes_mode_e mode, gboolean nocase)
+{
+  frame_bytes_pattern_t *pattern;
+  size_t                 i;
+
+  g_assert(len > 0);
+
+  pattern = g_new(frame_bytes_pattern_t, 1);
+  pattern->data = (guint8 *)g_memdup(data, (guint)len);
+  pattern->len = len;
+  pattern->mode = mode;
+  pattern->nocase = nocase;
+
+  for (i = 0; i < 256; i++) {
+    pattern->fold[i] = nocase ? (guint8)g_ascii_toupper((gchar)i) : (guint8)i;
+    pattern->skip[i] = len;
+  }
+  /* Horspool's shifts: how far the pattern can move on when the byte under
+     its last one is a given byte. */
+  for (i = 0; i + 1 < len; i++)
+    pattern->skip[pattern->data[i]] = len - 1 - i;
+
+  return pattern;
+}
+
+void
+frame_bytes_pattern_free(frame_bytes_pattern_t *pattern)
+{
+  if (pattern == NULL)
+    return;
+  g_free(pattern->data);
+  g_free(pattern);
+}
+
+static frame_bytes_pattern_t *
+pattern_copy(const frame_bytes_pattern_t *pattern)
+{
+  return frame_bytes_pattern_new(pattern->data, pattern->len, pattern->mode, pattern->nocase);
+}
+
+static gboolean
+pattern_equal(const frame_bytes_pattern_t *a, const frame_bytes_pattern_t *b)
+{
+  return a->len == b->len && a->mode == b->mode && a->nocase == b->nocase &&
+         memcmp(a->data, b->data, a->len) == 0;
+}
+
+static gboolean
+match_exact(const frame_bytes_pattern_t *pattern, const guint8 *data, guint32 len,
+            guint32 *last_pos)
+{
+  const guint8 *fold = pattern->fold;
+  const guint8 *p = pattern->data;
+  size_t        last = pattern->len - 1;
+  size_t        pos, j;
+
+  if (len < pattern->len)
+    return FALSE;
+
+  for (pos = 0; pos + last < len; pos += pattern->skip[fold[data[pos + last]]]) {
+    if (fold[data[pos + last]] != p[last])
+      continue;
+    for (j = 0; j < last && fold[data[pos + j]] == p[j]; j++)
+      ;
+    if (j == last) {
+      *last_pos = (guint32)(pos + last);
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+/* These two are the loops the match routines in file.c used. */
+static gboolean
+match_wide(const frame_bytes_pattern_t *pattern, const guint8 *data, guint32 len,
+           guint32 *last_pos)
+{
+  guint32 i = 0;
+  size_t  c_match = 0;
+  guint8  c_char;
+
+  while (i < len) {
+    c_char = pattern->fold[data[i]];
+    if (c_char == pattern->data[c_match]) {
+      c_match += 1;
+      if (c_match == pattern->len) {
+        *last_pos = i;
+        return TRUE;
+      }
+      i += 1;
+    } else {
+      i -= (guint32)c_match * 2;
+      c_match = 0;
+    }
+    i += 1;
+  }
+  return FALSE;
+}
+
+static gboolean
+match_narrow_and_wide(const frame_bytes_pattern_t *pattern, const guint8 *data, guint32 len,
+                      guint32 *last_pos)
+{
+  guint32 i = 0;
+  size_t  c_match = 0;
+  guint8  c_char;
+
+  while (i < len) {
+    c_char = pattern->fold[data[i]];
+    if (c_char != '\0') {
+      if (c_char == pattern->data[c_match]) {
+        c_match += 1;
+        if (c_match == pattern->len) {
+          *last_pos = i;
+          return TRUE;
+        }
+      } else {
+        i -= (guint32)c_match;
+        c_match = 0;
+      }
+    }
+    i += 1;
+  }
+  return FALSE;
+}
+
+gboolean
+frame_bytes_pattern_match(const frame_bytes_pattern_t *pattern, const guint8 *data,
+                          guint32 len, guint32 *last_pos)
+{
+  switch (pattern->mode) {
+
+  case FRAME_BYTES_WIDE:
+    return match_wide(pattern, data, len, last_pos);
+
+  case FRAME_BYTES_NARROW_AND_WIDE:
+    return match_narrow_and_wide(pattern, data, len, last_pos);
+
+  default:
+    return match_exact(pattern, data, len, last_pos);
+  }
+}
+
+static gpointer
+search_worker(gpointer data)
+{
+  worker_t             *worker = (worker_t *)data;
+  frame_bytes_search_t *search = worker->search;
+  wtap                 *wth;
+  wtap_rec              rec;
+  Buffer                buf;
+  int                   err;
+  gchar                *err_info = NULL;
+  guint32               num, since_progress = 0;
+  guint32               last_pos;
+
+  wth = wtap_open_offline(search->filename, search->open_type, &err, &err_info, TRUE);
+  if (wth == NULL) {
+    g_free(err_info);
+    worker->failed = TRUE;
+  } else {
+    wtap_rec_init(&rec);
+    ws_buffer_init(&buf, 1514);
+
+    for (num = worker->first; num <= worker->last; num++) {
+      const frame_loc_t *loc = &search->locs[num - 1];
+
+      if (g_atomic_int_get(&search->stop)) {
+        worker->failed = TRUE;
+        break;
+      }
+      if (!wtap_seek_read(wth, loc->offset, &rec, &buf, &err, &err_info)) {
+        g_free(err_info);
+        err_info = NULL;
+        worker->failed = TRUE;
+        break;
+      }
+      if (frame_bytes_pattern_match(search->pattern, ws_buffer_start_ptr(&buf),
+                                    MIN(loc->cap_len, (guint32)ws_buffer_length(&buf)),
+                                    &last_pos)) {
+        match_t match;
+
+        match.framenum = num;
+        match.last_pos = last_pos;
+        g_array_append_val(worker->matches, match);
+      }
+      if (++since_progress == PROGRESS_FRAMES) {
+        g_atomic_int_add(&search->frames_done, since_progress);
+        since_progress = 0;
+      }
+    }
+    g_atomic_int_add(&search->frames_done, since_progress);
+
+    wtap_rec_cleanup(&rec);
+    ws_buffer_free(&buf);
+    wtap_close(wth);
+  }
+
+  g_mutex_lock(&search->mutex);
+  search->running--;
+  g_cond_signal(&search->cond);
+  g_mutex_unlock(&search->mutex);
+  return NULL;
+}
+
+frame_bytes_search_t *
+frame_bytes_search_start(const frame_bytes_pattern_t *pattern, const char *filename,
+                         unsigned int open_type, frame_data_sequence *frames, guint32 frame_count)
+{
+  frame_bytes_search_t *search;
+  guint32               num;
+  guint                 i;
+
+  search = g_new0(frame_bytes_search_t, 1);
+  search->pattern = pattern_copy(pattern);
+  search->filename = g_strdup(filename);
+  search->open_type = open_type;
+  search->frame_count = frame_count;
+  search->matches = g_array_new(FALSE, FALSE, sizeof(match_t));
+  g_mutex_init(&search->mutex);
+  g_cond_init(&search->cond);
+
+  search->locs = g_new(frame_loc_t, frame_count ? frame_count : 1);
+  for (num = 1; num <= frame_count; num++) {
+    const frame_data *fdata = frame_data_sequence_find(frames, num);
+
+    search->locs[num - 1].offset = fdata->file_off;
+    search->locs[num - 1].cap_len = fdata->cap_len;
+  }
+
+  search->num_workers = MIN((guint)g_get_num_processors(), frame_count / MIN_WORKER_FRAMES + 1);
+  search->workers = g_new0(worker_t, search->num_workers);
+  search->threads = g_new0(GThread *, search->num_workers);
+  search->running = search->num_workers;
+  for (i = 0; i < search->num_workers; i++) {
+    worker_t *worker = &search->workers[i];
+
+    worker->search = search;
+    worker->first = (guint32)((guint64)frame_count * i / search->num_workers) + 1;
+    worker->last = (guint32)((guint64)frame_count * (i + 1) / search->num_workers);
+    worker->matches = g_array_new(FALSE, FALSE, sizeof(match_t));
+    search->threads[i] = g_thread_new("frame bytes search", search_worker, worker);
+  }
+  return search;
+}
+
+/* Join the workers and gather their matches, once they've all finished. */
+static void
+join_workers(frame_bytes_search_t *search)
+{
+  guint i;
+
+  if (search->joined)
+    return;
+
+  search->succeeded = TRUE;
+  for (i = 0; i < search->num_workers; i++) {
+    worker_t *worker = &search->workers[i];
+
+    g_thread_join(search->threads[i]);
+    if (worker->failed)
+      search->succeeded = FALSE;
+    g_array_append_vals(search->matches, worker->matches->data, worker->matches->len);
+    g_array_free(worker->matches, TRUE);
+  }
+  g_free(search->workers);
+  search->workers = NULL;
+  g_free(search->threads);
+  search->threads = NULL;
+  g_free(search->locs);
+  search->locs = NULL;
+  search->joined = TRUE;
+}
+
+gboolean
+frame_bytes_search_wait(frame_bytes_search_t *search, gint64 timeout)
+{
+  gint64   end_time = g_get_monotonic_time() + timeout;
+  gboolean finished;
+
+  g_mutex_lock(&search->mutex);
+  while (search->running > 0) {
+    if (!g_cond_wait_until(&search->cond, &search->mutex, end_time))
+      break;
+  }
+  finished = search->running == 0;
+  g_mutex_unlock(&search->mutex);
+
+  if (finished)
+    join_workers(search);
+  return finished;
+}
+
+guint32
+frame_bytes_search_frames_done(const frame_bytes_search_t *search)
+{
+  return (guint32)g_atomic_int_get(&search->frames_done);
+}
+
+gboolean
+frame_bytes_search_succeeded(const frame_bytes_search_t *search)
+{
+  return search->joined && search->succeeded;
+}
+
+gboolean
+frame_bytes_search_is_for(const frame_bytes_search_t *search,
+                          const frame_bytes_pattern_t *pattern, guint32 frame_count)
+{
+  return frame_bytes_search_succeeded(search) && search->frame_count == frame_count &&
+         pattern_equal(search->pattern, pattern);
+}
+
+static int
+compare_match_frames(const void *key, const void *element)
+{
+  guint32 framenum = *(const guint32 *)key;
+  guint32 match_num = ((const match_t *)element)->framenum;
+
+  return framenum < match_num ? -1 : (framenum > match_num ? 1 : 0);
+}
+
+gboolean
+frame_bytes_search_matched(const frame_bytes_search_t *search, guint32 framenum,
+                           guint32 *last_pos)
+{
+  const match_t *match;
+
+  match = (const match_t *)bsearch(&framenum, search->matches->data, search->matches->len,
+                                   sizeof(match_t), compare_match_frames);
+  if (match == NULL)
+    return FALSE;
+  *last_pos = match->last_pos;
+  return TRUE;
+}
+
+void
+frame_bytes_search_free(frame_bytes_search_t *search)
+{
+  if (search == NULL)
+    return;
+
+  g_atomic_int_set(&search->stop, 1);
+  join_workers(search);
+  g_mutex_clear(&search->mutex);
+  g_cond_clear(&search->cond);
+  g_array_free(search->matches, TRUE);
+  frame_bytes_pattern_free(search->pattern);
+  g_free(search->filename);
+  g_free(search);
+}
@@ -0,0 +1,112 @@
+/* frame_bytes_search.h
+ * Definitions for searching the bytes of frames
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __FRAME_BYTES_SEARCH_H__
+#define __FRAME_BYTES_SEARCH_H__
+
+#include <epan/frame_data_sequence.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* How a pattern is matched against the bytes of a frame */
+typedef enum {
+  FRAME_BYTES_EXACT,              /* byte for byte: hex values and narrow strings */
+  FRAME_BYTES_WIDE,               /* against every other byte: wide strings */
+  FRAME_BYTES_NARROW_AND_WIDE     /* ignoring NUL bytes: either kind of string */
+} frame_bytes_mode_e;
+
+typedef struct frame_bytes_pattern frame_bytes_pattern_t;
+
+/** Create a pattern.
+ *
+ * @param data the bytes to look for; for a search that ignores case, they
+ * must already be in upper case
+ * @param len their number, at least 1
+ * @param mode how to match them
+ * @param nocase TRUE to ignore ASCII case
+ */
+extern frame_bytes_pattern_t *frame_bytes_pattern_new(const guint8 *data, size_t len,
+                                                      frame_bytes_mode_e mode, gboolean nocase);
+
+extern void frame_bytes_pattern_free(frame_bytes_pattern_t *pattern);
+
+/** Look for the first match of a pattern in some bytes.
+ *
+ * @param pattern the pattern
+ * @param data the bytes
+ * @param len their number
+ * @param[out] last_pos the offset of the last byte of the match
+ * @return TRUE if the pattern matched
+ */
+extern gboolean frame_bytes_pattern_match(const frame_bytes_pattern_t *pattern,
+                                          const guint8 *data, guint32 len, guint32 *last_pos);
+
+/*
+ * A frame bytes search matches a pattern against every frame of a
+ * capture file, on as many threads as there are processors, each reading
+ * the file through its own wtap handle, and keeps every match, so that
+ * finding the next or previous one is a lookup.
+ *
+ * The offsets and lengths of the frames are copied when the search
+ * starts, so the frames can change, or the file be closed, while it runs.
+ */
+typedef struct frame_bytes_search frame_bytes_search_t;
+
+/** Start searching all the frames of a capture file.
+ *
+ * @param pattern the pattern, which is copied
+ * @param filename the file's name
+ * @param open_type the type to open it as, or WTAP_TYPE_AUTO
+ * @param frames the frames read from it
+ * @param frame_count their number
+ */
+extern frame_bytes_search_t *frame_bytes_search_start(const frame_bytes_pattern_t *pattern,
+                                                      const char *filename, unsigned int open_type,
+                                                      frame_data_sequence *frames, guint32 frame_count);
+
+/** Wait for a search to finish.
+ *
+ * @param search the search
+ * @param timeout the longest time to wait, in microseconds
+ * @return TRUE if it has finished
+ */
+extern gboolean frame_bytes_search_wait(frame_bytes_search_t *search, gint64 timeout);
+
+/** Get the number of frames searched so far. */
+extern guint32 frame_bytes_search_frames_done(const frame_bytes_search_t *search);
+
+/** Did a finished search read all the frames?  If not, a frame couldn't
+ * be read, and the search can't be used. */
+extern gboolean frame_bytes_search_succeeded(const frame_bytes_search_t *search);
+
+/** Is a finished search for a pattern, over a given number of frames? */
+extern gboolean frame_bytes_search_is_for(const frame_bytes_search_t *search,
+                                          const frame_bytes_pattern_t *pattern, guint32 frame_count);
+
+/** Did the pattern of a finished search match a frame?
+ *
+ * @param search the search
+ * @param framenum the frame number
+ * @param[out] last_pos the offset of the last byte of its first match
+ * @return TRUE if it did
+ */
+extern gboolean frame_bytes_search_matched(const frame_bytes_search_t *search,
+                                           guint32 framenum, guint32 *last_pos);
+
+/** Free a search, stopping it first if it's still running. */
+extern void frame_bytes_search_free(frame_bytes_search_t *search);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __FRAME_BYTES_SEARCH_H__ */
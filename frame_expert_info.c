@@ -0,0 +1,167 @@
+/* frame_expert_info.c
+ * Routines for the expert information of the frames of a capture file
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <glib.h>
+
+#include <epan/packet.h>
+#include <epan/expert.h>
+#include <epan/tap.h>
+#include <wsutil/glib-compat.h>
+
+#include "frame_expert_info.h"
+
+/* What the items of one kind have in common. */
+typedef struct {
+  int          severity;
+  int          group;
+  int          hf_index;
+  const gchar *protocol;      /* interned */
+} item_kind_t;
+
+typedef struct {
+  guint32      framenum;
+  guint32      kind;          /* index into kinds */
+  const gchar *summary;       /* interned */
+} item_t;
+
+struct frame_expert_info {
+  guint32       frame_count;
+  GArray       *items;        /* item_t, in the order they were added */
+  GPtrArray    *kinds;        /* item_kind_t, indexed by kind number */
+  GHashTable   *kind_numbers; /* item_kind_t in kinds -> kind number + 1 */
+  GStringChunk *strings;
+};
+
+static guint
+item_kind_hash(gconstpointer key)
+{
+  const item_kind_t *kind = (const item_kind_t *)key;
+
+  /* The protocol is interned, so its address will do. */
+  return g_direct_hash(kind->protocol) ^
+         (guint)((kind->severity << 24) ^ (kind->group << 12) ^ kind->hf_index);
+}
+
+static gboolean
+item_kind_equal(gconstpointer a, gconstpointer b)
+{
+  const item_kind_t *ka = (const item_kind_t *)a;
+  const item_kind_t *kb = (const item_kind_t *)b;
+
+  return ka->severity == kb->severity && ka->group == kb->group &&
+         ka->hf_index == kb->hf_index && ka->protocol == kb->protocol;
+}
+
+static tap_packet_status
+expert_info_packet(void *tapdata, packet_info *pinfo,
+                   epan_dissect_t *edt _U_, const void *data)
+{
+  frame_expert_info_t *ei = (frame_expert_info_t *)tapdata;
+  const expert_info_t *ti = (const expert_info_t *)data;
+  item_kind_t kind;
+  item_t item;
+  gpointer value;
+
+  /* Only keep what's reported for the frame being added. */
+  if (ti == NULL || pinfo->num != ei->frame_count + 1)
+    return TAP_PACKET_DONT_REDRAW;
+
+  kind.severity = ti->severity;
+  kind.group = ti->group;
+  kind.hf_index = ti->hf_index;
+  kind.protocol = g_string_chunk_insert_const(ei->strings,
+                                              ti->protocol != NULL ? ti->protocol : "");
+  value = g_hash_table_lookup(ei->kind_numbers, &kind);
+  if (value != NULL) {
+    item.kind = GPOINTER_TO_UINT(value) - 1;
+  } else {
+    item_kind_t *new_kind = (item_kind_t *)g_memdup2(&kind, sizeof kind);
+
+    item.kind = ei->kinds->len;
+    g_ptr_array_add(ei->kinds, new_kind);
+    g_hash_table_insert(ei->kind_numbers, new_kind, GUINT_TO_POINTER(item.kind + 1));
+  }
+  item.framenum = pinfo->num;
+  item.summary = g_string_chunk_insert_const(ei->strings,
+                                             ti->summary != NULL ? ti->summary : "");
+  g_array_append_val(ei->items, item);
+
+  return TAP_PACKET_DONT_REDRAW;
+}
+
+frame_expert_info_t *
+frame_expert_info_new(void)
+{
+  frame_expert_info_t *ei = g_new0(frame_expert_info_t, 1);
+  GString *error_string;
+
+  error_string = register_tap_listener("expert", ei, NULL, TL_IS_DISSECTOR_HELPER,
+                                       NULL, expert_info_packet, NULL, NULL);
+  if (error_string != NULL) {
+    g_string_free(error_string, TRUE);
+    g_free(ei);
+    return NULL;
+  }
+
+  ei->items = g_array_new(FALSE, FALSE, sizeof(item_t));
+  ei->kinds = g_ptr_array_new_with_free_func(g_free);
+  ei->kind_numbers = g_hash_table_new(item_kind_hash, item_kind_equal);
+  ei->strings = g_string_chunk_new(4096);
+  return ei;
+}
+
+void
+frame_expert_info_free(frame_expert_info_t *ei)
+{
+  if (ei == NULL)
+    return;
+  remove_tap_listener(ei);
+  g_array_free(ei->items, TRUE);
+  g_ptr_array_free(ei->kinds, TRUE);
+  g_hash_table_destroy(ei->kind_numbers);
+  g_string_chunk_free(ei->strings);
+  g_free(ei);
+}
+
+guint32
+frame_expert_info_frame_count(const frame_expert_info_t *ei)
+{
+  return ei->frame_count;
+}
+
+void
+frame_expert_info_frame_done(frame_expert_info_t *ei)
+{
+  ei->frame_count++;
+}
+
+guint
+frame_expert_info_item_count(const frame_expert_info_t *ei)
+{
+  return ei->items->len;
+}
+
+void
+frame_expert_info_get_item(const frame_expert_info_t *ei, guint i,
+                           expert_info_t *item)
+{
+  const item_t *it = &g_array_index(ei->items, item_t, i);
+  const item_kind_t *kind = (const item_kind_t *)g_ptr_array_index(ei->kinds, it->kind);
+
+  item->packet_num = it->framenum;
+  item->group = kind->group;
+  item->severity = kind->severity;
+  item->hf_index = kind->hf_index;
+  item->protocol = kind->protocol;
+  item->summary = (gchar *)it->summary;
+  item->pitem = NULL;
+}
@@ -0,0 +1,70 @@
+/* frame_expert_info.h
+ * Definitions for the expert information of the frames of a capture file
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __FRAME_EXPERT_INFO_H__
+#define __FRAME_EXPERT_INFO_H__
+
+#include <epan/expert.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * A frame expert info store keeps the expert information items that are
+ * added while each frame is dissected for the first time, as the "expert"
+ * tap reports them, so that the Expert Information dialog can be filled
+ * in without dissecting all the frames again.
+ *
+ * The severity, group, field and protocol of the items take only a few
+ * distinct combinations, each of which is stored once, with a count of
+ * its items; the protocol names and summaries are interned, so an item
+ * costs little more than its frame number.
+ */
+typedef struct frame_expert_info frame_expert_info_t;
+
+/** Create a store, listening to the "expert" tap.
+ *
+ * @return the store, or NULL if the tap couldn't be listened to
+ */
+extern frame_expert_info_t *frame_expert_info_new(void);
+
+/** Stop listening and free a store; ei may be NULL. */
+extern void frame_expert_info_free(frame_expert_info_t *ei);
+
+/** Get the number of frames in the store; the items of frames 1 through
+ * that number have been added. */
+extern guint32 frame_expert_info_frame_count(const frame_expert_info_t *ei);
+
+/** Finish adding the next frame, after it has been dissected with taps.
+ * Items reported for any other frame are ignored.
+ *
+ * @param ei the store
+ */
+extern void frame_expert_info_frame_done(frame_expert_info_t *ei);
+
+/** Get the number of items in the store. */
+extern guint frame_expert_info_item_count(const frame_expert_info_t *ei);
+
+/** Get an item, in the order in which the items were added.
+ *
+ * @param ei the store
+ * @param i the index of the item, less than frame_expert_info_item_count()
+ * @param[out] item filled in with the item; its strings belong to the
+ * store, and pitem is NULL
+ */
+extern void frame_expert_info_get_item(const frame_expert_info_t *ei, guint i,
+                                       expert_info_t *item);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __FRAME_EXPERT_INFO_H__ */
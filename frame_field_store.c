@@ -0,0 +1,438 @@
+/* frame_field_store.c
+ * Routines for the per-frame store of field values
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/epan.h>
+#include <epan/proto.h>
+#include <epan/ipv4.h>
+#include <epan/ftypes/ftypes.h>
+
+#include "frame_field_store.h"
+
+/* Frames per block; the values of the block being filled are kept as they
+   are until it is full. */
+#define BLOCK_FRAMES 1024
+
+/* The values of a block, less their smallest one, "base", each in
+   "width" bytes; no data is needed if they are all the same. */
+typedef struct {
+  gint64   base;
+  guint    width;
+  guint8  *data;
+} packed_values_t;
+
+enum { VAL_COUNT, VAL_SUM, VAL_MIN, VAL_MAX, NUM_VALS };
+
+typedef struct {
+  packed_values_t vals[NUM_VALS];
+} block_t;
+
+typedef struct {
+  int          hf_index;
+  ftenum_t     ftype;
+  GArray      *blocks;                  /* block_t, of the full blocks */
+  gint64       open[NUM_VALS][BLOCK_FRAMES];
+} column_t;
+
+struct frame_field_store {
+  GPtrArray   *columns;                 /* column_t */
+  guint32      frame_count;
+  gsize        memory;
+};
+
+static gboolean
+storable_ftype(ftenum_t ftype)
+{
+  switch (ftype) {
+
+  case FT_NONE:
+  case FT_PROTOCOL:
+  case FT_BOOLEAN:
+  case FT_UINT8:
+  case FT_UINT16:
+  case FT_UINT24:
+  case FT_UINT32:
+  case FT_UINT40:
+  case FT_UINT48:
+  case FT_UINT56:
+  case FT_UINT64:
+  case FT_INT8:
+  case FT_INT16:
+  case FT_INT24:
+  case FT_INT32:
+  case FT_INT40:
+  case FT_INT48:
+  case FT_INT56:
+  case FT_INT64:
+  case FT_FRAMENUM:
+  case FT_IPv4:
+    return TRUE;
+
+  default:
+    return FALSE;
+  }
+}
+
+static void
+free_column(gpointer data)
+{
+  column_t *column = (column_t *)data;
+  guint     i, v;
+
+  for (i = 0; i < column->blocks->len; i++) {
+    block_t *block = &g_array_index(column->blocks, block_t, i);
+
+    for (v = 0; v < NUM_VALS; v++)
+      g_free(block->vals[v].data);
+  }
+  g_array_free(column->blocks, TRUE);
+  g_free(column);
+}
+
+frame_field_store_t *
+frame_field_store_new(const char *fields)
+{
+  frame_field_store_t *store;
+  gchar              **names;
+  guint                i;
+
+  store = g_new(frame_field_store_t, 1);
+  store->columns = g_ptr_array_new_with_free_func(free_column);
+  store->frame_count = 0;
+  store->memory = sizeof(frame_field_store_t);
+
+  names = g_strsplit_set(fields ? fields : "", ", \t", -1);
+  for (i = 0; names[i] != NULL; i++) {
+    header_field_info *hfinfo;
+    column_t          *column;
+
+    if (names[i][0] == '\0')
+      continue;
+    hfinfo = proto_registrar_get_byname(names[i]);
+    if (hfinfo == NULL || !storable_ftype(hfinfo->type) ||
+        frame_field_store_find_column(store, hfinfo->id) >= 0)
+      continue;
+
+    column = g_new(column_t, 1);
+    column->hf_index = hfinfo->id;
+    column->ftype = hfinfo->type;
+    column->blocks = g_array_new(FALSE, FALSE, sizeof(block_t));
+    g_ptr_array_add(store->columns, column);
+    store->memory += sizeof(column_t);
+  }
+  g_strfreev(names);
+
+  if (store->columns->len == 0) {
+    frame_field_store_free(store);
+    return NULL;
+  }
+  return store;
+}
+
+void
+frame_field_store_free(frame_field_store_t *store)
+{
+  if (store == NULL)
+    return;
+  g_ptr_array_free(store->columns, TRUE);
+  g_free(store);
+}
+
+guint32
+frame_field_store_frame_count(const frame_field_store_t *store)
+{
+  return store->frame_count;
+}
+
+int
+frame_field_store_find_column(const frame_field_store_t *store, int hf_index)
+{
+  guint i;
+
+  for (i = 0; i < store->columns->len; i++) {
+    if (((const column_t *)g_ptr_array_index(store->columns, i))->hf_index == hf_index)
+      return (int)i;
+  }
+  return -1;
+}
+
+void
+frame_field_store_prime_edt(const frame_field_store_t *store, epan_dissect_t *edt)
+{
+  guint i;
+
+  for (i = 0; i < store->columns->len; i++)
+    epan_dissect_prime_with_hfid(edt, ((const column_t *)g_ptr_array_index(store->columns, i))->hf_index);
+}
+
+static inline gint64
+packed_value(const packed_values_t *packed, guint i)
+{
+  switch (packed->width) {
+
+  case 0:
+    return packed->base;
+
+  case 1:
+    return packed->base + packed->data[i];
+
+  case 2:
+  {
+    guint16 delta;
+
+    memcpy(&delta, packed->data + i * 2, 2);
+    return packed->base + delta;
+  }
+
+  case 4:
+  {
+    guint32 delta;
+
+    memcpy(&delta, packed->data + i * 4, 4);
+    return packed->base + delta;
+  }
+
+  default:
+  {
+    guint64 delta;
+
+    memcpy(&delta, packed->data + i * 8, 8);
+    return (gint64)((guint64)packed->base + delta);
+  }
+  }
+}
+
+static gsize
+pack_values(packed_values_t *packed, const gint64 *values)
+{
+  gint64  min = values[0], max = values[0];
+  guint64 range;
+  guint   i;
+
+  for (i = 1; i < BLOCK_FRAMES; i++) {
+    if (values[i] < min)
+      min = values[i];
+    if (values[i] > max)
+      max = values[i];
+  }
+  range = (guint64)max - (guint64)min;
+
+  packed->base = min;
+  if (range == 0)
+    packed->width = 0;
+  else if (range <= G_MAXUINT8)
+    packed->width = 1;
+  else if (range <= G_MAXUINT16)
+    packed->width = 2;
+  else if (range <= G_MAXUINT32)
+    packed->width = 4;
+  else
+    packed->width = 8;
+
+  if (packed->width == 0) {
+    packed->data = NULL;
+    return 0;
+  }
+
+  packed->data = (guint8 *)g_malloc(BLOCK_FRAMES * packed->width);
+  for (i = 0; i < BLOCK_FRAMES; i++) {
+    guint64 delta = (guint64)values[i] - (guint64)min;
+
+    switch (packed->width) {
+
+    case 1:
+      packed->data[i] = (guint8)delta;
+      break;
+
+    case 2:
+    {
+      guint16 d16 = (guint16)delta;
+
+      memcpy(packed->data + i * 2, &d16, 2);
+      break;
+    }
+
+    case 4:
+    {
+      guint32 d32 = (guint32)delta;
+
+      memcpy(packed->data + i * 4, &d32, 4);
+      break;
+    }
+
+    default:
+      memcpy(packed->data + i * 8, &delta, 8);
+      break;
+    }
+  }
+  return BLOCK_FRAMES * packed->width;
+}
+
+static gint64
+field_value(const field_info *fi, ftenum_t ftype)
+{
+  switch (ftype) {
+
+  case FT_NONE:
+  case FT_PROTOCOL:
+    return 1;
+
+  case FT_BOOLEAN:
+  case FT_UINT40:
+  case FT_UINT48:
+  case FT_UINT56:
+  case FT_UINT64:
+    return (gint64)fvalue_get_uinteger64(&fi->value);
+
+  case FT_INT8:
+  case FT_INT16:
+  case FT_INT24:
+  case FT_INT32:
+    return fvalue_get_sinteger(&fi->value);
+
+  case FT_INT40:
+  case FT_INT48:
+  case FT_INT56:
+  case FT_INT64:
+    return fvalue_get_sinteger64(&fi->value);
+
+  case FT_IPv4:
+    return ((const ipv4_addr_and_mask *)fvalue_get(&fi->value))->addr;
+
+  default:
+    return fvalue_get_uinteger(&fi->value);
+  }
+}
+
+void
+frame_field_store_add(frame_field_store_t *store, epan_dissect_t *edt)
+{
+  guint slot = store->frame_count % BLOCK_FRAMES;
+  guint c, i, v;
+
+  for (c = 0; c < store->columns->len; c++) {
+    column_t  *column = (column_t *)g_ptr_array_index(store->columns, c);
+    GPtrArray *finfos = edt->tree ? proto_get_finfo_ptr_array(edt->tree, column->hf_index) : NULL;
+    gint64     count = 0, sum = 0, min = 0, max = 0;
+
+    if (finfos != NULL) {
+      for (i = 0; i < finfos->len; i++) {
+        gint64 value = field_value((field_info *)g_ptr_array_index(finfos, i), column->ftype);
+
+        if (count == 0 || value < min)
+          min = value;
+        if (count == 0 || value > max)
+          max = value;
+        sum += value;
+        count++;
+      }
+    }
+    column->open[VAL_COUNT][slot] = count;
+    column->open[VAL_SUM][slot] = sum;
+    column->open[VAL_MIN][slot] = min;
+    column->open[VAL_MAX][slot] = max;
+
+    if (slot == BLOCK_FRAMES - 1) {
+      block_t block;
+
+      for (v = 0; v < NUM_VALS; v++)
+        store->memory += pack_values(&block.vals[v], column->open[v]);
+      g_array_append_val(column->blocks, block);
+      store->memory += sizeof(block_t);
+    }
+  }
+  store->frame_count++;
+}
+
+void
+frame_field_store_get(const frame_field_store_t *store, int column_num,
+                      guint32 framenum, frame_field_values_t *values)
+{
+  const column_t *column = (const column_t *)g_ptr_array_index(store->columns, column_num);
+  guint           block_num = (framenum - 1) / BLOCK_FRAMES;
+  guint           slot = (framenum - 1) % BLOCK_FRAMES;
+
+  g_assert(framenum >= 1 && framenum <= store->frame_count);
+
+  if (block_num < column->blocks->len) {
+    const block_t *block = &g_array_index(column->blocks, block_t, block_num);
+
+    values->count = (guint64)packed_value(&block->vals[VAL_COUNT], slot);
+    values->sum = packed_value(&block->vals[VAL_SUM], slot);
+    values->min = packed_value(&block->vals[VAL_MIN], slot);
+    values->max = packed_value(&block->vals[VAL_MAX], slot);
+  } else {
+    values->count = (guint64)column->open[VAL_COUNT][slot];
+    values->sum = column->open[VAL_SUM][slot];
+    values->min = column->open[VAL_MIN][slot];
+    values->max = column->open[VAL_MAX][slot];
+  }
+}
+
+void
+frame_field_store_scan(const frame_field_store_t *store, int column_num,
+                       guint32 first, guint32 last,
+                       frame_field_scan_cb cb, void *user_data)
+{
+  const column_t      *column = (const column_t *)g_ptr_array_index(store->columns, column_num);
+  frame_field_values_t values;
+  guint32              framenum;
+  guint                block_num, slot;
+
+  if (first < 1)
+    first = 1;
+  if (last > store->frame_count)
+    last = store->frame_count;
+
+  for (framenum = first; framenum <= last; ) {
+    block_num = (framenum - 1) / BLOCK_FRAMES;
+    slot = (framenum - 1) % BLOCK_FRAMES;
+
+    if (block_num < column->blocks->len) {
+      const block_t *block = &g_array_index(column->blocks, block_t, block_num);
+
+      if (block->vals[VAL_COUNT].width == 0 && block->vals[VAL_COUNT].base == 0) {
+        /* The field occurred in none of the block's frames. */
+        framenum += BLOCK_FRAMES - slot;
+        continue;
+      }
+      for (; slot < BLOCK_FRAMES && framenum <= last; slot++, framenum++) {
+        values.count = (guint64)packed_value(&block->vals[VAL_COUNT], slot);
+        if (values.count == 0)
+          continue;
+        values.sum = packed_value(&block->vals[VAL_SUM], slot);
+        values.min = packed_value(&block->vals[VAL_MIN], slot);
+        values.max = packed_value(&block->vals[VAL_MAX], slot);
+        cb(framenum, &values, user_data);
+      }
+    } else {
+      for (; framenum <= last; slot++, framenum++) {
+        values.count = (guint64)column->open[VAL_COUNT][slot];
+        if (values.count == 0)
+          continue;
+        values.sum = column->open[VAL_SUM][slot];
+        values.min = column->open[VAL_MIN][slot];
+        values.max = column->open[VAL_MAX][slot];
+        cb(framenum, &values, user_data);
+      }
+    }
+  }
+}
+
+gsize
+frame_field_store_memory(const frame_field_store_t *store)
+{
+  return store->memory;
+}
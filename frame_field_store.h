@@ -0,0 +1,111 @@
+/* frame_field_store.h
+ * Definitions for the per-frame store of field values
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __FRAME_FIELD_STORE_H__
+#define __FRAME_FIELD_STORE_H__
+
+#include <epan/epan_dissect.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * A frame field store keeps, for each frame and for each of a few fields
+ * chosen by the user, what the statistics need of the values the field had
+ * in the frame: how many there were, their sum, the smallest and the
+ * largest.  It is filled in during the first pass, so that graphs and
+ * tables of those fields can be computed again, for instance with another
+ * interval, by scanning it rather than by dissecting the frames again.
+ *
+ * Only fields with integral values are kept: integers, booleans, frame
+ * numbers and IPv4 addresses, and fields without a value, such as most
+ * expert info flags, whose every occurrence counts as 1.
+ *
+ * The values are kept column by column, in blocks of consecutive frames,
+ * each block with the difference of each value from the block's smallest
+ * one, in as few bytes as the largest difference needs; the values of
+ * most fields vary little from frame to frame, so that this usually takes
+ * a byte or two per value.
+ */
+typedef struct frame_field_store frame_field_store_t;
+
+/* The values of a field in a frame */
+typedef struct {
+  guint64 count;   /* number of occurrences; the others are 0 if this is */
+  gint64  sum;
+  gint64  min;
+  gint64  max;
+} frame_field_values_t;
+
+/** Create a store for some fields.
+ *
+ * @param fields the fields' names, separated by commas or spaces
+ * @return the store, or NULL if none of the fields can be kept
+ */
+extern frame_field_store_t *frame_field_store_new(const char *fields);
+
+extern void frame_field_store_free(frame_field_store_t *store);
+
+/** Get the number of frames in the store; frames 1 through that number
+ * have been added. */
+extern guint32 frame_field_store_frame_count(const frame_field_store_t *store);
+
+/** Get the column of a field in the store.
+ *
+ * @param store the store
+ * @param hf_index the field
+ * @return the column, or -1 if the field isn't kept
+ */
+extern int frame_field_store_find_column(const frame_field_store_t *store, int hf_index);
+
+/** Ask for the fields of the store to be kept in the tree of the next
+ * frame, before dissecting it. */
+extern void frame_field_store_prime_edt(const frame_field_store_t *store, epan_dissect_t *edt);
+
+/** Add the next frame to the store, after it has been dissected with an
+ * epan_dissect_t primed with frame_field_store_prime_edt(). */
+extern void frame_field_store_add(frame_field_store_t *store, epan_dissect_t *edt);
+
+/** Get the values of a field in a frame.
+ *
+ * @param store the store
+ * @param column the field's column
+ * @param framenum the frame number, no greater than frame_field_store_frame_count()
+ * @param[out] values the values
+ */
+extern void frame_field_store_get(const frame_field_store_t *store, int column,
+                                  guint32 framenum, frame_field_values_t *values);
+
+typedef void (*frame_field_scan_cb)(guint32 framenum, const frame_field_values_t *values, void *user_data);
+
+/** Call a function for each frame of a range in which a field occurred, in
+ * frame order; this decodes the blocks of the column one at a time, and is
+ * much faster than getting the frames' values one by one.
+ *
+ * @param store the store
+ * @param column the field's column
+ * @param first the first frame number
+ * @param last the last frame number, no greater than frame_field_store_frame_count()
+ * @param cb the function
+ * @param user_data passed to it
+ */
+extern void frame_field_store_scan(const frame_field_store_t *store, int column,
+                                   guint32 first, guint32 last,
+                                   frame_field_scan_cb cb, void *user_data);
+
+/** Get the memory taken by the store, in bytes. */
+extern gsize frame_field_store_memory(const frame_field_store_t *store);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __FRAME_FIELD_STORE_H__ */
@@ -0,0 +1,128 @@
+/* frame_proto_hier.c
+ * Routines for the protocol hierarchy of the frames of a capture file
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <glib.h>
+
+#include <epan/epan_dissect.h>
+
+#include "ui/proto_hier_stats.h"
+
+#include "frame_proto_hier.h"
+
+/* An item of a stored stack. */
+typedef struct {
+  int          hf_id;
+  gint32       len_delta;     /* the frame's length minus the item's */
+} stack_item_t;
+
+struct frame_proto_hier {
+  GArray      *frame_stacks;  /* stack number of each frame, indexed by frame number - 1 */
+  GPtrArray   *stacks;        /* GBytes of stack_item_t, indexed by stack number */
+  GHashTable  *stack_numbers; /* GBytes in stacks -> stack number + 1 */
+  GArray      *scratch;       /* ph_stack_item_t, for getting a tree's stack */
+  GArray      *scratch_items; /* stack_item_t, for building them */
+};
+
+frame_proto_hier_t *
+frame_proto_hier_new(void)
+{
+  frame_proto_hier_t *ph = g_new(frame_proto_hier_t, 1);
+
+  ph->frame_stacks = g_array_new(FALSE, FALSE, sizeof(guint32));
+  ph->stacks = g_ptr_array_new_with_free_func((GDestroyNotify)g_bytes_unref);
+  ph->stack_numbers = g_hash_table_new(g_bytes_hash, g_bytes_equal);
+  ph->scratch = g_array_new(FALSE, FALSE, sizeof(ph_stack_item_t));
+  ph->scratch_items = g_array_new(FALSE, FALSE, sizeof(stack_item_t));
+  return ph;
+}
+
+void
+frame_proto_hier_free(frame_proto_hier_t *ph)
+{
+  if (ph == NULL)
+    return;
+  g_array_free(ph->frame_stacks, TRUE);
+  g_hash_table_destroy(ph->stack_numbers);
+  g_ptr_array_free(ph->stacks, TRUE);
+  g_array_free(ph->scratch, TRUE);
+  g_array_free(ph->scratch_items, TRUE);
+  g_free(ph);
+}
+
+guint32
+frame_proto_hier_frame_count(const frame_proto_hier_t *ph)
+{
+  return ph->frame_stacks->len;
+}
+
+void
+frame_proto_hier_prime_edt(const frame_proto_hier_t *ph, epan_dissect_t *edt,
+                           guint32 framenum)
+{
+  /* Faking protocols is a setting of the tree, so set it either way. */
+  epan_dissect_fake_protocols(edt, framenum != ph->frame_stacks->len + 1);
+}
+
+void
+frame_proto_hier_add(frame_proto_hier_t *ph, const epan_dissect_t *edt)
+{
+  GBytes  *key;
+  gpointer value;
+  guint32  stack_num;
+  guint    i;
+
+  g_array_set_size(ph->scratch, 0);
+  if (edt->tree != NULL)
+    ph_stats_get_stack(edt->tree, ph->scratch);
+
+  g_array_set_size(ph->scratch_items, ph->scratch->len);
+  for (i = 0; i < ph->scratch->len; i++) {
+    const ph_stack_item_t *item = &g_array_index(ph->scratch, ph_stack_item_t, i);
+    stack_item_t *stored = &g_array_index(ph->scratch_items, stack_item_t, i);
+
+    stored->hf_id = item->hf_id;
+    stored->len_delta = (gint32)(edt->pi.fd->pkt_len - (guint32)item->length);
+  }
+
+  key = g_bytes_new(ph->scratch_items->data, ph->scratch_items->len * sizeof(stack_item_t));
+  value = g_hash_table_lookup(ph->stack_numbers, key);
+  if (value != NULL) {
+    stack_num = GPOINTER_TO_UINT(value) - 1;
+    g_bytes_unref(key);
+  } else {
+    stack_num = ph->stacks->len;
+    g_ptr_array_add(ph->stacks, key);
+    g_hash_table_insert(ph->stack_numbers, key, GUINT_TO_POINTER(stack_num + 1));
+  }
+  g_array_append_val(ph->frame_stacks, stack_num);
+}
+
+void
+frame_proto_hier_get(const frame_proto_hier_t *ph, const frame_data *fdata,
+                     GArray *stack)
+{
+  guint32             stack_num = g_array_index(ph->frame_stacks, guint32, fdata->num - 1);
+  GBytes             *bytes = (GBytes *)g_ptr_array_index(ph->stacks, stack_num);
+  const stack_item_t *stored;
+  gsize               size;
+  guint               i, n;
+
+  stored = (const stack_item_t *)g_bytes_get_data(bytes, &size);
+  n = (guint)(size / sizeof(stack_item_t));
+  g_array_set_size(stack, n);
+  for (i = 0; i < n; i++) {
+    ph_stack_item_t *item = &g_array_index(stack, ph_stack_item_t, i);
+
+    item->hf_id = stored[i].hf_id;
+    item->length = (gint)(fdata->pkt_len - (guint32)stored[i].len_delta);
+  }
+}
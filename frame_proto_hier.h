@@ -0,0 +1,74 @@
+/* frame_proto_hier.h
+ * Definitions for the protocol hierarchy of the frames of a capture file
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __FRAME_PROTO_HIER_H__
+#define __FRAME_PROTO_HIER_H__
+
+#include <epan/epan_dissect.h>
+#include <epan/frame_data.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * A frame protocol hierarchy records, for each frame, the stack of
+ * protocols in its protocol tree that protocol hierarchy statistics
+ * count, as the frame is dissected for the first time, so that the
+ * statistics can be computed, for any display filter, without dissecting
+ * all the frames again.
+ *
+ * Frames usually have one of a small number of distinct stacks, so each
+ * distinct stack is stored once, and each frame just refers to its stack.
+ * The lengths of the protocols are stored as the difference from the
+ * length of the frame, which is mostly the same for frames of a stack.
+ */
+typedef struct frame_proto_hier frame_proto_hier_t;
+
+extern frame_proto_hier_t *frame_proto_hier_new(void);
+
+extern void frame_proto_hier_free(frame_proto_hier_t *ph);
+
+/** Get the number of frames recorded; frames 1 through that number
+ * have been added. */
+extern guint32 frame_proto_hier_frame_count(const frame_proto_hier_t *ph);
+
+/** Prepare to dissect a frame.  The protocols in the tree mustn't be
+ * faked the first time it's dissected.
+ *
+ * @param ph the hierarchy
+ * @param edt the epan_dissect_t the frame will be dissected with
+ * @param framenum the number of the frame
+ */
+extern void frame_proto_hier_prime_edt(const frame_proto_hier_t *ph,
+                                       epan_dissect_t *edt, guint32 framenum);
+
+/** Add the next frame, after it has been dissected with a protocol tree.
+ *
+ * @param ph the hierarchy
+ * @param edt the epan_dissect_t the frame was dissected with
+ */
+extern void frame_proto_hier_add(frame_proto_hier_t *ph, const epan_dissect_t *edt);
+
+/** Get a frame's stack.
+ *
+ * @param ph the hierarchy
+ * @param fdata the frame, numbered no greater than frame_proto_hier_frame_count()
+ * @param[out] stack set to the ph_stack_item_t of the frame's stack
+ */
+extern void frame_proto_hier_get(const frame_proto_hier_t *ph, const frame_data *fdata,
+                                 GArray *stack);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __FRAME_PROTO_HIER_H__ */
+
@@ -0,0 +1,168 @@
+/* frame_proto_index.c
+ * Routines for the per-frame protocol presence index
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/packet.h>
+#include <epan/wmem/wmem.h>
+
+#include "frame_proto_index.h"
+
+/* A set of protocols, sorted by protocol id. */
+typedef struct {
+  guint        num_protos;
+  int         *protos;
+  gboolean     may_match;     /* for the current filter */
+} proto_set_t;
+
+struct frame_proto_index {
+  GArray      *frame_sets;    /* set number of each frame, indexed by frame number - 1 */
+  GPtrArray   *sets;          /* proto_set_t, indexed by set number */
+  GHashTable  *set_numbers;   /* GBytes of a set's protocol ids -> set number + 1 */
+  GHashTable  *seen_protos;   /* protocol ids that appear in any set */
+  GArray      *scratch;       /* for building sets */
+};
+
+static gint
+compare_protos(gconstpointer a, gconstpointer b)
+{
+  return *(const int *)a - *(const int *)b;
+}
+
+static void
+free_proto_set(gpointer data)
+{
+  proto_set_t *set = (proto_set_t *)data;
+
+  g_free(set->protos);
+  g_free(set);
+}
+
+frame_proto_index_t *
+frame_proto_index_new(void)
+{
+  frame_proto_index_t *idx = g_new(frame_proto_index_t, 1);
+
+  idx->frame_sets = g_array_new(FALSE, FALSE, sizeof(guint32));
+  idx->sets = g_ptr_array_new_with_free_func(free_proto_set);
+  idx->set_numbers = g_hash_table_new_full(g_bytes_hash, g_bytes_equal,
+                                           (GDestroyNotify)g_bytes_unref, NULL);
+  idx->seen_protos = g_hash_table_new(g_direct_hash, g_direct_equal);
+  idx->scratch = g_array_new(FALSE, FALSE, sizeof(int));
+  return idx;
+}
+
+void
+frame_proto_index_free(frame_proto_index_t *idx)
+{
+  if (idx == NULL)
+    return;
+  g_array_free(idx->frame_sets, TRUE);
+  g_ptr_array_free(idx->sets, TRUE);
+  g_hash_table_destroy(idx->set_numbers);
+  g_hash_table_destroy(idx->seen_protos);
+  g_array_free(idx->scratch, TRUE);
+  g_free(idx);
+}
+
+guint32
+frame_proto_index_frame_count(const frame_proto_index_t *idx)
+{
+  return idx->frame_sets->len;
+}
+
+void
+frame_proto_index_add(frame_proto_index_t *idx, const packet_info *pinfo)
+{
+  wmem_list_frame_t *layer;
+  GBytes            *key;
+  gpointer           value;
+  guint32            set_num;
+  guint              i, n;
+
+  /* Get the frame's protocols, sorted, without duplicates. */
+  g_array_set_size(idx->scratch, 0);
+  for (layer = wmem_list_head(pinfo->layers); layer != NULL; layer = wmem_list_frame_next(layer)) {
+    int proto_id = GPOINTER_TO_INT(wmem_list_frame_data(layer));
+
+    g_array_append_val(idx->scratch, proto_id);
+  }
+  g_array_sort(idx->scratch, compare_protos);
+  for (i = 0, n = 0; i < idx->scratch->len; i++) {
+    if (n == 0 || g_array_index(idx->scratch, int, i) != g_array_index(idx->scratch, int, n - 1))
+      g_array_index(idx->scratch, int, n++) = g_array_index(idx->scratch, int, i);
+  }
+
+  key = g_bytes_new(idx->scratch->data, n * sizeof(int));
+  value = g_hash_table_lookup(idx->set_numbers, key);
+  if (value != NULL) {
+    set_num = GPOINTER_TO_UINT(value) - 1;
+    g_bytes_unref(key);
+  } else {
+    proto_set_t *set = g_new(proto_set_t, 1);
+
+    set->num_protos = n;
+    set->protos = (int *)g_memdup(idx->scratch->data, n * sizeof(int));
+    set->may_match = TRUE;
+    set_num = idx->sets->len;
+    g_ptr_array_add(idx->sets, set);
+    g_hash_table_insert(idx->set_numbers, key, GUINT_TO_POINTER(set_num + 1));
+    for (i = 0; i < n; i++)
+      g_hash_table_add(idx->seen_protos, GINT_TO_POINTER(set->protos[i]));
+  }
+  g_array_append_val(idx->frame_sets, set_num);
+}
+
+static gboolean
+proto_set_has(const proto_set_t *set, int proto_id)
+{
+  return bsearch(&proto_id, set->protos, set->num_protos, sizeof(int), compare_protos) != NULL;
+}
+
+gboolean
+frame_proto_index_set_filter(frame_proto_index_t *idx, const dfilter_t *dfcode)
+{
+  const int *required;
+  int        num_required, i;
+  guint      set_num;
+  gboolean   can_rule_out = FALSE;
+
+  required = dfilter_required_protocols(dfcode, &num_required);
+
+  for (set_num = 0; set_num < idx->sets->len; set_num++) {
+    proto_set_t *set = (proto_set_t *)g_ptr_array_index(idx->sets, set_num);
+
+    set->may_match = TRUE;
+    for (i = 0; i < num_required; i++) {
+      /* See the XXX comment in frame_proto_index.h. */
+      if (!g_hash_table_contains(idx->seen_protos, GINT_TO_POINTER(required[i])))
+        continue;
+      if (!proto_set_has(set, required[i])) {
+        set->may_match = FALSE;
+        can_rule_out = TRUE;
+        break;
+      }
+    }
+  }
+  return can_rule_out;
+}
+
+gboolean
+frame_proto_index_may_match(const frame_proto_index_t *idx, guint32 framenum)
+{
+  guint32 set_num = g_array_index(idx->frame_sets, guint32, framenum - 1);
+
+  return ((const proto_set_t *)g_ptr_array_index(idx->sets, set_num))->may_match;
+}
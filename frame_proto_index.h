@@ -0,0 +1,74 @@
+/* frame_proto_index.h
+ * Definitions for the per-frame protocol presence index
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __FRAME_PROTO_INDEX_H__
+#define __FRAME_PROTO_INDEX_H__
+
+#include <epan/packet_info.h>
+#include <epan/dfilter/dfilter.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * A frame protocol index records, for each frame, which protocols were
+ * dissected in it, as listed in pinfo->layers.  Given a display filter,
+ * it can tell which frames can't match, because they lack a protocol
+ * that the filter requires, so that they needn't be dissected again.
+ *
+ * Frames usually have one of a small number of distinct protocol
+ * stacks, so each distinct set of protocols is stored once, and each
+ * frame just refers to its set.
+ *
+ * XXX - protocols that are dissected by calling another dissector's
+ * routines directly, rather than through a dissector handle, don't
+ * appear in pinfo->layers.  To avoid ruling out frames that have that
+ * protocol's fields, a protocol is only used to rule frames out if it has
+ * appeared in the layers of some frame.
+ */
+typedef struct frame_proto_index frame_proto_index_t;
+
+extern frame_proto_index_t *frame_proto_index_new(void);
+
+extern void frame_proto_index_free(frame_proto_index_t *idx);
+
+/** Get the number of frames in the index; frames 1 through that number
+ * have been added. */
+extern guint32 frame_proto_index_frame_count(const frame_proto_index_t *idx);
+
+/** Add the next frame to the index, after it has been dissected.
+ *
+ * @param idx the index
+ * @param pinfo the packet_info from dissecting the frame
+ */
+extern void frame_proto_index_add(frame_proto_index_t *idx, const packet_info *pinfo);
+
+/** Prepare to ask which frames might match a display filter.
+ *
+ * @param idx the index
+ * @param dfcode the display filter
+ * @return TRUE if the index can rule out any frames for the filter
+ */
+extern gboolean frame_proto_index_set_filter(frame_proto_index_t *idx, const dfilter_t *dfcode);
+
+/** Could a frame match the display filter given to frame_proto_index_set_filter()?
+ *
+ * @param idx the index
+ * @param framenum the frame number, no greater than frame_proto_index_frame_count()
+ * @return FALSE if it can't; TRUE if it might
+ */
+extern gboolean frame_proto_index_may_match(const frame_proto_index_t *idx, guint32 framenum);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __FRAME_PROTO_INDEX_H__ */
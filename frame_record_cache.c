@@ -0,0 +1,239 @@
+/* frame_record_cache.c
+ * Routines for a cache of the records of recently read frames
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <wiretap/wtap.h>
+#include <wsutil/buffer.h>
+#include <wsutil/glib-compat.h>
+
+#include "frame_record_cache.h"
+
+typedef struct {
+  GList     link;               /* in the cache's LRU queue; data points to us */
+  guint32   framenum;
+  wtap_rec  rec;                /* our own copy */
+  guint8   *data;
+  gsize     data_len;
+  gsize     size;               /* memory charged to the cache */
+} cached_record_t;
+
+struct frame_record_cache {
+  GHashTable *records;          /* framenum -> cached_record_t */
+  GQueue      lru;              /* most recently read first */
+  gsize       max_bytes;
+  gsize       bytes;
+  guint64     hits;
+  guint64     misses;
+};
+
+/*
+ * Copy the metadata of a record, including what it points to, replacing
+ * that of dst.
+ */
+static void
+copy_rec(wtap_rec *dst, wtap_rec *src)
+{
+  guint i;
+
+  dst->rec_type = src->rec_type;
+  dst->presence_flags = src->presence_flags;
+  dst->ts = src->ts;
+  dst->tsprec = src->tsprec;
+  dst->rec_header = src->rec_header;
+  g_free(dst->opt_comment);
+  dst->opt_comment = g_strdup(src->opt_comment);
+  dst->has_comment_changed = FALSE;
+  if (dst->packet_verdict != NULL) {
+    g_ptr_array_free(dst->packet_verdict, TRUE);
+    dst->packet_verdict = NULL;
+  }
+  if (src->packet_verdict != NULL && src->packet_verdict->len != 0) {
+    dst->packet_verdict = g_ptr_array_new_full(src->packet_verdict->len,
+                                               (GDestroyNotify) g_bytes_unref);
+    for (i = 0; i < src->packet_verdict->len; i++)
+      g_ptr_array_add(dst->packet_verdict,
+                      g_bytes_ref((GBytes *)g_ptr_array_index(src->packet_verdict, i)));
+  }
+  ws_buffer_clean(&dst->options_buf);
+  ws_buffer_append(&dst->options_buf,
+                   ws_buffer_start_ptr(&src->options_buf),
+                   ws_buffer_length(&src->options_buf));
+}
+
+/*
+ * The number of bytes a read put into the buffer for the record; readers
+ * put them at its start without setting its length.  0 for records that
+ * can't be kept, either because we don't know that, or because the K12
+ * pseudo-header points to a buffer that the reader reuses.
+ */
+static gsize
+rec_data_len(const wtap_rec *rec)
+{
+  switch (rec->rec_type) {
+
+  case REC_TYPE_PACKET:
+    if (rec->rec_header.packet_header.pkt_encap == WTAP_ENCAP_K12)
+      return 0;
+    return rec->rec_header.packet_header.caplen;
+
+  case REC_TYPE_FT_SPECIFIC_EVENT:
+  case REC_TYPE_FT_SPECIFIC_REPORT:
+    return rec->rec_header.ft_specific_header.record_len;
+
+  case REC_TYPE_SYSCALL:
+    return rec->rec_header.syscall_header.event_filelen;
+
+  case REC_TYPE_SYSTEMD_JOURNAL:
+    return rec->rec_header.systemd_journal_header.record_len;
+
+  default:
+    return 0;
+  }
+}
+
+static void
+cached_record_free(gpointer data)
+{
+  cached_record_t *record = (cached_record_t *)data;
+
+  wtap_rec_cleanup(&record->rec);
+  g_free(record->data);
+  g_free(record);
+}
+
+frame_record_cache_t *
+frame_record_cache_new(gsize max_bytes)
+{
+  frame_record_cache_t *cache = g_new0(frame_record_cache_t, 1);
+
+  cache->records = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                         NULL, cached_record_free);
+  g_queue_init(&cache->lru);
+  cache->max_bytes = max_bytes;
+  return cache;
+}
+
+void
+frame_record_cache_clear(frame_record_cache_t *cache)
+{
+  if (cache == NULL)
+    return;
+
+  /* The links are in the records, which the hash table frees. */
+  g_queue_init(&cache->lru);
+  g_hash_table_remove_all(cache->records);
+  cache->bytes = 0;
+}
+
+void
+frame_record_cache_free(frame_record_cache_t *cache)
+{
+  if (cache == NULL)
+    return;
+
+  frame_record_cache_clear(cache);
+  g_hash_table_destroy(cache->records);
+  g_free(cache);
+}
+
+/* Drop the least recently read records until there's room for size bytes. */
+static void
+make_room(frame_record_cache_t *cache, gsize size)
+{
+  GList *link;
+  cached_record_t *record;
+
+  while (cache->bytes + size > cache->max_bytes &&
+         (link = g_queue_peek_tail_link(&cache->lru)) != NULL) {
+    record = (cached_record_t *)link->data;
+    g_queue_unlink(&cache->lru, link);
+    cache->bytes -= record->size;
+    g_hash_table_remove(cache->records, GUINT_TO_POINTER(record->framenum));
+  }
+}
+
+static void
+add_record(frame_record_cache_t *cache, guint32 framenum, wtap_rec *rec,
+           Buffer *buf, gsize data_len)
+{
+  cached_record_t *record;
+  gsize size;
+
+  size = sizeof(cached_record_t) + data_len +
+         ws_buffer_length(&rec->options_buf) +
+         (rec->opt_comment != NULL ? strlen(rec->opt_comment) + 1 : 0);
+  if (size > cache->max_bytes)
+    return;
+  make_room(cache, size);
+
+  record = g_new0(cached_record_t, 1);
+  record->link.data = record;
+  record->framenum = framenum;
+  wtap_rec_init(&record->rec);
+  copy_rec(&record->rec, rec);
+  record->data = (guint8 *)g_memdup2(ws_buffer_start_ptr(buf), data_len);
+  record->data_len = data_len;
+  record->size = size;
+  g_hash_table_insert(cache->records, GUINT_TO_POINTER(framenum), record);
+  g_queue_push_head_link(&cache->lru, &record->link);
+  cache->bytes += size;
+}
+
+gboolean
+frame_record_cache_read(frame_record_cache_t *cache, wtap *wth,
+                        guint32 framenum, gint64 file_off, wtap_rec *rec,
+                        Buffer *buf, int *err, gchar **err_info)
+{
+  cached_record_t *record;
+  gsize data_len;
+
+  if (cache == NULL)
+    return wtap_seek_read(wth, file_off, rec, buf, err, err_info);
+
+  record = (cached_record_t *)g_hash_table_lookup(cache->records,
+                                                  GUINT_TO_POINTER(framenum));
+  if (record != NULL) {
+    cache->hits++;
+    g_queue_unlink(&cache->lru, &record->link);
+    g_queue_push_head_link(&cache->lru, &record->link);
+    copy_rec(rec, &record->rec);
+    ws_buffer_assure_space(buf, record->data_len);
+    memcpy(ws_buffer_start_ptr(buf), record->data, record->data_len);
+    *err = 0;
+    *err_info = NULL;
+    return TRUE;
+  }
+
+  cache->misses++;
+  if (!wtap_seek_read(wth, file_off, rec, buf, err, err_info))
+    return FALSE;
+  data_len = rec_data_len(rec);
+  if (data_len != 0)
+    add_record(cache, framenum, rec, buf, data_len);
+  return TRUE;
+}
+
+void
+frame_record_cache_get_stats(const frame_record_cache_t *cache,
+                             guint64 *hits, guint64 *misses)
+{
+  if (cache == NULL) {
+    *hits = 0;
+    *misses = 0;
+    return;
+  }
+  *hits = cache->hits;
+  *misses = cache->misses;
+}
@@ -0,0 +1,75 @@
+/* frame_record_cache.h
+ * Definitions for a cache of the records of recently read frames
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __FRAME_RECORD_CACHE_H__
+#define __FRAME_RECORD_CACHE_H__
+
+#include <wiretap/wtap.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * A frame record cache keeps the metadata and bytes of the records of
+ * the frames that were read most recently with wtap_seek_read(), up to
+ * a given number of bytes, so that reading one of them again, as the
+ * GUI and sharkd often do within a short time, doesn't have to seek in
+ * the file or, for a compressed file, inflate it again from the nearest
+ * seek point.  When it's full, the least recently read records are
+ * dropped.
+ *
+ * Records are looked up by frame number, so the cache must be cleared
+ * whenever the frames are read from another file.
+ */
+typedef struct frame_record_cache frame_record_cache_t;
+
+/** Create a cache.
+ *
+ * @param max_bytes the most memory to use for the records it keeps
+ */
+extern frame_record_cache_t *frame_record_cache_new(gsize max_bytes);
+
+/** Free a cache and the records in it; cache may be NULL. */
+extern void frame_record_cache_free(frame_record_cache_t *cache);
+
+/** Drop all the records in a cache; cache may be NULL. */
+extern void frame_record_cache_clear(frame_record_cache_t *cache);
+
+/** Read the record of a frame, from the cache if it's there, otherwise
+ * with wtap_seek_read(), keeping a copy in the cache.
+ *
+ * @param cache the cache, or NULL to just call wtap_seek_read()
+ * @param wth the wiretap session the frame was read from
+ * @param framenum the number of the frame
+ * @param file_off the offset of its record, as for wtap_seek_read()
+ * @param rec filled in with the record metadata
+ * @param buf filled in with the record data
+ * @param[out] err set to the error code on failure
+ * @param[out] err_info set to additional information for some errors
+ * @return TRUE on success, FALSE as wtap_seek_read() does on failure
+ */
+extern gboolean frame_record_cache_read(frame_record_cache_t *cache, wtap *wth,
+                                        guint32 framenum, gint64 file_off,
+                                        wtap_rec *rec, Buffer *buf,
+                                        int *err, gchar **err_info);
+
+/** Get the number of reads from a cache that found the record there,
+ * and of those that didn't; both are 0 if cache is NULL.
+ */
+extern void frame_record_cache_get_stats(const frame_record_cache_t *cache,
+                                         guint64 *hits, guint64 *misses);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __FRAME_RECORD_CACHE_H__ */
+
@@ -0,0 +1,152 @@
+/* frame_traffic_tables.c
+ * Routines for the conversation and endpoint tables of a capture file
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <glib.h>
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/conversation_table.h>
+
+#include "frame_traffic_tables.h"
+
+typedef struct {
+  frame_traffic_tables_t *tt;
+  register_ct_t          *table;
+  gboolean                hostlist;
+  tap_packet_cb           packet;   /* the protocol's own tap callback */
+  conv_hash_t             hash;
+} traffic_table_t;
+
+struct frame_traffic_tables {
+  guint32    frame_count;
+  GPtrArray *tables;                /* traffic_table_t */
+  gboolean   failed;                /* a tap couldn't be listened to */
+};
+
+static tap_packet_status
+traffic_table_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt,
+                     const void *data)
+{
+  traffic_table_t *tt_table = (traffic_table_t *)tapdata;
+
+  /* Only count what's reported for the frame being added. */
+  if (pinfo->num != tt_table->tt->frame_count + 1)
+    return TAP_PACKET_DONT_REDRAW;
+  tt_table->packet(&tt_table->hash, pinfo, edt, data);
+  return TAP_PACKET_DONT_REDRAW;
+}
+
+static void
+free_traffic_table(gpointer data)
+{
+  traffic_table_t *tt_table = (traffic_table_t *)data;
+
+  remove_tap_listener(tt_table);
+  if (tt_table->hostlist)
+    reset_hostlist_table_data(&tt_table->hash);
+  else
+    reset_conversation_table_data(&tt_table->hash);
+  g_free(tt_table);
+}
+
+static void
+add_table(frame_traffic_tables_t *tt, register_ct_t *table, gboolean hostlist,
+          tap_packet_cb packet)
+{
+  traffic_table_t *tt_table;
+  GString *error_string;
+
+  if (packet == NULL)
+    return;
+
+  tt_table = g_new0(traffic_table_t, 1);
+  tt_table->tt = tt;
+  tt_table->table = table;
+  tt_table->hostlist = hostlist;
+  tt_table->packet = packet;
+  error_string = register_tap_listener(proto_get_protocol_filter_name(get_conversation_proto_id(table)),
+                                       tt_table, NULL, TL_IS_DISSECTOR_HELPER,
+                                       NULL, traffic_table_packet, NULL, NULL);
+  if (error_string != NULL) {
+    g_string_free(error_string, TRUE);
+    g_free(tt_table);
+    tt->failed = TRUE;
+    return;
+  }
+  g_ptr_array_add(tt->tables, tt_table);
+}
+
+static gboolean
+add_tables(const void *key _U_, void *value, void *userdata)
+{
+  register_ct_t *table = (register_ct_t *)value;
+  frame_traffic_tables_t *tt = (frame_traffic_tables_t *)userdata;
+
+  add_table(tt, table, FALSE, get_conversation_packet_func(table));
+  add_table(tt, table, TRUE, get_hostlist_packet_func(table));
+  return FALSE;
+}
+
+frame_traffic_tables_t *
+frame_traffic_tables_new(void)
+{
+  frame_traffic_tables_t *tt = g_new0(frame_traffic_tables_t, 1);
+
+  tt->tables = g_ptr_array_new_with_free_func(free_traffic_table);
+  conversation_table_iterate_tables(add_tables, tt);
+  if (tt->failed) {
+    frame_traffic_tables_free(tt);
+    return NULL;
+  }
+  return tt;
+}
+
+void
+frame_traffic_tables_free(frame_traffic_tables_t *tt)
+{
+  if (tt == NULL)
+    return;
+  g_ptr_array_free(tt->tables, TRUE);
+  g_free(tt);
+}
+
+guint32
+frame_traffic_tables_frame_count(const frame_traffic_tables_t *tt)
+{
+  return tt->frame_count;
+}
+
+void
+frame_traffic_tables_frame_done(frame_traffic_tables_t *tt)
+{
+  tt->frame_count++;
+}
+
+gboolean
+frame_traffic_tables_copy(const frame_traffic_tables_t *tt, register_ct_t *table,
+                          gboolean hostlist, conv_hash_t *dst)
+{
+  guint i;
+
+  for (i = 0; i < tt->tables->len; i++) {
+    traffic_table_t *tt_table = (traffic_table_t *)g_ptr_array_index(tt->tables, i);
+
+    if (tt_table->table == table && tt_table->hostlist == hostlist) {
+      if (hostlist)
+        copy_hostlist_table_data(dst, &tt_table->hash);
+      else
+        copy_conversation_table_data(dst, &tt_table->hash);
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
@@ -0,0 +1,66 @@
+/* frame_traffic_tables.h
+ * Definitions for the conversation and endpoint tables of a capture file
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __FRAME_TRAFFIC_TABLES_H__
+#define __FRAME_TRAFFIC_TABLES_H__
+
+#include <epan/conversation_table.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Frame traffic tables are the conversation and endpoint tables of all
+ * the protocols that have them, filled in from the taps of those
+ * protocols as each frame is dissected for the first time, so that the
+ * Conversations and Endpoints dialogs can show them for the whole file
+ * without dissecting all the frames again.
+ */
+typedef struct frame_traffic_tables frame_traffic_tables_t;
+
+/** Create the tables, listening to the taps of their protocols.
+ *
+ * @return the tables, or NULL if the taps couldn't be listened to
+ */
+extern frame_traffic_tables_t *frame_traffic_tables_new(void);
+
+/** Stop listening and free the tables; tt may be NULL. */
+extern void frame_traffic_tables_free(frame_traffic_tables_t *tt);
+
+/** Get the number of frames in the tables; frames 1 through that number
+ * have been added. */
+extern guint32 frame_traffic_tables_frame_count(const frame_traffic_tables_t *tt);
+
+/** Finish adding the next frame, after it has been dissected with taps.
+ * What the taps report for any other frame is ignored.
+ *
+ * @param tt the tables
+ */
+extern void frame_traffic_tables_frame_done(frame_traffic_tables_t *tt);
+
+/** Copy one of the tables.
+ *
+ * @param tt the tables
+ * @param table the conversation table registration of the protocol
+ * @param hostlist TRUE for the protocol's endpoint table, FALSE for its
+ * conversation table
+ * @param[out] dst replaced with a copy of the table
+ * @return TRUE if the table was copied, FALSE if there's no such table
+ */
+extern gboolean frame_traffic_tables_copy(const frame_traffic_tables_t *tt,
+                                          register_ct_t *table, gboolean hostlist,
+                                          conv_hash_t *dst);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __FRAME_TRAFFIC_TABLES_H__ */
@@ -0,0 +1,116 @@
+/* frame_tree_cache.c
+ * Routines for a cache of the dissection trees of recently selected frames
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <glib.h>
+
+#include <epan/epan_dissect.h>
+#include <wiretap/wtap.h>
+#include <wsutil/buffer.h>
+
+#include "frame_tree_cache.h"
+
+struct frame_tree_cache {
+  GQueue      trees;            /* most recently selected first */
+  guint       max_trees;
+  guint       generation;
+};
+
+frame_tree_cache_t *
+frame_tree_cache_new(guint max_trees)
+{
+  frame_tree_cache_t *cache = g_new0(frame_tree_cache_t, 1);
+
+  g_queue_init(&cache->trees);
+  cache->max_trees = max_trees;
+  return cache;
+}
+
+void
+frame_tree_cache_invalidate(frame_tree_cache_t *cache)
+{
+  frame_tree_t *tree;
+
+  if (cache == NULL)
+    return;
+
+  while ((tree = (frame_tree_t *)g_queue_pop_head(&cache->trees)) != NULL)
+    frame_tree_free(tree);
+  cache->generation++;
+}
+
+void
+frame_tree_cache_free(frame_tree_cache_t *cache)
+{
+  if (cache == NULL)
+    return;
+
+  frame_tree_cache_invalidate(cache);
+  g_free(cache);
+}
+
+frame_tree_t *
+frame_tree_new(frame_tree_cache_t *cache, guint32 framenum)
+{
+  frame_tree_t *tree = g_new0(frame_tree_t, 1);
+
+  tree->framenum = framenum;
+  tree->generation = cache->generation;
+  wtap_rec_init(&tree->rec);
+  ws_buffer_init(&tree->buf, 1514);
+  return tree;
+}
+
+void
+frame_tree_free(frame_tree_t *tree)
+{
+  if (tree->edt != NULL)
+    epan_dissect_free(tree->edt);
+  wtap_rec_cleanup(&tree->rec);
+  ws_buffer_free(&tree->buf);
+  g_free(tree);
+}
+
+frame_tree_t *
+frame_tree_cache_take(frame_tree_cache_t *cache, guint32 framenum)
+{
+  GList *link;
+  frame_tree_t *tree;
+
+  /* There are only a few of them. */
+  for (link = g_queue_peek_head_link(&cache->trees); link != NULL; link = link->next) {
+    tree = (frame_tree_t *)link->data;
+    if (tree->framenum == framenum) {
+      g_queue_delete_link(&cache->trees, link);
+      return tree;
+    }
+  }
+  return NULL;
+}
+
+void
+frame_tree_cache_put(frame_tree_cache_t *cache, frame_tree_t *tree)
+{
+  frame_tree_t *other;
+
+  if (tree->generation != cache->generation || tree->edt == NULL) {
+    frame_tree_free(tree);
+    return;
+  }
+
+  other = frame_tree_cache_take(cache, tree->framenum);
+  if (other != NULL)
+    frame_tree_free(other);
+  g_queue_push_head(&cache->trees, tree);
+  while (cache->trees.length > cache->max_trees)
+    frame_tree_free((frame_tree_t *)g_queue_pop_tail(&cache->trees));
+}
+
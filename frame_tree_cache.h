@@ -0,0 +1,77 @@
+/* frame_tree_cache.h
+ * Definitions for a cache of the dissection trees of recently selected frames
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __FRAME_TREE_CACHE_H__
+#define __FRAME_TREE_CACHE_H__
+
+#include <epan/epan_dissect.h>
+#include <wiretap/wtap.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * A frame tree cache keeps the protocol trees of the frames that were
+ * selected most recently, up to a given number of them, so that going
+ * back to one of them, as "Go To Related Packet" or stepping through a
+ * conversation does, needn't dissect it again.  When it's full, the
+ * least recently selected trees are dropped.
+ *
+ * A tree is only good for as long as nothing changes the way its frame
+ * is dissected; frame_tree_cache_invalidate() drops the trees in the
+ * cache, and makes those taken out of it stale, so that they're dropped
+ * when they're put back.
+ */
+typedef struct frame_tree_cache frame_tree_cache_t;
+
+typedef struct frame_tree {
+  guint32         framenum;
+  guint           generation;   /* the cache's, when it was made */
+  epan_dissect_t *edt;          /* NULL until it's been dissected */
+  wtap_rec        rec;          /* what it's dissected from */
+  Buffer          buf;
+} frame_tree_t;
+
+/** Create a cache.
+ *
+ * @param max_trees the most trees to keep
+ */
+extern frame_tree_cache_t *frame_tree_cache_new(guint max_trees);
+
+/** Free a cache and the trees in it; cache may be NULL. */
+extern void frame_tree_cache_free(frame_tree_cache_t *cache);
+
+/** Drop all the trees in a cache, and make those taken out of it stale;
+ * cache may be NULL. */
+extern void frame_tree_cache_invalidate(frame_tree_cache_t *cache);
+
+/** Make a tree for a frame, with an empty record, to be read and
+ * dissected by the caller. */
+extern frame_tree_t *frame_tree_new(frame_tree_cache_t *cache, guint32 framenum);
+
+/** Free a tree, and the epan_dissect_t in it. */
+extern void frame_tree_free(frame_tree_t *tree);
+
+/** Take the tree of a frame out of a cache.
+ *
+ * @return the tree, or NULL if the cache doesn't have it
+ */
+extern frame_tree_t *frame_tree_cache_take(frame_tree_cache_t *cache, guint32 framenum);
+
+/** Put a tree into a cache, as the most recently selected one, replacing
+ * any other tree of its frame; it's freed instead if it's stale. */
+extern void frame_tree_cache_put(frame_tree_cache_t *cache, frame_tree_t *tree);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __FRAME_TREE_CACHE_H__ */
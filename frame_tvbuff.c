@@ -17,6 +17,7 @@
 #include <epan/tvbuff.h>
 
 #include "frame_tvbuff.h"
+#include "frame_record_cache.h"
 
 #include "wiretap/wtap-int.h" /* for ->random_fh */
 
@@ -26,6 +27,7 @@ struct tvb_frame {
 	Buffer *buf;         /* Packet data */
 
 	const struct packet_provider_data *prov;	/* provider of packet information */
+	guint32 framenum;    /**< Frame number */
 	gint64 file_off;     /**< File offset */
 
 	guint offset;
@@ -40,7 +42,8 @@ frame_read(struct tvb_frame *frame_tvb, wtap_rec *rec, Buffer *buf)
 	/* XXX, what if phdr->caplen isn't equal to
 	 * frame_tvb->tvb.length + frame_tvb->offset?
 	 */
-	if (!wtap_seek_read(frame_tvb->prov->wth, frame_tvb->file_off, rec, buf, &err, &err_info)) {
+	if (!frame_record_cache_read(frame_tvb->prov->record_cache, frame_tvb->prov->wth,
+	    frame_tvb->framenum, frame_tvb->file_off, rec, buf, &err, &err_info)) {
 		/* XXX - report error! */
 		switch (err) {
 			case WTAP_ERR_BAD_FILE:
@@ -207,6 +210,7 @@ frame_tvbuff_new(const struct packet_provider_data *prov, const frame_data *fd,
 	/* XXX, wtap_can_seek() */
 	if (prov->wth && prov->wth->random_fh) {
 		frame_tvb->prov = prov;
+		frame_tvb->framenum = fd->num;
 		frame_tvb->file_off = fd->file_off;
 		frame_tvb->offset = 0;
 	} else
@@ -255,6 +259,7 @@ frame_clone(tvbuff_t *tvb, guint abs_offset, guint abs_length)
 
 	cloned_frame_tvb = (struct tvb_frame *) cloned_tvb;
 	cloned_frame_tvb->prov = frame_tvb->prov;
+	cloned_frame_tvb->framenum = frame_tvb->framenum;
 	cloned_frame_tvb->file_off = frame_tvb->file_off;
 	cloned_frame_tvb->offset = abs_offset;
 	cloned_frame_tvb->buf = NULL;
@@ -312,6 +317,7 @@ file_tvbuff_new(const struct packet_provider_data *prov, const frame_data *fd,
 	/* XXX, wtap_can_seek() */
 	if (prov->wth && prov->wth->random_fh) {
 		frame_tvb->prov = prov;
+		frame_tvb->framenum = fd->num;
 		frame_tvb->file_off = fd->file_off;
 		frame_tvb->offset = 0;
 	} else
@@ -42,12 +42,15 @@
 #endif
 
 #include "FuzzerInterface.h"
+#include "fuzzshark.h"
 
 #define EPAN_INIT_FAIL 2
 
 static column_info fuzz_cinfo;
 static epan_t *fuzz_epan;
 static epan_dissect_t *fuzz_edt;
+static const char *fuzz_target_name;
+static gboolean fuzz_benchmarking;
 
 /*
  * Report an error in command-line arguments.
@@ -221,6 +224,8 @@ fuzz_init(int argc _U_, char **argv)
 
 	dissector_handle_t fuzz_handle = NULL;
 
+	fuzz_target_name = fuzz_target;
+
 	/* In oss-fuzz running environment g_get_home_dir() fails:
 	 * (process:1): GLib-WARNING **: getpwuid_r(): failed due to unknown user id (0)
 	 * (process:1): GLib-CRITICAL **: g_once_init_leave: assertion 'result != 0' failed
@@ -231,8 +236,11 @@ fuzz_init(int argc _U_, char **argv)
 	g_setenv("XDG_CONFIG_HOME", "/not/existing/directory", 0); /* g_get_user_config_dir() */
 	g_setenv("XDG_DATA_HOME", "/not/existing/directory", 0);   /* g_get_user_data_dir() */
 
-	g_setenv("WIRESHARK_DEBUG_WMEM_OVERRIDE", "simple", 0);
-	g_setenv("G_SLICE", "always-malloc", 0);
+	/* Benchmarks measure the allocators that are really used. */
+	if (!fuzz_benchmarking) {
+		g_setenv("WIRESHARK_DEBUG_WMEM_OVERRIDE", "simple", 0);
+		g_setenv("G_SLICE", "always-malloc", 0);
+	}
 
 	cmdarg_err_init(fuzzshark_cmdarg_err, fuzzshark_cmdarg_err_cont);
 
@@ -377,6 +385,27 @@ LLVMFuzzerTestOneInput(const guint8 *buf, size_t real_len)
 # error "Missing fuzz target."
 #endif
 
+void
+fuzzshark_set_benchmarking(gboolean benchmarking)
+{
+	fuzz_benchmarking = benchmarking;
+}
+
+const char *
+fuzzshark_target(void)
+{
+	return fuzz_target_name;
+}
+
+guint64
+fuzzshark_alloc_count(void)
+{
+	return wmem_allocator_alloc_count(wmem_packet_scope()) +
+	    wmem_allocator_alloc_count(wmem_file_scope()) +
+	    wmem_allocator_alloc_count(wmem_epan_scope()) +
+	    wmem_allocator_alloc_count(fuzz_edt->pi.pool);
+}
+
 int
 LLVMFuzzerInitialize(int *argc, char ***argv)
 {
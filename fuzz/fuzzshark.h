@@ -0,0 +1,52 @@
+/* fuzzshark.h
+ *
+ * Functions of the fuzz target for programs other than a fuzzer that
+ * drive it, such as fuzzshark_benchmark
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __FUZZSHARK_H__
+#define __FUZZSHARK_H__
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Don't make every allocation go through the system allocator, as is done
+ * for fuzzing so that sanitizers see them all; must be called before
+ * LLVMFuzzerInitialize().
+ */
+void fuzzshark_set_benchmarking(gboolean benchmarking);
+
+/* The name of the dissector that is fuzzed, once initialized. */
+const char *fuzzshark_target(void);
+
+/* The number of wmem allocations made so far while dissecting. */
+guint64 fuzzshark_alloc_count(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __FUZZSHARK_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -0,0 +1,678 @@
+/* fuzzshark_benchmark.c
+ *
+ * Replays a corpus through a fuzz target, in several processes, and
+ * reports how fast it was dissected, to catch performance regressions
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+/*
+ * If we have getopt_long() in the system library, include <getopt.h>.
+ * Otherwise, we're using our own getopt_long() (either because the
+ * system has getopt() but not getopt_long(), as with some UN*Xes,
+ * or because it doesn't even have getopt(), as with Windows), so
+ * include our getopt_long()'s header.
+ */
+#ifdef HAVE_GETOPT_LONG
+#include <getopt.h>
+#else
+#include <wsutil/wsgetopt.h>
+#endif
+
+#include <glib.h>
+
+#include <epan/packet.h>
+
+#include <ui/failure_message.h>
+#include <wiretap/wtap.h>
+#include <wsutil/file_util.h>
+#include <wsutil/json_dumper.h>
+
+#include "FuzzerInterface.h"
+#include "fuzzshark.h"
+
+/* The results of one worker process, or of all of them merged. */
+typedef struct {
+	guint64 packets;
+	guint64 bytes;
+	guint64 allocs;
+	guint64 wall_time;	/* ns */
+	GArray *latencies;	/* guint64 ns, one per packet */
+	GArray *profiles;	/* dissector_profile_t, if profiling */
+} bench_result_t;
+
+static GPtrArray *inputs;	/* GBytes */
+
+static void
+print_usage(FILE *output)
+{
+	fprintf(output,
+"Usage: fuzzshark_benchmark [options] <input file or directory> ...\n"
+"\n"
+"Dissects each input with the fuzz target selected by FUZZSHARK_TARGET and\n"
+"FUZZSHARK_TABLE, as fuzzshark does, and reports the throughput, the\n"
+"allocations per packet and the per-packet latency.\n"
+"\n"
+"  -j <jobs>      split the inputs between <jobs> processes (default: 1)\n"
+"  -n <passes>    dissect every input <passes> times (default: 1)\n"
+"  -c             the inputs are capture files; dissect each of their packets\n"
+"  -p             also report the time spent in each dissector called\n"
+"  -T text|json   output format (default: text); use json to compare runs\n"
+"  -h             display this help and exit\n");
+}
+
+static guint64
+bench_now(void)
+{
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (guint64)ts.tv_sec * G_GUINT64_CONSTANT(1000000000) + (guint64)ts.tv_nsec;
+#else
+	return (guint64)g_get_monotonic_time() * 1000;
+#endif
+}
+
+static gboolean
+add_input_file(const char *path)
+{
+	gchar  *contents;
+	gsize   len;
+	GError *error = NULL;
+
+	if (!g_file_get_contents(path, &contents, &len, &error)) {
+		fprintf(stderr, "fuzzshark_benchmark: %s\n", error->message);
+		g_error_free(error);
+		return FALSE;
+	}
+	g_ptr_array_add(inputs, g_bytes_new_take(contents, len));
+	return TRUE;
+}
+
+static gboolean
+add_input_capture(const char *path)
+{
+	wtap     *wth;
+	wtap_rec  rec;
+	Buffer    buf;
+	int       err;
+	gchar    *err_info;
+	gint64    data_offset;
+
+	wth = wtap_open_offline(path, WTAP_TYPE_AUTO, &err, &err_info, FALSE);
+	if (wth == NULL) {
+		cfile_open_failure_message(path, err, err_info);
+		return FALSE;
+	}
+
+	wtap_rec_init(&rec);
+	ws_buffer_init(&buf, 1514);
+	while (wtap_read(wth, &rec, &buf, &err, &err_info, &data_offset)) {
+		if (rec.rec_type != REC_TYPE_PACKET)
+			continue;
+		g_ptr_array_add(inputs, g_bytes_new(ws_buffer_start_ptr(&buf),
+		    rec.rec_header.packet_header.caplen));
+	}
+	ws_buffer_free(&buf);
+	wtap_rec_cleanup(&rec);
+	wtap_close(wth);
+
+	if (err != 0) {
+		cfile_read_failure_message(path, err, err_info);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static gboolean
+add_input(const char *path, gboolean captures)
+{
+	GDir       *dir;
+	const char *name;
+	gchar      *entry;
+	gboolean    ok = TRUE;
+
+	if (!g_file_test(path, G_FILE_TEST_IS_DIR))
+		return captures ? add_input_capture(path) : add_input_file(path);
+
+	dir = g_dir_open(path, 0, NULL);
+	if (dir == NULL) {
+		fprintf(stderr, "fuzzshark_benchmark: can't open directory %s\n", path);
+		return FALSE;
+	}
+	while (ok && (name = g_dir_read_name(dir)) != NULL) {
+		entry = g_build_filename(path, name, NULL);
+		if (g_file_test(entry, G_FILE_TEST_IS_REGULAR))
+			ok = captures ? add_input_capture(entry) : add_input_file(entry);
+		g_free(entry);
+	}
+	g_dir_close(dir);
+	return ok;
+}
+
+static void
+bench_result_init(bench_result_t *result)
+{
+	memset(result, 0, sizeof(*result));
+	result->latencies = g_array_new(FALSE, FALSE, sizeof(guint64));
+	result->profiles = g_array_new(FALSE, FALSE, sizeof(dissector_profile_t));
+}
+
+static void
+bench_result_free(bench_result_t *result)
+{
+	guint i;
+
+	g_array_free(result->latencies, TRUE);
+	for (i = 0; i < result->profiles->len; i++)
+		g_free(g_array_index(result->profiles, dissector_profile_t, i).name);
+	g_array_free(result->profiles, TRUE);
+}
+
+/* Dissect the inputs of a worker, every jobs'th one from the first. */
+static void
+run_worker(guint first, guint jobs, guint passes, gboolean profile,
+    bench_result_t *result)
+{
+	guint      pass, i, j;
+	guint64    start, before, allocs_before;
+	GBytes    *input;
+	gsize      len;
+	GPtrArray *profiles;
+	dissector_profile_t copy;
+
+	if (profile) {
+		dissector_profiling_reset();
+		dissector_profiling_enable(TRUE);
+	}
+
+	start = bench_now();
+	for (pass = 0; pass < passes; pass++) {
+		for (i = first; i < inputs->len; i += jobs) {
+			input = (GBytes *)g_ptr_array_index(inputs, i);
+			allocs_before = fuzzshark_alloc_count();
+			before = bench_now();
+			LLVMFuzzerTestOneInput((const guint8 *)g_bytes_get_data(input, &len), len);
+			before = bench_now() - before;
+			g_array_append_val(result->latencies, before);
+			result->allocs += fuzzshark_alloc_count() - allocs_before;
+			result->bytes += len;
+			result->packets++;
+		}
+	}
+	result->wall_time = bench_now() - start;
+
+	if (profile) {
+		dissector_profiling_enable(FALSE);
+		profiles = dissector_profiling_get();
+		for (j = 0; j < profiles->len; j++) {
+			copy = *(dissector_profile_t *)g_ptr_array_index(profiles, j);
+			copy.name = g_strdup(copy.name);
+			g_array_append_val(result->profiles, copy);
+		}
+		g_ptr_array_free(profiles, TRUE);
+	}
+}
+
+/*
+ * Merge the results of a worker into the total; the workers ran at the
+ * same time, so the wall time is the longest of theirs.
+ */
+static void
+bench_result_merge(bench_result_t *total, bench_result_t *result)
+{
+	guint i, j;
+	dissector_profile_t *part, *sum;
+
+	total->packets += result->packets;
+	total->bytes += result->bytes;
+	total->allocs += result->allocs;
+	total->wall_time = MAX(total->wall_time, result->wall_time);
+	g_array_append_vals(total->latencies, result->latencies->data, result->latencies->len);
+
+	for (i = 0; i < result->profiles->len; i++) {
+		part = &g_array_index(result->profiles, dissector_profile_t, i);
+		sum = NULL;
+		for (j = 0; j < total->profiles->len; j++) {
+			dissector_profile_t *p = &g_array_index(total->profiles, dissector_profile_t, j);
+			if (p->heuristic == part->heuristic && !strcmp(p->name, part->name)) {
+				sum = p;
+				break;
+			}
+		}
+		if (sum == NULL) {
+			dissector_profile_t copy = *part;
+			copy.name = g_strdup(part->name);
+			g_array_append_val(total->profiles, copy);
+			continue;
+		}
+		sum->calls += part->calls;
+		sum->accepted += part->accepted;
+		sum->exceptions += part->exceptions;
+		sum->bytes += part->bytes;
+		sum->total_time += part->total_time;
+		sum->self_time += part->self_time;
+	}
+}
+
+#ifndef _WIN32
+static gboolean
+write_all(int fd, const void *data, size_t len)
+{
+	const char *p = (const char *)data;
+	ssize_t     n;
+
+	while (len != 0) {
+		n = write(fd, p, len);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return FALSE;
+		p += n;
+		len -= (size_t)n;
+	}
+	return TRUE;
+}
+
+static gboolean
+read_all(int fd, void *data, size_t len)
+{
+	char    *p = (char *)data;
+	ssize_t  n;
+
+	while (len != 0) {
+		n = read(fd, p, len);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return FALSE;
+		p += n;
+		len -= (size_t)n;
+	}
+	return TRUE;
+}
+
+/*
+ * The results are sent to the parent process as they are in memory, as
+ * both ends are the same program; each profile's name follows it. The
+ * profiles' protocol names are static strings of the dissectors, and, as
+ * the workers are forked, are at the same addresses in the parent.
+ */
+static gboolean
+send_result(int fd, const bench_result_t *result)
+{
+	guint i;
+	guint32 len;
+	const dissector_profile_t *profile;
+	guint64 counts[4];
+
+	counts[0] = result->packets;
+	counts[1] = result->bytes;
+	counts[2] = result->allocs;
+	counts[3] = result->wall_time;
+	if (!write_all(fd, counts, sizeof(counts)) ||
+	    !write_all(fd, &result->latencies->len, sizeof(guint)) ||
+	    !write_all(fd, result->latencies->data, result->latencies->len * sizeof(guint64)) ||
+	    !write_all(fd, &result->profiles->len, sizeof(guint)))
+		return FALSE;
+	for (i = 0; i < result->profiles->len; i++) {
+		profile = &g_array_index(result->profiles, dissector_profile_t, i);
+		len = (guint32)strlen(profile->name);
+		if (!write_all(fd, profile, sizeof(*profile)) ||
+		    !write_all(fd, &len, sizeof(len)) ||
+		    !write_all(fd, profile->name, len))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static gboolean
+receive_result(int fd, bench_result_t *result)
+{
+	guint i, count;
+	guint32 len;
+	dissector_profile_t profile;
+	guint64 counts[4];
+
+	bench_result_init(result);
+	if (!read_all(fd, counts, sizeof(counts)) ||
+	    !read_all(fd, &count, sizeof(count)))
+		return FALSE;
+	result->packets = counts[0];
+	result->bytes = counts[1];
+	result->allocs = counts[2];
+	result->wall_time = counts[3];
+	g_array_set_size(result->latencies, count);
+	if (!read_all(fd, result->latencies->data, count * sizeof(guint64)) ||
+	    !read_all(fd, &count, sizeof(count)))
+		return FALSE;
+	for (i = 0; i < count; i++) {
+		if (!read_all(fd, &profile, sizeof(profile)) ||
+		    !read_all(fd, &len, sizeof(len)))
+			return FALSE;
+		profile.name = (gchar *)g_malloc(len + 1);
+		if (!read_all(fd, profile.name, len)) {
+			g_free(profile.name);
+			return FALSE;
+		}
+		profile.name[len] = '\0';
+		g_array_append_val(result->profiles, profile);
+	}
+	return TRUE;
+}
+
+/* Fork the workers and merge their results. */
+static gboolean
+run_workers(guint jobs, guint passes, gboolean profile, bench_result_t *total)
+{
+	int           *fds = g_new(int, jobs);
+	pid_t         *pids = g_new(pid_t, jobs);
+	int            pipe_fds[2];
+	guint          i;
+	int            status;
+	gboolean       ok = TRUE;
+	bench_result_t result;
+
+	for (i = 0; i < jobs; i++) {
+		if (pipe(pipe_fds) < 0) {
+			fprintf(stderr, "fuzzshark_benchmark: pipe() failed: %s\n", g_strerror(errno));
+			exit(1);
+		}
+		pids[i] = fork();
+		if (pids[i] < 0) {
+			fprintf(stderr, "fuzzshark_benchmark: fork() failed: %s\n", g_strerror(errno));
+			exit(1);
+		}
+		if (pids[i] == 0) {
+			guint j;
+
+			close(pipe_fds[0]);
+			for (j = 0; j < i; j++)
+				close(fds[j]);
+			bench_result_init(&result);
+			run_worker(i, jobs, passes, profile, &result);
+			_exit(send_result(pipe_fds[1], &result) ? 0 : 1);
+		}
+		close(pipe_fds[1]);
+		fds[i] = pipe_fds[0];
+	}
+
+	for (i = 0; i < jobs; i++) {
+		if (receive_result(fds[i], &result))
+			bench_result_merge(total, &result);
+		else
+			ok = FALSE;
+		bench_result_free(&result);
+		close(fds[i]);
+		if (waitpid(pids[i], &status, 0) < 0 || !WIFEXITED(status) ||
+		    WEXITSTATUS(status) != 0) {
+			fprintf(stderr, "fuzzshark_benchmark: worker %u failed\n", i);
+			ok = FALSE;
+		}
+	}
+	g_free(fds);
+	g_free(pids);
+	return ok;
+}
+#endif /* _WIN32 */
+
+static int
+compare_guint64(const void *a, const void *b)
+{
+	guint64 x = *(const guint64 *)a, y = *(const guint64 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static int
+compare_profile_self_time(const void *a, const void *b)
+{
+	gint64 x = ((const dissector_profile_t *)a)->self_time;
+	gint64 y = ((const dissector_profile_t *)b)->self_time;
+
+	return x > y ? -1 : x < y;
+}
+
+/* The nearest-rank percentile of the sorted latencies. */
+static guint64
+percentile(const GArray *latencies, guint p)
+{
+	guint rank;
+
+	if (latencies->len == 0)
+		return 0;
+	rank = (guint)(((guint64)latencies->len * p + 99) / 100);
+	if (rank == 0)
+		rank = 1;
+	return g_array_index(latencies, guint64, rank - 1);
+}
+
+static void
+print_text(const bench_result_t *total, guint jobs, guint passes)
+{
+	double  seconds = total->wall_time / 1e9;
+	guint64 sum = 0;
+	guint   i;
+
+	for (i = 0; i < total->latencies->len; i++)
+		sum += g_array_index(total->latencies, guint64, i);
+
+	printf("Target:              %s\n", fuzzshark_target());
+	printf("Inputs:              %u, %u pass(es), %u job(s)\n", inputs->len, passes, jobs);
+	printf("Packets:             %" G_GINT64_MODIFIER "u (%" G_GINT64_MODIFIER "u bytes)\n",
+	    total->packets, total->bytes);
+	printf("Wall time:           %.3f s\n", seconds);
+	printf("Packets/s:           %.0f\n", seconds > 0 ? total->packets / seconds : 0.0);
+	printf("Allocations/packet:  %.1f\n",
+	    total->packets ? (double)total->allocs / total->packets : 0.0);
+	printf("Latency (ns):        mean %" G_GINT64_MODIFIER "u, p50 %" G_GINT64_MODIFIER "u, p99 %"
+	    G_GINT64_MODIFIER "u, max %" G_GINT64_MODIFIER "u\n",
+	    total->packets ? sum / total->packets : 0,
+	    percentile(total->latencies, 50), percentile(total->latencies, 99),
+	    percentile(total->latencies, 100));
+
+	if (total->profiles->len == 0)
+		return;
+	printf("\n%-32s %12s %12s %12s %12s %10s\n", "Dissector", "Calls", "Accepted",
+	    "Exceptions", "Self (us)", "Total (us)");
+	for (i = 0; i < total->profiles->len; i++) {
+		const dissector_profile_t *p = &g_array_index(total->profiles, dissector_profile_t, i);
+		printf("%-32s %12" G_GINT64_MODIFIER "u %12" G_GINT64_MODIFIER "u %12" G_GINT64_MODIFIER
+		    "u %12" G_GINT64_MODIFIER "d %10" G_GINT64_MODIFIER "d\n",
+		    p->name, p->calls, p->accepted, p->exceptions, p->self_time, p->total_time);
+	}
+}
+
+static void
+print_json(const bench_result_t *total, guint jobs, guint passes)
+{
+	json_dumper dumper = {
+		.output_file = stdout,
+		.flags = JSON_DUMPER_FLAGS_PRETTY_PRINT,
+	};
+	double  seconds = total->wall_time / 1e9;
+	guint64 sum = 0;
+	guint   i;
+
+	for (i = 0; i < total->latencies->len; i++)
+		sum += g_array_index(total->latencies, guint64, i);
+
+	json_dumper_begin_object(&dumper);
+	json_dumper_set_member_name(&dumper, "target");
+	json_dumper_value_string(&dumper, fuzzshark_target());
+	json_dumper_set_member_name(&dumper, "inputs");
+	json_dumper_value_anyf(&dumper, "%u", inputs->len);
+	json_dumper_set_member_name(&dumper, "passes");
+	json_dumper_value_anyf(&dumper, "%u", passes);
+	json_dumper_set_member_name(&dumper, "jobs");
+	json_dumper_value_anyf(&dumper, "%u", jobs);
+	json_dumper_set_member_name(&dumper, "packets");
+	json_dumper_value_anyf(&dumper, "%" G_GINT64_MODIFIER "u", total->packets);
+	json_dumper_set_member_name(&dumper, "bytes");
+	json_dumper_value_anyf(&dumper, "%" G_GINT64_MODIFIER "u", total->bytes);
+	json_dumper_set_member_name(&dumper, "wall_time_ns");
+	json_dumper_value_anyf(&dumper, "%" G_GINT64_MODIFIER "u", total->wall_time);
+	json_dumper_set_member_name(&dumper, "packets_per_second");
+	json_dumper_value_double(&dumper, seconds > 0 ? total->packets / seconds : 0.0);
+	json_dumper_set_member_name(&dumper, "allocations_per_packet");
+	json_dumper_value_double(&dumper,
+	    total->packets ? (double)total->allocs / total->packets : 0.0);
+	json_dumper_set_member_name(&dumper, "latency_ns");
+	json_dumper_begin_object(&dumper);
+	json_dumper_set_member_name(&dumper, "mean");
+	json_dumper_value_anyf(&dumper, "%" G_GINT64_MODIFIER "u",
+	    total->packets ? sum / total->packets : 0);
+	json_dumper_set_member_name(&dumper, "p50");
+	json_dumper_value_anyf(&dumper, "%" G_GINT64_MODIFIER "u", percentile(total->latencies, 50));
+	json_dumper_set_member_name(&dumper, "p99");
+	json_dumper_value_anyf(&dumper, "%" G_GINT64_MODIFIER "u", percentile(total->latencies, 99));
+	json_dumper_set_member_name(&dumper, "max");
+	json_dumper_value_anyf(&dumper, "%" G_GINT64_MODIFIER "u", percentile(total->latencies, 100));
+	json_dumper_end_object(&dumper);
+
+	json_dumper_set_member_name(&dumper, "dissectors");
+	json_dumper_begin_array(&dumper);
+	for (i = 0; i < total->profiles->len; i++) {
+		const dissector_profile_t *p = &g_array_index(total->profiles, dissector_profile_t, i);
+
+		json_dumper_begin_object(&dumper);
+		json_dumper_set_member_name(&dumper, "name");
+		json_dumper_value_string(&dumper, p->name);
+		json_dumper_set_member_name(&dumper, "heuristic");
+		json_dumper_value_anyf(&dumper, "%s", p->heuristic ? "true" : "false");
+		json_dumper_set_member_name(&dumper, "calls");
+		json_dumper_value_anyf(&dumper, "%" G_GINT64_MODIFIER "u", p->calls);
+		json_dumper_set_member_name(&dumper, "accepted");
+		json_dumper_value_anyf(&dumper, "%" G_GINT64_MODIFIER "u", p->accepted);
+		json_dumper_set_member_name(&dumper, "exceptions");
+		json_dumper_value_anyf(&dumper, "%" G_GINT64_MODIFIER "u", p->exceptions);
+		json_dumper_set_member_name(&dumper, "bytes");
+		json_dumper_value_anyf(&dumper, "%" G_GINT64_MODIFIER "u", p->bytes);
+		json_dumper_set_member_name(&dumper, "self_time_us");
+		json_dumper_value_anyf(&dumper, "%" G_GINT64_MODIFIER "d", p->self_time);
+		json_dumper_set_member_name(&dumper, "total_time_us");
+		json_dumper_value_anyf(&dumper, "%" G_GINT64_MODIFIER "d", p->total_time);
+		json_dumper_end_object(&dumper);
+	}
+	json_dumper_end_array(&dumper);
+	json_dumper_end_object(&dumper);
+	json_dumper_finish(&dumper);
+}
+
+int
+main(int argc, char **argv)
+{
+	int            opt;
+	guint          jobs = 1;
+	guint          passes = 1;
+	gboolean       captures = FALSE;
+	gboolean       profile = FALSE;
+	gboolean       json = FALSE;
+	gboolean       ok = TRUE;
+	bench_result_t total;
+
+	while ((opt = getopt(argc, argv, "cj:n:pT:h")) != -1) {
+		switch (opt) {
+		case 'c':
+			captures = TRUE;
+			break;
+		case 'j':
+			jobs = (guint)strtoul(optarg, NULL, 10);
+			break;
+		case 'n':
+			passes = (guint)strtoul(optarg, NULL, 10);
+			break;
+		case 'p':
+			profile = TRUE;
+			break;
+		case 'T':
+			if (!strcmp(optarg, "json")) {
+				json = TRUE;
+			} else if (strcmp(optarg, "text")) {
+				fprintf(stderr, "fuzzshark_benchmark: unknown output format \"%s\"\n", optarg);
+				return 1;
+			}
+			break;
+		case 'h':
+			print_usage(stdout);
+			return 0;
+		default:
+			print_usage(stderr);
+			return 1;
+		}
+	}
+	if (optind >= argc || jobs == 0 || passes == 0) {
+		print_usage(stderr);
+		return 1;
+	}
+#ifdef _WIN32
+	if (jobs > 1) {
+		fprintf(stderr, "fuzzshark_benchmark: only one job is supported on Windows\n");
+		jobs = 1;
+	}
+#endif
+
+	fuzzshark_set_benchmarking(TRUE);
+	LLVMFuzzerInitialize(&argc, &argv);
+
+	/* Read all the inputs first, so that no I/O is timed. */
+	inputs = g_ptr_array_new_with_free_func((GDestroyNotify)g_bytes_unref);
+	for (; optind < argc && ok; optind++)
+		ok = add_input(argv[optind], captures);
+	if (!ok)
+		return 1;
+	if (inputs->len < jobs)
+		jobs = MAX(inputs->len, 1);
+
+	bench_result_init(&total);
+#ifndef _WIN32
+	if (jobs > 1) {
+		ok = run_workers(jobs, passes, profile, &total);
+	} else
+#endif
+	{
+		run_worker(0, 1, passes, profile, &total);
+	}
+
+	g_array_sort(total.latencies, compare_guint64);
+	g_array_sort(total.profiles, compare_profile_self_time);
+	if (json)
+		print_json(&total, jobs, passes);
+	else
+		print_text(&total, jobs, passes);
+
+	bench_result_free(&total);
+	g_ptr_array_free(inputs, TRUE);
+	return ok ? 0 : 1;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
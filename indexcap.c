@@ -0,0 +1,604 @@
+/* indexcap.c
+ * Build, show and search the indexes written beside capture files by
+ * dumpcap --index, and extract the packets to or from a host from a set
+ * of capture files.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+/*
+ * If we have getopt_long() in the system library, include <getopt.h>.
+ * Otherwise, we're using our own getopt_long() (either because the
+ * system has getopt() but not getopt_long(), as with some UN*Xes,
+ * or because it doesn't even have getopt(), as with Windows), so
+ * include our getopt_long()'s header.
+ */
+#ifdef HAVE_GETOPT_LONG
+#include <getopt.h>
+#else
+#include <wsutil/wsgetopt.h>
+#endif
+
+#include <wiretap/wtap.h>
+
+#include <ui/cmdarg_err.h>
+#include <wsutil/capture_index.h>
+#include <wsutil/filesystem.h>
+#include <wsutil/file_util.h>
+#include <wsutil/nstime.h>
+#include <wsutil/privileges.h>
+#include <cli_main.h>
+#include <version_info.h>
+#include <wiretap/wtap_opttypes.h>
+
+#ifdef HAVE_PLUGINS
+#include <wsutil/plugins.h>
+#endif
+
+#include <wsutil/report_message.h>
+
+#include "ui/failure_message.h"
+
+#define INVALID_OPTION 1
+#define OPEN_ERROR 2
+#define OUTPUT_FILE_ERROR 1
+
+#define MAX_ENDPOINTS 2
+
+/* Show command-line usage */
+static void
+print_usage(FILE *output)
+{
+    fprintf(output, "\n");
+    fprintf(output, "Usage: indexcap [options] <infile> ...\n");
+    fprintf(output, "\n");
+    fprintf(output, "Options:\n");
+    fprintf(output, "  -b                     build an index for each input file.\n");
+    fprintf(output, "  -s                     show a summary of each input file's index\n");
+    fprintf(output, "                         (the default if -b and -w aren't given).\n");
+    fprintf(output, "  -w <outfile>           write the matching packets from all of the\n");
+    fprintf(output, "                         input files to <outfile>.\n");
+    fprintf(output, "  -A <start time>        only write packets with timestamps on or after\n");
+    fprintf(output, "                         the start time, given as YYYY-MM-DDThh:mm:ss[.nnnnnnnnn][Z|+-hh:mm]\n");
+    fprintf(output, "                         or as seconds since the Epoch.\n");
+    fprintf(output, "  -B <stop time>         only write packets with timestamps before the\n");
+    fprintf(output, "                         stop time, given the same way.\n");
+    fprintf(output, "  -e <host>[:<port>]     only write packets to or from the IP address,\n");
+    fprintf(output, "                         and port if given; with two -e options, only\n");
+    fprintf(output, "                         packets between the two.\n");
+    fprintf(output, "  -h                     display this help and exit.\n");
+    fprintf(output, "  -v                     print version information and exit.\n");
+}
+
+/* What we're looking for. */
+typedef struct {
+    capture_index_endpoint  eps[MAX_ENDPOINTS];
+    guint                   num_eps;
+    gint64                  start;
+    gint64                  stop;
+} index_query;
+
+/* The LINKTYPE_ value the index parser wants for a packet's encapsulation,
+   or -1 if it wouldn't understand it. */
+static int
+encap_to_linktype(int encap)
+{
+    switch (encap) {
+
+    case WTAP_ENCAP_ETHERNET:
+        return 1;       /* LINKTYPE_ETHERNET */
+
+    case WTAP_ENCAP_NULL:
+        return 0;       /* LINKTYPE_NULL */
+
+    case WTAP_ENCAP_RAW_IP:
+        return 101;     /* LINKTYPE_RAW */
+
+    case WTAP_ENCAP_LOOP:
+        return 108;     /* LINKTYPE_LOOP */
+
+    case WTAP_ENCAP_SLL:
+        return 113;     /* LINKTYPE_LINUX_SLL */
+
+    case WTAP_ENCAP_RAW_IP4:
+        return 228;     /* LINKTYPE_IPV4 */
+
+    case WTAP_ENCAP_RAW_IP6:
+        return 229;     /* LINKTYPE_IPV6 */
+
+    case WTAP_ENCAP_SLL2:
+        return 276;     /* LINKTYPE_LINUX_SLL2 */
+
+    default:
+        return -1;
+    }
+}
+
+static gint64
+rec_ts_nsecs(const wtap_rec *rec)
+{
+    if (!(rec->presence_flags & WTAP_HAS_TS))
+        return 0;
+    return (gint64)rec->ts.secs * 1000000000 + rec->ts.nsecs;
+}
+
+/* Is a packet one we're looking for? */
+static gboolean
+packet_matches(const index_query *q, const wtap_rec *rec, const guint8 *pd)
+{
+    capture_index_flow flow;
+    gint64 ts;
+    guint i;
+
+    if (rec->rec_type != REC_TYPE_PACKET)
+        return FALSE;
+    ts = rec_ts_nsecs(rec);
+    if (ts < q->start || ts > q->stop)
+        return FALSE;
+    if (q->num_eps == 0)
+        return TRUE;
+
+    capture_index_parse_packet(encap_to_linktype(rec->rec_header.packet_header.pkt_encap),
+                               pd, rec->rec_header.packet_header.caplen, &flow);
+    for (i = 0; i < q->num_eps; i++) {
+        if (!capture_index_flow_has_endpoint(&flow, &q->eps[i]))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ * Find the index for a capture file: the file's name with the index
+ * suffix, or, for a file that was compressed after it was written, its
+ * name without the compression suffix and with the index suffix.
+ */
+static capture_index *
+find_index(const char *infile)
+{
+    static const char *const compressed_suffixes[] = { ".gz", ".zst", ".lz4" };
+    capture_index *ci;
+    gchar *path;
+    size_t len = strlen(infile);
+    size_t i;
+    int err;
+
+    path = g_strconcat(infile, CAPTURE_INDEX_SUFFIX, NULL);
+    ci = capture_index_read(path, &err);
+    g_free(path);
+    if (ci != NULL)
+        return ci;
+
+    for (i = 0; i < G_N_ELEMENTS(compressed_suffixes); i++) {
+        size_t suffix_len = strlen(compressed_suffixes[i]);
+
+        if (len > suffix_len &&
+            strcmp(infile + len - suffix_len, compressed_suffixes[i]) == 0) {
+            gchar *base = g_strndup(infile, len - suffix_len);
+
+            path = g_strconcat(base, CAPTURE_INDEX_SUFFIX, NULL);
+            g_free(base);
+            ci = capture_index_read(path, &err);
+            g_free(path);
+            return ci;
+        }
+    }
+    return NULL;
+}
+
+/* Read a capture file and write an index for it. */
+static gboolean
+build_index(const char *infile)
+{
+    wtap *wth;
+    wtap_rec rec;
+    Buffer buf;
+    int err;
+    gchar *err_info;
+    gint64 data_offset;
+    capture_index *ci;
+    gchar *path;
+    gboolean ok = TRUE;
+
+    wth = wtap_open_offline(infile, WTAP_TYPE_AUTO, &err, &err_info, TRUE);
+    if (wth == NULL) {
+        cfile_open_failure_message(infile, err, err_info);
+        return FALSE;
+    }
+
+    ci = capture_index_new();
+    wtap_rec_init(&rec);
+    ws_buffer_init(&buf, 1514);
+    while (wtap_read(wth, &rec, &buf, &err, &err_info, &data_offset)) {
+        if (rec.rec_type != REC_TYPE_PACKET)
+            continue;
+        capture_index_add_packet(ci, data_offset, rec_ts_nsecs(&rec),
+                                 encap_to_linktype(rec.rec_header.packet_header.pkt_encap),
+                                 ws_buffer_start_ptr(&buf),
+                                 rec.rec_header.packet_header.caplen);
+    }
+    wtap_rec_cleanup(&rec);
+    ws_buffer_free(&buf);
+    wtap_close(wth);
+    if (err != 0) {
+        cfile_read_failure_message(infile, err, err_info);
+        capture_index_free(ci);
+        return FALSE;
+    }
+
+    path = g_strconcat(infile, CAPTURE_INDEX_SUFFIX, NULL);
+    err = capture_index_write(ci, path);
+    if (err != 0) {
+        write_failure_message(path, err);
+        ok = FALSE;
+    } else {
+        printf("%s: %u packets in %u blocks\n", path,
+               capture_index_num_packets(ci), capture_index_num_blocks(ci));
+    }
+    g_free(path);
+    capture_index_free(ci);
+    return ok;
+}
+
+static void
+print_ts(const char *label, gint64 ts)
+{
+    time_t secs = (time_t)(ts / 1000000000);
+    struct tm *tm = gmtime(&secs);
+
+    if (tm != NULL) {
+        printf("%s%04d-%02d-%02dT%02d:%02d:%02d.%09dZ\n", label,
+               tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday,
+               tm->tm_hour, tm->tm_min, tm->tm_sec, (int)(ts % 1000000000));
+    }
+}
+
+/* Print what a capture file's index says about it. */
+static gboolean
+show_index(const char *infile)
+{
+    capture_index *ci = find_index(infile);
+    gint64 first, last;
+    int proto;
+
+    if (ci == NULL) {
+        cmdarg_err("\"%s\" has no index.", infile);
+        return FALSE;
+    }
+
+    printf("File:               %s\n", infile);
+    printf("Complete:           %s\n", capture_index_is_complete(ci) ? "yes" : "no");
+    printf("Packets:            %u\n", capture_index_num_packets(ci));
+    printf("Blocks:             %u\n", capture_index_num_blocks(ci));
+    if (capture_index_time_range(ci, &first, &last)) {
+        print_ts("First packet:       ", first);
+        print_ts("Last packet:        ", last);
+    }
+    for (proto = 0; proto < CAPTURE_INDEX_NUM_PROTOS; proto++) {
+        printf("%-20s%" G_GUINT64_FORMAT "\n",
+               capture_index_proto_name((capture_index_proto)proto),
+               capture_index_proto_count(ci, (capture_index_proto)proto));
+    }
+    capture_index_free(ci);
+    return TRUE;
+}
+
+static gboolean
+write_packet(wtap_dumper *pdh, const wtap_rec *rec, Buffer *buf,
+             const char *infile, const char *outfile, guint32 framenum,
+             int file_type_subtype)
+{
+    int err;
+    gchar *err_info;
+
+    if (!wtap_dump(pdh, rec, ws_buffer_start_ptr(buf), &err, &err_info)) {
+        cfile_write_failure_message(infile, outfile, err, err_info, framenum,
+                                    file_type_subtype);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ * Write the packets in a capture file that match the query, reading
+ * only the blocks the index says might have them; without a complete
+ * index, read the whole file.
+ */
+static gboolean
+extract_packets(const char *infile, const index_query *q, wtap_dumper **pdhp,
+                const char *outfile, int *out_encap, guint *num_written)
+{
+    wtap *wth;
+    wtap_rec rec;
+    Buffer buf;
+    int err;
+    gchar *err_info;
+    gint64 data_offset;
+    capture_index *ci;
+    GArray *offsets = NULL;
+    guint32 framenum = 0;
+    gboolean ok = TRUE;
+    guint i;
+
+    wth = wtap_open_offline(infile, WTAP_TYPE_AUTO, &err, &err_info, TRUE);
+    if (wth == NULL) {
+        cfile_open_failure_message(infile, err, err_info);
+        return FALSE;
+    }
+
+    if (*pdhp == NULL) {
+        /* Write the output in the format of the first input file. */
+        wtap_dump_params params;
+
+        wtap_dump_params_init(&params, wth);
+        if (strcmp(outfile, "-") == 0) {
+            *pdhp = wtap_dump_open_stdout(wtap_file_type_subtype(wth),
+                                          WTAP_UNCOMPRESSED, &params, &err, &err_info);
+        } else {
+            *pdhp = wtap_dump_open(outfile, wtap_file_type_subtype(wth),
+                                   WTAP_UNCOMPRESSED, &params, &err, &err_info);
+        }
+        wtap_dump_params_cleanup(&params);
+        if (*pdhp == NULL) {
+            cfile_dump_open_failure_message(outfile, err, err_info,
+                                            wtap_file_type_subtype(wth));
+            wtap_close(wth);
+            return FALSE;
+        }
+        *out_encap = wtap_file_encap(wth);
+    } else if (wtap_file_encap(wth) != *out_encap) {
+        cmdarg_err("\"%s\" has a different link-layer type from the first input file.",
+                   infile);
+        wtap_close(wth);
+        return FALSE;
+    }
+
+    ci = find_index(infile);
+    if (ci != NULL && capture_index_is_complete(ci))
+        offsets = capture_index_find(ci, q->eps, q->num_eps, q->start, q->stop);
+    capture_index_free(ci);
+
+    wtap_rec_init(&rec);
+    ws_buffer_init(&buf, 1514);
+    if (offsets != NULL) {
+        for (i = 0; i < offsets->len && ok; i++) {
+            framenum++;
+            if (!wtap_seek_read(wth, g_array_index(offsets, gint64, i), &rec, &buf,
+                                &err, &err_info)) {
+                cfile_read_failure_message(infile, err, err_info);
+                ok = FALSE;
+                break;
+            }
+            if (packet_matches(q, &rec, ws_buffer_start_ptr(&buf))) {
+                if ((ok = write_packet(*pdhp, &rec, &buf, infile, outfile, framenum,
+                                       wtap_file_type_subtype(wth))))
+                    (*num_written)++;
+            }
+        }
+        g_array_free(offsets, TRUE);
+    } else {
+        while (ok && wtap_read(wth, &rec, &buf, &err, &err_info, &data_offset)) {
+            framenum++;
+            if (packet_matches(q, &rec, ws_buffer_start_ptr(&buf))) {
+                if ((ok = write_packet(*pdhp, &rec, &buf, infile, outfile, framenum,
+                                       wtap_file_type_subtype(wth))))
+                    (*num_written)++;
+            }
+        }
+        if (ok && err != 0) {
+            cfile_read_failure_message(infile, err, err_info);
+            ok = FALSE;
+        }
+    }
+    wtap_rec_cleanup(&rec);
+    ws_buffer_free(&buf);
+    wtap_close(wth);
+    return ok;
+}
+
+/*
+ * General errors and warnings are reported with an console message
+ * in indexcap.
+ */
+static void
+indexcap_cmdarg_err(const char *msg_format, va_list ap)
+{
+    fprintf(stderr, "indexcap: ");
+    vfprintf(stderr, msg_format, ap);
+    fprintf(stderr, "\n");
+}
+
+/*
+ * Report additional information for an error in command-line arguments.
+ */
+static void
+indexcap_cmdarg_err_cont(const char *msg_format, va_list ap)
+{
+    vfprintf(stderr, msg_format, ap);
+    fprintf(stderr, "\n");
+}
+
+/********************************************************************/
+/* Main function.                                                   */
+/********************************************************************/
+int
+main(int argc, char *argv[])
+{
+    char *init_progfile_dir_error;
+    static const struct report_message_routines indexcap_message_routines = {
+        failure_message,
+        failure_message,
+        open_failure_message,
+        read_failure_message,
+        write_failure_message,
+        cfile_open_failure_message,
+        cfile_dump_open_failure_message,
+        cfile_read_failure_message,
+        cfile_write_failure_message,
+        cfile_close_failure_message
+    };
+    gboolean build = FALSE;
+    gboolean show = FALSE;
+    const char *outfile = NULL;
+    index_query query;
+    wtap_dumper *pdh = NULL;
+    int out_encap = WTAP_ENCAP_UNKNOWN;
+    guint num_written = 0;
+    int err;
+    gchar *err_info;
+    int i;
+    int ret = EXIT_SUCCESS;
+
+    int opt;
+    static const struct option long_options[] = {
+        {"help", no_argument, NULL, 'h'},
+        {"version", no_argument, NULL, 'v'},
+        {0, 0, 0, 0 }
+    };
+
+    cmdarg_err_init(indexcap_cmdarg_err, indexcap_cmdarg_err_cont);
+
+    /* Initialize the version information. */
+    ws_init_version_info("Indexcap (Wireshark)", NULL, NULL, NULL);
+
+    /*
+     * Get credential information for later use.
+     */
+    init_process_policies();
+
+    /*
+     * Attempt to get the pathname of the directory containing the
+     * executable file.
+     */
+    init_progfile_dir_error = init_progfile_dir(argv[0]);
+    if (init_progfile_dir_error != NULL) {
+        fprintf(stderr,
+                "indexcap: Can't get pathname of directory containing the indexcap program: %s.\n",
+                init_progfile_dir_error);
+        g_free(init_progfile_dir_error);
+    }
+
+    init_report_message("indexcap", &indexcap_message_routines);
+
+    wtap_init(TRUE);
+
+    memset(&query, 0, sizeof query);
+    query.start = G_MININT64;
+    query.stop = G_MAXINT64;
+
+    /* Process the options first */
+    while ((opt = getopt_long(argc, argv, "A:B:be:hsvw:", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'A':
+            case 'B':
+            {
+                nstime_t in_time;
+
+                if ((0 < iso8601_to_nstime(&in_time, optarg)) || (0 < unix_epoch_to_nstime(&in_time, optarg))) {
+                    gint64 ts = (gint64)in_time.secs * 1000000000 + in_time.nsecs;
+
+                    if (opt == 'A')
+                        query.start = ts;
+                    else
+                        query.stop = ts - 1;
+                } else {
+                    cmdarg_err("\"%s\" isn't a valid date and time", optarg);
+                    ret = INVALID_OPTION;
+                    goto clean_exit;
+                }
+                break;
+            }
+            case 'b':
+                build = TRUE;
+                break;
+            case 'e':
+                if (query.num_eps == MAX_ENDPOINTS) {
+                    cmdarg_err("At most %d endpoints can be given.", MAX_ENDPOINTS);
+                    ret = INVALID_OPTION;
+                    goto clean_exit;
+                }
+                if (!capture_index_parse_endpoint(optarg, &query.eps[query.num_eps])) {
+                    cmdarg_err("\"%s\" isn't a valid address, or address and port", optarg);
+                    ret = INVALID_OPTION;
+                    goto clean_exit;
+                }
+                query.num_eps++;
+                break;
+            case 's':
+                show = TRUE;
+                break;
+            case 'w':
+                outfile = optarg;
+                break;
+            case 'h':
+                show_help_header("Build, show and search capture file indexes.");
+                print_usage(stdout);
+                goto clean_exit;
+            case 'v':
+                show_version();
+                goto clean_exit;
+            case '?':
+                print_usage(stderr);
+                ret = INVALID_OPTION;
+                goto clean_exit;
+        }
+    }
+
+    /* Remaining args are file names */
+    if (optind >= argc) {
+        print_usage(stderr);
+        ret = INVALID_OPTION;
+        goto clean_exit;
+    }
+    if (!build && outfile == NULL)
+        show = TRUE;
+
+    for (i = optind; i < argc; i++) {
+        if (build && !build_index(argv[i]))
+            ret = OPEN_ERROR;
+        if (show && !show_index(argv[i]))
+            ret = OPEN_ERROR;
+        if (outfile != NULL &&
+            !extract_packets(argv[i], &query, &pdh, outfile, &out_encap, &num_written)) {
+            ret = OUTPUT_FILE_ERROR;
+            break;
+        }
+    }
+
+    if (pdh != NULL) {
+        if (!wtap_dump_close(pdh, &err, &err_info)) {
+            cfile_close_failure_message(outfile, err, err_info);
+            ret = OUTPUT_FILE_ERROR;
+        } else if (strcmp(outfile, "-") != 0) {
+            printf("%u packets written to %s\n", num_written, outfile);
+        }
+    }
+
+clean_exit:
+    wtap_cleanup();
+    free_progdirs();
+    return ret;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -117,6 +117,11 @@ main(int argc, char *argv[])
     int in_items = 0;
     while (in_items != EOF) {
         int gai_err;
+        int is_ipv4;
+        // The longest prefix of the networks the address was found in, or
+        // -1 if a lookup failed: every address in that prefix has the same
+        // results, and the caller can keep them for all of it.
+        int prefix_len = 0;
 
         in_items = fscanf(stdin, "%" MMDBR_STRINGIFY(MAX_ADDR_LEN) "s", addr_str);
 
@@ -125,6 +130,7 @@ main(int argc, char *argv[])
         }
 
         fprintf(stdout, "[%s]\n", addr_str);
+        is_ipv4 = strchr(addr_str, ':') == NULL;
 
 #ifdef MMDB_DEBUG_SLOW
 #ifdef _WIN32
@@ -136,6 +142,19 @@ main(int argc, char *argv[])
             fprintf(stdout, "# %s\n", mmdbs[mmdb_idx].metadata.database_type);
             MMDB_lookup_result_s result = MMDB_lookup_string(&mmdbs[mmdb_idx], addr_str, &gai_err, &mmdb_err);
 
+            if (gai_err != 0 || mmdb_err != MMDB_SUCCESS) {
+                prefix_len = -1;
+            } else if (prefix_len >= 0) {
+                // IPv4 addresses in IPv6 databases are in ::/96.
+                int netmask = result.netmask;
+                if (is_ipv4 && mmdbs[mmdb_idx].metadata.ip_version == 6) {
+                    netmask = netmask >= 96 ? netmask - 96 : 0;
+                }
+                if (netmask > prefix_len) {
+                    prefix_len = netmask;
+                }
+            }
+
             if (result.found_entry && gai_err == 0 && mmdb_err == MMDB_SUCCESS) {
                 for (size_t key_idx = 0; lookup_keys[key_idx][0]; key_idx++) {
                     MMDB_entry_data_s entry_data;
@@ -181,6 +200,9 @@ main(int argc, char *argv[])
                 // dump error info.
             }
         }
+        if (prefix_len >= 0) {
+            fprintf(stdout, "network.prefix_length: %d\n", prefix_len);
+        }
         fprintf(stdout, "# End %s\n", addr_str);
         fflush(stdout);
     }
@@ -234,6 +234,9 @@ typedef struct _mate_config {
 	int dbg_gop_lvl;
 	int dbg_gog_lvl;
 
+	/* seconds after which idle groups are forgotten, or 0 to keep them all */
+	float forget_after;
+
 	GPtrArray* config_stack;
 	GString* config_error;
 
@@ -250,6 +253,7 @@ typedef struct _mate_runtime_data {
 	guint current_items; /* a count of items */
 	float now;
 	guint highest_analyzed_frame;
+	float next_forget; /* when to look for idle groups next */
 
 	GHashTable* frames; /* k=frame.num v=pdus */
 
@@ -136,6 +136,7 @@ void initialize_mate_runtime(mate_config* mc) {
 		rd->current_items = 0;
 		rd->now = -1.0f;
 		rd->highest_analyzed_frame = 0;
+		rd->next_forget = 0.0f;
 		rd->frames = g_hash_table_new(g_direct_hash,g_direct_equal);
 
 
@@ -193,6 +194,7 @@ static mate_gop* new_gop(mate_cfg_gop* cfg, mate_pdu* pdu, gchar* key) {
 	pdu->time_in_gop = 0.0f;
 
 	g_hash_table_insert(cfg->gop_index,gop->gop_key,gop);
+	g_hash_table_insert(cfg->items,GUINT_TO_POINTER(gop->id),gop);
 	return gop;
 }
 
@@ -248,6 +250,8 @@ static mate_gog* new_gog(mate_cfg_gog* cfg, mate_gop* gop) {
 
 	adopt_gop(gog,gop);
 
+	g_hash_table_insert(cfg->items,GUINT_TO_POINTER(gog->id),gog);
+
 	return gog;
 }
 
@@ -823,6 +827,91 @@ static mate_pdu* new_pdu(mate_cfg_pdu* cfg, guint32 framenum, field_info* proto,
 }
 
 
+/*
+ * When analyzing in a single pass no frame is dissected again, so the items
+ * only need to be kept for as long as more pdus can be added to them: gogs
+ * and their gops are freed, with their pdus, once none of the gops has had
+ * a pdu for forget_after seconds, and so are idle gops not in any gog and
+ * the pdus not in any gop.
+ */
+static void forget_gop_pdus(mate_gop* gop) {
+	mate_pdu* pdu;
+	mate_pdu* next;
+
+	for (pdu = gop->pdus; pdu; pdu = next) {
+		next = pdu->next;
+		g_hash_table_remove(pdu->cfg->items,GUINT_TO_POINTER(pdu->id));
+		destroy_mate_pdus(NULL,pdu,NULL);
+	}
+}
+
+static gboolean forget_idle_gog(gpointer k _U_, gpointer v, gpointer p) {
+	mate_gog* gog = (mate_gog*) v;
+	float idle_since = *((float*) p);
+	mate_gop* gop;
+	mate_gop* next;
+
+	for (gop = gog->gops; gop; gop = gop->next) {
+		if (gop->last_time >= idle_since) return FALSE;
+	}
+
+	dbg_print (dbg_gog,3,dbg_facility,"forget_idle_gog: %s:%d",gog->cfg->name,gog->id);
+
+	for (gop = gog->gops; gop; gop = next) {
+		next = gop->next;
+		forget_gop_pdus(gop);
+		g_hash_table_remove(gop->cfg->items,GUINT_TO_POINTER(gop->id));
+		destroy_mate_gops(NULL,gop,NULL);
+	}
+
+	return destroy_mate_gogs(NULL,gog,NULL);
+}
+
+static gboolean forget_idle_gop(gpointer k _U_, gpointer v, gpointer p) {
+	mate_gop* gop = (mate_gop*) v;
+	float idle_since = *((float*) p);
+
+	if (gop->gog || gop->last_time >= idle_since) return FALSE;
+
+	dbg_print (dbg_gop,3,dbg_facility,"forget_idle_gop: %s:%d",gop->cfg->name,gop->id);
+
+	forget_gop_pdus(gop);
+	return destroy_mate_gops(NULL,gop,NULL);
+}
+
+static gboolean forget_unassigned_pdu(gpointer k, gpointer v, gpointer p) {
+	mate_pdu* pdu = (mate_pdu*) v;
+
+	if (pdu->gop) return FALSE;
+
+	return destroy_mate_pdus(k,v,p);
+}
+
+static void forget_idle_gogs_in_cfg(gpointer k _U_, gpointer v, gpointer p) {
+	g_hash_table_foreach_remove(((mate_cfg_gog*)v)->items,forget_idle_gog,p);
+}
+
+static void forget_idle_gops_in_cfg(gpointer k _U_, gpointer v, gpointer p) {
+	g_hash_table_foreach_remove(((mate_cfg_gop*)v)->items,forget_idle_gop,p);
+}
+
+static void forget_unassigned_pdus_in_cfg(gpointer k _U_, gpointer v, gpointer p) {
+	g_hash_table_foreach_remove(((mate_cfg_pdu*)v)->items,forget_unassigned_pdu,p);
+}
+
+static void forget_idle_items(mate_config* mc) {
+	float idle_since = rd->now - mc->forget_after;
+
+	dbg_print (dbg,2,dbg_facility,"forget_idle_items: idle since %f",idle_since);
+
+	g_hash_table_foreach(mc->gogcfgs,forget_idle_gogs_in_cfg,&idle_since);
+	g_hash_table_foreach(mc->gopcfgs,forget_idle_gops_in_cfg,&idle_since);
+	g_hash_table_foreach(mc->pducfgs,forget_unassigned_pdus_in_cfg,NULL);
+
+	/* the frames already analyzed won't be looked up again */
+	g_hash_table_remove_all(rd->frames);
+}
+
 extern void mate_analyze_frame(mate_config *mc, packet_info *pinfo, proto_tree* tree) {
 	mate_cfg_pdu* cfg;
 	GPtrArray* protos;
@@ -837,6 +926,12 @@ extern void mate_analyze_frame(mate_config *mc, packet_info *pinfo, proto_tree*
 
 	if ( proto_tracking_interesting_fields(tree)
 		 && rd->highest_analyzed_frame < pinfo->num ) {
+
+		if (mc->forget_after > 0.0f && rd->now >= rd->next_forget) {
+			forget_idle_items(mc);
+			rd->next_forget = rd->now + mc->forget_after;
+		}
+
 		for ( i = 0; i < mc->pducfglist->len; i++ ) {
 
 			cfg = (mate_cfg_pdu *)g_ptr_array_index(mc->pducfglist,i);
@@ -886,6 +981,8 @@ extern void mate_analyze_frame(mate_config *mc, packet_info *pinfo, proto_tree*
 						pdu->avpl = NULL;
 					}
 
+					g_hash_table_insert(cfg->items,GUINT_TO_POINTER(pdu->id),pdu);
+
 					if (!last) {
 						g_hash_table_insert(rd->frames,GINT_TO_POINTER(pinfo->num),pdu);
 						last = pdu;
@@ -625,6 +625,8 @@ extern mate_config* mate_make_config(const gchar* filename, int mate_hfid) {
 	mc->dbg_gop_lvl = 0;
 	mc->dbg_gog_lvl = 0;
 
+	mc->forget_after = 0.0f;
+
 	mc->config_error = g_string_new("");
 
 	ett = &mc->ett_root;
@@ -447,6 +447,15 @@ static void insert_avp_before_node(AVPL* avpl, AVPN* next_node, AVP *avp, gboole
 #endif
 }
 
+/*
+ * The names and values of the avps are subscribed to avp_strings, so equal
+ * strings are most often the same string: compare pointers first, and only
+ * compare the characters of different ones, to keep the lists sorted.
+ */
+static inline int avp_strcmp(const gchar* a, const gchar* b) {
+	return a == b ? 0 : g_strcmp0(a, b);
+}
+
 /**
  * insert_avp:
  * @param avpl the avpl in which to insert.
@@ -466,12 +475,23 @@ extern gboolean insert_avp(AVPL* avpl, AVP* avp) {
 	dbg_print(dbg_avpl_op,4,dbg_fp,"insert_avp: %p %p %s%c%s;",avpl,avp,avp->n,avp->o,avp->v);
 #endif
 
+	/* avps sorted after the last one are appended without walking the list */
+	c = avpl->null.prev;
+	if (c->avp) {
+		int name_diff = avp_strcmp(avp->n, c->avp->n);
+
+		if (name_diff > 0 || (name_diff == 0 && avp_strcmp(avp->v, c->avp->v) > 0)) {
+			insert_avp_before_node(avpl, &avpl->null, avp, FALSE);
+			return TRUE;
+		}
+	}
+
 	/* get to the insertion point */
 	for (c=avpl->null.next; c->avp; c = c->next) {
-		int name_diff = strcmp(avp->n, c->avp->n);
+		int name_diff = avp_strcmp(avp->n, c->avp->n);
 
 		if (name_diff == 0) {
-			int value_diff = strcmp(avp->v, c->avp->v);
+			int value_diff = avp_strcmp(avp->v, c->avp->v);
 
 			if (value_diff < 0) {
 				break;
@@ -794,7 +814,7 @@ extern void merge_avpl(AVPL* dst, AVPL* src, gboolean copy_avps) {
 
 	while (cs->avp && cd->avp) {
 
-		int name_diff = strcmp(cd->avp->n, cs->avp->n);
+		int name_diff = avp_strcmp(cd->avp->n, cs->avp->n);
 
 		if (name_diff < 0) {
 			// dest < source, advance dest to find a better place to insert
@@ -805,7 +825,7 @@ extern void merge_avpl(AVPL* dst, AVPL* src, gboolean copy_avps) {
 			cs = cs->next;
 		} else {
 			// attribute names are equal. Ignore duplicate values but ensure that other values are sorted.
-			int value_diff = strcmp(cd->avp->v, cs->avp->v);
+			int value_diff = avp_strcmp(cd->avp->v, cs->avp->v);
 
 			if (value_diff < 0) {
 				// dest < source, do not insert it yet
@@ -995,7 +1015,7 @@ extern AVPL* new_avpl_loose_match(const gchar* name,
 	cs = src->null.next;
 	co = op->null.next;
 	while (cs->avp && co->avp) {
-		int name_diff = strcmp(co->avp->n, cs->avp->n);
+		int name_diff = avp_strcmp(co->avp->n, cs->avp->n);
 
 		if (name_diff < 0) {
 			// op < source, op is not matching
@@ -1056,7 +1076,7 @@ extern AVPL* new_avpl_pairs_match(const gchar* name, AVPL* src, AVPL* op, gboole
 	cs = src->null.next;
 	co = op->null.next;
 	while (cs->avp && co->avp) {
-		int name_diff = g_strcmp0(co->avp->n, cs->avp->n);
+		int name_diff = avp_strcmp(co->avp->n, cs->avp->n);
 		const gchar *failed_match = NULL;
 
 		if (name_diff < 0) {
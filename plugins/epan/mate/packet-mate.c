@@ -36,6 +36,7 @@ static expert_field ei_mate_undefined_attribute = EI_INIT;
 
 static const gchar* pref_mate_config_filename = "";
 static const gchar* current_mate_config_filename = NULL;
+static guint pref_mate_forget_after = 0;
 
 #ifdef _AVP_DEBUGGING
 static int pref_avp_debug_general = 0;
@@ -320,6 +321,7 @@ mate_tree(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
 static void
 initialize_mate(void)
 {
+	mc->forget_after = (float) pref_mate_forget_after;
 	initialize_mate_runtime(mc);
 #ifdef _AVP_DEBUGGING
 	setup_avp_debug(mc->dbg_facility,
@@ -406,6 +408,14 @@ proto_register_mate(void)
 					   "Configuration Filename",
 					   "The name of the file containing the mate module's configuration",
 					   &pref_mate_config_filename, FALSE);
+	prefs_register_uint_preference(mate_module, "forget_after",
+					    "Forget groups idle for (seconds)",
+					    "When analyzing in a single pass, free the Gops and Gogs"
+					    " that got no Pdus for this many seconds, and their Pdus;"
+					    " frames dissected again afterwards lose their MATE tree."
+					    " 0 keeps them all",
+					    10,
+					   &pref_mate_forget_after);
 #ifdef _AVP_DEBUGGING
 	prefs_register_uint_preference(mate_module, "avp_debug_general",
 					    "AVP Debug general",
@@ -122,6 +122,12 @@ static wmem_map_t *output_rrpd;
  */
 static wmem_list_t *temp_rsp_rrpd_list = NULL;  /* Reuse these for speed and efficient memory use - issue a warning if we run out */
 
+/*
+    In streaming mode the RTE data is output in the first scan, on the packet at which an RRPD is found to be complete,
+    and the RRPD is then removed from the rrpd_list.  completed_rrpd_list holds the RRPDs completed by the current packet.
+ */
+static wmem_list_t *completed_rrpd_list = NULL;
+
 /* Optimisation data - the following is used for various optimisation measures */
 static int highest_tcp_stream_no;
 static int highest_udp_stream_no;
@@ -201,6 +207,9 @@ static void register_dcerpc_stream(guint32 stream_no)
 /* This function should be called before any change to RTE data. */
 static void null_output_rrpd_entries(RRPD *in_rrpd)
 {
+    if (preferences.streaming)
+        return;
+
     wmem_map_remove(output_rrpd, GUINT_TO_POINTER(in_rrpd->req_first_frame));
     wmem_map_remove(output_rrpd, GUINT_TO_POINTER(in_rrpd->req_last_frame));
     wmem_map_remove(output_rrpd, GUINT_TO_POINTER(in_rrpd->rsp_first_frame));
@@ -210,6 +219,9 @@ static void null_output_rrpd_entries(RRPD *in_rrpd)
 /* This function should be called after any change to RTE data. */
 static void update_output_rrpd(RRPD *in_rrpd)
 {
+    if (preferences.streaming)
+        return;
+
     if (preferences.rte_on_first_req)
         wmem_map_insert(output_rrpd, GUINT_TO_POINTER(in_rrpd->req_first_frame), in_rrpd);
 
@@ -235,6 +247,93 @@ static RRPD* append_to_rrpd_list(RRPD *in_rrpd)
     return next_rrpd;
 }
 
+/*
+    This function moves an RRPD from the rrpd_list to the completed_rrpd_list (streaming mode only).
+ */
+static void complete_rrpd(wmem_list_frame_t *frame)
+{
+    wmem_list_append(completed_rrpd_list, wmem_list_frame_data(frame));
+    wmem_list_remove_frame(rrpd_list, frame);
+}
+
+/*
+    In streaming mode, a new request on a GTCP or GUDP stream completes the previous RR Pair of the stream, and any
+    request completes the SYN RR Pair of its stream.  The decode_based RR Pairs can be interleaved and so, except for
+    DNS which is complete when its response is seen, they are completed when they have been idle for streaming_timeout
+    seconds.
+ */
+static void complete_superseded_rrpd(RRPD *in_rrpd)
+{
+    RRPD *rrpd;
+    wmem_list_frame_t* i;
+
+    for (i = wmem_list_tail(rrpd_list); i != NULL; i = wmem_list_frame_prev(i))
+    {
+        rrpd = (RRPD*)wmem_list_frame_data(i);
+
+        if (rrpd->ip_proto == in_rrpd->ip_proto && rrpd->stream_no == in_rrpd->stream_no)
+        {
+            if (rrpd->rsp_first_frame &&
+                (rrpd->calculation == RTE_CALC_SYN ||
+                 (rrpd->calculation == in_rrpd->calculation &&
+                  (rrpd->calculation == RTE_CALC_GTCP || rrpd->calculation == RTE_CALC_GUDP))))
+                complete_rrpd(i);
+
+            return;
+        }
+    }
+}
+
+static void complete_rrpd_dns(RRPD *match)
+{
+    wmem_list_frame_t* i;
+
+    for (i = wmem_list_tail(rrpd_list); i != NULL; i = wmem_list_frame_prev(i))
+    {
+        if (wmem_list_frame_data(i) == match)
+        {
+            complete_rrpd(i);
+            return;
+        }
+    }
+}
+
+static const nstime_t *rrpd_last_rtime(const RRPD *rrpd)
+{
+    return rrpd->rsp_first_frame ? &rrpd->rsp_last_rtime : &rrpd->req_last_rtime;
+}
+
+/*
+    This function completes the RRPDs, and drops the entries of the temp_rsp_rrpd_list, that have been idle for
+    streaming_timeout seconds.  The lists are in the order the entries were added, so only the oldest entries are
+    checked.
+ */
+static void expire_idle_rrpds(const nstime_t *now)
+{
+    wmem_list_frame_t* i;
+    RRPD *rrpd;
+    nstime_t idle;
+
+    while ((i = wmem_list_head(rrpd_list)) != NULL)
+    {
+        rrpd = (RRPD*)wmem_list_frame_data(i);
+        nstime_delta(&idle, now, rrpd_last_rtime(rrpd));
+        if (idle.secs < (time_t)preferences.streaming_timeout)
+            break;
+        complete_rrpd(i);
+    }
+
+    while ((i = wmem_list_head(temp_rsp_rrpd_list)) != NULL)
+    {
+        rrpd = (RRPD*)wmem_list_frame_data(i);
+        nstime_delta(&idle, now, &rrpd->rsp_last_rtime);
+        if (idle.secs < (time_t)preferences.streaming_timeout)
+            break;
+        wmem_list_remove_frame(temp_rsp_rrpd_list, i);
+        wmem_free(wmem_file_scope(), rrpd);
+    }
+}
+
 static RRPD *find_latest_rrpd_dcerpc(RRPD *in_rrpd)
 {
     RRPD *rrpd;
@@ -584,6 +683,9 @@ static void update_rrpd_list_entry(RRPD *match, RRPD *in_rrpd)
     }
 
     update_output_rrpd(match);
+
+    if (preferences.streaming && !in_rrpd->c2s && match->calculation == RTE_CALC_DNS)
+        complete_rrpd_dns(match);
 }
 
 /*
@@ -598,7 +700,12 @@ static void update_rrpd_list_entry_req(RRPD *in_rrpd)
     if (match != NULL)
         update_rrpd_list_entry(match, in_rrpd);
     else
+    {
+        if (preferences.streaming)
+            complete_superseded_rrpd(in_rrpd);
+
         append_to_rrpd_list(in_rrpd);
+    }
 }
 
 /*
@@ -641,6 +748,7 @@ static void migrate_temp_rsp_rrpd(RRPD *main_list, RRPD *temp_list)
     update_rrpd_list_entry(main_list, temp_list);
 
     wmem_list_remove(temp_rsp_rrpd_list, temp_list);
+    wmem_free(wmem_file_scope(), temp_list);
 }
 
 static void update_rrpd_list_entry_rsp(RRPD *in_rrpd)
@@ -1104,6 +1212,12 @@ static int dissect_transum(tvbuff_t *buffer, packet_info *pinfo, proto_tree *tre
     {
         PKT_INFO *sub_packet = wmem_alloc0_array(wmem_packet_scope(), PKT_INFO, MAX_SUBPKTS_PER_PACKET);
 
+        if (preferences.streaming)
+        {
+            completed_rrpd_list = wmem_list_new(wmem_packet_scope());
+            expire_idle_rrpds(&pinfo->rel_ts);
+        }
+
         set_proto_values(pinfo, tree, &sub_packet[0], sub_packet);
 
         if (sub_packet[0].pkt_of_interest)
@@ -1117,6 +1231,22 @@ static int dissect_transum(tvbuff_t *buffer, packet_info *pinfo, proto_tree *tre
                 update_rrpd_rte_data(&(sub_packet[i].rrpd));
             }
         }
+
+        if (preferences.streaming)
+        {
+            wmem_list_frame_t *i;
+            RRPD *rrpd;
+
+            /* Output the RTE data of the RR Pairs completed by this packet, then forget them */
+            for (i = wmem_list_head(completed_rrpd_list); i; i = wmem_list_frame_next(i))
+            {
+                rrpd = (RRPD*)wmem_list_frame_data(i);
+                if (tree)
+                    write_rte(rrpd, buffer, tree, NULL);
+                wmem_free(wmem_file_scope(), rrpd);
+            }
+            completed_rrpd_list = NULL;
+        }
     }
 
     return 0;
@@ -1248,6 +1378,9 @@ proto_register_transum(void)
 
     preferences.debug_enabled = FALSE;
 
+    preferences.streaming = FALSE;
+    preferences.streaming_timeout = 10;
+
     /* no start registering stuff */
     proto_register_field_array(proto_transum, hf, array_length(hf));
     proto_register_subtree_array(ett, array_length(ett));
@@ -1325,6 +1458,21 @@ proto_register_transum(void)
         "RTE data will be added to the last response packet",
         &preferences.rte_on_last_rsp);
 
+    prefs_register_bool_preference(transum_module,
+        "streaming",
+        "Output RTE data in a single scan",
+        "Add the RTE data of each APDU Request-Response pair to the packet at which the pair is found to be complete,"
+        " as packets are first dissected, and then forget the pair.  For live captures and single-pass TShark runs;"
+        " the RTE data isn't shown when packets are dissected again",
+        &preferences.streaming);
+
+    prefs_register_uint_preference(transum_module,
+        "streaming_timeout",
+        "Seconds after which an idle pair is complete",
+        "In streaming mode, the Request-Response pairs that have had no packets for this many seconds are output and forgotten",
+        10,
+        &preferences.streaming_timeout);
+
     prefs_register_bool_preference(transum_module,
         "debug_enabled",
         "Enable debug info",
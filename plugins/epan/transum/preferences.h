@@ -39,4 +39,6 @@ typedef struct _TSUM_PREFERENCES
     gboolean summarise_tds;
     gboolean summarisers_escape_quotes;
     gboolean debug_enabled;
+    gboolean streaming;
+    guint    streaming_timeout;
 } TSUM_PREFERENCES;
@@ -43,11 +43,18 @@
 #endif
 
 #include "randpkt_core/randpkt_core.h"
+#include "randpkt_core/randpkt_flows.h"
 
 #define INVALID_OPTION 1
 #define INVALID_TYPE 2
 #define CLOSE_ERROR 2
 
+#define LONGOPT_FLOWS                LONGOPT_BASE_APPLICATION+1
+#define LONGOPT_FLOW_TYPES           LONGOPT_BASE_APPLICATION+2
+#define LONGOPT_CONCURRENT           LONGOPT_BASE_APPLICATION+3
+#define LONGOPT_LOSS                 LONGOPT_BASE_APPLICATION+4
+#define LONGOPT_SEED                 LONGOPT_BASE_APPLICATION+5
+
 /*
  * Report an error in command-line arguments.
  */
@@ -86,6 +93,8 @@ usage(gboolean is_error)
 	}
 
 	fprintf(output, "Usage: randpkt [-b maxbytes] [-c count] [-t type] [-r] filename\n");
+	fprintf(output, "       randpkt --flows count [--flow-types types] [--concurrent count]\n");
+	fprintf(output, "               [--loss percent] [--seed seed] filename\n");
 	fprintf(output, "Default max bytes (per packet) is 5000\n");
 	fprintf(output, "Default count is 1000.\n");
 	fprintf(output, "-r: random packet type selection\n");
@@ -103,6 +112,23 @@ usage(gboolean is_error)
 	g_strfreev(longname_list);
 
 	fprintf(output, "\nIf type is not specified, a random packet will be chosen\n\n");
+
+	fprintf(output, "--flows: write a pcapng file of count well-formed flows instead\n");
+	fprintf(output, "--flow-types: comma-separated flow types to generate (def: all)\n");
+	fprintf(output, "--concurrent: number of flows in progress at a time (def: 100)\n");
+	fprintf(output, "--loss: chance of a TCP segment or DNS query being lost (def: 1)\n");
+	fprintf(output, "--seed: seed of the random number generator (def: 1)\n");
+	fprintf(output, "\n");
+	fprintf(output, "Flow types:\n");
+
+	randpkt_flow_type_list(&abbrev_list, &longname_list);
+	for (i = 0; abbrev_list[i] && longname_list[i]; i++) {
+		fprintf(output, "\t%-16s%s\n", abbrev_list[i], longname_list[i]);
+	}
+
+	g_strfreev(abbrev_list);
+	g_strfreev(longname_list);
+	fprintf(output, "\n");
 }
 
 int
@@ -130,9 +156,23 @@ main(int argc, char *argv[])
 	guint8* type = NULL;
 	int allrandom = FALSE;
 	wtap_dumper *savedump;
+	randpkt_flow_params flow_params = {
+		.flow_count = 0,
+		.concurrency = 100,
+		.types = (1U << RANDPKT_FLOW_NUM_TYPES) - 1,
+		.loss_permille = 10,
+		.seed = 1,
+	};
+	double loss;
+	char *end;
 	int ret = EXIT_SUCCESS;
 	static const struct option long_options[] = {
 		{"help", no_argument, NULL, 'h'},
+		{"flows", required_argument, NULL, LONGOPT_FLOWS},
+		{"flow-types", required_argument, NULL, LONGOPT_FLOW_TYPES},
+		{"concurrent", required_argument, NULL, LONGOPT_CONCURRENT},
+		{"loss", required_argument, NULL, LONGOPT_LOSS},
+		{"seed", required_argument, NULL, LONGOPT_SEED},
 		{0, 0, 0, 0 }
 	};
 
@@ -191,6 +231,35 @@ main(int argc, char *argv[])
 				allrandom = TRUE;
 				break;
 
+			case LONGOPT_FLOWS:
+				flow_params.flow_count = get_positive_int(optarg, "number of flows");
+				break;
+
+			case LONGOPT_FLOW_TYPES:
+				if (!randpkt_flow_parse_types(optarg, &flow_params.types)) {
+					ret = INVALID_TYPE;
+					goto clean_exit;
+				}
+				break;
+
+			case LONGOPT_CONCURRENT:
+				flow_params.concurrency = get_positive_int(optarg, "number of concurrent flows");
+				break;
+
+			case LONGOPT_LOSS:
+				loss = g_ascii_strtod(optarg, &end);
+				if (end == optarg || *end != '\0' || loss < 0 || loss > 100) {
+					cmdarg_err("The loss rate \"%s\" isn't a percentage.", optarg);
+					ret = INVALID_OPTION;
+					goto clean_exit;
+				}
+				flow_params.loss_permille = (guint)(loss * 10 + 0.5);
+				break;
+
+			case LONGOPT_SEED:
+				flow_params.seed = get_guint32(optarg, "seed");
+				break;
+
 			default:
 				usage(TRUE);
 				ret = INVALID_OPTION;
@@ -208,6 +277,17 @@ main(int argc, char *argv[])
 		goto clean_exit;
 	}
 
+	if (flow_params.flow_count > 0) {
+		if (type || allrandom) {
+			cmdarg_err("-t and -r can't be used with --flows.");
+			g_free(type);
+			ret = INVALID_OPTION;
+			goto clean_exit;
+		}
+		ret = randpkt_flows_write(produce_filename, &flow_params);
+		goto clean_exit;
+	}
+
 	if (!allrandom) {
 		produce_type = randpkt_parse_type(type);
 		g_free(type);
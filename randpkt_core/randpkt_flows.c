@@ -0,0 +1,1166 @@
+/*
+ * randpkt_flows.c
+ * ---------
+ * Creates capture files of synthetic flows of several protocols, such as
+ * TCP connections with losses and retransmissions, DNS lookups or SIP
+ * calls with their RTP streams, for benchmarking dissection at scale.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include "randpkt_flows.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wsutil/pint.h>
+#include <wiretap/wtap.h>
+
+#include "ui/failure_message.h"
+
+#define WRITE_ERROR 2
+
+/*
+ * All the flows go through a capture point next to the clients, which
+ * are on 10.0.0.0/8, behind a router from the servers, on 172.16.0.0/12.
+ * The capture starts at a fixed time, so that the same parameters always
+ * give the same file.
+ */
+#define START_SECS		1600000000
+#define NS_PER_US		G_GUINT64_CONSTANT(1000)
+#define NS_PER_MS		G_GUINT64_CONSTANT(1000000)
+#define NS_PER_SEC		G_GUINT64_CONSTANT(1000000000)
+
+#define CLIENT			0
+#define SERVER			1
+
+#define CLIENT_NET		0x0a000000	/* 10.0.0.0 */
+#define SERVER_NET		0xac100000	/* 172.16.0.0 */
+#define CLIENT_FLOWS_PER_HOST	16
+
+static const guint8 router_mac[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+
+/* Time for a client to react to a packet, as seen at the capture point */
+#define REPLY_DELAY		(30 * NS_PER_US)
+
+#define WRITE_BUF_SIZE		(1024 * 1024)
+
+#define ETHERTYPE_IPv4		0x0800
+#define IP_PROTO_TCP		6
+#define IP_PROTO_UDP		17
+
+#define TH_FIN			0x01
+#define TH_SYN			0x02
+#define TH_PSH			0x08
+#define TH_ACK			0x10
+
+#define TCP_MSS			1460
+#define TCP_WINDOW		64240
+#define TCP_RTO_MIN		(200 * NS_PER_MS)
+#define TCP_NS_PER_BYTE		8		/* 1 Gb/s */
+
+#define PORT_DISCARD		9
+#define PORT_DNS		53
+#define PORT_HTTP		80
+#define PORT_QUIC		443
+#define PORT_SIP		5060
+
+#define DNS_TIMEOUT		NS_PER_SEC
+#define DNS_MAX_RETRIES		2
+
+#define H2_DATA			0x0
+#define H2_HEADERS		0x1
+#define H2_SETTINGS		0x4
+#define H2_GOAWAY		0x7
+#define H2_WINDOW_UPDATE	0x8
+#define H2_END_STREAM		0x01
+#define H2_ACK			0x01
+#define H2_END_HEADERS		0x04
+#define H2_MAX_FRAME_SIZE	16384
+
+#define QUIC_VERSION		0xff00001d	/* draft-29 */
+#define QUIC_INITIAL		0x0
+#define QUIC_HANDSHAKE		0x2
+#define QUIC_CID_LEN		8
+#define QUIC_LONG_HDR_LEN	(1 + 4 + 1 + QUIC_CID_LEN + 1 + QUIC_CID_LEN + 2 + 4)
+#define QUIC_SHORT_HDR_LEN	(1 + QUIC_CID_LEN + 4)
+#define QUIC_MIN_INITIAL_LEN	1200
+#define QUIC_MAX_PAYLOAD	1252
+
+#define RTP_PAYLOAD_LEN		160		/* 20 ms of PCMU */
+#define RTP_INTERVAL		(20 * NS_PER_MS)
+
+typedef struct {
+	guint64  ts;		/* nanoseconds since START_SECS */
+	guint    order;		/* in which the packets of a flow were added */
+	guint    len;
+	guint8  *data;
+} flow_pkt;
+
+typedef struct {
+	GRand   *rand;
+	guint    loss_permille;
+	GArray  *pkts;		/* flow_pkt, sorted by time once generated */
+	guint    next_pkt;	/* the next one to write */
+	guint64  ts;		/* time, as seen at the capture point, of the next exchange */
+	guint64  rtt;		/* round trip time from the capture point to the server */
+	guint8   mac[2][6];	/* a client's, and the router's for a server */
+	guint32  ip[2];		/* host byte order */
+	guint16  port[2];
+	guint16  ip_id[2];
+	guint32  snd_nxt[2];	/* TCP: the next sequence number to send */
+	guint32  rcv_nxt[2];	/* TCP: the next sequence number expected */
+} flow_t;
+
+typedef void (*flow_generator)(flow_t *flow);
+
+/* Uniformly distributed in [min, max] */
+static guint
+rand_range(flow_t *flow, guint min, guint max)
+{
+	return (guint)g_rand_int_range(flow->rand, (gint32)min, (gint32)max + 1);
+}
+
+static gboolean
+lost(flow_t *flow)
+{
+	return flow->loss_permille != 0 && rand_range(flow, 0, 999) < flow->loss_permille;
+}
+
+static void
+flow_wait(flow_t *flow, guint min_us, guint max_us)
+{
+	flow->ts += rand_range(flow, min_us, max_us) * NS_PER_US;
+}
+
+static void
+rand_bytes(flow_t *flow, guint8 *buf, guint len)
+{
+	guint32 r = 0;
+	guint i;
+
+	for (i = 0; i < len; i++) {
+		if ((i & 3) == 0)
+			r = g_rand_int(flow->rand);
+		buf[i] = (guint8)r;
+		r >>= 8;
+	}
+}
+
+static void
+append_rand_bytes(flow_t *flow, GByteArray *out, guint len)
+{
+	guint old_len = out->len;
+
+	g_byte_array_set_size(out, old_len + len);
+	rand_bytes(flow, out->data + old_len, len);
+}
+
+static guint32
+cksum_add(guint32 sum, const guint8 *p, guint len)
+{
+	for (; len > 1; p += 2, len -= 2)
+		sum += pntoh16(p);
+	if (len)
+		sum += p[0] << 8;
+	return sum;
+}
+
+static guint16
+cksum_finish(guint32 sum)
+{
+	while (sum >> 16)
+		sum = (sum & 0xffff) + (sum >> 16);
+	return (guint16)~sum;
+}
+
+/* Add an IPv4 packet, with its TCP or UDP header and payload */
+static void
+add_ip_packet(flow_t *flow, guint64 ts, int from, guint8 ip_proto,
+    const guint8 *l4_hdr, guint l4_hdr_len, const guint8 *payload, guint payload_len)
+{
+	int to = !from;
+	guint ip_len = 20 + l4_hdr_len + payload_len;
+	guint8 *ip, *l4;
+	guint16 cksum;
+	guint32 sum;
+	flow_pkt pkt;
+
+	pkt.ts = ts;
+	pkt.order = flow->pkts->len;
+	pkt.len = MAX(14 + ip_len, 60);
+	pkt.data = (guint8 *)g_malloc0(pkt.len);
+
+	memcpy(pkt.data, flow->mac[to], 6);
+	memcpy(pkt.data + 6, flow->mac[from], 6);
+	phton16(pkt.data + 12, ETHERTYPE_IPv4);
+
+	ip = pkt.data + 14;
+	ip[0] = 0x45;
+	phton16(ip + 2, ip_len);
+	phton16(ip + 4, flow->ip_id[from]++);
+	phton16(ip + 6, 0x4000);	/* Don't Fragment */
+	ip[8] = from == CLIENT ? 64 : 52;
+	ip[9] = ip_proto;
+	phton32(ip + 12, flow->ip[from]);
+	phton32(ip + 16, flow->ip[to]);
+	phton16(ip + 10, cksum_finish(cksum_add(0, ip, 20)));
+
+	/* The checksum field of the header is 0 until it's computed, over
+	 * a pseudo-header with the addresses, the protocol and the length */
+	l4 = ip + 20;
+	memcpy(l4, l4_hdr, l4_hdr_len);
+	if (payload_len)
+		memcpy(l4 + l4_hdr_len, payload, payload_len);
+	sum = cksum_add(ip_proto + l4_hdr_len + payload_len, ip + 12, 8);
+	cksum = cksum_finish(cksum_add(sum, l4, l4_hdr_len + payload_len));
+	if (ip_proto == IP_PROTO_UDP)
+		phton16(l4 + 6, cksum != 0 ? cksum : 0xffff);
+	else
+		phton16(l4 + 16, cksum);
+
+	g_array_append_val(flow->pkts, pkt);
+}
+
+static void
+add_udp_datagram(flow_t *flow, guint64 ts, int from, guint16 src_port,
+    guint16 dst_port, const guint8 *payload, guint len)
+{
+	guint8 hdr[8];
+
+	phton16(hdr, src_port);
+	phton16(hdr + 2, dst_port);
+	phton16(hdr + 4, 8 + len);
+	phton16(hdr + 6, 0);
+	add_ip_packet(flow, ts, from, IP_PROTO_UDP, hdr, 8, payload, len);
+}
+
+static void
+udp_send(flow_t *flow, int from, const guint8 *payload, guint len)
+{
+	add_udp_datagram(flow, flow->ts, from, flow->port[from], flow->port[!from],
+	    payload, len);
+}
+
+/*
+ * TCP.
+ */
+static void
+add_tcp_segment(flow_t *flow, guint64 ts, int from, guint32 seq, guint8 flags,
+    const guint8 *payload, guint len)
+{
+	guint hdr_len = (flags & TH_SYN) ? 24 : 20;
+	guint8 hdr[24];
+
+	memset(hdr, 0, sizeof hdr);
+	phton16(hdr, flow->port[from]);
+	phton16(hdr + 2, flow->port[!from]);
+	phton32(hdr + 4, seq);
+	if (flags & TH_ACK)
+		phton32(hdr + 8, flow->rcv_nxt[from]);
+	hdr[12] = (guint8)((hdr_len / 4) << 4);
+	hdr[13] = flags;
+	phton16(hdr + 14, TCP_WINDOW);
+	if (flags & TH_SYN) {
+		/* Maximum segment size */
+		hdr[20] = 2;
+		hdr[21] = 4;
+		phton16(hdr + 22, TCP_MSS);
+	}
+	add_ip_packet(flow, ts, from, IP_PROTO_TCP, hdr, hdr_len, payload, len);
+}
+
+static void
+add_tcp_ack(flow_t *flow, guint64 ts, int from)
+{
+	add_tcp_segment(flow, ts, from, flow->snd_nxt[from], TH_ACK, NULL, 0);
+}
+
+/* How long after a packet from one side the other's reaction to it is seen */
+static guint64
+reaction_delay(flow_t *flow, int from)
+{
+	return from == CLIENT ? flow->rtt : REPLY_DELAY;
+}
+
+static void
+tcp_connect(flow_t *flow)
+{
+	flow->snd_nxt[CLIENT] = g_rand_int(flow->rand);
+	flow->snd_nxt[SERVER] = g_rand_int(flow->rand);
+
+	add_tcp_segment(flow, flow->ts, CLIENT, flow->snd_nxt[CLIENT]++, TH_SYN, NULL, 0);
+	flow->rcv_nxt[SERVER] = flow->snd_nxt[CLIENT];
+	flow->ts += flow->rtt;
+	add_tcp_segment(flow, flow->ts, SERVER, flow->snd_nxt[SERVER]++, TH_SYN|TH_ACK, NULL, 0);
+	flow->rcv_nxt[CLIENT] = flow->snd_nxt[SERVER];
+	flow->ts += REPLY_DELAY;
+	add_tcp_ack(flow, flow->ts, CLIENT);
+}
+
+/*
+ * Send data from one side to the other in back-to-back segments, every
+ * other one of which is acknowledged.  One of them may be lost: if it's
+ * from the client, it's seen before it's lost, and if it's from the
+ * server, it isn't seen at all.  Either way, each segment after it gets
+ * a duplicate ACK, and it's retransmitted after the third one or, if
+ * there aren't three, after a timeout.
+ */
+static void
+tcp_send(flow_t *flow, int from, const guint8 *data, guint len)
+{
+	int to = !from;
+	guint64 delay = reaction_delay(flow, from);
+	guint64 ts = flow->ts;
+	guint64 done = ts;
+	guint64 lost_ts = 0, dup_ack_ts = 0;
+	gboolean hole = FALSE;
+	guint32 lost_seq = 0;
+	guint lost_off = 0, lost_len = 0;
+	guint dup_acks = 0, unacked = 0;
+	guint off, seg_len;
+
+	for (off = 0; off < len; off += seg_len) {
+		guint32 seq = flow->snd_nxt[from];
+		guint8 flags = TH_ACK;
+
+		seg_len = MIN(len - off, TCP_MSS);
+		if (off + seg_len == len)
+			flags |= TH_PSH;
+		flow->snd_nxt[from] += seg_len;
+
+		if (!hole && lost(flow)) {
+			hole = TRUE;
+			lost_seq = seq;
+			lost_off = off;
+			lost_len = seg_len;
+			lost_ts = ts;
+			if (from == CLIENT)
+				add_tcp_segment(flow, ts, from, seq, flags, data + off, seg_len);
+		} else {
+			add_tcp_segment(flow, ts, from, seq, flags, data + off, seg_len);
+			if (hole) {
+				add_tcp_ack(flow, ts + delay, to);
+				if (++dup_acks == 3)
+					dup_ack_ts = ts + delay;
+			} else {
+				flow->rcv_nxt[to] = flow->snd_nxt[from];
+				if (++unacked == 2 || (flags & TH_PSH)) {
+					add_tcp_ack(flow, ts + delay, to);
+					unacked = 0;
+				}
+			}
+		}
+		done = ts + delay;
+		ts += seg_len * TCP_NS_PER_BYTE;
+	}
+
+	if (hole) {
+		guint8 flags = TH_ACK | (lost_off + lost_len == len ? TH_PSH : 0);
+		guint64 rtx_ts;
+
+		if (dup_acks >= 3)
+			rtx_ts = dup_ack_ts + reaction_delay(flow, to);
+		else
+			rtx_ts = lost_ts + MAX(TCP_RTO_MIN, 2 * flow->rtt);
+		add_tcp_segment(flow, rtx_ts, from, lost_seq, flags, data + lost_off, lost_len);
+		flow->rcv_nxt[to] = flow->snd_nxt[from];
+		add_tcp_ack(flow, rtx_ts + delay, to);
+		done = MAX(done, rtx_ts + delay);
+	}
+	flow->ts = done;
+}
+
+static void
+tcp_close(flow_t *flow)
+{
+	add_tcp_segment(flow, flow->ts, CLIENT, flow->snd_nxt[CLIENT]++, TH_FIN|TH_ACK, NULL, 0);
+	flow->rcv_nxt[SERVER] = flow->snd_nxt[CLIENT];
+	flow->ts += flow->rtt;
+	add_tcp_segment(flow, flow->ts, SERVER, flow->snd_nxt[SERVER]++, TH_FIN|TH_ACK, NULL, 0);
+	flow->rcv_nxt[CLIENT] = flow->snd_nxt[SERVER];
+	flow->ts += REPLY_DELAY;
+	add_tcp_ack(flow, flow->ts, CLIENT);
+}
+
+/* A few requests and responses of random data, the responses being
+ * anything from a hundred bytes to hundreds of kilobytes */
+static void
+gen_tcp(flow_t *flow)
+{
+	guint exchanges = rand_range(flow, 1, 4);
+	guint8 *buf = (guint8 *)g_malloc(1000 << 8);
+	guint i, len;
+
+	flow->port[SERVER] = PORT_DISCARD;
+	tcp_connect(flow);
+	for (i = 0; i < exchanges; i++) {
+		flow_wait(flow, 100, 5000);
+		len = rand_range(flow, 50, 1000);
+		rand_bytes(flow, buf, len);
+		tcp_send(flow, CLIENT, buf, len);
+
+		flow_wait(flow, 50, 2000);
+		len = rand_range(flow, 100, 1000) << rand_range(flow, 0, 8);
+		rand_bytes(flow, buf, len);
+		tcp_send(flow, SERVER, buf, len);
+	}
+	flow_wait(flow, 100, 5000);
+	tcp_close(flow);
+	g_free(buf);
+}
+
+/*
+ * HTTP/2, in clear text with prior knowledge.
+ */
+static void
+h2_frame(GByteArray *out, guint8 type, guint8 flags, guint32 stream_id,
+    const guint8 *payload, guint len)
+{
+	guint8 hdr[9];
+
+	hdr[0] = (guint8)(len >> 16);
+	hdr[1] = (guint8)(len >> 8);
+	hdr[2] = (guint8)len;
+	hdr[3] = type;
+	hdr[4] = flags;
+	phton32(hdr + 5, stream_id);
+	g_byte_array_append(out, hdr, 9);
+	if (len)
+		g_byte_array_append(out, payload, len);
+}
+
+static void
+h2_setting(GByteArray *out, guint16 id, guint32 value)
+{
+	guint8 setting[6];
+
+	phton16(setting, id);
+	phton32(setting + 2, value);
+	g_byte_array_append(out, setting, 6);
+}
+
+/* A literal header field that isn't indexed, with the name from the
+ * static table; the value has to be shorter than 127 bytes */
+static void
+hpack_literal(GByteArray *out, guint8 name_index, const char *value)
+{
+	guint8 b;
+
+	if (name_index < 15) {
+		b = name_index;
+		g_byte_array_append(out, &b, 1);
+	} else {
+		b = 15;
+		g_byte_array_append(out, &b, 1);
+		b = name_index - 15;
+		g_byte_array_append(out, &b, 1);
+	}
+	b = (guint8)strlen(value);
+	g_byte_array_append(out, &b, 1);
+	g_byte_array_append(out, (const guint8 *)value, b);
+}
+
+static void
+gen_http2(flow_t *flow)
+{
+	GByteArray *out = g_byte_array_new();
+	GByteArray *block = g_byte_array_new();
+	guint requests = rand_range(flow, 1, 8);
+	guint host = rand_range(flow, 0, 999);
+	guint8 goaway[8];
+	guint i;
+
+	flow->port[SERVER] = PORT_HTTP;
+	tcp_connect(flow);
+
+	g_byte_array_append(out, (const guint8 *)"PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n", 24);
+	h2_setting(block, 0x3, 100);		/* SETTINGS_MAX_CONCURRENT_STREAMS */
+	h2_setting(block, 0x4, 6291456);	/* SETTINGS_INITIAL_WINDOW_SIZE */
+	h2_frame(out, H2_SETTINGS, 0, 0, block->data, block->len);
+	tcp_send(flow, CLIENT, out->data, out->len);
+
+	g_byte_array_set_size(out, 0);
+	g_byte_array_set_size(block, 0);
+	h2_setting(block, 0x3, 128);
+	h2_frame(out, H2_SETTINGS, 0, 0, block->data, block->len);
+	h2_frame(out, H2_SETTINGS, H2_ACK, 0, NULL, 0);
+	tcp_send(flow, SERVER, out->data, out->len);
+
+	for (i = 0; i < requests; i++) {
+		guint32 stream_id = 2 * i + 1;
+		guint body_len = rand_range(flow, 100, 1000) << rand_range(flow, 0, 7);
+		guint off, frame_len;
+		gchar *value;
+
+		flow_wait(flow, 100, 20000);
+		g_byte_array_set_size(out, 0);
+		if (i == 0)
+			h2_frame(out, H2_SETTINGS, H2_ACK, 0, NULL, 0);
+		g_byte_array_set_size(block, 0);
+		g_byte_array_append(block, (const guint8 *)"\x82\x86", 2);	/* GET, http */
+		value = g_strdup_printf("/objects/%u", rand_range(flow, 0, 99999));
+		hpack_literal(block, 4, value);					/* :path */
+		g_free(value);
+		value = g_strdup_printf("www%u.example.com", host);
+		hpack_literal(block, 1, value);					/* :authority */
+		g_free(value);
+		hpack_literal(block, 58, "randpkt");				/* user-agent */
+		h2_frame(out, H2_HEADERS, H2_END_STREAM|H2_END_HEADERS, stream_id,
+		    block->data, block->len);
+		tcp_send(flow, CLIENT, out->data, out->len);
+
+		flow_wait(flow, 50, 5000);
+		g_byte_array_set_size(out, 0);
+		g_byte_array_set_size(block, 0);
+		g_byte_array_append(block, (const guint8 *)"\x88", 1);		/* 200 */
+		hpack_literal(block, 31, "application/octet-stream");		/* content-type */
+		value = g_strdup_printf("%u", body_len);
+		hpack_literal(block, 28, value);				/* content-length */
+		g_free(value);
+		h2_frame(out, H2_HEADERS, H2_END_HEADERS, stream_id, block->data, block->len);
+		for (off = 0; off < body_len; off += frame_len) {
+			frame_len = MIN(body_len - off, H2_MAX_FRAME_SIZE);
+			g_byte_array_set_size(block, 0);
+			append_rand_bytes(flow, block, frame_len);
+			h2_frame(out, H2_DATA, off + frame_len == body_len ? H2_END_STREAM : 0,
+			    stream_id, block->data, block->len);
+		}
+		tcp_send(flow, SERVER, out->data, out->len);
+	}
+
+	flow_wait(flow, 100, 5000);
+	g_byte_array_set_size(out, 0);
+	phton32(goaway, 2 * requests - 1);	/* the last stream */
+	phton32(goaway + 4, 0);			/* NO_ERROR */
+	h2_frame(out, H2_GOAWAY, 0, 0, goaway, sizeof goaway);
+	tcp_send(flow, CLIENT, out->data, out->len);
+	tcp_close(flow);
+
+	g_byte_array_free(out, TRUE);
+	g_byte_array_free(block, TRUE);
+}
+
+/*
+ * DNS.
+ */
+static void
+dns_name(GByteArray *out, const char *name)
+{
+	const char *label = name, *dot;
+	guint8 len;
+
+	do {
+		dot = strchr(label, '.');
+		len = (guint8)(dot ? (size_t)(dot - label) : strlen(label));
+		g_byte_array_append(out, &len, 1);
+		g_byte_array_append(out, (const guint8 *)label, len);
+		if (dot != NULL)
+			label = dot + 1;
+	} while (dot != NULL);
+	len = 0;
+	g_byte_array_append(out, &len, 1);
+}
+
+/* A lookup of an A or AAAA record, retried if the query is lost; a few
+ * of the names don't exist */
+static void
+gen_dns(flow_t *flow)
+{
+	GByteArray *query = g_byte_array_new();
+	GByteArray *response = g_byte_array_new();
+	gboolean aaaa = rand_range(flow, 0, 9) < 3;
+	gboolean nxdomain = rand_range(flow, 0, 99) < 5;
+	guint8 header[12], rr[10];
+	gchar *name;
+	guint tries;
+
+	flow->port[SERVER] = PORT_DNS;
+
+	phton16(header, (guint16)g_rand_int(flow->rand));	/* ID */
+	phton16(header + 2, 0x0100);				/* RD */
+	phton16(header + 4, 1);
+	memset(header + 6, 0, 6);
+	g_byte_array_append(query, header, 12);
+	name = g_strdup_printf("host%u.example.com", rand_range(flow, 0, 99999));
+	dns_name(query, name);
+	g_free(name);
+	phton16(rr, aaaa ? 28 : 1);
+	phton16(rr + 2, 1);					/* IN */
+	g_byte_array_append(query, rr, 4);
+
+	for (tries = 0; tries < DNS_MAX_RETRIES && lost(flow); tries++) {
+		udp_send(flow, CLIENT, query->data, query->len);
+		flow->ts += DNS_TIMEOUT;
+	}
+	udp_send(flow, CLIENT, query->data, query->len);
+	flow->ts += flow->rtt;
+
+	g_byte_array_append(response, query->data, query->len);
+	phton16(response->data + 2, nxdomain ? 0x8183 : 0x8180);
+	if (!nxdomain) {
+		guint rdlength = aaaa ? 16 : 4;
+
+		phton16(response->data + 6, 1);
+		phton16(rr, 0xc00c);				/* the name in the question */
+		phton16(rr + 2, aaaa ? 28 : 1);
+		phton16(rr + 4, 1);
+		g_byte_array_append(response, rr, 6);
+		phton32(rr, rand_range(flow, 60, 86400));	/* TTL */
+		phton16(rr + 4, rdlength);
+		g_byte_array_append(response, rr, 6);
+		append_rand_bytes(flow, response, rdlength);
+	}
+	udp_send(flow, SERVER, response->data, response->len);
+
+	g_byte_array_free(query, TRUE);
+	g_byte_array_free(response, TRUE);
+}
+
+/*
+ * QUIC.  The packets have valid headers, but their payload is random, as
+ * if encrypted with keys that aren't known.
+ */
+static void
+quic_long_packet(flow_t *flow, GByteArray *out, guint8 type, const guint8 *dcid,
+    const guint8 *scid, guint32 pn, guint payload_len)
+{
+	guint8 hdr[QUIC_LONG_HDR_LEN + 1];
+	guint n = 0;
+
+	hdr[n++] = (guint8)(0xc0 | (type << 4) | 0x03);	/* 4-byte packet number */
+	phton32(hdr + n, QUIC_VERSION);
+	n += 4;
+	hdr[n++] = QUIC_CID_LEN;
+	memcpy(hdr + n, dcid, QUIC_CID_LEN);
+	n += QUIC_CID_LEN;
+	hdr[n++] = QUIC_CID_LEN;
+	memcpy(hdr + n, scid, QUIC_CID_LEN);
+	n += QUIC_CID_LEN;
+	if (type == QUIC_INITIAL)
+		hdr[n++] = 0;				/* no token */
+	phton16(hdr + n, 0x4000 | (4 + payload_len));	/* 2-byte length */
+	n += 2;
+	phton32(hdr + n, pn);
+	n += 4;
+	g_byte_array_append(out, hdr, n);
+	append_rand_bytes(flow, out, payload_len);
+}
+
+static void
+quic_short_packet(flow_t *flow, GByteArray *out, const guint8 *dcid, guint32 pn,
+    guint payload_len)
+{
+	guint8 hdr[QUIC_SHORT_HDR_LEN];
+
+	hdr[0] = 0x40 | 0x03;
+	memcpy(hdr + 1, dcid, QUIC_CID_LEN);
+	phton32(hdr + 1 + QUIC_CID_LEN, pn);
+	g_byte_array_append(out, hdr, sizeof hdr);
+	append_rand_bytes(flow, out, payload_len);
+}
+
+static void
+gen_quic(flow_t *flow)
+{
+	GByteArray *out = g_byte_array_new();
+	guint8 odcid[QUIC_CID_LEN], cid[2][QUIC_CID_LEN];
+	guint32 pn[2] = { 0, 0 };
+	guint requests = rand_range(flow, 1, 4);
+	guint i, j;
+
+	flow->port[SERVER] = PORT_QUIC;
+	rand_bytes(flow, odcid, QUIC_CID_LEN);
+	rand_bytes(flow, cid[CLIENT], QUIC_CID_LEN);
+	rand_bytes(flow, cid[SERVER], QUIC_CID_LEN);
+
+	/* The handshake */
+	quic_long_packet(flow, out, QUIC_INITIAL, odcid, cid[CLIENT], pn[CLIENT]++,
+	    QUIC_MIN_INITIAL_LEN - (QUIC_LONG_HDR_LEN + 1));
+	udp_send(flow, CLIENT, out->data, out->len);
+	flow->ts += flow->rtt;
+
+	g_byte_array_set_size(out, 0);
+	quic_long_packet(flow, out, QUIC_INITIAL, cid[CLIENT], cid[SERVER], pn[SERVER]++, 120);
+	quic_long_packet(flow, out, QUIC_HANDSHAKE, cid[CLIENT], cid[SERVER], pn[SERVER]++,
+	    QUIC_MIN_INITIAL_LEN - (out->len + QUIC_LONG_HDR_LEN));
+	udp_send(flow, SERVER, out->data, out->len);
+	flow->ts += 10 * NS_PER_US;
+	g_byte_array_set_size(out, 0);
+	quic_long_packet(flow, out, QUIC_HANDSHAKE, cid[CLIENT], cid[SERVER], pn[SERVER]++,
+	    rand_range(flow, 500, 1100));
+	udp_send(flow, SERVER, out->data, out->len);
+	flow->ts += REPLY_DELAY;
+
+	g_byte_array_set_size(out, 0);
+	quic_long_packet(flow, out, QUIC_INITIAL, cid[SERVER], cid[CLIENT], pn[CLIENT]++, 30);
+	quic_long_packet(flow, out, QUIC_HANDSHAKE, cid[SERVER], cid[CLIENT], pn[CLIENT]++,
+	    QUIC_MIN_INITIAL_LEN - (out->len + QUIC_LONG_HDR_LEN));
+	udp_send(flow, CLIENT, out->data, out->len);
+
+	/* Requests and responses */
+	for (i = 0; i < requests; i++) {
+		guint packets = rand_range(flow, 1, 8) << rand_range(flow, 0, 5);
+
+		flow_wait(flow, 10, 20000);
+		g_byte_array_set_size(out, 0);
+		quic_short_packet(flow, out, cid[SERVER], pn[CLIENT]++, rand_range(flow, 60, 300));
+		udp_send(flow, CLIENT, out->data, out->len);
+		flow->ts += flow->rtt;
+
+		for (j = 0; j < packets; j++) {
+			g_byte_array_set_size(out, 0);
+			quic_short_packet(flow, out, cid[CLIENT], pn[SERVER]++,
+			    j + 1 < packets ? QUIC_MAX_PAYLOAD - QUIC_SHORT_HDR_LEN : rand_range(flow, 40, 1000));
+			udp_send(flow, SERVER, out->data, out->len);
+			if (j % 2 == 1 || j + 1 == packets) {
+				/* An ACK */
+				guint64 ts = flow->ts;
+
+				g_byte_array_set_size(out, 0);
+				quic_short_packet(flow, out, cid[SERVER], pn[CLIENT]++, 25);
+				flow->ts += REPLY_DELAY;
+				udp_send(flow, CLIENT, out->data, out->len);
+				flow->ts = ts;
+			}
+			flow->ts += (QUIC_MAX_PAYLOAD + 28) * TCP_NS_PER_BYTE;
+		}
+		flow->ts += REPLY_DELAY;
+	}
+
+	/* CONNECTION_CLOSE */
+	flow_wait(flow, 100, 5000);
+	g_byte_array_set_size(out, 0);
+	quic_short_packet(flow, out, cid[SERVER], pn[CLIENT]++, 30);
+	udp_send(flow, CLIENT, out->data, out->len);
+
+	g_byte_array_free(out, TRUE);
+}
+
+/*
+ * SIP over UDP, with an RTP stream each way.
+ */
+typedef struct {
+	gchar   addr[2][16];
+	gchar  *call_id;
+	gchar  *from_tag;
+	gchar  *to_tag;		/* NULL until the callee answers */
+	gchar  *branch;
+	guint16 rtp_port[2];
+	guint32 session;
+} sip_call;
+
+static gchar *
+sip_random_token(flow_t *flow)
+{
+	return g_strdup_printf("%08x%08x", g_rand_int(flow->rand), g_rand_int(flow->rand));
+}
+
+static gchar *
+sip_sdp(const sip_call *call, int from)
+{
+	return g_strdup_printf(
+	    "v=0\r\n"
+	    "o=- %u %u IN IP4 %s\r\n"
+	    "s=-\r\n"
+	    "c=IN IP4 %s\r\n"
+	    "t=0 0\r\n"
+	    "m=audio %u RTP/AVP 0\r\n"
+	    "a=rtpmap:0 PCMU/8000\r\n",
+	    call->session + from, call->session + from, call->addr[from],
+	    call->addr[from], call->rtp_port[from]);
+}
+
+/* Send a request, if from is the caller, or a response */
+static void
+sip_send(flow_t *flow, int from, const sip_call *call, const char *start_line,
+    const char *cseq, gboolean with_sdp)
+{
+	GString *msg = g_string_new(start_line);
+	gchar *sdp = with_sdp ? sip_sdp(call, from) : NULL;
+
+	g_string_append_printf(msg, "\r\nVia: SIP/2.0/UDP %s:%u;branch=z9hG4bK%s\r\n",
+	    call->addr[CLIENT], PORT_SIP, call->branch);
+	if (from == CLIENT)
+		g_string_append(msg, "Max-Forwards: 70\r\n");
+	g_string_append_printf(msg, "From: <sip:alice@%s>;tag=%s\r\n",
+	    call->addr[CLIENT], call->from_tag);
+	g_string_append_printf(msg, "To: <sip:bob@%s>%s%s\r\n", call->addr[SERVER],
+	    call->to_tag ? ";tag=" : "", call->to_tag ? call->to_tag : "");
+	g_string_append_printf(msg, "Call-ID: %s@%s\r\n", call->call_id, call->addr[CLIENT]);
+	g_string_append_printf(msg, "CSeq: %s\r\n", cseq);
+	g_string_append_printf(msg, "Contact: <sip:%s@%s:%u>\r\n",
+	    from == CLIENT ? "alice" : "bob", call->addr[from], PORT_SIP);
+	if (sdp)
+		g_string_append(msg, "Content-Type: application/sdp\r\n");
+	g_string_append_printf(msg, "Content-Length: %u\r\n\r\n", sdp ? (guint)strlen(sdp) : 0);
+	if (sdp)
+		g_string_append(msg, sdp);
+
+	udp_send(flow, from, (const guint8 *)msg->str, (guint)msg->len);
+	g_string_free(msg, TRUE);
+	g_free(sdp);
+}
+
+static void
+gen_sip(flow_t *flow)
+{
+	sip_call call;
+	gchar *invite, *bye;
+	guint packets = rand_range(flow, 50, 1500);	/* 1 to 30 seconds */
+	guint64 offset = rand_range(flow, 0, 19999) * NS_PER_US;
+	guint16 rtp_seq[2];
+	guint32 rtp_ts[2], ssrc[2];
+	guint8 rtp[12 + RTP_PAYLOAD_LEN];
+	guint64 start;
+	guint i;
+	int side;
+
+	flow->port[CLIENT] = PORT_SIP;
+	flow->port[SERVER] = PORT_SIP;
+
+	for (side = CLIENT; side <= SERVER; side++) {
+		g_snprintf(call.addr[side], sizeof call.addr[side], "%u.%u.%u.%u",
+		    flow->ip[side] >> 24, (flow->ip[side] >> 16) & 0xff,
+		    (flow->ip[side] >> 8) & 0xff, flow->ip[side] & 0xff);
+		call.rtp_port[side] = 2 * rand_range(flow, 5000, 16383);
+		rtp_seq[side] = (guint16)g_rand_int(flow->rand);
+		rtp_ts[side] = g_rand_int(flow->rand);
+		ssrc[side] = g_rand_int(flow->rand);
+	}
+	call.call_id = sip_random_token(flow);
+	call.from_tag = sip_random_token(flow);
+	call.to_tag = NULL;
+	call.branch = sip_random_token(flow);
+	call.session = g_rand_int(flow->rand) >> 1;
+
+	/* Calling */
+	invite = g_strdup_printf("INVITE sip:bob@%s SIP/2.0", call.addr[SERVER]);
+	sip_send(flow, CLIENT, &call, invite, "1 INVITE", TRUE);
+	flow->ts += flow->rtt;
+	sip_send(flow, SERVER, &call, "SIP/2.0 100 Trying", "1 INVITE", FALSE);
+	call.to_tag = sip_random_token(flow);
+	flow_wait(flow, 10000, 2000000);
+	sip_send(flow, SERVER, &call, "SIP/2.0 180 Ringing", "1 INVITE", FALSE);
+	flow_wait(flow, 500000, 5000000);
+	sip_send(flow, SERVER, &call, "SIP/2.0 200 OK", "1 INVITE", TRUE);
+	flow->ts += REPLY_DELAY;
+	g_free(call.branch);
+	call.branch = sip_random_token(flow);
+	g_free(invite);
+	invite = g_strdup_printf("ACK sip:bob@%s SIP/2.0", call.addr[SERVER]);
+	sip_send(flow, CLIENT, &call, invite, "1 ACK", FALSE);
+
+	/* Talking, with the server's packets offset from the client's */
+	start = flow->ts + REPLY_DELAY;
+	for (i = 0; i < packets; i++) {
+		for (side = CLIENT; side <= SERVER; side++) {
+			rtp[0] = 0x80;				/* version 2 */
+			rtp[1] = i == 0 ? 0x80 : 0x00;		/* marker, PCMU */
+			phton16(rtp + 2, rtp_seq[side]++);
+			phton32(rtp + 4, rtp_ts[side]);
+			phton32(rtp + 8, ssrc[side]);
+			rtp_ts[side] += RTP_PAYLOAD_LEN;
+			rand_bytes(flow, rtp + 12, RTP_PAYLOAD_LEN);
+			add_udp_datagram(flow, start + i * RTP_INTERVAL + (side == SERVER ? offset : 0),
+			    side, call.rtp_port[side], call.rtp_port[!side], rtp, sizeof rtp);
+		}
+	}
+	flow->ts = start + packets * RTP_INTERVAL;
+
+	/* Hanging up */
+	g_free(call.branch);
+	call.branch = sip_random_token(flow);
+	bye = g_strdup_printf("BYE sip:bob@%s SIP/2.0", call.addr[SERVER]);
+	sip_send(flow, CLIENT, &call, bye, "2 BYE", FALSE);
+	flow->ts += flow->rtt;
+	sip_send(flow, SERVER, &call, "SIP/2.0 200 OK", "2 BYE", FALSE);
+
+	g_free(invite);
+	g_free(bye);
+	g_free(call.call_id);
+	g_free(call.from_tag);
+	g_free(call.to_tag);
+	g_free(call.branch);
+}
+
+static const struct {
+	const char     *abbrev;
+	const char     *longname;
+	flow_generator  generate;
+} flow_types[RANDPKT_FLOW_NUM_TYPES] = {
+	{ "tcp",   "TCP connections with lost and retransmitted segments", gen_tcp },
+	{ "http2", "HTTP/2 connections in clear text",                      gen_http2 },
+	{ "dns",   "DNS lookups over UDP, some of them retried",            gen_dns },
+	{ "quic",  "QUIC connections, with undecryptable payloads",         gen_quic },
+	{ "sip",   "SIP calls over UDP, with their RTP streams",            gen_sip },
+};
+
+gboolean
+randpkt_flow_parse_types(const char *string, guint *types)
+{
+	gchar **names = g_strsplit(string, ",", -1);
+	gboolean ok = TRUE;
+	guint i, j;
+
+	*types = 0;
+	for (i = 0; names[i] != NULL; i++) {
+		for (j = 0; j < RANDPKT_FLOW_NUM_TYPES; j++) {
+			if (g_ascii_strcasecmp(names[i], flow_types[j].abbrev) == 0)
+				break;
+		}
+		if (j == RANDPKT_FLOW_NUM_TYPES) {
+			fprintf(stderr, "randpkt: Flow type %s not known.\n", names[i]);
+			ok = FALSE;
+			break;
+		}
+		*types |= 1U << j;
+	}
+	g_strfreev(names);
+	return ok && *types != 0;
+}
+
+void
+randpkt_flow_type_list(char*** abbrev_list, char*** longname_list)
+{
+	guint i;
+
+	*abbrev_list = g_new0(char*, RANDPKT_FLOW_NUM_TYPES + 1);
+	*longname_list = g_new0(char*, RANDPKT_FLOW_NUM_TYPES + 1);
+	for (i = 0; i < RANDPKT_FLOW_NUM_TYPES; i++) {
+		(*abbrev_list)[i] = g_strdup(flow_types[i].abbrev);
+		(*longname_list)[i] = g_strdup(flow_types[i].longname);
+	}
+}
+
+static gint
+flow_pkt_compare(gconstpointer a, gconstpointer b)
+{
+	const flow_pkt *pa = (const flow_pkt *)a;
+	const flow_pkt *pb = (const flow_pkt *)b;
+
+	if (pa->ts != pb->ts)
+		return pa->ts < pb->ts ? -1 : 1;
+	return pa->order < pb->order ? -1 : (pa->order > pb->order);
+}
+
+/* Generate all the packets of a new flow, the first at start_ts */
+static flow_t *
+flow_new(GRand *flow_rand, const randpkt_flow_params *params, guint64 flow_num, guint64 start_ts)
+{
+	flow_t *flow = g_new0(flow_t, 1);
+	guint32 host = (guint32)(flow_num / CLIENT_FLOWS_PER_HOST % 0xfffffe) + 1;
+	guint type, n, enabled = 0;
+
+	flow->rand = flow_rand;
+	flow->loss_permille = params->loss_permille;
+	flow->pkts = g_array_new(FALSE, FALSE, sizeof(flow_pkt));
+	flow->ts = start_ts;
+	flow->rtt = rand_range(flow, 1000, 80000) * NS_PER_US;
+
+	/* Pick one of the types, all being as likely */
+	for (type = 0; type < RANDPKT_FLOW_NUM_TYPES; type++) {
+		if (params->types & (1U << type))
+			enabled++;
+	}
+	n = rand_range(flow, 0, enabled - 1);
+	for (type = 0; ; type++) {
+		if ((params->types & (1U << type)) && n-- == 0)
+			break;
+	}
+
+	flow->ip[CLIENT] = CLIENT_NET | host;
+	flow->ip[SERVER] = SERVER_NET | (type << 8) | rand_range(flow, 1, 254);
+	flow->mac[CLIENT][0] = 0x02;
+	flow->mac[CLIENT][1] = 0x00;
+	phton32(flow->mac[CLIENT] + 2, flow->ip[CLIENT]);
+	memcpy(flow->mac[SERVER], router_mac, 6);
+	flow->port[CLIENT] = rand_range(flow, 1024, 65535);
+	flow->ip_id[CLIENT] = (guint16)g_rand_int(flow_rand);
+	flow->ip_id[SERVER] = (guint16)g_rand_int(flow_rand);
+
+	flow_types[type].generate(flow);
+	g_array_sort(flow->pkts, flow_pkt_compare);
+	return flow;
+}
+
+static void
+flow_free(flow_t *flow)
+{
+	guint i;
+
+	for (i = flow->next_pkt; i < flow->pkts->len; i++)
+		g_free(g_array_index(flow->pkts, flow_pkt, i).data);
+	g_array_free(flow->pkts, TRUE);
+	g_free(flow);
+}
+
+/*
+ * The flows in progress are kept in a heap, by the time of their next
+ * packet, so that the packets are written in time order.
+ */
+static guint64
+flow_next_ts(const flow_t *flow)
+{
+	return g_array_index(flow->pkts, flow_pkt, flow->next_pkt).ts;
+}
+
+static void
+heap_sift_down(GPtrArray *heap, guint i)
+{
+	for (;;) {
+		guint child = 2 * i + 1;
+		gpointer tmp;
+
+		if (child >= heap->len)
+			break;
+		if (child + 1 < heap->len &&
+		    flow_next_ts((flow_t *)heap->pdata[child + 1]) < flow_next_ts((flow_t *)heap->pdata[child]))
+			child++;
+		if (flow_next_ts((flow_t *)heap->pdata[i]) <= flow_next_ts((flow_t *)heap->pdata[child]))
+			break;
+		tmp = heap->pdata[i];
+		heap->pdata[i] = heap->pdata[child];
+		heap->pdata[child] = tmp;
+		i = child;
+	}
+}
+
+static void
+heap_push(GPtrArray *heap, flow_t *flow)
+{
+	guint i;
+
+	g_ptr_array_add(heap, flow);
+	for (i = heap->len - 1; i > 0; i = (i - 1) / 2) {
+		guint parent = (i - 1) / 2;
+		gpointer tmp;
+
+		if (flow_next_ts((flow_t *)heap->pdata[parent]) <= flow_next_ts((flow_t *)heap->pdata[i]))
+			break;
+		tmp = heap->pdata[i];
+		heap->pdata[i] = heap->pdata[parent];
+		heap->pdata[parent] = tmp;
+	}
+}
+
+static void
+heap_pop(GPtrArray *heap)
+{
+	heap->pdata[0] = heap->pdata[heap->len - 1];
+	g_ptr_array_set_size(heap, heap->len - 1);
+	if (heap->len > 0)
+		heap_sift_down(heap, 0);
+}
+
+int
+randpkt_flows_write(const char *filename, const randpkt_flow_params *params)
+{
+	const wtap_dump_params dump_params = {
+		.encap = WTAP_ENCAP_ETHERNET,
+		.snaplen = WTAP_MAX_PACKET_SIZE_STANDARD,
+		.tsprec = WTAP_TSPREC_NSEC,
+		.write_buf_size = WRITE_BUF_SIZE,
+	};
+	int file_type_subtype = wtap_pcapng_file_type_subtype();
+	const char *display_name;
+	wtap_dumper *dump;
+	GRand *flow_rand;
+	GPtrArray *heap;
+	guint64 started = 0;
+	guint32 framenum = 0;
+	wtap_rec rec;
+	int err;
+	gchar *err_info;
+	int ret = EXIT_SUCCESS;
+
+	if (strcmp(filename, "-") == 0) {
+		dump = wtap_dump_open_stdout(file_type_subtype, WTAP_UNCOMPRESSED,
+			&dump_params, &err, &err_info);
+		display_name = "the standard output";
+	} else {
+		dump = wtap_dump_open(filename, file_type_subtype, WTAP_UNCOMPRESSED,
+			&dump_params, &err, &err_info);
+		display_name = filename;
+	}
+	if (!dump) {
+		cfile_dump_open_failure_message(filename, err, err_info, file_type_subtype);
+		return WRITE_ERROR;
+	}
+
+	memset(&rec, 0, sizeof rec);
+	rec.rec_type = REC_TYPE_PACKET;
+	rec.presence_flags = WTAP_HAS_TS;
+	rec.tsprec = WTAP_TSPREC_NSEC;
+	rec.rec_header.packet_header.pkt_encap = WTAP_ENCAP_ETHERNET;
+
+	/* The first flows start within the first 100 ms; each flow that
+	 * ends is replaced by a new one, a little later. */
+	flow_rand = g_rand_new_with_seed(params->seed);
+	heap = g_ptr_array_new();
+	while (started < params->flow_count && heap->len < params->concurrency) {
+		guint64 start_ts = g_rand_int_range(flow_rand, 0, 100000) * NS_PER_US;
+
+		heap_push(heap, flow_new(flow_rand, params, started++, start_ts));
+	}
+
+	while (heap->len > 0) {
+		flow_t *flow = (flow_t *)heap->pdata[0];
+		flow_pkt *pkt = &g_array_index(flow->pkts, flow_pkt, flow->next_pkt);
+
+		rec.ts.secs = START_SECS + (time_t)(pkt->ts / NS_PER_SEC);
+		rec.ts.nsecs = (int)(pkt->ts % NS_PER_SEC);
+		rec.rec_header.packet_header.caplen = pkt->len;
+		rec.rec_header.packet_header.len = pkt->len;
+		framenum++;
+		if (!wtap_dump(dump, &rec, pkt->data, &err, &err_info)) {
+			cfile_write_failure_message(NULL, display_name, err, err_info,
+			    framenum, file_type_subtype);
+			ret = WRITE_ERROR;
+			break;
+		}
+		g_free(pkt->data);
+
+		if (++flow->next_pkt < flow->pkts->len) {
+			heap_sift_down(heap, 0);
+		} else {
+			guint64 end_ts = pkt->ts;
+
+			heap_pop(heap);
+			flow_free(flow);
+			if (started < params->flow_count) {
+				guint64 start_ts = end_ts + g_rand_int_range(flow_rand, 0, 10000) * NS_PER_US;
+
+				heap_push(heap, flow_new(flow_rand, params, started++, start_ts));
+			}
+		}
+	}
+
+	while (heap->len > 0) {
+		flow_free((flow_t *)heap->pdata[heap->len - 1]);
+		g_ptr_array_set_size(heap, heap->len - 1);
+	}
+	g_ptr_array_free(heap, TRUE);
+	g_rand_free(flow_rand);
+
+	if (!wtap_dump_close(dump, &err, &err_info)) {
+		cfile_close_failure_message(display_name, err, err_info);
+		ret = WRITE_ERROR;
+	}
+	return ret;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
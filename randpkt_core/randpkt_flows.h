@@ -0,0 +1,59 @@
+/*
+ * randpkt_flows.h
+ * ---------
+ * Creates capture files of synthetic flows of several protocols, such as
+ * TCP connections with losses and retransmissions, DNS lookups or SIP
+ * calls with their RTP streams, for benchmarking dissection at scale.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __RANDPKT_FLOWS_H__
+#define __RANDPKT_FLOWS_H__
+
+#include <glib.h>
+
+/* The kinds of flow that can be generated */
+typedef enum {
+	RANDPKT_FLOW_TCP,
+	RANDPKT_FLOW_HTTP2,
+	RANDPKT_FLOW_DNS,
+	RANDPKT_FLOW_QUIC,
+	RANDPKT_FLOW_SIP,
+	RANDPKT_FLOW_NUM_TYPES
+} randpkt_flow_type;
+
+typedef struct {
+	guint64 flow_count;	/* the number of flows to generate */
+	guint   concurrency;	/* the number of flows in progress at a time */
+	guint   types;		/* bit mask of the randpkt_flow_type values to generate */
+	guint   loss_permille;	/* chance, per thousand, of a TCP segment or DNS query being lost */
+	guint32 seed;		/* seed of the random number generator */
+} randpkt_flow_params;
+
+/* Parse a comma-separated list of flow type names into a bit mask;
+ * returns FALSE, having complained, if a name isn't known */
+gboolean randpkt_flow_parse_types(const char *string, guint *types);
+
+/* Return the list of the flow types */
+void randpkt_flow_type_list(char*** abbrev_list, char*** longname_list);
+
+/* Write a pcapng file, or the standard output if filename is "-", of
+ * generated flows; the same parameters always give the same file.
+ * Returns EXIT_SUCCESS, or an error code having reported the error */
+int randpkt_flows_write(const char *filename, const randpkt_flow_params *params);
+
+#endif
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
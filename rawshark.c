@@ -170,6 +170,19 @@ int fd;
 int encap;
 GPtrArray *string_fmts;
 
+/*
+ * The pipe is read in blocks of as much as has been written to it, up to
+ * RAW_PIPE_BUFSIZE bytes, from which the records are then taken one by
+ * one, rather than with two reads per record.
+ */
+#define RAW_PIPE_BUFSIZE (256 * 1024)
+static guchar *pipe_buf;
+static size_t pipe_buf_start;
+static size_t pipe_buf_end;
+
+/* The line printed for the current packet, written out at its end */
+static GString *packet_line;
+
 static void
 print_usage(FILE *output)
 {
@@ -835,6 +848,63 @@ clean_exit:
     return ret;
 }
 
+/*
+ * Copy the next len bytes of the pipe to dst, reading from the pipe when
+ * the ones read before have all been used.
+ * @return The number of bytes copied, which is less than len at the end
+ *         of the input, or -1 on error, with errno set.
+ */
+static ssize_t
+raw_pipe_get(void *dst, size_t len, gint64 *data_offset)
+{
+    guchar *ptr = (guchar *)dst;
+    size_t copied = 0;
+    size_t chunk;
+    ssize_t bytes_read;
+
+    if (pipe_buf == NULL)
+        pipe_buf = (guchar *)g_malloc(RAW_PIPE_BUFSIZE);
+
+    while (copied < len) {
+        if (pipe_buf_start == pipe_buf_end) {
+            /*
+             * Newer versions of the VC runtime do parameter validation. If stdin
+             * has been closed, calls to _read, _get_osfhandle, et al will trigger
+             * the invalid parameter handler and crash.
+             * We could alternatively use ReadFile or set an invalid parameter
+             * handler.
+             * We could also tell callers not to close stdin prematurely.
+             */
+#ifdef _WIN32
+            DWORD ghi_flags;
+            if (fd == 0 && GetHandleInformation(GetStdHandle(STD_INPUT_HANDLE), &ghi_flags) == 0) {
+                return (ssize_t)copied;
+            }
+#endif
+            bytes_read = ws_read(fd, pipe_buf, RAW_PIPE_BUFSIZE);
+            if (bytes_read < 0)
+                return -1;
+            if (bytes_read == 0)
+                return (ssize_t)copied;
+            pipe_buf_start = 0;
+            pipe_buf_end = (size_t)bytes_read;
+        }
+        chunk = MIN(pipe_buf_end - pipe_buf_start, len - copied);
+        memcpy(ptr + copied, pipe_buf + pipe_buf_start, chunk);
+        pipe_buf_start += chunk;
+        copied += chunk;
+        *data_offset += chunk;
+    }
+    return (ssize_t)copied;
+}
+
+/* Whether there's more of the pipe read than has been used. */
+static gboolean
+raw_pipe_buffered(void)
+{
+    return pipe_buf_start != pipe_buf_end;
+}
+
 /**
  * Read data from a raw pipe.  The "raw" data consists of a libpcap
  * packet header followed by the payload.
@@ -860,39 +930,16 @@ raw_pipe_read(wtap_rec *rec, Buffer *buf, int *err, gchar **err_info, gint64 *da
         ptr = (guchar*) &mem_hdr;
     }
 
-    /*
-     * Newer versions of the VC runtime do parameter validation. If stdin
-     * has been closed, calls to _read, _get_osfhandle, et al will trigger
-     * the invalid parameter handler and crash.
-     * We could alternatively use ReadFile or set an invalid parameter
-     * handler.
-     * We could also tell callers not to close stdin prematurely.
-     */
-#ifdef _WIN32
-    DWORD ghi_flags;
-    if (fd == 0 && GetHandleInformation(GetStdHandle(STD_INPUT_HANDLE), &ghi_flags) == 0) {
+    bytes_read = raw_pipe_get(ptr, bytes_needed, data_offset);
+    if (bytes_read < 0) {
+        *err = errno;
+        *err_info = NULL;
+        return FALSE;
+    } else if ((unsigned int)bytes_read < bytes_needed) {
         *err = 0;
         *err_info = NULL;
         return FALSE;
     }
-#endif
-
-    /* Copied from capture_loop.c */
-    while (bytes_needed > 0) {
-        bytes_read = ws_read(fd, ptr, bytes_needed);
-        if (bytes_read == 0) {
-            *err = 0;
-            *err_info = NULL;
-            return FALSE;
-        } else if (bytes_read < 0) {
-            *err = errno;
-            *err_info = NULL;
-            return FALSE;
-        }
-        bytes_needed -= (unsigned int)bytes_read;
-        *data_offset += bytes_read;
-        ptr += bytes_read;
-    }
 
     rec->rec_type = REC_TYPE_PACKET;
     rec->presence_flags = WTAP_HAS_TS|WTAP_HAS_CAP_LEN;
@@ -926,21 +973,15 @@ raw_pipe_read(wtap_rec *rec, Buffer *buf, int *err, gchar **err_info, gint64 *da
     }
 
     ws_buffer_assure_space(buf, bytes_needed);
-    ptr = ws_buffer_start_ptr(buf);
-    while (bytes_needed > 0) {
-        bytes_read = ws_read(fd, ptr, bytes_needed);
-        if (bytes_read == 0) {
-            *err = WTAP_ERR_SHORT_READ;
-            *err_info = NULL;
-            return FALSE;
-        } else if (bytes_read < 0) {
-            *err = errno;
-            *err_info = NULL;
-            return FALSE;
-        }
-        bytes_needed -= (unsigned int)bytes_read;
-        *data_offset += bytes_read;
-        ptr += bytes_read;
+    bytes_read = raw_pipe_get(ws_buffer_start_ptr(buf), bytes_needed, data_offset);
+    if (bytes_read < 0) {
+        *err = errno;
+        *err_info = NULL;
+        return FALSE;
+    } else if ((unsigned int)bytes_read < bytes_needed) {
+        *err = WTAP_ERR_SHORT_READ;
+        *err_info = NULL;
+        return FALSE;
     }
     return TRUE;
 }
@@ -963,6 +1004,35 @@ load_cap_file(capture_file *cf)
 
     while (raw_pipe_read(&rec, &buf, &err, &err_info, &data_offset)) {
         process_packet(cf, &edt, data_offset, &rec, &buf);
+
+        /* The ANSI C standard does not appear to *require* that a line-buffered
+           stream be flushed to the host environment whenever a newline is
+           written, it just says that, on such a stream, characters "are
+           intended to be transmitted to or from the host environment as a
+           block when a new-line character is encountered".
+
+           The Visual C++ 6.0 C implementation doesn't do what is intended;
+           even if you set a stream to be line-buffered, it still doesn't
+           flush the buffer at the end of every line.
+
+           So, if the "-l" flag was specified, we flush the standard output
+           once the packets read from the pipe so far have been printed,
+           before waiting for more.  This will do the right thing if we're
+           printing packet summary lines, and, as we print the entire protocol
+           tree for a single packet without waiting for anything to happen,
+           it should be as good as line-buffered mode if we're printing
+           protocol trees.  (The whole reason for the "-l" flag in either
+           tcpdump or Rawshark is to allow the output of a live capture to
+           be piped to a program or script and to have that script see the
+           information for the packet as soon as it's printed, rather than
+           having to wait until a standard I/O buffer fills up. */
+        if (line_buffered && !raw_pipe_buffered())
+            fflush(stdout);
+
+        if (ferror(stdout)) {
+            show_print_file_io_error(errno);
+            exit(2);
+        }
     }
 
     epan_dissect_cleanup(&edt);
@@ -1018,7 +1088,9 @@ process_packet(capture_file *cf, epan_dissect_t *edt, gint64 offset,
         }
     }
 
-    printf("%lu", (unsigned long int) cf->count);
+    if (packet_line == NULL)
+        packet_line = g_string_sized_new(256);
+    g_string_printf(packet_line, "%lu", (unsigned long int) cf->count);
 
     frame_data_set_before_dissect(&fdata, &cf->elapsed_time,
                                   &cf->provider.ref, cf->provider.prev_dis);
@@ -1050,38 +1122,12 @@ process_packet(capture_file *cf, epan_dissect_t *edt, gint64 offset,
             passed = TRUE;
 
         /* Print a one-line summary */
-        printf(" %d", passed ? 1 : 0);
+        g_string_append(packet_line, passed ? " 1" : " 0");
     }
 
-    printf(" -\n");
-
-    /* The ANSI C standard does not appear to *require* that a line-buffered
-       stream be flushed to the host environment whenever a newline is
-       written, it just says that, on such a stream, characters "are
-       intended to be transmitted to or from the host environment as a
-       block when a new-line character is encountered".
-
-       The Visual C++ 6.0 C implementation doesn't do what is intended;
-       even if you set a stream to be line-buffered, it still doesn't
-       flush the buffer at the end of every line.
-
-       So, if the "-l" flag was specified, we flush the standard output
-       at the end of a packet.  This will do the right thing if we're
-       printing packet summary lines, and, as we print the entire protocol
-       tree for a single packet without waiting for anything to happen,
-       it should be as good as line-buffered mode if we're printing
-       protocol trees.  (The whole reason for the "-l" flag in either
-       tcpdump or Rawshark is to allow the output of a live capture to
-       be piped to a program or script and to have that script see the
-       information for the packet as soon as it's printed, rather than
-       having to wait until a standard I/O buffer fills up. */
-    if (line_buffered)
-        fflush(stdout);
+    g_string_append(packet_line, " -\n");
 
-    if (ferror(stdout)) {
-        show_print_file_io_error(errno);
-        exit(2);
-    }
+    fwrite(packet_line->str, 1, packet_line->len, stdout);
 
     epan_dissect_reset(edt);
     frame_data_destroy(&fdata);
@@ -1251,14 +1297,14 @@ static gboolean print_field_value(field_info *finfo, int cmd_line_index)
                 }
             }
         }
-        printf(" %d=\"%s\"", cmd_line_index, label_s->str);
+        g_string_append_printf(packet_line, " %d=\"%s\"", cmd_line_index, label_s->str);
         wmem_free(NULL, fs_buf);
         return TRUE;
     }
 
     if(finfo->value.ftype->val_to_string_repr)
     {
-        printf(" %d=\"%s\"", cmd_line_index, fs_ptr);
+        g_string_append_printf(packet_line, " %d=\"%s\"", cmd_line_index, fs_ptr);
         wmem_free(NULL, fs_buf);
         return TRUE;
     }
@@ -1268,7 +1314,7 @@ static gboolean print_field_value(field_info *finfo, int cmd_line_index)
      * e.g. http
      * We return n.a.
      */
-    printf(" %d=\"n.a.\"", cmd_line_index);
+    g_string_append_printf(packet_line, " %d=\"n.a.\"", cmd_line_index);
     return TRUE;
 }
 
@@ -1281,7 +1327,7 @@ protocolinfo_packet(void *prs, packet_info *pinfo _U_, epan_dissect_t *edt, cons
 
     gp=proto_get_finfo_ptr_array(edt->tree, rs->hf_index);
     if(!gp){
-        printf(" n.a.");
+        g_string_append(packet_line, " n.a.");
         return TAP_PACKET_DONT_REDRAW;
     }
 
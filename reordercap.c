@@ -30,6 +30,7 @@
 
 #include <wiretap/wtap.h>
 
+#include <ui/clopts_common.h>
 #include <ui/cmdarg_err.h>
 #include <wsutil/filesystem.h>
 #include <wsutil/file_util.h>
@@ -59,6 +60,14 @@ print_usage(FILE *output)
     fprintf(output, "\n");
     fprintf(output, "Options:\n");
     fprintf(output, "  -n        don't write to output file if the input file is ordered.\n");
+    fprintf(output, "  -m <megabytes>\n");
+    fprintf(output, "            sort runs of at most <megabytes> of frames, kept in\n");
+    fprintf(output, "            temporary files, and merge them, for files larger than\n");
+    fprintf(output, "            memory.\n");
+    fprintf(output, "  -w <frames>\n");
+    fprintf(output, "            only reorder frames within a window of <frames> frames,\n");
+    fprintf(output, "            reading and writing the file in one pass, for files that\n");
+    fprintf(output, "            are nearly in order.\n");
     fprintf(output, "  -h        display this help and exit.\n");
     fprintf(output, "  -v        print version information and exit.\n");
 }
@@ -123,6 +132,23 @@ frame_write(FrameRecord_t *frame, wtap *wth, wtap_dumper *pdh,
     }
 }
 
+/* Remember the frame read from infile, with its number and time stamp */
+static FrameRecord_t *
+frame_record_new(guint num, gint64 data_offset, const wtap_rec *rec)
+{
+    FrameRecord_t *newFrameRecord;
+
+    newFrameRecord = g_slice_new(FrameRecord_t);
+    newFrameRecord->num = num;
+    newFrameRecord->offset = data_offset;
+    if (rec->presence_flags & WTAP_HAS_TS) {
+        newFrameRecord->frame_time = rec->ts;
+    } else {
+        nstime_set_unset(&newFrameRecord->frame_time);
+    }
+    return newFrameRecord;
+}
+
 /* Comparing timestamps between 2 frames.
    negative if (t1 < t2)
    zero     if (t1 == t2)
@@ -140,6 +166,400 @@ frames_compare(gconstpointer a, gconstpointer b)
     return nstime_cmp(time1, time2);
 }
 
+/* As frames_compare(), but frames with the same time stamp stay in the
+   order they were read in, as they do with the (stable) sort. */
+static int
+frames_compare_num(gconstpointer a, gconstpointer b)
+{
+    const FrameRecord_t *frame1 = *(const FrameRecord_t *const *) a;
+    const FrameRecord_t *frame2 = *(const FrameRecord_t *const *) b;
+    int result;
+
+    result = frames_compare(a, b);
+    if (result != 0) {
+        return result;
+    }
+    return (frame1->num > frame2->num) - (frame1->num < frame2->num);
+}
+
+/**************************************************/
+/* Binary min-heap of pointers, used to keep the  */
+/* reorder window and to merge the sorted runs.   */
+/* compare() is given pointers to the pointers,   */
+/* as with g_ptr_array_sort().                    */
+
+static void
+heap_push(GPtrArray *heap, gpointer item, GCompareFunc compare)
+{
+    guint i, parent;
+
+    g_ptr_array_add(heap, item);
+    for (i = heap->len - 1; i > 0; i = parent) {
+        parent = (i - 1) / 2;
+        if (compare(&heap->pdata[i], &heap->pdata[parent]) >= 0) {
+            break;
+        }
+        item = heap->pdata[i];
+        heap->pdata[i] = heap->pdata[parent];
+        heap->pdata[parent] = item;
+    }
+}
+
+static gpointer
+heap_pop(GPtrArray *heap, GCompareFunc compare)
+{
+    gpointer top, item;
+    guint i, child;
+
+    top = heap->pdata[0];
+    heap->pdata[0] = heap->pdata[heap->len - 1];
+    g_ptr_array_set_size(heap, heap->len - 1);
+    for (i = 0; (child = 2 * i + 1) < heap->len; i = child) {
+        if (child + 1 < heap->len &&
+            compare(&heap->pdata[child + 1], &heap->pdata[child]) < 0) {
+            child++;
+        }
+        if (compare(&heap->pdata[i], &heap->pdata[child]) <= 0) {
+            break;
+        }
+        item = heap->pdata[i];
+        heap->pdata[i] = heap->pdata[child];
+        heap->pdata[child] = item;
+    }
+    return top;
+}
+/**************************************************/
+
+/* Write the frames in the order they're read in, except that each one is
+   held back until "window" later frames have been read, and the earliest
+   of the frames held back goes first.  Only a frame that's out of order by
+   more than the window is written out of order. */
+static void
+reorder_with_window(wtap *wth, wtap_dumper *pdh, guint window,
+                    const char *infile, const char *outfile)
+{
+    wtap_rec read_rec, write_rec;
+    Buffer read_buf, write_buf;
+    int err;
+    gchar *err_info;
+    gint64 data_offset;
+    GPtrArray *held;
+    FrameRecord_t *frame;
+    nstime_t prev_time, written_time;
+    guint frame_count = 0;
+    guint wrong_order_count = 0;
+    guint late_count = 0;
+
+    held = g_ptr_array_sized_new(MIN(window, 65536) + 1);
+    nstime_set_unset(&written_time);
+
+    wtap_rec_init(&read_rec);
+    ws_buffer_init(&read_buf, 1514);
+    wtap_rec_init(&write_rec);
+    ws_buffer_init(&write_buf, 1514);
+    while (wtap_read(wth, &read_rec, &read_buf, &err, &err_info, &data_offset)) {
+        frame = frame_record_new(++frame_count, data_offset, &read_rec);
+
+        if (frame_count > 1 && nstime_cmp(&frame->frame_time, &prev_time) < 0) {
+            wrong_order_count++;
+        }
+        prev_time = frame->frame_time;
+        if (frame_count > window + 1 && nstime_cmp(&frame->frame_time, &written_time) < 0) {
+            late_count++;
+        }
+
+        heap_push(held, frame, frames_compare_num);
+        if (held->len > window) {
+            frame = (FrameRecord_t *)heap_pop(held, frames_compare_num);
+            frame_write(frame, wth, pdh, &write_rec, &write_buf, infile, outfile);
+            written_time = frame->frame_time;
+            g_slice_free(FrameRecord_t, frame);
+        }
+    }
+    wtap_rec_cleanup(&read_rec);
+    ws_buffer_free(&read_buf);
+    if (err != 0) {
+      /* Print a message noting that the read failed somewhere along the line. */
+      cfile_read_failure_message(infile, err, err_info);
+    }
+
+    while (held->len > 0) {
+        frame = (FrameRecord_t *)heap_pop(held, frames_compare_num);
+        frame_write(frame, wth, pdh, &write_rec, &write_buf, infile, outfile);
+        g_slice_free(FrameRecord_t, frame);
+    }
+    wtap_rec_cleanup(&write_rec);
+    ws_buffer_free(&write_buf);
+    g_ptr_array_free(held, TRUE);
+
+    printf("%u frames, %u out of order\n", frame_count, wrong_order_count);
+    if (late_count > 0) {
+        fprintf(stderr,
+                "reordercap: %u frames were out of order by more than %u frames, and were written out of order.\n",
+                late_count, window);
+    }
+}
+
+/* The temporary files holding the sorted runs, removed when we exit,
+   however we exit. */
+static GPtrArray *run_files = NULL;
+
+static void
+remove_run_files(void)
+{
+    guint i;
+
+    if (run_files == NULL) {
+        return;
+    }
+    for (i = 0; i < run_files->len; i++) {
+        ws_unlink((const char *)run_files->pdata[i]);
+        g_free(run_files->pdata[i]);
+    }
+    g_ptr_array_free(run_files, TRUE);
+    run_files = NULL;
+}
+
+/* Sort a run of frames, write them to a temporary file and free them.
+   They were read just before, so re-reading them shouldn't need the disk. */
+static void
+write_run(GPtrArray *frames, gboolean sorted, wtap *wth,
+          const wtap_dump_params *params, const char *infile)
+{
+    wtap_dumper *run_pdh;
+    char *run_file;
+    wtap_rec rec;
+    Buffer buf;
+    int err;
+    gchar *err_info;
+    guint i;
+
+    run_pdh = wtap_dump_open_tempfile(&run_file, "reordercap",
+                                      wtap_file_type_subtype(wth),
+                                      WTAP_UNCOMPRESSED, params, &err, &err_info);
+    if (run_pdh == NULL) {
+        cfile_dump_open_failure_message("temporary file", err, err_info,
+                                        wtap_file_type_subtype(wth));
+        exit(1);
+    }
+    g_ptr_array_add(run_files, run_file);
+
+    if (!sorted) {
+        g_ptr_array_sort(frames, frames_compare);
+    }
+
+    DEBUG_PRINT("Writing run of %u frames to %s\n", frames->len, run_file);
+    wtap_rec_init(&rec);
+    ws_buffer_init(&buf, 1514);
+    for (i = 0; i < frames->len; i++) {
+        FrameRecord_t *frame = (FrameRecord_t *)frames->pdata[i];
+
+        frame_write(frame, wth, run_pdh, &rec, &buf, infile, run_file);
+        g_slice_free(FrameRecord_t, frame);
+    }
+    wtap_rec_cleanup(&rec);
+    ws_buffer_free(&buf);
+    g_ptr_array_set_size(frames, 0);
+
+    if (!wtap_dump_close(run_pdh, &err, &err_info)) {
+        cfile_close_failure_message(run_file, err, err_info);
+        exit(1);
+    }
+}
+
+/* A sorted run being merged, with its next frame */
+typedef struct SortedRun_t {
+    wtap        *wth;
+    const char  *filename;
+    guint        num;
+    wtap_rec     rec;
+    Buffer       buf;
+    nstime_t     frame_time;
+} SortedRun_t;
+
+static gboolean
+sorted_run_read(SortedRun_t *run)
+{
+    int    err;
+    gchar  *err_info;
+    gint64 data_offset;
+
+    if (!wtap_read(run->wth, &run->rec, &run->buf, &err, &err_info, &data_offset)) {
+        if (err != 0) {
+            cfile_read_failure_message(run->filename, err, err_info);
+            exit(1);
+        }
+        return FALSE;
+    }
+    if (run->rec.presence_flags & WTAP_HAS_TS) {
+        run->frame_time = run->rec.ts;
+    } else {
+        nstime_set_unset(&run->frame_time);
+    }
+    return TRUE;
+}
+
+/* Earliest next frame first; for the same time stamp, the earlier run,
+   whose frames were read first. */
+static int
+runs_compare(gconstpointer a, gconstpointer b)
+{
+    const SortedRun_t *run1 = *(const SortedRun_t *const *) a;
+    const SortedRun_t *run2 = *(const SortedRun_t *const *) b;
+    int result;
+
+    result = nstime_cmp(&run1->frame_time, &run2->frame_time);
+    if (result != 0) {
+        return result;
+    }
+    return (run1->num > run2->num) - (run1->num < run2->num);
+}
+
+static void
+sorted_run_close(SortedRun_t *run)
+{
+    wtap_close(run->wth);
+    wtap_rec_cleanup(&run->rec);
+    ws_buffer_free(&run->buf);
+    g_free(run);
+}
+
+/* Merge the sorted runs into outfile, reading each of them in turn */
+static void
+merge_runs(wtap_dumper *pdh, const char *outfile)
+{
+    GPtrArray *heap;
+    SortedRun_t *run;
+    int err;
+    gchar *err_info;
+    guint32 framenum = 0;
+    guint i;
+
+    heap = g_ptr_array_sized_new(run_files->len);
+    for (i = 0; i < run_files->len; i++) {
+        run = g_new0(SortedRun_t, 1);
+        run->filename = (const char *)run_files->pdata[i];
+        run->num = i;
+        run->wth = wtap_open_offline(run->filename, WTAP_TYPE_AUTO, &err, &err_info, FALSE);
+        if (run->wth == NULL) {
+            cfile_open_failure_message(run->filename, err, err_info);
+            exit(1);
+        }
+        wtap_rec_init(&run->rec);
+        ws_buffer_init(&run->buf, 1514);
+        if (sorted_run_read(run)) {
+            heap_push(heap, run, runs_compare);
+        } else {
+            sorted_run_close(run);
+        }
+    }
+
+    while (heap->len > 0) {
+        run = (SortedRun_t *)heap_pop(heap, runs_compare);
+        framenum++;
+        if (!wtap_dump(pdh, &run->rec, ws_buffer_start_ptr(&run->buf), &err, &err_info)) {
+            cfile_write_failure_message(run->filename, outfile, err, err_info, framenum,
+                                        wtap_file_type_subtype(run->wth));
+            exit(1);
+        }
+        if (sorted_run_read(run)) {
+            heap_push(heap, run, runs_compare);
+        } else {
+            sorted_run_close(run);
+        }
+    }
+    g_ptr_array_free(heap, TRUE);
+}
+
+/* Sort runs of frames of at most run_limit bytes each into temporary files,
+   and merge them; memory is only needed for the frames of one run.  A file
+   that fits in a single run is sorted as it would be without a limit. */
+static void
+sort_with_runs(wtap *wth, wtap_dumper *pdh, const wtap_dump_params *params,
+               guint64 run_limit, gboolean write_output_regardless,
+               const char *infile, const char *outfile)
+{
+    wtap_rec rec;
+    Buffer buf;
+    int err;
+    gchar *err_info;
+    gint64 data_offset;
+    GPtrArray *frames;
+    nstime_t prev_time;
+    guint64 run_bytes = 0;
+    gboolean run_sorted = TRUE;
+    guint frame_count = 0;
+    guint wrong_order_count = 0;
+    guint i;
+
+    run_files = g_ptr_array_new();
+    frames = g_ptr_array_new();
+
+    wtap_rec_init(&rec);
+    ws_buffer_init(&buf, 1514);
+    while (wtap_read(wth, &rec, &buf, &err, &err_info, &data_offset)) {
+        FrameRecord_t *newFrameRecord;
+
+        /* A FrameRecord_t and the frame itself, when it's re-read */
+        run_bytes += sizeof(FrameRecord_t) + sizeof(gpointer) + ws_buffer_length(&buf);
+        if (run_bytes > run_limit && frames->len > 0) {
+            write_run(frames, run_sorted, wth, params, infile);
+            run_bytes = sizeof(FrameRecord_t) + sizeof(gpointer) + ws_buffer_length(&buf);
+            run_sorted = TRUE;
+        }
+
+        newFrameRecord = frame_record_new(++frame_count, data_offset, &rec);
+        if (frame_count > 1 && nstime_cmp(&newFrameRecord->frame_time, &prev_time) < 0) {
+            wrong_order_count++;
+            if (frames->len > 0) {
+                run_sorted = FALSE;
+            }
+        }
+        prev_time = newFrameRecord->frame_time;
+        g_ptr_array_add(frames, newFrameRecord);
+    }
+    wtap_rec_cleanup(&rec);
+    ws_buffer_free(&buf);
+    if (err != 0) {
+      /* Print a message noting that the read failed somewhere along the line. */
+      cfile_read_failure_message(infile, err, err_info);
+    }
+
+    printf("%u frames, %u out of order\n", frame_count, wrong_order_count);
+
+    if (run_files->len == 0) {
+        /* It all fitted */
+        if (!run_sorted) {
+            g_ptr_array_sort(frames, frames_compare);
+        }
+        wtap_rec_init(&rec);
+        ws_buffer_init(&buf, 1514);
+        for (i = 0; i < frames->len; i++) {
+            FrameRecord_t *frame = (FrameRecord_t *)frames->pdata[i];
+
+            if (write_output_regardless || (wrong_order_count > 0)) {
+                frame_write(frame, wth, pdh, &rec, &buf, infile, outfile);
+            }
+            g_slice_free(FrameRecord_t, frame);
+        }
+        wtap_rec_cleanup(&rec);
+        ws_buffer_free(&buf);
+    } else {
+        if (frames->len > 0) {
+            write_run(frames, run_sorted, wth, params, infile);
+        }
+        if (write_output_regardless || (wrong_order_count > 0)) {
+            merge_runs(pdh, outfile);
+        }
+    }
+
+    if (!write_output_regardless && (wrong_order_count == 0)) {
+        printf("Not writing output file because input file is already in order.\n");
+    }
+    g_ptr_array_free(frames, TRUE);
+    remove_run_files();
+}
+
 /*
  * General errors and warnings are reported with an console message
  * in reordercap.
@@ -190,6 +610,8 @@ main(int argc, char *argv[])
     gint64 data_offset;
     guint wrong_order_count = 0;
     gboolean write_output_regardless = TRUE;
+    guint64 run_limit = 0;
+    guint window = 0;
     guint i;
     wtap_dump_params params;
     int                          ret = EXIT_SUCCESS;
@@ -234,11 +656,17 @@ main(int argc, char *argv[])
     wtap_init(TRUE);
 
     /* Process the options first */
-    while ((opt = getopt_long(argc, argv, "hnv", long_options, NULL)) != -1) {
+    while ((opt = getopt_long(argc, argv, "hm:nvw:", long_options, NULL)) != -1) {
         switch (opt) {
+            case 'm':
+                run_limit = (guint64)get_nonzero_guint32(optarg, "run size") * 1024 * 1024;
+                break;
             case 'n':
                 write_output_regardless = FALSE;
                 break;
+            case 'w':
+                window = get_nonzero_guint32(optarg, "reorder window");
+                break;
             case 'h':
                 show_help_header("Reorder timestamps of input file frames into output file.");
                 print_usage(stdout);
@@ -253,6 +681,18 @@ main(int argc, char *argv[])
         }
     }
 
+    if (window > 0 && run_limit > 0) {
+        cmdarg_err("-m and -w can't be used together.");
+        ret = INVALID_OPTION;
+        goto clean_exit;
+    }
+    if (window > 0 && !write_output_regardless) {
+        /* We write frames before we know whether the file is in order. */
+        cmdarg_err("-n can't be used with -w.");
+        ret = INVALID_OPTION;
+        goto clean_exit;
+    }
+
     /* Remaining args are file names */
     file_count = argc - optind;
     if (file_count == 2) {
@@ -286,17 +726,28 @@ main(int argc, char *argv[])
       pdh = wtap_dump_open(outfile, wtap_file_type_subtype(wth),
                            WTAP_UNCOMPRESSED, &params, &err, &err_info);
     }
-    g_free(params.idb_inf);
-    params.idb_inf = NULL;
 
     if (pdh == NULL) {
         cfile_dump_open_failure_message(outfile, err, err_info,
                                         wtap_file_type_subtype(wth));
+        g_free(params.idb_inf);
         wtap_dump_params_cleanup(&params);
         ret = OUTPUT_FILE_ERROR;
         goto clean_exit;
     }
 
+    if (window > 0) {
+        reorder_with_window(wth, pdh, window, infile, outfile);
+        goto close_output;
+    }
+    if (run_limit > 0) {
+        /* The runs are written with the same parameters as outfile. */
+        atexit(remove_run_files);
+        sort_with_runs(wth, pdh, &params, run_limit, write_output_regardless,
+                       infile, outfile);
+        goto close_output;
+    }
+
     /* Allocate the array of frame pointers. */
     frames = g_ptr_array_new();
 
@@ -306,14 +757,7 @@ main(int argc, char *argv[])
     while (wtap_read(wth, &rec, &buf, &err, &err_info, &data_offset)) {
         FrameRecord_t *newFrameRecord;
 
-        newFrameRecord = g_slice_new(FrameRecord_t);
-        newFrameRecord->num = frames->len + 1;
-        newFrameRecord->offset = data_offset;
-        if (rec.presence_flags & WTAP_HAS_TS) {
-            newFrameRecord->frame_time = rec.ts;
-        } else {
-            nstime_set_unset(&newFrameRecord->frame_time);
-        }
+        newFrameRecord = frame_record_new(frames->len + 1, data_offset, &rec);
 
         if (prevFrame && frames_compare(&newFrameRecord, &prevFrame) < 0) {
            wrong_order_count++;
@@ -358,6 +802,10 @@ main(int argc, char *argv[])
     /* Free the whole array */
     g_ptr_array_free(frames, TRUE);
 
+close_output:
+    g_free(params.idb_inf);
+    params.idb_inf = NULL;
+
     /* Close outfile */
     if (!wtap_dump_close(pdh, &err, &err_info)) {
         cfile_close_failure_message(outfile, err, err_info);
@@ -53,6 +53,7 @@
 
 #include "ringbuffer.h"
 #include <wsutil/file_util.h>
+#include <wsutil/stream_compress.h>
 
 #ifdef HAVE_ZLIB
 #include <zlib.h>
@@ -65,6 +66,20 @@ typedef struct _rb_file {
 
 #define MAX_FILENAME_QUEUE  100
 
+/*
+ * A file that has been switched away from, for the closer thread to
+ * close, along with the file, if any, that the new file replaces in the
+ * ring, for it to remove or compress.
+ */
+typedef struct _rb_close_job {
+  FILE         *pdh;
+  ws_cstream   *cstream;             /**< the compressor pdh writes to, or NULL */
+  char         *io_buffer;
+  gchar        *old_name;
+  gboolean      compress_old;
+  gboolean      quit;                /**< TRUE to make the thread exit */
+} rb_close_job;
+
 /** Ringbuffer data structure */
 typedef struct _ringbuf_data {
   rb_file      *files;
@@ -80,13 +95,50 @@ typedef struct _ringbuf_data {
   gboolean      group_read_access;   /**< TRUE if files need to be opened with group read access */
   FILE         *name_h;              /**< write names of completed files to this handle */
   gchar        *compress_type;       /**< compress type */
+  gboolean      stream_compress;     /**< TRUE to compress files as they're written */
+  ws_cstream_type stream_type;       /**< how to compress them */
+  ws_cstream   *cstream;             /**< the current file's compressor, or NULL */
+  gchar        *sidecar_suffix;      /**< suffix of a file that goes with each file, or NULL */
 
   GMutex        mutex;               /**< mutex for oldnames */
   gchar        *oldnames[MAX_FILENAME_QUEUE];       /**< filename list of pending to be deleted */
+
+  GThread      *closer;              /**< closes files that have been switched away from */
+  GAsyncQueue  *close_jobs;          /**< rb_close_job queue for the closer */
+  gint          close_err;           /**< errno of the first close failure in the closer */
 } ringbuf_data;
 
 static ringbuf_data rb_data;
 
+/*
+ * Remove the file that goes with a ring buffer file, if there is one.
+ */
+static void ringbuf_unlink_sidecar(const gchar *name)
+{
+  gchar *sidecar;
+
+  if (rb_data.sidecar_suffix != NULL) {
+    sidecar = g_strconcat(name, rb_data.sidecar_suffix, NULL);
+    ws_unlink(sidecar);
+    g_free(sidecar);
+  }
+}
+
+/*
+ * Close a file, waiting for its compressor, if it has one, to finish
+ * writing it; returns 0 or an errno value.
+ */
+static int ringbuf_close_file(FILE *pdh, ws_cstream *cstream)
+{
+  if (cstream != NULL) {
+    return ws_cstream_close(cstream);
+  }
+  if (fclose(pdh) == EOF) {
+    return errno != 0 ? errno : EIO;
+  }
+  return 0;
+}
+
 /*
  * delete pending uncompressed pcap files.
  */
@@ -191,15 +243,73 @@ static void* exec_compress_thread(void* arg)
 }
 
 /*
- * start a thread to compress capture file
+ * start a thread to compress capture file; takes ownership of name
  */
-static int ringbuf_start_compress_file(rb_file* rfile)
+static int ringbuf_start_compress_file(gchar* name)
 {
-  gchar* name = g_strdup(rfile->name);
   g_thread_new("exec_compress", &exec_compress_thread, name);
   return 0;
 }
 
+/*
+ * Close the files we've switched away from, and remove or compress the
+ * files they replace, so that the capture loop doesn't wait for that;
+ * on some file systems, removing a large file takes a long time.
+ */
+static void* ringbuf_closer_thread(void* arg _U_)
+{
+  rb_close_job *job;
+  int           close_err;
+
+  for (;;) {
+    job = (rb_close_job *)g_async_queue_pop(rb_data.close_jobs);
+    if (job->quit) {
+      g_free(job);
+      break;
+    }
+    close_err = ringbuf_close_file(job->pdh, job->cstream);
+    if (close_err != 0) {
+      /* Only the first error is reported. */
+      g_atomic_int_compare_and_exchange(&rb_data.close_err, 0, close_err);
+    }
+    g_free(job->io_buffer);
+    if (job->old_name != NULL) {
+      if (job->compress_old) {
+        ringbuf_start_compress_file(job->old_name);
+      } else {
+        /* remove old file (if any, so ignore error) */
+        ws_unlink(job->old_name);
+        ringbuf_unlink_sidecar(job->old_name);
+        g_free(job->old_name);
+      }
+    }
+    g_free(job);
+  }
+
+  return NULL;
+}
+
+/*
+ * Wait until the closer thread, if there is one, has closed every file
+ * that has been switched away from; returns the errno of the first
+ * failure to close one, or 0.
+ */
+static int ringbuf_finish_closing(void)
+{
+  if (rb_data.closer != NULL) {
+    rb_close_job *job = g_new0(rb_close_job, 1);
+
+    job->quit = TRUE;
+    g_async_queue_push(rb_data.close_jobs, job);
+    g_thread_join(rb_data.closer);
+    g_async_queue_unref(rb_data.close_jobs);
+    rb_data.closer = NULL;
+    rb_data.close_jobs = NULL;
+  }
+
+  return g_atomic_int_get(&rb_data.close_err);
+}
+
 /*
  * create the next filename and open a new binary file with that name
  */
@@ -210,16 +320,8 @@ static int ringbuf_open_file(rb_file *rfile, int *err)
   time_t  current_time;
   struct tm *tm;
 
-  if (rfile->name != NULL) {
-    if (rb_data.unlimited == FALSE) {
-      /* remove old file (if any, so ignore error) */
-      ws_unlink(rfile->name);
-    }
-    else if (rb_data.compress_type != NULL && strcmp(rb_data.compress_type, "gzip") == 0) {
-      ringbuf_start_compress_file(rfile);
-    }
-    g_free(rfile->name);
-  }
+  /* The closer thread takes care of the file this one replaces. */
+  g_assert(rfile->name == NULL);
 
 #ifdef _WIN32
   _tzset();
@@ -272,7 +374,13 @@ ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_acce
   rb_data.group_read_access = group_read_access;
   rb_data.name_h = NULL;
   rb_data.compress_type = compress_type;
+  rb_data.stream_compress = FALSE;
+  rb_data.cstream = NULL;
+  rb_data.sidecar_suffix = NULL;
   g_mutex_init(&rb_data.mutex);
+  rb_data.closer = NULL;
+  rb_data.close_jobs = NULL;
+  rb_data.close_err = 0;
 
   /* just to be sure ... */
   if (num_files <= RINGBUFFER_MAX_NUM_FILES) {
@@ -316,6 +424,20 @@ ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_acce
   g_free(save_file);
   save_file = NULL;
 
+  /* zstd and LZ4 compress each file as it's written, so the files get
+     the compressed file extension */
+  if (compress_type != NULL && (strcmp(compress_type, "zstd") == 0 ||
+                                strcmp(compress_type, "lz4") == 0)) {
+    gchar *suffix = rb_data.fsuffix;
+
+    rb_data.stream_compress = TRUE;
+    rb_data.stream_type = strcmp(compress_type, "zstd") == 0 ? WS_CSTREAM_ZSTD : WS_CSTREAM_LZ4;
+    rb_data.fsuffix = g_strconcat(suffix != NULL ? suffix : "",
+                                  rb_data.stream_type == WS_CSTREAM_ZSTD ? ".zst" : ".lz4",
+                                  NULL);
+    g_free(suffix);
+  }
+
   /* allocate rb_file structures (only one if unlimited since there is no
      need to save all file names in that case) */
 
@@ -371,6 +493,17 @@ ringbuf_set_print_name(gchar *name, int *err)
   return TRUE;
 }
 
+/*
+ * Set the suffix of a file, such as an index, that goes with each
+ * ringbuffer file, so that it's removed along with it.
+ */
+void
+ringbuf_set_sidecar_suffix(const gchar *suffix)
+{
+  g_free(rb_data.sidecar_suffix);
+  rb_data.sidecar_suffix = g_strdup(suffix);
+}
+
 /*
  * Whether the ringbuf filenames are ready.
  * (Whether ringbuf_init is called and ringbuf_free is not called.)
@@ -392,24 +525,39 @@ const gchar *ringbuf_current_filename(void)
 FILE *
 ringbuf_init_libpcap_fdopen(int *err)
 {
-  rb_data.pdh = ws_fdopen(rb_data.fd, "wb");
+  if (rb_data.stream_compress) {
+    int cstream_err;
+
+    /* the compressor takes the file descriptor; we write to a pipe */
+    rb_data.cstream = ws_cstream_fdopen(rb_data.fd, rb_data.stream_type, &cstream_err);
+    if (rb_data.cstream == NULL) {
+      if (err != NULL) {
+        *err = cstream_err;
+      }
+      return NULL;
+    }
+    rb_data.pdh = ws_cstream_file(rb_data.cstream);
+  } else {
+    rb_data.pdh = ws_fdopen(rb_data.fd, "wb");
+  }
   if (rb_data.pdh == NULL) {
     if (err != NULL) {
       *err = errno;
     }
   } else {
-    size_t buffsize = IO_BUF_SIZE;
+    size_t buffsize = CAPTURE_IO_BUF_SIZE;
 #ifdef HAVE_STRUCT_STAT_ST_BLKSIZE
     ws_statb64 statb;
 
     if (ws_fstat64(rb_data.fd, &statb) == 0) {
-      if (statb.st_blksize > IO_BUF_SIZE) {
+      if (statb.st_blksize > CAPTURE_IO_BUF_SIZE) {
         buffsize = statb.st_blksize;
       }
     }
 #endif
-    /* Increase the size of the IO buffer */
-    rb_data.io_buffer = (char *)g_realloc(rb_data.io_buffer, buffsize);
+    /* Increase the size of the IO buffer; the previous file's buffer,
+       if any, went to the closer thread with it. */
+    rb_data.io_buffer = (char *)g_malloc(buffsize);
     setvbuf(rb_data.pdh, rb_data.io_buffer, _IOFBF, buffsize);
   }
 
@@ -424,23 +572,42 @@ ringbuf_switch_file(FILE **pdh, gchar **save_file, int *save_file_fd, int *err)
 {
   int     next_file_index;
   rb_file *next_rfile = NULL;
+  rb_close_job *job;
+  int     close_err;
 
-  /* close current file */
+  /* did the closer fail to close a previous file? */
+  close_err = g_atomic_int_get(&rb_data.close_err);
+  if (close_err != 0) {
+    if (err != NULL) {
+      *err = close_err;
+    }
+    return FALSE;
+  }
+
+  /* flush current file; closing it is left to the closer thread, so
+     that this doesn't wait for that */
 
-  if (fclose(rb_data.pdh) == EOF) {
+  if (fflush(rb_data.pdh) == EOF) {
     if (err != NULL) {
       *err = errno;
     }
-    ws_close(rb_data.fd);  /* XXX - the above should have closed this already */
+    ringbuf_close_file(rb_data.pdh, rb_data.cstream);
     rb_data.pdh = NULL;    /* it's still closed, we just got an error while closing */
+    rb_data.cstream = NULL;
     rb_data.fd = -1;
     g_free(rb_data.io_buffer);
     rb_data.io_buffer = NULL;
     return FALSE;
   }
 
+  job = g_new0(rb_close_job, 1);
+  job->pdh = rb_data.pdh;
+  job->cstream = rb_data.cstream;
+  job->io_buffer = rb_data.io_buffer;
   rb_data.pdh = NULL;
+  rb_data.cstream = NULL;
   rb_data.fd  = -1;
+  rb_data.io_buffer = NULL;
 
   if (rb_data.name_h != NULL) {
     fprintf(rb_data.name_h, "%s\n", ringbuf_current_filename());
@@ -453,6 +620,26 @@ ringbuf_switch_file(FILE **pdh, gchar **save_file, int *save_file_fd, int *err)
   next_file_index = (rb_data.curr_file_num) % rb_data.num_files;
   next_rfile = &rb_data.files[next_file_index];
 
+  /* the closer removes the file this one replaces, or, if there's no
+     limit on the number of files, compresses the one we just closed */
+  if (next_rfile->name != NULL) {
+    if (rb_data.unlimited == FALSE) {
+      job->old_name = next_rfile->name;
+    } else if (rb_data.compress_type != NULL && strcmp(rb_data.compress_type, "gzip") == 0) {
+      job->old_name = next_rfile->name;
+      job->compress_old = TRUE;
+    } else {
+      g_free(next_rfile->name);
+    }
+    next_rfile->name = NULL;
+  }
+
+  if (rb_data.closer == NULL) {
+    rb_data.close_jobs = g_async_queue_new();
+    rb_data.closer = g_thread_new("ringbuf_closer", &ringbuf_closer_thread, NULL);
+  }
+  g_async_queue_push(rb_data.close_jobs, job);
+
   if (ringbuf_open_file(next_rfile, err) == -1) {
     return FALSE;
   }
@@ -476,10 +663,30 @@ gboolean
 ringbuf_libpcap_dump_close(gchar **save_file, int *err)
 {
   gboolean  ret_val = TRUE;
+  int       close_err;
+
+  /* wait for the files we switched away from to be closed */
+  close_err = ringbuf_finish_closing();
+  if (close_err != 0) {
+    if (err != NULL) {
+      *err = close_err;
+    }
+    ret_val = FALSE;
+  }
 
   /* close current file, if it's open */
   if (rb_data.pdh != NULL) {
-    if (fclose(rb_data.pdh) == EOF) {
+    if (rb_data.cstream != NULL) {
+      /* this closes the file descriptor, whether or not it fails */
+      close_err = ws_cstream_close(rb_data.cstream);
+      rb_data.cstream = NULL;
+      if (close_err != 0) {
+        if (err != NULL) {
+          *err = close_err;
+        }
+        ret_val = FALSE;
+      }
+    } else if (fclose(rb_data.pdh) == EOF) {
       if (err != NULL) {
         *err = errno;
       }
@@ -533,6 +740,8 @@ ringbuf_free(void)
     g_free(rb_data.fsuffix);
     rb_data.fsuffix = NULL;
   }
+  g_free(rb_data.sidecar_suffix);
+  rb_data.sidecar_suffix = NULL;
 
   CleanupOldCap(NULL);
 }
@@ -545,9 +754,16 @@ ringbuf_error_cleanup(void)
 {
   unsigned int i;
 
+  ringbuf_finish_closing();
+
   /* try to close via wtap */
   if (rb_data.pdh != NULL) {
-    if (fclose(rb_data.pdh) == 0) {
+    if (rb_data.cstream != NULL) {
+      /* this closes the file descriptor, whether or not it fails */
+      ws_cstream_close(rb_data.cstream);
+      rb_data.cstream = NULL;
+      rb_data.fd = -1;
+    } else if (fclose(rb_data.pdh) == 0) {
       rb_data.fd = -1;
     }
     rb_data.pdh = NULL;
@@ -563,6 +779,7 @@ ringbuf_error_cleanup(void)
     for (i=0; i < rb_data.num_files; i++) {
       if (rb_data.files[i].name != NULL) {
         ws_unlink(rb_data.files[i].name);
+        ringbuf_unlink_sidecar(rb_data.files[i].name);
       }
     }
   }
@@ -23,7 +23,14 @@
 /* Maximum number for FAT filesystems */
 #define RINGBUFFER_WARN_NUM_FILES 65535
 
+/*
+ * Size of the stdio buffer for the capture files dumpcap writes, so that
+ * at high packet rates the data is written with a few large write() calls.
+ */
+#define CAPTURE_IO_BUF_SIZE (1024 * 1024)
+
 int ringbuf_init(const char *capture_name, guint num_files, gboolean group_read_access, gchar* compress_type);
+void ringbuf_set_sidecar_suffix(const gchar *suffix);
 gboolean ringbuf_is_initialized(void);
 const gchar *ringbuf_current_filename(void);
 FILE *ringbuf_init_libpcap_fdopen(int *err);
@@ -27,6 +27,7 @@
 #include <ui/cmdarg_err.h>
 #include <wsutil/filesystem.h>
 #include <wsutil/file_util.h>
+#include <wsutil/glib-compat.h>
 #include <wsutil/privileges.h>
 #include <wsutil/report_message.h>
 #include <version_info.h>
@@ -36,6 +37,7 @@
 #include <epan/timestamp.h>
 #include <epan/packet.h>
 #include "frame_tvbuff.h"
+#include "frame_record_cache.h"
 #include <epan/disabled_protos.h>
 #include <epan/prefs.h>
 #include <epan/column.h>
@@ -72,6 +74,8 @@ capture_file cfile;
 
 static guint32 cum_bytes;
 static frame_data ref_frame;
+static sharkd_load_stats_t load_stats;
+static gboolean load_stats_valid;
 
 static void sharkd_cmdarg_err(const char *msg_format, va_list ap);
 static void sharkd_cmdarg_err_cont(const char *msg_format, va_list ap);
@@ -241,6 +245,51 @@ sharkd_epan_new(capture_file *cf)
   return epan_new(&cf->provider, &funcs);
 }
 
+static void
+load_stats_reset(void)
+{
+  load_stats.bytes = 0;
+  load_stats.have_times = FALSE;
+  nstime_set_zero(&load_stats.first_time);
+  nstime_set_zero(&load_stats.last_time);
+  if (load_stats.protocols == NULL) {
+    load_stats.protocols = g_array_new(FALSE, FALSE, sizeof(guint));
+    load_stats.protocols_set = g_hash_table_new(NULL /* g_direct_hash() */, NULL /* g_direct_equal */);
+  }
+  g_array_set_size(load_stats.protocols, 0);
+  g_hash_table_remove_all(load_stats.protocols_set);
+  load_stats_valid = FALSE;
+}
+
+/* Add a frame the load pass keeps to what the analyse request reports,
+   so that it doesn't have to dissect them all again. */
+static void
+load_stats_add(const frame_data *fdata, const packet_info *pi)
+{
+  wmem_list_frame_t *frame;
+  guint proto_id;
+
+  load_stats.bytes += fdata->pkt_len;
+
+  if (!load_stats.have_times || nstime_cmp(&fdata->abs_ts, &load_stats.first_time) < 0)
+    load_stats.first_time = fdata->abs_ts;
+  if (!load_stats.have_times || nstime_cmp(&fdata->abs_ts, &load_stats.last_time) > 0)
+    load_stats.last_time = fdata->abs_ts;
+  load_stats.have_times = TRUE;
+
+  if (pi->layers == NULL)
+    return;
+
+  for (frame = wmem_list_head(pi->layers); frame; frame = wmem_list_frame_next(frame)) {
+    proto_id = GPOINTER_TO_UINT(wmem_list_frame_data(frame));
+
+    if (!g_hash_table_lookup_extended(load_stats.protocols_set, GUINT_TO_POINTER(proto_id), NULL, NULL)) {
+      g_hash_table_insert(load_stats.protocols_set, GUINT_TO_POINTER(proto_id), GUINT_TO_POINTER(proto_id));
+      g_array_append_val(load_stats.protocols, proto_id);
+    }
+  }
+}
+
 static gboolean
 process_packet(capture_file *cf, epan_dissect_t *edt,
                gint64 offset, wtap_rec *rec, Buffer *buf)
@@ -292,10 +341,19 @@ process_packet(capture_file *cf, epan_dissect_t *edt,
     /* Run the read filter if we have one. */
     if (cf->rfcode)
       passed = dfilter_apply_edt(cf->rfcode, edt);
+
+    /* Start looking up the names of the addresses, so that they're
+       (mostly) known by the time a request shows them. */
+    if (passed && gbl_resolv_flags.network_name) {
+      host_name_lookup_prefetch(&edt->pi.net_src);
+      host_name_lookup_prefetch(&edt->pi.net_dst);
+    }
   }
 
   if (passed) {
     frame_data_set_after_dissect(&fdlocal, &cum_bytes);
+    if (edt)
+      load_stats_add(&fdlocal, &edt->pi);
     cf->provider.prev_cap = cf->provider.prev_dis = frame_data_sequence_add(cf->provider.frames, &fdlocal);
 
     /* If we're not doing dissection then there won't be any dependent frames.
@@ -337,6 +395,7 @@ load_cap_file(capture_file *cf, int max_packet_count, gint64 max_byte_count)
   {
     /* Allocate a frame_data_sequence for all the frames. */
     cf->provider.frames = new_frame_data_sequence();
+    load_stats_reset();
 
     {
       gboolean create_proto_tree;
@@ -394,6 +453,7 @@ load_cap_file(capture_file *cf, int max_packet_count, gint64 max_byte_count)
 
     cf->provider.prev_dis = NULL;
     cf->provider.prev_cap = NULL;
+    load_stats_valid = TRUE;
   }
 
   if (err != 0) {
@@ -439,6 +499,10 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_temp
   cf->provider.ref = NULL;
   cf->provider.prev_dis = NULL;
   cf->provider.prev_cap = NULL;
+  frame_record_cache_free(cf->provider.record_cache);
+  cf->provider.record_cache = NULL;
+  if (prefs.gui_record_cache_size > 0)
+    cf->provider.record_cache = frame_record_cache_new((gsize)prefs.gui_record_cache_size * 1024 * 1024);
 
   /* Create new epan session for dissection. */
   epan_free(cf->epan);
@@ -490,6 +554,51 @@ sharkd_load_cap_file(void)
   return load_cap_file(&cfile, 0, 0);
 }
 
+static void
+load_stats_dissect_cb(epan_dissect_t *edt, proto_tree *tree _U_, struct epan_column_info *cinfo _U_, const GSList *data_src _U_, void *data _U_)
+{
+  load_stats_add(edt->pi.fd, &edt->pi);
+}
+
+/*
+ * What the frames contain, as found by the load pass. If the preferences
+ * have changed since, the frames may dissect differently, and they're
+ * dissected again.
+ */
+const sharkd_load_stats_t *
+sharkd_get_load_stats(void)
+{
+  guint32 framenum;
+
+  if (!load_stats_valid) {
+    load_stats_reset();
+    for (framenum = 1; framenum <= cfile.count; framenum++)
+      sharkd_dissect_request(framenum, (framenum != 1) ? 1 : 0, framenum - 1, load_stats_dissect_cb, SHARKD_DISSECT_FLAG_NULL, NULL);
+    load_stats_valid = TRUE;
+  }
+  return &load_stats;
+}
+
+void
+sharkd_invalidate_load_stats(void)
+{
+  load_stats_valid = FALSE;
+}
+
+/*
+ * Open the capture file again for random access, after fork(), so that
+ * this process doesn't share a file offset with the others.
+ */
+int
+sharkd_reopen_cap_file(void)
+{
+  int err = 0;
+
+  if (!wtap_fdreopen(cfile.provider.wth, cfile.filename, &err))
+    return err != 0 ? err : EIO;
+  return 0;
+}
+
 frame_data *
 sharkd_get_frame(guint32 framenum)
 {
@@ -516,7 +625,8 @@ sharkd_dissect_request(guint32 framenum, guint32 frame_ref_num, guint32 prev_dis
   wtap_rec_init(&rec);
   ws_buffer_init(&buf, 1514);
 
-  if (!wtap_seek_read(cfile.provider.wth, fdata->file_off, &rec, &buf, &err, &err_info)) {
+  if (!frame_record_cache_read(cfile.provider.record_cache, cfile.provider.wth,
+                               framenum, fdata->file_off, &rec, &buf, &err, &err_info)) {
     wtap_rec_cleanup(&rec);
     ws_buffer_free(&buf);
     return -1; /* error reading the record */
@@ -617,8 +727,13 @@ sharkd_dissect_columns(frame_data *fdata, guint32 frame_ref_num, guint32 prev_di
   return 0;
 }
 
+/*
+ * Run the tap listeners over all the frames, calling progress_cb, if it's
+ * not NULL, at most every SHARKD_PROGRESS_INTERVAL microseconds, but
+ * don't draw the results.
+ */
 int
-sharkd_retap(void)
+sharkd_retap_run(sharkd_progress_func_t progress_cb, void *data)
 {
   guint32          framenum;
   frame_data      *fdata;
@@ -631,6 +746,7 @@ sharkd_retap(void)
   gboolean      create_proto_tree;
   epan_dissect_t edt;
   column_info   *cinfo;
+  gint64        last_progress = 0;
 
   /* Get the union of the flags for all tap listeners. */
   tap_flags = union_of_tap_listener_flags();
@@ -655,7 +771,19 @@ sharkd_retap(void)
 
   reset_tap_listeners();
 
+  if (progress_cb)
+    last_progress = g_get_monotonic_time();
+
   for (framenum = 1; framenum <= cfile.count; framenum++) {
+    if (progress_cb) {
+      gint64 now = g_get_monotonic_time();
+
+      if (now - last_progress >= SHARKD_PROGRESS_INTERVAL) {
+        progress_cb(framenum - 1, cfile.count, data);
+        last_progress = now;
+      }
+    }
+
     fdata = sharkd_get_frame(framenum);
 
     if (!wtap_seek_read(cfile.provider.wth, fdata->file_off, &rec, &buf, &err, &err_info))
@@ -674,6 +802,13 @@ sharkd_retap(void)
   ws_buffer_free(&buf);
   epan_dissect_cleanup(&edt);
 
+  return 0;
+}
+
+int
+sharkd_retap(void)
+{
+  sharkd_retap_run(NULL, NULL);
   draw_tap_listeners(TRUE);
 
   return 0;
@@ -681,6 +816,16 @@ sharkd_retap(void)
 
 int
 sharkd_filter(const char *dftext, guint8 **result)
+{
+  return sharkd_filter_masked(dftext, NULL, result);
+}
+
+/*
+ * Like sharkd_filter(), but only the frames whose bits are set in mask,
+ * if it's not NULL, are tested; the others don't match.
+ */
+int
+sharkd_filter_masked(const char *dftext, const guint8 *mask, guint8 **result)
 {
   dfilter_t  *dfcode = NULL;
 
@@ -703,7 +848,7 @@ sharkd_filter(const char *dftext, guint8 **result)
 
   /* if dfilter_compile() success, but (dfcode == NULL) all frames are matching */
   if (dfcode == NULL) {
-    *result = NULL;
+    *result = mask ? (guint8 *) g_memdup2(mask, 2 + (cfile.count / 8)) : NULL;
     return 0;
   }
 
@@ -724,6 +869,9 @@ sharkd_filter(const char *dftext, guint8 **result)
       passed_bits = 0;
     }
 
+    if (mask && !(mask[framenum / 8] & (1 << (framenum % 8))))
+      continue;
+
     if (!wtap_seek_read(cfile.provider.wth, fdata->file_off, &rec, &buf, &err, &err_info))
       break;
 
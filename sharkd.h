@@ -25,23 +25,44 @@
 #define SHARKD_MODE_GOLD_CONSOLE       3
 #define SHARKD_MODE_GOLD_DAEMON        4
 
+/* How often, in microseconds, long operations report their progress. */
+#define SHARKD_PROGRESS_INTERVAL       G_GINT64_CONSTANT(500000)
+
+typedef void (*sharkd_progress_func_t)(guint32 done, guint32 total, void *data);
+
+/* What the frames of the capture file were found to contain when it was loaded. */
+typedef struct {
+	guint64 bytes;            /* the sum of their lengths */
+	gboolean have_times;
+	nstime_t first_time;      /* the earliest and latest of their times */
+	nstime_t last_time;
+	GArray *protocols;        /* the ids of their protocols, as guint, in the order they were first seen */
+	GHashTable *protocols_set;
+} sharkd_load_stats_t;
+
 typedef void (*sharkd_dissect_func_t)(epan_dissect_t *edt, proto_tree *tree, struct epan_column_info *cinfo, const GSList *data_src, void *data);
 
 /* sharkd.c */
 cf_status_t sharkd_cf_open(const char *fname, unsigned int type, gboolean is_tempfile, int *err);
 int sharkd_load_cap_file(void);
+int sharkd_reopen_cap_file(void);
 int sharkd_retap(void);
+int sharkd_retap_run(sharkd_progress_func_t progress_cb, void *data);
 int sharkd_filter(const char *dftext, guint8 **result);
+int sharkd_filter_masked(const char *dftext, const guint8 *mask, guint8 **result);
 frame_data *sharkd_get_frame(guint32 framenum);
 int sharkd_dissect_columns(frame_data *fdata, guint32 frame_ref_num, guint32 prev_dis_num, column_info *cinfo, gboolean dissect_color);
 int sharkd_dissect_request(guint32 framenum, guint32 frame_ref_num, guint32 prev_dis_num, sharkd_dissect_func_t cb, guint32 dissect_flags, void *data);
 const char *sharkd_get_user_comment(const frame_data *fd);
 int sharkd_set_user_comment(frame_data *fd, const gchar *new_comment);
+const sharkd_load_stats_t *sharkd_get_load_stats(void);
+void sharkd_invalidate_load_stats(void);
 const char *sharkd_version(void);
 
 /* sharkd_daemon.c */
 int sharkd_init(int argc, char **argv);
 int sharkd_loop(int argc _U_, char* argv[] _U_);
+gboolean sharkd_is_shared_capture(const char *fname);
 
 /* sharkd_session.c */
 int sharkd_session_main(int mode_setting);
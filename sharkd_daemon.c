@@ -48,7 +48,10 @@
 
 #include <wsutil/strtoi.h>
 #include <version_info.h>
+#include <epan/exceptions.h>
+#include <wiretap/wtap.h>
 
+#include "globals.h"
 #include "sharkd.h"
 
 #ifdef _WIN32
@@ -62,6 +65,14 @@
 static int mode = 0;
 static socket_handle_t _server_fd = INVALID_SOCKET;
 
+/*
+ * A capture file the daemon loads before it accepts any connections;
+ * the session processes it forks start with it loaded, and share its
+ * frame data, conversations and other state copy-on-write, rather than
+ * each reading and dissecting it again.
+ */
+static char *shared_capture = NULL;
+
 static socket_handle_t
 socket_init(char *path)
 {
@@ -192,11 +203,19 @@ print_usage(FILE* output)
 	fprintf(output, "  -v, --version            show version information\n");
 	fprintf(output, "  -C <config profile>, --config-profile <config profile>\n");
 	fprintf(output, "                           start with specified configuration profile\n");
+#ifndef _WIN32
+	fprintf(output, "  -s <capture file>, --shared-capture <capture file>\n");
+	fprintf(output, "                           with -a, load the capture file once, and start\n");
+	fprintf(output, "                           every session with it loaded\n");
+#endif
 
 	fprintf(output, "\n");
 	fprintf(output, "  Examples:\n");
 	fprintf(output, "    sharkd -C myprofile\n");
 	fprintf(output, "    sharkd -a tcp:127.0.0.1:4446 -C myprofile\n");
+#ifndef _WIN32
+	fprintf(output, "    sharkd -a unix:/tmp/sharkd.sock -s big.pcapng\n");
+#endif
 
 	fprintf(output, "\n");
 	fprintf(output, "See the sharkd page of the Wireshark wiki for full details.\n");
@@ -226,7 +245,7 @@ sharkd_init(int argc, char **argv)
 	 * platform-dependent.
 	 */
 
-#define OPTSTRING "+" "a:hmvC:"
+#define OPTSTRING "+" "a:hms:vC:"
 
 	static const char    optstring[] = OPTSTRING;
 
@@ -236,6 +255,7 @@ sharkd_init(int argc, char **argv)
 	  {"help", no_argument, NULL, 'h'},
 	  {"version", no_argument, NULL, 'v'},
 	  {"config-profile", required_argument, NULL, 'C'},
+	  {"shared-capture", required_argument, NULL, 's'},
 	  {0, 0, 0, 0 }
 	};
 
@@ -330,6 +350,17 @@ sharkd_init(int argc, char **argv)
 				mode = SHARKD_MODE_GOLD_CONSOLE;
 				break;
 
+			case 's':
+#ifdef _WIN32
+				/* Sessions are new processes, not fork()ed copies of this one. */
+				fprintf(stderr, "--shared-capture is not supported on Windows\n");
+				return -1;
+#else
+				g_free(shared_capture);
+				shared_capture = g_strdup(optarg);
+				break;
+#endif
+
 			case 'v':         /* Show version and exit */
 				show_version();
 				exit(0);
@@ -345,6 +376,12 @@ sharkd_init(int argc, char **argv)
 		} while (opt != -1);
 	}
 
+	if (shared_capture != NULL && mode != SHARKD_MODE_GOLD_DAEMON)
+	{
+		fprintf(stderr, "--shared-capture can only be used with -a\n");
+		return -1;
+	}
+
 	if (mode == SHARKD_MODE_CLASSIC_DAEMON || mode == SHARKD_MODE_GOLD_DAEMON)
 	{
 		/* all good - try to daemonize */
@@ -376,6 +413,30 @@ sharkd_loop(int argc _U_, char* argv[])
 		return sharkd_session_main(mode);
 	}
 
+	if (shared_capture != NULL)
+	{
+		int err = 0;
+
+		fprintf(stderr, "load: filename=%s\n", shared_capture);
+
+		if (sharkd_cf_open(shared_capture, WTAP_TYPE_AUTO, FALSE, &err) != CF_OK)
+			return -1;
+
+		TRY
+		{
+			err = sharkd_load_cap_file();
+		}
+		CATCH(OutOfMemoryError)
+		{
+			fprintf(stderr, "load: OutOfMemoryError\n");
+			err = ENOMEM;
+		}
+		ENDTRY;
+
+		if (err != 0)
+			return -1;
+	}
+
 	while (1)
 	{
 #ifndef _WIN32
@@ -406,6 +467,19 @@ sharkd_loop(int argc _U_, char* argv[])
 			dup2(fd, 1);
 			close(fd);
 
+			if (shared_capture != NULL)
+			{
+				/* The file descriptor, and so its offset, is shared with
+				   the other sessions; get one of our own. */
+				int err = sharkd_reopen_cap_file();
+
+				if (err != 0)
+				{
+					fprintf(stderr, "cannot reopen %s: %s\n", shared_capture, g_strerror(err));
+					exit(1);
+				}
+			}
+
 			exit(sharkd_session_main(mode));
 		}
 
@@ -474,6 +548,13 @@ sharkd_loop(int argc _U_, char* argv[])
 	return 0;
 }
 
+gboolean
+sharkd_is_shared_capture(const char *fname)
+{
+	return shared_capture != NULL && cfile.filename != NULL &&
+	    strcmp(fname, shared_capture) == 0 && strcmp(cfile.filename, shared_capture) == 0;
+}
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
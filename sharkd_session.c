@@ -24,6 +24,7 @@
 
 #include <file.h>
 #include <epan/epan_dissect.h>
+#include <epan/packet.h>
 #include <epan/exceptions.h>
 #include <epan/color_filters.h>
 #include <epan/prefs.h>
@@ -38,6 +39,7 @@
 #include <ui/io_graph_item.h>
 #include <epan/stats_tree_priv.h>
 #include <epan/stat_tap_ui.h>
+#include <epan/tap.h>
 #include <epan/conversation_table.h>
 #include <epan/sequence_analysis.h>
 #include <epan/expert.h>
@@ -65,6 +67,7 @@
 
 #include <epan/maxmind_db.h>
 
+#include <wsutil/glib-compat.h>
 #include <wsutil/pint.h>
 #include <wsutil/strtoi.h>
 
@@ -75,10 +78,26 @@
 struct sharkd_filter_item
 {
 	guint8 *filtered; /* can be NULL if all frames are matching for given filter. */
+	GArray *rows;     /* numbers of the matching frames, made when first needed for paging */
+	GList *lru_link;  /* in filter_lru */
 };
 
 static GHashTable *filter_table = NULL;
 
+/*
+ * The results of the filters a session has used, most recently used
+ * first, so that dashboards sending the same few filters over and over
+ * don't run each one over every frame again.  They're thrown away when
+ * a file is loaded or a preference is changed (which can change what
+ * dissectors do, and so what filters match), and the least recently
+ * used are thrown away when there are too many.
+ */
+#define SHARKD_FILTER_CACHE_MAX 32
+
+static GQueue filter_lru = G_QUEUE_INIT;   /* filter texts */
+static guint32 filter_cache_hits = 0;
+static guint32 filter_cache_misses = 0;
+
 static int mode;
 gboolean extended_log = FALSE;
 
@@ -188,33 +207,287 @@ sharkd_session_filter_free(gpointer data)
 	struct sharkd_filter_item *l = (struct sharkd_filter_item *) data;
 
 	g_free(l->filtered);
+	if (l->rows)
+		g_array_free(l->rows, TRUE);
 	g_free(l);
 }
 
-static const struct sharkd_filter_item *
-sharkd_session_filter_data(const char *filter)
+static struct sharkd_filter_item *
+sharkd_session_filter_cached(const char *filter)
 {
 	struct sharkd_filter_item *l;
 
 	l = (struct sharkd_filter_item *) g_hash_table_lookup(filter_table, filter);
-	if (!l)
+	if (l)
+	{
+		/* most recently used */
+		g_queue_unlink(&filter_lru, l->lru_link);
+		g_queue_push_head_link(&filter_lru, l->lru_link);
+	}
+
+	return l;
+}
+
+static void
+sharkd_session_filter_cache_clear(void)
+{
+	g_hash_table_remove_all(filter_table);
+	g_queue_foreach(&filter_lru, (GFunc) g_free, NULL);
+	g_queue_clear(&filter_lru);
+}
+
+/*
+ * Split a filter at the "and"s, or "&&"s, that aren't in parentheses,
+ * brackets, braces or strings.  "and" has the lowest precedence of the
+ * display filter operators, so the filter matches the frames that all
+ * the parts match.
+ *
+ * Returns NULL if there's only one part.
+ */
+static GPtrArray *
+sharkd_session_filter_split(const char *filter)
+{
+	GPtrArray *parts = g_ptr_array_new_with_free_func(g_free);
+	const char *start = filter;
+	const char *p;
+	int depth = 0;
+
+	for (p = filter; *p; )
+	{
+		size_t op_len = 0;
+
+		if (*p == '"')
+		{
+			for (p++; *p && *p != '"'; p++)
+			{
+				if (*p == '\\' && p[1])
+					p++;
+			}
+			if (*p)
+				p++;
+			continue;
+		}
+
+		if (*p == '(' || *p == '[' || *p == '{')
+			depth++;
+		else if ((*p == ')' || *p == ']' || *p == '}') && depth > 0)
+			depth--;
+		else if (depth == 0)
+		{
+			if (p[0] == '&' && p[1] == '&')
+				op_len = 2;
+			else if (g_ascii_strncasecmp(p, "and", 3) == 0 &&
+			         (p == filter || !(g_ascii_isalnum(p[-1]) || strchr("_.-:", p[-1]))) &&
+			         !(g_ascii_isalnum(p[3]) || (p[3] && strchr("_.-:", p[3]))))
+				op_len = 3;
+		}
+
+		if (op_len)
+		{
+			g_ptr_array_add(parts, g_strstrip(g_strndup(start, p - start)));
+			p += op_len;
+			start = p;
+			continue;
+		}
+		p++;
+	}
+	g_ptr_array_add(parts, g_strstrip(g_strdup(start)));
+
+	if (parts->len < 2)
+	{
+		g_ptr_array_free(parts, TRUE);
+		return NULL;
+	}
+	return parts;
+}
+
+/*
+ * Run a filter that's "and"s of other filters using the cached results
+ * of any of those that have been run, so that only the frames they all
+ * match have to be tested against the rest.
+ *
+ * Returns -1 if none of the parts have been run.
+ */
+static int
+sharkd_session_filter_and_cached(const char *filter, guint8 **result)
+{
+	GPtrArray *parts;
+	GString *rest;
+	guint8 *mask = NULL;
+	gboolean have_cached = FALSE;
+	guint i;
+	int ret;
+
+	parts = sharkd_session_filter_split(filter);
+	if (!parts)
+		return -1;
+
+	rest = g_string_new(NULL);
+	for (i = 0; i < parts->len; i++)
+	{
+		const char *part = (const char *) g_ptr_array_index(parts, i);
+		struct sharkd_filter_item *l;
+
+		if (*part == '\0')
+			break;
+
+		l = sharkd_session_filter_cached(part);
+		if (!l)
+		{
+			g_string_append_printf(rest, "%s(%s)", rest->len ? " && " : "", part);
+			continue;
+		}
+
+		have_cached = TRUE;
+		if (!l->filtered)
+			continue; /* matches everything */
+
+		if (!mask)
+			mask = (guint8 *) g_memdup2(l->filtered, 2 + (cfile.count / 8));
+		else
+		{
+			guint32 j;
+
+			for (j = 0; j < 2 + (cfile.count / 8); j++)
+				mask[j] &= l->filtered[j];
+		}
+	}
+
+	if (i < parts->len || !have_cached)
+	{
+		/* an empty part makes the filter invalid; let the caller report that */
+		ret = -1;
+		g_free(mask);
+	}
+	else if (rest->len == 0)
+	{
+		*result = mask;
+		ret = 0;
+	}
+	else
+	{
+		ret = sharkd_filter_masked(rest->str, mask, result);
+		g_free(mask);
+	}
+
+	g_string_free(rest, TRUE);
+	g_ptr_array_free(parts, TRUE);
+	return ret;
+}
+
+static struct sharkd_filter_item *
+sharkd_session_filter_data(const char *filter)
+{
+	struct sharkd_filter_item *l;
+
+	l = sharkd_session_filter_cached(filter);
+	if (l)
+	{
+		filter_cache_hits++;
+	}
+	else
 	{
 		guint8 *filtered = NULL;
+		dfilter_t *dfcode = NULL;
+		char *err_msg = NULL;
+		int ret;
 
-		int ret = sharkd_filter(filter, &filtered);
+		if (!dfilter_compile(filter, &dfcode, &err_msg))
+		{
+			g_free(err_msg);
+			return NULL;
+		}
+		dfilter_free(dfcode);
+
+		filter_cache_misses++;
+
+		ret = sharkd_session_filter_and_cached(filter, &filtered);
+		if (ret == -1)
+			ret = sharkd_filter(filter, &filtered);
 
 		if (ret == -1)
 			return NULL;
 
 		l = g_new(struct sharkd_filter_item, 1);
 		l->filtered = filtered;
+		l->rows = NULL;
 
-		g_hash_table_insert(filter_table, g_strdup(filter), l);
+		g_queue_push_head(&filter_lru, g_strdup(filter));
+		l->lru_link = g_queue_peek_head_link(&filter_lru);
+		g_hash_table_insert(filter_table, l->lru_link->data, l);
+
+		while (g_queue_get_length(&filter_lru) > SHARKD_FILTER_CACHE_MAX)
+		{
+			char *oldest = (char *) g_queue_pop_tail(&filter_lru);
+
+			g_hash_table_remove(filter_table, oldest);
+			g_free(oldest);
+		}
 	}
 
 	return l;
 }
 
+/*
+ * Find the first frame of a page of the frames that match a filter, and
+ * the last matching frame before it; each row of the page is a frame
+ * after the cursor frame, and the first skip rows are skipped.  The
+ * list of matching frames is kept with the filter, so that getting the
+ * next page doesn't mean going through the frames before it again.
+ *
+ * Returns FALSE if there are no frames in the page.
+ */
+static gboolean
+sharkd_session_filter_page(struct sharkd_filter_item *l, guint32 cursor, guint32 skip,
+		guint32 *first_frame, guint32 *prev_frame)
+{
+	guint32 lo, hi, row;
+
+	if (!l || !l->filtered)
+	{
+		guint64 first = (guint64) cursor + skip + 1;
+
+		if (first > cfile.count)
+			return FALSE;
+		*first_frame = (guint32) first;
+		*prev_frame = (guint32) first - 1;
+		return TRUE;
+	}
+
+	if (!l->rows)
+	{
+		guint32 framenum;
+
+		l->rows = g_array_new(FALSE, FALSE, sizeof(guint32));
+		for (framenum = 1; framenum <= cfile.count; framenum++)
+		{
+			if (l->filtered[framenum / 8] & (1 << (framenum % 8)))
+				g_array_append_val(l->rows, framenum);
+		}
+	}
+
+	/* the first row after the cursor */
+	lo = 0;
+	hi = l->rows->len;
+	while (lo < hi)
+	{
+		guint32 mid = lo + (hi - lo) / 2;
+
+		if (g_array_index(l->rows, guint32, mid) <= cursor)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (skip >= l->rows->len - lo)
+		return FALSE;
+	row = lo + skip;
+
+	*first_frame = g_array_index(l->rows, guint32, row);
+	*prev_frame = (row != 0) ? g_array_index(l->rows, guint32, row - 1) : 0;
+	return TRUE;
+}
+
 static gboolean
 sharkd_rtp_match_init(rtpstream_id_t *id, const char *init_str)
 {
@@ -526,6 +799,44 @@ sharkd_session_process_info(void)
 	json_dumper_finish(&dumper);
 }
 
+static void
+sharkd_session_write_analyse(void)
+{
+	const sharkd_load_stats_t *stats = sharkd_get_load_stats();
+	guint i;
+
+	sharkd_json_value_anyf("frames", "%u", cfile.count);
+
+	sharkd_json_array_open("protocols");
+	for (i = 0; i < stats->protocols->len; i++)
+		sharkd_json_value_string(NULL, proto_get_protocol_filter_name(g_array_index(stats->protocols, guint, i)));
+	sharkd_json_array_close();
+
+	if (stats->have_times)
+	{
+		sharkd_json_value_anyf("first", "%.9f", nstime_to_sec(&stats->first_time));
+		sharkd_json_value_anyf("last", "%.9f", nstime_to_sec(&stats->last_time));
+	}
+
+	sharkd_json_value_anyf("bytes", "%" G_GUINT64_FORMAT, stats->bytes);
+}
+
+static void
+sharkd_session_load_reply(int err, gboolean analyse)
+{
+	if (err != 0 || !analyse)
+	{
+		sharkd_json_simple_reply(err, NULL);
+		return;
+	}
+
+	json_dumper_begin_object(&dumper);
+	sharkd_json_value_anyf("err", "%d", err);
+	sharkd_session_write_analyse();
+	json_dumper_end_object(&dumper);
+	json_dumper_finish(&dumper);
+}
+
 /**
  * sharkd_session_process_load()
  *
@@ -533,14 +844,19 @@ sharkd_session_process_info(void)
  *
  * Input:
  *   (m) file - file to be loaded
+ *   (o) analyse - if present, also reply with what an analyse request
+ *                 would, which the load gathers anyway
  *
  * Output object with attributes:
  *   (m) err - error code
+ *   (o) frames, protocols, first, last, bytes - for analyse, if the file
+ *                 was loaded; see sharkd_session_process_analyse()
  */
 static void
 sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
 {
 	const char *tok_file = json_find_attr(buf, tokens, count, "file");
+	gboolean analyse = (json_find_attr(buf, tokens, count, "analyse") != NULL);
 	int err = 0;
 
 	if (!tok_file)
@@ -548,6 +864,15 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
 
 	fprintf(stderr, "load: filename=%s\n", tok_file);
 
+	if (sharkd_is_shared_capture(tok_file))
+	{
+		/* The daemon loaded it before starting this session. */
+		sharkd_session_load_reply(0, analyse);
+		return;
+	}
+
+	sharkd_session_filter_cache_clear();
+
 	if (sharkd_cf_open(tok_file, WTAP_TYPE_AUTO, FALSE, &err) != CF_OK)
 	{
 		sharkd_json_simple_reply(err, NULL);
@@ -565,7 +890,7 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
 	}
 	ENDTRY;
 
-	sharkd_json_simple_reply(err, NULL);
+	sharkd_session_load_reply(err, analyse);
 }
 
 /**
@@ -578,6 +903,11 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
  *   (m) duration - time difference between time of first frame, and last loaded frame
  *   (o) filename - capture filename
  *   (o) filesize - capture filesize
+ *   (m) filter_cache - object with attributes:
+ *                  (m) entries - count of filters whose results are kept
+ *                  (m) bytes   - memory used by the kept results
+ *                  (m) hits    - count of filters found in the cache
+ *                  (m) misses  - count of filters which had to be run
  */
 static void
 sharkd_session_process_status(void)
@@ -603,92 +933,57 @@ sharkd_session_process_status(void)
 			sharkd_json_value_anyf("filesize", "%" G_GINT64_FORMAT, file_size);
 	}
 
-	json_dumper_end_object(&dumper);
-	json_dumper_finish(&dumper);
-}
-
-struct sharkd_analyse_data
-{
-	GHashTable *protocols_set;
-	nstime_t *first_time;
-	nstime_t *last_time;
-};
-
-static void
-sharkd_session_process_analyse_cb(epan_dissect_t *edt, proto_tree *tree, struct epan_column_info *cinfo, const GSList *data_src, void *data)
-{
-	struct sharkd_analyse_data *analyser = (struct sharkd_analyse_data *) data;
-	packet_info *pi = &edt->pi;
-	frame_data *fdata = pi->fd;
-
-	(void) tree;
-	(void) cinfo;
-	(void) data_src;
-
-	if (analyser->first_time == NULL || nstime_cmp(&fdata->abs_ts, analyser->first_time) < 0)
-		analyser->first_time = &fdata->abs_ts;
-
-	if (analyser->last_time == NULL || nstime_cmp(&fdata->abs_ts, analyser->last_time) > 0)
-		analyser->last_time = &fdata->abs_ts;
-
-	if (pi->layers)
+	json_dumper_set_member_name(&dumper, "filter_cache");
+	json_dumper_begin_object(&dumper);
 	{
-		wmem_list_frame_t *frame;
+		GHashTableIter iter;
+		gpointer value;
+		guint64 bytes = 0;
 
-		for (frame = wmem_list_head(pi->layers); frame; frame = wmem_list_frame_next(frame))
+		g_hash_table_iter_init(&iter, filter_table);
+		while (g_hash_table_iter_next(&iter, NULL, &value))
 		{
-			int proto_id = GPOINTER_TO_UINT(wmem_list_frame_data(frame));
+			struct sharkd_filter_item *l = (struct sharkd_filter_item *) value;
 
-			if (!g_hash_table_lookup_extended(analyser->protocols_set, GUINT_TO_POINTER(proto_id), NULL, NULL))
-			{
-				g_hash_table_insert(analyser->protocols_set, GUINT_TO_POINTER(proto_id), GUINT_TO_POINTER(proto_id));
-				sharkd_json_value_string(NULL, proto_get_protocol_filter_name(proto_id));
-			}
+			if (l->filtered)
+				bytes += 2 + (cfile.count / 8);
+			if (l->rows)
+				bytes += l->rows->len * sizeof(guint32);
 		}
+
+		sharkd_json_value_anyf("entries", "%u", g_hash_table_size(filter_table));
+		sharkd_json_value_anyf("bytes", "%" G_GUINT64_FORMAT, bytes);
+		sharkd_json_value_anyf("hits", "%u", filter_cache_hits);
+		sharkd_json_value_anyf("misses", "%u", filter_cache_misses);
 	}
+	json_dumper_end_object(&dumper);
 
+	json_dumper_end_object(&dumper);
+	json_dumper_finish(&dumper);
 }
 
 /**
- * sharkd_session_process_status()
+ * sharkd_session_process_analyse()
  *
  * Process analyse request
  *
+ * The results are gathered when the file is loaded; the frames are only
+ * dissected again if the preferences have changed since.
+ *
  * Output object with attributes:
  *   (m) frames  - count of currently loaded frames
  *   (m) protocols - protocol list
  *   (m) first     - earliest frame time
  *   (m) last      - latest frame time
+ *   (m) bytes     - sum of the frame lengths
  */
 static void
 sharkd_session_process_analyse(void)
 {
-	unsigned int framenum;
-	struct sharkd_analyse_data analyser;
-
-	analyser.first_time = NULL;
-	analyser.last_time  = NULL;
-	analyser.protocols_set = g_hash_table_new(NULL /* g_direct_hash() */, NULL /* g_direct_equal */);
-
 	json_dumper_begin_object(&dumper);
-
-	sharkd_json_value_anyf("frames", "%u", cfile.count);
-
-	sharkd_json_array_open("protocols");
-	for (framenum = 1; framenum <= cfile.count; framenum++)
-		sharkd_dissect_request(framenum, (framenum != 1) ? 1 : 0, framenum - 1, &sharkd_session_process_analyse_cb, SHARKD_DISSECT_FLAG_NULL, &analyser);
-	sharkd_json_array_close();
-
-	if (analyser.first_time)
-		sharkd_json_value_anyf("first", "%.9f", nstime_to_sec(analyser.first_time));
-
-	if (analyser.last_time)
-		sharkd_json_value_anyf("last", "%.9f", nstime_to_sec(analyser.last_time));
-
+	sharkd_session_write_analyse();
 	json_dumper_end_object(&dumper);
 	json_dumper_finish(&dumper);
-
-	g_hash_table_destroy(analyser.protocols_set);
 }
 
 static column_info *
@@ -772,10 +1067,14 @@ sharkd_session_create_columns(column_info *cinfo, const char *buf, const jsmntok
  *   (o) column0...columnXX - requested columns either number in range [0..NUM_COL_FMTS), or custom (syntax <dfilter>:<occurence>).
  *                            If column0 is not specified default column set will be used.
  *   (o) filter - filter to be used
+ *   (o) cursor=N - show only frames after frame N, usually the last frame of the previous page
  *   (o) skip=N   - skip N frames
  *   (o) limit=N  - show only N frames
  *   (o) refs  - list (comma separated) with sorted time reference frame numbers.
  *
+ * Pages of frames that match a filter are found without going through the
+ * earlier frames again; see sharkd_session_filter_page().
+ *
  * Output array of frames with attributes:
  *   (m) c   - array of column data
  *   (m) num - frame number
@@ -793,15 +1092,19 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 	const char *tok_skip   = json_find_attr(buf, tokens, count, "skip");
 	const char *tok_limit  = json_find_attr(buf, tokens, count, "limit");
 	const char *tok_refs   = json_find_attr(buf, tokens, count, "refs");
+	const char *tok_cursor = json_find_attr(buf, tokens, count, "cursor");
 
+	struct sharkd_filter_item *filter_item = NULL;
 	const guint8 *filter_data = NULL;
 
 	int col;
 
-	guint32 framenum, prev_dis_num = 0;
+	guint32 framenum, first_frame = 1, prev_dis_num = 0;
 	guint32 current_ref_frame = 0, next_ref_frame = G_MAXUINT32;
+	guint32 cursor;
 	guint32 skip;
 	guint32 limit;
+	gboolean have_frames;
 
 	column_info *cinfo = &cfile.cinfo;
 	column_info user_cinfo;
@@ -816,14 +1119,19 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 
 	if (tok_filter)
 	{
-		const struct sharkd_filter_item *filter_item;
-
 		filter_item = sharkd_session_filter_data(tok_filter);
 		if (!filter_item)
 			return;
 		filter_data = filter_item->filtered;
 	}
 
+	cursor = 0;
+	if (tok_cursor)
+	{
+		if (!ws_strtou32(tok_cursor, NULL, &cursor))
+			return;
+	}
+
 	skip = 0;
 	if (tok_skip)
 	{
@@ -844,8 +1152,10 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 			return;
 	}
 
+	have_frames = sharkd_session_filter_page(filter_item, cursor, skip, &first_frame, &prev_dis_num);
+
 	sharkd_json_array_open(NULL);
-	for (framenum = 1; framenum <= cfile.count; framenum++)
+	for (framenum = first_frame; have_frames && framenum <= cfile.count; framenum++)
 	{
 		frame_data *fdata;
 		guint32 ref_frame = (framenum != 1) ? 1 : 0;
@@ -853,13 +1163,6 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 		if (filter_data && !(filter_data[framenum / 8] & (1 << (framenum % 8))))
 			continue;
 
-		if (skip)
-		{
-			skip--;
-			prev_dis_num = framenum;
-			continue;
-		}
-
 		if (tok_refs)
 		{
 			if (framenum >= next_ref_frame)
@@ -2147,6 +2450,19 @@ sharkd_session_process_tap_rtp_cb(void *arg)
 	json_dumper_end_object(&dumper);
 }
 
+static void
+sharkd_session_progress_cb(guint32 done, guint32 total, void *data _U_)
+{
+	json_dumper_begin_object(&dumper);
+	sharkd_json_value_anyf("progress", "%u", done);
+	sharkd_json_value_anyf("frames", "%u", total);
+	json_dumper_end_object(&dumper);
+	json_dumper_finish(&dumper);
+
+	/* Get it to the client now, not when the reply fills the buffer. */
+	fflush(dumper.output_file);
+}
+
 /**
  * sharkd_session_process_tap()
  *
@@ -2155,6 +2471,11 @@ sharkd_session_process_tap_rtp_cb(void *arg)
  * Input:
  *   (m) tap0         - First tap request
  *   (o) tap1...tap15 - Other tap requests
+ *   (o) progress     - send progress objects while the frames are being tapped
+ *
+ * Output, if progress was given, objects on lines of their own, about twice a second:
+ *   (m) progress - count of frames tapped so far
+ *   (m) frames   - count of frames to tap
  *
  * Output object with attributes:
  *   (m) taps  - array of object with attributes:
@@ -2486,10 +2807,12 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 	if (taps_count == 0)
 		return;
 
+	sharkd_retap_run(json_find_attr(buf, tokens, count, "progress") != NULL ? sharkd_session_progress_cb : NULL, NULL);
+
 	json_dumper_begin_object(&dumper);
 
 	sharkd_json_array_open("taps");
-	sharkd_retap();
+	draw_tap_listeners(TRUE);
 	sharkd_json_array_close();
 
 	sharkd_json_value_anyf("err", "0");
@@ -3431,6 +3754,50 @@ sharkd_session_process_complete_pref_option_cb(pref_t *pref, gpointer d)
 	return 0; /* continue */
 }
 
+static void
+sharkd_session_process_complete_field_cb(gpointer d, gpointer user_data)
+{
+	header_field_info *hfinfo = (header_field_info *) d;
+	const int filter_with_dot = GPOINTER_TO_INT(user_data);
+	protocol_t *protocol;
+
+	if (proto_registrar_is_protocol(hfinfo->id))
+	{
+		protocol = find_protocol_by_id(hfinfo->id);
+		if (!proto_is_protocol_enabled(protocol))
+			return;
+
+		json_dumper_begin_object(&dumper);
+		{
+			sharkd_json_value_string("f", hfinfo->abbrev);
+			sharkd_json_value_anyf("t", "%d", FT_PROTOCOL);
+			sharkd_json_value_string("n", proto_get_protocol_long_name(protocol));
+		}
+		json_dumper_end_object(&dumper);
+		return;
+	}
+
+	if (!filter_with_dot || hfinfo->parent == -1)
+		return;
+
+	protocol = find_protocol_by_id(hfinfo->parent);
+	if (!proto_is_protocol_enabled(protocol))
+		return;
+
+	json_dumper_begin_object(&dumper);
+	{
+		sharkd_json_value_string("f", hfinfo->abbrev);
+
+		/* XXX, skip displaying name, if there are multiple (to not confuse user) */
+		if (hfinfo->same_name_next == NULL)
+		{
+			sharkd_json_value_anyf("t", "%d", hfinfo->type);
+			sharkd_json_value_string("n", hfinfo->name);
+		}
+	}
+	json_dumper_end_object(&dumper);
+}
+
 /**
  * sharkd_session_process_complete()
  *
@@ -3461,65 +3828,10 @@ sharkd_session_process_complete(char *buf, const jsmntok_t *tokens, int count)
 
 	if (tok_field != NULL && tok_field[0])
 	{
-		const size_t filter_length = strlen(tok_field);
 		const int filter_with_dot = !!strchr(tok_field, '.');
 
-		void *proto_cookie;
-		void *field_cookie;
-		int proto_id;
-
 		sharkd_json_array_open("field");
-
-		for (proto_id = proto_get_first_protocol(&proto_cookie); proto_id != -1; proto_id = proto_get_next_protocol(&proto_cookie))
-		{
-			protocol_t *protocol = find_protocol_by_id(proto_id);
-			const char *protocol_filter;
-			const char *protocol_name;
-			header_field_info *hfinfo;
-
-			if (!proto_is_protocol_enabled(protocol))
-				continue;
-
-			protocol_name   = proto_get_protocol_long_name(protocol);
-			protocol_filter = proto_get_protocol_filter_name(proto_id);
-
-			if (strlen(protocol_filter) >= filter_length && !g_ascii_strncasecmp(tok_field, protocol_filter, filter_length))
-			{
-				json_dumper_begin_object(&dumper);
-				{
-					sharkd_json_value_string("f", protocol_filter);
-					sharkd_json_value_anyf("t", "%d", FT_PROTOCOL);
-					sharkd_json_value_string("n", protocol_name);
-				}
-				json_dumper_end_object(&dumper);
-			}
-
-			if (!filter_with_dot)
-				continue;
-
-			for (hfinfo = proto_get_first_protocol_field(proto_id, &field_cookie); hfinfo != NULL; hfinfo = proto_get_next_protocol_field(proto_id, &field_cookie))
-			{
-				if (hfinfo->same_name_prev_id != -1) /* ignore duplicate names */
-					continue;
-
-				if (strlen(hfinfo->abbrev) >= filter_length && !g_ascii_strncasecmp(tok_field, hfinfo->abbrev, filter_length))
-				{
-					json_dumper_begin_object(&dumper);
-					{
-						sharkd_json_value_string("f", hfinfo->abbrev);
-
-						/* XXX, skip displaying name, if there are multiple (to not confuse user) */
-						if (hfinfo->same_name_next == NULL)
-						{
-							sharkd_json_value_anyf("t", "%d", hfinfo->type);
-							sharkd_json_value_string("n", hfinfo->name);
-						}
-					}
-					json_dumper_end_object(&dumper);
-				}
-			}
-		}
-
+		proto_registrar_foreach_prefix(tok_field, sharkd_session_process_complete_field_cb, GINT_TO_POINTER(filter_with_dot));
 		sharkd_json_array_close();
 	}
 
@@ -3621,6 +3933,13 @@ sharkd_session_process_setconf(char *buf, const jsmntok_t *tokens, int count)
 
 	ret = prefs_set_pref(pref, &errmsg);
 
+	/* dissectors may now see the frames differently */
+	if (ret == PREFS_SET_OK)
+	{
+		sharkd_session_filter_cache_clear();
+		sharkd_invalidate_load_stats();
+	}
+
 	sharkd_json_simple_reply(ret, errmsg);
 	g_free(errmsg);
 }
@@ -4020,6 +4339,71 @@ sharkd_session_packet_download_tap_rtp_cb(void *tapdata, packet_info *pinfo, epa
 	return TAP_PACKET_DONT_REDRAW;
 }
 
+/**
+ * sharkd_session_process_profile()
+ *
+ * Process profile request
+ *
+ * Input:
+ *   (o) enable - "1" to start timing the dissectors, "0" to stop
+ *   (o) reset  - "1" to forget the statistics collected so far
+ *
+ * Output object with attributes:
+ *   (m) enabled    - whether the dissectors are being timed
+ *   (m) dissectors - array of objects, by decreasing self time, with attributes:
+ *                  (m) name     - dissector name
+ *                  (o) proto    - protocol short name
+ *                  (o) heur     - present and true for a heuristic dissector
+ *                  (m) calls    - count of calls
+ *                  (m) accepted - count of calls which accepted the packet
+ *                  (m) exceptions - count of calls ended by an exception
+ *                  (m) bytes    - bytes handed to the dissector
+ *                  (m) total    - microseconds in it and the dissectors it called
+ *                  (m) self     - microseconds in it alone
+ */
+static void
+sharkd_session_process_profile(char *buf, const jsmntok_t *tokens, int count)
+{
+	const char *tok_enable = json_find_attr(buf, tokens, count, "enable");
+	const char *tok_reset  = json_find_attr(buf, tokens, count, "reset");
+	GPtrArray *profiles;
+	guint i;
+
+	if (tok_reset && !strcmp(tok_reset, "1"))
+		dissector_profiling_reset();
+	if (tok_enable)
+		dissector_profiling_enable(!strcmp(tok_enable, "1"));
+
+	json_dumper_begin_object(&dumper);
+	sharkd_json_value_anyf("enabled", dissector_profiling_enabled() ? "true" : "false");
+
+	sharkd_json_array_open("dissectors");
+	profiles = dissector_profiling_get();
+	for (i = 0; i < profiles->len; i++)
+	{
+		const dissector_profile_t *profile = (const dissector_profile_t *) g_ptr_array_index(profiles, i);
+
+		json_dumper_begin_object(&dumper);
+		sharkd_json_value_string("name", profile->name);
+		if (profile->protocol)
+			sharkd_json_value_string("proto", profile->protocol);
+		if (profile->heuristic)
+			sharkd_json_value_anyf("heur", "true");
+		sharkd_json_value_anyf("calls", "%" G_GUINT64_FORMAT, profile->calls);
+		sharkd_json_value_anyf("accepted", "%" G_GUINT64_FORMAT, profile->accepted);
+		sharkd_json_value_anyf("exceptions", "%" G_GUINT64_FORMAT, profile->exceptions);
+		sharkd_json_value_anyf("bytes", "%" G_GUINT64_FORMAT, profile->bytes);
+		sharkd_json_value_anyf("total", "%" G_GINT64_FORMAT, profile->total_time);
+		sharkd_json_value_anyf("self", "%" G_GINT64_FORMAT, profile->self_time);
+		json_dumper_end_object(&dumper);
+	}
+	g_ptr_array_free(profiles, TRUE);
+	sharkd_json_array_close();
+
+	json_dumper_end_object(&dumper);
+	json_dumper_finish(&dumper);
+}
+
 /**
  * sharkd_session_process_download()
  *
@@ -4226,6 +4610,8 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
 			sharkd_session_process_dumpconf(buf, tokens, count);
 		else if (!strcmp(tok_req, "download"))
 			sharkd_session_process_download(buf, tokens, count);
+		else if (!strcmp(tok_req, "profile"))
+			sharkd_session_process_profile(buf, tokens, count);
 		else if (!strcmp(tok_req, "bye"))
 			exit(0);
 		else
@@ -4265,7 +4651,8 @@ sharkd_session_main(int mode_setting)
 
 	dumper.output_file = stdout;
 
-	filter_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, sharkd_session_filter_free);
+	/* the keys belong to filter_lru */
+	filter_table = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, sharkd_session_filter_free);
 
 #ifdef HAVE_MAXMINDDB
 	/* mmdbresolve was stopped before fork(), force starting it */
@@ -4307,6 +4694,7 @@ sharkd_session_main(int mode_setting)
 		sharkd_session_process(buf, tokens, ret);
 	}
 
+	sharkd_session_filter_cache_clear();
 	g_hash_table_destroy(filter_table);
 	g_free(tokens);
 
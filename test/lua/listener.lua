@@ -9,6 +9,7 @@ local IP = "ip"
 local DHCP = "dhcp"
 local OTHER = "other"
 local PDISS = "postdissector"
+local BATCH = "batch"
 
 local packet_counts = {}
 local function incPktCount(name)
@@ -35,7 +36,8 @@ end
 -- note ip only runs 3 times because it gets removed
 -- and dhcp only runs twice because the filter makes it run
 -- once and then it gets replaced with a different one for the second time
-local taptests = { [FRAME]=4, [ETH]=4, [IP]=3, [DHCP]=2, [OTHER]=16 }
+-- and batch runs twice because it gets two packets at a time
+local taptests = { [FRAME]=4, [ETH]=4, [IP]=3, [DHCP]=2, [BATCH]=2, [OTHER]=18 }
 local function getResults()
     print("\n-----------------------------\n")
     for k,v in pairs(taptests) do
@@ -169,6 +171,15 @@ local f_dhcp_hw    = Field.new("dhcp.hw.mac_addr")
 local f_dhcp_opt   = Field.new("dhcp.option.type")
 
 local tap_frame = Listener.new(nil,nil,true)
+local tap_batch = Listener.new("eth")
+
+testing(OTHER,"negative batch tests")
+test(OTHER,"Listener.batch-1",not pcall(tap_batch.batch,tap_batch,{ "eth.src" }))
+setPassed(OTHER)
+test(OTHER,"Listener.batch-2",not pcall(tap_batch.batch,tap_batch,{ f_eth_src },0))
+setPassed(OTHER)
+
+tap_batch:batch({ f_eth_src, f_ip_src, f_dhcp_hw }, 2)
 local tap_eth = Listener.new("eth")
 local tap_ip = Listener.new("ip","dhcp")
 local tap_dhcp = Listener.new("dhcp","dhcp.option.dhcp == 1")
@@ -265,6 +276,26 @@ dhcp_packet = function (pinfo,tvb,dhcp)
 end
 tap_dhcp.packet = dhcp_packet
 
+function tap_batch.packet(pinfo,tvb,eth)
+    error("packet called for a batching listener!")
+end
+
+function tap_batch.packets(values,count)
+    incPktCount(BATCH)
+    testing(BATCH,"Batch")
+
+    test(BATCH,"arg-1", type(values) == "table" and #values == 3)
+    test(BATCH,"arg-2", count == 2)
+
+    for i = 1, count do
+        test(BATCH,"value-1", typeof(values[1][i]) == "Address")
+        test(BATCH,"value-2", typeof(values[2][i]) == "Address")
+        test(BATCH,"value-3", typeof(values[3][i]) == "Address")
+    end
+
+    setPassed(BATCH)
+end
+
 function tap_frame.reset()
     -- reset never gets called in tshark (sadly)
     if not GUI_ENABLED then
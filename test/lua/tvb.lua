@@ -54,7 +54,7 @@ end
 --     number of verifyFields() * (1 + number of fields) +
 --     number of verifyResults() * (1 + 2 * number of values)
 --
-local taptests = { [FRAME]=4, [OTHER]=353 }
+local taptests = { [FRAME]=4, [OTHER]=363 }
 
 local function getResults()
     print("\n-----------------------------\n")
@@ -976,6 +976,22 @@ function test_proto.dissector(tvbuf,pktinfo,root)
     execute ("tvbrange_offset_len_raw_offset_len", range_raw == expected,
         string.format('range_raw="%s" expected="%s"', range_raw, expected))
 
+----------------------------------------
+    testing(OTHER, "ByteArray integers")
+
+    local int_bytes = ByteArray.new("01 02 03 04 05 06 07 08 FF FE")
+
+    execute ("bytearray_uint", int_bytes:uint(0) == 0x01020304)
+    execute ("bytearray_uint_len", int_bytes:uint(1, 2) == 0x0203)
+    execute ("bytearray_le_uint", int_bytes:le_uint(0) == 0x04030201)
+    execute ("bytearray_int", int_bytes:int(8, 2) == -2)
+    execute ("bytearray_le_int", int_bytes:le_int(8, 2) == -257)
+    execute ("bytearray_uint64", int_bytes:uint64(0) == UInt64(0x05060708, 0x01020304))
+    execute ("bytearray_le_uint64", int_bytes:le_uint64(0) == UInt64(0x04030201, 0x08070605))
+    execute ("bytearray_int64", int_bytes:int64(8, 2) == Int64(-2))
+    execute ("bytearray_uint_out_of_bounds", not pcall(int_bytes.uint, int_bytes, 8, 4))
+    execute ("bytearray_uint_bad_length", not pcall(int_bytes.uint, int_bytes, 0, 5))
+
 ----------------------------------------
 
     setPassed(FRAME)
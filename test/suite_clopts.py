@@ -157,6 +157,24 @@ class case_tshark_unicode_clopts(subprocesstest.SubprocessTestCase):
         self.assertTrue(self.grepOutput('HEAD.*/v4/iuident.cab'))
 
 
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_tshark_read_capture_filter(subprocesstest.SubprocessTestCase):
+    def test_tshark_read_capfilter_match(self, cmd_tshark, capture_file):
+        '''Capture filter applied to a file that's read'''
+        self.assertRun((cmd_tshark, '-r', capture_file('http.pcap'), '-f', 'tcp port 80'))
+        self.assertTrue(self.grepOutput('HEAD.*/v4/iuident.cab'))
+
+    def test_tshark_read_capfilter_no_match(self, cmd_tshark, capture_file):
+        self.assertRun((cmd_tshark, '-r', capture_file('http.pcap'), '-f', 'udp'))
+        self.assertFalse(self.grepOutput('HEAD.*/v4/iuident.cab'))
+
+    def test_tshark_read_capfilter_invalid(self, cmd_tshark, capture_file):
+        self.assertRun((cmd_tshark, '-r', capture_file('http.pcap'), '-f', 'jkghg'),
+            expected_return=self.exit_error)
+        self.assertTrue(self.grepOutput("isn't a valid capture filter"))
+
+
 @fixtures.uses_fixtures
 class case_tshark_dump_glossaries(subprocesstest.SubprocessTestCase):
     def test_tshark_dump_glossary(self, cmd_tshark, base_env):
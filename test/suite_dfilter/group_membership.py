@@ -58,3 +58,20 @@ class case_membership(unittest.TestCase):
         dfilter = 'frame.number in {1 "foo"}'
         error = '"foo" cannot be converted to Unsigned integer, 4 bytes.'
         checkDFilterFail(dfilter, error)
+
+    def test_membership_12_large_set_match(self, checkDFilterCount):
+        # Sets this large are looked up rather than compared one by one.
+        dfilter = 'tcp.port in {1 2 3 4 5 6 7 8 80}'
+        checkDFilterCount(dfilter, 1)
+
+    def test_membership_13_large_set_no_match(self, checkDFilterCount):
+        dfilter = 'tcp.dstport in {1 2 3 4 5 6 7 8 3267}'
+        checkDFilterCount(dfilter, 0)
+
+    def test_membership_14_large_set_with_range(self, checkDFilterCount):
+        dfilter = 'ip.addr in {1.1.1.1 1.1.1.2 1.1.1.3 1.1.1.4 1.1.1.5 1.1.1.6 1.1.1.7 1.1.1.8 10.0.0.1 .. 10.0.0.9}'
+        checkDFilterCount(dfilter, 1)
+
+    def test_membership_15_large_set_subnet(self, checkDFilterCount):
+        dfilter = 'ip.addr in {1.1.1.1 1.1.1.2 1.1.1.3 1.1.1.4 1.1.1.5 1.1.1.6 1.1.1.7 10.0.0.0/24}'
+        checkDFilterCount(dfilter, 1)
@@ -60,4 +60,57 @@ class case_tvb(unittest.TestCase):
         dfilter = 'http contains "HEAD"'
         checkDFilterCount(dfilter, 1)
 
+    def test_contains_any_1(self, checkDFilterCount):
+        dfilter = 'frame contains any {"XYZZY" "HEAD /v4"}'
+        checkDFilterCount(dfilter, 1)
+
+    def test_contains_any_2(self, checkDFilterCount):
+        dfilter = 'frame contains any {"XYZZY" "PUT /v4"}'
+        checkDFilterCount(dfilter, 0)
+
+    def test_contains_any_3(self, checkDFilterCount):
+        # A single value is looked for as by "contains"
+        dfilter = 'eth contains any { 09:6b:88 }'
+        checkDFilterCount(dfilter, 1)
+
+    def test_contains_any_4(self, checkDFilterCount):
+        dfilter = 'http.request.method contains any {"PUT" "EA" "Z"}'
+        checkDFilterCount(dfilter, 1)
+
+    def test_contains_any_5(self, checkDFilterFail):
+        dfilter = 'frame contains any {"a" .. "b"}'
+        error = "A set for 'contains any' may not contain value ranges."
+        checkDFilterFail(dfilter, error)
+
+
+
+    def test_matches_1(self, checkDFilterCount):
+        # A pattern that is only a literal string
+        dfilter = 'frame matches "HEAD /v4"'
+        checkDFilterCount(dfilter, 1)
 
+    def test_matches_2(self, checkDFilterCount):
+        dfilter = 'frame matches "head /V4"'
+        checkDFilterCount(dfilter, 1)
+
+    def test_matches_3(self, checkDFilterCount):
+        dfilter = 'frame matches "HEAD /v5"'
+        checkDFilterCount(dfilter, 0)
+
+    def test_matches_4(self, checkDFilterCount):
+        # A required literal string and more
+        dfilter = 'frame matches "IUIDENT.cab[?]0307"'
+        checkDFilterCount(dfilter, 1)
+
+    def test_matches_5(self, checkDFilterCount):
+        dfilter = 'frame matches "(get|head) /v4"'
+        checkDFilterCount(dfilter, 1)
+
+    def test_matches_6(self, checkDFilterCount):
+        # The character before "?" isn't required
+        dfilter = 'frame matches "HEADX? /v4"'
+        checkDFilterCount(dfilter, 1)
+
+    def test_matches_7(self, checkDFilterCount):
+        dfilter = 'frame matches "XYZZY|PUT /v4"'
+        checkDFilterCount(dfilter, 0)
@@ -93,3 +93,16 @@ class case_outputformats(subprocesstest.SubprocessTestCase):
         ''' Check that the option -j works with -Tek.'''
         check_outputformat("ek", extra_args=['-j', 'dhcp'], expected="dhcp-filter.ek",
             multiline=True)
+
+    def test_outputformat_arrow(self, cmd_tshark, capture_file):
+        '''Checks that -Tarrow writes the fields as an Arrow IPC stream.'''
+        arrow_file = self.filename_from_id('dhcp.arrow')
+        self.assertRun('{} -r {} -T arrow -e frame.number -e ip.src -e frame.time > {}'.format(
+            cmd_tshark, capture_file('dhcp.pcap'), arrow_file), shell=True)
+        with open(arrow_file, 'rb') as f:
+            stream = f.read()
+        # A schema message, a record batch message and the end of the stream
+        self.assertEqual(stream[:4], b'\xff\xff\xff\xff')
+        self.assertEqual(stream.count(b'\xff\xff\xff\xff'), 3)
+        self.assertEqual(stream[-8:], b'\xff\xff\xff\xff\x00\x00\x00\x00')
+        self.assertIn(b'ip.src\0', stream)
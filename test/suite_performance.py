@@ -0,0 +1,222 @@
+#
+# Wireshark tests
+# By Gerald Combs <gerald@wireshark.org>
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+'''Performance tests
+
+Each test measures a metric on the same reference capture and checks the
+result of the run, not its speed. The metrics are written as JSON to the
+file named by WS_PERFORMANCE_RESULTS, or to performance-results.json in
+the current directory. If WS_PERFORMANCE_BASELINE names such a file from
+an earlier run, a test fails if its metric is more than
+WS_PERFORMANCE_TOLERANCE percent (25 by default) worse than there.
+'''
+
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+import unittest
+import subprocesstest
+import fixtures
+
+# Version of the format of the results file; bump it if the meaning of
+# an existing metric changes.
+results_format = 1
+
+# Reference captures, concatenated reference_repeat times into the capture
+# that is measured, so that there is enough to measure.
+reference_captures = (
+    'http.pcap',
+    'dhcp.pcap',
+    'dns_port.pcap',
+    'sip.pcapng',
+    'tls12-chacha20poly1305.pcap',
+    'http2-data-reassembly.pcap',
+    'segmented_fpm.pcap',
+    'tcp-badsegments.pcap',
+)
+reference_repeat = 40
+
+# The canonical display filters; each gets a metric of its own.
+canonical_filters = (
+    'tcp',
+    'ip.addr == 192.168.0.1',
+    'frame.len > 1000',
+    'tcp.port == 80 && tcp.len > 0',
+    'http or tls or http2',
+    'dns.qry.name contains "example"',
+    'udp && !dns',
+)
+
+# Runs a program given as arguments, with this script's standard input,
+# and prints the peak resident set size of the program in KiB.
+peak_rss_script = '''
+import resource, subprocess, sys
+subprocess.run(sys.argv[1:], stdin=sys.stdin, stdout=subprocess.DEVNULL, check=True)
+rss = resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss
+print(rss // 1024 if sys.platform == 'darwin' else rss)
+'''
+
+
+@fixtures.fixture(scope='session')
+def cmd_sharkd(program):
+    return program('sharkd')
+
+
+@fixtures.fixture(scope='session')
+def perf_capture(cmd_mergecap, capture_file, make_env):
+    '''The path of the capture that is measured.'''
+    with tempfile.TemporaryDirectory(prefix='wireshark-tests-perf-') as dirname:
+        path = os.path.join(dirname, 'reference.pcapng')
+        inputs = [capture_file(name) for name in reference_captures] * reference_repeat
+        subprocess.run([cmd_mergecap, '-a', '-F', 'pcapng', '-w', path] + inputs,
+            env=make_env(), check=True, stdout=subprocess.DEVNULL)
+        yield path
+
+
+@fixtures.fixture(scope='session')
+def perf_packets(cmd_tshark, perf_capture, make_env):
+    '''The number of packets in the capture that is measured.'''
+    proc = subprocess.run([cmd_tshark, '-r', perf_capture, '-T', 'fields', '-e', 'frame.number'],
+        env=make_env(), check=True, stdout=subprocess.PIPE)
+    return len(proc.stdout.splitlines())
+
+
+@fixtures.fixture(scope='session')
+def perf_metrics():
+    '''Collects the metrics of the session and writes them out at its end.'''
+    metrics = {}
+    yield metrics
+    results_path = os.environ.get('WS_PERFORMANCE_RESULTS', 'performance-results.json')
+    # Merge with the results of other test runs of the same session.
+    try:
+        with open(results_path) as f:
+            results = json.load(f)
+        if results.get('format') != results_format:
+            results = {}
+    except (OSError, ValueError):
+        results = {}
+    results['format'] = results_format
+    results.setdefault('metrics', {}).update(metrics)
+    with open(results_path, 'w') as f:
+        json.dump(results, f, indent=2, sort_keys=True)
+        f.write('\n')
+
+
+@fixtures.fixture(scope='session')
+def perf_baseline():
+    '''The metrics of the baseline run, if any.'''
+    baseline_path = os.environ.get('WS_PERFORMANCE_BASELINE')
+    if not baseline_path:
+        return {}
+    with open(baseline_path) as f:
+        baseline = json.load(f)
+    if baseline.get('format') != results_format:
+        return {}
+    return baseline.get('metrics', {})
+
+
+@fixtures.fixture
+def record_metric(perf_metrics, perf_baseline, request):
+    self = request.instance
+
+    def record_metric_real(name, value, unit, higher_is_better):
+        '''Record a metric and compare it with the baseline.'''
+        perf_metrics[name] = {
+            'value': value,
+            'unit': unit,
+            'better': 'higher' if higher_is_better else 'lower',
+        }
+        self.log_fd.write('-- Metric {}: {} {} --\n'.format(name, value, unit))
+        baseline = perf_baseline.get(name)
+        if not baseline or baseline.get('unit') != unit or not baseline.get('value'):
+            return
+        tolerance = float(os.environ.get('WS_PERFORMANCE_TOLERANCE', '25')) / 100
+        if higher_is_better:
+            limit = baseline['value'] * (1 - tolerance)
+            self.assertGreaterEqual(value, limit,
+                '{} regressed from {} {}'.format(name, baseline['value'], unit))
+        else:
+            limit = baseline['value'] * (1 + tolerance)
+            self.assertLessEqual(value, limit,
+                '{} regressed from {} {}'.format(name, baseline['value'], unit))
+    return record_metric_real
+
+
+@fixtures.fixture
+def timed_run(request):
+    self = request.instance
+
+    def timed_run_real(args, stdin=None):
+        '''Run a program, check that it succeeds, and return the process
+        and the number of seconds it took.'''
+        start = time.perf_counter()
+        proc = self.startProcess(args, stdin=subprocess.PIPE if stdin else None, max_lines=5)
+        if stdin:
+            proc.stdin.write(stdin.encode('utf8'))
+        self.waitProcess(proc)
+        elapsed = time.perf_counter() - start
+        self.assertEqual(proc.returncode, 0)
+        return proc, elapsed
+    return timed_run_real
+
+
+def sharkd_load_commands(path):
+    return '\n'.join(json.dumps(req) for req in (
+        {"req": "load", "file": path},
+        {"req": "status"},
+    ))
+
+
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_performance(subprocesstest.SubprocessTestCase):
+    def test_tshark_single_pass(self, cmd_tshark, perf_capture, perf_packets, timed_run, record_metric):
+        '''Packets per second dissected by TShark in one pass.'''
+        proc, elapsed = timed_run((cmd_tshark, '-r', perf_capture))
+        self.assertEqual(len(proc.stdout_str.splitlines()), perf_packets)
+        record_metric('tshark_single_pass', round(perf_packets / elapsed, 1), 'packets/s', True)
+
+    def test_tshark_two_pass(self, cmd_tshark, perf_capture, perf_packets, timed_run, record_metric):
+        '''Time taken by TShark to dissect in two passes.'''
+        proc, elapsed = timed_run((cmd_tshark, '-2', '-r', perf_capture))
+        self.assertEqual(len(proc.stdout_str.splitlines()), perf_packets)
+        record_metric('tshark_two_pass', round(elapsed, 3), 's', False)
+
+    def test_tshark_filters(self, cmd_tshark, perf_capture, timed_run, record_metric):
+        '''Time taken by TShark to apply each canonical display filter.'''
+        total = 0
+        for dfilter in canonical_filters:
+            proc, elapsed = timed_run((cmd_tshark, '-r', perf_capture, '-Y', dfilter))
+            total += elapsed
+            record_metric('tshark_filter {}'.format(dfilter), round(elapsed, 3), 's', False)
+        record_metric('tshark_filters', round(total, 3), 's', False)
+
+    def test_tshark_ek(self, cmd_tshark, perf_capture, perf_packets, timed_run, record_metric):
+        '''Packets per second written by TShark as Elasticsearch JSON.'''
+        proc, elapsed = timed_run((cmd_tshark, '-r', perf_capture, '-T', 'ek'))
+        # An index line and a document line per packet
+        self.assertEqual(len(proc.stdout_str.splitlines()), 2 * perf_packets)
+        record_metric('tshark_ek', round(perf_packets / elapsed, 1), 'packets/s', True)
+
+    @unittest.skipIf(sys.platform.startswith('win32'), 'Requires getrusage()')
+    def test_sharkd_peak_rss(self, cmd_sharkd, perf_capture, timed_run, record_metric):
+        '''Peak memory used by sharkd to open the capture, as the GUI does.'''
+        proc, elapsed = timed_run((sys.executable, '-c', peak_rss_script, cmd_sharkd, '-'),
+            stdin=sharkd_load_commands(perf_capture))
+        record_metric('sharkd_peak_rss', int(proc.stdout_str.strip()), 'KiB', False)
+
+    def test_sharkd_load(self, cmd_sharkd, perf_capture, perf_packets, timed_run, record_metric):
+        '''Time taken by sharkd to load the capture.'''
+        # Time a session that just starts, and subtract it.
+        proc, startup = timed_run((cmd_sharkd, '-'), stdin=json.dumps({"req": "status"}))
+        proc, elapsed = timed_run((cmd_sharkd, '-'), stdin=sharkd_load_commands(perf_capture))
+        outputs = [json.loads(line) for line in proc.stdout_str.splitlines() if line.strip()]
+        self.assertEqual(outputs[0], {"err": 0})
+        self.assertEqual(outputs[1]['frames'], perf_packets)
+        record_metric('sharkd_load', round(max(elapsed - startup, 0), 3), 's', False)
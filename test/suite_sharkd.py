@@ -92,7 +92,17 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
         ), (
             {"err": 0},
             {"frames": 4, "protocols": ["frame", "eth", "ethertype", "ip", "udp",
-                                        "dhcp"], "first": 1102274184.317452908, "last": 1102274184.387798071},
+                                        "dhcp"], "first": 1102274184.317452908, "last": 1102274184.387798071,
+                "bytes": 1312},
+        ))
+
+    def test_sharkd_req_load_analyse(self, check_sharkd_session, capture_file):
+        check_sharkd_session((
+            {"req": "load", "file": capture_file('dhcp.pcap'), "analyse": "1"},
+        ), (
+            {"err": 0, "frames": 4, "protocols": ["frame", "eth", "ethertype", "ip", "udp",
+                                                  "dhcp"], "first": 1102274184.317452908, "last": 1102274184.387798071,
+                "bytes": 1312},
         ))
 
     def test_sharkd_req_info(self, check_sharkd_session):
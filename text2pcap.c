@@ -238,6 +238,8 @@ static FILE       *input_file  = NULL;
 static char *output_filename;
 static FILE       *output_file = NULL;
 
+#define OUTPUT_BUFFER_SIZE  (1024*1024)
+
 /* Offset base to parse */
 static guint32 offset_base = 16;
 
@@ -1354,6 +1356,67 @@ fail_null_str:
     return EXIT_FAILURE;
 }
 
+/*----------------------------------------------------------------------
+ * Get the value of a character known to be a hex digit
+ */
+static inline guint8
+hex_digit_value (char c)
+{
+    return (guint8)(c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+}
+
+/*----------------------------------------------------------------------
+ * Parse a line made up of an offset and hex bytes only (called from the
+ * scanner), as parse_token() would parse its tokens, but converting and
+ * storing the bytes directly rather than one token at a time
+ */
+int
+parse_hex_line (char *str)
+{
+    char    *p;
+    char     saved;
+    char     byte_str[3];
+
+    /* The offset token is the offset and the character after it. */
+    for (p = str; g_ascii_isxdigit(*p); p++)
+        ;
+    p++;
+    saved = *p;
+    *p = '\0';
+    if (parse_token(T_OFFSET, str) != EXIT_SUCCESS)
+        return EXIT_FAILURE;
+    *p = saved;
+
+    if (state == READ_OFFSET && debug < 2) {
+        /* Record the bytes */
+        state = READ_BYTE;
+        for (; *p != '\r' && *p != '\n'; p++) {
+            if (*p == ' ' || *p == '\t')
+                continue;
+            packet_buf[curr_offset] = (hex_digit_value(p[0]) << 4) | hex_digit_value(p[1]);
+            curr_offset++;
+            if (curr_offset - header_length >= max_offset) /* packet full */
+                if (start_new_packet(TRUE) != EXIT_SUCCESS)
+                    return EXIT_FAILURE;
+            p++;
+        }
+    } else {
+        /* The bytes aren't recorded, or the tokens are being traced */
+        byte_str[2] = '\0';
+        for (; *p != '\r' && *p != '\n'; p++) {
+            if (*p == ' ' || *p == '\t')
+                continue;
+            byte_str[0] = p[0];
+            byte_str[1] = p[1];
+            if (parse_token(T_BYTE, byte_str) != EXIT_SUCCESS)
+                return EXIT_FAILURE;
+            p++;
+        }
+    }
+
+    return parse_token(T_EOL, NULL);
+}
+
 /*----------------------------------------------------------------------
  * Print usage string and exit
  */
@@ -1777,6 +1840,9 @@ parse_options (int argc, char *argv[])
         output_file = stdout;
     }
 
+    /* Write the packets out in large chunks, rather than a few at a time. */
+    setvbuf(output_file, NULL, _IOFBF, OUTPUT_BUFFER_SIZE);
+
     /* Some validation */
     if (pcap_link_type != 1 && hdr_ethernet) {
         fprintf(stderr, "Dummy headers (-e, -i, -u, -s, -S -T) cannot be specified with link type override (-l)\n");
@@ -1926,7 +1992,12 @@ clean_exit:
         fclose(input_file);
     }
     if (output_file) {
-        fclose(output_file);
+        /* This is where most of the last packets get written. */
+        if (fclose(output_file) == EOF && ret == EXIT_SUCCESS) {
+            fprintf(stderr, "File write error [%s] : %s\n",
+                    output_filename, g_strerror(errno));
+            ret = EXIT_FAILURE;
+        }
     }
     return ret;
 }
@@ -27,6 +27,8 @@ typedef enum {
 
 int parse_token(token_t token, char *str);
 
+int parse_hex_line(char *str);
+
 int text2pcap_scan(void);
 
 #endif
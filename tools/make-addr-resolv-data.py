@@ -0,0 +1,253 @@
+#!/usr/bin/env python3
+#
+# make-addr-resolv-data.py
+#
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+# Copyright 1998 Gerald Combs
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+
+'''\
+Compiles the "manuf", "services" and "enterprises.tsv" files into a C
+source with the sorted tables declared in epan/addr_resolv_data.h, so
+that libwireshark does not have to parse them each time it starts.
+
+Usage: make-addr-resolv-data.py <manuf> <services> <enterprises.tsv> <output.c>
+
+The files are read the way epan/addr_resolv.c read them: later entries
+for the same key replace earlier ones, and lines that it would have
+ignored are ignored.
+'''
+
+import re
+import sys
+
+
+def strtok_split(s, delims):
+    '''Split off the first token of s like strtok(3); returns the token
+    (or None) and the rest of s after the delimiter that ended it.'''
+    s = s.lstrip(delims)
+    if not s:
+        return None, ''
+    m = re.search('[' + re.escape(delims) + ']', s)
+    if not m:
+        return s, ''
+    return s[:m.start()], s[m.end():]
+
+
+def parse_ether_address(cp):
+    '''Parse an address as parse_ether_address() in addr_resolv.c does,
+    with masks accepted. Returns (address, mask) or None; the mask is 0
+    for a manufacturer ID and 48 for a complete address.'''
+    m = re.fullmatch(r'([0-9A-Fa-f]{1,2}(?:([:.-])[0-9A-Fa-f]{1,2})*)(?:/([0-9]+))?', cp)
+    if not m:
+        return None
+    sep = m.group(2)
+    octets = [int(o, 16) for o in (m.group(1).split(sep) if sep else [m.group(1)])]
+    if len(octets) > 6:
+        return None
+    addr = octets + [0] * (6 - len(octets))
+    if m.group(3) is not None:
+        mask = int(m.group(3))
+        if mask == 0 or mask >= 48:
+            return None
+        for i in range(6):
+            bits = min(max(mask - 8 * i, 0), 8)
+            addr[i] &= (0xFF << (8 - bits)) & 0xFF
+        return bytes(addr), mask
+    if len(octets) == 3:
+        return bytes(addr), 0
+    if len(octets) == 6:
+        return bytes(addr), 48
+    return None
+
+
+def read_lines(path):
+    with open(path, 'rb') as f:
+        for line in f:
+            yield line.decode('utf8', 'surrogateescape').rstrip('\r\n')
+
+
+def parse_manuf(path):
+    manuf = {}
+    wka = {}
+    for line in read_lines(path):
+        line = line.strip()
+        if not line or line.startswith('#'):
+            continue
+        line = line.split('#', 1)[0].rstrip()
+        cp, rest = strtok_split(line, ' \t')
+        if cp is None:
+            continue
+        parsed = parse_ether_address(cp)
+        if parsed is None:
+            continue
+        addr, mask = parsed
+        name, rest = strtok_split(rest, ' \t')
+        if name is None:
+            continue
+        longname, rest = strtok_split(rest, '\t')
+        if longname is None:
+            longname = name
+        if mask == 0:
+            manuf[(addr[0] << 16) | (addr[1] << 8) | addr[2]] = (name, longname)
+        elif mask == 48:
+            sys.exit('{}: {}: complete addresses belong in the "wka" file'.format(path, cp))
+        else:
+            wka[addr] = name
+    return manuf, wka
+
+
+def parse_port_range(spec):
+    '''Parse the ports of a services entry as range_convert_str() does,
+    without its error checking, since the file is ours.'''
+    ports = []
+    for part in spec.split(','):
+        part = part.strip()
+        if not part:
+            continue
+        if '-' in part:
+            low, high = part.split('-', 1)
+            low = int(low) if low.strip() else 0
+            high = int(high) if high.strip() else 65535
+        else:
+            low = high = int(part)
+        if low > high or high > 65535:
+            raise ValueError(spec)
+        ports.extend(range(low, high + 1))
+    return ports
+
+
+def parse_services(path):
+    protos = ('tcp', 'udp', 'sctp', 'dccp')
+    services = {}
+    for line in read_lines(path):
+        line = line.split('#', 1)[0]
+        service, rest = strtok_split(line, ' \t')
+        if service is None:
+            continue
+        spec, rest = strtok_split(rest, ' \t')
+        if spec is None:
+            continue
+        fields = [f for f in spec.split('/') if f]
+        if not fields:
+            continue
+        try:
+            ports = parse_port_range(fields[0])
+        except ValueError:
+            continue
+        for proto in fields[1:]:
+            if proto not in protos:
+                break
+            for port in ports:
+                if port:
+                    services.setdefault(port, dict())[proto] = service
+    return services
+
+
+def parse_enterprises(path):
+    enterprises = {}
+    for line in read_lines(path):
+        had_comment = '#' in line
+        line = line.split('#', 1)[0]
+        dec, org = strtok_split(line, ' \t')
+        if dec is None:
+            continue
+        if had_comment:
+            org = org.rstrip()
+        if not org or not re.fullmatch('[0-9]+', dec) or int(dec) > 0xFFFFFFFF:
+            continue
+        enterprises[int(dec)] = org
+    return enterprises
+
+
+class StringPool:
+    '''The strings of all tables, each stored once.'''
+    def __init__(self):
+        self.data = bytearray(b'\0')
+        self.offsets = {'': 0}
+
+    def add(self, s):
+        if s is None:
+            return 0
+        if s not in self.offsets:
+            self.offsets[s] = len(self.data)
+            self.data += s.encode('utf8', 'surrogateescape') + b'\0'
+        return self.offsets[s]
+
+
+def c_char(b):
+    # Values above 127 would overflow a signed char.
+    return str(b) if b < 128 else "'\\x{:02x}'".format(b)
+
+
+def write_source(out, manuf, wka, services, enterprises):
+    pool = StringPool()
+    out.write('/*\n'
+              ' * Do not modify this file. Changes will be overwritten.\n'
+              ' *\n'
+              ' * Generated automatically by tools/make-addr-resolv-data.py\n'
+              ' * from manuf, services and enterprises.tsv.\n'
+              ' */\n\n'
+              '#include "config.h"\n\n'
+              '#include "addr_resolv_data.h"\n\n')
+
+    out.write('const resolv_data_manuf_t resolv_data_manuf[] = {\n')
+    index = [0] * 257
+    ouis = sorted(manuf)
+    for oui in ouis:
+        name, longname = manuf[oui]
+        out.write('    {{ 0x{:06x}, {}, {} }},\n'.format(oui, pool.add(name), pool.add(longname)))
+        index[(oui >> 16) + 1] += 1
+    out.write('    { 0, 0, 0 }\n};\n\n')
+    out.write('const guint resolv_data_manuf_count = {};\n\n'.format(len(ouis)))
+    for i in range(1, 257):
+        index[i] += index[i - 1]
+    out.write('const guint32 resolv_data_manuf_index[257] = {\n')
+    for i in range(0, 257, 8):
+        out.write('    ' + ' '.join('{},'.format(n) for n in index[i:i + 8]) + '\n')
+    out.write('};\n\n')
+
+    out.write('const resolv_data_wka_t resolv_data_wka[] = {\n')
+    for addr in sorted(wka):
+        out.write('    {{ {}, {{ {} }} }},\n'.format(pool.add(wka[addr]),
+            ', '.join('0x{:02x}'.format(o) for o in addr)))
+    out.write('    { 0, { 0, 0, 0, 0, 0, 0 } }\n};\n\n')
+    out.write('const guint resolv_data_wka_count = {};\n\n'.format(len(wka)))
+
+    out.write('const resolv_data_serv_port_t resolv_data_serv_port[] = {\n')
+    for port in sorted(services):
+        names = services[port]
+        out.write('    {{ {}, {}, {}, {}, {} }},\n'.format(port,
+            *(pool.add(names.get(proto)) for proto in ('tcp', 'udp', 'sctp', 'dccp'))))
+    out.write('    { 0, 0, 0, 0, 0 }\n};\n\n')
+    out.write('const guint resolv_data_serv_port_count = {};\n\n'.format(len(services)))
+
+    out.write('const resolv_data_enterprise_t resolv_data_enterprises[] = {\n')
+    for number in sorted(enterprises):
+        out.write('    {{ {}, {} }},\n'.format(number, pool.add(enterprises[number])))
+    out.write('    { 0, 0 }\n};\n\n')
+    out.write('const guint resolv_data_enterprises_count = {};\n\n'.format(len(enterprises)))
+
+    # Written as numbers, since some compilers limit the length of
+    # string literals far below the size of the pool.
+    out.write('const char resolv_data_strings[] = {\n')
+    for i in range(0, len(pool.data), 16):
+        out.write('    ' + ''.join(c_char(b) + ',' for b in pool.data[i:i + 16]) + '\n')
+    out.write('};\n')
+
+
+def main():
+    if len(sys.argv) != 5:
+        sys.exit(__doc__)
+    manuf, wka = parse_manuf(sys.argv[1])
+    services = parse_services(sys.argv[2])
+    enterprises = parse_enterprises(sys.argv[3])
+    with open(sys.argv[4], 'w') as out:
+        write_source(out, manuf, wka, services, enterprises)
+
+
+if __name__ == '__main__':
+    main()
@@ -180,6 +180,8 @@ echo "snappy is unavailable" >&2
 
 add_package ADDITIONAL_LIST libzstd-devel || echo "zstd is unavailable" >&2
 
+add_package ADDITIONAL_LIST pcre2-devel || echo "pcre2 is unavailable" >&2
+
 add_package ADDITIONAL_LIST lz4-devel || add_package ADDITIONAL_LIST liblz4-devel ||
 echo "lz4 devel is unavailable" >&2
 
@@ -39,6 +39,8 @@
 
 #ifndef _WIN32
 #include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #endif
 
 #include <glib.h>
@@ -51,6 +53,7 @@
 #include <ui/urls.h>
 #include <wsutil/filesystem.h>
 #include <wsutil/file_util.h>
+#include <wsutil/tempfile.h>
 #include <wsutil/socket.h>
 #include <wsutil/privileges.h>
 #include <wsutil/report_message.h>
@@ -58,6 +61,7 @@
 #include <cli_main.h>
 #include <version_info.h>
 #include <wiretap/wtap_opttypes.h>
+#include <wiretap/pcap-encap.h>
 
 #include "globals.h"
 #include <epan/timestamp.h>
@@ -92,13 +96,16 @@
 #include <epan/epan_dissect.h>
 #include <epan/tap.h>
 #include <epan/stat_tap_ui.h>
+#include <epan/conversation.h>
 #include <epan/conversation_table.h>
+#include <epan/reassemble.h>
 #include <epan/srt_table.h>
 #include <epan/rtd_table.h>
 #include <epan/ex-opt.h>
 #include <epan/exported_pdu.h>
 #include <epan/secrets.h>
 
+#include "capture_flow.h"
 #include "capture_opts.h"
 
 #include "capture/capture-pcap-util.h"
@@ -116,6 +123,8 @@
 #include <epan/funnel.h>
 
 #include <wsutil/str_util.h>
+#include <wsutil/strtoi.h>
+#include <wsutil/numa.h>
 #include <wsutil/utf8_entities.h>
 #include <wsutil/json_dumper.h>
 #ifdef _WIN32
@@ -141,10 +150,26 @@
 #define INVALID_CAPTURE 2
 #define INIT_FAILED 2
 
+/* How long, in milliseconds, to wait after the first pass for names */
+#define NAME_LOOKUP_WAIT_TIMEOUT 10000
+
+/* The size of the standard output's buffer with JSON and EK output */
+#define JSON_OUTPUT_BUFFER_SIZE (1024 * 1024)
+
 #define LONGOPT_EXPORT_OBJECTS          LONGOPT_BASE_APPLICATION+1
 #define LONGOPT_COLOR                   LONGOPT_BASE_APPLICATION+2
 #define LONGOPT_NO_DUPLICATE_KEYS       LONGOPT_BASE_APPLICATION+3
 #define LONGOPT_ELASTIC_MAPPING_FILTER  LONGOPT_BASE_APPLICATION+4
+#define LONGOPT_THREADS                 LONGOPT_BASE_APPLICATION+5
+#define LONGOPT_MEMORY_STATS            LONGOPT_BASE_APPLICATION+6
+#define LONGOPT_SAVE_STATISTICS         LONGOPT_BASE_APPLICATION+7
+#define LONGOPT_MERGE_STATISTICS        LONGOPT_BASE_APPLICATION+8
+#define LONGOPT_BATCH                   LONGOPT_BASE_APPLICATION+9
+#define LONGOPT_SHARD                   LONGOPT_BASE_APPLICATION+10
+#define LONGOPT_OUTPUT_THREAD           LONGOPT_BASE_APPLICATION+11
+#define LONGOPT_CPU_AFFINITY            LONGOPT_BASE_APPLICATION+12
+#define LONGOPT_HUGE_PAGES              LONGOPT_BASE_APPLICATION+13
+#define LONGOPT_PDML_COMPACT            LONGOPT_BASE_APPLICATION+14
 
 #if 0
 #define tshark_debug(...) g_warning(__VA_ARGS__)
@@ -160,8 +185,24 @@ static frame_data prev_dis_frame;
 static frame_data prev_cap_frame;
 
 static gboolean perform_two_pass_analysis;
+static guint num_second_pass_threads = 1;
+static guint memory_stats_interval = 0;
+static GSList *stat_args = NULL;                /* the -z arguments */
+static gchar *save_statistics_file = NULL;
+static GSList *merge_statistics_files = NULL;
+static gboolean batch_mode = FALSE;             /* --batch */
+static guint32 shard_index = 0;                 /* --shard <index>/<count> */
+static guint32 shard_count = 1;
 static guint32 epan_auto_reset_count = 0;
 static gboolean epan_auto_reset = FALSE;
+static gboolean use_output_thread = FALSE;      /* --output-thread */
+static gboolean cpu_affinity_set = FALSE;       /* --cpu-affinity */
+#ifdef HAVE_LIBPCAP
+static const char *read_bpf_filter = NULL;      /* -f when reading files */
+static struct bpf_program read_bpf_code;        /* it, compiled... */
+static gboolean read_bpf_compiled = FALSE;
+static int read_bpf_encap = WTAP_ENCAP_PER_PACKET; /* ...for packets of this type */
+#endif
 
 /*
  * The way the packet decode is to be written.
@@ -173,7 +214,8 @@ typedef enum {
   WRITE_FIELDS,   /* User defined list of fields */
   WRITE_JSON,     /* JSON */
   WRITE_JSON_RAW, /* JSON only raw hex */
-  WRITE_EK        /* JSON bulk insert to Elasticsearch */
+  WRITE_EK,       /* JSON bulk insert to Elasticsearch */
+  WRITE_ARROW     /* User defined list of fields, as an Arrow IPC stream */
   /* Add CSV and the like here */
 } output_action_e;
 
@@ -182,6 +224,7 @@ static gboolean do_dissection;     /* TRUE if we have to dissect each packet */
 static gboolean print_packet_info; /* TRUE if we're to print packet information */
 static gboolean print_summary;     /* TRUE if we're to print packet summary information */
 static gboolean print_details;     /* TRUE if we're to print packet details information */
+static gboolean print_fields_only; /* TRUE if the details are just fields an invisible tree can have */
 static gboolean print_hex;         /* TRUE if we're to print hex/ascii information */
 static gboolean line_buffered;
 static gboolean quiet = FALSE;
@@ -202,6 +245,7 @@ static gboolean no_duplicate_keys = FALSE;
 static proto_node_children_grouper_func node_children_grouper = proto_node_group_children_by_unique;
 
 static json_dumper jdumper;
+static arrow_writer *awriter;
 
 /* The line separator used between packets, changeable via the -S option */
 static const char *separator = "";
@@ -247,6 +291,10 @@ static void report_counts_siginfo(int);
 #endif /* _WIN32 */
 #endif /* HAVE_LIBPCAP */
 
+#ifdef HAVE_LIBPCAP
+static gboolean compile_read_bpf_filter(int encap, gchar **err_msg);
+#endif
+
 static void reset_epan_mem(capture_file *cf, epan_dissect_t *edt, gboolean tree, gboolean visual);
 
 typedef enum {
@@ -256,11 +304,16 @@ typedef enum {
   PROCESS_FILE_INTERRUPTED
 } process_file_status_t;
 static process_file_status_t process_cap_file(capture_file *, char *, int, gboolean, int, gint64);
+static int process_batch(int, char *, int, gboolean, int, gint64, dfilter_t *, dfilter_t *);
 
 static gboolean process_packet_single_pass(capture_file *cf,
     epan_dissect_t *edt, gint64 offset, wtap_rec *rec, Buffer *buf,
     guint tap_flags);
 static void show_print_file_io_error(void);
+#ifndef _WIN32
+static gboolean output_thread_start(void);
+static gboolean output_thread_stop(void);
+#endif
 static gboolean write_preamble(capture_file *cf);
 static gboolean print_packet(capture_file *cf, epan_dissect_t *edt);
 static gboolean write_finale(void);
@@ -339,6 +392,87 @@ list_export_pdu_taps(void) {
   }
 }
 
+/*
+ * A statistics file holds the states of the tap listeners of the -z
+ * statistics, as saved by tap_listeners_save_states(), after a magic
+ * string, a version, which also tells the byte order, and the -z
+ * arguments, which must be the same to merge it.  The states are those
+ * of this version of TShark, as it was built.
+ */
+static const char statistics_file_magic[] = "TShark statistics\n";
+#define STATISTICS_FILE_VERSION ((guint32)VERSION_MAJOR << 16 | VERSION_MINOR << 8 | VERSION_MICRO)
+
+static void
+append_stat_args(GByteArray *buf)
+{
+  guint32 num_args = g_slist_length(stat_args);
+  guint32 version = STATISTICS_FILE_VERSION;
+  GSList *arg;
+
+  g_byte_array_append(buf, (const guint8 *)statistics_file_magic, sizeof statistics_file_magic);
+  g_byte_array_append(buf, (const guint8 *)&version, sizeof version);
+  g_byte_array_append(buf, (const guint8 *)&num_args, sizeof num_args);
+  for (arg = stat_args; arg; arg = arg->next) {
+    guint32 len = (guint32)strlen((const char *)arg->data);
+
+    g_byte_array_append(buf, (const guint8 *)&len, sizeof len);
+    g_byte_array_append(buf, (const guint8 *)arg->data, len);
+  }
+}
+
+static gboolean
+save_statistics(const char *path)
+{
+  GByteArray *buf = g_byte_array_new();
+  GError     *gerr = NULL;
+  gboolean    ok;
+
+  append_stat_args(buf);
+  tap_listeners_save_states(buf);
+  ok = g_file_set_contents(path, (const gchar *)buf->data, buf->len, &gerr);
+  if (!ok) {
+    cmdarg_err("Couldn't save the statistics to \"%s\": %s", path, gerr->message);
+    g_error_free(gerr);
+  }
+  g_byte_array_free(buf, TRUE);
+  return ok;
+}
+
+static gboolean
+merge_statistics(const char *path)
+{
+  GByteArray *header = g_byte_array_new();
+  gchar      *contents;
+  gsize       len;
+  GError     *gerr = NULL;
+  gboolean    ok = FALSE;
+
+  if (!g_file_get_contents(path, &contents, &len, &gerr)) {
+    cmdarg_err("Couldn't read the statistics in \"%s\": %s", path, gerr->message);
+    g_error_free(gerr);
+    g_byte_array_free(header, TRUE);
+    return FALSE;
+  }
+
+  append_stat_args(header);
+  if (len < sizeof statistics_file_magic + sizeof(guint32) ||
+      memcmp(contents, statistics_file_magic, sizeof statistics_file_magic) != 0) {
+    cmdarg_err("\"%s\" isn't a TShark statistics file.", path);
+  } else if (memcmp(contents + sizeof statistics_file_magic,
+                    header->data + sizeof statistics_file_magic, sizeof(guint32)) != 0) {
+    cmdarg_err("\"%s\" was saved by another version of TShark, or on another kind of machine.", path);
+  } else if (len < header->len || memcmp(contents, header->data, header->len) != 0) {
+    cmdarg_err("\"%s\" holds other statistics than given with -z.", path);
+  } else if (!tap_listeners_merge_states((const guint8 *)contents + header->len, len - header->len)) {
+    cmdarg_err("The statistics in \"%s\" couldn't be merged.", path);
+  } else {
+    ok = TRUE;
+  }
+  g_free(contents);
+  g_byte_array_free(header, TRUE);
+  return ok;
+}
+
 static void
 print_usage(FILE *output)
 {
@@ -373,6 +507,7 @@ print_usage(FILE *output)
   fprintf(output, "  -L, --list-data-link-types\n");
   fprintf(output, "                           print list of link-layer types of iface and exit\n");
   fprintf(output, "  --list-time-stamp-types  print list of timestamp types for iface and exit\n");
+  fprintf(output, "  --update-interval <ms>   time between reading captured packets (def: %dms)\n", DEFAULT_UPDATE_INTERVAL);
   fprintf(output, "\n");
   fprintf(output, "Capture stop conditions:\n");
   fprintf(output, "  -c <packet count>        stop after n packets (def: infinite)\n");
@@ -441,7 +576,7 @@ print_usage(FILE *output)
   fprintf(output, "  -P, --print              print packet summary even when writing to a file\n");
   fprintf(output, "  -S <separator>           the line separator to print between packets\n");
   fprintf(output, "  -x                       add output of hex and ASCII dump (Packet Bytes)\n");
-  fprintf(output, "  -T pdml|ps|psml|json|jsonraw|ek|tabs|text|fields|?\n");
+  fprintf(output, "  -T pdml|ps|psml|json|jsonraw|ek|tabs|text|fields|arrow|?\n");
   fprintf(output, "                           format of text output (def: text)\n");
   fprintf(output, "  -j <protocolfilter>      protocols layers filter if -T ek|pdml|json selected\n");
   fprintf(output, "                           (e.g. \"ip ip.flags text\", filter does not expand child\n");
@@ -481,8 +616,31 @@ print_usage(FILE *output)
   fprintf(output, "  --no-duplicate-keys      If -T json is specified, merge duplicate keys in an object\n");
   fprintf(output, "                           into a single key with as value a json array containing all\n");
   fprintf(output, "                           values\n");
+  fprintf(output, "  --pdml-compact           If -T pdml is specified, leave out indentation and\n");
+  fprintf(output, "                           attributes that repeat what others say\n");
   fprintf(output, "  --elastic-mapping-filter <protocols> If -G elastic-mapping is specified, put only the\n");
   fprintf(output, "                           specified protocols within the mapping file\n");
+#ifndef _WIN32
+  fprintf(output, "  --threads <count>        with -2, dissect and print the second pass using\n");
+  fprintf(output, "                           <count> worker processes (def: 1)\n");
+#endif
+  fprintf(output, "  --memory-stats <count>   without -2, report the memory held by conversations\n");
+  fprintf(output, "                           and reassemblies on stderr every <count> packets\n");
+  fprintf(output, "  --save-statistics <outfile> save the -z statistics, to be merged later\n");
+  fprintf(output, "  --merge-statistics <infile> add saved -z statistics to those being computed;\n");
+  fprintf(output, "                           without -r, only merge and print them\n");
+  fprintf(output, "  --batch                  read the names of the capture files to process, one\n");
+  fprintf(output, "                           per line, from the standard input\n");
+  fprintf(output, "  --shard <index>/<count>  only dissect the packets of the flows that hash to\n");
+  fprintf(output, "                           shard <index> of <count> (0-based)\n");
+#ifndef _WIN32
+  fprintf(output, "  --output-thread          write the standard output from a thread of its own,\n");
+  fprintf(output, "                           buffering it while the reader is slow\n");
+#endif
+  fprintf(output, "  --cpu-affinity <cpus>|node:<node>|iface:<interface>\n");
+  fprintf(output, "                           run only on the given CPUs, those of a NUMA node,\n");
+  fprintf(output, "                           or those of the node an interface is attached to\n");
+  fprintf(output, "  --huge-pages             ask for huge pages for long-lived memory\n");
 
   fprintf(output, "\n");
   fprintf(output, "Miscellaneous:\n");
@@ -732,6 +890,16 @@ main(int argc, char *argv[])
     {"color", no_argument, NULL, LONGOPT_COLOR},
     {"no-duplicate-keys", no_argument, NULL, LONGOPT_NO_DUPLICATE_KEYS},
     {"elastic-mapping-filter", required_argument, NULL, LONGOPT_ELASTIC_MAPPING_FILTER},
+    {"threads", required_argument, NULL, LONGOPT_THREADS},
+    {"memory-stats", required_argument, NULL, LONGOPT_MEMORY_STATS},
+    {"save-statistics", required_argument, NULL, LONGOPT_SAVE_STATISTICS},
+    {"merge-statistics", required_argument, NULL, LONGOPT_MERGE_STATISTICS},
+    {"batch", no_argument, NULL, LONGOPT_BATCH},
+    {"shard", required_argument, NULL, LONGOPT_SHARD},
+    {"output-thread", no_argument, NULL, LONGOPT_OUTPUT_THREAD},
+    {"cpu-affinity", required_argument, NULL, LONGOPT_CPU_AFFINITY},
+    {"huge-pages", no_argument, NULL, LONGOPT_HUGE_PAGES},
+    {"pdml-compact", no_argument, NULL, LONGOPT_PDML_COMPACT},
     {0, 0, 0, 0 }
   };
   gboolean             arg_error = FALSE;
@@ -921,6 +1089,23 @@ main(int argc, char *argv[])
     case LONGOPT_ELASTIC_MAPPING_FILTER:
       elastic_mapping_filter = optarg;
       break;
+    case LONGOPT_CPU_AFFINITY:
+    {
+      /* Early, so that what is allocated from now on is on the CPUs' node */
+      char *affinity_err = ws_numa_set_cpu_affinity(optarg);
+
+      if (affinity_err != NULL) {
+        cmdarg_err("--cpu-affinity %s: %s.", optarg, affinity_err);
+        g_free(affinity_err);
+        exit_status = INVALID_OPTION;
+        goto clean_exit;
+      }
+      cpu_affinity_set = TRUE;
+      break;
+    }
+    case LONGOPT_HUGE_PAGES:
+      ws_numa_set_huge_pages(TRUE);
+      break;
     default:
       break;
     }
@@ -1152,6 +1337,7 @@ main(int argc, char *argv[])
     case 'B':        /* Buffer size */
 #endif
     case LONGOPT_COMPRESS_TYPE:        /* compress type */
+    case LONGOPT_UPDATE_INTERVAL:      /* interval between reading captured packets */
       /* These are options only for packet capture. */
 #ifdef HAVE_LIBPCAP
       exit_status = capture_opts_add_opt(&global_capture_opts, opt, optarg, &start_capture);
@@ -1239,7 +1425,7 @@ main(int argc, char *argv[])
       if (protocolfilter) {
         cmdarg_err("-j or -J was already specified! Overwriting previous protocol filter");
       }
-      protocolfilter_flags = PF_INCLUDE_CHILDREN;
+      protocolfilter_flags |= PF_INCLUDE_CHILDREN;
       protocolfilter = wmem_strsplit(wmem_epan_scope(), optarg, " ", -1);
       break;
     case 'W':        /* Select extra information to save in our capture file */
@@ -1398,11 +1584,17 @@ main(int argc, char *argv[])
         output_action = WRITE_JSON_RAW;
         print_details = TRUE;   /* Need details */
         print_summary = FALSE;  /* Don't allow summary */
+      } else if (strcmp(optarg, "arrow") == 0) {
+        output_action = WRITE_ARROW;
+        print_details = TRUE;   /* Need full tree info */
+        print_summary = FALSE;  /* Don't allow summary */
       }
       else {
         cmdarg_err("Invalid -T parameter \"%s\"; it must be one of:", optarg);                   /* x */
         cmdarg_err_cont("\t\"fields\"  The values of fields specified with the -e option, in a form\n"
                         "\t          specified by the -E option.\n"
+                        "\t\"arrow\"   The values of fields specified with the -e option, as an\n"
+                        "\t          Apache Arrow IPC stream with a typed column for each field.\n"
                         "\t\"pdml\"    Packet Details Markup Language, an XML-based format for the\n"
                         "\t          details of a decoded packet. This information is equivalent to\n"
                         "\t          the packet details printed with the -V flag.\n"
@@ -1485,6 +1677,7 @@ main(int argc, char *argv[])
         exit_status = INVALID_OPTION;
         goto clean_exit;
       }
+      stat_args = g_slist_append(stat_args, g_strdup(optarg));
       break;
     case 'd':        /* Decode as rule */
     case 'K':        /* Kerberos keytab file */
@@ -1520,6 +1713,57 @@ main(int argc, char *argv[])
       no_duplicate_keys = TRUE;
       node_children_grouper = proto_node_group_children_by_json_key;
       break;
+    case LONGOPT_PDML_COMPACT:
+      protocolfilter_flags |= PF_PDML_COMPACT;
+      break;
+    case LONGOPT_THREADS:
+#ifdef _WIN32
+      cmdarg_err("--threads isn't supported on Windows.");
+      exit_status = INVALID_OPTION;
+      goto clean_exit;
+#else
+      num_second_pass_threads = get_positive_int(optarg, "number of threads");
+#endif
+      break;
+    case LONGOPT_MEMORY_STATS:
+      memory_stats_interval = get_positive_int(optarg, "memory statistics interval");
+      break;
+    case LONGOPT_SAVE_STATISTICS:
+      g_free(save_statistics_file);
+      save_statistics_file = g_strdup(optarg);
+      break;
+    case LONGOPT_MERGE_STATISTICS:
+      merge_statistics_files = g_slist_append(merge_statistics_files, g_strdup(optarg));
+      break;
+    case LONGOPT_BATCH:
+      batch_mode = TRUE;
+      break;
+    case LONGOPT_CPU_AFFINITY:
+    case LONGOPT_HUGE_PAGES:
+      /* already processed; just ignore it now */
+      break;
+    case LONGOPT_OUTPUT_THREAD:
+#ifndef _WIN32
+      use_output_thread = TRUE;
+#else
+      cmdarg_err("--output-thread isn't available on Windows.");
+      exit_status = INVALID_OPTION;
+      goto clean_exit;
+#endif
+      break;
+    case LONGOPT_SHARD:
+    {
+      const char *slash;
+
+      if (!ws_strtou32(optarg, &slash, &shard_index) || *slash != '/' ||
+          !ws_strtou32(slash + 1, NULL, &shard_count) ||
+          shard_count == 0 || shard_index >= shard_count) {
+        cmdarg_err("\"%s\" isn't a valid shard; it should be <index>/<count>, with <index> less than <count>.", optarg);
+        exit_status = INVALID_OPTION;
+        goto clean_exit;
+      }
+      break;
+    }
     default:
     case '?':        /* Bad flag - print usage message */
       switch(optopt) {
@@ -1558,15 +1802,21 @@ main(int argc, char *argv[])
     goto clean_exit;
   }
 
+  if ((protocolfilter_flags & PF_PDML_COMPACT) && (output_action != WRITE_XML || !print_details)) {
+    cmdarg_err("--pdml-compact can only be used with \"-T pdml\"");
+    exit_status = INVALID_OPTION;
+    goto clean_exit;
+  }
+
   /* If we specified output fields, but not the output field type... */
-  if ((WRITE_FIELDS != output_action && WRITE_XML != output_action && WRITE_JSON != output_action && WRITE_EK != output_action) && 0 != output_fields_num_fields(output_fields)) {
+  if ((WRITE_FIELDS != output_action && WRITE_ARROW != output_action && WRITE_XML != output_action && WRITE_JSON != output_action && WRITE_EK != output_action) && 0 != output_fields_num_fields(output_fields)) {
         cmdarg_err("Output fields were specified with \"-e\", "
-            "but \"-Tek, -Tfields, -Tjson or -Tpdml\" was not specified.");
+            "but \"-Tarrow, -Tek, -Tfields, -Tjson or -Tpdml\" was not specified.");
         exit_status = INVALID_OPTION;
         goto clean_exit;
-  } else if (WRITE_FIELDS == output_action && 0 == output_fields_num_fields(output_fields)) {
-        cmdarg_err("\"-Tfields\" was specified, but no fields were "
-                    "specified with \"-e\".");
+  } else if ((WRITE_FIELDS == output_action || WRITE_ARROW == output_action) && 0 == output_fields_num_fields(output_fields)) {
+        cmdarg_err("\"-T%s\" was specified, but no fields were "
+                    "specified with \"-e\".", WRITE_ARROW == output_action ? "arrow" : "fields");
 
         exit_status = INVALID_OPTION;
         goto clean_exit;
@@ -1584,7 +1834,7 @@ main(int argc, char *argv[])
      filter (if no "-r" flag was specified) or a display filter (if a "-r"
      flag was specified. */
   if (optind < argc) {
-    if (cf_name != NULL) {
+    if (cf_name != NULL || batch_mode) {
       if (dfilter != NULL) {
         cmdarg_err("Display filters were specified both with \"-Y\" "
             "and with additional command-line arguments.");
@@ -1685,6 +1935,65 @@ main(int argc, char *argv[])
     goto clean_exit;
   }
 
+  if (num_second_pass_threads > 1 && !perform_two_pass_analysis) {
+    cmdarg_err("--threads requires two-pass analysis (-2).");
+    exit_status = INVALID_OPTION;
+    goto clean_exit;
+  }
+
+  if (shard_count > 1 && perform_two_pass_analysis) {
+    cmdarg_err("--shard can't be used with two-pass analysis (-2).");
+    exit_status = INVALID_OPTION;
+    goto clean_exit;
+  }
+
+  if (memory_stats_interval != 0 && perform_two_pass_analysis) {
+    cmdarg_err("--memory-stats can't be used with two-pass analysis (-2).");
+    exit_status = INVALID_OPTION;
+    goto clean_exit;
+  }
+
+  if ((save_statistics_file != NULL || merge_statistics_files != NULL) && stat_args == NULL) {
+    cmdarg_err("--save-statistics and --merge-statistics require statistics (-z).");
+    exit_status = INVALID_OPTION;
+    goto clean_exit;
+  }
+
+  if (batch_mode && cf_name != NULL) {
+    cmdarg_err("--batch reads the names of the capture files from the standard input; it can't be used with -r.");
+    exit_status = INVALID_OPTION;
+    goto clean_exit;
+  }
+
+  if (batch_mode && (save_statistics_file != NULL || merge_statistics_files != NULL)) {
+    cmdarg_err("--batch can't be used with --save-statistics or --merge-statistics.");
+    exit_status = INVALID_OPTION;
+    goto clean_exit;
+  }
+
+  /* In a single pass each frame is dissected once, in order, so the
+     conversations that have been idle for long can be forgotten. */
+  conversation_set_expiry(!perform_two_pass_analysis);
+
+  /* JSON and EK output is written in many small pieces; give it a large
+     buffer, unless each packet is to be flushed as soon as it's written. */
+  if (!line_buffered &&
+      (output_action == WRITE_JSON || output_action == WRITE_JSON_RAW || output_action == WRITE_EK))
+    setvbuf(stdout, NULL, _IOFBF, JSON_OUTPUT_BUFFER_SIZE);
+
+#ifndef _WIN32
+  /* So does all output if it's handed to a thread to write. */
+  if (use_output_thread) {
+    if (!line_buffered)
+      setvbuf(stdout, NULL, _IOFBF, JSON_OUTPUT_BUFFER_SIZE);
+    if (!output_thread_start()) {
+      cmdarg_err("Couldn't start the output thread: %s.", g_strerror(errno));
+      exit_status = INVALID_OPTION;
+      goto clean_exit;
+    }
+  }
+#endif
+
 #ifdef HAVE_LIBPCAP
   if (caps_queries) {
     /* We're supposed to list the link-layer/timestamp types for an interface;
@@ -1703,21 +2012,17 @@ main(int argc, char *argv[])
       goto clean_exit;
     }
   } else {
-    if (cf_name) {
+    if (cf_name || batch_mode) {
       /*
-       * "-r" was specified, so we're reading a capture file.
+       * "-r" or "--batch" was specified, so we're reading capture files.
        * Capture options don't apply here.
        */
 
-      /* We don't support capture filters when reading from a capture file
-         (the BPF compiler doesn't support all link-layer types that we
-         support in capture files we read). */
-      if (global_capture_opts.default_options.cfilter) {
-        cmdarg_err("Only read filters, not capture filters, "
-          "can be specified when reading a capture file.");
-        exit_status = INVALID_OPTION;
-        goto clean_exit;
-      }
+      /* A capture filter is applied to the raw data of the packets
+         read, before they're dissected (the BPF compiler doesn't support
+         all link-layer types that we support in capture files we read,
+         so it's compiled for each type as packets of it turn up). */
+      read_bpf_filter = global_capture_opts.default_options.cfilter;
       if (global_capture_opts.multi_files_on) {
         cmdarg_err("Multiple capture files requested, but "
                    "a capture isn't being done.");
@@ -1899,6 +2204,9 @@ main(int argc, char *argv[])
       goto clean_exit;
     }
   }
+  /* If we're only writing fields, the tree needn't have anything else. */
+  print_fields_only = ((WRITE_FIELDS == output_action || WRITE_ARROW == output_action) &&
+                       !output_fields_need_visible_tree(output_fields));
 #ifdef HAVE_LIBPCAP
   /* We currently don't support taps, or printing dissected packets,
      if we're writing to a pipe. */
@@ -2099,6 +2407,21 @@ main(int argc, char *argv[])
       goto clean_exit;
     }
 
+#ifdef HAVE_LIBPCAP
+    /* If all the packets are of one type, find out now whether the
+       capture filter can be applied to them. */
+    if (read_bpf_filter != NULL &&
+        wtap_file_encap(cfile.provider.wth) != WTAP_ENCAP_PER_PACKET &&
+        !compile_read_bpf_filter(wtap_file_encap(cfile.provider.wth), &err_msg)) {
+      cmdarg_err("%s", err_msg);
+      g_free(err_msg);
+      epan_cleanup();
+      extcap_cleanup();
+      exit_status = INVALID_FILTER;
+      goto clean_exit;
+    }
+#endif
+
     /* Start statistics taps; we do so after successfully opening the
        capture file, so we know we have something to compute stats
        on, and after registering all dissectors, so that MATE will
@@ -2171,6 +2494,22 @@ main(int argc, char *argv[])
         g_free(pdu_export_arg);
         g_free(exp_pdu_filename);
     }
+  } else if (batch_mode) {
+    /* Read the captures named on the standard input; the statistics are
+       drawn after each of them. */
+    exit_status = process_batch(in_file_type, output_file_name, out_file_type, out_file_name_res,
+#ifdef HAVE_LIBPCAP
+        global_capture_opts.has_autostop_packets ? global_capture_opts.autostop_packets : 0,
+        global_capture_opts.has_autostop_filesize ? global_capture_opts.autostop_filesize : 0,
+#else
+        max_packet_count,
+        0,
+#endif
+        rfcode, dfcode);
+  } else if (merge_statistics_files != NULL) {
+    /* There's nothing to read; we just merge saved statistics. */
+    start_requested_stats();
+    draw_taps = TRUE;
   } else {
     tshark_debug("tshark: no capture file specified");
     /* No capture file specified, so we're supposed to do a live capture
@@ -2333,6 +2672,26 @@ main(int argc, char *argv[])
     cfile.provider.frames = NULL;
   }
 
+  if (draw_taps && (save_statistics_file != NULL || merge_statistics_files != NULL)) {
+    if (!tap_listeners_are_mergeable()) {
+      cmdarg_err("Some of the statistics can't be saved or merged.");
+      exit_status = INVALID_OPTION;
+      draw_taps = FALSE;
+    } else {
+      GSList *file;
+
+      for (file = merge_statistics_files; file && draw_taps; file = file->next) {
+        if (!merge_statistics((const char *)file->data)) {
+          exit_status = INVALID_FILE;
+          draw_taps = FALSE;
+        }
+      }
+      if (draw_taps && save_statistics_file != NULL &&
+          !save_statistics(save_statistics_file))
+        exit_status = 2;
+    }
+  }
+
   if (draw_taps)
     draw_tap_listeners(TRUE);
   /* Memory cleanup */
@@ -2346,11 +2705,20 @@ main(int argc, char *argv[])
   output_fields = NULL;
 
 clean_exit:
+#ifndef _WIN32
+  if (!output_thread_stop() && exit_status == EXIT_SUCCESS)
+    exit_status = 2;
+#endif
   cf_close(&cfile);
   g_free(cf_name);
   destroy_print_stream(print_stream);
   g_free(output_file_name);
+  g_slist_free_full(stat_args, g_free);
+  g_free(save_statistics_file);
+  g_slist_free_full(merge_statistics_files, g_free);
 #ifdef HAVE_LIBPCAP
+  if (read_bpf_compiled)
+    pcap_freecode(&read_bpf_code);
   capture_opts_cleanup(&global_capture_opts);
 #endif
   col_cleanup(&cfile.cinfo);
@@ -2502,6 +2870,30 @@ tshark_epan_new(capture_file *cf)
   return epan_new(&cf->provider, &funcs);
 }
 
+/*
+ * Mark as wanted only the columns we'll look at, given the flags of the
+ * tap listeners, so that dissectors don't format the others.
+ */
+static void
+set_wanted_columns(capture_file *cf, guint flags)
+{
+  gint     i;
+  gboolean wanted;
+
+  for (i = 0; i < cf->cinfo.num_cols; i++) {
+    wanted = (flags & TL_REQUIRES_COLUMNS) != 0;
+    if (!wanted && print_packet_info && print_summary) {
+      /* write_csv_columns() writes the last column even if it's hidden */
+      wanted = get_column_visible(i) || i == cf->cinfo.num_cols - 1;
+    }
+    if (!wanted && output_fields_has_cols(output_fields)) {
+      wanted = get_column_visible(i) &&
+               output_fields_has_col(output_fields, cf->cinfo.columns[i].col_title);
+    }
+    col_set_wanted(&cf->cinfo, i, wanted);
+  }
+}
+
 #ifdef HAVE_LIBPCAP
 static gboolean
 capture(void)
@@ -2782,6 +3174,7 @@ capture_input_new_packets(capture_session *cap_session, int to_read)
 
   /* Get the union of the flags for all tap listeners. */
   tap_flags = union_of_tap_listener_flags();
+  set_wanted_columns(cf, tap_flags);
 
   if (do_dissection) {
     gboolean create_proto_tree;
@@ -2818,7 +3211,8 @@ capture_input_new_packets(capture_session *cap_session, int to_read)
        printing packet details, which is true if we're printing stuff
        ("print_packet_info" is true) and we're in verbose mode
        ("packet_details" is true). */
-    edt = epan_dissect_new(cf->epan, create_proto_tree, print_packet_info && print_details);
+    edt = epan_dissect_new(cf->epan, create_proto_tree,
+                           print_packet_info && print_details && !print_fields_only);
 
     wtap_rec_init(&rec);
     ws_buffer_init(&buf, 1514);
@@ -2826,7 +3220,8 @@ capture_input_new_packets(capture_session *cap_session, int to_read)
     while (to_read-- && cf->provider.wth) {
       wtap_cleareof(cf->provider.wth);
       ret = wtap_read(cf->provider.wth, &rec, &buf, &err, &err_info, &data_offset);
-      reset_epan_mem(cf, edt, create_proto_tree, print_packet_info && print_details);
+      reset_epan_mem(cf, edt, create_proto_tree,
+                     print_packet_info && print_details && !print_fields_only);
       if (ret == FALSE) {
         /* read from file failed, tell the capture child to stop */
         sync_pipe_stop(cap_session);
@@ -2999,6 +3394,85 @@ capture_cleanup(int signum _U_)
 #endif /* _WIN32 */
 #endif /* HAVE_LIBPCAP */
 
+#ifdef HAVE_LIBPCAP
+/*
+ * Compile the capture filter for packets of a link-layer type, unless
+ * it's already been compiled for them; FALSE, with an error message, if
+ * it can't be.
+ */
+static gboolean
+compile_read_bpf_filter(int encap, gchar **err_msg)
+{
+  int     linktype;
+  pcap_t *pc;
+
+  if (read_bpf_compiled) {
+    if (encap == read_bpf_encap)
+      return TRUE;
+    pcap_freecode(&read_bpf_code);
+    read_bpf_compiled = FALSE;
+  }
+  read_bpf_encap = encap;
+
+  linktype = wtap_wtap_encap_to_pcap_encap(encap);
+  if (linktype == -1) {
+    *err_msg = g_strdup_printf("Capture filters can't be applied to %s packets.",
+                               wtap_encap_description(encap));
+    return FALSE;
+  }
+  pc = pcap_open_dead(linktype, WTAP_MAX_PACKET_SIZE_STANDARD);
+  if (pc == NULL) {
+    *err_msg = g_strdup("Capture filters can't be compiled.");
+    return FALSE;
+  }
+  if (pcap_compile(pc, &read_bpf_code, read_bpf_filter, 1, 0) == -1) {
+    *err_msg = g_strdup_printf("\"%s\" isn't a valid capture filter for %s packets: %s.",
+                               read_bpf_filter, wtap_encap_description(encap),
+                               pcap_geterr(pc));
+    pcap_close(pc);
+    return FALSE;
+  }
+  pcap_close(pc);
+  read_bpf_compiled = TRUE;
+  return TRUE;
+}
+
+/*
+ * Does a record match the capture filter?  Only packets can; those of a
+ * link-layer type the filter can't be applied to don't, and the first
+ * of them gets an error message.
+ */
+static gboolean
+record_passes_read_bpf_filter(const wtap_rec *rec, Buffer *buf)
+{
+  struct pcap_pkthdr  hdr;
+  int                 encap;
+  gchar              *err_msg;
+
+  if (rec->rec_type != REC_TYPE_PACKET)
+    return FALSE;
+
+  encap = rec->rec_header.packet_header.pkt_encap;
+  if (encap != read_bpf_encap || !read_bpf_compiled) {
+    if (encap == read_bpf_encap) {
+      /* We've already said why not. */
+      return FALSE;
+    }
+    if (!compile_read_bpf_filter(encap, &err_msg)) {
+      cmdarg_err("%s", err_msg);
+      g_free(err_msg);
+      return FALSE;
+    }
+  }
+
+  hdr.ts.tv_sec = (long)rec->ts.secs;
+  hdr.ts.tv_usec = rec->ts.nsecs / 1000;
+  hdr.caplen = rec->rec_header.packet_header.caplen;
+  hdr.len = rec->rec_header.packet_header.len;
+  return pcap_offline_filter(&read_bpf_code, &hdr, ws_buffer_start_ptr(buf)) != 0;
+}
+#endif /* HAVE_LIBPCAP */
+
 static gboolean
 process_packet_first_pass(capture_file *cf, epan_dissect_t *edt,
                           gint64 offset, wtap_rec *rec, Buffer *buf)
@@ -3007,6 +3481,12 @@ process_packet_first_pass(capture_file *cf, epan_dissect_t *edt,
   guint32        framenum;
   gboolean       passed;
 
+#ifdef HAVE_LIBPCAP
+  /* A packet that doesn't match the capture filter isn't even counted. */
+  if (read_bpf_filter != NULL && !record_passes_read_bpf_filter(rec, buf))
+    return FALSE;
+#endif
+
   /* The frame number of this packet is one more than the count of
      frames in this packet. */
   framenum = cf->count + 1;
@@ -3050,11 +3530,28 @@ process_packet_first_pass(capture_file *cf, epan_dissect_t *edt,
     /* Run the read filter if we have one. */
     if (cf->rfcode)
       passed = dfilter_apply_edt(cf->rfcode, edt);
+
+    /* Look up the names of the addresses now, rather than one by one
+       as the second pass prints them. */
+    if (passed && gbl_resolv_flags.network_name) {
+      host_name_lookup_prefetch(&edt->pi.net_src);
+      host_name_lookup_prefetch(&edt->pi.net_dst);
+      host_name_lookup_process();
+    }
   }
 
   if (passed) {
+    frame_data *fdata;
+
     frame_data_set_after_dissect(&fdlocal, &cum_bytes);
-    cf->provider.prev_cap = cf->provider.prev_dis = frame_data_sequence_add(cf->provider.frames, &fdlocal);
+    fdata = frame_data_sequence_add(cf->provider.frames, &fdlocal);
+    cf->provider.prev_cap = cf->provider.prev_dis = fdata;
+
+    /* Remember whether this frame is expected to be displayed in the
+     * second pass; the parallel second pass uses that to work out the
+     * previously-displayed frame and cumulative byte count at the start
+     * of each worker's range of frames. */
+    fdata->passed_dfilter = 1;
 
     /* If we're not doing dissection then there won't be any dependent frames.
      * More importantly, edt.pi.dependent_frames won't be initialized because
@@ -3065,6 +3562,8 @@ process_packet_first_pass(capture_file *cf, epan_dissect_t *edt,
     if (edt && cf->dfcode) {
       if (dfilter_apply_edt(cf->dfcode, edt)) {
         g_slist_foreach(edt->pi.dependent_frames, find_and_mark_frame_depended_upon, cf->provider.frames);
+      } else {
+        fdata->passed_dfilter = 0;
       }
     }
 
@@ -3200,6 +3699,14 @@ process_cap_file_first_pass(capture_file *cf, int max_packet_count,
   if (edt)
     epan_dissect_free(edt);
 
+  /* Let the lookups started on this pass finish, so that the second
+     pass doesn't wait for them. */
+  if (gbl_resolv_flags.network_name && status != PASS_INTERRUPTED) {
+    tshark_debug("tshark: waiting for name lookups");
+    /* Addresses whose lookups don't finish in time are shown as is. */
+    host_name_lookup_wait(NAME_LOOKUP_WAIT_TIMEOUT);
+  }
+
   /* Close the sequential I/O side, to free up memory it requires. */
   wtap_sequential_close(cf->provider.wth);
 
@@ -3242,6 +3749,10 @@ process_packet_second_pass(capture_file *cf, epan_dissect_t *edt,
 
     col_custom_prime_edt(edt, &cf->cinfo);
 
+    /* If we're writing fields from an invisible tree, prime it with them. */
+    if (print_packet_info && print_fields_only)
+      output_fields_prime_edt(output_fields, edt);
+
     /* We only need the columns if either
          1) some tap needs the columns
        or
@@ -3326,19 +3837,406 @@ process_new_idbs(wtap *wth, wtap_dumper *pdh, int *err, gchar **err_info)
   return TRUE;
 }
 
+/*
+ * Dissect, and print or write out, frames first_framenum through
+ * last_framenum in the second pass.
+ */
 static pass_status_t
-process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
-                             int *err, gchar **err_info,
-                             volatile guint32 *err_framenum)
+process_frames_second_pass(capture_file *cf, wtap_dumper *pdh,
+                           epan_dissect_t *edt, guint tap_flags,
+                           guint32 first_framenum, guint32 last_framenum,
+                           int *err, gchar **err_info,
+                           volatile guint32 *err_framenum)
 {
   wtap_rec        rec;
   Buffer          buf;
   guint32         framenum;
   frame_data     *fdata;
+  pass_status_t   status = PASS_SUCCEEDED;
+
+  wtap_rec_init(&rec);
+  ws_buffer_init(&buf, 1514);
+
+  for (framenum = first_framenum; framenum <= last_framenum; framenum++) {
+    if (read_interrupted) {
+      status = PASS_INTERRUPTED;
+      break;
+    }
+    fdata = frame_data_sequence_find(cf->provider.frames, framenum);
+    if (!wtap_seek_read(cf->provider.wth, fdata->file_off, &rec, &buf, err,
+                        err_info)) {
+      /* Error reading from the input file. */
+      status = PASS_READ_ERROR;
+      break;
+    }
+    tshark_debug("tshark: invoking process_packet_second_pass() for frame #%d", framenum);
+    if (process_packet_second_pass(cf, edt, fdata, &rec, &buf, tap_flags)) {
+      /* Either there's no read filtering or this packet passed the
+         filter, so, if we're writing to a capture file, write
+         this packet out. */
+      if (pdh != NULL) {
+        tshark_debug("tshark: writing packet #%d to outfile", framenum);
+        if (!wtap_dump(pdh, &rec, ws_buffer_start_ptr(&buf), err, err_info)) {
+          /* Error writing to the output file. */
+          tshark_debug("tshark: error writing to a capture file (%d)", *err);
+          *err_framenum = framenum;
+          status = PASS_WRITE_ERROR;
+          break;
+        }
+      }
+    }
+  }
+
+  ws_buffer_free(&buf);
+  wtap_rec_cleanup(&rec);
+
+  return status;
+}
+
+#ifndef _WIN32
+/*
+ * Parallel second pass.
+ *
+ * By the time the second pass starts, the first pass has built all the
+ * cross-frame state, so each frame can be dissected independently of the
+ * frames before it.  We fork one worker process per range of frames; each
+ * one gets a copy-on-write snapshot of that state and its own
+ * epan_dissect_t, writes its output to a temporary file, and reports how
+ * it did over a pipe.  The parent then copies the workers' output to the
+ * standard output in frame order, so the result is the same as that of a
+ * single-threaded second pass.
+ *
+ * The only state that carries over from one frame's second-pass output
+ * to the next is the previously displayed frame and the cumulative byte
+ * count; we seed each worker with those, using the display filter
+ * results from the first pass.
+ */
+typedef struct {
+  gint32  status;         /* pass_status_t */
+  gint32  err;
+  guint32 err_framenum;
+  guint32 err_info_len;   /* length of err_info string following this, if any */
+} second_pass_worker_result_t;
+
+typedef struct {
+  pid_t   pid;
+  int     out_fd;         /* worker's output */
+  int     result_fd;      /* read side of the worker's result pipe */
+} second_pass_worker_t;
+
+/*
+ * Can we do the second pass in parallel?  If not, returns a string
+ * explaining why not.
+ */
+static const char *
+second_pass_parallel_blocker(capture_file *cf, wtap_dumper *pdh)
+{
+  if (pdh != NULL)
+    return "packets are being written to a capture file";
+  if (!print_packet_info && !tap_listeners_require_dissection())
+    return "no packet information is being printed";
+  if (output_action == WRITE_JSON || output_action == WRITE_JSON_RAW)
+    return "JSON output carries state from one packet to the next";
+  if (!tap_listeners_are_mergeable())
+    return "some taps and statistics need to see every packet in a single process";
+  if (strcmp(cf->filename, "-") == 0)
+    return "the capture is being read from the standard input";
+  return NULL;
+}
+
+static void
+second_pass_worker_run(capture_file *cf, epan_dissect_t *edt, guint tap_flags,
+                       guint32 first_framenum, guint32 last_framenum,
+                       int out_fd, int result_fd)
+{
+  second_pass_worker_result_t result;
+  int          err = 0;
+  gchar       *err_info = NULL;
+  volatile guint32 err_framenum = 0;
+  pass_status_t status;
+  GByteArray  *tap_states;
+  guint64      tap_states_len;
+  ssize_t      ret _U_;
+
+  /*
+   * Our random-access file descriptor shares its file position with
+   * those of the parent and the other workers; get one of our own.
+   */
+  wtap_fdclose(cf->provider.wth);
+  if (!wtap_fdreopen(cf->provider.wth, cf->filename, &err)) {
+    status = PASS_READ_ERROR;
+  } else {
+    if (dup2(out_fd, 1) == -1) {
+      show_print_file_io_error();
+      _exit(2);
+    }
+    status = process_frames_second_pass(cf, NULL, edt, tap_flags,
+                                        first_framenum, last_framenum,
+                                        &err, &err_info, &err_framenum);
+    if (fflush(stdout) == EOF || ferror(stdout)) {
+      show_print_file_io_error();
+      _exit(2);
+    }
+  }
+
+  result.status = status;
+  result.err = err;
+  result.err_framenum = err_framenum;
+  result.err_info_len = err_info != NULL ? (guint32)strlen(err_info) : 0;
+  ret = ws_write(result_fd, &result, sizeof result);
+  if (result.err_info_len != 0)
+    ret = ws_write(result_fd, err_info, result.err_info_len);
+
+  /* Then the statistics of the frames we tapped, for the parent to merge. */
+  tap_states = g_byte_array_new();
+  tap_listeners_save_states(tap_states);
+  tap_states_len = tap_states->len;
+  ret = ws_write(result_fd, &tap_states_len, sizeof tap_states_len);
+  if (tap_states->len != 0)
+    ret = ws_write(result_fd, tap_states->data, tap_states->len);
+  ws_close(result_fd);
+
+  /* Don't run any exit-time cleanup; that's the parent's job. */
+  _exit(0);
+}
+
+/*
+ * Read exactly len bytes from a worker's result pipe, which a single
+ * read may not return all of.
+ */
+static gboolean
+second_pass_worker_read(second_pass_worker_t *worker, void *buf, size_t len)
+{
+  guint8  *p = (guint8 *)buf;
+  ssize_t  nread;
+
+  while (len != 0) {
+    nread = ws_read(worker->result_fd, p, (unsigned int)MIN(len, 65536));
+    if (nread <= 0)
+      return FALSE;
+    p += nread;
+    len -= (size_t)nread;
+  }
+  return TRUE;
+}
+
+/*
+ * Wait for a worker to finish and collect its result; if merge_taps is
+ * TRUE, merge the statistics it gathered into our tap listeners.
+ */
+static pass_status_t
+second_pass_worker_wait(second_pass_worker_t *worker, gboolean merge_taps,
+                        int *err, gchar **err_info,
+                        volatile guint32 *err_framenum)
+{
+  second_pass_worker_result_t result;
+  pass_status_t status;
+  guint64      tap_states_len;
+  int          wstatus;
+
+  if (ws_read(worker->result_fd, &result, sizeof result) != (ssize_t)sizeof result) {
+    /* The worker died without telling us how it went. */
+    status = PASS_READ_ERROR;
+    *err = WTAP_ERR_INTERNAL;
+    *err_info = g_strdup("tshark: second pass worker exited abnormally");
+  } else {
+    status = (pass_status_t)result.status;
+    *err = result.err;
+    *err_framenum = result.err_framenum;
+    if (result.err_info_len != 0) {
+      *err_info = (gchar *)g_malloc0(result.err_info_len + 1);
+      if (!second_pass_worker_read(worker, *err_info, result.err_info_len)) {
+        g_free(*err_info);
+        *err_info = NULL;
+      }
+    }
+    if (merge_taps &&
+        second_pass_worker_read(worker, &tap_states_len, sizeof tap_states_len)) {
+      guint8 *tap_states = (guint8 *)g_malloc(tap_states_len ? (gsize)tap_states_len : 1);
+
+      if (!second_pass_worker_read(worker, tap_states, (size_t)tap_states_len) ||
+          !tap_listeners_merge_states(tap_states, (gsize)tap_states_len)) {
+        if (status == PASS_SUCCEEDED) {
+          status = PASS_READ_ERROR;
+          *err = WTAP_ERR_INTERNAL;
+          g_free(*err_info);
+          *err_info = g_strdup("tshark: couldn't merge a second pass worker's statistics");
+        }
+      }
+      g_free(tap_states);
+    }
+  }
+  ws_close(worker->result_fd);
+  while (waitpid(worker->pid, &wstatus, 0) == -1 && errno == EINTR)
+    ;
+  worker->pid = 0;
+  return status;
+}
+
+/*
+ * Copy a worker's output to the standard output.
+ */
+static gboolean
+second_pass_worker_copy_output(second_pass_worker_t *worker)
+{
+  char    copybuf[65536];
+  ssize_t nread;
+
+  if (ws_lseek64(worker->out_fd, 0, SEEK_SET) == -1)
+    return FALSE;
+  while ((nread = ws_read(worker->out_fd, copybuf, sizeof copybuf)) > 0) {
+    if (fwrite(copybuf, 1, (size_t)nread, stdout) != (size_t)nread)
+      return FALSE;
+  }
+  if (line_buffered)
+    fflush(stdout);
+  return nread == 0 && !ferror(stdout);
+}
+
+static pass_status_t
+process_frames_second_pass_parallel(capture_file *cf, epan_dissect_t *edt,
+                                    guint tap_flags, guint num_workers,
+                                    int *err, gchar **err_info,
+                                    volatile guint32 *err_framenum)
+{
+  second_pass_worker_t *workers;
+  const frame_data *prev_dis = cf->provider.prev_dis;
+  guint32      range_cum_bytes = cum_bytes;
+  guint32      frames_per_worker, first_framenum, last_framenum, framenum;
+  guint        i, num_started;
+  pass_status_t status = PASS_SUCCEEDED;
+  GError      *gerr = NULL;
+
+  if (num_workers > cf->count)
+    num_workers = cf->count;
+  frames_per_worker = (cf->count + num_workers - 1) / num_workers;
+  workers = g_new0(second_pass_worker_t, num_workers);
+
+  /* Make sure nothing we've buffered gets printed by the workers, too. */
+  fflush(stdout);
+  fflush(stderr);
+
+  first_framenum = 1;
+  for (num_started = 0; num_started < num_workers && first_framenum <= cf->count; num_started++) {
+    second_pass_worker_t *worker = &workers[num_started];
+    int     result_pipe[2];
+    gchar  *out_path = NULL;
+
+    last_framenum = MIN(first_framenum + frames_per_worker - 1, cf->count);
+
+    worker->out_fd = create_tempfile(&out_path, "tshark_worker", NULL, &gerr);
+    if (worker->out_fd == -1) {
+      cmdarg_err("Couldn't create a temporary file for a second pass worker: %s",
+                 gerr->message);
+      g_clear_error(&gerr);
+      break;
+    }
+    /* The file stays around only as long as the descriptor is open. */
+    ws_unlink(out_path);
+    g_free(out_path);
+
+    if (pipe(result_pipe) == -1) {
+      cmdarg_err("Couldn't create a pipe for a second pass worker: %s",
+                 g_strerror(errno));
+      ws_close(worker->out_fd);
+      break;
+    }
+
+    /* Set up the state this range would have in a sequential pass. */
+    cf->provider.prev_dis = prev_dis;
+    cf->provider.prev_cap = (first_framenum > 1) ?
+        frame_data_sequence_find(cf->provider.frames, first_framenum - 1) : NULL;
+    cum_bytes = range_cum_bytes;
+
+    tshark_debug("tshark: starting second pass worker for frames %u-%u", first_framenum, last_framenum);
+    worker->pid = fork();
+    if (worker->pid == 0) {
+      /* Child. */
+      guint j;
+
+      ws_close(result_pipe[0]);
+      for (j = 0; j < num_started; j++) {
+        ws_close(workers[j].out_fd);
+        ws_close(workers[j].result_fd);
+      }
+      second_pass_worker_run(cf, edt, tap_flags, first_framenum,
+                             last_framenum, worker->out_fd, result_pipe[1]);
+      /* NOTREACHED */
+    }
+    ws_close(result_pipe[1]);
+    if (worker->pid == -1) {
+      cmdarg_err("Couldn't start a second pass worker: %s", g_strerror(errno));
+      ws_close(result_pipe[0]);
+      ws_close(worker->out_fd);
+      break;
+    }
+    worker->result_fd = result_pipe[0];
+
+    /* Work out the state at the beginning of the next range. */
+    for (framenum = first_framenum; framenum <= last_framenum; framenum++) {
+      const frame_data *fdata = frame_data_sequence_find(cf->provider.frames, framenum);
+
+      if (fdata->passed_dfilter) {
+        range_cum_bytes = fdata->ref_time ? fdata->pkt_len : range_cum_bytes + fdata->pkt_len;
+        prev_dis = fdata;
+      }
+    }
+    first_framenum = last_framenum + 1;
+  }
+
+  /*
+   * Collect the workers' output in frame order.  Once something's gone
+   * wrong, we still wait for the remaining workers, but we discard
+   * their output, as a sequential pass would have stopped there.
+   */
+  for (i = 0; i < num_started; i++) {
+    if (status == PASS_SUCCEEDED) {
+      status = second_pass_worker_wait(&workers[i], TRUE, err, err_info, err_framenum);
+      /* Whatever the worker printed before it stopped is still valid. */
+      if (!second_pass_worker_copy_output(&workers[i])) {
+        show_print_file_io_error();
+        exit(2);
+      }
+    } else {
+      int     junk_err;
+      gchar  *junk_err_info = NULL;
+      guint32 junk_framenum;
+
+      second_pass_worker_wait(&workers[i], FALSE, &junk_err, &junk_err_info, &junk_framenum);
+      g_free(junk_err_info);
+    }
+    ws_close(workers[i].out_fd);
+  }
+  g_free(workers);
+
+  cf->provider.prev_dis = prev_dis;
+  cf->provider.prev_cap = (first_framenum > 1) ?
+      frame_data_sequence_find(cf->provider.frames, first_framenum - 1) : NULL;
+  cum_bytes = range_cum_bytes;
+
+  /*
+   * If we couldn't start workers for all of the frames, do the rest
+   * ourselves; our dissection state is the same as the workers' was.
+   */
+  if (status == PASS_SUCCEEDED && first_framenum <= cf->count) {
+    status = process_frames_second_pass(cf, NULL, edt, tap_flags,
+                                        first_framenum, cf->count,
+                                        err, err_info, err_framenum);
+  }
+
+  return status;
+}
+#endif /* _WIN32 */
+
+static pass_status_t
+process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
+                             int *err, gchar **err_info,
+                             volatile guint32 *err_framenum)
+{
   gboolean        filtering_tap_listeners;
   guint           tap_flags;
   epan_dissect_t *edt = NULL;
-  pass_status_t   status = PASS_SUCCEEDED;
+  pass_status_t   status;
 
   /*
    * Process whatever IDBs we haven't seen yet.  This will be all
@@ -3350,14 +4248,12 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
     return PASS_WRITE_ERROR;
   }
 
-  wtap_rec_init(&rec);
-  ws_buffer_init(&buf, 1514);
-
   /* Do we have any tap listeners with filters? */
   filtering_tap_listeners = have_filtering_tap_listeners();
 
   /* Get the union of the flags for all tap listeners. */
   tap_flags = union_of_tap_listener_flags();
+  set_wanted_columns(cf, tap_flags);
 
   if (do_dissection) {
     gboolean create_proto_tree;
@@ -3385,7 +4281,8 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
        printing packet details, which is true if we're printing stuff
        ("print_packet_info" is true) and we're in verbose mode
        ("packet_details" is true). */
-    edt = epan_dissect_new(cf->epan, create_proto_tree, print_packet_info && print_details);
+    edt = epan_dissect_new(cf->epan, create_proto_tree,
+                           print_packet_info && print_details && !print_fields_only);
   }
 
   /*
@@ -3394,42 +4291,29 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
    */
   set_resolution_synchrony(TRUE);
 
-  for (framenum = 1; framenum <= cf->count; framenum++) {
-    if (read_interrupted) {
-      status = PASS_INTERRUPTED;
-      break;
-    }
-    fdata = frame_data_sequence_find(cf->provider.frames, framenum);
-    if (!wtap_seek_read(cf->provider.wth, fdata->file_off, &rec, &buf, err,
-                        err_info)) {
-      /* Error reading from the input file. */
-      status = PASS_READ_ERROR;
-      break;
-    }
-    tshark_debug("tshark: invoking process_packet_second_pass() for frame #%d", framenum);
-    if (process_packet_second_pass(cf, edt, fdata, &rec, &buf, tap_flags)) {
-      /* Either there's no read filtering or this packet passed the
-         filter, so, if we're writing to a capture file, write
-         this packet out. */
-      if (pdh != NULL) {
-        tshark_debug("tshark: writing packet #%d to outfile", framenum);
-        if (!wtap_dump(pdh, &rec, ws_buffer_start_ptr(&buf), err, err_info)) {
-          /* Error writing to the output file. */
-          tshark_debug("tshark: error writing to a capture file (%d)", *err);
-          *err_framenum = framenum;
-          status = PASS_WRITE_ERROR;
-          break;
-        }
-      }
+#ifndef _WIN32
+  if (num_second_pass_threads > 1 && cf->count > 1) {
+    const char *blocker = second_pass_parallel_blocker(cf, pdh);
+
+    if (blocker == NULL) {
+      status = process_frames_second_pass_parallel(cf, edt, tap_flags,
+                                                   num_second_pass_threads,
+                                                   err, err_info, err_framenum);
+      goto done;
     }
+    cmdarg_err("Not using multiple threads for the second pass, as %s.", blocker);
   }
+#endif
+
+  status = process_frames_second_pass(cf, pdh, edt, tap_flags, 1, cf->count,
+                                      err, err_info, err_framenum);
 
+#ifndef _WIN32
+done:
+#endif
   if (edt)
     epan_dissect_free(edt);
 
-  ws_buffer_free(&buf);
-  wtap_rec_cleanup(&rec);
-
   return status;
 }
 
@@ -3459,6 +4343,7 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
 
   /* Get the union of the flags for all tap listeners. */
   tap_flags = union_of_tap_listener_flags();
+  set_wanted_columns(cf, tap_flags);
 
   if (do_dissection) {
     /*
@@ -3492,7 +4377,8 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
        printing packet details, which is true if we're printing stuff
        ("print_packet_info" is true) and we're in verbose mode
        ("packet_details" is true). */
-    edt = epan_dissect_new(cf->epan, create_proto_tree, print_packet_info && print_details);
+    edt = epan_dissect_new(cf->epan, create_proto_tree,
+                           print_packet_info && print_details && !print_fields_only);
   }
 
   /*
@@ -3521,7 +4407,8 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
 
     tshark_debug("tshark: processing packet #%d", framenum);
 
-    reset_epan_mem(cf, edt, create_proto_tree, print_packet_info && print_details);
+    reset_epan_mem(cf, edt, create_proto_tree,
+                   print_packet_info && print_details && !print_fields_only);
 
     if (process_packet_single_pass(cf, edt, data_offset, &rec, &buf, tap_flags)) {
       /* Either there's no read filtering or this packet passed the
@@ -3564,6 +4451,111 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
   return status;
 }
 
+/*
+ * Process the capture files named on the standard input, one per line, as
+ * if each had been given with -r in a run of its own, but keeping the
+ * registrations, preferences and compiled filters of this run.  A line can
+ * give, after a tab, the file to write the packets of that capture to,
+ * instead of the one given with -w.  Statistics are drawn, and reset, after
+ * each capture.
+ */
+static int
+process_batch(int in_file_type, char *save_file, int out_file_type,
+    gboolean out_file_name_res, int max_packet_count, gint64 max_byte_count,
+    dfilter_t *rfcode, dfilter_t *dfcode)
+{
+  int       exit_status = EXIT_SUCCESS;
+  gboolean  stats_started = FALSE;
+  GString  *line = g_string_new(NULL);
+  int       c, err;
+
+  for (;;) {
+    char *in_file, *out_file;
+    volatile process_file_status_t status = PROCESS_FILE_SUCCEEDED;
+    volatile gboolean out_of_memory = FALSE;
+
+    g_string_truncate(line, 0);
+    while ((c = getc(stdin)) != EOF && c != '\n')
+      g_string_append_c(line, (gchar)c);
+    if (line->len == 0 && c == EOF)
+      break;
+    if (line->len > 0 && line->str[line->len - 1] == '\r')
+      g_string_truncate(line, line->len - 1);
+    if (line->len == 0)
+      continue;
+
+    in_file = line->str;
+    out_file = strchr(in_file, '\t');
+    if (out_file != NULL) {
+      *out_file++ = '\0';
+      if (save_file == NULL) {
+        cmdarg_err("%s: an output file can only be given for a capture with -w.", in_file);
+        exit_status = INVALID_OPTION;
+        continue;
+      }
+    } else {
+      out_file = save_file;
+    }
+    if (strcmp(in_file, "-") == 0) {
+      cmdarg_err("With --batch, a capture can't be read from the standard input.");
+      exit_status = INVALID_FILE;
+      continue;
+    }
+
+    tshark_debug("tshark: Opening capture file: %s", in_file);
+    if (cf_open(&cfile, in_file, in_file_type, FALSE, &err) != CF_OK) {
+      exit_status = INVALID_FILE;
+      continue;
+    }
+
+    if (!stats_started) {
+      /* As with -r, start the statistics taps once a capture file is
+         open, and see whether we have to dissect once they're listening. */
+      start_requested_stats();
+      do_dissection = must_do_dissection(rfcode, dfcode, NULL);
+      stats_started = TRUE;
+    }
+    cum_bytes = 0;
+
+    TRY {
+      status = process_cap_file(&cfile, out_file, out_file_type, out_file_name_res,
+                                max_packet_count, max_byte_count);
+    }
+    CATCH(OutOfMemoryError) {
+      fprintf(stderr,
+              "Out Of Memory.\n"
+              "\n"
+              "Sorry, but TShark has to terminate now.\n"
+              "\n"
+              "More information and workarounds can be found at\n"
+              WS_WIKI_URL("KnownBugs/OutOfMemory") "\n");
+      status = PROCESS_FILE_ERROR;
+      out_of_memory = TRUE;
+    }
+    ENDTRY;
+
+    /* As in main(), the statistics are drawn if any packets were read. */
+    if (status == PROCESS_FILE_SUCCEEDED || status == PROCESS_FILE_ERROR)
+      draw_tap_listeners(TRUE);
+    if (status != PROCESS_FILE_SUCCEEDED)
+      exit_status = 2;
+    reset_tap_listeners();
+
+    if (cfile.provider.frames != NULL) {
+      free_frame_data_sequence(cfile.provider.frames);
+      cfile.provider.frames = NULL;
+    }
+    cf_close(&cfile);
+    fflush(stdout);
+
+    if (status == PROCESS_FILE_INTERRUPTED || out_of_memory)
+      break;
+  }
+
+  g_string_free(line, TRUE);
+  return exit_status;
+}
+
 static process_file_status_t
 process_cap_file(capture_file *cf, char *save_file, int out_file_type,
     gboolean out_file_name_res, int max_packet_count, gint64 max_byte_count)
@@ -3809,6 +4801,65 @@ out:
   return status;
 }
 
+/*
+ * Report what the state kept across packets is made of, to keep an eye on
+ * the memory of long single-pass runs; only the last frame is kept, the
+ * rest is what the dissectors keep in the file scope.
+ */
+static void
+print_memory_stats(guint32 framenum)
+{
+  conversation_stats_t conv_stats;
+  reassembly_stats_t   reassembly_stats;
+
+  conversation_get_stats(&conv_stats);
+  reassembly_tables_get_stats(&reassembly_stats);
+
+  fprintf(stderr, "Memory after frame %u: %u conversations (%u expired); "
+          "reassemblies: %u pending (%" G_GUINT64_FORMAT " bytes), "
+          "%u complete (%" G_GUINT64_FORMAT " bytes), "
+          "%u dropped (%" G_GUINT64_FORMAT " bytes), "
+          "%" G_GUINT64_FORMAT " fragment lookups (%" G_GUINT64_FORMAT " new), "
+          "%" G_GUINT64_FORMAT " reassembled\n",
+          framenum, conv_stats.conversations, conv_stats.expired,
+          reassembly_stats.pending_heads, reassembly_stats.pending_bytes,
+          reassembly_stats.complete_heads, reassembly_stats.complete_bytes,
+          reassembly_stats.evicted_heads, reassembly_stats.evicted_bytes,
+          reassembly_stats.lookups, reassembly_stats.lookup_misses,
+          reassembly_stats.completed);
+
+  if (cpu_affinity_set) {
+    /* Memory on other nodes than that of the CPUs is accessed remotely */
+    GString *nodes = g_string_new(NULL);
+
+    if (ws_numa_get_memory_nodes(nodes))
+      fprintf(stderr, "Memory after frame %u by NUMA node: %s\n", framenum, nodes->str);
+    g_string_free(nodes, TRUE);
+  }
+}
+
+/*
+ * Is a record in the shard being dissected?  The packets of a flow all
+ * go to the same shard, chosen by a hash of the flow, in either
+ * direction; the packets that aren't IP, or whose headers can't be
+ * parsed, and the records that aren't packets, all go to shard 0.
+ */
+static gboolean
+record_in_shard(const wtap_rec *rec, Buffer *buf)
+{
+  capture_flow_key key;
+  int linktype;
+
+  if (rec->rec_type != REC_TYPE_PACKET)
+    return shard_index == 0;
+  linktype = wtap_wtap_encap_to_pcap_encap(rec->rec_header.packet_header.pkt_encap);
+  if (linktype == -1 ||
+      !capture_flow_parse(linktype, ws_buffer_start_ptr(buf),
+                          rec->rec_header.packet_header.caplen, &key))
+    return shard_index == 0;
+  return capture_flow_hash(&key) % shard_count == shard_index;
+}
+
 static gboolean
 process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
                            wtap_rec *rec, Buffer *buf, guint tap_flags)
@@ -3827,6 +4878,25 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
 
   frame_data_init(&fdata, cf->count, rec, offset, cum_bytes);
 
+  /* A packet of a flow in another shard isn't dissected, so none of
+     the state of its conversation is built up here, but it keeps its
+     frame number, and it's still the previously captured frame for
+     the next one. */
+  if (shard_count > 1 && !record_in_shard(rec, buf)) {
+    prev_cap_frame = fdata;
+    cf->provider.prev_cap = &prev_cap_frame;
+    return FALSE;
+  }
+
+#ifdef HAVE_LIBPCAP
+  /* Nor is a packet that doesn't match the capture filter. */
+  if (read_bpf_filter != NULL && !record_passes_read_bpf_filter(rec, buf)) {
+    prev_cap_frame = fdata;
+    cf->provider.prev_cap = &prev_cap_frame;
+    return FALSE;
+  }
+#endif
+
   /* If we're going to print packet information, or we're going to
      run a read filter, or we're going to process taps, set up to
      do a dissection and do so.  (This is the one and only pass
@@ -3844,6 +4914,10 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
 
     col_custom_prime_edt(edt, &cf->cinfo);
 
+    /* If we're writing fields from an invisible tree, prime it with them. */
+    if (print_packet_info && print_fields_only)
+      output_fields_prime_edt(output_fields, edt);
+
     /* We only need the columns if either
          1) some tap needs the columns
        or
@@ -3911,6 +4985,10 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
     epan_dissect_reset(edt);
     frame_data_destroy(&fdata);
   }
+
+  if (memory_stats_interval != 0 && cf->count % memory_stats_interval == 0)
+    print_memory_stats(cf->count);
+
   return passed;
 }
 
@@ -3941,6 +5019,10 @@ write_preamble(capture_file *cf)
   case WRITE_EK:
     return TRUE;
 
+  case WRITE_ARROW:
+    awriter = write_arrow_preamble(output_fields, stdout);
+    return !ferror(stdout);
+
   default:
     g_assert_not_reached();
     return FALSE;
@@ -4313,6 +5395,9 @@ print_packet(capture_file *cf, epan_dissect_t *edt)
                         protocolfilter_flags, edt, &cf->cinfo, stdout);
     return !ferror(stdout);
 
+  case WRITE_ARROW:
+    return write_arrow_proto_tree(output_fields, edt, &cf->cinfo, awriter);
+
   default:
     g_assert_not_reached();
   }
@@ -4357,6 +5442,9 @@ write_finale(void)
   case WRITE_EK:
     return TRUE;
 
+  case WRITE_ARROW:
+    return write_arrow_finale(awriter);
+
   default:
     g_assert_not_reached();
     return FALSE;
@@ -4440,6 +5528,208 @@ fail:
   return CF_ERROR;
 }
 
+#ifndef _WIN32
+/*
+ * With --output-thread, the standard output is a pipe, from which one
+ * thread reads what we print and queues it, and another writes it to
+ * the real standard output; a slow reader holds up only the latter,
+ * until OUTPUT_THREAD_MAX_QUEUED bytes are waiting for it, and the
+ * writes are done while the packets after them are being dissected.
+ */
+#define OUTPUT_THREAD_CHUNK_SIZE  (256 * 1024)
+#define OUTPUT_THREAD_MAX_QUEUED  (64 * 1024 * 1024)
+
+typedef struct {
+  int       pipe_fd;        /* the end of the pipe the standard output goes to */
+  int       out_fd;         /* the real standard output */
+  GThread  *reader;
+  GThread  *writer;
+  GMutex    mutex;          /* protects all that follows */
+  GCond     cond;
+  GQueue    chunks;         /* GByteArrays read and not yet written */
+  gsize     queued;         /* the bytes in them */
+  gboolean  eof;            /* the pipe's been closed */
+  int       write_err;      /* the errno of a failed write, or 0 */
+} output_thread_t;
+
+static output_thread_t *output_thread;
+
+static gpointer
+output_thread_read(gpointer data)
+{
+  output_thread_t *ot = (output_thread_t *)data;
+  guint8          *buf = (guint8 *)g_malloc(OUTPUT_THREAD_CHUNK_SIZE);
+  GByteArray      *chunk;
+  ssize_t          nread;
+
+  for (;;) {
+    nread = read(ot->pipe_fd, buf, OUTPUT_THREAD_CHUNK_SIZE);
+    if (nread == -1 && errno == EINTR)
+      continue;
+    if (nread <= 0)
+      break;
+    chunk = g_byte_array_sized_new((guint)nread);
+    g_byte_array_append(chunk, buf, (guint)nread);
+
+    g_mutex_lock(&ot->mutex);
+    while (ot->queued >= OUTPUT_THREAD_MAX_QUEUED && ot->write_err == 0)
+      g_cond_wait(&ot->cond, &ot->mutex);
+    if (ot->write_err != 0) {
+      /* Nothing more can be written; make our writes fail, too, so
+         that we stop. */
+      g_mutex_unlock(&ot->mutex);
+      g_byte_array_free(chunk, TRUE);
+      break;
+    }
+    g_queue_push_tail(&ot->chunks, chunk);
+    ot->queued += chunk->len;
+    g_cond_broadcast(&ot->cond);
+    g_mutex_unlock(&ot->mutex);
+  }
+  close(ot->pipe_fd);
+  ot->pipe_fd = -1;
+  g_free(buf);
+
+  g_mutex_lock(&ot->mutex);
+  ot->eof = TRUE;
+  g_cond_broadcast(&ot->cond);
+  g_mutex_unlock(&ot->mutex);
+  return NULL;
+}
+
+static gpointer
+output_thread_write(gpointer data)
+{
+  output_thread_t *ot = (output_thread_t *)data;
+  GByteArray      *out = g_byte_array_new();
+  GByteArray      *chunk;
+  const guint8    *p;
+  gsize            left;
+  ssize_t          nwritten;
+
+  for (;;) {
+    /* Write everything queued at once, as far as a chunk's worth. */
+    g_mutex_lock(&ot->mutex);
+    while (g_queue_is_empty(&ot->chunks) && !ot->eof)
+      g_cond_wait(&ot->cond, &ot->mutex);
+    g_byte_array_set_size(out, 0);
+    while (out->len < OUTPUT_THREAD_CHUNK_SIZE &&
+           (chunk = (GByteArray *)g_queue_pop_head(&ot->chunks)) != NULL) {
+      g_byte_array_append(out, chunk->data, chunk->len);
+      ot->queued -= chunk->len;
+      g_byte_array_free(chunk, TRUE);
+    }
+    g_cond_broadcast(&ot->cond);
+    g_mutex_unlock(&ot->mutex);
+    if (out->len == 0)
+      break;
+
+    p = out->data;
+    left = out->len;
+    while (left != 0) {
+      nwritten = write(ot->out_fd, p, left);
+      if (nwritten == -1) {
+        if (errno == EINTR)
+          continue;
+        g_mutex_lock(&ot->mutex);
+        ot->write_err = errno;
+        g_cond_broadcast(&ot->cond);
+        g_mutex_unlock(&ot->mutex);
+        g_byte_array_free(out, TRUE);
+        return NULL;
+      }
+      p += nwritten;
+      left -= (gsize)nwritten;
+    }
+  }
+  g_byte_array_free(out, TRUE);
+  return NULL;
+}
+
+static void
+output_thread_stop_at_exit(void)
+{
+  /* Write out what's queued if we exit() without going through
+     output_thread_stop(); the standard output is flushed before
+     this is called. */
+  output_thread_stop();
+}
+
+static gboolean
+output_thread_start(void)
+{
+  output_thread_t *ot;
+  int              fds[2];
+  int              out_fd;
+
+  if (pipe(fds) == -1)
+    return FALSE;
+  fflush(stdout);
+  out_fd = dup(1);
+  if (out_fd == -1 || dup2(fds[1], 1) == -1) {
+    int save_errno = errno;
+
+    if (out_fd != -1)
+      close(out_fd);
+    close(fds[0]);
+    close(fds[1]);
+    errno = save_errno;
+    return FALSE;
+  }
+  close(fds[1]);
+
+  ot = g_new0(output_thread_t, 1);
+  ot->pipe_fd = fds[0];
+  ot->out_fd = out_fd;
+  g_mutex_init(&ot->mutex);
+  g_cond_init(&ot->cond);
+  g_queue_init(&ot->chunks);
+  ot->reader = g_thread_new("tshark output reader", output_thread_read, ot);
+  ot->writer = g_thread_new("tshark output writer", output_thread_write, ot);
+  output_thread = ot;
+  atexit(output_thread_stop_at_exit);
+  return TRUE;
+}
+
+/*
+ * Write out everything that's been printed and put the standard output
+ * back; FALSE, after reporting it, if not all of it could be written.
+ */
+static gboolean
+output_thread_stop(void)
+{
+  output_thread_t *ot = output_thread;
+  GByteArray      *chunk;
+  int              write_err;
+
+  if (ot == NULL)
+    return TRUE;
+  output_thread = NULL;
+
+  /* Putting the real standard output back closes our end of the pipe,
+     so the reader sees its end, and then the writer does. */
+  fflush(stdout);
+  dup2(ot->out_fd, 1);
+  g_thread_join(ot->reader);
+  g_thread_join(ot->writer);
+  close(ot->out_fd);
+
+  write_err = ot->write_err;
+  while ((chunk = (GByteArray *)g_queue_pop_head(&ot->chunks)) != NULL)
+    g_byte_array_free(chunk, TRUE);
+  g_cond_clear(&ot->cond);
+  g_mutex_clear(&ot->mutex);
+  g_free(ot);
+
+  if (write_err != 0) {
+    errno = write_err;
+    show_print_file_io_error();
+    return FALSE;
+  }
+  return TRUE;
+}
+#endif /* _WIN32 */
+
 static void
 show_print_file_io_error(void)
 {
@@ -0,0 +1,112 @@
+/* tap-dissector-prof.c
+ * Time spent in each dissector, for tshark
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+#include <ui/cmdarg_err.h>
+
+void register_tap_listener_dissector_prof(void);
+
+/* Print the profile of each dissector, by decreasing self time */
+static void
+dissector_prof_draw(void *tapdata _U_)
+{
+    GPtrArray           *profiles = dissector_profiling_get();
+    dissector_profile_t *profile;
+    gint64               self_total = 0;
+    gchar                name[64];
+    guint                i;
+
+    for (i = 0; i < profiles->len; i++) {
+        profile = (dissector_profile_t *)g_ptr_array_index(profiles, i);
+        self_total += profile->self_time;
+    }
+
+    printf("\n");
+    printf("===================================================================================================\n");
+    printf("Dissector Profile (times in milliseconds)\n");
+    printf("%-24s %-12s %10s %10s %8s %14s %10s %10s %6s\n",
+           "Dissector", "Protocol", "Calls", "Accepted", "Except.", "Bytes", "Total", "Self", "Self%");
+    printf("---------------------------------------------------------------------------------------------------\n");
+    for (i = 0; i < profiles->len; i++) {
+        profile = (dissector_profile_t *)g_ptr_array_index(profiles, i);
+        g_snprintf(name, sizeof name, profile->heuristic ? "%s (heur)" : "%s", profile->name);
+        printf("%-24s %-12s %10" G_GUINT64_FORMAT " %10" G_GUINT64_FORMAT " %8" G_GUINT64_FORMAT
+               " %14" G_GUINT64_FORMAT " %10.1f %10.1f %6.2f\n",
+               name,
+               profile->protocol ? profile->protocol : "",
+               profile->calls, profile->accepted, profile->exceptions, profile->bytes,
+               profile->total_time / 1000.0, profile->self_time / 1000.0,
+               self_total ? 100.0 * profile->self_time / self_total : 0.0);
+    }
+    printf("===================================================================================================\n");
+
+    g_ptr_array_free(profiles, TRUE);
+}
+
+static void
+dissector_prof_init(const char *opt_arg, void *userdata _U_)
+{
+    GString *error_string;
+
+    if (strcmp(opt_arg, "dissector,prof") != 0) {
+        cmdarg_err("invalid \"-z dissector,prof\" argument");
+        exit(1);
+    }
+
+    /* The statistics come from the calls of the dissectors rather than
+       from a tap; the listener is only there to print them at the end. */
+    dissector_profiling_reset();
+    dissector_profiling_enable(TRUE);
+
+    error_string = register_tap_listener("frame", NULL, NULL, 0, NULL, NULL,
+                                         dissector_prof_draw, NULL);
+    if (error_string) {
+        cmdarg_err("Couldn't register dissector,prof tap: %s", error_string->str);
+        g_string_free(error_string, TRUE);
+        exit(1);
+    }
+}
+
+static stat_tap_ui dissector_prof_ui = {
+    REGISTER_STAT_GROUP_GENERIC,
+    NULL,
+    "dissector,prof",
+    dissector_prof_init,
+    0,
+    NULL
+};
+
+void
+register_tap_listener_dissector_prof(void)
+{
+    register_stat_tap_ui(&dissector_prof_ui, NULL);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
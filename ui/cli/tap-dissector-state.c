@@ -0,0 +1,112 @@
+/* tap-dissector-state.c
+ * Check of the dissectors registered as stateless, for tshark
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+#include <ui/cmdarg_err.h>
+
+void register_tap_listener_dissector_state(void);
+
+/* Print what each stateless dissector called did, those that wrote state
+   first */
+static void
+dissector_state_draw(void *tapdata _U_)
+{
+    GPtrArray               *checks = dissector_state_checking_get();
+    dissector_state_check_t *check;
+    guint                    i, failed = 0;
+
+    printf("\n");
+    printf("===================================================================================================\n");
+    printf("Stateless Dissector Check\n");
+    printf("%-24s %-12s %12s %12s %12s  %s\n",
+           "Dissector", "Protocol", "Calls", "Writes", "First frame", "First write");
+    printf("---------------------------------------------------------------------------------------------------\n");
+    for (i = 0; i < checks->len; i++) {
+        check = (dissector_state_check_t *)g_ptr_array_index(checks, i);
+        if (check->writes != 0) {
+            failed++;
+            printf("%-24s %-12s %12" G_GUINT64_FORMAT " %12" G_GUINT64_FORMAT " %12u  %s\n",
+                   check->name,
+                   check->protocol ? check->protocol : "",
+                   check->calls, check->writes, check->first_frame, check->first_write);
+        } else {
+            printf("%-24s %-12s %12" G_GUINT64_FORMAT " %12" G_GUINT64_FORMAT "\n",
+                   check->name,
+                   check->protocol ? check->protocol : "",
+                   check->calls, check->writes);
+        }
+    }
+    printf("---------------------------------------------------------------------------------------------------\n");
+    printf("%u of %u stateless dissectors called wrote state\n", failed, checks->len);
+    printf("===================================================================================================\n");
+
+    g_ptr_array_free(checks, TRUE);
+}
+
+static void
+dissector_state_init(const char *opt_arg, void *userdata _U_)
+{
+    GString *error_string;
+
+    if (strcmp(opt_arg, "dissector,state") != 0) {
+        cmdarg_err("invalid \"-z dissector,state\" argument");
+        exit(1);
+    }
+
+    /* As with "dissector,prof", the listener is only there to print the
+       check at the end. */
+    dissector_state_checking_reset();
+    dissector_state_checking_enable(TRUE);
+
+    error_string = register_tap_listener("frame", NULL, NULL, 0, NULL, NULL,
+                                         dissector_state_draw, NULL);
+    if (error_string) {
+        cmdarg_err("Couldn't register dissector,state tap: %s", error_string->str);
+        g_string_free(error_string, TRUE);
+        exit(1);
+    }
+}
+
+static stat_tap_ui dissector_state_ui = {
+    REGISTER_STAT_GROUP_GENERIC,
+    NULL,
+    "dissector,state",
+    dissector_state_init,
+    0,
+    NULL
+};
+
+void
+register_tap_listener_dissector_state(void)
+{
+    register_stat_tap_ui(&dissector_state_ui, NULL);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -117,6 +117,7 @@ void init_hostlists(struct register_ct *ct, const char *filter)
 		g_string_free(error_string, TRUE);
 		exit(1);
 	}
+	set_tap_listener_mergeable(&iu->hash, hostlist_table_save_state, hostlist_table_merge_state);
 
 }
 
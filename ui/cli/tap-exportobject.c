@@ -29,6 +29,9 @@
 typedef struct _export_object_list_gui_t {
     GSList *entries;
     register_eo_t* eo;
+    const gchar *save_in_path;
+    gboolean path_checked;  /* we've tried to create save_in_path */
+    gboolean path_failed;   /* and failed */
 } export_object_list_gui_t;
 
 static GHashTable* eo_opts = NULL;
@@ -82,12 +85,67 @@ gboolean eo_tap_opt_add(const char *option_string)
     return FALSE;
 }
 
+static gboolean
+eo_check_save_in_path(export_object_list_gui_t *object_list)
+{
+    if (!object_list->path_checked) {
+        object_list->path_checked = TRUE;
+        if (!g_file_test(object_list->save_in_path, G_FILE_TEST_IS_DIR)) {
+            /* If the destination directory (or its parents) do not exist, create them. */
+            if (g_mkdir_with_parents(object_list->save_in_path, 0755) == -1) {
+                fprintf(stderr, "Failed to create export objects output directory \"%s\": %s\n",
+                        object_list->save_in_path, g_strerror(errno));
+                object_list->path_failed = TRUE;
+            }
+        }
+    }
+    return !object_list->path_failed;
+}
+
+static void
+eo_write_entry(export_object_list_gui_t *object_list, export_object_entry_t *entry)
+{
+    GString *safe_filename = NULL;
+    gchar *save_as_fullpath = NULL;
+    guint count = 0;
+
+    do {
+        g_free(save_as_fullpath);
+        if (entry->filename) {
+            safe_filename = eo_massage_str(entry->filename,
+                EXPORT_OBJECT_MAXFILELEN, count);
+        } else {
+            char generic_name[EXPORT_OBJECT_MAXFILELEN+1];
+            const char *ext;
+            ext = eo_ct2ext(entry->content_type);
+            g_snprintf(generic_name, sizeof(generic_name),
+                "object%u%s%s", entry->pkt_num, ext ? "." : "", ext ? ext : "");
+            safe_filename = eo_massage_str(generic_name,
+                EXPORT_OBJECT_MAXFILELEN, count);
+        }
+        save_as_fullpath = g_build_filename(object_list->save_in_path, safe_filename->str, NULL);
+        g_string_free(safe_filename, TRUE);
+    } while (g_file_test(save_as_fullpath, G_FILE_TEST_EXISTS) && ++count < prefs.gui_max_export_objects);
+    eo_save_entry(save_as_fullpath, entry);
+    g_free(save_as_fullpath);
+}
+
 static void
 object_list_add_entry(void *gui_data, export_object_entry_t *entry)
 {
     export_object_list_gui_t *object_list = (export_object_list_gui_t*)gui_data;
 
-    object_list->entries = g_slist_append(object_list->entries, entry);
+    if (get_eo_updates_entries(object_list->eo)) {
+        /* It isn't complete until all the packets have been read. */
+        object_list->entries = g_slist_append(object_list->entries, entry);
+        return;
+    }
+
+    /* Write it out now, rather than keeping every object in memory
+       until the end. */
+    if (eo_check_save_in_path(object_list))
+        eo_write_entry(object_list, entry);
+    eo_free_entry(entry);
 }
 
 static export_object_entry_t*
@@ -103,51 +161,19 @@ eo_draw(void *tapdata)
 {
     export_object_list_t *tap_object = (export_object_list_t *)tapdata;
     export_object_list_gui_t *object_list = (export_object_list_gui_t*)tap_object->gui_data;
-    GSList *slist = object_list->entries;
-    export_object_entry_t *entry;
-    gchar* save_in_path = (gchar*)g_hash_table_lookup(eo_opts, proto_get_protocol_filter_name(get_eo_proto_id(object_list->eo)));
-    GString *safe_filename = NULL;
-    gchar *save_as_fullpath = NULL;
-    guint count = 0;
+    GSList *slist;
 
-    if (!g_file_test(save_in_path, G_FILE_TEST_IS_DIR)) {
-        /* If the destination directory (or its parents) do not exist, create them. */
-        if (g_mkdir_with_parents(save_in_path, 0755) == -1) {
-            fprintf(stderr, "Failed to create export objects output directory \"%s\": %s\n",
-                    save_in_path, g_strerror(errno));
-            return;
-        }
-    }
+    if (object_list->entries == NULL || !eo_check_save_in_path(object_list))
+        return;
 
-    while (slist) {
-        entry = (export_object_entry_t *)slist->data;
-        do {
-            g_free(save_as_fullpath);
-            if (entry->filename) {
-                safe_filename = eo_massage_str(entry->filename,
-                    EXPORT_OBJECT_MAXFILELEN, count);
-            } else {
-                char generic_name[EXPORT_OBJECT_MAXFILELEN+1];
-                const char *ext;
-                ext = eo_ct2ext(entry->content_type);
-                g_snprintf(generic_name, sizeof(generic_name),
-                    "object%u%s%s", entry->pkt_num, ext ? "." : "", ext ? ext : "");
-                safe_filename = eo_massage_str(generic_name,
-                    EXPORT_OBJECT_MAXFILELEN, count);
-            }
-            save_as_fullpath = g_build_filename(save_in_path, safe_filename->str, NULL);
-            g_string_free(safe_filename, TRUE);
-        } while (g_file_test(save_as_fullpath, G_FILE_TEST_EXISTS) && ++count < prefs.gui_max_export_objects);
-        count = 0;
-        eo_save_entry(save_as_fullpath, entry);
-        g_free(save_as_fullpath);
-        save_as_fullpath = NULL;
-        slist = slist->next;
-    }
+    for (slist = object_list->entries; slist; slist = slist->next)
+        eo_write_entry(object_list, (export_object_entry_t *)slist->data);
+    g_slist_free_full(object_list->entries, (GDestroyNotify)eo_free_entry);
+    object_list->entries = NULL;
 }
 
 static void
-exportobject_handler(gpointer key, gpointer value _U_, gpointer user_data _U_)
+exportobject_handler(gpointer key, gpointer value, gpointer user_data _U_)
 {
     GString *error_msg;
     export_object_list_t *tap_data;
@@ -169,6 +195,7 @@ exportobject_handler(gpointer key, gpointer value _U_, gpointer user_data _U_)
     tap_data->gui_data = (void*)object_list;
 
     object_list->eo = eo;
+    object_list->save_in_path = (const gchar*)value;
 
     /* Data will be gathered via a tap callback */
     error_msg = register_tap_listener(get_eo_tap_listener_name(eo), tap_data, NULL, 0,
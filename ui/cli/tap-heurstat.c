@@ -0,0 +1,116 @@
+/* tap-heurstat.c
+ * Calls of the heuristic dissectors, for tshark
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <epan/packet.h>
+#include <epan/prefs.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+#include <ui/cmdarg_err.h>
+
+void register_tap_listener_heurstat(void);
+
+static void
+heurstat_draw_entry(const gchar *table_name _U_, heur_dtbl_entry_t *hdtbl_entry, gpointer user_data _U_)
+{
+    if (hdtbl_entry->tries == 0) {
+        return;
+    }
+    printf("  %-30s %14" G_GUINT64_FORMAT " %14" G_GUINT64_FORMAT " %6.2f\n",
+           hdtbl_entry->short_name, hdtbl_entry->tries, hdtbl_entry->accepted,
+           100.0 * hdtbl_entry->accepted / hdtbl_entry->tries);
+}
+
+static void
+heurstat_draw_list(const char *table_name, struct heur_dissector_list *table, gpointer user_data _U_)
+{
+    heur_dissector_list_stats_t stats;
+
+    heur_dissector_list_get_stats(table, &stats);
+    if (stats.calls == 0) {
+        return;
+    }
+
+    printf("\n%s: %" G_GUINT64_FORMAT " packets, %" G_GUINT64_FORMAT " accepted, %.2f tries per packet",
+           table_name, stats.calls, stats.accepted, (double)stats.tries / stats.calls);
+    if (prefs.heuristic_adaptive_order) {
+        printf(", %" G_GUINT64_FORMAT " accepted by the conversation's last one", stats.cache_hits);
+    }
+    printf("\n");
+    printf("  %-30s %14s %14s %6s\n", "Heuristic", "Tries", "Accepted", "Rate%");
+    heur_dissector_table_foreach(table_name, heurstat_draw_entry, NULL);
+}
+
+/* Print the statistics of each heuristic list that was tried, with its
+ * dissectors in the order they are tried in now */
+static void
+heurstat_draw(void *tapdata _U_)
+{
+    printf("\n");
+    printf("===================================================================================================\n");
+    printf("Heuristic Dissector Statistics\n");
+    dissector_all_heur_tables_foreach_table(heurstat_draw_list, NULL, (GCompareFunc)strcmp);
+    printf("===================================================================================================\n");
+}
+
+static void
+heurstat_init(const char *opt_arg, void *userdata _U_)
+{
+    GString *error_string;
+
+    if (strcmp(opt_arg, "heur,stat") != 0) {
+        cmdarg_err("invalid \"-z heur,stat\" argument");
+        exit(1);
+    }
+
+    /* The heuristic lists count their calls themselves; the listener is
+       only there to print them at the end. */
+    error_string = register_tap_listener("frame", NULL, NULL, 0, NULL, NULL,
+                                         heurstat_draw, NULL);
+    if (error_string) {
+        cmdarg_err("Couldn't register heur,stat tap: %s", error_string->str);
+        g_string_free(error_string, TRUE);
+        exit(1);
+    }
+}
+
+static stat_tap_ui heurstat_ui = {
+    REGISTER_STAT_GROUP_GENERIC,
+    NULL,
+    "heur,stat",
+    heurstat_init,
+    0,
+    NULL
+};
+
+void
+register_tap_listener_heurstat(void)
+{
+    register_stat_tap_ui(&heurstat_ui, NULL);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -57,6 +57,7 @@ typedef struct _io_stat_t {
     const char **filters; /* 'io,stat' cmd strings (e.g., "AVG(smb.time)smb.time") */
     guint64 *max_vals;    /* The max value sans the decimal or nsecs portion in each stat column */
     guint32 *max_frame;   /* The max frame number displayed in each stat column */
+    guint64 merged_duration; /* The duration of the captures whose statistics were merged in (us) */
 } io_stat_t;
 
 typedef struct _io_stat_item_t {
@@ -78,13 +79,122 @@ typedef struct _io_stat_item_t {
 
 static guint64 last_relative_time;
 
+/* Get the item of a column for a time, which must be no earlier than the
+ * last interval in which we saw packets. */
+static io_stat_item_t *
+iostat_item_for_time(io_stat_item_t *mit, guint64 rt)
+{
+    io_stat_t *parent = mit->parent;
+    io_stat_item_t *it;
+
+    /* The prev item is always the last interval in which we saw packets. */
+    it = mit->prev;
+
+    /* If we have moved into a new interval (row), create a new io_stat_item_t struct for every interval
+    *  between the last struct and this one. If an item was not found in a previous interval, an empty
+    *  struct will be created for it. */
+    while (rt >= it->start_time + parent->interval) {
+        it->next = g_new(io_stat_item_t, 1);
+        it->next->prev = it;
+        it->next->next = NULL;
+        it = it->next;
+        mit->prev = it;
+
+        it->start_time = it->prev->start_time + parent->interval;
+        it->frames = 0;
+        it->counter = 0;
+        it->float_counter = 0;
+        it->double_counter = 0;
+        it->num = 0;
+        it->calc_type = it->prev->calc_type;
+        it->hf_index = it->prev->hf_index;
+        it->colnum = it->prev->colnum;
+    }
+    return it;
+}
+
+static void
+iostat_update_max(io_stat_t *parent, io_stat_item_t *it)
+{
+    int ftype;
+
+    /* Store the highest value for this item in order to determine the width of each stat column.
+    *  For real numbers we only need to know its magnitude (the value to the left of the decimal point
+    *  so round it up before storing it as an integer in max_vals. For AVG of RELATIVE_TIME fields,
+    *  calc the average, round it to the next second and store the seconds. For all other calc types
+    *  of RELATIVE_TIME fields, store the counters without modification.
+    *  fields. */
+    switch (it->calc_type) {
+        case CALC_TYPE_FRAMES:
+        case CALC_TYPE_FRAMES_AND_BYTES:
+            parent->max_frame[it->colnum] =
+                MAX(parent->max_frame[it->colnum], it->frames);
+            if (it->calc_type == CALC_TYPE_FRAMES_AND_BYTES)
+                parent->max_vals[it->colnum] =
+                    MAX(parent->max_vals[it->colnum], it->counter);
+            break;
+        case CALC_TYPE_BYTES:
+        case CALC_TYPE_COUNT:
+        case CALC_TYPE_LOAD:
+            parent->max_vals[it->colnum] = MAX(parent->max_vals[it->colnum], it->counter);
+            break;
+        case CALC_TYPE_SUM:
+        case CALC_TYPE_MIN:
+        case CALC_TYPE_MAX:
+            ftype = proto_registrar_get_ftype(it->hf_index);
+            switch (ftype) {
+                case FT_FLOAT:
+                    parent->max_vals[it->colnum] =
+                        MAX(parent->max_vals[it->colnum], (guint64)(it->float_counter+0.5));
+                    break;
+                case FT_DOUBLE:
+                    parent->max_vals[it->colnum] =
+                        MAX(parent->max_vals[it->colnum], (guint64)(it->double_counter+0.5));
+                    break;
+                case FT_RELATIVE_TIME:
+                    parent->max_vals[it->colnum] =
+                        MAX(parent->max_vals[it->colnum], it->counter);
+                    break;
+                default:
+                    /* UINT16-64 and INT8-64 */
+                    parent->max_vals[it->colnum] =
+                        MAX(parent->max_vals[it->colnum], it->counter);
+                    break;
+            }
+            break;
+        case CALC_TYPE_AVG:
+            if (it->num == 0) /* avoid division by zero */
+               break;
+            ftype = proto_registrar_get_ftype(it->hf_index);
+            switch (ftype) {
+                case FT_FLOAT:
+                    parent->max_vals[it->colnum] =
+                        MAX(parent->max_vals[it->colnum], (guint64)it->float_counter/it->num);
+                    break;
+                case FT_DOUBLE:
+                    parent->max_vals[it->colnum] =
+                        MAX(parent->max_vals[it->colnum], (guint64)it->double_counter/it->num);
+                    break;
+                case FT_RELATIVE_TIME:
+                    parent->max_vals[it->colnum] =
+                        MAX(parent->max_vals[it->colnum], ((it->counter/(guint64)it->num) + G_GUINT64_CONSTANT(500000000)) / NANOSECS_PER_SEC);
+                    break;
+                default:
+                    /* UINT16-64 and INT8-64 */
+                    parent->max_vals[it->colnum] =
+                        MAX(parent->max_vals[it->colnum], it->counter/it->num);
+                    break;
+            }
+    }
+}
+
 static tap_packet_status
 iostat_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt, const void *dummy _U_)
 {
     io_stat_t *parent;
     io_stat_item_t *mit;
     io_stat_item_t *it;
-    guint64 relative_time, rt;
+    guint64 relative_time;
     nstime_t *new_time;
     GPtrArray *gp;
     guint i;
@@ -107,30 +217,7 @@ iostat_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt, const void *du
         mit->parent->start_time = pinfo->abs_ts.secs - pinfo->rel_ts.secs;
     }
 
-    /* The prev item is always the last interval in which we saw packets. */
-    it = mit->prev;
-
-    /* If we have moved into a new interval (row), create a new io_stat_item_t struct for every interval
-    *  between the last struct and this one. If an item was not found in a previous interval, an empty
-    *  struct will be created for it. */
-    rt = relative_time;
-    while (rt >= it->start_time + parent->interval) {
-        it->next = g_new(io_stat_item_t, 1);
-        it->next->prev = it;
-        it->next->next = NULL;
-        it = it->next;
-        mit->prev = it;
-
-        it->start_time = it->prev->start_time + parent->interval;
-        it->frames = 0;
-        it->counter = 0;
-        it->float_counter = 0;
-        it->double_counter = 0;
-        it->num = 0;
-        it->calc_type = it->prev->calc_type;
-        it->hf_index = it->prev->hf_index;
-        it->colnum = it->prev->colnum;
-    }
+    it = iostat_item_for_time(mit, relative_time);
 
     /* Store info in the current structure */
     it->frames++;
@@ -438,74 +525,7 @@ iostat_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt, const void *du
         }
         break;
     }
-    /* Store the highest value for this item in order to determine the width of each stat column.
-    *  For real numbers we only need to know its magnitude (the value to the left of the decimal point
-    *  so round it up before storing it as an integer in max_vals. For AVG of RELATIVE_TIME fields,
-    *  calc the average, round it to the next second and store the seconds. For all other calc types
-    *  of RELATIVE_TIME fields, store the counters without modification.
-    *  fields. */
-    switch (it->calc_type) {
-        case CALC_TYPE_FRAMES:
-        case CALC_TYPE_FRAMES_AND_BYTES:
-            parent->max_frame[it->colnum] =
-                MAX(parent->max_frame[it->colnum], it->frames);
-            if (it->calc_type == CALC_TYPE_FRAMES_AND_BYTES)
-                parent->max_vals[it->colnum] =
-                    MAX(parent->max_vals[it->colnum], it->counter);
-            break;
-        case CALC_TYPE_BYTES:
-        case CALC_TYPE_COUNT:
-        case CALC_TYPE_LOAD:
-            parent->max_vals[it->colnum] = MAX(parent->max_vals[it->colnum], it->counter);
-            break;
-        case CALC_TYPE_SUM:
-        case CALC_TYPE_MIN:
-        case CALC_TYPE_MAX:
-            ftype = proto_registrar_get_ftype(it->hf_index);
-            switch (ftype) {
-                case FT_FLOAT:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], (guint64)(it->float_counter+0.5));
-                    break;
-                case FT_DOUBLE:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], (guint64)(it->double_counter+0.5));
-                    break;
-                case FT_RELATIVE_TIME:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], it->counter);
-                    break;
-                default:
-                    /* UINT16-64 and INT8-64 */
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], it->counter);
-                    break;
-            }
-            break;
-        case CALC_TYPE_AVG:
-            if (it->num == 0) /* avoid division by zero */
-               break;
-            ftype = proto_registrar_get_ftype(it->hf_index);
-            switch (ftype) {
-                case FT_FLOAT:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], (guint64)it->float_counter/it->num);
-                    break;
-                case FT_DOUBLE:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], (guint64)it->double_counter/it->num);
-                    break;
-                case FT_RELATIVE_TIME:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], ((it->counter/(guint64)it->num) + G_GUINT64_CONSTANT(500000000)) / NANOSECS_PER_SEC);
-                    break;
-                default:
-                    /* UINT16-64 and INT8-64 */
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], it->counter/it->num);
-                    break;
-            }
-    }
+    iostat_update_max(parent, it);
     return TAP_PACKET_REDRAW;
 }
 
@@ -544,6 +564,154 @@ printcenter (const char *label, int lenval, int numpad)
     }
 }
 
+static guint64
+iostat_duration(io_stat_t *iot)
+{
+    guint64 duration = ((guint64)cfile.elapsed_time.secs * G_GUINT64_CONSTANT(1000000)) +
+                        (guint64)((cfile.elapsed_time.nsecs + 500) / 1000);
+
+    return MAX(duration, iot->merged_duration);
+}
+
+/*
+ * The state of a column is saved as the parts of io_stat_t that belong to
+ * it and the duration of the capture, followed by the column's intervals
+ * that saw anything.
+ */
+static void
+iostat_save_state(void *arg, GByteArray *state)
+{
+    io_stat_item_t *mit = (io_stat_item_t *)arg;
+    io_stat_t *parent = mit->parent;
+    io_stat_item_t *it;
+    gint64 start_time = parent->start_time;
+    guint64 duration = iostat_duration(parent);
+
+    g_byte_array_append(state, (const guint8 *)&start_time, sizeof start_time);
+    g_byte_array_append(state, (const guint8 *)&duration, sizeof duration);
+    g_byte_array_append(state, (const guint8 *)&parent->max_vals[mit->colnum], sizeof parent->max_vals[mit->colnum]);
+    g_byte_array_append(state, (const guint8 *)&parent->max_frame[mit->colnum], sizeof parent->max_frame[mit->colnum]);
+    for (it = mit; it; it = it->next) {
+        if (it->frames == 0 && it->num == 0 && it->counter == 0 &&
+            it->float_counter == 0 && it->double_counter == 0)
+            continue;
+        g_byte_array_append(state, (const guint8 *)&it->start_time, sizeof it->start_time);
+        g_byte_array_append(state, (const guint8 *)&it->frames, sizeof it->frames);
+        g_byte_array_append(state, (const guint8 *)&it->num, sizeof it->num);
+        g_byte_array_append(state, (const guint8 *)&it->counter, sizeof it->counter);
+        g_byte_array_append(state, (const guint8 *)&it->float_counter, sizeof it->float_counter);
+        g_byte_array_append(state, (const guint8 *)&it->double_counter, sizeof it->double_counter);
+    }
+}
+
+/* Returns TRUE if the value of from is less than that of it, for MIN and MAX. */
+static gboolean
+iostat_item_less(const io_stat_item_t *from, const io_stat_item_t *it)
+{
+    switch (proto_registrar_get_ftype(it->hf_index)) {
+    case FT_INT8:
+    case FT_INT16:
+    case FT_INT24:
+    case FT_INT32:
+        return (gint32)from->counter < (gint32)it->counter;
+    case FT_INT40:
+    case FT_INT48:
+    case FT_INT56:
+    case FT_INT64:
+        return (gint64)from->counter < (gint64)it->counter;
+    case FT_FLOAT:
+        return from->float_counter < it->float_counter;
+    case FT_DOUBLE:
+        return from->double_counter < it->double_counter;
+    default:
+        return from->counter < it->counter;
+    }
+}
+
+static gboolean
+iostat_merge_state(void *arg, const guint8 *state, gsize len)
+{
+    io_stat_item_t *mit = (io_stat_item_t *)arg;
+    io_stat_t *parent = mit->parent;
+    io_stat_item_t *it, *cursor = mit;
+    tap_state_reader_t reader;
+    gint64 start_time;
+    guint64 duration, offset = 0;
+    guint64 max_val;
+    guint32 max_frame;
+
+    reader.data = state;
+    reader.len = len;
+    if (!tap_state_read(&reader, &start_time, sizeof start_time) ||
+        !tap_state_read(&reader, &duration, sizeof duration) ||
+        !tap_state_read(&reader, &max_val, sizeof max_val) ||
+        !tap_state_read(&reader, &max_frame, sizeof max_frame))
+        return FALSE;
+
+    /* The intervals of a capture that began later than ours are moved
+       by the difference; captures must be merged in the order in which
+       they were taken. */
+    if (parent->start_time == 0) {
+        parent->start_time = (time_t)start_time;
+    } else if (start_time != 0) {
+        if (start_time < parent->start_time)
+            return FALSE;
+        offset = (guint64)(start_time - parent->start_time) * G_GUINT64_CONSTANT(1000000);
+    }
+    parent->merged_duration = MAX(parent->merged_duration, offset + duration);
+    parent->max_vals[mit->colnum] = MAX(parent->max_vals[mit->colnum], max_val);
+    parent->max_frame[mit->colnum] = MAX(parent->max_frame[mit->colnum], max_frame);
+
+    while (reader.len > 0) {
+        io_stat_item_t from;
+
+        if (!tap_state_read(&reader, &from.start_time, sizeof from.start_time) ||
+            !tap_state_read(&reader, &from.frames, sizeof from.frames) ||
+            !tap_state_read(&reader, &from.num, sizeof from.num) ||
+            !tap_state_read(&reader, &from.counter, sizeof from.counter) ||
+            !tap_state_read(&reader, &from.float_counter, sizeof from.float_counter) ||
+            !tap_state_read(&reader, &from.double_counter, sizeof from.double_counter))
+            return FALSE;
+
+        /* The intervals are saved in order, so we can look for each one
+           from the last. */
+        from.start_time += offset;
+        if (from.start_time >= mit->prev->start_time) {
+            it = iostat_item_for_time(mit, from.start_time);
+        } else {
+            for (it = cursor; it->next && it->next->start_time <= from.start_time; it = it->next)
+                ;
+        }
+        cursor = it;
+
+        switch (it->calc_type) {
+        case CALC_TYPE_MIN:
+            if (from.frames != 0 && (it->frames == 0 || iostat_item_less(&from, it))) {
+                it->counter = from.counter;
+                it->float_counter = from.float_counter;
+                it->double_counter = from.double_counter;
+            }
+            break;
+        case CALC_TYPE_MAX:
+            if (iostat_item_less(it, &from)) {
+                it->counter = from.counter;
+                it->float_counter = from.float_counter;
+                it->double_counter = from.double_counter;
+            }
+            break;
+        default:
+            it->counter += from.counter;
+            it->float_counter += from.float_counter;
+            it->double_counter += from.double_counter;
+            break;
+        }
+        it->frames += from.frames;
+        it->num += from.num;
+        iostat_update_max(parent, it);
+    }
+    return TRUE;
+}
+
 typedef struct {
     int fr;  /* Width of this FRAMES column sans padding and border chars */
     int val; /* Width of this non-FRAMES column sans padding and border chars */
@@ -574,8 +742,7 @@ iostat_draw(void *arg)
     num_cols = iot->num_cols;
     col_w = g_new(column_width, num_cols);
     fmts = (char **)g_malloc(sizeof(char *) * num_cols);
-    duration = ((guint64)cfile.elapsed_time.secs * G_GUINT64_CONSTANT(1000000)) +
-                (guint64)((cfile.elapsed_time.nsecs + 500) / 1000);
+    duration = iostat_duration(iot);
 
     /* Store the pointer to each stat column */
     stat_cols = (io_stat_item_t **)g_malloc(sizeof(io_stat_item_t *) * num_cols);
@@ -1381,6 +1548,7 @@ register_io_tap(io_stat_t *io, int i, const char *filter)
         g_string_free(error_string, TRUE);
         exit(1);
     }
+    set_tap_listener_mergeable(&io->items[i], iostat_save_state, iostat_merge_state);
 }
 
 static void
@@ -1473,6 +1641,7 @@ iostat_init(const char *opt_arg, void *userdata _U_)
     /* Find how many ',' separated filters we have */
     io->num_cols = 1;
     io->start_time = 0;
+    io->merged_duration = 0;
 
     if (filters && (*filters != '\0')) {
         /* Eliminate the first comma. */
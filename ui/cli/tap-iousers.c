@@ -241,6 +241,7 @@ void init_iousers(struct register_ct *ct, const char *filter)
 		g_string_free(error_string, TRUE);
 		exit(1);
 	}
+	set_tap_listener_mergeable(&iu->hash, conversation_table_save_state, conversation_table_merge_state);
 
 }
 
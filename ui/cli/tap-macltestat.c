@@ -122,9 +122,20 @@ typedef struct mac_lte_stat_t {
     guint16 number_of_rntis;
 
     mac_lte_ep_t  *ep_list;
+    mac_lte_ep_t  *ep_last;
+
+    /* Rows by RNTI and UEId, see ep_key() */
+    GHashTable    *ep_table;
 } mac_lte_stat_t;
 
 
+/* Rows are matched by RNTI and UEId together */
+static gpointer ep_key(guint16 rnti, guint16 ueid)
+{
+    return GUINT_TO_POINTER(((guint)ueid << 16) | rnti);
+}
+
+
 /* Reset the statistics window */
 static void
 mac_lte_stat_reset(void *phs)
@@ -141,54 +152,15 @@ mac_lte_stat_reset(void *phs)
     /* Zero common stats */
     memset(&(mac_lte_stat->common_stats), 0, sizeof(mac_lte_common_stats));
 
-    if (!list) {
-        return;
+    g_hash_table_remove_all(mac_lte_stat->ep_table);
+    while (list) {
+        mac_lte_ep_t *next = list->next;
+        g_free(list);
+        list = next;
     }
 
     mac_lte_stat->ep_list = NULL;
-}
-
-
-/* Allocate a mac_lte_ep_t struct to store info for new UE */
-static mac_lte_ep_t *alloc_mac_lte_ep(const struct mac_lte_tap_info *si, packet_info *pinfo _U_)
-{
-    mac_lte_ep_t *ep;
-
-    if (!si) {
-        return NULL;
-    }
-
-    if (!(ep = g_new(mac_lte_ep_t, 1))) {
-        return NULL;
-    }
-
-    /* Copy SI data into ep->stats */
-    ep->stats.rnti = si->rnti;
-    ep->stats.rnti_type = si->rntiType;
-    ep->stats.ueid = si->ueid;
-
-    /* Counts for new UE are all 0 */
-    ep->stats.UL_frames = 0;
-    ep->stats.DL_frames = 0;
-    ep->stats.UL_total_bytes = 0;
-    ep->stats.UL_raw_bytes = 0;
-    ep->stats.UL_padding_bytes = 0;
-
-    ep->stats.DL_total_bytes = 0;
-    ep->stats.DL_raw_bytes = 0;
-    ep->stats.DL_padding_bytes = 0;
-
-    ep->stats.UL_CRC_errors = 0;
-    ep->stats.DL_CRC_failures = 0;
-    ep->stats.DL_CRC_high_code_rate = 0;
-    ep->stats.DL_CRC_PDSCH_lost = 0;
-    ep->stats.DL_CRC_Duplicate_NonZero_RV = 0;
-    ep->stats.UL_retx_frames = 0;
-    ep->stats.DL_retx_frames = 0;
-
-    ep->next = NULL;
-
-    return ep;
+    mac_lte_stat->ep_last = NULL;
 }
 
 
@@ -206,6 +178,37 @@ static void update_ueid_rnti_counts(guint16 rnti, guint16 ueid, mac_lte_stat_t *
 }
 
 
+/* Find the row of a UE, or add a new one to the end of the list */
+static mac_lte_ep_t *get_mac_lte_ep(mac_lte_stat_t *hs, guint16 rnti, guint8 rnti_type, guint16 ueid)
+{
+    mac_lte_ep_t *ep;
+
+    ep = (mac_lte_ep_t *)g_hash_table_lookup(hs->ep_table, ep_key(rnti, ueid));
+    if (ep) {
+        return ep;
+    }
+
+    /* Counts for new UE are all 0 */
+    ep = g_new0(mac_lte_ep_t, 1);
+    ep->stats.rnti = rnti;
+    ep->stats.rnti_type = rnti_type;
+    ep->stats.ueid = ueid;
+
+    if (hs->ep_last) {
+        hs->ep_last->next = ep;
+    } else {
+        hs->ep_list = ep;
+    }
+    hs->ep_last = ep;
+    g_hash_table_insert(hs->ep_table, ep_key(rnti, ueid), ep);
+
+    /* Update counts of unique ueids & rntis */
+    update_ueid_rnti_counts(rnti, ueid, hs);
+
+    return ep;
+}
+
+
 /* Process stat struct for a MAC LTE frame */
 static tap_packet_status
 mac_lte_stat_packet(void *phs, packet_info *pinfo, epan_dissect_t *edt _U_,
@@ -213,7 +216,7 @@ mac_lte_stat_packet(void *phs, packet_info *pinfo, epan_dissect_t *edt _U_,
 {
     /* Get reference to stat window instance */
     mac_lte_stat_t *hs = (mac_lte_stat_t *)phs;
-    mac_lte_ep_t *tmp = NULL, *te = NULL;
+    mac_lte_ep_t *te = NULL;
     int i;
 
     /* Cast tap info struct */
@@ -266,41 +269,7 @@ mac_lte_stat_packet(void *phs, packet_info *pinfo, epan_dissect_t *edt _U_,
     }
 
     /* For per-UE data, must create a new row if none already existing */
-    if (!hs->ep_list) {
-        /* Allocate new list */
-        hs->ep_list = alloc_mac_lte_ep(si, pinfo);
-        /* Make it the first/only entry */
-        te = hs->ep_list;
-
-        /* Update counts of unique ueids & rntis */
-        update_ueid_rnti_counts(si->rnti, si->ueid, hs);
-    } else {
-        /* Look among existing rows for this RNTI */
-        for (tmp = hs->ep_list;(tmp != NULL); tmp = tmp->next) {
-            /* Match only by RNTI and UEId together */
-            if ((tmp->stats.rnti == si->rnti) &&
-                (tmp->stats.ueid == si->ueid)) {
-                te = tmp;
-                break;
-            }
-        }
-
-        /* Not found among existing, so create a new one anyway */
-        if (te == NULL) {
-            if ((te = alloc_mac_lte_ep(si, pinfo))) {
-                /* Add new item to end of list */
-                mac_lte_ep_t *p = hs->ep_list;
-                while (p->next) {
-                    p = p->next;
-                }
-                p->next = te;
-                te->next = NULL;
-
-                /* Update counts of unique ueids & rntis */
-                update_ueid_rnti_counts(si->rnti, si->ueid, hs);
-            }
-        }
-    }
+    te = get_mac_lte_ep(hs, si->rnti, si->rntiType, si->ueid);
 
     /* Really should have a row pointer by now */
     if (!te) {
@@ -399,6 +368,98 @@ mac_lte_stat_packet(void *phs, packet_info *pinfo, epan_dissect_t *edt _U_,
 }
 
 
+/* Save the stats, for another process to merge them; see
+   set_tap_listener_mergeable() */
+static void
+mac_lte_stat_save_state(void *phs, GByteArray *state)
+{
+    mac_lte_stat_t *hs = (mac_lte_stat_t *)phs;
+    mac_lte_ep_t *tmp;
+    guint32 number_of_ues = g_hash_table_size(hs->ep_table);
+
+    g_byte_array_append(state, (const guint8 *)&hs->common_stats, sizeof hs->common_stats);
+    g_byte_array_append(state, (const guint8 *)&number_of_ues, sizeof number_of_ues);
+    for (tmp = hs->ep_list; tmp; tmp = tmp->next) {
+        g_byte_array_append(state, (const guint8 *)&tmp->stats, sizeof tmp->stats);
+    }
+}
+
+
+/* Add stats saved by mac_lte_stat_save_state() for later frames */
+static gboolean
+mac_lte_stat_merge_state(void *phs, const guint8 *state, gsize len)
+{
+    mac_lte_stat_t *hs = (mac_lte_stat_t *)phs;
+    tap_state_reader_t reader;
+    mac_lte_common_stats common;
+    mac_lte_row_data row;
+    guint32 number_of_ues, n;
+
+    reader.data = state;
+    reader.len = len;
+
+    if (!tap_state_read(&reader, &common, sizeof common) ||
+        !tap_state_read(&reader, &number_of_ues, sizeof number_of_ues)) {
+        return FALSE;
+    }
+
+    hs->common_stats.all_frames += common.all_frames;
+    hs->common_stats.mib_frames += common.mib_frames;
+    hs->common_stats.sib_frames += common.sib_frames;
+    hs->common_stats.sib_bytes += common.sib_bytes;
+    hs->common_stats.pch_frames += common.pch_frames;
+    hs->common_stats.pch_bytes += common.pch_bytes;
+    hs->common_stats.pch_paging_ids += common.pch_paging_ids;
+    hs->common_stats.rar_frames += common.rar_frames;
+    hs->common_stats.rar_entries += common.rar_entries;
+    hs->common_stats.max_ul_ues_in_tti = MAX(hs->common_stats.max_ul_ues_in_tti, common.max_ul_ues_in_tti);
+    hs->common_stats.max_dl_ues_in_tti = MAX(hs->common_stats.max_dl_ues_in_tti, common.max_dl_ues_in_tti);
+
+    for (n = 0; n < number_of_ues; n++) {
+        mac_lte_ep_t *te;
+
+        if (!tap_state_read(&reader, &row, sizeof row)) {
+            return FALSE;
+        }
+        te = get_mac_lte_ep(hs, row.rnti, row.rnti_type, row.ueid);
+
+        /* The saved frames come after those already counted */
+        te->stats.is_predefined_data = row.is_predefined_data;
+
+        if (row.UL_frames) {
+            if (te->stats.UL_frames == 0) {
+                te->stats.UL_time_start = row.UL_time_start;
+            }
+            te->stats.UL_time_stop = row.UL_time_stop;
+        }
+        te->stats.UL_frames += row.UL_frames;
+        te->stats.UL_raw_bytes += row.UL_raw_bytes;
+        te->stats.UL_total_bytes += row.UL_total_bytes;
+        te->stats.UL_padding_bytes += row.UL_padding_bytes;
+        te->stats.UL_CRC_errors += row.UL_CRC_errors;
+        te->stats.UL_retx_frames += row.UL_retx_frames;
+
+        if (row.DL_frames) {
+            if (te->stats.DL_frames == 0) {
+                te->stats.DL_time_start = row.DL_time_start;
+            }
+            te->stats.DL_time_stop = row.DL_time_stop;
+        }
+        te->stats.DL_frames += row.DL_frames;
+        te->stats.DL_raw_bytes += row.DL_raw_bytes;
+        te->stats.DL_total_bytes += row.DL_total_bytes;
+        te->stats.DL_padding_bytes += row.DL_padding_bytes;
+        te->stats.DL_CRC_failures += row.DL_CRC_failures;
+        te->stats.DL_CRC_high_code_rate += row.DL_CRC_high_code_rate;
+        te->stats.DL_CRC_PDSCH_lost += row.DL_CRC_PDSCH_lost;
+        te->stats.DL_CRC_Duplicate_NonZero_RV += row.DL_CRC_Duplicate_NonZero_RV;
+        te->stats.DL_retx_frames += row.DL_retx_frames;
+    }
+
+    return reader.len == 0;
+}
+
+
 /* Calculate and return a bandwidth figure, in Mbs */
 static float calculate_bw(nstime_t *start_time, nstime_t *stop_time, guint32 bytes)
 {
@@ -520,6 +581,7 @@ static void mac_lte_stat_init(const char *opt_arg, void *userdata _U_)
     /* Create struct */
     hs = g_new0(mac_lte_stat_t, 1);
     hs->ep_list = NULL;
+    hs->ep_table = g_hash_table_new(g_direct_hash, g_direct_equal);
 
     error_string = register_tap_listener("mac-lte", hs,
                                          filter, 0,
@@ -529,9 +591,12 @@ static void mac_lte_stat_init(const char *opt_arg, void *userdata _U_)
                                          NULL);
     if (error_string) {
         g_string_free(error_string, TRUE);
+        g_hash_table_destroy(hs->ep_table);
         g_free(hs);
         exit(1);
     }
+
+    set_tap_listener_mergeable(hs, mac_lte_stat_save_state, mac_lte_stat_merge_state);
 }
 
 static stat_tap_ui mac_lte_stat_ui = {
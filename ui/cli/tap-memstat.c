@@ -0,0 +1,116 @@
+/* tap-memstat.c
+ * File scope memory allocated by each protocol, for tshark
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+#include <epan/app_mem_usage.h>
+
+#include <ui/cmdarg_err.h>
+
+void register_tap_listener_memstat(void);
+
+/* Print the memory of each protocol, by decreasing number of bytes,
+   followed by that of the whole process */
+static void
+memstat_draw(void *tapdata _U_)
+{
+    GPtrArray          *usages = dissector_memory_accounting_get();
+    dissector_memory_t *usage;
+    guint64             bytes_total = 0;
+    const char         *name;
+    gchar               label[64];
+    gsize               value;
+    guint               i;
+
+    for (i = 0; i < usages->len; i++) {
+        usage = (dissector_memory_t *)g_ptr_array_index(usages, i);
+        bytes_total += usage->bytes;
+    }
+
+    printf("\n");
+    printf("=================================================================\n");
+    printf("File Scope Memory by Protocol\n");
+    printf("%-24s %14s %18s %7s\n", "Protocol", "Allocations", "Bytes", "Bytes%");
+    printf("-----------------------------------------------------------------\n");
+    for (i = 0; i < usages->len; i++) {
+        usage = (dissector_memory_t *)g_ptr_array_index(usages, i);
+        printf("%-24s %14" G_GUINT64_FORMAT " %18" G_GUINT64_FORMAT " %7.2f\n",
+               usage->protocol ? usage->protocol : "(no dissector)",
+               usage->allocs, usage->bytes,
+               bytes_total ? 100.0 * usage->bytes / bytes_total : 0.0);
+    }
+    printf("-----------------------------------------------------------------\n");
+    printf("%-24s %14s %18" G_GUINT64_FORMAT "\n", "Total", "", bytes_total);
+    for (i = 0; (name = memory_usage_get(i, &value)) != NULL; i++) {
+        g_snprintf(label, sizeof label, "Process (%s)", name);
+        printf("%-24s %14s %18" G_GSIZE_FORMAT "\n", label, "", value);
+    }
+    printf("=================================================================\n");
+
+    g_ptr_array_free(usages, TRUE);
+}
+
+static void
+memstat_init(const char *opt_arg, void *userdata _U_)
+{
+    GString *error_string;
+
+    if (strcmp(opt_arg, "mem") != 0) {
+        cmdarg_err("invalid \"-z mem\" argument");
+        exit(1);
+    }
+
+    /* As with "-z dissector,prof", the counts come from the dissectors'
+       allocations, and the listener only prints them at the end. */
+    dissector_memory_accounting_enable(TRUE);
+
+    error_string = register_tap_listener("frame", NULL, NULL, 0, NULL, NULL,
+                                         memstat_draw, NULL);
+    if (error_string) {
+        cmdarg_err("Couldn't register mem tap: %s", error_string->str);
+        g_string_free(error_string, TRUE);
+        exit(1);
+    }
+}
+
+static stat_tap_ui memstat_ui = {
+    REGISTER_STAT_GROUP_GENERIC,
+    NULL,
+    "mem",
+    memstat_init,
+    0,
+    NULL
+};
+
+void
+register_tap_listener_memstat(void)
+{
+    register_stat_tap_ui(&memstat_ui, NULL);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
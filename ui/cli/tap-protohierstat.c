@@ -115,6 +115,107 @@ protohierstat_packet(void *prs, packet_info *pinfo, epan_dissect_t *edt, const v
 	return TAP_PACKET_REDRAW;
 }
 
+/*
+ * The state of the tap is saved as the tree of protocols, each sibling list
+ * as its number of protocols followed by each protocol, with its counts
+ * and then the list of its children.
+ */
+static void
+phs_save(phs_t *rs, GByteArray *state)
+{
+	phs_t *tmprs;
+	guint32 count = 0;
+
+	for (tmprs=rs; tmprs && tmprs->protocol != -1; tmprs=tmprs->sibling) {
+		count++;
+	}
+	g_byte_array_append(state, (const guint8 *)&count, sizeof count);
+	for (tmprs=rs; tmprs && tmprs->protocol != -1; tmprs=tmprs->sibling) {
+		gint32 protocol = tmprs->protocol;
+
+		g_byte_array_append(state, (const guint8 *)&protocol, sizeof protocol);
+		g_byte_array_append(state, (const guint8 *)&tmprs->frames, sizeof tmprs->frames);
+		g_byte_array_append(state, (const guint8 *)&tmprs->bytes, sizeof tmprs->bytes);
+		phs_save(tmprs->child, state);
+	}
+}
+
+static void
+protohierstat_save_state(void *prs, GByteArray *state)
+{
+	phs_save((phs_t *)prs, state);
+}
+
+static gboolean
+phs_merge(phs_t *rs, tap_state_reader_t *reader)
+{
+	guint32 count, i;
+
+	if (!tap_state_read(reader, &count, sizeof count)) {
+		return FALSE;
+	}
+	for (i=0; i<count; i++) {
+		phs_t *tmprs;
+		gint32 protocol;
+		guint32 frames;
+		guint64 bytes;
+		header_field_info *hfinfo;
+
+		if (!tap_state_read(reader, &protocol, sizeof protocol) ||
+		    !tap_state_read(reader, &frames, sizeof frames) ||
+		    !tap_state_read(reader, &bytes, sizeof bytes)) {
+			return FALSE;
+		}
+		hfinfo = proto_registrar_get_nth(protocol);
+		if (!hfinfo) {
+			return FALSE;
+		}
+
+		/* find this protocol in the list of siblings, or add it, as
+		   protohierstat_packet() does */
+		if (rs->protocol == -1) {
+			tmprs = rs;
+		} else {
+			for (tmprs=rs; tmprs; tmprs=tmprs->sibling) {
+				if (tmprs->protocol == protocol) {
+					break;
+				}
+			}
+			if (!tmprs) {
+				for (tmprs=rs; tmprs->sibling; tmprs=tmprs->sibling)
+					;
+				tmprs->sibling = new_phs_t(rs->parent);
+				tmprs = tmprs->sibling;
+			}
+		}
+		if (tmprs->protocol == -1) {
+			tmprs->protocol = protocol;
+			tmprs->proto_name = hfinfo->abbrev;
+		}
+
+		tmprs->frames += frames;
+		tmprs->bytes += bytes;
+
+		if (!tmprs->child) {
+			tmprs->child = new_phs_t(tmprs);
+		}
+		if (!phs_merge(tmprs->child, reader)) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+static gboolean
+protohierstat_merge_state(void *prs, const guint8 *state, gsize len)
+{
+	tap_state_reader_t reader;
+
+	reader.data = state;
+	reader.len = len;
+	return phs_merge((phs_t *)prs, &reader) && reader.len == 0;
+}
+
 static void
 phs_draw(phs_t *rs, int indentation)
 {
@@ -187,6 +288,7 @@ protohierstat_init(const char *opt_arg, void *userdata _U_)
 		g_string_free(error_string, TRUE);
 		exit(1);
 	}
+	set_tap_listener_mergeable(rs, protohierstat_save_state, protohierstat_merge_state);
 }
 
 static stat_tap_ui protohierstat_ui = {
@@ -88,8 +88,12 @@ typedef struct rlc_lte_ep {
 /* Used to keep track of all RLC LTE statistics */
 typedef struct rlc_lte_stat_t {
     rlc_lte_ep_t  *ep_list;
+    rlc_lte_ep_t  *ep_last;
     guint32       total_frames;
 
+    /* Rows by UEId */
+    GHashTable    *ep_table;
+
     /* Common stats */
     rlc_lte_common_stats common_stats;
 } rlc_lte_stat_t;
@@ -106,45 +110,39 @@ rlc_lte_stat_reset(void *phs)
     rlc_lte_stat->total_frames = 0;
     memset(&rlc_lte_stat->common_stats, 0, sizeof(rlc_lte_common_stats));
 
-    if (!list) {
-        return;
+    g_hash_table_remove_all(rlc_lte_stat->ep_table);
+    while (list) {
+        rlc_lte_ep_t *next = list->next;
+        g_free(list);
+        list = next;
     }
 
     rlc_lte_stat->ep_list = NULL;
+    rlc_lte_stat->ep_last = NULL;
 }
 
 
-/* Allocate a rlc_lte_ep_t struct to store info for new UE */
-static rlc_lte_ep_t *alloc_rlc_lte_ep(const struct rlc_lte_tap_info *si, packet_info *pinfo _U_)
+/* Find the row of a UE, or add a new one to the end of the list */
+static rlc_lte_ep_t *get_rlc_lte_ep(rlc_lte_stat_t *hs, guint16 ueid)
 {
     rlc_lte_ep_t *ep;
 
-    if (!si) {
-        return NULL;
-    }
-
-    if (!(ep = g_new(rlc_lte_ep_t, 1))) {
-        return NULL;
+    ep = (rlc_lte_ep_t *)g_hash_table_lookup(hs->ep_table, GUINT_TO_POINTER(ueid));
+    if (ep) {
+        return ep;
     }
 
-    /* Copy SI data into ep->stats */
-    ep->stats.ueid = si->ueid;
-
     /* Counts for new UE are all 0 */
-    ep->stats.UL_frames = 0;
-    ep->stats.DL_frames = 0;
-    ep->stats.UL_total_bytes = 0;
-    ep->stats.DL_total_bytes = 0;
-    memset(&ep->stats.DL_time_start, 0, sizeof(nstime_t));
-    memset(&ep->stats.DL_time_stop, 0, sizeof(nstime_t));
-    ep->stats.UL_total_acks = 0;
-    ep->stats.DL_total_acks = 0;
-    ep->stats.UL_total_nacks = 0;
-    ep->stats.DL_total_nacks = 0;
-    ep->stats.UL_total_missing = 0;
-    ep->stats.DL_total_missing = 0;
-
-    ep->next = NULL;
+    ep = g_new0(rlc_lte_ep_t, 1);
+    ep->stats.ueid = ueid;
+
+    if (hs->ep_last) {
+        hs->ep_last->next = ep;
+    } else {
+        hs->ep_list = ep;
+    }
+    hs->ep_last = ep;
+    g_hash_table_insert(hs->ep_table, GUINT_TO_POINTER(ueid), ep);
 
     return ep;
 }
@@ -157,7 +155,7 @@ rlc_lte_stat_packet(void *phs, packet_info *pinfo, epan_dissect_t *edt _U_,
 {
     /* Get reference to stats struct */
     rlc_lte_stat_t *hs = (rlc_lte_stat_t *)phs;
-    rlc_lte_ep_t *tmp = NULL, *te = NULL;
+    rlc_lte_ep_t *te = NULL;
 
     /* Cast tap info struct */
     const struct rlc_lte_tap_info *si = (const struct rlc_lte_tap_info *)phi;
@@ -188,38 +186,7 @@ rlc_lte_stat_packet(void *phs, packet_info *pinfo, epan_dissect_t *edt _U_,
     }
 
     /* For per-UE data, must create a new row if none already existing */
-    if (!hs->ep_list) {
-        /* Allocate new list */
-        hs->ep_list = alloc_rlc_lte_ep(si, pinfo);
-        /* Make it the first/only entry */
-        te = hs->ep_list;
-    } else {
-        /* Look among existing rows for this UEId */
-        for (tmp = hs->ep_list; (tmp != NULL); tmp = tmp->next) {
-            if (tmp->stats.ueid == si->ueid) {
-                te = tmp;
-                break;
-            }
-        }
-
-        /* Not found among existing, so create a new one anyway */
-        if (te == NULL) {
-            if ((te = alloc_rlc_lte_ep(si, pinfo))) {
-                /* Add new item to end of list */
-                rlc_lte_ep_t *p = hs->ep_list;
-                while (p->next) {
-                    p = p->next;
-                }
-                p->next = te;
-                te->next = NULL;
-            }
-        }
-    }
-
-    /* Really should have a row pointer by now */
-    if (!te) {
-        return TAP_PACKET_DONT_REDRAW;
-    }
+    te = get_rlc_lte_ep(hs, si->ueid);
 
     /* Update entry with details from si */
     te->stats.ueid = si->ueid;
@@ -266,6 +233,88 @@ rlc_lte_stat_packet(void *phs, packet_info *pinfo, epan_dissect_t *edt _U_,
 }
 
 
+/* Save the stats, for another process to merge them; see
+   set_tap_listener_mergeable() */
+static void
+rlc_lte_stat_save_state(void *phs, GByteArray *state)
+{
+    rlc_lte_stat_t *hs = (rlc_lte_stat_t *)phs;
+    rlc_lte_ep_t *tmp;
+    guint32 number_of_ues = g_hash_table_size(hs->ep_table);
+
+    g_byte_array_append(state, (const guint8 *)&hs->total_frames, sizeof hs->total_frames);
+    g_byte_array_append(state, (const guint8 *)&hs->common_stats, sizeof hs->common_stats);
+    g_byte_array_append(state, (const guint8 *)&number_of_ues, sizeof number_of_ues);
+    for (tmp = hs->ep_list; tmp; tmp = tmp->next) {
+        g_byte_array_append(state, (const guint8 *)&tmp->stats, sizeof tmp->stats);
+    }
+}
+
+
+/* Add stats saved by rlc_lte_stat_save_state() for later frames */
+static gboolean
+rlc_lte_stat_merge_state(void *phs, const guint8 *state, gsize len)
+{
+    rlc_lte_stat_t *hs = (rlc_lte_stat_t *)phs;
+    tap_state_reader_t reader;
+    guint32 total_frames;
+    rlc_lte_common_stats common;
+    rlc_lte_row_data row;
+    guint32 number_of_ues, n;
+
+    reader.data = state;
+    reader.len = len;
+
+    if (!tap_state_read(&reader, &total_frames, sizeof total_frames) ||
+        !tap_state_read(&reader, &common, sizeof common) ||
+        !tap_state_read(&reader, &number_of_ues, sizeof number_of_ues)) {
+        return FALSE;
+    }
+
+    hs->total_frames += total_frames;
+    hs->common_stats.bcch_frames += common.bcch_frames;
+    hs->common_stats.bcch_bytes += common.bcch_bytes;
+    hs->common_stats.pcch_frames += common.pcch_frames;
+    hs->common_stats.pcch_bytes += common.pcch_bytes;
+
+    for (n = 0; n < number_of_ues; n++) {
+        rlc_lte_ep_t *te;
+
+        if (!tap_state_read(&reader, &row, sizeof row)) {
+            return FALSE;
+        }
+        te = get_rlc_lte_ep(hs, row.ueid);
+
+        /* The saved frames come after those already counted */
+        if (row.UL_frames) {
+            if (te->stats.UL_frames == 0) {
+                te->stats.UL_time_start = row.UL_time_start;
+            }
+            te->stats.UL_time_stop = row.UL_time_stop;
+        }
+        te->stats.UL_frames += row.UL_frames;
+        te->stats.UL_total_bytes += row.UL_total_bytes;
+        te->stats.UL_total_acks += row.UL_total_acks;
+        te->stats.UL_total_nacks += row.UL_total_nacks;
+        te->stats.UL_total_missing += row.UL_total_missing;
+
+        if (row.DL_frames) {
+            if (te->stats.DL_frames == 0) {
+                te->stats.DL_time_start = row.DL_time_start;
+            }
+            te->stats.DL_time_stop = row.DL_time_stop;
+        }
+        te->stats.DL_frames += row.DL_frames;
+        te->stats.DL_total_bytes += row.DL_total_bytes;
+        te->stats.DL_total_acks += row.DL_total_acks;
+        te->stats.DL_total_nacks += row.DL_total_nacks;
+        te->stats.DL_total_missing += row.DL_total_missing;
+    }
+
+    return reader.len == 0;
+}
+
+
 /* Calculate and return a bandwidth figure, in Mbs */
 static float calculate_bw(nstime_t *start_time, nstime_t *stop_time, guint32 bytes)
 {
@@ -368,6 +417,7 @@ static void rlc_lte_stat_init(const char *opt_arg, void *userdata _U_)
     /* Create top-level struct */
     hs = g_new0(rlc_lte_stat_t, 1);
     hs->ep_list = NULL;
+    hs->ep_table = g_hash_table_new(g_direct_hash, g_direct_equal);
 
 
     /**********************************************/
@@ -382,10 +432,12 @@ static void rlc_lte_stat_init(const char *opt_arg, void *userdata _U_)
                                          NULL);
     if (error_string) {
         g_string_free(error_string, TRUE);
+        g_hash_table_destroy(hs->ep_table);
         g_free(hs);
         exit(1);
     }
 
+    set_tap_listener_mergeable(hs, rlc_lte_stat_save_state, rlc_lte_stat_merge_state);
 }
 
 
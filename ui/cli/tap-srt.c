@@ -123,6 +123,7 @@ init_srt_tables(register_srt_t* srt, const char *filter)
 		g_string_free(error_string, TRUE);
 		exit(1);
 	}
+	set_tap_listener_mergeable(&ui->data, srt_table_save_state, srt_table_merge_state);
 }
 
 static void
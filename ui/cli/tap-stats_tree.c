@@ -91,6 +91,7 @@ init_stats_tree(const char *opt_arg, void *userdata _U_)
 		report_failure("stats_tree for: %s failed to attach to the tap: %s", cfg->name, error_string->str);
 		return;
 	}
+	set_tap_listener_mergeable(st, stats_tree_save_state, stats_tree_merge_state);
 
 	if (cfg->init) cfg->init(st);
 
@@ -24,41 +24,33 @@
 
 #include <wsutil/file_util.h>
 #include <wsutil/report_message.h>
+#include <wsutil/tempfile.h>
 
 #include "export_object_ui.h"
 
-void
-eo_save_entry(const gchar *save_as_filename, export_object_entry_t *entry)
+#define EO_COPY_BUF_SIZE (1024 * 1024)
+
+/*
+ * The third argument to _write() on Windows is an unsigned int,
+ * so, on Windows, that's the size of the third argument to
+ * ws_write().
+ *
+ * The third argument to write() on UN*X is a size_t, although
+ * the return value is an ssize_t, so one probably shouldn't
+ * write more than the max value of an ssize_t.
+ *
+ * In either case, there's no guarantee that a gint64 such as
+ * payload_len can be passed to ws_write(), so we write in
+ * chunks of, at most 2^31 bytes.
+ *
+ * Returns 0 on success, or the error.
+ */
+static int
+eo_write_all(int to_fd, const guint8 *ptr, gint64 bytes_left)
 {
-    int to_fd;
-    gint64 bytes_left;
     int bytes_to_write;
     ssize_t bytes_written;
-    guint8 *ptr;
-    int err;
 
-    to_fd = ws_open(save_as_filename, O_WRONLY | O_CREAT | O_EXCL |
-             O_BINARY, 0644);
-    if(to_fd == -1) { /* An error occurred */
-        report_open_failure(save_as_filename, errno, TRUE);
-        return;
-    }
-
-    /*
-     * The third argument to _write() on Windows is an unsigned int,
-     * so, on Windows, that's the size of the third argument to
-     * ws_write().
-     *
-     * The third argument to write() on UN*X is a size_t, although
-     * the return value is an ssize_t, so one probably shouldn't
-     * write more than the max value of an ssize_t.
-     *
-     * In either case, there's no guarantee that a gint64 such as
-     * payload_len can be passed to ws_write(), so we write in
-     * chunks of, at most 2^31 bytes.
-     */
-    ptr = entry->payload_data;
-    bytes_left = entry->payload_len;
     while (bytes_left != 0) {
         if (bytes_left > 0x40000000)
             bytes_to_write = 0x40000000;
@@ -67,20 +59,96 @@ eo_save_entry(const gchar *save_as_filename, export_object_entry_t *entry)
         bytes_written = ws_write(to_fd, ptr, bytes_to_write);
         if (bytes_written <= 0) {
             if (bytes_written < 0)
-                err = errno;
-            else
-                err = WTAP_ERR_SHORT_WRITE;
-            report_write_failure(save_as_filename, err);
-            ws_close(to_fd);
-            return;
+                return errno;
+            return WTAP_ERR_SHORT_WRITE;
         }
         bytes_left -= bytes_written;
         ptr += bytes_written;
     }
+    return 0;
+}
+
+/* Copy the payload of an entry that has been spooled to a file. */
+static int
+eo_copy_spooled(int to_fd, export_object_entry_t *entry)
+{
+    int from_fd;
+    guint8 *buf;
+    ssize_t bytes_read;
+    int err = 0;
+
+    from_fd = ws_open(entry->spool_filename, O_RDONLY | O_BINARY, 0000);
+    if (from_fd == -1)
+        return errno;
+
+    buf = (guint8 *)g_malloc(EO_COPY_BUF_SIZE);
+    while ((bytes_read = ws_read(from_fd, buf, EO_COPY_BUF_SIZE)) > 0) {
+        err = eo_write_all(to_fd, buf, bytes_read);
+        if (err != 0)
+            break;
+    }
+    if (bytes_read < 0)
+        err = errno;
+    g_free(buf);
+    ws_close(from_fd);
+    return err;
+}
+
+void
+eo_save_entry(const gchar *save_as_filename, export_object_entry_t *entry)
+{
+    int to_fd;
+    int err;
+
+    to_fd = ws_open(save_as_filename, O_WRONLY | O_CREAT | O_EXCL |
+             O_BINARY, 0644);
+    if(to_fd == -1) { /* An error occurred */
+        report_open_failure(save_as_filename, errno, TRUE);
+        return;
+    }
+
+    if (entry->spool_filename)
+        err = eo_copy_spooled(to_fd, entry);
+    else
+        err = eo_write_all(to_fd, entry->payload_data, entry->payload_len);
+    if (err != 0) {
+        report_write_failure(save_as_filename, err);
+        ws_close(to_fd);
+        return;
+    }
     if (ws_close(to_fd) < 0)
         report_write_failure(save_as_filename, errno);
 }
 
+gboolean
+eo_spool_entry(export_object_entry_t *entry)
+{
+    int fd;
+    int err;
+    gchar *spool_filename;
+
+    if (entry->spool_filename || entry->payload_data == NULL)
+        return TRUE;
+
+    fd = create_tempfile(&spool_filename, "wireshark_eo", NULL, NULL);
+    if (fd == -1)
+        return FALSE;
+
+    err = eo_write_all(fd, entry->payload_data, entry->payload_len);
+    if (ws_close(fd) < 0 && err == 0)
+        err = errno;
+    if (err != 0) {
+        ws_unlink(spool_filename);
+        g_free(spool_filename);
+        return FALSE;
+    }
+
+    entry->spool_filename = spool_filename;
+    g_free(entry->payload_data);
+    entry->payload_data = NULL;
+    return TRUE;
+}
+
 /*
  * Editor modelines
  *
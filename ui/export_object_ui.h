@@ -22,6 +22,15 @@ extern "C" {
 
 void eo_save_entry(const gchar *save_as_filename, export_object_entry_t *entry);
 
+/* Payloads at least this long are kept in a temporary file rather than
+   in memory while they're listed. */
+#define EO_SPOOL_MIN_LEN (64 * 1024)
+
+/* Move the payload of an entry to a temporary file, freeing the copy in
+   memory; returns FALSE, leaving the entry as it is, if it can't be
+   written. */
+gboolean eo_spool_entry(export_object_entry_t *entry);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -18,12 +18,16 @@
 #include "ui/io_graph_item.h"
 
 int get_io_graph_index(packet_info *pinfo, int interval) {
+    return get_io_graph_index_from_ts(&pinfo->rel_ts, interval);
+}
+
+int get_io_graph_index_from_ts(const nstime_t *rel_ts, int interval) {
     nstime_t time_delta;
 
     /*
      * Find in which interval this is supposed to go and store the interval index as idx
      */
-    time_delta = pinfo->rel_ts;
+    time_delta = *rel_ts;
     if (time_delta.nsecs<0) {
         time_delta.secs--;
         time_delta.nsecs += 1000000000;
@@ -125,6 +129,81 @@ GString *check_field_unit(const char *field_name, int *hf_index, io_graph_item_u
     return err_str;
 }
 
+void merge_io_graph_item(io_graph_item_t *item, const io_graph_item_t *from, int item_unit)
+{
+    if (from->first_frame_in_invl != 0 &&
+        (item->first_frame_in_invl == 0 || from->first_frame_in_invl < item->first_frame_in_invl)) {
+        item->first_frame_in_invl = from->first_frame_in_invl;
+    }
+    if (from->last_frame_in_invl > item->last_frame_in_invl) {
+        item->last_frame_in_invl = from->last_frame_in_invl;
+    }
+
+    if (from->fields != 0) {
+        gboolean from_max, from_min;
+
+        /* Only one of the kinds of values is used for a field, but all of
+         * them are kept in step here since we don't know which. */
+        if (item->fields == 0) {
+            from_max = from_min = TRUE;
+        } else {
+            from_max = from->int_max > item->int_max || from->float_max > item->float_max ||
+                       from->double_max > item->double_max || nstime_cmp(&from->time_max, &item->time_max) > 0;
+            from_min = from->int_min < item->int_min || from->float_min < item->float_min ||
+                       from->double_min < item->double_min || nstime_cmp(&from->time_min, &item->time_min) < 0;
+        }
+        if (from_max) {
+            item->int_max = from->int_max;
+            item->float_max = from->float_max;
+            item->double_max = from->double_max;
+            item->time_max = from->time_max;
+            if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
+                item->extreme_frame_in_invl = from->extreme_frame_in_invl;
+            }
+        }
+        if (from_min) {
+            item->int_min = from->int_min;
+            item->float_min = from->float_min;
+            item->double_min = from->double_min;
+            item->time_min = from->time_min;
+            if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
+                item->extreme_frame_in_invl = from->extreme_frame_in_invl;
+            }
+        }
+        item->int_tot += from->int_tot;
+        item->float_tot += from->float_tot;
+        item->double_tot += from->double_tot;
+        item->fields += from->fields;
+    }
+    /* LOAD adds to the time of intervals without counting fields in them. */
+    nstime_add(&item->time_tot, &from->time_tot);
+
+    item->frames += from->frames;
+    item->bytes += from->bytes;
+}
+
+gsize coarsen_io_graph_items(io_graph_item_t *items, gsize count, guint factor, int item_unit)
+{
+    gsize i, coarse_count;
+
+    if (factor <= 1) {
+        return count;
+    }
+
+    coarse_count = (count + factor - 1) / factor;
+    for (i = 0; i < count; i++) {
+        if (i % factor == 0) {
+            /* items[i / factor] has already been merged into an earlier
+             * item, or is items[i] itself. */
+            items[i / factor] = items[i];
+        } else {
+            merge_io_graph_item(&items[i / factor], &items[i], item_unit);
+        }
+    }
+    reset_io_graph_items(&items[coarse_count], count - coarse_count);
+    return coarse_count;
+}
+
 // Adapted from get_it_value in gtk/io_stat.c.
 double get_io_graph_item(const io_graph_item_t *items_, io_graph_item_unit_t val_units_, int idx, int hf_index_, const capture_file *cap_file, int interval_, int cur_idx_)
 {
@@ -59,6 +59,28 @@ typedef struct _io_graph_item_t {
     guint32  last_frame_in_invl;
 } io_graph_item_t;
 
+/* A value of a field, of the type its ftype says */
+typedef union {
+    guint64  uinteger64;
+    gint64   sinteger64;
+    gdouble  floating;
+    nstime_t time;
+} io_graph_field_value_t;
+
+/*
+ * A frame seen by an I/O graph of a field, with what's needed to count it
+ * again, for another unit or interval, without dissecting it: its values
+ * of the field are values[first_value] through
+ * values[first_value + num_values - 1] of an array kept alongside.
+ */
+typedef struct _io_graph_field_frame_t {
+    guint32  num;
+    guint32  pkt_len;
+    nstime_t rel_ts;
+    guint32  first_value;
+    guint32  num_values;
+} io_graph_field_frame_t;
+
 /** Reset (zero) an io_graph_item_t.
  *
  * @param items [in,out] Array containing the items to reset.
@@ -103,6 +125,13 @@ reset_io_graph_items(io_graph_item_t *items, gsize count) {
  */
 int get_io_graph_index(packet_info *pinfo, int interval);
 
+/** Get the interval (array index) for a time relative to the first packet.
+ * @param [in] rel_ts Time of interest.
+ * @param [in] interval Time interval in milliseconds.
+ * @return Array index on success, -1 on failure.
+ */
+int get_io_graph_index_from_ts(const nstime_t *rel_ts, int interval);
+
 /** Check field and item unit compatibility
  *
  * @param field_name [in] Header field name to check
@@ -126,6 +155,316 @@ GString *check_field_unit(const char *field_name, int *hf_index, io_graph_item_u
  */
 double get_io_graph_item(const io_graph_item_t *items, io_graph_item_unit_t val_units, int idx, int hf_index, const capture_file *cap_file, int interval, int cur_idx);
 
+/** Add the values of an io_graph_item_t to those of another, as if the
+ * packets of both had been counted in one interval.
+ *
+ * @param item [in,out] The item to add to.
+ * @param from [in] The item to add.
+ * @param item_unit [in] The type of unit to calculate. From IOG_ITEM_UNITS.
+ */
+void merge_io_graph_item(io_graph_item_t *item, const io_graph_item_t *from, int item_unit);
+
+/** Turn the items of an interval into those of a longer one, which is a
+ * multiple of it, in place.
+ *
+ * Item i of the result is the merge of items i * factor through
+ * (i + 1) * factor - 1; the items beyond the result are reset.
+ *
+ * @param items [in,out] Array containing the items.
+ * @param count [in] The number of items in the array.
+ * @param factor [in] The ratio of the longer interval to the shorter.
+ * @param item_unit [in] The type of unit to calculate. From IOG_ITEM_UNITS.
+ * @return The number of items of the longer interval.
+ */
+gsize coarsen_io_graph_items(io_graph_item_t *items, gsize count, guint factor, int item_unit);
+
+/** Get a value of a field as the io_graph_item_t functions use it.
+ * @param value [out] The value.
+ * @param ftype [in] The type of the field.
+ * @param fv [in] The value of the field in the protocol tree.
+ */
+static inline void
+get_io_graph_field_value(io_graph_field_value_t *value, enum ftenum ftype, fvalue_t *fv) {
+    switch (ftype) {
+    case FT_UINT8:
+    case FT_UINT16:
+    case FT_UINT24:
+    case FT_UINT32:
+        value->uinteger64 = fvalue_get_uinteger(fv);
+        break;
+    case FT_INT8:
+    case FT_INT16:
+    case FT_INT24:
+    case FT_INT32:
+        value->sinteger64 = fvalue_get_sinteger(fv);
+        break;
+    case FT_UINT40:
+    case FT_UINT48:
+    case FT_UINT56:
+    case FT_UINT64:
+        value->uinteger64 = fvalue_get_uinteger64(fv);
+        break;
+    case FT_INT40:
+    case FT_INT48:
+    case FT_INT56:
+    case FT_INT64:
+        value->sinteger64 = fvalue_get_sinteger64(fv);
+        break;
+    case FT_FLOAT:
+    case FT_DOUBLE:
+        value->floating = fvalue_get_floating(fv);
+        break;
+    case FT_RELATIVE_TIME:
+        value->time = *(nstime_t *)fvalue_get(fv);
+        break;
+    default:
+        /* Only counted */
+        value->uinteger64 = 0;
+        break;
+    }
+}
+
+/** Update the advanced statistics of an io_graph_item_t with a value of
+ * its field.
+ * @param items [in,out] Array containing the item to update.
+ * @param idx [in] Index of the item to update.
+ * @param num [in] Number of the frame the value is in.
+ * @param rel_ts [in] Time of the frame, relative to the first.
+ * @param ftype [in] The type of the field.
+ * @param value [in] The value.
+ * @param item_unit [in] The type of unit to calculate. From IOG_ITEM_UNITS.
+ * @param interval [in] Timing interval in ms.
+ */
+static inline void
+update_io_graph_item_value(io_graph_item_t *items, int idx, guint32 num, const nstime_t *rel_ts, enum ftenum ftype, const io_graph_field_value_t *value, int item_unit, guint32 interval) {
+    io_graph_item_t *item = &items[idx];
+    gint64 new_int64;
+    guint64 new_uint64;
+    float new_float;
+    double new_double;
+    const nstime_t *new_time;
+
+    /* Update the appropriate counters. If fields == 0, this is the first seen
+     *  value so set any min/max values accordingly. */
+    switch (ftype) {
+    case FT_UINT8:
+    case FT_UINT16:
+    case FT_UINT24:
+    case FT_UINT32:
+        new_uint64 = value->uinteger64;
+
+        if ((new_uint64 > (guint64)item->int_max) || (item->fields == 0)) {
+            item->int_max = new_uint64;
+            item->double_max = (gdouble)new_uint64;
+            if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
+                item->extreme_frame_in_invl = num;
+            }
+        }
+        if ((new_uint64 < (guint64)item->int_min) || (item->fields == 0)) {
+            item->int_min = new_uint64;
+            item->double_min = (gdouble)new_uint64;
+            if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
+                item->extreme_frame_in_invl = num;
+            }
+        }
+        item->int_tot += new_uint64;
+        item->double_tot += (gdouble)new_uint64;
+        item->fields++;
+        break;
+    case FT_INT8:
+    case FT_INT16:
+    case FT_INT24:
+    case FT_INT32:
+        new_int64 = value->sinteger64;
+        if ((new_int64 > item->int_max) || (item->fields == 0)) {
+            item->int_max = new_int64;
+            item->double_max = (gdouble)new_int64;
+            if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
+                item->extreme_frame_in_invl = num;
+            }
+        }
+        if ((new_int64 < item->int_min) || (item->fields == 0)) {
+            item->int_min = new_int64;
+            item->double_min = (gdouble)new_int64;
+            if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
+                item->extreme_frame_in_invl = num;
+            }
+        }
+        item->int_tot += new_int64;
+        item->double_tot += (gdouble)new_int64;
+        item->fields++;
+        break;
+    case FT_UINT40:
+    case FT_UINT48:
+    case FT_UINT56:
+    case FT_UINT64:
+        new_uint64 = value->uinteger64;
+        if ((new_uint64 > (guint64)item->int_max) || (item->fields == 0)) {
+            item->int_max = new_uint64;
+            item->double_max = (gdouble)new_uint64;
+            if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
+                item->extreme_frame_in_invl = num;
+            }
+        }
+        if ((new_uint64 < (guint64)item->int_min) || (item->fields == 0)) {
+            item->int_min = new_uint64;
+            item->double_min = (gdouble)new_uint64;
+            if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
+                item->extreme_frame_in_invl = num;
+            }
+        }
+        item->int_tot += new_uint64;
+        item->double_tot += (gdouble)new_uint64;
+        item->fields++;
+        break;
+    case FT_INT40:
+    case FT_INT48:
+    case FT_INT56:
+    case FT_INT64:
+        new_int64 = value->sinteger64;
+        if ((new_int64 > item->int_max) || (item->fields == 0)) {
+            item->int_max = new_int64;
+            item->double_max = (gdouble)new_int64;
+            if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
+                item->extreme_frame_in_invl = num;
+            }
+        }
+        if ((new_int64 < item->int_min) || (item->fields == 0)) {
+            item->int_min = new_int64;
+            item->double_min = (gdouble)new_int64;
+            if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
+                item->extreme_frame_in_invl = num;
+            }
+        }
+        item->int_tot += new_int64;
+        item->double_tot += (gdouble)new_int64;
+        item->fields++;
+        break;
+    case FT_FLOAT:
+        new_float = (gfloat)value->floating;
+        if ((new_float > item->float_max) || (item->fields == 0)) {
+            item->float_max = new_float;
+            if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
+                item->extreme_frame_in_invl = num;
+            }
+        }
+        if ((new_float < item->float_min) || (item->fields == 0)) {
+            item->float_min = new_float;
+            if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
+                item->extreme_frame_in_invl = num;
+            }
+        }
+        item->float_tot += new_float;
+        item->fields++;
+        break;
+    case FT_DOUBLE:
+        new_double = value->floating;
+        if ((new_double > item->double_max) || (item->fields == 0)) {
+            item->double_max = new_double;
+            if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
+                item->extreme_frame_in_invl = num;
+            }
+        }
+        if ((new_double < item->double_min) || (item->fields == 0)) {
+            item->double_min = new_double;
+            if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
+                item->extreme_frame_in_invl = num;
+            }
+        }
+        item->double_tot += new_double;
+        item->fields++;
+        break;
+    case FT_RELATIVE_TIME:
+        new_time = &value->time;
+
+        switch (item_unit) {
+        case IOG_ITEM_UNIT_CALC_LOAD:
+        {
+            guint64 t, pt; /* time in us */
+            int j;
+            /*
+             * Add the time this call spanned each interval according to its contribution
+             * to that interval.
+             */
+            t = new_time->secs;
+            t = t * 1000000 + new_time->nsecs / 1000;
+            j = idx;
+            /*
+             * Handle current interval
+             */
+            pt = rel_ts->secs * 1000000 + rel_ts->nsecs / 1000;
+            pt = pt % (interval * 1000);
+            if (pt > t) {
+                pt = t;
+            }
+            while (t) {
+                io_graph_item_t *load_item;
+
+                load_item = &items[j];
+                load_item->time_tot.nsecs += (int) (pt * 1000);
+                if (load_item->time_tot.nsecs > 1000000000) {
+                    load_item->time_tot.secs++;
+                    load_item->time_tot.nsecs -= 1000000000;
+                }
+
+                if (j == 0) {
+                    break;
+                }
+                j--;
+                t -= pt;
+                if (t > (guint64) interval * 1000) {
+                    pt = (guint64) interval * 1000;
+                } else {
+                    pt = t;
+                }
+            }
+            break;
+        }
+        default:
+            if ( (new_time->secs > item->time_max.secs)
+                 || ( (new_time->secs == item->time_max.secs)
+                      && (new_time->nsecs > item->time_max.nsecs))
+                 || (item->fields == 0)) {
+                item->time_max = *new_time;
+                if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
+                    item->extreme_frame_in_invl = num;
+                }
+            }
+            if ( (new_time->secs<item->time_min.secs)
+                 || ( (new_time->secs == item->time_min.secs)
+                      && (new_time->nsecs < item->time_min.nsecs))
+                 || (item->fields == 0)) {
+                item->time_min = *new_time;
+                if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
+                    item->extreme_frame_in_invl = num;
+                }
+            }
+            nstime_add(&item->time_tot, new_time);
+            item->fields++;
+        }
+        break;
+    default:
+        if ((item_unit == IOG_ITEM_UNIT_CALC_FRAMES) ||
+            (item_unit == IOG_ITEM_UNIT_CALC_FIELDS)) {
+            /*
+             * It's not an integeresque type, but
+             * all we want to do is count it, so
+             * that's all right.
+             */
+            item->fields++;
+        }
+        else {
+            /*
+             * "Can't happen"; see the "check that the
+             * type is compatible" check in
+             * filter_callback().
+             */
+            g_assert_not_reached();
+        }
+        break;
+    }
+}
+
 /** Update the values of an io_graph_item_t.
  *
  * Frame and byte counts are always calculated. If edt is non-NULL advanced
@@ -153,238 +492,18 @@ update_io_graph_item(io_graph_item_t *items, int idx, packet_info *pinfo, epan_d
     if (edt && hf_index >= 0) {
         GPtrArray *gp;
         guint i;
+        enum ftenum ftype;
+        io_graph_field_value_t value;
 
         gp = proto_get_finfo_ptr_array(edt->tree, hf_index);
         if (!gp) {
             return FALSE;
         }
 
-        /* Update the appropriate counters. If fields == 0, this is the first seen
-         *  value so set any min/max values accordingly. */
+        ftype = proto_registrar_get_ftype(hf_index);
         for (i=0; i < gp->len; i++) {
-            gint64 new_int64;
-            guint64 new_uint64;
-            float new_float;
-            double new_double;
-            nstime_t *new_time;
-
-            switch (proto_registrar_get_ftype(hf_index)) {
-            case FT_UINT8:
-            case FT_UINT16:
-            case FT_UINT24:
-            case FT_UINT32:
-                new_uint64 = fvalue_get_uinteger(&((field_info *)gp->pdata[i])->value);
-
-                if ((new_uint64 > (guint64)item->int_max) || (item->fields == 0)) {
-                    item->int_max = new_uint64;
-                    item->double_max = (gdouble)new_uint64;
-                    if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
-                        item->extreme_frame_in_invl = pinfo->num;
-                    }
-                }
-                if ((new_uint64 < (guint64)item->int_min) || (item->fields == 0)) {
-                    item->int_min = new_uint64;
-                    item->double_min = (gdouble)new_uint64;
-                    if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
-                        item->extreme_frame_in_invl = pinfo->num;
-                    }
-                }
-                item->int_tot += new_uint64;
-                item->double_tot += (gdouble)new_uint64;
-                item->fields++;
-                break;
-            case FT_INT8:
-            case FT_INT16:
-            case FT_INT24:
-            case FT_INT32:
-                new_int64 = fvalue_get_sinteger(&((field_info *)gp->pdata[i])->value);
-                if ((new_int64 > item->int_max) || (item->fields == 0)) {
-                    item->int_max = new_int64;
-                    item->double_max = (gdouble)new_int64;
-                    if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
-                        item->extreme_frame_in_invl = pinfo->num;
-                    }
-                }
-                if ((new_int64 < item->int_min) || (item->fields == 0)) {
-                    item->int_min = new_int64;
-                    item->double_min = (gdouble)new_int64;
-                    if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
-                        item->extreme_frame_in_invl = pinfo->num;
-                    }
-                }
-                item->int_tot += new_int64;
-                item->double_tot += (gdouble)new_int64;
-                item->fields++;
-                break;
-            case FT_UINT40:
-            case FT_UINT48:
-            case FT_UINT56:
-            case FT_UINT64:
-                new_uint64 = fvalue_get_uinteger64(&((field_info *)gp->pdata[i])->value);
-                if ((new_uint64 > (guint64)item->int_max) || (item->fields == 0)) {
-                    item->int_max = new_uint64;
-                    item->double_max = (gdouble)new_uint64;
-                    if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
-                        item->extreme_frame_in_invl = pinfo->num;
-                    }
-                }
-                if ((new_uint64 < (guint64)item->int_min) || (item->fields == 0)) {
-                    item->int_min = new_uint64;
-                    item->double_min = (gdouble)new_uint64;
-                    if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
-                        item->extreme_frame_in_invl = pinfo->num;
-                    }
-                }
-                item->int_tot += new_uint64;
-                item->double_tot += (gdouble)new_uint64;
-                item->fields++;
-                break;
-            case FT_INT40:
-            case FT_INT48:
-            case FT_INT56:
-            case FT_INT64:
-                new_int64 = fvalue_get_sinteger64(&((field_info *)gp->pdata[i])->value);
-                if ((new_int64 > item->int_max) || (item->fields == 0)) {
-                    item->int_max = new_int64;
-                    item->double_max = (gdouble)new_int64;
-                    if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
-                        item->extreme_frame_in_invl = pinfo->num;
-                    }
-                }
-                if ((new_int64 < item->int_min) || (item->fields == 0)) {
-                    item->int_min = new_int64;
-                    item->double_min = (gdouble)new_int64;
-                    if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
-                        item->extreme_frame_in_invl = pinfo->num;
-                    }
-                }
-                item->int_tot += new_int64;
-                item->double_tot += (gdouble)new_int64;
-                item->fields++;
-                break;
-            case FT_FLOAT:
-                new_float = (gfloat)fvalue_get_floating(&((field_info *)gp->pdata[i])->value);
-                if ((new_float > item->float_max) || (item->fields == 0)) {
-                    item->float_max = new_float;
-                    if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
-                        item->extreme_frame_in_invl = pinfo->num;
-                    }
-                }
-                if ((new_float < item->float_min) || (item->fields == 0)) {
-                    item->float_min = new_float;
-                    if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
-                        item->extreme_frame_in_invl = pinfo->num;
-                    }
-                }
-                item->float_tot += new_float;
-                item->fields++;
-                break;
-            case FT_DOUBLE:
-                new_double = fvalue_get_floating(&((field_info *)gp->pdata[i])->value);
-                if ((new_double > item->double_max) || (item->fields == 0)) {
-                    item->double_max = new_double;
-                    if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
-                        item->extreme_frame_in_invl = pinfo->num;
-                    }
-                }
-                if ((new_double < item->double_min) || (item->fields == 0)) {
-                    item->double_min = new_double;
-                    if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
-                        item->extreme_frame_in_invl = pinfo->num;
-                    }
-                }
-                item->double_tot += new_double;
-                item->fields++;
-                break;
-            case FT_RELATIVE_TIME:
-                new_time = (nstime_t *)fvalue_get(&((field_info *)gp->pdata[i])->value);
-
-                switch (item_unit) {
-                case IOG_ITEM_UNIT_CALC_LOAD:
-                {
-                    guint64 t, pt; /* time in us */
-                    int j;
-                    /*
-                     * Add the time this call spanned each interval according to its contribution
-                     * to that interval.
-                     */
-                    t = new_time->secs;
-                    t = t * 1000000 + new_time->nsecs / 1000;
-                    j = idx;
-                    /*
-                     * Handle current interval
-                     */
-                    pt = pinfo->rel_ts.secs * 1000000 + pinfo->rel_ts.nsecs / 1000;
-                    pt = pt % (interval * 1000);
-                    if (pt > t) {
-                        pt = t;
-                    }
-                    while (t) {
-                        io_graph_item_t *load_item;
-
-                        load_item = &items[j];
-                        load_item->time_tot.nsecs += (int) (pt * 1000);
-                        if (load_item->time_tot.nsecs > 1000000000) {
-                            load_item->time_tot.secs++;
-                            load_item->time_tot.nsecs -= 1000000000;
-                        }
-
-                        if (j == 0) {
-                            break;
-                        }
-                        j--;
-                        t -= pt;
-                        if (t > (guint64) interval * 1000) {
-                            pt = (guint64) interval * 1000;
-                        } else {
-                            pt = t;
-                        }
-                    }
-                    break;
-                }
-                default:
-                    if ( (new_time->secs > item->time_max.secs)
-                         || ( (new_time->secs == item->time_max.secs)
-                              && (new_time->nsecs > item->time_max.nsecs))
-                         || (item->fields == 0)) {
-                        item->time_max = *new_time;
-                        if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
-                            item->extreme_frame_in_invl = pinfo->num;
-                        }
-                    }
-                    if ( (new_time->secs<item->time_min.secs)
-                         || ( (new_time->secs == item->time_min.secs)
-                              && (new_time->nsecs < item->time_min.nsecs))
-                         || (item->fields == 0)) {
-                        item->time_min = *new_time;
-                        if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
-                            item->extreme_frame_in_invl = pinfo->num;
-                        }
-                    }
-                    nstime_add(&item->time_tot, new_time);
-                    item->fields++;
-                }
-                break;
-            default:
-                if ((item_unit == IOG_ITEM_UNIT_CALC_FRAMES) ||
-                    (item_unit == IOG_ITEM_UNIT_CALC_FIELDS)) {
-                    /*
-                     * It's not an integeresque type, but
-                     * all we want to do is count it, so
-                     * that's all right.
-                     */
-                    item->fields++;
-                }
-                else {
-                    /*
-                     * "Can't happen"; see the "check that the
-                     * type is compatible" check in
-                     * filter_callback().
-                     */
-                    g_assert_not_reached();
-                }
-                break;
-            }
+            get_io_graph_field_value(&value, ftype, &((field_info *)gp->pdata[i])->value);
+            update_io_graph_item_value(items, idx, pinfo->num, &pinfo->rel_ts, ftype, &value, item_unit, interval);
         }
     }
 
@@ -394,6 +513,35 @@ update_io_graph_item(io_graph_item_t *items, int idx, packet_info *pinfo, epan_d
     return TRUE;
 }
 
+/** Update the values of an io_graph_item_t from the values of its field
+ * in a frame recorded before, as update_io_graph_item() would from the
+ * frame's dissection.
+ * @param items [in,out] Array containing the item to update.
+ * @param idx [in] Index of the item to update.
+ * @param frame [in] The frame.
+ * @param values [in] The values of the field in the frame.
+ * @param ftype [in] The type of the field.
+ * @param item_unit [in] The type of unit to calculate. From IOG_ITEM_UNITS.
+ * @param interval [in] Timing interval in ms.
+ */
+static inline void
+update_io_graph_item_from_values(io_graph_item_t *items, int idx, const io_graph_field_frame_t *frame, const io_graph_field_value_t *values, enum ftenum ftype, int item_unit, guint32 interval) {
+    io_graph_item_t *item = &items[idx];
+    guint i;
+
+    if (item->first_frame_in_invl == 0) {
+        item->first_frame_in_invl = frame->num;
+    }
+    item->last_frame_in_invl = frame->num;
+
+    for (i = 0; i < frame->num_values; i++) {
+        update_io_graph_item_value(items, idx, frame->num, &frame->rel_ts, ftype, &values[i], item_unit, interval);
+    }
+
+    item->frames++;
+    item->bytes += frame->pkt_len;
+}
+
 
 #ifdef __cplusplus
 }
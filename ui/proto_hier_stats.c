@@ -13,6 +13,7 @@
 #include <string.h>
 
 #include "file.h"
+#include "frame_proto_hier.h"
 #include "frame_tvbuff.h"
 #include "ui/proto_hier_stats.h"
 #include "ui/progress_dlg.h"
@@ -77,57 +78,17 @@ find_stat_node(GNode *parent_stat_node, header_field_info *needle_hfinfo)
 }
 
 
-    static void
-process_node(proto_node *ptree_node, GNode *parent_stat_node, ph_stats_t *ps)
+    void
+ph_stats_get_stack(proto_tree *protocol_tree, GArray *stack)
 {
+    proto_node		*ptree_node;
     field_info		*finfo;
-    ph_stats_node_t	*stats;
-    proto_node		*proto_sibling_node;
-    GNode		*stat_node;
-
-    finfo = PNODE_FINFO(ptree_node);
-    /* We don't fake protocol nodes we expect them to have a field_info.
-     * Dissection with faked proto tree? */
-    g_assert(finfo);
-
-    /* If the field info isn't related to a protocol but to a field,
-     * don't count them, as they don't belong to any protocol.
-     * (happens e.g. for toplevel tree item of desegmentation "[Reassembled TCP Segments]") */
-    if (finfo->hfinfo->parent != -1) {
-        /* Skip this element, use parent status node */
-        stat_node = parent_stat_node;
-        stats = STAT_NODE_STATS(stat_node);
-    } else {
-        stat_node = find_stat_node(parent_stat_node, finfo->hfinfo);
-
-        stats = STAT_NODE_STATS(stat_node);
-        stats->num_pkts_total++;
-        stats->num_bytes_total += finfo->length;
-    }
+    ph_stack_item_t	item;
 
-    proto_sibling_node = ptree_node->next;
+    g_array_set_size(stack, 0);
 
-    if (proto_sibling_node) {
-        /* If the name does not exist for this proto_sibling_node, then it is
-         * not a normal protocol in the top-level tree.  It was instead
-         * added as a normal tree such as IPv6's Hop-by-hop Option Header and
-         * should be skipped when creating the protocol hierarchy display. */
-        if(strlen(PNODE_FINFO(proto_sibling_node)->hfinfo->name) == 0 && ptree_node->next)
-            proto_sibling_node = proto_sibling_node->next;
-
-        process_node(proto_sibling_node, stat_node, ps);
-    } else {
-        stats->num_pkts_last++;
-        stats->num_bytes_last += finfo->length;
-    }
-}
-
-
-
-    static void
-process_tree(proto_tree *protocol_tree, ph_stats_t* ps)
-{
-    proto_node	*ptree_node;
+    if (pc_proto_id == -1)
+        pc_proto_id = proto_registrar_get_id_byname("pkt_comment");
 
     /*
      * If our first item is a comment, skip over it. This keeps
@@ -139,19 +100,67 @@ process_tree(proto_tree *protocol_tree, ph_stats_t* ps)
         ptree_node = ptree_node->next;
     }
 
-    if (!ptree_node) {
-        return;
+    while (ptree_node) {
+        finfo = PNODE_FINFO(ptree_node);
+        /* We don't fake protocol nodes we expect them to have a field_info.
+         * Dissection with faked proto tree? */
+        g_assert(finfo);
+
+        item.hf_id = finfo->hfinfo->id;
+        item.length = finfo->length;
+        g_array_append_val(stack, item);
+
+        ptree_node = ptree_node->next;
+
+        /* If the name does not exist for this sibling, then it is
+         * not a normal protocol in the top-level tree.  It was instead
+         * added as a normal tree such as IPv6's Hop-by-hop Option Header and
+         * should be skipped when creating the protocol hierarchy display. */
+        if (ptree_node && strlen(PNODE_FINFO(ptree_node)->hfinfo->name) == 0)
+            ptree_node = ptree_node->next;
+    }
+}
+
+    static void
+process_stack(const GArray *stack, ph_stats_t *ps)
+{
+    const ph_stack_item_t	*item = NULL;
+    header_field_info	*hfinfo;
+    ph_stats_node_t	*stats;
+    GNode		*stat_node;
+    guint		i;
+
+    stat_node = ps->stats_tree;
+    for (i = 0; i < stack->len; i++) {
+        item = &g_array_index(stack, ph_stack_item_t, i);
+        hfinfo = proto_registrar_get_nth(item->hf_id);
+
+        /* If the field info isn't related to a protocol but to a field,
+         * don't count them, as they don't belong to any protocol.
+         * (happens e.g. for toplevel tree item of desegmentation "[Reassembled TCP Segments]")
+         * Use the parent status node. */
+        if (hfinfo->parent == -1) {
+            stat_node = find_stat_node(stat_node, hfinfo);
+
+            stats = STAT_NODE_STATS(stat_node);
+            stats->num_pkts_total++;
+            stats->num_bytes_total += item->length;
+        }
     }
 
-    process_node(ptree_node, ps->stats_tree, ps);
+    /* The last item ends the stack of the protocol it's counted with. */
+    stats = STAT_NODE_STATS(stat_node);
+    if (item && stats) {
+        stats->num_pkts_last++;
+        stats->num_bytes_last += item->length;
+    }
 }
 
     static gboolean
 process_record(capture_file *cf, frame_data *frame, column_info *cinfo,
-               wtap_rec *rec, Buffer *buf, ph_stats_t* ps)
+               wtap_rec *rec, Buffer *buf, GArray *stack)
 {
     epan_dissect_t	edt;
-    double		cur_time;
 
     /* Load the record from the capture file */
     if (!cf_read_record(cf, frame, rec, buf))
@@ -165,17 +174,8 @@ process_record(capture_file *cf, frame_data *frame, column_info *cinfo,
                      frame_tvbuff_new_buffer(&cf->provider, frame, buf),
                      frame, cinfo);
 
-    /* Get stats from this protocol tree */
-    process_tree(edt.tree, ps);
-
-    if (frame->has_ts) {
-        /* Update times */
-        cur_time = nstime_to_sec(&frame->abs_ts);
-        if (cur_time < ps->first_time)
-            ps->first_time = cur_time;
-        if (cur_time > ps->last_time)
-            ps->last_time = cur_time;
-    }
+    /* Get the protocols of this protocol tree */
+    ph_stats_get_stack(edt.tree, stack);
 
     /* Free our memory. */
     epan_dissect_cleanup(&edt);
@@ -199,11 +199,10 @@ ph_stats_new(capture_file *cf)
     gchar	status_str[100];
     int		progbar_nextstep;
     int		progbar_quantum;
+    GArray	*stack;
 
     if (!cf) return NULL;
 
-    pc_proto_id = proto_registrar_get_id_byname("pkt_comment");
-
     /* Initialize the data */
     ps = g_new(ph_stats_t, 1);
     ps->tot_packets = 0;
@@ -229,6 +228,7 @@ ph_stats_new(capture_file *cf)
 
     wtap_rec_init(&rec);
     ws_buffer_init(&buf, 1514);
+    stack = g_array_new(FALSE, FALSE, sizeof(ph_stack_item_t));
 
     for (framenum = 1; framenum <= cf->count; framenum++) {
         frame = frame_data_sequence_find(cf->provider.frames, framenum);
@@ -289,8 +289,13 @@ ph_stats_new(capture_file *cf)
                 }
             }
 
-            /* we don't care about colinfo */
-            if (!process_record(cf, frame, NULL, &rec, &buf, ps)) {
+            /* Use the protocols recorded on the first pass if we have
+               them; otherwise dissect the frame (we don't care about
+               colinfo) */
+            if (cf->proto_hier != NULL &&
+                framenum <= frame_proto_hier_frame_count(cf->proto_hier)) {
+                frame_proto_hier_get(cf->proto_hier, frame, stack);
+            } else if (!process_record(cf, frame, NULL, &rec, &buf, stack)) {
                 /*
                  * Give up, and set "stop_flag" so we
                  * just abort rather than popping up
@@ -300,6 +305,18 @@ ph_stats_new(capture_file *cf)
                 break;
             }
 
+            /* Get stats from this protocol stack */
+            process_stack(stack, ps);
+
+            if (frame->has_ts) {
+                /* Update times */
+                double cur_time = nstime_to_sec(&frame->abs_ts);
+                if (cur_time < ps->first_time)
+                    ps->first_time = cur_time;
+                if (cur_time > ps->last_time)
+                    ps->last_time = cur_time;
+            }
+
             tot_packets++;
             tot_bytes += frame->pkt_len;
         }
@@ -309,6 +326,7 @@ ph_stats_new(capture_file *cf)
 
     wtap_rec_cleanup(&rec);
     ws_buffer_free(&buf);
+    g_array_free(stack, TRUE);
 
     /* We're done calculating the statistics; destroy the progress bar
        if it was created. */
@@ -38,8 +38,22 @@ typedef struct {
     double	last_time;	/* seconds (msec resolution) of last packet  */
 } ph_stats_t;
 
+/** An item of a protocol tree that the statistics count */
+typedef struct {
+    int		hf_id;
+    gint	length;
+} ph_stack_item_t;
+
 ph_stats_t *ph_stats_new(capture_file *cf);
 
+/** Get the items of a frame's protocol tree that the statistics count,
+ * in order.  The tree must have been made without faking protocols.
+ *
+ * @param protocol_tree the tree
+ * @param[out] stack set to the ph_stack_item_t of the items
+ */
+void ph_stats_get_stack(proto_tree *protocol_tree, GArray *stack);
+
 void ph_stats_free(ph_stats_t *ps);
 
 #ifdef __cplusplus
@@ -215,6 +215,17 @@ QString CaptureFilePropertiesDialog::summaryToHtml()
             << table_row_end;
     }
 
+    guint64 record_reads = summary.record_cache_hits + summary.record_cache_misses;
+    if (record_reads > 0) {
+        out << table_row_begin
+            << table_vheader_tmpl.arg(tr("Record cache hits"))
+            << table_data_tmpl.arg(tr("%1 of %2 reads (%3%)")
+                                   .arg(summary.record_cache_hits)
+                                   .arg(record_reads)
+                                   .arg(100.0 * summary.record_cache_hits / record_reads, 1, 'f', 1))
+            << table_row_end;
+    }
+
     out << table_end;
 
     // Time Section
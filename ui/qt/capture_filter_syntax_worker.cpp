@@ -44,6 +44,9 @@ static QMutex pcap_compile_mtx_;
 #define DUMMY_SNAPLENGTH                65535
 #define DUMMY_NETMASK                   0xFF000000
 
+// Forget what we've found out once we've checked this many filters.
+#define MAX_CACHED_RESULTS              1000
+
 void CaptureFilterSyntaxWorker::start() {
 #ifdef HAVE_LIBPCAP
     forever {
@@ -91,7 +94,20 @@ void CaptureFilterSyntaxWorker::start() {
             }
         }
 
+        if (dlt_errors_.size() > MAX_CACHED_RESULTS) dlt_errors_.clear();
+        if (extcap_results_.size() > MAX_CACHED_RESULTS) extcap_results_.clear();
+
         foreach (gint dlt, active_dlts.values()) {
+            QPair<int, QString> dlt_key(dlt, filter);
+            if (dlt_errors_.contains(dlt_key)) {
+                if (!dlt_errors_[dlt_key].isEmpty()) {
+                    state = SyntaxLineEdit::Invalid;
+                    err_str = dlt_errors_[dlt_key];
+                    break;
+                }
+                continue;
+            }
+
             pcap_compile_mtx_.lock();
             pd = pcap_open_dead(dlt, DUMMY_SNAPLENGTH);
             if (pd == NULL)
@@ -113,8 +129,11 @@ void CaptureFilterSyntaxWorker::start() {
                 DEBUG_SYNTAX_CHECK("unknown", "known bad");
                 state = SyntaxLineEdit::Invalid;
                 err_str = pcap_geterr(pd);
+                dlt_errors_[dlt_key] = err_str;
             } else {
                 DEBUG_SYNTAX_CHECK("unknown", "known good");
+                pcap_freecode(&fcode);
+                dlt_errors_[dlt_key] = QString();
             }
             pcap_close(pd);
 
@@ -129,7 +148,15 @@ void CaptureFilterSyntaxWorker::start() {
                 gchar *error = NULL;
 
                 device = &g_array_index(global_capture_opts.all_ifaces, interface_t, extcapif);
-                extcap_filter_status status = extcap_verify_capture_filter(device->name, filter.toUtf8().constData(), &error);
+                QPair<QString, QString> extcap_key(device->name, filter);
+                extcap_filter_status status;
+                if (extcap_results_.contains(extcap_key)) {
+                    status = (extcap_filter_status) extcap_results_[extcap_key].first;
+                    error = g_strdup(extcap_results_[extcap_key].second.toUtf8().constData());
+                } else {
+                    status = extcap_verify_capture_filter(device->name, filter.toUtf8().constData(), &error);
+                    extcap_results_[extcap_key] = QPair<int, QString>(status, error);
+                }
                 if (status == EXTCAP_FILTER_VALID) {
                     DEBUG_SYNTAX_CHECK("unknown", "known good");
                 } else if (status == EXTCAP_FILTER_INVALID) {
@@ -10,8 +10,10 @@
 #ifndef CAPTURE_FILTER_SYNTAX_WORKER_H
 #define CAPTURE_FILTER_SYNTAX_WORKER_H
 
+#include <QHash>
 #include <QMutex>
 #include <QObject>
+#include <QPair>
 #include <QWaitCondition>
 
 class CaptureFilterSyntaxWorker : public QObject
@@ -30,6 +32,12 @@ private:
     QWaitCondition data_cond_;
     QString filter_text_;
 
+    // What we found out about the filters checked so far, so that going
+    // back to one (e.g. with backspace) needn't compile it or, worse, run
+    // an extcap tool again.  Only used by the worker thread.
+    QHash<QPair<int, QString>, QString> dlt_errors_;      // (DLT, filter) -> error, empty if none
+    QHash<QPair<QString, QString>, QPair<int, QString> > extcap_results_; // (interface, filter) -> (extcap_filter_status, error)
+
 signals:
     void syntaxResult(QString filter, int state, QString err_msg);
 };
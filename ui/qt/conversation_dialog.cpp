@@ -16,6 +16,8 @@
 #include "ui/tap-tcp-stream.h"
 #include "ui/traffic_table_ui.h"
 
+#include "frame_traffic_tables.h"
+
 #include "wsutil/str_util.h"
 
 #include <ui/qt/utils/qt_ui_utils.h>
@@ -104,7 +106,9 @@ ConversationDialog::ConversationDialog(QWidget &parent, CaptureFile &cf, int cli
     updateWidgets();
 //    currentTabChanged();
 
-    cap_file_.delayedRetapPackets();
+    if (!fillTablesFromFile()) {
+        cap_file_.delayedRetapPackets();
+    }
 }
 
 ConversationDialog::~ConversationDialog()
@@ -301,6 +305,14 @@ void ConversationDialog::on_displayFilterCheckBox_toggled(bool checked)
         set_tap_dfilter(trafficTableTabWidget()->widget(i), filter);
     }
 
+    if (fillTablesFromFile()) {
+        return;
+    }
+
+    for (int i = 0; i < trafficTableTabWidget()->count(); i++) {
+        mark_tap_listener_for_retap(trafficTableTabWidget()->widget(i));
+    }
+
     cap_file_.retapPackets();
 }
 
@@ -704,6 +716,16 @@ void ConversationTreeWidget::tapReset(void *conv_hash_ptr)
     conv_tree->max_rel_stop_time_ = 0;
 }
 
+bool ConversationTreeWidget::fillFromFileTables(const struct frame_traffic_tables *traffic_tables)
+{
+    tapReset(&hash_);
+    if (!frame_traffic_tables_copy(traffic_tables, table_, FALSE, &hash_)) {
+        return false;
+    }
+    tapDraw(&hash_);
+    return true;
+}
+
 void ConversationTreeWidget::tapDraw(void *conv_hash_ptr)
 {
     conv_hash_t *hash = (conv_hash_t*)conv_hash_ptr;
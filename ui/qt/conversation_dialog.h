@@ -19,6 +19,8 @@ public:
     explicit ConversationTreeWidget(QWidget *parent, register_ct_t* table);
     ~ConversationTreeWidget();
 
+    bool fillFromFileTables(const struct frame_traffic_tables *traffic_tables);
+
     static void tapReset(void *conv_hash_ptr);
     static void tapDraw(void *conv_hash_ptr);
     double minRelStartTime() { return min_rel_start_time_; }
@@ -16,6 +16,9 @@
 
 #include <epan/conversation.h>
 #include <epan/conversation_debug.h>
+#include <epan/reassemble.h>
+
+#include <wsutil/str_util.h>
 
 #include <ui/qt/utils/qt_ui_utils.h>
 #include "wireshark_application.h"
@@ -38,6 +41,9 @@ ConversationHashTablesDialog::ConversationHashTablesDialog(QWidget *parent) :
     html += hashTableToHtmlTable("conversation_hashtable_no_port2", get_conversation_hashtable_no_port2());
     html += hashTableToHtmlTable("conversation_hashtable_no_addr2_or_port2", get_conversation_hashtable_no_addr2_or_port2());
 
+    html += "<h3>Reassembly Tables</h3>\n";
+    html += reassemblyStatsToHtmlTable();
+
     ui->conversationTextEdit->setHtml(html);
 }
 
@@ -58,13 +64,13 @@ populate_html_table(gpointer data, gpointer user_data)
     wmem_free(NULL, tmp);
 }
 
-const QString ConversationHashTablesDialog::hashTableToHtmlTable(const QString table_name, wmem_map_t *hash_table)
+const QString ConversationHashTablesDialog::hashTableToHtmlTable(const QString table_name, wmem_flat_map_t *hash_table)
 {
     wmem_list_t *conversation_keys = NULL;
     guint num_keys = 0;
     if (hash_table)
     {
-        conversation_keys = wmem_map_get_keys(NULL, hash_table);
+        conversation_keys = wmem_flat_map_get_keys(NULL, hash_table);
         num_keys = wmem_list_count(conversation_keys);
     }
 
@@ -83,3 +89,27 @@ const QString ConversationHashTablesDialog::hashTableToHtmlTable(const QString t
         wmem_destroy_list(conversation_keys);
     return html_table;
 }
+
+const QString ConversationHashTablesDialog::reassemblyStatsToHtmlTable()
+{
+    reassembly_stats_t stats;
+
+    reassembly_tables_get_stats(&stats);
+
+    int one_em = fontMetrics().height();
+    QString html_table = QString("<p>%1 tables</p>").arg(stats.tables);
+    html_table += QString("<table cellpadding=\"%1\">\n").arg(one_em / 4);
+    html_table += "<tr><th align=\"left\">Reassemblies</th><th align=\"left\">Count</th><th align=\"left\">Data</th></tr>\n";
+    html_table += QString("<tr><td>Waiting for fragments</td><td>%1</td><td>%2</td></tr>\n")
+            .arg(stats.pending_heads)
+            .arg(gchar_free_to_qstring(format_size(stats.pending_bytes, format_size_unit_bytes|format_size_prefix_iec)));
+    html_table += QString("<tr><td>Complete</td><td>%1</td><td>%2</td></tr>\n")
+            .arg(stats.complete_heads)
+            .arg(gchar_free_to_qstring(format_size(stats.complete_bytes, format_size_unit_bytes|format_size_prefix_iec)));
+    html_table += QString("<tr><td>Dropped to stay within limits</td><td>%1</td><td>%2</td></tr>\n")
+            .arg(stats.evicted_heads)
+            .arg(gchar_free_to_qstring(format_size(stats.evicted_bytes, format_size_unit_bytes|format_size_prefix_iec)));
+    html_table += "</table>\n";
+
+    return html_table;
+}
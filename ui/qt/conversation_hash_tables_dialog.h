@@ -28,7 +28,8 @@ public:
 private:
     Ui::ConversationHashTablesDialog *ui;
 
-    const QString hashTableToHtmlTable(const QString table_name, wmem_map_t *hash_table);
+    const QString hashTableToHtmlTable(const QString table_name, wmem_flat_map_t *hash_table);
+    const QString reassemblyStatsToHtmlTable();
 };
 
 #endif // CONVERSATION_HASH_TABLES_DIALOG_H
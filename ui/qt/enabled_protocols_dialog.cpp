@@ -13,6 +13,7 @@
 #include <QElapsedTimer>
 
 #include <epan/prefs.h>
+#include <epan/proto.h>
 
 #include "wireshark_application.h"
 
@@ -45,6 +46,9 @@ EnabledProtocolsDialog::EnabledProtocolsDialog(QWidget *parent) :
     ui->cmbProtocolType->addItem(tr("non-heuristic protocols"), QVariant::fromValue(EnabledProtocolItem::Standard));
     ui->cmbProtocolType->addItem(tr("heuristic protocols"), QVariant::fromValue(EnabledProtocolItem::Heuristic));
 
+    // List the protocols of the plugins that haven't been needed yet too.
+    proto_initialize_all_prefixes();
+
     fillTree();
 }
 
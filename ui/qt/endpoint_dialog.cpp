@@ -16,6 +16,8 @@
 #include "ui/recent.h"
 #include "ui/traffic_table_ui.h"
 
+#include "frame_traffic_tables.h"
+
 #include "wsutil/file_util.h"
 #include "wsutil/pint.h"
 #include "wsutil/str_util.h"
@@ -86,7 +88,9 @@ EndpointDialog::EndpointDialog(QWidget &parent, CaptureFile &cf, int cli_proto_i
     updateWidgets();
 //    currentTabChanged();
 
-    cap_file_.delayedRetapPackets();
+    if (!fillTablesFromFile()) {
+        cap_file_.delayedRetapPackets();
+    }
 }
 
 EndpointDialog::~EndpointDialog()
@@ -594,6 +598,16 @@ void EndpointTreeWidget::tapReset(void *conv_hash_ptr)
     reset_hostlist_table_data(&endp_tree->hash_);
 }
 
+bool EndpointTreeWidget::fillFromFileTables(const struct frame_traffic_tables *traffic_tables)
+{
+    tapReset(&hash_);
+    if (!frame_traffic_tables_copy(traffic_tables, table_, TRUE, &hash_)) {
+        return false;
+    }
+    tapDraw(&hash_);
+    return true;
+}
+
 void EndpointTreeWidget::tapDraw(void *conv_hash_ptr)
 {
     conv_hash_t *hash = (conv_hash_t*)conv_hash_ptr;
@@ -19,6 +19,8 @@ public:
     explicit EndpointTreeWidget(QWidget *parent, register_ct_t* table);
     ~EndpointTreeWidget();
 
+    bool fillFromFileTables(const struct frame_traffic_tables *traffic_tables);
+
 #ifdef HAVE_MAXMINDDB
     bool hasGeoIPData() const { return has_geoip_data_; }
 #endif
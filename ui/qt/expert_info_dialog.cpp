@@ -139,6 +139,12 @@ void ExpertInfoDialog::retapPackets()
     clearAllData();
     removeTapListeners();
 
+    // The items of all the packets may have been kept as they were read.
+    if (!ui->limitCheckBox->isChecked() && expert_info_model_->loadFileExpertInfo()) {
+        updateWidgets();
+        return;
+    }
+
     if (!registerTapListener("expert",
                              expert_info_model_,
                              ui->limitCheckBox->isChecked() ? display_filter_.toUtf8().constData(): NULL,
@@ -13,6 +13,7 @@
 #include "main_window.h"
 #include "wireshark_application.h"
 
+#include "file.h"
 #include "frame_tvbuff.h"
 #include "epan/follow.h"
 #include "epan/dissectors/packet-tcp.h"
@@ -1034,6 +1035,15 @@ bool FollowStreamDialog::follow(QString previous_filter, bool use_stream_index,
     beginRetapPackets();
     updateWidgets(true);
 
+    /* If the follower knows which frames the stream is in, only they
+       need to be dissected. */
+    follow_stream_frames_func stream_frames = get_follow_stream_frames_func(follower_);
+    wmem_array_t *frames = stream_frames ? stream_frames(stream_num, sub_stream_num) : NULL;
+    if (frames) {
+        cf_set_filter_frames(cap_file_.capFile(), follow_filter.toUtf8().constData(),
+                             (const guint32 *)wmem_array_get_raw(frames), wmem_array_get_count(frames));
+    }
+
     /* Run the display filter so it goes in effect - even if it's the
        same as the previous display filter. */
     emit updateFilter(follow_filter, TRUE);
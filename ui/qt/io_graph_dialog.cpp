@@ -72,6 +72,9 @@ const int min_zoom_pixels_ = 20;
 
 const int stat_update_interval_ = 200; // ms
 
+// How many fields, or filters, each graph keeps the values of.
+const int max_field_values_ = 4;
+
 // Saved graph settings
 typedef struct _io_graph_settings_t {
     gboolean enabled;
@@ -1143,6 +1146,10 @@ void IOGraphDialog::updateStatistics()
 
     if (need_retap_ && !file_closed_) {
         need_retap_ = false;
+        // Leave the other dialogs' statistics alone.
+        foreach (IOGraph *iog, ioGraphs_) {
+            mark_tap_listener_for_retap(iog);
+        }
         cap_file_.retapPackets();
         // The user might have closed the window while tapping, which means
         // we might no longer exist.
@@ -1229,8 +1236,7 @@ void IOGraphDialog::on_intervalComboBox_currentIndexChanged(int)
         for (int row = 0; row < uat_model_->rowCount(); row++) {
             IOGraph *iog = ioGraphs_.value(row, NULL);
             if (iog) {
-                iog->setInterval(interval);
-                if (iog->visible()) {
+                if (iog->setInterval(interval) && iog->visible()) {
                     need_retap = true;
                 }
             }
@@ -1239,6 +1245,8 @@ void IOGraphDialog::on_intervalComboBox_currentIndexChanged(int)
 
     if (need_retap) {
         scheduleRetap(true);
+    } else {
+        scheduleRecalc(true);
     }
 
     updateLegend();
@@ -1588,7 +1596,13 @@ IOGraph::IOGraph(QCustomPlot *parent) :
     bars_(NULL),
     val_units_(IOG_ITEM_UNIT_FIRST),
     hf_index_(-1),
-    cur_idx_(-1)
+    interval_(0),
+    cur_idx_(-1),
+    tap_idx_(-1),
+    tap_interval_(0),
+    tap_field_values_(NULL),
+    retapping_(false),
+    reset_in_retap_(false)
 {
     Q_ASSERT(parent_ != NULL);
     graph_ = parent_->addGraph(parent_->xAxis, parent_->yAxis);
@@ -1613,6 +1627,7 @@ IOGraph::IOGraph(QCustomPlot *parent) :
 
 IOGraph::~IOGraph() {
     remove_tap_listener(this);
+    clearFieldValues();
     if (graph_) {
         parent_->removeGraph(graph_);
     }
@@ -1627,8 +1642,11 @@ void IOGraph::setFilter(const QString &filter)
 {
     GString *error_string;
     QString full_filter(filter.trimmed());
+    // What we record from now on has to be what we graph.
+    FieldValues *recording = tap_field_values_;
 
     config_err_.clear();
+    tap_field_values_ = NULL;
 
     // Make sure we have a good display filter
     if (!full_filter.isEmpty()) {
@@ -1669,10 +1687,18 @@ void IOGraph::setFilter(const QString &filter)
         g_string_free(error_string, TRUE);
         return;
     } else {
-        if (filter_.compare(filter) && visible_) {
-            emit requestRetap();
-        }
+        bool filter_changed = filter_.compare(filter) != 0;
         filter_ = filter;
+        if (recording && recording == field_values_.value(fieldValuesKey(), NULL)) {
+            tap_field_values_ = recording;
+        }
+        if (filter_changed && visible_) {
+            if (replayFieldValues()) {
+                emit requestRecalc();
+            } else {
+                emit requestRetap();
+            }
+        }
     }
 }
 
@@ -1815,7 +1841,8 @@ void IOGraph::setValueUnits(int val_units)
 
         if (old_val_units != val_units) {
             setFilter(filter_); // Check config & prime vu field
-            if (val_units < IOG_ITEM_UNIT_CALC_SUM) {
+            if (val_units < IOG_ITEM_UNIT_CALC_SUM ||
+                    (config_err_.isEmpty() && replayFieldValues())) {
                 emit requestRecalc();
             }
         }
@@ -1836,6 +1863,13 @@ void IOGraph::setValueUnitField(const QString &vu_field)
 
     if (old_hf_index != hf_index_) {
         setFilter(filter_); // Check config & prime vu field
+        if (config_err_.isEmpty() && val_units_ >= IOG_ITEM_UNIT_CALC_SUM) {
+            if (replayFieldValues()) {
+                emit requestRecalc();
+            } else if (visible_) {
+                emit requestRetap();
+            }
+        }
     }
 }
 
@@ -1890,7 +1924,9 @@ int IOGraph::packetFromTime(double ts)
 void IOGraph::clearAllData()
 {
     cur_idx_ = -1;
-    reset_io_graph_items(items_, max_io_items_);
+    items_.clear();
+    tap_idx_ = -1;
+    tap_items_.clear();
     if (graph_) {
         graph_->data()->clear();
     }
@@ -2083,11 +2119,32 @@ void IOGraph::captureEvent(CaptureEvent e)
             (e.eventType() == CaptureEvent::Closing))
     {
          remove_tap_listener(this);
+         clearFieldValues();
+    }
+
+    if (e.captureContext() == CaptureEvent::Retap) {
+        switch (e.eventType()) {
+        case CaptureEvent::Started:
+            retapping_ = true;
+            break;
+        case CaptureEvent::Finished:
+            // We have every packet unless the retap was stopped.
+            if (reset_in_retap_ && tap_field_values_ && !CaptureFile::globalCapFile()->stop_flag) {
+                tap_field_values_->complete = true;
+            }
+            retapping_ = false;
+            reset_in_retap_ = false;
+            break;
+        default:
+            break;
+        }
     }
 }
 
 void IOGraph::reloadValueUnitField()
 {
+    // The fields might have been registered again, with other types.
+    clearFieldValues();
     if (vu_field_.length() > 0) {
         setValueUnitField(vu_field_);
     }
@@ -2096,7 +2153,7 @@ void IOGraph::reloadValueUnitField()
 // Check if a packet is available at the given interval (idx).
 bool IOGraph::hasItemToShow(int idx, double value) const
 {
-    g_assert(idx < max_io_items_);
+    g_assert(idx < items_.size());
 
     bool result = false;
 
@@ -2134,17 +2191,65 @@ bool IOGraph::hasItemToShow(int idx, double value) const
     return result;
 }
 
-void IOGraph::setInterval(int interval)
+// Returns true if we need to be retapped for the new interval, false if our
+// items could be computed from those we have.
+bool IOGraph::setInterval(int interval)
 {
+    if (interval == interval_) {
+        return false;
+    }
+
+    if (!tap_items_.isEmpty() && interval == tap_interval_) {
+        items_.swap(tap_items_);
+        cur_idx_ = tap_idx_;
+        tap_items_.clear();
+        tap_idx_ = -1;
+        interval_ = interval;
+        return false;
+    }
+
+    if (tap_items_.isEmpty() && cur_idx_ >= 0 && cur_idx_ < max_io_items_ - 1) {
+        // What we have is complete; keep it to compute the others from.
+        tap_items_ = items_;
+        tap_idx_ = cur_idx_;
+        tap_interval_ = interval_;
+    }
+
+    if (!tap_items_.isEmpty() && interval > tap_interval_ && interval % tap_interval_ == 0) {
+        items_ = tap_items_.mid(0, tap_idx_ + 1);
+        cur_idx_ = (int) coarsen_io_graph_items(items_.data(), items_.size(), interval / tap_interval_, val_units_) - 1;
+        items_.resize(cur_idx_ + 1);
+        interval_ = interval;
+        return false;
+    }
+
+    tap_items_.clear();
+    tap_idx_ = -1;
     interval_ = interval;
+    return !replayFieldValues();
 }
 
 // Get the value at the given interval (idx) for the current value unit.
 double IOGraph::getItemValue(int idx, const capture_file *cap_file) const
 {
-    g_assert(idx < max_io_items_);
+    g_assert(idx < items_.size());
+
+    return get_io_graph_item(items_.constData(), val_units_, idx, hf_index_, cap_file, interval_, cur_idx_);
+}
+
+// Make room for items through idx. We start small and grow as the tap goes,
+// rather than allocating max_io_items_ for each graph up front.
+void IOGraph::reserveItems(QVector<io_graph_item_t> &items, int idx)
+{
+    int old_size = items.size();
+
+    if (idx < old_size) {
+        return;
+    }
 
-    return get_io_graph_item(items_, val_units_, idx, hf_index_, cap_file, interval_, cur_idx_);
+    int new_size = qMin(qMax(idx + 1, qMax(old_size * 2, 1024)), max_io_items_);
+    items.resize(new_size);
+    reset_io_graph_items(items.data() + old_size, new_size - old_size);
 }
 
 // "tap_reset" callback for register_tap_listener
@@ -2155,6 +2260,14 @@ void IOGraph::tapReset(void *iog_ptr)
 
 //    qDebug() << "=tapReset" << iog->name_;
     iog->clearAllData();
+
+    // Outside of a retap the packets are being read or dissected again, and
+    // might not hold the values we kept any more.
+    if (!iog->retapping_) {
+        iog->clearFieldValues();
+    }
+    iog->reset_in_retap_ = iog->retapping_;
+    iog->startFieldValues();
 }
 
 // "tap_packet" callback for register_tap_listener
@@ -2168,11 +2281,26 @@ tap_packet_status IOGraph::tapPacket(void *iog_ptr, packet_info *pinfo, epan_dis
     int idx = get_io_graph_index(pinfo, iog->interval_);
     bool recalc = false;
 
+    /* Keep the values of our field, to graph them again without retapping. */
+    const io_graph_field_frame_t *frame = NULL;
+    if (iog->tap_field_values_) {
+        frame = iog->recordFieldValues(pinfo, edt);
+        if (!frame) {
+            return TAP_PACKET_DONT_REDRAW;
+        }
+    }
+    if (!iog->retapping_ && iog->field_values_.size() > (iog->tap_field_values_ ? 1 : 0)) {
+        /* A packet of a live capture; only the values we record have it. */
+        iog->clearFieldValues(iog->tap_field_values_);
+    }
+
     /* some sanity checks */
     if ((idx < 0) || (idx >= max_io_items_)) {
         iog->cur_idx_ = max_io_items_ - 1;
+        reserveItems(iog->items_, iog->cur_idx_);
         return TAP_PACKET_DONT_REDRAW;
     }
+    reserveItems(iog->items_, idx);
 
     /* update num_items */
     if (idx > iog->cur_idx_) {
@@ -2194,7 +2322,24 @@ tap_packet_status IOGraph::tapPacket(void *iog_ptr, packet_info *pinfo, epan_dis
         adv_edt = edt;
     }
 
-    if (!update_io_graph_item(iog->items_, idx, pinfo, adv_edt, iog->hf_index_, iog->val_units_, iog->interval_)) {
+    /* Keep the items we computed the current ones from up to date, too. */
+    if (!iog->tap_items_.isEmpty()) {
+        int tap_idx = get_io_graph_index(pinfo, iog->tap_interval_);
+
+        if (tap_idx >= max_io_items_) {
+            /* They no longer cover the capture. */
+            iog->tap_items_.clear();
+            iog->tap_idx_ = -1;
+        } else {
+            reserveItems(iog->tap_items_, tap_idx);
+            if (tap_idx > iog->tap_idx_) {
+                iog->tap_idx_ = tap_idx;
+            }
+            iog->updateItem(iog->tap_items_, tap_idx, iog->tap_interval_, pinfo, adv_edt, frame);
+        }
+    }
+
+    if (!iog->updateItem(iog->items_, idx, iog->interval_, pinfo, adv_edt, frame)) {
         return TAP_PACKET_DONT_REDRAW;
     }
 
@@ -2206,6 +2351,140 @@ tap_packet_status IOGraph::tapPacket(void *iog_ptr, packet_info *pinfo, epan_dis
     return TAP_PACKET_REDRAW;
 }
 
+// The field values we keep are those of a field in the packets that passed a
+// filter; an empty key if we don't graph a field.
+const QString IOGraph::fieldValuesKey() const
+{
+    if (val_units_ < IOG_ITEM_UNIT_CALC_SUM || hf_index_ < 0 || vu_field_.isEmpty()) {
+        return QString();
+    }
+    return QString("%1\n%2").arg(vu_field_, filter_);
+}
+
+// Start recording the values of our field, replacing those we have for it.
+void IOGraph::startFieldValues()
+{
+    const QString key = fieldValuesKey();
+
+    tap_field_values_ = NULL;
+    if (key.isEmpty()) {
+        return;
+    }
+
+    FieldValues *fv = field_values_.value(key, NULL);
+    if (fv) {
+        field_values_order_.removeOne(key);
+    } else {
+        if (field_values_order_.size() >= max_field_values_) {
+            delete field_values_.take(field_values_order_.takeFirst());
+        }
+        fv = new FieldValues;
+        field_values_.insert(key, fv);
+    }
+    field_values_order_.append(key);
+
+    fv->frames.clear();
+    fv->values.clear();
+    fv->ftype = proto_registrar_get_ftype(hf_index_);
+    fv->start_time = 0.0;
+    fv->complete = false;
+    tap_field_values_ = fv;
+}
+
+// Record the values of our field in a packet. Returns NULL if it has none.
+const io_graph_field_frame_t *IOGraph::recordFieldValues(packet_info *pinfo, epan_dissect_t *edt)
+{
+    FieldValues *fv = tap_field_values_;
+    GPtrArray *gp = edt ? proto_get_finfo_ptr_array(edt->tree, hf_index_) : NULL;
+
+    if (!gp) {
+        return NULL;
+    }
+
+    if (fv->frames.isEmpty()) {
+        nstime_t start_nstime;
+        nstime_set_zero(&start_nstime);
+        nstime_delta(&start_nstime, &pinfo->abs_ts, &pinfo->rel_ts);
+        fv->start_time = nstime_to_sec(&start_nstime);
+    }
+
+    io_graph_field_frame_t frame;
+    frame.num = pinfo->num;
+    frame.pkt_len = pinfo->fd->pkt_len;
+    frame.rel_ts = pinfo->rel_ts;
+    frame.first_value = fv->values.size();
+    frame.num_values = gp->len;
+    for (guint i = 0; i < gp->len; i++) {
+        io_graph_field_value_t value;
+        get_io_graph_field_value(&value, fv->ftype, &((field_info *)gp->pdata[i])->value);
+        fv->values.append(value);
+    }
+    fv->frames.append(frame);
+    return &fv->frames.last();
+}
+
+// Compute our items from the field values we have for our field, filter,
+// value unit and interval. Returns false if we have to be retapped instead.
+bool IOGraph::replayFieldValues()
+{
+    const QString key = fieldValuesKey();
+    FieldValues *fv = key.isEmpty() ? NULL : field_values_.value(key, NULL);
+
+    if (!fv || !fv->complete || interval_ <= 0) {
+        return false;
+    }
+    field_values_order_.removeOne(key);
+    field_values_order_.append(key);
+
+    // The packets of a live capture are added to them.
+    tap_field_values_ = fv;
+    clearAllData();
+    start_time_ = fv->start_time;
+    foreach (const io_graph_field_frame_t &frame, fv->frames) {
+        int idx = get_io_graph_index_from_ts(&frame.rel_ts, interval_);
+
+        /* The same sanity checks as tapPacket's */
+        if ((idx < 0) || (idx >= max_io_items_)) {
+            cur_idx_ = max_io_items_ - 1;
+            reserveItems(items_, cur_idx_);
+            continue;
+        }
+        reserveItems(items_, idx);
+        if (idx > cur_idx_) {
+            cur_idx_ = idx;
+        }
+        update_io_graph_item_from_values(items_.data(), idx, &frame, fv->values.constData() + frame.first_value, fv->ftype, val_units_, interval_);
+    }
+    return true;
+}
+
+// Drop the field values we keep, except those at keep.
+void IOGraph::clearFieldValues(const FieldValues *keep)
+{
+    foreach (const QString &key, field_values_order_) {
+        FieldValues *fv = field_values_.value(key);
+        if (fv != keep) {
+            field_values_.remove(key);
+            field_values_order_.removeOne(key);
+            delete fv;
+        }
+    }
+    if (tap_field_values_ != keep) {
+        tap_field_values_ = NULL;
+    }
+}
+
+// Update the item at idx from a packet, or from the values of our field we
+// recorded from it.
+bool IOGraph::updateItem(QVector<io_graph_item_t> &items, int idx, int interval, packet_info *pinfo, epan_dissect_t *edt, const io_graph_field_frame_t *frame)
+{
+    if (frame) {
+        update_io_graph_item_from_values(items.data(), idx, frame, tap_field_values_->values.constData() + frame->first_value, tap_field_values_->ftype, val_units_, interval);
+        return true;
+    }
+    return update_io_graph_item(items.data(), idx, pinfo, edt, hf_index_, val_units_, interval);
+}
+
 // "tap_draw" callback for register_tap_listener
 void IOGraph::tapDraw(void *iog_ptr)
 {
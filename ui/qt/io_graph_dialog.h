@@ -23,9 +23,12 @@
 #include <ui/qt/models/uat_model.h>
 #include <ui/qt/models/uat_delegate.h>
 
+#include <QHash>
 #include <QIcon>
 #include <QMenu>
+#include <QStringList>
 #include <QTextStream>
+#include <QVector>
 
 class QRubberBand;
 class QTimer;
@@ -65,7 +68,7 @@ public:
     const QString valueUnitField() { return vu_field_; }
     void setValueUnitField(const QString &vu_field);
     unsigned int movingAveragePeriod() { return moving_avg_period_; }
-    void setInterval(int interval);
+    bool setInterval(int interval);
     bool addToLegend();
     bool removeFromLegend();
     QCPGraph *graph() { return graph_; }
@@ -97,6 +100,24 @@ private:
     static void tapReset(void *iog_ptr);
     static tap_packet_status tapPacket(void *iog_ptr, packet_info *pinfo, epan_dissect_t *edt, const void *data);
     static void tapDraw(void *iog_ptr);
+    static void reserveItems(QVector<io_graph_item_t> &items, int idx);
+
+    // The values of our field in the packets that passed our filter, as
+    // tapped, so that we can graph them again for another value unit or
+    // interval, or if we go back to the field, without retapping.
+    struct FieldValues {
+        QVector<io_graph_field_frame_t> frames;
+        QVector<io_graph_field_value_t> values;
+        enum ftenum ftype;
+        double start_time;
+        bool complete;
+    };
+    const QString fieldValuesKey() const;
+    void startFieldValues();
+    const io_graph_field_frame_t *recordFieldValues(packet_info *pinfo, epan_dissect_t *edt);
+    bool replayFieldValues();
+    void clearFieldValues(const FieldValues *keep = NULL);
+    bool updateItem(QVector<io_graph_item_t> &items, int idx, int interval, packet_info *pinfo, epan_dissect_t *edt, const io_graph_field_frame_t *frame);
 
     void calculateScaledValueUnit();
     template<class DataMap> double maxValueFromGraphData(const DataMap &map);
@@ -119,8 +140,21 @@ private:
 
     // Cached data. We should be able to change the Y axis without retapping as
     // much as is feasible.
-    io_graph_item_t items_[max_io_items_];
+    QVector<io_graph_item_t> items_;
     int cur_idx_;
+    // The items we tapped, if interval_ is a multiple of the interval they
+    // were tapped at and items_ were computed from them. They let us go to
+    // any other multiple of that interval, or back to it, without retapping.
+    QVector<io_graph_item_t> tap_items_;
+    int tap_idx_;
+    int tap_interval_;
+    // The values of the fields we graphed recently, by field and filter, and
+    // the ones we are recording.
+    QHash<QString, FieldValues *> field_values_;
+    QStringList field_values_order_; // Least recently used first
+    FieldValues *tap_field_values_;
+    bool retapping_;
+    bool reset_in_retap_;
 };
 
 namespace Ui {
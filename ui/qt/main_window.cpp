@@ -563,6 +563,8 @@ MainWindow::MainWindow(QWidget *parent) :
             this, SLOT(updateRecentActions()));
     connect(wsApp, SIGNAL(packetDissectionChanged()),
             this, SLOT(redissectPackets()), Qt::QueuedConnection);
+    connect(wsApp, SIGNAL(packetDisplayChanged()),
+            this, SLOT(redrawPackets()), Qt::QueuedConnection);
 
     connect(wsApp, SIGNAL(checkDisplayFilter()),
             this, SLOT(checkDisplayFilter()));
@@ -1032,25 +1034,9 @@ void MainWindow::dropEvent(QDropEvent *event)
         return;
     }
 
-    const char **in_filenames = g_new(const char *, local_files.size());
-    char *tmpname = NULL;
-
-    for (int i = 0; i < local_files.size(); i++) {
-        in_filenames[i] = local_files.at(i).constData();
-    }
-
-    /* merge the files in chronological order */
-    if (cf_merge_files_to_tempfile(this, &tmpname, local_files.size(),
-                                   in_filenames,
-                                   wtap_pcapng_file_type_subtype(),
-                                   FALSE) == CF_OK) {
-        /* Merge succeeded; close the currently-open file and try
-           to open the merged capture file. */
-        openCaptureFile(tmpname, QString(), WTAP_TYPE_AUTO, TRUE);
-    }
-
-    g_free(tmpname);
-    g_free(in_filenames);
+    /* Read the files in chronological order, as if they'd been merged,
+       without copying them into a temporary file. */
+    openCaptureFiles(local_files);
 }
 
 // Apply recent settings to the main window geometry.
@@ -331,6 +331,13 @@ public slots:
     // XXX We might want to return a cf_read_status_t or a CaptureFile.
     bool openCaptureFile(QString cf_path, QString display_filter, unsigned int type, gboolean is_tempfile = FALSE);
     bool openCaptureFile(QString cf_path = QString(), QString display_filter = QString()) { return openCaptureFile(cf_path, display_filter, WTAP_TYPE_AUTO); }
+    /**
+     * Open several capture files as one, reading their packets in
+     * chronological order from the files themselves.
+     * @param cf_paths Paths to the files.
+     * @return True on success, false on failure.
+     */
+    bool openCaptureFiles(const QList<QByteArray> &cf_paths);
     void filterPackets(QString new_filter = QString(), bool force = false);
     void setDisplayFilter(QString filter, FilterAction::Action action, FilterAction::ActionType filterType);
     void updateForUnsavedChanges();
@@ -403,6 +410,7 @@ private slots:
     void interfaceSelectionChanged();
     void captureFilterSyntaxChanged(bool valid);
     void redissectPackets();
+    void redrawPackets();
     void checkDisplayFilter();
     void fieldsChanged();
     void reloadLuaPlugins();
@@ -53,6 +53,7 @@ DIAG_ON(frame-larger-than=)
 #include "epan/filter_expressions.h"
 #include "epan/prefs.h"
 #include "epan/plugin_if.h"
+#include "epan/tap.h"
 #include "epan/uat.h"
 #include "epan/uat-int.h"
 #include "epan/value_string.h"
@@ -287,6 +288,57 @@ finish:
     return ret;
 }
 
+bool MainWindow::openCaptureFiles(const QList<QByteArray> &cf_paths)
+{
+    int err;
+    bool ret = true;
+
+    QString before_what(tr(" before opening another file"));
+    if (!testCaptureFileClose(before_what)) {
+        return false;
+    }
+
+    const char **in_filenames = g_new(const char *, cf_paths.size());
+    for (int i = 0; i < cf_paths.size(); i++) {
+        in_filenames[i] = cf_paths.at(i).constData();
+    }
+
+    /* Make the file name available via MainWindow */
+    setMwFileName(QString::fromUtf8(cf_paths.at(0)));
+
+    /* This closes the current file if it succeeds. */
+    CaptureFile::globalCapFile()->window = this;
+    if (cf_open_virtual(CaptureFile::globalCapFile(), cf_paths.size(),
+                        in_filenames, FALSE, &err) != CF_OK) {
+        CaptureFile::globalCapFile()->window = NULL;
+        ret = false;
+        goto finish;
+    }
+
+    switch (cf_read(CaptureFile::globalCapFile(), FALSE)) {
+    case CF_READ_OK:
+    case CF_READ_ERROR:
+        /* Just because we got an error, that doesn't mean we were unable
+           to read any of the files; we handle what we could get from them. */
+        break;
+
+    case CF_READ_ABORTED:
+        /* The user bailed out of reading the files; they've been closed. */
+        capture_file_.setCapFile(NULL);
+        ret = false;
+        goto finish;
+    }
+
+    // get_dirname overwrites its path.
+    wsApp->setLastOpenDir(get_dirname(QByteArray(cf_paths.at(0)).data()));
+
+    main_ui_->statusBar->showExpert();
+
+finish:
+    g_free(in_filenames);
+    return ret;
+}
+
 void MainWindow::filterPackets(QString new_filter, bool force)
 {
     cf_status_t cf_status;
@@ -1438,6 +1490,29 @@ void MainWindow::redissectPackets()
     proto_free_deregistered_fields();
 }
 
+// Only what the packets show has changed, not what the dissectors have
+// learned about them, so there's no need to start again from the first
+// frame with the state thrown away.
+void MainWindow::redrawPackets()
+{
+    capture_file *cf = capture_file_.capFile();
+
+    if (!cf) {
+        return;
+    }
+
+    if (cf->dfilter) {
+        // The filter might match differently now. Filtering again also
+        // gives the packets to the taps.
+        cf_filter_packets(cf, cf->dfilter, TRUE);
+    } else {
+        packet_list_->redrawVisiblePackets();
+        if (tap_listeners_require_dissection()) {
+            cf_retap_packets(cf);
+        }
+    }
+}
+
 void MainWindow::checkDisplayFilter()
 {
     if (!df_combo_box_->checkDisplayFilter()) {
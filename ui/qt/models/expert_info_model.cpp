@@ -11,6 +11,10 @@
 #include "expert_info_model.h"
 
 #include "file.h"
+#include "frame_expert_info.h"
+#include "frame_tvbuff.h"
+
+#include <epan/epan_dissect.h>
 
 ExpertPacketItem::ExpertPacketItem(const expert_info_t& expert_info, column_info *cinfo, ExpertPacketItem* parent) :
     packet_num_(expert_info.packet_num),
@@ -19,10 +23,12 @@ ExpertPacketItem::ExpertPacketItem(const expert_info_t& expert_info, column_info
     hf_id_(expert_info.hf_index),
     protocol_(expert_info.protocol),
     summary_(expert_info.summary),
+    has_info_(false),
     parentItem_(parent)
 {
     if (cinfo) {
         info_ = col_get_text(cinfo, COL_INFO);
+        has_info_ = true;
     }
 }
 
@@ -252,7 +258,7 @@ QVariant ExpertInfoModel::data(const QModelIndex &index, int role) const
             if (item->severity() == PI_COMMENT)
                 return item->summary().simplified();
             if (group_by_summary_)
-                return item->colInfo().simplified();
+                return colInfo(item).simplified();
 
             return item->summary().simplified();
         }
@@ -339,20 +345,94 @@ int ExpertInfoModel::columnCount(const QModelIndex&) const
 }
 
 void ExpertInfoModel::addExpertInfo(const struct expert_info_s& expert_info)
+{
+    addExpertInfo(expert_info, &(capture_file_.capFile()->cinfo));
+}
+
+bool ExpertInfoModel::loadFileExpertInfo()
+{
+    capture_file *cf = capture_file_.capFile();
+
+    // Comments may have been changed since.
+    if (!cf || !cf->expert_info || cf->unsaved_changes ||
+            frame_expert_info_frame_count(cf->expert_info) != cf->count) {
+        return false;
+    }
+
+    emit beginResetModel();
+
+    eventCounts_.clear();
+    delete root_;
+    root_ = createRootItem();
+
+    guint item_count = frame_expert_info_item_count(cf->expert_info);
+    for (guint i = 0; i < item_count; i++) {
+        expert_info_t expert_info;
+
+        frame_expert_info_get_item(cf->expert_info, i, &expert_info);
+        addExpertInfo(expert_info, NULL);
+        eventCounts_[(enum ExpertSeverity)expert_info.severity]++;
+    }
+
+    emit endResetModel();
+    return true;
+}
+
+QString ExpertInfoModel::colInfo(ExpertPacketItem *item) const
+{
+    if (!item->hasColInfo()) {
+        item->setColInfo(packetColInfo(item->packetNum()));
+    }
+    return item->colInfo();
+}
+
+QString ExpertInfoModel::packetColInfo(unsigned int packet_num) const
+{
+    capture_file *cf = capture_file_.capFile();
+    frame_data *fdata;
+    epan_dissect_t edt;
+    wtap_rec rec;
+    Buffer buf;
+    QString info;
+
+    if (!cf || !cf->provider.frames) {
+        return info;
+    }
+    fdata = frame_data_sequence_find(cf->provider.frames, packet_num);
+    if (!fdata) {
+        return info;
+    }
+
+    wtap_rec_init(&rec);
+    ws_buffer_init(&buf, 1514);
+    if (cf_read_record_no_alert(cf, fdata, &rec, &buf)) {
+        epan_dissect_init(&edt, cf->epan, FALSE, FALSE);
+        epan_dissect_run(&edt, cf->cd_t, &rec,
+                         frame_tvbuff_new_buffer(&cf->provider, fdata, &buf),
+                         fdata, &cf->cinfo);
+        info = col_get_text(&cf->cinfo, COL_INFO);
+        epan_dissect_cleanup(&edt);
+    }
+    ws_buffer_free(&buf);
+    wtap_rec_cleanup(&rec);
+    return info;
+}
+
+void ExpertInfoModel::addExpertInfo(const struct expert_info_s& expert_info, column_info *cinfo)
 {
     QString groupKey = ExpertPacketItem::groupKey(FALSE, expert_info.severity, expert_info.group, QString(expert_info.protocol), expert_info.hf_index);
     QString summaryKey = ExpertPacketItem::groupKey(TRUE, expert_info.severity, expert_info.group, QString(expert_info.protocol), expert_info.hf_index);
 
     ExpertPacketItem* expert_root = root_->child(groupKey);
     if (expert_root == NULL) {
-        ExpertPacketItem *new_item = new ExpertPacketItem(expert_info, &(capture_file_.capFile()->cinfo), root_);
+        ExpertPacketItem *new_item = new ExpertPacketItem(expert_info, cinfo, root_);
 
         root_->appendChild(new_item, groupKey);
 
         expert_root = new_item;
     }
 
-    ExpertPacketItem *expert = new ExpertPacketItem(expert_info, &(capture_file_.capFile()->cinfo), expert_root);
+    ExpertPacketItem *expert = new ExpertPacketItem(expert_info, cinfo, expert_root);
     expert_root->appendChild(expert, groupKey);
 
     //add the summary children off of the first child of the root children
@@ -361,13 +441,13 @@ void ExpertInfoModel::addExpertInfo(const struct expert_info_s& expert_info)
     //make a summary child
     ExpertPacketItem* expert_summary_root = summary_root->child(summaryKey);
     if (expert_summary_root == NULL) {
-        ExpertPacketItem *new_summary = new ExpertPacketItem(expert_info, &(capture_file_.capFile()->cinfo), summary_root);
+        ExpertPacketItem *new_summary = new ExpertPacketItem(expert_info, cinfo, summary_root);
 
         summary_root->appendChild(new_summary, summaryKey);
         expert_summary_root = new_summary;
     }
 
-    ExpertPacketItem *expert_summary = new ExpertPacketItem(expert_info, &(capture_file_.capFile()->cinfo), expert_summary_root);
+    ExpertPacketItem *expert_summary = new ExpertPacketItem(expert_info, cinfo, expert_summary_root);
     expert_summary_root->appendChild(expert_summary, summaryKey);
 }
 
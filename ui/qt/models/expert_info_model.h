@@ -36,6 +36,10 @@ public:
     QString protocol() const { return protocol_; }
     QString summary() const { return summary_; }
     QString colInfo() const { return info_; }
+    // Whether colInfo() has been set, which it is only for items made
+    // while their packet's columns were filled in.
+    bool hasColInfo() const { return has_info_; }
+    void setColInfo(const QString &info) { info_ = info.toUtf8(); has_info_ = true; }
 
     static QString groupKey(bool group_by_summary, int severity, int group, QString protocol, int expert_hf);
     QString groupKey(bool group_by_summary);
@@ -57,6 +61,7 @@ private:
     QByteArray protocol_;
     QByteArray summary_;
     QByteArray info_;
+    bool has_info_;
 
     QList<ExpertPacketItem*> childItems_;
     ExpertPacketItem* parentItem_;
@@ -111,6 +116,14 @@ public:
     // Called from tapPacket
     void addExpertInfo(const struct expert_info_s& expert_info);
 
+    // Fill the model with the expert info kept when the file was read, if
+    // it's all there. The Info column text of each packet is filled in by
+    // dissecting the packet when it's wanted.
+    bool loadFileExpertInfo();
+
+    // The Info column text of an item's packet.
+    QString colInfo(ExpertPacketItem *item) const;
+
     // Callbacks for register_tap_listener
     static void tapReset(void *eid_ptr);
     static tap_packet_status tapPacket(void *eid_ptr, struct _packet_info *pinfo, struct epan_dissect *, const void *data);
@@ -120,6 +133,8 @@ private:
     CaptureFile& capture_file_;
 
     ExpertPacketItem* createRootItem();
+    void addExpertInfo(const struct expert_info_s& expert_info, column_info *cinfo);
+    QString packetColInfo(unsigned int packet_num) const;
 
     bool group_by_summary_;
     ExpertPacketItem* root_;
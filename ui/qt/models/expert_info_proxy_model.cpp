@@ -238,7 +238,8 @@ bool ExpertInfoProxyModel::filterAcceptItem(ExpertPacketItem& item) const
         if (item.summary().contains(regex))
             return true;
 
-        if (item.colInfo().contains(regex))
+        ExpertInfoModel *model = qobject_cast<ExpertInfoModel *>(sourceModel());
+        if (model && model->colInfo(&item).contains(regex))
             return true;
 
         return false;
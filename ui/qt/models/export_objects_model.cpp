@@ -53,6 +53,11 @@ ExportObjectModel::ExportObjectModel(register_eo_t* eo, QObject *parent) :
     export_object_list_.gui_data = (void*)&eo_gui_data_;
 }
 
+ExportObjectModel::~ExportObjectModel()
+{
+    freeObjects();
+}
+
 QVariant ExportObjectModel::data(const QModelIndex &index, int role) const
 {
     if ((!index.isValid()) || ((role != Qt::DisplayRole) && (role != Qt::UserRole))) {
@@ -128,6 +133,11 @@ void ExportObjectModel::addObjectEntry(export_object_entry_t *entry)
     if (entry == NULL)
         return;
 
+    // Only the list is kept in memory; large payloads wait in a file
+    // until they're saved.
+    if (entry->payload_len >= EO_SPOOL_MIN_LEN && !get_eo_updates_entries(eo_))
+        eo_spool_entry(entry);
+
     int count = objects_.count();
     beginInsertRows(QModelIndex(), count, count);
     objects_.append(VariantPointer<export_object_entry_t>::asQVariant(entry));
@@ -200,13 +210,23 @@ void ExportObjectModel::resetObjects()
     export_object_gui_reset_cb reset_cb = get_eo_reset_func(eo_);
 
     emit beginResetModel();
-    objects_.clear();
+    freeObjects();
     emit endResetModel();
 
     if (reset_cb)
         reset_cb();
 }
 
+void ExportObjectModel::freeObjects()
+{
+    foreach (QVariant object, objects_) {
+        export_object_entry_t *entry = VariantPointer<export_object_entry_t>::asPtr(object);
+        if (entry)
+            eo_free_entry(entry);
+    }
+    objects_.clear();
+}
+
 // Called by taps
 /* Runs at the beginning of tapping only */
 void ExportObjectModel::resetTap(void *tapdata)
@@ -19,6 +19,7 @@
 #include <epan/prefs.h>
 
 #include "ui/packet_list_utils.h"
+#include "ui/progress_dlg.h"
 #include "ui/recent.h"
 
 #include <epan/color_filters.h>
@@ -36,6 +37,9 @@
 #include <QFontMetrics>
 #include <QModelIndex>
 #include <QElapsedTimer>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
 
 // Print timing information
 //#define DEBUG_PACKET_LIST_MODEL 1
@@ -71,7 +75,11 @@ PacketListModel::PacketListModel(QObject *parent, capture_file *cf) :
     number_to_row_(QVector<int>()),
     max_row_height_(0),
     max_line_count_(1),
-    idle_dissection_row_(0)
+    idle_dissection_row_(0),
+    prefetch_pos_(0),
+    row_color_levels_(1),
+    row_color_levels_stale_(false),
+    sort_stop_flag_(FALSE)
 {
     Q_ASSERT(glbl_plist_model == Q_NULLPTR);
     glbl_plist_model = this;
@@ -153,11 +161,14 @@ guint PacketListModel::recreateVisibleRows()
             number_to_row_[fdata->num] = visible_rows_.count();
         }
     }
+    resetRowColorLevels();
     if (!visible_rows_.isEmpty()) {
         beginInsertRows(QModelIndex(), 0, visible_rows_.count() - 1);
         endInsertRows();
     }
     idle_dissection_row_ = 0;
+    prefetch_rows_.clear();
+    prefetch_pos_ = 0;
     return visible_rows_.count();
 }
 
@@ -168,10 +179,16 @@ void PacketListModel::clear() {
     visible_rows_.resize(0);
     new_visible_rows_.resize(0);
     number_to_row_.resize(0);
+    frame_color_index_.resize(0);
+    resetColorIndex();
     emit endResetModel();
     max_row_height_ = 0;
     max_line_count_ = 1;
     idle_dissection_row_ = 0;
+    prefetch_rows_.clear();
+    prefetch_pos_ = 0;
+    // The records a sort in progress is using are gone.
+    sort_stop_flag_ = TRUE;
 }
 
 void PacketListModel::invalidateAllColumnStrings()
@@ -194,6 +211,11 @@ void PacketListModel::resetColumns()
 void PacketListModel::resetColorized()
 {
     PacketListRecord::resetColorization();
+    // The colors set on the frames' first pass are out of date, too.
+    if (cap_file_) {
+        cap_file_->colorized_through = 0;
+    }
+    resetColorIndex();
     dataChanged(index(0, 0), index(rowCount() - 1, columnCount() - 1),
             QVector<int>() << Qt::BackgroundRole << Qt::ForegroundRole);
 }
@@ -299,7 +321,7 @@ void PacketListModel::toggleFrameRefTime(const QModelIndex &rt_index)
         fdata->ref_time=1;
         cap_file_->ref_time_count++;
     }
-    cf_reftime_packets(cap_file_);
+    cf_reftime_packet(cap_file_, fdata);
     if (!fdata->ref_time && !fdata->passed_dfilter) {
         cap_file_->displayed_count--;
     }
@@ -354,8 +376,6 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
 
     QString col_title = get_column_title(column);
 
-    // XXX Use updateProgress instead. We'd have to switch from std::sort to
-    // something we can interrupt.
     if (!col_title.isEmpty()) {
         QString busy_msg = tr("Sorting \"%1\"…").arg(col_title);
         wsApp->pushStatus(WiresharkApplication::BusyStatus, busy_msg);
@@ -363,7 +383,15 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
 
     busy_timer_.start();
     sort_column_is_numeric_ = isNumericColumn(sort_column_);
-    std::sort(physical_rows_.begin(), physical_rows_.end(), recordLessThan);
+    if (text_sort_column_ < 0) {
+        // Comparing frame data is cheap; sort the records directly.
+        std::sort(physical_rows_.begin(), physical_rows_.end(), recordLessThan);
+    } else if (!sortByColumnStrings(col_title)) {
+        if (!col_title.isEmpty()) {
+            wsApp->popStatus(WiresharkApplication::BusyStatus);
+        }
+        return;
+    }
 
     emit beginResetModel();
     visible_rows_.resize(0);
@@ -379,6 +407,7 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
             number_to_row_[fdata->num] = visible_rows_.count();
         }
     }
+    resetRowColorLevels();
     emit endResetModel();
 
     if (!col_title.isEmpty()) {
@@ -390,6 +419,181 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
     }
 }
 
+// The sort key of a record, taken from its column string.
+struct PacketListSortKey {
+    PacketListRecord *record;
+    guint32 num;
+    bool num_valid;
+    double num_val;
+    QString text;
+};
+
+// The comparison of recordLessThan, on sort keys.
+class PacketListSortKeyLess
+{
+public:
+    PacketListSortKeyLess(bool numeric, Qt::SortOrder order) :
+        numeric_(numeric),
+        ascending_(order == Qt::AscendingOrder)
+    {}
+
+    bool operator()(const PacketListSortKey &k1, const PacketListSortKey &k2) const
+    {
+        int cmp_val = 0;
+
+        if (numeric_) {
+            if (!k1.num_valid && !k2.num_valid) {
+                cmp_val = 0;
+            } else if (!k1.num_valid || (k2.num_valid && k1.num_val < k2.num_val)) {
+                cmp_val = -1;
+            } else if (!k2.num_valid || (k1.num_val > k2.num_val)) {
+                cmp_val = 1;
+            }
+        } else {
+            cmp_val = k1.text.compare(k2.text);
+        }
+
+        if (cmp_val == 0) {
+            cmp_val = k1.num < k2.num ? -1 : (k1.num > k2.num ? 1 : 0);
+        }
+
+        return ascending_ ? cmp_val < 0 : cmp_val > 0;
+    }
+
+private:
+    bool numeric_;
+    bool ascending_;
+};
+
+// Sort a run of keys, or merge two sorted neighbouring runs.
+class PacketListSortTask : public QRunnable
+{
+public:
+    PacketListSortTask(PacketListSortKey *first, PacketListSortKey *middle, PacketListSortKey *last, const PacketListSortKeyLess &less) :
+        first_(first),
+        middle_(middle),
+        last_(last),
+        less_(less)
+    {}
+
+    void run()
+    {
+        if (middle_ == last_) {
+            std::sort(first_, last_, less_);
+        } else {
+            std::inplace_merge(first_, middle_, last_, less_);
+        }
+    }
+
+private:
+    PacketListSortKey *first_;
+    PacketListSortKey *middle_;
+    PacketListSortKey *last_;
+    PacketListSortKeyLess less_;
+};
+
+// Fewer keys than this per thread aren't worth sorting in parallel.
+static const int min_parallel_sort_keys_ = 50000;
+
+// Sort by the string of a column. Getting the strings means dissecting
+// every record, which is by far the slowest part of sorting and must be
+// done here, as dissection isn't thread-safe; do it once per record and
+// parse numeric strings once, rather than on every comparison, then sort
+// the keys on as many threads as are worthwhile. Returns false if the
+// user stopped the sort, or if the records went away.
+bool PacketListModel::sortByColumnStrings(const QString &col_title)
+{
+    int count = physical_rows_.count();
+    QVector<PacketListSortKey> keys(count);
+    PacketListSortKeyLess less(sort_column_is_numeric_, sort_order_);
+    QByteArray title_utf8 = col_title.toUtf8();
+    progdlg_t *progbar = NULL;
+    QElapsedTimer show_timer;
+
+    sort_cap_file_->stop_flag = FALSE;
+    sort_stop_flag_ = FALSE;
+    show_timer.start();
+    for (int i = 0; i < count; i++) {
+        PacketListRecord *record = physical_rows_[i];
+        PacketListSortKey &key = keys[i];
+        QString text = record->columnString(sort_cap_file_, sort_column_);
+
+        key.record = record;
+        key.num = record->frameData()->num;
+        if (sort_column_is_numeric_) {
+            key.num_val = parseNumericColumn(text, &key.num_valid);
+        } else {
+            key.num_valid = false;
+            key.num_val = 0;
+            key.text = text;
+        }
+
+        if (busy_timer_.elapsed() > busy_timeout_) {
+            if (!progbar && show_timer.elapsed() > 500) {
+                progbar = delayed_create_progress_dlg(sort_cap_file_->window, "Sorting", title_utf8.constData(),
+                                                      TRUE, &sort_cap_file_->stop_flag, (float) i / count);
+            }
+            if (progbar) {
+                // This processes user input, so that the sort can be stopped.
+                update_progress_dlg(progbar, (float) i / count, "");
+            } else {
+                wsApp->processEvents(QEventLoop::ExcludeUserInputEvents | QEventLoop::ExcludeSocketNotifiers, 1);
+            }
+            busy_timer_.restart();
+            if (sort_cap_file_->stop_flag || sort_stop_flag_) {
+                break;
+            }
+        }
+    }
+    if (progbar) {
+        destroy_progress_dlg(progbar);
+    }
+    if (sort_cap_file_->stop_flag || sort_stop_flag_) {
+        return false;
+    }
+
+    // Sort runs of keys in parallel, then merge neighbouring runs, also
+    // in parallel, until there's only one.
+    int runs = qBound(1, count / min_parallel_sort_keys_, QThread::idealThreadCount());
+    if (runs < 2) {
+        std::sort(keys.begin(), keys.end(), less);
+    } else {
+        PacketListSortKey *data = keys.data();
+        QVector<int> bounds;
+        QThreadPool pool;
+
+        pool.setMaxThreadCount(runs);
+        for (int i = 0; i <= runs; i++) {
+            bounds << (int) ((qint64) count * i / runs);
+        }
+        for (int i = 0; i < runs; i++) {
+            pool.start(new PacketListSortTask(data + bounds[i], data + bounds[i + 1], data + bounds[i + 1], less));
+        }
+        pool.waitForDone();
+
+        while (bounds.count() > 2) {
+            QVector<int> merged_bounds;
+
+            merged_bounds << bounds[0];
+            for (int i = 0; i + 2 < bounds.count(); i += 2) {
+                pool.start(new PacketListSortTask(data + bounds[i], data + bounds[i + 1], data + bounds[i + 2], less));
+                merged_bounds << bounds[i + 2];
+            }
+            if (merged_bounds.last() != bounds.last()) {
+                merged_bounds << bounds.last();
+            }
+            pool.waitForDone();
+            bounds = merged_bounds;
+        }
+    }
+
+    // Records appended while the strings were being dissected stay last.
+    for (int i = 0; i < count; i++) {
+        physical_rows_[i] = keys[i].record;
+    }
+    return true;
+}
+
 bool PacketListModel::isNumericColumn(int column)
 {
     if (column < 0) {
@@ -474,37 +678,10 @@ bool PacketListModel::recordLessThan(PacketListRecord *r1, PacketListRecord *r2)
     if (sort_column_ < 0) {
         // No column.
         cmp_val = frame_data_compare(sort_cap_file_->epan, r1->frameData(), r2->frameData(), COL_NUMBER);
-    } else if (text_sort_column_ < 0) {
-        // Column comes directly from frame data
+    } else {
+        // Column comes directly from frame data; columns with strings
+        // are sorted by sortByColumnStrings().
         cmp_val = frame_data_compare(sort_cap_file_->epan, r1->frameData(), r2->frameData(), sort_cap_file_->cinfo.columns[sort_column_].col_fmt);
-    } else  {
-        if (r1->columnString(sort_cap_file_, sort_column_).constData() == r2->columnString(sort_cap_file_, sort_column_).constData()) {
-            cmp_val = 0;
-        } else if (sort_column_is_numeric_) {
-            // Custom column with numeric data (or something like a port number).
-            // Attempt to convert to numbers.
-            // XXX This is slow. Can we avoid doing this?
-            bool ok_r1, ok_r2;
-            double num_r1 = parseNumericColumn(r1->columnString(sort_cap_file_, sort_column_), &ok_r1);
-            double num_r2 = parseNumericColumn(r2->columnString(sort_cap_file_, sort_column_), &ok_r2);
-
-            if (!ok_r1 && !ok_r2) {
-                cmp_val = 0;
-            } else if (!ok_r1 || (ok_r2 && num_r1 < num_r2)) {
-                // either r1 is invalid (and sort it before others) or both
-                // r1 and r2 are valid (sort normally)
-                cmp_val = -1;
-            } else if (!ok_r2 || (num_r1 > num_r2)) {
-                cmp_val = 1;
-            }
-        } else {
-            cmp_val = r1->columnString(sort_cap_file_, sort_column_).compare(r2->columnString(sort_cap_file_, sort_column_));
-        }
-
-        if (cmp_val == 0) {
-            // All else being equal, compare column numbers.
-            cmp_val = frame_data_compare(sort_cap_file_->epan, r1->frameData(), r2->frameData(), COL_NUMBER);
-        }
     }
 
     if (sort_order_ == Qt::AscendingOrder) {
@@ -613,6 +790,7 @@ QVariant PacketListModel::data(const QModelIndex &d_index, int role) const
     {
         int column = d_index.column();
         QString column_string = record->columnString(cap_file_, column, true);
+        noteRowColor(d_index.row(), fdata);
         // We don't know an item's sizeHint until we fetch its text here.
         // Assume each line count is 1. If the line count changes, emit
         // itemHeightChanged which triggers another redraw (including a
@@ -670,7 +848,9 @@ void PacketListModel::flushVisibleRows()
                 number_to_row_.resize(fdata->num + 10000);
             }
             number_to_row_[fdata->num] = visible_rows_.count();
+            row_color_levels_[0] << frame_color_index_.value((int)fdata->num);
         }
+        row_color_levels_stale_ = true;
         emit endInsertRows();
         new_visible_rows_.resize(0);
     }
@@ -706,6 +886,85 @@ void PacketListModel::dissectIdle(bool reset)
 
     // report colorization progress
     emit bgColorizationProgress(first+1, idle_dissection_row_+1);
+    if (idle_dissection_row_ >= physical_rows_.count()) {
+        emit bgColorizationFinished();
+    }
+}
+
+// Dissect this many pages of rows ahead of the visible ones in the direction
+// of scrolling, and one page back, or one page each way if we're not
+// scrolling. The records cache their column strings, so scrolling through
+// them later doesn't stall on dissection.
+static const int prefetch_pages_ahead_ = 3;
+void PacketListModel::prefetchRows(int first, int last, int direction)
+{
+    if (first < 0 || last < first) {
+        return;
+    }
+
+    int page = last - first + 1;
+    int ahead = direction != 0 ? prefetch_pages_ahead_ * page : page;
+    bool idle = prefetch_pos_ >= prefetch_rows_.count();
+
+    prefetch_rows_.clear();
+    prefetch_pos_ = 0;
+    if (direction < 0) {
+        for (int row = first - 1; row >= first - ahead && row >= 0; row--) {
+            prefetch_rows_ << row;
+        }
+        for (int row = last + 1; row <= last + page && row < visible_rows_.count(); row++) {
+            prefetch_rows_ << row;
+        }
+    } else {
+        for (int row = last + 1; row <= last + ahead && row < visible_rows_.count(); row++) {
+            prefetch_rows_ << row;
+        }
+        for (int row = first - 1; row >= first - page && row >= 0; row--) {
+            prefetch_rows_ << row;
+        }
+    }
+
+    // If a slice is already scheduled it will pick up the new rows.
+    if (idle && !prefetch_rows_.isEmpty()) {
+        QTimer::singleShot(0, this, SLOT(dissectPrefetchRows()));
+    }
+}
+
+// Dissect rows queued by prefetchRows for at most idle_dissection_interval_
+// ms at a time, letting the event loop handle input and painting between
+// slices. The dissection is done here, in the GUI thread, like any other;
+// epan can't dissect two packets at once.
+void PacketListModel::dissectPrefetchRows()
+{
+    if (!cap_file_ || cap_file_->read_lock) {
+        // Reading the file dissects its packets; try again later.
+        if (prefetch_pos_ < prefetch_rows_.count()) {
+            QTimer::singleShot(idle_dissection_interval_, this, SLOT(dissectPrefetchRows()));
+        }
+        return;
+    }
+
+    QElapsedTimer slice_timer;
+    slice_timer.start();
+
+    while (slice_timer.elapsed() < idle_dissection_interval_
+           && prefetch_pos_ < prefetch_rows_.count()) {
+        int row = prefetch_rows_[prefetch_pos_++];
+
+        if (row < 0 || row >= visible_rows_.count()) {
+            continue;
+        }
+        PacketListRecord *record = visible_rows_[row];
+        record->ensureCached(cap_file_);
+        noteRowColor(row, record->frameData());
+        if (record->lineCountChanged() && record->lineCount() > max_line_count_) {
+            emit maxLineCountChanged(index(row, 0));
+        }
+    }
+
+    if (prefetch_pos_ < prefetch_rows_.count()) {
+        QTimer::singleShot(0, this, SLOT(dissectPrefetchRows()));
+    }
 }
 
 // XXX Pass in cinfo from packet_list_append so that we can fill in
@@ -715,6 +974,11 @@ gint PacketListModel::appendPacket(frame_data *fdata)
     PacketListRecord *record = new PacketListRecord(fdata);
     gint pos = -1;
 
+    if (cap_file_ && fdata->num <= cap_file_->colorized_through) {
+        record->setColorized();
+        noteRowColor(-1, fdata);
+    }
+
 #ifdef DEBUG_PACKET_LIST_MODEL
     if (fdata->num % 10000 == 1) {
         log_resource_usage(fdata->num == 1, "%u packets", fdata->num);
@@ -759,9 +1023,170 @@ void PacketListModel::ensureRowColorized(int row)
     PacketListRecord *record = visible_rows_[row];
     if (!record)
         return;
-    if (!record->colorized()) {
-        record->ensureColorized(cap_file_);
+    // This checks whether the coloring rules have changed since.
+    record->ensureColorized(cap_file_);
+    noteRowColor(row, record->frameData());
+}
+
+bool PacketListModel::colorizeRows(int first, int last)
+{
+    QElapsedTimer slice_timer;
+    slice_timer.start();
+
+    for (int row = qMax(first, 0); row <= last && row < visible_rows_.count(); row++) {
+        if (row_color_levels_[0][row] != 0) {
+            continue;
+        }
+        if (slice_timer.elapsed() >= idle_dissection_interval_) {
+            return false;
+        }
+        ensureRowColorized(row);
+    }
+    return true;
+}
+
+// Combine the color indexes of two runs of rows into that of both: the
+// first color, if either has one.
+static inline quint8 combineColorIndex(quint8 left, quint8 right)
+{
+    if (left > 1) {
+        return left;
+    }
+    if (right > 1) {
+        return right;
+    }
+    return qMax(left, right);
+}
+
+QVector<QRgb> PacketListModel::rowColors(int first, int count, int lines) const
+{
+    QVector<QRgb> colors(qMax(lines, 0), qRgba(0, 0, 0, 0));
+
+    first = qMax(first, 0);
+    count = qMin(count, row_color_levels_[0].size() - first);
+    if (count < 1 || lines < 1) {
+        return colors;
+    }
+    if (row_color_levels_stale_) {
+        buildRowColorLevels();
+    }
+
+    for (int line = 0; line < lines; line++) {
+        // The rows drawn on this line, or the one it's a part of if there
+        // are more lines than rows.
+        int start = first + (qint64) line * count / lines;
+        int end = qMax(first + (int) ((qint64) (line + 1) * count / lines), start + 1);
+
+        // Combine the fewest entries of the pyramid that cover the rows,
+        // working up from the ends of the range.
+        quint8 left = 0, right = 0;
+        for (int level = 0; start < end; level++) {
+            const QVector<quint8> &entries = row_color_levels_[level];
+            if (start & 1) {
+                left = combineColorIndex(left, entries[start++]);
+            }
+            if (end & 1) {
+                right = combineColorIndex(entries[--end], right);
+            }
+            start >>= 1;
+            end >>= 1;
+        }
+
+        quint8 color_index = combineColorIndex(left, right);
+        if (color_index > 1) {
+            colors[line] = color_index_colors_[color_index - 2];
+        }
+    }
+    return colors;
+}
+
+// Record the color a frame was colorized with in the color index. row is
+// its visible row, or -1 if it isn't one yet.
+void PacketListModel::noteRowColor(int row, const frame_data *fdata) const
+{
+    quint8 color_index = 1;
+
+    if (fdata->color_filter) {
+        color_index = color_index_ids_.value(fdata->color_filter, 0);
+        if (color_index == 0) {
+            if (color_index_colors_.count() < 254) {
+                const color_filter_t *color_filter = (const color_filter_t *) fdata->color_filter;
+                color_index_colors_ << ColorUtils::fromColorT(&color_filter->bg_color).rgb();
+                color_index = color_index_colors_.count() + 1;
+            } else {
+                // The frames of any rules past this many aren't drawn.
+                color_index = 1;
+            }
+            color_index_ids_[fdata->color_filter] = color_index;
+        }
+    }
+
+    if (frame_color_index_.size() <= (int)fdata->num) {
+        frame_color_index_.resize(fdata->num + 10000);
+    }
+    frame_color_index_[fdata->num] = color_index;
+
+    QVector<quint8> &rows = row_color_levels_[0];
+    if (row < 0 || row >= rows.size() || rows[row] == color_index) {
+        return;
+    }
+    rows[row] = color_index;
+    if (row_color_levels_stale_) {
+        return;
+    }
+    for (int level = 1; level < row_color_levels_.size(); level++) {
+        const QVector<quint8> &below = row_color_levels_[level - 1];
+        int pos = row >> level;
+        quint8 combined = combineColorIndex(below[pos * 2],
+                pos * 2 + 1 < below.size() ? below[pos * 2 + 1] : 0);
+        if (row_color_levels_[level][pos] == combined) {
+            break;
+        }
+        row_color_levels_[level][pos] = combined;
+    }
+}
+
+// Forget the colors of all the frames, e.g. because the coloring rules
+// have changed.
+void PacketListModel::resetColorIndex()
+{
+    frame_color_index_.fill(0);
+    color_index_colors_.clear();
+    color_index_ids_.clear();
+    resetRowColorLevels();
+}
+
+// Take the colors of the visible rows from the color index after they've
+// been filtered or sorted.
+void PacketListModel::resetRowColorLevels()
+{
+    QVector<quint8> rows(visible_rows_.count());
+
+    for (int row = 0; row < visible_rows_.count(); row++) {
+        rows[row] = frame_color_index_.value((int)visible_rows_[row]->frameData()->num);
+    }
+    row_color_levels_.resize(1);
+    row_color_levels_[0] = rows;
+    row_color_levels_stale_ = true;
+}
+
+void PacketListModel::buildRowColorLevels() const
+{
+    row_color_levels_.resize(1);
+    for (int level = 1; row_color_levels_[level - 1].size() > 1; level++) {
+        const QVector<quint8> below = row_color_levels_[level - 1];
+        int count = below.size();
+        QVector<quint8> entries((count + 1) / 2);
+
+        for (int pos = 0; pos < count / 2; pos++) {
+            entries[pos] = combineColorIndex(below[pos * 2], below[pos * 2 + 1]);
+        }
+        if (count % 2) {
+            entries[count / 2] = below[count - 1];
+        }
+        row_color_levels_ << entries;
     }
+    row_color_levels_stale_ = false;
 }
 
 int PacketListModel::visibleIndexOf(frame_data *fdata) const
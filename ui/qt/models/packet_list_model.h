@@ -19,7 +19,9 @@
 #include <epan/packet.h>
 
 #include <QAbstractItemModel>
+#include <QColor>
 #include <QFont>
+#include <QHash>
 #include <QVector>
 
 #include "packet_list_record.h"
@@ -51,6 +53,24 @@ public:
     frame_data *getRowFdata(QModelIndex idx);
     frame_data *getRowFdata(int row);
     void ensureRowColorized(int row);
+    /**
+     * @brief Colorize the rows from first to last that aren't, for at most
+     * a few milliseconds.
+     * @return true if they're all colorized, false if time ran out.
+     */
+    bool colorizeRows(int first, int last);
+    /**
+     * @brief The colors of a range of rows for the intelligent scroll bar.
+     * They're taken from the color index, which is filled in as rows are
+     * colorized; no rows are colorized for it.
+     * @param first The first row.
+     * @param count The number of rows.
+     * @param lines The number of lines to draw them on.
+     * @return A color for each line: that of the first of its rows that
+     * matched a coloring rule, or transparent if none did or they haven't
+     * been colorized yet.
+     */
+    QVector<QRgb> rowColors(int first, int count, int lines) const;
     int visibleIndexOf(frame_data *fdata) const;
     /**
      * @brief Invalidate any cached column strings.
@@ -69,6 +89,15 @@ public:
     void unsetAllFrameRefTime();
 
     void setMaximumRowHeight(int height);
+    /**
+     * @brief Dissect the rows near the visible ones while idle, those the
+     * list is scrolling towards first, so that they're ready to be shown.
+     * @param first The first visible row.
+     * @param last The last visible row.
+     * @param direction 1 if the list is scrolling down, -1 if it's
+     * scrolling up and 0 if it isn't scrolling.
+     */
+    void prefetchRows(int first, int last, int direction);
 
 signals:
     void goToPacket(int);
@@ -76,6 +105,7 @@ signals:
     void itemHeightChanged(const QModelIndex &ih_index);
 
     void bgColorizationProgress(int first, int last);
+    void bgColorizationFinished();
 
 public slots:
     void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
@@ -100,16 +130,39 @@ private:
     static capture_file *sort_cap_file_;
     static bool recordLessThan(PacketListRecord *r1, PacketListRecord *r2);
     static double parseNumericColumn(const QString &val, bool *ok);
+    gboolean sort_stop_flag_;
+    bool sortByColumnStrings(const QString &col_title);
 
     QElapsedTimer *idle_dissection_timer_;
     int idle_dissection_row_;
 
+    QVector<int> prefetch_rows_;
+    int prefetch_pos_;
+
+    /** The color index: a byte per frame, by frame number, that is 0 if
+     * the frame hasn't been colorized, 1 if it matched no coloring rule,
+     * and otherwise 2 plus the index in color_index_colors_ of its
+     * background color. row_color_levels_[0] has the bytes of the visible
+     * rows, and each level above it one byte for every two of the one
+     * below, so that any number of rows can be drawn on a few lines. */
+    mutable QVector<quint8> frame_color_index_;
+    mutable QVector<QRgb> color_index_colors_;
+    mutable QHash<const void *, quint8> color_index_ids_;
+    mutable QVector<QVector<quint8> > row_color_levels_;
+    mutable bool row_color_levels_stale_;
+
+    void noteRowColor(int row, const frame_data *fdata) const;
+    void resetColorIndex();
+    void resetRowColorLevels();
+    void buildRowColorLevels() const;
+
     struct _GStringChunk *string_cache_pool_;
 
     bool isNumericColumn(int column);
 
 private slots:
     void emitItemHeightChanged(const QModelIndex &ih_index);
+    void dissectPrefetchRows();
 };
 
 #endif // PACKET_LIST_MODEL_H
@@ -18,17 +18,36 @@
 #include <epan/wmem/wmem.h>
 
 #include <epan/color_filters.h>
+#include <epan/prefs.h>
 
 #include "frame_tvbuff.h"
 
 #include <ui/qt/utils/qt_ui_utils.h>
 
-#include <QStringList>
+#include <QVector>
+
+#include <string.h>
 
 QMap<int, int> PacketListRecord::cinfo_column_;
 unsigned PacketListRecord::col_data_ver_ = 1;
 unsigned PacketListRecord::rows_color_ver_ = 1;
 
+QVector<PacketListRecord *> PacketListRecord::cached_records_;
+int PacketListRecord::cache_hand_ = 0;
+qint64 PacketListRecord::cache_size_ = 0;
+
+GStringChunk *PacketListRecord::interned_chunk_ = NULL;
+GHashTable *PacketListRecord::interned_ids_ = NULL;
+GPtrArray *PacketListRecord::interned_strs_ = NULL;
+
+// Entries of the column string table that refer to interned strings
+static const quint32 interned_flag_ = 0x80000000U;
+// Only strings this short are interned...
+static const size_t max_interned_len_ = 64;
+// ...and at most this many of them, so that columns that hardly ever
+// repeat, such as custom columns of sequence numbers, don't fill the pool.
+static const guint max_interned_strings_ = 256 * 1024;
+
 PacketListRecord::PacketListRecord(frame_data *frameData) :
     fdata_(frameData),
     lines_(1),
@@ -37,13 +56,15 @@ PacketListRecord::PacketListRecord(frame_data *frameData) :
     color_ver_(0),
     colorized_(false),
     conv_index_(0),
-    read_failed_(false)
+    read_failed_(false),
+    cache_referenced_(false),
+    cache_slot_(-1)
 {
 }
 
 PacketListRecord::~PacketListRecord()
 {
-    col_text_.clear();
+    removeFromCache();
 }
 
 void PacketListRecord::ensureColorized(capture_file *cap_file)
@@ -55,14 +76,25 @@ void PacketListRecord::ensureColorized(capture_file *cap_file)
         return;
     }
 
-    //
-    // XXX - do we need to check whether the data versions match?
-    // If the record's color is already correct, we shouldn't need
-    // to redissect it to colorize it.
-    //
+    // The column strings aren't needed to colorize the record, and aren't
+    // cached here; caching those of every record would just evict the
+    // ones of records that are being shown.
+    if (!colorized_ || ( color_ver_ != rows_color_ver_ )) {
+        dissect(cap_file, true, false);
+    }
+}
+
+void PacketListRecord::ensureCached(capture_file *cap_file)
+{
+    Q_ASSERT(fdata_);
+
+    if (!cap_file) {
+        return;
+    }
+
     bool dissect_color = !colorized_ || ( color_ver_ != rows_color_ver_ );
-    if (data_ver_ != col_data_ver_ || dissect_color) {
-        dissect(cap_file, dissect_color);
+    if (col_text_.isEmpty() || data_ver_ != col_data_ver_ || dissect_color) {
+        dissect(cap_file, dissect_color, true);
     }
 }
 
@@ -83,11 +115,142 @@ const QString PacketListRecord::columnString(capture_file *cap_file, int column,
     // properly colorized?
     //
     bool dissect_color = ( colorized && !colorized_ ) || ( color_ver_ != rows_color_ver_ );
-    if (column >= col_text_.count() || col_text_.at(column).isNull() || data_ver_ != col_data_ver_ || dissect_color) {
-        dissect(cap_file, dissect_color);
+    if (column >= columnCount() || data_ver_ != col_data_ver_ || dissect_color) {
+        dissect(cap_file, dissect_color, true);
+    }
+    if (column >= columnCount()) {
+        return QString();
+    }
+
+    cache_referenced_ = true;
+
+    quint32 entry;
+    memcpy(&entry, col_text_.constData() + (column + 1) * sizeof(quint32), sizeof(quint32));
+    if (entry & interned_flag_) {
+        return QString::fromUtf8((const char *) g_ptr_array_index(interned_strs_, entry & ~interned_flag_));
+    }
+    return QString::fromUtf8(col_text_.constData() + entry);
+}
+
+void PacketListRecord::invalidateAllRecords()
+{
+    col_data_ver_++;
+
+    // None of the cached strings can be used again; free them all.
+    foreach (PacketListRecord *record, cached_records_) {
+        record->col_text_.clear();
+        record->cache_slot_ = -1;
+    }
+    cached_records_.clear();
+    cache_hand_ = 0;
+    cache_size_ = 0;
+
+    if (interned_chunk_) {
+        g_string_chunk_clear(interned_chunk_);
+        g_hash_table_remove_all(interned_ids_);
+        g_ptr_array_set_size(interned_strs_, 0);
+    }
+}
+
+qint64 PacketListRecord::cacheSize(const QByteArray &text)
+{
+    return text.capacity() + (qint64) sizeof(void *) * 4;
+}
+
+void PacketListRecord::removeFromCache()
+{
+    if (cache_slot_ < 0) {
+        return;
+    }
+
+    // Move the last cached record into our slot.
+    PacketListRecord *last = cached_records_.last();
+    cached_records_[cache_slot_] = last;
+    last->cache_slot_ = cache_slot_;
+    cached_records_.removeLast();
+    if (cache_hand_ >= cached_records_.count()) {
+        cache_hand_ = 0;
+    }
+
+    cache_size_ -= cacheSize(col_text_);
+    cache_slot_ = -1;
+}
+
+// Evict the column strings of records, least recently used first (or near
+// enough: this is the "clock" algorithm, where a record used since the
+// hand last passed it is spared once), until the cache fits in its
+// budget. Return the strings of the last record evicted, for reuse.
+QByteArray PacketListRecord::trimCache(PacketListRecord *keep)
+{
+    QByteArray recycled;
+    qint64 budget = (qint64) prefs.gui_packet_list_cache_size * 1024 * 1024;
+
+    if (budget == 0) {
+        return recycled;
+    }
+
+    while (cache_size_ > budget && cached_records_.count() > 1) {
+        PacketListRecord *record = cached_records_[cache_hand_];
+
+        if (record == keep || record->cache_referenced_) {
+            record->cache_referenced_ = false;
+            cache_hand_ = (cache_hand_ + 1) % cached_records_.count();
+            continue;
+        }
+        record->removeFromCache();
+        recycled.swap(record->col_text_);
+        record->col_text_.clear();
+    }
+    return recycled;
+}
+
+const char *PacketListRecord::internString(const char *str, quint32 *id)
+{
+    if (!interned_chunk_) {
+        interned_chunk_ = g_string_chunk_new(64 * 1024);
+        interned_ids_ = g_hash_table_new(g_str_hash, g_str_equal);
+        interned_strs_ = g_ptr_array_new();
+    }
+
+    gpointer value;
+    if (g_hash_table_lookup_extended(interned_ids_, str, NULL, &value)) {
+        *id = GPOINTER_TO_UINT(value);
+        return (const char *) g_ptr_array_index(interned_strs_, *id);
+    }
+    if (interned_strs_->len >= max_interned_strings_) {
+        return NULL;
     }
 
-    return col_text_.at(column);
+    char *interned = g_string_chunk_insert(interned_chunk_, str);
+    *id = interned_strs_->len;
+    g_ptr_array_add(interned_strs_, interned);
+    g_hash_table_insert(interned_ids_, interned, GUINT_TO_POINTER(*id));
+    return interned;
+}
+
+// Columns whose values repeat from packet to packet: protocols,
+// addresses, ports, and most others, but not the number, time, cumulative
+// bytes and info columns, which are almost always unique.
+static bool internedColumn(int col_fmt)
+{
+    switch (col_fmt) {
+    case COL_NUMBER:
+    case COL_INFO:
+    case COL_CUMULATIVE_BYTES:
+    case COL_ABS_YMD_TIME:
+    case COL_ABS_YDOY_TIME:
+    case COL_ABS_TIME:
+    case COL_DELTA_TIME:
+    case COL_DELTA_TIME_DIS:
+    case COL_REL_TIME:
+    case COL_UTC_YMD_TIME:
+    case COL_UTC_YDOY_TIME:
+    case COL_UTC_TIME:
+    case COL_CLS_TIME:
+        return false;
+    default:
+        return true;
+    }
 }
 
 void PacketListRecord::resetColumns(column_info *cinfo)
@@ -108,7 +271,7 @@ void PacketListRecord::resetColumns(column_info *cinfo)
     }
 }
 
-void PacketListRecord::dissect(capture_file *cap_file, bool dissect_color)
+void PacketListRecord::dissect(capture_file *cap_file, bool dissect_color, bool want_columns)
 {
     // packet_list_store.c:packet_list_dissect_and_cache_record
     epan_dissect_t edt;
@@ -117,7 +280,7 @@ void PacketListRecord::dissect(capture_file *cap_file, bool dissect_color)
     wtap_rec rec; /* Record metadata */
     Buffer buf;   /* Record data */
 
-    gboolean dissect_columns = col_text_.isEmpty() || data_ver_ != col_data_ver_;
+    gboolean dissect_columns = want_columns && (col_text_.isEmpty() || data_ver_ != col_data_ver_);
 
     if (!cap_file) {
         return;
@@ -206,7 +369,9 @@ void PacketListRecord::dissect(capture_file *cap_file, bool dissect_color)
         colorized_ = true;
         color_ver_ = rows_color_ver_;
     }
-    data_ver_ = col_data_ver_;
+    if (dissect_columns) {
+        data_ver_ = col_data_ver_;
+    }
 
     struct conversation * conv = find_conversation_pinfo(&edt.pi, 0);
     conv_index_ = ! conv ? 0 : conv->conv_index;
@@ -216,7 +381,14 @@ void PacketListRecord::dissect(capture_file *cap_file, bool dissect_color)
     wtap_rec_cleanup(&rec);
 }
 
-//#define MINIMIZE_STRING_COPYING 1
+// The column strings are kept in a single block: the number of columns,
+// a table with an entry for each column, and the strings, each
+// NUL-terminated and in UTF-8. An entry is the offset of its string in the
+// block or, if it has interned_flag_ set, the index of an interned string
+// shared by all the records, for a value that's often repeated. A packet
+// list of millions of records uses much less memory this way than with a
+// QString for each column. The blocks are cached within the budget set by
+// the gui.packet_list_cache_size preference; see trimCache().
 void PacketListRecord::cacheColumnStrings(column_info *cinfo)
 {
     // packet_list_store.c:packet_list_change_record(PacketList *packet_list, PacketListRecord *record, gint col, column_info *cinfo)
@@ -224,89 +396,97 @@ void PacketListRecord::cacheColumnStrings(column_info *cinfo)
         return;
     }
 
-    col_text_.clear();
+    QVector<const char *> col_strs(cinfo->num_cols);
+    QVector<quint32> col_ids(cinfo->num_cols);
+    QVector<int> col_lens(cinfo->num_cols);
+    int text_size = (cinfo->num_cols + 1) * (int) sizeof(quint32);
+
     lines_ = 1;
     line_count_changed_ = false;
 
     for (int column = 0; column < cinfo->num_cols; ++column) {
-        int col_lines = 1;
-
-#ifdef MINIMIZE_STRING_COPYING
-        int text_col = cinfo_column_.value(column, -1);
+        const char *col_str;
 
-        /* Column based on frame_data or it already contains a value */
-        if (text_col < 0) {
-            col_fill_in_frame_data(fdata_, cinfo, column, FALSE);
-            col_text_ << QString(cinfo->columns[column].col_data);
-            continue;
-        }
-
-        switch (cinfo->col_fmt[column]) {
-        case COL_PROTOCOL:
-        case COL_INFO:
-        case COL_IF_DIR:
-        case COL_DCE_CALL:
-        case COL_8021Q_VLAN_ID:
-        case COL_EXPERT:
-        case COL_FREQ_CHAN:
-            if (cinfo->columns[column].col_data && cinfo->columns[column].col_data != cinfo->columns[column].col_buf) {
-                /* This is a constant string, so we don't have to copy it */
-                // XXX - ui/gtk/packet_list_store.c uses G_MAXUSHORT. We don't do proper UTF8
-                // truncation in either case.
-                int col_text_len = MIN(qstrlen(cinfo->col_data[column]) + 1, COL_MAX_INFO_LEN);
-                col_text_ << QString(QByteArray::fromRawData(cinfo->columns[column].col_data, col_text_len));
-                break;
-            }
-            /* !! FALL-THROUGH!! */
-
-        case COL_DEF_SRC:
-        case COL_RES_SRC:        /* COL_DEF_SRC is currently just like COL_RES_SRC */
-        case COL_UNRES_SRC:
-        case COL_DEF_DL_SRC:
-        case COL_RES_DL_SRC:
-        case COL_UNRES_DL_SRC:
-        case COL_DEF_NET_SRC:
-        case COL_RES_NET_SRC:
-        case COL_UNRES_NET_SRC:
-        case COL_DEF_DST:
-        case COL_RES_DST:        /* COL_DEF_DST is currently just like COL_RES_DST */
-        case COL_UNRES_DST:
-        case COL_DEF_DL_DST:
-        case COL_RES_DL_DST:
-        case COL_UNRES_DL_DST:
-        case COL_DEF_NET_DST:
-        case COL_RES_NET_DST:
-        case COL_UNRES_NET_DST:
-        default:
-            if (!get_column_resolved(column) && cinfo->col_expr.col_expr_val[column]) {
-                /* Use the unresolved value in col_expr_val */
-                // XXX Use QContiguousCache?
-                col_text_ << QString(cinfo->col_expr.col_expr_val[column]);
-            } else {
-                col_text_ << QString(cinfo->columns[column].col_data);
-            }
-            break;
-        }
-#else // MINIMIZE_STRING_COPYING
-        QString col_str;
         if (!get_column_resolved(column) && cinfo->col_expr.col_expr_val[column]) {
             /* Use the unresolved value in col_expr_val */
-            col_str = QString(cinfo->col_expr.col_expr_val[column]);
+            col_str = cinfo->col_expr.col_expr_val[column];
         } else {
             int text_col = cinfo_column_.value(column, -1);
 
             if (text_col < 0) {
                 col_fill_in_frame_data(fdata_, cinfo, column, FALSE);
             }
-            col_str = QString(cinfo->columns[column].col_data);
+            col_str = cinfo->columns[column].col_data;
+        }
+        if (!col_str) {
+            col_str = "";
+        }
+
+        size_t col_len = strlen(col_str);
+        const char *interned = NULL;
+        if (col_len <= max_interned_len_ && internedColumn(cinfo->columns[column].col_fmt)) {
+            interned = internString(col_str, &col_ids[column]);
+        }
+        if (interned) {
+            col_strs[column] = interned;
+            col_lens[column] = 0;
+        } else {
+            col_strs[column] = col_str;
+            col_lens[column] = (int) col_len + 1;
+        }
+        text_size += col_lens[column];
+    }
+
+    // Reuse the block of a record evicted to make room for ours, if any.
+    removeFromCache();
+    cache_size_ += text_size;
+    QByteArray recycled = trimCache(this);
+    cache_size_ -= text_size;
+    if (recycled.capacity() >= text_size) {
+        col_text_.swap(recycled);
+    }
+
+    col_text_.resize(text_size);
+    char *text = col_text_.data();
+    quint32 offset = (cinfo->num_cols + 1) * (quint32) sizeof(quint32);
+    quint32 num_cols = cinfo->num_cols;
+
+    memcpy(text, &num_cols, sizeof(quint32));
+    for (int column = 0; column < cinfo->num_cols; ++column) {
+        char *entry = text + (column + 1) * sizeof(quint32);
+
+        if (col_lens[column] == 0) {
+            quint32 id = col_ids[column] | interned_flag_;
+            memcpy(entry, &id, sizeof(quint32));
+        } else {
+            memcpy(entry, &offset, sizeof(quint32));
+            memcpy(text + offset, col_strs[column], col_lens[column]);
+            offset += col_lens[column];
         }
 
-        col_text_ << col_str;
-        col_lines = col_str.count('\n');
+        int col_lines = 0;
+        for (const char *nl = strchr(col_strs[column], '\n'); nl; nl = strchr(nl + 1, '\n')) {
+            col_lines++;
+        }
         if (col_lines > lines_) {
             lines_ = col_lines;
             line_count_changed_ = true;
         }
-#endif // MINIMIZE_STRING_COPYING
     }
+
+    cache_slot_ = cached_records_.count();
+    cached_records_ << this;
+    cache_size_ += cacheSize(col_text_);
+    cache_referenced_ = true;
+}
+
+int PacketListRecord::columnCount() const
+{
+    quint32 num_cols;
+
+    if (col_text_.isEmpty()) {
+        return 0;
+    }
+    memcpy(&num_cols, col_text_.constData(), sizeof(quint32));
+    return (int) num_cols;
 }
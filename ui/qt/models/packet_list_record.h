@@ -22,6 +22,7 @@
 #include <QByteArray>
 #include <QList>
 #include <QVariant>
+#include <QVector>
 
 struct conversation;
 struct _GStringChunk;
@@ -34,6 +35,11 @@ public:
 
     // Ensure that the record is colorized.
     void ensureColorized(capture_file *cap_file);
+    // Note that the frame was colorized with the current coloring rules
+    // when it was first dissected.
+    void setColorized() { colorized_ = true; color_ver_ = rows_color_ver_; }
+    // Ensure that the record is colorized and its column strings cached.
+    void ensureCached(capture_file *cap_file);
     // Return the string value for a column. Data is cached if possible.
     const QString columnString(capture_file *cap_file, int column, bool colorized = false);
     frame_data *frameData() const { return fdata_; }
@@ -43,7 +49,7 @@ public:
     unsigned int conversation() { return conv_index_; }
 
     int columnTextSize(const char *str);
-    static void invalidateAllRecords() { col_data_ver_++; }
+    static void invalidateAllRecords();
     static void resetColumns(column_info *cinfo);
     static void resetColorization() { rows_color_ver_++; }
 
@@ -51,8 +57,9 @@ public:
     inline int lineCountChanged() { return line_count_changed_; }
 
 private:
-    /** The column text for some columns */
-    QStringList col_text_;
+    /** The column text, as a table of offsets followed by the strings;
+     * see cacheColumnStrings() */
+    QByteArray col_text_;
 
     frame_data *fdata_;
     int lines_;
@@ -72,8 +79,27 @@ private:
 
     bool read_failed_;
 
-    void dissect(capture_file *cap_file, bool dissect_color = false);
+    /** The column string cache. Records with cached column strings are
+     * in cached_records_, at cache_slot_; cache_referenced_ is set when
+     * the strings are used. */
+    bool cache_referenced_;
+    int cache_slot_;
+    static QVector<PacketListRecord *> cached_records_;
+    static int cache_hand_;
+    static qint64 cache_size_;
+
+    /** Interned column strings */
+    static GStringChunk *interned_chunk_;
+    static GHashTable *interned_ids_;
+    static GPtrArray *interned_strs_;
+
+    void dissect(capture_file *cap_file, bool dissect_color, bool want_columns);
     void cacheColumnStrings(column_info *cinfo);
+    int columnCount() const;
+    void removeFromCache();
+    static qint64 cacheSize(const QByteArray &text);
+    static QByteArray trimCache(PacketListRecord *keep);
+    static const char *internString(const char *str, quint32 *id);
 };
 
 #endif // PACKET_LIST_RECORD_H
@@ -28,13 +28,43 @@ ProtoTreeModel::ProtoTreeModel(QObject * parent) :
 Qt::ItemFlags ProtoTreeModel::flags(const QModelIndex &index) const
 {
     Qt::ItemFlags item_flags = QAbstractItemModel::flags(index);
-    if (rowCount(index) < 1) {
+    if (!hasChildren(index)) {
         item_flags |= Qt::ItemNeverHasChildren;
     }
 
     return item_flags;
 }
 
+// Collect the visible children of a node, and remember their rows.
+const QVector<proto_node *> &ProtoTreeModel::childNodes(proto_node *parent_node) const
+{
+    QHash<proto_node *, QVector<proto_node *> >::iterator it = child_nodes_.find(parent_node);
+    if (it != child_nodes_.end()) {
+        return it.value();
+    }
+
+    QVector<proto_node *> nodes;
+    ProtoNode::ChildIterator kids = ProtoNode(parent_node).children();
+    while (kids.element().isValid())
+    {
+        node_rows_.insert(kids.element().protoNode(), nodes.size());
+        nodes.append(kids.element().protoNode());
+        kids.next();
+    }
+    return child_nodes_.insert(parent_node, nodes).value();
+}
+
+int ProtoTreeModel::nodeRow(proto_node *node) const
+{
+    if (!node || !node->parent) {
+        return -1;
+    }
+    if (!node_rows_.contains(node)) {
+        childNodes(node->parent);
+    }
+    return node_rows_.value(node, -1);
+}
+
 QModelIndex ProtoTreeModel::index(int row, int, const QModelIndex &parent) const
 {
     ProtoNode parent_node(root_node_);
@@ -47,20 +77,12 @@ QModelIndex ProtoTreeModel::index(int row, int, const QModelIndex &parent) const
     if (! parent_node.isValid())
         return QModelIndex();
 
-    int cur_row = 0;
-    ProtoNode::ChildIterator kids = parent_node.children();
-    while (kids.element().isValid())
-    {
-        if (cur_row == row)
-            break;
-        cur_row++;
-        kids.next();
-    }
-    if (! kids.element().isValid()) {
+    const QVector<proto_node *> &kids = childNodes(parent_node.protoNode());
+    if (row < 0 || row >= kids.size()) {
         return QModelIndex();
     }
 
-    return createIndex(row, 0, static_cast<void *>(kids.element().protoNode()));
+    return createIndex(row, 0, static_cast<void *>(kids.at(row)));
 }
 
 QModelIndex ProtoTreeModel::parent(const QModelIndex &index) const
@@ -71,10 +93,28 @@ QModelIndex ProtoTreeModel::parent(const QModelIndex &index) const
 
 int ProtoTreeModel::rowCount(const QModelIndex &parent) const
 {
-    if (parent.isValid()) {
-        return protoNodeFromIndex(parent).childrenCount();
+    proto_node *parent_node = parent.isValid() ? protoNodeFromIndex(parent).protoNode() : root_node_;
+
+    if (!parent_node) {
+        return 0;
     }
-    return ProtoNode(root_node_).childrenCount();
+    return childNodes(parent_node).size();
+}
+
+// Unlike rowCount, this doesn't collect the children, so that showing a
+// row doesn't do that for the subtree under it.
+bool ProtoTreeModel::hasChildren(const QModelIndex &parent) const
+{
+    ProtoNode parent_node = parent.isValid() ? protoNodeFromIndex(parent) : ProtoNode(root_node_);
+
+    if (!parent_node.isValid()) {
+        return false;
+    }
+    QHash<proto_node *, QVector<proto_node *> >::const_iterator it = child_nodes_.constFind(parent_node.protoNode());
+    if (it != child_nodes_.constEnd()) {
+        return !it.value().isEmpty();
+    }
+    return parent_node.children().element().isValid();
 }
 
 // The QItemDelegate documentation says
@@ -93,7 +133,13 @@ QVariant ProtoTreeModel::data(const QModelIndex &index, int role) const
 
     switch (role) {
     case Qt::DisplayRole:
-        return index_node.labelText();
+    {
+        QHash<proto_node *, QString>::const_iterator it = labels_.constFind(index_node.protoNode());
+        if (it != labels_.constEnd()) {
+            return it.value();
+        }
+        return labels_.insert(index_node.protoNode(), index_node.labelText()).value();
+    }
     case Qt::BackgroundRole:
     {
         switch(finfo.flag(PI_SEVERITY_MASK)) {
@@ -147,10 +193,13 @@ void ProtoTreeModel::setRootNode(proto_node *root_node)
 {
     beginResetModel();
     root_node_ = root_node;
+    child_nodes_.clear();
+    node_rows_.clear();
+    labels_.clear();
     endResetModel();
     if (!root_node) return;
 
-    int row_count = ProtoNode(root_node_).childrenCount();
+    int row_count = rowCount();
     if (row_count < 1) return;
     beginInsertRows(QModelIndex(), 0, row_count - 1);
     endInsertRows();
@@ -163,7 +212,7 @@ ProtoNode ProtoTreeModel::protoNodeFromIndex(const QModelIndex &index) const
 
 QModelIndex ProtoTreeModel::indexFromProtoNode(ProtoNode &index_node) const
 {
-    int row = index_node.row();
+    int row = nodeRow(index_node.protoNode());
 
     if (!index_node.isValid() || row < 0) {
         return QModelIndex();
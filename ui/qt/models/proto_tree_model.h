@@ -13,7 +13,16 @@
 #include <ui/qt/utils/proto_node.h>
 
 #include <QAbstractItemModel>
+#include <QHash>
 #include <QModelIndex>
+#include <QVector>
+
+// Rows are created lazily: the visible children of a node are collected
+// the first time the view asks about them, which it does when the node is
+// expanded or scrolled into view, and a label is formatted the first time
+// its row is shown. Both are kept until the root node changes, so that
+// finding a row or showing it again doesn't walk its siblings or format
+// it again.
 
 class ProtoTreeModel : public QAbstractItemModel
 {
@@ -26,6 +35,7 @@ public:
     QModelIndex index(int row, int, const QModelIndex &parent = QModelIndex()) const;
     virtual QModelIndex parent(const QModelIndex &index) const;
     virtual int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    virtual bool hasChildren(const QModelIndex &parent = QModelIndex()) const;
     virtual int columnCount(const QModelIndex &) const { return 1; }
     virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
 
@@ -39,6 +49,12 @@ public:
 
 private:
     proto_node* root_node_;
+    mutable QHash<proto_node *, QVector<proto_node *> > child_nodes_;
+    mutable QHash<proto_node *, int> node_rows_;
+    mutable QHash<proto_node *, QString> labels_;
+
+    const QVector<proto_node *> &childNodes(proto_node *parent_node) const;
+    int nodeRow(proto_node *node) const;
     static void foreachFindHfid(proto_node *node, gpointer find_hfid_ptr);
     static void foreachFindField(proto_node *node, gpointer find_finfo_ptr);
 };
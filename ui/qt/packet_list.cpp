@@ -93,6 +93,7 @@ static PacketList *gbl_cur_packet_list = NULL;
 const int max_comments_to_fetch_ = 20000000; // Arbitrary
 const int tail_update_interval_ = 100; // Milliseconds.
 const int overlay_update_interval_ = 100; // 250; // Milliseconds.
+const int refilter_interval_ = 0; // Milliseconds; whenever we're idle.
 
 
 // Copied from ui/gtk/packet_list.c
@@ -187,6 +188,16 @@ packet_list_moveto_end(void)
     // gbl_cur_packet_list->scrollToBottom();
 }
 
+// Called from cf_filter_packets when the display filter changes during
+// a live capture.
+void
+packet_list_schedule_refilter(void)
+{
+    if (gbl_cur_packet_list) {
+        gbl_cur_packet_list->scheduleRefilter();
+    }
+}
+
 /* Redraw the packet list *and* currently-selected detail */
 void
 packet_list_queue_draw(void)
@@ -225,13 +236,15 @@ PacketList::PacketList(QWidget *parent) :
     mouse_pressed_at_(QModelIndex()),
     capture_in_progress_(false),
     tail_timer_id_(0),
+    refilter_timer_id_(0),
     tail_at_end_(0),
     rows_inserted_(false),
     columns_changed_(false),
     set_column_visibility_(false),
     frozen_rows_(QModelIndexList()),
     cur_history_(-1),
-    in_history_(false)
+    in_history_(false),
+    prefetch_sb_value_(0)
 {
     setItemsExpandable(false);
     setRootIsDecorated(false);
@@ -272,6 +285,7 @@ PacketList::PacketList(QWidget *parent) :
 
     connect(packet_list_model_, SIGNAL(goToPacket(int)), this, SLOT(goToPacket(int)));
     connect(packet_list_model_, SIGNAL(itemHeightChanged(const QModelIndex&)), this, SLOT(updateRowHeights(const QModelIndex&)));
+    connect(packet_list_model_, SIGNAL(bgColorizationFinished()), this, SLOT(bgColorizationFinished()));
     connect(wsApp, SIGNAL(addressResolutionChanged()), this, SLOT(redrawVisiblePacketsDontSelectCurrent()));
     connect(wsApp, SIGNAL(columnDataChanged()), this, SLOT(redrawVisiblePacketsDontSelectCurrent()));
 
@@ -281,6 +295,7 @@ PacketList::PacketList(QWidget *parent) :
             this, SLOT(sectionMoved(int,int,int)));
 
     connect(verticalScrollBar(), SIGNAL(actionTriggered(int)), this, SLOT(vScrollBarActionTriggered(int)));
+    connect(verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(vScrollBarValueChanged(int)));
 }
 
 void PacketList::colorsChanged()
@@ -765,6 +780,13 @@ void PacketList::timerEvent(QTimerEvent *event)
             scrollToBottom();
             rows_inserted_ = false;
         }
+    } else if (event->timerId() == refilter_timer_id_) {
+        // Refilter the frames we had when the filter changed a chunk at
+        // a time, so that we keep up with new ones.
+        if (!cap_file_ || !cf_continue_refilter(cap_file_)) {
+            killTimer(refilter_timer_id_);
+            refilter_timer_id_ = 0;
+        }
     } else if (event->timerId() == overlay_timer_id_) {
         if (!capture_in_progress_) {
             if (create_near_overlay_) drawNearOverlay();
@@ -1175,6 +1197,11 @@ void PacketList::setVerticalAutoScroll(bool enabled)
     }
 }
 
+void PacketList::scheduleRefilter()
+{
+    if (refilter_timer_id_ == 0) refilter_timer_id_ = startTimer(refilter_interval_);
+}
+
 // Called when we finish reading, reloading, rescanning, and retapping
 // packets.
 void PacketList::captureFileReadFinished()
@@ -1845,6 +1872,20 @@ void PacketList::vScrollBarActionTriggered(int)
     scrollViewChanged(tail_at_end_);
 }
 
+// Have the rows we're scrolling towards dissected before they're shown.
+void PacketList::vScrollBarValueChanged(int value)
+{
+    int direction = value > prefetch_sb_value_ ? 1 : (value < prefetch_sb_value_ ? -1 : 0);
+    prefetch_sb_value_ = value;
+
+    int first = indexAt(viewport()->rect().topLeft()).row();
+    int last = indexAt(viewport()->rect().bottomLeft()).row();
+    if (last < 0) {
+        last = packet_list_model_->rowCount() - 1;
+    }
+    packet_list_model_->prefetchRows(first, last, direction);
+}
+
 void PacketList::scrollViewChanged(bool at_end)
 {
     if (capture_in_progress_ && prefs.capture_auto_scroll) {
@@ -1896,22 +1937,22 @@ void PacketList::drawNearOverlay()
             start += ((double) overlay_sb_->value() / overlay_sb_->maximum()) * (packet_list_model_->rowCount() - o_rows);
         }
         int end = start + o_rows;
-        for (int row = start; row < end; row++) {
-            packet_list_model_->ensureRowColorized(row);
 
-            frame_data *fdata = packet_list_model_->getRowFdata(row);
-            const color_t *bgcolor = NULL;
-            if (fdata->color_filter) {
-                const color_filter_t *color_filter = (const color_filter_t *) fdata->color_filter;
-                bgcolor = &color_filter->bg_color;
-            }
+        // Colorizing every row we show here at once makes scrolling
+        // through large captures stutter. Colorize a slice of the ones
+        // that aren't and draw the rest once they are, here or by
+        // dissectIdle.
+        if (!packet_list_model_->colorizeRows(start, end - 1)) {
+            create_near_overlay_ = true;
+        }
 
-            int next_line = (row - start) * o_height / o_rows;
-            if (bgcolor) {
-                QColor color(ColorUtils::fromColorT(bgcolor));
-                painter.fillRect(0, cur_line, o_width, next_line - cur_line, color);
+        QVector<QRgb> colors = packet_list_model_->rowColors(start, o_rows, o_height);
+        for (int line = 1; line <= o_height; line++) {
+            if (line < o_height && colors[line] == colors[cur_line]) continue;
+            if (qAlpha(colors[cur_line]) != 0) {
+                painter.fillRect(0, cur_line, o_width, line - cur_line, QColor(colors[cur_line]));
             }
-            cur_line = next_line;
+            cur_line = line;
         }
 
         // If the selected packet is in the overlay set selected_pos
@@ -1989,6 +2030,18 @@ void PacketList::drawFarOverlay()
         // Hopefully no themes use the text color for the groove color.
         overlay.fill(Qt::transparent);
 
+        // The colors of the packets that have been colorized, down the
+        // middle. Marked and ignored ticks are on the left, time
+        // references on the right.
+        int tick_width = o_width / 3;
+        QVector<QRgb> colors = packet_list_model_->rowColors(0, pl_rows, o_height);
+        for (int line = 0; line < o_height; line++) {
+            if (qAlpha(colors[line]) != 0) {
+                painter.fillRect(tick_width, line, o_width - 2 * tick_width, 1, QColor(colors[line]));
+                have_marked_image = true;
+            }
+        }
+
         QColor tick_color = palette().text().color();
         tick_color.setAlphaF(0.3);
         painter.setPen(tick_color);
@@ -1998,7 +2051,6 @@ void PacketList::drawFarOverlay()
             frame_data *fdata = packet_list_model_->getRowFdata(row);
             if (fdata->marked || fdata->ref_time || fdata->ignored) {
                 int new_line = row * o_height / pl_rows;
-                int tick_width = o_width / 3;
                 // Marked or ignored: left side, time refs: right side.
                 // XXX Draw ignored ticks in the middle?
                 int x1 = fdata->ref_time ? o_width - tick_width : 1;
@@ -2021,6 +2073,12 @@ void PacketList::drawFarOverlay()
     }
 }
 
+// The colors of all the packets are known now.
+void PacketList::bgColorizationFinished()
+{
+    create_far_overlay_ = true;
+}
+
 void PacketList::rowsInserted(const QModelIndex &parent, int start, int end)
 {
     QTreeView::rowsInserted(parent, start, end);
@@ -76,6 +76,7 @@ public:
     QString allPacketComments();
     void deleteAllPacketComments();
     void setVerticalAutoScroll(bool enabled = true);
+    void scheduleRefilter();
     void setCaptureInProgress(bool in_progress = false) { capture_in_progress_ = in_progress; tail_at_end_ = in_progress; }
     void captureFileReadFinished();
     void resetColumns();
@@ -130,6 +131,7 @@ private:
     QList<QAction *>show_hide_actions_;
     bool capture_in_progress_;
     int tail_timer_id_;
+    int refilter_timer_id_;
     bool tail_at_end_;
     bool rows_inserted_;
     bool columns_changed_;
@@ -138,6 +140,7 @@ private:
     QVector<int> selection_history_;
     int cur_history_;
     bool in_history_;
+    int prefetch_sb_value_;
 
     void setFrameReftime(gboolean set, frame_data *fdata);
     void setColumnVisibility();
@@ -191,8 +194,10 @@ private slots:
     void updateRowHeights(const QModelIndex &ih_index);
     void copySummary();
     void vScrollBarActionTriggered(int);
+    void vScrollBarValueChanged(int value);
     void drawFarOverlay();
     void drawNearOverlay();
+    void bgColorizationFinished();
     void updatePackets(bool redraw);
     void ctxDecodeAsDialog();
 };
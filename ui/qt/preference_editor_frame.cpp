@@ -233,7 +233,7 @@ void PreferenceEditorFrame::on_buttonBox_accepted()
     }
 
     if (apply && module_) {
-        changed_flags = module_->prefs_changed_flags;
+        changed_flags = module_->prefs_changed_flags | apply;
         pref_unstash_data_t unstashed_data;
 
         unstashed_data.module = module_;
@@ -256,7 +256,11 @@ void PreferenceEditorFrame::on_buttonBox_accepted()
         if (changed_flags & PREF_EFFECT_FIELDS) {
             wsApp->emitAppSignal(WiresharkApplication::FieldsChanged);
         }
-        wsApp->emitAppSignal(WiresharkApplication::PacketDissectionChanged);
+        if ((changed_flags & (PREF_EFFECT_DISSECTION|PREF_EFFECT_DISPLAY)) == PREF_EFFECT_DISPLAY) {
+            wsApp->emitAppSignal(WiresharkApplication::PacketDisplayChanged);
+        } else {
+            wsApp->emitAppSignal(WiresharkApplication::PacketDissectionChanged);
+        }
         wsApp->emitAppSignal(WiresharkApplication::PreferencesChanged);
     }
 }
@@ -292,6 +292,9 @@ void PreferencesDialog::on_buttonBox_accepted()
     if (redissect_flags & PREF_EFFECT_DISSECTION) {
         /* Redissect all the packets, and re-evaluate the display filter. */
         wsApp->queueAppSignal(WiresharkApplication::PacketDissectionChanged);
+    } else if (redissect_flags & PREF_EFFECT_DISPLAY) {
+        /* The state built from the packets is still good; redraw them. */
+        wsApp->queueAppSignal(WiresharkApplication::PacketDisplayChanged);
     }
     wsApp->queueAppSignal(WiresharkApplication::PreferencesChanged);
 
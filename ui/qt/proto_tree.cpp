@@ -412,16 +412,25 @@ void ProtoTree::setMonospaceFont(const QFont &mono_font)
     update();
 }
 
-void ProtoTree::foreachTreeNode(proto_node *node, gpointer proto_tree_ptr)
+struct tree_node_walk_ {
+    ProtoTree *tree_view;
+    bool shown;     // All the ancestors of the nodes are expanded.
+};
+
+void ProtoTree::foreachTreeNode(proto_node *node, gpointer walk_ptr)
 {
-    ProtoTree *tree_view = static_cast<ProtoTree *>(proto_tree_ptr);
+    struct tree_node_walk_ *walk = static_cast<struct tree_node_walk_ *>(walk_ptr);
+    ProtoTree *tree_view = walk->tree_view;
     ProtoTreeModel *model = qobject_cast<ProtoTreeModel *>(tree_view->model());
     if (!tree_view || !model) {
         return;
     }
 
-    // Expanded state
-    if (tree_expanded(node->finfo->tree_type)) {
+    // Expanded state. Subtrees under collapsed items are expanded by
+    // syncExpanded when those are, so that their rows aren't created
+    // until they're needed.
+    bool expanded = tree_expanded(node->finfo->tree_type);
+    if (walk->shown && expanded) {
         ProtoNode expand_node = ProtoNode(node);
         tree_view->expand(model->indexFromProtoNode(expand_node));
     }
@@ -432,7 +441,8 @@ void ProtoTree::foreachTreeNode(proto_node *node, gpointer proto_tree_ptr)
         tree_view->emitRelatedFrame(node->finfo->value.value.uinteger, framenum_type);
     }
 
-    proto_tree_children_foreach(node, foreachTreeNode, proto_tree_ptr);
+    struct tree_node_walk_ child_walk = { tree_view, walk->shown && expanded };
+    proto_tree_children_foreach(node, foreachTreeNode, &child_walk);
 }
 
 // setRootNode sets the new contents for the protocol tree and subsequently
@@ -443,8 +453,9 @@ void ProtoTree::setRootNode(proto_node *root_node) {
     // The expanded state will be reset as well and will be re-expanded below.
     proto_tree_model_->setRootNode(root_node);
 
+    struct tree_node_walk_ walk = { this, true };
     disconnect(this, SIGNAL(expanded(QModelIndex)), this, SLOT(syncExpanded(QModelIndex)));
-    proto_tree_children_foreach(root_node, foreachTreeNode, this);
+    proto_tree_children_foreach(root_node, foreachTreeNode, &walk);
     connect(this, SIGNAL(expanded(QModelIndex)), this, SLOT(syncExpanded(QModelIndex)));
 
     updateContentWidth();
@@ -512,6 +523,19 @@ void ProtoTree::syncExpanded(const QModelIndex &index) {
     if (finfo.treeType() != -1) {
         tree_expanded_set(finfo.treeType(), TRUE);
     }
+
+    // Restore the expanded state of the children, which setRootNode
+    // left alone while this item was collapsed. Expanding them brings
+    // us back here for their own children.
+    int row_count = proto_tree_model_->rowCount(index);
+    for (int row = 0; row < row_count; row++) {
+        QModelIndex child = proto_tree_model_->index(row, 0, index);
+        proto_node *child_node = proto_tree_model_->protoNodeFromIndex(child).protoNode();
+        if (child_node->finfo && tree_expanded(child_node->finfo->tree_type) &&
+                proto_tree_model_->hasChildren(child) && !isExpanded(child)) {
+            expand(child);
+        }
+    }
 }
 
 void ProtoTree::syncCollapsed(const QModelIndex &index) {
@@ -290,8 +290,12 @@ void ProtocolPreferencesMenu::boolPreferenceTriggered()
         wsApp->emitAppSignal(WiresharkApplication::FieldsChanged);
     }
     /* Protocol preference changes almost always affect dissection,
-       so don't bother checking flags */
-    wsApp->emitAppSignal(WiresharkApplication::PacketDissectionChanged);
+       so redissect unless the preference only affects the display */
+    if ((changed_flags & (PREF_EFFECT_DISSECTION|PREF_EFFECT_DISPLAY)) == PREF_EFFECT_DISPLAY) {
+        wsApp->emitAppSignal(WiresharkApplication::PacketDisplayChanged);
+    } else {
+        wsApp->emitAppSignal(WiresharkApplication::PacketDissectionChanged);
+    }
 }
 
 void ProtocolPreferencesMenu::enumPreferenceTriggered()
@@ -309,8 +313,12 @@ void ProtocolPreferencesMenu::enumPreferenceTriggered()
             wsApp->emitAppSignal(WiresharkApplication::FieldsChanged);
         }
         /* Protocol preference changes almost always affect dissection,
-           so don't bother checking flags */
-        wsApp->emitAppSignal(WiresharkApplication::PacketDissectionChanged);
+           so redissect unless the preference only affects the display */
+        if ((changed_flags & (PREF_EFFECT_DISSECTION|PREF_EFFECT_DISPLAY)) == PREF_EFFECT_DISPLAY) {
+            wsApp->emitAppSignal(WiresharkApplication::PacketDisplayChanged);
+        } else {
+            wsApp->emitAppSignal(WiresharkApplication::PacketDissectionChanged);
+        }
     }
 }
 
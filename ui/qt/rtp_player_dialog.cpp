@@ -33,6 +33,8 @@
 
 #include <QAudioFormat>
 #include <QAudioOutput>
+#include <QRunnable>
+#include <QThreadPool>
 #include <ui/qt/utils/rtp_audio_silence_generator.h>
 
 #endif // QT_MULTIMEDIA_LIB
@@ -48,7 +50,6 @@
 // - Make streams checkable.
 // - Add silence, drop & jitter indicators to the graph.
 // - How to handle multiple channels?
-// - Threaded decoding?
 // - Play MP3s. As per Zawinski's Law we already read emails.
 // - RTP audio streams are currently keyed on src addr + src port + dst addr
 //   + dst port + ssrc. This means that we can have multiple rtp_stream_info
@@ -96,6 +97,28 @@ enum {
     graph_silence_data_col_ = num_pkts_col_, // QCPGraph (silence)
 };
 
+#ifdef QT_MULTIMEDIA_LIB
+// Decode one stream. Each stream has its own packets, decoders, resamplers
+// and temporary files, so different streams can be decoded at once.
+class RtpAudioStreamDecodeTask : public QRunnable
+{
+public:
+    RtpAudioStreamDecodeTask(RtpAudioStream *audio_stream, const QAudioDeviceInfo &out_device) :
+        audio_stream_(audio_stream),
+        out_device_(out_device)
+    {}
+
+    void run()
+    {
+        audio_stream_->decode(out_device_);
+    }
+
+private:
+    RtpAudioStream *audio_stream_;
+    QAudioDeviceInfo out_device_;
+};
+#endif // QT_MULTIMEDIA_LIB
+
 class RtpPlayerTreeWidgetItem : public QTreeWidgetItem
 {
 public:
@@ -429,8 +452,27 @@ void RtpPlayerDialog::rescanPackets(bool rescale_axes)
             break;
         }
         audio_stream->setTimingMode(timing_mode);
+    }
 
-        audio_stream->decode(cur_out_device);
+    // Decode the streams in parallel. try_val_to_str_ext() sets up the
+    // value_string_ext the first time it's used, so do that here first.
+    try_val_to_str_ext(0, &rtp_payload_type_short_vals_ext);
+    if (row_count > 1 && QThread::idealThreadCount() > 1) {
+        QThreadPool pool;
+
+        pool.setMaxThreadCount(qMin(row_count, QThread::idealThreadCount()));
+        for (int row = 0; row < row_count; row++) {
+            QTreeWidgetItem *ti = ui->streamTreeWidget->topLevelItem(row);
+            RtpAudioStream *audio_stream = ti->data(stream_data_col_, Qt::UserRole).value<RtpAudioStream*>();
+            pool.start(new RtpAudioStreamDecodeTask(audio_stream, cur_out_device));
+        }
+        pool.waitForDone();
+    } else {
+        for (int row = 0; row < row_count; row++) {
+            QTreeWidgetItem *ti = ui->streamTreeWidget->topLevelItem(row);
+            RtpAudioStream *audio_stream = ti->data(stream_data_col_, Qt::UserRole).value<RtpAudioStream*>();
+            audio_stream->decode(cur_out_device);
+        }
     }
 
     for (int col = 0; col < ui->streamTreeWidget->columnCount() - 1; col++) {
@@ -21,35 +21,80 @@
 #include <QPalette>
 #include <QPen>
 #include <QPointF>
+#include <QtCore/qmath.h>
+
+#include <algorithm>
 
 const int max_comment_em_width_ = 20;
 
 // UML-like network node sequence diagrams.
 // https://developer.ibm.com/articles/the-sequence-diagram/
 
-WSCPSeqData::WSCPSeqData() :
-  key(0),
-  value(NULL)
+// Labels the keys of the items shown with their times or comments. The
+// labels are made for the ticks in view when the axis is drawn, instead of
+// for every item up front, which takes a long time for large flows.
+class WSCPSeqItemTicker : public QCPAxisTicker
 {
-}
+public:
+    enum LabelType { TimeLabel, CommentLabel };
+
+    WSCPSeqItemTicker(const WSCPSeqItemVector *items, LabelType label_type) :
+        items_(items),
+        label_type_(label_type),
+        elide_w_(0)
+    {}
+
+    void setCommentFont(const QFont &font) {
+        comment_font_ = font;
+        elide_w_ = QFontMetrics(font).height() * max_comment_em_width_;
+    }
 
-WSCPSeqData::WSCPSeqData(double key, struct _seq_analysis_item *value) :
-  key(key),
-  value(value)
-{
-}
+protected:
+    virtual double getTickStep(const QCPRange &) Q_DECL_OVERRIDE { return 1.0; }
+    virtual int getSubTickCount(double) Q_DECL_OVERRIDE { return 0; }
+
+    virtual QString getTickLabel(double tick, const QLocale &, QChar, int) Q_DECL_OVERRIDE {
+        int key = qRound(tick);
+        if (key < 0 || key >= items_->size()) return QString();
+
+        const seq_analysis_item_t *sai = items_->at(key);
+        if (label_type_ == TimeLabel) {
+            return sai->time_str;
+        }
+        return QFontMetrics(comment_font_).elidedText(sai->comment, Qt::ElideRight, elide_w_);
+    }
+
+    // One tick per item in range, plus one on each side as
+    // QCPAxisTickerText does.
+    virtual QVector<double> createTickVector(double, const QCPRange &range) Q_DECL_OVERRIDE {
+        QVector<double> ticks;
+        if (items_->isEmpty()) return ticks;
+
+        int first = qMax(0, int(qFloor(range.lower)) - 1);
+        int last = qMin(items_->size() - 1, int(qCeil(range.upper)) + 1);
+        for (int key = first; key <= last; key++) {
+            ticks.append(key);
+        }
+        return ticks;
+    }
+
+private:
+    const WSCPSeqItemVector *items_;
+    LabelType label_type_;
+    QFont comment_font_;
+    int elide_w_;
+};
 
 SequenceDiagram::SequenceDiagram(QCPAxis *keyAxis, QCPAxis *valueAxis, QCPAxis *commentAxis) :
     QCPAbstractPlottable(keyAxis, valueAxis),
     key_axis_(keyAxis),
     value_axis_(valueAxis),
     comment_axis_(commentAxis),
-    data_(NULL),
+    items_sorted_(true),
     sainfo_(NULL),
     selected_packet_(0),
     selected_key_(-1.0)
 {
-    data_ = new WSCPSeqDataMap();
     // xaxis (value): Address
     // yaxis (key): Time
     // yaxis2 (comment): Extra info ("Comment" in GTK+)
@@ -59,7 +104,14 @@ SequenceDiagram::SequenceDiagram(QCPAxis *keyAxis, QCPAxis *valueAxis, QCPAxis *
     axes << value_axis_ << key_axis_ << comment_axis_;
     QPen no_pen(Qt::NoPen);
     foreach (QCPAxis *axis, axes) {
-        QSharedPointer<QCPAxisTicker> ticker(new QCPAxisTickerText);
+        QSharedPointer<QCPAxisTicker> ticker;
+        if (axis == key_axis_) {
+            ticker = QSharedPointer<QCPAxisTicker>(new WSCPSeqItemTicker(&items_, WSCPSeqItemTicker::TimeLabel));
+        } else if (axis == comment_axis_) {
+            ticker = QSharedPointer<QCPAxisTicker>(new WSCPSeqItemTicker(&items_, WSCPSeqItemTicker::CommentLabel));
+        } else {
+            ticker = QSharedPointer<QCPAxisTicker>(new QCPAxisTickerText);
+        }
         axis->setTicker(ticker);
         axis->setSubTickPen(no_pen);
         axis->setTickPen(no_pen);
@@ -88,85 +140,80 @@ SequenceDiagram::SequenceDiagram(QCPAxis *keyAxis, QCPAxis *valueAxis, QCPAxis *
 
 SequenceDiagram::~SequenceDiagram()
 {
-    delete data_;
 }
 
 int SequenceDiagram::adjacentPacket(bool next)
 {
-    int adjacent_packet = -1;
-    WSCPSeqDataMap::const_iterator it;
+    int key;
 
-    if (data_->size() < 1) return adjacent_packet;
+    if (items_.size() < 1) return -1;
 
     if (selected_packet_ < 1) {
-        if (next) {
-            it = data_->constBegin();
-        } else {
-            it = data_->constEnd();
-            --it;
-        }
-        selected_key_ = it.value().key;
-        return it.value().value->frame_number;
+        key = next ? 0 : items_.size() - 1;
+    } else {
+        key = keyForPacket(selected_packet_);
+        if (key < 0) return -1;
+        key += next ? 1 : -1;
+        if (key < 0 || key >= items_.size()) return -1;
     }
 
-    if (next) {
-        for (it = data_->constBegin(); it != data_->constEnd(); ++it) {
-            if (it.value().value->frame_number == selected_packet_) {
-                ++it;
-                if (it != data_->constEnd()) {
-                    adjacent_packet = it.value().value->frame_number;
-                    selected_key_ = it.value().key;
-                }
-                break;
-            }
-        }
-    } else {
-        it = data_->constEnd();
-        --it;
-        while (it != data_->constBegin()) {
-            guint32 prev_frame = it.value().value->frame_number;
-            --it;
-            if (prev_frame == selected_packet_) {
-                adjacent_packet = it.value().value->frame_number;
-                selected_key_ = it.value().key;
-                break;
-            }
+    selected_key_ = key;
+    return items_.at(key)->frame_number;
+}
+
+static bool itemFrameLessThan(const seq_analysis_item_t *sai, guint32 frame_number)
+{
+    return sai->frame_number < frame_number;
+}
+
+// Items are usually in frame order, so that we can bisect. Returns -1 if
+// no item is for the packet.
+int SequenceDiagram::keyForPacket(guint32 packet) const
+{
+    if (selected_key_ >= 0 && selected_key_ < items_.size()
+            && items_.at(int(selected_key_))->frame_number == packet) {
+        return int(selected_key_);
+    }
+
+    if (items_sorted_) {
+        WSCPSeqItemVector::const_iterator it = std::lower_bound(items_.constBegin(), items_.constEnd(), packet, itemFrameLessThan);
+        if (it != items_.constEnd() && (*it)->frame_number == packet) {
+            return int(it - items_.constBegin());
         }
+        return -1;
     }
 
-    return adjacent_packet;
+    for (int key = 0; key < items_.size(); key++) {
+        if (items_.at(key)->frame_number == packet) {
+            return key;
+        }
+    }
+    return -1;
 }
 
 void SequenceDiagram::setData(_seq_analysis_info *sainfo)
 {
-    data_->clear();
+    items_.clear();
+    items_sorted_ = true;
+    selected_key_ = -1;
     sainfo_ = sainfo;
     if (!sainfo) return;
 
-    double cur_key = 0.0;
-    QVector<double> key_ticks, val_ticks;
-    QVector<QString> key_labels, val_labels, com_labels;
-    QFontMetrics com_fm(comment_axis_->tickLabelFont());
-    int elide_w = com_fm.height() * max_comment_em_width_;
+    QVector<double> val_ticks;
+    QVector<QString> val_labels;
     char* addr_str;
 
+    items_.reserve(g_queue_get_length(sainfo->items));
     for (GList *cur = g_queue_peek_nth_link(sainfo->items, 0); cur; cur = gxx_list_next(cur)) {
         seq_analysis_item_t *sai = gxx_list_data(seq_analysis_item_t *, cur);
         if (sai->display) {
-            WSCPSeqData new_data;
-
-            new_data.key = cur_key;
-            new_data.value = sai;
-            data_->insert(new_data.key, new_data);
-
-            key_ticks.append(cur_key);
-            key_labels.append(sai->time_str);
-
-            com_labels.append(com_fm.elidedText(sai->comment, Qt::ElideRight, elide_w));
-
-            cur_key++;
+            if (!items_.isEmpty() && sai->frame_number < items_.last()->frame_number) {
+                items_sorted_ = false;
+            }
+            items_.append(sai);
         }
     }
+    items_.squeeze();
 
     for (unsigned int i = 0; i < sainfo_->num_nodes; i++) {
         val_ticks.append(i);
@@ -179,21 +226,20 @@ void SequenceDiagram::setData(_seq_analysis_info *sainfo)
         wmem_free(Q_NULLPTR, addr_str);
     }
 
-    QSharedPointer<QCPAxisTickerText> key_ticker = qSharedPointerCast<QCPAxisTickerText>(keyAxis()->ticker());
-    key_ticker->setTicks(key_ticks, key_labels);
     QSharedPointer<QCPAxisTickerText> value_ticker = qSharedPointerCast<QCPAxisTickerText>(valueAxis()->ticker());
     value_ticker->setTicks(val_ticks, val_labels);
-    QSharedPointer<QCPAxisTickerText> comment_ticker = qSharedPointerCast<QCPAxisTickerText>(comment_axis_->ticker());
-    comment_ticker->setTicks(key_ticks, com_labels);
+    QSharedPointer<WSCPSeqItemTicker> comment_ticker = qSharedPointerCast<WSCPSeqItemTicker>(comment_axis_->ticker());
+    comment_ticker->setCommentFont(comment_axis_->tickLabelFont());
 }
 
 void SequenceDiagram::setSelectedPacket(int selected_packet)
 {
-    selected_key_ = -1;
     if (selected_packet > 0) {
         selected_packet_ = selected_packet;
+        selected_key_ = keyForPacket(selected_packet_);
     } else {
         selected_packet_ = 0;
+        selected_key_ = -1;
     }
     mParentPlot->replot();
 }
@@ -202,8 +248,8 @@ _seq_analysis_item *SequenceDiagram::itemForPosY(int ypos)
 {
     double key_pos = qRound(key_axis_->pixelToCoord(ypos));
 
-    if (key_pos >= 0 && key_pos < data_->size()) {
-        return data_->value(key_pos).value;
+    if (key_pos >= 0 && key_pos < items_.size()) {
+        return items_.at(int(key_pos));
     }
     return NULL;
 }
@@ -212,7 +258,7 @@ double SequenceDiagram::selectTest(const QPointF &pos, bool, QVariant *) const
 {
     double key_pos = qRound(key_axis_->pixelToCoord(pos.y()));
 
-    if (key_pos >= 0 && key_pos < data_->size()) {
+    if (key_pos >= 0 && key_pos < items_.size()) {
         return 1.0;
     }
 
@@ -240,17 +286,18 @@ void SequenceDiagram::draw(QCPPainter *painter)
     painter->restore();
     fg_pen = pen();
 
-    WSCPSeqDataMap::const_iterator it;
-    for (it = data_->constBegin(); it != data_->constEnd(); ++it) {
-        double cur_key = it.key();
-        seq_analysis_item_t *sai = it.value().value;
+    // Only the items in view (and the ones half in view at the edges).
+    int first_key = qMax(0, int(qFloor(key_axis_->range().lower - 0.5)));
+    int last_key = qMin(items_.size() - 1, int(qCeil(key_axis_->range().upper + 0.5)));
+    for (int key = first_key; key <= last_key; key++) {
+        double cur_key = key;
+        seq_analysis_item_t *sai = items_.at(key);
         QColor bg_color;
 
         if (sai->frame_number == selected_packet_) {
             QPalette sel_pal;
             fg_pen.setColor(sel_pal.color(QPalette::HighlightedText));
             bg_color = sel_pal.color(QPalette::Highlight);
-            selected_key_ = cur_key;
         } else if ((sai->has_color_filter) && (recent.packet_list_colorize)) {
             fg_pen.setColor(QColor().fromRgb(sai->fg_color));
             bg_color = QColor().fromRgb(sai->bg_color);
@@ -366,18 +413,10 @@ QCPRange SequenceDiagram::getKeyRange(bool &validRange, QCP::SignDomain) const
     QCPRange range;
     bool valid = false;
 
-    WSCPSeqDataMap::const_iterator it = data_->constBegin();
-    while (it != data_->constEnd()) {
-        double cur_key = it.key();
-        if (!valid) {
-            range.lower = range.upper = cur_key;
-            valid = true;
-        } else if (cur_key < range.lower) {
-            range.lower = cur_key;
-        } else if (cur_key > range.upper) {
-            range.upper = cur_key;
-        }
-        ++it;
+    if (!items_.isEmpty()) {
+        range.lower = 0;
+        range.upper = items_.size() - 1;
+        valid = true;
     }
     validRange = valid;
     return range;
@@ -390,7 +429,7 @@ QCPRange SequenceDiagram::getValueRange(bool &validRange, QCP::SignDomain, const
 
     if (sainfo_) {
         range.lower = 0;
-        range.upper = data_->size();
+        range.upper = items_.size();
         valid = true;
     }
     validRange = valid;
@@ -17,23 +17,14 @@
 #include <epan/address.h>
 
 #include <QObject>
-#include <QMultiMap>
+#include <QVector>
 #include <ui/qt/widgets/qcustomplot.h>
 
 struct _seq_analysis_info;
 struct _seq_analysis_item;
 
-// Some of this is probably unnecessary
-class WSCPSeqData
-{
-public:
-  WSCPSeqData();
-  WSCPSeqData(double key, _seq_analysis_item *value);
-  double key;
-  struct _seq_analysis_item *value;
-};
-
-typedef QMultiMap<double, WSCPSeqData> WSCPSeqDataMap;
+// The items shown, in display order. An item's key is its index.
+typedef QVector<struct _seq_analysis_item *> WSCPSeqItemVector;
 
 class SequenceDiagram : public QCPAbstractPlottable
 {
@@ -55,7 +46,7 @@ public:
     struct _seq_analysis_item *itemForPosY(int ypos);
 
     // reimplemented virtual methods:
-    virtual void clearData() { data_->clear(); }
+    virtual void clearData() { items_.clear(); selected_key_ = -1; }
     virtual double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details=0) const Q_DECL_OVERRIDE;
 
 public slots:
@@ -71,10 +62,13 @@ private:
     QCPAxis *key_axis_;
     QCPAxis *value_axis_;
     QCPAxis *comment_axis_;
-    WSCPSeqDataMap *data_;
+    WSCPSeqItemVector items_;
+    bool items_sorted_;
     struct _seq_analysis_info *sainfo_;
     guint32 selected_packet_;
     double selected_key_;
+
+    int keyForPacket(guint32 packet) const;
 };
 
 #endif // SEQUENCE_DIAGRAM_H
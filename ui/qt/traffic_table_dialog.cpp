@@ -16,6 +16,8 @@
 
 #include "ui/recent.h"
 
+#include "frame_traffic_tables.h"
+
 #include "progress_frame.h"
 #include "wireshark_application.h"
 
@@ -214,9 +216,47 @@ void TrafficTableDialog::on_displayFilterCheckBox_toggled(bool checked)
         set_tap_dfilter(cur_tree->trafficTreeHash(), filter);
     }
 
+    if (fillTablesFromFile()) {
+        return;
+    }
+
+    for (int i = 0; i < ui->trafficTableTabWidget->count(); i++) {
+        TrafficTableTreeWidget *cur_tree = qobject_cast<TrafficTableTreeWidget *>(ui->trafficTableTabWidget->widget(i));
+        mark_tap_listener_for_retap(cur_tree->trafficTreeHash());
+    }
+
     cap_file_.retapPackets();
 }
 
+bool TrafficTableDialog::fillTablesFromFile(TrafficTableTreeWidget *tree)
+{
+    if (!cap_file_.isValid()) {
+        return false;
+    }
+
+    // Filtered views, and relative times that time references have
+    // changed since, need the packets.
+    capture_file *cf = cap_file_.capFile();
+    if (ui->displayFilterCheckBox->isChecked() || !filter_.isEmpty() ||
+            !cf->traffic_tables || cf->ref_time_count > 0 ||
+            frame_traffic_tables_frame_count(cf->traffic_tables) != cf->count) {
+        return false;
+    }
+
+    QList<TrafficTableTreeWidget *> trees;
+    if (tree) {
+        trees << tree;
+    } else {
+        trees = proto_id_to_tree_.values();
+    }
+    foreach (TrafficTableTreeWidget *cur_tree, trees) {
+        if (!cur_tree->fillFromFileTables(cf->traffic_tables)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void TrafficTableDialog::captureEvent(CaptureEvent e)
 {
     if (e.captureContext() == CaptureEvent::Retap)
@@ -263,6 +303,14 @@ void TrafficTableDialog::toggleTable()
     }
 
     if (new_table) {
+        // Only the new table needs the packets.
+        TrafficTableTreeWidget *new_tree = proto_id_to_tree_.value(proto_id);
+        if (new_tree && fillTablesFromFile(new_tree)) {
+            return;
+        }
+        if (new_tree) {
+            mark_tap_listener_for_retap(new_tree->trafficTreeHash());
+        }
         cap_file_.retapPackets();
     }
 }
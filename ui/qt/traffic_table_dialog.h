@@ -62,6 +62,9 @@ public slots:
     // Title string plus optional count
     const QString &trafficTreeTitle() { return title_; }
     conv_hash_t* trafficTreeHash() {return &hash_;}
+    // Fill the tree from the tables kept when the file was read instead
+    // of retapping. Returns false if they don't have our table.
+    virtual bool fillFromFileTables(const struct frame_traffic_tables *) { return false; }
 
 protected:
     register_ct_t* table_;
@@ -136,6 +139,11 @@ protected:
     virtual bool addTrafficTable(register_ct_t*) { return false; }
     void addProgressFrame(QObject *parent);
 
+    // Fill a tree, or all of them if tree is NULL, from the tables kept
+    // when the file was read, if they're for all of its packets and no
+    // filter applies. Returns false if the packets must be retapped.
+    bool fillTablesFromFile(TrafficTableTreeWidget *tree = NULL);
+
     // UI getters
     QDialogButtonBox *buttonBox() const;
     QTabWidget *trafficTableTabWidget() const;
@@ -42,8 +42,8 @@ Q_DECLARE_METATYPE(DataPrinter::DumpType)
 
 ByteViewText::ByteViewText(const QByteArray &data, packet_char_enc encoding, QWidget *parent) :
     QAbstractScrollArea(parent),
-    layout_(new QTextLayout()),
     data_(data),
+    line_cache_(max_cached_lines_),
     encoding_(encoding),
     hovered_byte_offset_(-1),
     marked_byte_offset_(-1),
@@ -60,8 +60,6 @@ ByteViewText::ByteViewText(const QByteArray &data, packet_char_enc encoding, QWi
     font_width_(0),
     line_height_(0)
 {
-    layout_->setCacheEnabled(true);
-
     offset_normal_fg_ = ColorUtils::alphaBlend(palette().windowText(), palette().window(), 0.35);
     offset_field_fg_ = ColorUtils::alphaBlend(palette().windowText(), palette().window(), 0.65);
 
@@ -77,7 +75,6 @@ ByteViewText::ByteViewText(const QByteArray &data, packet_char_enc encoding, QWi
 ByteViewText::~ByteViewText()
 {
     ctx_menu_.clear();
-    delete(layout_);
 }
 
 void ByteViewText::createContextMenu()
@@ -187,8 +184,8 @@ void ByteViewText::setMonospaceFont(const QFont &mono_font)
 
     setFont(int_font);
     viewport()->setFont(int_font);
-    layout_->setFont(int_font);
 
+    invalidateLines();
     updateLayoutMetrics();
 
     updateScrollbars();
@@ -199,6 +196,7 @@ void ByteViewText::updateByteViewSettings()
 {
     row_width_ = recent.gui_bytes_view == BYTES_HEX ? 16 : 8;
 
+    invalidateLines();
     updateContextMenu();
     updateScrollbars();
     viewport()->update();
@@ -236,7 +234,6 @@ void ByteViewText::paintEvent(QPaintEvent *)
     int leading = fontMetrics().leading();
     painter.save();
 
-    x_pos_to_column_.clear();
     while ((int) (row_y + line_height_) < widget_height && offset < (int) data_.count()) {
         drawLine(&painter, offset, row_y);
         offset += row_width_;
@@ -341,12 +338,28 @@ void ByteViewText::contextMenuEvent(QContextMenuEvent *event)
 // Private
 
 const int ByteViewText::separator_interval_ = DataPrinter::separatorInterval();
+// More than fit on any screen
+const int ByteViewText::max_cached_lines_ = 512;
 
 void ByteViewText::updateLayoutMetrics()
 {
-    font_width_  = stringWidth("M");
+    int font_width = stringWidth("M");
     // We might want to match ProtoTree::rowHeight.
-    line_height_ = fontMetrics().height();
+    int line_height = fontMetrics().height();
+
+    if (font_width != font_width_ || line_height != line_height_) {
+        invalidateLines();
+    }
+    font_width_  = font_width;
+    line_height_ = line_height;
+}
+
+// Forget the laid out lines, and the pixel to byte offset vector built
+// along with them, as they no longer look the way they should.
+void ByteViewText::invalidateLines()
+{
+    line_cache_.clear();
+    x_pos_to_column_.clear();
 }
 
 int ByteViewText::stringWidth(const QString &line)
@@ -358,12 +371,12 @@ int ByteViewText::stringWidth(const QString &line)
 #endif
 }
 
-// Draw a line of byte view text for a given offset.
-// Text highlighting is handled using QTextLayout::FormatRange.
-void ByteViewText::drawLine(QPainter *painter, const int offset, const int row_y)
+// Lay out a line of byte view text for a given offset, or find it laid out.
+ByteViewText::LineLayout *ByteViewText::lineLayout(const int offset)
 {
-    if (isEmpty()) {
-        return;
+    LineLayout *line_layout = line_cache_.object(offset);
+    if (line_layout) {
+        return line_layout;
     }
 
     // Build our pixel to byte offset vector the first time through.
@@ -376,8 +389,8 @@ void ByteViewText::drawLine(QPainter *painter, const int offset, const int row_y
         '0', '1', '2', '3', '4', '5', '6', '7',
         '8', '9', 'a', 'b', 'c', 'd', 'e', 'f' };
 
+    line_layout = new LineLayout;
     QString line;
-    HighlightMode offset_mode = ModeOffsetNormal;
 
     // Offset.
     if (show_offset_) {
@@ -402,7 +415,9 @@ void ByteViewText::drawLine(QPainter *painter, const int offset, const int row_y
             /* insert a space every separator_interval_ bytes */
             if ((tvb_pos != offset) && ((tvb_pos % separator_interval_) == 0)) {
                 line += ' ';
-                x_pos_to_column_ += QVector<int>().fill(tvb_pos - offset - 1, font_width_);
+                if (build_x_pos) {
+                    x_pos_to_column_ += QVector<int>().fill(tvb_pos - offset - 1, font_width_);
+                }
             }
 
             switch (recent.gui_bytes_view) {
@@ -420,24 +435,16 @@ void ByteViewText::drawLine(QPainter *painter, const int offset, const int row_y
             if (build_x_pos) {
                 x_pos_to_column_ += QVector<int>().fill(tvb_pos - offset, stringWidth(line) - x_pos_to_column_.size() + slop);
             }
-            if (tvb_pos == hovered_byte_offset_ || tvb_pos == marked_byte_offset_) {
-                int ho_len = recent.gui_bytes_view == BYTES_HEX ? 2 : 8;
-                QRect ho_rect = painter->boundingRect(QRect(), Qt::AlignHCenter|Qt::AlignVCenter, line.right(ho_len));
-                ho_rect.moveRight(stringWidth(line));
-                ho_rect.moveTop(row_y);
-                hover_outlines_.append(ho_rect);
-            }
+            int ho_len = recent.gui_bytes_view == BYTES_HEX ? 2 : 8;
+            QRect ho_rect = fontMetrics().boundingRect(QRect(), Qt::AlignHCenter|Qt::AlignVCenter, line.right(ho_len));
+            ho_rect.moveRight(stringWidth(line));
+            ho_rect.moveTop(0);
+            line_layout->hex_rects.append(ho_rect);
         }
         line += QString(ascii_start - line.length(), ' ');
         if (build_x_pos) {
             x_pos_to_column_ += QVector<int>().fill(-1, stringWidth(line) - x_pos_to_column_.size());
         }
-
-        addHexFormatRange(fmt_list, proto_start_, proto_len_, offset, max_tvb_pos, ModeProtocol);
-        if (addHexFormatRange(fmt_list, field_start_, field_len_, offset, max_tvb_pos, ModeField)) {
-            offset_mode = ModeOffsetField;
-        }
-        addHexFormatRange(fmt_list, field_a_start_, field_a_len_, offset, max_tvb_pos, ModeField);
     }
 
     // ASCII
@@ -481,16 +488,57 @@ void ByteViewText::drawLine(QPainter *painter, const int offset, const int row_y
             if (build_x_pos) {
                 x_pos_to_column_ += QVector<int>().fill(tvb_pos - offset, stringWidth(line) - x_pos_to_column_.size());
             }
-            if (tvb_pos == hovered_byte_offset_ || tvb_pos == marked_byte_offset_) {
-                QRect ho_rect = painter->boundingRect(QRect(), 0, line.right(1));
-                ho_rect.moveRight(stringWidth(line));
-                ho_rect.moveTop(row_y);
-                hover_outlines_.append(ho_rect);
-            }
+            QRect ho_rect = fontMetrics().boundingRect(QRect(), 0, line.right(1));
+            ho_rect.moveRight(stringWidth(line));
+            ho_rect.moveTop(0);
+            line_layout->ascii_rects.append(ho_rect);
         }
         if (in_non_printable) {
             addAsciiFormatRange(fmt_list, np_start, np_len, offset, max_tvb_pos, ModeNonPrintable);
         }
+    }
+
+    QTextLayout &layout = line_layout->layout;
+    layout.setCacheEnabled(true);
+    layout.setFont(viewport()->font());
+    layout.setText(line);
+    layout.setFormats(fmt_list.toVector());
+    layout.beginLayout();
+    QTextLine tl = layout.createLine();
+    tl.setLineWidth(totalPixels());
+    tl.setLeadingIncluded(true);
+    layout.endLayout();
+
+    line_cache_.insert(offset, line_layout);
+    return line_layout;
+}
+
+// Draw a line of byte view text for a given offset.
+// Text highlighting is handled using QTextLayout::FormatRange, drawn as
+// selections over the laid out line.
+void ByteViewText::drawLine(QPainter *painter, const int offset, const int row_y)
+{
+    if (isEmpty()) {
+        return;
+    }
+
+    LineLayout *line_layout = lineLayout(offset);
+    int tvb_len = data_.count();
+    int max_tvb_pos = qMin(offset + row_width_, tvb_len) - 1;
+    QList<QTextLayout::FormatRange> fmt_list;
+    HighlightMode offset_mode = ModeOffsetNormal;
+
+    // Hex
+    if (show_hex_) {
+        addHexFormatRange(fmt_list, proto_start_, proto_len_, offset, max_tvb_pos, ModeProtocol);
+        if (addHexFormatRange(fmt_list, field_start_, field_len_, offset, max_tvb_pos, ModeField)) {
+            offset_mode = ModeOffsetField;
+        }
+        addHexFormatRange(fmt_list, field_a_start_, field_a_len_, offset, max_tvb_pos, ModeField);
+    }
+
+    // ASCII
+    if (show_ascii_) {
         addAsciiFormatRange(fmt_list, proto_start_, proto_len_, offset, max_tvb_pos, ModeProtocol);
         if (addAsciiFormatRange(fmt_list, field_start_, field_len_, offset, max_tvb_pos, ModeField)) {
             offset_mode = ModeOffsetField;
@@ -501,16 +549,24 @@ void ByteViewText::drawLine(QPainter *painter, const int offset, const int row_y
     // XXX Fields won't be highlighted if neither hex nor ascii are enabled.
     addFormatRange(fmt_list, 0, offsetChars(), offset_mode);
 
-    layout_->clearLayout();
-    layout_->clearFormats();
-    layout_->setText(line);
-    layout_->setFormats(fmt_list.toVector());
-    layout_->beginLayout();
-    QTextLine tl = layout_->createLine();
-    tl.setLineWidth(totalPixels());
-    tl.setLeadingIncluded(true);
-    layout_->endLayout();
-    layout_->draw(painter, QPointF(0.0, row_y));
+    // Hover outlines
+    QList<int> ho_positions = QList<int>() << hovered_byte_offset_;
+    if (marked_byte_offset_ != hovered_byte_offset_) {
+        ho_positions << marked_byte_offset_;
+    }
+    foreach (int ho_pos, ho_positions) {
+        if (ho_pos < offset || ho_pos > max_tvb_pos) {
+            continue;
+        }
+        if (ho_pos - offset < line_layout->hex_rects.size()) {
+            hover_outlines_.append(line_layout->hex_rects[ho_pos - offset].translated(0, row_y));
+        }
+        if (ho_pos - offset < line_layout->ascii_rects.size()) {
+            hover_outlines_.append(line_layout->ascii_rects[ho_pos - offset].translated(0, row_y));
+        }
+    }
+
+    line_layout->layout.draw(painter, QPointF(0.0, row_y), fmt_list.toVector());
 }
 
 bool ByteViewText::addFormatRange(QList<QTextLayout::FormatRange> &fmt_list, int start, int length, HighlightMode mode)
@@ -15,6 +15,7 @@
 #include "ui/recent.h"
 
 #include <QAbstractScrollArea>
+#include <QCache>
 #include <QFont>
 #include <QVector>
 #include <QMenu>
@@ -74,11 +75,24 @@ private:
         ModeNonPrintable
     } HighlightMode;
 
-    QTextLayout *layout_;
+    // A line of text, laid out once and drawn each time it's shown.
+    // Highlighting and hover outlines depend on the marked and hovered
+    // bytes and are added when it's drawn.
+    struct LineLayout {
+        QTextLayout layout;
+        QVector<QRect> hex_rects;   // Outline of each byte in the hex view, ...
+        QVector<QRect> ascii_rects; // ...and in the ASCII view, at y = 0.
+    };
+
     const QByteArray data_;
+    // The lines last shown, by byte offset, so that producing the view
+    // costs the same however much data there is.
+    QCache<int, LineLayout> line_cache_;
 
     void updateLayoutMetrics();
+    void invalidateLines();
     int stringWidth(const QString &line);
+    LineLayout *lineLayout(const int offset);
     void drawLine(QPainter *painter, const int offset, const int row_y);
     bool addFormatRange(QList<QTextLayout::FormatRange> &fmt_list, int start, int length, HighlightMode mode);
     bool addHexFormatRange(QList<QTextLayout::FormatRange> &fmt_list, int mark_start, int mark_length, int tvb_offset, int max_tvb_pos, HighlightMode mode);
@@ -98,6 +112,7 @@ private:
     const QByteArray printableData() { return data_; }
 
     static const int separator_interval_;
+    static const int max_cached_lines_;
 
     // Colors
     QColor offset_normal_fg_;
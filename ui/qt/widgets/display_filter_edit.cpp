@@ -465,6 +465,29 @@ void DisplayFilterEdit::updateBookmarkMenu()
 // - Popup does not appear when text is selected.
 // - Recent and saved display filters in popup when editing first word.
 
+struct completion_fields_t {
+    QStringList *field_list;
+    int field_dots;
+    gsize field_len;
+};
+
+static void addCompletionField(gpointer data, gpointer user_data)
+{
+    header_field_info *hfinfo = static_cast<header_field_info *>(data);
+    completion_fields_t *fields = static_cast<completion_fields_t *>(user_data);
+
+    if (hfinfo->parent == -1) return; // Protocols and text items.
+    if ((gsize) strlen(hfinfo->abbrev) == fields->field_len) return;
+
+    protocol_t *protocol = find_protocol_by_id(hfinfo->parent);
+    if (!proto_is_protocol_enabled(protocol)) return;
+
+    const QString pfname = proto_get_protocol_filter_name(hfinfo->parent);
+    if (fields->field_dots > pfname.count('.')) {
+        *fields->field_list << hfinfo->abbrev;
+    }
+}
+
 // ui/gtk/filter_autocomplete.c:build_autocompletion_list
 void DisplayFilterEdit::buildCompletionList(const QString &field_word)
 {
@@ -520,24 +543,16 @@ void DisplayFilterEdit::buildCompletionList(const QString &field_word)
         protocol_t *protocol = find_protocol_by_id(proto_id);
         if (!proto_is_protocol_enabled(protocol)) continue;
 
-        const QString pfname = proto_get_protocol_filter_name(proto_id);
-        field_list << pfname;
-
-        // Add fields only if we're past the protocol name and only for the
-        // current protocol.
-        if (field_dots > pfname.count('.')) {
-            void *field_cookie;
-            const QByteArray fw_ba = field_word.toUtf8(); // or toLatin1 or toStdString?
-            const char *fw_utf8 = fw_ba.constData();
-            gsize fw_len = (gsize) strlen(fw_utf8);
-            for (header_field_info *hfinfo = proto_get_first_protocol_field(proto_id, &field_cookie); hfinfo; hfinfo = proto_get_next_protocol_field(proto_id, &field_cookie)) {
-                if (hfinfo->same_name_prev_id != -1) continue; // Ignore duplicate names.
-
-                if (!g_ascii_strncasecmp(fw_utf8, hfinfo->abbrev, fw_len)) {
-                    if ((gsize) strlen(hfinfo->abbrev) != fw_len) field_list << hfinfo->abbrev;
-                }
-            }
-        }
+        field_list << proto_get_protocol_filter_name(proto_id);
+    }
+
+    // Add fields only if we're past the protocol name and only for the
+    // current protocol.
+    if (field_dots > 0) {
+        const QByteArray fw_ba = field_word.toUtf8(); // or toLatin1 or toStdString?
+        completion_fields_t fields = { &field_list, field_dots, (gsize) fw_ba.length() };
+
+        proto_registrar_foreach_prefix(fw_ba.constData(), addCompletionField, &fields);
     }
     field_list.sort();
 
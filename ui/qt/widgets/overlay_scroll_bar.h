@@ -40,8 +40,8 @@ public:
 
     /** Set the "far" overlay image.
      * @param mp_image An image showing the position of marked, ignored,
-     *        and reference time packets over the entire packet list. It
-     *        should be sized in device pixels.
+     *        and reference time packets, and the packet colors, over the
+     *        entire packet list. It should be sized in device pixels.
      */
     void setMarkedPacketImage(QImage &mp_image);
 
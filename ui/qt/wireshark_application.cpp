@@ -808,6 +808,9 @@ void WiresharkApplication::emitAppSignal(AppSignal signal)
     case PreferencesChanged:
         emit preferencesChanged();
         break;
+    case PacketDisplayChanged:
+        emit packetDisplayChanged();
+        break;
     case PacketDissectionChanged:
         emit packetDissectionChanged();
         break;
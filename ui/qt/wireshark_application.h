@@ -60,6 +60,7 @@ public:
         FilterExpressionsChanged,
         LocalInterfacesChanged,
         NameResolutionChanged,
+        PacketDisplayChanged,
         PacketDissectionChanged,
         PreferencesChanged,
         ProfileChanging,
@@ -185,6 +186,7 @@ signals:
     void captureFilterListChanged();
     void displayFilterListChanged();
     void filterExpressionsChanged();
+    void packetDisplayChanged();
     void packetDissectionChanged();
     void preferencesChanged();
     void addressResolutionChanged();
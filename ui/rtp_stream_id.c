@@ -88,6 +88,19 @@ gboolean rtpstream_id_equal(const rtpstream_id_t *id1, const rtpstream_id_t *id2
 	return FALSE;
 }
 
+/****************************************************************************/
+/* hash an id, including its ssrc */
+guint rtpstream_id_hash(const rtpstream_id_t *id)
+{
+    guint hash;
+
+    hash = add_address_to_hash(id->ssrc, &(id->src_addr));
+    hash = add_address_to_hash(hash, &(id->dst_addr));
+    hash ^= id->src_port | (id->dst_port << 16);
+
+    return hash;
+}
+
 /****************************************************************************/
 /* compare two ids, one in pinfo */
 gboolean rtpstream_id_equal_pinfo_rtp_info(const rtpstream_id_t *id, const packet_info *pinfo, const struct _rtp_info *rtp_info)
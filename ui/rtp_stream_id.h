@@ -63,6 +63,12 @@ void rtpstream_id_free(rtpstream_id_t *id);
 #define RTPSTREAM_ID_EQUAL_SSRC		0x0001
 gboolean rtpstream_id_equal(const rtpstream_id_t *id1, const rtpstream_id_t *id2, guint flags);
 
+/**
+ * Calculate a hash of rtpstream_id_t, consistent with
+ * rtpstream_id_equal(..., RTPSTREAM_ID_EQUAL_SSRC)
+ */
+guint rtpstream_id_hash(const rtpstream_id_t *id);
+
 /**
  * Check if rtpstream_id_t is equal to pinfo
  * - compare src_addr, dest_addr, src_port, dest_port with pinfo
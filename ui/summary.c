@@ -17,6 +17,8 @@
 #include <wsutil/file_util.h>
 #include <wsutil/wsgcrypt.h>
 #include "cfile.h"
+#include "file.h"
+#include "frame_record_cache.h"
 #include "ui/summary.h"
 
 // Strongest to weakest
@@ -26,74 +28,6 @@
 
 #define HASH_BUF_SIZE (1024 * 1024)
 
-static void
-tally_frame_data(frame_data *cur_frame, summary_tally *sum_tally)
-{
-    double cur_time;
-
-    sum_tally->bytes += cur_frame->pkt_len;
-    if (cur_frame->passed_dfilter){
-        sum_tally->filtered_count++;
-        sum_tally->filtered_bytes += cur_frame->pkt_len;
-    }
-    if (cur_frame->marked){
-        sum_tally->marked_count++;
-        sum_tally->marked_bytes += cur_frame->pkt_len;
-    }
-    if (cur_frame->ignored){
-        sum_tally->ignored_count++;
-    }
-
-    if (cur_frame->has_ts) {
-        /* This packet has a time stamp. */
-        cur_time = nstime_to_sec(&cur_frame->abs_ts);
-
-        sum_tally->packet_count_ts++;
-        if (cur_time < sum_tally->start_time) {
-            sum_tally->start_time = cur_time;
-        }
-        if (cur_time > sum_tally->stop_time){
-            sum_tally->stop_time = cur_time;
-        }
-        if (cur_frame->passed_dfilter){
-            sum_tally->filtered_count_ts++;
-            /*
-             * If we've seen one filtered packet, this is the first
-             * one.
-             */
-            if (sum_tally->filtered_count == 1){
-                sum_tally->filtered_start= cur_time;
-                sum_tally->filtered_stop = cur_time;
-            } else {
-                if (cur_time < sum_tally->filtered_start) {
-                    sum_tally->filtered_start = cur_time;
-                }
-                if (cur_time > sum_tally->filtered_stop) {
-                    sum_tally->filtered_stop = cur_time;
-                }
-            }
-        }
-        if (cur_frame->marked){
-            sum_tally->marked_count_ts++;
-            /*
-             * If we've seen one marked packet, this is the first
-             * one.
-             */
-            if (sum_tally->marked_count == 1){
-                sum_tally->marked_start= cur_time;
-                sum_tally->marked_stop = cur_time;
-            } else {
-                if (cur_time < sum_tally->marked_start) {
-                    sum_tally->marked_start = cur_time;
-                }
-                if (cur_time > sum_tally->marked_stop) {
-                    sum_tally->marked_stop = cur_time;
-                }
-            }
-        }
-    }
-}
-
 static void
 hash_to_str(const unsigned char *hash, size_t length, char *str) {
   int i;
@@ -106,8 +40,8 @@ hash_to_str(const unsigned char *hash, size_t length, char *str) {
 void
 summary_fill_in(capture_file *cf, summary_tally *st)
 {
-    frame_data    *first_frame, *cur_frame;
-    guint32        framenum;
+    frame_data    *first_frame;
+    frame_totals_t all, filtered, marked;
     iface_summary_info iface;
     guint i;
     wtapng_iface_descriptions_t* idb_info;
@@ -123,34 +57,44 @@ summary_fill_in(capture_file *cf, summary_tally *st)
     gcry_md_hd_t hd;
     size_t hash_bytes;
 
-    st->packet_count_ts = 0;
+    /* The totals are kept as the frames are read, marked and filtered. */
+    cf_get_frame_totals(cf, &all, &filtered, &marked);
+
+    st->bytes = all.bytes;
+    st->packet_count_ts = all.count_ts;
     st->start_time = 0;
     st->stop_time = 0;
-    st->bytes = 0;
-    st->filtered_count = 0;
-    st->filtered_count_ts = 0;
-    st->filtered_start = 0;
-    st->filtered_stop = 0;
-    st->filtered_bytes = 0;
-    st->marked_count = 0;
-    st->marked_count_ts = 0;
-    st->marked_start = 0;
-    st->marked_stop = 0;
-    st->marked_bytes = 0;
-    st->ignored_count = 0;
-
-    /* initialize the tally */
-    if (cf->count != 0) {
+    if (all.count_ts != 0) {
+        st->start_time = nstime_to_sec(&all.start);
+        st->stop_time = nstime_to_sec(&all.stop);
+    } else if (cf->count != 0) {
         first_frame = frame_data_sequence_find(cf->provider.frames, 1);
         st->start_time = nstime_to_sec(&first_frame->abs_ts);
         st->stop_time = nstime_to_sec(&first_frame->abs_ts);
+    }
 
-        for (framenum = 1; framenum <= cf->count; framenum++) {
-            cur_frame = frame_data_sequence_find(cf->provider.frames, framenum);
-            tally_frame_data(cur_frame, st);
-        }
+    st->filtered_count = filtered.count;
+    st->filtered_count_ts = filtered.count_ts;
+    st->filtered_bytes = filtered.bytes;
+    st->filtered_start = 0;
+    st->filtered_stop = 0;
+    if (filtered.count_ts != 0) {
+        st->filtered_start = nstime_to_sec(&filtered.start);
+        st->filtered_stop = nstime_to_sec(&filtered.stop);
+    }
+
+    st->marked_count = marked.count;
+    st->marked_count_ts = marked.count_ts;
+    st->marked_bytes = marked.bytes;
+    st->marked_start = 0;
+    st->marked_stop = 0;
+    if (marked.count_ts != 0) {
+        st->marked_start = nstime_to_sec(&marked.start);
+        st->marked_stop = nstime_to_sec(&marked.stop);
     }
 
+    st->ignored_count = cf->ignored_count;
+
     st->filename = cf->filename;
     st->file_length = cf->f_datalen;
     st->file_type = cf->cd_t;
@@ -164,6 +108,8 @@ summary_fill_in(capture_file *cf, summary_tally *st)
     st->drops_known = cf->drops_known;
     st->drops = cf->drops;
     st->dfilter = cf->dfilter;
+    frame_record_cache_get_stats(cf->provider.record_cache,
+                                 &st->record_cache_hits, &st->record_cache_misses);
 
     st->ifaces  = g_array_new(FALSE, FALSE, sizeof(iface_summary_info));
     idb_info = wtap_file_get_idb_info(cf->provider.wth);
@@ -65,6 +65,8 @@ typedef struct _summary_tally {
     gboolean              drops_known;        /**< TRUE if number of packet drops is known */
     guint64               drops;              /**< number of packet drops */
     const char           *dfilter;            /**< display filter */
+    guint64               record_cache_hits;  /**< reads of records found in the record cache */
+    guint64               record_cache_misses; /**< reads of records not found in it */
     gboolean              is_tempfile;
     /* capture related, use summary_fill_in_capture() to get values */
     GArray               *ifaces;
@@ -122,6 +122,18 @@ gint rtpstream_info_cmp(gconstpointer aa, gconstpointer bb)
         return 1;
 }
 
+/****************************************************************************/
+/* GHashFunc and GEqualFunc for the ids of the streams in strinfo_hash */
+static guint rtpstream_info_id_hash(gconstpointer key)
+{
+    return rtpstream_id_hash((const rtpstream_id_t *)key);
+}
+
+static gboolean rtpstream_info_id_equal(gconstpointer a, gconstpointer b)
+{
+    return rtpstream_id_equal((const rtpstream_id_t *)a, (const rtpstream_id_t *)b, RTPSTREAM_ID_EQUAL_SSRC);
+}
+
 /****************************************************************************/
 /* compare the endpoints of two RTP streams */
 gboolean rtpstream_info_is_reverse(const rtpstream_info_t *stream_a, rtpstream_info_t *stream_b)
@@ -157,6 +169,10 @@ void rtpstream_reset(rtpstream_tapinfo_t *tapinfo)
         }
         g_list_free(tapinfo->strinfo_list);
         tapinfo->strinfo_list = NULL;
+        if (tapinfo->strinfo_hash) {
+            g_hash_table_destroy(tapinfo->strinfo_hash);
+            tapinfo->strinfo_hash = NULL;
+        }
         tapinfo->nstreams = 0;
         tapinfo->npackets = 0;
     }
@@ -366,7 +382,6 @@ tap_packet_status rtpstream_packet_cb(void *arg, packet_info *pinfo, epan_dissec
     const struct _rtp_info *rtpinfo = (const struct _rtp_info *)arg2;
     rtpstream_info_t new_stream_info;
     rtpstream_info_t *stream_info = NULL;
-    GList* list;
     rtpdump_info_t rtpdump_info;
 
     struct _rtp_conversation_info *p_conv_data = NULL;
@@ -386,16 +401,10 @@ tap_packet_status rtpstream_packet_cb(void *arg, packet_info *pinfo, epan_dissec
         }
 
         /* check whether we already have a stream with these parameters in the list */
-        list = g_list_first(tapinfo->strinfo_list);
-        while (list)
-        {
-            if (rtpstream_info_cmp(&new_stream_info, (rtpstream_info_t *)(list->data))==0)
-            {
-                stream_info = (rtpstream_info_t *)(list->data);  /*found!*/
-                break;
-            }
-            list = g_list_next(list);
+        if (!tapinfo->strinfo_hash) {
+            tapinfo->strinfo_hash = g_hash_table_new(rtpstream_info_id_hash, rtpstream_info_id_equal);
         }
+        stream_info = (rtpstream_info_t *)g_hash_table_lookup(tapinfo->strinfo_hash, &new_stream_info.id);
 
         /* not in the list? then create a new entry */
         if (!stream_info) {
@@ -419,6 +428,7 @@ tap_packet_status rtpstream_packet_cb(void *arg, packet_info *pinfo, epan_dissec
             stream_info = rtpstream_info_malloc_and_init();
             rtpstream_info_copy_deep(stream_info, &new_stream_info);
             tapinfo->strinfo_list = g_list_prepend(tapinfo->strinfo_list, stream_info);
+            g_hash_table_insert(tapinfo->strinfo_hash, &stream_info->id, stream_info);
         }
 
         /* get RTP stats for the packet */
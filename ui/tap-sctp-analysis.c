@@ -37,6 +37,12 @@
 
 static sctp_allassocs_info_t sctp_tapinfo_struct = {0, NULL, FALSE, NULL};
 
+/* The associations of sctp_tapinfo_struct by assoc_id, and the last
+ * element of its list, so that neither finding the association of a
+ * packet nor adding one goes through them all. */
+static GHashTable *assoc_table = NULL;
+static GList *assoc_info_list_last = NULL;
+
 static void
 free_first(gpointer data, gpointer user_data _U_)
 {
@@ -169,6 +175,9 @@ reset(void *arg)
     g_list_free(tapdata->assoc_info_list);
     tapdata->sum_tvbs = 0;
     tapdata->assoc_info_list = NULL;
+    assoc_info_list_last = NULL;
+    if (assoc_table != NULL)
+        g_hash_table_remove_all(assoc_table);
 }
 
 
@@ -226,23 +235,26 @@ calc_checksum(const struct _sctp_info *check_data, sctp_assoc_info_t *data)
 static sctp_assoc_info_t *
 find_assoc(sctp_tmp_info_t *needle)
 {
-    sctp_allassocs_info_t *assoc_info;
-    sctp_assoc_info_t *info = NULL;
-    GList* list;
+    if (assoc_table == NULL)
+        return NULL;
 
-    assoc_info = &sctp_tapinfo_struct;
-    if ((list = g_list_last(assoc_info->assoc_info_list))!=NULL)
-    {
-        while (list)
-        {
-            info = (sctp_assoc_info_t*)(list->data);
-            if (needle->assoc_id == info->assoc_id)
-                return info;
+    return (sctp_assoc_info_t *)g_hash_table_lookup(assoc_table, GUINT_TO_POINTER(needle->assoc_id));
+}
 
-            list = g_list_previous(list);
-        }
-    }
-    return NULL;
+static void
+add_assoc(sctp_assoc_info_t *info)
+{
+    if (assoc_table == NULL)
+        assoc_table = g_hash_table_new(g_direct_hash, g_direct_equal);
+    g_hash_table_insert(assoc_table, GUINT_TO_POINTER(info->assoc_id), info);
+
+    /* g_list_append() returns the list it's given, with the new element
+     * after its last one. */
+    assoc_info_list_last = g_list_append(assoc_info_list_last, info);
+    if (sctp_tapinfo_struct.assoc_info_list == NULL)
+        sctp_tapinfo_struct.assoc_info_list = assoc_info_list_last;
+    else
+        assoc_info_list_last = assoc_info_list_last->next;
 }
 
 static sctp_assoc_info_t *
@@ -732,7 +744,7 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
                     info->sack2 = g_list_prepend(info->sack2, sack);
                     sack_used = TRUE;
                 }
-                sctp_tapinfo_struct.assoc_info_list = g_list_append(sctp_tapinfo_struct.assoc_info_list, info);
+                add_assoc(info);
             }
             else
             {
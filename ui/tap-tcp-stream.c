@@ -98,12 +98,69 @@ tapall_tcpip_packet(void *pct, packet_info *pinfo, epan_dissect_t *edt _U_, cons
     return TAP_PACKET_DONT_REDRAW;
 }
 
+/* Make the segment list out of the headers TCP recorded on the first pass */
+static void
+graph_segment_list_from_recorded(struct tcp_graph *tg, const tcp_graph_segments_t *recorded)
+{
+    struct segment *last = NULL;
+    guint count, i;
+
+    if (tg->src_address.type == AT_NONE || tg->dst_address.type == AT_NONE) {
+        /* As in tapall_tcpip_packet() */
+        copy_address(&tg->src_address, &recorded->dst_address);
+        tg->src_port = recorded->dst_port;
+        copy_address(&tg->dst_address, &recorded->src_address);
+        tg->dst_port = recorded->src_port;
+    }
+
+    count = wmem_array_get_count(recorded->segments);
+    for (i = 0; i < count; i++) {
+        const tcp_graph_segment_t *rec = (const tcp_graph_segment_t *)wmem_array_index(recorded->segments, i);
+        struct segment *segment = g_new(struct segment, 1);
+
+        segment->next      = NULL;
+        segment->num       = rec->num;
+        segment->rel_secs  = rec->rel_secs;
+        segment->rel_usecs = rec->rel_usecs;
+        segment->th_seq    = rec->th_seq;
+        segment->th_ack    = rec->th_ack;
+        segment->th_win    = rec->th_win;
+        segment->th_flags  = rec->th_flags;
+        segment->th_seglen = rec->th_seglen;
+        if (rec->from_dst) {
+            segment->th_sport = recorded->dst_port;
+            segment->th_dport = recorded->src_port;
+            copy_address(&segment->ip_src, &recorded->dst_address);
+            copy_address(&segment->ip_dst, &recorded->src_address);
+        } else {
+            segment->th_sport = recorded->src_port;
+            segment->th_dport = recorded->dst_port;
+            copy_address(&segment->ip_src, &recorded->src_address);
+            copy_address(&segment->ip_dst, &recorded->dst_address);
+        }
+
+        segment->num_sack_ranges = rec->num_sack_ranges;
+        for (guint8 n = 0; n < rec->num_sack_ranges; n++) {
+            segment->sack_left_edge[n] = *(const guint32 *)wmem_array_index(recorded->sack_edges, 2 * (rec->first_sack + n));
+            segment->sack_right_edge[n] = *(const guint32 *)wmem_array_index(recorded->sack_edges, 2 * (rec->first_sack + n) + 1);
+        }
+
+        if (last) {
+            last->next = segment;
+        } else {
+            tg->segments = segment;
+        }
+        last = segment;
+    }
+}
+
 /* here we collect all the external data we will ever need */
 void
 graph_segment_list_get(capture_file *cf, struct tcp_graph *tg)
 {
     GString    *error_string;
     tcp_scan_t  ts;
+    const tcp_graph_segments_t *recorded;
 
     g_log(NULL, G_LOG_LEVEL_DEBUG, "graph_segment_list_get()");
 
@@ -111,6 +168,13 @@ graph_segment_list_get(capture_file *cf, struct tcp_graph *tg)
         return;
     }
 
+    /* TCP keeps the headers of the segments of each stream, unless told not to */
+    recorded = tcp_get_graph_segments(tg->stream);
+    if (recorded) {
+        graph_segment_list_from_recorded(tg, recorded);
+        return;
+    }
+
     /* rescan all the packets and pick up all interesting tcp headers.
      * we only filter for TCP here for speed and do the actual compare
      * in the tap listener
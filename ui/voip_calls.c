@@ -293,6 +293,10 @@ voip_calls_reset_all_taps(voip_calls_tapinfo_t *tapinfo)
     }
     g_list_free(tapinfo->rtpstream_list);
     tapinfo->rtpstream_list = NULL;
+    if (tapinfo->rtpstream_hash) {
+        g_hash_table_destroy(tapinfo->rtpstream_hash);
+        tapinfo->rtpstream_hash = NULL;
+    }
 
     if (tapinfo->h245_labels) {
         memset(tapinfo->h245_labels, 0, sizeof(h245_labels_t));
@@ -586,6 +590,10 @@ rtp_reset(void *tap_offset_ptr)
     }
     g_list_free(tapinfo->rtpstream_list);
     tapinfo->rtpstream_list = NULL;
+    if (tapinfo->rtpstream_hash) {
+        g_hash_table_destroy(tapinfo->rtpstream_hash);
+        tapinfo->rtpstream_hash = NULL;
+    }
     tapinfo->nrtpstreams = 0;
 
     // Do not touch graph_analysis, it is handled by caller
@@ -605,7 +613,8 @@ rtp_packet(void *tap_offset_ptr, packet_info *pinfo, epan_dissect_t *edt, void c
     voip_calls_tapinfo_t *tapinfo = tap_id_to_base(tap_offset_ptr, tap_id_offset_rtp_);
     rtpstream_info_t    *tmp_listinfo;
     rtpstream_info_t    *strinfo = NULL;
-    GList                *list;
+    gint64               stream_key;
+    gint64              *new_stream_key;
     struct _rtp_conversation_info *p_conv_data = NULL;
 
     const struct _rtp_info *rtp_info = (const struct _rtp_info *)rtp_info_ptr;
@@ -624,31 +633,29 @@ rtp_packet(void *tap_offset_ptr, packet_info *pinfo, epan_dissect_t *edt, void c
         tapinfo->tap_packet(tapinfo, pinfo, edt, rtp_info_ptr);
     }
 
-    /* check whether we already have a RTP stream with this setup frame and ssrc in the list */
-    list = g_list_first(tapinfo->rtpstream_list);
-    while (list)
-    {
-        tmp_listinfo=(rtpstream_info_t *)list->data;
-        if ( (tmp_listinfo->setup_frame_number == rtp_info->info_setup_frame_num)
-                && (tmp_listinfo->id.ssrc == rtp_info->info_sync_src) && (tmp_listinfo->end_stream == FALSE)) {
-            /* if the payload type has changed, we mark the stream as finished to create a new one
-               this is to show multiple payload changes in the Graph for example for DTMF RFC2833 */
-            if ( tmp_listinfo->first_payload_type != rtp_info->info_payload_type ) {
-                tmp_listinfo->end_stream = TRUE;
-            } else if ( ( ( tmp_listinfo->ed137_info == NULL ) && (rtp_info->info_ed137_info != NULL) ) ||
-                        ( ( tmp_listinfo->ed137_info != NULL ) && (rtp_info->info_ed137_info == NULL) ) ||
-                        ( ( tmp_listinfo->ed137_info != NULL ) && (rtp_info->info_ed137_info != NULL) &&
-                          ( 0!=strcmp(tmp_listinfo->ed137_info, rtp_info->info_ed137_info) )
-                        )
-                      ) {
-            /* if ed137_info has changed, create new stream */
-                tmp_listinfo->end_stream = TRUE;
-            } else {
-                strinfo = (rtpstream_info_t*)(list->data);
-                break;
-            }
+    /* check whether we already have a RTP stream with this setup frame and ssrc in the list;
+       only the last one created for them can be not ended yet */
+    if (!tapinfo->rtpstream_hash) {
+        tapinfo->rtpstream_hash = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, NULL);
+    }
+    stream_key = ((gint64)rtp_info->info_setup_frame_num << 32) | rtp_info->info_sync_src;
+    tmp_listinfo = (rtpstream_info_t *)g_hash_table_lookup(tapinfo->rtpstream_hash, &stream_key);
+    if (tmp_listinfo && (tmp_listinfo->end_stream == FALSE)) {
+        /* if the payload type has changed, we mark the stream as finished to create a new one
+           this is to show multiple payload changes in the Graph for example for DTMF RFC2833 */
+        if ( tmp_listinfo->first_payload_type != rtp_info->info_payload_type ) {
+            tmp_listinfo->end_stream = TRUE;
+        } else if ( ( ( tmp_listinfo->ed137_info == NULL ) && (rtp_info->info_ed137_info != NULL) ) ||
+                    ( ( tmp_listinfo->ed137_info != NULL ) && (rtp_info->info_ed137_info == NULL) ) ||
+                    ( ( tmp_listinfo->ed137_info != NULL ) && (rtp_info->info_ed137_info != NULL) &&
+                      ( 0!=strcmp(tmp_listinfo->ed137_info, rtp_info->info_ed137_info) )
+                    )
+                  ) {
+        /* if ed137_info has changed, create new stream */
+            tmp_listinfo->end_stream = TRUE;
+        } else {
+            strinfo = tmp_listinfo;
         }
-        list = g_list_next(list);
     }
 
     /* if this is a duplicated RTP Event End, just return */
@@ -689,6 +696,9 @@ rtp_packet(void *tap_offset_ptr, packet_info *pinfo, epan_dissect_t *edt, void c
             strinfo->ed137_info = NULL;
         }
         tapinfo->rtpstream_list = g_list_prepend(tapinfo->rtpstream_list, strinfo);
+        new_stream_key = g_new(gint64, 1);
+        *new_stream_key = stream_key;
+        g_hash_table_replace(tapinfo->rtpstream_hash, new_stream_key, strinfo);
     }
 
     /* Add the info to the existing RTP stream */
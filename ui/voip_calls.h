@@ -218,6 +218,7 @@ typedef struct _voip_calls_tapinfo {
     flow_show_options     fs_option;
     guint32               redraw;
     gboolean              apply_display_filter;
+    GHashTable*           rtpstream_hash; /**< streams of rtpstream_list not ended yet, by setup frame and SSRC */
 } voip_calls_tapinfo_t;
 
 #if 0
@@ -66,6 +66,7 @@ void packet_list_recolor_packets(void);
 void packet_list_queue_draw(void);
 void packet_list_select_first_row(void);
 void packet_list_moveto_end(void);
+void packet_list_schedule_refilter(void);
 gboolean packet_list_select_row_from_data(frame_data *fdata_needle);
 void packet_list_resize_column(gint col);
 gboolean packet_list_multi_select_active(void);
@@ -14,7 +14,9 @@
 #include <errno.h>
 
 #include <wsutil/file_util.h>
+#include <wsutil/strtoi.h>
 #include <wsutil/tempfile.h>
+#include <wsutil/stream_compress.h>
 #ifdef HAVE_PLUGINS
 #include <wsutil/plugins.h>
 #endif
@@ -157,7 +159,7 @@ static const struct file_extension_info file_type_extensions_base[] = {
 	{ "MPEG files", FALSE, "mpg;mp3" },
 	{ "Transport-Neutral Encapsulation Format", FALSE, "tnef" },
 	{ "JPEG/JFIF files", FALSE, "jpg;jpeg;jfif" },
-	{ "JavaScript Object Notation file", FALSE, "json" },
+	{ "JavaScript Object Notation file", FALSE, "json;ndjson;jsonl" },
 	{ "MP4 file", FALSE, "mp4" },
 };
 
@@ -433,7 +435,7 @@ static const struct open_info open_info_base[] = {
 	/* Extremely weak heuristics - put them at the end. */
 	{ "Ixia IxVeriWave .vwr Raw Capture",       OPEN_INFO_HEURISTIC, vwr_open,                 "vwr",      NULL, NULL },
 	{ "CAM Inspector file",                     OPEN_INFO_HEURISTIC, camins_open,              "camins",   NULL, NULL },
-	{ "JavaScript Object Notation",             OPEN_INFO_HEURISTIC, json_open,                "json",     NULL, NULL },
+	{ "JavaScript Object Notation",             OPEN_INFO_HEURISTIC, json_open,                "json;ndjson;jsonl", NULL, NULL },
 	{ "Ruby Marshal Object",                    OPEN_INFO_HEURISTIC, ruby_marshal_open,        "",         NULL, NULL },
 	{ "Systemd Journal",                        OPEN_INFO_HEURISTIC, systemd_journal_open,     "log;jnl;journal",      NULL, NULL },
 	{ "3gpp phone log",                         OPEN_INFO_MAGIC,     log3gpp_open,             "log",      NULL, NULL },
@@ -743,6 +745,29 @@ heuristic_uses_extension(unsigned int i, const char *extension)
 	return FALSE;	/* it's not one of them */
 }
 
+/*
+ * The size of the chunks wtap_open_offline() reads ahead in, from the
+ * WIRESHARK_READ_AHEAD environment variable, in megabytes; 0 if it
+ * isn't set.
+ */
+static guint
+default_read_ahead_size(void)
+{
+	static gsize initialized = 0;
+	static guint size = 0;
+
+	if (g_once_init_enter(&initialized)) {
+		const char *env = g_getenv("WIRESHARK_READ_AHEAD");
+		guint32 megabytes;
+
+		if (env != NULL && ws_strtou32(env, NULL, &megabytes) &&
+		    megabytes > 0 && megabytes <= 1024)
+			size = megabytes * 1024 * 1024;
+		g_once_init_leave(&initialized, 1);
+	}
+	return size;
+}
+
 /* Opens a file and prepares a wtap struct.
    If "do_random" is TRUE, it opens the file twice; the second open
    allows the application to do random-access I/O without moving
@@ -1150,6 +1175,9 @@ fail:
 	return NULL;
 
 success:
+	/* Reading ahead only pays once the file's being read through. */
+	if (default_read_ahead_size() != 0)
+		file_set_read_ahead(wth->fh, default_read_ahead_size());
 	return wth;
 }
 
@@ -1170,6 +1198,17 @@ wtap_fdreopen(wtap *wth, const char *filename, int *err)
 {
 	ws_statb64 statb;
 
+	if (wth->members != NULL) {
+		/* Reopen the files a virtual file is read from. */
+		for (guint i = 0; i < wth->members->len; i++) {
+			wtap *member = (wtap *)g_ptr_array_index(wth->members, i);
+
+			if (!wtap_fdreopen(member, member->pathname, err))
+				return FALSE;
+		}
+		return TRUE;
+	}
+
 	/*
 	 * We need two independent descriptors for random access, so
 	 * they have different file positions.  If we're opening the
@@ -2162,6 +2201,13 @@ static WFILE_T wtap_dump_file_open(wtap_dumper *wdh, const char *filename);
 static WFILE_T wtap_dump_file_fdopen(wtap_dumper *wdh, int fd);
 static int wtap_dump_file_close(wtap_dumper *wdh);
 
+/* The kind of ws_cstream that writes files compressed this way. */
+static ws_cstream_type
+wtap_dump_cstream_type(wtap_compression_type compression_type)
+{
+	return compression_type == WTAP_LZ4_COMPRESSED ? WS_CSTREAM_LZ4 : WS_CSTREAM_ZSTD;
+}
+
 static wtap_dumper *
 wtap_dump_init_dumper(int file_type_subtype, wtap_compression_type compression_type,
                       const wtap_dump_params *params, int *err)
@@ -2216,6 +2262,15 @@ wtap_dump_init_dumper(int file_type_subtype, wtap_compression_type compression_t
 		return NULL;
 	}
 
+	/* We can only write zstd and LZ4 files if we have the libraries. */
+	if (compression_type == WTAP_ZSTD_COMPRESSED ||
+	    compression_type == WTAP_LZ4_COMPRESSED) {
+		if (!ws_cstream_type_supported(wtap_dump_cstream_type(compression_type))) {
+			*err = WTAP_ERR_COMPRESSION_NOT_SUPPORTED;
+			return NULL;
+		}
+	}
+
 	/* Allocate a data structure for the output stream. */
 	wdh = g_new0(wtap_dumper, 1);
 	if (wdh == NULL) {
@@ -2227,6 +2282,7 @@ wtap_dump_init_dumper(int file_type_subtype, wtap_compression_type compression_t
 	wdh->snaplen = params->snaplen;
 	wdh->encap = params->encap;
 	wdh->compression_type = compression_type;
+	wdh->write_buf_size = params->write_buf_size;
 	wdh->wslua_data = NULL;
 	wdh->interface_data = g_array_new(FALSE, FALSE, sizeof(wtap_block_t));
 
@@ -2357,6 +2413,7 @@ wtap_dump_open(const char *filename, int file_type_subtype,
 		   opening it. */
 		wtap_dump_file_close(wdh);
 		ws_unlink(filename);
+		g_free(wdh->write_buf);
 		g_free(wdh);
 		return NULL;
 	}
@@ -2419,6 +2476,7 @@ wtap_dump_open_tempfile(char **filenamep, const char *pfx,
 		   opening it. */
 		wtap_dump_file_close(wdh);
 		ws_unlink(*filenamep);
+		g_free(wdh->write_buf);
 		g_free(wdh);
 		return NULL;
 	}
@@ -2454,6 +2512,7 @@ wtap_dump_fdopen(int fd, int file_type_subtype, wtap_compression_type compressio
 
 	if (!wtap_dump_open_finish(wdh, err, err_info)) {
 		wtap_dump_file_close(wdh);
+		g_free(wdh->write_buf);
 		g_free(wdh);
 		return NULL;
 	}
@@ -2530,6 +2589,15 @@ wtap_dump_open_finish(wtap_dumper *wdh, int *err, gchar **err_info)
 		return FALSE;
 	}
 
+	/* Give the stream a bigger buffer if asked to, so that records
+	   are written out in fewer, larger writes; this has to be done
+	   before anything is written to it. */
+	if (wdh->compression_type == WTAP_UNCOMPRESSED && wdh->write_buf_size != 0) {
+		wdh->write_buf = (guint8 *)g_malloc(wdh->write_buf_size);
+		setvbuf((FILE *)wdh->fh, (char *)wdh->write_buf, _IOFBF,
+		    wdh->write_buf_size);
+	}
+
 	/* Set wdh with wslua data if any - this is how we pass the data
 	 * to the file writer.
 	 */
@@ -2585,6 +2653,12 @@ wtap_dump_flush(wtap_dumper *wdh, int *err)
 			*err = errno;
 			return FALSE;
 		}
+		/* That only hands the data to the compressor, if there
+		   is one; report any error it has had writing it out. */
+		if (wdh->cstream != NULL && ws_cstream_error(wdh->cstream) != 0) {
+			*err = ws_cstream_error(wdh->cstream);
+			return FALSE;
+		}
 	}
 	return TRUE;
 }
@@ -2612,6 +2686,7 @@ wtap_dump_close(wtap_dumper *wdh, int *err, gchar **err_info)
 		}
 		ret = FALSE;
 	}
+	g_free(wdh->write_buf);
 	g_free(wdh->priv);
 	wtap_block_array_free(wdh->interface_data);
 	wtap_block_array_free(wdh->dsbs_initial);
@@ -2682,43 +2757,73 @@ gboolean wtap_dump_get_needs_reload(wtap_dumper *wdh) {
         return wdh->needs_reload;
 }
 
+/* internally start compressing to a file with zstd or LZ4; on failure,
+   errno is set and the file is left open */
+static WFILE_T
+wtap_dump_cstream_fdopen(wtap_dumper *wdh, int fd)
+{
+	int err;
+
+	wdh->cstream = ws_cstream_fdopen(fd,
+	    wtap_dump_cstream_type(wdh->compression_type), &err);
+	if (wdh->cstream == NULL) {
+		errno = err;
+		return NULL;
+	}
+	return ws_cstream_file(wdh->cstream);
+}
+
 /* internally open a file for writing (compressed or not) */
-#ifdef HAVE_ZLIB
 static WFILE_T
 wtap_dump_file_open(wtap_dumper *wdh, const char *filename)
 {
-	if (wdh->compression_type == WTAP_GZIP_COMPRESSED) {
+	int fd, err;
+	WFILE_T fh;
+
+	switch (wdh->compression_type) {
+
+#ifdef HAVE_ZLIB
+	case WTAP_GZIP_COMPRESSED:
 		return gzwfile_open(filename);
-	} else {
+#endif
+
+	case WTAP_ZSTD_COMPRESSED:
+	case WTAP_LZ4_COMPRESSED:
+		fd = ws_open(filename, O_BINARY|O_WRONLY|O_CREAT|O_TRUNC, 0666);
+		if (fd == -1)
+			return NULL;
+		fh = wtap_dump_cstream_fdopen(wdh, fd);
+		if (fh == NULL) {
+			err = errno;
+			ws_close(fd);
+			errno = err;
+		}
+		return fh;
+
+	default:
 		return ws_fopen(filename, "wb");
 	}
 }
-#else
-static WFILE_T
-wtap_dump_file_open(wtap_dumper *wdh _U_, const char *filename)
-{
-	return ws_fopen(filename, "wb");
-}
-#endif
 
 /* internally open a file for writing (compressed or not) */
-#ifdef HAVE_ZLIB
 static WFILE_T
 wtap_dump_file_fdopen(wtap_dumper *wdh, int fd)
 {
-	if (wdh->compression_type == WTAP_GZIP_COMPRESSED) {
+	switch (wdh->compression_type) {
+
+#ifdef HAVE_ZLIB
+	case WTAP_GZIP_COMPRESSED:
 		return gzwfile_fdopen(fd);
-	} else {
+#endif
+
+	case WTAP_ZSTD_COMPRESSED:
+	case WTAP_LZ4_COMPRESSED:
+		return wtap_dump_cstream_fdopen(wdh, fd);
+
+	default:
 		return ws_fdopen(fd, "wb");
 	}
 }
-#else
-static WFILE_T
-wtap_dump_file_fdopen(wtap_dumper *wdh _U_, int fd)
-{
-	return ws_fdopen(fd, "wb");
-}
-#endif
 
 /* internally writing raw bytes (compressed or not) */
 gboolean
@@ -2765,18 +2870,28 @@ wtap_dump_file_close(wtap_dumper *wdh)
 		return gzwfile_close((GZWFILE_T)wdh->fh);
 	else
 #endif
+	if (wdh->cstream != NULL) {
+		/* This closes wdh->fh, and waits for the compressor to
+		   finish writing the file. */
+		int err = ws_cstream_close(wdh->cstream);
+
+		wdh->cstream = NULL;
+		if (err != 0) {
+			errno = err;
+			return EOF;
+		}
+		return 0;
+	} else
 		return fclose((FILE *)wdh->fh);
 }
 
 gint64
 wtap_dump_file_seek(wtap_dumper *wdh, gint64 offset, int whence, int *err)
 {
-#ifdef HAVE_ZLIB
 	if (wdh->compression_type != WTAP_UNCOMPRESSED) {
 		*err = WTAP_ERR_CANT_SEEK_COMPRESSED;
 		return -1;
 	} else
-#endif
 	{
 		if (-1 == ws_fseek64((FILE *)wdh->fh, offset, whence)) {
 			*err = errno;
@@ -2792,12 +2907,10 @@ gint64
 wtap_dump_file_tell(wtap_dumper *wdh, int *err)
 {
 	gint64 rval;
-#ifdef HAVE_ZLIB
 	if (wdh->compression_type != WTAP_UNCOMPRESSED) {
 		*err = WTAP_ERR_CANT_SEEK_COMPRESSED;
 		return -1;
 	} else
-#endif
 	{
 		if (-1 == (rval = ws_ftell64((FILE *)wdh->fh))) {
 			*err = errno;
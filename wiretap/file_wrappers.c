@@ -27,12 +27,25 @@
 #include <zlib.h>
 #endif /* HAVE_ZLIB */
 
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif /* HAVE_ZSTD */
+
+#ifdef HAVE_LZ4FRAME_H
+#include <lz4frame.h>
+#endif /* HAVE_LZ4FRAME_H */
+
 /*
  * See RFC 1952:
  *
  *      https://tools.ietf.org/html/rfc1952
  *
- * for a description of the gzip file format.
+ * for a description of the gzip file format, and
+ *
+ *      https://tools.ietf.org/html/rfc8878
+ *      https://github.com/lz4/lz4/blob/dev/doc/lz4_Frame_format.md
+ *
+ * for descriptions of the zstd and LZ4 frame formats.
  *
  * Some other compressed file formats we might want to support:
  *
@@ -53,6 +66,12 @@ static struct compression_type {
 } compression_types[] = {
 #ifdef HAVE_ZLIB
     { WTAP_GZIP_COMPRESSED, "gz", "gzip compressed" },
+#endif
+#ifdef HAVE_ZSTD
+    { WTAP_ZSTD_COMPRESSED, "zst", "zstd compressed" },
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    { WTAP_LZ4_COMPRESSED, "lz4", "lz4 compressed" },
 #endif
     { WTAP_UNCOMPRESSED, NULL, NULL }
 };
@@ -60,10 +79,11 @@ static struct compression_type {
 wtap_compression_type
 wtap_get_compression_type(wtap *wth)
 {
-	gboolean is_compressed;
-
-	is_compressed = file_iscompressed((wth->fh == NULL) ? wth->random_fh : wth->fh);
-	return is_compressed ? WTAP_GZIP_COMPRESSED : WTAP_UNCOMPRESSED;
+	/* The records of a virtual file are read uncompressed from the
+	   files it's read from. */
+	if (wth->members != NULL)
+		return WTAP_UNCOMPRESSED;
+	return file_get_compression_type((wth->fh == NULL) ? wth->random_fh : wth->fh);
 }
 
 const char *
@@ -111,10 +131,38 @@ typedef enum {
     UNCOMPRESSED,  /* uncompressed - copy input directly */
 #ifdef HAVE_ZLIB
     ZLIB,          /* decompress a zlib stream */
-    GZIP_AFTER_HEADER
+    GZIP_AFTER_HEADER,
+#endif
+#ifdef HAVE_ZSTD
+    ZSTD,          /* decompress a zstd frame */
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    LZ4,           /* decompress an LZ4 frame */
 #endif
 } compression_t;
 
+/*
+ * Read-ahead for sequential reading; see file_set_read_ahead().  A
+ * thread reads the file into one chunk while the other is being handed
+ * out, so that waiting for the file system overlaps with processing the
+ * data already read.
+ */
+typedef struct {
+    int fd;
+    guint chunk_size;
+    GThread *thread;
+    GMutex mutex;               /* protects full, len, err and stop */
+    GCond cond;
+    guint8 *chunks[2];
+    gboolean full[2];           /* TRUE if chunk i has been read into */
+    guint len[2];               /* how much was read into it; 0 at the end */
+    int err[2];                 /* the errno if reading it failed */
+    guint fill;                 /* the chunk the thread reads into next */
+    guint drain;                /* the chunk data is handed out of */
+    guint drain_pos;            /* how much of it has been */
+    gboolean stop;              /* TRUE to make the thread stop */
+} file_read_ahead_t;
+
 struct wtap_reader_buf {
     guint8 *buf;  /* buffer */
     guint8 *next; /* next byte to deliver from buffer */
@@ -135,6 +183,7 @@ struct wtap_reader {
     gint64 raw;                 /* where the raw data started, for seeking */
     compression_t compression;  /* type of compression, if any */
     gboolean is_compressed;     /* FALSE if completely uncompressed, TRUE otherwise */
+    wtap_compression_type compression_type; /* type of the first compressed data found */
 
     /* seek request */
     gint64 skip;                /* amount to skip (already rewound if backwards) */
@@ -148,10 +197,25 @@ struct wtap_reader {
     /* zlib inflate stream */
     z_stream strm;              /* stream structure in-place (not a pointer) */
     gboolean dont_check_crc;    /* TRUE if we aren't supposed to check the CRC */
+#endif
+#ifdef HAVE_ZSTD
+    ZSTD_DCtx *zstd_dctx;       /* zstd decompression context, created when needed */
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    LZ4F_dctx *lz4_dctx;        /* LZ4 decompression context, created when needed */
 #endif
     /* fast seeking */
     GPtrArray *fast_seek;
     void *fast_seek_cur;
+
+    /* memory-mapped access; see file_map() */
+    GMappedFile *mapped;
+    const unsigned char *map;   /* start of the mapping */
+    gint64 map_len;             /* length of the mapping */
+
+    /* read-ahead; see file_set_read_ahead() */
+    guint read_ahead_size;      /* the size of a chunk, or 0 for none */
+    file_read_ahead_t *read_ahead; /* NULL until it's needed */
 };
 
 /* Current read offset within a buffer. */
@@ -190,6 +254,142 @@ buf_reset(struct wtap_reader_buf *buf)
     buf->avail = 0;
 }
 
+static gpointer
+read_ahead_thread(gpointer data)
+{
+    file_read_ahead_t *ra = (file_read_ahead_t *)data;
+    guint i, len;
+    ssize_t ret;
+    int err;
+
+    for (;;) {
+        g_mutex_lock(&ra->mutex);
+        while (ra->full[ra->fill] && !ra->stop)
+            g_cond_wait(&ra->cond, &ra->mutex);
+        if (ra->stop) {
+            g_mutex_unlock(&ra->mutex);
+            break;
+        }
+        i = ra->fill;
+        g_mutex_unlock(&ra->mutex);
+
+        /* Fill the chunk, unless we get to the end first. */
+        len = 0;
+        err = 0;
+        while (len < ra->chunk_size) {
+            ret = ws_read(ra->fd, ra->chunks[i] + len, ra->chunk_size - len);
+            if (ret < 0) {
+                err = errno;
+                break;
+            }
+            if (ret == 0)
+                break;
+            len += (guint)ret;
+        }
+
+        g_mutex_lock(&ra->mutex);
+        ra->len[i] = len;
+        ra->err[i] = err;
+        ra->full[i] = TRUE;
+        ra->fill = i ^ 1;
+        g_cond_broadcast(&ra->cond);
+        g_mutex_unlock(&ra->mutex);
+
+        /* After the end, or an error, there's nothing more to read. */
+        if (len < ra->chunk_size)
+            break;
+    }
+    return NULL;
+}
+
+/* Start reading ahead from where the file is now. */
+static file_read_ahead_t *
+read_ahead_start(int fd, guint chunk_size)
+{
+    file_read_ahead_t *ra;
+
+    ra = g_new0(file_read_ahead_t, 1);
+    ra->fd = fd;
+    ra->chunk_size = chunk_size;
+    ra->chunks[0] = (guint8 *)g_try_malloc(chunk_size);
+    ra->chunks[1] = (guint8 *)g_try_malloc(chunk_size);
+    if (ra->chunks[0] == NULL || ra->chunks[1] == NULL) {
+        /* Read the usual way. */
+        g_free(ra->chunks[0]);
+        g_free(ra->chunks[1]);
+        g_free(ra);
+        return NULL;
+    }
+    g_mutex_init(&ra->mutex);
+    g_cond_init(&ra->cond);
+    ra->thread = g_thread_new("wiretap read-ahead", read_ahead_thread, ra);
+    return ra;
+}
+
+/* Like ws_read(), with what the thread has read. */
+static ssize_t
+read_ahead_read(file_read_ahead_t *ra, guint8 *buf, guint count)
+{
+    guint i, n;
+
+    g_mutex_lock(&ra->mutex);
+    while (!ra->full[ra->drain])
+        g_cond_wait(&ra->cond, &ra->mutex);
+    i = ra->drain;
+    g_mutex_unlock(&ra->mutex);
+
+    /* The thread leaves a full chunk alone. */
+    if (ra->err[i] != 0) {
+        errno = ra->err[i];
+        return -1;
+    }
+    n = MIN(count, ra->len[i] - ra->drain_pos);
+    if (n == 0)
+        return 0;
+    memcpy(buf, ra->chunks[i] + ra->drain_pos, n);
+    ra->drain_pos += n;
+    if (ra->drain_pos == ra->len[i] && ra->len[i] == ra->chunk_size) {
+        /* Let the thread have it back. */
+        g_mutex_lock(&ra->mutex);
+        ra->full[i] = FALSE;
+        ra->drain = i ^ 1;
+        ra->drain_pos = 0;
+        g_cond_broadcast(&ra->cond);
+        g_mutex_unlock(&ra->mutex);
+    }
+    return n;
+}
+
+/*
+ * Stop reading ahead, and put the file position back where our reading
+ * has got to, so the file can be seeked in or closed.  Reading ahead
+ * starts again with the next read.
+ */
+static void
+read_ahead_stop(FILE_T state)
+{
+    file_read_ahead_t *ra = state->read_ahead;
+
+    if (ra == NULL)
+        return;
+    state->read_ahead = NULL;
+
+    g_mutex_lock(&ra->mutex);
+    ra->stop = TRUE;
+    g_cond_broadcast(&ra->cond);
+    g_mutex_unlock(&ra->mutex);
+    g_thread_join(ra->thread);
+
+    if (state->fd != -1)
+        ws_lseek64(state->fd, state->raw_pos, SEEK_SET);
+
+    g_cond_clear(&ra->cond);
+    g_mutex_clear(&ra->mutex);
+    g_free(ra->chunks[0]);
+    g_free(ra->chunks[1]);
+    g_free(ra);
+}
+
 static int
 buf_read(FILE_T state, struct wtap_reader_buf *buf)
 {
@@ -215,7 +415,12 @@ buf_read(FILE_T state, struct wtap_reader_buf *buf)
         to_read = space_left;
     }
 
-    ret = ws_read(state->fd, read_ptr, to_read);
+    if (state->read_ahead_size != 0 && state->read_ahead == NULL)
+        state->read_ahead = read_ahead_start(state->fd, state->read_ahead_size);
+    if (state->read_ahead != NULL)
+        ret = read_ahead_read(state->read_ahead, read_ptr, to_read);
+    else
+        ret = ws_read(state->fd, read_ptr, to_read);
     if (ret < 0) {
         state->err = errno;
         state->err_info = NULL;
@@ -330,6 +535,205 @@ fast_seek_reset(
 #endif
 }
 
+#if defined(HAVE_ZSTD) || defined(HAVE_LZ4FRAME_H)
+/*
+ * Values for the magic numbers at the beginning of zstd and LZ4 frames,
+ * and for skippable frames, which are the same for both.
+ */
+#define ZSTD_FRAME_MAGIC        0xFD2FB528
+#define LZ4_FRAME_MAGIC         0x184D2204
+#define SKIPPABLE_FRAME_MAGIC   0x184D2A50
+#define SKIPPABLE_FRAME_MASK    0xFFFFFFF0
+
+/*
+ * Add a fast seek point at the start of a frame of a compressed format
+ * whose frames can be decompressed independently, if it's more than
+ * SPAN bytes past the last one.
+ */
+static void
+frame_fast_seek_add(FILE_T file, gint64 in_pos, gint64 out_pos,
+                    compression_t compression)
+{
+    struct fast_seek_point *item = NULL;
+
+    if (file->fast_seek->len != 0)
+        item = (struct fast_seek_point *)file->fast_seek->pdata[file->fast_seek->len - 1];
+
+    if (!item || item->out + SPAN < out_pos) {
+        struct fast_seek_point *val = g_new(struct fast_seek_point,1);
+        val->in = in_pos;
+        val->out = out_pos;
+        val->compression = compression;
+
+        g_ptr_array_add(file->fast_seek, val);
+    }
+}
+
+/* Make sure there are at least n bytes in the input buffer, unless we
+   hit the end of the file first, moving the bytes that are there to the
+   beginning of the buffer if need be.  Return -1 on an error. */
+static int
+fill_in_buffer_min(FILE_T state, guint n)
+{
+    while (state->in.avail < n && !state->eof) {
+        if (state->in.next != state->in.buf) {
+            memmove(state->in.buf, state->in.next, state->in.avail);
+            state->in.next = state->in.buf;
+        }
+        if (fill_in_buffer(state) == -1)
+            return -1;
+    }
+    return 0;
+}
+
+/* Start decompressing a frame that begins at the current input position. */
+static void
+frame_start(FILE_T state, compression_t compression,
+            wtap_compression_type compression_type)
+{
+    if (!state->is_compressed)
+        state->compression_type = compression_type;
+    state->compression = compression;
+    state->is_compressed = TRUE;
+    if (state->fast_seek)
+        frame_fast_seek_add(state, state->raw_pos - state->in.avail, state->pos, compression);
+}
+#endif
+
+#ifdef HAVE_ZSTD
+/* Get the zstd decompression context ready to start a new frame.
+   Return -1 on an error. */
+static int
+zstd_reset(FILE_T state)
+{
+    if (state->zstd_dctx == NULL) {
+        state->zstd_dctx = ZSTD_createDCtx();
+        if (state->zstd_dctx == NULL) {
+            state->err = ENOMEM;
+            state->err_info = NULL;
+            return -1;
+        }
+    }
+    (void)ZSTD_initDStream(state->zstd_dctx);
+    return 0;
+}
+
+static void
+zstd_read(FILE_T state, unsigned char *buf, unsigned int count)
+{
+    ZSTD_outBuffer output;
+    ZSTD_inBuffer input;
+    size_t ret, before;
+
+    output.dst = buf;
+    output.size = count;
+    output.pos = 0;
+
+    /* fill output buffer up to end of frame or error */
+    do {
+        /* get more input; an empty input buffer is OK, as the
+           decompressor might have output left to deliver */
+        if (state->in.avail == 0 && fill_in_buffer(state) == -1)
+            break;
+
+        input.src = state->in.next;
+        input.size = state->in.avail;
+        input.pos = 0;
+        before = output.pos;
+        ret = ZSTD_decompressStream(state->zstd_dctx, &output, &input);
+        state->in.next += input.pos;
+        state->in.avail -= (guint)input.pos;
+        if (ZSTD_isError(ret)) {
+            state->err = WTAP_ERR_DECOMPRESS;
+            state->err_info = ZSTD_getErrorName(ret);
+            break;
+        }
+        if (ret == 0) {
+            /* end of frame; ready for the next one */
+            state->compression = UNKNOWN;
+            break;
+        }
+        if (input.pos == 0 && output.pos == before &&
+            state->eof && state->in.avail == 0) {
+            /* EOF in the middle of a frame */
+            state->err = WTAP_ERR_SHORT_READ;
+            state->err_info = NULL;
+            break;
+        }
+    } while (output.pos < output.size);
+
+    /* update available output */
+    state->out.next = buf;
+    state->out.avail = (guint)output.pos;
+}
+#endif /* HAVE_ZSTD */
+
+#ifdef HAVE_LZ4FRAME_H
+/* Get the LZ4 decompression context ready to start a new frame.
+   Return -1 on an error. */
+static int
+lz4_reset(FILE_T state)
+{
+    /* A fresh context is the portable way to abandon a partly-read
+       frame; older versions of liblz4 can't reset one. */
+    if (state->lz4_dctx != NULL) {
+        LZ4F_freeDecompressionContext(state->lz4_dctx);
+        state->lz4_dctx = NULL;
+    }
+    if (LZ4F_isError(LZ4F_createDecompressionContext(&state->lz4_dctx, LZ4F_VERSION))) {
+        state->lz4_dctx = NULL;
+        state->err = ENOMEM;
+        state->err_info = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+static void
+lz4_read(FILE_T state, unsigned char *buf, unsigned int count)
+{
+    unsigned char *out = buf;
+    size_t out_left = count;
+    size_t ret, in_size, out_size;
+
+    /* fill output buffer up to end of frame or error */
+    do {
+        if (state->in.avail == 0 && fill_in_buffer(state) == -1)
+            break;
+
+        in_size = state->in.avail;
+        out_size = out_left;
+        ret = LZ4F_decompress(state->lz4_dctx, out, &out_size,
+                              state->in.next, &in_size, NULL);
+        state->in.next += in_size;
+        state->in.avail -= (guint)in_size;
+        out += out_size;
+        out_left -= out_size;
+        if (LZ4F_isError(ret)) {
+            state->err = WTAP_ERR_DECOMPRESS;
+            state->err_info = LZ4F_getErrorName(ret);
+            break;
+        }
+        if (ret == 0) {
+            /* end of frame; ready for the next one */
+            state->compression = UNKNOWN;
+            break;
+        }
+        if (in_size == 0 && out_size == 0 &&
+            state->eof && state->in.avail == 0) {
+            /* EOF in the middle of a frame */
+            state->err = WTAP_ERR_SHORT_READ;
+            state->err_info = NULL;
+            break;
+        }
+    } while (out_left != 0);
+
+    /* update available output */
+    state->out.next = buf;
+    state->out.avail = count - (guint)out_left;
+}
+#endif /* HAVE_LZ4FRAME_H */
+
 #ifdef HAVE_ZLIB
 
 /* Get next byte from input, or -1 if end or error.
@@ -765,6 +1169,8 @@ gz_head(FILE_T state)
                 /* set up for decompression */
                 inflateReset(&(state->strm));
                 state->strm.adler = crc32(0L, Z_NULL, 0);
+                if (!state->is_compressed)
+                    state->compression_type = WTAP_GZIP_COMPRESSED;
                 state->compression = ZLIB;
                 state->is_compressed = TRUE;
 #ifdef Z_BLOCK
@@ -804,6 +1210,38 @@ gz_head(FILE_T state)
             state->in.next--;
         }
     }
+#if defined(HAVE_ZSTD) || defined(HAVE_LZ4FRAME_H)
+    /* look for a zstd or LZ4 frame, or a skippable frame */
+    if (fill_in_buffer_min(state, 4) == -1)
+        return -1;
+    if (state->in.avail >= 4) {
+        guint32 magic = pletoh32(state->in.next);
+
+#ifdef HAVE_ZSTD
+        /*
+         * The zstd decoder also handles skippable frames, such as
+         * the seek tables of the zstd "seekable" format.
+         */
+        if (magic == ZSTD_FRAME_MAGIC ||
+            (magic & SKIPPABLE_FRAME_MASK) == SKIPPABLE_FRAME_MAGIC) {
+            if (zstd_reset(state) == -1)
+                return -1;
+            frame_start(state, ZSTD, WTAP_ZSTD_COMPRESSED);
+            return 0;
+        }
+#endif
+#ifdef HAVE_LZ4FRAME_H
+        if (magic == LZ4_FRAME_MAGIC ||
+            (magic & SKIPPABLE_FRAME_MASK) == SKIPPABLE_FRAME_MAGIC) {
+            if (lz4_reset(state) == -1)
+                return -1;
+            frame_start(state, LZ4, WTAP_LZ4_COMPRESSED);
+            return 0;
+        }
+#endif
+    }
+#endif /* HAVE_ZSTD || HAVE_LZ4FRAME_H */
+
 #ifdef HAVE_LIBXZ
     /* { 0xFD, '7', 'z', 'X', 'Z', 0x00 } */
     /* FD 37 7A 58 5A 00 */
@@ -848,6 +1286,16 @@ fill_out_buffer(FILE_T state)
     else if (state->compression == ZLIB) {      /* decompress */
         zlib_read(state, state->out.buf, state->size << 1);
     }
+#endif
+#ifdef HAVE_ZSTD
+    else if (state->compression == ZSTD) {
+        zstd_read(state, state->out.buf, state->size << 1);
+    }
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    else if (state->compression == LZ4) {
+        lz4_read(state, state->out.buf, state->size << 1);
+    }
 #endif
     return 0;
 }
@@ -1065,6 +1513,207 @@ file_set_random_access(FILE_T stream, gboolean random_flag _U_, GPtrArray *seek)
     stream->fast_seek = seek;
 }
 
+void
+file_set_read_ahead(FILE_T stream, guint chunk_size)
+{
+    /* It starts with the next read. */
+    read_ahead_stop(stream);
+    stream->read_ahead_size = chunk_size;
+}
+
+/*
+ * Fast seek points, serialized by file_fast_seek_serialize(): a magic
+ * number and a count of points, followed by, for each point, its
+ * offsets, a code for its compression type and, for points in the
+ * middle of a deflate stream, what's needed to resume inflating there.
+ * All values are in host byte order.
+ *
+ * The codes don't depend on which decompressors we were built with;
+ * points we can't use are dropped when the points are read back.
+ */
+#define FAST_SEEK_MAGIC             0x57534b50  /* "WSKP" */
+
+#define FAST_SEEK_UNCOMPRESSED      0
+#define FAST_SEEK_ZLIB              1
+#define FAST_SEEK_GZIP_AFTER_HEADER 2
+#define FAST_SEEK_ZSTD              3
+#define FAST_SEEK_LZ4               4
+
+typedef struct {
+    gint64  out;
+    gint64  in;
+    guint32 compression;
+    gint32  bits;       /* FAST_SEEK_ZLIB only, as are the rest */
+    guint32 adler;
+    guint32 total_out;
+} fast_seek_record_t;
+
+GByteArray *
+file_fast_seek_serialize(GPtrArray *fast_seek)
+{
+    GByteArray *bytes;
+    guint32 val;
+    guint i;
+
+    bytes = g_byte_array_new();
+    val = FAST_SEEK_MAGIC;
+    g_byte_array_append(bytes, (const guint8 *)&val, sizeof val);
+    val = fast_seek->len;
+    g_byte_array_append(bytes, (const guint8 *)&val, sizeof val);
+
+    for (i = 0; i < fast_seek->len; i++) {
+        struct fast_seek_point *point = (struct fast_seek_point *)fast_seek->pdata[i];
+        fast_seek_record_t rec;
+
+        memset(&rec, 0, sizeof rec);
+        rec.out = point->out;
+        rec.in = point->in;
+        switch (point->compression) {
+
+#ifdef HAVE_ZLIB
+        case ZLIB:
+            rec.compression = FAST_SEEK_ZLIB;
+#ifdef HAVE_INFLATEPRIME
+            rec.bits = point->data.zlib.bits;
+#endif
+            rec.adler = point->data.zlib.adler;
+            rec.total_out = point->data.zlib.total_out;
+            break;
+
+        case GZIP_AFTER_HEADER:
+            rec.compression = FAST_SEEK_GZIP_AFTER_HEADER;
+            break;
+#endif
+
+#ifdef HAVE_ZSTD
+        case ZSTD:
+            rec.compression = FAST_SEEK_ZSTD;
+            break;
+#endif
+
+#ifdef HAVE_LZ4FRAME_H
+        case LZ4:
+            rec.compression = FAST_SEEK_LZ4;
+            break;
+#endif
+
+        default:
+            rec.compression = FAST_SEEK_UNCOMPRESSED;
+            break;
+        }
+        g_byte_array_append(bytes, (const guint8 *)&rec, sizeof rec);
+#ifdef HAVE_ZLIB
+        if (point->compression == ZLIB)
+            g_byte_array_append(bytes, point->data.zlib.window, ZLIB_WINSIZE);
+#endif
+    }
+    return bytes;
+}
+
+gboolean
+file_fast_seek_deserialize(GPtrArray *fast_seek, const guint8 *data, gsize len)
+{
+    GPtrArray *points;
+    guint32 val, count, i;
+    gsize off = 0;
+
+    if (len < 2 * sizeof val)
+        return FALSE;
+    memcpy(&val, data, sizeof val);
+    if (val != FAST_SEEK_MAGIC)
+        return FALSE;
+    memcpy(&count, data + sizeof val, sizeof count);
+    off = 2 * sizeof val;
+
+    points = g_ptr_array_new_with_free_func(g_free);
+    for (i = 0; i < count; i++) {
+        struct fast_seek_point *point;
+        fast_seek_record_t rec;
+        gboolean usable = TRUE;
+
+        if (len - off < sizeof rec)
+            goto bad;
+        memcpy(&rec, data + off, sizeof rec);
+        off += sizeof rec;
+        if (rec.compression == FAST_SEEK_ZLIB) {
+            if (len - off < ZLIB_WINSIZE)
+                goto bad;
+        }
+
+        point = g_new(struct fast_seek_point, 1);
+        point->out = rec.out;
+        point->in = rec.in;
+        switch (rec.compression) {
+
+        case FAST_SEEK_UNCOMPRESSED:
+            point->compression = UNCOMPRESSED;
+            break;
+
+#ifdef HAVE_ZLIB
+        case FAST_SEEK_ZLIB:
+            point->compression = ZLIB;
+#ifdef HAVE_INFLATEPRIME
+            point->data.zlib.bits = rec.bits;
+#else
+            if (rec.bits != 0)
+                usable = FALSE;
+#endif
+            point->data.zlib.adler = rec.adler;
+            point->data.zlib.total_out = rec.total_out;
+            memcpy(point->data.zlib.window, data + off, ZLIB_WINSIZE);
+            break;
+
+        case FAST_SEEK_GZIP_AFTER_HEADER:
+            point->compression = GZIP_AFTER_HEADER;
+            break;
+#endif
+
+#ifdef HAVE_ZSTD
+        case FAST_SEEK_ZSTD:
+            point->compression = ZSTD;
+            break;
+#endif
+
+#ifdef HAVE_LZ4FRAME_H
+        case FAST_SEEK_LZ4:
+            point->compression = LZ4;
+            break;
+#endif
+
+        default:
+            usable = FALSE;
+            break;
+        }
+        if (rec.compression == FAST_SEEK_ZLIB)
+            off += ZLIB_WINSIZE;
+
+        /* The points must be in order. */
+        if (points->len != 0 &&
+            ((struct fast_seek_point *)points->pdata[points->len - 1])->out >= point->out)
+            usable = FALSE;
+        if (usable)
+            g_ptr_array_add(points, point);
+        else
+            g_free(point);
+    }
+    if (off != len)
+        goto bad;
+
+    /* Replace whatever points we already had. */
+    for (i = 0; i < fast_seek->len; i++)
+        g_free(fast_seek->pdata[i]);
+    g_ptr_array_set_size(fast_seek, 0);
+    for (i = 0; i < points->len; i++)
+        g_ptr_array_add(fast_seek, points->pdata[i]);
+    g_ptr_array_set_free_func(points, NULL);
+    g_ptr_array_free(points, TRUE);
+    return TRUE;
+
+bad:
+    g_ptr_array_free(points, TRUE);
+    return FALSE;
+}
+
 gint64
 file_seek(FILE_T file, gint64 offset, int whence, int *err)
 {
@@ -1079,6 +1728,21 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
 */
     }
 
+    if (file->map != NULL) {
+        /* Just move our position within the mapping. */
+        if (whence == SEEK_CUR)
+            offset += file->pos;
+        else if (whence == SEEK_END)
+            offset += file->map_len;
+        if (offset < 0) {
+            *err = EINVAL;
+            return -1;
+        }
+        file->pos = offset;
+        file->eof = FALSE;
+        return file->pos;
+    }
+
     /* Normalize offset to a SEEK_CUR specification */
     if (whence == SEEK_END) {
         /* Seek relative to the end of the file; given that we might be
@@ -1200,11 +1864,16 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
             off2 = here->out;
         } else
 #endif
-        {
+        if (here->compression != UNCOMPRESSED) {
+            /* The start of a zstd or LZ4 frame. */
+            off = here->in;
+            off2 = here->out;
+        } else {
             off2 = (file->pos + offset);
             off = here->in + (off2 - here->out);
         }
 
+        read_ahead_stop(file);
         if (ws_lseek64(file->fd, off, SEEK_SET) == -1) {
             *err = errno;
             return -1;
@@ -1254,6 +1923,19 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
 #endif
             file->compression = here->compression;
 
+#ifdef HAVE_ZSTD
+        if (here->compression == ZSTD && zstd_reset(file) == -1) {
+            *err = file->err;
+            return -1;
+        }
+#endif
+#ifdef HAVE_LZ4FRAME_H
+        if (here->compression == LZ4 && lz4_reset(file) == -1) {
+            *err = file->err;
+            return -1;
+        }
+#endif
+
         offset = (file->pos + offset) - off2;
         file->pos = off2;
         /* g_print("OK! %ld\n", offset); */
@@ -1285,6 +1967,7 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
         /*
          * Yes.  Just seek there within the file.
          */
+        read_ahead_stop(file);
         if (ws_lseek64(file->fd, offset - file->out.avail, SEEK_CUR) == -1) {
             *err = errno;
             return -1;
@@ -1319,6 +2002,7 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
         /* rewind, then skip to offset */
 
         /* back up and start over */
+        read_ahead_stop(file);
         if (ws_lseek64(file->fd, file->start, SEEK_SET) == -1) {
             *err = errno;
             return -1;
@@ -1361,6 +2045,8 @@ file_tell(FILE_T stream)
 gint64
 file_tell_raw(FILE_T stream)
 {
+    if (stream->map != NULL)
+        return stream->pos;
     return stream->raw_pos;
 }
 
@@ -1381,6 +2067,12 @@ file_iscompressed(FILE_T stream)
     return stream->is_compressed;
 }
 
+wtap_compression_type
+file_get_compression_type(FILE_T stream)
+{
+    return stream->is_compressed ? stream->compression_type : WTAP_UNCOMPRESSED;
+}
+
 int
 file_read(void *buf, unsigned int len, FILE_T file)
 {
@@ -1390,6 +2082,22 @@ file_read(void *buf, unsigned int len, FILE_T file)
     if (len == 0)
         return 0;
 
+    if (file->map != NULL) {
+        /* Copy straight from the mapping. */
+        if (file->pos >= file->map_len) {
+            file->eof = TRUE;
+            return 0;
+        }
+        if ((gint64)len > file->map_len - file->pos) {
+            len = (unsigned int)(file->map_len - file->pos);
+            file->eof = TRUE;
+        }
+        if (buf != NULL)
+            memcpy(buf, file->map + file->pos, len);
+        file->pos += len;
+        return (int)len;
+    }
+
     /* process a skip request */
     if (file->seek_pending) {
         file->seek_pending = FALSE;
@@ -1454,6 +2162,14 @@ file_peekc(FILE_T file)
     if (file->err != 0)
         return -1;
 
+    if (file->map != NULL) {
+        if (file->pos >= file->map_len) {
+            file->eof = TRUE;
+            return -1;
+        }
+        return file->map[file->pos];
+    }
+
     /* try output buffer (no need to check for skip request) */
     if (file->out.avail != 0) {
         return *(file->out.next);
@@ -1529,6 +2245,26 @@ file_getsp(char *buf, int len, FILE_T file)
     if (file->err != 0)
         return NULL;
 
+    if (file->map != NULL) {
+        /* copy bytes from the mapping up to new line or len - 1 */
+        gint64 avail = file->map_len - file->pos;
+
+        if (avail <= 0) {
+            file->eof = TRUE;
+            return NULL;
+        }
+        n = avail > len - 1 ? (unsigned)len - 1 : (unsigned)avail;
+        eol = (unsigned char *)memchr(file->map + file->pos, '\n', n);
+        if (eol != NULL)
+            n = (unsigned)(eol - (file->map + file->pos)) + 1;
+        else if (n == avail)
+            file->eof = TRUE;
+        memcpy(buf, file->map + file->pos, n);
+        file->pos += n;
+        buf[n] = 0;
+        return buf + n;
+    }
+
     /* process a skip request */
     if (file->seek_pending) {
         file->seek_pending = FALSE;
@@ -1597,6 +2333,58 @@ file_eof(FILE_T file)
     return (file->eof && file->in.avail == 0 && file->out.avail == 0);
 }
 
+/*
+ * Read an uncompressed file through a memory mapping of it, rather than
+ * with read() calls, so that seeking to and reading a record needs no
+ * system calls.  The file must not grow after this, as we'd not see the
+ * new data.  Returns FALSE, leaving things as they were, if the file
+ * is compressed or can't be mapped.
+ */
+gboolean
+file_map(FILE_T file)
+{
+    GError *err = NULL;
+
+    if (file->map != NULL)
+        return TRUE;
+    if (file->is_compressed || file->compression != UNCOMPRESSED || file->fd == -1)
+        return FALSE;
+
+    file->mapped = g_mapped_file_new_from_fd(file->fd, FALSE, &err);
+    if (file->mapped == NULL) {
+        /* Too big for our address space, not a regular file, etc. */
+        g_clear_error(&err);
+        return FALSE;
+    }
+    file->map_len = (gint64)g_mapped_file_get_length(file->mapped);
+    file->map = (const unsigned char *)g_mapped_file_get_contents(file->mapped);
+    if (file->map == NULL) {
+        /* An empty file; nothing to gain. */
+        g_mapped_file_unref(file->mapped);
+        file->mapped = NULL;
+        return FALSE;
+    }
+
+    /* Carry on from where we were, with nothing buffered. */
+    file->pos = file_tell(file);
+    file->seek_pending = FALSE;
+    buf_reset(&file->out);
+    buf_reset(&file->in);
+    file->eof = FALSE;
+    return TRUE;
+}
+
+static void
+file_unmap(FILE_T file)
+{
+    if (file->mapped != NULL) {
+        g_mapped_file_unref(file->mapped);
+        file->mapped = NULL;
+        file->map = NULL;
+        file->map_len = 0;
+    }
+}
+
 /*
  * Routine to return a Wiretap error code (0 for no error, an errno
  * for a file error, or a WTAP_ERR_ code for other errors) for an
@@ -1624,6 +2412,7 @@ file_clearerr(FILE_T stream)
 void
 file_fdclose(FILE_T file)
 {
+    read_ahead_stop(file);
     ws_close(file->fd);
     file->fd = -1;
 }
@@ -1636,6 +2425,19 @@ file_fdreopen(FILE_T file, const char *path)
     if ((fd = ws_open(path, O_RDONLY|O_BINARY, 0000)) == -1)
         return FALSE;
     file->fd = fd;
+
+    /* The file may have been replaced, so map the new one. */
+    if (file->map != NULL) {
+        file_unmap(file);
+        if (!file_map(file)) {
+            /* Read it the usual way. */
+            file->raw_pos = 0;
+            file->pos = 0;
+            file->eof = FALSE;
+            buf_reset(&file->out);
+            buf_reset(&file->in);
+        }
+    }
     return TRUE;
 }
 
@@ -1644,15 +2446,24 @@ file_close(FILE_T file)
 {
     int fd = file->fd;
 
+    read_ahead_stop(file);
+
     /* free memory and close file */
     if (file->size) {
 #ifdef HAVE_ZLIB
         inflateEnd(&(file->strm));
+#endif
+#ifdef HAVE_ZSTD
+        ZSTD_freeDCtx(file->zstd_dctx);
+#endif
+#ifdef HAVE_LZ4FRAME_H
+        LZ4F_freeDecompressionContext(file->lz4_dctx);
 #endif
         g_free(file->out.buf);
         g_free(file->in.buf);
     }
     g_free(file->fast_seek_cur);
+    file_unmap(file);
     file->err = 0;
     file->err_info = NULL;
     g_free(file);
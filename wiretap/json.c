@@ -18,10 +18,69 @@
 /* Maximum size of json file. */
 #define MAX_FILE_SIZE  (50*1024*1024)
 
+/*
+ * Newline-delimited JSON (NDJSON, or JSON Lines) files have one JSON
+ * text on each line; each line is a record, read as it's needed rather
+ * than with the whole file.
+ */
+#define NDJSON_MIN_LINE_SPACE  (64*1024)
+#define NDJSON_MAX_LINE_SIZE   (256*1024*1024)
+
 static int json_file_type_subtype = -1;
+static int ndjson_file_type_subtype = -1;
 
 void register_json(void);
 
+static gboolean ndjson_read(wtap *wth, wtap_rec *rec, Buffer *buf,
+    int *err, gchar **err_info, gint64 *data_offset);
+static gboolean ndjson_seek_read(wtap *wth, gint64 seek_off,
+    wtap_rec *rec, Buffer *buf, int *err, gchar **err_info);
+
+/*
+ * Is the start of a file, len bytes of it, and all of it if complete,
+ * newline-delimited JSON? Every line has to be an object or an array,
+ * so that a file of numbers or of strings isn't taken for it, and there
+ * have to be at least two, so that a JSON text on one line is still
+ * read as a JSON file.
+ */
+static gboolean
+json_is_ndjson(const guint8 *buf, size_t len, gboolean complete)
+{
+    const guint8 *newline;
+    size_t offset = 0, line_end, pos;
+    guint lines = 0;
+
+    while (offset < len) {
+        newline = (const guint8 *)memchr(buf + offset, '\n', len - offset);
+        if (newline != NULL) {
+            line_end = newline - buf;
+        } else if (complete) {
+            line_end = len;
+        } else {
+            /* The rest of the line wasn't read. */
+            break;
+        }
+
+        for (pos = offset; pos < line_end && g_ascii_isspace(buf[pos]); pos++)
+            ;
+        if (pos < line_end) {
+            if (buf[pos] != '{' && buf[pos] != '[')
+                return FALSE;
+            pos = json_tape_parse(buf, line_end, pos, NULL);
+            if (pos == 0)
+                return FALSE;
+            for (; pos < line_end && g_ascii_isspace(buf[pos]); pos++)
+                ;
+            if (pos < line_end)
+                return FALSE;
+            lines++;
+        }
+        offset = line_end + 1;
+    }
+
+    return lines >= 2;
+}
+
 wtap_open_return_val json_open(wtap *wth, int *err, gchar **err_info)
 {
     guint8* filebuf;
@@ -46,7 +105,15 @@ wtap_open_return_val json_open(wtap *wth, int *err, gchar **err_info)
         return WTAP_OPEN_NOT_MINE;
     }
 
-    if (json_validate(filebuf, bytes_read) == FALSE) {
+    if (json_is_ndjson(filebuf, bytes_read, bytes_read < MAX_FILE_SIZE)) {
+        wth->file_type_subtype = ndjson_file_type_subtype;
+        wth->subtype_read = ndjson_read;
+        wth->subtype_seek_read = ndjson_seek_read;
+    } else if (json_validate(filebuf, bytes_read)) {
+        wth->file_type_subtype = json_file_type_subtype;
+        wth->subtype_read = wtap_full_file_read;
+        wth->subtype_seek_read = wtap_full_file_seek_read;
+    } else {
         g_free(filebuf);
         return WTAP_OPEN_NOT_MINE;
     }
@@ -56,17 +123,103 @@ wtap_open_return_val json_open(wtap *wth, int *err, gchar **err_info)
         return WTAP_OPEN_ERROR;
     }
 
-    wth->file_type_subtype = json_file_type_subtype;
     wth->file_encap = WTAP_ENCAP_JSON;
     wth->file_tsprec = WTAP_TSPREC_SEC;
-    wth->subtype_read = wtap_full_file_read;
-    wth->subtype_seek_read = wtap_full_file_seek_read;
     wth->snapshot_length = 0;
 
     g_free(filebuf);
     return WTAP_OPEN_MINE;
 }
 
+/*
+ * Read the line at the current offset, without the line ending.
+ * Returns FALSE, with *err 0, at the end of the file.
+ */
+static gboolean
+ndjson_read_line(FILE_T fh, wtap_rec *rec, Buffer *buf, int *err, gchar **err_info)
+{
+    char *line, *end;
+    int space = NDJSON_MIN_LINE_SPACE;
+    int line_len = 0;
+
+    for (;;) {
+        ws_buffer_assure_space(buf, (gsize)space + 1);
+        line = (char *)ws_buffer_start_ptr(buf);
+        end = file_getsp(line + line_len, space + 1 - line_len, fh);
+        if (end == NULL) {
+            *err = file_error(fh, err_info);
+            if (*err != 0)
+                return FALSE;
+            if (line_len == 0)
+                return FALSE;
+            /* The last line has no line ending. */
+            break;
+        }
+        line_len = (int)(end - line);
+        if (line[line_len - 1] == '\n' || file_eof(fh))
+            break;
+
+        /* The line didn't fit; get more space. */
+        if (space >= NDJSON_MAX_LINE_SIZE) {
+            *err = WTAP_ERR_BAD_FILE;
+            *err_info = g_strdup_printf("ndjson: line is longer than the maximum of %u bytes",
+                                        NDJSON_MAX_LINE_SIZE);
+            return FALSE;
+        }
+        space *= 2;
+    }
+
+    if (line_len > 0 && line[line_len - 1] == '\n')
+        line_len--;
+    if (line_len > 0 && line[line_len - 1] == '\r')
+        line_len--;
+
+    rec->rec_type = REC_TYPE_PACKET;
+    rec->presence_flags = 0; /* no time stamps */
+    rec->ts.secs = 0;
+    rec->ts.nsecs = 0;
+    rec->rec_header.packet_header.caplen = line_len;
+    rec->rec_header.packet_header.len = line_len;
+
+    return TRUE;
+}
+
+static gboolean
+ndjson_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err, gchar **err_info,
+            gint64 *data_offset)
+{
+    const guint8 *line;
+    guint32 i;
+
+    /* Skip the lines with only whitespace. */
+    for (;;) {
+        *data_offset = file_tell(wth->fh);
+        if (!ndjson_read_line(wth->fh, rec, buf, err, err_info))
+            return FALSE;
+
+        line = ws_buffer_start_ptr(buf);
+        for (i = 0; i < rec->rec_header.packet_header.caplen; i++) {
+            if (!g_ascii_isspace(line[i]))
+                return TRUE;
+        }
+    }
+}
+
+static gboolean
+ndjson_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec, Buffer *buf,
+                 int *err, gchar **err_info)
+{
+    if (file_seek(wth->random_fh, seek_off, SEEK_SET, err) == -1)
+        return FALSE;
+
+    if (!ndjson_read_line(wth->random_fh, rec, buf, err, err_info)) {
+        if (*err == 0)
+            *err = WTAP_ERR_SHORT_READ;
+        return FALSE;
+    }
+    return TRUE;
+}
+
 static const struct supported_block_type json_blocks_supported[] = {
     /*
      * This is a file format that we dissect, so we provide only one
@@ -82,9 +235,23 @@ static const struct file_type_subtype_info json_info = {
     NULL, NULL, NULL
 };
 
+static const struct supported_block_type ndjson_blocks_supported[] = {
+    /*
+     * One packet for each line, with no options.
+     */
+    { WTAP_BLOCK_PACKET, MULTIPLE_BLOCKS_SUPPORTED, NO_OPTIONS_SUPPORTED }
+};
+
+static const struct file_type_subtype_info ndjson_info = {
+    "Newline-delimited JSON", "ndjson", "ndjson", "jsonl",
+    FALSE, BLOCKS_SUPPORTED(ndjson_blocks_supported),
+    NULL, NULL, NULL
+};
+
 void register_json(void)
 {
     json_file_type_subtype = wtap_register_file_type_subtype(&json_info);
+    ndjson_file_type_subtype = wtap_register_file_type_subtype(&ndjson_info);
 
     /*
      * Register name for backwards compatibility with the
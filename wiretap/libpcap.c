@@ -65,8 +65,12 @@ static gboolean libpcap_read(wtap *wth, wtap_rec *rec, Buffer *buf,
     int *err, gchar **err_info, gint64 *data_offset);
 static gboolean libpcap_seek_read(wtap *wth, gint64 seek_off,
     wtap_rec *rec, Buffer *buf, int *err, gchar **err_info);
+static gboolean libpcap_read_batch(wtap *wth, wtap_batch *batch, int *err,
+    gchar **err_info);
 static gboolean libpcap_read_packet(wtap *wth, FILE_T fh,
     wtap_rec *rec, Buffer *buf, int *err, gchar **err_info);
+static gboolean libpcap_read_packet_header(wtap *wth, FILE_T fh,
+    wtap_rec *rec, guint *packet_size, int *err, gchar **err_info);
 static int libpcap_read_header(wtap *wth, FILE_T fh, int *err, gchar **err_info,
     struct pcaprec_ss990915_hdr *hdr);
 static void libpcap_close(wtap *wth);
@@ -342,6 +346,7 @@ wtap_open_return_val libpcap_open(wtap *wth, int *err, gchar **err_info)
 	wth->priv = (void *)libpcap;
 	wth->subtype_read = libpcap_read;
 	wth->subtype_seek_read = libpcap_seek_read;
+	wth->subtype_read_batch = libpcap_read_batch;
 	wth->subtype_close = libpcap_close;
 	wth->file_encap = file_encap;
 	wth->snapshot_length = hdr.snaplen;
@@ -823,6 +828,47 @@ static gboolean libpcap_read(wtap *wth, wtap_rec *rec, Buffer *buf,
 	return libpcap_read_packet(wth, wth->fh, rec, buf, err, err_info);
 }
 
+/* Read as many packets as fit in a batch, straight into its buffer */
+static gboolean libpcap_read_batch(wtap *wth, wtap_batch *batch, int *err,
+    gchar **err_info)
+{
+	libpcap_t *libpcap = (libpcap_t *)wth->priv;
+	wtap_rec *rec;
+	Buffer window;
+	guint packet_size;
+
+	while (batch->num_recs < batch->max_recs) {
+		rec = wtap_batch_start_rec(wth, batch, file_tell(wth->fh));
+		if (!libpcap_read_packet_header(wth, wth->fh, rec, &packet_size,
+		    err, err_info))
+			return FALSE;
+
+		if (wth->headers_only) {
+			/* Skip the packet data. */
+			if (!wtap_read_bytes(wth->fh, NULL, packet_size, err,
+			    err_info))
+				return FALSE;	/* failed */
+
+			pcap_read_post_process(libpcap->variant == PCAP_NOKIA,
+			    wth->file_encap, rec, NULL,
+			    libpcap->byte_swapped, -1);
+			wtap_batch_end_rec(batch, NULL);
+			continue;
+		}
+
+		wtap_batch_reserve(batch, &window, packet_size);
+		if (!wtap_read_packet_bytes(wth->fh, &window, packet_size, err,
+		    err_info))
+			return FALSE;	/* failed */
+
+		pcap_read_post_process(libpcap->variant == PCAP_NOKIA,
+		    wth->file_encap, rec, ws_buffer_start_ptr(&window),
+		    libpcap->byte_swapped, -1);
+		wtap_batch_end_rec(batch, &window);
+	}
+	return TRUE;
+}
+
 static gboolean
 libpcap_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec,
     Buffer *buf, int *err, gchar **err_info)
@@ -842,6 +888,46 @@ libpcap_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec,
 static gboolean
 libpcap_read_packet(wtap *wth, FILE_T fh, wtap_rec *rec,
     Buffer *buf, int *err, gchar **err_info)
+{
+	libpcap_t *libpcap = (libpcap_t *)wth->priv;
+	guint packet_size;
+
+	if (!libpcap_read_packet_header(wth, fh, rec, &packet_size, err,
+	    err_info))
+		return FALSE;
+
+	if (wth->headers_only && fh == wth->fh) {
+		/*
+		 * Reading sequentially, for the record alone; skip
+		 * the packet data.
+		 */
+		if (!wtap_read_bytes(fh, NULL, packet_size, err, err_info))
+			return FALSE;	/* failed */
+
+		pcap_read_post_process(libpcap->variant == PCAP_NOKIA,
+		    wth->file_encap, rec, NULL, libpcap->byte_swapped, -1);
+		return TRUE;
+	}
+
+	/*
+	 * Read the packet data.
+	 */
+	if (!wtap_read_packet_bytes(fh, buf, packet_size, err, err_info))
+		return FALSE;	/* failed */
+
+	pcap_read_post_process(libpcap->variant == PCAP_NOKIA,
+	    wth->file_encap, rec, ws_buffer_start_ptr(buf),
+	    libpcap->byte_swapped, -1);
+	return TRUE;
+}
+
+/* Read the record header, and any pseudo-header, of the next packet,
+   and fill in the record, leaving the packet data to be read.
+
+   Return FALSE on an error, TRUE on success. */
+static gboolean
+libpcap_read_packet_header(wtap *wth, FILE_T fh, wtap_rec *rec,
+    guint *packet_size_ret, int *err, gchar **err_info)
 {
 	struct pcaprec_ss990915_hdr hdr;
 	guint packet_size;
@@ -926,14 +1012,7 @@ libpcap_read_packet(wtap *wth, FILE_T fh, wtap_rec *rec,
 	rec->rec_header.packet_header.caplen = packet_size;
 	rec->rec_header.packet_header.len = orig_size;
 
-	/*
-	 * Read the packet data.
-	 */
-	if (!wtap_read_packet_bytes(fh, buf, packet_size, err, err_info))
-		return FALSE;	/* failed */
-
-	pcap_read_post_process(is_nokia, wth->file_encap, rec,
-	    ws_buffer_start_ptr(buf), libpcap->byte_swapped, -1);
+	*packet_size_ret = packet_size;
 	return TRUE;
 }
 
@@ -105,6 +105,7 @@ add_idb_index_map(merge_in_file_t *in_file, const guint orig_index, const guint
  *
  * @param in_file_count number of entries in in_file_names
  * @param in_file_names filenames of the input files
+ * @param do_random TRUE if the files will be read randomly as well
  * @param out_files output pointer with filled file array, or NULL
  * @param err wiretap error, if failed
  * @param err_info wiretap error string, if failed
@@ -113,8 +114,9 @@ add_idb_index_map(merge_in_file_t *in_file, const guint orig_index, const guint
  */
 static gboolean
 merge_open_in_files(guint in_file_count, const char *const *in_file_names,
-                    merge_in_file_t **out_files, merge_progress_callback_t* cb,
-                    int *err, gchar **err_info, guint *err_fileno)
+                    gboolean do_random, merge_in_file_t **out_files,
+                    merge_progress_callback_t* cb, int *err, gchar **err_info,
+                    guint *err_fileno)
 {
     guint i;
     guint j;
@@ -127,7 +129,7 @@ merge_open_in_files(guint in_file_count, const char *const *in_file_names,
 
     for (i = 0; i < in_file_count; i++) {
         files[i].filename    = in_file_names[i];
-        files[i].wth         = wtap_open_offline(in_file_names[i], WTAP_TYPE_AUTO, err, err_info, FALSE);
+        files[i].wth         = wtap_open_offline(in_file_names[i], WTAP_TYPE_AUTO, err, err_info, do_random);
         files[i].state       = RECORD_NOT_PRESENT;
         files[i].packet_num  = 0;
 
@@ -206,22 +208,303 @@ merge_select_frame_type(int in_file_count, merge_in_file_t in_files[])
 }
 
 /*
- * returns TRUE if first argument is earlier than second
+ * Records are read from the input files ahead of the merge, by a pool
+ * of threads, into a ring of MERGE_READAHEAD_RECORDS records for each
+ * file; a file's ring is refilled once it's half empty, so that the
+ * merge seldom has to wait for a read.
+ */
+#define MERGE_READAHEAD_RECORDS 32
+
+/* The output file is written in pieces of this size. */
+#define MERGE_WRITE_BUF_SIZE    (1024 * 1024)
+
+typedef struct {
+    wtap_rec            rec;
+    Buffer              frame_buffer;
+    in_file_state_e     state;          /* RECORD_PRESENT, AT_EOF or GOT_ERROR */
+    int                 err;
+    gchar              *err_info;
+    GArray             *dsbs;           /* DSBs read along with the record */
+} merge_readahead_rec;
+
+typedef struct {
+    merge_in_file_t    *in_file;
+    GMutex              mutex;
+    GCond               cond;           /* signalled when a record is added */
+    merge_readahead_rec recs[MERGE_READAHEAD_RECORDS];
+    guint               first;          /* the first record read but not taken */
+    guint               count;          /* the number of records read but not taken */
+    gboolean            scheduled;      /* a reader is or will be filling the ring */
+    gboolean            done;           /* the reader has hit EOF or an error */
+    GArray             *dsbs;           /* DSBs read along with the current record */
+} merge_readahead;
+
+/*
+ * The state of a merge: the input files, the read-ahead rings, and, for
+ * a chronological merge, a heap of the input files that have a record,
+ * ordered so that the top one is the one merge_read_packet() would have
+ * picked by comparing all of them.
+ */
+typedef struct {
+    merge_in_file_t    *in_files;
+    guint               in_file_count;
+    merge_readahead    *readahead;
+    GThreadPool        *readers;
+    guint              *heap;
+    guint               heap_len;
+    guint               next_unread;    /* the first file not read from yet */
+    merge_in_file_t    *last;           /* the file the last record came from */
+} merge_reader;
+
+/* Fill a file's ring; runs in a reader thread. */
+static void
+merge_readahead_fill(gpointer data, gpointer user_data _U_)
+{
+    merge_readahead *ra = (merge_readahead *)data;
+    merge_in_file_t *in_file = ra->in_file;
+    merge_readahead_rec *rr;
+    gint64 data_offset;
+    gboolean got_rec;
+
+    for (;;) {
+        g_mutex_lock(&ra->mutex);
+        if (ra->count == MERGE_READAHEAD_RECORDS) {
+            ra->scheduled = FALSE;
+            g_mutex_unlock(&ra->mutex);
+            return;
+        }
+        /* Nobody else looks at the slots past the last record read. */
+        rr = &ra->recs[(ra->first + ra->count) % MERGE_READAHEAD_RECORDS];
+        g_mutex_unlock(&ra->mutex);
+
+        got_rec = wtap_read(in_file->wth, &rr->rec, &rr->frame_buffer,
+                            &rr->err, &rr->err_info, &data_offset);
+        if (got_rec)
+            rr->state = RECORD_PRESENT;
+        else
+            rr->state = rr->err != 0 ? GOT_ERROR : AT_EOF;
+
+        /* Hand over any DSBs read since the previous record, so that
+           they're written before this one, as they would be if we
+           weren't reading ahead. */
+        g_array_set_size(rr->dsbs, 0);
+        if (in_file->wth->dsbs) {
+            GArray *in_dsb = in_file->wth->dsbs;
+            for (; in_file->dsbs_seen < in_dsb->len; in_file->dsbs_seen++) {
+                wtap_block_t wblock = g_array_index(in_dsb, wtap_block_t, in_file->dsbs_seen);
+                g_array_append_val(rr->dsbs, wblock);
+            }
+        }
+
+        g_mutex_lock(&ra->mutex);
+        ra->count++;
+        if (!got_rec) {
+            ra->done = TRUE;
+            ra->scheduled = FALSE;
+        }
+        g_cond_signal(&ra->cond);
+        g_mutex_unlock(&ra->mutex);
+        if (!got_rec)
+            return;
+    }
+}
+
+/* Have a reader fill a file's ring, if none is and it's not at its end;
+   called with the mutex held. */
+static void
+merge_readahead_schedule(merge_reader *mr, merge_readahead *ra)
+{
+    if (!ra->scheduled && !ra->done) {
+        ra->scheduled = TRUE;
+        g_thread_pool_push(mr->readers, ra, NULL);
+    }
+}
+
+/*
+ * Take the next record read from a file, waiting for it if need be,
+ * and make it the file's current record.  Returns FALSE, with *err set,
+ * if there was a read error, and FALSE with *err set to 0 at EOF.
  */
 static gboolean
-is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
+merge_readahead_take(merge_reader *mr, guint i, int *err, gchar **err_info)
 {
-    if (l->secs > r->secs) {  /* left is later */
-        return FALSE;
-    } else if (l->secs < r->secs) { /* left is earlier */
-        return TRUE;
-    } else if (l->nsecs > r->nsecs) { /* tv_sec equal, l.usec later */
-        return FALSE;
+    merge_readahead *ra = &mr->readahead[i];
+    merge_in_file_t *in_file = &mr->in_files[i];
+    merge_readahead_rec *rr;
+    wtap_rec rec;
+    Buffer buf;
+    GArray *dsbs;
+
+    g_mutex_lock(&ra->mutex);
+    while (ra->count == 0) {
+        merge_readahead_schedule(mr, ra);
+        g_cond_wait(&ra->cond, &ra->mutex);
+    }
+    rr = &ra->recs[ra->first];
+    g_mutex_unlock(&ra->mutex);
+
+    /* Swap the record into the merge_in_file_t, and give the slot the
+       storage of the file's previous record to read into. */
+    rec = in_file->rec;
+    in_file->rec = rr->rec;
+    rr->rec = rec;
+    buf = in_file->frame_buffer;
+    in_file->frame_buffer = rr->frame_buffer;
+    rr->frame_buffer = buf;
+    dsbs = ra->dsbs;
+    ra->dsbs = rr->dsbs;
+    rr->dsbs = dsbs;
+    in_file->state = rr->state;
+    *err = rr->err;
+    *err_info = rr->err_info;
+    rr->err_info = NULL;
+
+    g_mutex_lock(&ra->mutex);
+    ra->first = (ra->first + 1) % MERGE_READAHEAD_RECORDS;
+    ra->count--;
+    if (ra->count <= MERGE_READAHEAD_RECORDS / 2)
+        merge_readahead_schedule(mr, ra);
+    g_mutex_unlock(&ra->mutex);
+
+    return in_file->state == RECORD_PRESENT;
+}
+
+static void
+merge_reader_init(merge_reader *mr, merge_in_file_t *in_files, guint in_file_count)
+{
+    guint i, j, num_threads;
+
+    mr->in_files = in_files;
+    mr->in_file_count = in_file_count;
+    mr->readahead = g_new0(merge_readahead, in_file_count);
+    for (i = 0; i < in_file_count; i++) {
+        merge_readahead *ra = &mr->readahead[i];
+
+        ra->in_file = &in_files[i];
+        g_mutex_init(&ra->mutex);
+        g_cond_init(&ra->cond);
+        for (j = 0; j < MERGE_READAHEAD_RECORDS; j++) {
+            wtap_rec_init(&ra->recs[j].rec);
+            ws_buffer_init(&ra->recs[j].frame_buffer, 1514);
+            ra->recs[j].dsbs = g_array_new(FALSE, FALSE, sizeof(wtap_block_t));
+        }
+        ra->dsbs = g_array_new(FALSE, FALSE, sizeof(wtap_block_t));
+    }
+    num_threads = MIN(in_file_count, g_get_num_processors());
+    mr->readers = g_thread_pool_new(merge_readahead_fill, mr, (gint)num_threads,
+                                    FALSE, NULL);
+    mr->heap = g_new(guint, in_file_count);
+    mr->heap_len = 0;
+    mr->next_unread = 0;
+    mr->last = NULL;
+}
+
+/* Start reading all the files, rather than each when it's first needed. */
+static void
+merge_reader_start_all(merge_reader *mr)
+{
+    guint i;
+
+    for (i = 0; i < mr->in_file_count; i++) {
+        g_mutex_lock(&mr->readahead[i].mutex);
+        merge_readahead_schedule(mr, &mr->readahead[i]);
+        g_mutex_unlock(&mr->readahead[i].mutex);
     }
-    /* either one < two or one == two
-     * either way, return one
-     */
-    return TRUE;
+}
+
+/* Stop the readers and free the rings; the files aren't closed. */
+static void
+merge_reader_cleanup(merge_reader *mr)
+{
+    guint i, j;
+
+    /* Drop the fills that haven't started, and wait for the rest. */
+    g_thread_pool_free(mr->readers, TRUE, TRUE);
+    for (i = 0; i < mr->in_file_count; i++) {
+        merge_readahead *ra = &mr->readahead[i];
+
+        for (j = 0; j < MERGE_READAHEAD_RECORDS; j++) {
+            wtap_rec_cleanup(&ra->recs[j].rec);
+            ws_buffer_free(&ra->recs[j].frame_buffer);
+            g_free(ra->recs[j].err_info);
+            g_array_free(ra->recs[j].dsbs, TRUE);
+        }
+        g_array_free(ra->dsbs, TRUE);
+        g_mutex_clear(&ra->mutex);
+        g_cond_clear(&ra->cond);
+    }
+    g_free(mr->readahead);
+    g_free(mr->heap);
+}
+
+/*
+ * Should file a's record be merged before file b's?
+ *
+ * Records without time stamps go first, lowest-numbered file first;
+ * records with equal time stamps go highest-numbered file first.  That's
+ * the order a scan of the files that picks a record without a time stamp
+ * as soon as it finds one, and otherwise the last record whose time
+ * stamp is no later than any seen before it, produces.
+ */
+static gboolean
+merge_heap_before(const merge_reader *mr, guint a, guint b)
+{
+    const wtap_rec *ra = &mr->in_files[a].rec;
+    const wtap_rec *rb = &mr->in_files[b].rec;
+    gboolean a_has_ts = (ra->presence_flags & WTAP_HAS_TS) != 0;
+    gboolean b_has_ts = (rb->presence_flags & WTAP_HAS_TS) != 0;
+
+    if (!a_has_ts || !b_has_ts) {
+        if (!a_has_ts && !b_has_ts)
+            return a < b;
+        return !a_has_ts;
+    }
+    if (ra->ts.secs != rb->ts.secs)
+        return ra->ts.secs < rb->ts.secs;
+    if (ra->ts.nsecs != rb->ts.nsecs)
+        return ra->ts.nsecs < rb->ts.nsecs;
+    return a > b;
+}
+
+static void
+merge_heap_push(merge_reader *mr, guint file)
+{
+    guint i = mr->heap_len++;
+
+    while (i > 0) {
+        guint parent = (i - 1) / 2;
+
+        if (!merge_heap_before(mr, file, mr->heap[parent]))
+            break;
+        mr->heap[i] = mr->heap[parent];
+        i = parent;
+    }
+    mr->heap[i] = file;
+}
+
+static guint
+merge_heap_pop(merge_reader *mr)
+{
+    guint top = mr->heap[0];
+    guint file, i, child;
+
+    file = mr->heap[--mr->heap_len];
+    i = 0;
+    for (;;) {
+        child = 2 * i + 1;
+        if (child >= mr->heap_len)
+            break;
+        if (child + 1 < mr->heap_len &&
+            merge_heap_before(mr, mr->heap[child + 1], mr->heap[child]))
+            child++;
+        if (!merge_heap_before(mr, mr->heap[child], file))
+            break;
+        mr->heap[i] = mr->heap[child];
+        i = child;
+    }
+    if (mr->heap_len > 0)
+        mr->heap[i] = file;
+    return top;
 }
 
 /** Read the next packet, in chronological order, from the set of files to
@@ -236,8 +519,7 @@ is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
  * On an EOF (meaning all the files are at EOF), set *err to 0 and return
  * NULL.
  *
- * @param in_file_count number of entries in in_files
- * @param in_files input file array
+ * @param mr the merge state
  * @param err wiretap error, if failed
  * @param err_info wiretap error string, if failed
  * @return pointer to merge_in_file_t for file from which that packet
@@ -245,80 +527,61 @@ is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
  * all files
  */
 static merge_in_file_t *
-merge_read_packet(int in_file_count, merge_in_file_t in_files[],
-                  int *err, gchar **err_info)
+merge_read_packet(merge_reader *mr, int *err, gchar **err_info)
 {
-    int i;
-    int ei = -1;
-    nstime_t tv = NSTIME_INIT_MAX;
-    wtap_rec *rec;
+    guint i;
 
     /*
-     * Make sure we have a record available from each file that's not at
-     * EOF, and search for the record with the earliest time stamp or
-     * with no time stamp (those records are treated as earlier than
-     * all other records).  Yes, this means you won't get a chronological
-     * merge of those records, but you obviously *can't* get that.
+     * Records with no time stamp are treated as earlier than all other
+     * records.  Yes, this means you won't get a chronological merge of
+     * those records, but you obviously *can't* get that.
+     *
+     * Get the next record from the file whose record we returned last,
+     * which is the only one that has none available.  The files are
+     * first read in order, and, as a scan of them would stop at the
+     * first record without a time stamp it finds, reading the rest
+     * waits until no record at the top lacks one; that keeps read errors
+     * being reported where they would be without the heap.
      */
-    for (i = 0; i < in_file_count; i++) {
-        gint64 data_offset;
-
-        if (in_files[i].state == RECORD_NOT_PRESENT) {
-            /*
-             * No packet available, and we haven't seen an error or EOF yet,
-             * so try to read the next packet.
-             */
-            if (!wtap_read(in_files[i].wth, &in_files[i].rec,
-                           &in_files[i].frame_buffer, err, err_info,
-                           &data_offset)) {
-                if (*err != 0) {
-                    in_files[i].state = GOT_ERROR;
-                    return &in_files[i];
-                }
-                in_files[i].state = AT_EOF;
-            } else
-                in_files[i].state = RECORD_PRESENT;
-        }
-
-        if (in_files[i].state == RECORD_PRESENT) {
-            rec = &in_files[i].rec;
-            if (!(rec->presence_flags & WTAP_HAS_TS)) {
-                /*
-                 * No time stamp.  Pick this record, and stop looking.
-                 */
-                ei = i;
-                break;
-            }
-            if (is_earlier(&rec->ts, &tv)) {
-                /*
-                 * This record's time stamp is earlier than any of the
-                 * records we've seen so far.  Pick it, for now, but
-                 * keep looking.
-                 */
-                tv = rec->ts;
-                ei = i;
-            }
-        }
+    if (mr->last != NULL) {
+        i = (guint)(mr->last - mr->in_files);
+        mr->last = NULL;
+        if (merge_readahead_take(mr, i, err, err_info))
+            merge_heap_push(mr, i);
+        else if (*err != 0)
+            return &mr->in_files[i];
+    }
+    while (mr->next_unread < mr->in_file_count &&
+           !(mr->heap_len > 0 &&
+             !(mr->in_files[mr->heap[0]].rec.presence_flags & WTAP_HAS_TS))) {
+        i = mr->next_unread++;
+        if (merge_readahead_take(mr, i, err, err_info))
+            merge_heap_push(mr, i);
+        else if (*err != 0)
+            return &mr->in_files[i];
     }
 
-    if (ei == -1) {
+    if (mr->heap_len == 0) {
         /* All the streams are at EOF.  Return an EOF indication. */
         *err = 0;
         return NULL;
     }
 
+    i = merge_heap_pop(mr);
+    mr->last = &mr->in_files[i];
+
     /* We'll need to read another packet from this file. */
-    in_files[ei].state = RECORD_NOT_PRESENT;
+    mr->in_files[i].state = RECORD_NOT_PRESENT;
 
     /* Count this packet. */
-    in_files[ei].packet_num++;
+    mr->in_files[i].packet_num++;
 
     /*
      * Return a pointer to the merge_in_file_t of the file from which the
      * packet was read.
      */
     *err = 0;
-    return &in_files[ei];
+    return &mr->in_files[i];
 }
 
 /** Read the next packet, in file sequence order, from the set of files
@@ -333,8 +596,7 @@ merge_read_packet(int in_file_count, merge_in_file_t in_files[],
  * On an EOF (meaning all the files are at EOF), set *err to 0 and return
  * NULL.
  *
- * @param in_file_count number of entries in in_files
- * @param in_files input file array
+ * @param mr the merge state
  * @param err wiretap error, if failed
  * @param err_info wiretap error string, if failed
  * @return pointer to merge_in_file_t for file from which that packet
@@ -342,31 +604,31 @@ merge_read_packet(int in_file_count, merge_in_file_t in_files[],
  * all files
  */
 static merge_in_file_t *
-merge_append_read_packet(int in_file_count, merge_in_file_t in_files[],
-                         int *err, gchar **err_info)
+merge_append_read_packet(merge_reader *mr, int *err, gchar **err_info)
 {
-    int i;
-    gint64 data_offset;
+    guint i;
 
     /*
      * Find the first file not at EOF, and read the next packet from it.
      */
-    for (i = 0; i < in_file_count; i++) {
-        if (in_files[i].state == AT_EOF)
+    for (i = 0; i < mr->in_file_count; i++) {
+        if (mr->in_files[i].state == AT_EOF)
             continue; /* This file is already at EOF */
-        if (wtap_read(in_files[i].wth, &in_files[i].rec,
-                      &in_files[i].frame_buffer, err, err_info,
-                      &data_offset))
+        if (merge_readahead_take(mr, i, err, err_info))
             break; /* We have a packet */
         if (*err != 0) {
             /* Read error - quit immediately. */
-            in_files[i].state = GOT_ERROR;
-            return &in_files[i];
+            return &mr->in_files[i];
+        }
+        /* EOF - the file is flagged as being at EOF; try the next one. */
+        if (i + 1 < mr->in_file_count) {
+            /* Start reading the next file while we finish this one. */
+            g_mutex_lock(&mr->readahead[i + 1].mutex);
+            merge_readahead_schedule(mr, &mr->readahead[i + 1]);
+            g_mutex_unlock(&mr->readahead[i + 1].mutex);
         }
-        /* EOF - flag this file as being at EOF, and try the next one. */
-        in_files[i].state = AT_EOF;
     }
-    if (i == in_file_count) {
+    if (i == mr->in_file_count) {
         /* All the streams are at EOF.  Return an EOF indication. */
         *err = 0;
         return NULL;
@@ -377,7 +639,7 @@ merge_append_read_packet(int in_file_count, merge_in_file_t in_files[],
      * packet was read.
      */
     *err = 0;
-    return &in_files[i];
+    return &mr->in_files[i];
 }
 
 
@@ -847,20 +1109,23 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
 {
     merge_result        status = MERGE_OK;
     merge_in_file_t    *in_file;
+    merge_reader        mr;
     int                 count = 0;
     gboolean            stop_flag = FALSE;
     wtap_rec *rec,      snap_rec;
 
+    merge_reader_init(&mr, in_files, in_file_count);
+    if (!do_append)
+        merge_reader_start_all(&mr);
+
     for (;;) {
         *err = 0;
 
         if (do_append) {
-            in_file = merge_append_read_packet(in_file_count, in_files, err,
-                                               err_info);
+            in_file = merge_append_read_packet(&mr, err, err_info);
         }
         else {
-            in_file = merge_read_packet(in_file_count, in_files, err,
-                                        err_info);
+            in_file = merge_read_packet(&mr, err, err_info);
         }
 
         if (in_file == NULL) {
@@ -933,12 +1198,11 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
          * If any DSBs were read before this record, be sure to pass those now
          * such that wtap_dump can pick it up.
          */
-        if (dsb_combined && in_file->wth->dsbs) {
-            GArray *in_dsb = in_file->wth->dsbs;
-            for (guint i = in_file->dsbs_seen; i < in_dsb->len; i++) {
+        if (dsb_combined) {
+            GArray *in_dsb = mr.readahead[in_file - in_files].dsbs;
+            for (guint i = 0; i < in_dsb->len; i++) {
                 wtap_block_t wblock = g_array_index(in_dsb, wtap_block_t, i);
                 g_array_append_val(dsb_combined, wblock);
-                in_file->dsbs_seen++;
             }
         }
 
@@ -949,6 +1213,9 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
         }
     }
 
+    /* Stop reading ahead before anything is closed. */
+    merge_reader_cleanup(&mr);
+
     if (cb)
         cb->callback_func(MERGE_EVENT_DONE, count, in_files, in_file_count, cb->data);
 
@@ -1016,7 +1283,7 @@ merge_files_common(const gchar* out_filename, /* normal output mode */
     merge_debug("merge_files: begin");
 
     /* open the input files */
-    if (!merge_open_in_files(in_file_count, in_filenames, &in_files, cb,
+    if (!merge_open_in_files(in_file_count, in_filenames, FALSE, &in_files, cb,
                              err, err_info, err_fileno)) {
         merge_debug("merge_files: merge_open_in_files() failed with err=%d", *err);
         *err_framenum = 0;
@@ -1045,6 +1312,7 @@ merge_files_common(const gchar* out_filename, /* normal output mode */
     wtap_dump_params params = WTAP_DUMP_PARAMS_INIT;
     params.encap = frame_type;
     params.snaplen = snaplen;
+    params.write_buf_size = MERGE_WRITE_BUF_SIZE;
     /*
      * Does this file type support identifying the interfaces on
      * which packets arrive?
@@ -1171,6 +1439,248 @@ merge_files_to_stdout(const int file_type, const char *const *in_filenames,
                               err_info, err_fileno, err_framenum);
 }
 
+/*
+ * A virtual merge: the input files are read as if they were the merged
+ * file, without it being written.  Records are read from the input files
+ * as they're needed, and read again from the file they came from; the
+ * offset of a record is the number of its file in the top bits and its
+ * offset in that file in the rest.
+ */
+#define MERGE_VIRTUAL_OFFSET_BITS   40
+#define MERGE_VIRTUAL_OFFSET_MASK   ((G_GINT64_CONSTANT(1) << MERGE_VIRTUAL_OFFSET_BITS) - 1)
+#define MERGE_VIRTUAL_MAX_FILES     (1U << (63 - MERGE_VIRTUAL_OFFSET_BITS))
+
+typedef struct {
+    merge_in_file_t    *in_files;
+    guint               in_file_count;
+    gboolean            do_append;
+    merge_reader        mr;             /* only the heap is used */
+    gint64             *data_offsets;   /* of the record each file has */
+    guint               next_file;      /* when appending, the file being read */
+} merge_virtual;
+
+/* Read the next record of file i into its merge_in_file_t. */
+static gboolean
+merge_virtual_fill(merge_virtual *mv, guint i, int *err, gchar **err_info)
+{
+    merge_in_file_t *in_file = &mv->in_files[i];
+
+    if (!wtap_read(in_file->wth, &in_file->rec, &in_file->frame_buffer,
+                   err, err_info, &mv->data_offsets[i])) {
+        in_file->state = (*err != 0) ? GOT_ERROR : AT_EOF;
+        return FALSE;
+    }
+    if (mv->data_offsets[i] & ~MERGE_VIRTUAL_OFFSET_MASK) {
+        *err = WTAP_ERR_BAD_FILE;
+        *err_info = g_strdup_printf("merge: %s is too big to be read without merging it",
+                                    in_file->filename);
+        in_file->state = GOT_ERROR;
+        return FALSE;
+    }
+    in_file->state = RECORD_PRESENT;
+    return TRUE;
+}
+
+static gboolean
+merge_virtual_map_interface_id(wtap_rec *rec, const merge_in_file_t *in_file,
+                               int *err, gchar **err_info)
+{
+    if (rec->rec_type == REC_TYPE_PACKET && !map_rec_interface_id(rec, in_file)) {
+        *err = WTAP_ERR_BAD_FILE;
+        *err_info = g_strdup_printf("merge: a record in %s has an interface ID with no interface",
+                                    in_file->filename);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static gboolean
+merge_virtual_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
+                   gchar **err_info, gint64 *data_offset)
+{
+    merge_virtual   *mv = (merge_virtual *)wth->priv;
+    merge_in_file_t *in_file;
+    wtap_rec         tmp_rec;
+    Buffer           tmp_buf;
+    guint            i;
+
+    if (mv->do_append) {
+        /* Read the files one after the other. */
+        for (;;) {
+            if (mv->next_file == mv->in_file_count)
+                return FALSE;   /* at EOF on all of them */
+            i = mv->next_file;
+            if (merge_virtual_fill(mv, i, err, err_info))
+                break;
+            if (*err != 0)
+                return FALSE;
+            mv->next_file++;
+        }
+    } else {
+        /* What merge_read_packet() does, reading only when needed. */
+        if (mv->mr.last != NULL) {
+            i = (guint)(mv->mr.last - mv->in_files);
+            mv->mr.last = NULL;
+            if (merge_virtual_fill(mv, i, err, err_info))
+                merge_heap_push(&mv->mr, i);
+            else if (*err != 0)
+                return FALSE;
+        }
+        while (mv->mr.next_unread < mv->in_file_count &&
+               !(mv->mr.heap_len > 0 &&
+                 !(mv->in_files[mv->mr.heap[0]].rec.presence_flags & WTAP_HAS_TS))) {
+            i = mv->mr.next_unread++;
+            if (merge_virtual_fill(mv, i, err, err_info))
+                merge_heap_push(&mv->mr, i);
+            else if (*err != 0)
+                return FALSE;
+        }
+        if (mv->mr.heap_len == 0)
+            return FALSE;       /* at EOF on all of them */
+        i = merge_heap_pop(&mv->mr);
+        mv->mr.last = &mv->in_files[i];
+    }
+
+    in_file = &mv->in_files[i];
+    in_file->state = RECORD_NOT_PRESENT;
+    in_file->packet_num++;
+    if (!merge_virtual_map_interface_id(&in_file->rec, in_file, err, err_info))
+        return FALSE;
+
+    /* Hand the record over, rather than copying it; the file's next
+       record is read into what the caller had. */
+    tmp_rec = *rec;
+    *rec = in_file->rec;
+    in_file->rec = tmp_rec;
+    tmp_buf = *buf;
+    *buf = in_file->frame_buffer;
+    in_file->frame_buffer = tmp_buf;
+
+    *data_offset = ((gint64)i << MERGE_VIRTUAL_OFFSET_BITS) | mv->data_offsets[i];
+    return TRUE;
+}
+
+static gboolean
+merge_virtual_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec,
+                        Buffer *buf, int *err, gchar **err_info)
+{
+    merge_virtual   *mv = (merge_virtual *)wth->priv;
+    guint64          i = (guint64)seek_off >> MERGE_VIRTUAL_OFFSET_BITS;
+    merge_in_file_t *in_file;
+
+    if (i >= mv->in_file_count) {
+        *err = WTAP_ERR_BAD_FILE;
+        *err_info = g_strdup("merge: record offset isn't in any of the files");
+        return FALSE;
+    }
+    in_file = &mv->in_files[i];
+    if (!wtap_seek_read(in_file->wth, seek_off & MERGE_VIRTUAL_OFFSET_MASK,
+                        rec, buf, err, err_info))
+        return FALSE;
+    return merge_virtual_map_interface_id(rec, in_file, err, err_info);
+}
+
+static void
+merge_virtual_sequential_close(wtap *wth)
+{
+    merge_virtual *mv = (merge_virtual *)wth->priv;
+    guint i;
+
+    for (i = 0; i < mv->in_file_count; i++)
+        wtap_sequential_close(mv->in_files[i].wth);
+}
+
+static void
+merge_virtual_close(wtap *wth)
+{
+    merge_virtual *mv = (merge_virtual *)wth->priv;
+
+    g_ptr_array_free(wth->members, TRUE);
+    wth->members = NULL;
+    merge_close_in_files(mv->in_file_count, mv->in_files);
+    g_free(mv->in_files);
+    g_free(mv->mr.heap);
+    g_free(mv->data_offsets);
+}
+
+/*
+ * Opens the files as a single virtual file, read in merged order, or in
+ * file order if do_append is set.  Returns NULL on failure.
+ */
+wtap *
+merge_open_virtual(const char *const *in_filenames, const guint in_file_count,
+                   const gboolean do_append, const idb_merge_mode mode,
+                   int *err, gchar **err_info, guint *err_fileno)
+{
+    merge_in_file_t *in_files;
+    merge_virtual   *mv;
+    wtapng_iface_descriptions_t *idb_inf;
+    wtap            *wth;
+    guint            i;
+
+    g_assert(in_file_count > 0);
+    g_assert(in_filenames != NULL);
+    g_assert(err != NULL);
+    g_assert(err_info != NULL);
+    g_assert(err_fileno != NULL);
+
+    if (in_file_count >= MERGE_VIRTUAL_MAX_FILES) {
+        *err = WTAP_ERR_INTERNAL;
+        *err_info = g_strdup_printf("merge: can't read more than %u files without merging them",
+                                    MERGE_VIRTUAL_MAX_FILES - 1);
+        *err_fileno = 0;
+        return NULL;
+    }
+
+    if (!merge_open_in_files(in_file_count, in_filenames, TRUE, &in_files,
+                             NULL, err, err_info, err_fileno)) {
+        merge_debug("merge_open_virtual: merge_open_in_files() failed with err=%d", *err);
+        return NULL;
+    }
+
+    mv = g_new0(merge_virtual, 1);
+    mv->in_files = in_files;
+    mv->in_file_count = in_file_count;
+    mv->do_append = do_append;
+    mv->mr.in_files = in_files;
+    mv->mr.in_file_count = in_file_count;
+    mv->mr.heap = g_new(guint, in_file_count);
+    mv->data_offsets = g_new0(gint64, in_file_count);
+
+    wth = g_new0(wtap, 1);
+    wth->members = g_ptr_array_sized_new(in_file_count);
+    wth->file_type_subtype = wtap_pcapng_file_type_subtype();
+    wth->file_encap = merge_select_frame_type(in_file_count, in_files);
+    wth->file_tsprec = wtap_file_tsprec(in_files[0].wth);
+    wth->snapshot_length = 0;
+    for (i = 0; i < in_file_count; i++) {
+        wtap *in_wth = in_files[i].wth;
+
+        /* The caller's names needn't outlive the open. */
+        in_files[i].filename = in_wth->pathname;
+        g_ptr_array_add(wth->members, in_wth);
+        if (wtap_file_tsprec(in_wth) != wth->file_tsprec)
+            wth->file_tsprec = WTAP_TSPREC_PER_PACKET;
+        if (in_wth->snapshot_length > wth->snapshot_length)
+            wth->snapshot_length = in_wth->snapshot_length;
+        if (in_wth->dsbs != NULL && wth->dsbs == NULL)
+            wth->dsbs = g_array_new(FALSE, FALSE, sizeof(wtap_block_t));
+    }
+    wth->shb_hdrs = wtap_file_get_shb_for_new_file(in_files[0].wth);
+    idb_inf = generate_merged_idbs(in_files, in_file_count, mode);
+    wth->interface_data = idb_inf->interface_data;
+    g_free(idb_inf);
+    wth->pathname = g_strdup(in_files[0].filename);
+
+    wth->priv = mv;
+    wth->subtype_read = merge_virtual_read;
+    wth->subtype_seek_read = merge_virtual_seek_read;
+    wth->subtype_sequential_close = merge_virtual_sequential_close;
+    wth->subtype_close = merge_virtual_close;
+
+    return wth;
+}
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
@@ -104,6 +104,9 @@ merge_idb_merge_mode_to_string(const int mode);
  * of the created merge info, in_file_count is the size of the array, data is
  * whatever was passed in the data member of this struct. The callback_func
  * routine's return value should be TRUE if merging should be aborted.
+ * While records are being merged, the input files are read ahead by
+ * other threads, so for MERGE_EVENT_RECORD_WAS_READ the callback should
+ * use in_files[i].wth only to get wtap_read_so_far().
  */
 typedef struct {
     gboolean (*callback_func)(merge_event event, int num,
@@ -202,6 +205,29 @@ merge_files_to_stdout(const int file_type, const char *const *in_filenames,
                       int *err, gchar **err_info, guint *err_fileno,
                       guint32 *err_framenum);
 
+/** Open the given input files as one virtual file, whose records are read
+ * in the order they would be in the merged file, without writing it
+ *
+ * The records are read again, randomly, from the input files; they must
+ * all stay open, and unchanged, until the virtual file is closed.  It
+ * has the merged IDBs, and the first file's SHB.
+ *
+ * @param in_filenames An array of input filenames to merge from
+ * @param in_file_count The number of entries in in_filenames
+ * @param do_append Whether to append by file order instead of chronological order
+ * @param mode The IDB_MERGE_MODE_XXX merge mode for interface data
+ * @param[out] err Set to the internal WTAP_ERR_XXX error code if it failed
+ * @param[out] err_info Additional information for some WTAP_ERR_XXX codes
+ * @param[out] err_fileno Set to the input file number which failed, if it
+ *   failed
+ * @return the virtual file, to be closed with wtap_close(), or NULL if it
+ *   failed
+ */
+WS_DLL_PUBLIC wtap *
+merge_open_virtual(const char *const *in_filenames, const guint in_file_count,
+                   const gboolean do_append, const idb_merge_mode mode,
+                   int *err, gchar **err_info, guint *err_fileno);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -2280,7 +2280,8 @@ pcap_read_post_process(gboolean is_nokia, int wtap_encap,
 			 * Guess the traffic type based on the packet
 			 * contents.
 			 */
-			atm_guess_traffic_type(rec, pd);
+			if (pd != NULL)
+				atm_guess_traffic_type(rec, pd);
 		} else {
 			/*
 			 * SunATM.
@@ -2289,7 +2290,8 @@ pcap_read_post_process(gboolean is_nokia, int wtap_encap,
 			 * type of LANE traffic it is based on the packet
 			 * contents.
 			 */
-			if (rec->rec_header.packet_header.pseudo_header.atm.type == TRAF_LANE)
+			if (pd != NULL &&
+			    rec->rec_header.packet_header.pseudo_header.atm.type == TRAF_LANE)
 				atm_guess_lane_type(rec, pd);
 		}
 		break;
@@ -2299,17 +2301,17 @@ pcap_read_post_process(gboolean is_nokia, int wtap_encap,
 		break;
 
 	case WTAP_ENCAP_SLL:
-		if (bytes_swapped)
+		if (bytes_swapped && pd != NULL)
 			pcap_byteswap_linux_sll_pseudoheader(rec, pd);
 		break;
 
 	case WTAP_ENCAP_USB_LINUX:
-		if (bytes_swapped)
+		if (bytes_swapped && pd != NULL)
 			pcap_byteswap_linux_usb_pseudoheader(rec, pd, FALSE);
 		break;
 
 	case WTAP_ENCAP_USB_LINUX_MMAPPED:
-		if (bytes_swapped)
+		if (bytes_swapped && pd != NULL)
 			pcap_byteswap_linux_usb_pseudoheader(rec, pd, TRUE);
 		break;
 
@@ -2323,7 +2325,7 @@ pcap_read_post_process(gboolean is_nokia, int wtap_encap,
 		break;
 
 	case WTAP_ENCAP_NFLOG:
-		if (bytes_swapped)
+		if (bytes_swapped && pd != NULL)
 			pcap_byteswap_nflog_pseudoheader(rec, pd);
 		break;
 
@@ -23,6 +23,8 @@ extern int pcap_process_pseudo_header(FILE_T fh, gboolean is_nokia,
     int wtap_encap, guint packet_size, wtap_rec *rec,
     int *err, gchar **err_info);
 
+/* pd is NULL if the packet data was skipped; only what doesn't depend
+   on the data is then done. */
 extern void pcap_read_post_process(gboolean is_nokia, int wtap_encap,
     wtap_rec *rec, guint8 *pd, gboolean bytes_swapped, int fcs_len);
 
@@ -48,6 +48,8 @@ pcapng_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
 static gboolean
 pcapng_seek_read(wtap *wth, gint64 seek_off,
                  wtap_rec *rec, Buffer *buf, int *err, gchar **err_info);
+static gboolean
+pcapng_read_batch(wtap *wth, wtap_batch *batch, int *err, gchar **err_info);
 static void
 pcapng_close(wtap *wth);
 
@@ -239,6 +241,10 @@ typedef struct {
     GArray *sections;             /**< Sections found in the capture file. */
     wtap_new_ipv4_callback_t add_new_ipv4;
     wtap_new_ipv6_callback_t add_new_ipv6;
+    wtap_batch *batch;            /**< Batch being read by pcapng_read_batch(), or NULL */
+    Buffer batch_window;          /**< Where in the batch packet data is being read */
+    gboolean in_batch_window;     /**< TRUE if the last block was read into batch_window */
+    gboolean skipped_data;        /**< TRUE if the packet data of the last block was skipped */
 } pcapng_t;
 
 /*
@@ -1275,7 +1281,6 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     guint8 *opt_ptr;
     pcapng_option_header_t *oh;
     guint8 *option_content;
-    gpointer option_content_copy;
     int pseudo_header_len;
     int fcslen;
 
@@ -1452,9 +1457,12 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     wblock->rec->ts.secs = (time_t)(ts / iface_info.time_units_per_second);
     wblock->rec->ts.nsecs = (int)(((ts % iface_info.time_units_per_second) * 1000000000) / iface_info.time_units_per_second);
 
-    /* "(Enhanced) Packet Block" read capture data */
-    if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
-                                packet.cap_len - pseudo_header_len, err, err_info))
+    /* "(Enhanced) Packet Block" read capture data, or skip it */
+    if (wblock->frame_buffer == NULL) {
+        if (!wtap_read_bytes(fh, NULL, packet.cap_len - pseudo_header_len, err, err_info))
+            return FALSE;
+    } else if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
+                                       packet.cap_len - pseudo_header_len, err, err_info))
         return FALSE;
     block_read += packet.cap_len - pseudo_header_len;
 
@@ -1465,17 +1473,18 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
         block_read += padding;
     }
 
-    /* Option defaults */
-    g_free(wblock->rec->opt_comment);   /* Free memory from an earlier read. */
-    wblock->rec->opt_comment = NULL;
+    /*
+     * Option defaults.  The comment and the array of verdicts from an
+     * earlier read are reused, rather than freed and allocated again for
+     * every packet; the comment is freed after the options if this packet
+     * has none.
+     */
     wblock->rec->rec_header.packet_header.drop_count  = -1;
     wblock->rec->rec_header.packet_header.pack_flags  = 0;
     wblock->rec->rec_header.packet_header.packet_id  = 0;
     wblock->rec->rec_header.packet_header.interface_queue  = 0;
-    if (wblock->rec->packet_verdict != NULL) {
-        g_ptr_array_free(wblock->rec->packet_verdict, TRUE);
-        wblock->rec->packet_verdict = NULL;
-    }
+    if (wblock->rec->packet_verdict != NULL)
+        g_ptr_array_set_size(wblock->rec->packet_verdict, 0);
 
     /* FCS length default */
     fcslen = iface_info.fcslen;
@@ -1543,8 +1552,9 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
             case(OPT_COMMENT):
                 if (oh->option_length > 0 && oh->option_length < opt_cont_buf_len) {
                     wblock->rec->presence_flags |= WTAP_HAS_COMMENTS;
-                    g_free(wblock->rec->opt_comment);
-                    wblock->rec->opt_comment = g_strndup((char *)option_content, oh->option_length);
+                    wblock->rec->opt_comment = (char *)g_realloc(wblock->rec->opt_comment, oh->option_length + 1);
+                    memcpy(wblock->rec->opt_comment, option_content, oh->option_length);
+                    wblock->rec->opt_comment[oh->option_length] = '\0';
                     pcapng_debug("pcapng_read_packet_block: length %u opt_comment '%s'", oh->option_length, wblock->rec->opt_comment);
                 } else {
                     pcapng_debug("pcapng_read_packet_block: opt_comment length %u seems strange", oh->option_length);
@@ -1658,12 +1668,9 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
                 if (option_content[0] > OPT_VERDICT_TYPE_XDP)
                     continue;
 
-                if (wblock->rec->packet_verdict == NULL) {
-                    wblock->rec->presence_flags |= WTAP_HAS_VERDICT;
+                if (wblock->rec->packet_verdict == NULL)
                     wblock->rec->packet_verdict = g_ptr_array_new_with_free_func((GDestroyNotify) g_bytes_unref);
-                }
-
-                option_content_copy = g_memdup2(option_content, oh->option_length);
+                wblock->rec->presence_flags |= WTAP_HAS_VERDICT;
 
                 /* For Linux XDP and TC we might need to byte swap */
                 if (section_info->byte_swapped &&
@@ -1677,10 +1684,7 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
                 }
 
                 g_ptr_array_add(wblock->rec->packet_verdict,
-                                g_bytes_new_with_free_func(option_content_copy,
-                                                           oh->option_length,
-                                                           g_free,
-                                                           option_content_copy));
+                                g_bytes_new(option_content, oh->option_length));
                 pcapng_debug("pcapng_read_packet_block: verdict type %u, data len %u",
                              option_content[0], oh->option_length - 1);
                 break;
@@ -1691,8 +1695,14 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
         }
     }
 
+    if (!(wblock->rec->presence_flags & WTAP_HAS_COMMENTS)) {
+        g_free(wblock->rec->opt_comment);
+        wblock->rec->opt_comment = NULL;
+    }
+
     pcap_read_post_process(FALSE, iface_info.wtap_encap,
-                           wblock->rec, ws_buffer_start_ptr(wblock->frame_buffer),
+                           wblock->rec,
+                           wblock->frame_buffer != NULL ? ws_buffer_start_ptr(wblock->frame_buffer) : NULL,
                            section_info->byte_swapped, fcslen);
 
     /*
@@ -1820,10 +1830,8 @@ pcapng_read_simple_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     wblock->rec->rec_header.packet_header.pack_flags = 0;
     wblock->rec->rec_header.packet_header.packet_id = 0;
     wblock->rec->rec_header.packet_header.interface_queue = 0;
-    if (wblock->rec->packet_verdict != NULL) {
-        g_ptr_array_free(wblock->rec->packet_verdict, TRUE);
-        wblock->rec->packet_verdict = NULL;
-    }
+    if (wblock->rec->packet_verdict != NULL)
+        g_ptr_array_set_size(wblock->rec->packet_verdict, 0);
 
     memset((void *)&wblock->rec->rec_header.packet_header.pseudo_header, 0, sizeof(union wtap_pseudo_header));
     pseudo_header_len = pcap_process_pseudo_header(fh,
@@ -1841,9 +1849,12 @@ pcapng_read_simple_packet_block(FILE_T fh, pcapng_block_header_t *bh,
 
     memset((void *)&wblock->rec->rec_header.packet_header.pseudo_header, 0, sizeof(union wtap_pseudo_header));
 
-    /* "Simple Packet Block" read capture data */
-    if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
-                                simple_packet.cap_len, err, err_info))
+    /* "Simple Packet Block" read capture data, or skip it */
+    if (wblock->frame_buffer == NULL) {
+        if (!wtap_read_bytes(fh, NULL, simple_packet.cap_len, err, err_info))
+            return FALSE;
+    } else if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
+                                       simple_packet.cap_len, err, err_info))
         return FALSE;
 
     /* jump over potential padding bytes at end of the packet data */
@@ -1853,7 +1864,8 @@ pcapng_read_simple_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     }
 
     pcap_read_post_process(FALSE, iface_info.wtap_encap,
-                           wblock->rec, ws_buffer_start_ptr(wblock->frame_buffer),
+                           wblock->rec,
+                           wblock->frame_buffer != NULL ? ws_buffer_start_ptr(wblock->frame_buffer) : NULL,
                            section_info->byte_swapped, iface_info.fcslen);
 
     /*
@@ -2640,8 +2652,10 @@ pcapng_read_block(wtap *wth, FILE_T fh, pcapng_t *pn,
 {
     block_return_val ret;
     pcapng_block_header_t bh;
+    Buffer *frame_buffer;
 
     wblock->block = NULL;
+    pn->skipped_data = FALSE;
 
     /* Try to read the (next) block header */
     if (!wtap_read_bytes_or_eof(fh, &bh, sizeof bh, err, err_info)) {
@@ -2716,6 +2730,36 @@ pcapng_read_block(wtap *wth, FILE_T fh, pcapng_t *pn,
             return FALSE;
         }
 
+        /*
+         * If we're reading sequentially for records alone, skip packet
+         * data; the packet block readers do so when given no buffer.
+         */
+        pn->skipped_data = (wth->headers_only && fh == wth->fh &&
+                            (bh.block_type == BLOCK_TYPE_EPB ||
+                             bh.block_type == BLOCK_TYPE_PB ||
+                             bh.block_type == BLOCK_TYPE_SPB));
+
+        if (pn->batch != NULL) {
+            /*
+             * We're reading a batch.  Read packet data, which is no
+             * longer than the block, straight into the batch; read
+             * anything else into its scratch buffer.
+             */
+            pn->in_batch_window = (!pn->skipped_data &&
+                                   (bh.block_type == BLOCK_TYPE_EPB ||
+                                    bh.block_type == BLOCK_TYPE_PB ||
+                                    bh.block_type == BLOCK_TYPE_SPB));
+            if (pn->in_batch_window) {
+                wtap_batch_reserve(pn->batch, &pn->batch_window, bh.block_total_length);
+                wblock->frame_buffer = &pn->batch_window;
+            } else {
+                wblock->frame_buffer = &pn->batch->scratch;
+            }
+        }
+        frame_buffer = wblock->frame_buffer;
+        if (pn->skipped_data)
+            wblock->frame_buffer = NULL;
+
         /*
          * ***DO NOT*** add any items to this table that are not
          * standardized block types in the current pcapng spec at
@@ -2770,6 +2814,7 @@ pcapng_read_block(wtap *wth, FILE_T fh, pcapng_t *pn,
                     return FALSE;
                 break;
         }
+        wblock->frame_buffer = frame_buffer;
     }
 
     /*
@@ -2973,8 +3018,13 @@ pcapng_open(wtap *wth, int *err, gchar **err_info)
     pcapng->add_new_ipv4 = NULL;
     pcapng->add_new_ipv6 = NULL;
 
+    pcapng->batch = NULL;
+    pcapng->in_batch_window = FALSE;
+    pcapng->skipped_data = FALSE;
+
     wth->subtype_read = pcapng_read;
     wth->subtype_seek_read = pcapng_seek_read;
+    wth->subtype_read_batch = pcapng_read_batch;
     wth->subtype_close = pcapng_close;
     wth->file_type_subtype = pcapng_file_type_subtype;
 
@@ -3045,8 +3095,7 @@ pcapng_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
     section_info_t *current_section, new_section;
     wtapng_block_t wblock;
     wtap_block_t wtapng_if_descr;
-    wtap_block_t if_stats;
-    wtapng_if_stats_mandatory_t *if_stats_mand_block, *if_stats_mand;
+    wtapng_if_stats_mandatory_t *if_stats_mand_block;
     wtapng_if_descr_mandatory_t *wtapng_if_descr_mand;
 
     wblock.frame_buffer  = buf;
@@ -3163,15 +3212,10 @@ pcapng_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
                         wtapng_if_descr_mand->interface_statistics = g_array_new(FALSE, FALSE, sizeof(wtap_block_t));
                     }
 
-                    if_stats = wtap_block_create(WTAP_BLOCK_IF_STATISTICS);
-                    if_stats_mand = (wtapng_if_stats_mandatory_t*)wtap_block_get_mandatory_data(if_stats);
-                    if_stats_mand->interface_id  = if_stats_mand_block->interface_id;
-                    if_stats_mand->ts_high       = if_stats_mand_block->ts_high;
-                    if_stats_mand->ts_low        = if_stats_mand_block->ts_low;
-
-                    wtap_block_copy(if_stats, wblock.block);
-                    g_array_append_val(wtapng_if_descr_mand->interface_statistics, if_stats);
+                    /* The interface takes the block as it was read. */
+                    g_array_append_val(wtapng_if_descr_mand->interface_statistics, wblock.block);
                     wtapng_if_descr_mand->num_stat_entries++;
+                    wblock.block = NULL;
                 }
                 wtap_block_free(wblock.block);
                 break;
@@ -3190,6 +3234,35 @@ pcapng_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
 }
 
 
+/* read as many records as fit in a batch */
+static gboolean
+pcapng_read_batch(wtap *wth, wtap_batch *batch, int *err, gchar **err_info)
+{
+    pcapng_t *pcapng = (pcapng_t *)wth->priv;
+    wtap_rec *rec;
+    gboolean ret = TRUE;
+
+    /* See pcapng_read_block(). */
+    pcapng->batch = batch;
+    while (batch->num_recs < batch->max_recs) {
+        rec = wtap_batch_start_rec(wth, batch, 0);
+        if (!pcapng_read(wth, rec, &batch->scratch, err, err_info,
+                         &batch->data_offsets[batch->num_recs])) {
+            ret = FALSE;
+            break;
+        }
+        if (pcapng->skipped_data) {
+            wtap_batch_end_rec(batch, NULL);
+        } else {
+            wtap_batch_end_rec(batch, pcapng->in_batch_window ?
+                                      &pcapng->batch_window : &batch->scratch);
+        }
+    }
+    pcapng->batch = NULL;
+    return ret;
+}
+
+
 /* classic wtap: seek to file position and read packet */
 static gboolean
 pcapng_seek_read(wtap *wth, gint64 seek_off,
@@ -3341,6 +3414,11 @@ typedef struct pcapng_write_block_t
 }
 pcapng_write_block_t;
 
+/* Per-file state for writing */
+typedef struct {
+    Buffer block;       /* the EPB being put together */
+} pcapng_dump_t;
+
 static gboolean pcapng_write_option_string(wtap_dumper *wdh, guint option_id, char *str, int *err)
 {
     struct pcapng_option_header option_hdr;
@@ -3563,11 +3641,33 @@ pcapng_write_section_header_block(wtap_dumper *wdh, int *err)
     return TRUE;
 }
 
+/* Append an option, with its padding, to a block being put together */
+static void
+pcapng_append_option(Buffer *block, guint16 type, const void *value, guint16 value_length)
+{
+    struct option option_hdr;
+    const guint32 zero_pad = 0;
+
+    option_hdr.type         = type;
+    option_hdr.value_length = value_length;
+    ws_buffer_append(block, (guint8 *)&option_hdr, 4);
+    ws_buffer_append(block, (guint8 *)value, value_length);
+    if (ROUND_TO_4BYTE(value_length) != value_length)
+        ws_buffer_append(block, (guint8 *)&zero_pad, ROUND_TO_4BYTE(value_length) - value_length);
+}
+
+/*
+ * EPBs are put together in a buffer kept with the dumper and written
+ * with one write; the lengths in the header and the trailer are filled
+ * in at the end, so the options are looked at only once.
+ */
 static gboolean
 pcapng_write_enhanced_packet_block(wtap_dumper *wdh, const wtap_rec *rec,
                                    const guint8 *pd, int *err, gchar **err_info)
 {
     const union wtap_pseudo_header *pseudo_header = &rec->rec_header.packet_header.pseudo_header;
+    pcapng_dump_t *pcapng = (pcapng_dump_t *)wdh->priv;
+    Buffer *block;
     pcapng_block_header_t bh;
     pcapng_enhanced_packet_block_t epb;
     guint64 ts;
@@ -3575,9 +3675,9 @@ pcapng_write_enhanced_packet_block(wtap_dumper *wdh, const wtap_rec *rec,
     guint32 pad_len;
     guint32 phdr_len;
     gboolean have_options = FALSE;
-    guint32 options_total_length = 0;
-    struct option option_hdr;
-    guint32 comment_len = 0, comment_pad_len = 0;
+    guint32 comment_len;
+    guint32 block_total_length;
+    guint8 *block_data;
     wtap_block_t int_data;
     wtapng_if_descr_mandatory_t *int_data_mand;
 
@@ -3594,57 +3694,6 @@ pcapng_write_enhanced_packet_block(wtap_dumper *wdh, const wtap_rec *rec,
         pad_len = 0;
     }
 
-    /* Check if we should write comment option */
-    if (rec->opt_comment) {
-        have_options = TRUE;
-        comment_len = (guint32)strlen(rec->opt_comment) & 0xffff;
-        if ((comment_len % 4)) {
-            comment_pad_len = 4 - (comment_len % 4);
-        } else {
-            comment_pad_len = 0;
-        }
-        options_total_length = options_total_length + comment_len + comment_pad_len + 4 /* comment options tag */ ;
-    }
-    if (rec->presence_flags & WTAP_HAS_PACK_FLAGS) {
-        have_options = TRUE;
-        options_total_length = options_total_length + 8;
-    }
-    if (rec->presence_flags & WTAP_HAS_DROP_COUNT) {
-        have_options = TRUE;
-        options_total_length = options_total_length + 12;
-    }
-    if (rec->presence_flags & WTAP_HAS_PACKET_ID) {
-        have_options = TRUE;
-        options_total_length = options_total_length + 12;
-    }
-    if (rec->presence_flags & WTAP_HAS_INT_QUEUE) {
-        have_options = TRUE;
-        options_total_length = options_total_length + 8;
-    }
-    if (rec->presence_flags & WTAP_HAS_VERDICT && rec->packet_verdict != NULL) {
-
-        for(guint i = 0; i < rec->packet_verdict->len; i++) {
-            gsize len;
-            GBytes *verdict = (GBytes *) g_ptr_array_index(rec->packet_verdict, i);
-
-            if (g_bytes_get_data(verdict, &len) && len != 0)
-                options_total_length += ROUND_TO_4BYTE(4 + len);
-        }
-        have_options = TRUE;
-    }
-    if (have_options) {
-        /* End-of options tag */
-        options_total_length += 4;
-    }
-
-    /* write (enhanced) packet block header */
-    bh.block_type = BLOCK_TYPE_EPB;
-    bh.block_total_length = (guint32)sizeof(bh) + (guint32)sizeof(epb) + phdr_len + rec->rec_header.packet_header.caplen + pad_len + options_total_length + 4;
-
-    if (!wtap_dump_file_write(wdh, &bh, sizeof bh, err))
-        return FALSE;
-    wdh->bytes_dumped += sizeof bh;
-
     /* write block fixed content */
     if (rec->presence_flags & WTAP_HAS_INTERFACE_ID)
         epb.interface_id        = rec->rec_header.packet_header.interface_id;
@@ -3690,29 +3739,26 @@ pcapng_write_enhanced_packet_block(wtap_dumper *wdh, const wtap_rec *rec,
     epb.captured_len        = rec->rec_header.packet_header.caplen + phdr_len;
     epb.packet_len          = rec->rec_header.packet_header.len + phdr_len;
 
-    if (!wtap_dump_file_write(wdh, &epb, sizeof epb, err))
-        return FALSE;
-    wdh->bytes_dumped += sizeof epb;
-
-    /* write pseudo header */
-    if (!pcap_write_phdr(wdh, rec->rec_header.packet_header.pkt_encap, pseudo_header, err)) {
-        return FALSE;
+    if (pcapng == NULL) {
+        pcapng = g_new(pcapng_dump_t, 1);
+        ws_buffer_init(&pcapng->block, 65536);
+        wdh->priv = pcapng;
     }
-    wdh->bytes_dumped += phdr_len;
+    block = &pcapng->block;
+    ws_buffer_clean(block);
 
-    /* write packet data */
-    if (!wtap_dump_file_write(wdh, pd, rec->rec_header.packet_header.caplen, err))
-        return FALSE;
-    wdh->bytes_dumped += rec->rec_header.packet_header.caplen;
+    /* (enhanced) packet block header; its length is filled in below */
+    bh.block_type = BLOCK_TYPE_EPB;
+    bh.block_total_length = 0;
+    ws_buffer_append(block, (guint8 *)&bh, sizeof bh);
+    ws_buffer_append(block, (guint8 *)&epb, sizeof epb);
 
-    /* write padding (if any) */
-    if (pad_len != 0) {
-        if (!wtap_dump_file_write(wdh, &zero_pad, pad_len, err))
-            return FALSE;
-        wdh->bytes_dumped += pad_len;
-    }
+    /* packet data (after the pseudo header, written below) and padding (if any) */
+    ws_buffer_append(block, (guint8 *)pd, rec->rec_header.packet_header.caplen);
+    if (pad_len != 0)
+        ws_buffer_append(block, (guint8 *)&zero_pad, pad_len);
 
-    /* XXX - write (optional) block options */
+    /* (optional) block options */
     /* options defined in Section 2.5 (Options)
      * Name           Code Length     Description
      * opt_comment    1    variable   A UTF-8 string containing a comment that is associated to the current block.
@@ -3763,71 +3809,29 @@ pcapng_write_enhanced_packet_block(wtap_dumper *wdh, const wtap_rec *rec,
      * opt_endofopt    0   0          It delimits the end of the optional fields. This block cannot be repeated within a given list of options.
      */
     if (rec->opt_comment) {
-        option_hdr.type         = OPT_COMMENT;
-        option_hdr.value_length = comment_len;
-        if (!wtap_dump_file_write(wdh, &option_hdr, 4, err))
-            return FALSE;
-        wdh->bytes_dumped += 4;
-
-        /* Write the comments string */
-        pcapng_debug("pcapng_write_enhanced_packet_block, comment:'%s' comment_len %u comment_pad_len %u" , rec->opt_comment, comment_len, comment_pad_len);
-        if (!wtap_dump_file_write(wdh, rec->opt_comment, comment_len, err))
-            return FALSE;
-        wdh->bytes_dumped += comment_len;
-
-        /* write padding (if any) */
-        if (comment_pad_len != 0) {
-            if (!wtap_dump_file_write(wdh, &zero_pad, comment_pad_len, err))
-                return FALSE;
-            wdh->bytes_dumped += comment_pad_len;
-        }
-
-        pcapng_debug("pcapng_write_enhanced_packet_block: Wrote Options comments: comment_len %u, comment_pad_len %u",
-                      comment_len,
-                      comment_pad_len);
+        have_options = TRUE;
+        comment_len = (guint32)strlen(rec->opt_comment) & 0xffff;
+        pcapng_debug("pcapng_write_enhanced_packet_block, comment:'%s' comment_len %u", rec->opt_comment, comment_len);
+        pcapng_append_option(block, OPT_COMMENT, rec->opt_comment, (guint16)comment_len);
     }
     if (rec->presence_flags & WTAP_HAS_PACK_FLAGS) {
-        option_hdr.type         = OPT_EPB_FLAGS;
-        option_hdr.value_length = 4;
-        if (!wtap_dump_file_write(wdh, &option_hdr, 4, err))
-            return FALSE;
-        wdh->bytes_dumped += 4;
-        if (!wtap_dump_file_write(wdh, &rec->rec_header.packet_header.pack_flags, 4, err))
-            return FALSE;
-        wdh->bytes_dumped += 4;
+        have_options = TRUE;
+        pcapng_append_option(block, OPT_EPB_FLAGS, &rec->rec_header.packet_header.pack_flags, 4);
         pcapng_debug("pcapng_write_enhanced_packet_block: Wrote Options packet flags: %x", rec->rec_header.packet_header.pack_flags);
     }
     if (rec->presence_flags & WTAP_HAS_DROP_COUNT) {
-        option_hdr.type         = OPT_EPB_DROPCOUNT;
-        option_hdr.value_length = 8;
-        if (!wtap_dump_file_write(wdh, &option_hdr, 4, err))
-            return FALSE;
-        wdh->bytes_dumped += 4;
-        if (!wtap_dump_file_write(wdh, &rec->rec_header.packet_header.drop_count, 8, err))
-            return FALSE;
-        wdh->bytes_dumped += 8;
+        have_options = TRUE;
+        pcapng_append_option(block, OPT_EPB_DROPCOUNT, &rec->rec_header.packet_header.drop_count, 8);
         pcapng_debug("pcapng_write_enhanced_packet_block: Wrote Options drop count: %" G_GINT64_MODIFIER "u", rec->rec_header.packet_header.drop_count);
     }
     if (rec->presence_flags & WTAP_HAS_PACKET_ID) {
-        option_hdr.type         = OPT_EPB_PACKETID;
-        option_hdr.value_length = 8;
-        if (!wtap_dump_file_write(wdh, &option_hdr, 4, err))
-            return FALSE;
-        wdh->bytes_dumped += 4;
-        if (!wtap_dump_file_write(wdh, &rec->rec_header.packet_header.packet_id, 8, err))
-            return FALSE;
-        wdh->bytes_dumped += 8;
+        have_options = TRUE;
+        pcapng_append_option(block, OPT_EPB_PACKETID, &rec->rec_header.packet_header.packet_id, 8);
         pcapng_debug("pcapng_write_enhanced_packet_block: Wrote Options packet id: %" G_GINT64_MODIFIER "u", rec->rec_header.packet_header.packet_id);
     }
     if (rec->presence_flags & WTAP_HAS_INT_QUEUE) {
-        option_hdr.type         = OPT_EPB_QUEUE;
-        option_hdr.value_length = 4;
-        if (!wtap_dump_file_write(wdh, &option_hdr, 4, err))
-            return FALSE;
-        wdh->bytes_dumped += 4;
-        if (!wtap_dump_file_write(wdh, &rec->rec_header.packet_header.interface_queue, 4, err))
-            return FALSE;
-        wdh->bytes_dumped += 4;
+        have_options = TRUE;
+        pcapng_append_option(block, OPT_EPB_QUEUE, &rec->rec_header.packet_header.interface_queue, 4);
         pcapng_debug("pcapng_write_enhanced_packet_block: Wrote Options queue: %u", rec->rec_header.packet_header.interface_queue);
     }
     if (rec->presence_flags & WTAP_HAS_VERDICT && rec->packet_verdict != NULL) {
@@ -3838,40 +3842,39 @@ pcapng_write_enhanced_packet_block(wtap_dumper *wdh, const wtap_rec *rec,
             const guint8 *verdict_data = (const guint8 *) g_bytes_get_data(verdict, &len);
 
             if (verdict_data && len != 0) {
-
-                option_hdr.type         = OPT_EPB_VERDICT;
-                option_hdr.value_length = (guint16) len;
-                if (!wtap_dump_file_write(wdh, &option_hdr, 4, err))
-                    return FALSE;
-                wdh->bytes_dumped += 4;
-                if (!wtap_dump_file_write(wdh, verdict_data, len, err))
-                    return FALSE;
-                wdh->bytes_dumped += len;
-
-                if (ROUND_TO_4BYTE(len) != len) {
-                    size_t plen = ROUND_TO_4BYTE(len) - len;
-
-                    if (!wtap_dump_file_write(wdh, &zero_pad, plen, err))
-                        return FALSE;
-                    wdh->bytes_dumped += plen;
-                }
+                pcapng_append_option(block, OPT_EPB_VERDICT, verdict_data, (guint16) len);
                 pcapng_debug("pcapng_write_enhanced_packet_block: Wrote Options verdict: %u",
                              verdict_data[0]);
             }
         }
+        have_options = TRUE;
     }
     /* Write end of options if we have options */
-    if (have_options) {
-        if (!wtap_dump_file_write(wdh, &zero_pad, 4, err))
+    if (have_options)
+        ws_buffer_append(block, (guint8 *)&zero_pad, 4);
+
+    /* block footer, and the length in the header and in it */
+    ws_buffer_append(block, (guint8 *)&zero_pad, 4);
+    block_total_length = (guint32)ws_buffer_length(block) + phdr_len;
+    block_data = ws_buffer_start_ptr(block);
+    memcpy(block_data + offsetof(pcapng_block_header_t, block_total_length), &block_total_length, 4);
+    memcpy(block_data + ws_buffer_length(block) - 4, &block_total_length, 4);
+
+    if (phdr_len != 0) {
+        /* pcap_write_phdr() writes the pseudo header to the file
+         * itself, between the fixed content and the packet data. */
+        if (!wtap_dump_file_write(wdh, block_data, sizeof bh + sizeof epb, err))
+            return FALSE;
+        if (!pcap_write_phdr(wdh, rec->rec_header.packet_header.pkt_encap, pseudo_header, err))
+            return FALSE;
+        block_data += sizeof bh + sizeof epb;
+        if (!wtap_dump_file_write(wdh, block_data, ws_buffer_length(block) - (sizeof bh + sizeof epb), err))
+            return FALSE;
+    } else {
+        if (!wtap_dump_file_write(wdh, block_data, ws_buffer_length(block), err))
             return FALSE;
-        wdh->bytes_dumped += 4;
     }
-
-    /* write block footer */
-    if (!wtap_dump_file_write(wdh, &bh.block_total_length,
-                              sizeof bh.block_total_length, err))
-        return FALSE;
-    wdh->bytes_dumped += sizeof bh.block_total_length;
+    wdh->bytes_dumped += block_total_length;
 
     return TRUE;
 }
@@ -5003,8 +5006,13 @@ static gboolean pcapng_dump(wtap_dumper *wdh,
 static gboolean pcapng_dump_finish(wtap_dumper *wdh, int *err,
                                    gchar **err_info _U_)
 {
+    pcapng_dump_t *pcapng = (pcapng_dump_t *)wdh->priv;
     guint i, j;
 
+    /* wtap_dump_close() frees the state itself. */
+    if (pcapng != NULL)
+        ws_buffer_free(&pcapng->block);
+
     /* Flush any hostname resolution info we may have */
     pcapng_write_name_resolution_block(wdh, err);
 
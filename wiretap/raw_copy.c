@@ -0,0 +1,416 @@
+/* raw_copy.c
+ * Routines for copying records of a pcap or pcapng file verbatim
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#ifdef HAVE_COPY_FILE_RANGE
+#define _GNU_SOURCE /* Otherwise copy_file_range() won't be declared on Linux */
+#endif
+
+#include <errno.h>
+#include <string.h>
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <wsutil/file_util.h>
+
+#include "wtap-int.h"
+#include "libpcap.h"
+#include "pcapng.h"
+#include "pcapng_module.h"
+#include "raw_copy.h"
+
+/* Size of the header of a pcap file, struct pcap_hdr plus the magic number */
+#define PCAP_FILE_HEADER_SIZE 24
+
+/* Size of the buffer for copying without copy_file_range() */
+#define RAW_COPY_BUFFER_SIZE (1024 * 1024)
+
+struct wtap_raw_copier {
+    int       in_fd;
+    int       out_fd;
+    gboolean  pcapng;
+    gboolean  byte_swapped;     /* current section of the input */
+    gint64    in_size;          /* size of the input when opened */
+    gint64    pos;              /* offset of the first input byte not yet dealt with */
+    gint64    run_start;        /* start of the input bytes before pos to copy, or -1 */
+    gboolean  use_copy_file_range;
+    guint8   *buf;
+};
+
+gboolean
+wtap_raw_copy_supported(int file_type_subtype)
+{
+    /* Other pcap variants have record headers of other sizes. */
+    return file_type_subtype == wtap_pcap_file_type_subtype() ||
+           file_type_subtype == wtap_pcap_nsec_file_type_subtype() ||
+           file_type_subtype == wtap_pcapng_file_type_subtype();
+}
+
+static guint32
+raw_copy_get_guint32(const wtap_raw_copier *copier, const guint8 *p)
+{
+    guint32 value;
+
+    memcpy(&value, p, sizeof value);
+    return copier->byte_swapped ? GUINT32_SWAP_LE_BE(value) : value;
+}
+
+static gboolean
+raw_copy_read_at(wtap_raw_copier *copier, gint64 offset, guint8 *buf,
+                 unsigned int count, int *err)
+{
+    unsigned int bytes_read = 0;
+    ssize_t nread;
+
+    if (ws_lseek64(copier->in_fd, offset, SEEK_SET) == -1) {
+        *err = errno;
+        return FALSE;
+    }
+    while (bytes_read < count) {
+        nread = ws_read(copier->in_fd, buf + bytes_read, count - bytes_read);
+        if (nread < 0) {
+            *err = errno;
+            return FALSE;
+        }
+        if (nread == 0) {
+            *err = WTAP_ERR_SHORT_READ;
+            return FALSE;
+        }
+        bytes_read += (unsigned int)nread;
+    }
+    return TRUE;
+}
+
+/* Append count bytes of the input, starting at offset, to the output. */
+static gboolean
+raw_copy_range(wtap_raw_copier *copier, gint64 offset, gint64 count, int *err)
+{
+    ssize_t nread, nwritten;
+
+#ifdef HAVE_COPY_FILE_RANGE
+    /* Let the kernel copy, or even share, the data without passing it
+       through our buffers. */
+    while (copier->use_copy_file_range && count > 0) {
+        off_t in_off = (off_t)offset;
+        ssize_t ncopied;
+
+        ncopied = copy_file_range(copier->in_fd, &in_off, copier->out_fd,
+                                  NULL, (size_t)count, 0);
+        if (ncopied < 0) {
+            if (errno == ENOSYS || errno == EXDEV || errno == EINVAL ||
+                errno == EOPNOTSUPP) {
+                /* Not for these files; copy them ourselves. */
+                copier->use_copy_file_range = FALSE;
+                break;
+            }
+            *err = errno;
+            return FALSE;
+        }
+        if (ncopied == 0) {
+            *err = WTAP_ERR_SHORT_READ;
+            return FALSE;
+        }
+        offset += ncopied;
+        count -= ncopied;
+    }
+    if (count == 0)
+        return TRUE;
+#endif
+
+    if (copier->buf == NULL)
+        copier->buf = (guint8 *)g_malloc(RAW_COPY_BUFFER_SIZE);
+    if (ws_lseek64(copier->in_fd, offset, SEEK_SET) == -1) {
+        *err = errno;
+        return FALSE;
+    }
+    while (count > 0) {
+        nread = ws_read(copier->in_fd, copier->buf,
+                        (unsigned int)MIN(count, RAW_COPY_BUFFER_SIZE));
+        if (nread < 0) {
+            *err = errno;
+            return FALSE;
+        }
+        if (nread == 0) {
+            *err = WTAP_ERR_SHORT_READ;
+            return FALSE;
+        }
+        nwritten = ws_write(copier->out_fd, copier->buf, (unsigned int)nread);
+        if (nwritten < nread) {
+            *err = nwritten < 0 ? errno : WTAP_ERR_SHORT_WRITE;
+            return FALSE;
+        }
+        count -= nread;
+    }
+    return TRUE;
+}
+
+/* Write out the run of input bytes to copy. */
+static gboolean
+raw_copy_flush(wtap_raw_copier *copier, int *err)
+{
+    gint64 run_start = copier->run_start;
+
+    copier->run_start = -1;
+    if (run_start < 0 || run_start == copier->pos)
+        return TRUE;
+    return raw_copy_range(copier, run_start, copier->pos - run_start, err);
+}
+
+/*
+ * Deal with the input bytes up to end: add them to the run to copy if
+ * they're wanted, otherwise write out that run and skip them.
+ */
+static gboolean
+raw_copy_advance(wtap_raw_copier *copier, gint64 end, gboolean wanted,
+                 int *err)
+{
+    if (wanted) {
+        if (copier->run_start < 0)
+            copier->run_start = copier->pos;
+    } else {
+        if (!raw_copy_flush(copier, err))
+            return FALSE;
+    }
+    copier->pos = end;
+    return TRUE;
+}
+
+/*
+ * Read the type and length of the pcapng block at offset; a Section
+ * Header Block also sets the byte order for the blocks that follow it.
+ */
+static gboolean
+raw_copy_pcapng_block(wtap_raw_copier *copier, gint64 offset, gint64 limit,
+                      guint32 *block_type, gint64 *block_len, int *err,
+                      gchar **err_info)
+{
+    guint8 hdr[12];
+    guint32 magic;
+
+    if (offset + (gint64)sizeof hdr > limit) {
+        *err = WTAP_ERR_BAD_FILE;
+        *err_info = g_strdup("pcapng: block header is cut short");
+        return FALSE;
+    }
+    if (!raw_copy_read_at(copier, offset, hdr, (unsigned int)sizeof hdr, err))
+        return FALSE;
+    memcpy(block_type, hdr, sizeof *block_type);
+    if (*block_type == BLOCK_TYPE_SHB) {
+        /* The type reads the same in either byte order. */
+        memcpy(&magic, hdr + 8, sizeof magic);
+        if (magic == PCAPNG_MAGIC) {
+            copier->byte_swapped = FALSE;
+        } else if (GUINT32_SWAP_LE_BE(magic) == PCAPNG_MAGIC) {
+            copier->byte_swapped = TRUE;
+        } else {
+            *err = WTAP_ERR_BAD_FILE;
+            *err_info = g_strdup("pcapng: unknown byte-order magic number");
+            return FALSE;
+        }
+    } else if (copier->byte_swapped) {
+        *block_type = GUINT32_SWAP_LE_BE(*block_type);
+    }
+    *block_len = raw_copy_get_guint32(copier, hdr + 4);
+    if (*block_len < 12 || offset + *block_len > limit) {
+        *err = WTAP_ERR_BAD_FILE;
+        *err_info = g_strdup_printf("pcapng: block at offset %" G_GINT64_MODIFIER "d has a bad length",
+                                    offset);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+wtap_raw_copier *
+wtap_raw_copy_open(const char *in_filename, int file_type_subtype,
+                   const char *out_filename, int *err, gchar **err_info)
+{
+    wtap_raw_copier *copier;
+    ws_statb64 statb;
+    guint8 hdr[4];
+    guint32 magic;
+
+    *err = 0;
+    *err_info = NULL;
+    if (!wtap_raw_copy_supported(file_type_subtype)) {
+        *err = WTAP_ERR_UNWRITABLE_FILE_TYPE;
+        return NULL;
+    }
+
+    copier = g_new0(wtap_raw_copier, 1);
+    copier->pcapng = file_type_subtype == wtap_pcapng_file_type_subtype();
+    copier->run_start = -1;
+#ifdef HAVE_COPY_FILE_RANGE
+    copier->use_copy_file_range = TRUE;
+#endif
+    copier->out_fd = -1;
+    copier->in_fd = ws_open(in_filename, O_RDONLY | O_BINARY, 0000);
+    if (copier->in_fd < 0 || ws_fstat64(copier->in_fd, &statb) < 0) {
+        *err = errno;
+        goto fail;
+    }
+    copier->in_size = statb.st_size;
+
+    if (!copier->pcapng) {
+        /* The records are in the byte order of the file header. */
+        if (!raw_copy_read_at(copier, 0, hdr, (unsigned int)sizeof hdr, err))
+            goto fail;
+        memcpy(&magic, hdr, sizeof magic);
+        if (magic == PCAP_MAGIC || magic == PCAP_NSEC_MAGIC) {
+            copier->byte_swapped = FALSE;
+        } else if (magic == PCAP_SWAPPED_MAGIC || magic == PCAP_SWAPPED_NSEC_MAGIC) {
+            copier->byte_swapped = TRUE;
+        } else {
+            *err = WTAP_ERR_BAD_FILE;
+            *err_info = g_strdup("pcap: not a file with standard record headers");
+            goto fail;
+        }
+    }
+
+    copier->out_fd = ws_open(out_filename, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666);
+    if (copier->out_fd < 0) {
+        *err = errno;
+        goto fail;
+    }
+    return copier;
+
+fail:
+    wtap_raw_copy_abort(copier);
+    return NULL;
+}
+
+gboolean
+wtap_raw_copy_record(wtap_raw_copier *copier, gint64 offset,
+                     gboolean wanted, int *err, gchar **err_info)
+{
+    guint8 rec_hdr[16];
+    guint32 block_type;
+    gint64 pos, rec_len;
+
+    *err = 0;
+    *err_info = NULL;
+    if (offset < copier->pos || offset >= copier->in_size) {
+        *err = WTAP_ERR_INTERNAL;
+        *err_info = g_strdup_printf("raw copy: record at offset %" G_GINT64_MODIFIER "d is out of order",
+                                    offset);
+        return FALSE;
+    }
+
+    /* Keep whatever precedes the record: the file header or, for
+       pcapng, blocks that aren't records. */
+    if (copier->pcapng) {
+        for (pos = copier->pos; pos < offset; pos += rec_len) {
+            if (!raw_copy_pcapng_block(copier, pos, offset, &block_type,
+                                       &rec_len, err, err_info))
+                return FALSE;
+        }
+    }
+    if (!raw_copy_advance(copier, offset, TRUE, err))
+        return FALSE;
+
+    if (copier->pcapng) {
+        if (!raw_copy_pcapng_block(copier, offset, copier->in_size,
+                                   &block_type, &rec_len, err, err_info))
+            return FALSE;
+    } else {
+        if (!raw_copy_read_at(copier, offset, rec_hdr, (unsigned int)sizeof rec_hdr, err))
+            return FALSE;
+        /* The header is followed by incl_len bytes of packet data. */
+        rec_len = (gint64)sizeof rec_hdr + raw_copy_get_guint32(copier, rec_hdr + 8);
+        if (offset + rec_len > copier->in_size) {
+            *err = WTAP_ERR_SHORT_READ;
+            return FALSE;
+        }
+    }
+    return raw_copy_advance(copier, offset + rec_len, wanted, err);
+}
+
+gboolean
+wtap_raw_copy_close(wtap_raw_copier *copier, int *err, gchar **err_info)
+{
+    guint32 block_type;
+    gint64 block_len;
+    gboolean keep;
+    int close_err;
+
+    *err = 0;
+    *err_info = NULL;
+
+    /* Keep the complete blocks after the last record that describe the
+       records before them, and the first section header if there were
+       no records; stop at anything else, which may be a record that was
+       being written when the file was read, or the start of a section
+       with no records. */
+    if (copier->pcapng) {
+        while (copier->pos + 12 <= copier->in_size) {
+            if (!raw_copy_pcapng_block(copier, copier->pos, copier->in_size,
+                                       &block_type, &block_len, err, err_info)) {
+                /* Probably cut short; just stop there. */
+                g_free(*err_info);
+                *err_info = NULL;
+                *err = 0;
+                break;
+            }
+            keep = block_type == BLOCK_TYPE_IDB || block_type == BLOCK_TYPE_NRB ||
+                   block_type == BLOCK_TYPE_ISB || block_type == BLOCK_TYPE_DSB ||
+                   (block_type == BLOCK_TYPE_SHB && copier->pos == 0);
+            if (!keep)
+                break;
+            if (!raw_copy_advance(copier, copier->pos + block_len, TRUE, err))
+                goto fail;
+        }
+    } else if (copier->pos < PCAP_FILE_HEADER_SIZE) {
+        /* There were no records; keep the file header. */
+        if (!raw_copy_advance(copier, MIN(PCAP_FILE_HEADER_SIZE, copier->in_size), TRUE, err))
+            goto fail;
+    }
+    if (!raw_copy_flush(copier, err))
+        goto fail;
+
+    ws_close(copier->in_fd);
+    close_err = ws_close(copier->out_fd) < 0 ? errno : 0;
+    g_free(copier->buf);
+    g_free(copier);
+    if (close_err != 0) {
+        *err = close_err;
+        return FALSE;
+    }
+    return TRUE;
+
+fail:
+    wtap_raw_copy_abort(copier);
+    return FALSE;
+}
+
+void
+wtap_raw_copy_abort(wtap_raw_copier *copier)
+{
+    if (copier->in_fd >= 0)
+        ws_close(copier->in_fd);
+    if (copier->out_fd >= 0)
+        ws_close(copier->out_fd);
+    g_free(copier->buf);
+    g_free(copier);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local Variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
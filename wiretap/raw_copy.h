@@ -0,0 +1,112 @@
+/* raw_copy.h
+ * Definitions for routines for copying records of a capture file verbatim.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __RAW_COPY_H__
+#define __RAW_COPY_H__
+
+#include "wiretap/wtap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * @brief Copies a subset of the records of a pcap or pcapng file.
+ *
+ * @details Instead of reading each record and writing it out again with
+ * wtap_dump(), the records that are wanted are copied byte for byte, with
+ * contiguous runs of them copied at once (with copy_file_range() where
+ * available). Everything else in the file is kept as it is: the file
+ * header, and for pcapng, all blocks that aren't records, such as
+ * section headers, interface descriptions, name resolution blocks and
+ * decryption secrets. The output is thus what writing the wanted records
+ * with wtap_dump() would give when nothing about them is to be changed.
+ *
+ * Only uncompressed files of the types for which
+ * wtap_raw_copy_supported() returns TRUE can be copied this way.
+ */
+typedef struct wtap_raw_copier wtap_raw_copier;
+
+/** Return whether records of files of the given type can be copied
+ * with a wtap_raw_copier.
+ *
+ * @param file_type_subtype The WTAP_FILE_TYPE_SUBTYPE_XXX file type
+ * @return TRUE if they can
+ */
+WS_DLL_PUBLIC gboolean
+wtap_raw_copy_supported(int file_type_subtype);
+
+/** Open a file to copy records of another, uncompressed, file to.
+ *
+ * @param in_filename The file to copy from
+ * @param file_type_subtype The WTAP_FILE_TYPE_SUBTYPE_XXX type of that file
+ * @param out_filename The file to create
+ * @param[out] err Set to the errno or WTAP_ERR_XXX error code on failure
+ * @param[out] err_info Additional information for some WTAP_ERR_XXX codes
+ * @return The copier, or NULL on failure
+ */
+WS_DLL_PUBLIC wtap_raw_copier *
+wtap_raw_copy_open(const char *in_filename, int file_type_subtype,
+                   const char *out_filename, int *err, gchar **err_info);
+
+/** Copy or skip the next record of the input file.
+ *
+ * Must be called for every record of the input file, in file order,
+ * with the offset that wtap_read() gave for it.
+ *
+ * @param copier The copier
+ * @param offset The offset of the record in the input file
+ * @param wanted Whether to copy the record
+ * @param[out] err Set to the errno or WTAP_ERR_XXX error code on failure
+ * @param[out] err_info Additional information for some WTAP_ERR_XXX codes
+ * @return TRUE on success
+ */
+WS_DLL_PUBLIC gboolean
+wtap_raw_copy_record(wtap_raw_copier *copier, gint64 offset,
+                     gboolean wanted, int *err, gchar **err_info);
+
+/** Finish the copy, and close both files.
+ *
+ * The blocks of a pcapng file that follow the last record and aren't
+ * records themselves, such as interface statistics, are copied too.
+ *
+ * @param copier The copier; freed
+ * @param[out] err Set to the errno or WTAP_ERR_XXX error code on failure
+ * @param[out] err_info Additional information for some WTAP_ERR_XXX codes
+ * @return TRUE on success
+ */
+WS_DLL_PUBLIC gboolean
+wtap_raw_copy_close(wtap_raw_copier *copier, int *err, gchar **err_info);
+
+/** Close both files of a copy that is not to be completed.
+ *
+ * @param copier The copier; freed
+ */
+WS_DLL_PUBLIC void
+wtap_raw_copy_abort(wtap_raw_copier *copier);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __RAW_COPY_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local Variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,413 @@
+/* time_index.c
+ * Routines for indices of the time stamps of capture files
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include "time_index.h"
+#include "wtap-int.h"
+#include "file_wrappers.h"
+#include "required_file_handlers.h"
+
+#include <wsutil/file_util.h>
+
+/* About how many bytes of records there are between entries */
+#define TIME_INDEX_SPACING  (1024 * 1024)
+
+/* Format of a saved index: all values are little-endian */
+#define TIME_INDEX_MAGIC    "WTAPTIDX"
+#define TIME_INDEX_VERSION  1
+
+typedef struct {
+    gint64   offset;        /* data offset of the first record of the entry */
+    guint32  rec_num;       /* number of records before it */
+    nstime_t max_before;    /* latest time stamp before it, unset if none */
+    nstime_t min_from;      /* earliest time stamp of the entry, and, once
+                               the index is complete, of all the later
+                               entries; unset if none */
+} time_index_entry_t;
+
+struct wtap_time_index {
+    GArray  *entries;       /* of time_index_entry_t */
+    gboolean started;       /* TRUE once a record has been added */
+    gboolean growing;       /* TRUE while sequential reads can be moved to
+                               the record being added */
+    gboolean complete;      /* TRUE once all the records have been added */
+    guint    num_shbs;      /* numbers of blocks read when the file */
+    guint    num_idbs;      /* was opened */
+    guint    num_dsbs;
+    guint32  num_recs;      /* records added */
+    nstime_t max_ts;        /* latest time stamp added, unset if none */
+    int      file_type_subtype;
+    gint64   file_size;     /* of the capture file, when complete */
+    gint64   file_mtime;
+};
+
+/* An unset time stamp is earlier than every other one in max_before, and
+   later than every other one in min_from. */
+static gboolean
+max_before_is_before(const time_index_entry_t *entry, const nstime_t *ts)
+{
+    return nstime_is_unset(&entry->max_before) ||
+           nstime_cmp(&entry->max_before, ts) < 0;
+}
+
+static gboolean
+min_from_is_at_or_after(const time_index_entry_t *entry, const nstime_t *ts)
+{
+    return nstime_is_unset(&entry->min_from) ||
+           nstime_cmp(&entry->min_from, ts) >= 0;
+}
+
+static guint
+num_blocks(GArray *blocks)
+{
+    return blocks != NULL ? blocks->len : 0;
+}
+
+/* Can the sequential read of a file be moved to a record? */
+static gboolean
+can_seek_sequential(wtap *wth)
+{
+    if (wth->ispipe)
+        return FALSE;
+    return wth->file_type_subtype == pcap_file_type_subtype ||
+           wth->file_type_subtype == pcap_nsec_file_type_subtype ||
+           wth->file_type_subtype == pcapng_file_type_subtype;
+}
+
+static gboolean
+get_file_identity(wtap *wth, gint64 *size, gint64 *mtime)
+{
+    ws_statb64 statb;
+
+    if (wth->pathname == NULL || ws_stat64(wth->pathname, &statb) != 0)
+        return FALSE;
+    *size = statb.st_size;
+    *mtime = statb.st_mtime;
+    return TRUE;
+}
+
+wtap_time_index *
+wtap_time_index_new(void)
+{
+    wtap_time_index *tidx = g_new0(wtap_time_index, 1);
+
+    tidx->entries = g_array_new(FALSE, FALSE, sizeof(time_index_entry_t));
+    nstime_set_unset(&tidx->max_ts);
+    return tidx;
+}
+
+void
+wtap_time_index_add(wtap_time_index *tidx, wtap *wth, const wtap_rec *rec,
+                    gint64 data_offset)
+{
+    time_index_entry_t *last = NULL;
+
+    if (tidx->complete)
+        return;
+
+    if (!tidx->started) {
+        tidx->started = TRUE;
+        tidx->growing = can_seek_sequential(wth);
+        tidx->num_shbs = num_blocks(wth->shb_hdrs);
+        tidx->num_idbs = num_blocks(wth->interface_data);
+        tidx->num_dsbs = num_blocks(wth->dsbs);
+        tidx->file_type_subtype = wth->file_type_subtype;
+    }
+
+    /*
+     * A block that had to be read before this record means the read
+     * can't be moved here, or anywhere later, without missing it.
+     */
+    if (tidx->growing &&
+        (num_blocks(wth->shb_hdrs) != tidx->num_shbs ||
+         num_blocks(wth->interface_data) != tidx->num_idbs ||
+         num_blocks(wth->dsbs) != tidx->num_dsbs))
+        tidx->growing = FALSE;
+
+    if (tidx->entries->len != 0)
+        last = &g_array_index(tidx->entries, time_index_entry_t, tidx->entries->len - 1);
+
+    if (tidx->growing &&
+        (last == NULL || data_offset - last->offset >= TIME_INDEX_SPACING)) {
+        time_index_entry_t entry;
+
+        entry.offset = data_offset;
+        entry.rec_num = tidx->num_recs;
+        entry.max_before = tidx->max_ts;
+        nstime_set_unset(&entry.min_from);
+        g_array_append_val(tidx->entries, entry);
+        last = &g_array_index(tidx->entries, time_index_entry_t, tidx->entries->len - 1);
+    }
+
+    tidx->num_recs++;
+    if (rec->presence_flags & WTAP_HAS_TS) {
+        if (nstime_is_unset(&tidx->max_ts) || nstime_cmp(&rec->ts, &tidx->max_ts) > 0)
+            tidx->max_ts = rec->ts;
+        if (last != NULL &&
+            (nstime_is_unset(&last->min_from) || nstime_cmp(&rec->ts, &last->min_from) < 0))
+            last->min_from = rec->ts;
+    }
+}
+
+void
+wtap_time_index_finish(wtap_time_index *tidx, wtap *wth)
+{
+    guint i;
+    nstime_t min_from = NSTIME_INIT_UNSET;
+
+    if (tidx->complete)
+        return;
+
+    if (!get_file_identity(wth, &tidx->file_size, &tidx->file_mtime)) {
+        /* It couldn't be checked when read back; don't let it be saved. */
+        g_array_set_size(tidx->entries, 0);
+    }
+
+    /* Make min_from the earliest time stamp from each entry on. */
+    for (i = tidx->entries->len; i-- != 0; ) {
+        time_index_entry_t *entry = &g_array_index(tidx->entries, time_index_entry_t, i);
+
+        if (!nstime_is_unset(&entry->min_from) &&
+            (nstime_is_unset(&min_from) || nstime_cmp(&entry->min_from, &min_from) < 0))
+            min_from = entry->min_from;
+        entry->min_from = min_from;
+    }
+    tidx->complete = TRUE;
+}
+
+gboolean
+wtap_time_index_seek(const wtap_time_index *tidx, wtap *wth,
+                     const nstime_t *start, guint32 *skipped, int *err)
+{
+    guint lo = 0, hi;
+    const time_index_entry_t *entry;
+
+    *skipped = 0;
+    if (!tidx->complete || tidx->entries->len == 0 || !can_seek_sequential(wth))
+        return TRUE;
+
+    /*
+     * max_before only grows from one entry to the next: find the last
+     * entry before which every record is earlier than the start.
+     */
+    hi = tidx->entries->len;
+    while (hi - lo > 1) {
+        guint mid = lo + (hi - lo) / 2;
+
+        if (max_before_is_before(&g_array_index(tidx->entries, time_index_entry_t, mid), start))
+            lo = mid;
+        else
+            hi = mid;
+    }
+    entry = &g_array_index(tidx->entries, time_index_entry_t, lo);
+    if (entry->rec_num == 0)
+        return TRUE;
+
+    if (file_seek(wth->fh, entry->offset, SEEK_SET, err) == -1)
+        return FALSE;
+    *skipped = entry->rec_num;
+    return TRUE;
+}
+
+gboolean
+wtap_time_index_stop_offset(const wtap_time_index *tidx,
+                            const nstime_t *stop, gint64 *offset)
+{
+    guint lo = 0, hi;
+
+    if (!tidx->complete || tidx->entries->len == 0)
+        return FALSE;
+
+    /*
+     * min_from only grows from one entry to the next: find the first
+     * entry from which every record is at or after the stop.
+     */
+    hi = tidx->entries->len;
+    while (lo < hi) {
+        guint mid = lo + (hi - lo) / 2;
+
+        if (min_from_is_at_or_after(&g_array_index(tidx->entries, time_index_entry_t, mid), stop))
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    if (lo == tidx->entries->len)
+        return FALSE;
+    *offset = g_array_index(tidx->entries, time_index_entry_t, lo).offset;
+    return TRUE;
+}
+
+static void
+put_le64(guint8 *p, guint64 value)
+{
+    value = GUINT64_TO_LE(value);
+    memcpy(p, &value, 8);
+}
+
+static void
+put_le32(guint8 *p, guint32 value)
+{
+    value = GUINT32_TO_LE(value);
+    memcpy(p, &value, 4);
+}
+
+static guint64
+get_le64(const guint8 *p)
+{
+    guint64 value;
+
+    memcpy(&value, p, 8);
+    return GUINT64_FROM_LE(value);
+}
+
+static guint32
+get_le32(const guint8 *p)
+{
+    guint32 value;
+
+    memcpy(&value, p, 4);
+    return GUINT32_FROM_LE(value);
+}
+
+/* magic, version, file type/subtype, entries, file size, mtime, spacing */
+#define TIME_INDEX_HEADER_LEN   (8 + 4 + 4 + 4 + 8 + 8 + 4)
+/* offset, record number, max_before, min_from */
+#define TIME_INDEX_ENTRY_LEN    (8 + 4 + 12 + 12)
+
+gboolean
+wtap_time_index_write(const wtap_time_index *tidx, const char *filename,
+                      int *err)
+{
+    FILE *fp;
+    guint8 buf[TIME_INDEX_HEADER_LEN];
+    guint i;
+
+    g_assert(tidx->complete);
+
+    fp = ws_fopen(filename, "wb");
+    if (fp == NULL) {
+        *err = errno;
+        return FALSE;
+    }
+
+    memcpy(buf, TIME_INDEX_MAGIC, 8);
+    put_le32(buf + 8, TIME_INDEX_VERSION);
+    put_le32(buf + 12, (guint32)tidx->file_type_subtype);
+    put_le32(buf + 16, tidx->entries->len);
+    put_le64(buf + 20, (guint64)tidx->file_size);
+    put_le64(buf + 28, (guint64)tidx->file_mtime);
+    put_le32(buf + 36, TIME_INDEX_SPACING);
+    if (fwrite(buf, 1, TIME_INDEX_HEADER_LEN, fp) != TIME_INDEX_HEADER_LEN)
+        goto write_error;
+
+    for (i = 0; i < tidx->entries->len; i++) {
+        const time_index_entry_t *entry = &g_array_index(tidx->entries, time_index_entry_t, i);
+
+        put_le64(buf, (guint64)entry->offset);
+        put_le32(buf + 8, entry->rec_num);
+        put_le64(buf + 12, (guint64)entry->max_before.secs);
+        put_le32(buf + 20, (guint32)entry->max_before.nsecs);
+        put_le64(buf + 24, (guint64)entry->min_from.secs);
+        put_le32(buf + 32, (guint32)entry->min_from.nsecs);
+        if (fwrite(buf, 1, TIME_INDEX_ENTRY_LEN, fp) != TIME_INDEX_ENTRY_LEN)
+            goto write_error;
+    }
+
+    if (fclose(fp) == EOF) {
+        *err = errno;
+        return FALSE;
+    }
+    return TRUE;
+
+write_error:
+    *err = ferror(fp) ? errno : WTAP_ERR_SHORT_WRITE;
+    fclose(fp);
+    return FALSE;
+}
+
+wtap_time_index *
+wtap_time_index_read(const char *filename, wtap *wth)
+{
+    FILE *fp;
+    guint8 buf[TIME_INDEX_HEADER_LEN];
+    guint32 num_entries, i;
+    gint64 file_size, file_mtime;
+    wtap_time_index *tidx;
+
+    if (!can_seek_sequential(wth) || !get_file_identity(wth, &file_size, &file_mtime))
+        return NULL;
+
+    fp = ws_fopen(filename, "rb");
+    if (fp == NULL)
+        return NULL;
+
+    if (fread(buf, 1, TIME_INDEX_HEADER_LEN, fp) != TIME_INDEX_HEADER_LEN ||
+        memcmp(buf, TIME_INDEX_MAGIC, 8) != 0 ||
+        get_le32(buf + 8) != TIME_INDEX_VERSION ||
+        get_le32(buf + 12) != (guint32)wth->file_type_subtype ||
+        (gint64)get_le64(buf + 20) != file_size ||
+        (gint64)get_le64(buf + 28) != file_mtime) {
+        fclose(fp);
+        return NULL;
+    }
+    num_entries = get_le32(buf + 16);
+
+    tidx = wtap_time_index_new();
+    for (i = 0; i < num_entries; i++) {
+        time_index_entry_t entry;
+
+        if (fread(buf, 1, TIME_INDEX_ENTRY_LEN, fp) != TIME_INDEX_ENTRY_LEN) {
+            wtap_time_index_free(tidx);
+            fclose(fp);
+            return NULL;
+        }
+        entry.offset = (gint64)get_le64(buf);
+        entry.rec_num = get_le32(buf + 8);
+        entry.max_before.secs = (time_t)get_le64(buf + 12);
+        entry.max_before.nsecs = (int)get_le32(buf + 20);
+        entry.min_from.secs = (time_t)get_le64(buf + 24);
+        entry.min_from.nsecs = (int)get_le32(buf + 32);
+        g_array_append_val(tidx->entries, entry);
+    }
+    fclose(fp);
+
+    tidx->started = TRUE;
+    tidx->complete = TRUE;
+    tidx->file_type_subtype = wth->file_type_subtype;
+    tidx->file_size = file_size;
+    tidx->file_mtime = file_mtime;
+    return tidx;
+}
+
+void
+wtap_time_index_free(wtap_time_index *tidx)
+{
+    if (tidx == NULL)
+        return;
+    g_array_free(tidx->entries, TRUE);
+    g_free(tidx);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,126 @@
+/* time_index.h
+ * Definitions for indices of the time stamps of capture files
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __TIME_INDEX_H__
+#define __TIME_INDEX_H__
+
+#include "wiretap/wtap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * A time index is a sparse map from time stamps to the offsets of the
+ * records of a capture file, with an entry about every megabyte, that
+ * lets a sequential read start at the first part of the file that can
+ * have records at or after a given time, and stop at the first part
+ * that has only records after another one, without reading what's
+ * before or after.  The records needn't be in time order: an entry keeps
+ * the latest time stamp of the records before it and the earliest one
+ * of the records from it on.
+ *
+ * An index is built by passing it every record read sequentially from a
+ * freshly opened file, and is only complete once the end of the file
+ * has been reached; it can be saved to a file of its own and read back
+ * as long as the capture file doesn't change.
+ *
+ * Sequential reads can only be moved for pcap and pcapng files, and, for
+ * pcapng files, only to records in the first section that come after
+ * all of its interface description and decryption secrets blocks;
+ * there are no entries for the rest of the file, which is read anyway.
+ */
+typedef struct wtap_time_index wtap_time_index;
+
+/** Create an empty time index. */
+WS_DLL_PUBLIC wtap_time_index *
+wtap_time_index_new(void);
+
+/** Add a record to an index being built.
+ *
+ * @param tidx the index
+ * @param wth the file being read, sequentially from its start
+ * @param rec the record just read
+ * @param data_offset its offset, as returned by wtap_read()
+ */
+WS_DLL_PUBLIC void
+wtap_time_index_add(wtap_time_index *tidx, wtap *wth, const wtap_rec *rec,
+                    gint64 data_offset);
+
+/** Mark an index as complete, once all the records of its file have
+ * been added. */
+WS_DLL_PUBLIC void
+wtap_time_index_finish(wtap_time_index *tidx, wtap *wth);
+
+/** Move the sequential read of a freshly opened file forward to the first
+ * part of it that can have records at or after a time.
+ *
+ * @param tidx a complete index for the file
+ * @param wth the file
+ * @param start the time
+ * @param[out] skipped the number of records skipped
+ * @param[out] err the error code if it fails
+ * @return FALSE if the file couldn't be seeked
+ */
+WS_DLL_PUBLIC gboolean
+wtap_time_index_seek(const wtap_time_index *tidx, wtap *wth,
+                     const nstime_t *start, guint32 *skipped, int *err);
+
+/** Get the offset from which all the records are at or after a time.
+ *
+ * @param tidx a complete index
+ * @param stop the time
+ * @param[out] offset the offset; records at or after it have data offsets
+ * at or after it
+ * @return FALSE if there's no such offset in the index
+ */
+WS_DLL_PUBLIC gboolean
+wtap_time_index_stop_offset(const wtap_time_index *tidx,
+                            const nstime_t *stop, gint64 *offset);
+
+/** Save a complete index to a file.
+ *
+ * @return FALSE, with *err set, on an error
+ */
+WS_DLL_PUBLIC gboolean
+wtap_time_index_write(const wtap_time_index *tidx, const char *filename,
+                      int *err);
+
+/** Read an index saved with wtap_time_index_write().
+ *
+ * @param filename the file it was saved to
+ * @param wth the capture file it's for
+ * @return the index, or NULL if it couldn't be read or it's not an index
+ * of the capture file as it is now
+ */
+WS_DLL_PUBLIC wtap_time_index *
+wtap_time_index_read(const char *filename, wtap *wth);
+
+WS_DLL_PUBLIC void
+wtap_time_index_free(wtap_time_index *tidx);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __TIME_INDEX_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -32,6 +32,8 @@ typedef gboolean (*subtype_read_func)(struct wtap*, wtap_rec *,
                                       Buffer *, int *, char **, gint64 *);
 typedef gboolean (*subtype_seek_read_func)(struct wtap*, gint64, wtap_rec *,
                                            Buffer *, int *, char **);
+typedef gboolean (*subtype_read_batch_func)(struct wtap*, wtap_batch *,
+                                            int *, char **);
 
 /**
  * Struct holding data of the currently read file.
@@ -55,6 +57,7 @@ struct wtap {
 
     subtype_read_func           subtype_read;
     subtype_seek_read_func      subtype_seek_read;
+    subtype_read_batch_func     subtype_read_batch;     /**< NULL if records are read one at a time */
     void                        (*subtype_sequential_close)(struct wtap*);
     void                        (*subtype_close)(struct wtap*);
     int                         file_encap;    /* per-file, for those
@@ -77,12 +80,15 @@ struct wtap {
     wtap_new_ipv6_callback_t    add_new_ipv6;
     wtap_new_secrets_callback_t add_new_secrets;
     GPtrArray                   *fast_seek;
+    gboolean                    headers_only;  /**< TRUE if sequential reads needn't read packet data */
+    GPtrArray                   *members;      /**< for a virtual file read from several files, their wtaps; otherwise NULL */
 };
 
 struct wtap_dumper;
 
 /*
- * This could either be a FILE * or a gzFile.
+ * This could either be a FILE * or a gzFile.  For zstd and LZ4, it's the
+ * FILE * that writes to the ws_cstream that compresses the data.
  */
 typedef void *WFILE_T;
 
@@ -96,6 +102,9 @@ typedef gboolean (*subtype_finish_func)(struct wtap_dumper*, int*, gchar**);
 
 struct wtap_dumper {
     WFILE_T                 fh;
+    struct ws_cstream       *cstream;        /* zstd or LZ4 compressor, or NULL */
+    gsize                   write_buf_size;  /* size of write_buf, or 0 */
+    guint8                  *write_buf;      /* standard I/O buffer for fh, or NULL */
     int                     file_type_subtype;
     int                     snaplen;
     int                     encap;
@@ -323,6 +332,28 @@ gboolean
 wtap_read_packet_bytes(FILE_T fh, Buffer *buf, guint length, int *err,
     gchar **err_info);
 
+/*
+ * Routines for implementations of wth->subtype_read_batch.
+ *
+ * For each record, call wtap_batch_start_rec() to get the wtap_rec to
+ * fill in, read the record, and call wtap_batch_end_rec() with the
+ * Buffer holding its data, or with NULL if its data was skipped because
+ * wth->headers_only is set.
+ *
+ * To read the data without copying it, call wtap_batch_reserve(), once
+ * the record's data is known to be no longer than a given length, to
+ * set up a Buffer, aliasing the end of the batch's buffer, to read it
+ * into; nothing may put more than that length into that Buffer.
+ */
+wtap_rec *
+wtap_batch_start_rec(wtap *wth, wtap_batch *batch, gint64 data_offset);
+
+void
+wtap_batch_reserve(wtap_batch *batch, Buffer *window, guint length);
+
+void
+wtap_batch_end_rec(wtap_batch *batch, Buffer *data);
+
 /*
  * Implementation of wth->subtype_read that reads the full file contents
  * as a single packet.
@@ -72,6 +72,18 @@ wtap_file_size(wtap *wth, int *err)
 {
 	ws_statb64 statb;
 
+	if (wth->members != NULL) {
+		/* A virtual file is as big as the files it's read from. */
+		gint64 size, total = 0;
+
+		for (guint i = 0; i < wth->members->len; i++) {
+			size = wtap_file_size((wtap *)g_ptr_array_index(wth->members, i), err);
+			if (size == -1)
+				return -1;
+			total += size;
+		}
+		return total;
+	}
 	if (file_fstat((wth->fh == NULL) ? wth->random_fh : wth->fh,
 	    &statb, err) == -1)
 		return -1;
@@ -84,6 +96,8 @@ wtap_file_size(wtap *wth, int *err)
 int
 wtap_fstat(wtap *wth, ws_statb64 *statb, int *err)
 {
+	if (wth->members != NULL)
+		return wtap_fstat((wtap *)g_ptr_array_index(wth->members, 0), statb, err);
 	if (file_fstat((wth->fh == NULL) ? wth->random_fh : wth->fh,
 	    statb, err) == -1)
 		return -1;
@@ -1421,12 +1435,58 @@ g_fast_seek_item_free(gpointer data, gpointer user_data _U_)
 void
 wtap_fdclose(wtap *wth)
 {
+	if (wth->members != NULL) {
+		for (guint i = 0; i < wth->members->len; i++)
+			wtap_fdclose((wtap *)g_ptr_array_index(wth->members, i));
+	}
 	if (wth->fh != NULL)
 		file_fdclose(wth->fh);
 	if (wth->random_fh != NULL)
 		file_fdclose(wth->random_fh);
 }
 
+GByteArray *
+wtap_get_seek_index(wtap *wth)
+{
+	if (wth->fast_seek == NULL)
+		return NULL;
+	return file_fast_seek_serialize(wth->fast_seek);
+}
+
+gboolean
+wtap_set_seek_index(wtap *wth, const guint8 *data, gsize len)
+{
+	if (wth->fast_seek == NULL)
+		return FALSE;
+	return file_fast_seek_deserialize(wth->fast_seek, data, len);
+}
+
+gboolean
+wtap_map_random_access(wtap *wth)
+{
+#ifdef _WIN32
+	/*
+	 * Windows won't let us rename a file that's mapped, even after
+	 * wtap_fdclose(), so don't.
+	 */
+	(void)wth;
+	return FALSE;
+#else
+	if (wth->members != NULL) {
+		gboolean mapped = TRUE;
+
+		for (guint i = 0; i < wth->members->len; i++) {
+			if (!wtap_map_random_access((wtap *)g_ptr_array_index(wth->members, i)))
+				mapped = FALSE;
+		}
+		return mapped;
+	}
+	if (wth->random_fh == NULL)
+		return FALSE;
+	return file_map(wth->random_fh);
+#endif
+}
+
 void
 wtap_close(wtap *wth)
 {
@@ -1457,18 +1517,33 @@ wtap_close(wtap *wth)
 
 void
 wtap_cleareof(wtap *wth) {
+	if (wth->members != NULL) {
+		for (guint i = 0; i < wth->members->len; i++)
+			wtap_cleareof((wtap *)g_ptr_array_index(wth->members, i));
+		return;
+	}
 	/* Reset EOF */
 	file_clearerr(wth->fh);
 }
 
 void wtap_set_cb_new_ipv4(wtap *wth, wtap_new_ipv4_callback_t add_new_ipv4) {
-	if (wth)
+	if (wth) {
 		wth->add_new_ipv4 = add_new_ipv4;
+		if (wth->members != NULL) {
+			for (guint i = 0; i < wth->members->len; i++)
+				wtap_set_cb_new_ipv4((wtap *)g_ptr_array_index(wth->members, i), add_new_ipv4);
+		}
+	}
 }
 
 void wtap_set_cb_new_ipv6(wtap *wth, wtap_new_ipv6_callback_t add_new_ipv6) {
-	if (wth)
+	if (wth) {
 		wth->add_new_ipv6 = add_new_ipv6;
+		if (wth->members != NULL) {
+			for (guint i = 0; i < wth->members->len; i++)
+				wtap_set_cb_new_ipv6((wtap *)g_ptr_array_index(wth->members, i), add_new_ipv6);
+		}
+	}
 }
 
 void wtap_set_cb_new_secrets(wtap *wth, wtap_new_secrets_callback_t add_new_secrets) {
@@ -1486,6 +1561,11 @@ void wtap_set_cb_new_secrets(wtap *wth, wtap_new_secrets_callback_t add_new_secr
 		wtap_block_t dsb = g_array_index(wth->dsbs, wtap_block_t, i);
 		wtapng_process_dsb(wth, dsb);
 	}
+	/* A virtual file's secrets are read by the files it's read from. */
+	if (wth->members != NULL) {
+		for (guint i = 0; i < wth->members->len; i++)
+			wtap_set_cb_new_secrets((wtap *)g_ptr_array_index(wth->members, i), add_new_secrets);
+	}
 }
 
 void
@@ -1535,7 +1615,7 @@ wtap_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
 		 * got enough compressed data to decompress the
 		 * last packet of the file.
 		 */
-		if (*err == 0)
+		if (*err == 0 && wth->fh != NULL)
 			*err = file_error(wth->fh, err_info);
 		return FALSE;	/* failure */
 	}
@@ -1563,6 +1643,170 @@ wtap_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
 	return TRUE;	/* success */
 }
 
+void
+wtap_set_headers_only(wtap *wth, gboolean headers_only)
+{
+	wth->headers_only = headers_only;
+}
+
+void
+wtap_set_read_ahead(wtap *wth, guint chunk_size)
+{
+	if (wth->members != NULL) {
+		for (guint i = 0; i < wth->members->len; i++)
+			wtap_set_read_ahead((wtap *)g_ptr_array_index(wth->members, i), chunk_size);
+		return;
+	}
+	file_set_read_ahead(wth->fh, chunk_size);
+}
+
+/*
+ * Get the length of the data for a record.
+ */
+static guint
+rec_data_len(const wtap_rec *rec)
+{
+	switch (rec->rec_type) {
+
+	case REC_TYPE_PACKET:
+		return rec->rec_header.packet_header.caplen;
+
+	case REC_TYPE_FT_SPECIFIC_EVENT:
+	case REC_TYPE_FT_SPECIFIC_REPORT:
+		return rec->rec_header.ft_specific_header.record_len;
+
+	case REC_TYPE_SYSCALL:
+		return rec->rec_header.syscall_header.event_filelen;
+
+	case REC_TYPE_SYSTEMD_JOURNAL:
+		return rec->rec_header.systemd_journal_header.record_len;
+	}
+	return 0;
+}
+
+wtap_rec *
+wtap_batch_start_rec(wtap *wth, wtap_batch *batch, gint64 data_offset)
+{
+	wtap_rec *rec = &batch->recs[batch->num_recs];
+
+	wtap_init_rec(wth, rec);
+	batch->data_offsets[batch->num_recs] = data_offset;
+	batch->buf_offsets[batch->num_recs] = ws_buffer_length(&batch->buf);
+	return rec;
+}
+
+void
+wtap_batch_reserve(wtap_batch *batch, Buffer *window, guint length)
+{
+	/*
+	 * The batch's buffer always starts at the beginning of its
+	 * allocation, so this never moves the data in it; with the
+	 * space there, ws_buffer_assure_space() on the window won't
+	 * touch it either.
+	 */
+	ws_buffer_assure_space(&batch->buf, length);
+	window->data = batch->buf.data;
+	window->allocated = batch->buf.allocated;
+	window->start = batch->buf.first_free;
+	window->first_free = batch->buf.first_free;
+}
+
+void
+wtap_batch_end_rec(wtap_batch *batch, Buffer *data)
+{
+	wtap_rec *rec = &batch->recs[batch->num_recs];
+	guint length;
+
+	/* Do the checks wtap_read() does. */
+	if (rec->rec_type == REC_TYPE_PACKET) {
+		if (rec->rec_header.packet_header.caplen > rec->rec_header.packet_header.len)
+			rec->rec_header.packet_header.caplen = rec->rec_header.packet_header.len;
+		g_assert(rec->rec_header.packet_header.pkt_encap != WTAP_ENCAP_PER_PACKET);
+	}
+
+	if (data == NULL) {
+		/* The data was skipped; see wtap_set_headers_only(). */
+		batch->num_recs++;
+		return;
+	}
+
+	length = rec_data_len(rec);
+	if (data->data == batch->buf.data &&
+	    data->start == batch->buf.first_free) {
+		/* It was read into a window from wtap_batch_reserve(). */
+		ws_buffer_increase_length(&batch->buf, length);
+	} else {
+		ws_buffer_append(&batch->buf, ws_buffer_start_ptr(data), length);
+	}
+	batch->num_recs++;
+}
+
+gboolean
+wtap_read_batch(wtap *wth, wtap_batch *batch, int *err, gchar **err_info)
+{
+	gboolean ret = TRUE;
+
+	batch->num_recs = 0;
+	ws_buffer_clean(&batch->buf);
+
+	*err = 0;
+	*err_info = NULL;
+	if (wth->subtype_read_batch != NULL) {
+		ret = wth->subtype_read_batch(wth, batch, err, err_info);
+	} else {
+		/*
+		 * Read the records one at a time, and copy their data
+		 * into the batch.
+		 */
+		while (batch->num_recs < batch->max_recs) {
+			wtap_rec *rec;
+
+			rec = wtap_batch_start_rec(wth, batch, 0);
+			if (!wth->subtype_read(wth, rec, &batch->scratch, err,
+			    err_info, &batch->data_offsets[batch->num_recs])) {
+				ret = FALSE;
+				break;
+			}
+			wtap_batch_end_rec(batch, &batch->scratch);
+		}
+	}
+	if (!ret && *err == 0 && wth->fh != NULL) {
+		/* See wtap_read(). */
+		*err = file_error(wth->fh, err_info);
+	}
+	return ret;
+}
+
+void
+wtap_batch_init(wtap_batch *batch, guint max_recs)
+{
+	guint i;
+
+	batch->max_recs = max_recs;
+	batch->num_recs = 0;
+	batch->recs = g_new(wtap_rec, max_recs);
+	for (i = 0; i < max_recs; i++)
+		wtap_rec_init(&batch->recs[i]);
+	batch->data_offsets = g_new(gint64, max_recs);
+	batch->buf_offsets = g_new(gsize, max_recs);
+	ws_buffer_init(&batch->buf, (gsize)max_recs * 1514);
+	ws_buffer_init(&batch->scratch, 1514);
+}
+
+void
+wtap_batch_cleanup(wtap_batch *batch)
+{
+	guint i;
+
+	for (i = 0; i < batch->max_recs; i++)
+		wtap_rec_cleanup(&batch->recs[i]);
+	g_free(batch->recs);
+	g_free(batch->data_offsets);
+	g_free(batch->buf_offsets);
+	ws_buffer_free(&batch->buf);
+	ws_buffer_free(&batch->scratch);
+}
+
 /*
  * Read a given number of bytes from a file into a buffer or, if
  * buf is NULL, just discard them.
@@ -1649,6 +1893,17 @@ wtap_read_packet_bytes(FILE_T fh, Buffer *buf, guint length, int *err,
 gint64
 wtap_read_so_far(wtap *wth)
 {
+	if (wth->members != NULL) {
+		gint64 total = 0;
+
+		for (guint i = 0; i < wth->members->len; i++) {
+			wtap *member = (wtap *)g_ptr_array_index(wth->members, i);
+
+			if (member->fh != NULL)
+				total += wtap_read_so_far(member);
+		}
+		return total;
+	}
 	return file_tell_raw(wth->fh);
 }
 
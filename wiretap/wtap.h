@@ -1350,6 +1350,28 @@ typedef struct {
     Buffer    options_buf;      /* file-type specific data */
 } wtap_rec;
 
+/*
+ * A batch of records, read with wtap_read_batch().
+ *
+ * The data for all the records in the batch is stored, one record after
+ * another, in one buffer; use wtap_batch_data() to get a pointer to a
+ * record's data.  The records, and that buffer, are reused by the next
+ * call to wtap_read_batch().
+ */
+typedef struct wtap_batch {
+    guint     max_recs;         /* maximum number of records in a batch */
+    guint     num_recs;         /* number of records in this batch */
+    wtap_rec  *recs;            /* the records */
+    gint64    *data_offsets;    /* offset of each record, for wtap_seek_read() */
+    gsize     *buf_offsets;     /* offset of each record's data in buf */
+    Buffer    buf;              /* data for all the records */
+    Buffer    scratch;          /* for readers that can't read into buf */
+} wtap_batch;
+
+/** Get a pointer to the data for a record in a batch. */
+#define wtap_batch_data(batch, i) \
+    (ws_buffer_start_ptr(&(batch)->buf) + (batch)->buf_offsets[(i)])
+
 /*
  * Bits in presence_flags, indicating which of the fields we have.
  *
@@ -1434,6 +1456,7 @@ typedef struct wtap_dump_params {
                                                  This array may grow since the dumper was opened and will subsequently
                                                  be written before newer packets are written in wtap_dump. */
     gboolean    dont_copy_idbs;             /**< XXX - don't copy IDBs; this should eventually always be the case. */
+    gsize       write_buf_size;             /**< Size of the buffer for writes to an uncompressed file, or 0 for the standard I/O default. */
 } wtap_dump_params;
 
 /* Zero-initializer for wtap_dump_params. */
@@ -1717,6 +1740,33 @@ typedef void (*wtap_new_secrets_callback_t)(guint32 secrets_type, const void *se
 WS_DLL_PUBLIC
 void wtap_set_cb_new_secrets(wtap *wth, wtap_new_secrets_callback_t add_new_secrets);
 
+/**
+ * Tell wiretap whether the caller of wtap_read() and wtap_read_batch()
+ * wants only the records, and not the data, of packets, e.g. to count
+ * them and their lengths and time stamps.  Readers that can do so then
+ * skip packet data instead of reading it, leaving the data Buffer of
+ * wtap_read() as it was and giving no data in a batch; others, and
+ * wtap_seek_read(), still read it.  Currently pcap and pcapng only.
+ *
+ * As the data isn't looked at, any pseudo-header fields that are
+ * guessed from it, as for some ATM traffic, aren't filled in.
+ */
+WS_DLL_PUBLIC
+void wtap_set_headers_only(wtap *wth, gboolean headers_only);
+
+/**
+ * Read the file ahead of wtap_read(), from a thread, in two chunks of
+ * chunk_size bytes, so that reading it, from a slow file system, say,
+ * and processing what's been read are done at the same time; 0 turns
+ * that off.  It's turned off while seeking, and doesn't affect
+ * wtap_seek_read().
+ *
+ * wtap_open_offline() starts it with chunks of as many megabytes as the
+ * WIRESHARK_READ_AHEAD environment variable gives, if it's set.
+ */
+WS_DLL_PUBLIC
+void wtap_set_read_ahead(wtap *wth, guint chunk_size);
+
 /** Read the next record in the file, filling in *phdr and *buf.
  *
  * @wth a wtap * returned by a call that opened a file for reading.
@@ -1736,6 +1786,36 @@ WS_DLL_PUBLIC
 gboolean wtap_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
     gchar **err_info, gint64 *offset);
 
+/** Read up to batch->max_recs records from the file, as wtap_read()
+ * would, into a batch.
+ *
+ * This saves the per-record overhead of wtap_read() and, for file
+ * types that support it, reads all the records' data into one buffer
+ * without copying it.
+ *
+ * @wth a wtap * returned by a call that opened a file for reading.
+ * @batch a batch initialized with wtap_batch_init(); batch->num_recs is
+ * set to the number of records read.
+ * @param err a positive "errno" value, or a negative number indicating
+ * the type of error, if the read failed.
+ * @param err_info for some errors, a string giving more details of
+ * the error
+ * @return TRUE if the batch was filled, FALSE if we got an EOF or an
+ * error first, with *err set to 0 on an EOF.  In either case, the
+ * records in the batch should be processed.
+ */
+WS_DLL_PUBLIC
+gboolean wtap_read_batch(wtap *wth, wtap_batch *batch, int *err,
+    gchar **err_info);
+
+/*** initialize a wtap_batch structure to hold up to max_recs records ***/
+WS_DLL_PUBLIC
+void wtap_batch_init(wtap_batch *batch, guint max_recs);
+
+/*** clean up a wtap_batch structure, freeing what wtap_batch_init() allocated */
+WS_DLL_PUBLIC
+void wtap_batch_cleanup(wtap_batch *batch);
+
 /** Read the record at a specified offset in a capture file, filling in
  * *phdr and *buf.
  *
@@ -1769,7 +1849,9 @@ void wtap_rec_cleanup(wtap_rec *rec);
  */
 typedef enum {
     WTAP_UNCOMPRESSED,
-    WTAP_GZIP_COMPRESSED
+    WTAP_GZIP_COMPRESSED,
+    WTAP_ZSTD_COMPRESSED,
+    WTAP_LZ4_COMPRESSED
 } wtap_compression_type;
 
 WS_DLL_PUBLIC
@@ -1958,6 +2040,41 @@ void wtap_fdclose(wtap *wth);
 WS_DLL_PUBLIC
 gboolean wtap_fdreopen(wtap *wth, const char *filename, int *err);
 
+/** Read the random stream through a memory mapping of the file, so that
+ * wtap_seek_read() needs no system calls.  The file must not grow after
+ * this is called; it should be called only once the file has been read
+ * completely.
+ *
+ * @param wth The wiretap session.
+ * @return TRUE if the file is now mapped, FALSE if it is compressed or
+ *         couldn't be mapped, in which case it's read as before.
+ */
+WS_DLL_PUBLIC
+gboolean wtap_map_random_access(wtap *wth);
+
+/** Get the points from which a compressed file can be decompressed,
+ * which are found as the file is read sequentially, so that they can
+ * be saved and handed to wtap_set_seek_index() when the file is opened
+ * again, rather than reading the file sequentially again to find them.
+ *
+ * @param wth The wiretap session.
+ * @return The seek points, serialized; free with g_byte_array_free().
+ *         NULL if the file wasn't opened for random access.
+ */
+WS_DLL_PUBLIC
+GByteArray *wtap_get_seek_index(wtap *wth);
+
+/** Replace the seek points for a file with ones saved from an earlier
+ * wtap_get_seek_index() call for the same file.
+ *
+ * @param wth The wiretap session.
+ * @param data The serialized seek points.
+ * @param len The length of the serialized seek points.
+ * @return TRUE on success, FALSE if they're not valid.
+ */
+WS_DLL_PUBLIC
+gboolean wtap_set_seek_index(wtap *wth, const guint8 *data, gsize len);
+
 /** Close only the sequential side, freeing up memory it uses. */
 WS_DLL_PUBLIC
 void wtap_sequential_close(wtap *wth);
@@ -18,6 +18,13 @@
 
 #include <wsutil/glib-compat.h>
 
+/*
+ * Option IDs below this, which is all of the standard pcapng ones, have
+ * their type, and the first instance in a block, looked up directly
+ * rather than through the hash table or by going through the options.
+ */
+#define WTAP_SMALL_OPTION_IDS 32
+
 #if 0
 #define wtap_debug(...) g_warning(__VA_ARGS__)
 #else
@@ -35,15 +42,13 @@ typedef struct {
     wtap_mand_free_func free_mand;
     wtap_mand_copy_func copy_mand;
     GHashTable *options;             /**< hash table of known options */
+    const struct wtap_opttype *small_options[WTAP_SMALL_OPTION_IDS]; /**< known options with small IDs */
 } wtap_blocktype_t;
 
-#define GET_OPTION_TYPE(options, option_id) \
-    (const wtap_opttype_t *)g_hash_table_lookup((options), GUINT_TO_POINTER(option_id))
-
 /*
  * Structure describing a type of option.
  */
-typedef struct {
+typedef struct wtap_opttype {
     const char *name;                            /**< name of option */
     const char *description;                     /**< human-readable description of option */
     wtap_opttype_e data_type;                    /**< data type of that option */
@@ -58,8 +63,20 @@ struct wtap_block
     wtap_blocktype_t* info;
     void* mandatory_data;
     GArray* options;
+    guint first_option[WTAP_SMALL_OPTION_IDS];  /**< index + 1 of the first instance of each small option ID, 0 if none */
 };
 
+static inline const wtap_opttype_t *
+wtap_blocktype_get_option_type(const wtap_blocktype_t *info, guint option_id)
+{
+    if (option_id < WTAP_SMALL_OPTION_IDS)
+        return info->small_options[option_id];
+    return (const wtap_opttype_t *)g_hash_table_lookup(info->options, GUINT_TO_POINTER(option_id));
+}
+
+#define GET_OPTION_TYPE(info, option_id) \
+    wtap_blocktype_get_option_type((info), (option_id))
+
 /* Keep track of wtap_blocktype_t's via their id number */
 static wtap_blocktype_t* blocktype_list[MAX_WTAP_BLOCK_TYPE_VALUE];
 
@@ -98,6 +115,7 @@ static void wtap_opttype_block_register(wtap_blocktype_t *blocktype)
     blocktype->options = g_hash_table_new(g_direct_hash, g_direct_equal);
     g_hash_table_insert(blocktype->options, GUINT_TO_POINTER(OPT_COMMENT),
                         (gpointer)&opt_comment);
+    blocktype->small_options[OPT_COMMENT] = &opt_comment;
 
     blocktype_list[block_type] = blocktype;
 }
@@ -106,6 +124,8 @@ static void wtap_opttype_option_register(wtap_blocktype_t *blocktype, guint optt
 {
     g_hash_table_insert(blocktype->options, GUINT_TO_POINTER(opttype),
                         (gpointer) option);
+    if (opttype < WTAP_SMALL_OPTION_IDS)
+        blocktype->small_options[opttype] = option;
 }
 
 wtap_block_type_t wtap_block_get_type(wtap_block_t block)
@@ -118,13 +138,43 @@ void* wtap_block_get_mandatory_data(wtap_block_t block)
     return block->mandatory_data;
 }
 
+/*
+ * Rebuild the index of the first instance of each small option ID, after
+ * options have been removed.
+ */
+static void
+wtap_block_index_options(wtap_block_t block)
+{
+    guint i;
+    wtap_option_t *opt;
+
+    memset(block->first_option, 0, sizeof block->first_option);
+    for (i = block->options->len; i > 0; i--) {
+        opt = &g_array_index(block->options, wtap_option_t, i - 1);
+        if (opt->option_id < WTAP_SMALL_OPTION_IDS)
+            block->first_option[opt->option_id] = i;
+    }
+}
+
+/* Where to start looking for the first instance of an option. */
+static guint
+wtap_block_option_start(wtap_block_t block, guint option_id)
+{
+    if (option_id < WTAP_SMALL_OPTION_IDS) {
+        if (block->first_option[option_id] == 0)
+            return block->options->len;
+        return block->first_option[option_id] - 1;
+    }
+    return 0;
+}
+
 static wtap_optval_t *
 wtap_block_get_option(wtap_block_t block, guint option_id)
 {
     guint i;
     wtap_option_t *opt;
 
-    for (i = 0; i < block->options->len; i++) {
+    for (i = wtap_block_option_start(block, option_id); i < block->options->len; i++) {
         opt = &g_array_index(block->options, wtap_option_t, i);
         if (opt->option_id == option_id)
             return &opt->value;
@@ -141,7 +191,7 @@ wtap_block_get_nth_option(wtap_block_t block, guint option_id, guint idx)
     guint opt_idx;
 
     opt_idx = 0;
-    for (i = 0; i < block->options->len; i++) {
+    for (i = wtap_block_option_start(block, option_id); i < block->options->len; i++) {
         opt = &g_array_index(block->options, wtap_option_t, i);
         if (opt->option_id == option_id) {
             if (opt_idx == idx)
@@ -162,7 +212,9 @@ wtap_block_t wtap_block_create(wtap_block_type_t block_type)
 
     block = g_new(struct wtap_block, 1);
     block->info = blocktype_list[block_type];
-    block->options = g_array_new(FALSE, FALSE, sizeof(wtap_option_t));
+    /* Most blocks have only a few options. */
+    block->options = g_array_sized_new(FALSE, FALSE, sizeof(wtap_option_t), 4);
+    memset(block->first_option, 0, sizeof block->first_option);
     block->info->create(block);
 
     return block;
@@ -172,7 +224,7 @@ static void wtap_block_free_option(wtap_block_t block, wtap_option_t *opt)
 {
     const wtap_opttype_t *opttype;
 
-    opttype = GET_OPTION_TYPE(block->info->options, opt->option_id);
+    opttype = GET_OPTION_TYPE(block->info, opt->option_id);
     switch (opttype->data_type) {
 
     case WTAP_OPTTYPE_STRING:
@@ -261,7 +313,7 @@ wtap_block_copy(wtap_block_t dest_block, wtap_block_t src_block)
     for (i = 0; i < src_block->options->len; i++)
     {
         src_opt = &g_array_index(src_block->options, wtap_option_t, i);
-        opttype = GET_OPTION_TYPE(src_block->info->options, src_opt->option_id);
+        opttype = GET_OPTION_TYPE(src_block->info, src_opt->option_id);
 
         switch(opttype->data_type) {
 
@@ -309,7 +361,7 @@ void wtap_block_foreach_option(wtap_block_t block, wtap_block_foreach_func func,
 
     for (i = 0; i < block->options->len; i++) {
         opt = &g_array_index(block->options, wtap_option_t, i);
-        opttype = GET_OPTION_TYPE(block->info->options, opt->option_id);
+        opttype = GET_OPTION_TYPE(block->info, opt->option_id);
         func(block, opt->option_id, opttype->data_type, &opt->value, user_data);
     }
 }
@@ -321,7 +373,7 @@ wtap_block_add_option_common(wtap_block_t block, guint option_id, wtap_opttype_e
     const wtap_opttype_t *opttype;
     guint i;
 
-    opttype = GET_OPTION_TYPE(block->info->options, option_id);
+    opttype = GET_OPTION_TYPE(block->info, option_id);
     if (opttype == NULL) {
         /* There's no option for this block with that option ID */
         return WTAP_OPTTYPE_NO_SUCH_OPTION;
@@ -359,6 +411,8 @@ wtap_block_add_option_common(wtap_block_t block, guint option_id, wtap_opttype_e
     g_array_set_size(block->options, i + 1);
     opt = &g_array_index(block->options, wtap_option_t, i);
     opt->option_id = option_id;
+    if (option_id < WTAP_SMALL_OPTION_IDS && block->first_option[option_id] == 0)
+        block->first_option[option_id] = i + 1;
     *optp = opt;
     return WTAP_OPTTYPE_SUCCESS;
 }
@@ -369,7 +423,7 @@ wtap_block_get_option_common(wtap_block_t block, guint option_id, wtap_opttype_e
     const wtap_opttype_t *opttype;
     wtap_optval_t *optval;
 
-    opttype = GET_OPTION_TYPE(block->info->options, option_id);
+    opttype = GET_OPTION_TYPE(block->info, option_id);
     if (opttype == NULL) {
         /* There's no option for this block with that option ID */
         return WTAP_OPTTYPE_NO_SUCH_OPTION;
@@ -411,7 +465,7 @@ wtap_block_get_nth_option_common(wtap_block_t block, guint option_id, wtap_optty
     const wtap_opttype_t *opttype;
     wtap_optval_t *optval;
 
-    opttype = GET_OPTION_TYPE(block->info->options, option_id);
+    opttype = GET_OPTION_TYPE(block->info, option_id);
     if (opttype == NULL) {
         /* There's no option for this block with that option ID */
         return WTAP_OPTTYPE_NO_SUCH_OPTION;
@@ -855,7 +909,7 @@ wtap_block_remove_option(wtap_block_t block, guint option_id)
     guint i;
     wtap_option_t *opt;
 
-    opttype = GET_OPTION_TYPE(block->info->options, option_id);
+    opttype = GET_OPTION_TYPE(block->info, option_id);
     if (opttype == NULL) {
         /* There's no option for this block with that option ID */
         return WTAP_OPTTYPE_NO_SUCH_OPTION;
@@ -871,13 +925,14 @@ wtap_block_remove_option(wtap_block_t block, guint option_id)
         return WTAP_OPTTYPE_NUMBER_MISMATCH;
     }
 
-    for (i = 0; i < block->options->len; i++) {
+    for (i = wtap_block_option_start(block, option_id); i < block->options->len; i++) {
         opt = &g_array_index(block->options, wtap_option_t, i);
         if (opt->option_id == option_id) {
             /* Found it - free up the value */
             wtap_block_free_option(block, opt);
             /* Remove the option from the array of options */
             g_array_remove_index(block->options, i);
+            wtap_block_index_options(block);
             return WTAP_OPTTYPE_SUCCESS;
         }
     }
@@ -895,7 +950,7 @@ wtap_block_remove_nth_option_instance(wtap_block_t block, guint option_id,
     wtap_option_t *opt;
     guint opt_idx;
 
-    opttype = GET_OPTION_TYPE(block->info->options, option_id);
+    opttype = GET_OPTION_TYPE(block->info, option_id);
     if (opttype == NULL) {
         /* There's no option for this block with that option ID */
         return WTAP_OPTTYPE_NO_SUCH_OPTION;
@@ -912,7 +967,7 @@ wtap_block_remove_nth_option_instance(wtap_block_t block, guint option_id,
     }
 
     opt_idx = 0;
-    for (i = 0; i < block->options->len; i++) {
+    for (i = wtap_block_option_start(block, option_id); i < block->options->len; i++) {
         opt = &g_array_index(block->options, wtap_option_t, i);
         if (opt->option_id == option_id) {
             if (opt_idx == idx) {
@@ -920,6 +975,7 @@ wtap_block_remove_nth_option_instance(wtap_block_t block, guint option_id,
                 wtap_block_free_option(block, opt);
                 /* Remove the option from the array of options */
                 g_array_remove_index(block->options, i);
+                wtap_block_index_options(block);
                 return WTAP_OPTTYPE_SUCCESS;
             }
             opt_idx++;
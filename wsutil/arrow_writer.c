@@ -0,0 +1,624 @@
+/* arrow_writer.c
+ * Routines for writing tables in the Apache Arrow IPC streaming format.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "arrow_writer.h"
+
+#include <string.h>
+
+/*
+ * See https://arrow.apache.org/docs/format/Columnar.html for the format.
+ * Each message is a continuation marker, the length of its metadata, the
+ * metadata, a Message flatbuffer (see Message.fbs and Schema.fbs in the
+ * Arrow sources), padded to a multiple of 8 bytes, and a body holding the
+ * buffers of the columns.
+ */
+#define ARROW_CONTINUATION      0xFFFFFFFFU
+#define ARROW_METADATA_V5       4
+
+/* MessageHeader union */
+#define ARROW_HEADER_SCHEMA         1
+#define ARROW_HEADER_RECORD_BATCH   3
+
+/* Type union */
+#define ARROW_FB_TYPE_INT           2
+#define ARROW_FB_TYPE_FLOATING      3
+#define ARROW_FB_TYPE_UTF8          5
+#define ARROW_FB_TYPE_BOOL          6
+#define ARROW_FB_TYPE_TIMESTAMP     10
+
+#define ARROW_PRECISION_DOUBLE      2
+#define ARROW_TIME_UNIT_NANOSECOND  3
+
+/*
+ * The UTF-8 offsets are 32-bit; a batch is written early, before the data
+ * of a string column can get near that.
+ */
+#define ARROW_MAX_STRING_DATA       (1U << 30)
+
+typedef struct {
+    char           *name;
+    arrow_type_e    type;
+    GByteArray     *validity;
+    GByteArray     *values;     /* for UTF8 columns, the offsets */
+    GByteArray     *data;       /* for UTF8 columns, the strings */
+    guint64         null_count;
+    gboolean        is_set;     /* in the current row */
+} arrow_column;
+
+struct arrow_writer {
+    FILE           *output_file;
+    guint           batch_rows;
+    GPtrArray      *columns;
+    guint           num_rows;   /* in the current batch */
+    gboolean        started;    /* schema written */
+    gboolean        error;
+};
+
+/*
+ * A minimal flatbuffer builder.  Flatbuffers are usually built back to
+ * front; since an offset to a table, string or vector must only point
+ * forward, this one writes each table first, with its vtable just before
+ * it, and whatever it refers to after it, patching the offsets in.
+ */
+typedef struct {
+    guint8  size;       /* 1, 2, 4 or 8 bytes; 0 if the field is absent */
+    guint64 value;
+} fb_field;
+
+static void
+fb_align(GByteArray *fb, guint align)
+{
+    static const guint8 zeroes[8] = { 0 };
+
+    if (fb->len % align != 0)
+        g_byte_array_append(fb, zeroes, align - fb->len % align);
+}
+
+static void
+fb_put(GByteArray *fb, guint pos, guint size, guint64 value)
+{
+    guint i;
+
+    for (i = 0; i < size; i++) {
+        fb->data[pos + i] = (guint8)value;
+        value >>= 8;
+    }
+}
+
+static guint
+fb_append(GByteArray *fb, guint size, guint64 value)
+{
+    guint pos = fb->len;
+
+    g_byte_array_set_size(fb, pos + size);
+    fb_put(fb, pos, size, value);
+    return pos;
+}
+
+/* Point the offset at "pos" to "target". */
+static void
+fb_patch(GByteArray *fb, guint pos, guint target)
+{
+    fb_put(fb, pos, 4, target - pos);
+}
+
+/*
+ * Write a table with fields 0 to num_fields - 1; the position of each
+ * field is put in field_pos, for its offset, if it's one, to be patched.
+ */
+static guint
+fb_table(GByteArray *fb, const fb_field *fields, guint num_fields, guint *field_pos)
+{
+    guint vtable_size = 4 + 2 * num_fields;
+    guint table_size = 4;
+    guint vtable, table;
+    guint i;
+
+    /* The table starts on a multiple of 8, so its fields can be aligned. */
+    while ((fb->len + vtable_size) % 8 != 0)
+        g_byte_array_append(fb, (const guint8 *)"", 1);
+
+    vtable = fb_append(fb, 2, vtable_size);
+    fb_append(fb, 2, 0);
+    for (i = 0; i < num_fields; i++) {
+        if (fields[i].size == 0) {
+            fb_append(fb, 2, 0);
+            continue;
+        }
+        table_size = (table_size + fields[i].size - 1) / fields[i].size * fields[i].size;
+        fb_append(fb, 2, table_size);
+        table_size += fields[i].size;
+    }
+    fb_put(fb, vtable + 2, 2, table_size);
+
+    table = fb_append(fb, 4, vtable_size);
+    g_byte_array_set_size(fb, table + table_size);
+    memset(fb->data + table + 4, 0, table_size - 4);
+    for (i = 0; i < num_fields; i++) {
+        guint off;
+
+        if (fields[i].size == 0)
+            continue;
+        off = fb->data[vtable + 4 + 2 * i] | fb->data[vtable + 5 + 2 * i] << 8;
+        field_pos[i] = table + off;
+        fb_put(fb, table + off, fields[i].size, fields[i].value);
+    }
+    return table;
+}
+
+static guint
+fb_string(GByteArray *fb, const char *str)
+{
+    guint len = (guint)strlen(str);
+    guint pos;
+
+    fb_align(fb, 4);
+    pos = fb_append(fb, 4, len);
+    g_byte_array_append(fb, (const guint8 *)str, len + 1);
+    return pos;
+}
+
+/* Write the length of a vector whose elements are aligned to "align". */
+static guint
+fb_vector(GByteArray *fb, guint count, guint align)
+{
+    while ((fb->len + 4) % align != 0)
+        g_byte_array_append(fb, (const guint8 *)"", 1);
+    return fb_append(fb, 4, count);
+}
+
+/* Begin a Message flatbuffer; its header is patched in by the caller,
+ * at the returned position. */
+static guint
+fb_message(GByteArray *fb, guint8 header_type, guint64 body_length)
+{
+    const fb_field fields[] = {
+        { 2, ARROW_METADATA_V5 },   /* version */
+        { 1, header_type },         /* header_type */
+        { 4, 0 },                   /* header */
+        { 8, body_length },         /* bodyLength */
+    };
+    guint field_pos[G_N_ELEMENTS(fields)];
+    guint root, table;
+
+    root = fb_append(fb, 4, 0);
+    table = fb_table(fb, fields, G_N_ELEMENTS(fields), field_pos);
+    fb_patch(fb, root, table);
+    return field_pos[2];
+}
+
+static void
+arrow_write(arrow_writer *writer, const void *data, gsize len)
+{
+    if (len != 0 && fwrite(data, 1, len, writer->output_file) != len)
+        writer->error = TRUE;
+}
+
+static void
+arrow_write_u32(arrow_writer *writer, guint32 value)
+{
+    value = GUINT32_TO_LE(value);
+    arrow_write(writer, &value, 4);
+}
+
+static void
+arrow_write_message(arrow_writer *writer, GByteArray *fb)
+{
+    fb_align(fb, 8);
+    arrow_write_u32(writer, ARROW_CONTINUATION);
+    arrow_write_u32(writer, fb->len);
+    arrow_write(writer, fb->data, fb->len);
+}
+
+static guint
+arrow_type_table(GByteArray *fb, arrow_type_e type, guint8 *type_type)
+{
+    fb_field fields[2];
+    guint field_pos[2];
+    guint table;
+
+    switch (type) {
+
+    case ARROW_TYPE_BOOL:
+        *type_type = ARROW_FB_TYPE_BOOL;
+        return fb_table(fb, NULL, 0, NULL);
+
+    case ARROW_TYPE_INT64:
+    case ARROW_TYPE_UINT32:
+    case ARROW_TYPE_UINT64:
+        *type_type = ARROW_FB_TYPE_INT;
+        fields[0].size = 4;     /* bitWidth */
+        fields[0].value = type == ARROW_TYPE_UINT32 ? 32 : 64;
+        fields[1].size = 1;     /* is_signed */
+        fields[1].value = type == ARROW_TYPE_INT64;
+        return fb_table(fb, fields, 2, field_pos);
+
+    case ARROW_TYPE_DOUBLE:
+        *type_type = ARROW_FB_TYPE_FLOATING;
+        fields[0].size = 2;     /* precision */
+        fields[0].value = ARROW_PRECISION_DOUBLE;
+        return fb_table(fb, fields, 1, field_pos);
+
+    case ARROW_TYPE_TIMESTAMP:
+        *type_type = ARROW_FB_TYPE_TIMESTAMP;
+        fields[0].size = 2;     /* unit */
+        fields[0].value = ARROW_TIME_UNIT_NANOSECOND;
+        fields[1].size = 4;     /* timezone */
+        fields[1].value = 0;
+        table = fb_table(fb, fields, 2, field_pos);
+        fb_patch(fb, field_pos[1], fb_string(fb, "UTC"));
+        return table;
+
+    default:
+        *type_type = ARROW_FB_TYPE_UTF8;
+        return fb_table(fb, NULL, 0, NULL);
+    }
+}
+
+static void
+arrow_write_schema(arrow_writer *writer)
+{
+    GByteArray *fb = g_byte_array_new();
+    const fb_field schema_fields[] = {
+        { 2, 0 },   /* endianness: Little */
+        { 4, 0 },   /* fields */
+    };
+    guint schema_pos[G_N_ELEMENTS(schema_fields)];
+    guint header, vector, i;
+
+    header = fb_message(fb, ARROW_HEADER_SCHEMA, 0);
+    fb_patch(fb, header, fb_table(fb, schema_fields, G_N_ELEMENTS(schema_fields), schema_pos));
+
+    vector = fb_vector(fb, writer->columns->len, 4);
+    fb_patch(fb, schema_pos[1], vector);
+    g_byte_array_set_size(fb, vector + 4 + 4 * writer->columns->len);
+
+    for (i = 0; i < writer->columns->len; i++) {
+        arrow_column *column = (arrow_column *)g_ptr_array_index(writer->columns, i);
+        fb_field fields[] = {
+            { 4, 0 },   /* name */
+            { 1, 1 },   /* nullable */
+            { 1, 0 },   /* type_type */
+            { 4, 0 },   /* type */
+            { 0, 0 },   /* dictionary */
+            { 4, 0 },   /* children */
+        };
+        guint field_pos[G_N_ELEMENTS(fields)];
+        guint8 type_type;
+        guint type_table;
+        guint table;
+
+        table = fb_table(fb, fields, G_N_ELEMENTS(fields), field_pos);
+        fb_patch(fb, vector + 4 + 4 * i, table);
+        fb_patch(fb, field_pos[0], fb_string(fb, column->name));
+        type_table = arrow_type_table(fb, column->type, &type_type);
+        fb->data[field_pos[2]] = type_type;
+        fb_patch(fb, field_pos[3], type_table);
+        /* Readers insist on the children, even if there are none. */
+        fb_patch(fb, field_pos[5], fb_vector(fb, 0, 4));
+    }
+
+    arrow_write_message(writer, fb);
+    g_byte_array_free(fb, TRUE);
+    writer->started = TRUE;
+}
+
+/* The buffers of a column, in the order of the record batch */
+static guint
+arrow_column_buffers(const arrow_column *column, const GByteArray **buffers)
+{
+    buffers[0] = column->validity;
+    buffers[1] = column->values;
+    if (column->type != ARROW_TYPE_UTF8)
+        return 2;
+    buffers[2] = column->data;
+    return 3;
+}
+
+static void
+arrow_write_batch(arrow_writer *writer)
+{
+    static const guint8 zeroes[8] = { 0 };
+    GByteArray *fb = g_byte_array_new();
+    const fb_field batch_fields[] = {
+        { 8, writer->num_rows },    /* length */
+        { 4, 0 },                   /* nodes */
+        { 4, 0 },                   /* buffers */
+    };
+    guint batch_pos[G_N_ELEMENTS(batch_fields)];
+    const GByteArray *buffers[3];
+    guint num_buffers = 0;
+    guint64 body_length = 0;
+    guint header, nodes, buffer_vector;
+    guint i, b, n;
+
+    for (i = 0; i < writer->columns->len; i++) {
+        n = arrow_column_buffers((arrow_column *)g_ptr_array_index(writer->columns, i), buffers);
+        for (b = 0; b < n; b++)
+            body_length += (buffers[b]->len + 7) / 8 * 8;
+        num_buffers += n;
+    }
+
+    header = fb_message(fb, ARROW_HEADER_RECORD_BATCH, body_length);
+    fb_patch(fb, header, fb_table(fb, batch_fields, G_N_ELEMENTS(batch_fields), batch_pos));
+
+    /* FieldNode and Buffer structs: two longs each */
+    nodes = fb_vector(fb, writer->columns->len, 8);
+    fb_patch(fb, batch_pos[1], nodes);
+    for (i = 0; i < writer->columns->len; i++) {
+        arrow_column *column = (arrow_column *)g_ptr_array_index(writer->columns, i);
+
+        fb_append(fb, 8, writer->num_rows);
+        fb_append(fb, 8, column->null_count);
+    }
+
+    buffer_vector = fb_vector(fb, num_buffers, 8);
+    fb_patch(fb, batch_pos[2], buffer_vector);
+    body_length = 0;
+    for (i = 0; i < writer->columns->len; i++) {
+        n = arrow_column_buffers((arrow_column *)g_ptr_array_index(writer->columns, i), buffers);
+        for (b = 0; b < n; b++) {
+            fb_append(fb, 8, body_length);
+            fb_append(fb, 8, buffers[b]->len);
+            body_length += (buffers[b]->len + 7) / 8 * 8;
+        }
+    }
+
+    arrow_write_message(writer, fb);
+    g_byte_array_free(fb, TRUE);
+
+    for (i = 0; i < writer->columns->len; i++) {
+        arrow_column *column = (arrow_column *)g_ptr_array_index(writer->columns, i);
+
+        n = arrow_column_buffers(column, buffers);
+        for (b = 0; b < n; b++) {
+            arrow_write(writer, buffers[b]->data, buffers[b]->len);
+            arrow_write(writer, zeroes, (8 - buffers[b]->len % 8) % 8);
+        }
+
+        g_byte_array_set_size(column->validity, 0);
+        g_byte_array_set_size(column->values, 0);
+        if (column->type == ARROW_TYPE_UTF8) {
+            g_byte_array_set_size(column->data, 0);
+            fb_append(column->values, 4, 0);
+        }
+        column->null_count = 0;
+    }
+    writer->num_rows = 0;
+}
+
+static void
+free_column(gpointer data)
+{
+    arrow_column *column = (arrow_column *)data;
+
+    g_free(column->name);
+    g_byte_array_free(column->validity, TRUE);
+    g_byte_array_free(column->values, TRUE);
+    if (column->data)
+        g_byte_array_free(column->data, TRUE);
+    g_free(column);
+}
+
+arrow_writer *
+arrow_writer_new(FILE *output_file, guint batch_rows)
+{
+    arrow_writer *writer = g_new0(arrow_writer, 1);
+
+    writer->output_file = output_file;
+    writer->batch_rows = batch_rows ? batch_rows : 1;
+    writer->columns = g_ptr_array_new_with_free_func(free_column);
+    return writer;
+}
+
+void
+arrow_writer_add_column(arrow_writer *writer, const char *name, arrow_type_e type)
+{
+    arrow_column *column = g_new0(arrow_column, 1);
+
+    g_assert(!writer->started);
+
+    column->name = g_strdup(name);
+    column->type = type;
+    column->validity = g_byte_array_new();
+    column->values = g_byte_array_new();
+    if (type == ARROW_TYPE_UTF8) {
+        column->data = g_byte_array_new();
+        fb_append(column->values, 4, 0);
+    }
+    g_ptr_array_add(writer->columns, column);
+}
+
+/*
+ * Get a column ready for a value in the current row, and get the position
+ * of a value of "size" bytes in its values; a value set again overwrites
+ * the previous one.
+ */
+static guint
+arrow_column_value(arrow_writer *writer, guint column_num, arrow_type_e type, guint size)
+{
+    arrow_column *column = (arrow_column *)g_ptr_array_index(writer->columns, column_num);
+    guint pos = writer->num_rows * size;
+
+    g_assert(column->type == type ||
+             (column->type == ARROW_TYPE_TIMESTAMP && type == ARROW_TYPE_INT64) ||
+             (column->type == ARROW_TYPE_UINT32 && type == ARROW_TYPE_UINT64));
+
+    if (!column->is_set) {
+        column->is_set = TRUE;
+        if (writer->num_rows % 8 == 0)
+            g_byte_array_append(column->validity, (const guint8 *)"", 1);
+        column->validity->data[writer->num_rows / 8] |= 1 << (writer->num_rows % 8);
+        g_byte_array_set_size(column->values, pos + size);
+    }
+    return pos;
+}
+
+void
+arrow_writer_set_bool(arrow_writer *writer, guint column_num, gboolean value)
+{
+    arrow_column *column = (arrow_column *)g_ptr_array_index(writer->columns, column_num);
+    guint row = writer->num_rows;
+
+    g_assert(column->type == ARROW_TYPE_BOOL);
+
+    if (!column->is_set) {
+        column->is_set = TRUE;
+        if (row % 8 == 0) {
+            g_byte_array_append(column->validity, (const guint8 *)"", 1);
+            g_byte_array_append(column->values, (const guint8 *)"", 1);
+        }
+        column->validity->data[row / 8] |= 1 << (row % 8);
+    }
+    if (value)
+        column->values->data[row / 8] |= 1 << (row % 8);
+    else
+        column->values->data[row / 8] &= ~(1 << (row % 8));
+}
+
+void
+arrow_writer_set_int64(arrow_writer *writer, guint column_num, gint64 value)
+{
+    arrow_column *column = (arrow_column *)g_ptr_array_index(writer->columns, column_num);
+    guint pos = arrow_column_value(writer, column_num, ARROW_TYPE_INT64, 8);
+
+    fb_put(column->values, pos, 8, (guint64)value);
+}
+
+void
+arrow_writer_set_uint64(arrow_writer *writer, guint column_num, guint64 value)
+{
+    arrow_column *column = (arrow_column *)g_ptr_array_index(writer->columns, column_num);
+    guint size = column->type == ARROW_TYPE_UINT32 ? 4 : 8;
+    guint pos = arrow_column_value(writer, column_num, ARROW_TYPE_UINT64, size);
+
+    fb_put(column->values, pos, size, value);
+}
+
+void
+arrow_writer_set_double(arrow_writer *writer, guint column_num, double value)
+{
+    arrow_column *column = (arrow_column *)g_ptr_array_index(writer->columns, column_num);
+    guint pos = arrow_column_value(writer, column_num, ARROW_TYPE_DOUBLE, 8);
+    guint64 bits;
+
+    memcpy(&bits, &value, 8);
+    fb_put(column->values, pos, 8, bits);
+}
+
+void
+arrow_writer_set_string(arrow_writer *writer, guint column_num, const char *value, gssize len)
+{
+    arrow_column *column = (arrow_column *)g_ptr_array_index(writer->columns, column_num);
+    guint row = writer->num_rows;
+    guint start;
+
+    g_assert(column->type == ARROW_TYPE_UTF8);
+
+    if (len < 0)
+        len = strlen(value);
+
+    if (!column->is_set) {
+        column->is_set = TRUE;
+        if (row % 8 == 0)
+            g_byte_array_append(column->validity, (const guint8 *)"", 1);
+        column->validity->data[row / 8] |= 1 << (row % 8);
+        fb_append(column->values, 4, 0);
+    }
+    /* The row's string starts where the previous row's ended. */
+    start = column->values->data[row * 4] | column->values->data[row * 4 + 1] << 8 |
+            column->values->data[row * 4 + 2] << 16 | (guint)column->values->data[row * 4 + 3] << 24;
+    g_byte_array_set_size(column->data, start);
+    g_byte_array_append(column->data, (const guint8 *)value, (guint)len);
+    fb_put(column->values, (row + 1) * 4, 4, column->data->len);
+}
+
+gboolean
+arrow_writer_end_row(arrow_writer *writer)
+{
+    gboolean full;
+    guint row = writer->num_rows;
+    guint i;
+
+    if (!writer->started)
+        arrow_write_schema(writer);
+
+    full = writer->num_rows + 1 >= writer->batch_rows;
+    for (i = 0; i < writer->columns->len; i++) {
+        arrow_column *column = (arrow_column *)g_ptr_array_index(writer->columns, i);
+
+        if (!column->is_set) {
+            /* A null: a clear validity bit, and a value that's ignored. */
+            if (row % 8 == 0)
+                g_byte_array_append(column->validity, (const guint8 *)"", 1);
+            switch (column->type) {
+
+            case ARROW_TYPE_BOOL:
+                if (row % 8 == 0)
+                    g_byte_array_append(column->values, (const guint8 *)"", 1);
+                break;
+
+            case ARROW_TYPE_UTF8:
+                fb_append(column->values, 4, column->data->len);
+                break;
+
+            case ARROW_TYPE_UINT32:
+                fb_append(column->values, 4, 0);
+                break;
+
+            default:
+                fb_append(column->values, 8, 0);
+                break;
+            }
+            column->null_count++;
+        }
+        column->is_set = FALSE;
+        if (column->type == ARROW_TYPE_UTF8 && column->data->len >= ARROW_MAX_STRING_DATA)
+            full = TRUE;
+    }
+    writer->num_rows++;
+
+    if (full)
+        arrow_write_batch(writer);
+    return !writer->error;
+}
+
+gboolean
+arrow_writer_finish(arrow_writer *writer)
+{
+    gboolean ok;
+
+    if (!writer->started)
+        arrow_write_schema(writer);
+    if (writer->num_rows != 0)
+        arrow_write_batch(writer);
+
+    /* End of stream: a continuation and a length of 0 */
+    arrow_write_u32(writer, ARROW_CONTINUATION);
+    arrow_write_u32(writer, 0);
+
+    ok = !writer->error && !ferror(writer->output_file);
+    g_ptr_array_free(writer->columns, TRUE);
+    g_free(writer);
+    return ok;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
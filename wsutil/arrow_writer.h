@@ -0,0 +1,114 @@
+/* arrow_writer.h
+ * Routines for writing tables in the Apache Arrow IPC streaming format.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __ARROW_WRITER_H__
+#define __ARROW_WRITER_H__
+
+#include "ws_symbol_export.h"
+#include <glib.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * An Arrow writer writes a table, row by row, as an Arrow IPC stream: a
+ * schema message, then a record batch message for every "batch_rows"
+ * rows, and an end-of-stream marker.  The values of a row are kept, column
+ * by column, in the buffers Arrow itself uses, so that a batch is written
+ * as it is, without any conversion.
+ *
+ * Every column is nullable; a column that has no value set in a row is
+ * null in that row.  Only little-endian data is written, on any host.
+ *
+ * Example:
+ *
+ *  arrow_writer *writer = arrow_writer_new(stdout, 65536);
+ *  arrow_writer_add_column(writer, "frame.number", ARROW_TYPE_INT64);
+ *  arrow_writer_add_column(writer, "ip.src", ARROW_TYPE_UINT32);
+ *  arrow_writer_set_int64(writer, 0, 1);
+ *  arrow_writer_set_uint64(writer, 1, 0xc0a80001);
+ *  arrow_writer_end_row(writer);
+ *  arrow_writer_finish(writer);
+ */
+
+typedef enum {
+    ARROW_TYPE_BOOL,
+    ARROW_TYPE_INT64,
+    ARROW_TYPE_UINT32,
+    ARROW_TYPE_UINT64,
+    ARROW_TYPE_DOUBLE,
+    ARROW_TYPE_TIMESTAMP,   /* nanoseconds since the Epoch, UTC */
+    ARROW_TYPE_UTF8
+} arrow_type_e;
+
+typedef struct arrow_writer arrow_writer;
+
+/** Create a writer; columns must be added before the first row ends. */
+WS_DLL_PUBLIC arrow_writer *
+arrow_writer_new(FILE *output_file, guint batch_rows);
+
+WS_DLL_PUBLIC void
+arrow_writer_add_column(arrow_writer *writer, const char *name, arrow_type_e type);
+
+/*
+ * Set the value of a column in the current row; setting it again replaces
+ * the value.  The value must suit the column's type: set_int64 for INT64
+ * and TIMESTAMP columns, set_uint64 for UINT32 and UINT64 ones.
+ */
+WS_DLL_PUBLIC void
+arrow_writer_set_bool(arrow_writer *writer, guint column, gboolean value);
+
+WS_DLL_PUBLIC void
+arrow_writer_set_int64(arrow_writer *writer, guint column, gint64 value);
+
+WS_DLL_PUBLIC void
+arrow_writer_set_uint64(arrow_writer *writer, guint column, guint64 value);
+
+WS_DLL_PUBLIC void
+arrow_writer_set_double(arrow_writer *writer, guint column, double value);
+
+WS_DLL_PUBLIC void
+arrow_writer_set_string(arrow_writer *writer, guint column, const char *value, gssize len);
+
+/** End the current row, writing a record batch if it's the last row of one.
+ *
+ * @return FALSE if writing failed
+ */
+WS_DLL_PUBLIC gboolean
+arrow_writer_end_row(arrow_writer *writer);
+
+/** Write the rows not written yet and the end of the stream, and free the
+ * writer.
+ *
+ * @return FALSE if writing failed, now or earlier
+ */
+WS_DLL_PUBLIC gboolean
+arrow_writer_finish(arrow_writer *writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ARROW_WRITER_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,791 @@
+/* capture_index.c
+ * Time and endpoint index of the packets in a capture file
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "capture_index.h"
+#include "file_util.h"
+#include "inet_addr.h"
+#include "pint.h"
+#include "strtoi.h"
+
+#define INDEX_MAGIC         "WSCAPIDX"
+#define INDEX_VERSION       1
+#define INDEX_INCOMPLETE    0x00000001
+
+#define INDEX_HEADER_SIZE   (8 + 6 * 4)
+#define INDEX_BLOCK_SIZE    (3 * 8 + 2 * 4)
+#define INDEX_PACKET_SIZE   4
+#define INDEX_KEY_SIZE      (2 * 4)
+#define INDEX_PROTO_SIZE    8
+
+/* The link-layer types we understand; we take the DLT_ values that
+   differ from the LINKTYPE_ values as well. */
+#define LINKTYPE_NULL       0
+#define LINKTYPE_ETHERNET   1
+#define DLT_RAW_LINUX       12
+#define DLT_RAW_OPENBSD     14
+#define LINKTYPE_RAW        101
+#define LINKTYPE_LOOP       108
+#define LINKTYPE_LINUX_SLL  113
+#define LINKTYPE_IPV4       228
+#define LINKTYPE_IPV6       229
+#define LINKTYPE_LINUX_SLL2 276
+
+#define ETHERTYPE_IP        0x0800
+#define ETHERTYPE_ARP       0x0806
+#define ETHERTYPE_VLAN      0x8100
+#define ETHERTYPE_IPV6      0x86dd
+#define ETHERTYPE_QINQ      0x88a8
+#define ETHERTYPE_QINQ_OLD  0x9100
+
+typedef struct {
+    gint64      offset;         /* file offset of the first packet */
+    gint64      first_ts;       /* earliest time stamp */
+    gint64      last_ts;        /* latest time stamp */
+    guint32     first_packet;   /* index of the first packet in packets */
+    guint32     num_packets;
+} index_block;
+
+typedef struct {
+    guint32     key;            /* endpoint hash */
+    guint32     block;          /* index of a block it appears in */
+} index_key;
+
+struct capture_index {
+    gboolean    incomplete;
+    gboolean    finished;       /* TRUE once keys is sorted */
+    GArray     *blocks;         /* index_block */
+    GArray     *packets;        /* guint32 offsets from the block offset */
+    GArray     *keys;           /* index_key */
+    guint64     proto_counts[CAPTURE_INDEX_NUM_PROTOS];
+
+    /* While adding packets: */
+    gint64      block_start_ts; /* time stamp of the current block's first packet */
+    GArray     *block_keys;     /* guint32 endpoint hashes in the current block */
+};
+
+static const char *proto_names[CAPTURE_INDEX_NUM_PROTOS] = {
+    "IPv4",
+    "IPv6",
+    "ARP",
+    "Other link-layer",
+    "TCP",
+    "UDP",
+    "SCTP",
+    "ICMP",
+    "ICMPv6",
+    "Other IP"
+};
+
+/*
+ * Get the addresses and ports of the IPv4 packet at off.
+ */
+static void
+parse_ipv4(const guint8 *pd, guint32 caplen, guint32 off, capture_index_flow *flow)
+{
+    guint32 ihl;
+    gboolean later_fragment;
+
+    flow->link_proto = CAPTURE_INDEX_PROTO_IPV4;
+    if (caplen < off + 20)
+        return;
+    ihl = (pd[off] & 0x0f) * 4;
+    if (ihl < 20)
+        return;
+    flow->ip_version = 4;
+    flow->ip_proto = pd[off + 9];
+    memcpy(flow->src, pd + off + 12, 4);
+    memcpy(flow->dst, pd + off + 16, 4);
+    later_fragment = (pntoh16(pd + off + 6) & 0x1fff) != 0;
+    off += ihl;
+    if (!later_fragment && caplen >= off + 4 &&
+        (flow->ip_proto == 6 || flow->ip_proto == 17 || flow->ip_proto == 132)) {
+        flow->has_ports = TRUE;
+        flow->src_port = pntoh16(pd + off);
+        flow->dst_port = pntoh16(pd + off + 2);
+    }
+}
+
+/*
+ * Get the addresses and ports of the IPv6 packet at off, skipping
+ * extension headers.
+ */
+static void
+parse_ipv6(const guint8 *pd, guint32 caplen, guint32 off, capture_index_flow *flow)
+{
+    guint8 nh;
+    gboolean later_fragment = FALSE;
+    int headers;
+
+    flow->link_proto = CAPTURE_INDEX_PROTO_IPV6;
+    if (caplen < off + 40)
+        return;
+    flow->ip_version = 6;
+    memcpy(flow->src, pd + off + 8, 16);
+    memcpy(flow->dst, pd + off + 24, 16);
+    nh = pd[off + 6];
+    off += 40;
+    for (headers = 0; headers < 8; headers++) {
+        if (nh == 0 || nh == 43 || nh == 60) {
+            /* hop-by-hop, routing or destination options */
+            if (caplen < off + 2)
+                break;
+            nh = pd[off];
+            off += (pd[off + 1] + 1) * 8;
+        } else if (nh == 44) {
+            /* fragment */
+            if (caplen < off + 8)
+                break;
+            nh = pd[off];
+            later_fragment = (pntoh16(pd + off + 2) & 0xfff8) != 0;
+            off += 8;
+        } else if (nh == 51) {
+            /* authentication header */
+            if (caplen < off + 2)
+                break;
+            nh = pd[off];
+            off += (pd[off + 1] + 2) * 4;
+        } else {
+            break;
+        }
+    }
+    flow->ip_proto = nh;
+    if (!later_fragment && caplen >= off + 4 &&
+        (nh == 6 || nh == 17 || nh == 132)) {
+        flow->has_ports = TRUE;
+        flow->src_port = pntoh16(pd + off);
+        flow->dst_port = pntoh16(pd + off + 2);
+    }
+}
+
+void
+capture_index_parse_packet(int linktype, const guint8 *pd, guint32 caplen,
+                           capture_index_flow *flow)
+{
+    guint32 off;
+    guint16 ethertype;
+    int vlans;
+
+    memset(flow, 0, sizeof *flow);
+    flow->link_proto = CAPTURE_INDEX_PROTO_OTHER_LINK;
+
+    switch (linktype) {
+
+    case LINKTYPE_ETHERNET:
+        if (caplen < 14)
+            return;
+        ethertype = pntoh16(pd + 12);
+        off = 14;
+        for (vlans = 0; vlans < 2; vlans++) {
+            if (ethertype != ETHERTYPE_VLAN && ethertype != ETHERTYPE_QINQ &&
+                ethertype != ETHERTYPE_QINQ_OLD)
+                break;
+            if (caplen < off + 4)
+                return;
+            ethertype = pntoh16(pd + off + 2);
+            off += 4;
+        }
+        break;
+
+    case LINKTYPE_LINUX_SLL:
+        if (caplen < 16)
+            return;
+        ethertype = pntoh16(pd + 14);
+        off = 16;
+        break;
+
+    case LINKTYPE_LINUX_SLL2:
+        if (caplen < 20)
+            return;
+        ethertype = pntoh16(pd);
+        off = 20;
+        break;
+
+    case LINKTYPE_NULL:
+    case LINKTYPE_LOOP:
+    case DLT_RAW_LINUX:
+    case DLT_RAW_OPENBSD:
+    case LINKTYPE_RAW:
+    case LINKTYPE_IPV4:
+    case LINKTYPE_IPV6:
+        /* The address family in the loopback header is in the byte
+           order of the machine that captured the packet, so look at
+           the IP version instead. */
+        off = (linktype == LINKTYPE_NULL || linktype == LINKTYPE_LOOP) ? 4 : 0;
+        if (caplen <= off)
+            return;
+        switch (pd[off] >> 4) {
+        case 4:
+            ethertype = ETHERTYPE_IP;
+            break;
+        case 6:
+            ethertype = ETHERTYPE_IPV6;
+            break;
+        default:
+            return;
+        }
+        break;
+
+    default:
+        return;
+    }
+
+    switch (ethertype) {
+
+    case ETHERTYPE_IP:
+        parse_ipv4(pd, caplen, off, flow);
+        break;
+
+    case ETHERTYPE_IPV6:
+        parse_ipv6(pd, caplen, off, flow);
+        break;
+
+    case ETHERTYPE_ARP:
+        flow->link_proto = CAPTURE_INDEX_PROTO_ARP;
+        return;
+
+    default:
+        return;
+    }
+
+    switch (flow->ip_proto) {
+    case 1:
+        flow->ip_proto_class = CAPTURE_INDEX_PROTO_ICMP;
+        break;
+    case 6:
+        flow->ip_proto_class = CAPTURE_INDEX_PROTO_TCP;
+        break;
+    case 17:
+        flow->ip_proto_class = CAPTURE_INDEX_PROTO_UDP;
+        break;
+    case 58:
+        flow->ip_proto_class = CAPTURE_INDEX_PROTO_ICMPV6;
+        break;
+    case 132:
+        flow->ip_proto_class = CAPTURE_INDEX_PROTO_SCTP;
+        break;
+    default:
+        flow->ip_proto_class = CAPTURE_INDEX_PROTO_OTHER_IP;
+        break;
+    }
+}
+
+gboolean
+capture_index_parse_endpoint(const char *str, capture_index_endpoint *ep)
+{
+    gchar *addr;
+    const char *port = NULL, *sep;
+    gboolean ok;
+
+    memset(ep, 0, sizeof *ep);
+
+    if (str[0] == '[') {
+        /* [IPv6 address] or [IPv6 address]:port */
+        sep = strchr(str, ']');
+        if (sep == NULL)
+            return FALSE;
+        if (sep[1] == ':')
+            port = sep + 2;
+        else if (sep[1] != '\0')
+            return FALSE;
+        addr = g_strndup(str + 1, sep - (str + 1));
+    } else if (strchr(str, ':') != NULL && strchr(str, ':') == strrchr(str, ':')) {
+        /* IPv4 address:port */
+        sep = strchr(str, ':');
+        port = sep + 1;
+        addr = g_strndup(str, sep - str);
+    } else {
+        addr = g_strdup(str);
+    }
+
+    if (ws_inet_pton4(addr, (ws_in4_addr *)(void *)ep->addr)) {
+        ep->ip_version = 4;
+        ok = TRUE;
+    } else if (ws_inet_pton6(addr, (ws_in6_addr *)(void *)ep->addr)) {
+        ep->ip_version = 6;
+        ok = TRUE;
+    } else {
+        ok = FALSE;
+    }
+    g_free(addr);
+
+    if (ok && port != NULL) {
+        ok = ws_strtou16(port, NULL, &ep->port);
+        ep->has_port = TRUE;
+    }
+    return ok;
+}
+
+gboolean
+capture_index_flow_has_endpoint(const capture_index_flow *flow,
+                                const capture_index_endpoint *ep)
+{
+    size_t len = ep->ip_version == 4 ? 4 : 16;
+
+    if (flow->ip_version != ep->ip_version)
+        return FALSE;
+    if (ep->has_port && !flow->has_ports)
+        return FALSE;
+    if (memcmp(flow->src, ep->addr, len) == 0 &&
+        (!ep->has_port || flow->src_port == ep->port))
+        return TRUE;
+    if (memcmp(flow->dst, ep->addr, len) == 0 &&
+        (!ep->has_port || flow->dst_port == ep->port))
+        return TRUE;
+    return FALSE;
+}
+
+/*
+ * The hash of an address, or an address and port, by which the index
+ * finds the blocks it appears in; 32-bit FNV-1a.
+ */
+static guint32
+endpoint_key(guint8 ip_version, const guint8 *addr, gboolean has_port, guint16 port)
+{
+    guint32 hash = 2166136261U;
+    size_t len = ip_version == 4 ? 4 : 16, i;
+
+#define FNV_BYTE(b) hash = (hash ^ (guint8)(b)) * 16777619U
+    FNV_BYTE(ip_version | (has_port ? 0x80 : 0));
+    for (i = 0; i < len; i++)
+        FNV_BYTE(addr[i]);
+    if (has_port) {
+        FNV_BYTE(port >> 8);
+        FNV_BYTE(port);
+    }
+#undef FNV_BYTE
+
+    return hash;
+}
+
+static gint
+compare_guint32(gconstpointer a, gconstpointer b)
+{
+    guint32 x = *(const guint32 *)a, y = *(const guint32 *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static gint
+compare_keys(gconstpointer a, gconstpointer b)
+{
+    const index_key *x = (const index_key *)a, *y = (const index_key *)b;
+
+    if (x->key != y->key)
+        return x->key < y->key ? -1 : 1;
+    return x->block < y->block ? -1 : x->block > y->block;
+}
+
+/*
+ * Add the distinct endpoint hashes of the current block to the keys.
+ */
+static void
+finish_block(capture_index *ci)
+{
+    index_key k;
+    guint i;
+
+    if (ci->block_keys->len == 0)
+        return;
+
+    g_array_sort(ci->block_keys, compare_guint32);
+    k.block = ci->blocks->len - 1;
+    for (i = 0; i < ci->block_keys->len; i++) {
+        k.key = g_array_index(ci->block_keys, guint32, i);
+        if (i == 0 || k.key != g_array_index(ci->block_keys, guint32, i - 1))
+            g_array_append_val(ci->keys, k);
+    }
+    g_array_set_size(ci->block_keys, 0);
+}
+
+capture_index *
+capture_index_new(void)
+{
+    capture_index *ci = g_new0(capture_index, 1);
+
+    ci->blocks = g_array_new(FALSE, FALSE, sizeof(index_block));
+    ci->packets = g_array_new(FALSE, FALSE, sizeof(guint32));
+    ci->keys = g_array_new(FALSE, FALSE, sizeof(index_key));
+    ci->block_keys = g_array_new(FALSE, FALSE, sizeof(guint32));
+    return ci;
+}
+
+void
+capture_index_add_packet(capture_index *ci, gint64 offset, gint64 ts,
+                         int linktype, const guint8 *pd, guint32 caplen)
+{
+    index_block *block = NULL;
+    capture_index_flow flow;
+    guint32 delta, key;
+
+    g_assert(!ci->finished);
+
+    if (ci->blocks->len != 0)
+        block = &g_array_index(ci->blocks, index_block, ci->blocks->len - 1);
+
+    /* Start a new block if this packet is too far from the start of the
+       current one, in the file or in time. */
+    if (block == NULL || offset < block->offset ||
+        offset - block->offset >= CAPTURE_INDEX_BLOCK_BYTES ||
+        ts - ci->block_start_ts >= CAPTURE_INDEX_BLOCK_NSECS ||
+        ci->block_start_ts - ts >= CAPTURE_INDEX_BLOCK_NSECS) {
+        index_block new_block;
+
+        if (block != NULL)
+            finish_block(ci);
+        new_block.offset = offset;
+        new_block.first_ts = ts;
+        new_block.last_ts = ts;
+        new_block.first_packet = ci->packets->len;
+        new_block.num_packets = 0;
+        g_array_append_val(ci->blocks, new_block);
+        block = &g_array_index(ci->blocks, index_block, ci->blocks->len - 1);
+        ci->block_start_ts = ts;
+    }
+
+    delta = (guint32)(offset - block->offset);
+    g_array_append_val(ci->packets, delta);
+    block->num_packets++;
+    if (ts < block->first_ts)
+        block->first_ts = ts;
+    if (ts > block->last_ts)
+        block->last_ts = ts;
+
+    capture_index_parse_packet(linktype, pd, caplen, &flow);
+    ci->proto_counts[flow.link_proto]++;
+    if (flow.ip_version == 0)
+        return;
+    ci->proto_counts[flow.ip_proto_class]++;
+
+    key = endpoint_key(flow.ip_version, flow.src, FALSE, 0);
+    g_array_append_val(ci->block_keys, key);
+    key = endpoint_key(flow.ip_version, flow.dst, FALSE, 0);
+    g_array_append_val(ci->block_keys, key);
+    if (flow.has_ports) {
+        key = endpoint_key(flow.ip_version, flow.src, TRUE, flow.src_port);
+        g_array_append_val(ci->block_keys, key);
+        key = endpoint_key(flow.ip_version, flow.dst, TRUE, flow.dst_port);
+        g_array_append_val(ci->block_keys, key);
+    }
+}
+
+void
+capture_index_set_incomplete(capture_index *ci)
+{
+    ci->incomplete = TRUE;
+}
+
+int
+capture_index_write(capture_index *ci, const char *path)
+{
+    GByteArray *out;
+    guint8 buf[INDEX_BLOCK_SIZE];
+    guint i;
+    FILE *fh;
+    int err = 0;
+
+    if (!ci->finished) {
+        finish_block(ci);
+        g_array_sort(ci->keys, compare_keys);
+        ci->finished = TRUE;
+    }
+
+    out = g_byte_array_sized_new(INDEX_HEADER_SIZE +
+                                 ci->blocks->len * INDEX_BLOCK_SIZE +
+                                 ci->packets->len * INDEX_PACKET_SIZE +
+                                 ci->keys->len * INDEX_KEY_SIZE +
+                                 CAPTURE_INDEX_NUM_PROTOS * INDEX_PROTO_SIZE);
+
+    g_byte_array_append(out, (const guint8 *)INDEX_MAGIC, 8);
+    phtole32(buf, INDEX_VERSION);
+    phtole32(buf + 4, ci->incomplete ? INDEX_INCOMPLETE : 0);
+    phtole32(buf + 8, ci->blocks->len);
+    phtole32(buf + 12, ci->packets->len);
+    phtole32(buf + 16, ci->keys->len);
+    phtole32(buf + 20, CAPTURE_INDEX_NUM_PROTOS);
+    g_byte_array_append(out, buf, 24);
+
+    for (i = 0; i < ci->blocks->len; i++) {
+        const index_block *block = &g_array_index(ci->blocks, index_block, i);
+
+        phtole64(buf, (guint64)block->offset);
+        phtole64(buf + 8, (guint64)block->first_ts);
+        phtole64(buf + 16, (guint64)block->last_ts);
+        phtole32(buf + 24, block->first_packet);
+        phtole32(buf + 28, block->num_packets);
+        g_byte_array_append(out, buf, INDEX_BLOCK_SIZE);
+    }
+    for (i = 0; i < ci->packets->len; i++) {
+        phtole32(buf, g_array_index(ci->packets, guint32, i));
+        g_byte_array_append(out, buf, INDEX_PACKET_SIZE);
+    }
+    for (i = 0; i < ci->keys->len; i++) {
+        const index_key *k = &g_array_index(ci->keys, index_key, i);
+
+        phtole32(buf, k->key);
+        phtole32(buf + 4, k->block);
+        g_byte_array_append(out, buf, INDEX_KEY_SIZE);
+    }
+    for (i = 0; i < CAPTURE_INDEX_NUM_PROTOS; i++) {
+        phtole64(buf, ci->proto_counts[i]);
+        g_byte_array_append(out, buf, INDEX_PROTO_SIZE);
+    }
+
+    fh = ws_fopen(path, "wb");
+    if (fh == NULL) {
+        err = errno;
+    } else {
+        if (fwrite(out->data, 1, out->len, fh) != out->len)
+            err = errno != 0 ? errno : EIO;
+        if (fclose(fh) == EOF && err == 0)
+            err = errno != 0 ? errno : EIO;
+    }
+    g_byte_array_free(out, TRUE);
+
+    return err;
+}
+
+capture_index *
+capture_index_read(const char *path, int *err)
+{
+    ws_statb64 statb;
+    capture_index *ci;
+    guint8 *data = NULL;
+    const guint8 *p;
+    guint32 num_blocks, num_packets, num_keys, num_protos, i;
+    guint64 size;
+    FILE *fh;
+
+    *err = 0;
+    fh = ws_fopen(path, "rb");
+    if (fh == NULL) {
+        *err = errno;
+        return NULL;
+    }
+    if (ws_fstat64(ws_fileno(fh), &statb) != 0) {
+        *err = errno;
+        fclose(fh);
+        return NULL;
+    }
+    if (statb.st_size < INDEX_HEADER_SIZE || (guint64)statb.st_size > G_MAXSIZE)
+        goto bad;
+    size = (guint64)statb.st_size;
+    data = (guint8 *)g_malloc((gsize)size);
+    if (fread(data, 1, (size_t)size, fh) != size) {
+        *err = ferror(fh) ? (errno != 0 ? errno : EIO) : 0;
+        goto bad;
+    }
+    fclose(fh);
+    fh = NULL;
+
+    if (memcmp(data, INDEX_MAGIC, 8) != 0 || pletoh32(data + 8) != INDEX_VERSION)
+        goto bad;
+    num_blocks = pletoh32(data + 16);
+    num_packets = pletoh32(data + 20);
+    num_keys = pletoh32(data + 24);
+    num_protos = pletoh32(data + 28);
+    if (size != INDEX_HEADER_SIZE +
+                (guint64)num_blocks * INDEX_BLOCK_SIZE +
+                (guint64)num_packets * INDEX_PACKET_SIZE +
+                (guint64)num_keys * INDEX_KEY_SIZE +
+                (guint64)num_protos * INDEX_PROTO_SIZE)
+        goto bad;
+
+    ci = capture_index_new();
+    ci->incomplete = (pletoh32(data + 12) & INDEX_INCOMPLETE) != 0;
+    ci->finished = TRUE;
+    p = data + INDEX_HEADER_SIZE;
+
+    g_array_set_size(ci->blocks, num_blocks);
+    for (i = 0; i < num_blocks; i++, p += INDEX_BLOCK_SIZE) {
+        index_block *block = &g_array_index(ci->blocks, index_block, i);
+
+        block->offset = (gint64)pletoh64(p);
+        block->first_ts = (gint64)pletoh64(p + 8);
+        block->last_ts = (gint64)pletoh64(p + 16);
+        block->first_packet = pletoh32(p + 24);
+        block->num_packets = pletoh32(p + 28);
+        if (block->first_packet > num_packets ||
+            block->num_packets > num_packets - block->first_packet) {
+            capture_index_free(ci);
+            goto bad;
+        }
+    }
+    g_array_set_size(ci->packets, num_packets);
+    for (i = 0; i < num_packets; i++, p += INDEX_PACKET_SIZE)
+        g_array_index(ci->packets, guint32, i) = pletoh32(p);
+    g_array_set_size(ci->keys, num_keys);
+    for (i = 0; i < num_keys; i++, p += INDEX_KEY_SIZE) {
+        index_key *k = &g_array_index(ci->keys, index_key, i);
+
+        k->key = pletoh32(p);
+        k->block = pletoh32(p + 4);
+        if (k->block >= num_blocks ||
+            (i > 0 && compare_keys(k - 1, k) > 0)) {
+            capture_index_free(ci);
+            goto bad;
+        }
+    }
+    /* Counts for protocols we don't know about are ignored. */
+    for (i = 0; i < num_protos; i++, p += INDEX_PROTO_SIZE) {
+        if (i < CAPTURE_INDEX_NUM_PROTOS)
+            ci->proto_counts[i] = pletoh64(p);
+    }
+
+    g_free(data);
+    return ci;
+
+bad:
+    if (fh != NULL)
+        fclose(fh);
+    g_free(data);
+    return NULL;
+}
+
+gboolean
+capture_index_is_complete(const capture_index *ci)
+{
+    return !ci->incomplete;
+}
+
+guint32
+capture_index_num_packets(const capture_index *ci)
+{
+    return ci->packets->len;
+}
+
+guint32
+capture_index_num_blocks(const capture_index *ci)
+{
+    return ci->blocks->len;
+}
+
+gboolean
+capture_index_time_range(const capture_index *ci, gint64 *first, gint64 *last)
+{
+    guint i;
+
+    if (ci->blocks->len == 0)
+        return FALSE;
+
+    *first = G_MAXINT64;
+    *last = G_MININT64;
+    for (i = 0; i < ci->blocks->len; i++) {
+        const index_block *block = &g_array_index(ci->blocks, index_block, i);
+
+        if (block->first_ts < *first)
+            *first = block->first_ts;
+        if (block->last_ts > *last)
+            *last = block->last_ts;
+    }
+    return TRUE;
+}
+
+guint64
+capture_index_proto_count(const capture_index *ci, capture_index_proto proto)
+{
+    return ci->proto_counts[proto];
+}
+
+const char *
+capture_index_proto_name(capture_index_proto proto)
+{
+    return proto_names[proto];
+}
+
+GArray *
+capture_index_find(const capture_index *ci, const capture_index_endpoint *eps,
+                   guint num_eps, gint64 start, gint64 stop)
+{
+    GArray *offsets = g_array_new(FALSE, FALSE, sizeof(gint64));
+    guint8 *match, *seen;
+    guint i, j, lo, hi;
+
+    g_assert(ci->finished);
+
+    match = (guint8 *)g_malloc(ci->blocks->len + 1);
+    seen = (guint8 *)g_malloc(ci->blocks->len + 1);
+    for (i = 0; i < ci->blocks->len; i++) {
+        const index_block *block = &g_array_index(ci->blocks, index_block, i);
+
+        match[i] = block->last_ts >= start && block->first_ts <= stop;
+    }
+
+    for (j = 0; j < num_eps; j++) {
+        guint32 key = endpoint_key(eps[j].ip_version, eps[j].addr,
+                                   eps[j].has_port, eps[j].port);
+
+        /* Find the first entry for the key. */
+        lo = 0;
+        hi = ci->keys->len;
+        while (lo < hi) {
+            guint mid = lo + (hi - lo) / 2;
+
+            if (g_array_index(ci->keys, index_key, mid).key < key)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        memset(seen, 0, ci->blocks->len);
+        for (; lo < ci->keys->len && g_array_index(ci->keys, index_key, lo).key == key; lo++)
+            seen[g_array_index(ci->keys, index_key, lo).block] = 1;
+        for (i = 0; i < ci->blocks->len; i++)
+            match[i] &= seen[i];
+    }
+
+    for (i = 0; i < ci->blocks->len; i++) {
+        const index_block *block = &g_array_index(ci->blocks, index_block, i);
+
+        if (!match[i])
+            continue;
+        for (j = 0; j < block->num_packets; j++) {
+            gint64 offset = block->offset +
+                g_array_index(ci->packets, guint32, block->first_packet + j);
+
+            g_array_append_val(offsets, offset);
+        }
+    }
+
+    g_free(match);
+    g_free(seen);
+    return offsets;
+}
+
+void
+capture_index_free(capture_index *ci)
+{
+    if (ci == NULL)
+        return;
+    g_array_free(ci->blocks, TRUE);
+    g_array_free(ci->packets, TRUE);
+    g_array_free(ci->keys, TRUE);
+    g_array_free(ci->block_keys, TRUE);
+    g_free(ci);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
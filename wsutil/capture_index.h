@@ -0,0 +1,210 @@
+/* capture_index.h
+ * Time and endpoint index of the packets in a capture file
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __CAPTURE_INDEX_H__
+#define __CAPTURE_INDEX_H__
+
+#include <glib.h>
+
+#include "ws_symbol_export.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * A capture index is a sidecar file, with the name of the capture file
+ * followed by CAPTURE_INDEX_SUFFIX, that lets a search for the packets
+ * to or from a host, or a host and port, in a time range, read only the
+ * parts of the capture file that might have them.
+ *
+ * The packets are grouped into blocks of consecutive packets, covering
+ * at most CAPTURE_INDEX_BLOCK_BYTES of the file and
+ * CAPTURE_INDEX_BLOCK_NSECS of time.  For each block, the index has the
+ * range of the time stamps in it, the file offset of each packet in it,
+ * and a hash of each IP address, and of each IP address and TCP, UDP or
+ * SCTP port, that appears in it.  The index also has the number of
+ * packets of each of a few protocols in the whole file.
+ *
+ * The offsets are those that libwiretap gives for the packets, so that
+ * wtap_seek_read() can read them; for a compressed file, they're offsets
+ * in the uncompressed data.
+ *
+ * All values in the file are little-endian:
+ *
+ *   header      "WSCAPIDX", version, flags, and the number of blocks,
+ *               packets, keys and protocol counts, all 32 bits
+ *   blocks      file offset (64 bits), first and last time stamp in
+ *               nanoseconds since the Epoch (64 bits each), index of the
+ *               first packet and number of packets (32 bits each)
+ *   packets     offset of each packet from the start of its block
+ *               (32 bits)
+ *   keys        endpoint hash and block index (32 bits each), sorted
+ *   protocols   packet count for each capture_index_proto (64 bits)
+ */
+#define CAPTURE_INDEX_SUFFIX        ".idx"
+#define CAPTURE_INDEX_BLOCK_BYTES   (1024 * 1024)
+#define CAPTURE_INDEX_BLOCK_NSECS   G_GINT64_CONSTANT(10000000000)
+
+/* The protocols whose packets are counted. */
+typedef enum {
+    CAPTURE_INDEX_PROTO_IPV4,
+    CAPTURE_INDEX_PROTO_IPV6,
+    CAPTURE_INDEX_PROTO_ARP,
+    CAPTURE_INDEX_PROTO_OTHER_LINK,  /**< neither IP nor ARP, or not understood */
+    CAPTURE_INDEX_PROTO_TCP,
+    CAPTURE_INDEX_PROTO_UDP,
+    CAPTURE_INDEX_PROTO_SCTP,
+    CAPTURE_INDEX_PROTO_ICMP,
+    CAPTURE_INDEX_PROTO_ICMPV6,
+    CAPTURE_INDEX_PROTO_OTHER_IP,    /**< another protocol over IP */
+    CAPTURE_INDEX_NUM_PROTOS
+} capture_index_proto;
+
+/* The addresses and ports of a packet. */
+typedef struct {
+    guint8      ip_version;     /**< 4 or 6, or 0 if the packet isn't IP */
+    guint8      ip_proto;       /**< the protocol over IP */
+    gboolean    has_ports;      /**< TRUE for unfragmented TCP, UDP and SCTP */
+    guint8      src[16];        /**< the first 4 bytes for IPv4 */
+    guint8      dst[16];
+    guint16     src_port;
+    guint16     dst_port;
+    capture_index_proto link_proto;
+    capture_index_proto ip_proto_class;  /**< if ip_version isn't 0 */
+} capture_index_flow;
+
+/* An IP address, and optionally a port, to look for. */
+typedef struct {
+    guint8      ip_version;     /**< 4 or 6 */
+    guint8      addr[16];       /**< the first 4 bytes for IPv4 */
+    gboolean    has_port;
+    guint16     port;
+} capture_index_endpoint;
+
+typedef struct capture_index capture_index;
+
+/** Get the addresses and ports of a packet.
+ *
+ * @param linktype the LINKTYPE_ or DLT_ value for the packet; Ethernet,
+ * raw IP, Linux cooked, and BSD loopback packets are understood
+ * @param pd the packet data
+ * @param caplen the amount of packet data
+ * @param flow filled in with what was found
+ */
+WS_DLL_PUBLIC void capture_index_parse_packet(int linktype, const guint8 *pd,
+                                              guint32 caplen, capture_index_flow *flow);
+
+/** Parse "address", "address:port" or "[IPv6 address]:port".
+ *
+ * @return TRUE if that worked
+ */
+WS_DLL_PUBLIC gboolean capture_index_parse_endpoint(const char *str,
+                                                    capture_index_endpoint *ep);
+
+/** Is one end of a packet's flow the endpoint? */
+WS_DLL_PUBLIC gboolean capture_index_flow_has_endpoint(const capture_index_flow *flow,
+                                                       const capture_index_endpoint *ep);
+
+/** Create an empty index, to add packets to. */
+WS_DLL_PUBLIC capture_index *capture_index_new(void);
+
+/** Add a packet to an index; packets must be added in file order.
+ *
+ * @param ci the index
+ * @param offset the offset of the packet's record in the file
+ * @param ts the packet's time stamp, in nanoseconds since the Epoch
+ * @param linktype the LINKTYPE_ or DLT_ value for the packet
+ * @param pd the packet data
+ * @param caplen the amount of packet data
+ */
+WS_DLL_PUBLIC void capture_index_add_packet(capture_index *ci, gint64 offset, gint64 ts,
+                                            int linktype, const guint8 *pd, guint32 caplen);
+
+/** Note that the file has packets that weren't added to the index, so
+ * that searches read all of it. */
+WS_DLL_PUBLIC void capture_index_set_incomplete(capture_index *ci);
+
+/** Write an index to a file; no more packets can be added to it after
+ * this.
+ *
+ * @return 0, or an errno value
+ */
+WS_DLL_PUBLIC int capture_index_write(capture_index *ci, const char *path);
+
+/** Read an index from a file.
+ *
+ * @param path the index file
+ * @param err set to an errno value, or to 0 if the file isn't a valid index
+ * @return the index, or NULL on failure
+ */
+WS_DLL_PUBLIC capture_index *capture_index_read(const char *path, int *err);
+
+/** Does the index cover every packet in the file?  If not, searches need
+ * to read all of it. */
+WS_DLL_PUBLIC gboolean capture_index_is_complete(const capture_index *ci);
+
+/** Get the number of packets in an index. */
+WS_DLL_PUBLIC guint32 capture_index_num_packets(const capture_index *ci);
+
+/** Get the number of blocks in an index. */
+WS_DLL_PUBLIC guint32 capture_index_num_blocks(const capture_index *ci);
+
+/** Get the range of the packet time stamps, in nanoseconds since the
+ * Epoch.
+ *
+ * @return FALSE if there are no packets
+ */
+WS_DLL_PUBLIC gboolean capture_index_time_range(const capture_index *ci,
+                                                gint64 *first, gint64 *last);
+
+/** Get the number of packets of a protocol. */
+WS_DLL_PUBLIC guint64 capture_index_proto_count(const capture_index *ci,
+                                                capture_index_proto proto);
+
+/** Get the name of a protocol, for printing. */
+WS_DLL_PUBLIC const char *capture_index_proto_name(capture_index_proto proto);
+
+/** Find the packets that might be to or from all of the endpoints, and
+ * have time stamps in a range; the caller has to check each packet.
+ *
+ * @param ci the index
+ * @param eps the endpoints, all of which must match
+ * @param num_eps the number of endpoints, which may be 0
+ * @param start the start of the time range, or G_MININT64
+ * @param stop the end of the time range, or G_MAXINT64
+ * @return an array of the gint64 file offsets of the packets, in file
+ * order, to be freed with g_array_free()
+ */
+WS_DLL_PUBLIC GArray *capture_index_find(const capture_index *ci,
+                                         const capture_index_endpoint *eps, guint num_eps,
+                                         gint64 start, gint64 stop);
+
+/** Free an index. */
+WS_DLL_PUBLIC void capture_index_free(capture_index *ci);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __CAPTURE_INDEX_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -18,6 +18,17 @@
 #include <glib.h>
 #include <wsutil/crc32.h>
 
+#include "crc32_int.h"
+
+#if defined(HAVE_SSE4_2) || defined(HAVE_PCLMUL)
+#include "ws_cpuid.h"
+#endif
+
+#if defined(HAVE_ARMV8_CRC32) && defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
 #define CRC32_ACCUMULATE(c,d,table) (c=(c>>8)^(table)[(c^(d))&0xFF])
 
 /*****************************************************************/
@@ -365,26 +376,114 @@ crc32_ccitt_table_lookup (guchar pos)
 	return crc32_ccitt_table[pos];
 }
 
+/*
+ * Which CRC instructions can we use?  We check the first time we're
+ * called; the answer is the same for every thread, so a race just means
+ * we check more than once.
+ */
+static gboolean crc_hw_checked = FALSE;
+#ifdef HAVE_SSE4_2
+static gboolean use_sse42 = FALSE;
+#endif
+#ifdef HAVE_PCLMUL
+static gboolean use_pclmul = FALSE;
+#endif
+#ifdef HAVE_ARMV8_CRC32
+static gboolean use_armv8_crc32 = FALSE;
+#endif
+
+static void
+check_crc_hw(void)
+{
+#ifdef HAVE_SSE4_2
+	use_sse42 = ws_cpuid_sse42() != 0;
+#endif
+#ifdef HAVE_PCLMUL
+	use_pclmul = ws_cpuid_pclmul() != 0;
+#endif
+#ifdef HAVE_ARMV8_CRC32
+#if defined(__linux__)
+	use_armv8_crc32 = (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#elif defined(__APPLE__)
+	/* Every 64-bit ARM processor Apple has shipped has them. */
+	use_armv8_crc32 = TRUE;
+#endif
+#endif
+	crc_hw_checked = TRUE;
+}
+
+guint32
+crc32c_portable_update(const guint8 *buf, size_t len, guint32 crc)
+{
+	while (len-- != 0) {
+		CRC32C(crc, *buf++);
+	}
+
+	return crc;
+}
+
+guint32
+crc32_ccitt_portable_update(const guint8 *buf, size_t len, guint32 crc)
+{
+	while (len-- != 0)
+		CRC32_ACCUMULATE(crc, *buf++, crc32_ccitt_table);
+
+	return crc;
+}
+
+static guint32
+crc32c_update(const guint8 *buf, size_t len, guint32 crc)
+{
+	if (!crc_hw_checked)
+		check_crc_hw();
+#ifdef HAVE_SSE4_2
+	if (use_sse42)
+		return crc32c_sse42_update(buf, len, crc);
+#endif
+#ifdef HAVE_ARMV8_CRC32
+	if (use_armv8_crc32)
+		return crc32c_armv8_update(buf, len, crc);
+#endif
+	return crc32c_portable_update(buf, len, crc);
+}
+
+static guint32
+crc32_ccitt_update(const guint8 *buf, size_t len, guint32 crc)
+{
+	if (!crc_hw_checked)
+		check_crc_hw();
+#ifdef HAVE_PCLMUL
+	if (use_pclmul && len >= 64) {
+		size_t folded = len & ~(size_t)15;
+
+		crc = crc32_ccitt_pclmul_update(buf, folded, crc);
+		buf += folded;
+		len -= folded;
+	}
+#endif
+#ifdef HAVE_ARMV8_CRC32
+	if (use_armv8_crc32)
+		return crc32_ccitt_armv8_update(buf, len, crc);
+#endif
+	return crc32_ccitt_portable_update(buf, len, crc);
+}
+
 guint32
 crc32c_calculate(const void *buf, int len, guint32 crc)
 {
-	const guint8 *p = (const guint8 *)buf;
+	if (len <= 0)
+		return crc;
 	crc = CRC32C_SWAP(crc);
-	while (len-- > 0) {
-		CRC32C(crc, *p++);
-	}
+	crc = crc32c_update((const guint8 *)buf, len, crc);
 	return CRC32C_SWAP(crc);
 }
 
 guint32
 crc32c_calculate_no_swap(const void *buf, int len, guint32 crc)
 {
-	const guint8 *p = (const guint8 *)buf;
-	while (len-- > 0) {
-		CRC32C(crc, *p++);
-	}
-
-	return crc;
+	if (len <= 0)
+		return crc;
+	return crc32c_update((const guint8 *)buf, len, crc);
 }
 
 guint32
@@ -396,13 +495,7 @@ crc32_ccitt(const guint8 *buf, guint len)
 guint32
 crc32_ccitt_seed(const guint8 *buf, guint len, guint32 seed)
 {
-	guint i;
-	guint32 crc32 = seed;
-
-	for (i = 0; i < len; i++)
-		CRC32_ACCUMULATE(crc32, buf[i], crc32_ccitt_table);
-
-	return ( ~crc32 );
+	return ( ~crc32_ccitt_update(buf, len, seed) );
 }
 
 guint32
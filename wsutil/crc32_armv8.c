@@ -0,0 +1,74 @@
+/* crc32_armv8.c
+ * CRC32C and CRC-32 with the ARMv8 CRC32 instructions
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#ifdef HAVE_ARMV8_CRC32
+
+#include <glib.h>
+#include <string.h>
+
+#include <arm_acle.h>
+
+#include "crc32_int.h"
+
+/*
+ * These are only called if the OS says the CPU has the CRC32
+ * instructions; that check is done in crc32.c, which isn't compiled
+ * with the CRC flag.
+ */
+guint32
+crc32c_armv8_update(const guint8 *buf, size_t len, guint32 crc)
+{
+	guint64 word;
+
+	while (len >= 8) {
+		memcpy(&word, buf, 8);
+		crc = __crc32cd(crc, word);
+		buf += 8;
+		len -= 8;
+	}
+	while (len-- != 0)
+		crc = __crc32cb(crc, *buf++);
+
+	return crc;
+}
+
+guint32
+crc32_ccitt_armv8_update(const guint8 *buf, size_t len, guint32 crc)
+{
+	guint64 word;
+
+	while (len >= 8) {
+		memcpy(&word, buf, 8);
+		crc = __crc32d(crc, word);
+		buf += 8;
+		len -= 8;
+	}
+	while (len-- != 0)
+		crc = __crc32b(crc, *buf++);
+
+	return crc;
+}
+
+#endif /* HAVE_ARMV8_CRC32 */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -0,0 +1,126 @@
+/* crc32_bench.c
+ * Standalone program to check the hardware-accelerated versions of
+ * crc32c_calculate() and crc32_ccitt_seed() against the table-driven
+ * ones, and to compare their speed.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <glib.h>
+
+#include "crc32.h"
+#include "crc32_int.h"
+
+/* Bytes to checksum for each measurement. */
+#define BYTES_PER_RUN   (64 * 1024 * 1024)
+
+#define MAX_CHECK_LEN   300
+
+static const size_t sizes[] = { 64, 1500, 9000, 65536 };
+
+typedef guint32 (*crc_func)(const guint8 *, size_t, guint32);
+
+static gboolean failed = FALSE;
+
+static guint32
+crc32c_dispatched(const guint8 *buf, size_t len, guint32 crc)
+{
+	return crc32c_calculate_no_swap(buf, (int)len, crc);
+}
+
+static guint32
+crc32_ccitt_dispatched(const guint8 *buf, size_t len, guint32 crc)
+{
+	/* crc32_ccitt_seed() complements the result. */
+	return ~crc32_ccitt_seed(buf, (guint)len, crc);
+}
+
+static double
+time_crc(crc_func func, const guint8 *buf, size_t len)
+{
+	size_t  runs = BYTES_PER_RUN / len, i;
+	gint64  start;
+	volatile guint32 result = 0;
+
+	start = g_get_monotonic_time();
+	for (i = 0; i < runs; i++)
+		result = func(buf, len, result);
+
+	return (double)(runs * len) / (double)(g_get_monotonic_time() - start);
+}
+
+/* Check every length and alignment up to MAX_CHECK_LEN bytes. */
+static void
+check_crc(const char *name, crc_func portable, crc_func dispatched, const guint8 *buf)
+{
+	size_t off, len;
+
+	for (off = 0; off < 16; off++) {
+		for (len = 0; len <= MAX_CHECK_LEN; len++) {
+			guint32 seed = (guint32)(len * 0x9e3779b9U);
+
+			if (portable(buf + off, len, seed) != dispatched(buf + off, len, seed)) {
+				printf("%s is wrong for %u bytes at offset %u\n",
+				       name, (guint)len, (guint)off);
+				failed = TRUE;
+			}
+		}
+	}
+}
+
+int
+main(void)
+{
+	guint8 *buf;
+	size_t  i, s;
+
+	buf = (guint8 *)g_malloc(sizes[G_N_ELEMENTS(sizes) - 1] + 16);
+	for (i = 0; i < sizes[G_N_ELEMENTS(sizes) - 1] + 16; i++)
+		buf[i] = (guint8)(i * 251 + (i >> 8));
+
+	check_crc("crc32c_calculate_no_swap()", crc32c_portable_update, crc32c_dispatched, buf);
+	check_crc("crc32_ccitt_seed()", crc32_ccitt_portable_update, crc32_ccitt_dispatched, buf);
+
+	printf("Throughput in MB/s; higher is better\n\n");
+	printf("%-12s %8s %12s %12s\n", "crc", "size", "table", "dispatched");
+
+	for (s = 0; s < G_N_ELEMENTS(sizes); s++) {
+		printf("%-12s %8u %12.0f %12.0f\n", "CRC32C", (guint)sizes[s],
+		       time_crc(crc32c_portable_update, buf, sizes[s]),
+		       time_crc(crc32c_dispatched, buf, sizes[s]));
+	}
+	for (s = 0; s < G_N_ELEMENTS(sizes); s++) {
+		printf("%-12s %8u %12.0f %12.0f\n", "CRC-32", (guint)sizes[s],
+		       time_crc(crc32_ccitt_portable_update, buf, sizes[s]),
+		       time_crc(crc32_ccitt_dispatched, buf, sizes[s]));
+	}
+
+	g_free(buf);
+
+	if (failed)
+		return 1;
+
+	return 0;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -0,0 +1,36 @@
+/* crc32_int.h
+ * Internal declarations for the CRC-32 routines
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __CRC32_INT_H__
+#define __CRC32_INT_H__
+
+/*
+ * These all update a bit-reflected CRC register, without any initial
+ * or final inversion or byte swapping.
+ */
+guint32 crc32c_portable_update(const guint8 *buf, size_t len, guint32 crc);
+guint32 crc32_ccitt_portable_update(const guint8 *buf, size_t len, guint32 crc);
+
+#ifdef HAVE_SSE4_2
+/* Uses the SSE 4.2 crc32 instruction, which computes CRC32C. */
+guint32 crc32c_sse42_update(const guint8 *buf, size_t len, guint32 crc);
+#endif
+
+#ifdef HAVE_PCLMUL
+/* len must be at least 64 and a multiple of 16. */
+guint32 crc32_ccitt_pclmul_update(const guint8 *buf, size_t len, guint32 crc);
+#endif
+
+#ifdef HAVE_ARMV8_CRC32
+guint32 crc32c_armv8_update(const guint8 *buf, size_t len, guint32 crc);
+guint32 crc32_ccitt_armv8_update(const guint8 *buf, size_t len, guint32 crc);
+#endif
+
+#endif /* __CRC32_INT_H__ */
@@ -0,0 +1,119 @@
+/* crc32_pclmul.c
+ * CRC-32 with carry-less multiplication
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#ifdef HAVE_PCLMUL
+
+#include <glib.h>
+
+#include <emmintrin.h>
+#include <wmmintrin.h>
+
+#include "crc32_int.h"
+
+/*
+ * This folds the data 64 bytes at a time, and then 16 bytes at a time,
+ * into a 128-bit remainder, which is then reduced to 32 bits with a
+ * Barrett reduction, as described in Intel's "Fast CRC Computation for
+ * Generic Polynomials Using PCLMULQDQ Instruction" white paper.
+ *
+ * The constants are, for the bit-reflected polynomial 0x04C11DB7,
+ * x^(4*128+32) mod P and x^(4*128-32) mod P for the 64-byte folds,
+ * x^(128+32) mod P and x^(128-32) mod P for the 16-byte folds, x^64 mod P
+ * for the 64-bit fold, and P and floor(x^64 / P) for the reduction, all
+ * bit-reflected and shifted left by one.
+ *
+ * This is only called if ws_cpuid_pclmul() says the CPU has PCLMULQDQ;
+ * that check is done in crc32.c, which isn't compiled with the PCLMUL
+ * flag.
+ */
+guint32
+crc32_ccitt_pclmul_update(const guint8 *buf, size_t len, guint32 crc)
+{
+	const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+	const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+	const __m128i k5 = _mm_set_epi64x(0, 0x0163cd6124);
+	const __m128i poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+	const __m128i mask32 = _mm_setr_epi32(-1, 0, -1, 0);
+	__m128i x0, x1, x2, x3, x4;
+
+	x1 = _mm_loadu_si128((const __m128i *)(const void *)(buf + 0x00));
+	x2 = _mm_loadu_si128((const __m128i *)(const void *)(buf + 0x10));
+	x3 = _mm_loadu_si128((const __m128i *)(const void *)(buf + 0x20));
+	x4 = _mm_loadu_si128((const __m128i *)(const void *)(buf + 0x30));
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+	buf += 64;
+	len -= 64;
+
+	/* Fold four 16-byte blocks at a time. */
+	while (len >= 64) {
+		x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k1k2, 0x00),
+						 _mm_clmulepi64_si128(x1, k1k2, 0x11)),
+				   _mm_loadu_si128((const __m128i *)(const void *)(buf + 0x00)));
+		x2 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x2, k1k2, 0x00),
+						 _mm_clmulepi64_si128(x2, k1k2, 0x11)),
+				   _mm_loadu_si128((const __m128i *)(const void *)(buf + 0x10)));
+		x3 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x3, k1k2, 0x00),
+						 _mm_clmulepi64_si128(x3, k1k2, 0x11)),
+				   _mm_loadu_si128((const __m128i *)(const void *)(buf + 0x20)));
+		x4 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x4, k1k2, 0x00),
+						 _mm_clmulepi64_si128(x4, k1k2, 0x11)),
+				   _mm_loadu_si128((const __m128i *)(const void *)(buf + 0x30)));
+		buf += 64;
+		len -= 64;
+	}
+
+	/* Fold the four remainders into one. */
+	x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x00),
+					 _mm_clmulepi64_si128(x1, k3k4, 0x11)), x2);
+	x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x00),
+					 _mm_clmulepi64_si128(x1, k3k4, 0x11)), x3);
+	x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x00),
+					 _mm_clmulepi64_si128(x1, k3k4, 0x11)), x4);
+
+	/* Fold in the rest, 16 bytes at a time. */
+	while (len >= 16) {
+		x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x00),
+						 _mm_clmulepi64_si128(x1, k3k4, 0x11)),
+				   _mm_loadu_si128((const __m128i *)(const void *)buf));
+		buf += 16;
+		len -= 16;
+	}
+
+	/* Fold 128 bits to 64 bits. */
+	x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+	x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+	x2 = _mm_srli_si128(x1, 4);
+	x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k5, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	/* Barrett reduction to 32 bits. */
+	x0 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), poly, 0x10);
+	x0 = _mm_clmulepi64_si128(_mm_and_si128(x0, mask32), poly, 0x00);
+	x1 = _mm_xor_si128(x1, x0);
+
+	return (guint32)_mm_cvtsi128_si32(_mm_srli_si128(x1, 4));
+}
+
+#endif /* HAVE_PCLMUL */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -0,0 +1,68 @@
+/* crc32_sse42.c
+ * CRC32C with the SSE 4.2 crc32 instruction
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#ifdef HAVE_SSE4_2
+
+#include <glib.h>
+#include <string.h>
+
+#include <nmmintrin.h>
+
+#include "crc32_int.h"
+
+/*
+ * This is only called if ws_cpuid_sse42() says we have SSE 4.2; that
+ * check is done in crc32.c, which isn't compiled with the SSE 4.2 flag.
+ */
+guint32
+crc32c_sse42_update(const guint8 *buf, size_t len, guint32 crc)
+{
+#if defined(__x86_64__) || defined(_M_X64)
+	guint64 crc64 = crc;
+	guint64 word;
+
+	while (len >= 8) {
+		memcpy(&word, buf, 8);
+		crc64 = _mm_crc32_u64(crc64, word);
+		buf += 8;
+		len -= 8;
+	}
+	crc = (guint32)crc64;
+#endif
+	while (len >= 4) {
+		guint32 word32;
+
+		memcpy(&word32, buf, 4);
+		crc = _mm_crc32_u32(crc, word32);
+		buf += 4;
+		len -= 4;
+	}
+	while (len-- != 0)
+		crc = _mm_crc32_u8(crc, *buf++);
+
+	return crc;
+}
+
+#endif /* HAVE_SSE4_2 */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
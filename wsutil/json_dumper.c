@@ -14,6 +14,7 @@
 #include "json_dumper.h"
 
 #include <math.h>
+#include <string.h>
 
 /*
  * json_dumper.state[current_depth] describes a nested element:
@@ -42,35 +43,56 @@ enum json_dumper_change {
     JSON_DUMPER_FINISH,
 };
 
+/* The characters json_puts_string() can't copy as they are; '/' only needs
+   escaping after a '<', and '.' only if dots become underscores. */
+#define JSON_CNTRL_CHARS \
+    "\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f" \
+    "\x10\x11\x12\x13\x14\x15\x16\x17\x18\x19\x1a\x1b\x1c\x1d\x1e\x1f"
+static const char json_special_chars[] = "\"\\/" JSON_CNTRL_CHARS;
+static const char json_special_chars_dot[] = "\"\\/." JSON_CNTRL_CHARS;
+
 static void
 json_puts_string(FILE *fp, const char *str, gboolean dot_to_underscore)
 {
-    if (!str) {
-        fputs("null", fp);
-        return;
-    }
-
     static const char json_cntrl[0x20][6] = {
         "u0000", "u0001", "u0002", "u0003", "u0004", "u0005", "u0006", "u0007", "b",     "t",     "n",     "u000b", "f",     "r",     "u000e", "u000f",
         "u0010", "u0011", "u0012", "u0013", "u0014", "u0015", "u0016", "u0017", "u0018", "u0019", "u001a", "u001b", "u001c", "u001d", "u001e", "u001f"
     };
+    const char *specials = dot_to_underscore ? json_special_chars_dot : json_special_chars;
+    const char *start = str;
+
+    if (!str) {
+        fputs("null", fp);
+        return;
+    }
 
     fputc('"', fp);
-    for (int i = 0; str[i]; i++) {
-        if ((guint)str[i] < 0x20) {
+    for (;;) {
+        /* Copy the run of characters that need no escaping at once;
+           strcspn() is usually vectorized by the C library. */
+        size_t run = strcspn(str, specials);
+        char c;
+
+        if (run > 0) {
+            fwrite(str, 1, run, fp);
+            str += run;
+        }
+        c = *str++;
+        if (c == '\0')
+            break;
+        if ((guchar)c < 0x20) {
             fputc('\\', fp);
-            fputs(json_cntrl[(guint)str[i]], fp);
-        } else if (i > 0 && str[i - 1] == '<' && str[i] == '/') {
+            fputs(json_cntrl[(guchar)c], fp);
+        } else if (c == '/') {
             // Convert </script> to <\/script> to avoid breaking web pages.
-            fputs("\\/", fp);
-        } else {
-            if (str[i] == '\\' || str[i] == '"') {
+            if (str - 1 > start && str[-2] == '<')
                 fputc('\\', fp);
-            }
-            if (dot_to_underscore && str[i] == '.')
-                fputc('_', fp);
-            else
-                fputc(str[i], fp);
+            fputc('/', fp);
+        } else if (c == '.') {
+            fputc('_', fp);
+        } else {
+            fputc('\\', fp);
+            fputc(c, fp);
         }
     }
     fputc('"', fp);
@@ -0,0 +1,176 @@
+/* mempbrk_bench.c
+ * Standalone program to compare the speed of the SIMD and portable
+ * versions of ws_mempbrk_exec() and ws_memmem().
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "ws_mempbrk.h"
+#include "ws_mempbrk_int.h"
+
+/* Bytes to search for each measurement. */
+#define BYTES_PER_RUN   (256 * 1024 * 1024)
+
+static const size_t sizes[] = { 64, 1500, 65536 };
+
+static const char *needle_sets[] = {
+    "\r\n",
+    " \t\r\n;,=",
+    "\"'()<>@,;:\\/[]?={} \t",
+};
+
+static const guint8 substring[] = "Content-Length:";
+
+/* Text for the substring search, with many partial matches. */
+static const char headers[] = "Content-Type: text/html\r\nConnection: close\r\nCache-Control: no-cache\r\n";
+
+typedef const guint8 *(*pbrk_func)(const guint8 *, size_t, const ws_mempbrk_pattern *, guchar *);
+typedef const guint8 *(*memmem_func)(const guint8 *, size_t, const guint8 *, size_t);
+
+static gboolean failed = FALSE;
+
+/* Fill the haystack with text that contains none of the needles. */
+static void
+fill_haystack(guint8 *haystack, size_t len, const ws_mempbrk_pattern *pattern)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        guint8 c = (guint8)('a' + (i * 7) % 26);
+
+        while (pattern->patt[c])
+            c++;
+        haystack[i] = c;
+    }
+}
+
+static double
+time_pbrk(pbrk_func func, const guint8 *haystack, size_t len, const ws_mempbrk_pattern *pattern)
+{
+    size_t  runs = BYTES_PER_RUN / len, i;
+    gint64  start;
+    guchar  found;
+    volatile const guint8 *result = NULL;
+
+    start = g_get_monotonic_time();
+    for (i = 0; i < runs; i++)
+        result = func(haystack, len, pattern, &found);
+    (void)result;
+
+    return (double)(runs * len) / (double)(g_get_monotonic_time() - start);
+}
+
+static double
+time_memmem(memmem_func func, const guint8 *haystack, size_t len)
+{
+    size_t  runs = BYTES_PER_RUN / len, i;
+    gint64  start;
+    volatile const guint8 *result = NULL;
+
+    start = g_get_monotonic_time();
+    for (i = 0; i < runs; i++)
+        result = func(haystack, len, substring, sizeof substring - 1);
+    (void)result;
+
+    return (double)(runs * len) / (double)(g_get_monotonic_time() - start);
+}
+
+/* Check that both versions find each needle at every position. */
+static void
+check_pbrk(const char *needles, const ws_mempbrk_pattern *pattern, guint8 *haystack, size_t len)
+{
+    size_t       pos;
+    const char  *n;
+    guchar       found1, found2;
+
+    for (n = needles; *n != '\0'; n++) {
+        for (pos = 0; pos < len; pos++) {
+            guint8 saved = haystack[pos];
+
+            haystack[pos] = (guint8)*n;
+            if (ws_mempbrk_exec(haystack, len, pattern, &found1) !=
+                ws_mempbrk_portable_exec(haystack, len, pattern, &found2) ||
+                found1 != found2) {
+                printf("ws_mempbrk_exec() is wrong for needle 0x%02x at %u of %u\n",
+                       (guint8)*n, (guint)pos, (guint)len);
+                failed = TRUE;
+            }
+            haystack[pos] = saved;
+        }
+    }
+}
+
+int
+main(void)
+{
+    guint8 *haystack;
+    size_t  s, n;
+
+    haystack = (guint8 *)g_malloc(sizes[G_N_ELEMENTS(sizes) - 1]);
+
+    printf("Throughput in MB/s; higher is better\n\n");
+    printf("%-24s %8s %12s %12s\n", "search", "size", "portable", "dispatched");
+
+    for (n = 0; n < G_N_ELEMENTS(needle_sets); n++) {
+        ws_mempbrk_pattern pattern;
+
+        memset(&pattern, 0, sizeof pattern);
+        ws_mempbrk_compile(&pattern, needle_sets[n]);
+
+        for (s = 0; s < G_N_ELEMENTS(sizes); s++) {
+            fill_haystack(haystack, sizes[s], &pattern);
+            if (sizes[s] <= 1500)
+                check_pbrk(needle_sets[n], &pattern, haystack, sizes[s]);
+            printf("mempbrk, %2u needles     %8u %12.0f %12.0f\n",
+                   (guint)strlen(needle_sets[n]), (guint)sizes[s],
+                   time_pbrk(ws_mempbrk_portable_exec, haystack, sizes[s], &pattern),
+                   time_pbrk(ws_mempbrk_exec, haystack, sizes[s], &pattern));
+        }
+    }
+
+    for (s = 0; s < G_N_ELEMENTS(sizes); s++) {
+        for (n = 0; n < sizes[s]; n++)
+            haystack[n] = headers[n % (sizeof headers - 1)];
+        memcpy(haystack + sizes[s] - (sizeof substring - 1), substring, sizeof substring - 1);
+        if (ws_memmem(haystack, sizes[s], substring, sizeof substring - 1) !=
+            ws_memmem_portable(haystack, sizes[s], substring, sizeof substring - 1)) {
+            printf("ws_memmem() is wrong for size %u\n", (guint)sizes[s]);
+            failed = TRUE;
+        }
+        printf("memmem                   %8u %12.0f %12.0f\n", (guint)sizes[s],
+               time_memmem(ws_memmem_portable, haystack, sizes[s]),
+               time_memmem(ws_memmem, haystack, sizes[s]));
+    }
+
+    g_free(haystack);
+
+    if (failed)
+        return 1;
+
+    return 0;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,276 @@
+/* numa.c
+ * Routines for placing threads and memory on multi-socket machines
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* Otherwise the CPU_SET() macros won't be defined */
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#endif
+
+#include <wsutil/strtoi.h>
+#include <wsutil/numa.h>
+
+/*
+ * The size of the huge pages transparent huge pages are made of on the
+ * machines this matters on (x86-64, and arm64 with 4 kB pages).
+ */
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+static gboolean use_huge_pages = FALSE;
+
+#ifdef __linux__
+/* Parse a list of CPUs as the kernel writes them, e.g. "0-7,16-23". */
+static gboolean
+parse_cpu_list(const char *list, cpu_set_t *set)
+{
+    const char *p = list;
+    guint32 first, last, cpu;
+
+    CPU_ZERO(set);
+    for (;;) {
+        if (!ws_strtou32(p, &p, &first))
+            return FALSE;
+        last = first;
+        if (*p == '-') {
+            if (!ws_strtou32(p + 1, &p, &last) || last < first)
+                return FALSE;
+        }
+        if (last >= CPU_SETSIZE)
+            return FALSE;
+        for (cpu = first; cpu <= last; cpu++)
+            CPU_SET(cpu, set);
+        if (*p == '\0')
+            break;
+        if (*p != ',')
+            return FALSE;
+        p++;
+    }
+    return CPU_COUNT(set) != 0;
+}
+
+/* The contents of a file in /sys, without the newline; NULL if it can't be read. */
+static char *
+read_sys_file(const char *path)
+{
+    char *contents;
+
+    if (!g_file_get_contents(path, &contents, NULL, NULL))
+        return NULL;
+    return g_strstrip(contents);
+}
+
+/* The CPUs of a NUMA node. */
+static char *
+node_cpus(guint32 node, cpu_set_t *set)
+{
+    char *path, *cpulist;
+    gboolean ok;
+
+    path = g_strdup_printf("/sys/devices/system/node/node%u/cpulist", node);
+    cpulist = read_sys_file(path);
+    g_free(path);
+    if (cpulist == NULL)
+        return g_strdup_printf("there's no NUMA node %u", node);
+    ok = parse_cpu_list(cpulist, set);
+    g_free(cpulist);
+    if (!ok)
+        return g_strdup_printf("NUMA node %u has no CPUs", node);
+    return NULL;
+}
+#endif
+
+char *
+ws_numa_set_cpu_affinity(const char *spec)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    char *err_msg, *path, *contents;
+    guint32 node;
+    gint32 iface_node;
+    GDir *dir;
+    const char *name;
+    guint32 tid;
+    int ret = 0;
+    int err = 0;
+
+    if (g_str_has_prefix(spec, "node:")) {
+        if (!ws_strtou32(spec + 5, NULL, &node))
+            return g_strdup_printf("\"%s\" isn't a NUMA node number", spec + 5);
+        err_msg = node_cpus(node, &set);
+        if (err_msg != NULL)
+            return err_msg;
+    } else if (g_str_has_prefix(spec, "iface:")) {
+        path = g_build_filename("/sys/class/net", spec + 6, "device", "numa_node", NULL);
+        contents = read_sys_file(path);
+        g_free(path);
+        if (contents == NULL)
+            return g_strdup_printf("the NUMA node of interface %s isn't known", spec + 6);
+        if (!ws_strtoi32(contents, NULL, &iface_node) || iface_node < 0) {
+            /* -1 when the machine or the bus doesn't say */
+            g_free(contents);
+            return g_strdup_printf("interface %s isn't attached to a NUMA node", spec + 6);
+        }
+        g_free(contents);
+        err_msg = node_cpus((guint32)iface_node, &set);
+        if (err_msg != NULL)
+            return err_msg;
+    } else if (!parse_cpu_list(spec, &set)) {
+        return g_strdup_printf("\"%s\" isn't a list of CPUs, node:N or iface:NAME", spec);
+    }
+
+    /*
+     * sched_setaffinity() applies to one thread; threads created later
+     * get the affinity of the thread that creates them, but the ones
+     * already running, e.g. GLib's, have to be set one by one.
+     */
+    dir = g_dir_open("/proc/self/task", 0, NULL);
+    if (dir == NULL) {
+        ret = sched_setaffinity(0, sizeof set, &set);
+        err = errno;
+    } else {
+        while ((name = g_dir_read_name(dir)) != NULL) {
+            if (!ws_strtou32(name, NULL, &tid))
+                continue;
+            if (sched_setaffinity((pid_t)tid, sizeof set, &set) == -1 &&
+                errno != ESRCH) {
+                /* ESRCH is a thread that has exited since */
+                ret = -1;
+                err = errno;
+                break;
+            }
+        }
+        g_dir_close(dir);
+    }
+    if (ret == -1)
+        return g_strdup_printf("can't set the CPU affinity: %s", g_strerror(err));
+    return NULL;
+#else
+    (void)spec;
+    return g_strdup("setting the CPU affinity isn't supported on this platform");
+#endif
+}
+
+void
+ws_numa_set_huge_pages(gboolean enable)
+{
+    use_huge_pages = enable;
+}
+
+void
+ws_numa_advise_huge_pages(void *p, size_t len)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    guintptr start, end;
+
+    if (!use_huge_pages)
+        return;
+
+    /* Only the huge pages entirely within the allocation */
+    start = ((guintptr)p + HUGE_PAGE_SIZE - 1) & ~(guintptr)(HUGE_PAGE_SIZE - 1);
+    end = ((guintptr)p + len) & ~(guintptr)(HUGE_PAGE_SIZE - 1);
+    if (start < end) {
+        /* It's only advice; if transparent huge pages are disabled, it
+         * fails, and the memory is used as it is. */
+        madvise((void *)start, end - start, MADV_HUGEPAGE);
+    }
+#else
+    (void)p;
+    (void)len;
+#endif
+}
+
+gboolean
+ws_numa_get_memory_nodes(GString *str)
+{
+#ifdef __linux__
+    char *contents;
+    char **lines, **tokens;
+    GArray *node_kb;
+    guint64 pages, page_kb;
+    guint32 node;
+    guint i, j;
+    GArray *line_pages;
+    const char *sep = "";
+
+    /* Each mapping, with the number of its pages on each node as "N0=123" */
+    if (!g_file_get_contents("/proc/self/numa_maps", &contents, NULL, NULL))
+        return FALSE;
+
+    node_kb = g_array_new(FALSE, TRUE, sizeof(guint64));
+    line_pages = g_array_new(FALSE, TRUE, sizeof(guint64));
+    lines = g_strsplit(contents, "\n", -1);
+    g_free(contents);
+    for (i = 0; lines[i] != NULL; i++) {
+        page_kb = 4;
+        g_array_set_size(line_pages, 0);
+        tokens = g_strsplit(lines[i], " ", -1);
+        for (j = 0; tokens[j] != NULL; j++) {
+            if (tokens[j][0] == 'N' &&
+                sscanf(tokens[j] + 1, "%u=%" G_GUINT64_FORMAT, &node, &pages) == 2 &&
+                node < 1024) {
+                if (line_pages->len <= node)
+                    g_array_set_size(line_pages, node + 1);
+                g_array_index(line_pages, guint64, node) += pages;
+            } else if (g_str_has_prefix(tokens[j], "kernelpagesize_kB=")) {
+                page_kb = g_ascii_strtoull(tokens[j] + 18, NULL, 10);
+            }
+        }
+        g_strfreev(tokens);
+        if (node_kb->len < line_pages->len)
+            g_array_set_size(node_kb, line_pages->len);
+        for (node = 0; node < line_pages->len; node++)
+            g_array_index(node_kb, guint64, node) += g_array_index(line_pages, guint64, node) * page_kb;
+    }
+    g_strfreev(lines);
+    g_array_free(line_pages, TRUE);
+
+    if (node_kb->len == 0) {
+        /* Not a NUMA kernel */
+        g_array_free(node_kb, TRUE);
+        return FALSE;
+    }
+    for (node = 0; node < node_kb->len; node++) {
+        g_string_append_printf(str, "%snode%u %" G_GUINT64_FORMAT " kB", sep, node,
+                               g_array_index(node_kb, guint64, node));
+        sep = ", ";
+    }
+    g_array_free(node_kb, TRUE);
+    return TRUE;
+#else
+    (void)str;
+    return FALSE;
+#endif
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
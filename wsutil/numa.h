@@ -0,0 +1,72 @@
+/* numa.h
+ * Declarations of routines for placing threads and memory on
+ * multi-socket machines
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WSUTIL_NUMA_H__
+#define __WSUTIL_NUMA_H__
+
+#include <glib.h>
+
+#include "ws_symbol_export.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Restrict all the threads of the process, and those it creates later,
+ * to the CPUs given by spec: a list such as "0-7,16-23", "node:N" for
+ * the CPUs of NUMA node N, or "iface:NAME" for those of the node the
+ * network interface NAME is attached to.  As memory is allocated on the
+ * node of the CPU that first touches it, this keeps it there as well.
+ *
+ * Returns NULL on success, or a g_malloc()ed message saying what went
+ * wrong.
+ */
+WS_DLL_PUBLIC char *ws_numa_set_cpu_affinity(const char *spec);
+
+/*
+ * Whether ws_numa_advise_huge_pages() asks for huge pages; off by
+ * default, as they are only worth it for large, long-lived allocations.
+ */
+WS_DLL_PUBLIC void ws_numa_set_huge_pages(gboolean enable);
+
+/*
+ * If huge pages were asked for, ask for the whole huge pages in the len
+ * bytes at p to be backed by them.  Used for the blocks of the wmem block
+ * allocator, from which the file scope is allocated.
+ */
+WS_DLL_PUBLIC void ws_numa_advise_huge_pages(void *p, size_t len);
+
+/*
+ * Append to str how much of the memory of the process is on each NUMA
+ * node, as "node0 1234 kB, node1 56 kB".  Returns FALSE, appending
+ * nothing, if that isn't known.
+ */
+WS_DLL_PUBLIC gboolean ws_numa_get_memory_nodes(GString *str);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __WSUTIL_NUMA_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -29,9 +29,10 @@
 #include <wsutil/ws_printf.h> /* ws_debug_printf */
 
 typedef struct _plugin {
-    GModule        *handle;       /* handle returned by g_module_open */
+    GModule        *handle;       /* handle returned by g_module_open; NULL until a deferred plugin is loaded */
     gchar          *name;         /* plugin name */
-    const gchar    *version;      /* plugin version */
+    gchar          *filename;     /* plugin file path */
+    gchar          *version;      /* plugin version */
     const gchar    *type_name;    /* user-facing name (what it does). Should these be capitalized? */
 } plugin;
 
@@ -85,8 +86,11 @@ static void
 free_plugin(gpointer data)
 {
     plugin *p = (plugin *)data;
-    g_module_close(p->handle);
+    if (p->handle)
+        g_module_close(p->handle);
     g_free(p->name);
+    g_free(p->filename);
+    g_free(p->version);
     g_free(p);
 }
 
@@ -123,16 +127,64 @@ pass_plugin_version_compatibility(GModule *handle, const char *name)
     return TRUE;
 }
 
+/*
+ * Open a plugin, check that it's one for this version, and call its
+ * registration function.
+ */
+static gboolean
+load_plugin(plugin *plug)
+{
+    GModule       *handle;          /* handle returned by g_module_open */
+    gpointer       symbol;
+    const char    *plug_version;
+
+    handle = g_module_open(plug->filename, G_MODULE_BIND_LOCAL);
+    if (handle == NULL) {
+        /* g_module_error() provides file path. */
+        report_failure("Couldn't load plugin '%s': %s", plug->name,
+                        g_module_error());
+        return FALSE;
+    }
+
+    if (!g_module_symbol(handle, "plugin_version", &symbol))
+    {
+        report_failure("The plugin '%s' has no \"plugin_version\" symbol", plug->name);
+        g_module_close(handle);
+        return FALSE;
+    }
+    plug_version = (const char *)symbol;
+
+    if (!pass_plugin_version_compatibility(handle, plug->name)) {
+        g_module_close(handle);
+        return FALSE;
+    }
+
+    /* Search for the entry point for the plugin registration function */
+    if (!g_module_symbol(handle, "plugin_register", &symbol)) {
+        report_failure("The plugin '%s' has no \"plugin_register\" symbol", plug->name);
+        g_module_close(handle);
+        return FALSE;
+    }
+
+DIAG_OFF_PEDANTIC
+    /* Found it, call the plugin registration function. */
+    ((plugin_register_func)symbol)();
+DIAG_ON_PEDANTIC
+
+    plug->handle = handle;
+    g_free(plug->version);
+    plug->version = g_strdup(plug_version);
+    return TRUE;
+}
+
 static void
-scan_plugins_dir(GHashTable *plugins_module, const char *dirpath, plugin_type_e type, gboolean append_type)
+scan_plugins_dir(GHashTable *plugins_module, const char *dirpath, plugin_type_e type, gboolean append_type,
+                 plugin_defer_callback defer_cb, void *user_data)
 {
     GDir          *dir;
     const char    *name;            /* current file name */
     gchar         *plugin_folder;
-    gchar         *plugin_file;     /* current file full path */
-    GModule       *handle;          /* handle returned by g_module_open */
-    gpointer       symbol;
-    const char    *plug_version;
+    const char    *deferred_version;
     plugin        *new_plug;
 
     if (append_type)
@@ -161,47 +213,22 @@ scan_plugins_dir(GHashTable *plugins_module, const char *dirpath, plugin_type_e
             continue;
         }
 
-        plugin_file = g_build_filename(plugin_folder, name, (gchar *)NULL);
-        handle = g_module_open(plugin_file, G_MODULE_BIND_LOCAL);
-        g_free(plugin_file);
-        if (handle == NULL) {
-            /* g_module_error() provides file path. */
-            report_failure("Couldn't load plugin '%s': %s", name,
-                            g_module_error());
-            continue;
-        }
-
-        if (!g_module_symbol(handle, "plugin_version", &symbol))
-        {
-            report_failure("The plugin '%s' has no \"plugin_version\" symbol", name);
-            g_module_close(handle);
-            continue;
-        }
-        plug_version = (const char *)symbol;
-
-        if (!pass_plugin_version_compatibility(handle, name)) {
-            g_module_close(handle);
-            continue;
-        }
-
-        /* Search for the entry point for the plugin registration function */
-        if (!g_module_symbol(handle, "plugin_register", &symbol)) {
-            report_failure("The plugin '%s' has no \"plugin_register\" symbol", name);
-            g_module_close(handle);
-            continue;
-        }
-
-DIAG_OFF_PEDANTIC
-        /* Found it, call the plugin registration function. */
-        ((plugin_register_func)symbol)();
-DIAG_ON_PEDANTIC
-
         new_plug = g_new(plugin, 1);
-        new_plug->handle = handle;
+        new_plug->handle = NULL;
         new_plug->name = g_strdup(name);
-        new_plug->version = plug_version;
+        new_plug->filename = g_build_filename(plugin_folder, name, (gchar *)NULL);
+        new_plug->version = NULL;
         new_plug->type_name = type_to_name(type);
 
+        deferred_version = defer_cb ? defer_cb(new_plug->name, new_plug->filename, user_data) : NULL;
+        if (deferred_version != NULL) {
+            /* It's loaded by plugins_load() when it's needed. */
+            new_plug->version = g_strdup(deferred_version);
+        } else if (!load_plugin(new_plug)) {
+            free_plugin(new_plug);
+            continue;
+        }
+
         /* Add it to the list of plugins. */
         g_hash_table_replace(plugins_module, new_plug->name, new_plug);
     }
@@ -214,6 +241,12 @@ DIAG_ON_PEDANTIC
  */
 plugins_t *
 plugins_init(plugin_type_e type)
+{
+    return plugins_init_deferred(type, NULL, NULL);
+}
+
+plugins_t *
+plugins_init_deferred(plugin_type_e type, plugin_defer_callback defer_cb, void *user_data)
 {
     if (!g_module_supported())
         return NULL; /* nothing to do */
@@ -223,7 +256,7 @@ plugins_init(plugin_type_e type)
     /*
      * Scan the global plugin directory.
      */
-    scan_plugins_dir(plugins_module, get_plugins_dir_with_version(), type, TRUE);
+    scan_plugins_dir(plugins_module, get_plugins_dir_with_version(), type, TRUE, defer_cb, user_data);
 
     /*
      * If the program wasn't started with special privileges,
@@ -234,7 +267,7 @@ plugins_init(plugin_type_e type)
      * reclaim them before each time we start capturing.)
      */
     if (!started_with_special_privs()) {
-        scan_plugins_dir(plugins_module, get_plugins_pers_dir_with_version(), type, TRUE);
+        scan_plugins_dir(plugins_module, get_plugins_pers_dir_with_version(), type, TRUE, defer_cb, user_data);
     }
 
     plugins_module_list = g_slist_prepend(plugins_module_list, plugins_module);
@@ -242,6 +275,26 @@ plugins_init(plugin_type_e type)
     return plugins_module;
 }
 
+gboolean
+plugins_load(plugins_t *plugins, const char *name)
+{
+    plugin *plug;
+
+    if (!plugins)
+        return FALSE;
+
+    plug = (plugin *)g_hash_table_lookup((GHashTable *)plugins, name);
+    if (plug == NULL)
+        return FALSE;
+    if (plug->handle != NULL)
+        return TRUE;
+    if (!load_plugin(plug)) {
+        g_hash_table_remove((GHashTable *)plugins, name);
+        return FALSE;
+    }
+    return TRUE;
+}
+
 WS_DLL_PUBLIC void
 plugins_get_descriptions(plugin_description_callback callback, void *callback_data)
 {
@@ -260,7 +313,7 @@ plugins_get_descriptions(plugin_description_callback callback, void *callback_da
 
     for (guint i = 0; i < plugins_array->len; i++) {
         plugin *plug = (plugin *)plugins_array->pdata[i];
-        callback(plug->name, plug->version, plug->type_name, g_module_name(plug->handle), callback_data);
+        callback(plug->name, plug->version, plug->type_name, plug->filename, callback_data);
     }
 
     g_ptr_array_free(plugins_array, TRUE);
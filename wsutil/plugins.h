@@ -32,6 +32,26 @@ typedef enum {
 
 WS_DLL_PUBLIC plugins_t *plugins_init(plugin_type_e type);
 
+/*
+ * Called for each plugin plugins_init_deferred() finds, before it's
+ * loaded.  If it returns a version string, the plugin isn't loaded until
+ * plugins_load() is called for it, and is listed with that version until
+ * then; if it returns NULL, the plugin is loaded now.
+ */
+typedef const char *(*plugin_defer_callback)(const char *name, const char *filename,
+                                             void *user_data);
+
+WS_DLL_PUBLIC plugins_t *plugins_init_deferred(plugin_type_e type,
+                                               plugin_defer_callback defer_cb,
+                                               void *user_data);
+
+/*
+ * Load, and register, a plugin whose loading was deferred.  Returns
+ * TRUE if it's loaded, now or before; a plugin that fails to load is
+ * dropped from the list.
+ */
+WS_DLL_PUBLIC gboolean plugins_load(plugins_t *plugins, const char *name);
+
 typedef void (*plugin_description_callback)(const char *name, const char *version,
                                             const char *types, const char *filename,
                                             void *user_data);
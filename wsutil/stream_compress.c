@@ -0,0 +1,417 @@
+/* stream_compress.c
+ * Write zstd and LZ4 frame compressed files, compressing on a separate
+ * thread
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <string.h>
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+
+#include <glib.h>
+
+#include "file_util.h"
+#include "stream_compress.h"
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif /* HAVE_ZSTD */
+
+#ifdef HAVE_LZ4FRAME_H
+#include <lz4frame.h>
+#endif /* HAVE_LZ4FRAME_H */
+
+#if defined(HAVE_ZSTD) || defined(HAVE_LZ4FRAME_H)
+
+/*
+ * How much uncompressed data the thread reads from the pipe at a time,
+ * and how much we ask the OS to let the pipe hold, so that the writer
+ * only waits if the compressor falls a long way behind.
+ */
+#define CSTREAM_CHUNK_SIZE  (1024 * 1024)
+#define CSTREAM_PIPE_SIZE   (1024 * 1024)
+
+/*
+ * zstd level 1 compresses at several hundred MB/s on one core, which
+ * keeps up with all but the busiest captures, and still does much
+ * better than gzip's default level on typical traffic.
+ */
+#define CSTREAM_ZSTD_LEVEL  1
+
+struct ws_cstream {
+    ws_cstream_type  type;
+    FILE            *fh;            /* write end of the pipe */
+    int              read_fd;       /* read end of the pipe */
+    int              out_fd;        /* the compressed file */
+    GThread         *thread;
+    gint             err;           /* first error, or 0 */
+    guint8          *in_buf;
+    guint8          *out_buf;
+    size_t           out_buf_size;
+#ifdef HAVE_ZSTD
+    ZSTD_CStream    *zstd;
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    LZ4F_cctx       *lz4;
+#endif
+};
+
+static void
+cstream_set_error(ws_cstream *cs, int err)
+{
+    /* Only the first error is reported. */
+    g_atomic_int_compare_and_exchange(&cs->err, 0, err);
+}
+
+/* Write all of a buffer of compressed data to the file. */
+static void
+cstream_write_out(ws_cstream *cs, const guint8 *buf, size_t len)
+{
+    if (g_atomic_int_get(&cs->err) != 0)
+        return;
+
+    while (len > 0) {
+        ssize_t nwritten = ws_write(cs->out_fd, buf, (unsigned int)len);
+
+        if (nwritten < 0) {
+            if (errno == EINTR)
+                continue;
+            cstream_set_error(cs, errno);
+            return;
+        }
+        buf += nwritten;
+        len -= nwritten;
+    }
+}
+
+#ifdef HAVE_ZSTD
+static gboolean
+zstd_start(ws_cstream *cs)
+{
+    cs->zstd = ZSTD_createCStream();
+    if (cs->zstd == NULL)
+        return FALSE;
+    if (ZSTD_isError(ZSTD_initCStream(cs->zstd, CSTREAM_ZSTD_LEVEL)))
+        return FALSE;
+    cs->out_buf_size = ZSTD_CStreamOutSize();
+    cs->out_buf = (guint8 *)g_malloc(cs->out_buf_size);
+    return TRUE;
+}
+
+/* Compress some data, or, if len is 0, finish the frame. */
+static void
+zstd_compress(ws_cstream *cs, const guint8 *buf, size_t len)
+{
+    ZSTD_inBuffer input = { buf, len, 0 };
+    ZSTD_outBuffer output;
+    size_t ret;
+
+    do {
+        output.dst = cs->out_buf;
+        output.size = cs->out_buf_size;
+        output.pos = 0;
+        if (len != 0)
+            ret = ZSTD_compressStream(cs->zstd, &output, &input);
+        else
+            ret = ZSTD_endStream(cs->zstd, &output);
+        if (ZSTD_isError(ret)) {
+            cstream_set_error(cs, EIO);
+            return;
+        }
+        cstream_write_out(cs, cs->out_buf, output.pos);
+        /* ZSTD_endStream() returns the number of bytes it still has
+           to write out. */
+    } while (len != 0 ? input.pos < input.size : ret != 0);
+}
+#endif /* HAVE_ZSTD */
+
+#ifdef HAVE_LZ4FRAME_H
+static gboolean
+lz4_start(ws_cstream *cs)
+{
+    size_t ret;
+
+    if (LZ4F_isError(LZ4F_createCompressionContext(&cs->lz4, LZ4F_VERSION))) {
+        cs->lz4 = NULL;
+        return FALSE;
+    }
+    /* Big enough for the result of compressing a whole chunk, along
+       with the frame header or end mark. */
+    cs->out_buf_size = LZ4F_compressBound(CSTREAM_CHUNK_SIZE, NULL) + LZ4F_HEADER_SIZE_MAX;
+    cs->out_buf = (guint8 *)g_malloc(cs->out_buf_size);
+    ret = LZ4F_compressBegin(cs->lz4, cs->out_buf, cs->out_buf_size, NULL);
+    if (LZ4F_isError(ret))
+        return FALSE;
+    cstream_write_out(cs, cs->out_buf, ret);
+    return TRUE;
+}
+
+/* Compress some data, or, if len is 0, finish the frame. */
+static void
+lz4_compress(ws_cstream *cs, const guint8 *buf, size_t len)
+{
+    size_t ret;
+
+    if (len != 0)
+        ret = LZ4F_compressUpdate(cs->lz4, cs->out_buf, cs->out_buf_size, buf, len, NULL);
+    else
+        ret = LZ4F_compressEnd(cs->lz4, cs->out_buf, cs->out_buf_size, NULL);
+    if (LZ4F_isError(ret)) {
+        cstream_set_error(cs, EIO);
+        return;
+    }
+    cstream_write_out(cs, cs->out_buf, ret);
+}
+#endif /* HAVE_LZ4FRAME_H */
+
+static void
+cstream_compress(ws_cstream *cs, const guint8 *buf, size_t len)
+{
+    switch (cs->type) {
+
+#ifdef HAVE_ZSTD
+    case WS_CSTREAM_ZSTD:
+        zstd_compress(cs, buf, len);
+        break;
+#endif
+
+#ifdef HAVE_LZ4FRAME_H
+    case WS_CSTREAM_LZ4:
+        lz4_compress(cs, buf, len);
+        break;
+#endif
+
+    default:
+        g_assert_not_reached();
+    }
+}
+
+/*
+ * Read the pipe until the writer closes it, compressing what we read.
+ * After an error we keep reading, and throw the data away, so that the
+ * writer never waits for us forever.
+ */
+static void *
+cstream_thread(void *arg)
+{
+    ws_cstream *cs = (ws_cstream *)arg;
+    ssize_t nread;
+
+    for (;;) {
+        nread = ws_read(cs->read_fd, cs->in_buf, CSTREAM_CHUNK_SIZE);
+        if (nread < 0) {
+            if (errno == EINTR)
+                continue;
+            cstream_set_error(cs, errno);
+            break;
+        }
+        if (nread == 0)
+            break;
+        if (g_atomic_int_get(&cs->err) == 0)
+            cstream_compress(cs, cs->in_buf, (size_t)nread);
+    }
+
+    if (g_atomic_int_get(&cs->err) == 0)
+        cstream_compress(cs, NULL, 0);
+    ws_close(cs->read_fd);
+    cs->read_fd = -1;
+
+    return NULL;
+}
+
+static void
+cstream_free(ws_cstream *cs)
+{
+#ifdef HAVE_ZSTD
+    if (cs->zstd != NULL)
+        ZSTD_freeCStream(cs->zstd);
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    if (cs->lz4 != NULL)
+        LZ4F_freeCompressionContext(cs->lz4);
+#endif
+    g_free(cs->in_buf);
+    g_free(cs->out_buf);
+    g_free(cs);
+}
+#endif /* HAVE_ZSTD || HAVE_LZ4FRAME_H */
+
+gboolean
+ws_cstream_type_supported(ws_cstream_type type)
+{
+    switch (type) {
+
+#ifdef HAVE_ZSTD
+    case WS_CSTREAM_ZSTD:
+        return TRUE;
+#endif
+
+#ifdef HAVE_LZ4FRAME_H
+    case WS_CSTREAM_LZ4:
+        return TRUE;
+#endif
+
+    default:
+        return FALSE;
+    }
+}
+
+#if defined(HAVE_ZSTD) || defined(HAVE_LZ4FRAME_H)
+ws_cstream *
+ws_cstream_fdopen(int fd, ws_cstream_type type, int *err)
+{
+    ws_cstream *cs;
+    int pipe_fds[2];
+    gboolean started;
+
+    if (!ws_cstream_type_supported(type)) {
+        *err = EINVAL;
+        return NULL;
+    }
+
+    cs = g_new0(ws_cstream, 1);
+    cs->type = type;
+    cs->out_fd = fd;
+
+    switch (type) {
+
+#ifdef HAVE_ZSTD
+    case WS_CSTREAM_ZSTD:
+        started = zstd_start(cs);
+        break;
+#endif
+
+#ifdef HAVE_LZ4FRAME_H
+    case WS_CSTREAM_LZ4:
+        started = lz4_start(cs);
+        break;
+#endif
+
+    default:
+        started = FALSE;
+        break;
+    }
+    if (!started || cs->err != 0) {
+        *err = cs->err != 0 ? cs->err : ENOMEM;
+        cstream_free(cs);
+        return NULL;
+    }
+
+#ifdef _WIN32
+    if (_pipe(pipe_fds, CSTREAM_PIPE_SIZE, _O_BINARY) != 0) {
+#else
+    if (pipe(pipe_fds) != 0) {
+#endif
+        *err = errno;
+        cstream_free(cs);
+        return NULL;
+    }
+#ifndef _WIN32
+    /* Don't give the pipe to any programs we run. */
+    fcntl(pipe_fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(pipe_fds[1], F_SETFD, FD_CLOEXEC);
+#endif
+#ifdef F_SETPIPE_SZ
+    /* Linux pipes hold 64 KiB by default; this can fail if we're over
+       the limit on pipe sizes, which just means we wait sooner. */
+    fcntl(pipe_fds[1], F_SETPIPE_SZ, CSTREAM_PIPE_SIZE);
+#endif
+
+    cs->read_fd = pipe_fds[0];
+    cs->fh = ws_fdopen(pipe_fds[1], "wb");
+    if (cs->fh == NULL) {
+        *err = errno;
+        ws_close(pipe_fds[0]);
+        ws_close(pipe_fds[1]);
+        cstream_free(cs);
+        return NULL;
+    }
+
+    cs->in_buf = (guint8 *)g_malloc(CSTREAM_CHUNK_SIZE);
+    cs->thread = g_thread_new("ws_cstream", cstream_thread, cs);
+
+    return cs;
+}
+
+FILE *
+ws_cstream_file(ws_cstream *cs)
+{
+    return cs->fh;
+}
+
+int
+ws_cstream_error(ws_cstream *cs)
+{
+    return g_atomic_int_get(&cs->err);
+}
+
+int
+ws_cstream_close(ws_cstream *cs)
+{
+    int err = 0;
+
+    /* Closing the write end of the pipe makes the thread finish. */
+    if (fclose(cs->fh) == EOF)
+        err = errno != 0 ? errno : EIO;
+    g_thread_join(cs->thread);
+    if (cs->err != 0)
+        err = cs->err;
+    if (ws_close(cs->out_fd) != 0 && err == 0)
+        err = errno;
+    cstream_free(cs);
+
+    return err;
+}
+#else /* HAVE_ZSTD || HAVE_LZ4FRAME_H */
+ws_cstream *
+ws_cstream_fdopen(int fd _U_, ws_cstream_type type _U_, int *err)
+{
+    *err = EINVAL;
+    return NULL;
+}
+
+FILE *
+ws_cstream_file(ws_cstream *cs _U_)
+{
+    return NULL;
+}
+
+int
+ws_cstream_error(ws_cstream *cs _U_)
+{
+    return EINVAL;
+}
+
+int
+ws_cstream_close(ws_cstream *cs _U_)
+{
+    return EINVAL;
+}
+#endif /* HAVE_ZSTD || HAVE_LZ4FRAME_H */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,95 @@
+/* stream_compress.h
+ * Write zstd and LZ4 frame compressed files, compressing on a separate
+ * thread
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WS_STREAM_COMPRESS_H__
+#define __WS_STREAM_COMPRESS_H__
+
+#include <stdio.h>
+
+#include <glib.h>
+
+#include "ws_symbol_export.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * A compressed output stream is a standard I/O stream whose data goes
+ * through a pipe to a thread that compresses it and writes it to a file,
+ * so that whoever writes to the stream only waits for the compressor if
+ * it can't keep up and the pipe fills.  The stream is written to like
+ * any other FILE *; nothing is compressed until it reaches the thread,
+ * so fflush() doesn't make the data so far readable from the file.
+ *
+ * The result is a single zstd or LZ4 frame, which the file_wrappers.c
+ * code in libwiretap can read.
+ */
+typedef struct ws_cstream ws_cstream;
+
+typedef enum {
+    WS_CSTREAM_ZSTD,
+    WS_CSTREAM_LZ4
+} ws_cstream_type;
+
+/** Can we write files compressed this way?  That depends on the
+ * libraries we were built with.
+ */
+WS_DLL_PUBLIC gboolean ws_cstream_type_supported(ws_cstream_type type);
+
+/** Start compressing to a file.
+ *
+ * @param fd the file to write the compressed data to; on success, it
+ * belongs to the stream, and is closed by ws_cstream_close()
+ * @param type the kind of compression
+ * @param err set to an errno value on failure
+ * @return the stream, or NULL on failure
+ */
+WS_DLL_PUBLIC ws_cstream *ws_cstream_fdopen(int fd, ws_cstream_type type, int *err);
+
+/** Get the standard I/O stream to write the uncompressed data to; it
+ * is closed by ws_cstream_close(), not by the caller.
+ */
+WS_DLL_PUBLIC FILE *ws_cstream_file(ws_cstream *cs);
+
+/** Get the errno value for the first error the compression thread has
+ * had writing the file so far, or 0 if it has had none; the error is
+ * also reported by ws_cstream_close().
+ */
+WS_DLL_PUBLIC int ws_cstream_error(ws_cstream *cs);
+
+/** Close the standard I/O stream, wait for the thread to compress the
+ * rest of the data and finish the frame, close the file and free the
+ * stream.
+ *
+ * @return 0, or the errno value for the first error writing, compressing
+ * or closing
+ */
+WS_DLL_PUBLIC int ws_cstream_close(ws_cstream *cs);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __WS_STREAM_COMPRESS_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
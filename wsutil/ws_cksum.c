@@ -0,0 +1,130 @@
+/* ws_cksum.c
+ * Sum of 16-bit words for the Internet checksum
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include "ws_cksum.h"
+#include "ws_cksum_int.h"
+#ifdef HAVE_AVX2
+#include "ws_cpuid.h"
+#endif
+
+#ifdef HAVE_AVX2
+/* Can we use the AVX2 version?  -1 if we haven't checked yet. */
+static int use_avx2 = -1;
+#endif
+
+/* Fold a 64-bit one's complement sum to 32 bits. */
+static guint32
+fold64(guint64 sum)
+{
+    sum = (sum & 0xffffffff) + (sum >> 32);
+    sum = (sum & 0xffffffff) + (sum >> 32);
+    return (guint32)sum;
+}
+
+/*
+ * Up to 32768 16-bit words can be added to a 32-bit sum without
+ * overflowing it.
+ */
+#define PORTABLE_WORDS_PER_CHUNK    32768
+
+guint32
+ws_cksum_portable_sum(const guint8 *ptr, size_t len)
+{
+    const guint16 *w = (const guint16 *)(const void *)ptr;
+    guint64 sum = 0;
+
+    while (len >= 2) {
+        guint32 chunk_sum = 0;
+        size_t words = len / 2;
+
+        if (words > PORTABLE_WORDS_PER_CHUNK)
+            words = PORTABLE_WORDS_PER_CHUNK;
+        len -= words * 2;
+        /*
+         * Unroll the loop to make overhead from
+         * branches &c small.
+         */
+        for (; words >= 16; words -= 16) {
+            chunk_sum += w[0]; chunk_sum += w[1]; chunk_sum += w[2]; chunk_sum += w[3];
+            chunk_sum += w[4]; chunk_sum += w[5]; chunk_sum += w[6]; chunk_sum += w[7];
+            chunk_sum += w[8]; chunk_sum += w[9]; chunk_sum += w[10]; chunk_sum += w[11];
+            chunk_sum += w[12]; chunk_sum += w[13]; chunk_sum += w[14]; chunk_sum += w[15];
+            w += 16;
+        }
+        for (; words != 0; words--)
+            chunk_sum += *w++;
+        sum += chunk_sum;
+    }
+    if (len != 0) {
+        /* Pad the last byte with a zero byte, in memory order. */
+        union {
+            guint8  c[2];
+            guint16 s;
+        } last;
+
+        last.c[0] = *(const guint8 *)w;
+        last.c[1] = 0;
+        sum += last.s;
+    }
+
+    return fold64(sum);
+}
+
+gboolean
+ws_cksum_have_simd(void)
+{
+#ifdef HAVE_AVX2
+    if (use_avx2 == -1)
+        use_avx2 = ws_cpuid_avx2() ? 1 : 0;
+    return use_avx2;
+#elif defined(HAVE_CKSUM_NEON)
+    return TRUE;
+#else
+    return FALSE;
+#endif
+}
+
+guint16
+ws_cksum_sum(const guint8 *ptr, size_t len)
+{
+    guint32 sum;
+
+#ifdef HAVE_AVX2
+    if (len >= 64 && ws_cksum_have_simd())
+        sum = ws_cksum_avx2_sum(ptr, len);
+    else
+#elif defined(HAVE_CKSUM_NEON)
+    if (len >= 32)
+        sum = ws_cksum_neon_sum(ptr, len);
+    else
+#endif
+        sum = ws_cksum_portable_sum(ptr, len);
+
+    sum = (sum & 0xffff) + (sum >> 16);
+    sum = (sum & 0xffff) + (sum >> 16);
+    return (guint16)sum;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
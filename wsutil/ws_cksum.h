@@ -0,0 +1,42 @@
+/* ws_cksum.h
+ * Sum of 16-bit words for the Internet checksum
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WS_CKSUM_H__
+#define __WS_CKSUM_H__
+
+#include "ws_symbol_export.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** Compute the one's complement sum of a buffer, taken as 16-bit words
+ * in host byte order, as RFC 1071 describes; if len is odd, the last
+ * byte is padded with a zero byte.
+ *
+ * The sum is *not* complemented, so that sums of several pieces can be
+ * added together.
+ *
+ * @param ptr the data to sum, which must be 16-bit aligned
+ * @param len the length of the data
+ * @return the sum, folded to 16 bits
+ */
+WS_DLL_PUBLIC guint16 ws_cksum_sum(const guint8 *ptr, size_t len);
+
+/** Can ws_cksum_sum() use SIMD instructions on this machine?  If not,
+ * it's no faster than a plain unrolled loop.
+ */
+WS_DLL_PUBLIC gboolean ws_cksum_have_simd(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __WS_CKSUM_H__ */
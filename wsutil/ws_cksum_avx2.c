@@ -0,0 +1,99 @@
+/* ws_cksum_avx2.c
+ * Sum of 16-bit words for the Internet checksum, with AVX2 intrinsics
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#ifdef HAVE_AVX2
+
+#include <glib.h>
+
+#include <immintrin.h>
+
+#include "ws_cksum.h"
+#include "ws_cksum_int.h"
+
+/*
+ * Each 16-bit word is added into the 32-bit lane it's in, so a lane can
+ * take 65536 words before it might overflow; we move the lanes into
+ * 64-bit sums well before that.
+ */
+#define AVX2_ITERATIONS_PER_CHUNK   32768
+
+/* Add the 32-bit lanes of v to the 64-bit lanes of sum. */
+static inline __m256i
+add_lanes(__m256i sum, __m256i v)
+{
+    const __m256i low32 = _mm256_set1_epi64x(0xffffffff);
+
+    sum = _mm256_add_epi64(sum, _mm256_and_si256(v, low32));
+    return _mm256_add_epi64(sum, _mm256_srli_epi64(v, 32));
+}
+
+/*
+ * This is only called if ws_cpuid_avx2() says we have AVX2; that check
+ * is done in ws_cksum.c, which isn't compiled with the AVX2 flag.  The
+ * loads needn't be aligned.
+ */
+guint32
+ws_cksum_avx2_sum(const guint8 *ptr, size_t len)
+{
+    const __m256i low16 = _mm256_set1_epi32(0xffff);
+    __m256i sum = _mm256_setzero_si256();
+    guint64 lanes[4];
+    guint64 total;
+
+    while (len >= 64) {
+        __m256i lo0 = _mm256_setzero_si256(), hi0 = _mm256_setzero_si256();
+        __m256i lo1 = _mm256_setzero_si256(), hi1 = _mm256_setzero_si256();
+        size_t iterations = len / 64;
+
+        if (iterations > AVX2_ITERATIONS_PER_CHUNK)
+            iterations = AVX2_ITERATIONS_PER_CHUNK;
+        len -= iterations * 64;
+        while (iterations-- != 0) {
+            __m256i v0 = _mm256_loadu_si256((const __m256i *)(const void *)ptr);
+            __m256i v1 = _mm256_loadu_si256((const __m256i *)(const void *)(ptr + 32));
+
+            lo0 = _mm256_add_epi32(lo0, _mm256_and_si256(v0, low16));
+            hi0 = _mm256_add_epi32(hi0, _mm256_srli_epi32(v0, 16));
+            lo1 = _mm256_add_epi32(lo1, _mm256_and_si256(v1, low16));
+            hi1 = _mm256_add_epi32(hi1, _mm256_srli_epi32(v1, 16));
+            ptr += 64;
+        }
+        sum = add_lanes(sum, lo0);
+        sum = add_lanes(sum, hi0);
+        sum = add_lanes(sum, lo1);
+        sum = add_lanes(sum, hi1);
+    }
+
+    _mm256_storeu_si256((__m256i *)(void *)lanes, sum);
+    total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+
+    /* We've consumed a multiple of 64 bytes, so the words still line up. */
+    total += ws_cksum_portable_sum(ptr, len);
+    total = (total & 0xffffffff) + (total >> 32);
+    total = (total & 0xffffffff) + (total >> 32);
+    return (guint32)total;
+}
+
+#endif /* HAVE_AVX2 */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
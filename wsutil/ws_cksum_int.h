@@ -0,0 +1,29 @@
+/* ws_cksum_int.h
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WS_CKSUM_INT_H__
+#define __WS_CKSUM_INT_H__
+
+/*
+ * These return the sum folded to 32 bits; ws_cksum_sum() folds it the
+ * rest of the way.
+ */
+guint32 ws_cksum_portable_sum(const guint8 *ptr, size_t len);
+
+#ifdef HAVE_AVX2
+guint32 ws_cksum_avx2_sum(const guint8 *ptr, size_t len);
+#endif
+
+/* NEON is always there on 64-bit ARM. */
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define HAVE_CKSUM_NEON 1
+guint32 ws_cksum_neon_sum(const guint8 *ptr, size_t len);
+#endif
+
+#endif /* __WS_CKSUM_INT_H__ */
@@ -0,0 +1,72 @@
+/* ws_cksum_neon.c
+ * Sum of 16-bit words for the Internet checksum, with NEON intrinsics
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include "ws_cksum.h"
+#include "ws_cksum_int.h"
+
+#ifdef HAVE_CKSUM_NEON
+
+#include <arm_neon.h>
+
+/*
+ * vpadalq_u16 adds pairs of 16-bit words into each 32-bit lane, so a
+ * lane can take 32768 pairs before it might overflow.
+ */
+#define NEON_ITERATIONS_PER_CHUNK   16384
+
+guint32
+ws_cksum_neon_sum(const guint8 *ptr, size_t len)
+{
+    uint64x2_t sum = vdupq_n_u64(0);
+    guint64 total;
+
+    while (len >= 32) {
+        uint32x4_t acc0 = vdupq_n_u32(0), acc1 = vdupq_n_u32(0);
+        size_t iterations = len / 32;
+
+        if (iterations > NEON_ITERATIONS_PER_CHUNK)
+            iterations = NEON_ITERATIONS_PER_CHUNK;
+        len -= iterations * 32;
+        while (iterations-- != 0) {
+            acc0 = vpadalq_u16(acc0, vreinterpretq_u16_u8(vld1q_u8(ptr)));
+            acc1 = vpadalq_u16(acc1, vreinterpretq_u16_u8(vld1q_u8(ptr + 16)));
+            ptr += 32;
+        }
+        sum = vpadalq_u32(sum, acc0);
+        sum = vpadalq_u32(sum, acc1);
+    }
+
+    total = vgetq_lane_u64(sum, 0) + vgetq_lane_u64(sum, 1);
+
+    /* We've consumed a multiple of 32 bytes, so the words still line up. */
+    total += ws_cksum_portable_sum(ptr, len);
+    total = (total & 0xffffffff) + (total >> 32);
+    total = (total & 0xffffffff) + (total >> 32);
+    return (guint32)total;
+}
+
+#endif /* HAVE_CKSUM_NEON */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
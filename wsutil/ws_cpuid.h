@@ -22,7 +22,8 @@ static gboolean
 ws_cpuid(guint32 *CPUInfo, guint32 selector)
 {
 	CPUInfo[0] = CPUInfo[1] = CPUInfo[2] = CPUInfo[3] = 0;
-	__cpuid((int *) CPUInfo, selector);
+	/* Leaf 7 has subleaves; we want subleaf 0. */
+	__cpuidex((int *) CPUInfo, selector, 0);
 	/* XXX, how to check if it's supported on MSVC? just in case clear all flags above */
 	return TRUE;
 }
@@ -89,7 +90,7 @@ ws_cpuid(guint32 *CPUInfo _U_, int selector _U_)
 }
 #endif
 
-static int
+static inline int
 ws_cpuid_sse42(void)
 {
 	guint32 CPUInfo[4];
@@ -100,3 +101,70 @@ ws_cpuid_sse42(void)
 	/* in ECX bit 20 toggled on */
 	return (CPUInfo[2] & (1 << 20));
 }
+
+static inline int
+ws_cpuid_pclmul(void)
+{
+	guint32 CPUInfo[4];
+
+	if (!ws_cpuid(CPUInfo, 1))
+		return 0;
+
+	/* in ECX bit 1 toggled on */
+	return (CPUInfo[2] & (1 << 1));
+}
+
+/*
+ * Get the state components the OS has enabled in XCR0; the AVX
+ * registers can only be used if the OS saves them on context switches.
+ */
+#if defined(_MSC_VER)
+#include <immintrin.h>
+
+static inline guint64
+ws_xgetbv0(void)
+{
+	return _xgetbv(0);
+}
+#elif defined(__GNUC__) && defined(__x86_64__)
+static inline guint64
+ws_xgetbv0(void)
+{
+	guint32 eax, edx;
+
+	__asm__ __volatile__("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+	return ((guint64)edx << 32) | eax;
+}
+#else
+static inline guint64
+ws_xgetbv0(void)
+{
+	return 0;
+}
+#endif
+
+static inline int
+ws_cpuid_avx2(void)
+{
+	guint32 CPUInfo[4];
+
+	if (!ws_cpuid(CPUInfo, 0) || CPUInfo[0] < 7)
+		return 0;
+
+	if (!ws_cpuid(CPUInfo, 1))
+		return 0;
+
+	/* in ECX bits 27 (OSXSAVE) and 28 (AVX) toggled on */
+	if ((CPUInfo[2] & (3U << 27)) != (3U << 27))
+		return 0;
+
+	/* XMM and YMM state saved by the OS */
+	if ((ws_xgetbv0() & 0x6) != 0x6)
+		return 0;
+
+	if (!ws_cpuid(CPUInfo, 7))
+		return 0;
+
+	/* in EBX bit 5 toggled on */
+	return (CPUInfo[1] & (1 << 5));
+}
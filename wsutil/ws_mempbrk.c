@@ -23,19 +23,48 @@
 #endif
 
 #include <glib.h>
+#include <string.h>
 #include "ws_symbol_export.h"
 #include "ws_mempbrk.h"
 #include "ws_mempbrk_int.h"
+#ifdef HAVE_AVX2
+#include "ws_cpuid.h"
+#endif
+#ifdef __SSE2__
+/* SSE2 is part of x86-64, so it needs no flag and no CPUID check. */
+#include <emmintrin.h>
+#include "bits_ctz.h"
+#endif
+
+#ifdef HAVE_AVX2
+/* Can we use the AVX2 versions?  -1 if we haven't checked yet. */
+static int use_avx2 = -1;
+
+static gboolean
+cpu_has_avx2(void)
+{
+    if (use_avx2 == -1)
+        use_avx2 = ws_cpuid_avx2() ? 1 : 0;
+    return use_avx2;
+}
+#endif
 
 void
 ws_mempbrk_compile(ws_mempbrk_pattern* pattern, const gchar *needles)
 {
     const gchar *n = needles;
     while (*n) {
-        pattern->patt[(int)*n] = 1;
+        guint8 c = (guint8)*n;
+
+        pattern->patt[c] = 1;
+        pattern->nibble_sets[c >> 7][c & 0x0f] |= 1 << ((c >> 4) & 7);
         n++;
     }
 
+#ifdef HAVE_AVX2
+    pattern->use_avx2 = cpu_has_avx2();
+#endif
+
 #ifdef HAVE_SSE4_2
     ws_mempbrk_sse42_compile(pattern, needles);
 #endif
@@ -63,15 +92,120 @@ ws_mempbrk_portable_exec(const guint8* haystack, size_t haystacklen, const ws_me
 WS_DLL_PUBLIC const guint8 *
 ws_mempbrk_exec(const guint8* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, guchar *found_needle)
 {
+#ifdef HAVE_AVX2
+    if (haystacklen >= 32 && pattern->use_avx2)
+        return ws_mempbrk_avx2_exec(haystack, haystacklen, pattern, found_needle);
+#endif
+
 #ifdef HAVE_SSE4_2
     if (haystacklen >= 16 && pattern->use_sse42)
         return ws_mempbrk_sse42_exec(haystack, haystacklen, pattern, found_needle);
 #endif
 
+#ifdef HAVE_MEMPBRK_NEON
+    if (haystacklen >= 16)
+        return ws_mempbrk_neon_exec(haystack, haystacklen, pattern, found_needle);
+#endif
+
     return ws_mempbrk_portable_exec(haystack, haystacklen, pattern, found_needle);
 }
 
 
+const guint8 *
+ws_memmem_portable(const guint8* haystack, size_t haystacklen, const guint8* needle, size_t needlelen)
+{
+    const guint8 *begin;
+    const guint8 *last_possible;
+
+    if (needlelen == 0 || needlelen > haystacklen)
+        return NULL;
+
+    /* Let memchr(), which is usually vectorized, look for the first
+       byte of the needle. */
+    last_possible = haystack + haystacklen - needlelen;
+    for (begin = haystack; begin <= last_possible; begin++) {
+        begin = (const guint8 *)memchr(begin, needle[0], last_possible - begin + 1);
+        if (begin == NULL)
+            return NULL;
+        if (begin[needlelen - 1] == needle[needlelen - 1] &&
+            memcmp(begin + 1, needle + 1, needlelen - 1) == 0)
+            return begin;
+    }
+
+    return NULL;
+}
+
+
+#ifdef __SSE2__
+/*
+ * This works the same way as ws_memmem_avx2(): compare 16 positions at a
+ * time with both the first and the last byte of the needle, and only
+ * compare the rest of it at the positions where both match.
+ */
+static const guint8 *
+ws_memmem_sse2(const guint8* haystack, size_t haystacklen, const guint8* needle, size_t needlelen)
+{
+    const __m128i first = _mm_set1_epi8((char)needle[0]);
+    const __m128i last = _mm_set1_epi8((char)needle[needlelen - 1]);
+    const guint8 *begin = haystack;
+    size_t left = haystacklen;
+
+    /* Each iteration reads 16 bytes from begin and from begin + needlelen - 1. */
+    while (left >= needlelen + 15) {
+        __m128i at_first = _mm_loadu_si128((const __m128i *)(const void *)begin);
+        __m128i at_last = _mm_loadu_si128((const __m128i *)(const void *)(begin + needlelen - 1));
+        guint32 mask = (guint32)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(at_first, first),
+                          _mm_cmpeq_epi8(at_last, last)));
+
+        while (mask != 0) {
+            int pos = ws_ctz(mask);
+
+            if (memcmp(begin + pos + 1, needle + 1, needlelen - 2) == 0)
+                return begin + pos;
+            mask &= mask - 1;
+        }
+        begin += 16;
+        left -= 16;
+    }
+
+    return ws_memmem_portable(begin, left, needle, needlelen);
+}
+#endif
+
+
+WS_DLL_PUBLIC const guint8 *
+ws_memmem(const guint8* haystack, size_t haystacklen, const guint8* needle, size_t needlelen)
+{
+#ifdef HAVE_AVX2
+    /*
+     * memchr() is already vectorized, and is faster if the first byte of
+     * the needle is rare, so only use the AVX2 version on longer buffers,
+     * where skipping the false starts pays for itself.
+     */
+    if (needlelen >= 2 && haystacklen >= needlelen + 127 && cpu_has_avx2())
+        return ws_memmem_avx2(haystack, haystacklen, needle, needlelen);
+#endif
+
+    /*
+     * Looking at the last byte of the needle as well as the first one
+     * throws away most false starts, which can make memchr() stop every
+     * few bytes on text (a needle beginning with a space or "e", say).
+     */
+#ifdef __SSE2__
+    if (needlelen >= 2 && haystacklen >= needlelen + 63)
+        return ws_memmem_sse2(haystack, haystacklen, needle, needlelen);
+#endif
+
+#ifdef HAVE_MEMPBRK_NEON
+    if (needlelen >= 2 && haystacklen >= needlelen + 63)
+        return ws_memmem_neon(haystack, haystacklen, needle, needlelen);
+#endif
+
+    return ws_memmem_portable(haystack, haystacklen, needle, needlelen);
+}
+
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
@@ -24,6 +24,10 @@ typedef struct {
     gboolean use_sse42;
     __m128i mask;
 #endif
+    /* For the AVX2 and NEON versions: for each needle c, bit (c >> 4) & 7
+     * is set in nibble_sets[c >> 7][c & 0x0f]. */
+    guint8 nibble_sets[2][16];
+    gboolean use_avx2;
 } ws_mempbrk_pattern;
 
 /** Compile the pattern for the needles to find using ws_mempbrk_exec().
@@ -34,4 +38,9 @@ WS_DLL_PUBLIC void ws_mempbrk_compile(ws_mempbrk_pattern* pattern, const gchar *
  */
 WS_DLL_PUBLIC const guint8 *ws_mempbrk_exec(const guint8* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, guchar *found_needle);
 
+/** Find the first occurrence of a byte string in another one.
+ * Returns NULL if it isn't found, or if needlelen is 0.
+ */
+WS_DLL_PUBLIC const guint8 *ws_memmem(const guint8* haystack, size_t haystacklen, const guint8* needle, size_t needlelen);
+
 #endif /* __WS_MEMPBRK_H__ */
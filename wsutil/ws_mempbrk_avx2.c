@@ -0,0 +1,117 @@
+/* ws_mempbrk_avx2.c
+ * mempbrk and memmem with AVX2 intrinsics
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#ifdef HAVE_AVX2
+
+#include <glib.h>
+#include <string.h>
+
+#include <immintrin.h>
+
+#include "ws_mempbrk.h"
+#include "ws_mempbrk_int.h"
+#include "bits_ctz.h"
+
+/*
+ * These are only called if ws_cpuid_avx2() says we have AVX2; that check
+ * is done in ws_mempbrk.c, which isn't compiled with the AVX2 flag, so
+ * that the compiler can't use AVX2 instructions in it.
+ */
+
+/*
+ * Each byte c is looked up in two 16-entry tables, indexed by its low
+ * nibble, with vpshufb; the table for the top bit of c gives the set of
+ * values of bits 4-6 of c that are needles with that low nibble.
+ */
+const guint8 *
+ws_mempbrk_avx2_exec(const guint8* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, guchar *found_needle)
+{
+    const __m256i sets_lo = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(const void *)pattern->nibble_sets[0]));
+    const __m256i sets_hi = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(const void *)pattern->nibble_sets[1]));
+    const __m256i bit_for_nibble = _mm256_setr_epi8(
+        1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+        1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    const __m256i low_nibble = _mm256_set1_epi8(0x0f);
+    const __m256i seven = _mm256_set1_epi8(7);
+    const __m256i zero = _mm256_setzero_si256();
+
+    while (haystacklen >= 32) {
+        __m256i value = _mm256_loadu_si256((const __m256i *)(const void *)haystack);
+        __m256i lo = _mm256_and_si256(value, low_nibble);
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi16(value, 4), low_nibble);
+        __m256i sets = _mm256_blendv_epi8(_mm256_shuffle_epi8(sets_lo, lo),
+                                          _mm256_shuffle_epi8(sets_hi, lo),
+                                          _mm256_cmpgt_epi8(hi, seven));
+        __m256i hits = _mm256_and_si256(sets, _mm256_shuffle_epi8(bit_for_nibble, hi));
+        guint32 mask = ~(guint32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hits, zero));
+
+        if (mask != 0) {
+            haystack += ws_ctz(mask);
+            if (found_needle)
+                *found_needle = *haystack;
+            return haystack;
+        }
+        haystack += 32;
+        haystacklen -= 32;
+    }
+
+    return ws_mempbrk_portable_exec(haystack, haystacklen, pattern, found_needle);
+}
+
+/*
+ * Look for the first and last bytes of the needle 32 positions at a time,
+ * and only compare the rest of it where both match.
+ */
+const guint8 *
+ws_memmem_avx2(const guint8* haystack, size_t haystacklen, const guint8* needle, size_t needlelen)
+{
+    const __m256i first = _mm256_set1_epi8((char)needle[0]);
+    const __m256i last = _mm256_set1_epi8((char)needle[needlelen - 1]);
+    const guint8 *begin = haystack;
+    size_t left = haystacklen;
+
+    /* Each iteration reads 32 bytes from begin and from begin + needlelen - 1. */
+    while (left >= needlelen + 31) {
+        __m256i at_first = _mm256_loadu_si256((const __m256i *)(const void *)begin);
+        __m256i at_last = _mm256_loadu_si256((const __m256i *)(const void *)(begin + needlelen - 1));
+        guint32 mask = (guint32)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(at_first, first),
+                             _mm256_cmpeq_epi8(at_last, last)));
+
+        while (mask != 0) {
+            int pos = ws_ctz(mask);
+
+            if (memcmp(begin + pos + 1, needle + 1, needlelen - 2) == 0)
+                return begin + pos;
+            mask &= mask - 1;
+        }
+        begin += 32;
+        left -= 32;
+    }
+
+    return ws_memmem_portable(begin, left, needle, needlelen);
+}
+
+#endif /* HAVE_AVX2 */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
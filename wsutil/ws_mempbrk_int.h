@@ -12,9 +12,23 @@
 
 const guint8 *ws_mempbrk_portable_exec(const guint8* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, guchar *found_needle);
 
+const guint8 *ws_memmem_portable(const guint8* haystack, size_t haystacklen, const guint8* needle, size_t needlelen);
+
 #ifdef HAVE_SSE4_2
 void ws_mempbrk_sse42_compile(ws_mempbrk_pattern* pattern, const gchar *needles);
 const char *ws_mempbrk_sse42_exec(const char* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, guchar *found_needle);
 #endif
 
+#ifdef HAVE_AVX2
+const guint8 *ws_mempbrk_avx2_exec(const guint8* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, guchar *found_needle);
+const guint8 *ws_memmem_avx2(const guint8* haystack, size_t haystacklen, const guint8* needle, size_t needlelen);
+#endif
+
+/* NEON is always there on 64-bit ARM. */
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define HAVE_MEMPBRK_NEON 1
+const guint8 *ws_mempbrk_neon_exec(const guint8* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, guchar *found_needle);
+const guint8 *ws_memmem_neon(const guint8* haystack, size_t haystacklen, const guint8* needle, size_t needlelen);
+#endif
+
 #endif /* __WS_MEMPBRK_INT_H__ */
@@ -0,0 +1,117 @@
+/* ws_mempbrk_neon.c
+ * mempbrk with NEON intrinsics
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <string.h>
+
+#include "ws_mempbrk.h"
+#include "ws_mempbrk_int.h"
+
+#ifdef HAVE_MEMPBRK_NEON
+
+#include <arm_neon.h>
+
+#include "bits_ctz.h"
+
+/*
+ * This works the same way as ws_mempbrk_avx2_exec(), 16 bytes at a time,
+ * with tbl doing the table lookups.
+ */
+const guint8 *
+ws_mempbrk_neon_exec(const guint8* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, guchar *found_needle)
+{
+    static const guint8 bit_for_nibble_bytes[16] = {
+        1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128
+    };
+    const uint8x16_t sets_lo = vld1q_u8(pattern->nibble_sets[0]);
+    const uint8x16_t sets_hi = vld1q_u8(pattern->nibble_sets[1]);
+    const uint8x16_t bit_for_nibble = vld1q_u8(bit_for_nibble_bytes);
+    const uint8x16_t low_nibble = vdupq_n_u8(0x0f);
+    const uint8x16_t seven = vdupq_n_u8(7);
+
+    while (haystacklen >= 16) {
+        uint8x16_t value = vld1q_u8(haystack);
+        uint8x16_t lo = vandq_u8(value, low_nibble);
+        uint8x16_t hi = vshrq_n_u8(value, 4);
+        uint8x16_t sets = vbslq_u8(vcgtq_u8(hi, seven),
+                                   vqtbl1q_u8(sets_hi, lo),
+                                   vqtbl1q_u8(sets_lo, lo));
+        uint8x16_t hits = vtstq_u8(sets, vqtbl1q_u8(bit_for_nibble, hi));
+
+        if (vmaxvq_u8(hits) != 0) {
+            /* Narrow the 0x00/0xff bytes to 4 bits each. */
+            guint64 mask = vget_lane_u64(vreinterpret_u64_u8(
+                vshrn_n_u16(vreinterpretq_u16_u8(hits), 4)), 0);
+
+            haystack += ws_ctz(mask) / 4;
+            if (found_needle)
+                *found_needle = *haystack;
+            return haystack;
+        }
+        haystack += 16;
+        haystacklen -= 16;
+    }
+
+    return ws_mempbrk_portable_exec(haystack, haystacklen, pattern, found_needle);
+}
+
+/*
+ * This works the same way as ws_memmem_avx2(), 16 positions at a time,
+ * narrowing the comparison results to a 64-bit mask with 4 bits for each
+ * position.
+ */
+const guint8 *
+ws_memmem_neon(const guint8* haystack, size_t haystacklen, const guint8* needle, size_t needlelen)
+{
+    const uint8x16_t first = vdupq_n_u8(needle[0]);
+    const uint8x16_t last = vdupq_n_u8(needle[needlelen - 1]);
+    const guint8 *begin = haystack;
+    size_t left = haystacklen;
+
+    /* Each iteration reads 16 bytes from begin and from begin + needlelen - 1. */
+    while (left >= needlelen + 15) {
+        uint8x16_t hits = vandq_u8(vceqq_u8(vld1q_u8(begin), first),
+                                   vceqq_u8(vld1q_u8(begin + needlelen - 1), last));
+
+        if (vmaxvq_u8(hits) != 0) {
+            guint64 mask = vget_lane_u64(vreinterpret_u64_u8(
+                vshrn_n_u16(vreinterpretq_u16_u8(hits), 4)), 0);
+
+            while (mask != 0) {
+                int pos = ws_ctz(mask) / 4;
+
+                if (memcmp(begin + pos + 1, needle + 1, needlelen - 2) == 0)
+                    return begin + pos;
+                mask &= ~((guint64)0xf << (pos * 4));
+            }
+        }
+        begin += 16;
+        left -= 16;
+    }
+
+    return ws_memmem_portable(begin, left, needle, needlelen);
+}
+
+#endif /* HAVE_MEMPBRK_NEON */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -18,63 +18,303 @@
 #include <errno.h>
 #include <wsutil/jsmn.h>
 #include <wsutil/str_util.h>
+#include <wsutil/ws_mempbrk.h>
 #include <wsutil/unicode-utils.h>
 #include "log.h"
 
-gboolean
-json_validate(const guint8 *buf, const size_t len)
+/* The bytes that end the plain part of a string */
+static ws_mempbrk_pattern json_string_specials;
+
+static void
+json_init_patterns(void)
 {
-    gboolean ret = TRUE;
-    /* We expect no more than 1024 tokens */
-    guint max_tokens = 1024;
-    jsmntok_t* t;
-    jsmn_parser p;
-    int rcode;
+    static gsize initialized = 0;
 
-    /*
-     * Make sure the buffer isn't empty and the first octet isn't a NUL;
-     * otherwise, the parser will immediately stop parsing and not validate
-     * anything after that, so it'll just think it was handed an empty string.
-     *
-     * XXX - should we check for NULs anywhere in the buffer?
-     */
-    if (len == 0) {
-        g_log(LOG_DOMAIN_MAIN, G_LOG_LEVEL_DEBUG, "jsmn: JSON string is empty");
-        return FALSE;
+    if (g_once_init_enter(&initialized)) {
+        ws_mempbrk_compile(&json_string_specials, "\"\\");
+        g_once_init_leave(&initialized, 1);
     }
-    if (buf[0] == '\0') {
-        g_log(LOG_DOMAIN_MAIN, G_LOG_LEVEL_DEBUG, "jsmn: invalid character inside JSON string");
-        return FALSE;
+}
+
+#define JSON_IS_WS(c) ((c) == ' ' || (c) == '\t' || (c) == '\r' || (c) == '\n')
+
+static size_t
+json_skip_ws(const guint8 *buf, size_t len, size_t pos)
+{
+    while (pos < len && JSON_IS_WS(buf[pos]))
+        pos++;
+    return pos;
+}
+
+/* The offset after the string beginning at pos, or 0 */
+static size_t
+json_scan_string(const guint8 *buf, size_t len, size_t pos)
+{
+    const guint8 *p;
+    int i;
+
+    pos++;
+    for (;;) {
+        p = ws_mempbrk_exec(buf + pos, len - pos, &json_string_specials, NULL);
+        if (p == NULL)
+            return 0;
+        pos = p - buf;
+        if (*p == '"')
+            return pos + 1;
+
+        if (pos + 1 >= len)
+            return 0;
+        switch (buf[pos + 1]) {
+            case '"':
+            case '\\':
+            case '/':
+            case 'b':
+            case 'f':
+            case 'n':
+            case 'r':
+            case 't':
+                pos += 2;
+                break;
+
+            case 'u':
+                if (len - pos < 6)
+                    return 0;
+                for (i = 2; i < 6; i++) {
+                    if (!g_ascii_isxdigit(buf[pos + i]))
+                        return 0;
+                }
+                pos += 6;
+                break;
+
+            default:
+                return 0;
+        }
+    }
+}
+
+/* The offset after the number beginning at pos, or 0 */
+static size_t
+json_scan_number(const guint8 *buf, size_t len, size_t pos)
+{
+    if (buf[pos] == '-')
+        pos++;
+
+    /* int = zero / ( digit1-9 *DIGIT ) */
+    if (pos >= len)
+        return 0;
+    if (buf[pos] == '0') {
+        pos++;
+    } else if (buf[pos] >= '1' && buf[pos] <= '9') {
+        do
+            pos++;
+        while (pos < len && g_ascii_isdigit(buf[pos]));
+    } else {
+        return 0;
     }
 
-    t = g_new0(jsmntok_t, max_tokens);
+    /* frac = decimal-point 1*DIGIT */
+    if (pos < len && buf[pos] == '.') {
+        pos++;
+        if (pos >= len || !g_ascii_isdigit(buf[pos]))
+            return 0;
+        do
+            pos++;
+        while (pos < len && g_ascii_isdigit(buf[pos]));
+    }
 
-    if (!t)
-        return FALSE;
+    /* exp = e [ minus / plus ] 1*DIGIT */
+    if (pos < len && (buf[pos] == 'e' || buf[pos] == 'E')) {
+        pos++;
+        if (pos < len && (buf[pos] == '-' || buf[pos] == '+'))
+            pos++;
+        if (pos >= len || !g_ascii_isdigit(buf[pos]))
+            return 0;
+        do
+            pos++;
+        while (pos < len && g_ascii_isdigit(buf[pos]));
+    }
 
-    jsmn_init(&p);
-    rcode = jsmn_parse(&p, buf, len, t, max_tokens);
-    if (rcode < 0) {
-        switch (rcode) {
-            case JSMN_ERROR_NOMEM:
-                g_log(LOG_DOMAIN_MAIN, G_LOG_LEVEL_DEBUG, "jsmn: not enough tokens were provided");
+    return pos;
+}
+
+/* An object or array that json_tape_parse() is in */
+typedef struct {
+    json_tape_type_t type;
+    guint index;        /* in the tape */
+} json_container_t;
+
+size_t
+json_tape_parse(const guint8 *buf, size_t len, size_t offset, GArray *tape)
+{
+    GArray *containers;
+    json_container_t *top;
+    json_tape_entry_t entry;
+    guint tape_len = tape ? tape->len : 0;
+    size_t pos, end = 0;
+    gboolean want_key = FALSE;
+
+    /* The tape has 32-bit offsets */
+    if (len > G_MAXUINT32)
+        return 0;
+
+    json_init_patterns();
+    containers = g_array_new(FALSE, FALSE, sizeof(json_container_t));
+
+    pos = json_skip_ws(buf, len, offset);
+    for (;;) {
+        /* A value, or a key if want_key */
+        if (pos >= len)
+            goto fail;
+        entry.offset = (guint32)pos;
+        switch (buf[pos]) {
+            case '{':
+            case '[':
+                if (want_key)
+                    goto fail;
+                entry.type = buf[pos] == '{' ? JSON_TAPE_OBJECT : JSON_TAPE_ARRAY;
+                end = pos + 1;
+                break;
+
+            case '"':
+                entry.type = JSON_TAPE_STRING;
+                end = json_scan_string(buf, len, pos);
                 break;
-            case JSMN_ERROR_INVAL:
-                g_log(LOG_DOMAIN_MAIN, G_LOG_LEVEL_DEBUG, "jsmn: invalid character inside JSON string");
+
+            case 'f':
+                entry.type = JSON_TAPE_FALSE;
+                end = len - pos >= 5 && memcmp(buf + pos, "false", 5) == 0 ? pos + 5 : 0;
                 break;
-            case JSMN_ERROR_PART:
-                g_log(LOG_DOMAIN_MAIN, G_LOG_LEVEL_DEBUG, "jsmn: the string is not a full JSON packet, "
-                    "more bytes expected");
+
+            case 'n':
+                entry.type = JSON_TAPE_NULL;
+                end = len - pos >= 4 && memcmp(buf + pos, "null", 4) == 0 ? pos + 4 : 0;
+                break;
+
+            case 't':
+                entry.type = JSON_TAPE_TRUE;
+                end = len - pos >= 4 && memcmp(buf + pos, "true", 4) == 0 ? pos + 4 : 0;
                 break;
+
             default:
-                g_log(LOG_DOMAIN_MAIN, G_LOG_LEVEL_DEBUG, "jsmn: unexpected error");
+                entry.type = JSON_TAPE_NUMBER;
+                end = json_scan_number(buf, len, pos);
+                break;
+        }
+        if (end == 0 || (want_key && entry.type != JSON_TAPE_STRING))
+            goto fail;
+        entry.len = (guint32)(end - pos);
+        if (tape) {
+            entry.next = tape->len + 1;
+            g_array_append_val(tape, entry);
+        }
+        pos = json_skip_ws(buf, len, end);
+
+        if (want_key) {
+            if (pos >= len || buf[pos] != ':')
+                goto fail;
+            pos = json_skip_ws(buf, len, pos + 1);
+            want_key = FALSE;
+            continue;
+        }
+
+        if (entry.type == JSON_TAPE_OBJECT || entry.type == JSON_TAPE_ARRAY) {
+            json_container_t container;
+
+            container.type = entry.type;
+            container.index = tape ? tape->len - 1 : 0;
+            g_array_append_val(containers, container);
+            if (pos < len && buf[pos] == (entry.type == JSON_TAPE_OBJECT ? '}' : ']')) {
+                /* It's empty */
+                end = pos + 1;
+            } else {
+                want_key = entry.type == JSON_TAPE_OBJECT;
+                continue;
+            }
+        } else if (containers->len == 0) {
+            /* A value by itself */
+            break;
+        } else if (pos < len && buf[pos] == ',') {
+            pos = json_skip_ws(buf, len, pos + 1);
+            want_key = g_array_index(containers, json_container_t, containers->len - 1).type == JSON_TAPE_OBJECT;
+            continue;
+        } else {
+            end = 0;
+        }
+
+        /* Close the containers that end here */
+        for (;;) {
+            top = &g_array_index(containers, json_container_t, containers->len - 1);
+            if (end == 0) {
+                if (pos >= len || buf[pos] != (top->type == JSON_TAPE_OBJECT ? '}' : ']'))
+                    goto fail;
+                end = pos + 1;
+            }
+            if (tape) {
+                json_tape_entry_t *container_entry = &g_array_index(tape, json_tape_entry_t, top->index);
+
+                container_entry->len = (guint32)(end - container_entry->offset);
+                container_entry->next = tape->len;
+            }
+            g_array_set_size(containers, containers->len - 1);
+            if (containers->len == 0)
+                break;
+
+            pos = json_skip_ws(buf, len, end);
+            if (pos < len && buf[pos] == ',') {
+                pos = json_skip_ws(buf, len, pos + 1);
+                want_key = g_array_index(containers, json_container_t, containers->len - 1).type == JSON_TAPE_OBJECT;
                 break;
+            }
+            end = 0;
         }
-        ret = FALSE;
+        if (containers->len == 0)
+            break;
+    }
+
+    g_array_free(containers, TRUE);
+    return end;
+
+fail:
+    g_array_free(containers, TRUE);
+    if (tape)
+        g_array_set_size(tape, tape_len);
+    return 0;
+}
+
+gboolean
+json_validate(const guint8 *buf, const size_t len)
+{
+    const guint8 *nul;
+    size_t text_len = len;
+    size_t pos = 0;
+
+    /*
+     * Make sure the buffer isn't empty and the first octet isn't a NUL;
+     * the JSON text ends at a NUL, as it did with jsmn, which stopped
+     * there.
+     */
+    if (len == 0) {
+        g_log(LOG_DOMAIN_MAIN, G_LOG_LEVEL_DEBUG, "json: JSON string is empty");
+        return FALSE;
     }
+    if (buf[0] == '\0') {
+        g_log(LOG_DOMAIN_MAIN, G_LOG_LEVEL_DEBUG, "json: invalid character inside JSON string");
+        return FALSE;
+    }
+    nul = (const guint8 *)memchr(buf, '\0', len);
+    if (nul)
+        text_len = nul - buf;
+
+    do {
+        pos = json_tape_parse(buf, text_len, pos, NULL);
+        if (pos == 0) {
+            g_log(LOG_DOMAIN_MAIN, G_LOG_LEVEL_DEBUG, "json: the string is not valid JSON, or not a full JSON packet");
+            return FALSE;
+        }
+        pos = json_skip_ws(buf, text_len, pos);
+    } while (pos < text_len);
 
-    g_free(t);
-    return ret;
+    return TRUE;
 }
 
 int
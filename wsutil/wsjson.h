@@ -27,6 +27,42 @@ extern "C" {
  */
 WS_DLL_PUBLIC gboolean json_validate(const guint8 *buf, const size_t len);
 
+/**
+ * The kinds of value in a JSON tape.
+ */
+typedef enum {
+    JSON_TAPE_OBJECT,
+    JSON_TAPE_ARRAY,
+    JSON_TAPE_STRING,
+    JSON_TAPE_NUMBER,
+    JSON_TAPE_FALSE,
+    JSON_TAPE_NULL,
+    JSON_TAPE_TRUE
+} json_tape_type_t;
+
+/**
+ * One value of a JSON text, as found by json_tape_parse(). The values
+ * are in the order they begin in; those in an object are its keys (as
+ * strings) and their values, alternately.
+ */
+typedef struct {
+    json_tape_type_t type;
+    guint32 offset;     /**< of the value in the buffer */
+    guint32 len;        /**< with the quotes or brackets */
+    guint32 next;       /**< index of the value after this one and the values in it */
+} json_tape_entry_t;
+
+/**
+ * Parse the JSON value at offset (after any whitespace) in a buffer,
+ * appending its values to tape, a GArray of json_tape_entry_t, if it
+ * isn't NULL. Strings and whitespace, where most of the bytes of large
+ * JSON texts are, are scanned with ws_mempbrk_exec(), and the structure
+ * isn't limited in size or depth.
+ * Returns the offset after the value, or 0, having left the tape as it
+ * was, if there isn't a complete value there.
+ */
+WS_DLL_PUBLIC size_t json_tape_parse(const guint8 *buf, size_t len, size_t offset, GArray *tape);
+
 WS_DLL_PUBLIC int json_parse(const char *buf, jsmntok_t *tokens, unsigned int max_tokens);
 
 /**
@@ -0,0 +1,383 @@
+/* xxh3.c
+ * The XXH3 128-bit non-cryptographic hash
+ *
+ * This is a scalar version of XXH3_128bits() from xxHash 0.8, with only
+ * the default seed and secret, kept here (as packet-kafka.c does with
+ * XXH32) because not everyone packaging Wireshark provides xxhash.h.
+ * The output is the same as the library's, so it can be checked with
+ * "xxhsum -H2".
+ *
+ * xxHash - Extremely Fast Hash algorithm
+ * Copyright (C) 2012-2020 Yann Collet
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later AND BSD-2-Clause
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "pint.h"
+#include "xxh3.h"
+
+#define PRIME32_1   G_GUINT64_CONSTANT(0x9E3779B1)
+#define PRIME32_2   G_GUINT64_CONSTANT(0x85EBCA77)
+#define PRIME32_3   G_GUINT64_CONSTANT(0xC2B2AE3D)
+#define PRIME64_1   G_GUINT64_CONSTANT(0x9E3779B185EBCA87)
+#define PRIME64_2   G_GUINT64_CONSTANT(0xC2B2AE3D27D4EB4F)
+#define PRIME64_3   G_GUINT64_CONSTANT(0x165667B19E3779F9)
+#define PRIME64_4   G_GUINT64_CONSTANT(0x85EBCA77C2B2AE63)
+#define PRIME64_5   G_GUINT64_CONSTANT(0x27D4EB2F165667C5)
+#define PRIME_MX1   G_GUINT64_CONSTANT(0x165667919E3779F9)
+#define PRIME_MX2   G_GUINT64_CONSTANT(0x9FB21C651E98DF25)
+
+#define STRIPE_LEN          64
+#define SECRET_CONSUME_RATE 8
+#define MIDSIZE_MAX         240
+#define MIDSIZE_STARTOFFSET 3
+#define MIDSIZE_LASTOFFSET  17
+#define SECRET_SIZE_MIN     136
+#define SECRET_LASTACC_START    7
+#define SECRET_MERGEACCS_START  11
+
+static const guint8 xxh3_secret[192] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+typedef struct {
+    guint64 lo;
+    guint64 hi;
+} xxh_u128;
+
+static inline guint64
+xxh_swap64(guint64 x)
+{
+    return GUINT64_SWAP_LE_BE(x);
+}
+
+static inline guint32
+xxh_swap32(guint32 x)
+{
+    return GUINT32_SWAP_LE_BE(x);
+}
+
+static inline guint32
+xxh_rotl32(guint32 x, int r)
+{
+    return (x << r) | (x >> (32 - r));
+}
+
+/* The full 128-bit product, done in 32-bit pieces so that it works with
+   compilers that have no 128-bit integer type. */
+static inline xxh_u128
+xxh_mult64to128(guint64 a, guint64 b)
+{
+    guint64 lo_lo = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+    guint64 hi_lo = (a >> 32) * (b & 0xFFFFFFFF);
+    guint64 lo_hi = (a & 0xFFFFFFFF) * (b >> 32);
+    guint64 hi_hi = (a >> 32) * (b >> 32);
+    guint64 cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+    xxh_u128 r;
+
+    r.hi = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+    r.lo = (cross << 32) | (lo_lo & 0xFFFFFFFF);
+    return r;
+}
+
+static inline guint64
+xxh_mul128_fold64(guint64 a, guint64 b)
+{
+    xxh_u128 r = xxh_mult64to128(a, b);
+
+    return r.lo ^ r.hi;
+}
+
+static guint64
+xxh64_avalanche(guint64 h)
+{
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+static guint64
+xxh3_avalanche(guint64 h)
+{
+    h ^= h >> 37;
+    h *= PRIME_MX1;
+    h ^= h >> 32;
+    return h;
+}
+
+static xxh_u128
+xxh3_len_1to3(const guint8 *in, size_t len, const guint8 *secret)
+{
+    guint32 combinedl = ((guint32)in[0] << 16) | ((guint32)in[len >> 1] << 24) |
+                        ((guint32)in[len - 1]) | ((guint32)len << 8);
+    guint32 combinedh = xxh_rotl32(xxh_swap32(combinedl), 13);
+    guint64 bitflipl = pletoh32(secret) ^ pletoh32(secret + 4);
+    guint64 bitfliph = pletoh32(secret + 8) ^ pletoh32(secret + 12);
+    xxh_u128 h;
+
+    h.lo = xxh64_avalanche(combinedl ^ bitflipl);
+    h.hi = xxh64_avalanche(combinedh ^ bitfliph);
+    return h;
+}
+
+static xxh_u128
+xxh3_len_4to8(const guint8 *in, size_t len, const guint8 *secret)
+{
+    guint64 in64 = pletoh32(in) + ((guint64)pletoh32(in + len - 4) << 32);
+    guint64 bitflip = pletoh64(secret + 16) ^ pletoh64(secret + 24);
+    xxh_u128 m = xxh_mult64to128(in64 ^ bitflip, PRIME64_1 + (len << 2));
+
+    m.hi += m.lo << 1;
+    m.lo ^= m.hi >> 3;
+    m.lo ^= m.lo >> 35;
+    m.lo *= PRIME_MX2;
+    m.lo ^= m.lo >> 28;
+    m.hi = xxh3_avalanche(m.hi);
+    return m;
+}
+
+static xxh_u128
+xxh3_len_9to16(const guint8 *in, size_t len, const guint8 *secret)
+{
+    guint64 bitflipl = pletoh64(secret + 32) ^ pletoh64(secret + 40);
+    guint64 bitfliph = pletoh64(secret + 48) ^ pletoh64(secret + 56);
+    guint64 in_lo = pletoh64(in);
+    guint64 in_hi = pletoh64(in + len - 8);
+    xxh_u128 m = xxh_mult64to128(in_lo ^ in_hi ^ bitflipl, PRIME64_1);
+    xxh_u128 h;
+
+    m.lo += (guint64)(len - 1) << 54;
+    in_hi ^= bitfliph;
+    m.hi += in_hi + (in_hi & 0xFFFFFFFF) * (PRIME32_2 - 1);
+    m.lo ^= xxh_swap64(m.hi);
+
+    h = xxh_mult64to128(m.lo, PRIME64_2);
+    h.hi += m.hi * PRIME64_2;
+    h.lo = xxh3_avalanche(h.lo);
+    h.hi = xxh3_avalanche(h.hi);
+    return h;
+}
+
+static xxh_u128
+xxh3_len_0to16(const guint8 *in, size_t len, const guint8 *secret)
+{
+    xxh_u128 h;
+
+    if (len > 8)
+        return xxh3_len_9to16(in, len, secret);
+    if (len >= 4)
+        return xxh3_len_4to8(in, len, secret);
+    if (len > 0)
+        return xxh3_len_1to3(in, len, secret);
+    h.lo = xxh64_avalanche(pletoh64(secret + 64) ^ pletoh64(secret + 72));
+    h.hi = xxh64_avalanche(pletoh64(secret + 80) ^ pletoh64(secret + 88));
+    return h;
+}
+
+static inline guint64
+xxh3_mix16(const guint8 *in, const guint8 *secret, guint64 seed)
+{
+    return xxh_mul128_fold64(pletoh64(in) ^ (pletoh64(secret) + seed),
+                             pletoh64(in + 8) ^ (pletoh64(secret + 8) - seed));
+}
+
+static inline xxh_u128
+xxh3_mix32(xxh_u128 acc, const guint8 *in1, const guint8 *in2,
+           const guint8 *secret, guint64 seed)
+{
+    acc.lo += xxh3_mix16(in1, secret, seed);
+    acc.lo ^= pletoh64(in2) + pletoh64(in2 + 8);
+    acc.hi += xxh3_mix16(in2, secret + 16, seed);
+    acc.hi ^= pletoh64(in1) + pletoh64(in1 + 8);
+    return acc;
+}
+
+static xxh_u128
+xxh3_midsize_final(xxh_u128 acc, size_t len)
+{
+    xxh_u128 h;
+
+    h.lo = xxh3_avalanche(acc.lo + acc.hi);
+    h.hi = (guint64)0 - xxh3_avalanche(acc.lo * PRIME64_1 + acc.hi * PRIME64_4 +
+                                       (guint64)len * PRIME64_2);
+    return h;
+}
+
+static xxh_u128
+xxh3_len_17to128(const guint8 *in, size_t len, const guint8 *secret)
+{
+    xxh_u128 acc;
+
+    acc.lo = (guint64)len * PRIME64_1;
+    acc.hi = 0;
+    if (len > 32) {
+        if (len > 64) {
+            if (len > 96)
+                acc = xxh3_mix32(acc, in + 48, in + len - 64, secret + 96, 0);
+            acc = xxh3_mix32(acc, in + 32, in + len - 48, secret + 64, 0);
+        }
+        acc = xxh3_mix32(acc, in + 16, in + len - 32, secret + 32, 0);
+    }
+    acc = xxh3_mix32(acc, in, in + len - 16, secret, 0);
+    return xxh3_midsize_final(acc, len);
+}
+
+static xxh_u128
+xxh3_len_129to240(const guint8 *in, size_t len, const guint8 *secret)
+{
+    xxh_u128 acc;
+    size_t i;
+
+    acc.lo = (guint64)len * PRIME64_1;
+    acc.hi = 0;
+    for (i = 32; i < 160; i += 32)
+        acc = xxh3_mix32(acc, in + i - 32, in + i - 16, secret + i - 32, 0);
+    acc.lo = xxh3_avalanche(acc.lo);
+    acc.hi = xxh3_avalanche(acc.hi);
+    /* This repeats the last 32 bytes if len is a multiple of 32, as the
+       library does. */
+    for (i = 160; i <= len; i += 32)
+        acc = xxh3_mix32(acc, in + i - 32, in + i - 16,
+                         secret + MIDSIZE_STARTOFFSET + i - 160, 0);
+    acc = xxh3_mix32(acc, in + len - 16, in + len - 32,
+                     secret + SECRET_SIZE_MIN - MIDSIZE_LASTOFFSET - 16, 0);
+    return xxh3_midsize_final(acc, len);
+}
+
+static inline void
+xxh3_accumulate_512(guint64 *acc, const guint8 *in, const guint8 *secret)
+{
+    size_t lane;
+
+    for (lane = 0; lane < 8; lane++) {
+        guint64 data_val = pletoh64(in + lane * 8);
+        guint64 data_key = data_val ^ pletoh64(secret + lane * 8);
+
+        acc[lane ^ 1] += data_val;
+        acc[lane] += (data_key & 0xFFFFFFFF) * (data_key >> 32);
+    }
+}
+
+static inline void
+xxh3_accumulate(guint64 *acc, const guint8 *in, const guint8 *secret, size_t nb_stripes)
+{
+    size_t n;
+
+    for (n = 0; n < nb_stripes; n++)
+        xxh3_accumulate_512(acc, in + n * STRIPE_LEN, secret + n * SECRET_CONSUME_RATE);
+}
+
+static inline void
+xxh3_scramble(guint64 *acc, const guint8 *secret)
+{
+    size_t lane;
+
+    for (lane = 0; lane < 8; lane++) {
+        guint64 a = acc[lane];
+
+        a ^= a >> 47;
+        a ^= pletoh64(secret + lane * 8);
+        a *= PRIME32_1;
+        acc[lane] = a;
+    }
+}
+
+static guint64
+xxh3_merge_accs(const guint64 *acc, const guint8 *secret, guint64 start)
+{
+    guint64 result = start;
+    size_t i;
+
+    for (i = 0; i < 4; i++)
+        result += xxh_mul128_fold64(acc[2 * i] ^ pletoh64(secret + 16 * i),
+                                    acc[2 * i + 1] ^ pletoh64(secret + 16 * i + 8));
+    return xxh3_avalanche(result);
+}
+
+static xxh_u128
+xxh3_hash_long(const guint8 *in, size_t len, const guint8 *secret, size_t secret_size)
+{
+    guint64 acc[8] = {
+        PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3,
+        PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1
+    };
+    size_t nb_stripes_per_block = (secret_size - STRIPE_LEN) / SECRET_CONSUME_RATE;
+    size_t block_len = STRIPE_LEN * nb_stripes_per_block;
+    size_t nb_blocks = (len - 1) / block_len;
+    size_t n;
+    xxh_u128 h;
+
+    for (n = 0; n < nb_blocks; n++) {
+        xxh3_accumulate(acc, in + n * block_len, secret, nb_stripes_per_block);
+        xxh3_scramble(acc, secret + secret_size - STRIPE_LEN);
+    }
+
+    /* The last partial block, and then the last stripe, which may
+       overlap it. */
+    xxh3_accumulate(acc, in + nb_blocks * block_len, secret,
+                    ((len - 1) - block_len * nb_blocks) / STRIPE_LEN);
+    xxh3_accumulate_512(acc, in + len - STRIPE_LEN,
+                        secret + secret_size - STRIPE_LEN - SECRET_LASTACC_START);
+
+    h.lo = xxh3_merge_accs(acc, secret + SECRET_MERGEACCS_START,
+                           (guint64)len * PRIME64_1);
+    h.hi = xxh3_merge_accs(acc, secret + secret_size - sizeof(acc) - SECRET_MERGEACCS_START,
+                           ~((guint64)len * PRIME64_2));
+    return h;
+}
+
+void
+ws_xxh3_128(const void *data, size_t len, guint8 digest[XXH3_128_LEN])
+{
+    const guint8 *in = (const guint8 *)data;
+    xxh_u128 h;
+
+    if (len <= 16)
+        h = xxh3_len_0to16(in, len, xxh3_secret);
+    else if (len <= 128)
+        h = xxh3_len_17to128(in, len, xxh3_secret);
+    else if (len <= MIDSIZE_MAX)
+        h = xxh3_len_129to240(in, len, xxh3_secret);
+    else
+        h = xxh3_hash_long(in, len, xxh3_secret, sizeof xxh3_secret);
+
+    phton64(digest, h.hi);
+    phton64(digest + 8, h.lo);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
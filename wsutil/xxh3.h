@@ -0,0 +1,53 @@
+/* xxh3.h
+ * The XXH3 128-bit non-cryptographic hash
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WS_XXH3_H__
+#define __WS_XXH3_H__
+
+#include <glib.h>
+
+#include "ws_symbol_export.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define XXH3_128_LEN    16
+
+/** Compute the XXH3 128-bit hash of a buffer, with a seed of 0 and the
+ * default secret, as XXH3_128bits() in the xxHash library does.
+ *
+ * It is many times faster than MD5 for packet sized data, but it is no
+ * good for anything where someone might make collisions on purpose.
+ *
+ * @param data the data
+ * @param len the amount of data
+ * @param digest set to the hash in xxHash's canonical (big-endian) form
+ */
+WS_DLL_PUBLIC void ws_xxh3_128(const void *data, size_t len, guint8 digest[XXH3_128_LEN]);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __WS_XXH3_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */